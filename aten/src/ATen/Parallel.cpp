@@ -0,0 +1,265 @@
+#include "ATen/Parallel.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace at {
+
+namespace {
+// set_intra_op_num_threads of this thread, or -1 to use the global default
+thread_local int intra_op_num_threads = -1;
+
+// set while this thread is running part of a parallel_for or parallel_reduce
+thread_local bool in_parallel = false;
+
+struct ParallelRegionGuard {
+  ParallelRegionGuard() : prev_(in_parallel) { in_parallel = true; }
+  ~ParallelRegionGuard() { in_parallel = prev_; }
+ private:
+  bool prev_;
+};
+
+#if AT_PARALLEL_NATIVE() || defined(_OPENMP)
+int default_num_threads() {
+  int num_threads = get_num_threads();
+  if (num_threads > 0) {
+    return num_threads;
+  }
+  return std::max<int>(1, std::thread::hardware_concurrency());
+}
+#endif
+} // namespace
+
+#if AT_PARALLEL_NATIVE()
+namespace internal {
+namespace {
+
+// The intra-op team of one thread: the owner thread and size - 1 workers.
+// run() gives every member a deque of contiguous tasks. Members take tasks
+// from the front of their own deque and, once it is empty, steal from the
+// back of the others, so that a slow member doesn't hold up the others.
+//
+// Only the owner calls run(), and tasks run with in_parallel set, so there
+// is at most one job in flight per team.
+class ThreadTeam {
+ public:
+  explicit ThreadTeam(int size) : size_(size), queues_(size) {
+    for (auto& queue : queues_) {
+      queue.reset(new TaskQueue());
+    }
+    for (int id = 1; id < size; id++) {
+      workers_.emplace_back([this, id] { worker_loop(id); });
+    }
+  }
+
+  ~ThreadTeam() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  int size() const { return size_; }
+
+  void run(int64_t ntasks, const std::function<void(int64_t)>& fn) {
+    pending_.store(ntasks);
+    for (int id = 0; id < size_; id++) {
+      auto& queue = *queues_[id];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      for (int64_t i = id * ntasks / size_; i < (id + 1) * ntasks / size_; i++) {
+        queue.tasks.push_back(Task{&fn, i});
+      }
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      generation_++;
+    }
+    wake_.notify_all();
+
+    work(0);
+    std::exception_ptr error;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_.wait(lock, [this] { return pending_.load() == 0; });
+      std::swap(error, error_);
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+ private:
+  struct Task {
+    const std::function<void(int64_t)>* fn;
+    int64_t index;
+  };
+
+  struct TaskQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  bool pop(int id, Task& task) {
+    auto& queue = *queues_[id];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      return false;
+    }
+    task = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+  }
+
+  bool steal(int id, Task& task) {
+    for (int i = 1; i < size_; i++) {
+      auto& queue = *queues_[(id + i) % size_];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.tasks.empty()) {
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Runs tasks until there are none left to take.
+  void work(int id) {
+    ParallelRegionGuard guard;
+    Task task;
+    while (pop(id, task) || steal(id, task)) {
+      try {
+        (*task.fn)(task.index);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) {
+          error_ = std::current_exception();
+        }
+      }
+      if (--pending_ == 0) {
+        // lock so that the owner can't miss the notification between
+        // checking pending_ and waiting
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_.notify_one();
+      }
+    }
+  }
+
+  void worker_loop(int id) {
+    uint64_t seen = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+        if (stop_) {
+          return;
+        }
+        seen = generation_;
+      }
+      work(id);
+    }
+  }
+
+  const int size_;
+  std::vector<std::unique_ptr<TaskQueue>> queues_;
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  uint64_t generation_ = 0;
+  bool stop_ = false;
+  std::atomic<int64_t> pending_{0};
+  std::exception_ptr error_;
+};
+
+// The team of a thread that set its own number of intra-op threads,
+// created on first use and resized when that number changes. The workers
+// are joined when this thread exits.
+thread_local std::unique_ptr<ThreadTeam> team;
+
+// The team shared by the threads that use the default number of intra-op
+// threads, so that N inter-op threads don't start N teams of one thread per
+// core. One of them at a time runs on it; the others run their tasks
+// serially meanwhile. It is never destroyed, since its workers can't be
+// joined once the process exits.
+std::mutex shared_team_mutex;
+ThreadTeam* shared_team = nullptr;
+
+void run_serially(int64_t ntasks, const std::function<void(int64_t)>& task) {
+  ParallelRegionGuard guard;
+  for (int64_t i = 0; i < ntasks; i++) {
+    task(i);
+  }
+}
+
+} // namespace
+
+void run_parallel_tasks(int64_t ntasks, const std::function<void(int64_t)>& task) {
+  int num_threads = get_intra_op_num_threads();
+  if (num_threads == 1 || ntasks <= 1) {
+    run_serially(ntasks, task);
+    return;
+  }
+  if (intra_op_num_threads > 0) {
+    if (!team || team->size() != num_threads) {
+      team.reset();
+      team.reset(new ThreadTeam(num_threads));
+    }
+    team->run(ntasks, task);
+    return;
+  }
+  std::unique_lock<std::mutex> lock(shared_team_mutex, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    run_serially(ntasks, task);
+    return;
+  }
+  if (!shared_team || shared_team->size() != num_threads) {
+    delete shared_team;
+    shared_team = new ThreadTeam(num_threads);
+  }
+  shared_team->run(ntasks, task);
+}
+
+} // namespace internal
+#endif
+
+void set_intra_op_num_threads(int num_threads) {
+  intra_op_num_threads = num_threads > 0 ? num_threads : -1;
+#if defined(_OPENMP) && !AT_PARALLEL_NATIVE()
+  // the nthreads ICV is per thread as well
+  omp_set_num_threads(num_threads > 0 ? num_threads : default_num_threads());
+#endif
+}
+
+int get_intra_op_num_threads() {
+  if (in_parallel_region()) {
+    return 1;
+  }
+#if AT_PARALLEL_NATIVE()
+  return intra_op_num_threads > 0 ? intra_op_num_threads : default_num_threads();
+#elif defined(_OPENMP)
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+bool in_parallel_region() {
+#if defined(_OPENMP) && !AT_PARALLEL_NATIVE()
+  return omp_in_parallel();
+#else
+  return in_parallel;
+#endif
+}
+
+} // namespace at
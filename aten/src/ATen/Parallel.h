@@ -1,11 +1,32 @@
 #pragma once
 #include <ATen/ATen.h>
+#include <ATen/Config.h>
+#include <algorithm>
 #include <cstddef>
+#include <functional>
+#include <numeric>
+#include <vector>
 
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
+// at::parallel_for and at::parallel_reduce split a range across the intra-op
+// threads of the calling thread. The backend is chosen at build time with
+// ATEN_THREADING:
+//
+//  - OMP (default): an OpenMP parallel region per call, or serial execution
+//    if ATen is built without OpenMP.
+//  - NATIVE: a work-stealing team of std::threads (see Parallel.cpp). The
+//    threads that use the default number of intra-op threads share one
+//    team, which runs the work of one of them at a time, while the others
+//    run theirs serially; the total stays at one thread per core however
+//    many inter-op threads call into ATen. A thread that sets its own number
+//    with set_intra_op_num_threads gets a team of its own.
+//
+// In both cases parallel constructs nested inside a parallel region run
+// serially on the thread of the enclosing region.
+
 namespace at {
 namespace internal {
 // This parameter is heuristically chosen to determine the minimum number of
@@ -14,8 +35,31 @@ namespace internal {
 // no parallel algorithm (such as parallel_reduce) should split work into
 // smaller than GRAIN_SIZE chunks.
 constexpr int64_t GRAIN_SIZE = 32768;
+
+#if AT_PARALLEL_NATIVE()
+// Runs task(0), ..., task(ntasks - 1) on the intra-op team of the calling
+// thread, which takes part in the work, and returns once all of them are
+// done. The first exception thrown by a task is rethrown here.
+AT_API void run_parallel_tasks(int64_t ntasks, const std::function<void(int64_t)>& task);
+#endif
 } // namespace internal
 
+// Sets the number of intra-op threads (including itself) the calling thread
+// uses for parallel_for and parallel_reduce. Other threads keep using the
+// global default of at::set_num_threads. Non-positive values reset the
+// calling thread to that default.
+AT_API void set_intra_op_num_threads(int num_threads);
+
+// The number of threads parallel_for and parallel_reduce called from this
+// thread may use right now: 1 inside of a parallel region, otherwise the
+// value of set_intra_op_num_threads, then at::set_num_threads, then the
+// number of hardware threads.
+AT_API int get_intra_op_num_threads();
+
+// Whether the calling thread is running part of a parallel_for or
+// parallel_reduce.
+AT_API bool in_parallel_region();
+
 inline int64_t divup(int64_t x, int64_t y) {
   return (x + y - 1) / y;
 }
@@ -26,7 +70,21 @@ inline void parallel_for(
     const int64_t end,
     const int64_t grain_size,
     const F f) {
-#ifdef _OPENMP
+#if AT_PARALLEL_NATIVE()
+  int64_t num_threads = get_intra_op_num_threads();
+  if ((end - begin) < grain_size || num_threads == 1) {
+    f(begin, end);
+    return;
+  }
+  // a few chunks per thread, so that the team can even out the load by
+  // stealing, but none smaller than grain_size
+  int64_t chunk_size = std::max<int64_t>(
+      std::max<int64_t>(grain_size, 1), divup(end - begin, 4 * num_threads));
+  internal::run_parallel_tasks(divup(end - begin, chunk_size), [&](int64_t id) {
+    int64_t begin_id = begin + id * chunk_size;
+    f(begin_id, std::min(end, begin_id + chunk_size));
+  });
+#elif defined(_OPENMP)
 #pragma omp parallel if ((end - begin) >= grain_size)
   {
     int64_t num_threads = omp_get_num_threads();
@@ -49,17 +107,24 @@ inline scalar_t parallel_reduce(
     const scalar_t ident,
     const F f,
     const SF sf) {
-  if (get_num_threads() == 1) {
+  if (get_intra_op_num_threads() == 1 || (end - begin) < grain_size) {
     return f(begin, end, ident);
   } else {
     const int64_t num_results = divup((end - begin), grain_size);
     std::vector<scalar_t> results(num_results);
     scalar_t* results_data = results.data();
+#if AT_PARALLEL_NATIVE()
+    internal::run_parallel_tasks(num_results, [&](int64_t id) {
+      int64_t i = begin + id * grain_size;
+      results_data[id] = f(i, i + std::min(end - i, grain_size), ident);
+    });
+#else
 #pragma omp parallel for if ((end - begin) >= grain_size)
     for (int64_t id = 0; id < num_results; id++) {
       int64_t i = begin + id * grain_size;
       results_data[id] = f(i, i + std::min(end - i, grain_size), ident);
     }
+#endif
     return std::accumulate(
         results_data, results_data + results.size(), ident, sf);
   }
@@ -46,6 +46,15 @@ struct AT_API SparseTensorImpl : public TensorImpl {
   // because many algorithms proceed by merging two sorted lists (of indices).
   bool coalesced_ = false;
 
+  // The row pointers and column indices of a coalesced 2-D tensor, i.e. its
+  // CSR layout together with values_.  They are built by the sparse-dense
+  // matrix product kernels, in the index type the kernel needs (int64 for
+  // the CPU loops, int32 for cuSPARSE and MKL), and cached here so that
+  // repeated products with the same matrix don't convert it every time.
+  // Every setter that can change the indices, the sizes or nnz drops them.
+  Tensor csr_rows_;
+  Tensor csr_cols_;
+
 public:
   // Public for now...
   explicit SparseTensorImpl(Type * type);
@@ -56,6 +65,8 @@ public:
   bool coalesced() const { return coalesced_; }
   Tensor indices() const { return indices_; }
   Tensor values() const { return values_; }
+  Tensor csr_rows() const { return csr_rows_; }
+  Tensor csr_cols() const { return csr_cols_; }
 
   const char * toString() const override;
   IntList sizes() const override;
@@ -67,7 +78,10 @@ public:
 
   // Some ops do some manual size fiddling.
   // TODO: Figure out a more safe way to provide this functionality
-  std::vector<int64_t>& _sizes_mut() { return size_; }
+  std::vector<int64_t>& _sizes_mut() {
+    clear_csr();
+    return size_;
+  }
 
   // WARNING: This function does NOT preserve invariants of sparseDims/denseDims with
   // respect to indices and values
@@ -80,6 +94,7 @@ public:
     }
     sparseDims_ = sparseDims;
     denseDims_ = denseDims;
+    clear_csr();
   }
 
   // TODO: I hate these two setters, please get rid of them!!!
@@ -87,14 +102,33 @@ public:
     AT_ASSERT(indices.type().backend() == at::toDense(type().backend()));
     AT_ASSERT(indices.type().scalarType() == kLong);
     indices_ = indices;
+    clear_csr();
   }
   void set_values(const Tensor& values) {
     AT_ASSERT(values.type().toSparse() == type());
     values_ = values;
   }
 
-  void set_coalesced(bool coalesced) { coalesced_ = coalesced; }
-  void set_nnz(int64_t nnz) { nnz_ = nnz; }
+  void set_coalesced(bool coalesced) {
+    coalesced_ = coalesced;
+    clear_csr();
+  }
+  void set_nnz(int64_t nnz) {
+    nnz_ = nnz;
+    clear_csr();
+  }
+
+  // Only valid for coalesced 2-D tensors with scalar values; rows has
+  // size(0) + 1 entries and cols has nnz entries, of the same index type.
+  void set_csr(const Tensor& rows, const Tensor& cols) {
+    AT_ASSERT(coalesced_ && sparseDims_ == 2 && denseDims_ == 0);
+    csr_rows_ = rows;
+    csr_cols_ = cols;
+  }
+  void clear_csr() {
+    csr_rows_ = Tensor();
+    csr_cols_ = Tensor();
+  }
 
   // This used to be called THSTensor_(_move)
   // NB: This used to be able to avoid a refcount bump, but I was too lazy to
@@ -0,0 +1,28 @@
+#pragma once
+
+// Kernels in native/cpu that are written against vec::Vectorized<T> and the
+// vec:: functions (map, reduce_all, max, ...) use 512-bit vectors in their
+// AVX512 build and 256-bit ones in all others. See native/cpu/README.
+
+#if defined(CPU_CAPABILITY_AVX512)
+#include "ATen/cpu/vec512/functional.h"
+#include "ATen/cpu/vec512/vec512.h"
+#else
+#include "ATen/cpu/vec256/functional.h"
+#include "ATen/cpu/vec256/vec256.h"
+#endif
+
+namespace at {
+namespace vec {
+
+#if defined(CPU_CAPABILITY_AVX512)
+using namespace ::at::vec512;
+template <typename T>
+using Vectorized = ::at::vec512::Vec512<T>;
+#else
+using namespace ::at::vec256;
+template <typename T>
+using Vectorized = ::at::vec256::Vec256<T>;
+#endif
+
+}}
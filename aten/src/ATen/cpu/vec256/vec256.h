@@ -5,6 +5,7 @@
 #include "vec256_base.h"
 #include "vec256_float.h"
 #include "vec256_double.h"
+#include "vec256_half.h"
 #include "vec256_int.h"
 
 #include <algorithm>
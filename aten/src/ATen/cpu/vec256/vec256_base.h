@@ -208,4 +208,22 @@ template <class T> Vec256<T> max(const Vec256<T> &a, const Vec256<T> &b) {
   return c;
 }
 
+// maximum and minimum propagate NaN if either input is NaN, like
+// torch.max and torch.min do; max above doesn't
+template <class T> Vec256<T> maximum(const Vec256<T> &a, const Vec256<T> &b) {
+  Vec256<T> c = Vec256<T>();
+  for (int i = 0; i != Vec256<T>::size; i++) {
+    c[i] = (a[i] > b[i] || a[i] != a[i]) ? a[i] : b[i];
+  }
+  return c;
+}
+
+template <class T> Vec256<T> minimum(const Vec256<T> &a, const Vec256<T> &b) {
+  Vec256<T> c = Vec256<T>();
+  for (int i = 0; i != Vec256<T>::size; i++) {
+    c[i] = (a[i] < b[i] || a[i] != a[i]) ? a[i] : b[i];
+  }
+  return c;
+}
+
 }}}
@@ -178,6 +178,22 @@ Vec256<double> inline max(const Vec256<double>& a, const Vec256<double>& b) {
   return _mm256_max_pd(a, b);
 }
 
+template <>
+Vec256<double> inline maximum(const Vec256<double>& a, const Vec256<double>& b) {
+  Vec256<double> max = _mm256_max_pd(a, b);
+  Vec256<double> isnan = _mm256_cmp_pd(a, b, _CMP_UNORD_Q);
+  // all bits set is a NaN
+  return _mm256_or_pd(max, isnan);
+}
+
+template <>
+Vec256<double> inline minimum(const Vec256<double>& a, const Vec256<double>& b) {
+  Vec256<double> min = _mm256_min_pd(a, b);
+  Vec256<double> isnan = _mm256_cmp_pd(a, b, _CMP_UNORD_Q);
+  // all bits set is a NaN
+  return _mm256_or_pd(min, isnan);
+}
+
 #endif
 
 }}}
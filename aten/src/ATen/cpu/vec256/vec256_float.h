@@ -183,6 +183,22 @@ Vec256<float> inline max(const Vec256<float>& a, const Vec256<float>& b) {
   return _mm256_max_ps(a, b);
 }
 
+template <>
+Vec256<float> inline maximum(const Vec256<float>& a, const Vec256<float>& b) {
+  Vec256<float> max = _mm256_max_ps(a, b);
+  Vec256<float> isnan = _mm256_cmp_ps(a, b, _CMP_UNORD_Q);
+  // all bits set is a NaN
+  return _mm256_or_ps(max, isnan);
+}
+
+template <>
+Vec256<float> inline minimum(const Vec256<float>& a, const Vec256<float>& b) {
+  Vec256<float> min = _mm256_min_ps(a, b);
+  Vec256<float> isnan = _mm256_cmp_ps(a, b, _CMP_UNORD_Q);
+  // all bits set is a NaN
+  return _mm256_or_ps(min, isnan);
+}
+
 #endif
 
 }}}
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "intrinsics.h"
+#include "vec256_base.h"
+#include "vec256_float.h"
+#include "ATen/Half.h"
+
+namespace at {
+namespace vec256 {
+namespace {
+
+// Half is only a storage type on the CPU. Vec256<Half> holds 8 halves (128
+// bits of memory) widened to a Vec256<float>, computes in float and rounds
+// to half when it is stored. Loads and stores convert with F16C when the
+// capability has it (AVX2 and up), one element at a time otherwise.
+//
+// Unlike for the other types, size is not 32 / sizeof(T): it is the size of
+// the float vector, so that Half can be loaded into and stored from
+// Vec256<float> one vector at a time.
+
+#if defined(__AVX__) && defined(__F16C__) && !defined(_MSC_VER)
+#define AT_VEC256_HALF_F16C
+#endif
+
+template <> class Vec256<Half> {
+private:
+  Vec256<float> values;
+public:
+  static constexpr int64_t size = Vec256<float>::size;
+  Vec256() {}
+  Vec256(Vec256<float> v) : values(v) {}
+  Vec256(Half val) : values(static_cast<float>(val)) {}
+  operator Vec256<float>() const {
+    return values;
+  }
+  template <int64_t mask>
+  static Vec256<Half> blend(Vec256<Half> a, Vec256<Half> b) {
+    return Vec256<float>::blend<mask>(a.values, b.values);
+  }
+  static Vec256<Half> set(Vec256<Half> a, Vec256<Half> b, int64_t count = size) {
+    return Vec256<float>::set(a.values, b.values, count);
+  }
+  static Vec256<Half> loadu(const void* ptr, int64_t count = size) {
+#ifdef AT_VEC256_HALF_F16C
+    if (count == size) {
+      return Vec256<float>(_mm256_cvtph_ps(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr))));
+    }
+    __at_align32__ Half tmp_values[size] = {};
+    std::memcpy(tmp_values, ptr, count * sizeof(Half));
+    return Vec256<float>(_mm256_cvtph_ps(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(tmp_values))));
+#else
+    const Half* src = reinterpret_cast<const Half*>(ptr);
+    __at_align32__ float tmp_values[size] = {};
+    for (int64_t i = 0; i < count; i++) {
+      tmp_values[i] = src[i];
+    }
+    return Vec256<float>::loadu(tmp_values);
+#endif
+  }
+  void store(void* ptr, int64_t count = size) const {
+#ifdef AT_VEC256_HALF_F16C
+    __m256 v = values;
+    __m128i halves = _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+    if (count == size) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), halves);
+    } else {
+      __at_align32__ Half tmp_values[size];
+      _mm_store_si128(reinterpret_cast<__m128i*>(tmp_values), halves);
+      std::memcpy(ptr, tmp_values, count * sizeof(Half));
+    }
+#else
+    __at_align32__ float tmp_values[size];
+    values.store(tmp_values);
+    Half* dst = reinterpret_cast<Half*>(ptr);
+    for (int64_t i = 0; i < count; i++) {
+      dst[i] = tmp_values[i];
+    }
+#endif
+  }
+  const Half& operator[](int idx) const  = delete;
+  Half& operator[](int idx) = delete;
+  Vec256<Half> map(float (*f)(float)) const {
+    return values.map(f);
+  }
+  Vec256<Half> abs() const {
+    return values.abs();
+  }
+  Vec256<Half> acos() const {
+    return values.acos();
+  }
+  Vec256<Half> asin() const {
+    return values.asin();
+  }
+  Vec256<Half> atan() const {
+    return values.atan();
+  }
+  Vec256<Half> erf() const {
+    return values.erf();
+  }
+  Vec256<Half> erfc() const {
+    return values.erfc();
+  }
+  Vec256<Half> exp() const {
+    return values.exp();
+  }
+  Vec256<Half> expm1() const {
+    return values.expm1();
+  }
+  Vec256<Half> log() const {
+    return values.log();
+  }
+  Vec256<Half> log2() const {
+    return values.log2();
+  }
+  Vec256<Half> log10() const {
+    return values.log10();
+  }
+  Vec256<Half> log1p() const {
+    return values.log1p();
+  }
+  Vec256<Half> sin() const {
+    return values.sin();
+  }
+  Vec256<Half> sinh() const {
+    return values.sinh();
+  }
+  Vec256<Half> cos() const {
+    return values.cos();
+  }
+  Vec256<Half> cosh() const {
+    return values.cosh();
+  }
+  Vec256<Half> ceil() const {
+    return values.ceil();
+  }
+  Vec256<Half> floor() const {
+    return values.floor();
+  }
+  Vec256<Half> neg() const {
+    return values.neg();
+  }
+  Vec256<Half> round() const {
+    return values.round();
+  }
+  Vec256<Half> tan() const {
+    return values.tan();
+  }
+  Vec256<Half> tanh() const {
+    return values.tanh();
+  }
+  Vec256<Half> trunc() const {
+    return values.trunc();
+  }
+  Vec256<Half> sqrt() const {
+    return values.sqrt();
+  }
+  Vec256<Half> reciprocal() const {
+    return values.reciprocal();
+  }
+  Vec256<Half> rsqrt() const {
+    return values.rsqrt();
+  }
+};
+
+#undef AT_VEC256_HALF_F16C
+
+template <>
+Vec256<Half> inline operator+(const Vec256<Half>& a, const Vec256<Half>& b) {
+  return Vec256<float>(a) + Vec256<float>(b);
+}
+
+template <>
+Vec256<Half> inline operator-(const Vec256<Half>& a, const Vec256<Half>& b) {
+  return Vec256<float>(a) - Vec256<float>(b);
+}
+
+template <>
+Vec256<Half> inline operator*(const Vec256<Half>& a, const Vec256<Half>& b) {
+  return Vec256<float>(a) * Vec256<float>(b);
+}
+
+template <>
+Vec256<Half> inline operator/(const Vec256<Half>& a, const Vec256<Half>& b) {
+  return Vec256<float>(a) / Vec256<float>(b);
+}
+
+template <>
+Vec256<Half> inline max(const Vec256<Half>& a, const Vec256<Half>& b) {
+  return max(Vec256<float>(a), Vec256<float>(b));
+}
+
+template <>
+Vec256<Half> inline maximum(const Vec256<Half>& a, const Vec256<Half>& b) {
+  return maximum(Vec256<float>(a), Vec256<float>(b));
+}
+
+template <>
+Vec256<Half> inline minimum(const Vec256<Half>& a, const Vec256<Half>& b) {
+  return minimum(Vec256<float>(a), Vec256<float>(b));
+}
+
+}}}
@@ -0,0 +1,229 @@
+#pragma once
+
+#include <cstring>
+#include <functional>
+#include <cmath>
+
+#include "ATen/Utils.h"
+
+#if defined(__GNUC__)
+#define __at_align64__ __attribute__((aligned(64)))
+#elif defined(_WIN32)
+#define __at_align64__ __declspec(align(64))
+#else
+#define __at_align64__
+#endif
+
+namespace at {
+namespace vec512 {
+namespace {
+
+// NOTE: If you specialize on a type, you must define all operations!
+
+// emulates vectorized types
+template <class T>
+struct Vec512 {
+private:
+  T values[64 / sizeof(T)] = {0};
+public:
+  static constexpr int size = 64 / sizeof(T);
+  Vec512() {}
+  Vec512(T val) {
+    for (int i = 0; i != size; i++) {
+      values[i] = val;
+    }
+  }
+  template <int64_t mask_>
+  static Vec512<T> blend(Vec512<T> a, Vec512<T> b) {
+    int64_t mask = mask_;
+    Vec512 vec;
+    for (int64_t i = 0; i < size; i++) {
+      if (mask & 0x01) {
+        vec[i] = b[i];
+      } else {
+        vec[i] = a[i];
+      }
+      mask = mask >> 1;
+    }
+    return vec;
+  }
+  static Vec512<T> set(Vec512<T> a, Vec512<T> b, int64_t count = size) {
+    Vec512 vec;
+    for (int64_t i = 0; i < size; i++) {
+      if (i < count) {
+        vec[i] = b[i];
+      } else {
+        vec[i] = a[i];
+      }
+    }
+    return vec;
+  }
+  static Vec512<T> loadu(const void* ptr) {
+    Vec512 vec;
+    std::memcpy(vec.values, ptr, 64);
+    return vec;
+  }
+  static Vec512<T> loadu(const void* ptr, int64_t count) {
+    Vec512 vec;
+    std::memcpy(vec.values, ptr, count * sizeof(T));
+    return vec;
+  }
+  void store(void* ptr, int count = size) const {
+    std::memcpy(ptr, values, count * sizeof(T));
+  }
+  const T& operator[](int idx) const {
+    return values[idx];
+  }
+  T& operator[](int idx) {
+    return values[idx];
+  }
+  Vec512<T> map(T (*f)(T)) const {
+    Vec512<T> ret;
+    for (int64_t i = 0; i != size; i++) {
+      ret[i] = f(values[i]);
+    }
+    return ret;
+  }
+  Vec512<T> abs() const {
+    Vec512<T> ret;
+    for (int64_t i = 0; i < size; i++) {
+      ret[i] = values[i] < 0 ? -values[i] : values[i];
+    }
+    return ret;
+  }
+  Vec512<T> acos() const {
+    return map(std::acos);
+  }
+  Vec512<T> asin() const {
+    return map(std::asin);
+  }
+  Vec512<T> atan() const {
+    return map(std::atan);
+  }
+  Vec512<T> erf() const {
+    return map(std::erf);
+  }
+  Vec512<T> erfc() const {
+    return map(std::erfc);
+  }
+  Vec512<T> exp() const {
+    return map(std::exp);
+  }
+  Vec512<T> expm1() const {
+    return map(std::expm1);
+  }
+  Vec512<T> log() const {
+    return map(std::log);
+  }
+  Vec512<T> log10() const {
+    return map(std::log10);
+  }
+  Vec512<T> log1p() const {
+    return map(std::log1p);
+  }
+  Vec512<T> log2() const {
+    return map(std::log2);
+  }
+  Vec512<T> ceil() const {
+    return map(std::ceil);
+  }
+  Vec512<T> cos() const {
+    return map(std::cos);
+  }
+  Vec512<T> cosh() const {
+    return map(std::cosh);
+  }
+  Vec512<T> floor() const {
+    return map(std::floor);
+  }
+  Vec512<T> neg() const {
+    return map([](T x) { return -x; });
+  }
+  Vec512<T> round() const {
+    return map(std::round);
+  }
+  Vec512<T> sin() const {
+    return map(std::sin);
+  }
+  Vec512<T> sinh() const {
+    return map(std::sinh);
+  }
+  Vec512<T> tan() const {
+    return map(std::tan);
+  }
+  Vec512<T> tanh() const {
+    return map(std::tanh);
+  }
+  Vec512<T> trunc() const {
+    return map(std::trunc);
+  }
+  Vec512<T> sqrt() const {
+    return map(std::sqrt);
+  }
+  Vec512<T> reciprocal() const {
+    return map([](T x) { return (T)(1) / x; });
+  }
+  Vec512<T> rsqrt() const {
+    return map([](T x) { return 1 / std::sqrt(x); });
+  }
+};
+
+template <class T> Vec512<T> operator+(const Vec512<T> &a, const Vec512<T> &b) {
+  Vec512<T> c = Vec512<T>();
+  for (int i = 0; i != Vec512<T>::size; i++) {
+    c[i] = a[i] + b[i];
+  }
+  return c;
+}
+
+template <class T> Vec512<T> operator-(const Vec512<T> &a, const Vec512<T> &b) {
+  Vec512<T> c = Vec512<T>();
+  for (int i = 0; i != Vec512<T>::size; i++) {
+    c[i] = a[i] - b[i];
+  }
+  return c;
+}
+
+template <class T> Vec512<T> operator*(const Vec512<T> &a, const Vec512<T> &b) {
+  Vec512<T> c = Vec512<T>();
+  for (int i = 0; i != Vec512<T>::size; i++) {
+    c[i] = a[i] * b[i];
+  }
+  return c;
+}
+
+template <class T> Vec512<T> operator/(const Vec512<T> &a, const Vec512<T> &b) __ubsan_ignore_float_divide_by_zero__ {
+  Vec512<T> c = Vec512<T>();
+  for (int i = 0; i != Vec512<T>::size; i++) {
+    c[i] = a[i] / b[i];
+  }
+  return c;
+}
+
+template <class T> Vec512<T> max(const Vec512<T> &a, const Vec512<T> &b) {
+  Vec512<T> c = Vec512<T>();
+  for (int i = 0; i != Vec512<T>::size; i++) {
+    c[i] = std::max(a[i], b[i]);
+  }
+  return c;
+}
+
+// maximum and minimum propagate NaN if either input is NaN, like
+// torch.max and torch.min do; max above doesn't
+template <class T> Vec512<T> maximum(const Vec512<T> &a, const Vec512<T> &b) {
+  Vec512<T> c = Vec512<T>();
+  for (int i = 0; i != Vec512<T>::size; i++) {
+    c[i] = (a[i] > b[i] || a[i] != a[i]) ? a[i] : b[i];
+  }
+  return c;
+}
+
+template <class T> Vec512<T> minimum(const Vec512<T> &a, const Vec512<T> &b) {
+  Vec512<T> c = Vec512<T>();
+  for (int i = 0; i != Vec512<T>::size; i++) {
+    c[i] = (a[i] < b[i] || a[i] != a[i]) ? a[i] : b[i];
+  }
+  return c;
+}
+
+}}}
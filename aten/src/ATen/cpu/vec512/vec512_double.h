@@ -0,0 +1,184 @@
+#pragma once
+
+#include "ATen/cpu/vec256/intrinsics.h"
+#include "vec512_base.h"
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+#include <sleef.h>
+#endif
+
+namespace at {
+namespace vec512 {
+namespace {
+
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+
+template <> class Vec512<double> {
+private:
+  __m512d values;
+  static __mmask8 count_mask(int64_t count) {
+    return static_cast<__mmask8>((1 << count) - 1);
+  }
+public:
+  static constexpr int64_t size = 8;
+  Vec512() {}
+  Vec512(__m512d v) : values(v) {}
+  Vec512(double val) {
+    values = _mm512_set1_pd(val);
+  }
+  operator __m512d() const {
+    return values;
+  }
+  template <int64_t mask>
+  static Vec512<double> blend(Vec512<double> a, Vec512<double> b) {
+    return _mm512_mask_blend_pd(static_cast<__mmask8>(mask), a.values, b.values);
+  }
+  static Vec512<double> set(Vec512<double> a, Vec512<double> b, int64_t count = size) {
+    if (count >= size)
+      return b;
+    return _mm512_mask_blend_pd(count_mask(count), a.values, b.values);
+  }
+  static Vec512<double> loadu(const void* ptr, int64_t count = size) {
+    if (count == size)
+      return _mm512_loadu_pd(reinterpret_cast<const double*>(ptr));
+    return _mm512_maskz_loadu_pd(count_mask(count), ptr);
+  }
+  void store(void* ptr, int64_t count = size) const {
+    if (count == size) {
+      _mm512_storeu_pd(reinterpret_cast<double*>(ptr), values);
+    } else {
+      _mm512_mask_storeu_pd(ptr, count_mask(count), values);
+    }
+  }
+  const double& operator[](int idx) const  = delete;
+  double& operator[](int idx) = delete;
+  Vec512<double> map(double (*f)(double)) const {
+    __at_align64__ double tmp[8];
+    store(tmp);
+    for (int64_t i = 0; i < 8; i++) {
+      tmp[i] = f(tmp[i]);
+    }
+    return loadu(tmp);
+  }
+  Vec512<double> abs() const {
+    auto sign = _mm512_castpd_si512(_mm512_set1_pd(-0.0));
+    return _mm512_castsi512_pd(
+        _mm512_andnot_si512(sign, _mm512_castpd_si512(values)));
+  }
+  Vec512<double> acos() const {
+    return Vec512<double>(Sleef_acosd8_u10(values));
+  }
+  Vec512<double> asin() const {
+    return Vec512<double>(Sleef_asind8_u10(values));
+  }
+  Vec512<double> atan() const {
+    return Vec512<double>(Sleef_atand8_u10(values));
+  }
+  Vec512<double> erf() const {
+    return Vec512<double>(Sleef_erfd8_u10(values));
+  }
+  Vec512<double> erfc() const {
+    return Vec512<double>(Sleef_erfcd8_u15(values));
+  }
+  Vec512<double> exp() const {
+    return Vec512<double>(Sleef_expd8_u10(values));
+  }
+  Vec512<double> expm1() const {
+    return Vec512<double>(Sleef_expm1d8_u10(values));
+  }
+  Vec512<double> log() const {
+    return Vec512<double>(Sleef_logd8_u10(values));
+  }
+  Vec512<double> log2() const {
+    return Vec512<double>(Sleef_log2d8_u10(values));
+  }
+  Vec512<double> log10() const {
+    return Vec512<double>(Sleef_log10d8_u10(values));
+  }
+  Vec512<double> log1p() const {
+    return Vec512<double>(Sleef_log1pd8_u10(values));
+  }
+  Vec512<double> sin() const {
+    return map(std::sin);
+  }
+  Vec512<double> sinh() const {
+    return map(std::sinh);
+  }
+  Vec512<double> cos() const {
+    return map(std::cos);
+  }
+  Vec512<double> cosh() const {
+    return map(std::cosh);
+  }
+  Vec512<double> ceil() const {
+    return _mm512_roundscale_pd(values, (_MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<double> floor() const {
+    return _mm512_roundscale_pd(values, (_MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<double> neg() const {
+    return _mm512_castsi512_pd(_mm512_xor_si512(
+        _mm512_castpd_si512(_mm512_set1_pd(-0.0)), _mm512_castpd_si512(values)));
+  }
+  Vec512<double> round() const {
+    return _mm512_roundscale_pd(values, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+  Vec512<double> tan() const {
+    return map(std::tan);
+  }
+  Vec512<double> tanh() const {
+    return Vec512<double>(Sleef_tanhd8_u10(values));
+  }
+  Vec512<double> trunc() const {
+    return _mm512_roundscale_pd(values, (_MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+  }
+  Vec512<double> sqrt() const {
+    return _mm512_sqrt_pd(values);
+  }
+  Vec512<double> reciprocal() const {
+    return _mm512_div_pd(_mm512_set1_pd(1), values);
+  }
+  Vec512<double> rsqrt() const {
+    return _mm512_div_pd(_mm512_set1_pd(1), _mm512_sqrt_pd(values));
+  }
+};
+
+template <>
+Vec512<double> inline operator+(const Vec512<double>& a, const Vec512<double>& b) {
+  return _mm512_add_pd(a, b);
+}
+
+template <>
+Vec512<double> inline operator-(const Vec512<double>& a, const Vec512<double>& b) {
+  return _mm512_sub_pd(a, b);
+}
+
+template <>
+Vec512<double> inline operator*(const Vec512<double>& a, const Vec512<double>& b) {
+  return _mm512_mul_pd(a, b);
+}
+
+template <>
+Vec512<double> inline operator/(const Vec512<double>& a, const Vec512<double>& b) {
+  return _mm512_div_pd(a, b);
+}
+
+template <>
+Vec512<double> inline max(const Vec512<double>& a, const Vec512<double>& b) {
+  return _mm512_max_pd(a, b);
+}
+
+template <>
+Vec512<double> inline maximum(const Vec512<double>& a, const Vec512<double>& b) {
+  auto isnan = _mm512_cmp_pd_mask(a, b, _CMP_UNORD_Q);
+  return _mm512_mask_blend_pd(isnan, _mm512_max_pd(a, b), _mm512_set1_pd(NAN));
+}
+
+template <>
+Vec512<double> inline minimum(const Vec512<double>& a, const Vec512<double>& b) {
+  auto isnan = _mm512_cmp_pd_mask(a, b, _CMP_UNORD_Q);
+  return _mm512_mask_blend_pd(isnan, _mm512_min_pd(a, b), _mm512_set1_pd(NAN));
+}
+
+#endif
+
+}}}
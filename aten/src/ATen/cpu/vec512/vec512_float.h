@@ -0,0 +1,184 @@
+#pragma once
+
+#include "ATen/cpu/vec256/intrinsics.h"
+#include "vec512_base.h"
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+#include <sleef.h>
+#endif
+
+namespace at {
+namespace vec512 {
+namespace {
+
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+
+template <> class Vec512<float> {
+private:
+  __m512 values;
+  static __mmask16 count_mask(int64_t count) {
+    return static_cast<__mmask16>((1 << count) - 1);
+  }
+public:
+  static constexpr int64_t size = 16;
+  Vec512() {}
+  Vec512(__m512 v) : values(v) {}
+  Vec512(float val) {
+    values = _mm512_set1_ps(val);
+  }
+  operator __m512() const {
+    return values;
+  }
+  template <int64_t mask>
+  static Vec512<float> blend(Vec512<float> a, Vec512<float> b) {
+    return _mm512_mask_blend_ps(static_cast<__mmask16>(mask), a.values, b.values);
+  }
+  static Vec512<float> set(Vec512<float> a, Vec512<float> b, int64_t count = size) {
+    if (count >= size)
+      return b;
+    return _mm512_mask_blend_ps(count_mask(count), a.values, b.values);
+  }
+  static Vec512<float> loadu(const void* ptr, int64_t count = size) {
+    if (count == size)
+      return _mm512_loadu_ps(reinterpret_cast<const float*>(ptr));
+    return _mm512_maskz_loadu_ps(count_mask(count), ptr);
+  }
+  void store(void* ptr, int64_t count = size) const {
+    if (count == size) {
+      _mm512_storeu_ps(reinterpret_cast<float*>(ptr), values);
+    } else {
+      _mm512_mask_storeu_ps(ptr, count_mask(count), values);
+    }
+  }
+  const float& operator[](int idx) const  = delete;
+  float& operator[](int idx) = delete;
+  Vec512<float> map(float (*f)(float)) const {
+    __at_align64__ float tmp[16];
+    store(tmp);
+    for (int64_t i = 0; i < 16; i++) {
+      tmp[i] = f(tmp[i]);
+    }
+    return loadu(tmp);
+  }
+  Vec512<float> abs() const {
+    auto sign = _mm512_castps_si512(_mm512_set1_ps(-0.f));
+    return _mm512_castsi512_ps(
+        _mm512_andnot_si512(sign, _mm512_castps_si512(values)));
+  }
+  Vec512<float> acos() const {
+    return Vec512<float>(Sleef_acosf16_u10(values));
+  }
+  Vec512<float> asin() const {
+    return Vec512<float>(Sleef_asinf16_u10(values));
+  }
+  Vec512<float> atan() const {
+    return Vec512<float>(Sleef_atanf16_u10(values));
+  }
+  Vec512<float> erf() const {
+    return Vec512<float>(Sleef_erff16_u10(values));
+  }
+  Vec512<float> erfc() const {
+    return Vec512<float>(Sleef_erfcf16_u15(values));
+  }
+  Vec512<float> exp() const {
+    return Vec512<float>(Sleef_expf16_u10(values));
+  }
+  Vec512<float> expm1() const {
+    return Vec512<float>(Sleef_expm1f16_u10(values));
+  }
+  Vec512<float> log() const {
+    return Vec512<float>(Sleef_logf16_u10(values));
+  }
+  Vec512<float> log2() const {
+    return Vec512<float>(Sleef_log2f16_u10(values));
+  }
+  Vec512<float> log10() const {
+    return Vec512<float>(Sleef_log10f16_u10(values));
+  }
+  Vec512<float> log1p() const {
+    return Vec512<float>(Sleef_log1pf16_u10(values));
+  }
+  Vec512<float> sin() const {
+    return map(std::sin);
+  }
+  Vec512<float> sinh() const {
+    return map(std::sinh);
+  }
+  Vec512<float> cos() const {
+    return map(std::cos);
+  }
+  Vec512<float> cosh() const {
+    return map(std::cosh);
+  }
+  Vec512<float> ceil() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> floor() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> neg() const {
+    return _mm512_castsi512_ps(_mm512_xor_si512(
+        _mm512_castps_si512(_mm512_set1_ps(-0.f)), _mm512_castps_si512(values)));
+  }
+  Vec512<float> round() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> tan() const {
+    return map(std::tan);
+  }
+  Vec512<float> tanh() const {
+    return Vec512<float>(Sleef_tanhf16_u10(values));
+  }
+  Vec512<float> trunc() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> sqrt() const {
+    return _mm512_sqrt_ps(values);
+  }
+  Vec512<float> reciprocal() const {
+    return _mm512_div_ps(_mm512_set1_ps(1), values);
+  }
+  Vec512<float> rsqrt() const {
+    return _mm512_div_ps(_mm512_set1_ps(1), _mm512_sqrt_ps(values));
+  }
+};
+
+template <>
+Vec512<float> inline operator+(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_add_ps(a, b);
+}
+
+template <>
+Vec512<float> inline operator-(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_sub_ps(a, b);
+}
+
+template <>
+Vec512<float> inline operator*(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_mul_ps(a, b);
+}
+
+template <>
+Vec512<float> inline operator/(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_div_ps(a, b);
+}
+
+template <>
+Vec512<float> inline max(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_max_ps(a, b);
+}
+
+template <>
+Vec512<float> inline maximum(const Vec512<float>& a, const Vec512<float>& b) {
+  auto isnan = _mm512_cmp_ps_mask(a, b, _CMP_UNORD_Q);
+  return _mm512_mask_blend_ps(isnan, _mm512_max_ps(a, b), _mm512_set1_ps(NAN));
+}
+
+template <>
+Vec512<float> inline minimum(const Vec512<float>& a, const Vec512<float>& b) {
+  auto isnan = _mm512_cmp_ps_mask(a, b, _CMP_UNORD_Q);
+  return _mm512_mask_blend_ps(isnan, _mm512_min_ps(a, b), _mm512_set1_ps(NAN));
+}
+
+#endif
+
+}}}
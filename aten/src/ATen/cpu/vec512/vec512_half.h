@@ -0,0 +1,198 @@
+#pragma once
+
+#include "ATen/cpu/vec256/intrinsics.h"
+#include "vec512_base.h"
+#include "vec512_float.h"
+#include "ATen/Half.h"
+
+namespace at {
+namespace vec512 {
+namespace {
+
+// Vec512<Half> holds 16 halves widened to a Vec512<float>, like
+// Vec256<Half> (see vec256/vec256_half.h). AVX512F converts between them.
+
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+#define AT_VEC512_HALF_CVT
+#endif
+
+template <> class Vec512<Half> {
+private:
+  Vec512<float> values;
+public:
+  static constexpr int64_t size = Vec512<float>::size;
+  Vec512() {}
+  Vec512(Vec512<float> v) : values(v) {}
+  Vec512(Half val) : values(static_cast<float>(val)) {}
+  operator Vec512<float>() const {
+    return values;
+  }
+  template <int64_t mask>
+  static Vec512<Half> blend(Vec512<Half> a, Vec512<Half> b) {
+    return Vec512<float>::blend<mask>(a.values, b.values);
+  }
+  static Vec512<Half> set(Vec512<Half> a, Vec512<Half> b, int64_t count = size) {
+    return Vec512<float>::set(a.values, b.values, count);
+  }
+  static Vec512<Half> loadu(const void* ptr, int64_t count = size) {
+#ifdef AT_VEC512_HALF_CVT
+    if (count == size) {
+      return Vec512<float>(_mm512_cvtph_ps(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr))));
+    }
+    __at_align64__ Half tmp_values[size] = {};
+    std::memcpy(tmp_values, ptr, count * sizeof(Half));
+    return Vec512<float>(_mm512_cvtph_ps(
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(tmp_values))));
+#else
+    const Half* src = reinterpret_cast<const Half*>(ptr);
+    __at_align64__ float tmp_values[size] = {};
+    for (int64_t i = 0; i < count; i++) {
+      tmp_values[i] = src[i];
+    }
+    return Vec512<float>::loadu(tmp_values);
+#endif
+  }
+  void store(void* ptr, int64_t count = size) const {
+#ifdef AT_VEC512_HALF_CVT
+    __m512 v = values;
+    __m256i halves = _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+    if (count == size) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), halves);
+    } else {
+      __at_align64__ Half tmp_values[size];
+      _mm256_store_si256(reinterpret_cast<__m256i*>(tmp_values), halves);
+      std::memcpy(ptr, tmp_values, count * sizeof(Half));
+    }
+#else
+    __at_align64__ float tmp_values[size];
+    values.store(tmp_values);
+    Half* dst = reinterpret_cast<Half*>(ptr);
+    for (int64_t i = 0; i < count; i++) {
+      dst[i] = tmp_values[i];
+    }
+#endif
+  }
+  const Half& operator[](int idx) const  = delete;
+  Half& operator[](int idx) = delete;
+  Vec512<Half> map(float (*f)(float)) const {
+    return values.map(f);
+  }
+  Vec512<Half> abs() const {
+    return values.abs();
+  }
+  Vec512<Half> acos() const {
+    return values.acos();
+  }
+  Vec512<Half> asin() const {
+    return values.asin();
+  }
+  Vec512<Half> atan() const {
+    return values.atan();
+  }
+  Vec512<Half> erf() const {
+    return values.erf();
+  }
+  Vec512<Half> erfc() const {
+    return values.erfc();
+  }
+  Vec512<Half> exp() const {
+    return values.exp();
+  }
+  Vec512<Half> expm1() const {
+    return values.expm1();
+  }
+  Vec512<Half> log() const {
+    return values.log();
+  }
+  Vec512<Half> log2() const {
+    return values.log2();
+  }
+  Vec512<Half> log10() const {
+    return values.log10();
+  }
+  Vec512<Half> log1p() const {
+    return values.log1p();
+  }
+  Vec512<Half> sin() const {
+    return values.sin();
+  }
+  Vec512<Half> sinh() const {
+    return values.sinh();
+  }
+  Vec512<Half> cos() const {
+    return values.cos();
+  }
+  Vec512<Half> cosh() const {
+    return values.cosh();
+  }
+  Vec512<Half> ceil() const {
+    return values.ceil();
+  }
+  Vec512<Half> floor() const {
+    return values.floor();
+  }
+  Vec512<Half> neg() const {
+    return values.neg();
+  }
+  Vec512<Half> round() const {
+    return values.round();
+  }
+  Vec512<Half> tan() const {
+    return values.tan();
+  }
+  Vec512<Half> tanh() const {
+    return values.tanh();
+  }
+  Vec512<Half> trunc() const {
+    return values.trunc();
+  }
+  Vec512<Half> sqrt() const {
+    return values.sqrt();
+  }
+  Vec512<Half> reciprocal() const {
+    return values.reciprocal();
+  }
+  Vec512<Half> rsqrt() const {
+    return values.rsqrt();
+  }
+};
+
+#undef AT_VEC512_HALF_CVT
+
+template <>
+Vec512<Half> inline operator+(const Vec512<Half>& a, const Vec512<Half>& b) {
+  return Vec512<float>(a) + Vec512<float>(b);
+}
+
+template <>
+Vec512<Half> inline operator-(const Vec512<Half>& a, const Vec512<Half>& b) {
+  return Vec512<float>(a) - Vec512<float>(b);
+}
+
+template <>
+Vec512<Half> inline operator*(const Vec512<Half>& a, const Vec512<Half>& b) {
+  return Vec512<float>(a) * Vec512<float>(b);
+}
+
+template <>
+Vec512<Half> inline operator/(const Vec512<Half>& a, const Vec512<Half>& b) {
+  return Vec512<float>(a) / Vec512<float>(b);
+}
+
+template <>
+Vec512<Half> inline max(const Vec512<Half>& a, const Vec512<Half>& b) {
+  return max(Vec512<float>(a), Vec512<float>(b));
+}
+
+template <>
+Vec512<Half> inline maximum(const Vec512<Half>& a, const Vec512<Half>& b) {
+  return maximum(Vec512<float>(a), Vec512<float>(b));
+}
+
+template <>
+Vec512<Half> inline minimum(const Vec512<Half>& a, const Vec512<Half>& b) {
+  return minimum(Vec512<float>(a), Vec512<float>(b));
+}
+
+}}}
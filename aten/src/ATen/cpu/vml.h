@@ -52,6 +52,18 @@ namespace {
 
 using namespace vec256;
 
+// The type of the libm functions that compute scalar_t, for
+// DL_RUNTIME_BUG. Vec256<Half> computes in float.
+template <typename scalar_t>
+struct libm_type {
+  using type = scalar_t;
+};
+
+template <>
+struct libm_type<Half> {
+  using type = float;
+};
+
 template <typename scalar_t>
 inline void vrsqrt(scalar_t* out, scalar_t* in, int64_t size) {
   parallel_for(0, size, 2048, [out, in](int64_t begin, int64_t end) {
@@ -76,7 +88,7 @@ inline void vrsqrt(scalar_t* out, scalar_t* in, int64_t size) {
 #define IMPLEMENT_VML_BUG(op)                                          \
   template <typename scalar_t>                                          \
   inline void v##op(scalar_t* out, const scalar_t* in, int64_t size) {  \
-    DL_RUNTIME_BUG(op, scalar_t)                                        \
+    DL_RUNTIME_BUG(op, typename libm_type<scalar_t>::type)              \
     parallel_for(0, size, 2048, [out, in](int64_t begin, int64_t end) { \
       map([](const Vec256<scalar_t>& x) { return x.op(); },             \
           out + begin,                                                  \
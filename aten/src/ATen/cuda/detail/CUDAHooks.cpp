@@ -183,33 +183,49 @@ double CUDAHooks::batchnormMinEpsilonCuDNN() const {
 #endif
 }
 
-int64_t CUDAHooks::cuFFTGetPlanCacheMaxSize() const {
+int64_t CUDAHooks::cuFFTGetPlanCacheMaxSize(int64_t device_index) const {
 #ifndef __HIP_PLATFORM_HCC__
-  return at::native::detail::cufft_get_plan_cache_max_size_impl();
+  return at::native::detail::cufft_get_plan_cache_max_size_impl(device_index);
 #else
   AT_ERROR("cuFFT with HIP is not supported");
 #endif
 }
 
-void CUDAHooks::cuFFTSetPlanCacheMaxSize(int64_t max_size) const {
+void CUDAHooks::cuFFTSetPlanCacheMaxSize(int64_t device_index, int64_t max_size) const {
 #ifndef __HIP_PLATFORM_HCC__
-  at::native::detail::cufft_set_plan_cache_max_size_impl(max_size);
+  at::native::detail::cufft_set_plan_cache_max_size_impl(device_index, max_size);
 #else
   AT_ERROR("cuFFT with HIP is not supported");
 #endif
 }
 
-int64_t CUDAHooks::cuFFTGetPlanCacheSize() const {
+int64_t CUDAHooks::cuFFTGetPlanCacheSize(int64_t device_index) const {
 #ifndef __HIP_PLATFORM_HCC__
-  return at::native::detail::cufft_get_plan_cache_size_impl();
+  return at::native::detail::cufft_get_plan_cache_size_impl(device_index);
 #else
   AT_ERROR("cuFFT with HIP is not supported");
 #endif
 }
 
-void CUDAHooks::cuFFTClearPlanCache() const {
+int64_t CUDAHooks::cuFFTGetPlanCacheHits(int64_t device_index) const {
 #ifndef __HIP_PLATFORM_HCC__
-  at::native::detail::cufft_clear_plan_cache_impl();
+  return at::native::detail::cufft_get_plan_cache_hits_impl(device_index);
+#else
+  AT_ERROR("cuFFT with HIP is not supported");
+#endif
+}
+
+int64_t CUDAHooks::cuFFTGetPlanCacheMisses(int64_t device_index) const {
+#ifndef __HIP_PLATFORM_HCC__
+  return at::native::detail::cufft_get_plan_cache_misses_impl(device_index);
+#else
+  AT_ERROR("cuFFT with HIP is not supported");
+#endif
+}
+
+void CUDAHooks::cuFFTClearPlanCache(int64_t device_index) const {
+#ifndef __HIP_PLATFORM_HCC__
+  at::native::detail::cufft_clear_plan_cache_impl(device_index);
 #else
   AT_ERROR("cuFFT with HIP is not supported");
 #endif
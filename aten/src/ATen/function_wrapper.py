@@ -448,6 +448,9 @@ FunctionOption = TypedDict('FunctionOption', {
     'device_guard_declaration': str,
     'with_gil': bool,
     'cpu_half': bool,
+    # NN functions whose CPU implementation is a native function rather
+    # than THNN (see nn_parse.py)
+    'cpu_native': bool,
     'deprecated': bool,
     'formals_list': List[AtFormal],
     'formals_with_defaults': List[str],
@@ -798,6 +801,10 @@ def create_generic(top_env, declarations):
                 TYPE_METHOD_DECLARATION_ABSTRACT.substitute(env))
             top_env['type_method_definitions'].append(
                 TYPE_METHOD_DEFINITION_ABSTRACT.substitute(env))
+            if option.get('cpu_native', False):
+                option['native_type_method_dispatch'] = option['api_name'] + '_cpu'
+                top_env['native_function_declarations'].append(
+                    NATIVE_DECLARATION.substitute(env))
         else:
             top_env['type_method_declarations'].append(
                 TYPE_METHOD_DECLARATION_BROADCAST.substitute(env))
@@ -1475,7 +1482,11 @@ def create_derived(backend_type_env, declarations):
                 backend_type_env['ScalarName'])
         if pair in option['backend_type_pairs']:
             env = nested_dict(option, backend_type_env)
-            body = emit_body(env, option)  # type: ignore
+            if option.get('cpu_native', False) and not is_cuda:
+                body = ['return at::native::{}_cpu({});'.format(
+                    option['api_name'], ', '.join(option['actuals']))]
+            else:
+                body = emit_body(env, option)  # type: ignore
             option['type_definition_body'] = body
             type_object_declarations.append(
                 TYPE_DERIVED_DECLARATION.substitute(env))
@@ -0,0 +1,72 @@
+#include "ATen/ATen.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/native/TensorIterator.h"
+#include "ATen/native/cpu/BinaryOpsKernel.h"
+
+// Dense CPU kernels for the same-size s_native_ binary ops. The functions
+// in LegacyBridge.cpp broadcast the inputs before calling these, and call TH
+// for whatever they don't handle.
+
+namespace at { namespace native {
+
+Tensor& s_add_out_cpu(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  auto iter = TensorIterator::binary_op(result, self, other);
+  add_kernel(iter, alpha);
+  return result;
+}
+
+Tensor s_add_cpu(const Tensor& self, const Tensor& other, Scalar alpha) {
+  Tensor result = self.type().tensor();
+  return s_add_out_cpu(result, self, other, alpha);
+}
+
+Tensor& s_add__cpu(Tensor& self, const Tensor& other, Scalar alpha) {
+  return s_add_out_cpu(self, self, other, alpha);
+}
+
+Tensor& s_sub_out_cpu(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  auto iter = TensorIterator::binary_op(result, self, other);
+  sub_kernel(iter, alpha);
+  return result;
+}
+
+Tensor s_sub_cpu(const Tensor& self, const Tensor& other, Scalar alpha) {
+  Tensor result = self.type().tensor();
+  return s_sub_out_cpu(result, self, other, alpha);
+}
+
+Tensor& s_sub__cpu(Tensor& self, const Tensor& other, Scalar alpha) {
+  return s_sub_out_cpu(self, self, other, alpha);
+}
+
+Tensor& s_mul_out_cpu(Tensor& result, const Tensor& self, const Tensor& other) {
+  auto iter = TensorIterator::binary_op(result, self, other);
+  mul_kernel(iter);
+  return result;
+}
+
+Tensor s_mul_cpu(const Tensor& self, const Tensor& other) {
+  Tensor result = self.type().tensor();
+  return s_mul_out_cpu(result, self, other);
+}
+
+Tensor& s_mul__cpu(Tensor& self, const Tensor& other) {
+  return s_mul_out_cpu(self, self, other);
+}
+
+Tensor& s_div_out_cpu(Tensor& result, const Tensor& self, const Tensor& other) {
+  auto iter = TensorIterator::binary_op(result, self, other);
+  div_kernel(iter);
+  return result;
+}
+
+Tensor s_div_cpu(const Tensor& self, const Tensor& other) {
+  Tensor result = self.type().tensor();
+  return s_div_out_cpu(result, self, other);
+}
+
+Tensor& s_div__cpu(Tensor& self, const Tensor& other) {
+  return s_div_out_cpu(self, self, other);
+}
+
+}} // namespace at::native
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "ATen/ATen.h"
+
+namespace at { namespace native {
+
+// The CPU pooling and upsampling kernels take 4-D (N, C, H, W) tensors that
+// are either contiguous or channels-last: contiguous in (N, H, W, C) order and
+// viewed as (N, C, H, W), i.e. x.permute({0, 2, 3, 1}).contiguous().permute({0, 3, 1, 2}).
+// The channels-last kernels vectorize over C.
+
+// Whether the kernels should run t as channels-last. A tensor that is also
+// contiguous, e.g. with C == 1, is run as contiguous.
+static inline bool is_channels_last(const Tensor& t) {
+  return t.dim() == 4 && !t.is_contiguous() && t.permute({0, 2, 3, 1}).is_contiguous();
+}
+
+static inline bool has_layout(const Tensor& t, bool channels_last) {
+  return channels_last ? t.permute({0, 2, 3, 1}).is_contiguous() : t.is_contiguous();
+}
+
+// t itself, or a copy of it with the layout.
+static inline Tensor to_layout(const Tensor& t, bool channels_last) {
+  if (has_layout(t, channels_last)) {
+    return t;
+  }
+  return channels_last ? t.permute({0, 2, 3, 1}).contiguous().permute({0, 3, 1, 2})
+                       : t.contiguous();
+}
+
+// Resizes out to sizes, with the layout if it has to be resized. Outputs that
+// already have the sizes keep their strides, like resize_ does.
+static inline void resize_with_layout_(Tensor& out, IntList sizes, bool channels_last) {
+  if (out.sizes().equals(sizes)) {
+    return;
+  }
+  if (!channels_last) {
+    out.resize_(sizes);
+    return;
+  }
+  const int64_t C = sizes[1], H = sizes[2], W = sizes[3];
+  out.resize_({sizes[0] * C * H * W});
+  out.as_strided_(sizes, {C * H * W, 1, W * C, C});
+}
+
+// out resized to sizes if that gives it the layout, or else a new tensor
+// with the layout whose values the caller copies to out with copy_back_.
+static inline Tensor output_with_layout(Tensor& out, IntList sizes, bool channels_last) {
+  resize_with_layout_(out, sizes, channels_last);
+  if (has_layout(out, channels_last)) {
+    return out;
+  }
+  Tensor result = out.type().tensor();
+  resize_with_layout_(result, sizes, channels_last);
+  return result;
+}
+
+static inline void copy_back_(Tensor& out, const Tensor& result) {
+  if (result.unsafeGetTensorImpl() != out.unsafeGetTensorImpl()) {
+    out.copy_(result);
+  }
+}
+
+}} // namespace at::native
@@ -0,0 +1,131 @@
+// Dropout that keeps one bit per element for backward.
+//
+// _fused_dropout returns the output and a byte mask of ceil(numel / 8)
+// bytes, where bit b of byte j is set if element 8 * j + b is kept. The
+// random bits come from a Philox stream whose key is drawn from the
+// generator, so the input is processed in parallel without holding the
+// generator lock.
+
+#include "ATen/ATen.h"
+#include "ATen/CPUGenerator.h"
+#include "ATen/CheckGenerator.h"
+#include "ATen/Dispatch.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/Parallel.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "TH/THGenerator.hpp"
+#include "TH/THPhilox.h"
+#include "TH/THRandom.h"
+
+namespace at {
+namespace native {
+
+namespace {
+
+uint64_t dropout_philox_key(Generator* gen) {
+  auto default_gen = &globalContext().defaultGenerator(Backend::CPU);
+  THGenerator* generator =
+      check_generator<CPUGenerator>(gen, default_gen)->generator;
+  std::lock_guard<std::mutex> lock(generator->mutex);
+  return THRandom_random64(generator);
+}
+
+void check_dropout_probability(double p) {
+  AT_CHECK(
+      p > 0 && p < 1,
+      "_fused_dropout: probability has to be in (0, 1), but got ", p);
+}
+
+template <typename scalar_t>
+void fused_dropout_cpu_kernel(
+    const scalar_t* input,
+    scalar_t* output,
+    uint8_t* mask,
+    int64_t numel,
+    double p,
+    uint64_t key) {
+  const scalar_t scale = 1 / (1 - p);
+  // element 8 * j + b is kept if its 32 random bits, word b % 4 of Philox
+  // block 2 * j + b / 4, are below (1 - p) * 2^32
+  const double threshold = (1 - p) * 4294967296.0;
+  parallel_for(0, divup(numel, 8), internal::GRAIN_SIZE / 8, [&](int64_t begin, int64_t end) {
+    for (int64_t j = begin; j < end; ++j) {
+      uint32_t bits[8];
+      THPhilox_block(key, 2 * j, bits);
+      THPhilox_block(key, 2 * j + 1, bits + 4);
+      const int64_t count = std::min<int64_t>(8, numel - 8 * j);
+      uint8_t byte = 0;
+      for (int64_t b = 0; b < count; ++b) {
+        const bool keep = bits[b] < threshold;
+        byte |= keep << b;
+        output[8 * j + b] = keep ? input[8 * j + b] * scale : scalar_t(0);
+      }
+      mask[j] = byte;
+    }
+  });
+}
+
+template <typename scalar_t>
+void fused_dropout_backward_cpu_kernel(
+    const scalar_t* grad,
+    const uint8_t* mask,
+    scalar_t* grad_input,
+    int64_t numel,
+    double p) {
+  const scalar_t scale = 1 / (1 - p);
+  parallel_for(0, divup(numel, 8), internal::GRAIN_SIZE / 8, [&](int64_t begin, int64_t end) {
+    for (int64_t j = begin; j < end; ++j) {
+      const int64_t count = std::min<int64_t>(8, numel - 8 * j);
+      for (int64_t b = 0; b < count; ++b) {
+        grad_input[8 * j + b] =
+            (mask[j] >> b) & 1 ? grad[8 * j + b] * scale : scalar_t(0);
+      }
+    }
+  });
+}
+
+} // namespace
+
+std::tuple<Tensor, Tensor> _fused_dropout_cpu(const Tensor& self, double p, Generator* gen) {
+  check_dropout_probability(p);
+  auto input = self.contiguous();
+  Tensor output = at::empty_like(input);
+  Tensor mask = at::empty({divup(input.numel(), 8)}, input.type().toScalarType(kByte));
+  const uint64_t key = dropout_philox_key(gen);
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "_fused_dropout", [&] {
+    fused_dropout_cpu_kernel<scalar_t>(
+        input.data<scalar_t>(),
+        output.data<scalar_t>(),
+        mask.data<uint8_t>(),
+        input.numel(),
+        p,
+        key);
+  });
+  return std::make_tuple(output, mask);
+}
+
+Tensor _fused_dropout_backward_cpu(const Tensor& grad_output, const Tensor& mask, double p) {
+  check_dropout_probability(p);
+  AT_CHECK(
+      mask.numel() == divup(grad_output.numel(), 8),
+      "_fused_dropout_backward: expected a mask of ", divup(grad_output.numel(), 8),
+      " bytes for ", grad_output.numel(), " elements, but got ", mask.numel());
+  auto grad_contig = grad_output.contiguous();
+  auto mask_contig = mask.contiguous();
+  Tensor grad_input = at::empty_like(grad_contig);
+  AT_DISPATCH_FLOATING_TYPES(grad_output.type(), "_fused_dropout_backward", [&] {
+    fused_dropout_backward_cpu_kernel<scalar_t>(
+        grad_contig.data<scalar_t>(),
+        mask_contig.data<uint8_t>(),
+        grad_input.data<scalar_t>(),
+        grad_contig.numel(),
+        p);
+  });
+  return grad_input;
+}
+
+} // namespace native
+} // namespace at
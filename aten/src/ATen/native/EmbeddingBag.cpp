@@ -1,6 +1,7 @@
 #include "ATen/ATen.h"
 #include "ATen/TensorUtils.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/native/cpu/EmbeddingBagKernel.h"
 
 #include "TH/THBlasUtils.h"
 
@@ -31,28 +32,12 @@ static void make_offset2bag(const Tensor &offsets, const Tensor &indices,
   offset2bag = offset2bag.cumsum(0);     // offset2bag = [0 0 1 1 2]
 }
 
-// This function combines index_select (using select_indices as the index) and
-// index_add (using add_indices as the index), without creating an intermediary
-// tensor to hold the selected embeddings
-template<typename T>
-static void index_select_add(const Tensor &select_indices,
-                             const Tensor &add_indices,
-                             const Tensor &src,
-                             Tensor &output) {
-  auto add_indices_data = add_indices.data<int64_t>();
-  auto select_indices_data = select_indices.data<int64_t>();
-  auto src_data = src.data<T>();
-  auto output_data = output.data<T>();
-  auto numel = add_indices.numel();
-  int64_t ddim = src.size(1);
-  auto src_stride0 = src.stride(0);
-  auto src_stride1 = src.stride(1);
-  auto output_stride0 = output.stride(0);
-  auto output_stride1 = output.stride(1);
-  for (int64_t i = 0; i < numel; i++) {
-    THBlas_axpy<T>(ddim, 1,
-            src_data + src_stride0 * select_indices_data[i], src_stride1,
-            output_data + output_stride0 * add_indices_data[i], output_stride1);
+static void check_embedding_bag_indices(const Tensor &indices, int64_t num_weights) {
+  auto indices_data = indices.data<int64_t>();
+  for (int64_t i = 0; i < indices.numel(); i++) {
+    AT_CHECK(indices_data[i] >= 0 && indices_data[i] < num_weights,
+             "embedding_bag: index ", indices_data[i], " is out of range for ",
+             num_weights, " embeddings");
   }
 }
 
@@ -69,86 +54,6 @@ static void make_bag_size(const Tensor &offsets, const Tensor &indices,
   }
 }
 
-static Tensor apply_bag_size(const Tensor &offsets, const Tensor &indices,
-                             const int64_t mode, Tensor &output,
-                             const Tensor &bag_size) {
-  if (mode == MODE_MEAN) {
-    if (offsets.size(0) == 1) {
-      auto bag_size_ = indices.size(0);
-      output /= bag_size_;
-    } else {
-      // Avoid dividing by 0 for empty bags.
-      // Instead we want empty bags to return all 0s
-      auto bag_size_ = at::max(bag_size, at::ones_like(bag_size))
-                           .toType(output.type())
-                           .unsqueeze(1)
-                           .expand_as(output);
-      output /= bag_size_;
-    }
-  }
-  return output;
-}
-
-static Tensor apply_bag_size_backward(const Tensor &offsets,
-                                      const Tensor &indices, const int64_t mode,
-                                      Tensor &output, const Tensor &offset2bag,
-                                      const Tensor &bag_size) {
-  if (mode == MODE_MEAN) {
-    if (offsets.size(0) == 1) {
-      auto bag_size_ = indices.size(0);
-      output /= bag_size_;
-    } else {
-      auto inv_bag_size_ = (1 / bag_size.toType(output.type()))
-                             .unsqueeze(1)
-                             .index_select(0, offset2bag);
-      output *= inv_bag_size_;
-    }
-  }
-  return output;
-}
-
-
-template <typename scalar_t>
-std::tuple<Tensor, Tensor, Tensor, Tensor> embedding_bag_cpu_max(
-  const Tensor& weight, const Tensor &indices, const Tensor& offset2bag, const Tensor& output, const Tensor& bag_size, const Tensor& offsets) {
-
-    auto max_indices = at::zeros({offsets.size(0), weight.size(1)}, indices.type());
-
-    int64_t numel = indices.numel();
-    int64_t dims = weight.size(1);
-    auto indices_data = indices.data<int64_t>();
-    auto offset2bag_data = offset2bag.data<int64_t>();
-
-    auto max_indices_data = max_indices.data<int64_t>();
-    auto max_indices_stride = max_indices.stride(0);
-
-    auto weight_data = weight.data<scalar_t>();
-    auto output_data = output.data<scalar_t>();
-    auto weight_stride0 = weight.stride(0);
-    auto weight_stride1 = weight.stride(1);
-    auto output_stride = output.stride(0);
-
-    for (int i = 0; i < numel; i++) {
-      auto bag = offset2bag_data[i];
-      auto word_idx = indices_data[i];
-
-
-      for (int dim = 0; dim < dims; dim++) {
-        auto& current_item = output_data[output_stride * bag + dim];
-        auto weight_item = weight_data[weight_stride0 * word_idx + dim * weight_stride1];
-
-        bool is_first_for_bag = (i == 0) || offset2bag_data[i - 1] != bag;
-
-        if (is_first_for_bag || weight_item > current_item) {
-          current_item = weight_item;
-          max_indices_data[max_indices_stride * bag + dim] = word_idx;
-        }
-      }
-    }
-
-    return std::tuple<Tensor, Tensor, Tensor, Tensor>(output, offset2bag, bag_size, max_indices);
-}
-
 // embedding_bag wrapper to enforce contiguity in tensors other than `weight`.
 // This is created to save extra `.contiguous()` call in backward.
 // See NOTE [ embedding_bag Native Functions ] in native_functions.yaml for details
@@ -171,7 +76,7 @@ _embedding_bag_cpu(const Tensor &weight, const Tensor &indices,
   auto offsets_arg = TensorArg(offsets, "offsets", 1);
   checkScalarType("embedding_bag", indices_arg, kLong);
   auto weight_arg = TensorArg(weight, "weight", 1);
-  checkScalarTypes("embedding_bag", weight_arg, {kFloat, kDouble});
+  checkScalarTypes("embedding_bag", weight_arg, {kFloat, kDouble, kHalf});
 
   auto bag_size = at::zeros(offsets.sizes(), indices.type());
   make_bag_size(offsets, indices, mode, bag_size);
@@ -188,22 +93,11 @@ _embedding_bag_cpu(const Tensor &weight, const Tensor &indices,
   offset2bag.resize_({indices.sizes()[0]});
 
   auto output = at::zeros({offsets.size(0), weight.size(1)}, weight.options());
-
-  if (mode == MODE_MEAN || mode == MODE_SUM) {
-    if (weight.type().scalarType() == kFloat) {
-      index_select_add<float>(indices, offset2bag, weight, output);
-    } else if (weight.type().scalarType() == kDouble) {
-      index_select_add<double>(indices, offset2bag, weight, output);
-    }
-    auto ret = apply_bag_size(offsets, indices, mode, output, bag_size);
-    return std::tuple<Tensor, Tensor, Tensor, Tensor>(ret, offset2bag, bag_size, bag_size);
-  } else { // MODE_MAX
-    return AT_DISPATCH_FLOATING_TYPES_AND_HALF(
-      weight.type(), "embedding_bag_cpu_max", [&]() {
-        return embedding_bag_cpu_max<scalar_t>(weight, indices, offset2bag, output, bag_size, offsets);
-      }
-    );
-  }
+  auto max_indices = mode == MODE_MAX ? at::zeros({offsets.size(0), weight.size(1)}, indices.type())
+                                      : bag_size;
+  check_embedding_bag_indices(indices, weight.size(0));
+  embedding_bag_kernel(output, max_indices, weight, indices, offsets, mode);
+  return std::tuple<Tensor, Tensor, Tensor, Tensor>(output, offset2bag, bag_size, max_indices);
 }
 
 // Assumes all input tensors are contiguous.
@@ -336,7 +230,45 @@ Tensor _embedding_bag_dense_backward_cpu(const Tensor &grad_, const Tensor &indi
   return index_grad_weight;
 }
 
-Tensor _embedding_bag_sparse_backward(
+static Tensor apply_bag_size_backward(const Tensor &offsets,
+                                      const Tensor &indices, const int64_t mode,
+                                      Tensor &output, const Tensor &offset2bag,
+                                      const Tensor &bag_size) {
+  if (mode == MODE_MEAN) {
+    if (offsets.size(0) == 1) {
+      auto bag_size_ = indices.size(0);
+      output /= bag_size_;
+    } else {
+      auto inv_bag_size_ = (1 / bag_size.toType(output.type()))
+                             .unsqueeze(1)
+                             .index_select(0, offset2bag);
+      output *= inv_bag_size_;
+    }
+  }
+  return output;
+}
+
+Tensor _embedding_bag_sparse_backward_cpu(
+    const Tensor &grad_, const Tensor &indices, const Tensor &offsets,
+    const Tensor &offset2bag, const Tensor &bag_size_, int64_t num_weights,
+    bool scale_grad_by_freq, int64_t mode) {
+  // indices, offsets and offset2bag are assumed having correct dtypes and
+  // contiguous here due to the checks in _embedding_bag_backward above.
+  // Also see NOTE [ embedding_bag Native Functions ] in native_functions.yaml
+  // for more details.
+
+  auto grad = grad_.contiguous();
+  auto grad_arg = TensorArg(grad, "grad_", 1);
+  checkScalarTypes("embedding_bag", grad_arg, {kFloat, kDouble});
+
+  // gathers and scales the rows of grad in one pass
+  auto index_grad = at::empty({indices.numel(), grad.size(1)}, grad.options());
+  embedding_bag_sparse_backward_kernel(index_grad, grad, offset2bag, bag_size_, mode);
+  return native::embedding_backward(index_grad, indices, num_weights, -1,
+                                    scale_grad_by_freq, true);
+}
+
+Tensor _embedding_bag_sparse_backward_cuda(
     const Tensor &grad_, const Tensor &indices, const Tensor &offsets,
     const Tensor &offset2bag, const Tensor &bag_size_, int64_t num_weights,
     bool scale_grad_by_freq, int64_t mode) {
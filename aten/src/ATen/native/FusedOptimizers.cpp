@@ -0,0 +1,149 @@
+#include "ATen/native/FusedOptimizers.h"
+
+#include "ATen/ATen.h"
+#include "ATen/Dispatch.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/Parallel.h"
+
+namespace at { namespace native {
+
+namespace {
+
+template <typename scalar_t>
+scalar_t* data_or_null(const std::vector<Tensor>& tensors, size_t i) {
+  return tensors.empty() ? nullptr : tensors[i].data<scalar_t>();
+}
+
+} // namespace
+
+void _fused_sgd_step_cpu(
+    TensorList params_, TensorList grads_, TensorList momentum_buffers_,
+    double lr, double momentum, double dampening, double weight_decay,
+    bool nesterov, bool first_step) {
+  check_fused_step_inputs(
+      "_fused_sgd_step", params_, grads_, {momentum_buffers_});
+  auto params = fused_step_operands(params_);
+  auto grads = fused_step_operands(grads_);
+  auto momentum_buffers = fused_step_operands(momentum_buffers_);
+  AT_DISPATCH_FLOATING_TYPES(params[0].type(), "_fused_sgd_step", [&] {
+    for (size_t t = 0; t < params.size(); ++t) {
+      scalar_t* p = params[t].data<scalar_t>();
+      const scalar_t* g = grads[t].data<scalar_t>();
+      scalar_t* buf = data_or_null<scalar_t>(momentum_buffers, t);
+      parallel_for(0, params[t].numel(), internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          p[i] = fused_sgd_update<scalar_t>(
+              p[i], g[i], buf == nullptr ? nullptr : buf + i, lr, momentum,
+              dampening, weight_decay, nesterov, first_step);
+        }
+      });
+    }
+  });
+  fused_step_write_back(params_, params);
+  fused_step_write_back(momentum_buffers_, momentum_buffers);
+}
+
+void _fused_adam_step_cpu(
+    TensorList params_, TensorList grads_, TensorList exp_avgs_,
+    TensorList exp_avg_sqs_, TensorList max_exp_avg_sqs_, IntList steps,
+    double lr, double beta1, double beta2, double weight_decay, double eps) {
+  check_fused_step_inputs(
+      "_fused_adam_step", params_, grads_,
+      {exp_avgs_, exp_avg_sqs_, max_exp_avg_sqs_});
+  AT_CHECK(exp_avgs_.size() == params_.size() &&
+           exp_avg_sqs_.size() == params_.size() &&
+           steps.size() == params_.size(),
+           "_fused_adam_step: expected moments and a step for every parameter");
+  auto params = fused_step_operands(params_);
+  auto grads = fused_step_operands(grads_);
+  auto exp_avgs = fused_step_operands(exp_avgs_);
+  auto exp_avg_sqs = fused_step_operands(exp_avg_sqs_);
+  auto max_exp_avg_sqs = fused_step_operands(max_exp_avg_sqs_);
+  AT_DISPATCH_FLOATING_TYPES(params[0].type(), "_fused_adam_step", [&] {
+    for (size_t t = 0; t < params.size(); ++t) {
+      scalar_t* p = params[t].data<scalar_t>();
+      const scalar_t* g = grads[t].data<scalar_t>();
+      scalar_t* m = exp_avgs[t].data<scalar_t>();
+      scalar_t* v = exp_avg_sqs[t].data<scalar_t>();
+      scalar_t* vmax = data_or_null<scalar_t>(max_exp_avg_sqs, t);
+      const scalar_t step_size = fused_adam_step_size(lr, beta1, beta2, steps[t]);
+      parallel_for(0, params[t].numel(), internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          p[i] = fused_adam_update<scalar_t>(
+              p[i], g[i], m + i, v + i, vmax == nullptr ? nullptr : vmax + i,
+              step_size, beta1, beta2, weight_decay, eps);
+        }
+      });
+    }
+  });
+  fused_step_write_back(params_, params);
+  fused_step_write_back(exp_avgs_, exp_avgs);
+  fused_step_write_back(exp_avg_sqs_, exp_avg_sqs);
+  fused_step_write_back(max_exp_avg_sqs_, max_exp_avg_sqs);
+}
+
+void _fused_rmsprop_step_cpu(
+    TensorList params_, TensorList grads_, TensorList square_avgs_,
+    TensorList grad_avgs_, TensorList momentum_buffers_, double lr,
+    double alpha, double eps, double weight_decay, double momentum) {
+  check_fused_step_inputs(
+      "_fused_rmsprop_step", params_, grads_,
+      {square_avgs_, grad_avgs_, momentum_buffers_});
+  AT_CHECK(square_avgs_.size() == params_.size(),
+           "_fused_rmsprop_step: expected a square average for every parameter");
+  auto params = fused_step_operands(params_);
+  auto grads = fused_step_operands(grads_);
+  auto square_avgs = fused_step_operands(square_avgs_);
+  auto grad_avgs = fused_step_operands(grad_avgs_);
+  auto momentum_buffers = fused_step_operands(momentum_buffers_);
+  AT_DISPATCH_FLOATING_TYPES(params[0].type(), "_fused_rmsprop_step", [&] {
+    for (size_t t = 0; t < params.size(); ++t) {
+      scalar_t* p = params[t].data<scalar_t>();
+      const scalar_t* g = grads[t].data<scalar_t>();
+      scalar_t* sq = square_avgs[t].data<scalar_t>();
+      scalar_t* ga = data_or_null<scalar_t>(grad_avgs, t);
+      scalar_t* buf = data_or_null<scalar_t>(momentum_buffers, t);
+      parallel_for(0, params[t].numel(), internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          p[i] = fused_rmsprop_update<scalar_t>(
+              p[i], g[i], sq + i, ga == nullptr ? nullptr : ga + i,
+              buf == nullptr ? nullptr : buf + i, lr, alpha, eps,
+              weight_decay, momentum);
+        }
+      });
+    }
+  });
+  fused_step_write_back(params_, params);
+  fused_step_write_back(square_avgs_, square_avgs);
+  fused_step_write_back(grad_avgs_, grad_avgs);
+  fused_step_write_back(momentum_buffers_, momentum_buffers);
+}
+
+void _fused_adagrad_step_cpu(
+    TensorList params_, TensorList grads_, TensorList sums_, IntList steps,
+    double lr, double lr_decay, double weight_decay) {
+  check_fused_step_inputs("_fused_adagrad_step", params_, grads_, {sums_});
+  AT_CHECK(sums_.size() == params_.size() && steps.size() == params_.size(),
+           "_fused_adagrad_step: expected a sum and a step for every parameter");
+  auto params = fused_step_operands(params_);
+  auto grads = fused_step_operands(grads_);
+  auto sums = fused_step_operands(sums_);
+  AT_DISPATCH_FLOATING_TYPES(params[0].type(), "_fused_adagrad_step", [&] {
+    for (size_t t = 0; t < params.size(); ++t) {
+      scalar_t* p = params[t].data<scalar_t>();
+      const scalar_t* g = grads[t].data<scalar_t>();
+      scalar_t* sum = sums[t].data<scalar_t>();
+      const scalar_t clr = fused_adagrad_clr(lr, lr_decay, steps[t]);
+      parallel_for(0, params[t].numel(), internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; ++i) {
+          p[i] = fused_adagrad_update<scalar_t>(
+              p[i], g[i], sum + i, clr, weight_decay);
+        }
+      });
+    }
+  });
+  fused_step_write_back(params_, params);
+  fused_step_write_back(sums_, sums);
+}
+
+}} // namespace at::native
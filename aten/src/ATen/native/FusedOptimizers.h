@@ -0,0 +1,170 @@
+#pragma once
+
+#include "ATen/ATen.h"
+
+#include <cmath>
+#include <initializer_list>
+#include <vector>
+
+// Per-element update rules of the fused optimizer steps, shared by the CPU
+// and CUDA kernels. Each one reproduces the sequence of tensor ops that
+// torch::optim applies to a single parameter, with `T` the type the
+// arithmetic is carried out in. Optional state is passed as a null pointer
+// when the corresponding option is off.
+
+#ifdef __CUDACC__
+#define FUSED_OPTIMIZER_HOSTDEVICE __host__ __device__
+#else
+#define FUSED_OPTIMIZER_HOSTDEVICE
+#endif
+
+namespace at { namespace native {
+
+template <typename T>
+FUSED_OPTIMIZER_HOSTDEVICE inline T fused_sgd_update(
+    T p, T g, T* momentum_buffer, T lr, T momentum, T dampening,
+    T weight_decay, bool nesterov, bool first_step) {
+  T d = g;
+  if (weight_decay != T(0)) {
+    d += weight_decay * p;
+  }
+  if (momentum_buffer != nullptr) {
+    // The first step seeds the buffer with the undampened gradient.
+    const T buf = first_step ? *momentum_buffer * momentum + d
+                             : *momentum_buffer * momentum + (T(1) - dampening) * d;
+    *momentum_buffer = buf;
+    d = nesterov ? d + momentum * buf : buf;
+  }
+  return p - lr * d;
+}
+
+// `step_size` folds in both bias corrections, see fused_adam_step_size().
+template <typename T>
+FUSED_OPTIMIZER_HOSTDEVICE inline T fused_adam_update(
+    T p, T g, T* exp_avg, T* exp_avg_sq, T* max_exp_avg_sq, T step_size,
+    T beta1, T beta2, T weight_decay, T eps) {
+  T d = g;
+  if (weight_decay != T(0)) {
+    d += weight_decay * p;
+  }
+  const T m = *exp_avg * beta1 + (T(1) - beta1) * d;
+  const T v = *exp_avg_sq * beta2 + (T(1) - beta2) * d * d;
+  *exp_avg = m;
+  *exp_avg_sq = v;
+  T denom = v;
+  if (max_exp_avg_sq != nullptr) {
+    denom = *max_exp_avg_sq > v ? *max_exp_avg_sq : v;
+    *max_exp_avg_sq = denom;
+  }
+  return p - step_size * m / (::sqrt(denom) + eps);
+}
+
+template <typename T>
+FUSED_OPTIMIZER_HOSTDEVICE inline T fused_rmsprop_update(
+    T p, T g, T* square_avg, T* grad_avg, T* momentum_buffer, T lr, T alpha,
+    T eps, T weight_decay, T momentum) {
+  T d = g;
+  if (weight_decay != T(0)) {
+    d += weight_decay * p;
+  }
+  const T sq = *square_avg * alpha + (T(1) - alpha) * d * d;
+  *square_avg = sq;
+  T avg;
+  if (grad_avg != nullptr) {
+    const T ga = *grad_avg * alpha + (T(1) - alpha) * d;
+    *grad_avg = ga;
+    avg = ::sqrt(sq - ga * ga) + eps;
+  } else {
+    avg = ::sqrt(sq) + eps;
+  }
+  if (momentum_buffer != nullptr) {
+    const T buf = *momentum_buffer * momentum + d / avg;
+    *momentum_buffer = buf;
+    return p - lr * buf;
+  }
+  return p - lr * d / avg;
+}
+
+// `clr` is the decayed learning rate, see fused_adagrad_clr().
+template <typename T>
+FUSED_OPTIMIZER_HOSTDEVICE inline T fused_adagrad_update(
+    T p, T g, T* sum, T clr, T weight_decay) {
+  T d = g;
+  if (weight_decay != T(0)) {
+    d += weight_decay * p;
+  }
+  const T s = *sum + d * d;
+  *sum = s;
+  return p - clr * d / (::sqrt(s) + T(1e-10));
+}
+
+static inline double fused_adam_step_size(
+    double lr, double beta1, double beta2, int64_t step) {
+  const double bias_correction1 = 1 - std::pow(beta1, step);
+  const double bias_correction2 = 1 - std::pow(beta2, step);
+  return lr * std::sqrt(bias_correction2) / bias_correction1;
+}
+
+static inline double fused_adagrad_clr(
+    double lr, double lr_decay, int64_t step) {
+  return lr / (1.0 + (step - 1.0) * lr_decay);
+}
+
+// All lists of a fused step must line up with `params`: same length (or
+// empty, for state that is switched off), and per index the same type and
+// number of elements. All parameters must share one type and device.
+static inline void check_fused_step_inputs(
+    const char* op, TensorList params, TensorList grads,
+    std::initializer_list<TensorList> states) {
+  AT_CHECK(params.size() > 0, op, ": expected at least one parameter");
+  AT_CHECK(grads.size() == params.size(), op, ": expected ", params.size(),
+           " gradients but got ", grads.size());
+  const auto& type = params[0].type();
+  const auto device = params[0].device();
+  for (size_t i = 0; i < params.size(); ++i) {
+    AT_CHECK(params[i].type() == type && params[i].device() == device, op,
+             ": all parameters must have the same type and device, but "
+             "parameter ", i, " does not match parameter 0 (",
+             type.toString(), ")");
+    AT_CHECK(grads[i].type() == type && grads[i].numel() == params[i].numel(),
+             op, ": gradient ", i, " does not match its parameter");
+  }
+  for (const auto& state : states) {
+    if (state.empty()) {
+      continue;
+    }
+    AT_CHECK(state.size() == params.size(), op, ": expected ", params.size(),
+             " state tensors but got ", state.size());
+    for (size_t i = 0; i < params.size(); ++i) {
+      AT_CHECK(state[i].type() == type && state[i].device() == device &&
+               state[i].numel() == params[i].numel(),
+               op, ": state tensor ", i, " does not match its parameter");
+    }
+  }
+}
+
+// The kernels walk flat buffers, so every list is viewed contiguously.
+// Contiguous tensors are used as they are; the others are updated through
+// a copy that fused_step_write_back() copies back afterwards.
+static inline std::vector<Tensor> fused_step_operands(TensorList tensors) {
+  std::vector<Tensor> result;
+  result.reserve(tensors.size());
+  for (const auto& tensor : tensors) {
+    result.push_back(tensor.contiguous());
+  }
+  return result;
+}
+
+static inline void fused_step_write_back(
+    TensorList originals, const std::vector<Tensor>& operands) {
+  for (size_t i = 0; i < originals.size(); ++i) {
+    Tensor original = originals[i];
+    if (!original.is_contiguous()) {
+      original.copy_(operands[i]);
+    }
+  }
+}
+
+}} // namespace at::native
+
+#undef FUSED_OPTIMIZER_HOSTDEVICE
@@ -3,12 +3,15 @@
 #include "ATen/Dispatch.h"
 #include "ATen/ExpandUtils.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/Parallel.h"
 
 #include "ATen/native/LinearAlgebraUtils.h"
 #include "ATen/native/Gesv.h"
 
 #include "TH.h"  // for USE_LAPACK
 
+#include <algorithm>
+#include <cmath>
 #include <vector>
 
 #ifdef USE_LAPACK
@@ -43,11 +46,84 @@ template<> void lapackGesv<double>(
 }
 #endif
 
+// Systems of up to this size are solved by smallGesv rather than LAPACK,
+// whose overhead per call is larger than the solve for matrices that small.
+constexpr int64_t kSmallGesvSize = 4;
+
+// gesv of the column-major n x n matrix a and n x nrhs matrix b, with lda and
+// ldb equal to n: the LU factorization with partial pivoting of a, as in
+// LAPACK's getf2, then the solution of a x = b in b. N is n if it isn't zero,
+// so that the loops over the rows are unrolled.
+template <typename scalar_t, int N>
+static void smallGesv(int n, int nrhs, scalar_t* a, int* ipiv, scalar_t* b, int* info) {
+  const int size = N ? N : n;
+  *info = 0;
+  for (int j = 0; j < size; j++) {
+    int pivot = j;
+    for (int i = j + 1; i < size; i++) {
+      if (std::abs(a[j * size + i]) > std::abs(a[j * size + pivot])) {
+        pivot = i;
+      }
+    }
+    ipiv[j] = pivot + 1;
+    if (a[j * size + pivot] == 0) {
+      // like LAPACK, report the first zero pivot and don't solve
+      if (*info == 0) {
+        *info = j + 1;
+      }
+      continue;
+    }
+    if (pivot != j) {
+      for (int k = 0; k < size; k++) {
+        std::swap(a[k * size + j], a[k * size + pivot]);
+      }
+      for (int k = 0; k < nrhs; k++) {
+        std::swap(b[k * size + j], b[k * size + pivot]);
+      }
+    }
+    const scalar_t inverse = scalar_t(1) / a[j * size + j];
+    for (int i = j + 1; i < size; i++) {
+      a[j * size + i] *= inverse;
+    }
+    for (int k = j + 1; k < size; k++) {
+      for (int i = j + 1; i < size; i++) {
+        a[k * size + i] -= a[j * size + i] * a[k * size + j];
+      }
+    }
+  }
+  if (*info != 0) {
+    return;
+  }
+  for (int k = 0; k < nrhs; k++) {
+    scalar_t* x = b + k * size;
+    for (int j = 0; j < size; j++) {
+      for (int i = j + 1; i < size; i++) {
+        x[i] -= a[j * size + i] * x[j];
+      }
+    }
+    for (int j = size - 1; j >= 0; j--) {
+      x[j] /= a[j * size + j];
+      for (int i = 0; i < j; i++) {
+        x[i] -= a[j * size + i] * x[j];
+      }
+    }
+  }
+}
+
 template <typename scalar_t>
-static void applyGesv(Tensor& b, Tensor& A, std::vector<int64_t> infos) {
-#ifndef USE_LAPACK
-  AT_ERROR("gesv: LAPACK library not found in compilation");
-#endif
+static void smallGesv(int n, int nrhs, scalar_t* a, int* ipiv, scalar_t* b, int* info) {
+  switch (n) {
+    case 1: return smallGesv<scalar_t, 1>(n, nrhs, a, ipiv, b, info);
+    case 2: return smallGesv<scalar_t, 2>(n, nrhs, a, ipiv, b, info);
+    case 3: return smallGesv<scalar_t, 3>(n, nrhs, a, ipiv, b, info);
+    case 4: return smallGesv<scalar_t, 4>(n, nrhs, a, ipiv, b, info);
+    default: return smallGesv<scalar_t, 0>(n, nrhs, a, ipiv, b, info);
+  }
+}
+
+// The systems of the batch are independent and spread over the threads.
+template <typename scalar_t>
+static void applyGesv(Tensor& b, Tensor& A, std::vector<int64_t>& infos) {
   auto A_data = A.data<scalar_t>();
   auto b_data = b.data<scalar_t>();
   auto A_mat_stride = matrixStride(A);
@@ -56,20 +132,30 @@ static void applyGesv(Tensor& b, Tensor& A, std::vector<int64_t> infos) {
   auto batch_size = batchCount(A);
   auto n = A.size(-2);
   auto nrhs = b.size(-1);
+  const bool small = n <= kSmallGesvSize;
+#ifndef USE_LAPACK
+  if (!small) {
+    AT_ERROR("gesv: LAPACK library not found in compilation");
+  }
+#endif
 
-  auto ipiv = at::empty({n}, b.type().toScalarType(kInt));
-
-  for (int64_t i = 0; i < batch_size; i++) {
-    int info;
-    scalar_t* A_working_ptr = &A_data[i * A_mat_stride];
-    scalar_t* b_working_ptr = &b_data[i * b_mat_stride];
-    lapackGesv<scalar_t>(n, nrhs, A_working_ptr, n, ipiv.data<int>(),
-        b_working_ptr, n, &info);
-    infos[i] = info;
-    if (info != 0) {
-      return;
+  const int64_t work = std::max<int64_t>(1, n * n * (n + nrhs));
+  const int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / work);
+  parallel_for(0, batch_size, grain_size, [&](int64_t begin, int64_t end) {
+    std::vector<int> ipiv(n);
+    for (int64_t i = begin; i < end; i++) {
+      int info;
+      scalar_t* A_working_ptr = &A_data[i * A_mat_stride];
+      scalar_t* b_working_ptr = &b_data[i * b_mat_stride];
+      if (small) {
+        smallGesv<scalar_t>(n, nrhs, A_working_ptr, ipiv.data(), b_working_ptr, &info);
+      } else {
+        lapackGesv<scalar_t>(n, nrhs, A_working_ptr, n, ipiv.data(),
+            b_working_ptr, n, &info);
+      }
+      infos[i] = info;
     }
-  }
+  });
 }
 
 std::tuple<Tensor,Tensor> _gesv_helper_cpu(const Tensor& self, const Tensor& A) {
@@ -2,6 +2,11 @@
 #include <ATen/NativeFunctions.h>
 #include <ATen/SparseTensorRef.h>
 #include <ATen/ExpandUtils.h>
+#include <ATen/native/ReduceOpsUtils.h>
+#include <ATen/native/cpu/ReduceOpsKernel.h>
+
+#include <algorithm>
+#include <cstring>
 
 namespace at { namespace native {
 
@@ -13,6 +18,53 @@ namespace {
   static bool _has_native(const Tensor& self) {
     return _type_has_native(self.type());
   }
+
+  static bool _are_broadcastable(IntList a, IntList b) {
+    size_t ndim = std::max(a.size(), b.size());
+    for (size_t i = 1; i <= ndim; i++) {
+      int64_t size_a = i <= a.size() ? a[a.size() - i] : 1;
+      int64_t size_b = i <= b.size() ? b[b.size() - i] : 1;
+      if (size_a != size_b && size_a != 1 && size_b != 1) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static bool _is_expandable_to(IntList shape, IntList desired) {
+    if (shape.size() > desired.size()) {
+      return false;
+    }
+    for (size_t i = 1; i <= shape.size(); i++) {
+      int64_t size = shape[shape.size() - i];
+      if (size != 1 && size != desired[desired.size() - i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Whether a dense binary op can use the native CPU kernels (see
+  // BinaryOps.cpp). They don't handle mixed types or the deprecated
+  // fallback for inputs that don't broadcast, which TH does.
+  static bool _is_dense_cpu_pair(const Tensor& self, const Tensor& other) {
+    return self.type().backend() == Backend::CPU &&
+           &self.type() == &other.type();
+  }
+
+  static bool _has_native_dense(const Tensor& self, const Tensor& other) {
+    return _is_dense_cpu_pair(self, other) &&
+           _are_broadcastable(self.sizes(), other.sizes());
+  }
+
+  static bool _has_native_dense_out(const Tensor& result, const Tensor& self, const Tensor& other) {
+    return &result.type() == &self.type() && _has_native_dense(self, other);
+  }
+
+  static bool _has_native_dense_(const Tensor& self, const Tensor& other) {
+    return _is_dense_cpu_pair(self, other) &&
+           _is_expandable_to(other.sizes(), self.sizes());
+  }
 }
 
 // These native operations are not "really" native; they're actually just bridge
@@ -25,6 +77,10 @@ namespace {
 Tensor norm(const Tensor & self, Scalar p) {
   if (_has_native(self)) {
     return native_norm(self, p);
+  } else if (_has_norm_kernel(self, p)) {
+    Tensor result = at::empty({}, self.type());
+    norm_kernel(result, self, p, at::nullopt);
+    return result;
   } else {
     return th_norm(self, p);
   }
@@ -65,6 +121,11 @@ Tensor pow(const Tensor& self, Scalar exponent) {
 Tensor& zero_(Tensor& self) {
   if (_has_native(self)) {
     return native_zero_(self);
+  } else if (self.type().backend() == Backend::CPU &&
+             self.type().scalarType() == ScalarType::Half && self.is_contiguous()) {
+    // TH has no math for CPU Half; a half zero has all bits clear
+    std::memset(self.data_ptr(), 0, self.numel() * sizeof(Half));
+    return self;
   } else {
     return th_zero_(self);
   }
@@ -98,6 +159,10 @@ Tensor& zero_(Tensor& self) {
 // Why not change TH to follow this new scheme?  We could... but since it's
 // all going away when we finish porting the TH functions to ATen, we haven't
 // done it.
+//
+// The same-size s_native_ add, sub, mul and div also have dense CPU kernels
+// (BinaryOps.cpp), so for dense CPU tensors of one type the trampolines
+// broadcast and call those instead of TH.
 
 Tensor& add_out(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
   // See Note [Multiple dispatch to sparse]
@@ -113,6 +178,10 @@ Tensor& add_out(Tensor& result, const Tensor& self, const Tensor& other, Scalar
     // For now, we do it this way for consistency with the TH bindings
     // (not that it is terribly consistent anyway).
     return native_add_out(result, self, SparseTensorRef(other), alpha);
+  } else if (_has_native_dense_out(result, self, other)) {
+    Tensor b_self, b_other;
+    std::tie(b_self, b_other) = expand_outplace(self, other, "add_out");
+    return s_native_add_out(result, b_self, b_other, alpha);
   } else {
     return th_add_out(result, self, other, alpha);
   }
@@ -136,6 +205,10 @@ Tensor add(const Tensor& self, const Tensor& other, Scalar alpha) {
     return s_native_add(b_self, b_other, alpha);
   } else if (!self_sparse && other_sparse) {
     return native_add(self, SparseTensorRef(other), alpha);
+  } else if (_has_native_dense(self, other)) {
+    Tensor b_self, b_other;
+    std::tie(b_self, b_other) = expand_outplace(self, other, "add");
+    return s_native_add(b_self, b_other, alpha);
   } else {
     return th_add(self, other, alpha);
   }
@@ -151,6 +224,10 @@ Tensor& add_(Tensor& self, const Tensor& other, Scalar alpha) {
     return s_native_add_(self, b_other, alpha);
   } else if (!self_sparse && other_sparse) {
     return native_add_(self, SparseTensorRef(other), alpha);
+  } else if (_has_native_dense_(self, other)) {
+    Tensor b_other;
+    std::tie(b_other) = expand_inplace(self, other, "add_");
+    return s_native_add_(self, b_other, alpha);
   } else {
     return th_add_(self, other, alpha);
   }
@@ -162,6 +239,10 @@ Tensor& sub_out(Tensor& result, const Tensor& self, const Tensor& other, Scalar
     Tensor b_self, b_other;
     std::tie(b_self, b_other) = expand_outplace(self, other, "sub_out");
     return s_native_sub_out(result, b_self, b_other, alpha);
+  } else if (_has_native_dense_out(result, self, other)) {
+    Tensor b_self, b_other;
+    std::tie(b_self, b_other) = expand_outplace(self, other, "sub_out");
+    return s_native_sub_out(result, b_self, b_other, alpha);
   } else {
     return th_sub_out(result, self, other, alpha);
   }
@@ -172,6 +253,10 @@ Tensor sub(const Tensor& self, const Tensor& other, Scalar alpha) {
     Tensor b_self, b_other;
     std::tie(b_self, b_other) = expand_outplace(self, other, "sub");
     return s_native_sub(b_self, b_other, alpha);
+  } else if (_has_native_dense(self, other)) {
+    Tensor b_self, b_other;
+    std::tie(b_self, b_other) = expand_outplace(self, other, "sub");
+    return s_native_sub(b_self, b_other, alpha);
   } else {
     return th_sub(self, other, alpha);
   }
@@ -182,6 +267,10 @@ Tensor& sub_(Tensor& self, const Tensor& other, Scalar alpha) {
     Tensor b_other;
     std::tie(b_other) = expand_inplace(self, other, "sub_");
     return s_native_sub_(self, b_other, alpha);
+  } else if (_has_native_dense_(self, other)) {
+    Tensor b_other;
+    std::tie(b_other) = expand_inplace(self, other, "sub_");
+    return s_native_sub_(self, b_other, alpha);
   } else {
     return th_sub_(self, other, alpha);
   }
@@ -193,6 +282,10 @@ Tensor& mul_out(Tensor& result, const Tensor& self, const Tensor& other) {
     Tensor b_self, b_other;
     std::tie(b_self, b_other) = expand_outplace(self, other, "mul_out");
     return s_native_mul_out(result, self, other);
+  } else if (_has_native_dense_out(result, self, other)) {
+    Tensor b_self, b_other;
+    std::tie(b_self, b_other) = expand_outplace(self, other, "mul_out");
+    return s_native_mul_out(result, b_self, b_other);
   } else {
     return th_mul_out(result, self, other);
   }
@@ -203,6 +296,10 @@ Tensor mul(const Tensor& self, const Tensor& other) {
     Tensor b_self, b_other;
     std::tie(b_self, b_other) = expand_outplace(self, other, "mul");
     return s_native_mul(self, other);
+  } else if (_has_native_dense(self, other)) {
+    Tensor b_self, b_other;
+    std::tie(b_self, b_other) = expand_outplace(self, other, "mul");
+    return s_native_mul(b_self, b_other);
   } else {
     return th_mul(self, other);
   }
@@ -213,6 +310,10 @@ Tensor& mul_(Tensor& self, const Tensor& other) {
     Tensor b_other;
     std::tie(b_other) = expand_inplace(self, other, "mul_");
     return s_native_mul_(self, b_other);
+  } else if (_has_native_dense_(self, other)) {
+    Tensor b_other;
+    std::tie(b_other) = expand_inplace(self, other, "mul_");
+    return s_native_mul_(self, b_other);
   } else {
     return th_mul_(self, other);
   }
@@ -243,6 +344,36 @@ Tensor& mul_(Tensor& self, Scalar other) {
 }
 
 
+Tensor& div_out(Tensor& result, const Tensor& self, const Tensor& other) {
+  if (_has_native_dense_out(result, self, other)) {
+    Tensor b_self, b_other;
+    std::tie(b_self, b_other) = expand_outplace(self, other, "div_out");
+    return s_native_div_out(result, b_self, b_other);
+  } else {
+    return th_div_out(result, self, other);
+  }
+}
+
+Tensor div(const Tensor& self, const Tensor& other) {
+  if (_has_native_dense(self, other)) {
+    Tensor b_self, b_other;
+    std::tie(b_self, b_other) = expand_outplace(self, other, "div");
+    return s_native_div(b_self, b_other);
+  } else {
+    return th_div(self, other);
+  }
+}
+
+Tensor& div_(Tensor& self, const Tensor& other) {
+  if (_has_native_dense_(self, other)) {
+    Tensor b_other;
+    std::tie(b_other) = expand_inplace(self, other, "div_");
+    return s_native_div_(self, b_other);
+  } else {
+    return th_div_(self, other);
+  }
+}
+
 Tensor& div_out(Tensor& result, const Tensor& self, Scalar other) {
   if (_has_native(self)) {
     return native_div_out(result, self, other);
@@ -83,17 +83,38 @@ std::tuple<Tensor, Tensor> slogdet(const Tensor& self) {
   return std::make_tuple(det.sign(), diag_U.abs_().log_().sum());
 }
 
+static void check_inverse_input(const Tensor& self) {
+  AT_CHECK(self.type().backend() == kCPU || self.type().backend() == kCUDA,
+           "tensor should have CPU or CUDA backend");
+  AT_CHECK(self.dim() >= 2, "tensor should have at least 2 dimensions");
+  AT_CHECK(self.size(-1) == self.size(-2), "tensor should be square or batches of square matrices");
+  AT_CHECK(at::isFloatingType(self.type().scalarType()), "tensor should be of floating-point type");
+}
+
+// Batches of matrices are inverted by a single batched gesv of A X = I,
+// rather than by a getri each.
+static Tensor inverse_batched(const Tensor& self) {
+  if (self.numel() == 0) {
+    return self.type().tensor(self.sizes());
+  }
+  auto identity = at::eye(self.size(-1), self.type()).expand_as(self);
+  return std::get<0>(at::gesv(identity, self));
+}
+
 Tensor inverse(const Tensor& self) {
+  if (self.dim() > 2) {
+    check_inverse_input(self);
+    return inverse_batched(self);
+  }
   Tensor result = self.type().tensor();
   return at::native::inverse_out(result, self);
 }
 
 Tensor& inverse_out(Tensor &result, const Tensor &self) {
-  AT_CHECK(self.type().backend() == kCPU || self.type().backend() == kCUDA,
-           "tensor should have CPU or CUDA backend");
-  AT_CHECK(self.dim() == 2, "tensor should be 2 dimensional");
-  AT_CHECK(self.size(0) == self.size(1), "tensor should be square");
-  AT_CHECK(at::isFloatingType(self.type().scalarType()), "tensor should be of floating-point type");
+  check_inverse_input(self);
+  if (self.dim() > 2) {
+    return result.resize_(self.sizes()).copy_(inverse_batched(self));
+  }
   if (self.size(0) == 0) {
     return result.resize_({0, 0});
   } else {
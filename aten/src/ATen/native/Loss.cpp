@@ -61,6 +61,33 @@ Tensor triplet_margin_loss(const Tensor& anchor, const Tensor& positive, const T
   return output;
 }
 
+// log_softmax followed by nll_loss for a (N, C) input without class weights.
+// Only the logsumexp of each row is kept for the backward, which recomputes
+// the softmax from it, instead of a full (N, C) tensor of log-probabilities.
+std::tuple<Tensor, Tensor> _cross_entropy_forward(const Tensor& self, const Tensor& target, int64_t reduction, int64_t ignore_index) {
+  AT_CHECK(self.dim() == 2, "cross_entropy: expected 2D input, got ", self.dim(), "D");
+  AT_CHECK(target.dim() == 1 && target.size(0) == self.size(0),
+           "Expected input batch_size (", self.size(0), ") to match target batch_size (", target.size(0), ").");
+  Tensor output, logsumexp;
+  std::tie(output, logsumexp) = at::_cross_entropy_lastdim(self, target, ignore_index);
+  if (reduction == Reduction::ElementwiseMean) {
+    output = output.sum() / target.ne(ignore_index).sum().type_as(output);
+  } else if (reduction == Reduction::Sum) {
+    output = output.sum();
+  }
+  return std::make_tuple(output, logsumexp);
+}
+
+Tensor _cross_entropy_backward(const Tensor& grad_output, const Tensor& self, const Tensor& target, const Tensor& logsumexp, int64_t reduction, int64_t ignore_index) {
+  // the gradient of the loss of each row, before the softmax
+  auto scale = target.ne(ignore_index).type_as(self);
+  if (reduction == Reduction::ElementwiseMean) {
+    scale.div_(scale.sum());
+  }
+  scale.mul_(grad_output);
+  return at::_cross_entropy_lastdim_backward(scale, self, target, logsumexp, ignore_index);
+}
+
 Tensor margin_ranking_loss(const Tensor& input1, const Tensor& input2, const Tensor& target, double margin, int64_t reduction) {
   auto output =  (-target * (input1 - input2) + margin).clamp_min_(0);
 
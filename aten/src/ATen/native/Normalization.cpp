@@ -4,7 +4,9 @@
 #include "ATen/Config.h"
 
 #include "ATen/detail/CUDAHooksInterface.h"
+#include "ATen/native/cpu/LayerNormKernel.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace at { namespace native {
@@ -117,22 +119,56 @@ Tensor layer_norm(const Tensor& input, IntList normalized_shape,
       n *= input_shape[i];
     }
 
-    // Apply layer norm
-    auto input_reshaped = input.contiguous().view({1, n, -1});
+    // Each of the n rows of normalized_shape is normalized by a fused kernel
+    // with its own mean and rstd.
+    int64_t row_size = 1;
+    for (auto size : normalized_shape) {
+      row_size *= size;
+    }
+    auto out = std::get<0>(at::_layer_norm_forward(
+        input.contiguous(),
+        weight.defined() ? weight.contiguous().view({row_size}) : weight,
+        bias.defined() ? bias.contiguous().view({row_size}) : bias,
+        n, row_size, eps));
+    return out.view(input_shape);
+}
 
-    auto out = at::batch_norm(input_reshaped, {}, {}, {}, {}, true, 0, eps,
-                              cudnn_enabled);
-    out = out.view(input_shape);
+std::tuple<Tensor, Tensor, Tensor> layer_norm_forward_cpu(
+    const Tensor& input, const Tensor& weight /* optional */, const Tensor& bias /* optional */,
+    int64_t M, int64_t N, double eps) {
+  auto X = input.contiguous();
+  Tensor Y = at::native::empty_like(X);
+  Tensor mean = at::empty({M}, X.type());
+  Tensor rstd = at::empty({M}, X.type());
+  if (M > 0) {
+    layer_norm_kernel(Y, mean, rstd, X,
+                      weight.defined() ? weight.contiguous() : weight,
+                      bias.defined() ? bias.contiguous() : bias,
+                      M, N, eps);
+  }
+  return std::make_tuple(Y, mean, rstd);
+}
 
-    if (weight.defined() && bias.defined()) {
-      return bias.addcmul(out, weight, 1);
-    } else if (weight.defined()) {
-      return out.mul(weight);
-    } else if (bias.defined()) {
-      return out.add(bias);
-    } else {
-      return out;
-    }
+std::tuple<Tensor, Tensor, Tensor> layer_norm_backward_cpu(
+    const Tensor& grad_out, const Tensor& input, const Tensor& mean, const Tensor& rstd,
+    const Tensor& weight /* optional */, int64_t M, int64_t N, std::array<bool,3> output_mask) {
+  auto dY = grad_out.contiguous();
+  auto X = input.contiguous();
+  Tensor dX, dgamma, dbeta;
+  if (output_mask[0]) {
+    dX = at::native::empty_like(X);
+  }
+  if (output_mask[1]) {
+    dgamma = at::zeros({N}, X.type());
+  }
+  if (output_mask[2]) {
+    dbeta = at::zeros({N}, X.type());
+  }
+  if (M > 0) {
+    layer_norm_backward_kernel(dX, dgamma, dbeta, dY, X, mean.contiguous(), rstd.contiguous(),
+                               weight.defined() ? weight.contiguous() : weight, M, N);
+  }
+  return std::make_tuple(dX, dgamma, dbeta);
 }
 
 Tensor group_norm(const Tensor& input, int64_t num_groups,
@@ -167,11 +203,11 @@ Tensor group_norm(const Tensor& input, int64_t num_groups,
       throw std::runtime_error(ss.str());
     }
 
-    // Apply group norm
-    auto input_reshaped = input.contiguous().view({1, b * num_groups, -1});
-
-    auto out = at::batch_norm(input_reshaped, {}, {}, {}, {}, true, 0, eps,
-                              cudnn_enabled);
+    // Apply group norm: each group of each sample is a row of the fused
+    // layer norm kernel, without its affine, which is per channel here.
+    int64_t rows = b * num_groups;
+    auto out = std::get<0>(at::_layer_norm_forward(
+        input.contiguous(), {}, {}, rows, input.numel() / std::max<int64_t>(rows, 1), eps));
     out = out.view(input_shape);
 
     if (!weight.defined() && !bias.defined()) {
@@ -3,8 +3,13 @@
 #include "ATen/Error.h"
 #include "ATen/NativeFunctions.h"
 #include "ATen/TensorUtils.h"
+#include "ATen/Utils.h"
+#include "ATen/native/ChannelsLastUtils.h"
+#include "ATen/native/cpu/PoolingKernel.h"
 
+#include <cmath>
 #include <tuple>
+#include <vector>
 
 namespace at { namespace native {
 
@@ -130,5 +135,238 @@ Tensor max_pool3d(
       self, kernel_size, stride, padding, dilation, ceil_mode);
   return std::get<0>(output_and_indices);
 }
+
+// The CPU max_pool2d_with_indices and avg_pool2d of nn.yaml. They check their
+// arguments and size their outputs like SpatialDilatedMaxPooling and
+// SpatialAveragePooling of THNN, and run in the layout of self: outputs and
+// grad_input are channels-last if self is (see ChannelsLastUtils.h).
+
+static Pool2dParams pool2d_params(
+    IntList kernel_size, IntList stride, IntList padding, IntList dilation) {
+  auto kernel_size_ = check_intlist<2>(kernel_size, "kernel_size", 2);
+  auto stride_ = check_intlist<2>(stride, "stride", 3, kernel_size);
+  auto padding_ = check_intlist<2>(padding, "padding", 4);
+  auto dilation_ = check_intlist<2>(dilation, "dilation", 5, {1});
+  Pool2dParams p;
+  p.kH = kernel_size_[0];
+  p.kW = kernel_size_[1];
+  p.dH = stride_[0];
+  p.dW = stride_[1];
+  p.padH = padding_[0];
+  p.padW = padding_[1];
+  p.dilationH = dilation_[0];
+  p.dilationW = dilation_[1];
+  return p;
+}
+
+static int64_t pool2d_output_size(
+    int64_t input_size, int64_t k, int64_t d, int64_t pad, int64_t dilation, bool ceil_mode) {
+  const float size = (float)(input_size - (dilation * (k - 1) + 1) + 2 * pad) / d;
+  return (int64_t)(ceil_mode ? std::ceil(size) : std::floor(size)) + 1;
+}
+
+static std::vector<int64_t> pool2d_output_sizes(
+    const Tensor& self, const Pool2dParams& p, bool ceil_mode) {
+  AT_CHECK(p.kH > 0 && p.kW > 0,
+           "kernel size should be greater than zero, but got kH: ", p.kH, " kW: ", p.kW);
+  AT_CHECK(p.dH > 0 && p.dW > 0,
+           "stride should be greater than zero, but got dH: ", p.dH, " dW: ", p.dW);
+  AT_CHECK(p.dilationH > 0 && p.dilationW > 0,
+           "dilation should be greater than zero, but got dilationH: ", p.dilationH,
+           " dilationW: ", p.dilationW);
+  AT_CHECK(self.numel() > 0 && (self.dim() == 3 || self.dim() == 4),
+           "non-empty 3D or 4D input tensor expected but got: ", self.sizes());
+  AT_CHECK(p.kW / 2 >= p.padW && p.kH / 2 >= p.padH,
+           "pad should be smaller than half of kernel size, but got padW = ", p.padW,
+           ", padH = ", p.padH, ", kW = ", p.kW, ", kH = ", p.kH);
+
+  const int64_t C = self.size(-3), H = self.size(-2), W = self.size(-1);
+  int64_t OH = pool2d_output_size(H, p.kH, p.dH, p.padH, p.dilationH, ceil_mode);
+  int64_t OW = pool2d_output_size(W, p.kW, p.dW, p.padW, p.dilationW, ceil_mode);
+  if (p.padH || p.padW) {
+    // the last window has to start inside of the input, which it may not in
+    // ceil mode
+    if ((OH - 1) * p.dH >= H + p.padH) {
+      --OH;
+    }
+    if ((OW - 1) * p.dW >= W + p.padW) {
+      --OW;
+    }
+  }
+  AT_CHECK(OH >= 1 && OW >= 1,
+           "Given input size: (", C, "x", H, "x", W, "). Calculated output size: (",
+           C, "x", OH, "x", OW, "). Output size is too small");
+
+  auto sizes = self.sizes().vec();
+  sizes[self.dim() - 2] = OH;
+  sizes[self.dim() - 1] = OW;
+  return sizes;
+}
+
+// The kernels take (N, C, H, W); a 3-D (C, H, W) tensor is a batch of one.
+static Tensor as_4d(const Tensor& t) {
+  return t.dim() == 3 ? t.unsqueeze(0) : t;
+}
+
+std::tuple<Tensor&, Tensor&> max_pool2d_with_indices_forward_out_cpu(
+    Tensor& output,
+    Tensor& indices,
+    const Tensor& self,
+    IntList kernel_size,
+    IntList stride,
+    IntList padding,
+    IntList dilation,
+    bool ceil_mode) {
+  checkSameType("max_pool2d_with_indices_forward_out", {output, "output", 1}, {self, "self", 3});
+  checkScalarType("max_pool2d_with_indices_forward_out", {indices, "indices", 2}, kLong);
+  const auto p = pool2d_params(kernel_size, stride, padding, dilation);
+  const auto sizes = pool2d_output_sizes(self, p, ceil_mode);
+  const bool channels_last = is_channels_last(self);
+
+  const Tensor input = as_4d(to_layout(self, channels_last));
+  Tensor out = output_with_layout(output, sizes, channels_last);
+  Tensor ind = output_with_layout(indices, sizes, channels_last);
+  Tensor out_4d = as_4d(out);
+  Tensor ind_4d = as_4d(ind);
+  max_pool2d_kernel(out_4d, ind_4d, input, p);
+  copy_back_(output, out);
+  copy_back_(indices, ind);
+  return std::tuple<Tensor&, Tensor&>(output, indices);
+}
+
+std::tuple<Tensor, Tensor> max_pool2d_with_indices_forward_cpu(
+    const Tensor& self,
+    IntList kernel_size,
+    IntList stride,
+    IntList padding,
+    IntList dilation,
+    bool ceil_mode) {
+  Tensor output = self.type().tensor();
+  Tensor indices = self.type().toScalarType(kLong).tensor();
+  max_pool2d_with_indices_forward_out_cpu(
+      output, indices, self, kernel_size, stride, padding, dilation, ceil_mode);
+  return std::make_tuple(output, indices);
+}
+
+Tensor& max_pool2d_with_indices_backward_out_cpu(
+    Tensor& grad_input,
+    const Tensor& grad_output,
+    const Tensor& self,
+    IntList kernel_size,
+    IntList stride,
+    IntList padding,
+    IntList dilation,
+    bool ceil_mode,
+    const Tensor& indices) {
+  CheckedFrom c = "max_pool2d_with_indices_backward_out";
+  TensorArg grad_output_arg{grad_output, "grad_output", 2};
+  TensorArg indices_arg{indices, "indices", 9};
+  checkSameType(c, {grad_input, "grad_input", 1}, grad_output_arg);
+  checkSameType(c, grad_output_arg, {self, "self", 3});
+  checkScalarType(c, indices_arg, kLong);
+  const auto p = pool2d_params(kernel_size, stride, padding, dilation);
+  const auto sizes = pool2d_output_sizes(self, p, ceil_mode);
+  checkSize(c, grad_output_arg, sizes);
+  checkSize(c, indices_arg, sizes);
+  const bool channels_last = is_channels_last(self);
+
+  Tensor grad = output_with_layout(grad_input, self.sizes(), channels_last);
+  grad.zero_();
+  Tensor grad_4d = as_4d(grad);
+  max_pool2d_backward_kernel(
+      grad_4d,
+      as_4d(to_layout(grad_output, channels_last)),
+      as_4d(to_layout(indices, channels_last)));
+  copy_back_(grad_input, grad);
+  return grad_input;
+}
+
+Tensor max_pool2d_with_indices_backward_cpu(
+    const Tensor& grad_output,
+    const Tensor& self,
+    IntList kernel_size,
+    IntList stride,
+    IntList padding,
+    IntList dilation,
+    bool ceil_mode,
+    const Tensor& indices) {
+  Tensor grad_input = self.type().tensor();
+  return max_pool2d_with_indices_backward_out_cpu(
+      grad_input, grad_output, self, kernel_size, stride, padding, dilation, ceil_mode, indices);
+}
+
+Tensor& avg_pool2d_forward_out_cpu(
+    Tensor& output,
+    const Tensor& self,
+    IntList kernel_size,
+    IntList stride,
+    IntList padding,
+    bool ceil_mode,
+    bool count_include_pad) {
+  checkSameType("avg_pool2d_forward_out", {output, "output", 1}, {self, "self", 2});
+  const auto p = pool2d_params(kernel_size, stride, padding, {1});
+  const auto sizes = pool2d_output_sizes(self, p, ceil_mode);
+  const bool channels_last = is_channels_last(self);
+
+  const Tensor input = as_4d(to_layout(self, channels_last));
+  Tensor out = output_with_layout(output, sizes, channels_last);
+  Tensor out_4d = as_4d(out);
+  avg_pool2d_kernel(out_4d, input, p, count_include_pad);
+  copy_back_(output, out);
+  return output;
+}
+
+Tensor avg_pool2d_forward_cpu(
+    const Tensor& self,
+    IntList kernel_size,
+    IntList stride,
+    IntList padding,
+    bool ceil_mode,
+    bool count_include_pad) {
+  Tensor output = self.type().tensor();
+  return avg_pool2d_forward_out_cpu(
+      output, self, kernel_size, stride, padding, ceil_mode, count_include_pad);
+}
+
+Tensor& avg_pool2d_backward_out_cpu(
+    Tensor& grad_input,
+    const Tensor& grad_output,
+    const Tensor& self,
+    IntList kernel_size,
+    IntList stride,
+    IntList padding,
+    bool ceil_mode,
+    bool count_include_pad) {
+  CheckedFrom c = "avg_pool2d_backward_out";
+  TensorArg grad_output_arg{grad_output, "grad_output", 2};
+  checkSameType(c, {grad_input, "grad_input", 1}, grad_output_arg);
+  checkSameType(c, grad_output_arg, {self, "self", 3});
+  const auto p = pool2d_params(kernel_size, stride, padding, {1});
+  const auto sizes = pool2d_output_sizes(self, p, ceil_mode);
+  checkSize(c, grad_output_arg, sizes);
+  const bool channels_last = is_channels_last(self);
+
+  Tensor grad = output_with_layout(grad_input, self.sizes(), channels_last);
+  grad.zero_();
+  Tensor grad_4d = as_4d(grad);
+  avg_pool2d_backward_kernel(
+      grad_4d, as_4d(to_layout(grad_output, channels_last)), p, count_include_pad);
+  copy_back_(grad_input, grad);
+  return grad_input;
+}
+
+Tensor avg_pool2d_backward_cpu(
+    const Tensor& grad_output,
+    const Tensor& self,
+    IntList kernel_size,
+    IntList stride,
+    IntList padding,
+    bool ceil_mode,
+    bool count_include_pad) {
+  Tensor grad_input = self.type().tensor();
+  return avg_pool2d_backward_out_cpu(
+      grad_input, grad_output, self, kernel_size, stride, padding, ceil_mode, count_include_pad);
+}
+
 } // namespace native
 } // namespace at
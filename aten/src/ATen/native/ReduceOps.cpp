@@ -345,6 +345,12 @@ Tensor _prod(const Tensor &self, int64_t dim_, bool keepdim) {
 
 Tensor& logsumexp_out(Tensor& result, const Tensor &self, int64_t dim_, bool keepdim) {
   int64_t dim = maybe_wrap_dim(dim_, self.dim());
+  if (self.dim() > 0 && self.numel() != 0 && _has_float_reduce_kernel(result, self)) {
+    _dimreduce_setup(result, self, dim);
+    logsumexp_kernel(result, self, dim);
+    if (!keepdim) result.squeeze_(dim);
+    return result;
+  }
   // can't take max of empty tensor.
   if (self.numel() != 0) {
     auto maxes = at::max_values(self, dim, true);
@@ -369,7 +375,7 @@ Tensor logsumexp(const Tensor &self, int64_t dim_, bool keepdim) {
 
 // MULTI DIM REDUCE ###########################################################
 
-// NB: this applies two optimizations:
+// NB: this applies three optimizations:
 //   1. Reducing the dimensions in the order of decreasing size, so that the
 //      larger dimensions are dealt earlier and we can work with less elements
 //      overall.
@@ -448,8 +454,43 @@ Tensor logsumexp(const Tensor &self, int64_t dim_, bool keepdim) {
 //                buffer:        [ {output of 3rd it}, {output of 2nd it}]
 //            Return {output of 3rd it}.
 //
-// TODO: If two or more reduced dimensions are contiguous, reduce as if they are
-//       a large dimension.
+//   3. If the reduced dimensions are adjacent and the input is contiguous, they
+//      are reduced in one go as if they were a single large dimension (see
+//      _merge_reduced_dims).
+
+// Returns self viewed with the reduced dimensions merged into one, dims[0]
+// after sorting, if they are adjacent and self is contiguous.
+static optional<Tensor> _merge_reduced_dims(const Tensor &self, std::vector<int64_t> dims) {
+  if (!self.is_contiguous()) {
+    return nullopt;
+  }
+  std::sort(dims.begin(), dims.end());
+  for (size_t i = 1; i < dims.size(); i++) {
+    if (dims[i] != dims[i - 1] + 1) {
+      return nullopt;
+    }
+  }
+  auto sizes = self.sizes();
+  std::vector<int64_t> merged_sizes(sizes.begin(), sizes.begin() + dims.front());
+  int64_t merged_size = 1;
+  for (auto dim : dims) {
+    merged_size *= sizes[dim];
+  }
+  merged_sizes.push_back(merged_size);
+  merged_sizes.insert(merged_sizes.end(), sizes.begin() + dims.back() + 1, sizes.end());
+  return self.view(merged_sizes);
+}
+
+// Turns the result of reducing the merged dimension with keepdim=true into
+// the result of reducing all of dims with keepdim=true.
+static void _unmerge_reduced_dims(Tensor &result, std::vector<int64_t> dims) {
+  std::sort(dims.begin(), dims.end());
+  result.squeeze_(dims.front());
+  for (auto dim : dims) {
+    result.unsqueeze_(dim);
+  }
+}
+
 template <Tensor (reduce_1)(const Tensor &, int64_t, bool),
     Tensor& (reduce_1_out)(Tensor& result, const Tensor &, int64_t, bool)>
 inline Tensor reduce_multi_associative(const Tensor &self, IntList dims_, bool keepdim) {
@@ -466,6 +507,13 @@ inline Tensor reduce_multi_associative(const Tensor &self, IntList dims_, bool k
   auto reduced_size = self.sizes().vec();
   auto dims = dims_.vec();
   maybe_wrap_dims(dims, ndims);
+  if (auto merged = _merge_reduced_dims(self, dims)) {
+    Tensor result = reduce_1(*merged, *std::min_element(dims.begin(), dims.end()), keepdim);
+    if (keepdim) {
+      _unmerge_reduced_dims(result, dims);
+    }
+    return result;
+  }
   // Sort the reduced dimensions so that we reduce the larger dimensions first.
   std::sort(dims.begin(), dims.end(),
         [&](int64_t i, int64_t j){ return reduced_size[i] > reduced_size[j]; });
@@ -522,6 +570,13 @@ inline Tensor& reduce_multi_associative_out(Tensor &result, const Tensor &self,
   auto reduced_size = self.sizes().vec();
   auto dims = dims_.vec();
   maybe_wrap_dims(dims, ndims);
+  if (auto merged = _merge_reduced_dims(self, dims)) {
+    reduce_1_out(result, *merged, *std::min_element(dims.begin(), dims.end()), keepdim);
+    if (keepdim) {
+      _unmerge_reduced_dims(result, dims);
+    }
+    return result;
+  }
   // Sort the reduced dimensions so that we reduce the largest dimension first.
   std::sort(dims.begin(), dims.end(),
         [&](int64_t i, int64_t j){ return reduced_size[i] > reduced_size[j]; });
@@ -593,6 +648,11 @@ Tensor &norm_out(Tensor &result, const Tensor &self, Scalar p, int64_t dim, bool
   dim = maybe_wrap_dim(dim, self.dim());
   if (_dimreduce_return_trivial(result, self, 0, dim, keepdim)) {
     return result;
+  } else if (_has_norm_kernel(self, p) && _has_float_reduce_kernel(result, self)) {
+    _dimreduce_setup(result, self, dim);
+    norm_kernel(result, self, p, dim);
+    if (!keepdim) result.squeeze_(dim);
+    return result;
   } else {
     return at::_th_norm_out(result, self, p, dim, keepdim);
   }
@@ -637,7 +697,15 @@ Tensor var(const Tensor& self, bool unbiased) {
            "var only supports CPU AND CUDA backend, got: ", at::toString(self.type().backend()));
   AT_CHECK(at::isFloatingType(self.type().scalarType()), "var only supports floating-point dtypes");
   auto trivial_return = _allreduce_return_trivial(self, std::numeric_limits<double>::quiet_NaN());
-  return trivial_return.has_value() ? trivial_return.value() : at::_th_var(self, unbiased);
+  if (trivial_return.has_value()) {
+    return trivial_return.value();
+  } else if (_has_float_reduce_kernel(self)) {
+    Tensor result = at::empty({}, self.type());
+    std_var_kernel(result, self, at::nullopt, unbiased, /*take_sqrt=*/false);
+    return result;
+  } else {
+    return at::_th_var(self, unbiased);
+  }
 }
 
 Tensor var(const Tensor& self, int64_t dim, bool unbiased, bool keepdim) {
@@ -652,6 +720,11 @@ Tensor &var_out(Tensor &result, const Tensor &self, int64_t dim, bool unbiased,
   dim = maybe_wrap_dim(dim, self.dim());
   if (_dimreduce_return_trivial(result, self, std::numeric_limits<double>::quiet_NaN(), dim, keepdim)) {
     return result;
+  } else if (_has_float_reduce_kernel(result, self)) {
+    _dimreduce_setup(result, self, dim);
+    std_var_kernel(result, self, dim, unbiased, /*take_sqrt=*/false);
+    if (!keepdim) result.squeeze_(dim);
+    return result;
   } else {
     return at::_th_var_out(result, self, dim, unbiased, keepdim);
   }
@@ -662,7 +735,15 @@ Tensor std(const Tensor& self, bool unbiased) {
            "std only supports CPU AND CUDA backend, got: ", at::toString(self.type().backend()));
   AT_CHECK(at::isFloatingType(self.type().scalarType()), "std only supports floating-point dtypes");
   auto trivial_return = _allreduce_return_trivial(self, std::numeric_limits<double>::quiet_NaN());
-  return trivial_return.has_value() ? trivial_return.value() : at::_th_std(self, unbiased);
+  if (trivial_return.has_value()) {
+    return trivial_return.value();
+  } else if (_has_float_reduce_kernel(self)) {
+    Tensor result = at::empty({}, self.type());
+    std_var_kernel(result, self, at::nullopt, unbiased, /*take_sqrt=*/true);
+    return result;
+  } else {
+    return at::_th_std(self, unbiased);
+  }
 }
 
 Tensor std(const Tensor& self, int64_t dim, bool unbiased, bool keepdim) {
@@ -677,6 +758,11 @@ Tensor &std_out(Tensor &result, const Tensor &self, int64_t dim, bool unbiased,
   dim = maybe_wrap_dim(dim, self.dim());
   if (_dimreduce_return_trivial(result, self, std::numeric_limits<double>::quiet_NaN(), dim, keepdim)) {
     return result;
+  } else if (_has_float_reduce_kernel(result, self)) {
+    _dimreduce_setup(result, self, dim);
+    std_var_kernel(result, self, dim, unbiased, /*take_sqrt=*/true);
+    if (!keepdim) result.squeeze_(dim);
+    return result;
   } else {
     return at::_th_std_out(result, self, dim, unbiased, keepdim);
   }
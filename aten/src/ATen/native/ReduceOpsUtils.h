@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cmath>
+
 namespace at { namespace native {
 
 static Tensor &_dimreduce_setup(Tensor &result, const Tensor &self,
@@ -52,4 +54,25 @@ static at::optional<Tensor> _allreduce_return_trivial(const Tensor &self, Scalar
   return at::nullopt;
 }
 
+// The floating point kernels in cpu/ReduceOpsKernel.h (all but sum and
+// prod) take contiguous CPU tensors of float or double, and write to a
+// contiguous result of the same type.
+static inline bool _has_float_reduce_kernel(const Tensor &self) {
+  auto scalar_type = self.type().scalarType();
+  return self.type().backend() == Backend::CPU &&
+         (scalar_type == ScalarType::Float || scalar_type == ScalarType::Double) &&
+         self.is_contiguous();
+}
+
+static inline bool _has_float_reduce_kernel(const Tensor &result, const Tensor &self) {
+  return _has_float_reduce_kernel(self) &&
+         &result.type() == &self.type() && result.is_contiguous();
+}
+
+static inline bool _has_norm_kernel(const Tensor &self, Scalar p) {
+  auto pval = p.toDouble();
+  return _has_float_reduce_kernel(self) &&
+         (pval == 1 || pval == 2 || pval == INFINITY);
+}
+
 }}  // at::native
@@ -156,6 +156,49 @@ Tensor log_softmax_cpu(const Tensor& input_, const int64_t dim_) {
   return output;
 }
 
+std::tuple<Tensor, Tensor> cross_entropy_lastdim_cpu(
+    const Tensor& input_,
+    const Tensor& target_,
+    const int64_t ignore_index) {
+  auto input = input_.contiguous();
+  auto target = target_.contiguous();
+  int64_t classes = input.size(1);
+  auto target_data = target.data<int64_t>();
+  for (int64_t i = 0; i < target.numel(); i++) {
+    AT_CHECK(
+        target_data[i] == ignore_index ||
+            (target_data[i] >= 0 && target_data[i] < classes),
+        "Target ", target_data[i], " is out of bounds.");
+  }
+  Tensor loss = at::empty({input.size(0)}, input.type());
+  Tensor logsumexp = at::empty({input.size(0)}, input.type());
+  if (input.numel() > 0) {
+    cross_entropy_lastdim_kernel(loss, logsumexp, input, target, ignore_index);
+  } else {
+    loss.zero_();
+    logsumexp.fill_(-std::numeric_limits<double>::infinity());
+  }
+  return std::make_tuple(loss, logsumexp);
+}
+
+Tensor cross_entropy_lastdim_backward_cpu(
+    const Tensor& scale_,
+    const Tensor& input_,
+    const Tensor& target_,
+    const Tensor& logsumexp_,
+    const int64_t ignore_index) {
+  auto scale = scale_.contiguous();
+  auto input = input_.contiguous();
+  auto target = target_.contiguous();
+  auto logsumexp = logsumexp_.contiguous();
+  Tensor grad_input = at::native::empty_like(input);
+  if (input.numel() > 0) {
+    cross_entropy_backward_lastdim_kernel(
+        grad_input, scale, input, target, logsumexp, ignore_index);
+  }
+  return grad_input;
+}
+
 Tensor softmax_backward_cpu(
     const Tensor& grad_,
     const Tensor& output_,
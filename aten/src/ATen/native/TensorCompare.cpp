@@ -5,6 +5,7 @@
 #include "ATen/ExpandUtils.h"
 #include "ATen/NativeFunctions.h"
 #include "ReduceOpsUtils.h"
+#include "cpu/ReduceOpsKernel.h"
 
 namespace {
 template <typename scalar_t>
@@ -167,6 +168,14 @@ std::tuple<Tensor &,Tensor &> max_out(Tensor& max, Tensor& max_indices,
 }
 
 Tensor max_values(const Tensor& self, int64_t dim, bool keepdim) {
+  dim = maybe_wrap_dim(dim, self.dim());
+  if (self.dim() > 0 && self.numel() != 0 && _has_float_reduce_kernel(self)) {
+    Tensor result = self.type().tensor();
+    _dimreduce_setup(result, self, dim);
+    max_kernel(result, self, dim);
+    if (!keepdim) result.squeeze_(dim);
+    return result;
+  }
   return std::get<0>(self.max(dim, keepdim));
 }
 
@@ -191,6 +200,14 @@ std::tuple<Tensor &,Tensor &> min_out(Tensor& min, Tensor& min_indices,
 }
 
 Tensor min_values(const Tensor& self, int64_t dim, bool keepdim) {
+  dim = maybe_wrap_dim(dim, self.dim());
+  if (self.dim() > 0 && self.numel() != 0 && _has_float_reduce_kernel(self)) {
+    Tensor result = self.type().tensor();
+    _dimreduce_setup(result, self, dim);
+    min_kernel(result, self, dim);
+    if (!keepdim) result.squeeze_(dim);
+    return result;
+  }
   return std::get<0>(self.min(dim, keepdim));
 }
 
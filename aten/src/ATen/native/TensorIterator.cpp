@@ -0,0 +1,200 @@
+#include "ATen/native/TensorIterator.h"
+
+#include "ATen/ExpandUtils.h"
+
+#include <algorithm>
+
+namespace at { namespace native {
+
+TensorIterator TensorIterator::binary_op(Tensor& out, const Tensor& a, const Tensor& b) {
+  TensorIterator iter;
+  iter.compute_shape(out, a, b);
+  iter.add_operand(out);
+  iter.add_operand(a);
+  iter.add_operand(b);
+  iter.compute_strides();
+  iter.reorder_dimensions();
+  iter.coalesce_dimensions();
+  return iter;
+}
+
+int64_t TensorIterator::numel() const {
+  int64_t numel = 1;
+  for (int64_t size : shape_) {
+    numel *= size;
+  }
+  return numel;
+}
+
+void TensorIterator::add_operand(const Tensor& tensor) {
+  if (!operands_.empty()) {
+    AT_CHECK(&tensor.type() == &type(), "expected type ", type().toString(),
+             " but got ", tensor.type().toString());
+  }
+  operands_.push_back(tensor);
+}
+
+void TensorIterator::compute_shape(Tensor& out, const Tensor& a, const Tensor& b) {
+  auto shape = infer_size(a.sizes(), b.sizes());
+  if (!out.sizes().equals(shape)) {
+    bool out_is_input = out.get() == a.get() || out.get() == b.get();
+    AT_CHECK(!out_is_input, "output with shape ", out.sizes(),
+             " doesn't match the broadcast shape ", IntList(shape));
+    out.resize_(shape);
+  }
+  // innermost dimension first
+  shape_ = DimVector(shape.rbegin(), shape.rend());
+}
+
+void TensorIterator::compute_strides() {
+  int ndim = shape_.size();
+  for (auto& tensor : operands_) {
+    auto element_size = tensor.type().elementSizeInBytes();
+    auto sizes = tensor.sizes();
+    auto strides = tensor.strides();
+    int offset = ndim - tensor.dim();
+    DimVector byte_strides(ndim, 0);
+    for (int i = 0; i < tensor.dim(); i++) {
+      // broadcast dimensions and dimensions of size 1 don't move
+      if (sizes[i] != 1) {
+        byte_strides[ndim - 1 - (offset + i)] = strides[i] * element_size;
+      }
+    }
+    strides_.push_back(std::move(byte_strides));
+  }
+}
+
+// Sorts the dimensions by increasing stride of the output, so that the inner
+// loop runs along the dimension of the output that is contiguous in memory.
+// Dimensions the output doesn't move along are ordered by the inputs.
+void TensorIterator::reorder_dimensions() {
+  int ndim = shape_.size();
+  if (ndim <= 1) {
+    return;
+  }
+  // returns true if dim0 should be iterated over inside of dim1
+  auto should_be_inner = [&](int dim0, int dim1) {
+    for (auto& strides : strides_) {
+      int64_t stride0 = strides[dim0];
+      int64_t stride1 = strides[dim1];
+      if (stride0 == 0 || stride1 == 0) {
+        continue;
+      }
+      return stride0 < stride1;
+    }
+    return false;
+  };
+  DimVector perm(ndim, 0);
+  for (int i = 0; i < ndim; i++) {
+    perm[i] = i;
+  }
+  // insertion sort, stable so that the original order breaks ties
+  for (int i = 1; i < ndim; i++) {
+    for (int j = i; j > 0 && should_be_inner(perm[j], perm[j - 1]); j--) {
+      std::swap(perm[j], perm[j - 1]);
+    }
+  }
+  auto permute = [&](DimVector& values) {
+    DimVector permuted(ndim, 0);
+    for (int i = 0; i < ndim; i++) {
+      permuted[i] = values[perm[i]];
+    }
+    values = std::move(permuted);
+  };
+  permute(shape_);
+  for (auto& strides : strides_) {
+    permute(strides);
+  }
+}
+
+// Merges adjacent dimensions that can be walked with a single stride in
+// every operand, e.g. both dimensions of a contiguous matrix.
+void TensorIterator::coalesce_dimensions() {
+  int ndim = shape_.size();
+  if (ndim <= 1) {
+    return;
+  }
+  auto can_coalesce = [&](int dim0, int dim1) {
+    int64_t size0 = shape_[dim0];
+    int64_t size1 = shape_[dim1];
+    if (size0 == 1 || size1 == 1) {
+      return true;
+    }
+    for (auto& strides : strides_) {
+      if (strides[dim0] * size0 != strides[dim1]) {
+        return false;
+      }
+    }
+    return true;
+  };
+  int prev_dim = 0;
+  for (int dim = 1; dim < ndim; dim++) {
+    if (can_coalesce(prev_dim, dim)) {
+      if (shape_[prev_dim] == 1) {
+        for (auto& strides : strides_) {
+          strides[prev_dim] = strides[dim];
+        }
+      }
+      shape_[prev_dim] *= shape_[dim];
+    } else {
+      prev_dim++;
+      if (prev_dim != dim) {
+        shape_[prev_dim] = shape_[dim];
+        for (auto& strides : strides_) {
+          strides[prev_dim] = strides[dim];
+        }
+      }
+    }
+  }
+  shape_.resize(prev_dim + 1);
+  for (auto& strides : strides_) {
+    strides.resize(prev_dim + 1);
+  }
+}
+
+void TensorIterator::serial_for_each(const loop_t& loop, int64_t begin, int64_t end) const {
+  int ntensors = this->ntensors();
+  SmallVector<char*, 4> base(ntensors, nullptr);
+  SmallVector<char*, 4> data(ntensors, nullptr);
+  SmallVector<int64_t, 4> inner_strides(ntensors, 0);
+  for (int k = 0; k < ntensors; k++) {
+    base[k] = static_cast<char*>(operands_[k].data_ptr());
+  }
+  if (shape_.empty()) {
+    // zero-dim operands
+    loop(ntensors, base.data(), inner_strides.data(), 1);
+    return;
+  }
+  for (int k = 0; k < ntensors; k++) {
+    inner_strides[k] = strides_[k][0];
+  }
+
+  int ndim = shape_.size();
+  DimVector counter(ndim, 0);
+  int64_t remainder = begin;
+  for (int dim = 0; dim < ndim; dim++) {
+    counter[dim] = remainder % shape_[dim];
+    remainder /= shape_[dim];
+  }
+
+  int64_t inner_size = shape_[0];
+  while (begin < end) {
+    for (int k = 0; k < ntensors; k++) {
+      data[k] = base[k];
+      for (int dim = 0; dim < ndim; dim++) {
+        data[k] += counter[dim] * strides_[k][dim];
+      }
+    }
+    int64_t n = std::min(inner_size - counter[0], end - begin);
+    loop(ntensors, data.data(), inner_strides.data(), n);
+    begin += n;
+
+    counter[0] += n;
+    for (int dim = 0; dim < ndim - 1 && counter[dim] == shape_[dim]; dim++) {
+      counter[dim] = 0;
+      counter[dim + 1]++;
+    }
+  }
+}
+
+}} // namespace at::native
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ATen/ATen.h"
+#include "ATen/DimVector.h"
+#include "ATen/Parallel.h"
+#include "ATen/SmallVector.h"
+
+#include <functional>
+
+// TensorIterator walks the elements of an output and its inputs, all of the
+// same type, broadcasting the inputs against each other. Elementwise kernels
+// then only have to implement a loop over a single dimension:
+//
+//   auto iter = TensorIterator::binary_op(result, self, other);
+//   iter.for_each([](int ntensors, char** data, const int64_t* strides, int64_t n) {
+//     // data[0] points to the output and data[1], data[2] to the inputs.
+//     // Element i of operand k is at data[k] + i * strides[k] (in bytes).
+//   });
+//
+// Before iterating, the dimensions are reordered by the strides of the
+// output and the dimensions that are contiguous in every operand are
+// coalesced, so that the inner loop is as long as possible. An inner stride
+// of 0 means that the operand is broadcast along the loop. Iteration is
+// split across threads with at::parallel_for.
+//
+// The vectorized inner loops for CPU kernels are in native/cpu/Loops.h.
+// Only the CPU add, sub, mul and div kernels are ported to it so far; the
+// other binary and ternary pointwise ops (pow, fmod, addcmul, ...) still use
+// the TH apply macros.
+
+namespace at { namespace native {
+
+struct TensorIterator {
+  using loop_t = std::function<void(int, char**, const int64_t*, int64_t)>;
+
+  // Iterates over out = op(a, b). out is resized to the broadcast shape of
+  // a and b, unless it is one of them, in which case it must already have
+  // that shape.
+  static TensorIterator binary_op(Tensor& out, const Tensor& a, const Tensor& b);
+
+  int ntensors() const { return operands_.size(); }
+  int ndim() const { return shape_.size(); }
+  int64_t numel() const;
+  const Type& type() const { return operands_[0].type(); }
+
+  // The shape and per operand byte strides after reordering and coalescing,
+  // innermost dimension first.
+  IntList shape() const { return shape_; }
+  IntList strides(int arg) const { return strides_[arg]; }
+
+  template <typename F>
+  void for_each(const F& loop, int64_t grain_size = internal::GRAIN_SIZE) const {
+    int64_t n = numel();
+    if (n == 0) {
+      return;
+    }
+    if (n < grain_size || get_intra_op_num_threads() == 1) {
+      serial_for_each(loop, 0, n);
+      return;
+    }
+    parallel_for(0, n, grain_size, [&](int64_t begin, int64_t end) {
+      serial_for_each(loop, begin, end);
+    });
+  }
+
+  // Runs the loop over the elements [begin, end) in the iteration order, one
+  // call per (part of a) row of the innermost dimension.
+  void serial_for_each(const loop_t& loop, int64_t begin, int64_t end) const;
+
+ private:
+  void add_operand(const Tensor& tensor);
+  void compute_shape(Tensor& out, const Tensor& a, const Tensor& b);
+  void compute_strides();
+  void reorder_dimensions();
+  void coalesce_dimensions();
+
+  DimVector shape_;
+  SmallVector<Tensor, 4> operands_;
+  SmallVector<DimVector, 4> strides_;
+};
+
+}} // namespace at::native
@@ -2,50 +2,159 @@
 
 #include "ATen/ATen.h"
 #include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
 
-#include <set>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <tuple>
-#include <unordered_map>
-#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace at {
 namespace native{
 
 namespace {
 
+// Orders NaNs after all other values, so that inputs with NaNs still have a
+// strict weak ordering. Like the other comparisons, NaNs are not equal to each
+// other, so every NaN of the input is a unique element.
+template <typename scalar_t>
+inline bool unique_less(scalar_t a, scalar_t b) {
+  return a < b || (std::isnan(b) && !std::isnan(a));
+}
+
+template <typename scalar_t>
+inline scalar_t unique_key(scalar_t value) {
+  return value;
+}
+
+template <typename scalar_t>
+inline scalar_t unique_key(const std::pair<scalar_t, int64_t>& entry) {
+  return entry.first;
+}
+
+template <typename scalar_t>
+inline void set_inverse(scalar_t, int64_t, int64_t*) {}
+
+template <typename scalar_t>
+inline void set_inverse(
+    const std::pair<scalar_t, int64_t>& entry,
+    int64_t unique_index,
+    int64_t* inverse_indices) {
+  inverse_indices[entry.second] = unique_index;
+}
+
+// Splits [0, numel) into num_chunks contiguous chunks and runs
+// f(chunk, begin, end) on every chunk in parallel.
+template <typename F>
+void parallel_for_chunks(int64_t numel, int64_t num_chunks, const F& f) {
+  const int64_t chunk_size = divup(numel, num_chunks);
+  parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t chunk = begin; chunk < end; ++chunk) {
+      const int64_t chunk_begin = std::min(numel, chunk * chunk_size);
+      f(chunk, chunk_begin, std::min(numel, chunk_begin + chunk_size));
+    }
+  });
+}
+
+// Sorts every chunk in parallel, then merges neighbouring runs pairwise in
+// parallel until a single sorted run is left.
+template <typename T, typename Compare>
+void parallel_sort(std::vector<T>& vec, int64_t num_chunks, const Compare& comp) {
+  const int64_t numel = vec.size();
+  const int64_t chunk_size = divup(numel, num_chunks);
+  parallel_for_chunks(numel, num_chunks, [&](int64_t, int64_t begin, int64_t end) {
+    std::sort(vec.begin() + begin, vec.begin() + end, comp);
+  });
+  for (int64_t width = chunk_size; width < numel; width *= 2) {
+    const int64_t num_merges = divup(numel, 2 * width);
+    parallel_for(0, num_merges, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t merge = begin; merge < end; ++merge) {
+        const int64_t lo = merge * 2 * width;
+        const int64_t mid = std::min(numel, lo + width);
+        const int64_t hi = std::min(numel, lo + 2 * width);
+        std::inplace_merge(
+            vec.begin() + lo, vec.begin() + mid, vec.begin() + hi, comp);
+      }
+    });
+  }
+}
+
+// Sorts the elements (with their positions in the input if return_inverse),
+// then every chunk of the sorted elements counts the first occurrences of
+// the unique elements it contains, so that after a scan over the chunks the
+// unique elements and the inverse indices can be written out in parallel.
+template <typename scalar_t, typename T>
+std::tuple<Tensor, Tensor> _unique_cpu_sorted(
+    const Tensor& input,
+    std::vector<T>& vec,
+    const bool return_inverse) {
+  const int64_t numel = vec.size();
+  const int64_t num_chunks = std::max<int64_t>(1, std::min<int64_t>(
+      get_intra_op_num_threads(), divup(numel, internal::GRAIN_SIZE)));
+
+  parallel_sort(vec, num_chunks, [](const T& a, const T& b) {
+    return unique_less<scalar_t>(unique_key<scalar_t>(a), unique_key<scalar_t>(b));
+  });
+
+  const auto is_first = [&](int64_t i) {
+    return i == 0 ||
+        !(unique_key<scalar_t>(vec[i]) == unique_key<scalar_t>(vec[i - 1]));
+  };
+  std::vector<int64_t> chunk_offsets(num_chunks + 1, 0);
+  parallel_for_chunks(numel, num_chunks, [&](int64_t chunk, int64_t begin, int64_t end) {
+    int64_t count = 0;
+    for (int64_t i = begin; i < end; ++i) {
+      count += is_first(i);
+    }
+    chunk_offsets[chunk + 1] = count;
+  });
+  std::partial_sum(
+      chunk_offsets.begin(), chunk_offsets.end(), chunk_offsets.begin());
+
+  Tensor output = at::empty({chunk_offsets[num_chunks]}, input.type());
+  scalar_t* output_data = output.data<scalar_t>();
+  Tensor inverse_indices = at::empty({0}, input.type().toScalarType(kLong));
+  int64_t* inverse_indices_data = nullptr;
+  if (return_inverse) {
+    inverse_indices.resize_(input.sizes());
+    inverse_indices_data = inverse_indices.data<int64_t>();
+  }
+  parallel_for_chunks(numel, num_chunks, [&](int64_t chunk, int64_t begin, int64_t end) {
+    // the index of the unique element of vec[begin] in the output
+    int64_t unique_index = chunk_offsets[chunk] - 1;
+    for (int64_t i = begin; i < end; ++i) {
+      if (is_first(i)) {
+        output_data[++unique_index] = unique_key<scalar_t>(vec[i]);
+      }
+      set_inverse(vec[i], unique_index, inverse_indices_data);
+    }
+  });
+  return std::make_tuple(output, inverse_indices);
+}
+
 template <typename scalar_t>
 std::tuple<Tensor, Tensor> _unique_cpu_template(
     const Tensor& self,
     const bool sorted,
     const bool return_inverse) {
+  // The unique elements are always found by sorting, so they are returned
+  // in ascending order whether or not `sorted` is set.
   const Tensor& input = self.contiguous();
   const scalar_t* input_data = input.data<scalar_t>();
-  std::unordered_set<scalar_t> set(input_data, input_data + input.numel());
-  Tensor output = at::empty({static_cast<int64_t>(set.size())}, input.type());
-  scalar_t* output_data = output.data<scalar_t>();
-
-  if (sorted) {
-    std::vector<scalar_t> vec(set.begin(), set.end());
-    std::sort(vec.begin(), vec.end());
-    std::copy(vec.begin(), vec.end(), output_data);
-  } else {
-    std::copy(set.begin(), set.end(), output_data);
-  }
-
-  Tensor inverse_indices = at::empty({0}, self.type().toScalarType(kLong));
+  const int64_t numel = input.numel();
   if (return_inverse) {
-    inverse_indices.resize_(input.sizes());
-    int64_t* inverse_indices_data = inverse_indices.data<int64_t>();
-    std::unordered_map<scalar_t, int64_t> inverse_map;
-    inverse_map.reserve(output.numel());
-    for (int i = 0; i < output.numel(); ++i) {
-      inverse_map[output_data[i]] = i;
-    }
-    for (int i = 0; i < input.numel(); ++i) {
-      inverse_indices_data[i] = inverse_map[input_data[i]];
-    }
+    std::vector<std::pair<scalar_t, int64_t>> vec(numel);
+    parallel_for(0, numel, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; ++i) {
+        vec[i] = std::make_pair(input_data[i], i);
+      }
+    });
+    return _unique_cpu_sorted<scalar_t>(input, vec, return_inverse);
   }
-  return std::make_tuple(output, inverse_indices);
+  std::vector<scalar_t> vec(input_data, input_data + numel);
+  return _unique_cpu_sorted<scalar_t>(input, vec, return_inverse);
 }
 } // namespace
 
@@ -0,0 +1,141 @@
+#include "ATen/ATen.h"
+
+#include "ATen/Error.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/TensorUtils.h"
+#include "ATen/Utils.h"
+#include "ATen/native/ChannelsLastUtils.h"
+#include "ATen/native/cpu/UpSampleKernel.h"
+
+namespace at { namespace native {
+
+// The CPU upsample_nearest2d and upsample_bilinear2d of nn.yaml. They check
+// their arguments like SpatialUpSamplingNearest and SpatialUpSamplingBilinear
+// of THNN, and run in the layout of their input: output is channels-last if
+// self is, and grad_input if grad_output is (see ChannelsLastUtils.h).
+
+static void upsample2d_shape_check(
+    int64_t input_height, int64_t input_width, int64_t output_height, int64_t output_width) {
+  AT_CHECK(input_height > 0 && input_width > 0 && output_height > 0 && output_width > 0,
+           "input and output sizes should be greater than 0, but got input (H: ", input_height,
+           ", W: ", input_width, ") output (H: ", output_height, ", W: ", output_width, ")");
+}
+
+// The tensor of the sizes of the input, grad_input, is created by the
+// backward. The kernels run in its layout, which is the contiguous one if it
+// is both.
+static Tensor upsample2d_grad_input(
+    CheckedFrom c, Tensor& grad_input, const Tensor& grad_output,
+    IntList input_size, IntList output_size) {
+  TensorArg grad_output_arg{grad_output, "grad_output", 1};
+  checkSameType(c, {grad_input, "grad_input", 4}, grad_output_arg);
+  upsample2d_shape_check(input_size[2], input_size[3], output_size[0], output_size[1]);
+  checkSize(c, grad_output_arg, {input_size[0], input_size[1], output_size[0], output_size[1]});
+  Tensor grad = output_with_layout(grad_input, input_size, is_channels_last(grad_output));
+  grad.zero_();
+  return grad;
+}
+
+Tensor& upsample_nearest2d_forward_out_cpu(
+    Tensor& output, const Tensor& self, IntList output_size) {
+  checkSameType("upsample_nearest2d_forward_out", {output, "output", 3}, {self, "self", 1});
+  auto output_size_ = check_intlist<2>(output_size, "output_size", 2);
+  AT_CHECK(self.dim() == 4, "4D input tensor expected but got: ", self.sizes());
+  const int64_t H = self.size(2), W = self.size(3);
+  const int64_t OH = output_size_[0], OW = output_size_[1];
+  upsample2d_shape_check(H, W, OH, OW);
+  const bool channels_last = is_channels_last(self);
+
+  const Tensor input = to_layout(self, channels_last);
+  Tensor out = output_with_layout(output, {self.size(0), self.size(1), OH, OW}, channels_last);
+  if (H == OH && W == OW) {
+    out.copy_(input);
+  } else {
+    upsample_nearest2d_kernel(out, input);
+  }
+  copy_back_(output, out);
+  return output;
+}
+
+Tensor upsample_nearest2d_forward_cpu(const Tensor& self, IntList output_size) {
+  Tensor output = self.type().tensor();
+  return upsample_nearest2d_forward_out_cpu(output, self, output_size);
+}
+
+Tensor& upsample_nearest2d_backward_out_cpu(
+    Tensor& grad_input, const Tensor& grad_output, IntList output_size, IntList input_size) {
+  auto output_size_ = check_intlist<2>(output_size, "output_size", 2);
+  auto input_size_ = check_intlist<4>(input_size, "input_size", 3);
+  Tensor grad = upsample2d_grad_input(
+      "upsample_nearest2d_backward_out", grad_input, grad_output, input_size_, output_size_);
+
+  const Tensor grad_output_ = to_layout(grad_output, !grad.is_contiguous());
+  if (grad.sizes().equals(grad_output_.sizes())) {
+    grad.copy_(grad_output_);
+  } else {
+    upsample_nearest2d_backward_kernel(grad, grad_output_);
+  }
+  copy_back_(grad_input, grad);
+  return grad_input;
+}
+
+Tensor upsample_nearest2d_backward_cpu(
+    const Tensor& grad_output, IntList output_size, IntList input_size) {
+  Tensor grad_input = grad_output.type().tensor();
+  return upsample_nearest2d_backward_out_cpu(grad_input, grad_output, output_size, input_size);
+}
+
+Tensor& upsample_bilinear2d_forward_out_cpu(
+    Tensor& output, const Tensor& self, IntList output_size, bool align_corners) {
+  checkSameType("upsample_bilinear2d_forward_out", {output, "output", 4}, {self, "self", 1});
+  auto output_size_ = check_intlist<2>(output_size, "output_size", 2);
+  AT_CHECK(self.numel() > 0 && self.dim() == 4,
+           "non-empty 4D input tensor expected but got: ", self.sizes());
+  const int64_t H = self.size(2), W = self.size(3);
+  const int64_t OH = output_size_[0], OW = output_size_[1];
+  upsample2d_shape_check(H, W, OH, OW);
+  const bool channels_last = is_channels_last(self);
+
+  const Tensor input = to_layout(self, channels_last);
+  Tensor out = output_with_layout(output, {self.size(0), self.size(1), OH, OW}, channels_last);
+  if (H == OH && W == OW) {
+    out.copy_(input);
+  } else {
+    upsample_bilinear2d_kernel(out, input, align_corners);
+  }
+  copy_back_(output, out);
+  return output;
+}
+
+Tensor upsample_bilinear2d_forward_cpu(
+    const Tensor& self, IntList output_size, bool align_corners) {
+  Tensor output = self.type().tensor();
+  return upsample_bilinear2d_forward_out_cpu(output, self, output_size, align_corners);
+}
+
+Tensor& upsample_bilinear2d_backward_out_cpu(
+    Tensor& grad_input, const Tensor& grad_output,
+    IntList output_size, IntList input_size, bool align_corners) {
+  auto output_size_ = check_intlist<2>(output_size, "output_size", 2);
+  auto input_size_ = check_intlist<4>(input_size, "input_size", 3);
+  Tensor grad = upsample2d_grad_input(
+      "upsample_bilinear2d_backward_out", grad_input, grad_output, input_size_, output_size_);
+
+  const Tensor grad_output_ = to_layout(grad_output, !grad.is_contiguous());
+  if (grad.sizes().equals(grad_output_.sizes())) {
+    grad.copy_(grad_output_);
+  } else {
+    upsample_bilinear2d_backward_kernel(grad, grad_output_, align_corners);
+  }
+  copy_back_(grad_input, grad);
+  return grad_input;
+}
+
+Tensor upsample_bilinear2d_backward_cpu(
+    const Tensor& grad_output, IntList output_size, IntList input_size, bool align_corners) {
+  Tensor grad_input = grad_output.type().tensor();
+  return upsample_bilinear2d_backward_out_cpu(
+      grad_input, grad_output, output_size, input_size, align_corners);
+}
+
+}} // namespace at::native
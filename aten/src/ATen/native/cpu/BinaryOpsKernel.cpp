@@ -0,0 +1,66 @@
+#include "ATen/native/cpu/BinaryOpsKernel.h"
+
+#include "ATen/Dispatch.h"
+#include "ATen/native/cpu/Loops.h"
+
+namespace at { namespace native {
+namespace {
+
+static void add_kernel_impl(TensorIterator& iter, Scalar alpha_scalar) {
+  AT_DISPATCH_ALL_TYPES_AND_HALF(iter.type(), "add", [&] {
+    using Vec = vec::Vectorized<scalar_t>;
+    auto alpha = alpha_scalar.to<scalar_t>();
+    binary_kernel_vec<scalar_t>(
+        iter,
+        [=](scalar_t a, scalar_t b) -> scalar_t { return a + alpha * b; },
+        [=](Vec a, Vec b) { return a + Vec(alpha) * b; });
+  });
+}
+
+static void sub_kernel_impl(TensorIterator& iter, Scalar alpha_scalar) {
+  AT_DISPATCH_ALL_TYPES_AND_HALF(iter.type(), "sub", [&] {
+    using Vec = vec::Vectorized<scalar_t>;
+    auto alpha = alpha_scalar.to<scalar_t>();
+    binary_kernel_vec<scalar_t>(
+        iter,
+        [=](scalar_t a, scalar_t b) -> scalar_t { return a - alpha * b; },
+        [=](Vec a, Vec b) { return a - Vec(alpha) * b; });
+  });
+}
+
+static void mul_kernel_impl(TensorIterator& iter) {
+  AT_DISPATCH_ALL_TYPES_AND_HALF(iter.type(), "mul", [&] {
+    using Vec = vec::Vectorized<scalar_t>;
+    binary_kernel_vec<scalar_t>(
+        iter,
+        [](scalar_t a, scalar_t b) -> scalar_t { return a * b; },
+        [](Vec a, Vec b) { return a * b; });
+  });
+}
+
+static void div_kernel_impl(TensorIterator& iter) {
+  if (isIntegralType(iter.type().scalarType())) {
+    // there's no vectorized integer division
+    AT_DISPATCH_INTEGRAL_TYPES(iter.type(), "div", [&] {
+      binary_kernel<scalar_t>(
+          iter, [](scalar_t a, scalar_t b) -> scalar_t { return a / b; });
+    });
+  } else {
+    AT_DISPATCH_FLOATING_TYPES_AND_HALF(iter.type(), "div", [&] {
+      using Vec = vec::Vectorized<scalar_t>;
+      binary_kernel_vec<scalar_t>(
+          iter,
+          [](scalar_t a, scalar_t b) -> scalar_t { return a / b; },
+          [](Vec a, Vec b) { return a / b; });
+    });
+  }
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(add_kernel, &add_kernel_impl);
+REGISTER_DISPATCH(sub_kernel, &sub_kernel_impl);
+REGISTER_DISPATCH(mul_kernel, &mul_kernel_impl);
+REGISTER_DISPATCH(div_kernel, &div_kernel_impl);
+
+}} // namespace at::native
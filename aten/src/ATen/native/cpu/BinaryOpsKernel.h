@@ -0,0 +1,18 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "ATen/native/TensorIterator.h"
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+using binary_fn = void(*)(TensorIterator&);
+using binary_fn_alpha = void(*)(TensorIterator&, Scalar alpha);
+
+// out = a + alpha * b and out = a - alpha * b
+extern DispatchStub<binary_fn_alpha> add_kernel;
+extern DispatchStub<binary_fn_alpha> sub_kernel;
+extern DispatchStub<binary_fn> mul_kernel;
+extern DispatchStub<binary_fn> div_kernel;
+
+}} // namespace at::native
@@ -1,7 +1,11 @@
 #pragma once
 
 #include <cpuinfo.h>
+#include "ATen/Error.h"
+#include <cstdlib>
+#include <cstring>
 #include <type_traits>
+#include <utility>
 #include <iostream>
 
 // Implements instruction set specific function dispatch.
@@ -25,35 +29,74 @@
 // To call:
 //   stub(tensor);
 //
+// The ATEN_DISABLE_AVX512, ATEN_DISABLE_AVX2 and ATEN_DISABLE_AVX
+// environment variables turn off the respective kernels. To compare them,
+// ATEN_CPU_CAPABILITY=default|avx|avx2|avx512 caps the capability that is
+// chosen (it never picks a kernel the CPU doesn't support).
+//
 
 namespace at {
 namespace native {
 
-enum class CPUCapability { DEFAULT, AVX, AVX2, NUM_OPTIONS };
+enum class CPUCapability { DEFAULT, AVX, AVX2, AVX512, NUM_OPTIONS };
+
+// The highest capability allowed by ATEN_CPU_CAPABILITY, or AVX512 if it is
+// unset. An unrecognized value warns and falls back to DEFAULT.
+static inline CPUCapability parse_cpu_capability(const char* env) {
+  if (!env) {
+    return CPUCapability::AVX512;
+  } else if (std::strcmp(env, "default") == 0) {
+    return CPUCapability::DEFAULT;
+  } else if (std::strcmp(env, "avx") == 0) {
+    return CPUCapability::AVX;
+  } else if (std::strcmp(env, "avx2") == 0) {
+    return CPUCapability::AVX2;
+  } else if (std::strcmp(env, "avx512") == 0) {
+    return CPUCapability::AVX512;
+  }
+  AT_WARN(
+      "ignoring unknown ATEN_CPU_CAPABILITY ", env,
+      " (expected default, avx, avx2 or avx512), using default");
+  return CPUCapability::DEFAULT;
+}
+
+inline CPUCapability max_cpu_capability() {
+  static const CPUCapability capability =
+      parse_cpu_capability(std::getenv("ATEN_CPU_CAPABILITY"));
+  return capability;
+}
 
 template <typename FnPtr>
 struct DispatchStub {
   static_assert(std::is_pointer<FnPtr>::value, "FnPtr should be a pointer type");
 
   template <typename... ArgTypes>
-  void operator()(ArgTypes... args) {
+  void operator()(ArgTypes&&... args) {
     if (!dispatch_ptr) {
       dispatch_ptr = choose_impl();
     }
-    (*dispatch_ptr)(args...);
+    (*dispatch_ptr)(std::forward<ArgTypes>(args)...);
   }
 
   FnPtr choose_impl() {
 // Do not use cpuinfo on PowerPC as it shows confusing errors when run on ppc
 #ifndef __powerpc__
     if (cpuinfo_initialize()) {
+      int max_capability = static_cast<int>(max_cpu_capability());
+      int avx512 = static_cast<int>(CPUCapability::AVX512);
+      if (avx512 <= max_capability && !std::getenv("ATEN_DISABLE_AVX512") &&
+          cpuinfo_has_x86_avx512f() && table[avx512]) {
+        return table[avx512];
+      }
       int avx2 = static_cast<int>(CPUCapability::AVX2);
-      if (!std::getenv("ATEN_DISABLE_AVX2") && cpuinfo_has_x86_avx2() &&
-          cpuinfo_has_x86_fma3() && table[avx2]) {
+      if (avx2 <= max_capability && !std::getenv("ATEN_DISABLE_AVX2") &&
+          cpuinfo_has_x86_avx2() && cpuinfo_has_x86_fma3() &&
+          cpuinfo_has_x86_f16c() && table[avx2]) {
         return table[avx2];
       }
       int avx = static_cast<int>(CPUCapability::AVX);
-      if (!std::getenv("ATEN_DISABLE_AVX") && cpuinfo_has_x86_avx() && table[avx]) {
+      if (avx <= max_capability && !std::getenv("ATEN_DISABLE_AVX") &&
+          cpuinfo_has_x86_avx() && table[avx]) {
         return table[avx];
       }
     }
@@ -0,0 +1,185 @@
+#include "ATen/native/cpu/EmbeddingBagKernel.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/cpu/vec.h"
+
+namespace at { namespace native {
+namespace {
+
+const int MODE_SUM = 0;
+const int MODE_MEAN = 1;
+const int MODE_MAX = 2;
+
+// Bags of Half rows are summed in float and rounded to half once
+template <typename scalar_t>
+struct BagAcc {
+  using type = scalar_t;
+};
+
+template <>
+struct BagAcc<Half> {
+  using type = float;
+};
+
+// out[0:n] += src[0:n]
+template <typename acc_t, typename scalar_t>
+static inline void add_row(acc_t* out, const scalar_t* src, int64_t n) {
+  using Vec = vec::Vectorized<acc_t>;
+  using SrcVec = vec::Vectorized<scalar_t>;
+  int64_t d = 0;
+  for (; d <= n - 2 * Vec::size; d += 2 * Vec::size) {
+    auto a1 = Vec::loadu(out + d) + Vec(SrcVec::loadu(src + d));
+    auto a2 = Vec::loadu(out + d + Vec::size) + Vec(SrcVec::loadu(src + d + Vec::size));
+    a1.store(out + d);
+    a2.store(out + d + Vec::size);
+  }
+  for (; d < n; d++) {
+    out[d] += src[d];
+  }
+}
+
+// out[0:n] = src[0:n] * scale
+template <typename scalar_t>
+static inline void scale_row(scalar_t* out, const scalar_t* src, scalar_t scale, int64_t n) {
+  using Vec = vec::Vectorized<scalar_t>;
+  int64_t d = 0;
+  for (; d <= n - Vec::size; d += Vec::size) {
+    (Vec::loadu(src + d) * Vec(scale)).store(out + d);
+  }
+  for (; d < n; d++) {
+    out[d] = src[d] * scale;
+  }
+}
+
+// out[0:n] = src[0:n], converted to scalar_t
+template <typename scalar_t, typename acc_t>
+static inline void store_row(scalar_t* out, const acc_t* src, int64_t n) {
+  using Vec = vec::Vectorized<scalar_t>;
+  using SrcVec = vec::Vectorized<acc_t>;
+  int64_t d = 0;
+  for (; d <= n - Vec::size; d += Vec::size) {
+    Vec(SrcVec::loadu(src + d)).store(out + d);
+  }
+  for (; d < n; d++) {
+    out[d] = src[d];
+  }
+}
+
+template <typename acc_t, typename scalar_t>
+static void embedding_bag_sum(acc_t* out, const scalar_t* weight, int64_t stride0,
+                              int64_t stride1, const int64_t* indices, int64_t len,
+                              int64_t dims) {
+  if (stride1 == 1) {
+    for (int64_t i = 0; i < len; i++) {
+      add_row(out, weight + stride0 * indices[i], dims);
+    }
+  } else {
+    for (int64_t i = 0; i < len; i++) {
+      const scalar_t* row = weight + stride0 * indices[i];
+      for (int64_t d = 0; d < dims; d++) {
+        out[d] += row[d * stride1];
+      }
+    }
+  }
+}
+
+template <typename scalar_t>
+static void embedding_bag_max(scalar_t* out, int64_t* max_indices, const scalar_t* weight,
+                              int64_t stride0, int64_t stride1, const int64_t* indices,
+                              int64_t len, int64_t dims) {
+  for (int64_t i = 0; i < len; i++) {
+    int64_t word_idx = indices[i];
+    const scalar_t* row = weight + stride0 * word_idx;
+    for (int64_t d = 0; d < dims; d++) {
+      scalar_t item = row[d * stride1];
+      if (i == 0 || item > out[d]) {
+        out[d] = item;
+        max_indices[d] = word_idx;
+      }
+    }
+  }
+}
+
+static void embedding_bag_kernel_impl(Tensor& output, Tensor& max_indices, const Tensor& weight,
+                                      const Tensor& indices, const Tensor& offsets, int64_t mode) {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(weight.type(), "embedding_bag", [&] {
+    using acc_t = BagAcc<scalar_t>::type;
+    constexpr bool ACC_IN_OUTPUT = std::is_same<acc_t, scalar_t>::value;
+    int64_t num_bags = offsets.size(0);
+    int64_t numel = indices.numel();
+    int64_t dims = weight.size(1);
+    auto weight_data = weight.data<scalar_t>();
+    auto stride0 = weight.stride(0);
+    auto stride1 = weight.stride(1);
+    auto indices_data = indices.data<int64_t>();
+    auto offsets_data = offsets.data<int64_t>();
+    auto output_data = output.data<scalar_t>();
+    int64_t* max_indices_data = mode == MODE_MAX ? max_indices.data<int64_t>() : nullptr;
+
+    // each bag reads about numel / num_bags rows of dims elements
+    int64_t work_per_bag = std::max<int64_t>(1, numel / std::max<int64_t>(num_bags, 1) * dims);
+    int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / work_per_bag);
+    parallel_for(0, num_bags, grain_size, [&](int64_t begin, int64_t end) {
+      std::vector<acc_t> acc_buf(ACC_IN_OUTPUT ? 0 : dims);
+      for (int64_t bag = begin; bag < end; bag++) {
+        int64_t start = offsets_data[bag];
+        int64_t stop = bag + 1 < num_bags ? offsets_data[bag + 1] : numel;
+        int64_t len = stop - start;
+        if (len <= 0) {
+          continue;
+        }
+        scalar_t* out = output_data + bag * dims;
+        if (mode == MODE_MAX) {
+          embedding_bag_max(out, max_indices_data + bag * dims, weight_data, stride0, stride1,
+                            indices_data + start, len, dims);
+        } else {
+          acc_t* acc = ACC_IN_OUTPUT ? reinterpret_cast<acc_t*>(out) : acc_buf.data();
+          if (!ACC_IN_OUTPUT) {
+            std::fill(acc, acc + dims, acc_t(0));
+          }
+          embedding_bag_sum(acc, weight_data, stride0, stride1, indices_data + start, len, dims);
+          if (mode == MODE_MEAN) {
+            scale_row(acc, acc, acc_t(1) / len, dims);
+          }
+          if (!ACC_IN_OUTPUT) {
+            store_row(out, acc, dims);
+          }
+        }
+      }
+    });
+  });
+}
+
+static void embedding_bag_sparse_backward_kernel_impl(Tensor& values, const Tensor& grad,
+                                                      const Tensor& offset2bag,
+                                                      const Tensor& bag_size, int64_t mode) {
+  AT_DISPATCH_FLOATING_TYPES(grad.type(), "embedding_bag_sparse_backward", [&] {
+    int64_t numel = offset2bag.numel();
+    int64_t dims = grad.size(1);
+    auto grad_data = grad.data<scalar_t>();
+    auto offset2bag_data = offset2bag.data<int64_t>();
+    auto bag_size_data = bag_size.data<int64_t>();
+    auto values_data = values.data<scalar_t>();
+
+    int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(dims, 1));
+    parallel_for(0, numel, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        int64_t bag = offset2bag_data[i];
+        scalar_t scale = mode == MODE_MEAN ? scalar_t(1) / bag_size_data[bag] : scalar_t(1);
+        scale_row(values_data + i * dims, grad_data + bag * dims, scale, dims);
+      }
+    });
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(embedding_bag_kernel, &embedding_bag_kernel_impl);
+REGISTER_DISPATCH(embedding_bag_sparse_backward_kernel, &embedding_bag_sparse_backward_kernel_impl);
+
+}} // namespace at::native
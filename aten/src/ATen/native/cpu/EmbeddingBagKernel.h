@@ -0,0 +1,23 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// Fused gather and reduce for embedding_bag: output[b] is the sum, mean or
+// max of the rows weight[indices[i]] for offsets[b] <= i < offsets[b + 1].
+// output must be zero-filled, empty bags are left as they are. For max,
+// max_indices[b][d] is set to the index of the row the maximum comes from.
+//   (output, max_indices, weight, indices, offsets, mode)
+using embedding_bag_fn = void(*)(Tensor&, Tensor&, const Tensor&, const Tensor&, const Tensor&, int64_t);
+
+// The values of the sparse gradient of embedding_bag wrt. weight: row i is
+// grad[offset2bag[i]], divided by the size of the bag for mean.
+//   (values, grad, offset2bag, bag_size, mode)
+using embedding_bag_backward_fn = void(*)(Tensor&, const Tensor&, const Tensor&, const Tensor&, int64_t);
+
+extern DispatchStub<embedding_bag_fn> embedding_bag_kernel;
+extern DispatchStub<embedding_bag_backward_fn> embedding_bag_sparse_backward_kernel;
+
+}} // namespace at::native
@@ -0,0 +1,263 @@
+#include "ATen/native/cpu/LayerNormKernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/cpu/vec.h"
+
+namespace at { namespace native {
+namespace {
+
+// Merges the moments (mean_b, m2_b) of count_b values into those of count_a.
+template <typename scalar_t>
+static inline void welford_combine(
+    scalar_t& mean_a, scalar_t& m2_a, scalar_t& count_a,
+    scalar_t mean_b, scalar_t m2_b, scalar_t count_b) {
+  const scalar_t count = count_a + count_b;
+  if (count == 0) {
+    return;
+  }
+  const scalar_t delta = mean_b - mean_a;
+  const scalar_t ratio = count_b / count;
+  mean_a += delta * ratio;
+  m2_a += m2_b + delta * delta * count_a * ratio;
+  count_a = count;
+}
+
+// The mean and biased variance of x[0:n] in one pass. Each lane of the
+// vector runs its own Welford update; the lanes always hold the same number
+// of values, so a step needs a single reciprocal. They are merged at the end.
+template <typename scalar_t>
+static void row_moments(const scalar_t* x, int64_t n, scalar_t& mean, scalar_t& var) {
+  using Vec = vec::Vectorized<scalar_t>;
+  const int64_t steps = n / Vec::size;
+  Vec mean_vec(0);
+  Vec m2_vec(0);
+  for (int64_t k = 0; k < steps; k++) {
+    const Vec data = Vec::loadu(x + k * Vec::size);
+    const Vec delta = data - mean_vec;
+    mean_vec = mean_vec + delta * Vec(scalar_t(1) / static_cast<scalar_t>(k + 1));
+    m2_vec = m2_vec + delta * (data - mean_vec);
+  }
+  scalar_t mean_arr[Vec::size];
+  scalar_t m2_arr[Vec::size];
+  mean_vec.store(mean_arr);
+  m2_vec.store(m2_arr);
+  scalar_t m2 = 0;
+  scalar_t count = 0;
+  mean = 0;
+  for (int64_t j = 0; j < Vec::size; j++) {
+    welford_combine(mean, m2, count, mean_arr[j], m2_arr[j], static_cast<scalar_t>(steps));
+  }
+  for (int64_t i = steps * Vec::size; i < n; i++) {
+    welford_combine(mean, m2, count, x[i], scalar_t(0), scalar_t(1));
+  }
+  var = n > 0 ? m2 / n : scalar_t(0);
+}
+
+template <typename scalar_t>
+static void layer_norm_rows(
+    scalar_t* Y, scalar_t* mean_data, scalar_t* rstd_data,
+    const scalar_t* X, const scalar_t* gamma, const scalar_t* beta,
+    int64_t M, int64_t N, double eps) {
+  using Vec = vec::Vectorized<scalar_t>;
+  // About 8 operations per element, counting both passes.
+  const int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / (8 * std::max<int64_t>(N, 1)));
+  parallel_for(0, M, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const scalar_t* x = X + i * N;
+      scalar_t* y = Y + i * N;
+      scalar_t mean, var;
+      row_moments(x, N, mean, var);
+      const scalar_t rstd = scalar_t(1) / std::sqrt(var + static_cast<scalar_t>(eps));
+      mean_data[i] = mean;
+      rstd_data[i] = rstd;
+      for (int64_t d = 0; d < N; d += Vec::size) {
+        const int64_t len = std::min<int64_t>(Vec::size, N - d);
+        Vec out = (Vec::loadu(x + d, len) - Vec(mean)) * Vec(rstd);
+        if (gamma) {
+          out = out * Vec::loadu(gamma + d, len);
+        }
+        if (beta) {
+          out = out + Vec::loadu(beta + d, len);
+        }
+        out.store(y + d, len);
+      }
+    }
+  });
+}
+
+// With g = dY * gamma and x_hat = (X - mean) * rstd,
+//   dX = rstd * (g - mean(g) - x_hat * mean(g * x_hat))
+// where the row means come from ds = sum(g * X) and db = sum(g).
+template <typename scalar_t>
+static void layer_norm_backward_rows(
+    scalar_t* dX, const scalar_t* dY, const scalar_t* X,
+    const scalar_t* mean_data, const scalar_t* rstd_data,
+    const scalar_t* gamma, int64_t M, int64_t N) {
+  using Vec = vec::Vectorized<scalar_t>;
+  const int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / (8 * std::max<int64_t>(N, 1)));
+  parallel_for(0, M, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const scalar_t* x = X + i * N;
+      const scalar_t* dy = dY + i * N;
+      scalar_t* dx = dX + i * N;
+      Vec ds_vec(0);
+      Vec db_vec(0);
+      int64_t d = 0;
+      for (; d <= N - Vec::size; d += Vec::size) {
+        Vec g = Vec::loadu(dy + d);
+        if (gamma) {
+          g = g * Vec::loadu(gamma + d);
+        }
+        ds_vec = ds_vec + g * Vec::loadu(x + d);
+        db_vec = db_vec + g;
+      }
+      scalar_t ds_arr[Vec::size];
+      scalar_t db_arr[Vec::size];
+      ds_vec.store(ds_arr);
+      db_vec.store(db_arr);
+      scalar_t ds = 0;
+      scalar_t db = 0;
+      for (int64_t j = 0; j < Vec::size; j++) {
+        ds += ds_arr[j];
+        db += db_arr[j];
+      }
+      for (; d < N; d++) {
+        const scalar_t g = gamma ? dy[d] * gamma[d] : dy[d];
+        ds += g * x[d];
+        db += g;
+      }
+      const scalar_t mean = mean_data[i];
+      const scalar_t rstd = rstd_data[i];
+      // dX = a * g + b * X + c
+      const scalar_t scale = scalar_t(1) / N;
+      const scalar_t b = (db * mean - ds) * rstd * rstd * rstd * scale;
+      const scalar_t c = -b * mean - db * rstd * scale;
+      for (d = 0; d < N; d += Vec::size) {
+        const int64_t len = std::min<int64_t>(Vec::size, N - d);
+        Vec g = Vec::loadu(dy + d, len);
+        if (gamma) {
+          g = g * Vec::loadu(gamma + d, len);
+        }
+        Vec out = Vec(rstd) * g + Vec(b) * Vec::loadu(x + d, len) + Vec(c);
+        out.store(dx + d, len);
+      }
+    }
+  });
+}
+
+// dgamma = sum(dY * x_hat) and dbeta = sum(dY) over the rows, split by
+// columns so that each task owns its slice of the outputs.
+template <typename scalar_t>
+static void layer_norm_backward_affine(
+    scalar_t* dgamma, scalar_t* dbeta, const scalar_t* dY, const scalar_t* X,
+    const scalar_t* mean_data, const scalar_t* rstd_data, int64_t M, int64_t N) {
+  using Vec = vec::Vectorized<scalar_t>;
+  const int64_t grain_size = std::max<int64_t>(Vec::size, internal::GRAIN_SIZE / (4 * std::max<int64_t>(M, 1)));
+  parallel_for(0, N, grain_size, [&](int64_t begin, int64_t end) {
+    if (dgamma) {
+      std::fill(dgamma + begin, dgamma + end, scalar_t(0));
+    }
+    if (dbeta) {
+      std::fill(dbeta + begin, dbeta + end, scalar_t(0));
+    }
+    for (int64_t i = 0; i < M; i++) {
+      const scalar_t* x = X + i * N;
+      const scalar_t* dy = dY + i * N;
+      const Vec mean(mean_data[i]);
+      const Vec rstd(rstd_data[i]);
+      for (int64_t d = begin; d < end; d += Vec::size) {
+        const int64_t len = std::min<int64_t>(Vec::size, end - d);
+        const Vec g = Vec::loadu(dy + d, len);
+        if (dgamma) {
+          const Vec x_hat = (Vec::loadu(x + d, len) - mean) * rstd;
+          (Vec::loadu(dgamma + d, len) + g * x_hat).store(dgamma + d, len);
+        }
+        if (dbeta) {
+          (Vec::loadu(dbeta + d, len) + g).store(dbeta + d, len);
+        }
+      }
+    }
+  });
+}
+
+template <typename scalar_t>
+static const scalar_t* data_or_null(const Tensor& t) {
+  return t.defined() ? t.data<scalar_t>() : nullptr;
+}
+
+template <typename scalar_t>
+static scalar_t* mutable_data_or_null(Tensor& t) {
+  return t.defined() ? t.data<scalar_t>() : nullptr;
+}
+
+static void layer_norm_kernel_impl(
+    Tensor& Y,
+    Tensor& mean,
+    Tensor& rstd,
+    const Tensor& X,
+    const Tensor& gamma,
+    const Tensor& beta,
+    int64_t M,
+    int64_t N,
+    double eps) {
+  AT_DISPATCH_FLOATING_TYPES(X.type(), "layer_norm_kernel_impl", [&] {
+    layer_norm_rows<scalar_t>(
+        Y.data<scalar_t>(),
+        mean.data<scalar_t>(),
+        rstd.data<scalar_t>(),
+        X.data<scalar_t>(),
+        data_or_null<scalar_t>(gamma),
+        data_or_null<scalar_t>(beta),
+        M,
+        N,
+        eps);
+  });
+}
+
+static void layer_norm_backward_kernel_impl(
+    Tensor& dX,
+    Tensor& dgamma,
+    Tensor& dbeta,
+    const Tensor& dY,
+    const Tensor& X,
+    const Tensor& mean,
+    const Tensor& rstd,
+    const Tensor& gamma,
+    int64_t M,
+    int64_t N) {
+  AT_DISPATCH_FLOATING_TYPES(X.type(), "layer_norm_backward_kernel_impl", [&] {
+    if (dX.defined()) {
+      layer_norm_backward_rows<scalar_t>(
+          dX.data<scalar_t>(),
+          dY.data<scalar_t>(),
+          X.data<scalar_t>(),
+          mean.data<scalar_t>(),
+          rstd.data<scalar_t>(),
+          data_or_null<scalar_t>(gamma),
+          M,
+          N);
+    }
+    if (dgamma.defined() || dbeta.defined()) {
+      layer_norm_backward_affine<scalar_t>(
+          mutable_data_or_null<scalar_t>(dgamma),
+          mutable_data_or_null<scalar_t>(dbeta),
+          dY.data<scalar_t>(),
+          X.data<scalar_t>(),
+          mean.data<scalar_t>(),
+          rstd.data<scalar_t>(),
+          M,
+          N);
+    }
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(layer_norm_kernel, &layer_norm_kernel_impl);
+REGISTER_DISPATCH(layer_norm_backward_kernel, &layer_norm_backward_kernel_impl);
+
+}} // namespace at::native
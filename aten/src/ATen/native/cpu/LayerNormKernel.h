@@ -0,0 +1,23 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// Fused layer norm over the rows of a contiguous (M, N) input X. The mean and
+// rstd = 1 / sqrt(var + eps) of each row are computed in a single pass with
+// Welford's algorithm, and Y = (X - mean) * rstd * gamma + beta in a second
+// one. gamma and beta have N elements and may be undefined.
+//   (Y, mean, rstd, X, gamma, beta, M, N, eps)
+using layer_norm_fn = void(*)(Tensor&, Tensor&, Tensor&, const Tensor&, const Tensor&, const Tensor&, int64_t, int64_t, double);
+
+// The gradients of layer_norm from the mean and rstd saved by the forward.
+// Those of dX, dgamma and dbeta that are undefined are not computed.
+//   (dX, dgamma, dbeta, dY, X, mean, rstd, gamma, M, N)
+using layer_norm_backward_fn = void(*)(Tensor&, Tensor&, Tensor&, const Tensor&, const Tensor&, const Tensor&, const Tensor&, const Tensor&, int64_t, int64_t);
+
+extern DispatchStub<layer_norm_fn> layer_norm_kernel;
+extern DispatchStub<layer_norm_backward_fn> layer_norm_backward_kernel;
+
+}} // namespace at::native
@@ -0,0 +1,90 @@
+#pragma once
+
+// Inner loops for elementwise kernels on top of TensorIterator. The
+// vectorized loops depend on the capability the kernel is compiled for, so
+// this should only be included from native/cpu.
+//
+// binary_kernel_vec<scalar_t>(iter, op, vop) picks a loop over vec::Vectorized
+// when all operands are contiguous along the inner dimension, or when one
+// of the inputs is a scalar broadcast along it, and a strided scalar loop
+// otherwise. op takes and returns scalar_t, vop the same for vectors; both
+// must compute the same thing.
+
+#include "ATen/cpu/vec.h"
+#include "ATen/native/TensorIterator.h"
+
+namespace at { namespace native { namespace {
+
+template <typename scalar_t>
+static inline bool is_contiguous_binary(const int64_t* strides) {
+  constexpr int64_t size = sizeof(scalar_t);
+  return strides[0] == size && strides[1] == size && strides[2] == size;
+}
+
+// input arg (1 or 2) is a scalar broadcast along the loop, the output and
+// the other input are contiguous
+template <typename scalar_t>
+static inline bool is_scalar_binary(const int64_t* strides, int arg) {
+  constexpr int64_t size = sizeof(scalar_t);
+  return strides[0] == size && strides[arg] == 0 && strides[3 - arg] == size;
+}
+
+template <typename scalar_t, typename op_t>
+static inline void basic_binary_loop(char** data, const int64_t* strides, int64_t n, op_t op) {
+  char* out = data[0];
+  const char* a = data[1];
+  const char* b = data[2];
+  for (int64_t i = 0; i < n; i++) {
+    *reinterpret_cast<scalar_t*>(out + i * strides[0]) = op(
+        *reinterpret_cast<const scalar_t*>(a + i * strides[1]),
+        *reinterpret_cast<const scalar_t*>(b + i * strides[2]));
+  }
+}
+
+// scalar_arg is 0 if both inputs are contiguous, or the index of the input
+// that is a broadcast scalar
+template <typename scalar_t, typename op_t, typename vop_t>
+static inline void vectorized_binary_loop(char** data, int64_t n, int scalar_arg, op_t op, vop_t vop) {
+  using Vec = vec::Vectorized<scalar_t>;
+  scalar_t* out = reinterpret_cast<scalar_t*>(data[0]);
+  const scalar_t* a = reinterpret_cast<const scalar_t*>(data[1]);
+  const scalar_t* b = reinterpret_cast<const scalar_t*>(data[2]);
+  Vec a_scalar = Vec(a[0]);
+  Vec b_scalar = Vec(b[0]);
+  int64_t i = 0;
+  for (; i <= n - 2 * Vec::size; i += 2 * Vec::size) {
+    auto a1 = scalar_arg == 1 ? a_scalar : Vec::loadu(a + i);
+    auto a2 = scalar_arg == 1 ? a_scalar : Vec::loadu(a + i + Vec::size);
+    auto b1 = scalar_arg == 2 ? b_scalar : Vec::loadu(b + i);
+    auto b2 = scalar_arg == 2 ? b_scalar : Vec::loadu(b + i + Vec::size);
+    vop(a1, b1).store(out + i);
+    vop(a2, b2).store(out + i + Vec::size);
+  }
+  for (; i < n; i++) {
+    out[i] = op(scalar_arg == 1 ? a[0] : a[i], scalar_arg == 2 ? b[0] : b[i]);
+  }
+}
+
+template <typename scalar_t, typename op_t>
+void binary_kernel(TensorIterator& iter, op_t op) {
+  iter.for_each([&](int ntensors, char** data, const int64_t* strides, int64_t n) {
+    basic_binary_loop<scalar_t>(data, strides, n, op);
+  });
+}
+
+template <typename scalar_t, typename op_t, typename vop_t>
+void binary_kernel_vec(TensorIterator& iter, op_t op, vop_t vop) {
+  iter.for_each([&](int ntensors, char** data, const int64_t* strides, int64_t n) {
+    if (is_contiguous_binary<scalar_t>(strides)) {
+      vectorized_binary_loop<scalar_t>(data, n, 0, op, vop);
+    } else if (is_scalar_binary<scalar_t>(strides, 1)) {
+      vectorized_binary_loop<scalar_t>(data, n, 1, op, vop);
+    } else if (is_scalar_binary<scalar_t>(strides, 2)) {
+      vectorized_binary_loop<scalar_t>(data, n, 2, op, vop);
+    } else {
+      basic_binary_loop<scalar_t>(data, strides, n, op);
+    }
+  });
+}
+
+}}} // namespace at::native::<anonymous>
@@ -0,0 +1,331 @@
+#include "ATen/native/cpu/PoolingKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/cpu/vec.h"
+
+namespace at { namespace native {
+namespace {
+
+// The channels-last backward kernels split the channels into blocks of this
+// many, so that the threads scatter into disjoint parts of grad_input.
+constexpr int64_t kChannelBlock = 64;
+
+// The grain of a parallel_for over items that cost work each.
+static inline int64_t grain_size(int64_t work) {
+  return std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(1, work));
+}
+
+// The rows or columns [start, end) of the input that the window at out reads
+// from, one every dilation.
+struct MaxWindow {
+  int64_t start, end;
+  MaxWindow(int64_t out, int64_t size, int64_t k, int64_t d, int64_t pad, int64_t dilation) {
+    start = out * d - pad;
+    end = std::min(start + (k - 1) * dilation + 1, size);
+    while (start < 0) {
+      start += dilation;
+    }
+  }
+};
+
+// The rows or columns [start, end) of the input that the window at out reads
+// from, and the extent of the window clipped to the padded input.
+struct AvgWindow {
+  int64_t start, end, padded;
+  AvgWindow(int64_t out, int64_t size, int64_t k, int64_t d, int64_t pad) {
+    start = out * d - pad;
+    end = std::min(start + k, size + pad);
+    padded = end - start;
+    start = std::max<int64_t>(start, 0);
+    end = std::min(end, size);
+  }
+};
+
+static inline int64_t avg_divisor(const AvgWindow& h, const AvgWindow& w, bool count_include_pad) {
+  return count_include_pad ? h.padded * w.padded : (h.end - h.start) * (w.end - w.start);
+}
+
+template <typename scalar_t>
+static void max_pool2d_planes(
+    scalar_t* out, int64_t* ind, const scalar_t* in,
+    int64_t planes, int64_t H, int64_t W, int64_t OH, int64_t OW,
+    const Pool2dParams& p) {
+  parallel_for(0, planes, grain_size(OH * OW * p.kH * p.kW), [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k < end; k++) {
+      const scalar_t* x = in + k * H * W;
+      scalar_t* y = out + k * OH * OW;
+      int64_t* y_ind = ind + k * OH * OW;
+      for (int64_t oh = 0; oh < OH; oh++) {
+        const MaxWindow h(oh, H, p.kH, p.dH, p.padH, p.dilationH);
+        for (int64_t ow = 0; ow < OW; ow++) {
+          const MaxWindow w(ow, W, p.kW, p.dW, p.padW, p.dilationW);
+          scalar_t maxval = -std::numeric_limits<scalar_t>::infinity();
+          int64_t maxindex = -1;
+          for (int64_t ih = h.start; ih < h.end; ih += p.dilationH) {
+            for (int64_t iw = w.start; iw < w.end; iw += p.dilationW) {
+              const scalar_t val = x[ih * W + iw];
+              if (val > maxval || std::isnan(val)) {
+                maxval = val;
+                maxindex = ih * W + iw;
+              }
+            }
+          }
+          y[oh * OW + ow] = maxval;
+          y_ind[oh * OW + ow] = maxindex;
+        }
+      }
+    }
+  });
+}
+
+// One task per output pixel, whose C channels are contiguous in the input
+// pixels of the window.
+template <typename scalar_t>
+static void max_pool2d_channels_last(
+    scalar_t* out, int64_t* ind, const scalar_t* in,
+    int64_t N, int64_t C, int64_t H, int64_t W, int64_t OH, int64_t OW,
+    const Pool2dParams& p) {
+  parallel_for(0, N * OH * OW, grain_size(C * p.kH * p.kW), [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k < end; k++) {
+      const int64_t n = k / (OH * OW);
+      const MaxWindow h(k / OW % OH, H, p.kH, p.dH, p.padH, p.dilationH);
+      const MaxWindow w(k % OW, W, p.kW, p.dW, p.padW, p.dilationW);
+      scalar_t* y = out + k * C;
+      int64_t* y_ind = ind + k * C;
+      std::fill(y, y + C, -std::numeric_limits<scalar_t>::infinity());
+      std::fill(y_ind, y_ind + C, -1);
+      for (int64_t ih = h.start; ih < h.end; ih += p.dilationH) {
+        for (int64_t iw = w.start; iw < w.end; iw += p.dilationW) {
+          const scalar_t* x = in + ((n * H + ih) * W + iw) * C;
+          const int64_t index = ih * W + iw;
+          for (int64_t c = 0; c < C; c++) {
+            const scalar_t val = x[c];
+            if (val > y[c] || std::isnan(val)) {
+              y[c] = val;
+              y_ind[c] = index;
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+static void max_pool2d_kernel_impl(
+    Tensor& output, Tensor& indices, const Tensor& input, const Pool2dParams& p) {
+  const int64_t N = input.size(0), C = input.size(1), H = input.size(2), W = input.size(3);
+  const int64_t OH = output.size(2), OW = output.size(3);
+  const bool channels_last = !input.is_contiguous();
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "max_pool2d", [&] {
+    scalar_t* out = output.data<scalar_t>();
+    int64_t* ind = indices.data<int64_t>();
+    const scalar_t* in = input.data<scalar_t>();
+    if (channels_last) {
+      max_pool2d_channels_last(out, ind, in, N, C, H, W, OH, OW, p);
+    } else {
+      max_pool2d_planes(out, ind, in, N * C, H, W, OH, OW, p);
+    }
+  });
+}
+
+static void max_pool2d_backward_kernel_impl(
+    Tensor& grad_input, const Tensor& grad_output, const Tensor& indices) {
+  const int64_t N = grad_input.size(0), C = grad_input.size(1);
+  const int64_t HW = grad_input.size(2) * grad_input.size(3);
+  const int64_t OHW = grad_output.size(2) * grad_output.size(3);
+  const bool channels_last = !grad_input.is_contiguous();
+  AT_DISPATCH_FLOATING_TYPES(grad_input.type(), "max_pool2d_backward", [&] {
+    scalar_t* gi = grad_input.data<scalar_t>();
+    const scalar_t* go = grad_output.data<scalar_t>();
+    const int64_t* ind = indices.data<int64_t>();
+    if (channels_last) {
+      const int64_t blocks = divup(C, kChannelBlock);
+      parallel_for(0, N * blocks, grain_size(OHW * kChannelBlock), [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; k++) {
+          const int64_t n = k / blocks;
+          const int64_t c_begin = k % blocks * kChannelBlock;
+          const int64_t c_end = std::min(c_begin + kChannelBlock, C);
+          scalar_t* gi_n = gi + n * HW * C;
+          for (int64_t o = n * OHW; o < (n + 1) * OHW; o++) {
+            for (int64_t c = c_begin; c < c_end; c++) {
+              const int64_t index = ind[o * C + c];
+              if (index != -1) {
+                gi_n[index * C + c] += go[o * C + c];
+              }
+            }
+          }
+        }
+      });
+    } else {
+      parallel_for(0, N * C, grain_size(OHW), [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; k++) {
+          for (int64_t o = k * OHW; o < (k + 1) * OHW; o++) {
+            if (ind[o] != -1) {
+              gi[k * HW + ind[o]] += go[o];
+            }
+          }
+        }
+      });
+    }
+  });
+}
+
+template <typename scalar_t>
+static void avg_pool2d_planes(
+    scalar_t* out, const scalar_t* in,
+    int64_t planes, int64_t H, int64_t W, int64_t OH, int64_t OW,
+    const Pool2dParams& p, bool count_include_pad) {
+  parallel_for(0, planes, grain_size(OH * OW * p.kH * p.kW), [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k < end; k++) {
+      const scalar_t* x = in + k * H * W;
+      scalar_t* y = out + k * OH * OW;
+      for (int64_t oh = 0; oh < OH; oh++) {
+        const AvgWindow h(oh, H, p.kH, p.dH, p.padH);
+        for (int64_t ow = 0; ow < OW; ow++) {
+          const AvgWindow w(ow, W, p.kW, p.dW, p.padW);
+          scalar_t sum = 0;
+          for (int64_t ih = h.start; ih < h.end; ih++) {
+            for (int64_t iw = w.start; iw < w.end; iw++) {
+              sum += x[ih * W + iw];
+            }
+          }
+          y[oh * OW + ow] = sum / avg_divisor(h, w, count_include_pad);
+        }
+      }
+    }
+  });
+}
+
+template <typename scalar_t>
+static void avg_pool2d_channels_last(
+    scalar_t* out, const scalar_t* in,
+    int64_t N, int64_t C, int64_t H, int64_t W, int64_t OH, int64_t OW,
+    const Pool2dParams& p, bool count_include_pad) {
+  using Vec = vec::Vectorized<scalar_t>;
+  parallel_for(0, N * OH * OW, grain_size(C * p.kH * p.kW), [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k < end; k++) {
+      const int64_t n = k / (OH * OW);
+      const AvgWindow h(k / OW % OH, H, p.kH, p.dH, p.padH);
+      const AvgWindow w(k % OW, W, p.kW, p.dW, p.padW);
+      const Vec divisor(static_cast<scalar_t>(avg_divisor(h, w, count_include_pad)));
+      scalar_t* y = out + k * C;
+      for (int64_t c = 0; c < C; c += Vec::size) {
+        const int64_t count = std::min<int64_t>(Vec::size, C - c);
+        Vec sum(0);
+        for (int64_t ih = h.start; ih < h.end; ih++) {
+          for (int64_t iw = w.start; iw < w.end; iw++) {
+            sum = sum + Vec::loadu(in + ((n * H + ih) * W + iw) * C + c, count);
+          }
+        }
+        (sum / divisor).store(y + c, count);
+      }
+    }
+  });
+}
+
+static void avg_pool2d_kernel_impl(
+    Tensor& output, const Tensor& input, const Pool2dParams& p, bool count_include_pad) {
+  const int64_t N = input.size(0), C = input.size(1), H = input.size(2), W = input.size(3);
+  const int64_t OH = output.size(2), OW = output.size(3);
+  const bool channels_last = !input.is_contiguous();
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "avg_pool2d", [&] {
+    scalar_t* out = output.data<scalar_t>();
+    const scalar_t* in = input.data<scalar_t>();
+    if (channels_last) {
+      avg_pool2d_channels_last(out, in, N, C, H, W, OH, OW, p, count_include_pad);
+    } else {
+      avg_pool2d_planes(out, in, N * C, H, W, OH, OW, p, count_include_pad);
+    }
+  });
+}
+
+template <typename scalar_t>
+static void avg_pool2d_backward_planes(
+    scalar_t* gi, const scalar_t* go,
+    int64_t planes, int64_t H, int64_t W, int64_t OH, int64_t OW,
+    const Pool2dParams& p, bool count_include_pad) {
+  parallel_for(0, planes, grain_size(OH * OW * p.kH * p.kW), [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k < end; k++) {
+      scalar_t* dx = gi + k * H * W;
+      const scalar_t* dy = go + k * OH * OW;
+      for (int64_t oh = 0; oh < OH; oh++) {
+        const AvgWindow h(oh, H, p.kH, p.dH, p.padH);
+        for (int64_t ow = 0; ow < OW; ow++) {
+          const AvgWindow w(ow, W, p.kW, p.dW, p.padW);
+          const scalar_t g = dy[oh * OW + ow] / avg_divisor(h, w, count_include_pad);
+          for (int64_t ih = h.start; ih < h.end; ih++) {
+            for (int64_t iw = w.start; iw < w.end; iw++) {
+              dx[ih * W + iw] += g;
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+template <typename scalar_t>
+static void avg_pool2d_backward_channels_last(
+    scalar_t* gi, const scalar_t* go,
+    int64_t N, int64_t C, int64_t H, int64_t W, int64_t OH, int64_t OW,
+    const Pool2dParams& p, bool count_include_pad) {
+  using Vec = vec::Vectorized<scalar_t>;
+  const int64_t blocks = divup(C, kChannelBlock);
+  const int64_t work = OH * OW * p.kH * p.kW * kChannelBlock;
+  parallel_for(0, N * blocks, grain_size(work), [&](int64_t begin, int64_t end) {
+    for (int64_t k = begin; k < end; k++) {
+      const int64_t n = k / blocks;
+      const int64_t c_begin = k % blocks * kChannelBlock;
+      const int64_t c_end = std::min(c_begin + kChannelBlock, C);
+      for (int64_t oh = 0; oh < OH; oh++) {
+        const AvgWindow h(oh, H, p.kH, p.dH, p.padH);
+        for (int64_t ow = 0; ow < OW; ow++) {
+          const AvgWindow w(ow, W, p.kW, p.dW, p.padW);
+          const Vec divisor(static_cast<scalar_t>(avg_divisor(h, w, count_include_pad)));
+          const scalar_t* dy = go + ((n * OH + oh) * OW + ow) * C;
+          for (int64_t c = c_begin; c < c_end; c += Vec::size) {
+            const int64_t count = std::min<int64_t>(Vec::size, c_end - c);
+            const Vec g = Vec::loadu(dy + c, count) / divisor;
+            for (int64_t ih = h.start; ih < h.end; ih++) {
+              for (int64_t iw = w.start; iw < w.end; iw++) {
+                scalar_t* dx = gi + ((n * H + ih) * W + iw) * C + c;
+                (Vec::loadu(dx, count) + g).store(dx, count);
+              }
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
+static void avg_pool2d_backward_kernel_impl(
+    Tensor& grad_input, const Tensor& grad_output, const Pool2dParams& p, bool count_include_pad) {
+  const int64_t N = grad_input.size(0), C = grad_input.size(1);
+  const int64_t H = grad_input.size(2), W = grad_input.size(3);
+  const int64_t OH = grad_output.size(2), OW = grad_output.size(3);
+  const bool channels_last = !grad_input.is_contiguous();
+  AT_DISPATCH_FLOATING_TYPES(grad_input.type(), "avg_pool2d_backward", [&] {
+    scalar_t* gi = grad_input.data<scalar_t>();
+    const scalar_t* go = grad_output.data<scalar_t>();
+    if (channels_last) {
+      avg_pool2d_backward_channels_last(gi, go, N, C, H, W, OH, OW, p, count_include_pad);
+    } else {
+      avg_pool2d_backward_planes(gi, go, N * C, H, W, OH, OW, p, count_include_pad);
+    }
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(max_pool2d_kernel, &max_pool2d_kernel_impl);
+REGISTER_DISPATCH(max_pool2d_backward_kernel, &max_pool2d_backward_kernel_impl);
+REGISTER_DISPATCH(avg_pool2d_kernel, &avg_pool2d_kernel_impl);
+REGISTER_DISPATCH(avg_pool2d_backward_kernel, &avg_pool2d_backward_kernel_impl);
+
+}} // namespace at::native
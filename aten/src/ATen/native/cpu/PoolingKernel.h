@@ -0,0 +1,41 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// The window of a 2D pooling. padH and padW are at most half of the kernel.
+struct Pool2dParams {
+  int64_t kH, kW;
+  int64_t dH, dW;
+  int64_t padH, padW;
+  int64_t dilationH, dilationW;
+};
+
+// The kernels take 4-D (N, C, H, W) tensors of the same layout, contiguous or
+// channels-last (see ChannelsLastUtils.h), that the caller has sized. The
+// layout is the one of the tensor with the sizes of the input. Batch and
+// channels are spread over the threads; the channels-last kernels also
+// vectorize over C. Backward kernels accumulate into a zeroed grad_input.
+
+// Max pooling. The indices are the offsets h * W + w of the maximums in the
+// input planes. NaNs are taken over numbers, as in THNN.
+//   (output, indices, input, params)
+using max_pool2d_fn = void(*)(Tensor&, Tensor&, const Tensor&, const Pool2dParams&);
+//   (grad_input, grad_output, indices)
+using max_pool2d_backward_fn = void(*)(Tensor&, const Tensor&, const Tensor&);
+
+// Average pooling, which divides by the size of the window clipped to the
+// padded input if count_include_pad, or to the input otherwise.
+//   (output, input, params, count_include_pad)
+using avg_pool2d_fn = void(*)(Tensor&, const Tensor&, const Pool2dParams&, bool);
+//   (grad_input, grad_output, params, count_include_pad)
+using avg_pool2d_backward_fn = void(*)(Tensor&, const Tensor&, const Pool2dParams&, bool);
+
+extern DispatchStub<max_pool2d_fn> max_pool2d_kernel;
+extern DispatchStub<max_pool2d_backward_fn> max_pool2d_backward_kernel;
+extern DispatchStub<avg_pool2d_fn> avg_pool2d_kernel;
+extern DispatchStub<avg_pool2d_backward_fn> avg_pool2d_backward_kernel;
+
+}} // namespace at::native
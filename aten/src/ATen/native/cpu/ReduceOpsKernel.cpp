@@ -3,55 +3,204 @@
 #include <numeric>
 #include <iterator>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
 
 #include "ATen/Dispatch.h"
 #include "ATen/Parallel.h"
-#include "ATen/cpu/vec256/vec256.h"
+#include "ATen/cpu/vec.h"
 #include "ATen/optional.h"
 
 namespace at { namespace native { namespace {
 
-using namespace vec256;
+// A reduction is described by an op with the members
+//
+//   ident()        the value the accumulators start from
+//   map(x, c)      applied to every element before it is accumulated
+//   reduce(a, b)   combines two accumulators; must be associative
+//   project(a, c)  turns the final accumulator into the result
+//
+// map and reduce take both scalar_t and vec::Vectorized<scalar_t>. An op
+// that sets `centered` reads c from the output, which has to hold the
+// result of an earlier reduction of the same input (e.g. the mean, for the
+// variance); for other ops c is 0. An op that sets `pairwise` accumulates
+// floating point types in blocks of PAIRWISE_ROWS along the reduced
+// dimension and combines the blocks pairwise, so that the rounding error
+// grows with log(n) rather than n.
+//
+// Half is reduced with the float version of an op: the elements are
+// converted to float as they are loaded and the result is rounded to half
+// once, see ReduceAcc.
 
-static inline int64_t round_down(int64_t a, int64_t m) {
-  return a - (a % m);
-}
+template <typename scalar_t>
+struct SumOp {
+  static constexpr bool centered = false;
+  static constexpr bool pairwise = true;
+  scalar_t ident() const { return 0; }
+  template <typename T> T map(T x, T) const { return x; }
+  template <typename T> T reduce(T a, T b) const { return a + b; }
+  scalar_t project(scalar_t acc, scalar_t) const { return acc; }
+};
 
-template <typename F>
-static void _parallel_for(int64_t size, int64_t step, bool parallelize, F func) {
-  if (parallelize) {
-    parallel_for(0, size / step, 1, [func, step](int64_t begin, int64_t end) {
-      int64_t k = begin * step;
-      for (int64_t i = begin; i < end; i++, k += step) {
-        func(k);
-      }
-    });
-  } else {
-    for (int64_t i = 0; i != size; i += step) {
-      func(i);
-    }
+template <typename scalar_t>
+struct MeanOp : SumOp<scalar_t> {
+  explicit MeanOp(int64_t n) : n(n) {}
+  scalar_t project(scalar_t acc, scalar_t) const { return acc / n; }
+  int64_t n;
+};
+
+template <typename scalar_t>
+struct ProdOp {
+  static constexpr bool centered = false;
+  static constexpr bool pairwise = false;
+  scalar_t ident() const { return 1; }
+  template <typename T> T map(T x, T) const { return x; }
+  template <typename T> T reduce(T a, T b) const { return a * b; }
+  scalar_t project(scalar_t acc, scalar_t) const { return acc; }
+};
+
+// max and min propagate NaN
+template <typename scalar_t>
+struct MaxOp {
+  using Vec = vec::Vectorized<scalar_t>;
+  static constexpr bool centered = false;
+  static constexpr bool pairwise = false;
+  scalar_t ident() const { return -std::numeric_limits<scalar_t>::infinity(); }
+  template <typename T> T map(T x, T) const { return x; }
+  scalar_t reduce(scalar_t a, scalar_t b) const { return (a > b || a != a) ? a : b; }
+  Vec reduce(Vec a, Vec b) const { return vec::maximum(a, b); }
+  scalar_t project(scalar_t acc, scalar_t) const { return acc; }
+};
+
+template <typename scalar_t>
+struct MinOp {
+  using Vec = vec::Vectorized<scalar_t>;
+  static constexpr bool centered = false;
+  static constexpr bool pairwise = false;
+  scalar_t ident() const { return std::numeric_limits<scalar_t>::infinity(); }
+  template <typename T> T map(T x, T) const { return x; }
+  scalar_t reduce(scalar_t a, scalar_t b) const { return (a < b || a != a) ? a : b; }
+  Vec reduce(Vec a, Vec b) const { return vec::minimum(a, b); }
+  scalar_t project(scalar_t acc, scalar_t) const { return acc; }
+};
+
+template <typename scalar_t>
+struct Norm1Op {
+  using Vec = vec::Vectorized<scalar_t>;
+  static constexpr bool centered = false;
+  static constexpr bool pairwise = true;
+  scalar_t ident() const { return 0; }
+  scalar_t map(scalar_t x, scalar_t) const { return std::abs(x); }
+  Vec map(Vec x, Vec) const { return x.abs(); }
+  template <typename T> T reduce(T a, T b) const { return a + b; }
+  scalar_t project(scalar_t acc, scalar_t) const { return acc; }
+};
+
+template <typename scalar_t>
+struct Norm2Op {
+  static constexpr bool centered = false;
+  static constexpr bool pairwise = true;
+  scalar_t ident() const { return 0; }
+  template <typename T> T map(T x, T) const { return x * x; }
+  template <typename T> T reduce(T a, T b) const { return a + b; }
+  scalar_t project(scalar_t acc, scalar_t) const { return std::sqrt(acc); }
+};
+
+template <typename scalar_t>
+struct NormInfOp {
+  using Vec = vec::Vectorized<scalar_t>;
+  static constexpr bool centered = false;
+  static constexpr bool pairwise = false;
+  scalar_t ident() const { return 0; }
+  scalar_t map(scalar_t x, scalar_t) const { return std::abs(x); }
+  Vec map(Vec x, Vec) const { return x.abs(); }
+  scalar_t reduce(scalar_t a, scalar_t b) const { return (a > b || a != a) ? a : b; }
+  Vec reduce(Vec a, Vec b) const { return vec::maximum(a, b); }
+  scalar_t project(scalar_t acc, scalar_t) const { return acc; }
+};
+
+// c is the mean
+template <typename scalar_t>
+struct VarOp {
+  static constexpr bool centered = true;
+  static constexpr bool pairwise = true;
+  VarOp(int64_t n, bool unbiased, bool take_sqrt)
+    : n(n), unbiased(unbiased), take_sqrt(take_sqrt) {}
+  scalar_t ident() const { return 0; }
+  template <typename T> T map(T x, T mean) const {
+    T delta = x - mean;
+    return delta * delta;
   }
-}
+  template <typename T> T reduce(T a, T b) const { return a + b; }
+  scalar_t project(scalar_t acc, scalar_t) const {
+    // NaN for a single element if unbiased, like TH
+    scalar_t var = acc / (n - (unbiased ? 1 : 0));
+    return take_sqrt ? std::sqrt(var) : var;
+  }
+  int64_t n;
+  bool unbiased;
+  bool take_sqrt;
+};
+
+// c is the maximum
+template <typename scalar_t>
+struct LogSumExpOp {
+  using Vec = vec::Vectorized<scalar_t>;
+  static constexpr bool centered = true;
+  static constexpr bool pairwise = true;
+  scalar_t ident() const { return 0; }
+  scalar_t map(scalar_t x, scalar_t max) const { return std::exp(x - max); }
+  Vec map(Vec x, Vec max) const { return (x - max).exp(); }
+  template <typename T> T reduce(T a, T b) const { return a + b; }
+  scalar_t project(scalar_t acc, scalar_t max) const {
+    return std::isinf(max) ? max : max + std::log(acc);
+  }
+};
 
-// Vectorized reduction defined by reduce operation `Op` with identity `ident`.
+// The type the ops accumulate scalar_t in
+template <typename scalar_t>
+struct ReduceAcc {
+  using type = scalar_t;
+};
+
+template <>
+struct ReduceAcc<Half> {
+  using type = float;
+};
+
+// Vectorized reduction of contiguous tensors over one or all dimensions.
 // The reduction is built on top of reduce128, which reduces down a column
 // 128 bytes wide (WIDTH scalar elements). The width of 128 bytes is chosen
 // because of the "adjacent cache line prefetch" behavior on x86 CPUs.
-template<typename scalar_t, template <class> class Op, int ident>
+//
+// Reducing over the innermost dimension (stride 1) splits the rows of the
+// reduced dimension across threads, or each row if there are fewer rows
+// than threads. Reducing over an outer dimension splits the columns across
+// threads, or the reduced dimension if there are too few columns.
+//
+// The elements are scalar_t and the accumulators acc_t, the type Op works
+// in. Vectorized<scalar_t> and Vectorized<acc_t> have the same size.
+template <typename scalar_t, typename acc_t, typename Op>
 struct Reduction {
   // reduction width in number of scalar elements
   static constexpr int WIDTH = 128 / sizeof(scalar_t);
+  // rows accumulated in sequence before pairwise summation kicks in
+  static constexpr int64_t PAIRWISE_ROWS = 128;
+  static constexpr bool PAIRWISE = Op::pairwise && std::is_floating_point<acc_t>::value;
 
-  using Vec = Vec256<scalar_t>;
-  using Reduce = Op<Vec>;
-  using ReduceScalar = Op<scalar_t>;
+  using Vec = vec::Vectorized<acc_t>;
+  static_assert(vec::Vectorized<scalar_t>::size == Vec::size,
+                "elements and accumulators should have vectors of the same size");
 
-  static void apply(Tensor& res, const Tensor& self, at::optional<int64_t> dim) {
+  static void apply(Tensor& res, const Tensor& self, at::optional<int64_t> dim, const Op& op) {
     auto out_ = res.data<scalar_t>();
     auto data_ = self.data<scalar_t>();
     auto numel = self.numel();
     if (!dim.has_value()) {
-      *out_ = reduce_all(data_, numel);
+      acc_t c = center(out_);
+      *out_ = op.project(reduce_all(data_, numel, c, op), c);
       return;
     }
 
@@ -66,120 +215,263 @@ struct Reduction {
       }
     }
     int64_t batch = numel / (n * stride);
-    bool paralellize = batch * n > internal::GRAIN_SIZE;
     if (stride == 1) {
-      parallel_for(0, batch, 1, [=](int64_t begin, int64_t end) {
-        for (int64_t b = begin; b < end; b++) {
-          const scalar_t* data = &data_[b * n];
-          scalar_t* out = &out_[b];
-          scalar_t buf[WIDTH] = {0};
-          std::fill(buf, buf + WIDTH, ident);
-          int64_t cols_rounded = n / WIDTH;
-          reduce128(data, buf, cols_rounded, WIDTH);
-          scalar_t result = ident;
-          for (int64_t i = 0; i < WIDTH; i++) {
-            result = ReduceScalar()(result, buf[i]);
-          }
-          for (int64_t col = cols_rounded * WIDTH; col != n; col++) {
-            result = ReduceScalar()(result, data[col]);
-          }
-          out_[b] = result;
-        }
-      });
+      reduce_rows(out_, data_, batch, n, op);
     } else {
-      int64_t rows = n;
-      int64_t cols = stride;
-      int64_t cols_rounded = round_down(cols, WIDTH);
-      int64_t size = cols_rounded;
-      parallel_for(
-          0,
-          batch * (size / WIDTH),
-          1,
-          [out_, data_, n, stride, rows, cols, cols_rounded, size](
-              int64_t begin, int64_t end) {
-            for (int64_t bi = begin; bi < end; bi++) {
-              int64_t b = bi / (size / WIDTH);
-              int64_t i = bi % (size / WIDTH);
-              int64_t k = i * WIDTH;
-              reduce128(
-                  &data_[b * n * stride + k],
-                  &out_[b * stride + k],
-                  rows,
-                  stride);
-            }
-          });
-
-      _parallel_for(batch, 1, paralellize, [=](int64_t b) {
-        const scalar_t* data = &data_[b * n * stride];
-        scalar_t* out = &out_[b * stride];
-        int64_t rows = n;
-        int64_t cols = stride;
-
-        int64_t cols_rounded = round_down(cols, WIDTH);
-        if (cols_rounded != cols) {
-          scalar_t buf[WIDTH] = {0};
-          std::fill(buf, buf + WIDTH, ident);
-          for (int64_t row = 0; row != rows; row++) {
-            for (int64_t j = 0; j != cols - cols_rounded; j++) {
-              auto val = data[row * stride + j + cols_rounded];
-              buf[j] = ReduceScalar()(buf[j], val);
-            }
-          }
-          for (int64_t j = 0; j != cols - cols_rounded; j++) {
-            out[j + cols_rounded] = buf[j];
-          }
-        }
-      });
+      reduce_columns(out_, data_, batch, n, stride, op);
     }
   }
 
-  static scalar_t reduce_all(const scalar_t* data, int64_t size) {
+  static acc_t center(const scalar_t* out) {
+    return Op::centered ? static_cast<acc_t>(*out) : acc_t(0);
+  }
+
+  // Vec::size elements, converted to acc_t
+  static Vec load(const scalar_t* data) {
+    return Vec(vec::Vectorized<scalar_t>::loadu(data));
+  }
+
+  static acc_t reduce_all(const scalar_t* data, int64_t size, acc_t c, const Op& op) {
     int64_t k = size / WIDTH;
 
-    scalar_t sum = parallel_reduce(
+    acc_t acc = parallel_reduce(
         0,
         k,
         internal::GRAIN_SIZE / WIDTH,
-        (scalar_t)ident,
-        [data](int64_t begin, int64_t end, scalar_t init) {
-          scalar_t buf[WIDTH];
-          reduce128(&data[begin * WIDTH], buf, end - begin, WIDTH);
-          return std::accumulate(buf, buf + WIDTH, init, ReduceScalar());
+        op.ident(),
+        [data, c, &op](int64_t begin, int64_t end, acc_t init) {
+          return op.reduce(init, reduce_contiguous(&data[begin * WIDTH], (end - begin) * WIDTH, c, op));
         },
-        ReduceScalar());
+        [&op](acc_t a, acc_t b) { return op.reduce(a, b); });
 
     for (int64_t i = k * WIDTH; i != size; i++) {
-      sum = ReduceScalar()(sum, data[i]);
+      acc = op.reduce(acc, op.map(static_cast<acc_t>(data[i]), c));
+    }
+    return acc;
+  }
+
+  // Reduces n contiguous elements on the calling thread. Returns the
+  // accumulator, before project.
+  static acc_t reduce_contiguous(const scalar_t* data, int64_t n, acc_t c, const Op& op) {
+    acc_t centers[WIDTH];
+    std::fill(centers, centers + WIDTH, c);
+    acc_t buf[WIDTH];
+    int64_t cols_rounded = n / WIDTH;
+    reduce_block(data, buf, cols_rounded, WIDTH, WIDTH, centers, op);
+    acc_t acc = op.ident();
+    for (int64_t i = 0; i != WIDTH; i++) {
+      acc = op.reduce(acc, buf[i]);
+    }
+    for (int64_t col = cols_rounded * WIDTH; col != n; col++) {
+      acc = op.reduce(acc, op.map(static_cast<acc_t>(data[col]), c));
+    }
+    return acc;
+  }
+
+  // Reduces batch contiguous rows of n elements each.
+  static void reduce_rows(scalar_t* out_, const scalar_t* data_, int64_t batch, int64_t n, const Op& op) {
+    if (batch < get_intra_op_num_threads() && n > internal::GRAIN_SIZE) {
+      // too few rows to keep the threads busy, so split each of them
+      for (int64_t b = 0; b < batch; b++) {
+        acc_t c = center(&out_[b]);
+        out_[b] = op.project(reduce_all(&data_[b * n], n, c, op), c);
+      }
+      return;
+    }
+    int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / n);
+    parallel_for(0, batch, grain_size, [out_, data_, n, &op](int64_t begin, int64_t end) {
+      for (int64_t b = begin; b < end; b++) {
+        acc_t c = center(&out_[b]);
+        out_[b] = op.project(reduce_contiguous(&data_[b * n], n, c, op), c);
+      }
+    });
+  }
+
+  // Reduces batch blocks of n rows, each of stride contiguous elements,
+  // along the rows.
+  static void reduce_columns(scalar_t* out_, const scalar_t* data_, int64_t batch, int64_t n, int64_t stride, const Op& op) {
+    // blocks of WIDTH columns per batch, the last one may be narrower
+    int64_t blocks = divup(stride, WIDTH);
+    int64_t num_threads = get_intra_op_num_threads();
+    if (batch * blocks < num_threads && n >= num_threads &&
+        batch * n * stride > internal::GRAIN_SIZE) {
+      reduce_columns_split_rows(out_, data_, batch, n, stride, op);
+      return;
+    }
+    int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / (n * WIDTH));
+    parallel_for(0, batch * blocks, grain_size, [=, &op](int64_t begin, int64_t end) {
+      acc_t centers[WIDTH];
+      acc_t buf[WIDTH];
+      for (int64_t i = begin; i < end; i++) {
+        int64_t b = i / blocks;
+        int64_t k = (i % blocks) * WIDTH;
+        int64_t ncols = std::min<int64_t>(WIDTH, stride - k);
+        scalar_t* out = &out_[b * stride + k];
+        for (int64_t j = 0; j != WIDTH; j++) {
+          centers[j] = j < ncols ? center(&out[j]) : acc_t(0);
+        }
+        reduce_block(&data_[b * n * stride + k], buf, n, stride, ncols, centers, op);
+        for (int64_t j = 0; j != ncols; j++) {
+          out[j] = op.project(buf[j], centers[j]);
+        }
+      }
+    });
+  }
+
+  // Few columns and many rows (e.g. the sum over dim 0 of a 100000 x 8
+  // tensor): each thread reduces a range of rows into its own partial
+  // accumulators, which are combined at the end.
+  static void reduce_columns_split_rows(scalar_t* out_, const scalar_t* data_, int64_t batch, int64_t n, int64_t stride, const Op& op) {
+    int64_t chunks = get_intra_op_num_threads();
+    int64_t outputs = batch * stride;
+    std::vector<acc_t> centers(outputs);
+    for (int64_t i = 0; i != outputs; i++) {
+      centers[i] = center(&out_[i]);
+    }
+    std::vector<acc_t> partial(chunks * outputs);
+    parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t chunk = begin; chunk < end; chunk++) {
+        int64_t row_begin = chunk * n / chunks;
+        int64_t row_end = (chunk + 1) * n / chunks;
+        for (int64_t b = 0; b != batch; b++) {
+          for (int64_t k = 0; k < stride; k += WIDTH) {
+            int64_t ncols = std::min<int64_t>(WIDTH, stride - k);
+            reduce_block(
+                &data_[(b * n + row_begin) * stride + k],
+                &partial[chunk * outputs + b * stride + k],
+                row_end - row_begin,
+                stride,
+                ncols,
+                &centers[b * stride + k],
+                op);
+          }
+        }
+      }
+    });
+    for (int64_t i = 0; i != outputs; i++) {
+      acc_t acc = partial[i];
+      for (int64_t chunk = 1; chunk != chunks; chunk++) {
+        acc = op.reduce(acc, partial[chunk * outputs + i]);
+      }
+      out_[i] = op.project(acc, centers[i]);
+    }
+  }
+
+  // Reduce down ncols <= WIDTH columns with the given number of rows, stride
+  // elements apart. Stores the accumulators in acc[0 ... ncols-1]. centers
+  // holds c for each column.
+  static void reduce_block(const scalar_t* data, acc_t* acc, int64_t rows, int64_t stride,
+                           int64_t ncols, const acc_t* centers, const Op& op) {
+    if (PAIRWISE && rows > PAIRWISE_ROWS) {
+      int64_t half = rows / 2;
+      acc_t acc2[WIDTH];
+      reduce_block(data, acc, half, stride, ncols, centers, op);
+      reduce_block(&data[half * stride], acc2, rows - half, stride, ncols, centers, op);
+      for (int64_t j = 0; j != ncols; j++) {
+        acc[j] = op.reduce(acc[j], acc2[j]);
+      }
+      return;
+    }
+    if (ncols == WIDTH) {
+      reduce128(data, acc, rows, stride, centers, op);
+      return;
+    }
+    for (int64_t j = 0; j != ncols; j++) {
+      acc[j] = op.ident();
+    }
+    for (int64_t row = 0; row != rows; row++) {
+      for (int64_t j = 0; j != ncols; j++) {
+        acc[j] = op.reduce(acc[j], op.map(static_cast<acc_t>(data[row * stride + j]), centers[j]));
+      }
     }
-    return sum;
   }
 
   // Reduce down a column of WIDTH elements (128 bytes) with the given number
   // of rows. Stores the results in out[0 ... WIDTH-1].
-  static void reduce128(const scalar_t* data, scalar_t* out, int64_t rows, int64_t stride) {
-    Vec acc[4] = {ident, ident, ident, ident};  // 128 bytes (two cache lines)
-    static_assert(sizeof(acc) == 128, "accumulator should be 128 bytes");
+  static void reduce128(const scalar_t* data, acc_t* out, int64_t rows, int64_t stride,
+                        const acc_t* centers, const Op& op) {
+    // 128 bytes (two cache lines): four 256-bit or two 512-bit vectors,
+    // twice as many for Half, whose vectors hold floats
+    static constexpr int NUM_VECS = WIDTH / Vec::size;
+    Vec acc[NUM_VECS];
+    Vec c[NUM_VECS];
+    static_assert(NUM_VECS * Vec::size * sizeof(scalar_t) == 128, "the column should be 128 bytes");
+    for (int j = 0; j != NUM_VECS; j++) {
+      acc[j] = Vec(op.ident());
+      c[j] = Vec::loadu(&centers[j * Vec::size]);
+    }
     for (int64_t row = 0; row != rows; row++) {
-      for (int j = 0; j != 4; j++) {
-        auto val = Vec::loadu(&data[row * stride + j * Vec::size]);
-        acc[j] = Reduce()(acc[j], val);
+      for (int j = 0; j != NUM_VECS; j++) {
+        auto val = load(&data[row * stride + j * Vec::size]);
+        acc[j] = op.reduce(acc[j], op.map(val, c[j]));
       }
     }
-    for (int j = 0; j != 4; j++) {
+    for (int j = 0; j != NUM_VECS; j++) {
       acc[j].store(&out[j * Vec::size]);
     }
   }
 };
 
+template <typename scalar_t, typename acc_t = scalar_t, typename Op>
+static void apply_reduction(Tensor& result, const Tensor& self, at::optional<int64_t> dim, const Op& op) {
+  Reduction<scalar_t, acc_t, Op>::apply(result, self, dim, op);
+}
+
 static void sum_kernel_impl(Tensor& result, const Tensor& self, at::optional<int64_t> dim) {
-  AT_DISPATCH_ALL_TYPES(self.type(), "sum", [&] {
-    Reduction<scalar_t, std::plus, 0>::apply(result, self, dim);
+  AT_DISPATCH_ALL_TYPES_AND_HALF(self.type(), "sum", [&] {
+    using acc_t = ReduceAcc<scalar_t>::type;
+    apply_reduction<scalar_t, acc_t>(result, self, dim, SumOp<acc_t>());
   });
 }
 
 static void prod_kernel_impl(Tensor& result, const Tensor& self, at::optional<int64_t> dim) {
-  AT_DISPATCH_ALL_TYPES(self.type(), "prod", [&] {
-    Reduction<scalar_t, std::multiplies, 1>::apply(result, self, dim);
+  AT_DISPATCH_ALL_TYPES_AND_HALF(self.type(), "prod", [&] {
+    using acc_t = ReduceAcc<scalar_t>::type;
+    apply_reduction<scalar_t, acc_t>(result, self, dim, ProdOp<acc_t>());
+  });
+}
+
+static void max_kernel_impl(Tensor& result, const Tensor& self, at::optional<int64_t> dim) {
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "max", [&] {
+    apply_reduction<scalar_t>(result, self, dim, MaxOp<scalar_t>());
+  });
+}
+
+static void min_kernel_impl(Tensor& result, const Tensor& self, at::optional<int64_t> dim) {
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "min", [&] {
+    apply_reduction<scalar_t>(result, self, dim, MinOp<scalar_t>());
+  });
+}
+
+static void norm_kernel_impl(Tensor& result, const Tensor& self, Scalar p, at::optional<int64_t> dim) {
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "norm", [&] {
+    auto pval = p.toDouble();
+    if (pval == 1) {
+      apply_reduction<scalar_t>(result, self, dim, Norm1Op<scalar_t>());
+    } else if (pval == 2) {
+      apply_reduction<scalar_t>(result, self, dim, Norm2Op<scalar_t>());
+    } else {
+      AT_ASSERTM(pval == INFINITY, "norm_kernel only supports p = 1, 2 and inf, got ", pval);
+      apply_reduction<scalar_t>(result, self, dim, NormInfOp<scalar_t>());
+    }
+  });
+}
+
+// Two passes: the first one leaves the mean in result.
+static void std_var_kernel_impl(Tensor& result, const Tensor& self, at::optional<int64_t> dim,
+                                bool unbiased, bool take_sqrt) {
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "std_var", [&] {
+    int64_t n = dim.has_value() ? self.size(*dim) : self.numel();
+    apply_reduction<scalar_t>(result, self, dim, MeanOp<scalar_t>(n));
+    apply_reduction<scalar_t>(result, self, dim, VarOp<scalar_t>(n, unbiased, take_sqrt));
+  });
+}
+
+// Two passes: the first one leaves the maximum in result.
+static void logsumexp_kernel_impl(Tensor& result, const Tensor& self, at::optional<int64_t> dim) {
+  AT_DISPATCH_FLOATING_TYPES(self.type(), "logsumexp", [&] {
+    apply_reduction<scalar_t>(result, self, dim, MaxOp<scalar_t>());
+    apply_reduction<scalar_t>(result, self, dim, LogSumExpOp<scalar_t>());
   });
 }
 
@@ -187,5 +479,10 @@ static void prod_kernel_impl(Tensor& result, const Tensor& self, at::optional<in
 
 REGISTER_DISPATCH(sum_kernel, &sum_kernel_impl);
 REGISTER_DISPATCH(prod_kernel, &prod_kernel_impl);
+REGISTER_DISPATCH(max_kernel, &max_kernel_impl);
+REGISTER_DISPATCH(min_kernel, &min_kernel_impl);
+REGISTER_DISPATCH(norm_kernel, &norm_kernel_impl);
+REGISTER_DISPATCH(std_var_kernel, &std_var_kernel_impl);
+REGISTER_DISPATCH(logsumexp_kernel, &logsumexp_kernel_impl);
 
 }}  // namespace at::native
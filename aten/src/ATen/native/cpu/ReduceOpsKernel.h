@@ -7,10 +7,23 @@
 namespace at {
 namespace native {
 
+// The kernels reduce a contiguous tensor over a dimension, or over all of
+// them if none is given, into a contiguous result of the same type with that
+// dimension of size 1 (see _dimreduce_setup).
 using reduce_fn = void(*)(Tensor &, const Tensor &, at::optional<int64_t>);
+using reduce_norm_fn = void(*)(Tensor &, const Tensor &, Scalar, at::optional<int64_t>);
+using reduce_std_var_fn = void(*)(Tensor &, const Tensor &, at::optional<int64_t>, bool, bool);
 
 extern DispatchStub<reduce_fn> sum_kernel;
 extern DispatchStub<reduce_fn> prod_kernel;
+// floating point types only, as are the kernels below
+extern DispatchStub<reduce_fn> max_kernel;
+extern DispatchStub<reduce_fn> min_kernel;
+extern DispatchStub<reduce_fn> logsumexp_kernel;
+// p = 1, 2 or inf
+extern DispatchStub<reduce_norm_fn> norm_kernel;
+// (result, self, dim, unbiased, take_sqrt)
+extern DispatchStub<reduce_std_var_fn> std_var_kernel;
 
 }
 }
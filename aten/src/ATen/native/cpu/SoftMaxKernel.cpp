@@ -6,8 +6,7 @@
 
 #include "ATen/Dispatch.h"
 #include "ATen/Parallel.h"
-#include "ATen/cpu/vec256/functional.h"
-#include "ATen/cpu/vec256/vec256.h"
+#include "ATen/cpu/vec.h"
 #include "ATen/optional.h"
 
 // [Note AVX-SSE transitions] In general we avoid calls into cmath for code
@@ -28,7 +27,7 @@ inline void _vec_log_softmax_lastdim(
     scalar_t* output_data_base,
     int64_t outer_size,
     int64_t dim_size) {
-  using Vec = vec256::Vec256<scalar_t>;
+  using Vec = vec::Vectorized<scalar_t>;
   static constexpr int64_t CHUNK_SIZE = (128 / sizeof(scalar_t)) * Vec::size;
   int64_t grain_size = internal::GRAIN_SIZE / (16 * dim_size * CHUNK_SIZE);
   if (grain_size < CHUNK_SIZE)
@@ -48,8 +47,8 @@ inline void _vec_log_softmax_lastdim(
           for (int64_t j = 0; j < loop_end; j++) {
             int64_t i = ii + j;
             scalar_t* input_data = input_data_base + i * dim_size;
-            max_input_arr[j] = vec256::reduce_all<scalar_t>(
-                [](Vec& x, Vec& y) { return vec256::max(x, y); },
+            max_input_arr[j] = vec::reduce_all<scalar_t>(
+                [](Vec& x, Vec& y) { return vec::max(x, y); },
                 input_data,
                 dim_size);
           }
@@ -57,7 +56,7 @@ inline void _vec_log_softmax_lastdim(
             int64_t i = ii + j;
             scalar_t* input_data = input_data_base + i * dim_size;
             scalar_t max_input = max_input_arr[j];
-            tmp_sum_scalar[j] = vec256::map_reduce_all<scalar_t>(
+            tmp_sum_scalar[j] = vec::map_reduce_all<scalar_t>(
                 [max_input](Vec x) { return (x - Vec(max_input)).exp(); },
                 [](Vec x, Vec y) { return x + y; },
                 input_data,
@@ -65,7 +64,7 @@ inline void _vec_log_softmax_lastdim(
           }
           // See [Note AVX-SSE transitions] for why this should call the
           // vectorized version (aside from perf improvements).
-          vec256::map2(
+          vec::map2(
               [](Vec x, Vec y) { return x.log() + y; },
               tmp_sum_scalar,
               tmp_sum_scalar,
@@ -76,7 +75,7 @@ inline void _vec_log_softmax_lastdim(
             scalar_t* input_data = input_data_base + i * dim_size;
             scalar_t* output_data = output_data_base + i * dim_size;
             scalar_t tmp_sum = tmp_sum_scalar[j];
-            vec256::map(
+            vec::map(
                 [tmp_sum](Vec x) { return x - Vec(tmp_sum); },
                 output_data,
                 input_data,
@@ -92,7 +91,7 @@ inline void _vec_softmax_lastdim(
     scalar_t* output_data_base,
     int64_t outer_size,
     int64_t dim_size) {
-  using Vec = vec256::Vec256<scalar_t>;
+  using Vec = vec::Vectorized<scalar_t>;
   int64_t grain_size = internal::GRAIN_SIZE / (16 * dim_size);
   if (grain_size < 1)
     grain_size = 1;
@@ -105,19 +104,19 @@ inline void _vec_softmax_lastdim(
         for (int64_t i = begin; i < end; i++) {
           scalar_t* input_data = input_data_base + i * dim_size;
           scalar_t* output_data = output_data_base + i * dim_size;
-          scalar_t max_input = vec256::reduce_all<scalar_t>(
-              [](Vec& x, Vec& y) { return vec256::max(x, y); },
+          scalar_t max_input = vec::reduce_all<scalar_t>(
+              [](Vec& x, Vec& y) { return vec::max(x, y); },
               input_data,
               dim_size);
-          vec256::map(
+          vec::map(
               [max_input](Vec x) { return (x - Vec(max_input)).exp(); },
               output_data,
               input_data,
               dim_size);
-          scalar_t tmp_sum = vec256::reduce_all<scalar_t>(
+          scalar_t tmp_sum = vec::reduce_all<scalar_t>(
               [](Vec x, Vec y) { return x + y; }, output_data, dim_size);
           tmp_sum = 1 / tmp_sum;
-          vec256::map(
+          vec::map(
               [tmp_sum](Vec x) { return x * Vec(tmp_sum); },
               output_data,
               output_data,
@@ -133,7 +132,7 @@ inline void _vec_host_softmax_backward_lastdim(
     scalar_t* output_data_base,
     int64_t outer_size,
     int64_t dim_size) {
-  using Vec = vec256::Vec256<scalar_t>;
+  using Vec = vec::Vectorized<scalar_t>;
   int64_t grain_size = internal::GRAIN_SIZE / (16 * dim_size);
   if (grain_size < 1)
     grain_size = 1;
@@ -149,10 +148,10 @@ inline void _vec_host_softmax_backward_lastdim(
           scalar_t* output_data = output_data_base + i * dim_size;
           scalar_t sum;
           if (log_softmax) {
-            sum = vec256::reduce_all<scalar_t>(
+            sum = vec::reduce_all<scalar_t>(
                 [](Vec& x, Vec& y) { return x + y; }, grad_data, dim_size);
           } else {
-            sum = vec256::map2_reduce_all<scalar_t>(
+            sum = vec::map2_reduce_all<scalar_t>(
                 [](Vec x, Vec y) { return x * y; },
                 [](Vec x, Vec y) { return x + y; },
                 grad_data,
@@ -160,14 +159,14 @@ inline void _vec_host_softmax_backward_lastdim(
                 dim_size);
           }
           if (log_softmax) {
-            vec256::map2(
+            vec::map2(
                 [sum](Vec x, Vec y) { return x - ((y.exp()) * Vec(sum)); },
                 grad_input_data,
                 grad_data,
                 output_data,
                 dim_size);
           } else {
-            vec256::map2(
+            vec::map2(
                 [sum](Vec x, Vec y) { return (x - Vec(sum)) * y; },
                 grad_input_data,
                 grad_data,
@@ -178,6 +177,110 @@ inline void _vec_host_softmax_backward_lastdim(
       });
 }
 
+// Computes logsumexp of each row like _vec_log_softmax_lastdim, but only
+// keeps its difference to the input at the target instead of the whole row
+// of log-probabilities.
+template <typename scalar_t>
+inline void _vec_cross_entropy_lastdim(
+    scalar_t* input_data_base,
+    int64_t* target_data,
+    scalar_t* loss_data,
+    scalar_t* lse_data,
+    int64_t outer_size,
+    int64_t dim_size,
+    int64_t ignore_index) {
+  using Vec = vec::Vectorized<scalar_t>;
+  static constexpr int64_t CHUNK_SIZE = (128 / sizeof(scalar_t)) * Vec::size;
+  // Rows of a large vocabulary are worth a task each.
+  int64_t grain_size = internal::GRAIN_SIZE / (16 * dim_size);
+  if (grain_size < 1)
+    grain_size = 1;
+
+  parallel_for(
+      0,
+      outer_size,
+      grain_size,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t ii = begin; ii < end; ii += CHUNK_SIZE) {
+          scalar_t tmp_sum_scalar[CHUNK_SIZE];
+          scalar_t max_input_arr[CHUNK_SIZE];
+          int64_t loop_end = CHUNK_SIZE;
+          if (ii + CHUNK_SIZE > end)
+            loop_end = end - ii;
+          for (int64_t j = 0; j < loop_end; j++) {
+            scalar_t* input_data = input_data_base + (ii + j) * dim_size;
+            max_input_arr[j] = vec::reduce_all<scalar_t>(
+                [](Vec& x, Vec& y) { return vec::max(x, y); },
+                input_data,
+                dim_size);
+          }
+          for (int64_t j = 0; j < loop_end; j++) {
+            scalar_t* input_data = input_data_base + (ii + j) * dim_size;
+            scalar_t max_input = max_input_arr[j];
+            tmp_sum_scalar[j] = vec::map_reduce_all<scalar_t>(
+                [max_input](Vec x) { return (x - Vec(max_input)).exp(); },
+                [](Vec x, Vec y) { return x + y; },
+                input_data,
+                dim_size);
+          }
+          // See [Note AVX-SSE transitions] for why this should call the
+          // vectorized version (aside from perf improvements).
+          vec::map2(
+              [](Vec x, Vec y) { return x.log() + y; },
+              lse_data + ii,
+              tmp_sum_scalar,
+              max_input_arr,
+              loop_end);
+          for (int64_t j = 0; j < loop_end; j++) {
+            int64_t i = ii + j;
+            int64_t target = target_data[i];
+            loss_data[i] = target == ignore_index
+                ? 0
+                : lse_data[i] - input_data_base[i * dim_size + target];
+          }
+        }
+      });
+}
+
+// The gradient of each row is scale * (softmax(input) - onehot(target)),
+// with softmax(input) recomputed from the saved logsumexp.
+template <typename scalar_t>
+inline void _vec_cross_entropy_backward_lastdim(
+    scalar_t* grad_input_data_base,
+    scalar_t* scale_data,
+    scalar_t* input_data_base,
+    int64_t* target_data,
+    scalar_t* lse_data,
+    int64_t outer_size,
+    int64_t dim_size,
+    int64_t ignore_index) {
+  using Vec = vec::Vectorized<scalar_t>;
+  int64_t grain_size = internal::GRAIN_SIZE / (16 * dim_size);
+  if (grain_size < 1)
+    grain_size = 1;
+
+  parallel_for(
+      0,
+      outer_size,
+      grain_size,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          scalar_t* grad_input_data = grad_input_data_base + i * dim_size;
+          scalar_t* input_data = input_data_base + i * dim_size;
+          scalar_t scale = scale_data[i];
+          scalar_t lse = lse_data[i];
+          vec::map(
+              [scale, lse](Vec x) { return (x - Vec(lse)).exp() * Vec(scale); },
+              grad_input_data,
+              input_data,
+              dim_size);
+          int64_t target = target_data[i];
+          if (target != ignore_index)
+            grad_input_data[target] -= scale;
+        }
+      });
+}
+
 template <typename scalar_t, bool LogSoftMax>
 struct vec_host_softmax_lastdim {
   static void apply(Tensor& output, const Tensor& input) {
@@ -254,6 +357,46 @@ static void log_softmax_backward_lastdim_kernel_impl(
       });
 }
 
+static void cross_entropy_lastdim_kernel_impl(
+    Tensor& loss,
+    Tensor& lse,
+    const Tensor& input,
+    const Tensor& target,
+    int64_t ignore_index) {
+  AT_DISPATCH_FLOATING_TYPES(
+      input.type(), "cross_entropy_lastdim_kernel_impl", [&] {
+        _vec_cross_entropy_lastdim<scalar_t>(
+            input.data<scalar_t>(),
+            target.data<int64_t>(),
+            loss.data<scalar_t>(),
+            lse.data<scalar_t>(),
+            input.size(0),
+            input.size(1),
+            ignore_index);
+      });
+}
+
+static void cross_entropy_backward_lastdim_kernel_impl(
+    Tensor& grad_input,
+    const Tensor& scale,
+    const Tensor& input,
+    const Tensor& target,
+    const Tensor& lse,
+    int64_t ignore_index) {
+  AT_DISPATCH_FLOATING_TYPES(
+      input.type(), "cross_entropy_backward_lastdim_kernel_impl", [&] {
+        _vec_cross_entropy_backward_lastdim<scalar_t>(
+            grad_input.data<scalar_t>(),
+            scale.data<scalar_t>(),
+            input.data<scalar_t>(),
+            target.data<int64_t>(),
+            lse.data<scalar_t>(),
+            input.size(0),
+            input.size(1),
+            ignore_index);
+      });
+}
+
 } // anonymous namespace
 
 REGISTER_DISPATCH(softmax_lastdim_kernel, &softmax_lastdim_kernel_impl);
@@ -264,5 +407,11 @@ REGISTER_DISPATCH(
 REGISTER_DISPATCH(
     log_softmax_backward_lastdim_kernel,
     &log_softmax_backward_lastdim_kernel_impl);
+REGISTER_DISPATCH(
+    cross_entropy_lastdim_kernel,
+    &cross_entropy_lastdim_kernel_impl);
+REGISTER_DISPATCH(
+    cross_entropy_backward_lastdim_kernel,
+    &cross_entropy_backward_lastdim_kernel_impl);
 
 }} // namespace at::native
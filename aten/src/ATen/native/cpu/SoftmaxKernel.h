@@ -8,11 +8,17 @@ namespace native {
 
 using forward_fn = void(*)(Tensor &, const Tensor &);
 using backward_fn = void(*)(Tensor &, const Tensor &, const Tensor&);
+// (loss, logsumexp, input, target, ignore_index)
+using cross_entropy_fn = void(*)(Tensor &, Tensor &, const Tensor &, const Tensor &, int64_t);
+// (grad_input, scale, input, target, logsumexp, ignore_index)
+using cross_entropy_backward_fn = void(*)(Tensor &, const Tensor &, const Tensor &, const Tensor &, const Tensor &, int64_t);
 
 extern DispatchStub<forward_fn> softmax_lastdim_kernel;
 extern DispatchStub<forward_fn> log_softmax_lastdim_kernel;
 extern DispatchStub<backward_fn> softmax_backward_lastdim_kernel;
 extern DispatchStub<backward_fn> log_softmax_backward_lastdim_kernel;
+extern DispatchStub<cross_entropy_fn> cross_entropy_lastdim_kernel;
+extern DispatchStub<cross_entropy_backward_fn> cross_entropy_backward_lastdim_kernel;
 
 }
 }
@@ -67,8 +67,14 @@ int64_t _sigmoid(double* x, double* y, int64_t size) {
   return i;
 }
 
+// Half goes through the loop in sigmoid_kernel, which computes in float
+template <>
+int64_t _sigmoid(Half* x, Half* y, int64_t size) {
+  return 0;
+}
+
 static void sigmoid_kernel(Tensor& result, const Tensor& self) {
-  AT_DISPATCH_FLOATING_TYPES(self.type(), "sigmoid", [&] {
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(self.type(), "sigmoid", [&] {
     using Vec = Vec256<scalar_t>;
     CPU_tensor_parallel_kernel_apply2<scalar_t, scalar_t>(
         result,
@@ -104,7 +110,7 @@ static void sigmoid_kernel(Tensor& result, const Tensor& self) {
 
 #define IMPLEMENT_FLOAT_KERNEL(dispatchtypes, op)                          \
   static void op##_kernel(Tensor& result, const Tensor& self) {            \
-    AT_DISPATCH_##dispatchtypes##_TYPES(self.type(), #op, [&] {            \
+    AT_DISPATCH_##dispatchtypes##_TYPES_AND_HALF(self.type(), #op, [&] {   \
       if (self.is_contiguous() && result.is_contiguous()) {                \
         vml::v##op(                                                        \
             result.data<scalar_t>(), self.data<scalar_t>(), self.numel()); \
@@ -0,0 +1,269 @@
+#include "ATen/native/cpu/UpSampleKernel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "ATen/AccumulateType.h"
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/cpu/vec.h"
+
+namespace at { namespace native {
+namespace {
+
+// The channels-last backward kernels split the channels into blocks of this
+// many, so that the threads scatter into disjoint parts of grad_input.
+constexpr int64_t kChannelBlock = 64;
+
+// The grain of a parallel_for over items that cost work each.
+static inline int64_t grain_size(int64_t work) {
+  return std::max<int64_t>(1, internal::GRAIN_SIZE / std::max<int64_t>(1, work));
+}
+
+// The source of each of the output_size rows or columns.
+static std::vector<int64_t> nearest_indices(int64_t input_size, int64_t output_size) {
+  const float scale = (float)input_size / (float)output_size;
+  std::vector<int64_t> indices(output_size);
+  for (int64_t i = 0; i < output_size; i++) {
+    indices[i] = std::min<int64_t>(std::floor(i * scale), input_size - 1);
+  }
+  return indices;
+}
+
+// An output row or column is lambda0 times row or column i0 of the input plus
+// lambda1 times row or column i1, which is i0 or the next one.
+template <typename scalar_t>
+struct LinearIndex {
+  int64_t i0, i1;
+  scalar_t lambda0, lambda1;
+};
+
+template <typename scalar_t>
+static std::vector<LinearIndex<scalar_t>> linear_indices(
+    int64_t input_size, int64_t output_size, bool align_corners) {
+  using accscalar_t = acc_type<scalar_t, false>;
+  accscalar_t scale = 0;
+  if (output_size > 1) {
+    scale = align_corners ? (accscalar_t)(input_size - 1) / (output_size - 1)
+                          : (accscalar_t)input_size / output_size;
+  }
+  std::vector<LinearIndex<scalar_t>> indices(output_size);
+  for (int64_t i = 0; i < output_size; i++) {
+    accscalar_t src = align_corners ? scale * i : scale * (i + 0.5) - 0.5;
+    src = src < 0 ? accscalar_t(0) : src;
+    auto& index = indices[i];
+    index.i0 = (int64_t)src;
+    index.i1 = index.i0 < input_size - 1 ? index.i0 + 1 : index.i0;
+    index.lambda1 = src - index.i0;
+    index.lambda0 = (scalar_t)1. - index.lambda1;
+  }
+  return indices;
+}
+
+static void upsample_nearest2d_kernel_impl(Tensor& output, const Tensor& input) {
+  const int64_t N = input.size(0), C = input.size(1), H = input.size(2), W = input.size(3);
+  const int64_t OH = output.size(2), OW = output.size(3);
+  const auto hs = nearest_indices(H, OH);
+  const auto ws = nearest_indices(W, OW);
+  const bool channels_last = !input.is_contiguous();
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "upsample_nearest2d", [&] {
+    scalar_t* out = output.data<scalar_t>();
+    const scalar_t* in = input.data<scalar_t>();
+    if (channels_last) {
+      parallel_for(0, N * OH * OW, grain_size(C), [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; k++) {
+          const int64_t n = k / (OH * OW);
+          const scalar_t* x = in + ((n * H + hs[k / OW % OH]) * W + ws[k % OW]) * C;
+          std::copy(x, x + C, out + k * C);
+        }
+      });
+    } else {
+      parallel_for(0, N * C, grain_size(OH * OW), [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; k++) {
+          const scalar_t* x = in + k * H * W;
+          scalar_t* y = out + k * OH * OW;
+          for (int64_t oh = 0; oh < OH; oh++) {
+            for (int64_t ow = 0; ow < OW; ow++) {
+              y[oh * OW + ow] = x[hs[oh] * W + ws[ow]];
+            }
+          }
+        }
+      });
+    }
+  });
+}
+
+static void upsample_nearest2d_backward_kernel_impl(Tensor& grad_input, const Tensor& grad_output) {
+  const int64_t N = grad_input.size(0), C = grad_input.size(1);
+  const int64_t H = grad_input.size(2), W = grad_input.size(3);
+  const int64_t OH = grad_output.size(2), OW = grad_output.size(3);
+  const auto hs = nearest_indices(H, OH);
+  const auto ws = nearest_indices(W, OW);
+  const bool channels_last = !grad_input.is_contiguous();
+  AT_DISPATCH_FLOATING_TYPES(grad_input.type(), "upsample_nearest2d_backward", [&] {
+    using Vec = vec::Vectorized<scalar_t>;
+    scalar_t* gi = grad_input.data<scalar_t>();
+    const scalar_t* go = grad_output.data<scalar_t>();
+    if (channels_last) {
+      const int64_t blocks = divup(C, kChannelBlock);
+      parallel_for(0, N * blocks, grain_size(OH * OW * kChannelBlock), [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; k++) {
+          const int64_t n = k / blocks;
+          const int64_t c_begin = k % blocks * kChannelBlock;
+          const int64_t c_end = std::min(c_begin + kChannelBlock, C);
+          for (int64_t oh = 0; oh < OH; oh++) {
+            for (int64_t ow = 0; ow < OW; ow++) {
+              const scalar_t* dy = go + ((n * OH + oh) * OW + ow) * C;
+              scalar_t* dx = gi + ((n * H + hs[oh]) * W + ws[ow]) * C;
+              for (int64_t c = c_begin; c < c_end; c += Vec::size) {
+                const int64_t count = std::min<int64_t>(Vec::size, c_end - c);
+                (Vec::loadu(dx + c, count) + Vec::loadu(dy + c, count)).store(dx + c, count);
+              }
+            }
+          }
+        }
+      });
+    } else {
+      parallel_for(0, N * C, grain_size(OH * OW), [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; k++) {
+          scalar_t* dx = gi + k * H * W;
+          const scalar_t* dy = go + k * OH * OW;
+          for (int64_t oh = 0; oh < OH; oh++) {
+            for (int64_t ow = 0; ow < OW; ow++) {
+              dx[hs[oh] * W + ws[ow]] += dy[oh * OW + ow];
+            }
+          }
+        }
+      });
+    }
+  });
+}
+
+static void upsample_bilinear2d_kernel_impl(Tensor& output, const Tensor& input, bool align_corners) {
+  const int64_t N = input.size(0), C = input.size(1), H = input.size(2), W = input.size(3);
+  const int64_t OH = output.size(2), OW = output.size(3);
+  const bool channels_last = !input.is_contiguous();
+  AT_DISPATCH_FLOATING_TYPES(input.type(), "upsample_bilinear2d", [&] {
+    using Vec = vec::Vectorized<scalar_t>;
+    const auto hs = linear_indices<scalar_t>(H, OH, align_corners);
+    const auto ws = linear_indices<scalar_t>(W, OW, align_corners);
+    scalar_t* out = output.data<scalar_t>();
+    const scalar_t* in = input.data<scalar_t>();
+    if (channels_last) {
+      parallel_for(0, N * OH * OW, grain_size(4 * C), [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; k++) {
+          const int64_t n = k / (OH * OW);
+          const auto& h = hs[k / OW % OH];
+          const auto& w = ws[k % OW];
+          const scalar_t* x00 = in + ((n * H + h.i0) * W + w.i0) * C;
+          const scalar_t* x01 = in + ((n * H + h.i0) * W + w.i1) * C;
+          const scalar_t* x10 = in + ((n * H + h.i1) * W + w.i0) * C;
+          const scalar_t* x11 = in + ((n * H + h.i1) * W + w.i1) * C;
+          const Vec h0(h.lambda0), h1(h.lambda1), w0(w.lambda0), w1(w.lambda1);
+          scalar_t* y = out + k * C;
+          for (int64_t c = 0; c < C; c += Vec::size) {
+            const int64_t count = std::min<int64_t>(Vec::size, C - c);
+            const Vec top = w0 * Vec::loadu(x00 + c, count) + w1 * Vec::loadu(x01 + c, count);
+            const Vec bottom = w0 * Vec::loadu(x10 + c, count) + w1 * Vec::loadu(x11 + c, count);
+            (h0 * top + h1 * bottom).store(y + c, count);
+          }
+        }
+      });
+    } else {
+      parallel_for(0, N * C, grain_size(4 * OH * OW), [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; k++) {
+          const scalar_t* x = in + k * H * W;
+          scalar_t* y = out + k * OH * OW;
+          for (int64_t oh = 0; oh < OH; oh++) {
+            const auto& h = hs[oh];
+            const scalar_t* row0 = x + h.i0 * W;
+            const scalar_t* row1 = x + h.i1 * W;
+            for (int64_t ow = 0; ow < OW; ow++) {
+              const auto& w = ws[ow];
+              y[oh * OW + ow] = h.lambda0 * (w.lambda0 * row0[w.i0] + w.lambda1 * row0[w.i1])
+                              + h.lambda1 * (w.lambda0 * row1[w.i0] + w.lambda1 * row1[w.i1]);
+            }
+          }
+        }
+      });
+    }
+  });
+}
+
+static void upsample_bilinear2d_backward_kernel_impl(
+    Tensor& grad_input, const Tensor& grad_output, bool align_corners) {
+  const int64_t N = grad_input.size(0), C = grad_input.size(1);
+  const int64_t H = grad_input.size(2), W = grad_input.size(3);
+  const int64_t OH = grad_output.size(2), OW = grad_output.size(3);
+  const bool channels_last = !grad_input.is_contiguous();
+  AT_DISPATCH_FLOATING_TYPES(grad_input.type(), "upsample_bilinear2d_backward", [&] {
+    using Vec = vec::Vectorized<scalar_t>;
+    const auto hs = linear_indices<scalar_t>(H, OH, align_corners);
+    const auto ws = linear_indices<scalar_t>(W, OW, align_corners);
+    scalar_t* gi = grad_input.data<scalar_t>();
+    const scalar_t* go = grad_output.data<scalar_t>();
+    if (channels_last) {
+      const int64_t blocks = divup(C, kChannelBlock);
+      parallel_for(0, N * blocks, grain_size(4 * OH * OW * kChannelBlock), [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; k++) {
+          const int64_t n = k / blocks;
+          const int64_t c_begin = k % blocks * kChannelBlock;
+          const int64_t c_end = std::min(c_begin + kChannelBlock, C);
+          for (int64_t oh = 0; oh < OH; oh++) {
+            const auto& h = hs[oh];
+            for (int64_t ow = 0; ow < OW; ow++) {
+              const auto& w = ws[ow];
+              const scalar_t* dy = go + ((n * OH + oh) * OW + ow) * C;
+              scalar_t* dx00 = gi + ((n * H + h.i0) * W + w.i0) * C;
+              scalar_t* dx01 = gi + ((n * H + h.i0) * W + w.i1) * C;
+              scalar_t* dx10 = gi + ((n * H + h.i1) * W + w.i0) * C;
+              scalar_t* dx11 = gi + ((n * H + h.i1) * W + w.i1) * C;
+              const Vec l00(h.lambda0 * w.lambda0), l01(h.lambda0 * w.lambda1);
+              const Vec l10(h.lambda1 * w.lambda0), l11(h.lambda1 * w.lambda1);
+              for (int64_t c = c_begin; c < c_end; c += Vec::size) {
+                const int64_t count = std::min<int64_t>(Vec::size, c_end - c);
+                const Vec g = Vec::loadu(dy + c, count);
+                // The four pixels are the same one at the borders, so each
+                // add has to see the previous ones.
+                (Vec::loadu(dx00 + c, count) + l00 * g).store(dx00 + c, count);
+                (Vec::loadu(dx01 + c, count) + l01 * g).store(dx01 + c, count);
+                (Vec::loadu(dx10 + c, count) + l10 * g).store(dx10 + c, count);
+                (Vec::loadu(dx11 + c, count) + l11 * g).store(dx11 + c, count);
+              }
+            }
+          }
+        }
+      });
+    } else {
+      parallel_for(0, N * C, grain_size(4 * OH * OW), [&](int64_t begin, int64_t end) {
+        for (int64_t k = begin; k < end; k++) {
+          scalar_t* dx = gi + k * H * W;
+          const scalar_t* dy = go + k * OH * OW;
+          for (int64_t oh = 0; oh < OH; oh++) {
+            const auto& h = hs[oh];
+            scalar_t* row0 = dx + h.i0 * W;
+            scalar_t* row1 = dx + h.i1 * W;
+            for (int64_t ow = 0; ow < OW; ow++) {
+              const auto& w = ws[ow];
+              const scalar_t g = dy[oh * OW + ow];
+              row0[w.i0] += h.lambda0 * w.lambda0 * g;
+              row0[w.i1] += h.lambda0 * w.lambda1 * g;
+              row1[w.i0] += h.lambda1 * w.lambda0 * g;
+              row1[w.i1] += h.lambda1 * w.lambda1 * g;
+            }
+          }
+        }
+      });
+    }
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(upsample_nearest2d_kernel, &upsample_nearest2d_kernel_impl);
+REGISTER_DISPATCH(upsample_nearest2d_backward_kernel, &upsample_nearest2d_backward_kernel_impl);
+REGISTER_DISPATCH(upsample_bilinear2d_kernel, &upsample_bilinear2d_kernel_impl);
+REGISTER_DISPATCH(upsample_bilinear2d_backward_kernel, &upsample_bilinear2d_backward_kernel_impl);
+
+}} // namespace at::native
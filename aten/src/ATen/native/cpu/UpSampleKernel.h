@@ -0,0 +1,29 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// The kernels take 4-D (N, C, H, W) tensors of the same layout, contiguous or
+// channels-last (see ChannelsLastUtils.h), that the caller has sized. The
+// layout is the one of the tensor with the sizes of the input. Source pixels
+// are picked as in THNN (see THNN/generic/linear_upsampling.h). Backward
+// kernels accumulate into a zeroed grad_input.
+
+//   (output, input)
+using upsample_nearest2d_fn = void(*)(Tensor&, const Tensor&);
+//   (grad_input, grad_output)
+using upsample_nearest2d_backward_fn = void(*)(Tensor&, const Tensor&);
+
+//   (output, input, align_corners)
+using upsample_bilinear2d_fn = void(*)(Tensor&, const Tensor&, bool);
+//   (grad_input, grad_output, align_corners)
+using upsample_bilinear2d_backward_fn = void(*)(Tensor&, const Tensor&, bool);
+
+extern DispatchStub<upsample_nearest2d_fn> upsample_nearest2d_kernel;
+extern DispatchStub<upsample_nearest2d_backward_fn> upsample_nearest2d_backward_kernel;
+extern DispatchStub<upsample_bilinear2d_fn> upsample_bilinear2d_kernel;
+extern DispatchStub<upsample_bilinear2d_backward_fn> upsample_bilinear2d_backward_kernel;
+
+}} // namespace at::native
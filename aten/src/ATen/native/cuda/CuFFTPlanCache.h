@@ -4,6 +4,7 @@
 #include "ATen/native/utils/ParamsHash.h"
 
 #include <list>
+#include <mutex>
 #include <unordered_map>
 #include <string>
 #include <stdexcept>
@@ -291,10 +292,14 @@ static_assert(CUFFT_MAX_PLAN_NUM >= 0 && CUFFT_MAX_PLAN_NUM <= std::numeric_limi
               "CUFFT_MAX_PLAN_NUM not in size_t range");
 
 // This cache assumes that the mapping from key to value never changes.
-// This is **NOT** thread-safe. Please use a mutex when using it **AND** the
+// This is **NOT** thread-safe. Please lock `mutex` when using it **AND** the
 // value returned from try_emplace_value.
 // The contract of using this cache is that try_emplace_value should only be
 // used when the max_size is positive.
+//
+// There is one cache per device (see cufft_get_plan_cache in
+// native/cuda/SpectralOps.cu), because a plan can only be executed on the
+// device it was created on.
 class CuFFTParamsLRUCache {
 public:
   using kv_t = typename std::pair<CuFFTParams, CuFFTConfig>;
@@ -323,11 +328,13 @@ public:
     map_kkv_iter_t map_it = _cache_map.find(key);
     // Hit, put to list front
     if (map_it != _cache_map.end()) {
+      _hits++;
       _usage_list.splice(_usage_list.begin(), _usage_list, map_it->second);
       return map_it->second->second;
     }
 
     // Miss
+    _misses++;
     // remove if needed
     if (_usage_list.size() >= _max_size) {
       auto last = _usage_list.end();
@@ -347,9 +354,12 @@ public:
     return kv_it->second;
   }
 
+  // Also resets the hit and miss counters.
   void clear() {
     _cache_map.clear();
     _usage_list.clear();
+    _hits = 0;
+    _misses = 0;
   }
 
   void resize(int64_t new_size) {
@@ -370,6 +380,14 @@ public:
 
   size_t max_size() const noexcept { return _max_size; }
 
+  // Number of calls of try_emplace_value that found the plan in the cache
+  // and that had to create it, since construction or the last clear().
+  int64_t hits() const noexcept { return _hits; }
+
+  int64_t misses() const noexcept { return _misses; }
+
+  std::mutex mutex;
+
 private:
   // Only sets size and does value check. Does not resize the data structures.
   void _set_max_size(int64_t new_size) {
@@ -383,6 +401,8 @@ private:
   std::list<kv_t> _usage_list;
   map_t _cache_map;
   size_t _max_size;
+  int64_t _hits = 0;
+  int64_t _misses = 0;
 };
 
 // Since ATen is separated into CPU build and CUDA build, we need a way to call
@@ -390,10 +410,14 @@ private:
 // (at cuda/detail/CUDAHooks.cpp), and call the hooked functions from the actual
 // native function counterparts (at native/SpectralOps.cpp), i.e.,
 // _cufft_get_plan_cache_max_size, _cufft_set_plan_cache_max_size
-// _cufft_get_plan_cache_size, and _cufft_clear_plan_cache.
-int64_t cufft_get_plan_cache_max_size_impl();
-void cufft_set_plan_cache_max_size_impl(int64_t max_size);
-int64_t cufft_get_plan_cache_size_impl();
-void cufft_clear_plan_cache_impl();
+// _cufft_get_plan_cache_size, _cufft_get_plan_cache_hits,
+// _cufft_get_plan_cache_misses and _cufft_clear_plan_cache.
+// All of them act on the cache of the device with index device_index.
+int64_t cufft_get_plan_cache_max_size_impl(int64_t device_index);
+void cufft_set_plan_cache_max_size_impl(int64_t device_index, int64_t max_size);
+int64_t cufft_get_plan_cache_size_impl(int64_t device_index);
+int64_t cufft_get_plan_cache_hits_impl(int64_t device_index);
+int64_t cufft_get_plan_cache_misses_impl(int64_t device_index);
+void cufft_clear_plan_cache_impl(int64_t device_index);
 
 }}} // namespace at::native::detail
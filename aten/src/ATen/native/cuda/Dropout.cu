@@ -0,0 +1,151 @@
+#include "ATen/ATen.h"
+#include "ATen/NativeFunctions.h"
+
+#include "ATen/AccumulateType.h"
+
+#include <curand.h>
+#include <curand_kernel.h>
+#include <curand_philox4x32_x.h>
+
+#include <THC/THCGeneral.h>
+#include <THC/THCGenerator.hpp>
+
+#include <algorithm>
+#include <utility>
+
+THCGenerator* THCRandom_getGenerator(THCState* state);
+
+namespace at {
+namespace native {
+
+namespace {
+
+const int DROPOUT_THREADS = 256;
+
+std::pair<uint64_t, uint64_t> next_philox_seed(uint64_t increment) {
+  auto gen_ = THCRandom_getGenerator(at::globalContext().getTHCState());
+  uint64_t offset = gen_->state.philox_seed_offset.fetch_add(increment);
+  return std::make_pair(gen_->state.initial_seed, offset);
+}
+
+// Every thread draws the 8 uniforms of each of its mask bytes from its own
+// Philox subsequence. Bit b of mask[j] is set if element 8 * j + b is kept.
+template <typename scalar_t, typename accscalar_t>
+__global__ void fusedDropoutKernel(
+    int64_t numel,
+    accscalar_t keep_prob,
+    const scalar_t* X,
+    scalar_t* Y,
+    uint8_t* mask,
+    std::pair<uint64_t, uint64_t> seeds) {
+  const int64_t idx = blockIdx.x * blockDim.x + threadIdx.x;
+  const int64_t num_bytes = (numel + 7) / 8;
+  const accscalar_t scale = accscalar_t(1) / keep_prob;
+  curandStatePhilox4_32_10_t state;
+  curand_init(seeds.first, idx, seeds.second, &state);
+  for (int64_t j = idx; j < num_bytes; j += blockDim.x * gridDim.x) {
+    const float4 rand_lo = curand_uniform4(&state);
+    const float4 rand_hi = curand_uniform4(&state);
+    const float rand[8] = {rand_lo.x, rand_lo.y, rand_lo.z, rand_lo.w,
+                           rand_hi.x, rand_hi.y, rand_hi.z, rand_hi.w};
+    uint8_t byte = 0;
+#pragma unroll
+    for (int b = 0; b < 8; ++b) {
+      const int64_t i = 8 * j + b;
+      if (i < numel) {
+        const bool keep = rand[b] < keep_prob;
+        byte |= keep << b;
+        Y[i] = keep
+            ? static_cast<scalar_t>(static_cast<accscalar_t>(X[i]) * scale)
+            : static_cast<scalar_t>(0);
+      }
+    }
+    mask[j] = byte;
+  }
+}
+
+template <typename scalar_t, typename accscalar_t>
+__global__ void fusedDropoutBackwardKernel(
+    int64_t numel,
+    accscalar_t scale,
+    const scalar_t* dY,
+    const uint8_t* mask,
+    scalar_t* dX) {
+  const int64_t stride = blockDim.x * gridDim.x;
+  for (int64_t i = blockIdx.x * blockDim.x + threadIdx.x; i < numel;
+       i += stride) {
+    dX[i] = (mask[i / 8] >> (i % 8)) & 1
+        ? static_cast<scalar_t>(static_cast<accscalar_t>(dY[i]) * scale)
+        : static_cast<scalar_t>(0);
+  }
+}
+
+void check_dropout_probability(double p) {
+  AT_CHECK(
+      p > 0 && p < 1,
+      "_fused_dropout: probability has to be in (0, 1), but got ", p);
+}
+
+} // namespace
+
+std::tuple<Tensor, Tensor> _fused_dropout_cuda(const Tensor& self, double p, Generator* gen) {
+  check_dropout_probability(p);
+  auto X = self.contiguous();
+  const int64_t numel = X.numel();
+  const int64_t num_bytes = (numel + 7) / 8;
+  Tensor Y = at::empty_like(X);
+  Tensor mask = at::empty({num_bytes}, X.type().toScalarType(kByte));
+  if (numel == 0) {
+    return std::make_tuple(Y, mask);
+  }
+  // Enough blocks to fill the device, with every thread looping over the
+  // remaining bytes, so that each thread initializes its Philox state once.
+  const cudaDeviceProp* prop = globalContext().getCurrentDeviceProperties();
+  const int64_t max_blocks = prop->multiProcessorCount *
+      (prop->maxThreadsPerMultiProcessor / DROPOUT_THREADS);
+  const int64_t blocks = std::min<int64_t>(
+      max_blocks, (num_bytes + DROPOUT_THREADS - 1) / DROPOUT_THREADS);
+  const int64_t bytes_per_thread =
+      (num_bytes + blocks * DROPOUT_THREADS - 1) / (blocks * DROPOUT_THREADS);
+  auto seeds = next_philox_seed(8 * bytes_per_thread);
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(X.type(), "_fused_dropout_cuda", [&] {
+    using accscalar_t = acc_type<scalar_t, true>;
+    fusedDropoutKernel<scalar_t, accscalar_t>
+      <<<blocks, DROPOUT_THREADS, 0, stream>>>(
+        numel, static_cast<accscalar_t>(1 - p), X.data<scalar_t>(),
+        Y.data<scalar_t>(), mask.data<uint8_t>(), seeds);
+  });
+  THCudaCheck(cudaGetLastError());
+  return std::make_tuple(Y, mask);
+}
+
+Tensor _fused_dropout_backward_cuda(const Tensor& grad_output, const Tensor& mask, double p) {
+  check_dropout_probability(p);
+  const int64_t numel = grad_output.numel();
+  AT_CHECK(
+      mask.numel() == (numel + 7) / 8,
+      "_fused_dropout_backward: expected a mask of ", (numel + 7) / 8,
+      " bytes for ", numel, " elements, but got ", mask.numel());
+  auto dY = grad_output.contiguous();
+  auto mask_contig = mask.contiguous();
+  Tensor dX = at::empty_like(dY);
+  if (numel == 0) {
+    return dX;
+  }
+  const int64_t blocks = std::min<int64_t>(
+      (numel + DROPOUT_THREADS - 1) / DROPOUT_THREADS, 65535);
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(dY.type(), "_fused_dropout_backward_cuda", [&] {
+    using accscalar_t = acc_type<scalar_t, true>;
+    fusedDropoutBackwardKernel<scalar_t, accscalar_t>
+      <<<blocks, DROPOUT_THREADS, 0, stream>>>(
+        numel, static_cast<accscalar_t>(1 / (1 - p)), dY.data<scalar_t>(),
+        mask_contig.data<uint8_t>(), dX.data<scalar_t>());
+  });
+  THCudaCheck(cudaGetLastError());
+  return dX;
+}
+
+} // namespace native
+} // namespace at
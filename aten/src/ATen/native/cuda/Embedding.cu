@@ -266,10 +266,16 @@ Tensor embedding_dense_backward_cuda(const Tensor & grad_, const Tensor & indice
     auto orig_data = device_ptr(orig_indices.data<int64_t>());
     thrust::copy(policy, count_iter, count_iter + num_indices, orig_data);
 
-    // Sort; a stable sort is not required
+    // Sort; a stable sort is only required for reproducible results, as it
+    // fixes the order in which the gradients of each index are added
     auto sorted_data = device_ptr(sorted_indices.data<int64_t>());
-    thrust::sort_by_key(policy, sorted_data, sorted_data + num_indices, orig_data,
-                        ThrustLTOp<int64_t>());
+    if (THCState_getDeterministicAccumulate(globalContext().lazyInitCUDA())) {
+      thrust::stable_sort_by_key(policy, sorted_data, sorted_data + num_indices,
+                                 orig_data);
+    } else {
+      thrust::sort_by_key(policy, sorted_data, sorted_data + num_indices, orig_data,
+                          ThrustLTOp<int64_t>());
+    }
   }
 
   Tensor count;
@@ -0,0 +1,318 @@
+#include "ATen/ATen.h"
+#include "ATen/AccumulateType.h"
+#include "ATen/Dispatch.h"
+#include "ATen/NativeFunctions.h"
+#include "ATen/native/FusedOptimizers.h"
+#include "ATen/native/cuda/MultiTensorApply.cuh"
+
+#include <initializer_list>
+
+namespace at { namespace native {
+
+namespace {
+
+// Gathers the lists taking part in a launch; switched-off state comes in as
+// an empty list and is skipped, so the functors find their optional state
+// right after the mandatory lists.
+template <int depth>
+std::array<std::vector<Tensor>, depth> gather_lists(
+    std::initializer_list<const std::vector<Tensor>*> lists) {
+  std::array<std::vector<Tensor>, depth> result;
+  int d = 0;
+  for (const auto* list : lists) {
+    if (!list->empty()) {
+      AT_ASSERT(d < depth);
+      result[d++] = *list;
+    }
+  }
+  AT_ASSERT(d == depth);
+  return result;
+}
+
+template <typename scalar_t>
+__device__ __forceinline__ scalar_t* chunk_of(void* pointer, int64_t offset) {
+  return static_cast<scalar_t*>(pointer) + offset;
+}
+
+// Lists: params, grads[, momentum_buffers].
+template <typename scalar_t, bool kMomentum>
+struct SGDFunctor {
+  using acc_t = acc_type<scalar_t, true>;
+
+  SGDFunctor(double lr, double momentum, double dampening,
+             double weight_decay, bool nesterov, bool first_step)
+      : lr(lr), momentum(momentum), dampening(dampening),
+        weight_decay(weight_decay), nesterov(nesterov),
+        first_step(first_step) {}
+
+  __device__ void operator()(
+      int64_t offset, int n, void** pointers, double /* unused */) const {
+    scalar_t* p = chunk_of<scalar_t>(pointers[0], offset);
+    const scalar_t* g = chunk_of<scalar_t>(pointers[1], offset);
+    scalar_t* buf = kMomentum ? chunk_of<scalar_t>(pointers[2], offset) : nullptr;
+    for (int i = threadIdx.x; i < n; i += blockDim.x) {
+      acc_t b = kMomentum ? static_cast<acc_t>(buf[i]) : acc_t(0);
+      p[i] = static_cast<scalar_t>(fused_sgd_update<acc_t>(
+          static_cast<acc_t>(p[i]), static_cast<acc_t>(g[i]),
+          kMomentum ? &b : nullptr, lr, momentum, dampening, weight_decay,
+          nesterov, first_step));
+      if (kMomentum) {
+        buf[i] = static_cast<scalar_t>(b);
+      }
+    }
+  }
+
+  acc_t lr, momentum, dampening, weight_decay;
+  bool nesterov, first_step;
+};
+
+// Lists: params, grads, exp_avgs, exp_avg_sqs[, max_exp_avg_sqs]; the
+// per-tensor scalar is the step size.
+template <typename scalar_t, bool kAmsgrad>
+struct AdamFunctor {
+  using acc_t = acc_type<scalar_t, true>;
+
+  AdamFunctor(double beta1, double beta2, double weight_decay, double eps)
+      : beta1(beta1), beta2(beta2), weight_decay(weight_decay), eps(eps) {}
+
+  __device__ void operator()(
+      int64_t offset, int n, void** pointers, double step_size) const {
+    scalar_t* p = chunk_of<scalar_t>(pointers[0], offset);
+    const scalar_t* g = chunk_of<scalar_t>(pointers[1], offset);
+    scalar_t* exp_avg = chunk_of<scalar_t>(pointers[2], offset);
+    scalar_t* exp_avg_sq = chunk_of<scalar_t>(pointers[3], offset);
+    scalar_t* max_exp_avg_sq =
+        kAmsgrad ? chunk_of<scalar_t>(pointers[4], offset) : nullptr;
+    for (int i = threadIdx.x; i < n; i += blockDim.x) {
+      acc_t m = static_cast<acc_t>(exp_avg[i]);
+      acc_t v = static_cast<acc_t>(exp_avg_sq[i]);
+      acc_t vmax = kAmsgrad ? static_cast<acc_t>(max_exp_avg_sq[i]) : acc_t(0);
+      p[i] = static_cast<scalar_t>(fused_adam_update<acc_t>(
+          static_cast<acc_t>(p[i]), static_cast<acc_t>(g[i]), &m, &v,
+          kAmsgrad ? &vmax : nullptr, static_cast<acc_t>(step_size), beta1,
+          beta2, weight_decay, eps));
+      exp_avg[i] = static_cast<scalar_t>(m);
+      exp_avg_sq[i] = static_cast<scalar_t>(v);
+      if (kAmsgrad) {
+        max_exp_avg_sq[i] = static_cast<scalar_t>(vmax);
+      }
+    }
+  }
+
+  acc_t beta1, beta2, weight_decay, eps;
+};
+
+// Lists: params, grads, square_avgs[, grad_avgs][, momentum_buffers].
+template <typename scalar_t, bool kCentered, bool kMomentum>
+struct RMSpropFunctor {
+  using acc_t = acc_type<scalar_t, true>;
+
+  RMSpropFunctor(double lr, double alpha, double eps, double weight_decay,
+                 double momentum)
+      : lr(lr), alpha(alpha), eps(eps), weight_decay(weight_decay),
+        momentum(momentum) {}
+
+  __device__ void operator()(
+      int64_t offset, int n, void** pointers, double /* unused */) const {
+    scalar_t* p = chunk_of<scalar_t>(pointers[0], offset);
+    const scalar_t* g = chunk_of<scalar_t>(pointers[1], offset);
+    scalar_t* square_avg = chunk_of<scalar_t>(pointers[2], offset);
+    scalar_t* grad_avg =
+        kCentered ? chunk_of<scalar_t>(pointers[3], offset) : nullptr;
+    scalar_t* buf =
+        kMomentum ? chunk_of<scalar_t>(pointers[3 + kCentered], offset) : nullptr;
+    for (int i = threadIdx.x; i < n; i += blockDim.x) {
+      acc_t sq = static_cast<acc_t>(square_avg[i]);
+      acc_t ga = kCentered ? static_cast<acc_t>(grad_avg[i]) : acc_t(0);
+      acc_t b = kMomentum ? static_cast<acc_t>(buf[i]) : acc_t(0);
+      p[i] = static_cast<scalar_t>(fused_rmsprop_update<acc_t>(
+          static_cast<acc_t>(p[i]), static_cast<acc_t>(g[i]), &sq,
+          kCentered ? &ga : nullptr, kMomentum ? &b : nullptr, lr, alpha, eps,
+          weight_decay, momentum));
+      square_avg[i] = static_cast<scalar_t>(sq);
+      if (kCentered) {
+        grad_avg[i] = static_cast<scalar_t>(ga);
+      }
+      if (kMomentum) {
+        buf[i] = static_cast<scalar_t>(b);
+      }
+    }
+  }
+
+  acc_t lr, alpha, eps, weight_decay, momentum;
+};
+
+// Lists: params, grads, sums; the per-tensor scalar is the decayed
+// learning rate.
+template <typename scalar_t>
+struct AdagradFunctor {
+  using acc_t = acc_type<scalar_t, true>;
+
+  explicit AdagradFunctor(double weight_decay) : weight_decay(weight_decay) {}
+
+  __device__ void operator()(
+      int64_t offset, int n, void** pointers, double clr) const {
+    scalar_t* p = chunk_of<scalar_t>(pointers[0], offset);
+    const scalar_t* g = chunk_of<scalar_t>(pointers[1], offset);
+    scalar_t* sum = chunk_of<scalar_t>(pointers[2], offset);
+    for (int i = threadIdx.x; i < n; i += blockDim.x) {
+      acc_t s = static_cast<acc_t>(sum[i]);
+      p[i] = static_cast<scalar_t>(fused_adagrad_update<acc_t>(
+          static_cast<acc_t>(p[i]), static_cast<acc_t>(g[i]), &s,
+          static_cast<acc_t>(clr), weight_decay));
+      sum[i] = static_cast<scalar_t>(s);
+    }
+  }
+
+  acc_t weight_decay;
+};
+
+template <typename scalar_t, bool kCentered, bool kMomentum>
+void rmsprop_apply(
+    const std::vector<Tensor>& params, const std::vector<Tensor>& grads,
+    const std::vector<Tensor>& square_avgs, const std::vector<Tensor>& grad_avgs,
+    const std::vector<Tensor>& momentum_buffers, double lr, double alpha,
+    double eps, double weight_decay, double momentum) {
+  constexpr int depth = 3 + kCentered + kMomentum;
+  multi_tensor_apply<depth>(
+      gather_lists<depth>(
+          {&params, &grads, &square_avgs, &grad_avgs, &momentum_buffers}),
+      {},
+      RMSpropFunctor<scalar_t, kCentered, kMomentum>(
+          lr, alpha, eps, weight_decay, momentum));
+}
+
+} // namespace
+
+void _fused_sgd_step_cuda(
+    TensorList params_, TensorList grads_, TensorList momentum_buffers_,
+    double lr, double momentum, double dampening, double weight_decay,
+    bool nesterov, bool first_step) {
+  check_fused_step_inputs(
+      "_fused_sgd_step", params_, grads_, {momentum_buffers_});
+  auto params = fused_step_operands(params_);
+  auto grads = fused_step_operands(grads_);
+  auto momentum_buffers = fused_step_operands(momentum_buffers_);
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(params[0].type(), "_fused_sgd_step_cuda", [&] {
+    if (momentum_buffers.empty()) {
+      multi_tensor_apply<2>(
+          gather_lists<2>({&params, &grads}), {},
+          SGDFunctor<scalar_t, false>(
+              lr, momentum, dampening, weight_decay, nesterov, first_step));
+    } else {
+      multi_tensor_apply<3>(
+          gather_lists<3>({&params, &grads, &momentum_buffers}), {},
+          SGDFunctor<scalar_t, true>(
+              lr, momentum, dampening, weight_decay, nesterov, first_step));
+    }
+  });
+  fused_step_write_back(params_, params);
+  fused_step_write_back(momentum_buffers_, momentum_buffers);
+}
+
+void _fused_adam_step_cuda(
+    TensorList params_, TensorList grads_, TensorList exp_avgs_,
+    TensorList exp_avg_sqs_, TensorList max_exp_avg_sqs_, IntList steps,
+    double lr, double beta1, double beta2, double weight_decay, double eps) {
+  check_fused_step_inputs(
+      "_fused_adam_step", params_, grads_,
+      {exp_avgs_, exp_avg_sqs_, max_exp_avg_sqs_});
+  AT_CHECK(exp_avgs_.size() == params_.size() &&
+           exp_avg_sqs_.size() == params_.size() &&
+           steps.size() == params_.size(),
+           "_fused_adam_step: expected moments and a step for every parameter");
+  auto params = fused_step_operands(params_);
+  auto grads = fused_step_operands(grads_);
+  auto exp_avgs = fused_step_operands(exp_avgs_);
+  auto exp_avg_sqs = fused_step_operands(exp_avg_sqs_);
+  auto max_exp_avg_sqs = fused_step_operands(max_exp_avg_sqs_);
+  std::vector<double> step_sizes;
+  step_sizes.reserve(steps.size());
+  for (auto step : steps) {
+    step_sizes.push_back(fused_adam_step_size(lr, beta1, beta2, step));
+  }
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(params[0].type(), "_fused_adam_step_cuda", [&] {
+    if (max_exp_avg_sqs.empty()) {
+      multi_tensor_apply<4>(
+          gather_lists<4>({&params, &grads, &exp_avgs, &exp_avg_sqs}),
+          step_sizes,
+          AdamFunctor<scalar_t, false>(beta1, beta2, weight_decay, eps));
+    } else {
+      multi_tensor_apply<5>(
+          gather_lists<5>(
+              {&params, &grads, &exp_avgs, &exp_avg_sqs, &max_exp_avg_sqs}),
+          step_sizes,
+          AdamFunctor<scalar_t, true>(beta1, beta2, weight_decay, eps));
+    }
+  });
+  fused_step_write_back(params_, params);
+  fused_step_write_back(exp_avgs_, exp_avgs);
+  fused_step_write_back(exp_avg_sqs_, exp_avg_sqs);
+  fused_step_write_back(max_exp_avg_sqs_, max_exp_avg_sqs);
+}
+
+void _fused_rmsprop_step_cuda(
+    TensorList params_, TensorList grads_, TensorList square_avgs_,
+    TensorList grad_avgs_, TensorList momentum_buffers_, double lr,
+    double alpha, double eps, double weight_decay, double momentum) {
+  check_fused_step_inputs(
+      "_fused_rmsprop_step", params_, grads_,
+      {square_avgs_, grad_avgs_, momentum_buffers_});
+  AT_CHECK(square_avgs_.size() == params_.size(),
+           "_fused_rmsprop_step: expected a square average for every parameter");
+  auto params = fused_step_operands(params_);
+  auto grads = fused_step_operands(grads_);
+  auto square_avgs = fused_step_operands(square_avgs_);
+  auto grad_avgs = fused_step_operands(grad_avgs_);
+  auto momentum_buffers = fused_step_operands(momentum_buffers_);
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(params[0].type(), "_fused_rmsprop_step_cuda", [&] {
+    const bool centered = !grad_avgs.empty();
+    const bool use_momentum = !momentum_buffers.empty();
+    if (centered && use_momentum) {
+      rmsprop_apply<scalar_t, true, true>(
+          params, grads, square_avgs, grad_avgs, momentum_buffers, lr, alpha,
+          eps, weight_decay, momentum);
+    } else if (centered) {
+      rmsprop_apply<scalar_t, true, false>(
+          params, grads, square_avgs, grad_avgs, momentum_buffers, lr, alpha,
+          eps, weight_decay, momentum);
+    } else if (use_momentum) {
+      rmsprop_apply<scalar_t, false, true>(
+          params, grads, square_avgs, grad_avgs, momentum_buffers, lr, alpha,
+          eps, weight_decay, momentum);
+    } else {
+      rmsprop_apply<scalar_t, false, false>(
+          params, grads, square_avgs, grad_avgs, momentum_buffers, lr, alpha,
+          eps, weight_decay, momentum);
+    }
+  });
+  fused_step_write_back(params_, params);
+  fused_step_write_back(square_avgs_, square_avgs);
+  fused_step_write_back(grad_avgs_, grad_avgs);
+  fused_step_write_back(momentum_buffers_, momentum_buffers);
+}
+
+void _fused_adagrad_step_cuda(
+    TensorList params_, TensorList grads_, TensorList sums_, IntList steps,
+    double lr, double lr_decay, double weight_decay) {
+  check_fused_step_inputs("_fused_adagrad_step", params_, grads_, {sums_});
+  AT_CHECK(sums_.size() == params_.size() && steps.size() == params_.size(),
+           "_fused_adagrad_step: expected a sum and a step for every parameter");
+  auto params = fused_step_operands(params_);
+  auto grads = fused_step_operands(grads_);
+  auto sums = fused_step_operands(sums_);
+  std::vector<double> clrs;
+  clrs.reserve(steps.size());
+  for (auto step : steps) {
+    clrs.push_back(fused_adagrad_clr(lr, lr_decay, step));
+  }
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(params[0].type(), "_fused_adagrad_step_cuda", [&] {
+    multi_tensor_apply<3>(
+        gather_lists<3>({&params, &grads, &sums}), clrs,
+        AdagradFunctor<scalar_t>(weight_decay));
+  });
+  fused_step_write_back(params_, params);
+  fused_step_write_back(sums_, sums);
+}
+
+}} // namespace at::native
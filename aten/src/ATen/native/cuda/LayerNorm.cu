@@ -0,0 +1,307 @@
+#include "ATen/ATen.h"
+#include "ATen/NativeFunctions.h"
+
+#include "ATen/AccumulateType.h"
+
+#include <THC/THCDeviceUtils.cuh>
+
+namespace at {
+namespace native {
+
+namespace {
+
+const int WARP_SIZE = 32;
+const int LAYER_NORM_THREADS = 256;
+
+// Mean, sum of squared deviations and count of a set of values.
+template <typename T>
+struct WelfordData {
+  T mean;
+  T m2;
+  T n;
+};
+
+template <typename T>
+__device__ __forceinline__ WelfordData<T> welfordCombine(
+    const WelfordData<T>& a, const WelfordData<T>& b) {
+  const T n = a.n + b.n;
+  if (n == T(0)) {
+    return a;
+  }
+  const T delta = b.mean - a.mean;
+  const T ratio = b.n / n;
+  return {a.mean + delta * ratio, a.m2 + b.m2 + delta * delta * a.n * ratio, n};
+}
+
+template <typename T>
+__device__ __forceinline__ WelfordData<T> warpReduceWelford(WelfordData<T> val) {
+  for (int offset = WARP_SIZE / 2; offset > 0; offset /= 2) {
+    WelfordData<T> other = {
+        WARP_SHFL_DOWN(val.mean, offset),
+        WARP_SHFL_DOWN(val.m2, offset),
+        WARP_SHFL_DOWN(val.n, offset)};
+    val = welfordCombine(val, other);
+  }
+  return val;
+}
+
+template <typename T>
+__device__ __forceinline__ T warpReduceSum(T val) {
+  for (int offset = WARP_SIZE / 2; offset > 0; offset /= 2) {
+    val += WARP_SHFL_DOWN(val, offset);
+  }
+  return val;
+}
+
+// The result is only valid in thread 0. smem holds one value per warp.
+template <typename T>
+__device__ __forceinline__ WelfordData<T> blockReduceWelford(
+    WelfordData<T> val, WelfordData<T>* smem) {
+  const int lane = threadIdx.x % WARP_SIZE;
+  const int warp = threadIdx.x / WARP_SIZE;
+  val = warpReduceWelford(val);
+  if (lane == 0) {
+    smem[warp] = val;
+  }
+  __syncthreads();
+  if (warp == 0) {
+    WelfordData<T> zero = {T(0), T(0), T(0)};
+    val = lane < blockDim.x / WARP_SIZE ? smem[lane] : zero;
+    val = warpReduceWelford(val);
+  }
+  return val;
+}
+
+template <typename T>
+__device__ __forceinline__ T blockReduceSum(T val, T* smem) {
+  const int lane = threadIdx.x % WARP_SIZE;
+  const int warp = threadIdx.x / WARP_SIZE;
+  val = warpReduceSum(val);
+  if (lane == 0) {
+    smem[warp] = val;
+  }
+  __syncthreads();
+  if (warp == 0) {
+    val = lane < blockDim.x / WARP_SIZE ? smem[lane] : T(0);
+    val = warpReduceSum(val);
+  }
+  return val;
+}
+
+// One block per row: the moments of the row are accumulated with Welford's
+// algorithm in a single read of X and reduced over the warps, then the row is
+// normalized and scaled while it is still in cache.
+template <typename scalar_t, typename accscalar_t>
+__global__ void layerNormForwardKernel(
+    int64_t N,
+    accscalar_t eps,
+    const scalar_t* X,
+    const scalar_t* gamma,
+    const scalar_t* beta,
+    scalar_t* mean,
+    scalar_t* rstd,
+    scalar_t* Y) {
+  __shared__ WelfordData<accscalar_t> smem[WARP_SIZE];
+  __shared__ accscalar_t row_mean;
+  __shared__ accscalar_t row_rstd;
+  const int64_t i = blockIdx.x;
+  const scalar_t* x = X + i * N;
+  scalar_t* y = Y + i * N;
+
+  WelfordData<accscalar_t> val = {accscalar_t(0), accscalar_t(0), accscalar_t(0)};
+  for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+    const accscalar_t v = static_cast<accscalar_t>(x[j]);
+    val.n += accscalar_t(1);
+    const accscalar_t delta = v - val.mean;
+    val.mean += delta / val.n;
+    val.m2 += delta * (v - val.mean);
+  }
+  val = blockReduceWelford(val, smem);
+  if (threadIdx.x == 0) {
+    const accscalar_t var = N > 0 ? val.m2 / N : accscalar_t(0);
+    row_mean = val.mean;
+    row_rstd = accscalar_t(1) / ::sqrt(var + eps);
+    mean[i] = static_cast<scalar_t>(row_mean);
+    rstd[i] = static_cast<scalar_t>(row_rstd);
+  }
+  __syncthreads();
+
+  for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+    accscalar_t v = (static_cast<accscalar_t>(x[j]) - row_mean) * row_rstd;
+    if (gamma != nullptr) {
+      v *= static_cast<accscalar_t>(gamma[j]);
+    }
+    if (beta != nullptr) {
+      v += static_cast<accscalar_t>(beta[j]);
+    }
+    y[j] = static_cast<scalar_t>(v);
+  }
+}
+
+// One block per row. With g = dY * gamma and x_hat = (X - mean) * rstd,
+//   dX = rstd * (g - mean(g) - x_hat * mean(g * x_hat))
+// where the row means come from ds = sum(g * X) and db = sum(g).
+template <typename scalar_t, typename accscalar_t>
+__global__ void layerNormBackwardKernel(
+    int64_t N,
+    const scalar_t* dY,
+    const scalar_t* X,
+    const scalar_t* mean,
+    const scalar_t* rstd,
+    const scalar_t* gamma,
+    scalar_t* dX) {
+  __shared__ accscalar_t ds_smem[WARP_SIZE];
+  __shared__ accscalar_t db_smem[WARP_SIZE];
+  __shared__ accscalar_t row_b;
+  __shared__ accscalar_t row_c;
+  const int64_t i = blockIdx.x;
+  const scalar_t* x = X + i * N;
+  const scalar_t* dy = dY + i * N;
+  scalar_t* dx = dX + i * N;
+
+  accscalar_t ds = 0;
+  accscalar_t db = 0;
+  for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+    accscalar_t g = static_cast<accscalar_t>(dy[j]);
+    if (gamma != nullptr) {
+      g *= static_cast<accscalar_t>(gamma[j]);
+    }
+    ds += g * static_cast<accscalar_t>(x[j]);
+    db += g;
+  }
+  ds = blockReduceSum(ds, ds_smem);
+  db = blockReduceSum(db, db_smem);
+  const accscalar_t a = static_cast<accscalar_t>(rstd[i]);
+  if (threadIdx.x == 0) {
+    // dX = a * g + b * X + c
+    const accscalar_t u = static_cast<accscalar_t>(mean[i]);
+    const accscalar_t scale = accscalar_t(1) / N;
+    row_b = (db * u - ds) * a * a * a * scale;
+    row_c = -row_b * u - db * a * scale;
+  }
+  __syncthreads();
+
+  for (int64_t j = threadIdx.x; j < N; j += blockDim.x) {
+    accscalar_t g = static_cast<accscalar_t>(dy[j]);
+    if (gamma != nullptr) {
+      g *= static_cast<accscalar_t>(gamma[j]);
+    }
+    dx[j] = static_cast<scalar_t>(a * g + row_b * static_cast<accscalar_t>(x[j]) + row_c);
+  }
+}
+
+// dgamma = sum(dY * x_hat) and dbeta = sum(dY) over the M rows, one thread
+// per column so that the reads of each row are coalesced.
+template <typename scalar_t, typename accscalar_t>
+__global__ void layerNormBackwardAffineKernel(
+    int64_t M,
+    int64_t N,
+    const scalar_t* dY,
+    const scalar_t* X,
+    const scalar_t* mean,
+    const scalar_t* rstd,
+    scalar_t* dgamma,
+    scalar_t* dbeta) {
+  const int64_t j = blockIdx.x * blockDim.x + threadIdx.x;
+  if (j >= N) {
+    return;
+  }
+  accscalar_t sum_gamma = 0;
+  accscalar_t sum_beta = 0;
+  for (int64_t i = 0; i < M; i++) {
+    const accscalar_t g = static_cast<accscalar_t>(dY[i * N + j]);
+    const accscalar_t x_hat =
+        (static_cast<accscalar_t>(X[i * N + j]) - static_cast<accscalar_t>(mean[i])) *
+        static_cast<accscalar_t>(rstd[i]);
+    sum_gamma += g * x_hat;
+    sum_beta += g;
+  }
+  if (dgamma != nullptr) {
+    dgamma[j] = static_cast<scalar_t>(sum_gamma);
+  }
+  if (dbeta != nullptr) {
+    dbeta[j] = static_cast<scalar_t>(sum_beta);
+  }
+}
+
+template <typename scalar_t>
+const scalar_t* dataOrNull(const Tensor& t) {
+  return t.defined() ? t.data<scalar_t>() : nullptr;
+}
+
+template <typename scalar_t>
+scalar_t* mutableDataOrNull(Tensor& t) {
+  return t.defined() ? t.data<scalar_t>() : nullptr;
+}
+
+} // namespace
+
+std::tuple<Tensor, Tensor, Tensor> layer_norm_forward_cuda(
+    const Tensor& input, const Tensor& weight, const Tensor& bias,
+    int64_t M, int64_t N, double eps) {
+  auto X = input.contiguous();
+  auto gamma = weight.defined() ? weight.contiguous() : weight;
+  auto beta = bias.defined() ? bias.contiguous() : bias;
+  Tensor Y = at::empty_like(X);
+  Tensor mean = at::empty({M}, X.type());
+  Tensor rstd = at::empty({M}, X.type());
+  if (M == 0) {
+    return std::make_tuple(Y, mean, rstd);
+  }
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(X.type(), "layer_norm_forward_cuda", [&] {
+    using accscalar_t = acc_type<scalar_t, true>;
+    layerNormForwardKernel<scalar_t, accscalar_t>
+      <<<M, LAYER_NORM_THREADS, 0, stream>>>(
+        N, static_cast<accscalar_t>(eps), X.data<scalar_t>(),
+        dataOrNull<scalar_t>(gamma), dataOrNull<scalar_t>(beta),
+        mean.data<scalar_t>(), rstd.data<scalar_t>(), Y.data<scalar_t>());
+  });
+  THCudaCheck(cudaGetLastError());
+  return std::make_tuple(Y, mean, rstd);
+}
+
+std::tuple<Tensor, Tensor, Tensor> layer_norm_backward_cuda(
+    const Tensor& grad_out, const Tensor& input, const Tensor& mean_, const Tensor& rstd_,
+    const Tensor& weight, int64_t M, int64_t N, std::array<bool,3> output_mask) {
+  auto dY = grad_out.contiguous();
+  auto X = input.contiguous();
+  auto mean = mean_.contiguous();
+  auto rstd = rstd_.contiguous();
+  auto gamma = weight.defined() ? weight.contiguous() : weight;
+  Tensor dX, dgamma, dbeta;
+  if (output_mask[0]) {
+    dX = at::empty_like(X);
+  }
+  if (output_mask[1]) {
+    dgamma = at::zeros({N}, X.type());
+  }
+  if (output_mask[2]) {
+    dbeta = at::zeros({N}, X.type());
+  }
+  if (M == 0 || N == 0) {
+    return std::make_tuple(dX, dgamma, dbeta);
+  }
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(X.type(), "layer_norm_backward_cuda", [&] {
+    using accscalar_t = acc_type<scalar_t, true>;
+    if (dX.defined()) {
+      layerNormBackwardKernel<scalar_t, accscalar_t>
+        <<<M, LAYER_NORM_THREADS, 0, stream>>>(
+          N, dY.data<scalar_t>(), X.data<scalar_t>(), mean.data<scalar_t>(),
+          rstd.data<scalar_t>(), dataOrNull<scalar_t>(gamma), dX.data<scalar_t>());
+    }
+    if (dgamma.defined() || dbeta.defined()) {
+      layerNormBackwardAffineKernel<scalar_t, accscalar_t>
+        <<<THCCeilDiv(N, (int64_t)LAYER_NORM_THREADS), LAYER_NORM_THREADS, 0, stream>>>(
+          M, N, dY.data<scalar_t>(), X.data<scalar_t>(), mean.data<scalar_t>(),
+          rstd.data<scalar_t>(), mutableDataOrNull<scalar_t>(dgamma),
+          mutableDataOrNull<scalar_t>(dbeta));
+    }
+  });
+  THCudaCheck(cudaGetLastError());
+  return std::make_tuple(dX, dgamma, dbeta);
+}
+
+} // namespace native
+} // namespace at
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ATen/ATen.h"
+
+#include <THC/THCGeneral.h>
+
+#include <array>
+#include <vector>
+
+// Runs a functor over several lists of tensors in as few kernel launches as
+// possible. Every tensor is cut into chunks of kMultiTensorChunkSize
+// elements and each block of a launch processes one (tensor, chunk) pair;
+// the addresses of the tensors travel in the kernel arguments, so a single
+// launch can cover many small parameters. Kernel arguments are limited to
+// 4KB, which bounds how many tensors and blocks a launch can describe.
+
+namespace at { namespace native {
+
+constexpr int kMultiTensorChunkSize = 65536;
+constexpr int kMultiTensorBlockSize = 512;
+constexpr int kMultiTensorMaxBlocks = 320;
+
+// Indexed by the number of lists minus one.
+constexpr int kMultiTensorMaxTensors[5] = {96, 64, 48, 36, 30};
+
+template <int depth>
+struct TensorListMetadata {
+  void* addresses[depth][kMultiTensorMaxTensors[depth - 1]];
+  int64_t sizes[kMultiTensorMaxTensors[depth - 1]];
+  // One per-tensor value, e.g. the bias-corrected step size of Adam.
+  double scalars[kMultiTensorMaxTensors[depth - 1]];
+  unsigned char block_to_tensor[kMultiTensorMaxBlocks];
+  int block_to_chunk[kMultiTensorMaxBlocks];
+};
+
+// Every block calls f(offset, n, pointers, scalar) for its chunk: elements
+// [offset, offset + n) of the tensors whose data `pointers` holds, one per
+// list, and the tensor's entry of `scalars`.
+template <int depth, typename Functor>
+__global__ void multi_tensor_apply_kernel(
+    TensorListMetadata<depth> meta, Functor f) {
+  const int tensor = meta.block_to_tensor[blockIdx.x];
+  const int64_t offset =
+      static_cast<int64_t>(meta.block_to_chunk[blockIdx.x]) * kMultiTensorChunkSize;
+  const int64_t remaining = meta.sizes[tensor] - offset;
+  const int n = remaining < kMultiTensorChunkSize
+      ? static_cast<int>(remaining) : kMultiTensorChunkSize;
+  void* pointers[depth];
+#pragma unroll
+  for (int d = 0; d < depth; ++d) {
+    pointers[d] = meta.addresses[d][tensor];
+  }
+  f(offset, n, pointers, meta.scalars[tensor]);
+}
+
+// `lists` are equally long lists of contiguous tensors of one type on the
+// current device, with lists[d][t].numel() the same for every d. `scalars`
+// holds one value per tensor, or nothing.
+template <int depth, typename Functor>
+void multi_tensor_apply(
+    const std::array<std::vector<Tensor>, depth>& lists,
+    const std::vector<double>& scalars,
+    const Functor& f) {
+  constexpr int max_tensors = kMultiTensorMaxTensors[depth - 1];
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  TensorListMetadata<depth> meta;
+  int loaded_tensors = 0;
+  int loaded_blocks = 0;
+  auto launch = [&] {
+    multi_tensor_apply_kernel<depth, Functor>
+        <<<loaded_blocks, kMultiTensorBlockSize, 0, stream>>>(meta, f);
+    THCudaCheck(cudaGetLastError());
+    loaded_blocks = 0;
+  };
+  for (size_t t = 0; t < lists[0].size(); ++t) {
+    const int64_t numel = lists[0][t].numel();
+    if (numel == 0) {
+      continue;
+    }
+    for (int d = 0; d < depth; ++d) {
+      meta.addresses[d][loaded_tensors] = lists[d][t].data_ptr();
+    }
+    meta.sizes[loaded_tensors] = numel;
+    meta.scalars[loaded_tensors] = scalars.empty() ? 0 : scalars[t];
+    ++loaded_tensors;
+    const int64_t chunks =
+        (numel + kMultiTensorChunkSize - 1) / kMultiTensorChunkSize;
+    for (int64_t chunk = 0; chunk < chunks; ++chunk) {
+      meta.block_to_tensor[loaded_blocks] = loaded_tensors - 1;
+      meta.block_to_chunk[loaded_blocks] = static_cast<int>(chunk);
+      ++loaded_blocks;
+      const bool last_chunk = chunk == chunks - 1;
+      if (loaded_blocks == kMultiTensorMaxBlocks ||
+          (loaded_tensors == max_tensors && last_chunk)) {
+        launch();
+        if (last_chunk) {
+          loaded_tensors = 0;
+        } else {
+          // The rest of the current tensor goes into the next launch.
+          for (int d = 0; d < depth; ++d) {
+            meta.addresses[d][0] = meta.addresses[d][loaded_tensors - 1];
+          }
+          meta.sizes[0] = meta.sizes[loaded_tensors - 1];
+          meta.scalars[0] = meta.scalars[loaded_tensors - 1];
+          loaded_tensors = 1;
+        }
+      }
+    }
+  }
+  if (loaded_blocks > 0) {
+    launch();
+  }
+}
+
+}} // namespace at::native
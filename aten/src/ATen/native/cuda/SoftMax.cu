@@ -468,6 +468,75 @@ cunn_SoftMaxBackward(scalar_t *gradInput, scalar_t *output, scalar_t *gradOutput
     gradInput[offset] = epilogue(gradOutput[offset], output[offset]);
 }
 
+// log_softmax followed by nll_loss, one block per row. Only the logsumexp of
+// the row is written, the backward recomputes the softmax from it.
+template <int ILP, typename scalar_t, typename accscalar_t>
+__global__ void
+cunn_CrossEntropyForward(scalar_t *loss, scalar_t *logsumexp, scalar_t *input,
+                         int64_t *target, int classes, int64_t ignore_index)
+{
+  extern __shared__ unsigned char smem[];
+  auto sdata = reinterpret_cast<accscalar_t*>(smem);
+  input += blockIdx.x * classes;
+
+  accscalar_t threadMax = ilpReduce<MaxFloat, ILP, scalar_t, accscalar_t>(
+      input, classes, MaxFloat<scalar_t, accscalar_t>(), -THCNumerics<accscalar_t>::max());
+  accscalar_t max_k = blockReduce<Max, accscalar_t>(
+      sdata, threadMax, Max<accscalar_t>(), -THCNumerics<accscalar_t>::max());
+
+  accscalar_t threadExp = ilpReduce<SumExpFloat, ILP, scalar_t, accscalar_t>(
+      input, classes, SumExpFloat<scalar_t, accscalar_t>(max_k), static_cast<accscalar_t>(0));
+  accscalar_t sumAll = blockReduce<Add, accscalar_t>(
+      sdata, threadExp, Add<accscalar_t>(), static_cast<accscalar_t>(0));
+
+  if (threadIdx.x == 0) {
+    accscalar_t lse = max_k + std::log(sumAll);
+    int64_t t = target[blockIdx.x];
+    logsumexp[blockIdx.x] = static_cast<scalar_t>(lse);
+    if (t == ignore_index) {
+      loss[blockIdx.x] = static_cast<scalar_t>(0);
+    } else {
+      assert(t >= 0 && t < classes);
+      loss[blockIdx.x] = static_cast<scalar_t>(lse - static_cast<accscalar_t>(input[t]));
+    }
+  }
+}
+
+template <int ILP, typename scalar_t, typename accscalar_t>
+__global__ void
+cunn_CrossEntropyBackward(scalar_t *gradInput, scalar_t *scale, scalar_t *input,
+                          int64_t *target, scalar_t *logsumexp, int classes,
+                          int64_t ignore_index)
+{
+  gradInput += blockIdx.x * classes;
+  input += blockIdx.x * classes;
+  const accscalar_t s = static_cast<accscalar_t>(scale[blockIdx.x]);
+  const accscalar_t lse = static_cast<accscalar_t>(logsumexp[blockIdx.x]);
+  const int64_t t = target[blockIdx.x];
+
+  int offset = threadIdx.x;
+  int last = classes % (ILP * blockDim.x);
+  for (; offset < classes - last; offset += blockDim.x * ILP) {
+    scalar_t tmp[ILP];
+
+#pragma unroll
+    for (int j = 0; j < ILP; ++j)
+      tmp[j] = input[offset + j * blockDim.x];
+
+#pragma unroll
+    for (int j = 0; j < ILP; ++j) {
+      int k = offset + j * blockDim.x;
+      accscalar_t g = std::exp(static_cast<accscalar_t>(tmp[j]) - lse) * s;
+      gradInput[k] = static_cast<scalar_t>(k == t ? g - s : g);
+    }
+  }
+
+  for (; offset < classes; offset += blockDim.x) {
+    accscalar_t g = std::exp(static_cast<accscalar_t>(input[offset]) - lse) * s;
+    gradInput[offset] = static_cast<scalar_t>(offset == t ? g - s : g);
+  }
+}
+
 
 
 
@@ -574,6 +643,59 @@ Tensor host_softmax_backward(const Tensor &grad_, const Tensor &output_, int64_t
 }
 }
 
+std::tuple<Tensor, Tensor> cross_entropy_lastdim_cuda(const Tensor &input_, const Tensor &target_, int64_t ignore_index){
+  auto input = input_.contiguous();
+  auto target = target_.contiguous();
+  int64_t outer_size = input.size(0);
+  int64_t dim_size = input.size(1);
+  Tensor loss = at::empty({outer_size}, input.type());
+  Tensor logsumexp = at::empty({outer_size}, input.type());
+  if (outer_size == 0) {
+    return std::make_tuple(loss, logsumexp);
+  }
+  AT_CHECK(dim_size > 0, "cross_entropy: expected at least one class");
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  const int ILP = 2;
+  dim3 grid(outer_size);
+  dim3 block = SoftMax_getBlockSize(ILP, dim_size);
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(input.type(), "cross_entropy_lastdim", [&] {
+  using accscalar_t = acc_type<scalar_t, true>;
+  cunn_CrossEntropyForward<ILP, scalar_t, accscalar_t>
+    <<<grid, block, block.x * sizeof(accscalar_t), stream>>>(
+      loss.data<scalar_t>(), logsumexp.data<scalar_t>(), input.data<scalar_t>(),
+      target.data<int64_t>(), dim_size, ignore_index
+  );
+  });
+  THCudaCheck(cudaGetLastError());
+  return std::make_tuple(loss, logsumexp);
+}
+
+Tensor cross_entropy_lastdim_backward_cuda(const Tensor &scale_, const Tensor &input_, const Tensor &target_, const Tensor &logsumexp_, int64_t ignore_index){
+  auto scale = scale_.contiguous();
+  auto input = input_.contiguous();
+  auto target = target_.contiguous();
+  auto logsumexp = logsumexp_.contiguous();
+  Tensor gI = at::empty_like(input);
+  if (input.numel() == 0) {
+    return gI;
+  }
+  cudaStream_t stream = globalContext().getCurrentCUDAStream();
+  const int ILP = 2;
+  int64_t dim_size = input.size(1);
+  dim3 grid(input.size(0));
+  dim3 block = SoftMax_getBlockSize(ILP, dim_size);
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(input.type(), "cross_entropy_lastdim_backward", [&] {
+  using accscalar_t = acc_type<scalar_t, true>;
+  cunn_CrossEntropyBackward<ILP, scalar_t, accscalar_t>
+    <<<grid, block, 0, stream>>>(
+      gI.data<scalar_t>(), scale.data<scalar_t>(), input.data<scalar_t>(),
+      target.data<int64_t>(), logsumexp.data<scalar_t>(), dim_size, ignore_index
+  );
+  });
+  THCudaCheck(cudaGetLastError());
+  return gI;
+}
+
 Tensor log_softmax_cuda(const Tensor &input, const int64_t dim){
   return host_softmax<LogSoftMaxForwardEpilogue>(input, dim);
 }
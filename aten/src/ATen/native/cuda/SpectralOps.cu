@@ -14,6 +14,9 @@
 #include <cufft.h>
 #include <cufftXt.h>
 #include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace at { namespace native {
 
@@ -215,29 +218,62 @@ static inline Tensor _run_cufft(
   return output;
 }
 
-// The cuFFT plan cache, defined in CuFFTUtils.h
-struct CuFFTParamsLRUCache plan_cache;
-std::mutex plan_cache_mutex;
+// The cuFFT plan caches, defined in CuFFTPlanCache.h, one per device. They
+// are created on first use and never destroyed, so references to them stay
+// valid.
+std::vector<std::unique_ptr<CuFFTParamsLRUCache>> plan_caches;
+std::mutex plan_caches_mutex;
+
+static inline CuFFTParamsLRUCache &cufft_get_plan_cache(int64_t device_index) {
+  std::lock_guard<std::mutex> guard(plan_caches_mutex);
+
+  AT_CHECK(device_index >= 0 && device_index < globalContext().getNumGPUs(),
+           "cuFFT plan cache: invalid device index ", device_index,
+           ", expected a value in [0, ", globalContext().getNumGPUs(), ")");
+  if (device_index >= static_cast<int64_t>(plan_caches.size())) {
+    plan_caches.resize(device_index + 1);
+  }
+  if (!plan_caches[device_index]) {
+    plan_caches[device_index].reset(new CuFFTParamsLRUCache());
+  }
+  return *plan_caches[device_index];
+}
 
 namespace detail {
 
-int64_t cufft_get_plan_cache_max_size_impl() {
-  std::lock_guard<std::mutex> guard(plan_cache_mutex);
+int64_t cufft_get_plan_cache_max_size_impl(int64_t device_index) {
+  auto& plan_cache = cufft_get_plan_cache(device_index);
+  std::lock_guard<std::mutex> guard(plan_cache.mutex);
   return plan_cache.max_size();
 }
 
-void cufft_set_plan_cache_max_size_impl(int64_t max_size) {
-  std::lock_guard<std::mutex> guard(plan_cache_mutex);
+void cufft_set_plan_cache_max_size_impl(int64_t device_index, int64_t max_size) {
+  auto& plan_cache = cufft_get_plan_cache(device_index);
+  std::lock_guard<std::mutex> guard(plan_cache.mutex);
   plan_cache.resize(max_size);
 }
 
-int64_t cufft_get_plan_cache_size_impl() {
-  std::lock_guard<std::mutex> guard(plan_cache_mutex);
+int64_t cufft_get_plan_cache_size_impl(int64_t device_index) {
+  auto& plan_cache = cufft_get_plan_cache(device_index);
+  std::lock_guard<std::mutex> guard(plan_cache.mutex);
   return plan_cache.size();
 }
 
-void cufft_clear_plan_cache_impl() {
-  std::lock_guard<std::mutex> guard(plan_cache_mutex);
+int64_t cufft_get_plan_cache_hits_impl(int64_t device_index) {
+  auto& plan_cache = cufft_get_plan_cache(device_index);
+  std::lock_guard<std::mutex> guard(plan_cache.mutex);
+  return plan_cache.hits();
+}
+
+int64_t cufft_get_plan_cache_misses_impl(int64_t device_index) {
+  auto& plan_cache = cufft_get_plan_cache(device_index);
+  std::lock_guard<std::mutex> guard(plan_cache.mutex);
+  return plan_cache.misses();
+}
+
+void cufft_clear_plan_cache_impl(int64_t device_index) {
+  auto& plan_cache = cufft_get_plan_cache(device_index);
+  std::lock_guard<std::mutex> guard(plan_cache.mutex);
   return plan_cache.clear();
 }
 
@@ -283,13 +319,17 @@ Tensor _fft_cufft(const Tensor& self, int64_t signal_ndim,
   // e.g., irfft, is difficult as we have a long call sequence looking like
   //   irfft --> _fft --> _fft_with_size --dispatching-to-> _fft_cufft
 
+  // Plans are created on, and can only run on, the device of the input, so
+  // each device has its own cache.
+  CuFFTParamsLRUCache &plan_cache = cufft_get_plan_cache(input.get_device());
+
   // This read is not locked for perf reason. Shouldn't matter too much because
   // we check again after acquiring the lock.
   if (plan_cache.max_size() > 0) {
     CuFFTParams params;
     setCuFFTParams(&params, input, signal_ndim, complex_input,
       complex_output, checked_signal_sizes, onesided);
-    std::lock_guard<std::mutex> guard(plan_cache_mutex);
+    std::lock_guard<std::mutex> guard(plan_cache.mutex);
     if (plan_cache.max_size() > 0) {  // check again after acquiring the lock
       const CuFFTConfig &config = plan_cache.try_emplace_value(std::move(params),
                                              input, signal_ndim, complex_input,
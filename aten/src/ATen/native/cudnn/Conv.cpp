@@ -85,12 +85,15 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> cudnn_convolution_transpose_backwar
 #include <ATen/TensorUtils.h>
 
 #include <functional>
+#include <fstream>
 #include <iterator>
 #include <sstream>
 #include <algorithm>
 #include <memory>
 #include <mutex>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string>
 #include <unordered_map>
 
 namespace at { namespace native {
@@ -345,6 +348,103 @@ BenchmarkCache<cudnnConvolutionFwdAlgo_t> fwd_algos;
 BenchmarkCache<cudnnConvolutionBwdDataAlgo_t> bwd_data_algos;
 BenchmarkCache<cudnnConvolutionBwdFilterAlgo_t> bwd_filter_algos;
 
+// Benchmark results that outlive the process.  If the environment variable
+// ATEN_CUDNN_ALGORITHMS_CACHE_FILE is set, the algorithms found by
+// benchmarking are appended to that file, and later processes look them up
+// there instead of benchmarking again.  The keys describe the convolution and
+// the cuDNN version and GPU the algorithm was found on, so one file can be
+// shared by different machines.  Each line is "<key> <algorithm> <time>", the
+// format of caffe2's --caffe2_cudnn_algorithms_cache_file, so both can use the
+// same file.
+struct PersistentBenchmarkCache {
+  std::mutex mutex;
+  bool loaded = false;
+  std::string path;
+  std::unordered_map<std::string, int> map;
+
+  bool enabled() {
+    std::lock_guard<std::mutex> guard(mutex);
+    load();
+    return !path.empty();
+  }
+
+  bool find(const std::string& key, int* algo) {
+    std::lock_guard<std::mutex> guard(mutex);
+    load();
+    auto it = map.find(key);
+    if (it == map.end()) {
+      return false;
+    }
+    *algo = it->second;
+    return true;
+  }
+
+  void insert(const std::string& key, int algo, float time) {
+    std::lock_guard<std::mutex> guard(mutex);
+    load();
+    map[key] = algo;
+    if (!path.empty()) {
+      std::ofstream file(path, std::ios::app);
+      file << key << " " << algo << " " << time << "\n";
+    }
+  }
+
+ private:
+  // Must be called with the mutex held.
+  void load() {
+    if (loaded) {
+      return;
+    }
+    loaded = true;
+    const char* env = getenv("ATEN_CUDNN_ALGORITHMS_CACHE_FILE");
+    if (!env || !*env) {
+      return;
+    }
+    path = env;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+      // The key is everything up to the last two fields.
+      auto time_pos = line.find_last_of(' ');
+      if (time_pos == std::string::npos || time_pos == 0) continue;
+      auto algo_pos = line.find_last_of(' ', time_pos - 1);
+      if (algo_pos == std::string::npos) continue;
+      try {
+        map[line.substr(0, algo_pos)] =
+            std::stoi(line.substr(algo_pos + 1, time_pos - algo_pos - 1));
+      } catch (const std::exception&) {
+        // skip malformed lines
+      }
+    }
+  }
+};
+
+PersistentBenchmarkCache persistent_algos;
+
+std::string persistentKey(const char* kind, const ConvolutionParams& params) {
+  cudaDeviceProp* prop = globalContext().getCurrentDeviceProperties();
+  std::string name(prop->name);
+  std::replace(name.begin(), name.end(), ' ', '_');
+  std::ostringstream key;
+  key << "aten cudnn" << cudnnGetVersion() << " " << name
+      << " sm" << prop->major << prop->minor << " conv_" << kind
+      << " type" << static_cast<int>(params.dataType);
+  auto add_array = [&](const char* field, const int* values, int n) {
+    key << " " << field;
+    for (int i = 0; i < n; i++) {
+      key << "," << values[i];
+    }
+  };
+  add_array("input", params.input_size, 2 + max_dim);
+  add_array("input_stride", params.input_stride, 2 + max_dim);
+  add_array("weight", params.weight_size, 2 + max_dim);
+  add_array("padding", params.padding, max_dim);
+  add_array("stride", params.stride, max_dim);
+  add_array("dilation", params.dilation, max_dim);
+  key << " groups" << params.groups << " deterministic" << params.deterministic;
+  return key.str();
+}
+
 // TODO: Stop manually allocating CUDA memory; allocate an ATen byte
 // tensor instead.
 struct Workspace {
@@ -459,6 +559,7 @@ struct algorithm_search<cudnnConvolutionFwdAlgo_t> {
 
   static constexpr auto DEFAULT_ALGO = CUDNN_CONVOLUTION_FWD_ALGO_IMPLICIT_PRECOMP_GEMM;
   static BenchmarkCache<algo_t>& cache() { return fwd_algos; }
+  static const char* name() { return "fwd"; }
 
   static perf_t findAlgorithm(const ConvolutionArgs& args) {
     static const algo_t algos[] = {
@@ -530,6 +631,7 @@ struct algorithm_search<cudnnConvolutionBwdDataAlgo_t> {
 
   static constexpr auto DEFAULT_ALGO = CUDNN_CONVOLUTION_BWD_DATA_ALGO_1;
   static BenchmarkCache<algo_t>& cache() { return bwd_data_algos; }
+  static const char* name() { return "bwd_data"; }
 
   static perf_t findAlgorithm(const ConvolutionArgs& args) {
     static const algo_t algos[] = {
@@ -596,6 +698,7 @@ struct algorithm_search<cudnnConvolutionBwdFilterAlgo_t> {
   static constexpr auto DEFAULT_ALGO = CUDNN_CONVOLUTION_BWD_FILTER_ALGO_1;
 
   static BenchmarkCache<algo_t>& cache() { return bwd_filter_algos; }
+  static const char* name() { return "bwd_filter"; }
 
   static perf_t findAlgorithm(const ConvolutionArgs& args) {
     static const algo_t algos[] = {
@@ -681,6 +784,17 @@ void findAlgorithm(const ConvolutionArgs& args, bool benchmark, algo_t* algo) {
     return;
   }
 
+  std::string key;
+  if (persistent_algos.enabled()) {
+    key = persistentKey(search::name(), args.params);
+    int persistent_algo;
+    if (persistent_algos.find(key, &persistent_algo)) {
+      *algo = static_cast<algo_t>(persistent_algo);
+      cache.insert(args.params, *algo);
+      return;
+    }
+  }
+
   auto perfResults = search::findAlgorithm(args);
   // for deterministic algo, look at all the perf results and return the best
   // deterministic algo
@@ -691,6 +805,9 @@ void findAlgorithm(const ConvolutionArgs& args, bool benchmark, algo_t* algo) {
       *algo = search::DEFAULT_ALGO;
   }
   cache.insert(args.params, *algo);
+  if (!key.empty()) {
+    persistent_algos.insert(key, static_cast<int>(*algo), perfResults.time);
+  }
 
   // Free the cached blocks in our caching allocator. They are
   // needed here because the above benchmarking uses a huge amount of memory,
@@ -60,6 +60,10 @@ Tensor _cudnn_init_dropout_state(const Type& ty, double dropout, bool train, int
 #include <ATen/cudnn/Types.h>
 #include <ATen/cudnn/Utils.h>
 
+#include <cstring>
+#include <map>
+#include <memory>
+
 namespace at { namespace native {
 
 namespace {
@@ -347,6 +351,58 @@ namespace {
     }
   };
 
+  // Building RNNDescriptors costs a handful of cuDNN calls per time step,
+  // which adds up for long sequences and is repeated by every forward and
+  // backward call.  The descriptors only depend on the values below, so we
+  // cache them per thread, keyed by all of them.  The dropout descriptor
+  // keeps its state tensor alive, so the cache is bounded.
+  constexpr size_t kMaxCachedRNNDescriptors = 64;
+
+  void append_geometry(std::vector<int64_t>& key, const Tensor& t) {
+    key.push_back(t.defined() ? t.dim() : -1);
+    if (t.defined()) {
+      key.insert(key.end(), t.sizes().begin(), t.sizes().end());
+      key.insert(key.end(), t.strides().begin(), t.strides().end());
+    }
+  }
+
+  std::shared_ptr<RNNDescriptors> get_rnn_descriptors(
+      const RNNParams& fn, cudnnHandle_t handle,
+      const Tensor& x, const Tensor& y, const Tensor& hx, const Tensor& cx) {
+    static thread_local std::map<std::vector<int64_t>, std::shared_ptr<RNNDescriptors>> cache;
+
+    const bool uses_dropout = fn.dropout.train && fn.dropout.dropout != 0;
+    int64_t dropout_bits = 0;
+    static_assert(sizeof(dropout_bits) == sizeof(fn.dropout.dropout), "double is not 64 bits");
+    std::memcpy(&dropout_bits, &fn.dropout.dropout, sizeof(dropout_bits));
+
+    std::vector<int64_t> key = {
+      reinterpret_cast<int64_t>(handle),
+      fn.rnn.hidden_size, fn.rnn.num_layers, fn.rnn.bidirectional,
+      fn.rnn.mode, fn.rnn.datatype, fn.rnn.input_mode,
+      uses_dropout ? dropout_bits : 0,
+      uses_dropout ? reinterpret_cast<int64_t>(fn.dropout.dropout_state.data_ptr()) : 0,
+      fn.tensors.seq_length, fn.tensors.mini_batch, fn.tensors.input_size,
+      static_cast<int64_t>(fn.tensors.batch_sizes.size()),
+    };
+    key.insert(key.end(), fn.tensors.batch_sizes.begin(), fn.tensors.batch_sizes.end());
+    append_geometry(key, x);
+    append_geometry(key, y);
+    append_geometry(key, hx);
+    append_geometry(key, cx);
+
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+      return it->second;
+    }
+    if (cache.size() >= kMaxCachedRNNDescriptors) {
+      cache.clear();
+    }
+    auto descs = std::make_shared<RNNDescriptors>(fn, handle, x, y, hx, cx);
+    cache.emplace(std::move(key), descs);
+    return descs;
+  }
+
   int64_t get_num_weights(cudnnHandle_t handle, const RNNDescriptor& rnn_desc,
                           const TensorDescriptor& x_desc, cudnnDataType_t datatype) {
     size_t weight_size;
@@ -633,7 +689,8 @@ std::tuple<Tensor, Tensor, Tensor, Tensor, Tensor> _cudnn_rnn(
   auto y = output;
 
   auto handle = getCudnnHandle();
-  RNNDescriptors descs(fn, handle, x, y, hx, cx);
+  auto cached_descs = get_rnn_descriptors(fn, handle, x, y, hx, cx);
+  auto& descs = *cached_descs;
 
   FilterDescriptor w_desc;
   if (!weight_buf.defined()) {
@@ -815,7 +872,8 @@ std::tuple<Tensor, Tensor, Tensor> _cudnn_rnn_backward_input(
     throw std::runtime_error("Gradients aren't CUDA tensors");
   }
 
-  RNNDescriptors descs(fn, handle, x, y, hx, cx);
+  auto cached_descs = get_rnn_descriptors(fn, handle, x, y, hx, cx);
+  auto& descs = *cached_descs;
 
   FilterDescriptor w_desc;
   w_desc.set(weight_buf, 3);
@@ -925,7 +983,8 @@ std::vector<Tensor> _cudnn_rnn_backward_weight(
   const auto& y = output;
   auto dw = weight_buf.type().tensor(weight_buf.sizes()).zero_();
 
-  RNNDescriptors descs(fn, handle, x, y, hx, cx);
+  auto cached_descs = get_rnn_descriptors(fn, handle, x, y, hx, cx);
+  auto& descs = *cached_descs;
 
   FilterDescriptor w_desc;
   w_desc.set(weight_buf, 3);
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "ATen/ATen.h"
+#include "ATen/Config.h"
+#include "ATen/native/utils/ParamsHash.h"
+
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <cmath>
+
+#include <mkl_dfti.h>
+#include <ATen/mkl/Exceptions.h>
+#include <ATen/mkl/Descriptors.h>
+
+namespace at { namespace native { namespace detail {
+
+constexpr int mkl_fft_max_rank = 3;
+
+// This POD struct is used to let us easily compute hashes of the
+// parameters.
+// It will be the **key** to the plan cache.
+//
+// Unlike cuFFT plans, DFTI descriptors hold the batch size, the strides, the
+// scale and the thread limit, so all of them are part of the key. The output
+// is always contiguous, and thus described by its sizes.
+struct MKLFFTParams
+{
+  at::ScalarType scalar_type_;
+  int64_t input_sizes_[mkl_fft_max_rank + 2];
+  int64_t input_strides_[mkl_fft_max_rank + 2];
+  int64_t output_sizes_[mkl_fft_max_rank + 2];
+  uint8_t signal_ndim_;  // between 1 and mkl_fft_max_rank
+  bool complex_input_;
+  bool complex_output_;
+  bool inverse_;
+  bool normalized_;
+  int64_t signal_sizes_[mkl_fft_max_rank];
+  int num_threads_;
+};
+
+// NB: This can't be a constructor, because then MKLFFTParams
+// would not be a POD anymore.
+static inline void setMKLFFTParams(MKLFFTParams* params,
+    const Tensor& input, int64_t signal_ndim, bool complex_input,
+    bool complex_output, bool inverse, IntList checked_signal_sizes,
+    bool normalized, IntList output_sizes, int num_threads) {
+
+  memset(params, 0, sizeof(MKLFFTParams));
+  params->scalar_type_ = input.type().scalarType();
+  for (int i = 0; i != input.dim(); ++i) {
+    params->input_sizes_[i] = input.size(i);
+    if (input.size(i) != 1) {
+      params->input_strides_[i] = input.stride(i);
+    }
+  }
+  for (size_t i = 0; i != output_sizes.size(); ++i) {
+    params->output_sizes_[i] = output_sizes[i];
+  }
+  params->signal_ndim_ = (uint8_t) signal_ndim;
+  params->complex_input_ = complex_input;
+  params->complex_output_ = complex_output;
+  params->inverse_ = inverse;
+  params->normalized_ = normalized;
+  for (size_t i = 0; i != checked_signal_sizes.size(); ++i) {
+    params->signal_sizes_[i] = checked_signal_sizes[i];
+  }
+  params->num_threads_ = num_threads;
+}
+
+// This class holds a committed DFTI descriptor that transforms the whole
+// batch of `input` into a contiguous tensor of sizes output_sizes, using up to
+// num_threads threads.
+//
+// This class will be the **value** in the plan cache.
+// It **owns** the raw descriptor via DftiDescriptor.
+class MKLFFTConfig {
+public:
+
+  // The descriptor must not be shared by accident, see CuFFTConfig.
+  MKLFFTConfig(const MKLFFTConfig&) = delete;
+  MKLFFTConfig& operator=(MKLFFTConfig const&) = delete;
+
+  explicit MKLFFTConfig(const Tensor& input, int64_t signal_ndim,
+    bool complex_input, bool complex_output, bool inverse,
+    IntList checked_signal_sizes, bool normalized, IntList output_sizes,
+    int num_threads) {
+
+    // precision
+    DFTI_CONFIG_VALUE prec;
+    if (input.type().scalarType() == ScalarType::Float) {
+      prec = DFTI_SINGLE;
+    } else if (input.type().scalarType() == ScalarType::Double) {
+      prec = DFTI_DOUBLE;
+    } else {
+      std::ostringstream ss;
+      ss << "MKL FFT doesn't support tensor of type: "
+         << at::toString(input.type().scalarType());
+      throw std::runtime_error(ss.str());
+    }
+    // signal type
+    DFTI_CONFIG_VALUE signal_type;
+    if (!inverse) {
+      signal_type = complex_input ? DFTI_COMPLEX : DFTI_REAL;
+    } else {
+      signal_type = complex_output ? DFTI_COMPLEX : DFTI_REAL;
+    }
+    // create descriptor with signal size
+    std::vector<MKL_LONG> mkl_signal_sizes(checked_signal_sizes.begin(), checked_signal_sizes.end());
+    descriptor_.init(prec, signal_type, signal_ndim, mkl_signal_sizes.data());
+    // out of place FFT
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_PLACEMENT, DFTI_NOT_INPLACE));
+    // batch mode, all signals are transformed by a single compute call
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_NUMBER_OF_TRANSFORMS,
+                                static_cast<MKL_LONG>(input.size(0))));
+    // MKL spreads the batch, or a single large signal, over this many threads
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_THREAD_LIMIT,
+                                static_cast<MKL_LONG>(num_threads)));
+
+    // the output is contiguous
+    std::vector<int64_t> ostrides(output_sizes.size());
+    int64_t onumel = 1;
+    for (int64_t i = output_sizes.size() - 1; i >= 0; i--) {
+      ostrides[i] = onumel;
+      onumel *= output_sizes[i];
+    }
+    auto istrides = input.strides();
+    // batch dim stride, i.e., dist between each data
+    MKL_LONG idist = complex_input ? istrides[0] >> 1 : istrides[0];
+    MKL_LONG odist = complex_output ? ostrides[0] >> 1 : ostrides[0];
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_INPUT_DISTANCE, idist));
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_OUTPUT_DISTANCE, odist));
+    // signal strides
+    // first val is offset, set to zero (ignored)
+    std::vector<MKL_LONG> mkl_istrides(1 + signal_ndim, 0), mkl_ostrides(1 + signal_ndim, 0);
+    for (int64_t i = 1; i <= signal_ndim; i++) {
+      mkl_istrides[i] = complex_input ? istrides[i] >> 1 : istrides[i];
+      mkl_ostrides[i] = complex_output ? ostrides[i] >> 1 : ostrides[i];
+    }
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_INPUT_STRIDES, mkl_istrides.data()));
+    MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_OUTPUT_STRIDES, mkl_ostrides.data()));
+    // if conjugate domain of real is involved, set standard CCE storage type
+    // this will become default in MKL in future
+    if (!complex_input || !complex_output) {
+      MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(), DFTI_CONJUGATE_EVEN_STORAGE, DFTI_COMPLEX_COMPLEX));
+    }
+    // rescale if needed by normalized flag or inverse transform
+    if (normalized || inverse) {
+      auto signal_numel = at::prod_intlist(checked_signal_sizes);
+      double double_scale;
+      if (normalized) {
+        double_scale = 1.0 / std::sqrt(static_cast<double>(signal_numel));
+      } else {
+        double_scale = 1.0 / static_cast<double>(signal_numel);
+      }
+      MKL_DFTI_CHECK(DftiSetValue(descriptor_.get(),
+        inverse ? DFTI_BACKWARD_SCALE : DFTI_FORWARD_SCALE,
+        prec == DFTI_DOUBLE ? double_scale : static_cast<float>(double_scale)));
+    }
+    // finalize
+    MKL_DFTI_CHECK(DftiCommitDescriptor(descriptor_.get()));
+  }
+
+  DFTI_DESCRIPTOR *descriptor() const { return descriptor_.get(); }
+
+private:
+  DftiDescriptor descriptor_;
+};
+
+// Committing a descriptor precomputes the twiddle factors of the signal
+// sizes, which costs about as much as a transform of a small batch. The
+// cache keeps at most this many of them.
+constexpr int64_t MKL_FFT_MAX_PLAN_NUM = 256;
+
+// This is an LRU cache of the descriptors, see CuFFTParamsLRUCache.
+class MKLFFTParamsLRUCache {
+public:
+  using kv_t = typename std::pair<MKLFFTParams, MKLFFTConfig>;
+  using map_t = typename std::unordered_map<std::reference_wrapper<MKLFFTParams>,
+                                            typename std::list<kv_t>::iterator,
+                                            ParamsHash<MKLFFTParams>,
+                                            ParamsEqual<MKLFFTParams>>;
+  using map_kkv_iter_t = typename map_t::iterator;
+
+  MKLFFTParamsLRUCache() : _max_size(MKL_FFT_MAX_PLAN_NUM) {}
+
+  // If key is in this cache, return the cached config. Otherwise, emplace the
+  // config in this cache using value_args and return it.
+  template<typename K, class ...VArgs>
+  const MKLFFTConfig &try_emplace_value(K&& key, VArgs&&... value_args) {
+    map_kkv_iter_t map_it = _cache_map.find(key);
+    // Hit, put to list front
+    if (map_it != _cache_map.end()) {
+      _usage_list.splice(_usage_list.begin(), _usage_list, map_it->second);
+      return map_it->second->second;
+    }
+
+    // Miss
+    // remove if needed
+    if (_usage_list.size() >= _max_size) {
+      auto last = _usage_list.end();
+      last--;
+      _cache_map.erase(last->first);
+      _usage_list.pop_back();
+    }
+
+    // construct new plan at list front, then insert into _cache_map
+    _usage_list.emplace_front(std::piecewise_construct,
+                       std::forward_as_tuple(key),
+                       std::forward_as_tuple(value_args...));
+    auto kv_it = _usage_list.begin();
+    _cache_map.emplace(std::piecewise_construct,
+                std::forward_as_tuple(kv_it->first),
+                std::forward_as_tuple(kv_it));
+    return kv_it->second;
+  }
+
+  size_t size() const { return _cache_map.size(); }
+
+  size_t max_size() const noexcept { return _max_size; }
+
+  std::mutex mutex;
+
+private:
+  std::list<kv_t> _usage_list;
+  map_t _cache_map;
+  size_t _max_size;
+};
+
+}}} // namespace at::native::detail
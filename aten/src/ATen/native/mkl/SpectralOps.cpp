@@ -24,6 +24,7 @@ Tensor _fft_mkl(const Tensor& input, int64_t signal_ndim,
 #include "ATen/Dispatch.h"
 #include "ATen/Utils.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/Parallel.h"
 
 #include <algorithm>
 #include <vector>
@@ -34,10 +35,7 @@ Tensor _fft_mkl(const Tensor& input, int64_t signal_ndim,
 #include <ATen/mkl/Exceptions.h>
 #include <ATen/mkl/Descriptors.h>
 #include <ATen/mkl/Limits.h>
-
-#ifdef _OPENMP
-#include <omp.h>
-#endif
+#include <ATen/native/mkl/MKLFFTPlanCache.h>
 
 namespace at { namespace native {
 
@@ -137,35 +135,25 @@ static inline void _fft_fill_with_conjugate_symmetry_(Tensor& input,
   for (int64_t d = 0; d < signal_ndim; d++) {
     num *= input.size(d);
   }
-#ifdef _OPENMP
-  if (num > 500) {
-    int nthreads = omp_get_num_threads();
-    int64_t num_slices_per_thread = num / nthreads + 1;
-    #pragma omp parallel
-    {
-      int tid = omp_get_thread_num();
-      int64_t start = tid * num_slices_per_thread;
-      AT_DISPATCH_FLOATING_TYPES(input.type(), "_fft_fill_with_conjugate_symmetry", [&] {
-        _fft_fill_with_conjugate_symmetry_slice<scalar_t>(input, signal_ndim, size_last_dim,
-            last_dim_start_slice, start, std::min(num_slices_per_thread, num - start));
-      });
-    }
-    return;
-  }
-#endif
   AT_DISPATCH_FLOATING_TYPES(input.type(), "_fft_fill_with_conjugate_symmetry", [&] {
-    _fft_fill_with_conjugate_symmetry_slice<scalar_t>(input, signal_ndim, size_last_dim,
-        last_dim_start_slice, 0, num);
+    parallel_for(0, num, 500, [&](int64_t start, int64_t end) {
+      _fft_fill_with_conjugate_symmetry_slice<scalar_t>(input, signal_ndim, size_last_dim,
+          last_dim_start_slice, start, end - start);
+    });
   });
 }
 
+// The descriptors of the recent transforms, see MKLFFTPlanCache.h. Computing
+// with a descriptor is done while holding the lock of the cache, so that the
+// descriptor can't be evicted by another thread in the meantime.
+static detail::MKLFFTParamsLRUCache mkl_fft_plan_cache;
+
 // MKL DFTI
 Tensor _fft_mkl(const Tensor& self, int64_t signal_ndim,
                 bool complex_input, bool complex_output,
                 bool inverse, IntList checked_signal_sizes,
                 bool normalized, bool onesided,
                 IntList output_sizes) {
-  int64_t batch = self.size(0);
   Tensor input = self;
   // real/imag dimension must aligned when viewed as of complex type
   if (complex_input) {
@@ -217,75 +205,24 @@ Tensor _fft_mkl(const Tensor& self, int64_t signal_ndim,
   }
   Tensor output = input.type().tensor(output_sizes);
 
-  // precision
-  DFTI_CONFIG_VALUE prec;
-  if (input.type().scalarType() == ScalarType::Float) {
-    prec = DFTI_SINGLE;
-  } else if (input.type().scalarType() == ScalarType::Double) {
-    prec = DFTI_DOUBLE;
-  } else {
-    std::ostringstream ss;
-    ss << "MKL FFT doesn't support tensor of type: "
-       << at::toString(input.type().scalarType());
-    throw std::runtime_error(ss.str());
-  }
-  // signal type
-  DFTI_CONFIG_VALUE signal_type;
-  if (!inverse) {
-    signal_type = complex_input ? DFTI_COMPLEX : DFTI_REAL;
-  } else {
-    signal_type = complex_output ? DFTI_COMPLEX : DFTI_REAL;
-  }
-  // create descriptor with signal size
-  std::vector<MKL_LONG> mkl_signal_sizes(checked_signal_sizes.begin(), checked_signal_sizes.end());
-  DftiDescriptor descriptor;
-  descriptor.init(prec, signal_type, signal_ndim, mkl_signal_sizes.data());
-  // out of place FFT
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_PLACEMENT, DFTI_NOT_INPLACE));
-  // batch mode
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_NUMBER_OF_TRANSFORMS, batch));
-
-  auto istrides = input.strides();
-  auto ostrides = output.strides();
-  // batch dim stride, i.e., dist between each data
-  MKL_LONG idist = complex_input ? istrides[0] >> 1 : istrides[0];
-  MKL_LONG odist = complex_output ? ostrides[0] >> 1 : ostrides[0];
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_INPUT_DISTANCE, idist));
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_OUTPUT_DISTANCE, odist));
-  // signal strides
-  // first val is offset, set to zero (ignored)
-  std::vector<MKL_LONG> mkl_istrides(1 + signal_ndim, 0), mkl_ostrides(1 + signal_ndim, 0);
-  for (int64_t i = 1; i <= signal_ndim; i++) {
-    mkl_istrides[i] = complex_input ? istrides[i] >> 1 : istrides[i];
-    mkl_ostrides[i] = complex_output ? ostrides[i] >> 1 : ostrides[i];
-  }
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_INPUT_STRIDES, mkl_istrides.data()));
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_OUTPUT_STRIDES, mkl_ostrides.data()));
-  // if conjugate domain of real is involved, set standard CCE storage type
-  // this will become default in MKL in future
-  if (!complex_input || !complex_output) {
-    MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_CONJUGATE_EVEN_STORAGE, DFTI_COMPLEX_COMPLEX));
-  }
-  // rescale if needed by normalized flag or inverse transform
-  if (normalized || inverse) {
-    auto signal_numel = at::prod_intlist(checked_signal_sizes);
-    double double_scale;
-    if (normalized) {
-      double_scale = 1.0 / std::sqrt(static_cast<double>(signal_numel));
+  // The descriptor transforms the whole batch in one compute call, on as many
+  // threads as parallel_for would use here.
+  int num_threads = get_intra_op_num_threads();
+  detail::MKLFFTParams params;
+  detail::setMKLFFTParams(&params, input, signal_ndim, complex_input,
+                          complex_output, inverse, checked_signal_sizes,
+                          normalized, output_sizes, num_threads);
+  {
+    std::lock_guard<std::mutex> guard(mkl_fft_plan_cache.mutex);
+    const detail::MKLFFTConfig &config = mkl_fft_plan_cache.try_emplace_value(
+        std::move(params), input, signal_ndim, complex_input, complex_output,
+        inverse, checked_signal_sizes, normalized, output_sizes, num_threads);
+    // run
+    if (!inverse) {
+      MKL_DFTI_CHECK(DftiComputeForward(config.descriptor(), input.data_ptr(), output.data_ptr()));
     } else {
-      double_scale = 1.0 / static_cast<double>(signal_numel);
+      MKL_DFTI_CHECK(DftiComputeBackward(config.descriptor(), input.data_ptr(), output.data_ptr()));
     }
-    MKL_DFTI_CHECK(DftiSetValue(descriptor.get(),
-      inverse ? DFTI_BACKWARD_SCALE : DFTI_FORWARD_SCALE,
-      prec == DFTI_DOUBLE ? double_scale : static_cast<float>(double_scale)));
-  }
-  // finalize
-  MKL_DFTI_CHECK(DftiCommitDescriptor(descriptor.get()));
-  // run
-  if (!inverse) {
-    MKL_DFTI_CHECK(DftiComputeForward(descriptor.get(), input.data_ptr(), output.data_ptr()));
-  } else {
-    MKL_DFTI_CHECK(DftiComputeBackward(descriptor.get(), input.data_ptr(), output.data_ptr()));
   }
   // now if needed, fill out the other half using Hermitian symmetry dim
   if (!complex_input && complex_output && !onesided) {
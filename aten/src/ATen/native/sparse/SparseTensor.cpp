@@ -3,10 +3,15 @@
 #include <ATen/ATen.h>
 #include <ATen/SparseTensorImpl.h>
 #include <ATen/NativeFunctions.h>
+#include <ATen/Parallel.h>
 #include <ATen/native/sparse/SparseUtils.h>
 
 #include <TH/THBlasUtils.h>
 
+#include <functional>
+#include <numeric>
+#include <vector>
+
 namespace at { namespace native {
 
 /******************************************************************************
@@ -254,6 +259,96 @@ SparseTensor& copy_sparse_(SparseTensor& self, const SparseTensor& src) {
   return self;
 }
 
+namespace {
+
+// Splits [0, n) into the contiguous chunks that the passes of coalesce hand
+// to the threads, so that every pass sees the same chunks.
+struct Chunks {
+  int64_t n;
+  int64_t count;
+  int64_t size;
+
+  explicit Chunks(int64_t n) : n(n) {
+    count = std::max<int64_t>(1, std::min<int64_t>(
+        get_intra_op_num_threads(), divup(n, internal::GRAIN_SIZE)));
+    size = divup(n, count);
+  }
+  int64_t begin(int64_t c) const { return std::min(n, c * size); }
+  int64_t end(int64_t c) const { return std::min(n, (c + 1) * size); }
+
+  template <typename F>
+  void parallel(const F& f) const {
+    parallel_for(0, count, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c < end; c++) {
+        f(c);
+      }
+    });
+  }
+};
+
+// Sorts keys, all in [0, 2^bits), together with perm, with a least
+// significant digit radix sort.  In each pass the threads count the digits
+// of their chunk, a prefix sum over (digit, chunk) gives each chunk where
+// its keys go, and the threads then scatter their chunks, which keeps the
+// sort stable.  Passes over a digit that all the keys share are skipped.
+void radix_sort_by_key(std::vector<int64_t>& keys, std::vector<int64_t>& perm, int bits) {
+  constexpr int kRadixBits = 8;
+  constexpr int64_t kRadix = 1 << kRadixBits;
+  const int64_t n = keys.size();
+  const Chunks chunks(n);
+  std::vector<int64_t> keys_out(n), perm_out(n);
+  std::vector<int64_t> offsets(chunks.count * kRadix);
+  for (int shift = 0; shift < bits; shift += kRadixBits) {
+    std::fill(offsets.begin(), offsets.end(), 0);
+    chunks.parallel([&](int64_t c) {
+      int64_t* count = offsets.data() + c * kRadix;
+      for (int64_t j = chunks.begin(c); j < chunks.end(c); j++) {
+        count[(keys[j] >> shift) & (kRadix - 1)]++;
+      }
+    });
+    bool same_digit = false;
+    int64_t offset = 0;
+    for (int64_t digit = 0; digit < kRadix; digit++) {
+      int64_t digit_start = offset;
+      for (int64_t c = 0; c < chunks.count; c++) {
+        int64_t count = offsets[c * kRadix + digit];
+        offsets[c * kRadix + digit] = offset;
+        offset += count;
+      }
+      same_digit |= offset - digit_start == n;
+    }
+    if (same_digit) {
+      continue;
+    }
+    chunks.parallel([&](int64_t c) {
+      int64_t* offset = offsets.data() + c * kRadix;
+      for (int64_t j = chunks.begin(c); j < chunks.end(c); j++) {
+        int64_t pos = offset[(keys[j] >> shift) & (kRadix - 1)]++;
+        keys_out[pos] = keys[j];
+        perm_out[pos] = perm[j];
+      }
+    });
+    keys.swap(keys_out);
+    perm.swap(perm_out);
+  }
+}
+
+// Number of j in [1, n) for which pred(keys[j - 1], keys[j]) holds
+template <typename Pred>
+int64_t count_adjacent(const std::vector<int64_t>& keys, const Pred& pred) {
+  return parallel_reduce(
+      1, static_cast<int64_t>(keys.size()), internal::GRAIN_SIZE, int64_t(0),
+      [&](int64_t begin, int64_t end, int64_t ident) {
+        for (int64_t j = begin; j < end; j++) {
+          ident += pred(keys[j - 1], keys[j]);
+        }
+        return ident;
+      },
+      std::plus<int64_t>());
+}
+
+} // namespace
+
 SparseTensor coalesce_sparse_cpu(const SparseTensor& self) {
   AT_ASSERT(self.defined());
   AT_ASSERT(!self.is_variable());
@@ -281,6 +376,24 @@ SparseTensor coalesce_sparse_cpu(const SparseTensor& self) {
     factor *= self.size(d);
   }
 
+  std::vector<int64_t> keys(indices_scalar.data<int64_t>(), indices_scalar.data<int64_t>() + nnz);
+  // Indices that are already sorted, as in the gradients of a lookup with
+  // sorted ids, are common enough to check for first: if they are also
+  // unique, there is nothing to do, and if not, the sort can be skipped.
+  if (count_adjacent(keys, std::greater_equal<int64_t>()) == 0) {
+    _get_sparse_impl(self)->set_coalesced(true);
+    return self;
+  }
+  std::vector<int64_t> perm(nnz);
+  std::iota(perm.begin(), perm.end(), 0);
+  if (count_adjacent(keys, std::greater<int64_t>()) != 0) {
+    int bits = 0;
+    while (bits < 63 && ((factor - 1) >> bits) != 0) {
+      bits++;
+    }
+    radix_sort_by_key(keys, perm, bits);
+  }
+
   SparseTensor dst = new_sparse(self.type());
   _raw_resize_sparse(dst, sparseDims, denseDims, self.sizes());
   // TODO: is there a more idiomatic way to do this?
@@ -288,40 +401,47 @@ SparseTensor coalesce_sparse_cpu(const SparseTensor& self) {
   Tensor newValues = values.type().tensor(values.sizes());
   _alias_into_sparse(dst, newIndices, newValues);
 
-  LongTensor indicesBuffer;
-  LongTensor indicesPermutation;
-  std::tie(indicesBuffer, indicesPermutation) = indices_scalar.sort(0);
+  // Each chunk of the sorted keys writes the runs of equal keys that start
+  // in it, possibly reading past its end, at the position given by the
+  // number of runs starting in the chunks before it.
   // NB: The accessor accesses here rely on self._nnz() > 0 (tested earlier in this function)
+  const Chunks chunks(nnz);
+  std::vector<int64_t> run_offsets(chunks.count + 1, 0);
+  chunks.parallel([&](int64_t c) {
+    for (int64_t j = chunks.begin(c); j < chunks.end(c); j++) {
+      run_offsets[c + 1] += j == 0 || keys[j] != keys[j - 1];
+    }
+  });
+  std::partial_sum(run_offsets.begin(), run_offsets.end(), run_offsets.begin());
+
   auto newIndicesAccessor = newIndices.accessor<int64_t, 2>();
   auto indicesAccessor = indices.accessor<int64_t, 2>();
-  auto indicesPermutationAccessor = indicesPermutation.accessor<int64_t, 1>();
-  auto indicesBufferAccessor = indicesBuffer.accessor<int64_t, 1>();
-
-  int64_t i = -1;
   AT_DISPATCH_ALL_TYPES(
       values.type(), "coalesce", [&] {
-        int64_t prev = -1;
         int64_t blockSize = values.stride(0);
         scalar_t* values_ptr = values.data<scalar_t>();
         scalar_t* newValues_ptr = newValues.data<scalar_t>();
-        for (int64_t j = 0; j < nnz; j++) {
-          int64_t pos = indicesPermutationAccessor[j];
-          int64_t curr = indicesBufferAccessor[j];
-          if (curr == prev) {
-            THBlas_axpy<scalar_t>(blockSize, 1, values_ptr + pos * blockSize, 1, newValues_ptr + i * blockSize, 1);
-          } else {
-            ++i;
+        chunks.parallel([&](int64_t c) {
+          int64_t i = run_offsets[c];
+          for (int64_t j = chunks.begin(c); j < chunks.end(c); j++) {
+            if (j != 0 && keys[j] == keys[j - 1]) {
+              continue;
+            }
+            int64_t pos = perm[j];
             for (int64_t d = 0; d < sparseDims; d++) {
               newIndicesAccessor[d][i] = indicesAccessor[d][pos];
             }
             THBlas_copy<scalar_t>(blockSize, values_ptr + pos * blockSize, 1, newValues_ptr + i * blockSize, 1);
+            for (int64_t k = j + 1; k < nnz && keys[k] == keys[j]; k++) {
+              THBlas_axpy<scalar_t>(blockSize, 1, values_ptr + perm[k] * blockSize, 1, newValues_ptr + i * blockSize, 1);
+            }
+            i++;
           }
-          prev = curr;
-        }
+        });
     });
 
   _get_sparse_impl(dst)->set_coalesced(true);
-  _get_sparse_impl(dst)->set_nnz(i + 1);
+  _get_sparse_impl(dst)->set_nnz(run_offsets.back());
 
   return dst;
 }
@@ -1,11 +1,19 @@
 #include <ATen/ATen.h>
+#include <ATen/Config.h>
 #include <ATen/SparseTensorImpl.h>
 #include <ATen/ExpandUtils.h>
 #include <ATen/NativeFunctions.h>
+#include <ATen/Parallel.h>
 #include <ATen/native/sparse/SparseUtils.h>
 
 #include <TH/THBlasUtils.h>
 
+#include <limits>
+
+#if AT_MKL_ENABLED()
+#include <mkl_spblas.h>
+#endif
+
 namespace at { namespace native {
 
 // --------------------------------------------------------------------
@@ -33,6 +41,35 @@ namespace {
     return csr;
   }
 
+  // The CSR row pointers and column indices of a coalesced 2-D sparse tensor
+  // with nnz > 0, in the given index type.  They are built the first time
+  // and cached on the tensor, see SparseTensorImpl::csr_rows_.  Building
+  // them also checks that the column indices are in bounds, so that the
+  // kernels using them don't have to.
+  std::tuple<Tensor, Tensor> _csr_indices(const SparseTensor& sparse, ScalarType index_type) {
+    SparseTensorImpl* impl = _get_sparse_impl(sparse);
+    Tensor rows = impl->csr_rows();
+    if (rows.defined() && rows.type().scalarType() == index_type) {
+      return std::make_tuple(rows, impl->csr_cols());
+    }
+    int64_t nnz = impl->nnz();
+    int64_t dim_j = sparse.size(1);
+    LongTensor indices = impl->indices().contiguous();
+    LongTensor cols = indices.select(0, 1).narrow(0, 0, nnz);
+    int64_t min_col = cols.min().toCLong();
+    int64_t max_col = cols.max().toCLong();
+    AT_CHECK(min_col >= 0 && max_col < dim_j,
+        "addmm: index out of bound: ", min_col < 0 ? min_col : max_col,
+        " not between 1 and ", dim_j);
+    rows = _to_csr(indices.data<int64_t>(), sparse.size(0), nnz);
+    if (index_type != kLong) {
+      rows = rows.toType(index_type);
+      cols = cols.toType(index_type);
+    }
+    impl->set_csr(rows, cols);
+    return std::make_tuple(rows, cols);
+  }
+
 }
 
 // --------------------------------------------------------------------
@@ -528,13 +565,11 @@ SparseTensor& s_mul_sparse_cpu_(SparseTensor& t, const SparseTensor& src) {
 // addmm(Tensor, SparseTensorRef, Tensor, Scalar, Scalar)  [broadcasts]
 // --------------------------------------------------------------------
 
-// NB: OMP pragmas have to get their own functions; can't put them in lambdas
-template <typename scalar_t>
-void s_addmm_out_sparse_dense_worker(int64_t nnz, int64_t dim_i, int64_t dim_j, int64_t dim_k, Tensor& r, Scalar beta, const Tensor& t, Scalar alpha, const Tensor& csr, const Tensor& indices, const Tensor& values, const Tensor& dense) {
-  int64_t h, i;
+namespace {
 
-  // r_ = alpha * sparse * dense
-  scalar_t cast_alpha = alpha.to<scalar_t>();
+// r = beta * t, before the product is added to it
+template <typename scalar_t>
+void _addmm_scale_out(Tensor& r, const Tensor& t, Scalar beta) {
   scalar_t cast_beta = beta.to<scalar_t>();
   if (cast_beta == 0) {
     r.zero_();
@@ -545,10 +580,96 @@ void s_addmm_out_sparse_dense_worker(int64_t nnz, int64_t dim_i, int64_t dim_j,
   } else {
     at::mul_out(r, t, beta);
   }
+}
+
+#if AT_MKL_ENABLED()
+constexpr ScalarType kMklIndex = sizeof(MKL_INT) == 8 ? kLong : kInt;
+
+sparse_status_t _mkl_sparse_create_csr(
+    sparse_matrix_t* A, MKL_INT rows, MKL_INT cols, MKL_INT* rows_start,
+    MKL_INT* col_indx, float* values) {
+  return mkl_sparse_s_create_csr(A, SPARSE_INDEX_BASE_ZERO, rows, cols,
+      rows_start, rows_start + 1, col_indx, values);
+}
+
+sparse_status_t _mkl_sparse_create_csr(
+    sparse_matrix_t* A, MKL_INT rows, MKL_INT cols, MKL_INT* rows_start,
+    MKL_INT* col_indx, double* values) {
+  return mkl_sparse_d_create_csr(A, SPARSE_INDEX_BASE_ZERO, rows, cols,
+      rows_start, rows_start + 1, col_indx, values);
+}
+
+sparse_status_t _mkl_sparse_mm(
+    float alpha, const sparse_matrix_t A, const float* x, MKL_INT columns,
+    MKL_INT ldx, float* y, MKL_INT ldy) {
+  matrix_descr descr;
+  descr.type = SPARSE_MATRIX_TYPE_GENERAL;
+  if (columns == 1) {
+    return mkl_sparse_s_mv(SPARSE_OPERATION_NON_TRANSPOSE, alpha, A, descr, x, 1, y);
+  }
+  return mkl_sparse_s_mm(SPARSE_OPERATION_NON_TRANSPOSE, alpha, A, descr,
+      SPARSE_LAYOUT_ROW_MAJOR, x, columns, ldx, 1, y, ldy);
+}
 
-  auto csr_accessor = csr.accessor<int64_t, 1>();
-  auto indices_accessor = indices.accessor<int64_t, 2>();
+sparse_status_t _mkl_sparse_mm(
+    double alpha, const sparse_matrix_t A, const double* x, MKL_INT columns,
+    MKL_INT ldx, double* y, MKL_INT ldy) {
+  matrix_descr descr;
+  descr.type = SPARSE_MATRIX_TYPE_GENERAL;
+  if (columns == 1) {
+    return mkl_sparse_d_mv(SPARSE_OPERATION_NON_TRANSPOSE, alpha, A, descr, x, 1, y);
+  }
+  return mkl_sparse_d_mm(SPARSE_OPERATION_NON_TRANSPOSE, alpha, A, descr,
+      SPARSE_LAYOUT_ROW_MAJOR, x, columns, ldx, 1, y, ldy);
+}
 
+// MKL's sparse BLAS takes float and double matrices whose sizes fit in
+// MKL_INT, multiplied with row-major dense matrices (dense vectors with
+// unit stride for SpMV).
+bool _use_mkl_sparse(const Tensor& r, const Tensor& values, const Tensor& dense, int64_t dim_i, int64_t dim_j, int64_t dim_k, int64_t nnz) {
+  ScalarType type = values.type().scalarType();
+  if (type != kFloat && type != kDouble) {
+    return false;
+  }
+  if (sizeof(MKL_INT) < sizeof(int64_t)) {
+    const int64_t max_int = std::numeric_limits<MKL_INT>::max();
+    if (dim_i >= max_int || dim_j >= max_int || dim_k >= max_int || nnz >= max_int ||
+        r.stride(0) >= max_int || dense.stride(0) >= max_int) {
+      return false;
+    }
+  }
+  if (dim_k == 1) {
+    return r.stride(0) == 1 && dense.stride(0) == 1;
+  }
+  return r.stride(1) == 1 && r.stride(0) >= dim_k &&
+      dense.stride(1) == 1 && dense.stride(0) >= dim_k;
+}
+
+template <typename scalar_t>
+void s_addmm_out_sparse_dense_mkl(int64_t dim_i, int64_t dim_j, int64_t dim_k, Tensor& r, Scalar beta, const Tensor& t, Scalar alpha, const Tensor& csr_rows, const Tensor& csr_cols, const Tensor& values_, const Tensor& dense) {
+  _addmm_scale_out<scalar_t>(r, t, beta);
+  Tensor values = values_.contiguous();
+  sparse_matrix_t A;
+  AT_CHECK(_mkl_sparse_create_csr(&A, dim_i, dim_j,
+          static_cast<MKL_INT*>(csr_rows.data_ptr()),
+          static_cast<MKL_INT*>(csr_cols.data_ptr()),
+          values.data<scalar_t>()) == SPARSE_STATUS_SUCCESS,
+      "addmm: MKL failed to create the sparse matrix");
+  sparse_status_t status = _mkl_sparse_mm(alpha.to<scalar_t>(), A,
+      dense.data<scalar_t>(), dim_k, dense.stride(0), r.data<scalar_t>(), r.stride(0));
+  mkl_sparse_destroy(A);
+  AT_CHECK(status == SPARSE_STATUS_SUCCESS, "addmm: MKL sparse matrix product failed");
+}
+#endif
+
+template <typename scalar_t>
+void s_addmm_out_sparse_dense_worker(int64_t nnz, int64_t dim_i, int64_t dim_k, Tensor& r, Scalar beta, const Tensor& t, Scalar alpha, const Tensor& csr_rows, const Tensor& csr_cols, const Tensor& values, const Tensor& dense) {
+  // r_ = alpha * sparse * dense
+  _addmm_scale_out<scalar_t>(r, t, beta);
+  scalar_t cast_alpha = alpha.to<scalar_t>();
+
+  const int64_t* rows_ptr = csr_rows.data<int64_t>();
+  const int64_t* cols_ptr = csr_cols.data<int64_t>();
   auto values_accessor = values.accessor<scalar_t, 1>();
   scalar_t* dense_ptr = dense.data<scalar_t>();
   scalar_t* r_ptr = r.data<scalar_t>();
@@ -557,24 +678,33 @@ void s_addmm_out_sparse_dense_worker(int64_t nnz, int64_t dim_i, int64_t dim_j,
   int64_t dense_stride1 = dense.stride(1);
   int64_t r_stride0 = r.stride(0);
   int64_t r_stride1 = r.stride(1);
-#pragma omp parallel for private(h, i) schedule(static) if (nnz > 10000)
-  for (h = 0; h < dim_i; h++) {
-    int64_t i_start = csr_accessor[h];
-    int64_t i_end = csr_accessor[h+1];
-    for (i = i_start; i < i_end; i++) {
-      scalar_t val = values_accessor[i];
-      int64_t col = indices_accessor[1][i];
-      if (col >= 0 && col < dim_j) {
-        THBlas_axpy<scalar_t>(dim_k,
-            cast_alpha * val,
-            dense_ptr + col * dense_stride0, dense_stride1,
-            r_ptr + h * r_stride0, r_stride1);
+  // Every row of r only depends on the same row of sparse, so the rows are
+  // split between the threads, about GRAIN_SIZE multiply-adds at a time.
+  int64_t grain_size = std::max<int64_t>(1, at::internal::GRAIN_SIZE * dim_i / (nnz * dim_k));
+  at::parallel_for(0, dim_i, grain_size, [&](int64_t start, int64_t end) {
+    for (int64_t h = start; h < end; h++) {
+      int64_t i_start = rows_ptr[h];
+      int64_t i_end = rows_ptr[h+1];
+      if (dim_k == 1) {
+        // SpMV: one dot product per row rather than axpys of length one
+        scalar_t sum = 0;
+        for (int64_t i = i_start; i < i_end; i++) {
+          sum += values_accessor[i] * dense_ptr[cols_ptr[i] * dense_stride0];
+        }
+        r_ptr[h * r_stride0] += cast_alpha * sum;
       } else {
-        AT_ERROR("addmm: index out of bound: ", col, " not between 1 and ", dim_j);
+        for (int64_t i = i_start; i < i_end; i++) {
+          THBlas_axpy<scalar_t>(dim_k,
+              cast_alpha * values_accessor[i],
+              dense_ptr + cols_ptr[i] * dense_stride0, dense_stride1,
+              r_ptr + h * r_stride0, r_stride1);
+        }
       }
     }
-  }
-};
+  });
+}
+
+} // namespace
 
 Tensor& s_addmm_out_sparse_dense_cpu(
     Tensor& r,
@@ -618,13 +748,25 @@ Tensor& s_addmm_out_sparse_dense_cpu(
     return r;
   }
 
-  LongTensor indices = sparse._indices();
   Tensor values      = sparse._values();
-  LongTensor csr = _to_csr(indices.data<int64_t>(), dim_i, nnz);
+  Tensor csr_rows, csr_cols;
+
+#if AT_MKL_ENABLED()
+  if (_use_mkl_sparse(r, values, dense, dim_i, dim_j, dim_k, nnz)) {
+    std::tie(csr_rows, csr_cols) = _csr_indices(sparse, kMklIndex);
+    AT_DISPATCH_FLOATING_TYPES(
+        values.type(), "addmm_sparse_dense", [&] {
+          s_addmm_out_sparse_dense_mkl<scalar_t>(dim_i, dim_j, dim_k, r, beta, t, alpha, csr_rows, csr_cols, values, dense);
+        }
+    );
+    return r;
+  }
+#endif
 
+  std::tie(csr_rows, csr_cols) = _csr_indices(sparse, kLong);
   AT_DISPATCH_ALL_TYPES(
       values.type(), "addmm_sparse_dense", [&] {
-        s_addmm_out_sparse_dense_worker<scalar_t>(nnz, dim_i, dim_j, dim_k, r, beta, t, alpha, csr, indices, values, dense);
+        s_addmm_out_sparse_dense_worker<scalar_t>(nnz, dim_i, dim_k, r, beta, t, alpha, csr_rows, csr_cols, values, dense);
       }
   );
 
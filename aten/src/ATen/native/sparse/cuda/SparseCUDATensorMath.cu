@@ -30,6 +30,24 @@ namespace {
     sparse::cuda::Xcoo2csr(rowIndicesInt.data<int32_t>(), nnz, dim, csr.data<int32_t>());
     return csr;
   }
+
+  // The int32 CSR row pointers and column indices cuSPARSE takes, built the
+  // first time a coalesced matrix is multiplied and cached on it, see
+  // SparseTensorImpl::csr_rows_.
+  std::tuple<IntTensor, IntTensor> _csr_indices_int(const SparseTensor& sparse) {
+    SparseTensorImpl* impl = _get_sparse_impl(sparse);
+    IntTensor csr = impl->csr_rows();
+    if (csr.defined() && csr.type().scalarType() == kInt) {
+      return std::make_tuple(csr, impl->csr_cols());
+    }
+    int64_t nnz = impl->nnz();
+    LongTensor indices = impl->indices();
+    csr = _to_csr_int(indices.select(0, 0), sparse.size(0), nnz);
+    IntTensor colIndicesInt = at::empty({nnz}, indices.type().toScalarType(kInt));
+    colIndicesInt.copy_(indices.select(0, 1).narrow(0, 0, nnz));
+    impl->set_csr(csr, colIndicesInt);
+    return std::make_tuple(csr, colIndicesInt);
+  }
 }
 #endif
 
@@ -71,14 +89,10 @@ Tensor& s_addmm_out_sparse_dense_cuda(Tensor& r_, const Tensor& t, const SparseT
   SparseTensor sparse = sparse_.coalesce();
 
   int64_t nnz = sparse._nnz();
-  LongTensor indices = sparse._indices();
   Tensor values = sparse._values();
 
-  LongTensor rowIndices = indices.select(0, 0);
-  LongTensor colIndices = indices.select(0, 1);
-  IntTensor csr = _to_csr_int(rowIndices, m, nnz);
-  IntTensor colIndicesInt = at::empty({colIndices.size(0)}, indices.type().toScalarType(kInt));
-  colIndicesInt.copy_(colIndices);
+  IntTensor csr, colIndicesInt;
+  std::tie(csr, colIndicesInt) = _csr_indices_int(sparse);
 
   // No half support, so we don't have to use CUDATypeConversion
   Tensor r__;
@@ -405,8 +405,16 @@ def run(paths):
 
             base = base_declaration(func, fwd_function, backends)
             declarations.append(base)
-            declarations.append(forward_declaration(base, fwd_function))
-            declarations.append(backward_declaration(base, bwd_functions))
+            fwd_declaration = forward_declaration(base, fwd_function)
+            bwd_declaration = backward_declaration(base, bwd_functions)
+            if func.get('cpu_native', False):
+                # The CPU forward and backward call at::native::<name>_cpu,
+                # e.g. avg_pool2d_forward_out_cpu, which take the arguments
+                # of the Type methods. CUDA still goes to THCUNN.
+                fwd_declaration['cpu_native'] = True
+                bwd_declaration['cpu_native'] = True
+            declarations.append(fwd_declaration)
+            declarations.append(bwd_declaration)
 
             if func.get('has_inplace', False):
                 declarations.append(base_declaration(func, fwd_function, backends, True))
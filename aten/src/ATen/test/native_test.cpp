@@ -2,6 +2,7 @@
 #include "catch.hpp"
 
 #include "ATen/ATen.h"
+#include "ATen/ExpandUtils.h"
 #include "test_seed.h"
 
 using namespace at;
@@ -176,6 +177,90 @@ void test(Type & T, Type & AccT) {
     REQUIRE_ALLCLOSE(at::where(cond_scalar, x_scalar, y_scalar).unsqueeze(0),
                      at::where(cond_1d, x_1d, y_1d));
   }
+
+  SECTION( "binary ops: same result as TH" ) {
+    // contiguous, transposed, broadcast scalar, broadcast row and column,
+    // and strided operands, of lengths that leave a vector remainder
+    auto a = randn({37, 19}, T);
+    std::vector<std::pair<Tensor, Tensor>> operands = {
+        {a, randn({37, 19}, T)},
+        {a.t(), randn({19, 37}, T)},
+        {a, ones({}, T).mul(3)},
+        {ones({1}, T).mul(3), a},
+        {a, randn({19}, T)},
+        {a, randn({37, 1}, T)},
+        {a.slice(1, 0, 19, 2), randn({10, 37}, T).t()},
+        {a.narrow(0, 1, 5), randn({5, 19}, T).transpose(0, 1).contiguous().t()},
+        {ones({0}, T), ones({0}, T)},
+    };
+    for (auto& pair : operands) {
+      auto& x = pair.first;
+      auto& y = pair.second;
+      REQUIRE_ALLCLOSE(at::add(x, y, 2), at::th_add(x, y, 2));
+      REQUIRE_ALLCLOSE(at::sub(x, y, 2), at::th_sub(x, y, 2));
+      REQUIRE_ALLCLOSE(at::mul(x, y), at::th_mul(x, y));
+      REQUIRE_ALLCLOSE(at::div(x, y), at::th_div(x, y));
+
+      auto result = T.tensor();
+      REQUIRE_ALLCLOSE(at::add_out(result, x, y), at::th_add(x, y));
+
+      if (x.sizes().equals(at::infer_size(x.sizes(), y.sizes()))) {
+        auto z = x.clone();
+        z.add_(y);
+        REQUIRE_ALLCLOSE(z, at::th_add(x, y));
+        z = x.clone();
+        z.mul_(y);
+        REQUIRE_ALLCLOSE(z, at::th_mul(x, y));
+      }
+    }
+
+    auto &lT = T.toScalarType(ScalarType::Long);
+    auto l = ones({33, 7}, lT).mul(7);
+    auto m = ones({7}, lT).mul(2);
+    REQUIRE_EQUAL(at::add(l, m, 3), at::th_add(l, m, 3));
+    REQUIRE_EQUAL(at::div(l, m), at::th_div(l, m));
+  }
+
+  SECTION( "reductions: same result as TH" ) {
+    // reductions over the inner and outer dimensions, to fewer and more
+    // outputs than threads, of lengths that leave a vector remainder
+    std::vector<Tensor> inputs = {
+        randn({37, 19}, T),
+        randn({3, 500, 7}, T),
+        randn({20000, 3}, T),
+        randn({2, 50000}, T),
+    };
+    for (auto& x : inputs) {
+      for (int64_t dim = 0; dim < x.dim(); dim++) {
+        REQUIRE_ALLCLOSE(at::sum(x, dim), at::_th_sum(x, dim));
+        REQUIRE_ALLCLOSE(at::norm(x, 1, dim), at::_th_norm(x, 1, dim));
+        REQUIRE_ALLCLOSE(at::norm(x, 2, dim, true), at::_th_norm(x, 2, dim, true));
+        REQUIRE_ALLCLOSE(at::norm(x, INFINITY, dim), at::_th_norm(x, INFINITY, dim));
+        REQUIRE_ALLCLOSE(at::var(x, dim, true, false), at::_th_var(x, dim, true, false));
+        REQUIRE_ALLCLOSE(at::std(x, dim, false, true), at::_th_std(x, dim, false, true));
+        REQUIRE_EQUAL(at::max_values(x, dim), std::get<0>(at::_th_max(x, dim)));
+        REQUIRE_EQUAL(at::min_values(x, dim), std::get<0>(at::_th_min(x, dim)));
+        REQUIRE_ALLCLOSE(at::logsumexp(x, dim), at::log(at::_th_sum(at::exp(x), dim)));
+      }
+      REQUIRE_ALLCLOSE(at::norm(x, 2), at::th_norm(x, 2));
+      REQUIRE_ALLCLOSE(at::var(x, true), at::_th_var(x, true));
+      REQUIRE_ALLCLOSE(at::std(x, false), at::_th_std(x, false));
+    }
+
+    // adjacent dimensions are reduced as one
+    auto x = inputs[1];
+    REQUIRE_ALLCLOSE(at::sum(x, {1, 2}), x.sum(2).sum(1));
+    REQUIRE_ALLCLOSE(at::sum(x, {0, 1}, true), x.sum(1, true).sum(0, true));
+    REQUIRE_ALLCLOSE(at::sum(x, {0, 2}), x.sum(2).sum(0));
+
+    // max and min propagate NaN
+    auto y = randn({4, 33}, T);
+    y.narrow(1, 5, 1).fill_(std::numeric_limits<double>::quiet_NaN());
+    auto max = at::max_values(y, 1);
+    auto min = at::min_values(y, 1);
+    REQUIRE(max.ne(max).sum().toCDouble() == 4);
+    REQUIRE(min.ne(min).sum().toCDouble() == 4);
+  }
 }
 
 TEST_CASE( "native test CPU", "[cpu]" ) {
@@ -3,10 +3,15 @@
 
 #include "ATen/ATen.h"
 #include "ATen/DLConvertor.h"
+#include "ATen/Parallel.h"
 
+#include <atomic>
 #include <iostream>
 #include <string.h>
 #include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 #include "test_seed.h"
 
 using namespace at;
@@ -26,3 +31,77 @@ TEST_CASE( "parallel", "[cpu]" ) {
   as[2] = 0;
   REQUIRE(a.sum(0).equal(as));
 }
+
+TEST_CASE( "parallel_for", "[cpu]" ) {
+  set_intra_op_num_threads(4);
+
+  SECTION( "covers the range once" ) {
+    std::vector<std::atomic<int>> hits(100003);
+    parallel_for(0, hits.size(), 7, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        hits[i]++;
+      }
+    });
+    for (auto& hit : hits) {
+      REQUIRE(hit == 1);
+    }
+    int64_t sum = parallel_reduce(0, 1000000, 1000, int64_t(0), [](int64_t begin, int64_t end, int64_t acc) {
+      for (int64_t i = begin; i < end; i++) {
+        acc += i;
+      }
+      return acc;
+    }, std::plus<int64_t>());
+    REQUIRE(sum == 499999500000);
+  }
+
+  SECTION( "nested regions are serial" ) {
+    std::atomic<int> nested_threads(0);
+    parallel_for(0, 100, 1, [&](int64_t begin, int64_t end) {
+      parallel_for(0, 100, 1, [&](int64_t begin, int64_t end) {
+        if (begin != 0 || end != 100) {
+          nested_threads++;
+        }
+      });
+    });
+    REQUIRE(nested_threads == 0);
+  }
+
+#if AT_PARALLEL_NATIVE() || defined(_OPENMP)
+  SECTION( "per thread number of threads" ) {
+    std::vector<std::thread> threads;
+    std::atomic<int> wrong(0);
+    for (int t = 1; t <= 3; t++) {
+      threads.emplace_back([t, &wrong] {
+        set_intra_op_num_threads(t);
+        if (get_intra_op_num_threads() != t) {
+          wrong++;
+        }
+        std::atomic<int64_t> count(0);
+        parallel_for(0, 10000, 10, [&](int64_t begin, int64_t end) {
+          count += end - begin;
+        });
+        if (count != 10000) {
+          wrong++;
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    REQUIRE(wrong == 0);
+    REQUIRE(get_intra_op_num_threads() == 4);
+  }
+#endif
+
+#if AT_PARALLEL_NATIVE()
+  SECTION( "exceptions are rethrown" ) {
+    REQUIRE_THROWS_AS(parallel_for(0, 1000, 1, [](int64_t begin, int64_t end) {
+      if (begin > 500) {
+        throw std::runtime_error("task failed");
+      }
+    }), std::runtime_error);
+  }
+#endif
+
+  set_intra_op_num_threads(0);
+}
@@ -1,4 +1,8 @@
 #include "THBlas.h"
 
+#ifdef TH_BLAS_MKL
+#include <mkl_cblas.h>
+#endif
+
 #include "generic/THBlas.cpp"
 #include "THGenerateAllTypes.h"
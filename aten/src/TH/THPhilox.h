@@ -0,0 +1,64 @@
+#ifndef TH_PHILOX_INC
+#define TH_PHILOX_INC
+
+#include "THGeneral.h"
+
+/* Philox4x32-10, the counter-based random number generator of Salmon et al.,
+   "Parallel Random Numbers: As Easy as 1, 2, 3" (SC 2011).
+
+   Block `counter` of the stream of `key` is 4 independent uniform 32 bit
+   integers that are computed from (key, counter) alone, so any chunk of a
+   stream can be generated without generating the blocks before it. This is
+   what lets the tensor random fills run in parallel and still give the same
+   numbers for any number of threads. */
+
+#define TH_PHILOX_M0 0xD2511F53U
+#define TH_PHILOX_M1 0xCD9E8D57U
+#define TH_PHILOX_W0 0x9E3779B9U
+#define TH_PHILOX_W1 0xBB67AE85U
+
+static inline void THPhilox_block(uint64_t key, uint64_t counter, uint32_t out[4])
+{
+  uint32_t k0 = (uint32_t)key;
+  uint32_t k1 = (uint32_t)(key >> 32);
+  uint32_t c0 = (uint32_t)counter;
+  uint32_t c1 = (uint32_t)(counter >> 32);
+  uint32_t c2 = 0;
+  uint32_t c3 = 0;
+  int round;
+  for (round = 0; round < 10; round++) {
+    uint64_t p0 = (uint64_t)TH_PHILOX_M0 * c0;
+    uint64_t p1 = (uint64_t)TH_PHILOX_M1 * c2;
+    uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+    uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+    c1 = (uint32_t)p1;
+    c3 = (uint32_t)p0;
+    c0 = n0;
+    c2 = n2;
+    k0 += TH_PHILOX_W0;
+    k1 += TH_PHILOX_W1;
+  }
+  out[0] = c0;
+  out[1] = c1;
+  out[2] = c2;
+  out[3] = c3;
+}
+
+/* Maps 32 random bits to a uniform float on [0, 1). */
+static inline float THPhilox_uniformFloat(uint32_t x)
+{
+  return (x >> 8) * (1.0f / 16777216.0f);
+}
+
+/* Maps 64 random bits to a uniform double on [0, 1). */
+static inline double THPhilox_uniformDouble(uint32_t hi, uint32_t lo)
+{
+  return ((((uint64_t)hi << 32) | lo) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+#undef TH_PHILOX_M0
+#undef TH_PHILOX_M1
+#undef TH_PHILOX_W0
+#undef TH_PHILOX_W1
+
+#endif
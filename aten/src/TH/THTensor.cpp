@@ -1,7 +1,10 @@
 #include <cmath>
 #include <float.h>
 
+#include <algorithm>
 #include <atomic>
+#include <numeric>
+#include <vector>
 #include "THTensor.hpp"
 #include "THVector.h"
 #include "generic/simd/simd.h"
@@ -432,4 +432,40 @@ void THBlas_(gemm)(char transa, char transb, int64_t m, int64_t n, int64_t k, re
   }
 }
 
+void THBlas_(gemmBatched)(char transa, char transb, int64_t batch, int64_t m, int64_t n, int64_t k, real alpha, real **a, int64_t lda, real **b, int64_t ldb, real beta, real **c, int64_t ldc)
+{
+#if defined(TH_BLAS_MKL) && (defined(TH_REAL_IS_DOUBLE) || defined(TH_REAL_IS_FLOAT))
+  if( (batch <= INT_MAX) && (m <= INT_MAX) && (n <= INT_MAX) && (k <= INT_MAX) &&
+      (lda <= INT_MAX) && (ldb <= INT_MAX) && (ldc <= INT_MAX) )
+  {
+    /* a single group of matrices, which MKL spreads over its threads */
+    CBLAS_TRANSPOSE transa_ = ((transa == 't') || (transa == 'T')) ? CblasTrans : CblasNoTrans;
+    CBLAS_TRANSPOSE transb_ = ((transb == 't') || (transb == 'T')) ? CblasTrans : CblasNoTrans;
+    MKL_INT i_m = (MKL_INT)m;
+    MKL_INT i_n = (MKL_INT)n;
+    MKL_INT i_k = (MKL_INT)k;
+    MKL_INT i_lda = (MKL_INT)lda;
+    MKL_INT i_ldb = (MKL_INT)ldb;
+    MKL_INT i_ldc = (MKL_INT)ldc;
+    MKL_INT group_size = (MKL_INT)batch;
+
+#if defined(TH_REAL_IS_DOUBLE)
+    cblas_dgemm_batch(CblasColMajor, &transa_, &transb_, &i_m, &i_n, &i_k,
+                      &alpha, (const double**)a, &i_lda, (const double**)b, &i_ldb,
+                      &beta, c, &i_ldc, 1, &group_size);
+#else
+    cblas_sgemm_batch(CblasColMajor, &transa_, &transb_, &i_m, &i_n, &i_k,
+                      &alpha, (const float**)a, &i_lda, (const float**)b, &i_ldb,
+                      &beta, c, &i_ldc, 1, &group_size);
+#endif
+    return;
+  }
+#endif
+  {
+    int64_t i;
+    for(i = 0; i < batch; i++)
+      THBlas_(gemm)(transa, transb, m, n, k, alpha, a[i], lda, b[i], ldb, beta, c[i], ldc);
+  }
+}
+
 #endif
@@ -15,5 +15,9 @@ TH_API void THBlas_(ger)(int64_t m, int64_t n, real alpha, real *x, int64_t incx
 
 /* Level 3 */
 TH_API void THBlas_(gemm)(char transa, char transb, int64_t m, int64_t n, int64_t k, real alpha, real *a, int64_t lda, real *b, int64_t ldb, real beta, real *c, int64_t ldc);
+/* gemm of each of the batch matrices a[i], b[i] and c[i], which all have the
+   same sizes and leading dimensions. Unlike with gemm, lda, ldb and ldc have
+   to be valid for BLAS also when the matrices are vectors. */
+TH_API void THBlas_(gemmBatched)(char transa, char transb, int64_t batch, int64_t m, int64_t n, int64_t k, real alpha, real **a, int64_t lda, real **b, int64_t ldb, real beta, real **c, int64_t ldc);
 
 #endif
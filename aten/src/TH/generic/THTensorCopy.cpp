@@ -13,70 +13,119 @@
 #include <omp.h>
 #endif
 
-int THTensor_(copyTransposeValid)(THTensor *tensor, THTensor *src) {
+// Describes src, copied into a contiguous tensor of the same size, by as few
+// dims as possible: dims of size 1 are dropped and neighbours that src
+// stores contiguously too are merged. Returns the number of dims left.
+static int THTensor_(copyPermuteDims)(THTensor *src, std::vector<int64_t>& sizes, std::vector<int64_t>& strides) {
+  for (int d = 0; d < THTensor_(nDimension)(src); d++) {
+    int64_t size = THTensor_(size)(src, d);
+    int64_t stride = THTensor_(stride)(src, d);
+    if (size == 1) {
+      continue;
+    }
+    if (!sizes.empty() && strides.back() == size * stride) {
+      sizes.back() *= size;
+      strides.back() = stride;
+    } else {
+      sizes.push_back(size);
+      strides.push_back(stride);
+    }
+  }
+  return sizes.size();
+}
+
+int THTensor_(copyPermuteValid)(THTensor *tensor, THTensor *src) {
   const int MIN_SZ = 60 * 60;
-  return THTensor_(isContiguous)(tensor) &&
-         !src->is_empty() &&
-         THTensor_(nDimension)(src) == 2 &&
-         THTensor_(stride)(src, 0) == 1 &&
-         THTensor_(stride)(src, 1) == THTensor_(size)(src, 0) &&
-         THTensor_(nElement)(tensor) >= MIN_SZ;
+  if (!THTensor_(isContiguous)(tensor) ||
+      src->is_empty() ||
+      THTensor_(nElement)(tensor) < MIN_SZ ||
+      !THTensor_(isSameSizeAs)(tensor, src)) {
+    return 0;
+  }
+  std::vector<int64_t> sizes, strides;
+  return THTensor_(copyPermuteDims)(src, sizes, strides) >= 2;
 }
 
-// special case copy where tensor is contiguous and src is a transposed matrix
-// This can be generalized to most copies, but it's tricker
-void THTensor_(copyTranspose)(THTensor *tensor, THTensor *src) {
+// special case copy where tensor is contiguous and src is a permutation of it,
+// e.g. a transposed matrix or NCHW <-> NHWC. When no dim of src has a smaller
+// stride than the last merged one, it is copied row by row. Otherwise the last dim and the
+// one src stores contiguously are copied by blocks, so that the lines of src
+// read for a block are still in cache when they are read again for its next
+// rows. The blocks are split between the threads.
+void THTensor_(copyPermute)(THTensor *tensor, THTensor *src) {
   #define MIN(x, y) (((x) < (y)) ? (x) : (y))
-  #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 
 #ifdef TH_REAL_IS_BYTE
-  const int BLOCK_SZ = 120;
+  const int64_t BLOCK_SZ = 120;
 #else
-  const int BLOCK_SZ = 60;
+  const int64_t BLOCK_SZ = 60;
 #endif
 
-  THTensor *buf = THTensor_(newWithSize2d)(BLOCK_SZ, BLOCK_SZ);
+  std::vector<int64_t> sizes, strides;
+  int64_t last = THTensor_(copyPermuteDims)(src, sizes, strides) - 1;
+  std::vector<int64_t> rstrides(last + 1, 1);
+  for (int64_t d = last - 1; d >= 0; d--) {
+    rstrides[d] = rstrides[d + 1] * sizes[d + 1];
+  }
+  // the dim src stores contiguously, which is last when rows can be copied
+  int64_t inner = last;
+  for (int64_t d = 0; d < last; d++) {
+    if (strides[d] < strides[inner]) {
+      inner = d;
+    }
+  }
+
   real *sp = THTensor_(data)(src);
   real *rp = THTensor_(data)(tensor);
-  real *bp = THTensor_(data)(buf);
-
+  ptrdiff_t size = THTensor_(nElement)(tensor);
 
-  int64_t NR = THTensor_(size)(src, 0);
-  int64_t NC = THTensor_(size)(src, 1);
-  for (int64_t R = 0; R < NR; R += BLOCK_SZ) {
-    for (int64_t C = 0; C < NC; C += BLOCK_SZ) {
-      real *spo = sp + R + C * NR;
-      real *rpo = rp + C + R * NC;
-
-      int nr = MIN(NR - R, BLOCK_SZ);
-      int nc = MIN(NC - C, BLOCK_SZ);
-
-      // 1. copy columns from src to buf
-      for (int c = 0; c < nc; c++) {
-        memcpy(bp + c * BLOCK_SZ, spo + c * NR, nr * sizeof(real));
+  int64_t NI = inner == last ? 1 : sizes[inner];
+  int64_t NL = sizes[last];
+  int64_t SI = strides[inner];
+  int64_t SL = strides[last];
+  int64_t RI = rstrides[inner];
+  int64_t blocks = (NI + BLOCK_SZ - 1) / BLOCK_SZ;
+  int64_t work = size / (NI * NL) * blocks;
+  int64_t w;
+#ifdef _OPENMP
+  #pragma omp parallel for if ((size > TH_OMP_OVERHEAD_THRESHOLD_COPY) && (!omp_in_parallel())) private(w)
+#endif
+  for (w = 0; w < work; w++) {
+    int64_t outer = w / blocks;
+    int64_t I = (w % blocks) * BLOCK_SZ;
+    int64_t ni = MIN(NI - I, BLOCK_SZ);
+    real *spo = sp + I * SI;
+    real *rpo = rp + I * RI;
+    for (int64_t d = last - 1; d >= 0; d--) {
+      if (d != inner) {
+        spo += (outer % sizes[d]) * strides[d];
+        rpo += (outer % sizes[d]) * rstrides[d];
+        outer /= sizes[d];
       }
+    }
 
-      // 2. transpose buf in place
-      int rc_max = MAX(nr, nc);
-      int rc_min = MIN(nr, nc);
-      for (int r = 0; r < rc_max; r++) {
-        int end = MIN(r, rc_min);
-        for (int c = 0; c < end; c++) {
-          real tmp = bp[r + BLOCK_SZ * c];
-          bp[r + BLOCK_SZ * c] = bp[r * BLOCK_SZ + c];
-          bp[r * BLOCK_SZ + c] = tmp;
+    if (inner == last) {
+      if (SL == 1) {
+        memcpy(rpo, spo, NL * sizeof(real));
+      } else {
+        for (int64_t l = 0; l < NL; l++) {
+          rpo[l] = spo[l * SL];
         }
       }
-
-      // 3. copy rows from buf to dst
-      for (int r = 0; r < nr; r++) {
-        memcpy(rpo + r * NC, bp + r * BLOCK_SZ, nc * sizeof(real));
+      continue;
+    }
+    for (int64_t L = 0; L < NL; L += BLOCK_SZ) {
+      int64_t nl = MIN(NL - L, BLOCK_SZ);
+      for (int64_t i = 0; i < ni; i++) {
+        real *spi = spo + i * SI + L * SL;
+        real *rpi = rpo + i * RI + L;
+        for (int64_t l = 0; l < nl; l++) {
+          rpi[l] = spi[l * SL];
+        }
       }
     }
   }
-  THTensor_(free)(buf);
   #undef MIN
-  #undef MAX
 }
 
 void THTensor_(copy)(THTensor *tensor, THTensor *src)
@@ -130,10 +179,8 @@ void THTensor_(copy)(THTensor *tensor, THTensor *src)
 
 #endif
 
-#ifndef TH_REAL_IS_HALF
-    } else if (THTensor_(copyTransposeValid)(tensor, src)) {
-      THTensor_(copyTranspose)(tensor, src);
-#endif
+    } else if (THTensor_(copyPermuteValid)(tensor, src)) {
+      THTensor_(copyPermute)(tensor, src);
     } else {
 #ifdef _OPENMP
       if (inOMP) {
@@ -193,29 +240,67 @@ struct inter_copy_type<uint8_t> {
 template<typename T>
 using inter_copy_type_t = typename inter_copy_type<T>::type;
 
+// Copies between tensors of different types with as many threads as the
+// copies between tensors of the same type.
+#ifdef _OPENMP
+#define TH_TENSOR_COPY_APPLY2(TYPE_SRC, CODE) \
+{ \
+  ptrdiff_t srcSize = THTensor_(nElement)(src); \
+  if (!omp_in_parallel() && THTensor_(nElement)(tensor) == srcSize) { \
+    int tensorContig = THTensor_(isContiguous)(tensor); \
+    int srcContig = THTensor_(isContiguous)(src); \
+    TH_TENSOR_APPLY2_OMP(srcSize, tensorContig, srcContig, real, tensor, TYPE_SRC, src, CODE, TH_OMP_OVERHEAD_THRESHOLD_COPY) \
+  } else { \
+    TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, CODE) \
+  } \
+}
+#else
+#define TH_TENSOR_COPY_APPLY2(TYPE_SRC, CODE) \
+  TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, CODE)
+#endif
+
+// Runs f(begin, end) over [0, size) split into one chunk per thread.
+template<typename F>
+static void THTensor_copyParallel(ptrdiff_t size, const F& f) {
+#ifdef _OPENMP
+  if ((size > TH_OMP_OVERHEAD_THRESHOLD_COPY) && (!omp_in_parallel())) {
+    #pragma omp parallel
+    {
+      ptrdiff_t num_threads = omp_get_num_threads();
+      ptrdiff_t tid = omp_get_thread_num();
+      ptrdiff_t begin = tid * (size / num_threads);
+      ptrdiff_t end = (tid == num_threads - 1) ? size : begin + size / num_threads;
+      f(begin, end);
+    }
+    return;
+  }
+#endif
+  f(0, size);
+}
+
 #endif
 
 #define IMPLEMENT_THTensor_COPY(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
-  TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, \
-                   *tensor_data = static_cast<real>( \
-                       static_cast<inter_copy_type_t<real>>(*src_data));) \
+  TH_TENSOR_COPY_APPLY2(TYPE_SRC, \
+                        *tensor_data = static_cast<real>( \
+                            static_cast<inter_copy_type_t<real>>(*src_data));) \
 }
 
 #define IMPLEMENT_THTensor_COPY_TO_HALF(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
- TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, *tensor_data = TH_float2half((float)*src_data);) \
+ TH_TENSOR_COPY_APPLY2(TYPE_SRC, *tensor_data = TH_float2half((float)*src_data);) \
 }
 
 #define IMPLEMENT_THTensor_COPY_FROM_HALF(TYPENAMESRC, TYPE_SRC) \
 void THTensor_(copy##TYPENAMESRC)(THTensor *tensor, TH##TYPENAMESRC##Tensor *src) \
 { \
- TH_TENSOR_APPLY2(real, tensor, TYPE_SRC, src, \
-                  *tensor_data = static_cast<real>( \
-                      static_cast<inter_copy_type_t<real>>( \
-                          TH_half2float(*src_data)));) \
+ TH_TENSOR_COPY_APPLY2(TYPE_SRC, \
+                       *tensor_data = static_cast<real>( \
+                           static_cast<inter_copy_type_t<real>>( \
+                               TH_half2float(*src_data)));) \
 }
 
 #define IMPLEMENT_THTensor_COPY_TO_FROM_HALF(TYPENAMESRC, TYPE_SRC) \
@@ -232,7 +317,24 @@ IMPLEMENT_THTensor_COPY(Int, int32_t)
 IMPLEMENT_THTensor_COPY(Long, int64_t)
 IMPLEMENT_THTensor_COPY(Float, float)
 IMPLEMENT_THTensor_COPY(Double, double)
+#ifdef TH_REAL_IS_FLOAT
+// contiguous tensors are converted with F16C where the CPU has it
+void THTensor_(copyHalf)(THTensor *tensor, THHalfTensor *src)
+{
+  if (THTensor_(isContiguous)(tensor) && THHalfTensor_isContiguous(src) &&
+      THTensor_(nElement)(tensor) == THHalfTensor_nElement(src)) {
+    float *rp = THTensor_(data)(tensor);
+    THHalf *sp = THHalfTensor_data(src);
+    THTensor_copyParallel(THTensor_(nElement)(tensor), [=](ptrdiff_t begin, ptrdiff_t end) {
+      THFloatVector_cvtFromHalf(rp + begin, sp + begin, end - begin);
+    });
+  } else {
+    TH_TENSOR_COPY_APPLY2(THHalf, *tensor_data = TH_half2float(*src_data);)
+  }
+}
+#else
 IMPLEMENT_THTensor_COPY_FROM_HALF(Half, THHalf)
+#endif
 #else
 /* only allow pass-through for Half */
 IMPLEMENT_THTensor_COPY_TO_FROM_HALF(Half, THHalf)
@@ -241,9 +343,22 @@ IMPLEMENT_THTensor_COPY_TO_HALF(Char, int8_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Short, int16_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Int, int32_t)
 IMPLEMENT_THTensor_COPY_TO_HALF(Long, int64_t)
-IMPLEMENT_THTensor_COPY_TO_HALF(Float, float)
 IMPLEMENT_THTensor_COPY_TO_HALF(Double, double)
 
+void THTensor_(copyFloat)(THTensor *tensor, THFloatTensor *src)
+{
+  if (THTensor_(isContiguous)(tensor) && THFloatTensor_isContiguous(src) &&
+      THTensor_(nElement)(tensor) == THFloatTensor_nElement(src)) {
+    THHalf *rp = THTensor_(data)(tensor);
+    float *sp = THFloatTensor_data(src);
+    THTensor_copyParallel(THTensor_(nElement)(tensor), [=](ptrdiff_t begin, ptrdiff_t end) {
+      THFloatVector_cvtToHalf(rp + begin, sp + begin, end - begin);
+    });
+  } else {
+    TH_TENSOR_COPY_APPLY2(float, *tensor_data = TH_float2half(*src_data);)
+  }
+}
+
 #endif /* REAL_IS_HALF */
 
 #endif
@@ -306,6 +306,42 @@ void THTensor_(nonzero)(THLongTensor *subscript, THTensor *tensor)
                   ++i;);
 }
 
+/* Number of elements in the dimensions before and after dim, so that a
+   contiguous tensor is an outer x size[dim] x inner array */
+static void THTensor_(outerInnerSize)(int64_t *size, int ndim, int dim, int64_t *outer, int64_t *inner)
+{
+  int d;
+  *outer = 1;
+  *inner = 1;
+  for (d = 0; d < dim; d++)
+    *outer *= size[d];
+  for (d = dim + 1; d < ndim; d++)
+    *inner *= size[d];
+}
+
+static int THTensor_(sizesEqualExceptDim)(int64_t *a, int64_t *b, int ndim, int dim)
+{
+  int d;
+  for (d = 0; d < ndim; d++) {
+    if (d != dim && a[d] != b[d])
+      return 0;
+  }
+  return 1;
+}
+
+/* Frees index and raises an error if one of its values is out of [0, size) */
+static void THTensor_(checkIndexRange)(THLongTensor *index, int64_t *index_data, ptrdiff_t numel, int64_t size)
+{
+  ptrdiff_t i;
+  int64_t max = size - 1 + TH_INDEX_BASE;
+  for (i=0; i<numel; i++) {
+    if (index_data[i] < TH_INDEX_BASE || index_data[i] > max) {
+      THLongTensor_free(index);
+      THError("index out of range");
+    }
+  }
+}
+
 void THTensor_(indexSelect)(THTensor *tensor, THTensor *src, int dim, THLongTensor *index)
 {
   ptrdiff_t i, numel;
@@ -344,14 +380,7 @@ void THTensor_(indexSelect)(THTensor *tensor, THTensor *src, int dim, THLongTens
     src_data = THTensor_(data)(src);
     ptrdiff_t rowsize = src->size[0] == 0 ? 1: THTensor_(nElement)(src) / src->size[0];
 
-    // check that the indices are within range
-    int64_t max = src->size[0] - 1 + TH_INDEX_BASE;
-    for (i=0; i<numel; i++) {
-      if (index_data[i] < TH_INDEX_BASE || index_data[i] > max) {
-        THLongTensor_free(index);
-        THError("index out of range");
-      }
-    }
+    THTensor_(checkIndexRange)(index, index_data, numel, src->size[0]);
 
     if (src->dim() == 1) {
       #pragma omp parallel for if(numel > TH_OMP_OVERHEAD_THRESHOLD) private(i)
@@ -363,6 +392,27 @@ void THTensor_(indexSelect)(THTensor *tensor, THTensor *src, int dim, THLongTens
         memcpy(tensor_data + i*rowsize, src_data + (index_data[i] - TH_INDEX_BASE)*rowsize, rowsize*sizeof(real));
     }
   }
+  else if (src->dim() > 1 && THTensor_(isContiguous)(src) && THTensor_(isContiguous)(tensor))
+  {
+    /* src is outer x size x inner and tensor outer x numel x inner, so every
+       selected slice is outer contiguous runs of inner elements */
+    int64_t outer, inner, size = src->size[dim], j;
+    THTensor_(outerInnerSize)(src->size, src->dim(), dim, &outer, &inner);
+    tensor_data = THTensor_(data)(tensor);
+    src_data = THTensor_(data)(src);
+
+    THTensor_(checkIndexRange)(index, index_data, numel, size);
+
+    #pragma omp parallel for if(outer*numel*inner > TH_OMP_OVERHEAD_THRESHOLD) private(j)
+    for (j=0; j<outer*numel; j++) {
+      const real *from = src_data + ((j / numel) * size + index_data[j % numel] - TH_INDEX_BASE) * inner;
+      real *to = tensor_data + j * inner;
+      if (inner == 1)
+        *to = *from;
+      else
+        memcpy(to, from, inner*sizeof(real));
+    }
+  }
   else if (src->dim() == 1)
   {
     for (i=0; i<numel; i++)
@@ -531,7 +581,62 @@ void THTensor_(indexAdd)(THTensor *tensor, int dim, THLongTensor *index, THTenso
   index = THLongTensor_newContiguous(index);
   index_data = THLongTensor_data(index);
 
-  if (tensor->dim() > 1)
+  if (tensor->dim() == src->dim() && THTensor_(isContiguous)(tensor) && THTensor_(isContiguous)(src) &&
+      THTensor_(sizesEqualExceptDim)(tensor->size, src->size, tensor->dim(), dim))
+  {
+    /* tensor is outer x size x inner and src outer x numel x inner */
+    int64_t outer, inner, size = tensor->size[dim], j;
+    THTensor_(outerInnerSize)(tensor->size, tensor->dim(), dim, &outer, &inner);
+    real *tensor_data = THTensor_(data)(tensor);
+    real *src_data = THTensor_(data)(src);
+
+    THTensor_(checkIndexRange)(index, index_data, numel, size);
+
+    if (outer*numel*inner > TH_OMP_OVERHEAD_THRESHOLD)
+    {
+      /* Without atomics, a destination slice must be updated by one thread
+         only: the positions are sorted (stably) by destination, and every
+         thread adds all the sources of a destination, in the order of the
+         index. The sums are then the same as those of the serial loop. */
+      std::vector<int64_t> order(numel);
+      std::vector<int64_t> groups;
+      std::iota(order.begin(), order.end(), 0);
+      std::stable_sort(order.begin(), order.end(), [index_data](int64_t a, int64_t b) {
+        return index_data[a] < index_data[b];
+      });
+      for (i=0; i<numel; i++) {
+        if (i == 0 || index_data[order[i]] != index_data[order[i-1]])
+          groups.push_back(i);
+      }
+      groups.push_back(numel);
+      int64_t numGroups = groups.size() - 1;
+
+      #pragma omp parallel for private(j)
+      for (j=0; j<outer*numGroups; j++) {
+        int64_t o = j / numGroups, g = j % numGroups, p;
+        real *to = tensor_data + (o * size + index_data[order[groups[g]]] - TH_INDEX_BASE) * inner;
+        for (p=groups[g]; p<groups[g+1]; p++) {
+          const real *from = src_data + (o * numel + order[p]) * inner;
+          if (inner == 1)
+            *to += *from;
+          else
+            THVector_(cadd)(to, to, from, 1, inner);
+        }
+      }
+    }
+    else
+    {
+      for (j=0; j<outer*numel; j++) {
+        real *to = tensor_data + ((j / numel) * size + index_data[j % numel] - TH_INDEX_BASE) * inner;
+        const real *from = src_data + j * inner;
+        if (inner == 1)
+          *to += *from;
+        else
+          THVector_(cadd)(to, to, from, 1, inner);
+      }
+    }
+  }
+  else if (tensor->dim() > 1)
   {
     tSlice = THTensor_(new)();
     sSlice = THTensor_(new)();
@@ -606,6 +711,42 @@ void THTensor_(gather)(THTensor *tensor, THTensor *src, int dim, THLongTensor *i
 
   elems_per_row = THLongTensor_size(index, dim);
 
+  if (THTensor_(isContiguous)(tensor) && THTensor_(isContiguous)(src) && THLongTensor_isContiguous(index) &&
+      THTensor_(sizesEqualExceptDim)(tensor->size, src->size, tensor->dim(), dim) &&
+      THTensor_(sizesEqualExceptDim)(tensor->size, index->size, tensor->dim(), -1))
+  {
+    /* tensor and index are outer x elems_per_row x inner and src outer x
+       size x inner: every output element is written once, so the rows are
+       gathered in parallel */
+    int64_t outer, inner, size = src->size[dim], j;
+    THTensor_(outerInnerSize)(tensor->size, tensor->dim(), dim, &outer, &inner);
+    real *tensor_data = THTensor_(data)(tensor);
+    real *src_data = THTensor_(data)(src);
+    int64_t *index_data = THLongTensor_data(index);
+    std::atomic<int64_t> invalidIdxPos(-1);
+
+    #pragma omp parallel for if(outer*elems_per_row*inner > TH_OMP_OVERHEAD_THRESHOLD) private(j)
+    for (j=0; j<outer*elems_per_row; j++) {
+      const int64_t *idx = index_data + j * inner;
+      const real *from = src_data + (j / elems_per_row) * size * inner;
+      real *to = tensor_data + j * inner;
+      int64_t k;
+      for (k=0; k<inner; k++) {
+        int64_t id = idx[k] - TH_INDEX_BASE;
+        if (id < 0 || id >= size) {
+          int64_t tmp = -1;
+          invalidIdxPos.compare_exchange_strong(tmp, j * inner + k);
+          break;
+        }
+        to[k] = from[id * inner + k];
+      }
+    }
+
+    if (invalidIdxPos >= 0)
+      THError("Invalid index in gather");
+    return;
+  }
+
   TH_TENSOR_DIM_APPLY3(real, tensor, real, src, int64_t, index, dim,
                        TH_TENSOR_DIM_APPLY3_SIZE_EQ_EXCEPT_DIM,
                        for (i = 0; i < elems_per_row; ++i)
@@ -620,6 +761,61 @@ void THTensor_(gather)(THTensor *tensor, THTensor *src, int dim, THLongTensor *i
                        })
 }
 
+/* Chunk of the inner dimension scattered by one thread */
+#define TH_SCATTER_CHUNK_SIZE 256
+
+/* scatter and scatterAdd of contiguous tensors, where src has the sizes of
+   index, and tensor too except along dim. They are viewed as outer x size x
+   inner arrays and each column tensor[o][.][k] is only written by one thread,
+   in the order of the index, so that duplicate indices give the same result
+   as the serial loop. Returns 0 if the tensors don't have this layout. */
+static int THTensor_(scatterContiguous)(THTensor *tensor, int dim, THLongTensor *index, THTensor *src, int accumulate)
+{
+  if (!THTensor_(isContiguous)(tensor) || !THTensor_(isContiguous)(src) || !THLongTensor_isContiguous(index) ||
+      !THTensor_(sizesEqualExceptDim)(src->size, index->size, tensor->dim(), -1) ||
+      !THTensor_(sizesEqualExceptDim)(tensor->size, index->size, tensor->dim(), dim))
+    return 0;
+
+  int64_t outer, inner, size = tensor->size[dim], elems_per_row = index->size[dim], j;
+  THTensor_(outerInnerSize)(index->size, index->dim(), dim, &outer, &inner);
+  int64_t chunks = (inner + TH_SCATTER_CHUNK_SIZE - 1) / TH_SCATTER_CHUNK_SIZE;
+  real *tensor_data = THTensor_(data)(tensor);
+  real *src_data = THTensor_(data)(src);
+  int64_t *index_data = THLongTensor_data(index);
+  std::atomic<int64_t> invalidIdxPos(-1);
+
+  #pragma omp parallel for if(outer*chunks > 1 && outer*elems_per_row*inner > TH_OMP_OVERHEAD_THRESHOLD) private(j)
+  for (j=0; j<outer*chunks; j++) {
+    int64_t o = j / chunks;
+    int64_t begin = (j % chunks) * TH_SCATTER_CHUNK_SIZE;
+    int64_t end = std::min<int64_t>(inner, begin + TH_SCATTER_CHUNK_SIZE);
+    real *to = tensor_data + o * size * inner;
+    int64_t i, k;
+    for (i=0; i<elems_per_row && invalidIdxPos < 0; i++) {
+      const int64_t *idx = index_data + (o * elems_per_row + i) * inner;
+      const real *from = src_data + (o * elems_per_row + i) * inner;
+      for (k=begin; k<end; k++) {
+        int64_t id = idx[k] - TH_INDEX_BASE;
+        if (id < 0 || id >= size) {
+          int64_t tmp = -1;
+          invalidIdxPos.compare_exchange_strong(tmp, (o * elems_per_row + i) * inner + k);
+          break;
+        }
+        if (accumulate)
+          to[id * inner + k] += from[k];
+        else
+          to[id * inner + k] = from[k];
+      }
+    }
+  }
+
+  if (invalidIdxPos >= 0)
+    THError(accumulate ? "Invalid index in scatterAdd" : "Invalid index in scatter");
+  return 1;
+}
+
+#undef TH_SCATTER_CHUNK_SIZE
+
 void THTensor_(scatter)(THTensor *tensor, int dim, THLongTensor *index, THTensor *src)
 {
   int64_t elems_per_row, i, idx;
@@ -640,6 +836,9 @@ void THTensor_(scatter)(THTensor *tensor, int dim, THLongTensor *index, THTensor
 
   elems_per_row = THLongTensor_size(index, dim);
 
+  if (THTensor_(scatterContiguous)(tensor, dim, index, src, 0))
+    return;
+
   TH_TENSOR_DIM_APPLY3(real, tensor, real, src, int64_t, index, dim,
                        TH_TENSOR_DIM_APPLY3_SIZE_SCATTER,
                        for (i = 0; i < elems_per_row; ++i)
@@ -666,6 +865,9 @@ void THTensor_(scatterAdd)(THTensor *tensor, int dim, THLongTensor *index, THTen
 
   elems_per_row = THLongTensor_size(index, dim);
 
+  if (THTensor_(scatterContiguous)(tensor, dim, index, src, 1))
+    return;
+
   TH_TENSOR_DIM_APPLY3(real, tensor, real, src, int64_t, index, dim,
                        TH_TENSOR_DIM_APPLY3_SIZE_SCATTER,
                        for (i = 0; i < elems_per_row; ++i)
@@ -2297,6 +2499,62 @@ void THTensor_(addbmm)(THTensor *result, real beta, THTensor *t, real alpha, THT
   THTensor_(free)(matrix2);
 }
 
+/* The batches of baddbmm whose matrices have no size above this are computed
+   directly instead of by a BLAS call each, whose overhead is larger than the
+   product for matrices that small. */
+#define TH_BADDBMM_SMALL_SIZE 8
+
+/* result[b] = beta * result[b] + alpha * batch1[b] * batch2[b] for matrices
+   of sizes M x K and K x N, with any strides. M, N and K are those of the
+   matrices if they are not zero, and are passed at run time otherwise. */
+template <int M_, int N_, int K_>
+static void THTensor_(baddbmmSmall)(int64_t bs, int64_t m, int64_t n, int64_t k,
+                                    real beta, real *r, const int64_t *rs,
+                                    real alpha, real *b1, const int64_t *b1s,
+                                    real *b2, const int64_t *b2s)
+{
+  const int64_t M = M_ ? M_ : m;
+  const int64_t N = N_ ? N_ : n;
+  const int64_t K = K_ ? K_ : k;
+  int64_t batch;
+#pragma omp parallel for if(bs * M * N * K > TH_OMP_OVERHEAD_THRESHOLD) private(batch)
+  for (batch = 0; batch < bs; batch++) {
+    real *r_ = r + batch * rs[0];
+    real *b1_ = b1 + batch * b1s[0];
+    real *b2_ = b2 + batch * b2s[0];
+    for (int64_t i = 0; i < M; i++) {
+      for (int64_t j = 0; j < N; j++) {
+        real sum = 0;
+        for (int64_t l = 0; l < K; l++)
+          sum += b1_[i * b1s[1] + l * b1s[2]] * b2_[l * b2s[1] + j * b2s[2]];
+        real *out = r_ + i * rs[1] + j * rs[2];
+        /* like BLAS, ignore the values of result if beta is 0 */
+        *out = beta == 0 ? alpha * sum : beta * *out + alpha * sum;
+      }
+    }
+  }
+}
+
+/* How gemm can read the last two dimensions (rows, cols) of t: as the
+   column-major cols x rows matrix of a row-major t ('n'), or as the
+   transposed one of a column-major t ('t'). Returns 0 if it can't. */
+static int THTensor_(gemmLayout)(THTensor *t, char *trans, int64_t *ld)
+{
+  int64_t rows = t->size[1], cols = t->size[2];
+  int64_t row_stride = t->stride[1], col_stride = t->stride[2];
+  if ((col_stride == 1 || cols == 1) && (rows == 1 || row_stride >= THMax(1, cols))) {
+    *trans = 'n';
+    *ld = rows == 1 ? THMax(1, cols) : row_stride;
+    return 1;
+  }
+  if ((row_stride == 1 || rows == 1) && (cols == 1 || col_stride >= THMax(1, rows))) {
+    *trans = 't';
+    *ld = cols == 1 ? THMax(1, rows) : col_stride;
+    return 1;
+  }
+  return 0;
+}
+
 void THTensor_(baddbmm)(THTensor *result, real beta, THTensor *t, real alpha, THTensor *batch1, THTensor *batch2)
 {
   int64_t batch;
@@ -2325,6 +2583,55 @@ void THTensor_(baddbmm)(THTensor *result, real beta, THTensor *t, real alpha, TH
     }
   }
 
+  int64_t dim12 = THTensor_(size)(batch1, 2);
+  if (bs == 0 || dim1 == 0 || dim2 == 0) {
+    return;
+  }
+
+  if (dim1 <= TH_BADDBMM_SMALL_SIZE && dim2 <= TH_BADDBMM_SMALL_SIZE &&
+      dim12 <= TH_BADDBMM_SMALL_SIZE) {
+    real *r = THTensor_(data)(result);
+    real *b1 = THTensor_(data)(batch1);
+    real *b2 = THTensor_(data)(batch2);
+    /* the sizes of the 3D and 4D transforms of physics and graphics are
+       compile-time constants, so that their loops are unrolled */
+    if (dim1 == 3 && dim2 == 3 && dim12 == 3) {
+      THTensor_(baddbmmSmall)<3, 3, 3>(bs, 3, 3, 3, beta, r, result->stride, alpha, b1, batch1->stride, b2, batch2->stride);
+    } else if (dim1 == 4 && dim2 == 4 && dim12 == 4) {
+      THTensor_(baddbmmSmall)<4, 4, 4>(bs, 4, 4, 4, beta, r, result->stride, alpha, b1, batch1->stride, b2, batch2->stride);
+    } else if (dim1 == 3 && dim2 == 1 && dim12 == 3) {
+      THTensor_(baddbmmSmall)<3, 1, 3>(bs, 3, 1, 3, beta, r, result->stride, alpha, b1, batch1->stride, b2, batch2->stride);
+    } else if (dim1 == 4 && dim2 == 1 && dim12 == 4) {
+      THTensor_(baddbmmSmall)<4, 1, 4>(bs, 4, 1, 4, beta, r, result->stride, alpha, b1, batch1->stride, b2, batch2->stride);
+    } else {
+      THTensor_(baddbmmSmall)<0, 0, 0>(bs, dim1, dim2, dim12, beta, r, result->stride, alpha, b1, batch1->stride, b2, batch2->stride);
+    }
+    return;
+  }
+
+  /* result[b]^T = batch2[b]^T * batch1[b]^T in column-major, as in addmm, in
+     a single BLAS call if the matrices of each tensor are laid out alike */
+  char trans_r, trans1, trans2;
+  int64_t ld_r, ld1, ld2;
+  if (THTensor_(gemmLayout)(result, &trans_r, &ld_r) && trans_r == 'n' &&
+      THTensor_(gemmLayout)(batch1, &trans1, &ld1) &&
+      THTensor_(gemmLayout)(batch2, &trans2, &ld2)) {
+    real **pointers = (real**)THAlloc(3 * bs * sizeof(real*));
+    real **r_pointers = pointers;
+    real **b1_pointers = pointers + bs;
+    real **b2_pointers = pointers + 2 * bs;
+    for (batch = 0; batch < bs; ++batch) {
+      r_pointers[batch] = THTensor_(data)(result) + batch * result->stride[0];
+      b1_pointers[batch] = THTensor_(data)(batch1) + batch * batch1->stride[0];
+      b2_pointers[batch] = THTensor_(data)(batch2) + batch * batch2->stride[0];
+    }
+    THBlas_(gemmBatched)(trans2, trans1, bs, dim2, dim1, dim12,
+                         alpha, b2_pointers, ld2, b1_pointers, ld1,
+                         beta, r_pointers, ld_r);
+    THFree(pointers);
+    return;
+  }
+
   THTensor *matrix1 = THTensor_(new)();
   THTensor *matrix2 = THTensor_(new)();
   THTensor *result_matrix = THTensor_(new)();
@@ -3191,6 +3498,82 @@ static void THTensor_(quicksortdescend)(real *arr, int64_t *idx, int64_t element
 #undef MAX_LEVELS
 #undef M_SMALL
 
+#if defined(TH_REAL_IS_BYTE) || defined(TH_REAL_IS_CHAR) || defined(TH_REAL_IS_SHORT) || \
+    defined(TH_REAL_IS_INT) || defined(TH_REAL_IS_LONG)
+#define TH_SORT_USE_RADIX 1
+/* Slices at least this long are radix sorted */
+#define RADIX_SORT_MIN_SIZE 256
+
+/* Stable LSD radix sort of (arr, idx), one byte per pass. The keys are mapped
+   to unsigned integers with the same order (inverted for a descending sort),
+   so ties keep the order of their indices. Passes over a byte that is the same
+   for all keys are skipped.
+   keys, idxs: scratch space for 2 * elements keys and indices */
+static void THTensor_(radixsort)(real *arr, int64_t *idx, int64_t elements, int64_t stride,
+                                 int descendingOrder, ureal *keys, int64_t *idxs)
+{
+  const ureal flip = ((real)-1 < (real)0) ? (ureal)((ureal)1 << (sizeof(real) * 8 - 1)) : 0;
+  const ureal invert = descendingOrder ? (ureal)~(ureal)0 : 0;
+  ureal *keysIn = keys, *keysOut = keys + elements;
+  int64_t *idxsIn = idxs, *idxsOut = idxs + elements;
+  int64_t counts[256];
+  int64_t i;
+  size_t pass;
+
+  for (i = 0; i < elements; i++) {
+    keysIn[i] = ((ureal)ARR(i) ^ flip) ^ invert;
+    idxsIn[i] = IDX(i);
+  }
+
+  for (pass = 0; pass < sizeof(real); pass++) {
+    const int shift = (int)(pass * 8);
+    int64_t sum = 0;
+    int b;
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < elements; i++)
+      counts[(keysIn[i] >> shift) & 0xff]++;
+    if (counts[(keysIn[0] >> shift) & 0xff] == elements)
+      continue;
+    for (b = 0; b < 256; b++) {
+      int64_t count = counts[b];
+      counts[b] = sum;
+      sum += count;
+    }
+    for (i = 0; i < elements; i++) {
+      int64_t pos = counts[(keysIn[i] >> shift) & 0xff]++;
+      keysOut[pos] = keysIn[i];
+      idxsOut[pos] = idxsIn[i];
+    }
+    {
+      ureal *keysTmp = keysIn; keysIn = keysOut; keysOut = keysTmp;
+    }
+    {
+      int64_t *idxsTmp = idxsIn; idxsIn = idxsOut; idxsOut = idxsTmp;
+    }
+  }
+
+  for (i = 0; i < elements; i++) {
+    ARR(i) = (real)((keysIn[i] ^ invert) ^ flip);
+    IDX(i) = idxsIn[i];
+  }
+}
+#endif
+
+/* Offset of the first element of the slice-th slice of t along dimension,
+   counting the slices in row-major order */
+static ptrdiff_t THTensor_(sliceOffset)(THTensor *t, int dimension, int64_t slice)
+{
+  ptrdiff_t offset = 0;
+  int d;
+  for (d = THTensor_(nDimension)(t) - 1; d >= 0; d--) {
+    if (d == dimension)
+      continue;
+    offset += (slice % t->size[d]) * t->stride[d];
+    slice /= t->size[d];
+  }
+  return offset;
+}
+
 void THTensor_(sort)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int dimension, int descendingOrder)
 {
   THArgCheck(dimension >= 0 && dimension < THTensor_(nDimension)(t), 2, "invalid dimension %d",
@@ -3205,24 +3588,58 @@ void THTensor_(sort)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int dimensio
     THLongStorage_free(size);
   }
 
-  if(descendingOrder)
-  {
-    TH_TENSOR_DIM_APPLY2(real, rt_, int64_t, ri_, dimension,
-                         int64_t i;
-                         for(i = 0; i < ri__size; i++)
-                           ri__data[i*ri__stride] = i;
-                         THTensor_(quicksortdescend)(rt__data, ri__data, rt__size, rt__stride);)
-      }
-  else
+  int64_t numel = THTensor_(nElement)(rt_);
+  if (numel == 0)
+    return;
+
+  /* The slices are independent, so they are sorted in parallel */
+  int64_t sliceSize = rt_->size[dimension];
+  int64_t numSlices = numel / sliceSize;
+  int64_t stride = rt_->stride[dimension];
+  real *rt_data = THTensor_(data)(rt_);
+  int64_t *ri_data = THLongTensor_data(ri_);
+
+#pragma omp parallel if(numSlices > 1 && numel > TH_OMP_OVERHEAD_THRESHOLD)
   {
-    TH_TENSOR_DIM_APPLY2(real, rt_, int64_t, ri_, dimension,
-                         int64_t i;
-                         for(i = 0; i < ri__size; i++)
-                           ri__data[i*ri__stride] = i;
-                         THTensor_(quicksortascend)(rt__data, ri__data, rt__size, rt__stride);)
+#ifdef TH_SORT_USE_RADIX
+    ureal *keys = NULL;
+    int64_t *idxs = NULL;
+    if (sliceSize >= RADIX_SORT_MIN_SIZE) {
+      keys = (ureal *)THAlloc(2 * sliceSize * sizeof(ureal));
+      idxs = (int64_t *)THAlloc(2 * sliceSize * sizeof(int64_t));
+    }
+#endif
+    int64_t slice;
+#pragma omp for
+    for (slice = 0; slice < numSlices; slice++) {
+      real *arr = rt_data + THTensor_(sliceOffset)(rt_, dimension, slice);
+      int64_t *idx = ri_data + THTensor_(sliceOffset)(ri_, dimension, slice);
+      int64_t i;
+      for (i = 0; i < sliceSize; i++)
+        IDX(i) = i;
+#ifdef TH_SORT_USE_RADIX
+      if (keys != NULL) {
+        THTensor_(radixsort)(arr, idx, sliceSize, stride, descendingOrder, keys, idxs);
+        continue;
       }
+#endif
+      if (descendingOrder)
+        THTensor_(quicksortdescend)(arr, idx, sliceSize, stride);
+      else
+        THTensor_(quicksortascend)(arr, idx, sliceSize, stride);
+    }
+#ifdef TH_SORT_USE_RADIX
+    THFree(keys);
+    THFree(idxs);
+#endif
+  }
 }
 
+#ifdef TH_SORT_USE_RADIX
+#undef TH_SORT_USE_RADIX
+#undef RADIX_SORT_MIN_SIZE
+#endif
+
 /* Implementation of the Quickselect algorithm, based on Nicolas Devillard's
 public domain implementation at http://ndevilla.free.fr/median/median/
 Adapted similarly to the above Quicksort algorithm.
@@ -3468,63 +3885,66 @@ void THTensor_(topk)(THTensor *rt_, THLongTensor *ri_, THTensor *t, int64_t k, i
   THArgCheck(k >= 0 && k <= sliceSize, 2, "k not in range for dimension");
 #endif
 
-  THTensor *tmpResults = THTensor_(new)();
-  THTensor_(resize1d)(tmpResults, sliceSize);
-  real *tmp__data = THTensor_(data)(tmpResults);
-
-  THLongTensor *tmpIndices = THLongTensor_new();
-  THLongTensor_resize1d(tmpIndices, sliceSize);
-  int64_t *tmpi__data = THLongTensor_data(tmpIndices);
-
   THLongStorage *topKSize = THTensor_(newSizeOf)(t);
   THLongStorage_set(topKSize, dim, k);
   THTensor_(resize)(rt_, topKSize, NULL);
   THLongTensor_resize(ri_, topKSize, NULL);
   THLongStorage_free(topKSize);
 
-  if (dir) {
-    /* k largest elements, descending order (optional: see sorted) */
-    int64_t K = sliceSize - k;
-    TH_TENSOR_DIM_APPLY3(real, t, real, rt_, int64_t, ri_, dim,
-                         TH_TENSOR_DIM_APPLY3_SIZE_EQ_EXCEPT_DIM,
-                         int64_t i;
-                         for(i = 0; i < sliceSize; i++)
-                         {
-                           tmp__data[i] = t_data[i*t_stride];
-                           tmpi__data[i] = i;
-                         }
-                         if (K > 0)
-                           THTensor_(quickselect)(tmp__data, tmpi__data, K - 1, sliceSize, 1);
-                         if (sorted)
-                           THTensor_(quicksortdescend)(tmp__data + K, tmpi__data + K, k, 1);
-                         for(i = 0; i < k; i++)
-                         {
-                           rt__data[i*rt__stride] = tmp__data[i + K];
-                           ri__data[i*ri__stride] = tmpi__data[i + K];
-                         })
-  }
-  else {
-    /* k smallest elements, ascending order (optional: see sorted) */
-    TH_TENSOR_DIM_APPLY3(real, t, real, rt_, int64_t, ri_, dim,
-                         TH_TENSOR_DIM_APPLY3_SIZE_EQ_EXCEPT_DIM,
-                         int64_t i;
-                         for(i = 0; i < sliceSize; i++)
-                         {
-                           tmp__data[i] = t_data[i*t_stride];
-                           tmpi__data[i] = i;
-                         }
-                         THTensor_(quickselect)(tmp__data, tmpi__data, k - 1, sliceSize, 1);
-                         if (sorted)
-                           THTensor_(quicksortascend)(tmp__data, tmpi__data, k - 1, 1);
-                         for(i = 0; i < k; i++)
-                         {
-                           rt__data[i*rt__stride] = tmp__data[i];
-                           ri__data[i*ri__stride] = tmpi__data[i];
-                         })
-  }
+  int64_t numel = THTensor_(nElement)(t);
+  if (numel == 0 || k == 0)
+    return;
+
+  /* The slices are independent, so they are selected in parallel, each
+     thread with its own scratch space */
+  int64_t numSlices = numel / sliceSize;
+  int64_t t_stride = t->stride[dim];
+  int64_t rt__stride = rt_->stride[dim];
+  int64_t ri__stride = ri_->stride[dim];
+  real *t_data = THTensor_(data)(t);
+  real *rt_data = THTensor_(data)(rt_);
+  int64_t *ri_data = THLongTensor_data(ri_);
 
-  THTensor_(free)(tmpResults);
-  THLongTensor_free(tmpIndices);
+#pragma omp parallel if(numSlices > 1 && numel > TH_OMP_OVERHEAD_THRESHOLD)
+  {
+    real *tmp__data = (real *)THAlloc(sliceSize * sizeof(real));
+    int64_t *tmpi__data = (int64_t *)THAlloc(sliceSize * sizeof(int64_t));
+    int64_t slice;
+#pragma omp for
+    for (slice = 0; slice < numSlices; slice++) {
+      real *t_slice = t_data + THTensor_(sliceOffset)(t, dim, slice);
+      real *rt__slice = rt_data + THTensor_(sliceOffset)(rt_, dim, slice);
+      int64_t *ri__slice = ri_data + THTensor_(sliceOffset)(ri_, dim, slice);
+      int64_t i;
+      for (i = 0; i < sliceSize; i++) {
+        tmp__data[i] = t_slice[i*t_stride];
+        tmpi__data[i] = i;
+      }
+      if (dir) {
+        /* k largest elements, descending order (optional: see sorted) */
+        int64_t K = sliceSize - k;
+        if (K > 0)
+          THTensor_(quickselect)(tmp__data, tmpi__data, K - 1, sliceSize, 1);
+        if (sorted)
+          THTensor_(quicksortdescend)(tmp__data + K, tmpi__data + K, k, 1);
+        for (i = 0; i < k; i++) {
+          rt__slice[i*rt__stride] = tmp__data[i + K];
+          ri__slice[i*ri__stride] = tmpi__data[i + K];
+        }
+      } else {
+        /* k smallest elements, ascending order (optional: see sorted) */
+        THTensor_(quickselect)(tmp__data, tmpi__data, k - 1, sliceSize, 1);
+        if (sorted)
+          THTensor_(quicksortascend)(tmp__data, tmpi__data, k - 1, 1);
+        for (i = 0; i < k; i++) {
+          rt__slice[i*rt__stride] = tmp__data[i];
+          ri__slice[i*ri__stride] = tmpi__data[i];
+        }
+      }
+    }
+    THFree(tmp__data);
+    THFree(tmpi__data);
+  }
 }
 
 void THTensor_(tril)(THTensor *r_, THTensor *t, int64_t k)
@@ -11,6 +11,19 @@
 #include <cpuinfo.h>
 
 #include "THGenerator.hpp"
+#include "THPhilox.h"
+
+#ifndef TH_RANDOM_PHILOX_CHUNK
+/* Contiguous tensors are filled from a Philox stream instead of the Mersenne
+   Twister, so that they can be filled in parallel. The key of the stream is
+   drawn from the generator, which is locked only for that draw, and element i
+   of the tensor uses the bits of block i / (elements per block) of the
+   stream. The result does not depend on the number of threads, and restoring
+   the state of the generator repeats the fill. */
+/* Elements per parallel task, a multiple of 16 for the Box-Muller pairs */
+#define TH_RANDOM_PHILOX_CHUNK 4096
+#define TH_RANDOM_OMP_OVERHEAD_THRESHOLD 100000
+#endif
 
 void THTensor_(random)(THTensor *self, THGenerator *_generator)
 {
@@ -132,6 +145,28 @@ void THTensor_(iBernoulli_generate_copy)(THTensor *self, THGenerator *_generator
 
 #endif
 
+static void THTensor_(bernoulliPhilox)(THTensor *self, THGenerator *_generator, double p)
+{
+  uint64_t key;
+  {
+    std::lock_guard<std::mutex> lock(_generator->mutex);
+    key = THRandom_random64(_generator);
+  }
+  real *data = THTensor_(data)(self);
+  int64_t n = THTensor_(nElement)(self);
+  int64_t blocks = (n + 3) / 4;
+  int64_t block;
+#pragma omp parallel for if(n > TH_RANDOM_OMP_OVERHEAD_THRESHOLD) private(block)
+  for (block = 0; block < blocks; block++) {
+    uint32_t bits[4];
+    THPhilox_block(key, block, bits);
+    int64_t count = n - block * 4 < 4 ? n - block * 4 : 4;
+    int64_t j;
+    for (j = 0; j < count; j++)
+      data[block * 4 + j] = (real)(bits[j] * (1.0 / 4294967296.0) < p);
+  }
+}
+
 void THTensor_(bernoulli)(THTensor *self, THGenerator *_generator, double p)
 {
 #ifdef TH_BLAS_MKL
@@ -143,6 +178,10 @@ void THTensor_(bernoulli)(THTensor *self, THGenerator *_generator, double p)
     TH_TENSOR_APPLY(real, self, *self_data = (real)THRandom_bernoulli(_generator, p););
   }
 #else
+  if (THTensor_(isContiguous)(self)) {
+    THTensor_(bernoulliPhilox)(self, _generator, p);
+    return;
+  }
   std::lock_guard<std::mutex> lock(_generator->mutex);
   TH_TENSOR_APPLY(real, self, *self_data = (real)THRandom_bernoulli(_generator, p););
 #endif
@@ -177,8 +216,56 @@ void THTensor_(bernoulli_Tensor)(THTensor *self, THGenerator *_generator, THTens
 #endif
 }
 
+/* Fills out[0, end - begin) with the uniform samples on [a, b) of elements
+   [begin, end) of the Philox stream of key. begin must be a multiple of the
+   elements per block. */
+static void THTensor_(uniformPhiloxRange)(real *out, int64_t begin, int64_t end,
+                                          uint64_t key, real a, real b)
+{
+#if defined(TH_REAL_IS_FLOAT)
+  const int64_t perBlock = 4;
+#else
+  const int64_t perBlock = 2;
+#endif
+  int64_t i;
+  for (i = begin; i < end; i += perBlock) {
+    uint32_t bits[4];
+    THPhilox_block(key, i / perBlock, bits);
+    int64_t count = end - i < perBlock ? end - i : perBlock;
+    int64_t j;
+    for (j = 0; j < count; j++) {
+#if defined(TH_REAL_IS_FLOAT)
+      out[i - begin + j] = THPhilox_uniformFloat(bits[j]) * (b - a) + a;
+#else
+      out[i - begin + j] = THPhilox_uniformDouble(bits[2 * j], bits[2 * j + 1]) * (b - a) + a;
+#endif
+    }
+  }
+}
+
+static uint64_t THTensor_(philoxKey)(THGenerator *_generator)
+{
+  std::lock_guard<std::mutex> lock(_generator->mutex);
+  return THRandom_random64(_generator);
+}
+
 void THTensor_(uniform)(THTensor *self, THGenerator *_generator, double a, double b)
 {
+  if (THTensor_(isContiguous)(self)) {
+    uint64_t key = THTensor_(philoxKey)(_generator);
+    real *data = THTensor_(data)(self);
+    int64_t n = THTensor_(nElement)(self);
+    int64_t chunks = (n + TH_RANDOM_PHILOX_CHUNK - 1) / TH_RANDOM_PHILOX_CHUNK;
+    int64_t chunk;
+#pragma omp parallel for if(n > TH_RANDOM_OMP_OVERHEAD_THRESHOLD) private(chunk)
+    for (chunk = 0; chunk < chunks; chunk++) {
+      int64_t begin = chunk * TH_RANDOM_PHILOX_CHUNK;
+      int64_t end = begin + TH_RANDOM_PHILOX_CHUNK < n ? begin + TH_RANDOM_PHILOX_CHUNK : n;
+      THTensor_(uniformPhiloxRange)(data + begin, begin, end, key, (real)a, (real)b);
+    }
+    return;
+  }
+
   std::lock_guard<std::mutex> lock(_generator->mutex);
   #if defined(TH_REAL_IS_FLOAT)
   TH_TENSOR_APPLY(real, self, *self_data =
@@ -191,13 +278,33 @@ void THTensor_(uniform)(THTensor *self, THGenerator *_generator, double a, doubl
 
 void THTensor_(normal)(THTensor *self, THGenerator *_generator, double mean, double stddev)
 {
-  std::lock_guard<std::mutex> lock(_generator->mutex);
-  const int64_t size = THTensor_(numel)(self);
-  if (size >= 16 && THTensor_(isContiguous)(self)) {
-    THVector_(normal_fill)(THStorage_(data)(self->storage), size, _generator, mean, stddev);
-  } else {
-    TH_TENSOR_APPLY(real, self, *self_data = (real)THRandom_normal(_generator, mean, stddev););
+  if (THTensor_(isContiguous)(self)) {
+    uint64_t key = THTensor_(philoxKey)(_generator);
+    real *data = THTensor_(data)(self);
+    int64_t n = THTensor_(nElement)(self);
+    int64_t full = n - n % 16;
+    int64_t chunks = (full + TH_RANDOM_PHILOX_CHUNK - 1) / TH_RANDOM_PHILOX_CHUNK;
+    int64_t chunk;
+#pragma omp parallel for if(n > TH_RANDOM_OMP_OVERHEAD_THRESHOLD) private(chunk)
+    for (chunk = 0; chunk < chunks; chunk++) {
+      int64_t begin = chunk * TH_RANDOM_PHILOX_CHUNK;
+      int64_t end = begin + TH_RANDOM_PHILOX_CHUNK < full ? begin + TH_RANDOM_PHILOX_CHUNK : full;
+      THTensor_(uniformPhiloxRange)(data + begin, begin, end, key, 0, 1);
+      THVector_(normal_from_uniform)(data + begin, end - begin, mean, stddev);
+    }
+    if (full < n) {
+      /* The last n % 16 samples are the first of the 16 normal samples of
+         elements [full, full + 16) of the stream */
+      real tail[16];
+      THTensor_(uniformPhiloxRange)(tail, full, full + 16, key, 0, 1);
+      THVector_(normal_from_uniform)(tail, 16, mean, stddev);
+      memcpy(data + full, tail, (n - full) * sizeof(real));
+    }
+    return;
   }
+
+  std::lock_guard<std::mutex> lock(_generator->mutex);
+  TH_TENSOR_APPLY(real, self, *self_data = (real)THRandom_normal(_generator, mean, stddev););
 }
 
 void THTensor_(normal_means)(THTensor *self, THGenerator *gen, THTensor *means, double stddev)
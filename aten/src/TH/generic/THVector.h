@@ -19,10 +19,22 @@ TH_API void THVector_(normal_fill)(real *data,
                                    struct THGenerator *generator,
                                    const real mean,
                                    const real stddev);
+/* Replaces the size uniform [0, 1) samples in data with normal samples by
+   the Box-Muller transform of the pairs (data[i], data[i + 8]) of every 16
+   consecutive samples. size must be a multiple of 16. */
+TH_API void THVector_(normal_from_uniform)(real *data,
+                                           const int64_t size,
+                                           const real mean,
+                                           const real stddev);
 #ifndef TH_REAL_IS_INT
 TH_API void THVector_(cvtFromInt)(real *y, const int *x, const ptrdiff_t n);
 #endif
 
+#if defined(TH_REAL_IS_FLOAT)
+TH_API void THVector_(cvtFromHalf)(real *y, const THHalf *x, const ptrdiff_t n);
+TH_API void THVector_(cvtToHalf)(THHalf *y, const real *x, const ptrdiff_t n);
+#endif
+
 #if defined(TH_REAL_IS_SHORT) || defined(TH_REAL_IS_INT) || defined(TH_REAL_IS_LONG)
 TH_API void THVector_(abs)(real *y, const real *x, const ptrdiff_t n);
 #endif
@@ -148,6 +148,20 @@ void THVector_(cvtFromInt_DEFAULT)(real *y, const int *x, const ptrdiff_t n)
 }
 #endif
 
+#if defined(TH_REAL_IS_FLOAT)
+void THVector_(cvtFromHalf_DEFAULT)(real *y, const THHalf *x, const ptrdiff_t n)
+{
+  for(ptrdiff_t i = 0; i < n; i++)
+    y[i] = TH_half2float(x[i]);
+}
+
+void THVector_(cvtToHalf_DEFAULT)(THHalf *y, const real *x, const ptrdiff_t n)
+{
+  for(ptrdiff_t i = 0; i < n; i++)
+    y[i] = TH_float2half(x[i]);
+}
+#endif
+
 // Fills 16 normally distributed samples into data, interleaved with a
 // stride of 8, i.e. in order of ([0], [8]), ([1], [9]), ...
 static void THVector_(interleaved_normal_fill_16)(real *data,
@@ -166,6 +180,16 @@ static void THVector_(interleaved_normal_fill_16)(real *data,
   }
 }
 
+void THVector_(normal_from_uniform_DEFAULT)(real *data,
+                                            const int64_t size,
+                                            const real mean,
+                                            const real stddev)
+{
+  for (int64_t i = 0; i < size - 15; i += 16) {
+    THVector_(interleaved_normal_fill_16)(data + i, mean, stddev);
+  }
+}
+
 void THVector_(normal_fill_DEFAULT)(real *data,
                                     int64_t size,
                                     THGenerator *generator,
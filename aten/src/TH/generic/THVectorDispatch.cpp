@@ -262,6 +262,33 @@ void THVector_(cvtFromInt)(real *y, const int *x, const ptrdiff_t n) {
 }
 #endif
 
+#if defined(TH_REAL_IS_FLOAT)
+/* The AVX2 implementations use F16C, which every CPU with AVX2 has */
+static void (*THVector_(cvtFromHalf_DISPATCHPTR))(real *, const THHalf *, const ptrdiff_t) = &THVector_(cvtFromHalf_DEFAULT);
+static FunctionDescription THVector_(cvtFromHalf_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+      FUNCTION_IMPL(THVector_(cvtFromHalf_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  FUNCTION_IMPL(THVector_(cvtFromHalf_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(cvtFromHalf)(real *y, const THHalf *x, const ptrdiff_t n) {
+  THVector_(cvtFromHalf_DISPATCHPTR)(y, x, n);
+}
+
+static void (*THVector_(cvtToHalf_DISPATCHPTR))(THHalf *, const real *, const ptrdiff_t) = &THVector_(cvtToHalf_DEFAULT);
+static FunctionDescription THVector_(cvtToHalf_DISPATCHTABLE)[] = {
+  #if defined(USE_AVX2)
+      FUNCTION_IMPL(THVector_(cvtToHalf_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  FUNCTION_IMPL(THVector_(cvtToHalf_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(cvtToHalf)(THHalf *y, const real *x, const ptrdiff_t n) {
+  THVector_(cvtToHalf_DISPATCHPTR)(y, x, n);
+}
+#endif
+
 static void (*THVector_(normal_fill_DISPATCHPTR))(real *, const int64_t, THGenerator *, const real, const real) = &THVector_(normal_fill_DEFAULT);
 static FunctionDescription THVector_(normal_fill_DISPATCHTABLE)[] = {
   #if defined(TH_REAL_IS_FLOAT) && defined(USE_AVX2)
@@ -278,6 +305,21 @@ void THVector_(normal_fill)(real *data,
   THVector_(normal_fill_DISPATCHPTR)(data, size, generator, mean, stddev);
 }
 
+static void (*THVector_(normal_from_uniform_DISPATCHPTR))(real *, const int64_t, const real, const real) = &THVector_(normal_from_uniform_DEFAULT);
+static FunctionDescription THVector_(normal_from_uniform_DISPATCHTABLE)[] = {
+  #if defined(TH_REAL_IS_FLOAT) && defined(USE_AVX2)
+      FUNCTION_IMPL(THVector_(normal_from_uniform_AVX2), SIMDExtension_AVX2),
+  #endif
+
+  FUNCTION_IMPL(THVector_(normal_from_uniform_DEFAULT), SIMDExtension_DEFAULT)
+};
+void THVector_(normal_from_uniform)(real *data,
+                                    const int64_t size,
+                                    const real mean,
+                                    const real stddev) {
+  THVector_(normal_from_uniform_DISPATCHPTR)(data, size, mean, stddev);
+}
+
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
 static void (*THVector_(sigmoid_DISPATCHPTR))(real *, const real *, const ptrdiff_t) = &THVector_(sigmoid_DEFAULT);
 static FunctionDescription THVector_(sigmoid_DISPATCHTABLE)[] = {
@@ -312,11 +354,17 @@ struct THVector_(startup) {
     INIT_DISPATCH_PTR(divs);
     INIT_DISPATCH_PTR(copy);
     INIT_DISPATCH_PTR(normal_fill);
+    INIT_DISPATCH_PTR(normal_from_uniform);
 
 #ifndef TH_REAL_IS_INT
     INIT_DISPATCH_PTR(cvtFromInt);
 #endif
 
+#if defined(TH_REAL_IS_FLOAT)
+    INIT_DISPATCH_PTR(cvtFromHalf);
+    INIT_DISPATCH_PTR(cvtToHalf);
+#endif
+
 #if defined(TH_REAL_IS_FLOAT) || defined(TH_REAL_IS_DOUBLE)
     INIT_DISPATCH_PTR(sigmoid);
 #endif
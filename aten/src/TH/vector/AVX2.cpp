@@ -105,6 +105,22 @@ void THFloatVector_normal_fill_AVX2(float *data,
   }
 }
 
+void THFloatVector_normal_from_uniform_AVX2(float *data,
+                                            const int64_t size,
+                                            const float mean,
+                                            const float stddev)
+{
+  const __m256 two_pi = _mm256_set1_ps(2.0f * M_PI);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 minus_two = _mm256_set1_ps(-2.0f);
+  const __m256 mean_v = _mm256_set1_ps(mean);
+  const __m256 stddev_v = _mm256_set1_ps(stddev);
+
+  for (int64_t i = 0; i < size - 15; i += 16) {
+    normal_fill_16_AVX2(data + i, &two_pi, &one, &minus_two, &mean_v, &stddev_v);
+  }
+}
+
 void THFloatVector_sigmoid_AVX2(float *y, const float *x, const ptrdiff_t n) {
   ptrdiff_t i;
   const __m256 one = _mm256_set1_ps(1.0f);
@@ -127,4 +143,31 @@ void THFloatVector_sigmoid_AVX2(float *y, const float *x, const ptrdiff_t n) {
   }
 }
 
+// The conversions round to nearest even, like TH_float2half.
+void THFloatVector_cvtFromHalf_AVX2(float *y, const THHalf *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i = 0; i <= ((n)-16); i += 16) {
+    __m128i XMM0 = _mm_loadu_si128((const __m128i *)(x + i));
+    __m128i XMM1 = _mm_loadu_si128((const __m128i *)(x + i + 8));
+    _mm256_storeu_ps(y + i, _mm256_cvtph_ps(XMM0));
+    _mm256_storeu_ps(y + i + 8, _mm256_cvtph_ps(XMM1));
+  }
+  for (; i < (n); i++) {
+    y[i] = TH_half2float(x[i]);
+  }
+}
+
+void THFloatVector_cvtToHalf_AVX2(THHalf *y, const float *x, const ptrdiff_t n) {
+  ptrdiff_t i;
+  for (i = 0; i <= ((n)-16); i += 16) {
+    __m256 YMM0 = _mm256_loadu_ps(x + i);
+    __m256 YMM1 = _mm256_loadu_ps(x + i + 8);
+    _mm_storeu_si128((__m128i *)(y + i), _mm256_cvtps_ph(YMM0, _MM_FROUND_TO_NEAREST_INT));
+    _mm_storeu_si128((__m128i *)(y + i + 8), _mm256_cvtps_ph(YMM1, _MM_FROUND_TO_NEAREST_INT));
+  }
+  for (; i < (n); i++) {
+    y[i] = TH_float2half(x[i]);
+  }
+}
+
 #endif // defined(__AVX2__)
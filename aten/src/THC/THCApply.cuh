@@ -162,6 +162,77 @@ kernelPointwiseApply3(const OffsetInfo<Ta, IndexType, ADims> a,
   }
 }
 
+// Contiguous fast path of THC_pointwiseApply2 and THC_pointwiseApply3 for the
+// common case of one output (ReadWrite) and read-only inputs. Each thread
+// reads VecSize consecutive elements of every input with a single 128-bit
+// load and applies the op to them one by one. The output is still accessed
+// in place, element by element, so ops that read it too (e.g. in-place ops)
+// see exactly what they see in kernelPointwiseApply*.
+#define THC_APPLY_VECTOR_BYTES 16
+
+// Number of elements of the larger of the input types in a vector.
+template <typename T1, typename T2 = T1>
+constexpr int THC_applyVectorSize() {
+  return sizeof(T1) < sizeof(T2) ? THC_applyVectorSize<T2, T2>()
+      : sizeof(T1) >= THC_APPLY_VECTOR_BYTES ? 1
+      : THC_APPLY_VECTOR_BYTES / sizeof(T1);
+}
+
+template <typename Op,
+          typename Ta, typename Tb,
+          int VecSize>
+__global__ void
+kernelPointwiseApply2Vectorized(Ta* a,
+                                Tb* b,
+                                uint64_t totalElements,
+                                Op op) {
+  typedef THCAlignedVector<Tb, VecSize> VecB;
+  const uint64_t numVectors = totalElements / VecSize;
+  const uint64_t step = (uint64_t) gridDim.x * blockDim.x;
+  const uint64_t start = (uint64_t) blockIdx.x * blockDim.x + threadIdx.x;
+  for (uint64_t v = start; v < numVectors; v += step) {
+    VecB vb = reinterpret_cast<const VecB*>(b)[v];
+    Ta* av = a + v * VecSize;
+#pragma unroll
+    for (int i = 0; i < VecSize; ++i) {
+      op(&av[i], &vb.val[i]);
+    }
+  }
+  // The elements after the last whole vector.
+  for (uint64_t i = numVectors * VecSize + start; i < totalElements; i += step) {
+    op(&a[i], &b[i]);
+  }
+}
+
+template <typename Op,
+          typename Ta, typename Tb, typename Tc,
+          int VecSize>
+__global__ void
+kernelPointwiseApply3Vectorized(Ta* a,
+                                Tb* b,
+                                Tc* c,
+                                uint64_t totalElements,
+                                Op op) {
+  typedef THCAlignedVector<Tb, VecSize> VecB;
+  typedef THCAlignedVector<Tc, VecSize> VecC;
+  const uint64_t numVectors = totalElements / VecSize;
+  const uint64_t step = (uint64_t) gridDim.x * blockDim.x;
+  const uint64_t start = (uint64_t) blockIdx.x * blockDim.x + threadIdx.x;
+  for (uint64_t v = start; v < numVectors; v += step) {
+    VecB vb = reinterpret_cast<const VecB*>(b)[v];
+    VecC vc = reinterpret_cast<const VecC*>(c)[v];
+    Ta* av = a + v * VecSize;
+#pragma unroll
+    for (int i = 0; i < VecSize; ++i) {
+      op(&av[i], &vb.val[i], &vc.val[i]);
+    }
+  }
+  // The elements after the last whole vector.
+  for (uint64_t i = numVectors * VecSize + start; i < totalElements; i += step) {
+    op(&a[i], &b[i], &c[i]);
+  }
+}
+
 inline dim3 getApplyBlock() {
   return dim3(THC_APPLY_THREADS_PER_BLOCK);
 }
@@ -183,6 +254,106 @@ inline bool getApplyGrid(THCState* state, uint64_t totalElements, dim3& grid, in
   return true;
 }
 
+template <typename T>
+inline bool THC_isVectorAligned(const T* p, int vecSize) {
+  return reinterpret_cast<uintptr_t>(p) % (sizeof(T) * vecSize) == 0;
+}
+
+// Whether writing the output element by element can change inputs that have
+// been read ahead in vectors, i.e. whether they overlap other than the input
+// being the output itself.
+template <typename Tout, typename Tin>
+inline bool THC_overlapsPartially(const Tout* out, const Tin* in,
+                                  uint64_t totalElements) {
+  const char* outBegin = reinterpret_cast<const char*>(out);
+  const char* inBegin = reinterpret_cast<const char*>(in);
+  if (outBegin == inBegin && sizeof(Tout) == sizeof(Tin)) {
+    return false;
+  }
+  return outBegin < inBegin + totalElements * sizeof(Tin) &&
+      inBegin < outBegin + totalElements * sizeof(Tout);
+}
+
+template <typename ScalarTypeA,
+          typename ScalarTypeB,
+          typename TensorTypeA,
+          typename TensorTypeB,
+          typename Op>
+bool THC_pointwiseApply2Vectorized(THCState* state,
+                                   TensorTypeA* a,
+                                   TensorTypeB* b,
+                                   const Op& op,
+                                   TensorArgType aType,
+                                   TensorArgType bType,
+                                   uint64_t totalElements,
+                                   int curDevice) {
+  constexpr int vecSize = THC_applyVectorSize<ScalarTypeB>();
+  if (vecSize < 2 || aType != ReadWrite || bType != ReadOnly ||
+      !THCTensor_isContiguous(state, a) || !THCTensor_isContiguous(state, b)) {
+    return false;
+  }
+  ScalarTypeA* aData = a->template data<ScalarTypeA>();
+  ScalarTypeB* bData = b->template data<ScalarTypeB>();
+  if (!THC_isVectorAligned(bData, vecSize) ||
+      THC_overlapsPartially(aData, bData, totalElements)) {
+    return false;
+  }
+
+  dim3 grid;
+  if (!getApplyGrid(state, THCCeilDiv(totalElements, (uint64_t) vecSize),
+                    grid, curDevice)) {
+    return false;
+  }
+  kernelPointwiseApply2Vectorized<Op, ScalarTypeA, ScalarTypeB, vecSize>
+    <<<grid, getApplyBlock(), 0, THCState_getCurrentStreamOnDevice(state, curDevice)>>>(
+      aData, bData, totalElements, op);
+  return true;
+}
+
+template <typename ScalarTypeA,
+          typename ScalarTypeB,
+          typename ScalarTypeC,
+          typename TensorTypeA,
+          typename TensorTypeB,
+          typename TensorTypeC,
+          typename Op>
+bool THC_pointwiseApply3Vectorized(THCState* state,
+                                   TensorTypeA* a,
+                                   TensorTypeB* b,
+                                   TensorTypeC* c,
+                                   const Op& op,
+                                   TensorArgType aType,
+                                   TensorArgType bType,
+                                   TensorArgType cType,
+                                   uint64_t totalElements,
+                                   int curDevice) {
+  constexpr int vecSize = THC_applyVectorSize<ScalarTypeB, ScalarTypeC>();
+  if (vecSize < 2 || aType != ReadWrite || bType != ReadOnly ||
+      cType != ReadOnly || !THCTensor_isContiguous(state, a) ||
+      !THCTensor_isContiguous(state, b) || !THCTensor_isContiguous(state, c)) {
+    return false;
+  }
+  ScalarTypeA* aData = a->template data<ScalarTypeA>();
+  ScalarTypeB* bData = b->template data<ScalarTypeB>();
+  ScalarTypeC* cData = c->template data<ScalarTypeC>();
+  if (!THC_isVectorAligned(bData, vecSize) ||
+      !THC_isVectorAligned(cData, vecSize) ||
+      THC_overlapsPartially(aData, bData, totalElements) ||
+      THC_overlapsPartially(aData, cData, totalElements)) {
+    return false;
+  }
+
+  dim3 grid;
+  if (!getApplyGrid(state, THCCeilDiv(totalElements, (uint64_t) vecSize),
+                    grid, curDevice)) {
+    return false;
+  }
+  kernelPointwiseApply3Vectorized<Op, ScalarTypeA, ScalarTypeB, ScalarTypeC, vecSize>
+    <<<grid, getApplyBlock(), 0, THCState_getCurrentStreamOnDevice(state, curDevice)>>>(
+      aData, bData, cData, totalElements, op);
+  return true;
+}
+
 template <typename ScalarTypeA,
           typename TensorTypeA,
           typename Op>
@@ -421,8 +592,11 @@ bool THC_pointwiseApply2(THCState* state,
   }                                         \
 }
 
-  if (THCTensor_canUse32BitIndexMath(state, a) &&
-      THCTensor_canUse32BitIndexMath(state, b)) {
+  if (THC_pointwiseApply2Vectorized<ScalarTypeA, ScalarTypeB>(
+          state, a, b, op, aType, bType, totalElements, curDevice)) {
+    // Done by the contiguous fast path.
+  } else if (THCTensor_canUse32BitIndexMath(state, a) &&
+             THCTensor_canUse32BitIndexMath(state, b)) {
     TensorInfo<ScalarTypeA, unsigned int> aInfo =
       getTensorInfo<ScalarTypeA, TensorTypeA, unsigned int>(state, a);
 
@@ -632,9 +806,12 @@ bool THC_pointwiseApply3(THCState* state,
   }                                         \
 }
 
-  if (THCTensor_canUse32BitIndexMath(state, a) &&
-      THCTensor_canUse32BitIndexMath(state, b) &&
-      THCTensor_canUse32BitIndexMath(state, c)) {
+  if (THC_pointwiseApply3Vectorized<ScalarTypeA, ScalarTypeB, ScalarTypeC>(
+          state, a, b, c, op, aType, bType, cType, totalElements, curDevice)) {
+    // Done by the contiguous fast path.
+  } else if (THCTensor_canUse32BitIndexMath(state, a) &&
+             THCTensor_canUse32BitIndexMath(state, b) &&
+             THCTensor_canUse32BitIndexMath(state, c)) {
     TensorInfo<ScalarTypeA, unsigned int> aInfo =
       getTensorInfo<ScalarTypeA, TensorTypeA, unsigned int>(state, a);
 
@@ -743,6 +920,7 @@ bool THC_pointwiseApply3(THCState* state,
 }
 
 #undef THC_APPLY_THREADS_PER_BLOCK
+#undef THC_APPLY_VECTOR_BYTES
 #undef THC_APPLY_BLOCKS_PER_SM
 
 #endif // THC_APPLY_INC
@@ -5,11 +5,14 @@
 
 #include <cuda_runtime_api.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <deque>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <set>
+#include <sstream>
 #include <unordered_map>
 #include <vector>
 
@@ -37,6 +40,18 @@
 // ensure that the block is not reused before each recorded stream completes
 // work.
 //
+// - Cached blocks are kept in one pool per (device, stream), each with its
+//   own lock, so that allocations on different streams neither scan each
+//   other's free lists nor contend on a single mutex. The map from pointer
+//   to allocated block is sharded for the same reason. Locks are never
+//   nested except for cuda_free_mutex, which is taken inside a pool lock,
+//   and shards, which snapshot() takes inside a pool lock.
+//
+// - For debugging fragmentation, snapshot() lists every segment and block,
+//   and recordHistory() keeps a ring buffer of alloc/free events that can
+//   be dumped as a Chrome trace. Allocations can be tagged with the site
+//   that made them through setAllocationTag().
+//
 
 namespace {
 
@@ -46,20 +61,27 @@ typedef std::set<THCStreamPtr> stream_set;
 const size_t kRoundSmall = 512;     // round up small allocs to 512 bytes
 const size_t kRoundLarge = 131072;  // round up large allocs to 128 KiB
 const size_t kSmallAlloc = 1048576; // largest "small" allocation is 1 MiB
+const size_t kNumBlockShards = 16;  // shards of the allocated-blocks map
 
 struct DeviceStats {
-  uint64_t   amount_allocated;      // total amount allocated in bytes
-  uint64_t   max_amount_allocated;  // max total amount allocated in bytes
-  uint64_t   amount_cached;         // total amount in cache in bytes
-  uint64_t   max_amount_cached;     // max total amount in cache in bytes
+  // Updated by every stream pool of the device; keep it lock-free.
+  std::atomic<uint64_t> amount_allocated;      // total amount allocated in bytes
+  std::atomic<uint64_t> max_amount_allocated;  // max total amount allocated in bytes
+  std::atomic<uint64_t> amount_cached;         // total amount in cache in bytes
+  std::atomic<uint64_t> max_amount_cached;     // max total amount in cache in bytes
 
   DeviceStats() :
       amount_allocated(0), max_amount_allocated(0),
       amount_cached(0), max_amount_cached(0) { }
 
+  static void updateMax(std::atomic<uint64_t>& max_value, uint64_t value) {
+    uint64_t prev = max_value.load();
+    while (prev < value && !max_value.compare_exchange_weak(prev, value)) {
+    }
+  }
+
   void increaseAllocated(size_t delta) {
-    amount_allocated += delta;
-    max_amount_allocated = std::max(max_amount_allocated, amount_allocated);
+    updateMax(max_amount_allocated, amount_allocated += delta);
   }
 
   void decreaseAllocated(size_t delta) {
@@ -67,8 +89,7 @@ struct DeviceStats {
   }
 
   void increaseCached(size_t delta) {
-    amount_cached += delta;
-    max_amount_cached = std::max(max_amount_cached, amount_cached);
+    updateMax(max_amount_cached, amount_cached += delta);
   }
 
   void decreaseCached(size_t delta) {
@@ -86,98 +107,258 @@ struct Block {
   Block*        prev;        // prev block if split from a larger allocation
   Block*        next;        // next block if split from a larger allocation
   int           event_count; // number of outstanding CUDA events
+  const std::string* tag;    // allocation-site tag, if any
 
   Block(int device, cudaStream_t stream, size_t size, char* ptr=NULL) :
       device(device), stream(stream), stream_uses(), size(size), ptr(ptr),
-      allocated(0), prev(NULL), next(NULL), event_count(0) { }
+      allocated(0), prev(NULL), next(NULL), event_count(0), tag(NULL) { }
 };
 
-static bool BlockComparator(const Block* a, const Block* b)
-{
-  if (a->device != b->device) {
-    return a->device < b->device;
+// Tags are interned and never freed, so blocks and trace entries can keep
+// plain pointers to them.
+const std::string* intern_tag(const std::string& tag) {
+  static std::mutex mutex;
+  static std::set<std::string> tags;
+  if (tag.empty()) {
+    return NULL;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  return &*tags.insert(tag).first;
+}
+
+thread_local const std::string* current_tag = NULL;
+
+struct TraceEntry {
+  enum Action { ALLOC, FREE, SEGMENT_ALLOC, SEGMENT_FREE };
+  Action        action;
+  int           device;
+  uintptr_t     ptr;
+  size_t        size;
+  cudaStream_t  stream;
+  uint64_t      time_us;
+  uint64_t      allocated;  // device bytes allocated after the action
+  uint64_t      cached;     // device bytes cached after the action
+  const std::string* tag;
+};
+
+// Ring buffer of allocator events, off unless recordHistory() enabled it.
+struct AllocatorHistory {
+  std::atomic<bool> enabled;
+  std::mutex mutex;
+  std::vector<TraceEntry> ring;
+  size_t next;
+  bool wrapped;
+
+  AllocatorHistory() : enabled(false), next(0), wrapped(false) {}
+
+  void reset(bool enable, size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    ring.clear();
+    ring.resize(enable ? capacity : 0);
+    next = 0;
+    wrapped = false;
+    enabled = enable && capacity > 0;
+  }
+
+  void record(const TraceEntry& entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (ring.empty()) {
+      return;
+    }
+    ring[next] = entry;
+    next = (next + 1) % ring.size();
+    wrapped = wrapped || next == 0;
   }
-  if (a->stream != b->stream) {
-    return (uintptr_t)a->stream < (uintptr_t)b->stream;
+
+  std::vector<TraceEntry> entries() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<TraceEntry> result;
+    if (wrapped) {
+      result.insert(result.end(), ring.begin() + next, ring.end());
+    }
+    result.insert(result.end(), ring.begin(), ring.begin() + next);
+    return result;
   }
+};
+
+// All blocks in one free list share device and stream, so blocks are
+// ordered by size (best fit) and then by address.
+static bool BlockComparator(const Block* a, const Block* b)
+{
   if (a->size != b->size) {
     return a->size < b->size;
   }
   return (uintptr_t)a->ptr < (uintptr_t)b->ptr;
 }
 
+typedef bool (*Comparison)(const Block*, const Block*);
+typedef std::set<Block*, Comparison> FreeBlocks;
+
+// The cached blocks of one (device, stream) pair. A block only ever lives
+// in the pool of its allocation stream, and all blocks split from one
+// cudaMalloc segment share that stream, so splitting, merging and the
+// allocated flag of a block are all guarded by its pool's mutex.
+struct StreamPool {
+  std::mutex    mutex;
+  int           device;
+  cudaStream_t  stream;
+  FreeBlocks    large_blocks;  // cached blocks larger than 1 MB
+  FreeBlocks    small_blocks;  // cached blocks 1 MB or smaller
+  // outstanding cuda events for blocks of this pool freed after
+  // recordStream()
+  std::deque<std::pair<cudaEvent_t, Block*>> cuda_events;
+
+  StreamPool(int device, cudaStream_t stream) :
+      device(device), stream(stream),
+      large_blocks(BlockComparator), small_blocks(BlockComparator) {}
+
+  FreeBlocks& free_blocks_for(size_t size) {
+    return size <= kSmallAlloc ? small_blocks : large_blocks;
+  }
+};
+
+struct DevicePools {
+  DeviceStats stats;
+  // guards the map only; pools are never destroyed
+  std::mutex mutex;
+  std::unordered_map<cudaStream_t, std::unique_ptr<StreamPool>> pools;
+};
+
+// allocated blocks by device pointer, sharded to spread frees over locks
+struct BlockShard {
+  std::mutex mutex;
+  std::unordered_map<void*, Block*> blocks;
+};
+
 } // namespace
 
 struct THCCachingAllocator
 {
-  typedef bool (*Comparison)(const Block*, const Block*);
-  typedef std::set<Block*, Comparison> FreeBlocks;
+  AllocatorHistory history;
 
-  // device statistics
-  std::vector<DeviceStats> device_stats;
-
-  // lock around all operations
-  std::mutex mutex;
+  // per-device pools and statistics, sized on first use
+  std::vector<std::unique_ptr<DevicePools>> devices;
+  std::once_flag devices_init;
 
   // lock around calls to cudaFree (to prevent deadlocks with NCCL)
   std::mutex cuda_free_mutex;
 
-  // cached blocks larger than 1 MB
-  FreeBlocks large_blocks;
+  BlockShard allocated_blocks[kNumBlockShards];
 
-  // cached blocks 1 MB or smaller
-  FreeBlocks small_blocks;
+  size_t num_devices() {
+    std::call_once(devices_init, [this] {
+      int count = 0;
+      if (cudaGetDeviceCount(&count) != cudaSuccess) {
+        cudaGetLastError();
+        count = 0;
+      }
+      for (int i = 0; i < count; ++i) {
+        devices.emplace_back(new DevicePools());
+      }
+    });
+    return devices.size();
+  }
 
-  // allocated blocks by device pointer
-  std::unordered_map<void*, Block*> allocated_blocks;
+  DevicePools& get_device(int device) {
+    THAssert(device >= 0 && (size_t) device < num_devices());
+    return *devices[device];
+  }
 
-  // outstanding cuda events
-  std::deque<std::pair<cudaEvent_t, Block*>> cuda_events;
+  DeviceStats &get_stats_for_device(int device) {
+    return get_device(device).stats;
+  }
 
-  THCCachingAllocator() :
-      large_blocks(BlockComparator),
-      small_blocks(BlockComparator) {}
+  StreamPool& get_pool(int device, cudaStream_t stream) {
+    // Most threads keep allocating on the same stream; remember the last
+    // pool to skip the per-device map lookup.
+    thread_local StreamPool* last_pool = nullptr;
+    if (last_pool && last_pool->device == device && last_pool->stream == stream) {
+      return *last_pool;
+    }
+    DevicePools& dev = get_device(device);
+    std::lock_guard<std::mutex> lock(dev.mutex);
+    auto& pool = dev.pools[stream];
+    if (!pool) {
+      pool.reset(new StreamPool(device, stream));
+    }
+    last_pool = pool.get();
+    return *pool;
+  }
 
-  DeviceStats &get_stats_for_device(int device) {
-    THAssert(device >= 0);
-    if ((size_t) device >= device_stats.size()) {
-      device_stats.resize(device + 1);
+  // Pools of all devices in a stable order. Pools are never destroyed, so
+  // the pointers stay valid after the per-device locks are dropped.
+  std::vector<StreamPool*> all_pools(int device = -1) {
+    std::vector<StreamPool*> result;
+    for (size_t d = 0; d < num_devices(); ++d) {
+      if (device >= 0 && (int) d != device) {
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(devices[d]->mutex);
+      for (auto& entry : devices[d]->pools) {
+        result.push_back(entry.second.get());
+      }
+    }
+    return result;
+  }
+
+  void record(TraceEntry::Action action, const Block* block, size_t size) {
+    if (!history.enabled.load(std::memory_order_relaxed)) {
+      return;
     }
-    return device_stats.at(device);
+    DeviceStats& stats = get_stats_for_device(block->device);
+    TraceEntry entry;
+    entry.action = action;
+    entry.device = block->device;
+    entry.ptr = (uintptr_t)block->ptr;
+    entry.size = size;
+    entry.stream = block->stream;
+    entry.time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    entry.allocated = stats.amount_allocated;
+    entry.cached = stats.amount_cached;
+    entry.tag = block->tag;
+    history.record(entry);
+  }
+
+  BlockShard& shard_for(void* ptr) {
+    // blocks are at least kRoundSmall-aligned; drop the low bits
+    return allocated_blocks[((uintptr_t)ptr / kRoundSmall) % kNumBlockShards];
   }
 
   /** allocates a block which is safe to use from the provided stream */
   cudaError_t malloc(void** devPtr, size_t size, cudaStream_t stream)
   {
-    std::lock_guard<std::mutex> lock(mutex);
-
     int device;
     cudaError_t err = cudaGetDevice(&device);
     if (err != cudaSuccess) {
       return err;
     }
 
-    err = process_events();
-    if (err != cudaSuccess) {
-      return err;
-    }
-
     size = round_size(size);
     bool small = size <= kSmallAlloc;
 
     DeviceStats &stats = get_stats_for_device(device);
+    StreamPool& pool = get_pool(device, stream);
+    auto& free_blocks = pool.free_blocks_for(size);
 
-    Block search_key(device, stream, size);
-    auto& free_blocks = small ? large_blocks : small_blocks;
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    err = process_events(pool);
+    if (err != cudaSuccess) {
+      return err;
+    }
 
+    Block search_key(device, stream, size);
     Block* block = NULL;
     Block* remaining = NULL;
 
     auto it = free_blocks.lower_bound(&search_key);
-    if (it != free_blocks.end() && (*it)->device == device && (*it)->stream == stream) {
+    if (it != free_blocks.end()) {
       block = *it;
       free_blocks.erase(it);
     } else {
+      // Do not hold the pool lock across cudaMalloc: it is slow, and on
+      // failure we need to free cached blocks of every pool of the device.
+      lock.unlock();
       void* ptr;
       size_t alloc_size = small ? kSmallAlloc : size;
       err = cuda_malloc_retry(device, &ptr, alloc_size);
@@ -186,6 +367,8 @@ struct THCCachingAllocator
       }
       stats.increaseCached(alloc_size);
       block = new Block(device, stream, alloc_size, (char*)ptr);
+      record(TraceEntry::SEGMENT_ALLOC, block, alloc_size);
+      lock.lock();
     }
 
     if (block->size - size >= (small ? kRoundSmall : kSmallAlloc + 1)) {
@@ -205,61 +388,87 @@ struct THCCachingAllocator
     }
 
     block->allocated = true;
-    allocated_blocks[block->ptr] = block;
+    block->tag = current_tag;
+    lock.unlock();
+    {
+      BlockShard& shard = shard_for(block->ptr);
+      std::lock_guard<std::mutex> shard_lock(shard.mutex);
+      shard.blocks[block->ptr] = block;
+    }
 
     *devPtr = (void*)block->ptr;
 
     stats.increaseAllocated(block->size);
+    record(TraceEntry::ALLOC, block, block->size);
     return cudaSuccess;
   }
 
   cudaError_t free(void* ptr)
   {
-    std::lock_guard<std::mutex> lock(mutex);
     if (!ptr) {
       return cudaSuccess;
     }
 
-    auto it = allocated_blocks.find(ptr);
-    if (it == allocated_blocks.end()) {
-      return cudaErrorInvalidDevicePointer;
+    Block* block;
+    {
+      BlockShard& shard = shard_for(ptr);
+      std::lock_guard<std::mutex> shard_lock(shard.mutex);
+      auto it = shard.blocks.find(ptr);
+      if (it == shard.blocks.end()) {
+        return cudaErrorInvalidDevicePointer;
+      }
+      block = it->second;
+      shard.blocks.erase(it);
     }
 
-    Block* block = it->second;
-    allocated_blocks.erase(it);
+    StreamPool& pool = get_pool(block->device, block->stream);
+    std::lock_guard<std::mutex> lock(pool.mutex);
     block->allocated = false;
 
     get_stats_for_device(block->device).decreaseAllocated(block->size);
+    record(TraceEntry::FREE, block, block->size);
+    block->tag = NULL;
     if (!block->stream_uses.empty()) {
-      return insert_events(block);
+      return insert_events(pool, block);
     }
 
-    free_block(block);
+    free_block(pool, block);
     return cudaSuccess;
   }
 
   /** returns cached blocks to the system allocator */
   cudaError_t emptyCache()
   {
-    std::lock_guard<std::mutex> lock(mutex);
-    cudaError_t err = free_blocks(large_blocks, large_blocks.begin(), large_blocks.end());
-    if (err != cudaSuccess) {
-      return err;
-    }
-    err = free_blocks(small_blocks, small_blocks.begin(), small_blocks.end());
-    if (err != cudaSuccess) {
-      return err;
+    for (StreamPool* pool : all_pools()) {
+      std::lock_guard<std::mutex> lock(pool->mutex);
+      cudaError_t err = free_blocks(pool->large_blocks);
+      if (err != cudaSuccess) {
+        return err;
+      }
+      err = free_blocks(pool->small_blocks);
+      if (err != cudaSuccess) {
+        return err;
+      }
     }
     return cudaSuccess;
   }
 
-  void* getBaseAllocation(void* ptr, size_t* outSize)
+  // Looks up an allocated block and locks the pool it belongs to.
+  Block* find_and_lock(void* ptr, std::unique_lock<std::mutex>* pool_lock)
   {
-    std::lock_guard<std::mutex> lock(mutex);
     Block* block = find_allocated_block(ptr);
     if (!block) {
       THError("invalid device pointer: %p", ptr);
     }
+    StreamPool& pool = get_pool(block->device, block->stream);
+    *pool_lock = std::unique_lock<std::mutex>(pool.mutex);
+    return block;
+  }
+
+  void* getBaseAllocation(void* ptr, size_t* outSize)
+  {
+    std::unique_lock<std::mutex> lock;
+    Block* block = find_and_lock(ptr, &lock);
     while (block->prev) {
       block = block->prev;
     }
@@ -275,13 +484,11 @@ struct THCCachingAllocator
     return basePtr;
   }
 
-  // Accumulates sizes of all memory blocks for given device in given free list
-  void cacheInfoAux(FreeBlocks& blocks, int dev_id, size_t* total, size_t* largest)
+  // Accumulates sizes of all memory blocks in given free list
+  void cacheInfoAux(FreeBlocks& blocks, size_t* total, size_t* largest)
   {
-    Block search_key(dev_id, 0, 0);
-    auto it = blocks.lower_bound(&search_key);
-    for (;it != blocks.end() && *it && (*it)->device == dev_id; ++it) {
-      size_t blocksize = (*it)->size;
+    for (Block* block : blocks) {
+      size_t blocksize = block->size;
       *total += blocksize;
       if (blocksize > *largest) {
         *largest = blocksize;
@@ -291,18 +498,17 @@ struct THCCachingAllocator
 
   void cacheInfo(int dev_id, size_t* total, size_t* largest)
   {
-    std::lock_guard<std::mutex> lock(mutex);
-    cacheInfoAux(large_blocks, dev_id, total, largest);
-    cacheInfoAux(small_blocks, dev_id, total, largest);
+    for (StreamPool* pool : all_pools(dev_id)) {
+      std::lock_guard<std::mutex> lock(pool->mutex);
+      cacheInfoAux(pool->large_blocks, total, largest);
+      cacheInfoAux(pool->small_blocks, total, largest);
+    }
   }
 
   void recordStream(void* ptr, THCStream* stream)
   {
-    std::lock_guard<std::mutex> lock(mutex);
-    Block* block = find_allocated_block(ptr);
-    if (!block) {
-      THError("invalid device pointer: %p", ptr);
-    }
+    std::unique_lock<std::mutex> lock;
+    Block* block = find_and_lock(ptr, &lock);
     if (THCStream_stream(stream) == block->stream) {
       // ignore uses on the allocation stream, since those don't require any
       // special synchronization
@@ -313,11 +519,10 @@ struct THCCachingAllocator
   }
 
   /** moves a block into the free block list */
-  void free_block(Block* block)
+  void free_block(StreamPool& pool, Block* block)
   {
     THAssert(!block->allocated && block->event_count == 0);
-    bool small = block->size <= kSmallAlloc;
-    auto& free_blocks = small ? large_blocks : small_blocks;
+    auto& free_blocks = pool.free_blocks_for(block->size);
     try_merge_blocks(block, block->prev, free_blocks);
     try_merge_blocks(block, block->next, free_blocks);
     free_blocks.insert(block);
@@ -379,29 +584,28 @@ struct THCCachingAllocator
 
   cudaError_t free_cached_blocks(int device)
   {
-    // Free all non-split cached blocks on device
-    Block lower_bound(device, NULL, 0);
-    Block upper_bound(device + 1, NULL, 0);
-
-    cudaError_t err = free_blocks(
-        large_blocks,
-        large_blocks.lower_bound(&lower_bound),
-        large_blocks.lower_bound(&upper_bound));
-    if (err != cudaSuccess) {
-      return err;
+    // Free all non-split cached blocks on device, one pool at a time. The
+    // caller must not hold any pool lock.
+    for (StreamPool* pool : all_pools(device)) {
+      std::lock_guard<std::mutex> lock(pool->mutex);
+      cudaError_t err = free_blocks(pool->large_blocks);
+      if (err != cudaSuccess) {
+        return err;
+      }
+      err = free_blocks(pool->small_blocks);
+      if (err != cudaSuccess) {
+        return err;
+      }
     }
-    err = free_blocks(
-        small_blocks,
-        small_blocks.lower_bound(&lower_bound),
-        small_blocks.lower_bound(&upper_bound));
-    return err;
+    return cudaSuccess;
   }
 
-  cudaError_t free_blocks(FreeBlocks& blocks, FreeBlocks::iterator it, FreeBlocks::iterator end)
+  cudaError_t free_blocks(FreeBlocks& blocks)
   {
-    // Frees all non-split blocks between `it` and `end`
+    // Frees all non-split blocks in `blocks`
     std::lock_guard<std::mutex> lock(cuda_free_mutex);
-    while (it != end) {
+    auto it = blocks.begin();
+    while (it != blocks.end()) {
       Block* block = *it;
       if (!block->prev && !block->next) {
         cudaError_t err = cudaFree((void*)block->ptr);
@@ -409,6 +613,7 @@ struct THCCachingAllocator
           return err;
         }
         get_stats_for_device(block->device).decreaseCached(block->size);
+        record(TraceEntry::SEGMENT_FREE, block, block->size);
         auto cur = it;
         ++it;
         blocks.erase(cur);
@@ -421,14 +626,16 @@ struct THCCachingAllocator
   }
 
   Block* find_allocated_block(void *ptr) {
-    auto it = allocated_blocks.find(ptr);
-    if (it == allocated_blocks.end()) {
+    BlockShard& shard = shard_for(ptr);
+    std::lock_guard<std::mutex> shard_lock(shard.mutex);
+    auto it = shard.blocks.find(ptr);
+    if (it == shard.blocks.end()) {
       return NULL;
     }
     return it->second;
   }
 
-  cudaError_t insert_events(Block* block)
+  cudaError_t insert_events(StreamPool& pool, Block* block)
   {
     cudaError_t err;
 
@@ -452,22 +659,87 @@ struct THCCachingAllocator
       if (err != cudaSuccess) break;
 
       block->event_count++;
-      cuda_events.emplace_back(event, block);
+      pool.cuda_events.emplace_back(event, block);
     }
 
     cudaSetDevice(prev_device);
     return err;
   }
 
-  cudaError_t process_events()
+  std::vector<THCCachingAllocatorSegmentInfo> snapshot()
+  {
+    std::vector<THCCachingAllocatorSegmentInfo> result;
+    for (StreamPool* pool : all_pools()) {
+      std::lock_guard<std::mutex> lock(pool->mutex);
+
+      // Every block of the pool is either free, waiting on events, or
+      // allocated; find the first block of each segment from any of them.
+      std::set<Block*> heads;
+      auto add_head = [&heads](Block* block) {
+        while (block->prev) {
+          block = block->prev;
+        }
+        heads.insert(block);
+      };
+      for (Block* block : pool->large_blocks) add_head(block);
+      for (Block* block : pool->small_blocks) add_head(block);
+      for (auto& e : pool->cuda_events) add_head(e.second);
+      for (auto& shard : allocated_blocks) {
+        std::lock_guard<std::mutex> shard_lock(shard.mutex);
+        for (auto& entry : shard.blocks) {
+          Block* block = entry.second;
+          if (block->device == pool->device && block->stream == pool->stream) {
+            add_head(block);
+          }
+        }
+      }
+
+      for (Block* head : heads) {
+        THCCachingAllocatorSegmentInfo segment;
+        segment.device = pool->device;
+        segment.address = (uintptr_t)head->ptr;
+        segment.total_size = 0;
+        segment.allocated_size = 0;
+        segment.stream = pool->stream;
+        for (Block* block = head; block; block = block->next) {
+          THCCachingAllocatorBlockInfo info;
+          info.size = block->size;
+          info.allocated = block->allocated;
+          info.pending_free = !block->allocated && block->event_count > 0;
+          if (block->tag) {
+            info.tag = *block->tag;
+          }
+          segment.total_size += block->size;
+          if (block->allocated) {
+            segment.allocated_size += block->size;
+          }
+          segment.blocks.push_back(std::move(info));
+        }
+        result.push_back(std::move(segment));
+      }
+    }
+    std::sort(result.begin(), result.end(),
+        [](const THCCachingAllocatorSegmentInfo& a,
+           const THCCachingAllocatorSegmentInfo& b) {
+          if (a.device != b.device) {
+            return a.device < b.device;
+          }
+          return a.address < b.address;
+        });
+    return result;
+  }
+
+  cudaError_t process_events(StreamPool& pool)
   {
-    // Process outstanding cudaEvents. Events that are completed are removed
-    // from the queue, and the 'event_count' for the corresponding allocation
-    // is decremented. Stops at the first event which has not been completed.
-    // Since events on different devices or streams may occur out of order,
-    // the processing of some events may be delayed.
-    while (!cuda_events.empty()) {
-      auto& e = cuda_events.front();
+    // Process outstanding cudaEvents of the pool. Events that are completed
+    // are removed from the queue, and the 'event_count' for the
+    // corresponding allocation is decremented. Stops at the first event
+    // which has not been completed. Since events recorded on different
+    // streams may occur out of order, the processing of some events may be
+    // delayed. Only blocks of this pool are ever waiting here, so other
+    // streams' pending frees never hold up this stream.
+    while (!pool.cuda_events.empty()) {
+      auto& e = pool.cuda_events.front();
       cudaEvent_t event = e.first;
       Block* block = e.second;
 
@@ -484,9 +756,9 @@ struct THCCachingAllocator
 
       block->event_count--;
       if (block->event_count == 0) {
-        free_block(block);
+        free_block(pool, block);
       }
-      cuda_events.pop_front();
+      pool.cuda_events.pop_front();
     }
     return cudaSuccess;
   }
@@ -573,3 +845,71 @@ THC_API uint64_t THCCachingAllocator_maxMemoryCached(int device) {
   assertValidDevice(device);
   return caching_allocator.get_stats_for_device(device).max_amount_cached;
 }
+
+THC_API std::vector<THCCachingAllocatorSegmentInfo> THCCachingAllocator_snapshot()
+{
+  return caching_allocator.snapshot();
+}
+
+THC_API void THCCachingAllocator_setAllocationTag(const std::string& tag)
+{
+  current_tag = intern_tag(tag);
+}
+
+THC_API std::string THCCachingAllocator_getAllocationTag()
+{
+  return current_tag ? *current_tag : std::string();
+}
+
+THC_API void THCCachingAllocator_recordHistory(bool enabled, size_t capacity)
+{
+  caching_allocator.history.reset(enabled, capacity);
+}
+
+static void writeJSONString(std::ostream& out, const std::string& str) {
+  out << '"';
+  for (char c : str) {
+    switch (c) {
+      case '"': out << "\\\""; break;
+      case '\\': out << "\\\\"; break;
+      case '\n': out << "\\n"; break;
+      default:
+        if ((unsigned char) c < 0x20) {
+          char buf[8];
+          snprintf(buf, sizeof(buf), "\\u%04x", c);
+          out << buf;
+        } else {
+          out << c;
+        }
+    }
+  }
+  out << '"';
+}
+
+THC_API std::string THCCachingAllocator_traceToChromeJSON()
+{
+  static const char* kActionNames[] = {
+      "alloc", "free", "segment_alloc", "segment_free"};
+  std::ostringstream out;
+  out << "{\"traceEvents\": [";
+  bool first = true;
+  for (const TraceEntry& e : caching_allocator.history.entries()) {
+    // One instant event per action on a per-stream track of the device's
+    // process, plus a counter track of allocated and cached bytes.
+    out << (first ? "\n" : ",\n");
+    first = false;
+    out << "{\"name\": \"" << kActionNames[e.action] << "\", \"ph\": \"i\", \"s\": \"t\""
+        << ", \"ts\": " << e.time_us << ", \"pid\": " << e.device
+        << ", \"tid\": " << (uintptr_t)e.stream
+        << ", \"args\": {\"ptr\": \"0x" << std::hex << e.ptr << std::dec << "\""
+        << ", \"size\": " << e.size << ", \"tag\": ";
+    writeJSONString(out, e.tag ? *e.tag : std::string());
+    out << "}},\n";
+    out << "{\"name\": \"memory\", \"ph\": \"C\", \"ts\": " << e.time_us
+        << ", \"pid\": " << e.device
+        << ", \"args\": {\"allocated\": " << e.allocated
+        << ", \"cached\": " << e.cached << "}}";
+  }
+  out << "\n]}\n";
+  return out.str();
+}
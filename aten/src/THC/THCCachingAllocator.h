@@ -3,6 +3,8 @@
 
 #if (__cplusplus >= 201103L) || (defined(_MSC_VER) && defined(__cplusplus))
 #include <mutex>
+#include <string>
+#include <vector>
 #endif
 
 #include "THCGeneral.h"
@@ -20,6 +22,41 @@ THC_API uint64_t THCCachingAllocator_maxMemoryCached(int device);
 
 #if (__cplusplus >= 201103L) || (defined(_MSC_VER) && defined(__cplusplus))
 THC_API std::mutex* THCCachingAllocator_getCudaFreeMutex();
+
+// One block of a cudaMalloc'ed segment, as seen by the caching allocator.
+struct THCCachingAllocatorBlockInfo {
+  size_t size;
+  bool allocated;
+  // set while a freed block waits for events recorded with recordStream
+  bool pending_free;
+  // allocation-site tag that was active when the block was allocated
+  std::string tag;
+};
+
+struct THCCachingAllocatorSegmentInfo {
+  int device;
+  uintptr_t address;
+  size_t total_size;
+  size_t allocated_size;
+  cudaStream_t stream;
+  std::vector<THCCachingAllocatorBlockInfo> blocks;
+};
+
+// Returns every segment currently held by the allocator, with its blocks
+// in address order.
+THC_API std::vector<THCCachingAllocatorSegmentInfo> THCCachingAllocator_snapshot();
+
+// Sets the tag recorded with allocations made by the calling thread; an
+// empty tag clears it.
+THC_API void THCCachingAllocator_setAllocationTag(const std::string& tag);
+THC_API std::string THCCachingAllocator_getAllocationTag();
+
+// Starts (or stops, with enabled == false) recording alloc/free/segment
+// events into a ring buffer of the given capacity. Restarting clears it.
+THC_API void THCCachingAllocator_recordHistory(bool enabled, size_t capacity);
+// Dumps the recorded events in the Chrome trace event JSON format
+// (chrome://tracing, Perfetto), oldest first.
+THC_API std::string THCCachingAllocator_traceToChromeJSON();
 #endif
 
 #endif
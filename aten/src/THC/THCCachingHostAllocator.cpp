@@ -3,15 +3,17 @@
 
 #include <cuda_runtime_api.h>
 #include <deque>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <set>
 #include <stdint.h>
-#include <unordered_map>
 #include <utility>
 
 namespace {
 
+const size_t kMinBlockSize = 512;  // smallest bucket, in bytes
+
 typedef std::shared_ptr<THCStream> THCStreamPtr;
 
 struct BlockSize
@@ -27,11 +29,30 @@ struct Block : public BlockSize
   bool  allocated;    // true if the block is currently allocated
   int   event_count;  // number of outstanding cuda events
   std::set<THCStreamPtr> streams;
+  // (device, stream) uses recorded by callers without a THCStream
+  std::set<std::pair<int, cudaStream_t>> raw_streams;
 
   Block(size_t size, void* ptr, bool allocated) :
-      BlockSize(size, ptr), allocated(allocated), event_count(0), streams() {}
+      BlockSize(size, ptr), allocated(allocated), event_count(0), streams(),
+      raw_streams() {}
 };
 
+// Rounds a request up to one of four buckets per power of two, so that a
+// cached block is only handed out for requests it fits within 25%, rather
+// than to any smaller request.
+static size_t roundSize(size_t size)
+{
+  if (size <= kMinBlockSize) {
+    return kMinBlockSize;
+  }
+  size_t power = kMinBlockSize;
+  while (power * 2 < size) {
+    power *= 2;
+  }
+  size_t step = power / 4;
+  return (size + step - 1) / step * step;
+}
+
 static bool BlockComparator(const BlockSize& a, const BlockSize& b)
 {
   // sort by size, break ties with pointer
@@ -48,8 +69,8 @@ struct HostAllocator
   // lock around all operations
   std::mutex mutex;
 
-  // blocks by pointer
-  std::unordered_map<void*, Block> blocks;
+  // blocks by pointer, ordered so that interior pointers can be resolved
+  std::map<void*, Block> blocks;
 
   // pointers that are ready to be allocated (event_count=0)
   std::set<BlockSize, Comparison> available;
@@ -69,10 +90,11 @@ struct HostAllocator
       return err;
     }
 
-    // search for the smallest block which can hold this allocation
+    // search for a block in the bucket of this allocation
+    size = roundSize(size);
     BlockSize search_key(size);
     auto it = available.lower_bound(search_key);
-    if (it != available.end()) {
+    if (it != available.end() && it->size == size) {
       Block& block = blocks.at(it->ptr);
       THAssert(!block.allocated && block.event_count == 0);
       block.allocated = true;
@@ -109,7 +131,10 @@ struct HostAllocator
     }
 
     auto it = blocks.find(ptr);
-    THAssert(it != blocks.end());
+    if (it == blocks.end()) {
+      // not allocated by us
+      return cudaErrorInvalidValue;
+    }
 
     Block& block = it->second;
     THAssert(block.allocated);
@@ -151,6 +176,27 @@ struct HostAllocator
     return cudaSuccess;
   }
 
+  cudaError_t recordEvent(void* ptr, int device, cudaStream_t stream)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // ptr may point into the middle of a block
+    auto it = blocks.upper_bound(ptr);
+    if (it == blocks.begin()) {
+      return cudaSuccess;
+    }
+    --it;
+    Block& block = it->second;
+    if ((char*)ptr >= (char*)block.ptr + block.size) {
+      // ignore events for untracked pointers
+      return cudaSuccess;
+    }
+    THAssert(block.allocated);
+
+    block.raw_streams.insert(std::make_pair(device, stream));
+    return cudaSuccess;
+  }
+
   cudaError_t processEvents()
   {
     // Process outstanding cudaEvents. Events that are completed are removed
@@ -223,18 +269,25 @@ struct HostAllocator
     err = cudaGetDevice(&prev_device);
     if (err != cudaSuccess) return err;
 
-    std::set<THCStreamPtr> streams(std::move(block.streams));
-    for (auto it = streams.begin(); it != streams.end(); ++it) {
-      auto& stream = *it;
+    std::set<std::pair<int, cudaStream_t>> streams(std::move(block.raw_streams));
+    for (auto& stream : block.streams) {
+      streams.insert(std::make_pair(
+          THCStream_device(stream.get()), THCStream_stream(stream.get())));
+    }
+    block.raw_streams.clear();
+    // the streams only have to stay alive until the events are recorded
+    std::set<THCStreamPtr> stream_refs(std::move(block.streams));
+    block.streams.clear();
 
-      err = cudaSetDevice(THCStream_device(stream.get()));
+    for (auto it = streams.begin(); it != streams.end(); ++it) {
+      err = cudaSetDevice(it->first);
       if (err != cudaSuccess) break;
 
       cudaEvent_t event;
       err = cudaEventCreateWithFlags(&event, cudaEventDisableTiming);
       if (err != cudaSuccess) break;
 
-      err = cudaEventRecord(event, THCStream_stream(stream.get()));
+      err = cudaEventRecord(event, it->second);
       if (err != cudaSuccess) break;
 
       block.event_count++;
@@ -255,6 +308,21 @@ cudaError_t THCCachingHostAllocator_recordEvent(void *ptr, THCStream *stream)
   return allocator.recordEvent(ptr, stream);
 }
 
+cudaError_t THCCachingHostAllocator_recordEventOnStream(void *ptr, int device, cudaStream_t stream)
+{
+  return allocator.recordEvent(ptr, device, stream);
+}
+
+cudaError_t THCCachingHostAllocator_malloc(void **ptr, size_t size)
+{
+  return allocator.malloc(ptr, size);
+}
+
+cudaError_t THCCachingHostAllocator_free(void *ptr)
+{
+  return allocator.free(ptr);
+}
+
 void THCCachingHostAllocator_emptyCache()
 {
   allocator.emptyCache();
@@ -17,7 +17,9 @@
 // and tensors in THCTensor_(copyAsyncCPU) and THCTensor_(copyAsyncCuda).
 //
 // Note that this allocator does not split larger allocations into smaller
-// blocks, unlike the caching device allocator.
+// blocks, unlike the caching device allocator. Requests are rounded up to
+// one of four size buckets per power of two, and a cached block only serves
+// requests of its own bucket.
 //
 THC_API THAllocator* getTHCCachingHostAllocator(void);
 
@@ -25,6 +27,17 @@ THC_API THAllocator* getTHCCachingHostAllocator(void);
 // re-used until the event has occurred.
 THC_API cudaError_t THCCachingHostAllocator_recordEvent(void *ptr, THCStream *stream);
 
+// Same as THCCachingHostAllocator_recordEvent, for callers that manage their
+// own streams (e.g. caffe2's CUDAContext). 'ptr' may point anywhere inside
+// an allocation. The stream must stay alive until the allocation is freed.
+THC_API cudaError_t THCCachingHostAllocator_recordEventOnStream(void *ptr, int device, cudaStream_t stream);
+
+// Raw allocation entry points, for users that are not going through
+// THAllocator. Freeing a pointer that was not allocated here returns
+// cudaErrorInvalidValue and has no other effect.
+THC_API cudaError_t THCCachingHostAllocator_malloc(void **ptr, size_t size);
+THC_API cudaError_t THCCachingHostAllocator_free(void *ptr);
+
 // Releases cached pinned memory allocations via cudaHostFree
 THC_API void THCCachingHostAllocator_emptyCache(void);
 
@@ -86,6 +86,7 @@ void THCudaInit(THCState* state)
 
   state->deviceProperties =
     (struct cudaDeviceProp*)malloc(numDevices * sizeof(struct cudaDeviceProp));
+  state->devicePropertiesOnce = new std::once_flag[numDevices];
 
   state->rngState = (THCRNGState*)malloc(sizeof(THCRNGState));
   THCRandom_init(state, numDevices, device);
@@ -95,6 +96,7 @@ void THCudaInit(THCState* state)
   // should be cross-GPU leads to synchronization errors. The user can choose
   // to disable this functionality, however.
   state->p2pKernelAccessEnabled = 0;
+  state->deterministicAccumulate = 0;
 
   // p2pAccessEnabled records if p2p copies are allowed between pairs of
   // devices. Values include "1" (copy allowed), "0" (copy not allowed), and
@@ -113,26 +115,8 @@ void THCudaInit(THCState* state)
         state->p2pAccessEnabled[i][j] = -1;
   }
 
-  for (int i = 0; i < numDevices; ++i) {
-    THCCudaResourcesPerDevice* res = THCState_getDeviceResourcePtr(state, i);
-    THCudaCheck(cudaSetDevice(i));
-    THCudaCheck(cudaGetDeviceProperties(&state->deviceProperties[i], i));
-
-    /* The scratch space that we want to have available per each device is
-       based on the number of SMs available per device. We guarantee a
-       minimum of 128kb of space per device, but to future-proof against
-       future architectures that may have huge #s of SMs, we guarantee that
-       we have at least 16 bytes for each SM. */
-    int numSM = state->deviceProperties[i].multiProcessorCount;
-    size_t sizePerStream =
-      MIN_GLOBAL_SCRATCH_SPACE_PER_DEVICE >= numSM * MIN_GLOBAL_SCRATCH_SPACE_PER_SM_STREAM ?
-      MIN_GLOBAL_SCRATCH_SPACE_PER_DEVICE :
-      numSM * MIN_GLOBAL_SCRATCH_SPACE_PER_SM_STREAM;
-    res->scratchSpacePerStream = sizePerStream;
-  }
-
-  /* Restore to previous device */
-  THCudaCheck(cudaSetDevice(device));
+  /* The device properties and the scratch space of each device are set up
+     on first use of the device, see THCState_initDevice. */
 
   // Unlike CUDA streams, there is no NULL cuBLAS handle. The default THC
   // cuBLAS handle is the first user BLAS handle. Note that the actual BLAS
@@ -150,6 +134,7 @@ void THCudaShutdown(THCState* state)
 
   free(state->rngState);
   free(state->deviceProperties);
+  delete[] state->devicePropertiesOnce;
 
   int deviceCount = 0;
   int prevDev = -1;
@@ -267,17 +252,47 @@ void THCState_setKernelPeerToPeerAccessEnabled(THCState* state, int val) {
   state->p2pKernelAccessEnabled = val;
 }
 
+int THCState_getDeterministicAccumulate(THCState* state) {
+  return state->deterministicAccumulate;
+}
+
+void THCState_setDeterministicAccumulate(THCState* state, int val) {
+  state->deterministicAccumulate = val;
+}
+
+/* Queries the properties of a device the first time they are needed. This
+   doesn't need the device to be current, nor create a context on it. */
+static void THCState_initDevice(THCState* state, int device)
+{
+  std::call_once(state->devicePropertiesOnce[device], [state, device] {
+    THCudaCheck(cudaGetDeviceProperties(&state->deviceProperties[device], device));
+
+    /* The scratch space that we want to have available per each device is
+       based on the number of SMs available per device. We guarantee a
+       minimum of 128kb of space per device, but to future-proof against
+       future architectures that may have huge #s of SMs, we guarantee that
+       we have at least 16 bytes for each SM. */
+    int numSM = state->deviceProperties[device].multiProcessorCount;
+    size_t sizePerStream =
+      MIN_GLOBAL_SCRATCH_SPACE_PER_DEVICE >= numSM * MIN_GLOBAL_SCRATCH_SPACE_PER_SM_STREAM ?
+      MIN_GLOBAL_SCRATCH_SPACE_PER_DEVICE :
+      numSM * MIN_GLOBAL_SCRATCH_SPACE_PER_SM_STREAM;
+    THCState_getDeviceResourcePtr(state, device)->scratchSpacePerStream = sizePerStream;
+  });
+}
+
 struct cudaDeviceProp* THCState_getCurrentDeviceProperties(THCState* state)
 {
   int curDev = -1;
   THCudaCheck(cudaGetDevice(&curDev));
 
-  return &(state->deviceProperties[curDev]);
+  return THCState_getDeviceProperties(state, curDev);
 }
 
 struct cudaDeviceProp* THCState_getDeviceProperties(THCState* state, int device)
 {
   THAssert(device >= 0 && device < state->numDevices);
+  THCState_initDevice(state, device);
   return &(state->deviceProperties[device]);
 }
 
@@ -530,6 +545,7 @@ size_t THCState_getCurrentDeviceScratchSpaceSize(THCState* state)
 
 size_t THCState_getDeviceScratchSpaceSize(THCState* state, int device)
 {
+  THCState_initDevice(state, device);
   THCCudaResourcesPerDevice* res =
     THCState_getDeviceResourcePtr(state, device);
 
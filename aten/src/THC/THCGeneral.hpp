@@ -2,10 +2,15 @@
 
 #include "THCGeneral.h"
 
+#include <mutex>
+
 /* Global state of THC. */
 struct THCState {
   struct THCRNGState* rngState;
+  /* Properties of each device, queried on first use of the device (see
+     devicePropertiesOnce) so that starting up doesn't touch every device. */
   struct cudaDeviceProp* deviceProperties;
+  std::once_flag* devicePropertiesOnce;
   /* Set of all allocated resources. blasHandles and sparseHandles do not have
      a default and must be explicitly initialized. We always initialize 1
      blasHandle and 1 sparseHandle but we can use more.
@@ -45,6 +50,10 @@ struct THCState {
      GPUs in question. */
   int p2pKernelAccessEnabled;
 
+  /* Do accumulating index ops avoid atomics, so that their results are
+     reproducible? See THCState_setDeterministicAccumulate. */
+  int deterministicAccumulate;
+
   void (*cutorchGCFunction)(void *data);
   void *cutorchGCData;
   ptrdiff_t heapSoftmax;
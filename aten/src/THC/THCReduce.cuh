@@ -10,6 +10,7 @@
 
 #include "THCTensorTypeUtils.cuh"
 #include "THCReduceApplyUtils.cuh"
+#include "THCReduceContig.cuh"
 #include "THCNumerics.cuh"
 
 // Threads per thread block
@@ -22,16 +23,6 @@ __device__ __forceinline__ IndexType getReduceNoncontigDimSliceIndex() {
   return getLinearBlockId<IndexType>() * THC_NONCONTIG_REDUCE_BLOCK_SIZE + threadIdx.x;
 }
 
-// quick hack to enable two-stage use of reduceChunk
-template <typename T>
-struct SimpleCopyOp
-{
-  __device__ __forceinline__ T operator()(const T val) const 
-  {
-    return val;
-  }
-};
-
 __device__ __forceinline__ int lastpow2(int n)
 {
   int out = 1 << (31 - __clz(n));
@@ -586,8 +577,26 @@ bool THC_reduceDim(THCState* state,
     }                                                     \
   }
 
-  if(THCTensor_canUse32BitIndexMath(state, out) &&
-     THCTensor_canUse32BitIndexMath(state, in)) 
+  if (contigReduction &&
+      THCTensor_isContiguous(state, in) &&
+      THCTensor_isContiguous(state, out))
+  {
+    // Each slice is a contiguous row of `in`, and the slices are laid
+    // out one after the other like the points of `out`.
+    if (THCTensor_canUse32BitIndexMath(state, in)) {
+      THC_reduceContigRows<ScalarType, ScalarType, unsigned int>(
+        state, out->template data<ScalarType>(), in->template data<ScalarType>(),
+        (unsigned int) outElements, (unsigned int) reductionSize,
+        init, modifyOp, reduceOp, finalizeOp);
+    } else {
+      THC_reduceContigRows<ScalarType, ScalarType, uint64_t>(
+        state, out->template data<ScalarType>(), in->template data<ScalarType>(),
+        (uint64_t) outElements, (uint64_t) reductionSize,
+        init, modifyOp, reduceOp, finalizeOp);
+    }
+  }
+  else if(THCTensor_canUse32BitIndexMath(state, out) &&
+          THCTensor_canUse32BitIndexMath(state, in)) 
   {
     TensorInfo<ScalarType,
                unsigned int> outInfo =
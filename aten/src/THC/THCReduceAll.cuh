@@ -10,6 +10,7 @@
 //
 
 #include "THCReduceApplyUtils.cuh"
+#include "THCReduceContig.cuh"
 
 // Size per each reduction block
 #define THC_REDUCE_ALL_BLOCK_SIZE 1024L
@@ -281,7 +282,20 @@ bool THC_reduceAll(THCState* state,
     }                                             \
   }
 
-  if (THCTensor_canUse32BitIndexMath(state, in)) {
+  if (THCTensor_isContiguous(state, in)) {
+    // A single row, split across blocks if it is long enough
+    if (THCTensor_canUse32BitIndexMath(state, in)) {
+      THC_reduceContigRows<AccT, ScalarType, unsigned int>(
+        state, devOut, in->template data<ScalarType>(),
+        1u, (unsigned int) inElements,
+        init, modifyOp, reduceOp, SimpleCopyOp<AccT>());
+    } else {
+      THC_reduceContigRows<AccT, ScalarType, uint64_t>(
+        state, devOut, in->template data<ScalarType>(),
+        (uint64_t) 1, (uint64_t) inElements,
+        init, modifyOp, reduceOp, SimpleCopyOp<AccT>());
+    }
+  } else if (THCTensor_canUse32BitIndexMath(state, in)) {
     TensorInfo<ScalarType, unsigned int> inInfo =
       getTensorInfo<ScalarType, TensorType, unsigned int>(state, in);
     inInfo.collapseDims();
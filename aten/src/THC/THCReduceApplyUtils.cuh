@@ -12,6 +12,22 @@
 // read-only
 enum TensorArgType { ReadWrite, ReadOnly };
 
+// N consecutive values of type T, moved with a single vector load or store
+template <typename T, int N>
+struct alignas(sizeof(T) * N) THCAlignedVector {
+  T val[N];
+};
+
+// Identity op, e.g. for the second stage of two-stage reductions
+template <typename T>
+struct SimpleCopyOp
+{
+  __device__ __forceinline__ T operator()(const T val) const 
+  {
+    return val;
+  }
+};
+
 template <typename IndexType>
 __device__ __forceinline__ IndexType getLinearBlockId() {
   return blockIdx.z * gridDim.y * gridDim.x +
@@ -143,6 +159,33 @@ __device__ T reduceBlockWithNThreadLocalReductions(T *smem,
   return reduceBlock<T, ReduceOp>(smem, blockDim.x < numVals ? blockDim.x : numVals, local, reduceOp, init);
 }
 
+// Shuffles a value of any type down the warp as a sequence of ints, which
+// also covers the 8-bit and 64-bit integer types reductions accumulate in
+template <typename T>
+__device__ __forceinline__ T shuffleDownWarp(T value, unsigned int delta) {
+  constexpr int kWords = (sizeof(T) + sizeof(int) - 1) / sizeof(int);
+  union {
+    T value;
+    int words[kWords];
+  } u;
+  u.value = value;
+  #pragma unroll
+  for (int i = 0; i < kWords; ++i) {
+    u.words[i] = WARP_SHFL_DOWN(u.words[i], delta);
+  }
+  return u.value;
+}
+
+// Warp-wide reduction with shuffles; all lanes of the warp must call it and
+// only lane 0 will return the reduced value
+template <typename T, typename ReduceOp>
+__device__ __forceinline__ T reduceWarp(T threadVal, ReduceOp reduceOp) {
+  for (int delta = warpSize / 2; delta > 0; delta /= 2) {
+    threadVal = reduceOp(threadVal, shuffleDownWarp(threadVal, delta));
+  }
+  return threadVal;
+}
+
 // Make sure the given tensor doesn't have too many dimensions
 void THCCheckTensorDims(THCState* state, THCudaTensor* tensor, int arg);
 
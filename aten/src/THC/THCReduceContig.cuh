@@ -0,0 +1,255 @@
+#ifndef THC_REDUCE_CONTIG_INC
+#define THC_REDUCE_CONTIG_INC
+
+//
+// This file contains the reduction engine for the common case of
+// reducing numRows contiguous rows of rowSize elements each, i.e. the
+// innermost dimension of a contiguous tensor (or a whole contiguous
+// tensor, as a single row). Depending on the shape, each row is reduced
+// by a warp, by several warps of a block, or split across blocks whose
+// partial results are reduced again in a second pass.
+//
+
+#include "THCReduceApplyUtils.cuh"
+#include "THCNumerics.cuh"
+
+// Bytes read by each vectorized load
+#define THC_REDUCE_CONTIG_VECTOR_BYTES 16
+// Threads per block
+#define THC_REDUCE_CONTIG_BLOCK_SIZE 256
+// Blocks resident per SM at THC_REDUCE_CONTIG_BLOCK_SIZE threads
+#define THC_REDUCE_CONTIG_BLOCKS_PER_SM 8
+// Vectors each thread of a row should load before more threads are
+// assigned to the row, and before the row is split across blocks
+#define THC_REDUCE_CONTIG_VECTORS_PER_THREAD 4
+#define THC_REDUCE_CONTIG_VECTORS_PER_SPLIT_THREAD 16
+
+#ifdef __HIP_PLATFORM_HCC__
+#define THC_REDUCE_CONTIG_WARP_SIZE 64
+#else
+#define THC_REDUCE_CONTIG_WARP_SIZE 32
+#endif
+
+template <typename T>
+constexpr int THC_reduceContigVectorSize() {
+  return sizeof(T) >= THC_REDUCE_CONTIG_VECTOR_BYTES ?
+    1 : THC_REDUCE_CONTIG_VECTOR_BYTES / sizeof(T);
+}
+
+// Reduces size contiguous elements starting at data into r, thread tid of
+// numThreads taking every numThreads-th vector. The elements before the
+// first aligned vector and after the last one are read one by one.
+template <typename InT,
+          typename IndexType,
+          typename AccT,
+          typename ModifyOp,
+          typename ReduceOp,
+          int VecSize>
+__device__ __forceinline__ AccT
+reduceContigRange(const InT* data,
+                  IndexType size,
+                  IndexType tid,
+                  IndexType numThreads,
+                  AccT r,
+                  ModifyOp modifyOp,
+                  ReduceOp reduceOp) {
+  typedef THCAlignedVector<InT, VecSize> Vec;
+
+  const uintptr_t misalignment = reinterpret_cast<uintptr_t>(data) % sizeof(Vec);
+  IndexType head = misalignment == 0 ?
+    0 : (IndexType) ((sizeof(Vec) - misalignment) / sizeof(InT));
+  if (head > size) {
+    head = size;
+  }
+  if (tid < head) {
+    r = reduceOp(r, modifyOp(scalar_cast<AccT>(data[tid])));
+  }
+
+  const Vec* vecs = reinterpret_cast<const Vec*>(data + head);
+  const IndexType numVecs = (size - head) / VecSize;
+  for (IndexType v = tid; v < numVecs; v += numThreads) {
+    const Vec vec = vecs[v];
+    #pragma unroll
+    for (int i = 0; i < VecSize; ++i) {
+      r = reduceOp(r, modifyOp(scalar_cast<AccT>(vec.val[i])));
+    }
+  }
+
+  for (IndexType i = head + numVecs * VecSize + tid; i < size; i += numThreads) {
+    r = reduceOp(r, modifyOp(scalar_cast<AccT>(data[i])));
+  }
+  return r;
+}
+
+// Kernel that reduces blockDim.y rows per block at a time, blockDim.x
+// threads (a multiple of the warp size) per row, with a grid-stride loop
+// over the rows. With gridDim.y > 1 each block only reduces the
+// blockIdx.y-th chunk of chunkSize elements of its rows, and writes the
+// partial result of row `row` to out[row * gridDim.y + blockIdx.y].
+template <typename OutT,
+          typename InT,
+          typename IndexType,
+          typename AccT,
+          typename ModifyOp,
+          typename ReduceOp,
+          typename FinalizeOp,
+          int VecSize>
+#if __CUDA_ARCH__ >= 350
+__launch_bounds__(THC_REDUCE_CONTIG_BLOCK_SIZE, 4)
+#endif
+__global__ void
+kernelReduceContigRows(OutT* out,
+                       const InT* in,
+                       IndexType numRows,
+                       IndexType rowSize,
+                       IndexType chunkSize,
+                       AccT init,
+                       ModifyOp modifyOp,
+                       ReduceOp reduceOp,
+                       FinalizeOp finalizeOp) {
+  // One value per warp, for the reduction across the warps of a row
+  extern __shared__ char smemChar[];
+  const int warpsPerRow = blockDim.x / warpSize;
+  AccT* smem = (AccT*) smemChar + threadIdx.y * warpsPerRow;
+  const int lane = threadIdx.x % warpSize;
+  const int warp = threadIdx.x / warpSize;
+
+  const IndexType chunkStart = (IndexType) blockIdx.y * chunkSize;
+  const IndexType size =
+    rowSize - chunkStart < chunkSize ? rowSize - chunkStart : chunkSize;
+
+  // All threads of the block run the same number of iterations, as the
+  // cross-warp reduction synchronizes them.
+  for (IndexType rowBase = (IndexType) blockIdx.x * blockDim.y;
+       rowBase < numRows;
+       rowBase += (IndexType) gridDim.x * blockDim.y) {
+    const IndexType row = rowBase + threadIdx.y;
+
+    AccT r = init;
+    if (row < numRows) {
+      r = reduceContigRange<InT, IndexType, AccT, ModifyOp, ReduceOp, VecSize>(
+        in + row * rowSize + chunkStart, size,
+        (IndexType) threadIdx.x, (IndexType) blockDim.x,
+        r, modifyOp, reduceOp);
+    }
+    r = reduceWarp<AccT, ReduceOp>(r, reduceOp);
+
+    if (warpsPerRow > 1) {
+      if (lane == 0) {
+        smem[warp] = r;
+      }
+      __syncthreads();
+      if (warp == 0) {
+        r = lane < warpsPerRow ? smem[lane] : init;
+        r = reduceWarp<AccT, ReduceOp>(r, reduceOp);
+      }
+      __syncthreads();
+    }
+
+    if (threadIdx.x == 0 && row < numRows) {
+      out[row * gridDim.y + blockIdx.y] = scalar_cast<OutT>(finalizeOp(r));
+    }
+  }
+}
+
+// Performs out[row] = finalize(reduce_i(modify(in[row * rowSize + i]))) for
+// all rows, where `out` and `in` point to device memory. Rows of up to a few
+// vectors per lane are reduced by a warp each; longer rows get more warps, up
+// to a block. When that leaves the device underutilized, rows are split into
+// chunks reduced by separate blocks, and the partial results are reduced by a
+// second pass (instead of atomics, as ReduceOp can be any associative op and
+// this keeps the result deterministic).
+template <typename OutT,
+          typename InT,
+          typename IndexType,
+          typename AccT,
+          typename ModifyOp,
+          typename ReduceOp,
+          typename FinalizeOp>
+void THC_reduceContigRows(THCState* state,
+                          OutT* out,
+                          const InT* in,
+                          IndexType numRows,
+                          IndexType rowSize,
+                          AccT init,
+                          const ModifyOp& modifyOp,
+                          const ReduceOp& reduceOp,
+                          const FinalizeOp& finalizeOp) {
+  constexpr int vecSize = THC_reduceContigVectorSize<InT>();
+  const IndexType vectorsPerRow = THCCeilDiv(rowSize, (IndexType) vecSize);
+
+  int rowThreads = THC_REDUCE_CONTIG_WARP_SIZE;
+  while (rowThreads < THC_REDUCE_CONTIG_BLOCK_SIZE &&
+         vectorsPerRow > (IndexType) rowThreads * THC_REDUCE_CONTIG_VECTORS_PER_THREAD) {
+    rowThreads *= 2;
+  }
+  const int rowsPerBlock = THC_REDUCE_CONTIG_BLOCK_SIZE / rowThreads;
+  const dim3 block(rowThreads, rowsPerBlock);
+
+  const IndexType rowBlocks = THCCeilDiv(numRows, (IndexType) rowsPerBlock);
+  const IndexType maxBlocks = (IndexType)
+    THCState_getCurrentDeviceProperties(state)->multiProcessorCount *
+    THC_REDUCE_CONTIG_BLOCKS_PER_SM;
+  dim3 grid(rowBlocks < maxBlocks ? rowBlocks : maxBlocks);
+
+  // Split the rows if there are too few blocks to fill the device, as long
+  // as each thread still loads a fair number of vectors in its chunk.
+  IndexType splits = 1;
+  if (rowBlocks < maxBlocks) {
+    const IndexType minChunkSize = (IndexType) rowThreads * vecSize *
+      THC_REDUCE_CONTIG_VECTORS_PER_SPLIT_THREAD;
+    const IndexType maxSplits = THCCeilDiv(rowSize, minChunkSize);
+    splits = THCCeilDiv(maxBlocks, rowBlocks);
+    if (splits > maxSplits) {
+      splits = maxSplits;
+    }
+    if (splits > 65535) {
+      splits = 65535;
+    }
+  }
+
+  const size_t smemSize = rowsPerBlock * (rowThreads / THC_REDUCE_CONTIG_WARP_SIZE) *
+    sizeof(AccT);
+  cudaStream_t stream = THCState_getCurrentStream(state);
+
+  if (splits <= 1) {
+    kernelReduceContigRows<OutT, InT, IndexType, AccT,
+                           ModifyOp, ReduceOp, FinalizeOp, vecSize>
+      <<<grid, block, smemSize, stream>>>(
+        out, in, numRows, rowSize, rowSize, init,
+        modifyOp, reduceOp, finalizeOp);
+    return;
+  }
+
+  // Chunks of whole vectors keep all but the first chunk of a row aligned
+  // if the row is; recompute the splits so that none is empty.
+  const IndexType chunkSize =
+    THCRoundUp(THCCeilDiv(rowSize, splits), (IndexType) vecSize);
+  splits = THCCeilDiv(rowSize, chunkSize);
+  grid.y = splits;
+
+  AccT* partials = static_cast<AccT*>(
+    THCudaMalloc(state, sizeof(AccT) * numRows * splits));
+
+  kernelReduceContigRows<AccT, InT, IndexType, AccT,
+                         ModifyOp, ReduceOp, SimpleCopyOp<AccT>, vecSize>
+    <<<grid, block, smemSize, stream>>>(
+      partials, in, numRows, rowSize, chunkSize, init,
+      modifyOp, reduceOp, SimpleCopyOp<AccT>());
+
+  THC_reduceContigRows<OutT, AccT, IndexType, AccT,
+                       SimpleCopyOp<AccT>, ReduceOp, FinalizeOp>(
+    state, out, partials, numRows, splits, init,
+    SimpleCopyOp<AccT>(), reduceOp, finalizeOp);
+
+  THCudaFree(state, partials);
+}
+
+#undef THC_REDUCE_CONTIG_VECTOR_BYTES
+#undef THC_REDUCE_CONTIG_BLOCK_SIZE
+#undef THC_REDUCE_CONTIG_BLOCKS_PER_SM
+#undef THC_REDUCE_CONTIG_VECTORS_PER_THREAD
+#undef THC_REDUCE_CONTIG_VECTORS_PER_SPLIT_THREAD
+#undef THC_REDUCE_CONTIG_WARP_SIZE
+
+#endif // THC_REDUCE_CONTIG_INC
@@ -53,22 +53,26 @@ __device__ inline void bitonicSwapKeys(K& kA, bool& validA,
   }
 }
 
+// Sorts with the thread at index `tid` of the Power2SortSize / 2
+// threads working on this sort; every thread of the block must call
+// this, since it synchronizes the whole block
 template <typename Comparator, typename K, typename V,
           typename IndexType, int Power2SortSize>
 __device__ inline void bitonicSort(K keys[Power2SortSize],
                                    V values[Power2SortSize],
                                    bool valid[Power2SortSize],
-                                   const Comparator& comp) {
+                                   const Comparator& comp,
+                                   unsigned int tid) {
 #pragma unroll
   for (unsigned int size = 2; size < Power2SortSize; size *= 2) {
-    bool flag = ((threadIdx.x & (size / 2)) != 0);
+    bool flag = ((tid & (size / 2)) != 0);
 
 #pragma unroll
     for (unsigned int stride = size / 2; stride > 0; stride /= 2) {
     
       __syncthreads();
       
-      unsigned int pos = 2 * threadIdx.x - (threadIdx.x & (stride - 1));
+      unsigned int pos = 2 * tid - (tid & (stride - 1));
       bitonicSwap<Comparator, K, V>(
         keys[pos], values[pos], valid[pos],
         keys[pos + stride], values[pos + stride], valid[pos + stride],
@@ -81,7 +85,7 @@ __device__ inline void bitonicSort(K keys[Power2SortSize],
     
     __syncthreads();
     
-    unsigned int pos = 2 * threadIdx.x - (threadIdx.x & (stride - 1));
+    unsigned int pos = 2 * tid - (tid & (stride - 1));
     bitonicSwap<Comparator, K, V>(
       keys[pos], values[pos], valid[pos],
       keys[pos + stride], values[pos + stride], valid[pos + stride],
@@ -92,6 +96,16 @@ __device__ inline void bitonicSort(K keys[Power2SortSize],
   
 }
 
+template <typename Comparator, typename K, typename V,
+          typename IndexType, int Power2SortSize>
+__device__ inline void bitonicSort(K keys[Power2SortSize],
+                                   V values[Power2SortSize],
+                                   bool valid[Power2SortSize],
+                                   const Comparator& comp) {
+  bitonicSort<Comparator, K, V, IndexType, Power2SortSize>(
+    keys, values, valid, comp, threadIdx.x);
+}
+
 template <typename Comparator, typename K,
           typename IndexType, int Power2SortSize>
 __device__ inline void bitonicSortKeys(K keys[Power2SortSize],
@@ -211,6 +225,77 @@ bitonicSortKVInPlace(TensorInfo<K, IndexType> keys,
   }
 }
 
+// Sorts (key, value) pairs of small slices in-place like
+// bitonicSortKVInPlace, but sorts SlicesPerBlock slices per block
+// instead of one, so that short slices don't leave most of the
+// threads of a block (and of the GPU) idle. The block is
+// (Power2SortSize / 2, SlicesPerBlock) threads; threadIdx.y selects
+// the slice.
+template <typename K, typename V,
+          int KeyDims, int ValueDims,
+          typename Comparator, typename IndexType,
+          int Power2SortSize, int SlicesPerBlock>
+__launch_bounds__(Power2SortSize / 2 * SlicesPerBlock)
+__global__ void
+bitonicSortKVInPlaceBatched(TensorInfo<K, IndexType> keys,
+                            IndexType keySlices,
+                            IndexType keySliceSize,
+                            IndexType keySliceStride,
+                            TensorInfo<V, IndexType> values,
+                            IndexType valueSliceStride,
+                            const Comparator& comp) {
+  const IndexType linearIndex =
+    getLinearBlockId<IndexType>() * SlicesPerBlock + threadIdx.y;
+  // The whole block takes part in the sort, so threads of slices that
+  // are out of bounds sort a slice of invalid entries instead of
+  // returning early
+  const bool sliceValid = (linearIndex < keySlices);
+
+  __shared__ K sharedKeys[SlicesPerBlock][Power2SortSize];
+  __shared__ V sharedValues[SlicesPerBlock][Power2SortSize];
+  __shared__ bool sharedValid[SlicesPerBlock][Power2SortSize];
+
+  const IndexType keyStartOffset = sliceValid ?
+    IndexToOffset<K, IndexType, KeyDims>::get(linearIndex, keys) : 0;
+  const IndexType valueStartOffset = sliceValid ?
+    IndexToOffset<V, IndexType, ValueDims>::get(linearIndex, values) : 0;
+
+  const int elem1 = threadIdx.x;
+  const int elem2 = threadIdx.x + (Power2SortSize / 2);
+
+  bool valid1 = sliceValid && (elem1 < keySliceSize);
+  sharedKeys[threadIdx.y][elem1] = valid1 ?
+    keys.data[keyStartOffset + elem1 * keySliceStride] : ScalarConvert<int, K>::to(0);
+  sharedValues[threadIdx.y][elem1] = valid1 ?
+    values.data[valueStartOffset + elem1 * valueSliceStride] : ScalarConvert<int, V>::to(0);
+  sharedValid[threadIdx.y][elem1] = valid1;
+
+  bool valid2 = sliceValid && (elem2 < keySliceSize);
+  sharedKeys[threadIdx.y][elem2] = valid2 ?
+    keys.data[keyStartOffset + elem2 * keySliceStride] : ScalarConvert<int, K>::to(0);
+  sharedValues[threadIdx.y][elem2] = valid2 ?
+    values.data[valueStartOffset + elem2 * valueSliceStride] : ScalarConvert<int, V>::to(0);
+  sharedValid[threadIdx.y][elem2] = valid2;
+
+  bitonicSort<Comparator, K, V, IndexType, Power2SortSize>(
+    sharedKeys[threadIdx.y], sharedValues[threadIdx.y],
+    sharedValid[threadIdx.y], comp, threadIdx.x);
+
+  if (valid1) {
+    keys.data[keyStartOffset + elem1 * keySliceStride] =
+      sharedKeys[threadIdx.y][elem1];
+    values.data[valueStartOffset + elem1 * valueSliceStride] =
+      sharedValues[threadIdx.y][elem1];
+  }
+
+  if (valid2) {
+    keys.data[keyStartOffset + elem2 * keySliceStride] =
+      sharedKeys[threadIdx.y][elem2];
+    values.data[valueStartOffset + elem2 * valueSliceStride] =
+      sharedValues[threadIdx.y][elem2];
+  }
+}
+
 uint64_t nextHighestPowerOf2(uint64_t n);
 
 #endif // THC_SORT_UTILS_INC
@@ -2,6 +2,7 @@
 #include "THCHalf.h"
 #include "THCNumerics.cuh"
 #include "THCTensorCopy.hpp"
+#include <algorithm>
 #include <type_traits>
 
 inline int curGPU() {
@@ -22,6 +23,157 @@ struct CopyOp {
   }
 };
 
+// Tiles transposed through shared memory by THC_copyPermute
+#define THC_PERMUTE_TILE 32
+#define THC_PERMUTE_TILE_ROWS 8
+#define THC_PERMUTE_MAX_DIMS 8
+
+// src, copied into a contiguous dst of the same size, described by merged
+// dims: the last one, the one src stores contiguously and the outer ones
+struct PermuteCopyParams {
+  int64_t outerSizes[THC_PERMUTE_MAX_DIMS];
+  int64_t outerStrides[THC_PERMUTE_MAX_DIMS];
+  int64_t outerDstStrides[THC_PERMUTE_MAX_DIMS];
+  int outerDims;
+  int64_t outer;
+  int64_t NI, NL;
+  int64_t SI, SL;
+  int64_t RI;
+};
+
+template <typename T>
+__global__ void THC_copyPermuteKernel(T* dst, const T* src, PermuteCopyParams p) {
+  __shared__ T tile[THC_PERMUTE_TILE][THC_PERMUTE_TILE + 1];
+  int64_t tilesI = THCCeilDiv(p.NI, (int64_t) THC_PERMUTE_TILE);
+  int64_t tilesL = THCCeilDiv(p.NL, (int64_t) THC_PERMUTE_TILE);
+  for (int64_t t = blockIdx.x; t < p.outer * tilesI * tilesL; t += gridDim.x) {
+    int64_t outer = t / (tilesI * tilesL);
+    int64_t I = (t / tilesL) % tilesI * THC_PERMUTE_TILE;
+    int64_t L = t % tilesL * THC_PERMUTE_TILE;
+    const T* s = src;
+    T* d = dst;
+    for (int k = p.outerDims - 1; k >= 0; k--) {
+      s += (outer % p.outerSizes[k]) * p.outerStrides[k];
+      d += (outer % p.outerSizes[k]) * p.outerDstStrides[k];
+      outer /= p.outerSizes[k];
+    }
+
+    // consecutive threads read along the dim src stores contiguously ...
+    int64_t i = I + threadIdx.x;
+    for (int j = threadIdx.y; j < THC_PERMUTE_TILE; j += THC_PERMUTE_TILE_ROWS) {
+      int64_t l = L + j;
+      if (i < p.NI && l < p.NL) {
+        tile[j][threadIdx.x] = s[i * p.SI + l * p.SL];
+      }
+    }
+    __syncthreads();
+    // ... and write along the last dim, which dst stores contiguously
+    int64_t l = L + threadIdx.x;
+    for (int j = threadIdx.y; j < THC_PERMUTE_TILE; j += THC_PERMUTE_TILE_ROWS) {
+      int64_t row = I + j;
+      if (row < p.NI && l < p.NL) {
+        d[row * p.RI + l] = tile[threadIdx.x][j];
+      }
+    }
+    __syncthreads();
+  }
+}
+
+// Copies src into the contiguous dst of the same size and type when src is
+// a permutation of it that doesn't store the last dim contiguously, e.g. a
+// transposed matrix or NCHW <-> NHWC, which the pointwise copy would read or
+// write uncoalesced. As in TH's copyPermute, dims of size 1 are dropped and
+// neighbours src stores contiguously are merged; each block then transposes
+// tiles between the last dim and the one src stores contiguously. Returns
+// false for the copies it doesn't handle.
+template <typename ScalarType>
+bool THC_copyPermute(THCState* state, THCTensor* dst, THCTensor* src,
+                     cudaStream_t stream) {
+  int dims = THCTensor__nDimension(state, src);
+  if (dims != THCTensor__nDimension(state, dst) ||
+      THCTensor_nElement(state, src) < THC_PERMUTE_TILE * THC_PERMUTE_TILE) {
+    return false;
+  }
+  int64_t sizes[MAX_CUTORCH_DIMS];
+  int64_t strides[MAX_CUTORCH_DIMS];
+  int merged = 0;
+  for (int d = 0; d < dims; d++) {
+    int64_t size = THCTensor_size(state, src, d);
+    int64_t stride = THCTensor_stride(state, src, d);
+    if (size != THCTensor_size(state, dst, d)) {
+      return false;
+    }
+    if (size == 1) {
+      continue;
+    }
+    if (merged > 0 && strides[merged - 1] == size * stride) {
+      sizes[merged - 1] *= size;
+      strides[merged - 1] = stride;
+    } else if (merged < MAX_CUTORCH_DIMS) {
+      sizes[merged] = size;
+      strides[merged] = stride;
+      merged++;
+    } else {
+      return false;
+    }
+  }
+  if (merged < 2 || merged - 2 > THC_PERMUTE_MAX_DIMS) {
+    return false;
+  }
+  int last = merged - 1;
+  int inner = last;
+  for (int d = 0; d < last; d++) {
+    if (strides[d] < strides[inner]) {
+      inner = d;
+    }
+  }
+  if (inner == last) {
+    return false;
+  }
+
+  PermuteCopyParams p;
+  p.outerDims = merged - 2;
+  p.outer = 1;
+  int k = p.outerDims;
+  int64_t dstStride = 1;
+  for (int d = last; d >= 0; d--) {
+    if (d == last) {
+      p.NL = sizes[d];
+      p.SL = strides[d];
+    } else if (d == inner) {
+      p.NI = sizes[d];
+      p.SI = strides[d];
+      p.RI = dstStride;
+    } else {
+      k--;
+      p.outerSizes[k] = sizes[d];
+      p.outerStrides[k] = strides[d];
+      p.outerDstStrides[k] = dstStride;
+      p.outer *= sizes[d];
+    }
+    dstStride *= sizes[d];
+  }
+
+  int64_t tiles = p.outer *
+    THCCeilDiv(p.NI, (int64_t) THC_PERMUTE_TILE) *
+    THCCeilDiv(p.NL, (int64_t) THC_PERMUTE_TILE);
+  int64_t maxGridX = THCState_getCurrentDeviceProperties(state)->maxGridSize[0];
+  dim3 grid(std::min(tiles, maxGridX));
+  dim3 block(THC_PERMUTE_TILE, THC_PERMUTE_TILE_ROWS);
+
+  // the copy only moves bits, so types of the same size share kernels
+  typedef typename std::conditional<sizeof(ScalarType) == 1, uint8_t,
+          typename std::conditional<sizeof(ScalarType) == 2, uint16_t,
+          typename std::conditional<sizeof(ScalarType) == 4, uint32_t,
+                                    uint64_t>::type>::type>::type Bits;
+  static_assert(sizeof(Bits) == sizeof(ScalarType), "unexpected scalar size");
+  THC_copyPermuteKernel<Bits><<<grid, block, 0, stream>>>(
+    reinterpret_cast<Bits*>(dst->template data<ScalarType>()),
+    reinterpret_cast<const Bits*>(src->template data<ScalarType>()),
+    p);
+  return true;
+}
+
 // Copy for the same type to the same type
 template <typename ScalarTypeDst, typename ScalarTypeSrc>
 void THC_copyTensor(THCState* state, THCTensor* dst, THCTensor* src) {
@@ -114,14 +266,17 @@ void THC_copyTensor(THCState* state, THCTensor* dst, THCTensor* src) {
     // they are not, then taking the hit of the memory allocation/free
     // might be worth it to avoid non-coalesced reads or writes.
     if (p2pEnabled) {
-      bool succ =
-        THC_pointwiseApply2<ScalarTypeDst,
-                            ScalarTypeSrc>(
-          state, dst, src,
-          CopyOp<ScalarTypeDst,
-                 ScalarTypeSrc>());
-
-      THArgCheck(succ, 2, CUTORCH_DIM_WARNING);
+      if (!(sameType && dstContig &&
+            THC_copyPermute<ScalarTypeDst>(state, dst, src, copyStream))) {
+        bool succ =
+          THC_pointwiseApply2<ScalarTypeDst,
+                              ScalarTypeSrc>(
+            state, dst, src,
+            CopyOp<ScalarTypeDst,
+                   ScalarTypeSrc>());
+
+        THArgCheck(succ, 2, CUTORCH_DIM_WARNING);
+      }
     } else {
       // GPUs can't access each other directly, but the tensors
       // involved are non-contiguous and/or are different types.
@@ -201,6 +201,56 @@ __global__ void indexAddLargeIndex(TensorInfo<T, IndexType> dst,
   }
 }
 
+// Alternative to the atomicAdd kernels above, for many repeated indices
+// or reproducible results: the indices are sorted beforehand, along with
+// their positions in `indices`, and only the first of each run of equal
+// indices adds the source slices of the whole run to its destination, in
+// their original order.
+template <typename T, typename AccT, typename IndexType, int DstDim, int SrcDim>
+__global__ void indexAddSortedIndex(TensorInfo<T, IndexType> dst,
+                                    TensorInfo<T, IndexType> src,
+                                    const int64_t* sortedIndices,
+                                    const int64_t* positions,
+                                    int dstAddDim,
+                                    int srcAddDim,
+                                    IndexType totalSize,
+                                    IndexType innerSize,
+                                    IndexType numIndices,
+                                    int64_t dstAddDimSize) {
+  for (IndexType linearIndex = blockIdx.x * blockDim.x + threadIdx.x;
+       linearIndex < totalSize;
+       linearIndex += gridDim.x * blockDim.x) {
+    IndexType sortedIndex = linearIndex / innerSize;
+    IndexType elementInSlice = linearIndex % innerSize;
+
+    const int64_t index = sortedIndices[sortedIndex];
+    if (sortedIndex > 0 && sortedIndices[sortedIndex - 1] == index) {
+      continue;
+    }
+
+    // Lua indices begin at 1
+    IndexType dstIndex = index - TH_INDEX_BASE;
+    assert(dstIndex < dstAddDimSize);
+
+    IndexType dstOffset =
+      IndexToOffset<T, IndexType, DstDim>::get(elementInSlice, dst);
+    dstOffset += dstIndex * dst.strides[dstAddDim];
+
+    IndexType srcBaseOffset =
+      IndexToOffset<T, IndexType, SrcDim>::get(elementInSlice, src);
+
+    AccT sum = ScalarConvert<T, AccT>::to(dst.data[dstOffset]);
+    do {
+      IndexType srcOffset =
+        srcBaseOffset + (IndexType) positions[sortedIndex] * src.strides[srcAddDim];
+      sum = THCNumerics<AccT>::add(sum, ScalarConvert<T, AccT>::to(src.data[srcOffset]));
+      ++sortedIndex;
+    } while (sortedIndex < numIndices && sortedIndices[sortedIndex] == index);
+
+    dst.data[dstOffset] = ScalarConvert<AccT, T>::to(sum);
+  }
+}
+
 // We prefer this kernel to avoid reloading index points if the number
 // of indices is a small number.
 // This kernel in fact works for all choices of problem size, but if
@@ -2,6 +2,8 @@
 #include "THCGeneral.h"
 #include "THCAtomics.cuh"
 #include "THCApply.cuh"
+#include "THCNumerics.cuh"
+#include "THCTensorSort.cuh"
 
 // Compute the offsets into the given tensors for a linear index. For the 't2'
 // tensor, dimension 'dim' is skipped. The tensors are assumed to have the same
@@ -155,6 +157,75 @@ __global__ void THCudaTensor_scatterAddKernel(
   }
 }
 
+// First step of the sorted alternative to THCudaTensor_scatterAddKernel:
+// computes the offset in `tensor` each element of `src` is added to.
+template <typename IndexType, typename Real, int Dims>
+__global__ void THCudaTensor_scatterAddOffsetsKernel(
+    TensorInfo<Real, IndexType> tensor,
+    TensorInfo<Real, IndexType> src,
+    TensorInfo<int64_t, IndexType> index,
+    const int dim,
+    const IndexType totalElements,
+    int64_t* tensorOffsets) {
+  for (IndexType linearId = blockIdx.x * blockDim.x + threadIdx.x;
+       linearId < totalElements;
+       linearId += gridDim.x * blockDim.x) {
+    IndexType tensorOffset = 0;
+    IndexType srcOffset = 0;
+    IndexType indexOffset = 0;
+
+    IndexToScatterGatherOffsets<IndexType, Real, Dims>::compute(linearId, dim,
+                                                          index, &indexOffset,
+                                                          src, &srcOffset,
+                                                          tensor, &tensorOffset);
+
+    int64_t indexValue = index.data[indexOffset] - TH_INDEX_BASE;
+    assert(indexValue >= 0 && indexValue < tensor.sizes[dim]);
+    tensorOffsets[linearId] = tensorOffset + indexValue * tensor.strides[dim];
+  }
+}
+
+// Second step, once the offsets are sorted along with the linear ids of
+// their elements of `src`: only the first of each run of equal offsets adds
+// the elements of the whole run, in their original order, to `tensor`. This
+// avoids contention on repeated offsets and gives reproducible results.
+template <typename IndexType, typename Real, typename AccReal, int Dims>
+__global__ void THCudaTensor_scatterAddSortedKernel(
+    TensorInfo<Real, IndexType> tensor,
+    TensorInfo<Real, IndexType> src,
+    TensorInfo<int64_t, IndexType> index,
+    const int dim,
+    const IndexType totalElements,
+    const int64_t* sortedOffsets,
+    const int64_t* linearIds) {
+  for (IndexType i = blockIdx.x * blockDim.x + threadIdx.x;
+       i < totalElements;
+       i += gridDim.x * blockDim.x) {
+    const int64_t tensorOffset = sortedOffsets[i];
+    if (i > 0 && sortedOffsets[i - 1] == tensorOffset) {
+      continue;
+    }
+
+    AccReal sum = ScalarConvert<Real, AccReal>::to(tensor.data[tensorOffset]);
+    IndexType j = i;
+    do {
+      IndexType unusedOffset = 0;
+      IndexType srcOffset = 0;
+      IndexType indexOffset = 0;
+      IndexToScatterGatherOffsets<IndexType, Real, Dims>::compute(
+          (IndexType) linearIds[j], dim,
+          index, &indexOffset,
+          src, &srcOffset,
+          tensor, &unusedOffset);
+      sum = THCNumerics<AccReal>::add(
+          sum, ScalarConvert<Real, AccReal>::to(src.data[srcOffset]));
+      ++j;
+    } while (j < totalElements && sortedOffsets[j] == tensorOffset);
+
+    tensor.data[tensorOffset] = ScalarConvert<AccReal, Real>::to(sum);
+  }
+}
+
 template <typename IndexType, typename Real, int Dims>
 __global__ void THCudaTensor_scatterFillKernel(
     TensorInfo<Real, IndexType> tensor,
@@ -1,5 +1,7 @@
 #include "THCTensorSort.cuh"
 
+#include <thrust/sequence.h>
+
 void THCudaLongTensor_fillSliceWithIndex(THCState* state,
                                          THCudaLongTensor* t,
                                          int dim) {
@@ -60,3 +62,20 @@ void THCudaLongTensor_fillSliceWithIndex(THCState* state,
 
   THCudaCheck(cudaGetLastError());
 }
+
+void THCudaLongTensor_stableSortWithPositions(THCState* state,
+                                              THCudaLongTensor* keys,
+                                              THCudaLongTensor* positions) {
+  THAssert(THCudaLongTensor_isContiguous(state, keys));
+  ptrdiff_t numKeys = THCudaLongTensor_nElement(state, keys);
+  THCudaLongTensor_resize1d(state, positions, numKeys);
+
+  THCThrustAllocator thrustAlloc(state);
+  auto policy = thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state));
+  auto keyIter = thrust::device_ptr<int64_t>(THCudaLongTensor_data(state, keys));
+  auto positionIter =
+    thrust::device_ptr<int64_t>(THCudaLongTensor_data(state, positions));
+
+  thrust::sequence(policy, positionIter, positionIter + numKeys);
+  thrust::stable_sort_by_key(policy, keyIter, keyIter + numKeys, positionIter);
+}
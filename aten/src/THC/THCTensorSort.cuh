@@ -7,6 +7,9 @@
 #include "THCTensorTypeUtils.cuh"
 
 #include "THCThrustAllocator.cuh"
+#include <cub/device/device_segmented_radix_sort.cuh>
+#include <cub/iterator/counting_input_iterator.cuh>
+#include <cub/iterator/transform_input_iterator.cuh>
 #include <thrust/device_ptr.h>
 #include <thrust/sort.h>
 #if CUDA_VERSION >= 7000 || defined(__HIP_PLATFORM_HCC__)
@@ -80,7 +83,41 @@ struct GlobalIndexToPerSliceIndex {
   const int64_t sliceSize;
 };
 
+// For segmented radix sort in CUB; maps a slice number to the offset
+// of the first element of that slice in a contiguous tensor whose
+// innermost dimension is the slice
+struct SliceToOffset {
+  __host__ __device__ SliceToOffset(int size) : sliceSize(size) {}
+
+  __host__ __device__ __forceinline__ int operator()(const int& slice) const {
+    return slice * sliceSize;
+  }
+
+  const int sliceSize;
+};
+
+typedef cub::TransformInputIterator<
+  int, SliceToOffset, cub::CountingInputIterator<int> > SliceOffsetIterator;
+
 void THCudaLongTensor_fillSliceWithIndex(THCState* state,
                                          THCudaLongTensor* t,
                                          int dim);
+
+// Sorts the contiguous `keys` in place and sets `positions` to the position
+// each key had before sorting. Equal keys keep their relative order.
+void THCudaLongTensor_stableSortWithPositions(THCState* state,
+                                              THCudaLongTensor* keys,
+                                              THCudaLongTensor* positions);
+
+// Whether accumulating numUpdates values into numDestinations places should
+// sort the updates by destination and reduce each run of them, rather than
+// use atomics: always if accumulation is to be deterministic, and otherwise
+// if there are enough updates per destination, on average, for atomics on
+// the same addresses to contend.
+inline bool THC_shouldSortAccumulate(THCState* state,
+                                     ptrdiff_t numUpdates,
+                                     ptrdiff_t numDestinations) {
+  return THCState_getDeterministicAccumulate(state) ||
+    numUpdates >= numDestinations * 16;
+}
 #endif // THC_TENSORSORT_CUH
@@ -239,10 +239,18 @@ static void THCTensor_(sort_indices)(THCState *state, THCudaLongTensor *index, T
   auto src_iter = thrust::device_ptr<real>(THCTensor_(data)(state, src));
   auto numel = THCTensor_(numel)(state, src);
 
-  thrust::sort_by_key(
-    thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
-    index_iter, index_iter + numel,
-    src_iter, ThrustLTOp<int64_t>());
+  // A stable sort keeps the order in which values with the same index are
+  // accumulated, which makes the result reproducible
+  if (THCState_getDeterministicAccumulate(state)) {
+    thrust::stable_sort_by_key(
+      thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+      index_iter, index_iter + numel, src_iter);
+  } else {
+    thrust::sort_by_key(
+      thrust::cuda::par(thrustAlloc).on(THCState_getCurrentStream(state)),
+      index_iter, index_iter + numel,
+      src_iter, ThrustLTOp<int64_t>());
+  }
 }
 
 void THCTensor_(put)(THCState *state, THCTensor *dst, THCudaLongTensor *index, THCTensor *src, int accumulate)
@@ -281,6 +289,72 @@ void THCTensor_(put)(THCState *state, THCTensor *dst, THCudaLongTensor *index, T
   }
 }
 
+// indexAdd by sorting the indices and reducing each run of equal ones,
+// see indexAddSortedIndex
+static void THCTensor_(indexAddSorted)(THCState *state, THCTensor *dst, int dim,
+                                       THCudaLongTensor *indices, THCTensor *src,
+                                       ptrdiff_t sliceSize, int64_t dstAddDimSize)
+{
+  ptrdiff_t numIndices = THCudaLongTensor_nElement(state, indices);
+  ptrdiff_t totalSize = sliceSize * numIndices;
+  cudaStream_t stream = THCState_getCurrentStream(state);
+  int mpc = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
+
+  THCudaLongTensor* sortedIndices = THCudaLongTensor_newClone(state, indices);
+  THCudaLongTensor* positions = THCudaLongTensor_new(state);
+  THCudaLongTensor_stableSortWithPositions(state, sortedIndices, positions);
+
+#define SORTED_INDEX(TENSOR_TYPE, TYPE, DST_DIM, SRC_DIM)           \
+  indexAddSortedIndex<TENSOR_TYPE, accreal, TYPE, DST_DIM, SRC_DIM> \
+    <<<grid, block, 0, stream>>>(                                   \
+      dstInfo, srcInfo,                                             \
+      THCudaLongTensor_data(state, sortedIndices),                  \
+      THCudaLongTensor_data(state, positions),                      \
+      dstAddDim, srcAddDim, totalSize, sliceSize, numIndices,       \
+      dstAddDimSize);
+
+  dim3 grid(std::min(THCCeilDiv(totalSize, (ptrdiff_t)128), (ptrdiff_t)(mpc * 8)));
+  dim3 block(std::min(totalSize, (ptrdiff_t)128));
+
+  if (THCTensor_canUse32BitIndexMath(state, dst) &&
+      THCTensor_canUse32BitIndexMath(state, src)) {
+    TensorInfo<real, unsigned int> dstInfo =
+      getTensorInfo<real, THCTensor, unsigned int>(state, dst);
+    int dstAddDim = dstInfo.collapseDims(dim);
+    dstInfo.reduceDim(dstAddDim);
+
+    TensorInfo<real, unsigned int> srcInfo =
+      getTensorInfo<real, THCTensor, unsigned int>(state, src);
+    int srcAddDim = srcInfo.collapseDims(dim);
+    srcInfo.reduceDim(srcAddDim);
+
+    if (dstInfo.dims == 1 && srcInfo.dims == 1) {
+      SORTED_INDEX(real, unsigned int, 1, 1);
+    } else if (dstInfo.dims == 2 && srcInfo.dims == 2) {
+      SORTED_INDEX(real, unsigned int, 2, 2);
+    } else {
+      SORTED_INDEX(real, unsigned int, -1, -1);
+    }
+  } else {
+    TensorInfo<real, uint64_t> dstInfo =
+      getTensorInfo<real, THCTensor, uint64_t>(state, dst);
+    int dstAddDim = dstInfo.collapseDims(dim);
+    dstInfo.reduceDim(dstAddDim);
+
+    TensorInfo<real, uint64_t> srcInfo =
+      getTensorInfo<real, THCTensor, uint64_t>(state, src);
+    int srcAddDim = srcInfo.collapseDims(dim);
+    srcInfo.reduceDim(srcAddDim);
+
+    SORTED_INDEX(real, uint64_t, -1, -1);
+  }
+
+#undef SORTED_INDEX
+
+  THCudaLongTensor_free(state, sortedIndices);
+  THCudaLongTensor_free(state, positions);
+}
+
 void THCTensor_(indexAdd)(THCState *state, THCTensor *dst, int dim, THCudaLongTensor *indices, THCTensor *src)
 {
   THCAssertSameGPU(THCTensor_(checkGPU)(state, 2, dst, src));
@@ -308,6 +382,13 @@ void THCTensor_(indexAdd)(THCState *state, THCTensor *dst, int dim, THCudaLongTe
 
   int mpc = THCState_getCurrentDeviceProperties(state)->multiProcessorCount;
 
+  if (numIndices > 0 && sliceSize > 0 &&
+      THC_shouldSortAccumulate(state, numIndices, dstAddDimSize)) {
+    THCTensor_(indexAddSorted)(state, dst, dim, indices, src,
+                               sliceSize, dstAddDimSize);
+    return;
+  }
+
 #define SMALL_INDEX(TENSOR_TYPE, TYPE, DST_DIM, SRC_DIM, IDX_DIM) \
   indexAddSmallIndex<TENSOR_TYPE, TYPE, DST_DIM, SRC_DIM, IDX_DIM> \
     <<<smallIndexGrid, smallIndexBlock, 0, stream>>>(   \
@@ -47,9 +47,16 @@ void THCTensor_(gather)(THCState* state, THCTensor *tensor,
     tensor = THCTensor_(newContiguous)(state, tensor);
   }
 
-  if (THCTensor_canUse32BitIndexMath(state, tensor) &&
-      THCTensor_canUse32BitIndexMath(state, src) &&
-      THCTensor_canUse32BitIndexMath(state, index)) {
+  // Each element of `tensor` receives index.size(dim) / tensor.size(dim)
+  // elements of `src` on average
+  if (totalElements > 0 &&
+      THC_shouldSortAccumulate(state, THCudaLongTensor_size(state, index, dim),
+                               THCTensor_(size)(state, tensor, dim))) {
+    THCTensor_(scatterAddSorted)(state, tensor, dim, index, src,
+                                 grid, block, curDevice);
+  } else if (THCTensor_canUse32BitIndexMath(state, tensor) &&
+             THCTensor_canUse32BitIndexMath(state, src) &&
+             THCTensor_canUse32BitIndexMath(state, index)) {
     TensorInfo<real, unsigned int> tensorInfo =
       getTensorInfo<real, THCTensor, unsigned int>(state, tensor);
     TensorInfo<real, unsigned int> srcInfo =
@@ -188,6 +195,72 @@ void THCTensor_(scatter)(THCState* state, THCTensor *tensor, int dim, THCudaLong
 
 #undef RUN
 
+#define RUN(TYPE, DIMS, REAL)                                                 \
+  THCudaTensor_scatterAddOffsetsKernel<TYPE, REAL, DIMS>                      \
+  <<<grid, block, 0, stream>>>(                                               \
+    tensorInfo, srcInfo, indexInfo, dim, (TYPE)totalElements,                 \
+    THCudaLongTensor_data(state, offsets));                                   \
+  THCudaLongTensor_stableSortWithPositions(state, offsets, linearIds);        \
+  THCudaTensor_scatterAddSortedKernel<TYPE, REAL, accreal, DIMS>              \
+  <<<grid, block, 0, stream>>>(                                               \
+    tensorInfo, srcInfo, indexInfo, dim, (TYPE)totalElements,                 \
+    THCudaLongTensor_data(state, offsets),                                    \
+    THCudaLongTensor_data(state, linearIds));
+
+// scatterAdd by sorting the offsets the elements of `src` are added to and
+// reducing each run of equal ones, see THCudaTensor_scatterAddSortedKernel
+static void THCTensor_(scatterAddSorted)(THCState* state, THCTensor *tensor,
+                                         int dim, THCudaLongTensor *index,
+                                         THCTensor *src, dim3 grid, dim3 block,
+                                         int curDevice) {
+  const ptrdiff_t totalElements = THCudaLongTensor_nElement(state, index);
+  cudaStream_t stream = THCState_getCurrentStreamOnDevice(state, curDevice);
+
+  THCudaLongTensor* offsets = THCudaLongTensor_newWithSize1d(state, totalElements);
+  THCudaLongTensor* linearIds = THCudaLongTensor_new(state);
+
+  if (THCTensor_canUse32BitIndexMath(state, tensor) &&
+      THCTensor_canUse32BitIndexMath(state, src) &&
+      THCTensor_canUse32BitIndexMath(state, index)) {
+    TensorInfo<real, unsigned int> tensorInfo =
+      getTensorInfo<real, THCTensor, unsigned int>(state, tensor);
+    TensorInfo<real, unsigned int> srcInfo =
+      getTensorInfo<real, THCTensor, unsigned int>(state, src);
+    TensorInfo<int64_t, unsigned int> indexInfo =
+      getTensorInfo<int64_t, THCudaLongTensor, unsigned int>(state, index);
+
+    // Specialize for a small number of dimensions.
+    switch (indexInfo.dims) {
+      case 1:
+        RUN(unsigned int, 1, real);
+        break;
+      case 2:
+        RUN(unsigned int, 2, real);
+        break;
+      case 3:
+        RUN(unsigned int, 3, real);
+        break;
+      default:
+        RUN(unsigned int, -1, real);
+        break;
+    }
+  } else {
+    TensorInfo<real, uint64_t> tensorInfo =
+      getTensorInfo<real, THCTensor, uint64_t>(state, tensor);
+    TensorInfo<real, uint64_t> srcInfo =
+      getTensorInfo<real, THCTensor, uint64_t>(state, src);
+    TensorInfo<int64_t, uint64_t> indexInfo =
+      getTensorInfo<int64_t, THCudaLongTensor, uint64_t>(state, index);
+
+    RUN(uint64_t, -1, real)
+  }
+
+  THCudaLongTensor_free(state, offsets);
+  THCudaLongTensor_free(state, linearIds);
+}
+
+#undef RUN
+
 #define RUN(TYPE, DIMS, REAL)                                           \
   THCudaTensor_scatterAddKernel<TYPE, REAL, DIMS>                               \
   <<<grid, block, 0, THCState_getCurrentStreamOnDevice(state, curDevice)>>>(               \
@@ -45,6 +45,15 @@ THC_API void THCTensor_(sortKeyValueInplace)(THCState* state,
     THError("Slice to sort is too large");
   }
 
+  // Slices of up to 32 elements would only keep 16 threads of a block
+  // busy, so these are sorted SLICES_PER_BLOCK slices to a block
+#define SLICES_PER_BLOCK 16
+  dim3 batchedGrid;
+  if (!THC_getGridFromTiles(THCCeilDiv(keySlices, (ptrdiff_t) SLICES_PER_BLOCK),
+                            batchedGrid)) {
+    THError("Slice to sort is too large");
+  }
+
 #define HANDLE_CASE(TYPE, A, SIZE)                                      \
   do {                                                                  \
     int blockSize = SIZE / 2;                                           \
@@ -77,6 +86,35 @@ THC_API void THCTensor_(sortKeyValueInplace)(THCState* state,
     }                                                                   \
   } while (0)
 
+#define HANDLE_BATCHED_CASE(TYPE, A, SIZE)                              \
+  do {                                                                  \
+    dim3 block(SIZE / 2, SLICES_PER_BLOCK);                             \
+                                                                        \
+    if (dir) {                                                          \
+      bitonicSortKVInPlaceBatched<real, int64_t, A, -1, GTComp<real>,   \
+                                  TYPE, SIZE, SLICES_PER_BLOCK>         \
+        <<<batchedGrid, block, 0, THCState_getCurrentStream(state)>>>(  \
+          keyInfo,                                                      \
+          keySlices,                                                    \
+          (TYPE) keySliceSize,                                          \
+          (TYPE) keyInfo.strides[collapseKeyDim],                       \
+          valueInfo,                                                    \
+          (TYPE) valueInfo.strides[collapseValueDim],                   \
+          GTComp<real>());                                              \
+    } else {                                                            \
+      bitonicSortKVInPlaceBatched<real, int64_t, A, -1, LTComp<real>,   \
+                                  TYPE, SIZE, SLICES_PER_BLOCK>         \
+        <<<batchedGrid, block, 0, THCState_getCurrentStream(state)>>>(  \
+          keyInfo,                                                      \
+          keySlices,                                                    \
+          (TYPE) keySliceSize,                                          \
+          (TYPE) keyInfo.strides[collapseKeyDim],                       \
+          valueInfo,                                                    \
+          (TYPE) valueInfo.strides[collapseValueDim],                   \
+          LTComp<real>());                                              \
+    }                                                                   \
+  } while (0)
+
 #define HANDLE_SORT_CASE(TYPE, A)                       \
   {                                                     \
     switch (ceilPowerOf2) {                             \
@@ -97,7 +135,7 @@ THC_API void THCTensor_(sortKeyValueInplace)(THCState* state,
       case 8:                                           \
       case 4:                                           \
       case 2:                                           \
-      HANDLE_CASE(TYPE, A, 32);                         \
+      HANDLE_BATCHED_CASE(TYPE, A, 32);                 \
       break;                                            \
       case 1:                                           \
       /* Nothing to do, data already sorted */          \
@@ -147,7 +185,9 @@ THC_API void THCTensor_(sortKeyValueInplace)(THCState* state,
     HANDLE_SORT_CASE(uint64_t, -1);
   }
 #undef HANDLE_CASE
+#undef HANDLE_BATCHED_CASE
 #undef HANDLE_SORT_CASE
+#undef SLICES_PER_BLOCK
 #undef HANDLE_A_CASE
 
   THCudaCheck(cudaGetLastError());
@@ -276,6 +316,88 @@ void THCTensor_(sortViaThrust)(THCState* state,
   THCudaLongTensor_freeCopyTo(state, trContigIndices, indices);
 }
 
+#if !defined(THC_REAL_IS_HALF)
+// Sorts all slices at once with a CUB segmented radix sort. Like the
+// Thrust sort, this needs the slices to be innermost and contiguous,
+// but it sorts every element only once, and is stable as well.
+// Requires fewer than 2^31 elements in total.
+void THCTensor_(sortViaSegmentedRadixSort)(THCState* state,
+                                           THCTensor* sorted,
+                                           THCudaLongTensor* indices,
+                                           THCTensor* input,
+                                           int dim, bool dir) {
+  int nDims = THCTensor_(_nDimension)(state, input);
+
+  int totalElements = (int) THCTensor_(nElement)(state, input);
+  int sliceSize = (int) THCTensor_(size)(state, input, dim);
+  int numSlices = totalElements / sliceSize;
+
+  // Transpose dim to innermost, and make the keys contiguous
+  THCTensor* trInput = THCTensor_(newWithTensor)(state, input);
+  if (dim != nDims - 1) {
+    THCTensor_(transpose)(state, trInput, NULL, dim, nDims - 1);
+  }
+  THCTensor* trContigInput = THCTensor_(newContiguous)(state, trInput);
+  THCTensor_(free)(state, trInput);
+
+  // The radix sort is not in-place, so sort into new tensors of the
+  // transposed size
+  THLongStorage* trSize = THCTensor_(newSizeOf)(state, trContigInput);
+  THCTensor* trContigKey = THCTensor_(newWithSize)(state, trSize, NULL);
+  THCudaLongTensor* trContigIndicesIn =
+    THCudaLongTensor_newWithSize(state, trSize, NULL);
+  THCudaLongTensor* trContigIndices =
+    THCudaLongTensor_newWithSize(state, trSize, NULL);
+  THLongStorage_free(trSize);
+
+  THCudaLongTensor_fillSliceWithIndex(state, trContigIndicesIn, nDims - 1);
+
+  SliceOffsetIterator sliceBegin(
+    cub::CountingInputIterator<int>(0), SliceToOffset(sliceSize));
+  SliceOffsetIterator sliceEnd = sliceBegin + 1;
+  cudaStream_t stream = THCState_getCurrentStream(state);
+
+#define SEGMENTED_SORT(FUNC, TEMP, TEMP_BYTES)                          \
+  THCudaCheck(cub::DeviceSegmentedRadixSort::FUNC(                      \
+    TEMP, TEMP_BYTES,                                                   \
+    THCTensor_(data)(state, trContigInput),                             \
+    THCTensor_(data)(state, trContigKey),                               \
+    THCudaLongTensor_data(state, trContigIndicesIn),                    \
+    THCudaLongTensor_data(state, trContigIndices),                      \
+    totalElements, numSlices, sliceBegin, sliceEnd,                     \
+    0, sizeof(real) * 8, stream))
+
+  size_t tempBytes = 0;
+  if (dir) {
+    SEGMENTED_SORT(SortPairsDescending, NULL, tempBytes);
+  } else {
+    SEGMENTED_SORT(SortPairs, NULL, tempBytes);
+  }
+  void* temp = THCudaMalloc(state, tempBytes);
+  if (dir) {
+    SEGMENTED_SORT(SortPairsDescending, temp, tempBytes);
+  } else {
+    SEGMENTED_SORT(SortPairs, temp, tempBytes);
+  }
+  THCudaFree(state, temp);
+
+#undef SEGMENTED_SORT
+
+  THCTensor_(free)(state, trContigInput);
+  THCudaLongTensor_free(state, trContigIndicesIn);
+
+  // Reverse the transposition as needed
+  if (dim != nDims - 1) {
+    THCTensor_(transpose)(state, trContigKey, NULL, dim, nDims - 1);
+    THCudaLongTensor_transpose(state, trContigIndices, NULL, dim, nDims - 1);
+  }
+
+  // Then copy back to the expected output
+  THCTensor_(freeCopyTo)(state, trContigKey, sorted);
+  THCudaLongTensor_freeCopyTo(state, trContigIndices, indices);
+}
+#endif
+
 THC_API void THCTensor_(sort)(THCState* state,
                                THCTensor *sorted,
                                THCudaLongTensor *indices,
@@ -325,7 +447,16 @@ THC_API void THCTensor_(sort)(THCState* state,
     // layout
     THCTensor_(sortKeyValueInplace)(state, sorted, indices, dim, order);
   } else {
-    // Otherwise, fall back upon Thrust, which handles all other cases
+#if !defined(THC_REAL_IS_HALF)
+    // Otherwise, sort all slices at once with a segmented radix sort
+    if (THCTensor_(nElement)(state, input) <= INT_MAX) {
+      THCTensor_(sortViaSegmentedRadixSort)(
+        state, sorted, indices, input, dim, (bool) order);
+      THCudaCheck(cudaGetLastError());
+      return;
+    }
+#endif
+    // Fall back upon Thrust, which handles all other cases
     // (potentially slowly, with extra copies/memory allocations)
     THCTensor_(sortViaThrust)(state, sorted, indices, input, dim, (bool) order);
   }
@@ -128,8 +128,9 @@ THC_API void THCTensor_(topk)(THCState* state,
   // selection routine does not ensure sorting
   if (sorted) {
     // FIXME: the k/v inplace sort along slice only works for size <=
-    // 2048 at the moment
-    if (sliceSize <= 2048) {
+    // 2048 at the moment. The slices sorted here are the k selected
+    // elements, not the input slices.
+    if (k <= 2048) {
       // This avoids any memory allocations and performs all sorting
       // work inplace along the slice
       THCTensor_(sortKeyValueInplace)(state, topK, indices, dim, dir);
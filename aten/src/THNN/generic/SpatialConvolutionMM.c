@@ -134,6 +134,79 @@ static void THNN_(SpatialConvolutionMM_updateOutput_frame)(
   THTensor_(free)(output2d);
 }
 
+/* Frames are spread over the threads when there are enough of them to keep all
+   the threads busy. Smaller batches leave the threads to unfolded_copy and to
+   the BLAS instead, which only get a single thread inside the loop of frames. */
+static inline int THNN_(SpatialConvolutionMM_parallelOverFrames)(int64_t T)
+{
+  return T >= THGetNumThreads();
+}
+
+/* The columns of all the frames are laid side by side in a 2D finput of
+   (kW*kH*nInputPlane) x (T*outputHeight*outputWidth), so that the whole batch
+   is a single GEMM rather than T small ones, which matters for the small
+   outputs of the deep layers. */
+static void THNN_(SpatialConvolutionMM_updateOutput_batch)(
+          THTensor *input,
+          THTensor *output,
+          THTensor *weight,
+          THTensor *bias,
+          THTensor *finput,
+          int kW,
+          int kH,
+          int dW,
+          int dH,
+          int padW,
+          int padH,
+          int64_t nInputPlane,
+          int64_t inputWidth,
+          int64_t inputHeight,
+          int64_t nOutputPlane,
+          int64_t outputWidth,
+          int64_t outputHeight)
+{
+  int64_t T = input->size[0];
+  int64_t frameSize = outputHeight*outputWidth;
+  int64_t i, t;
+  THTensor *output2d = THTensor_(newWithSize2d)(nOutputPlane, T*frameSize);
+  THTensor *outputColumns, *output3d;
+
+  for(t = 0; t < T; t++)
+  {
+    THNN_(unfolded_copy_strided)(THTensor_(data)(finput) + t*frameSize, T*frameSize,
+                                 THTensor_(data)(input) + t*input->stride[0],
+                                 kW, kH, dW, dH, padW, padH,
+                                 nInputPlane, inputWidth, inputHeight,
+                                 outputWidth, outputHeight);
+  }
+
+  if (bias) {
+    for(i = 0; i < nOutputPlane; i++)
+        THVector_(fill)
+	  (THTensor_(data)(output2d) + i*T*frameSize,
+	   THTensor_(get1d)(bias, i), T*frameSize);
+  } else {
+    THTensor_(zero)(output2d);
+  }
+
+  THTensor_(addmm)(output2d, 1, output2d, 1, weight, finput);
+
+  /* output2d holds nOutputPlane x T x frameSize, the output T x nOutputPlane x frameSize */
+  outputColumns = THTensor_(newWithStorage3d)(output2d->storage, output2d->storageOffset,
+                                              T, frameSize,
+                                              nOutputPlane, T*frameSize,
+                                              frameSize, 1);
+  output3d = THTensor_(newWithStorage3d)(output->storage, output->storageOffset,
+                                         T, -1,
+                                         nOutputPlane, -1,
+                                         frameSize, -1);
+  THTensor_(copy)(output3d, outputColumns);
+
+  THTensor_(free)(output3d);
+  THTensor_(free)(outputColumns);
+  THTensor_(free)(output2d);
+}
+
 void THNN_(SpatialConvolutionMM_updateOutput)(
           THNNState *state,
           THTensor *input,
@@ -184,6 +257,19 @@ void THNN_(SpatialConvolutionMM_updateOutput)(
        nInputPlane, inputWidth, inputHeight,
        nOutputPlane, outputWidth, outputHeight);
   }
+  else if (!THNN_(SpatialConvolutionMM_parallelOverFrames)(input->size[0]))
+  {
+    int64_t T = input->size[0];
+
+    THTensor_(resize2d)(finput, kW*kH*nInputPlane, T*outputHeight*outputWidth);
+    THTensor_(resize4d)(output, T, nOutputPlane, outputHeight, outputWidth);
+
+    THNN_(SpatialConvolutionMM_updateOutput_batch)
+      (input, output, weight, bias, finput,
+       kW, kH, dW, dH, padW, padH,
+       nInputPlane, inputWidth, inputHeight,
+       nOutputPlane, outputWidth, outputHeight);
+  }
   else
   {
     int64_t T = input->size[0];
@@ -266,7 +352,13 @@ void THNN_(SpatialConvolutionMM_updateGradInput)(
   gradOutput = THTensor_(newContiguous)(gradOutput);
 
   THTensor_(resizeAs)(gradInput, input);
-  THTensor_(resizeAs)(fgradInput, finput);
+  // the frames keep their own columns here, whichever layout the forward gave finput
+  if(input->dim() == 3)
+    THTensor_(resize2d)(fgradInput, weight->size[1],
+                        gradOutput->size[1]*gradOutput->size[2]);
+  else
+    THTensor_(resize3d)(fgradInput, input->size[0], weight->size[1],
+                        gradOutput->size[2]*gradOutput->size[3]);
 
   // depending on the BLAS library, fgradInput (result tensor) might
   // be left uninitialized on zero alpha, which might lead to weird behavior
@@ -285,8 +377,9 @@ void THNN_(SpatialConvolutionMM_updateGradInput)(
   {
     int64_t T = input->size[0];
     int64_t t;
+    int parallelOverFrames = THNN_(SpatialConvolutionMM_parallelOverFrames)(T);
 
-#pragma omp parallel for private(t)
+#pragma omp parallel for if(parallelOverFrames) private(t)
     for(t = 0; t < T; t++)
     {
       THTensor *gradInput_t = THTensor_(newSelect)(gradInput, 0, t);
@@ -380,6 +473,28 @@ void THNN_(SpatialConvolutionMM_accGradParameters)(
     THNN_(SpatialConvolutionMM_accGradParameters_frame)(gradOutput, gradWeight,
 							gradBias, finput, scale);
   }
+  else if (gradWeight && finput->dim() == 2)
+  {
+    /* finput has the columns of the whole batch side by side (see
+       updateOutput_batch): gradOutput is laid out the same way to get
+       gradWeight from a single GEMM */
+    int64_t T = gradOutput->size[0];
+    int64_t nOutputPlane = gradOutput->size[1];
+    int64_t frameSize = gradOutput->size[2]*gradOutput->size[3];
+    THTensor *gradColumns = THTensor_(newWithSize3d)(nOutputPlane, T, frameSize);
+    THTensor *gradOutput3d = THTensor_(newWithStorage3d)
+      (gradOutput->storage, gradOutput->storageOffset,
+       nOutputPlane, frameSize,
+       T, nOutputPlane*frameSize,
+       frameSize, 1);
+    THTensor_(copy)(gradColumns, gradOutput3d);
+
+    THNN_(SpatialConvolutionMM_accGradParameters_frame)(gradColumns, gradWeight,
+							gradBias, finput, scale);
+
+    THTensor_(free)(gradOutput3d);
+    THTensor_(free)(gradColumns);
+  }
   else
   {
     int64_t T = input->size[0];
@@ -83,9 +83,12 @@ void THNN_(unfolded_acc)(
   }
 }
 
-void THNN_(unfolded_copy)(
-          THTensor *finput,
-          THTensor *input,
+/* same as unfolded_copy, but the rows of finput_data are ldFinput apart, so that
+   the columns of several frames can be laid side by side in one matrix */
+static void THNN_(unfolded_copy_strided)(
+          real *finput_data,
+          int64_t ldFinput,
+          real *input_data,
           int kW,
           int kH,
           int dW,
@@ -105,8 +108,6 @@ void THNN_(unfolded_copy)(
   // outputWidth*dW does not overflow a int64_t
 
   int64_t k;
-  real *input_data = THTensor_(data)(input);
-  real *finput_data = THTensor_(data)(finput);
 
 #pragma omp parallel for private(k)
   for(k = 0; k < (int64_t)nInputPlane*kH*kW; k++) {
@@ -116,7 +117,7 @@ void THNN_(unfolded_copy)(
     int64_t kw = rest % kW;
     int x, y;
     int64_t ix, iy;
-    real *dst = finput_data + nip*((size_t)kH*kW*outputHeight*outputWidth) + kh*((size_t)kW*outputHeight*outputWidth) + kw*((size_t)outputHeight*outputWidth);
+    real *dst = finput_data + (size_t)k*ldFinput;
     real *src = input_data + nip*((size_t)inputHeight*inputWidth);
     if (padW > 0 || padH > 0) {
       int64_t lpad,rpad;
@@ -163,4 +164,25 @@ void THNN_(unfolded_copy)(
   }
 }
 
+void THNN_(unfolded_copy)(
+          THTensor *finput,
+          THTensor *input,
+          int kW,
+          int kH,
+          int dW,
+          int dH,
+          int padW,
+          int padH,
+          int nInputPlane,
+          int inputWidth,
+          int inputHeight,
+          int outputWidth,
+          int outputHeight)
+{
+  THNN_(unfolded_copy_strided)(THTensor_(data)(finput), (int64_t)outputHeight*outputWidth,
+                               THTensor_(data)(input), kW, kH, dW, dH, padW, padH,
+                               nInputPlane, inputWidth, inputHeight,
+                               outputWidth, outputHeight);
+}
+
 #endif
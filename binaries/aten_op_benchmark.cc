@@ -0,0 +1,571 @@
+/**
+ * Copyright (c) 2018-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Microbenchmarks for the most used ATen operators.
+//
+// Every operator is swept over a family of shapes, the scalar types it is
+// commonly run in, contiguous and strided (transposed) inputs, each device
+// and, on the CPU, one thread and all threads. Cases are named
+//
+//   <op>/<device>/<dtype>/<shape>/<contig|strided>/threads:<n>
+//
+// so that --benchmark_filter can select e.g. all half precision cases with
+// 'Half'. Besides the time per call every case reports the bytes it touches
+// (inputs plus output) as GB/s and, where it is meaningful, GFLOP/s.
+//
+// Cases an operator does not support (e.g. Half on the CPU for some ops)
+// are reported as errors instead of aborting the run. For machine readable
+// output use the standard Google benchmark flags:
+//
+//   aten_op_benchmark --benchmark_format=json --benchmark_out=ops.json
+//
+// Two such files can be compared with third_party/benchmark/tools/compare.py.
+
+#include <algorithm>
+#include <functional>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "ATen/ATen.h"
+#include "benchmark/benchmark.h"
+
+#ifdef ATEN_BENCHMARK_CUDA
+#include <cuda_runtime.h>
+#endif
+
+using at::Tensor;
+
+namespace {
+
+struct Case {
+  at::Backend backend;
+  at::ScalarType dtype;
+  // Meaning depends on the shape family of the op, see Family below.
+  int64_t size;
+  bool contiguous;
+  int threads;
+
+  at::Type& type() const {
+    return at::getType(backend, dtype);
+  }
+  at::Type& longType() const {
+    return at::getType(backend, at::kLong);
+  }
+};
+
+enum class Family {
+  // {size, 1024} matrices.
+  kPointwise,
+  // {size, size} matrices.
+  kMatrix,
+  // {size, 64, 56, 56} images.
+  kImage,
+  // size lookups into a {100000, 64} table.
+  kLookup,
+};
+
+using Inputs = std::vector<Tensor>;
+
+struct OpSpec {
+  std::string name;
+  Family family;
+  std::function<Inputs(const Case&)> make;
+  std::function<Tensor(const Inputs&)> run;
+  // Floating point operations per call, or nullptr if not meaningful.
+  std::function<double(const Inputs&)> flops;
+  // Bytes written by in-place ops are not counted a second time.
+  bool inplace;
+};
+
+constexpr int64_t kCols = 1024;
+constexpr int64_t kTableRows = 100000;
+constexpr int64_t kEmbeddingDim = 64;
+
+// Random {rows, cols} tensor of the case's type. Strided cases get the
+// transpose of a {cols, rows} tensor, so the innermost stride is not 1.
+Tensor randMatrix(const Case& c, int64_t rows, int64_t cols) {
+  if (c.contiguous) {
+    return at::randn({rows, cols}).toType(c.type());
+  }
+  return at::randn({cols, rows}).toType(c.type()).t();
+}
+
+Tensor randTensor(const Case& c, at::IntList sizes) {
+  if (c.contiguous || sizes.size() < 3) {
+    return at::randn(sizes).toType(c.type());
+  }
+  // Same shape, with dimension 1 (e.g. channels) innermost in memory.
+  std::vector<int64_t> storageSizes(sizes.begin(), sizes.end());
+  std::rotate(
+      storageSizes.begin() + 1, storageSizes.begin() + 2, storageSizes.end());
+  std::vector<int64_t> perm = {0, static_cast<int64_t>(sizes.size()) - 1};
+  for (size_t i = 1; i + 1 < sizes.size(); ++i) {
+    perm.push_back(i);
+  }
+  return at::randn(storageSizes).toType(c.type()).permute(perm);
+}
+
+Tensor randIndex(const Case& c, int64_t n, int64_t high) {
+  return at::empty({n}, at::dtype(at::kLong)).random_(0, high).toType(
+      c.longType());
+}
+
+double elements(const Tensor& t) {
+  return static_cast<double>(t.numel());
+}
+
+double nbytes(const Tensor& t) {
+  return t.defined() ? elements(t) * t.type().elementSizeInBytes() : 0;
+}
+
+std::vector<OpSpec>& ops() {
+  static std::vector<OpSpec> ops;
+  return ops;
+}
+
+void addOp(
+    const std::string& name,
+    Family family,
+    std::function<Inputs(const Case&)> make,
+    std::function<Tensor(const Inputs&)> run,
+    std::function<double(const Inputs&)> flops = nullptr,
+    bool inplace = false) {
+  ops().push_back({name, family, make, run, flops, inplace});
+}
+
+Inputs oneMatrix(const Case& c) {
+  return {randMatrix(c, c.size, kCols)};
+}
+
+Inputs twoMatrices(const Case& c) {
+  return {randMatrix(c, c.size, kCols), randMatrix(c, c.size, kCols)};
+}
+
+double perElement(const Inputs& in) {
+  return elements(in[0]);
+}
+
+void addUnary(const std::string& name, Tensor (*fn)(const Tensor&)) {
+  addOp(
+      name, Family::kPointwise, oneMatrix,
+      [fn](const Inputs& in) { return fn(in[0]); }, perElement);
+}
+
+void addBinary(
+    const std::string& name,
+    Tensor (*fn)(const Tensor&, const Tensor&)) {
+  addOp(
+      name, Family::kPointwise, twoMatrices,
+      [fn](const Inputs& in) { return fn(in[0], in[1]); }, perElement);
+}
+
+void registerOps() {
+  // Unary pointwise.
+  addUnary("abs", at::abs);
+  addUnary("neg", at::neg);
+  addUnary("exp", at::exp);
+  addUnary("log", at::log);
+  addUnary("log1p", at::log1p);
+  addUnary("expm1", at::expm1);
+  addUnary("sqrt", at::sqrt);
+  addUnary("rsqrt", at::rsqrt);
+  addUnary("reciprocal", at::reciprocal);
+  addUnary("sigmoid", at::sigmoid);
+  addUnary("tanh", at::tanh);
+  addUnary("sin", at::sin);
+  addUnary("cos", at::cos);
+  addUnary("floor", at::floor);
+  addUnary("round", at::round);
+  addUnary("erf", at::erf);
+  addUnary("relu", at::relu);
+  addOp(
+      "clamp", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::clamp(in[0], -0.5, 0.5); },
+      perElement);
+  addOp(
+      "threshold", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::threshold(in[0], 0, 0); },
+      perElement);
+  addOp(
+      "pow_scalar", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::pow(in[0], 2); }, perElement);
+
+  // Binary pointwise.
+  addBinary("add", [](const Tensor& a, const Tensor& b) { return a + b; });
+  addBinary("sub", [](const Tensor& a, const Tensor& b) { return a - b; });
+  addBinary("mul", at::mul);
+  addBinary("div", at::div);
+  addBinary("max_elementwise", at::max);
+  addBinary("atan2", at::atan2);
+  addBinary("lt", at::lt);
+  addOp(
+      "add_scalar", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::add(in[0], 1); }, perElement);
+  addOp(
+      "add_broadcast", Family::kPointwise,
+      [](const Case& c) {
+        return Inputs{randMatrix(c, c.size, kCols), randMatrix(c, 1, kCols)};
+      },
+      [](const Inputs& in) { return at::add(in[0], in[1]); }, perElement);
+  addOp(
+      "where", Family::kPointwise,
+      [](const Case& c) {
+        Tensor a = randMatrix(c, c.size, kCols);
+        Tensor b = randMatrix(c, c.size, kCols);
+        return Inputs{at::lt(a, b), a, b};
+      },
+      [](const Inputs& in) { return at::where(in[0], in[1], in[2]); });
+  addOp(
+      "masked_fill", Family::kPointwise,
+      [](const Case& c) {
+        Tensor a = randMatrix(c, c.size, kCols);
+        return Inputs{a, at::lt(a, 0)};
+      },
+      [](const Inputs& in) {
+        Tensor dst = in[0];
+        return dst.masked_fill_(in[1], 0);
+      },
+      nullptr, true);
+
+  // Copies.
+  addOp(
+      "contiguous", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return in[0].contiguous(); });
+  addOp(
+      "clone", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return in[0].clone(); });
+  addOp(
+      "copy_", Family::kPointwise, twoMatrices,
+      [](const Inputs& in) {
+        Tensor dst = in[0];
+        return dst.copy_(in[1]);
+      },
+      nullptr, true);
+  addOp(
+      "fill_", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) {
+        Tensor dst = in[0];
+        return dst.fill_(1);
+      },
+      nullptr, true);
+  addOp(
+      "zero_", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) {
+        Tensor dst = in[0];
+        return dst.zero_();
+      },
+      nullptr, true);
+
+  // Reductions.
+  addOp(
+      "sum", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::sum(in[0]); }, perElement);
+  addOp(
+      "sum_dim0", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::sum(in[0], {0}); }, perElement);
+  addOp(
+      "sum_dim1", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::sum(in[0], {1}); }, perElement);
+  addOp(
+      "prod", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::prod(in[0]); }, perElement);
+  addOp(
+      "mean", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::mean(in[0]); }, perElement);
+  addOp(
+      "max", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::max(in[0]); }, perElement);
+  addOp(
+      "max_dim1", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return std::get<0>(at::max(in[0], 1)); },
+      perElement);
+  addOp(
+      "argmax_dim1", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::argmax(in[0], 1); }, perElement);
+  addOp(
+      "norm", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::norm(in[0]); },
+      [](const Inputs& in) { return 2 * elements(in[0]); });
+  addOp(
+      "std", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::std(in[0]); },
+      [](const Inputs& in) { return 3 * elements(in[0]); });
+  addOp(
+      "var_dim1", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::var(in[0], 1, true); },
+      [](const Inputs& in) { return 3 * elements(in[0]); });
+  addOp(
+      "cumsum_dim1", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::cumsum(in[0], 1); }, perElement);
+  addOp(
+      "logsumexp_dim1", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::logsumexp(in[0], 1); },
+      [](const Inputs& in) { return 3 * elements(in[0]); });
+  addOp(
+      "softmax_dim1", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::softmax(in[0], 1); },
+      [](const Inputs& in) { return 4 * elements(in[0]); });
+  addOp(
+      "log_softmax_dim1", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::log_softmax(in[0], 1); },
+      [](const Inputs& in) { return 4 * elements(in[0]); });
+  addOp(
+      "topk10_dim1", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return std::get<0>(at::topk(in[0], 10, 1)); });
+  addOp(
+      "sort_dim1", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return std::get<0>(at::sort(in[0], 1)); });
+  addOp(
+      "cat_dim1", Family::kPointwise, twoMatrices,
+      [](const Inputs& in) { return at::cat({in[0], in[1]}, 1); });
+
+  // Linear algebra.
+  auto squareMatrices = [](const Case& c) {
+    return Inputs{randMatrix(c, c.size, c.size), randMatrix(c, c.size, c.size)};
+  };
+  auto mmFlops = [](const Inputs& in) {
+    return 2 * elements(in[0]) * in[1].size(1);
+  };
+  addOp(
+      "mm", Family::kMatrix, squareMatrices,
+      [](const Inputs& in) { return at::mm(in[0], in[1]); }, mmFlops);
+  addOp(
+      "matmul", Family::kMatrix, squareMatrices,
+      [](const Inputs& in) { return at::matmul(in[0], in[1]); }, mmFlops);
+  addOp(
+      "addmm", Family::kMatrix,
+      [](const Case& c) {
+        return Inputs{randMatrix(c, c.size, c.size),
+                      randMatrix(c, c.size, c.size),
+                      randMatrix(c, c.size, c.size)};
+      },
+      [](const Inputs& in) { return at::addmm(in[0], in[1], in[2]); },
+      [](const Inputs& in) { return 2 * elements(in[1]) * in[2].size(1); });
+  addOp(
+      "bmm", Family::kMatrix,
+      [](const Case& c) {
+        // A batch of 16 blocks with as many elements as one size x size matrix.
+        const int64_t n = std::max<int64_t>(c.size / 4, 1);
+        return Inputs{randTensor(c, {16, n, n}), randTensor(c, {16, n, n})};
+      },
+      [](const Inputs& in) { return at::bmm(in[0], in[1]); },
+      [](const Inputs& in) { return 2 * elements(in[0]) * in[1].size(2); });
+  addOp(
+      "mv", Family::kMatrix,
+      [](const Case& c) {
+        return Inputs{randMatrix(c, c.size, c.size),
+                      at::randn({c.size}).toType(c.type())};
+      },
+      [](const Inputs& in) { return at::mv(in[0], in[1]); },
+      [](const Inputs& in) { return 2 * elements(in[0]); });
+  addOp(
+      "dot", Family::kMatrix,
+      [](const Case& c) {
+        return Inputs{at::randn({c.size * c.size}).toType(c.type()),
+                      at::randn({c.size * c.size}).toType(c.type())};
+      },
+      [](const Inputs& in) { return at::dot(in[0], in[1]); },
+      [](const Inputs& in) { return 2 * elements(in[0]); });
+
+  // Neural network layers.
+  auto image = [](const Case& c) {
+    return Inputs{randTensor(c, {c.size, 64, 56, 56})};
+  };
+  addOp(
+      "conv2d_3x3", Family::kImage,
+      [](const Case& c) {
+        return Inputs{randTensor(c, {c.size, 64, 56, 56}),
+                      at::randn({64, 64, 3, 3}).toType(c.type())};
+      },
+      [](const Inputs& in) { return at::conv2d(in[0], in[1], {}, 1, 1); },
+      [](const Inputs& in) {
+        return 2 * elements(in[0]) * in[1].size(0) * 9;
+      });
+  addOp(
+      "max_pool2d_3x3s2", Family::kImage, image,
+      [](const Inputs& in) { return at::max_pool2d(in[0], 3, 2, 1); },
+      [](const Inputs& in) { return elements(in[0]) * 9 / 4; });
+  addOp(
+      "avg_pool2d_3x3s2", Family::kImage, image,
+      [](const Inputs& in) { return at::avg_pool2d(in[0], 3, 2, 1); },
+      [](const Inputs& in) { return elements(in[0]) * 9 / 4; });
+  addOp(
+      "batch_norm_eval", Family::kImage,
+      [](const Case& c) {
+        return Inputs{randTensor(c, {c.size, 64, 56, 56}),
+                      at::ones({64}).toType(c.type()),
+                      at::zeros({64}).toType(c.type()),
+                      at::zeros({64}).toType(c.type()),
+                      at::ones({64}).toType(c.type())};
+      },
+      [](const Inputs& in) {
+        return at::batch_norm(
+            in[0], in[1], in[2], in[3], in[4], false, 0.1, 1e-5, true);
+      },
+      [](const Inputs& in) { return 2 * elements(in[0]); });
+  addOp(
+      "layer_norm", Family::kPointwise, oneMatrix,
+      [](const Inputs& in) { return at::layer_norm(in[0], {kCols}); },
+      [](const Inputs& in) { return 5 * elements(in[0]); });
+  addOp(
+      "relu_image", Family::kImage, image,
+      [](const Inputs& in) { return at::relu(in[0]); }, perElement);
+
+  // Indexing.
+  auto table = [](const Case& c) {
+    return Inputs{randMatrix(c, kTableRows, kEmbeddingDim),
+                  randIndex(c, c.size, kTableRows)};
+  };
+  addOp(
+      "embedding", Family::kLookup, table,
+      [](const Inputs& in) { return at::embedding(in[0], in[1]); });
+  addOp(
+      "index_select", Family::kLookup, table,
+      [](const Inputs& in) { return at::index_select(in[0], 0, in[1]); });
+  addOp(
+      "embedding_bag_sum", Family::kLookup,
+      [](const Case& c) {
+        // Bags of 16 lookups each.
+        return Inputs{randMatrix(c, kTableRows, kEmbeddingDim),
+                      randIndex(c, c.size, kTableRows),
+                      at::arange(0, c.size, 16, at::dtype(at::kLong))
+                          .toType(c.longType())};
+      },
+      [](const Inputs& in) {
+        return std::get<0>(at::embedding_bag(in[0], in[1], in[2]));
+      },
+      [](const Inputs& in) { return elements(in[1]) * kEmbeddingDim; });
+  addOp(
+      "gather_dim1", Family::kLookup,
+      [](const Case& c) {
+        const int64_t rows = std::max<int64_t>(c.size / kEmbeddingDim, 1);
+        Tensor index = randIndex(c, rows * kEmbeddingDim, kCols);
+        return Inputs{randMatrix(c, rows, kCols),
+                      index.view({rows, kEmbeddingDim})};
+      },
+      [](const Inputs& in) { return at::gather(in[0], 1, in[1]); });
+}
+
+std::vector<int64_t> familySizes(Family family) {
+  switch (family) {
+    case Family::kPointwise:
+      return {1, 64, 1024, 8192};
+    case Family::kMatrix:
+      return {64, 256, 1024};
+    case Family::kImage:
+      return {1, 16};
+    case Family::kLookup:
+      return {1024, 65536};
+  }
+  return {};
+}
+
+void sync(const Case& c) {
+#ifdef ATEN_BENCHMARK_CUDA
+  if (c.backend == at::Backend::CUDA) {
+    cudaDeviceSynchronize();
+  }
+#endif
+}
+
+void runCase(benchmark::State& state, const OpSpec& op, const Case& c) {
+  if (c.backend == at::Backend::CPU) {
+    at::set_num_threads(c.threads);
+  }
+  Inputs inputs;
+  Tensor output;
+  try {
+    inputs = op.make(c);
+    // Warm up, and find out whether the op supports this case at all.
+    output = op.run(inputs);
+    sync(c);
+  } catch (const std::exception& e) {
+    state.SkipWithError(e.what());
+    return;
+  }
+
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(op.run(inputs));
+    sync(c);
+  }
+
+  double bytes = op.inplace ? 0 : nbytes(output);
+  for (const auto& input : inputs) {
+    bytes += nbytes(input);
+  }
+  const double iterations = static_cast<double>(state.iterations());
+  state.counters["GB/s"] = benchmark::Counter(
+      bytes * iterations / 1e9, benchmark::Counter::kIsRate);
+  if (op.flops) {
+    state.counters["GFLOP/s"] = benchmark::Counter(
+        op.flops(inputs) * iterations / 1e9, benchmark::Counter::kIsRate);
+  }
+}
+
+std::string caseName(const OpSpec& op, const Case& c) {
+  return op.name + "/" + at::toString(c.backend) + "/" +
+      at::toString(c.dtype) + "/" + std::to_string(c.size) + "/" +
+      (c.contiguous ? "contig" : "strided") + "/threads:" +
+      std::to_string(c.threads);
+}
+
+void registerCases() {
+  std::vector<at::Backend> backends = {at::Backend::CPU};
+#ifdef ATEN_BENCHMARK_CUDA
+  if (at::hasCUDA()) {
+    backends.push_back(at::Backend::CUDA);
+  }
+#endif
+  const int maxThreads = std::max(
+      static_cast<int>(std::thread::hardware_concurrency()), 1);
+  std::vector<int> cpuThreads = {1};
+  if (maxThreads > 1) {
+    cpuThreads.push_back(maxThreads);
+  }
+
+  for (const auto& op : ops()) {
+    for (auto backend : backends) {
+      const std::vector<int> threads = backend == at::Backend::CPU
+          ? cpuThreads
+          : std::vector<int>{1};
+      for (auto dtype : {at::kFloat, at::kHalf, at::kDouble}) {
+        for (auto size : familySizes(op.family)) {
+          for (bool contiguous : {true, false}) {
+            for (int n : threads) {
+              const Case c{backend, dtype, size, contiguous, n};
+              benchmark::RegisterBenchmark(
+                  caseName(op, c).c_str(),
+                  [&op, c](benchmark::State& state) { runCase(state, op, c); })
+                  ->UseRealTime();
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  registerOps();
+  registerCases();
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
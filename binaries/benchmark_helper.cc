@@ -14,7 +14,12 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include <string>
+#include <thread>
 
 #include "binaries/benchmark_helper.h"
 #include "caffe2/core/blob_serialization.h"
@@ -25,11 +30,21 @@
 #include "caffe2/core/logging.h"
 #include "caffe2/core/net.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/observers/time_observer.h"
 #include "caffe2/utils/bench_utils.h"
 #include "caffe2/utils/string_utils.h"
 #include "observers/net_observer_reporter_print.h"
 #include "observers/observer_config.h"
 #include "observers/perf_observer.h"
+#if defined(CAFFE2_BENCHMARK_ACL)
+#include "caffe2/mobile/contrib/arm-compute/core/rewrite_net.h"
+#elif defined(CAFFE2_BENCHMARK_OPENGL)
+#include "caffe2/mobile/contrib/opengl/core/rewrite_net.h"
+#endif
+#ifdef CAFFE2_BENCHMARK_NNAPI
+#include "caffe2/mobile/contrib/nnapi/nnapi.h"
+#endif
 
 using std::map;
 using std::shared_ptr;
@@ -37,6 +52,27 @@ using std::string;
 using std::unique_ptr;
 using std::vector;
 
+void Cooldown::wait() const {
+  if (milliseconds > 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+  }
+  if (thermal_zone.empty()) {
+    return;
+  }
+  while (true) {
+    std::ifstream file(thermal_zone);
+    int millidegrees = 0;
+    if (!(file >> millidegrees)) {
+      LOG(WARNING) << "Cannot read the temperature from " << thermal_zone;
+      return;
+    }
+    if (millidegrees < max_temperature * 1000) {
+      return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+}
+
 void observerConfig() {
   caffe2::ClearGlobalNetObservers();
   caffe2::AddGlobalNetObserverCreator([](caffe2::NetBase* subject) {
@@ -89,6 +125,40 @@ void setOperatorEngine(caffe2::NetDef* net_def, const string& backend) {
   }
 }
 
+void setBackend(
+    caffe2::NetDef* init_net_def,
+    caffe2::NetDef* net_def,
+    const string& backend) {
+  if (backend == "opengl") {
+#ifdef CAFFE2_BENCHMARK_OPENGL
+    caffe2::NetDef gl_net_def;
+    CAFFE_ENFORCE(
+        caffe2::tryConvertToOpenGL(*init_net_def, *net_def, &gl_net_def),
+        "The net cannot run with OpenGL");
+    *net_def = gl_net_def;
+#else
+    CAFFE_THROW("OpenGL is not supported in this build");
+#endif
+  } else if (backend == "acl") {
+#ifdef CAFFE2_BENCHMARK_ACL
+    caffe2::NetDef gl_net_def;
+    CAFFE_ENFORCE(
+        caffe2::tryConvertToOpenGL(*net_def, &gl_net_def, true, {}),
+        "The net cannot run with the ARM Compute Library");
+    *net_def = gl_net_def;
+#else
+    CAFFE_THROW("The ARM Compute Library is not supported in this build");
+#endif
+  } else if (backend == "nnapi") {
+#ifndef CAFFE2_BENCHMARK_NNAPI
+    CAFFE_THROW("NNAPI is not supported in this build");
+#endif
+  } else {
+    setOperatorEngine(init_net_def, backend);
+    setOperatorEngine(net_def, backend);
+  }
+}
+
 void loadInput(
     shared_ptr<caffe2::Workspace> workspace,
     const bool run_on_gpu,
@@ -215,7 +285,9 @@ void runNetwork(
     const bool wipe_cache,
     const bool run_individual,
     const int warmup,
-    const int iter) {
+    const int iter,
+    const Cooldown& cooldown,
+    BenchmarkResult* result) {
   if (!net_def.has_name()) {
     net_def.set_name("benchmark");
   }
@@ -240,10 +312,17 @@ void runNetwork(
       "Number of main runs should be non negative, provided ",
       iter,
       ".");
+  // Only the main runs are timed, and the runs of the individual
+  // operators, if any, are included in the time of the operators.
+  auto* time_observer = net->AttachObserver(
+      caffe2::make_unique<caffe2::TimeObserver>(net));
+  caffe2::Timer timer;
   for (int i = 0; i < iter; ++i) {
     caffe2::ObserverConfig::initSampleRate(1, 1, 1, 0, warmup);
     fillInputBlob(workspace, tensor_protos_map, i);
+    timer.Start();
     CAFFE_ENFORCE(net->Run(), "Main run ", i, " has failed.");
+    result->latencies.push_back(timer.MilliSeconds());
     if (wipe_cache) {
       caffe2::wipe_cache();
     }
@@ -254,7 +333,134 @@ void runNetwork(
         caffe2::wipe_cache();
       }
     }
+    cooldown.wait();
+  }
+
+  if (iter > 0) {
+    const auto times = static_cast<const caffe2::TimeObserver*>(time_observer)
+                           ->average_time_operators();
+    const auto& operators = net->GetOperators();
+    for (int i = 0; i < operators.size(); ++i) {
+      const auto& op_def = operators[i]->debug_def();
+      string name = op_def.name();
+      if (name.empty() && op_def.output_size() > 0) {
+        name = op_def.output(0);
+      }
+      result->operators.push_back({name, op_def.type(), times[i]});
+    }
+  }
+  net->DetachObserver(time_observer);
+}
+
+void runNNApi(
+    shared_ptr<caffe2::Workspace> workspace,
+    const caffe2::NetDef& init_net_def,
+    const caffe2::NetDef& net_def,
+    const vector<string>& input_names,
+    map<string, caffe2::TensorProtos>& tensor_protos_map,
+    const int warmup,
+    const int iter,
+    const Cooldown& cooldown,
+    BenchmarkResult* result) {
+#ifdef CAFFE2_BENCHMARK_NNAPI
+  // NNAPI compiles the whole net into one model, so there is no breakdown
+  // of the time of the operators.
+  caffe2::NNApi model(init_net_def, net_def, workspace.get());
+  caffe2::NNApi::TensorVector inputs, outputs;
+  for (const auto& name : input_names) {
+    inputs.push_back(workspace->GetBlob(name)->GetMutable<caffe2::TensorCPU>());
+  }
+  LOG(INFO) << "Running warmup runs.";
+  for (int i = 0; i < warmup; ++i) {
+    fillInputBlob(workspace, tensor_protos_map, i);
+    CAFFE_ENFORCE(model.run(inputs, &outputs), "Warmup run ", i, " failed.");
+  }
+  LOG(INFO) << "Main runs.";
+  caffe2::Timer timer;
+  for (int i = 0; i < iter; ++i) {
+    fillInputBlob(workspace, tensor_protos_map, i);
+    timer.Start();
+    CAFFE_ENFORCE(model.run(inputs, &outputs), "Main run ", i, " failed.");
+    result->latencies.push_back(timer.MilliSeconds());
+    cooldown.wait();
+  }
+#else
+  CAFFE_THROW("NNAPI is not supported in this build");
+#endif
+}
+
+namespace {
+
+// Nearest-rank percentile of sorted latencies
+float percentile(const vector<float>& sorted, const float p) {
+  const size_t rank = std::ceil(p / 100 * sorted.size());
+  return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+}
+
+string jsonString(const string& s) {
+  string quoted = "\"";
+  for (const char c : s) {
+    if (c == '"' || c == '\\') {
+      quoted += '\\';
+    }
+    quoted += c;
+  }
+  return quoted + "\"";
+}
+
+} // namespace
+
+void logBenchmarkResult(const BenchmarkResult& result) {
+  if (result.latencies.empty()) {
+    return;
+  }
+  vector<float> sorted = result.latencies;
+  std::sort(sorted.begin(), sorted.end());
+  float sum = 0;
+  for (const float latency : sorted) {
+    sum += latency;
+  }
+  LOG(INFO) << result.backend << ": mean " << sum / sorted.size()
+            << " ms, p50 " << percentile(sorted, 50) << " ms, p90 "
+            << percentile(sorted, 90) << " ms, p99 " << percentile(sorted, 99)
+            << " ms over " << sorted.size() << " runs.";
+}
+
+void writeBenchmarkReport(
+    const string& path,
+    const vector<BenchmarkResult>& results) {
+  std::ofstream report(path);
+  CAFFE_ENFORCE(report, "Cannot open ", path);
+  report << "[";
+  for (int i = 0; i < results.size(); ++i) {
+    const auto& result = results[i];
+    report << (i ? ",\n" : "\n") << "  {\"backend\": "
+           << jsonString(result.backend)
+           << ", \"iterations\": " << result.latencies.size();
+    if (!result.latencies.empty()) {
+      vector<float> sorted = result.latencies;
+      std::sort(sorted.begin(), sorted.end());
+      float sum = 0;
+      for (const float latency : sorted) {
+        sum += latency;
+      }
+      report << ", \"latency_ms\": {\"mean\": " << sum / sorted.size()
+             << ", \"min\": " << sorted.front()
+             << ", \"p50\": " << percentile(sorted, 50)
+             << ", \"p90\": " << percentile(sorted, 90)
+             << ", \"p99\": " << percentile(sorted, 99)
+             << ", \"max\": " << sorted.back() << "}";
+    }
+    report << ", \"operators\": [";
+    for (int j = 0; j < result.operators.size(); ++j) {
+      const auto& op = result.operators[j];
+      report << (j ? ",\n" : "\n") << "    {\"name\": " << jsonString(op.name)
+             << ", \"type\": " << jsonString(op.type)
+             << ", \"time_ms\": " << op.milliseconds << "}";
+    }
+    report << (result.operators.empty() ? "]}" : "\n  ]}");
   }
+  report << "\n]\n";
 }
 
 void writeOutput(
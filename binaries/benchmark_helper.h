@@ -67,10 +67,39 @@ void writeTextOutput(
   std::copy(data.begin(), data.end(), output_iterator);
 }
 
+// How the device is let cool down between the main runs of a benchmark, so
+// that thermal throttling does not skew the later ones.
+struct Cooldown {
+  // Time to sleep after each run
+  int milliseconds = 0;
+  // A file holding the temperature in millidegrees Celsius, e.g.
+  // /sys/class/thermal/thermal_zone0/temp, polled after each run until it
+  // reads less than max_temperature degrees
+  string thermal_zone;
+  int max_temperature = 0;
+
+  void wait() const;
+};
+
+// The latencies of the main runs of a net on one backend, and the average
+// time of each of its operators, in the order of the operators of the net.
+struct BenchmarkResult {
+  struct Operator {
+    string name;
+    string type;
+    float milliseconds;
+  };
+
+  string backend;
+  vector<float> latencies;
+  vector<Operator> operators;
+};
+
 void observerConfig();
 bool backendCudaSet(const string&);
 void setDeviceType(caffe2::NetDef*, caffe2::DeviceType&);
 void setOperatorEngine(caffe2::NetDef*, const string&);
+void setBackend(caffe2::NetDef*, caffe2::NetDef*, const string&);
 void loadInput(
     shared_ptr<caffe2::Workspace>,
     const bool,
@@ -96,4 +125,18 @@ void runNetwork(
     const bool,
     const bool,
     const int,
-    const int);
+    const int,
+    const Cooldown&,
+    BenchmarkResult*);
+void runNNApi(
+    shared_ptr<caffe2::Workspace>,
+    const caffe2::NetDef&,
+    const caffe2::NetDef&,
+    const vector<string>&,
+    map<string, caffe2::TensorProtos>&,
+    const int,
+    const int,
+    const Cooldown&,
+    BenchmarkResult*);
+void logBenchmarkResult(const BenchmarkResult&);
+void writeBenchmarkReport(const string&, const vector<BenchmarkResult>&);
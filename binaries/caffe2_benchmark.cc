@@ -13,7 +13,14 @@ CAFFE2_DEFINE_string(
     backend,
     "builtin",
     "The backend to use when running the model. The allowed "
-    "backend choices are: builtin, default, nnpack, eigen, mkl, cuda");
+    "backend choices are: builtin, default, nnpack, eigen, mkl, cuda, "
+    "opengl, acl, nnapi. Use comma separated string to compare several "
+    "backends in one run.");
+CAFFE2_DEFINE_int(
+    cooldown_ms,
+    0,
+    "The time to sleep after each main run, to keep the device from "
+    "throttling.");
 
 CAFFE2_DEFINE_string(
     init_net,
@@ -45,6 +52,11 @@ CAFFE2_DEFINE_string(
     "Input type when specifying the input dimension."
     "The supported types are float, uint8_t.");
 CAFFE2_DEFINE_int(iter, 10, "The number of iterations to run.");
+CAFFE2_DEFINE_int(
+    max_temperature,
+    0,
+    "The temperature in degrees Celsius that thermal_zone must be below "
+    "before the next main run starts.");
 CAFFE2_DEFINE_string(net, "", "The given net to benchmark.");
 CAFFE2_DEFINE_string(
     output,
@@ -58,6 +70,11 @@ CAFFE2_DEFINE_string(
     "",
     "The folder that the output should be written to. This "
     "folder must already exist in the file system.");
+CAFFE2_DEFINE_string(
+    report,
+    "",
+    "The file to write the latency percentiles and the time of each "
+    "operator of every backend to, in JSON.");
 CAFFE2_DEFINE_bool(
     run_individual,
     false,
@@ -66,6 +83,12 @@ CAFFE2_DEFINE_bool(
     text_output,
     false,
     "Whether to write out output in text format for regression purpose.");
+CAFFE2_DEFINE_string(
+    thermal_zone,
+    "",
+    "The file holding the temperature of the device in millidegrees "
+    "Celsius, e.g. /sys/class/thermal/thermal_zone0/temp. If set, each main "
+    "run waits for it to drop below max_temperature.");
 CAFFE2_DEFINE_int(warmup, 0, "The number of iterations to warm up.");
 CAFFE2_DEFINE_bool(
     wipe_cache,
@@ -78,45 +101,84 @@ int main(int argc, char** argv) {
   observerConfig();
   caffe2::ShowLogInfoToStderr();
 
-  auto workspace = make_shared<caffe2::Workspace>(new caffe2::Workspace());
-  bool run_on_gpu = backendCudaSet(caffe2::FLAGS_backend);
+  Cooldown cooldown;
+  cooldown.milliseconds = caffe2::FLAGS_cooldown_ms;
+  cooldown.thermal_zone = caffe2::FLAGS_thermal_zone;
+  cooldown.max_temperature = caffe2::FLAGS_max_temperature;
 
-  // support other device type in the future?
-  caffe2::DeviceType run_dev = run_on_gpu ? caffe2::CUDA : caffe2::CPU;
+  vector<BenchmarkResult> results;
+  shared_ptr<caffe2::Workspace> workspace;
+  bool run_on_gpu = false;
+  for (const string& backend : caffe2::split(',', caffe2::FLAGS_backend)) {
+    LOG(INFO) << "Benchmarking backend " << backend << ".";
+    // Each backend starts from a fresh workspace.
+    workspace = make_shared<caffe2::Workspace>();
+    run_on_gpu = backendCudaSet(backend);
 
-  // Run initialization network.
-  caffe2::NetDef init_net_def;
-  CAFFE_ENFORCE(ReadProtoFromFile(caffe2::FLAGS_init_net, &init_net_def));
-  setDeviceType(&init_net_def, run_dev);
-  setOperatorEngine(&init_net_def, caffe2::FLAGS_backend);
-  CAFFE_ENFORCE(workspace->RunNetOnce(init_net_def));
+    // support other device type in the future?
+    caffe2::DeviceType run_dev = run_on_gpu ? caffe2::CUDA : caffe2::CPU;
 
-  // Run main network.
-  caffe2::NetDef net_def;
-  CAFFE_ENFORCE(ReadProtoFromFile(caffe2::FLAGS_net, &net_def));
-  setDeviceType(&net_def, run_dev);
-  setOperatorEngine(&net_def, caffe2::FLAGS_backend);
+    caffe2::NetDef init_net_def;
+    CAFFE_ENFORCE(ReadProtoFromFile(caffe2::FLAGS_init_net, &init_net_def));
+    setDeviceType(&init_net_def, run_dev);
+    caffe2::NetDef net_def;
+    CAFFE_ENFORCE(ReadProtoFromFile(caffe2::FLAGS_net, &net_def));
+    setDeviceType(&net_def, run_dev);
+    setBackend(&init_net_def, &net_def, backend);
 
-  map<string, caffe2::TensorProtos> tensor_protos_map;
+    map<string, caffe2::TensorProtos> tensor_protos_map;
+    results.emplace_back();
+    results.back().backend = backend;
+    if (backend == "nnapi") {
+      // NNAPI runs the initialization network itself.
+      loadInput(
+          workspace,
+          run_on_gpu,
+          tensor_protos_map,
+          caffe2::FLAGS_input,
+          caffe2::FLAGS_input_file,
+          caffe2::FLAGS_input_dims,
+          caffe2::FLAGS_input_type);
+      runNNApi(
+          workspace,
+          init_net_def,
+          net_def,
+          caffe2::split(',', caffe2::FLAGS_input),
+          tensor_protos_map,
+          caffe2::FLAGS_warmup,
+          caffe2::FLAGS_iter,
+          cooldown,
+          &results.back());
+    } else {
+      // Run initialization network.
+      CAFFE_ENFORCE(workspace->RunNetOnce(init_net_def));
+      loadInput(
+          workspace,
+          run_on_gpu,
+          tensor_protos_map,
+          caffe2::FLAGS_input,
+          caffe2::FLAGS_input_file,
+          caffe2::FLAGS_input_dims,
+          caffe2::FLAGS_input_type);
+      runNetwork(
+          workspace,
+          net_def,
+          tensor_protos_map,
+          caffe2::FLAGS_wipe_cache,
+          caffe2::FLAGS_run_individual,
+          caffe2::FLAGS_warmup,
+          caffe2::FLAGS_iter,
+          cooldown,
+          &results.back());
+    }
+    logBenchmarkResult(results.back());
+  }
 
-  loadInput(
-      workspace,
-      run_on_gpu,
-      tensor_protos_map,
-      caffe2::FLAGS_input,
-      caffe2::FLAGS_input_file,
-      caffe2::FLAGS_input_dims,
-      caffe2::FLAGS_input_type);
-
-  runNetwork(
-      workspace,
-      net_def,
-      tensor_protos_map,
-      caffe2::FLAGS_wipe_cache,
-      caffe2::FLAGS_run_individual,
-      caffe2::FLAGS_warmup,
-      caffe2::FLAGS_iter);
+  if (caffe2::FLAGS_report.size()) {
+    writeBenchmarkReport(caffe2::FLAGS_report, results);
+  }
 
+  // The outputs are the ones of the last backend.
   writeOutput(
       workspace,
       run_on_gpu,
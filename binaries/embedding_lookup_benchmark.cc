@@ -0,0 +1,213 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures caffe2::EmbeddingLookup (the kernel of SparseLengthsSum and
+// friends) over a sweep of table sizes, pooling factors and batch sizes, e.g.
+//
+//   embedding_lookup_benchmark --num_rows=100000,10000000 --pooling=20,100
+//       --prefetch_distances=-1,0,16 --sort_indices=false,true
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "caffe2/core/init.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/core/types.h"
+#include "caffe2/perfkernels/embedding_lookup.h"
+
+CAFFE2_DEFINE_string(
+    num_rows,
+    "10000,1000000,10000000",
+    "Comma separated numbers of rows of the table.");
+CAFFE2_DEFINE_int(block_size, 64, "Number of elements per row.");
+CAFFE2_DEFINE_string(
+    input_type,
+    "float",
+    "Type of the table elements: float, float16 or uint8.");
+CAFFE2_DEFINE_string(
+    pooling,
+    "1,20,100",
+    "Comma separated numbers of indices per bag.");
+CAFFE2_DEFINE_string(
+    batch_size,
+    "1,100,1000",
+    "Comma separated numbers of bags per call.");
+CAFFE2_DEFINE_double(
+    skew,
+    1.0,
+    "Indices are num_rows * u^skew for u uniform in [0, 1), so values > 1 "
+    "make low indices hot and repeat them within a batch.");
+CAFFE2_DEFINE_string(
+    prefetch_distances,
+    "-1",
+    "Comma separated values of --caffe2_embedding_lookup_prefetch_distance to "
+    "run with, -1 to autotune.");
+CAFFE2_DEFINE_string(
+    sort_indices,
+    "false",
+    "Comma separated values of --caffe2_embedding_lookup_sort_indices to run "
+    "with.");
+CAFFE2_DEFINE_int(warmup, 10, "Number of calls before timing.");
+CAFFE2_DEFINE_int(iter, 100, "Number of timed calls.");
+
+CAFFE2_DECLARE_int(caffe2_embedding_lookup_prefetch_distance);
+CAFFE2_DECLARE_bool(caffe2_embedding_lookup_sort_indices);
+
+namespace caffe2 {
+
+static std::vector<std::string> SplitList(const std::string& list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+static std::vector<TIndex> SplitIntList(const std::string& list) {
+  std::vector<TIndex> values;
+  for (const auto& item : SplitList(list)) {
+    values.push_back(std::stoll(item));
+  }
+  return values;
+}
+
+template <typename InType>
+static void FillTable(std::vector<InType>* table, std::mt19937* gen) {
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  for (auto& value : *table) {
+    value = static_cast<InType>(dist(*gen));
+  }
+}
+
+template <>
+void FillTable<float16>(std::vector<float16>* table, std::mt19937* gen) {
+  // the bit patterns of fp16 values in [-2, 2)
+  std::uniform_int_distribution<uint16_t> dist(0, 0x3fff);
+  for (auto& value : *table) {
+    value.x = dist(*gen) | ((*gen)() & 0x8000);
+  }
+}
+
+template <>
+void FillTable<uint8_t>(std::vector<uint8_t>* table, std::mt19937* gen) {
+  for (auto& value : *table) {
+    value = (*gen)() & 0xff;
+  }
+}
+
+template <typename InType>
+static void Benchmark(TIndex num_rows) {
+  const TIndex block_size = FLAGS_block_size;
+  std::mt19937 gen(0);
+  std::vector<InType> table(num_rows * block_size);
+  FillTable(&table, &gen);
+  std::vector<float> scale_bias;
+  if (std::is_same<InType, uint8_t>::value) {
+    scale_bias.resize(2 * num_rows, 0.5f);
+  }
+  const double row_bytes = block_size * sizeof(InType);
+
+  for (TIndex pooling : SplitIntList(FLAGS_pooling)) {
+    for (TIndex batch_size : SplitIntList(FLAGS_batch_size)) {
+      const TIndex index_size = pooling * batch_size;
+      std::vector<int> lengths(batch_size, pooling);
+      std::vector<float> output(batch_size * block_size);
+      // one set of indices per call, so that calls don't hit rows in cache
+      // just because the previous call loaded them
+      const int num_calls = FLAGS_warmup + FLAGS_iter;
+      std::vector<int64_t> indices(num_calls * index_size);
+      std::uniform_real_distribution<double> dist(0., 1.);
+      for (auto& index : indices) {
+        index = std::min<int64_t>(
+            num_rows - 1,
+            static_cast<int64_t>(num_rows * std::pow(dist(gen), FLAGS_skew)));
+      }
+
+      for (const auto& sort : SplitList(FLAGS_sort_indices)) {
+        for (TIndex distance : SplitIntList(FLAGS_prefetch_distances)) {
+          FLAGS_caffe2_embedding_lookup_sort_indices = sort == "true";
+          FLAGS_caffe2_embedding_lookup_prefetch_distance = distance;
+          Timer timer;
+          for (int call = 0; call < num_calls; ++call) {
+            if (call == FLAGS_warmup) {
+              timer.Start();
+            }
+            EmbeddingLookup(
+                block_size,
+                batch_size,
+                index_size,
+                num_rows,
+                table.data(),
+                indices.data() + call * index_size,
+                lengths.data(),
+                nullptr,
+                scale_bias.empty() ? nullptr : scale_bias.data(),
+                false,
+                output.data());
+          }
+          const double ns_per_index =
+              timer.NanoSeconds() / (FLAGS_iter * index_size);
+          printf(
+              "table %10.1f MB  pooling %4lld  batch %5lld  sort %5s  "
+              "prefetch %3lld  %8.2f ns/index  %7.2f GB/s\n",
+              num_rows * row_bytes / (1 << 20),
+              static_cast<long long>(pooling),
+              static_cast<long long>(batch_size),
+              sort.c_str(),
+              static_cast<long long>(distance),
+              ns_per_index,
+              row_bytes / ns_per_index);
+        }
+      }
+    }
+  }
+}
+
+static int Run(int argc, char** argv) {
+  GlobalInit(&argc, &argv);
+  CAFFE_ENFORCE_GT(FLAGS_block_size, 0, "--block_size must be positive");
+  CAFFE_ENFORCE_GT(FLAGS_iter, 0, "--iter must be positive");
+
+  for (TIndex num_rows : SplitIntList(FLAGS_num_rows)) {
+    if (FLAGS_input_type == "float") {
+      Benchmark<float>(num_rows);
+    } else if (FLAGS_input_type == "float16") {
+      Benchmark<float16>(num_rows);
+    } else if (FLAGS_input_type == "uint8") {
+      Benchmark<uint8_t>(num_rows);
+    } else {
+      CAFFE_THROW("Unknown --input_type ", FLAGS_input_type);
+    }
+  }
+  return 0;
+}
+
+} // namespace caffe2
+
+int main(int argc, char** argv) {
+  return caffe2::Run(argc, argv);
+}
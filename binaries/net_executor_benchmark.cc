@@ -0,0 +1,294 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the scheduling overhead of the net executors on synthetic nets of
+// ops that spin for a given time, e.g.
+//
+//   net_executor_benchmark --topologies=chain,random --num_ops=256
+//       --op_cost_us=0,50 --net_types=dag,async_scheduling --threads=1,8
+//
+// For every net it reports the time per run, the overhead per op, i.e. the
+// time per run over the ideal one spread over the ops, and the efficiency,
+// the ideal time over the time per run. The ideal time is the larger of the
+// critical path of the net and its total work spread evenly over the
+// threads.
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/init.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/core/workspace.h"
+
+CAFFE2_DEFINE_string(
+    topologies,
+    "chain,fanout,diamond,random",
+    "Comma separated shapes of the nets: chain, fanout (a root op, parallel "
+    "ops and a join op), diamond (stages of diamond_width parallel ops "
+    "between join ops) or random (random DAGs).");
+CAFFE2_DEFINE_string(
+    net_types,
+    "simple,dag,async_scheduling,async_polling,async_dag",
+    "Comma separated net types to run; the ones not built in are skipped.");
+CAFFE2_DEFINE_int(num_ops, 64, "Number of ops of the nets.");
+CAFFE2_DEFINE_string(
+    op_cost_us,
+    "0,10,100",
+    "Comma separated times in microseconds every op spins for.");
+CAFFE2_DEFINE_string(
+    threads,
+    "1,4,16",
+    "Comma separated numbers of workers of the nets, ignored by simple nets.");
+CAFFE2_DEFINE_int(diamond_width, 4, "Number of parallel ops of a diamond.");
+CAFFE2_DEFINE_int(
+    random_max_deps,
+    3,
+    "Maximum number of parents of an op of a random DAG.");
+CAFFE2_DEFINE_int(
+    random_window,
+    16,
+    "The parents of an op of a random DAG are among the random_window ops "
+    "before it.");
+CAFFE2_DEFINE_int(seed, 0, "Seed of the random DAGs.");
+CAFFE2_DEFINE_int(warmup, 10, "Number of runs before timing.");
+CAFFE2_DEFINE_int(iter, 100, "Number of timed runs.");
+
+namespace caffe2 {
+
+namespace {
+
+// Spins for cost_us microseconds and writes its output, so that the ops of
+// the benchmark nets only depend on each other through their blobs.
+class NetExecutorBenchmarkWorkOp final : public Operator<CPUContext> {
+ public:
+  NetExecutorBenchmarkWorkOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        cost_(std::chrono::nanoseconds(static_cast<int64_t>(
+            GetSingleArgument<float>("cost_us", 0) * 1000))) {}
+
+  bool RunOnDevice() override {
+    if (cost_.count() > 0) {
+      const auto end = std::chrono::steady_clock::now() + cost_;
+      while (std::chrono::steady_clock::now() < end) {
+      }
+    }
+    auto* output = Output(0);
+    output->Resize(1);
+    output->mutable_data<float>();
+    return true;
+  }
+
+ private:
+  const std::chrono::nanoseconds cost_;
+};
+
+REGISTER_CPU_OPERATOR(NetExecutorBenchmarkWork, NetExecutorBenchmarkWorkOp);
+OPERATOR_SCHEMA(NetExecutorBenchmarkWork).NumInputs(0, INT_MAX).NumOutputs(1);
+
+std::vector<std::string> SplitList(const std::string& list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    if (!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+std::vector<double> SplitDoubleList(const std::string& list) {
+  std::vector<double> values;
+  for (const auto& item : SplitList(list)) {
+    values.push_back(std::stod(item));
+  }
+  return values;
+}
+
+// The parents of every op of a net of the topology, which all come before it.
+std::vector<std::vector<int>> MakeTopology(
+    const std::string& topology,
+    int num_ops) {
+  std::vector<std::vector<int>> parents(num_ops);
+  if (topology == "chain") {
+    for (int i = 1; i < num_ops; ++i) {
+      parents[i] = {i - 1};
+    }
+  } else if (topology == "fanout" || topology == "diamond") {
+    // Stages of width parallel ops that fork from a join op and join into the
+    // next one
+    const int width =
+        topology == "fanout" ? std::max(num_ops - 2, 1) : FLAGS_diamond_width;
+    CAFFE_ENFORCE_GT(width, 0, "--diamond_width must be positive");
+    int join = 0;
+    int i = 1;
+    while (i < num_ops) {
+      const int stage_begin = i;
+      for (; i < num_ops && i - stage_begin < width; ++i) {
+        parents[i] = {join};
+      }
+      if (i < num_ops) {
+        for (int j = stage_begin; j < i; ++j) {
+          parents[i].push_back(j);
+        }
+        join = i++;
+      }
+    }
+  } else if (topology == "random") {
+    std::mt19937 gen(FLAGS_seed);
+    for (int i = 1; i < num_ops; ++i) {
+      const int window = std::min(i, FLAGS_random_window);
+      const int num_parents = std::uniform_int_distribution<int>(
+          1, std::min(window, std::max(FLAGS_random_max_deps, 1)))(gen);
+      std::vector<int> candidates;
+      for (int j = i - window; j < i; ++j) {
+        candidates.push_back(j);
+      }
+      std::shuffle(candidates.begin(), candidates.end(), gen);
+      parents[i].assign(candidates.begin(), candidates.begin() + num_parents);
+      std::sort(parents[i].begin(), parents[i].end());
+    }
+  } else {
+    CAFFE_THROW("Unknown topology: ", topology);
+  }
+  return parents;
+}
+
+// Number of ops of the longest path of the net.
+int CriticalPathLength(const std::vector<std::vector<int>>& parents) {
+  std::vector<int> depth(parents.size(), 1);
+  int longest = 0;
+  for (size_t i = 0; i < parents.size(); ++i) {
+    for (int parent : parents[i]) {
+      depth[i] = std::max(depth[i], depth[parent] + 1);
+    }
+    longest = std::max(longest, depth[i]);
+  }
+  return longest;
+}
+
+NetDef MakeNet(
+    const std::vector<std::vector<int>>& parents,
+    double cost_us,
+    const std::string& net_type,
+    int threads) {
+  NetDef net;
+  net.set_name("net_executor_benchmark");
+  net.set_type(net_type);
+  auto* num_workers = net.add_arg();
+  num_workers->set_name("num_workers");
+  num_workers->set_i(threads);
+  for (size_t i = 0; i < parents.size(); ++i) {
+    auto* op = net.add_op();
+    op->set_type("NetExecutorBenchmarkWork");
+    for (int parent : parents[i]) {
+      op->add_input("blob_" + caffe2::to_string(parent));
+    }
+    op->add_output("blob_" + caffe2::to_string(i));
+    auto* arg = op->add_arg();
+    arg->set_name("cost_us");
+    arg->set_f(cost_us);
+  }
+  return net;
+}
+
+void Benchmark(const std::string& topology) {
+  const auto parents = MakeTopology(topology, FLAGS_num_ops);
+  const int critical_path = CriticalPathLength(parents);
+  const int num_ops = parents.size();
+  std::vector<int> threads_list;
+  for (const auto& item : SplitList(FLAGS_threads)) {
+    threads_list.push_back(std::stoi(item));
+    CAFFE_ENFORCE_GT(threads_list.back(), 0, "--threads must be positive");
+  }
+
+  for (const auto& net_type : SplitList(FLAGS_net_types)) {
+    if (!NetRegistry()->Has(net_type)) {
+      LOG(WARNING) << "Net type " << net_type << " is not built in, skipping";
+      continue;
+    }
+    for (double cost_us : SplitDoubleList(FLAGS_op_cost_us)) {
+      const bool serial = net_type == "simple";
+      for (size_t t = 0; t < threads_list.size(); ++t) {
+        // Simple nets run on the calling thread
+        if (serial && t > 0) {
+          break;
+        }
+        const int threads = threads_list[t];
+
+        Workspace ws;
+        auto* net = ws.CreateNet(MakeNet(parents, cost_us, net_type, threads));
+        CAFFE_ENFORCE(net, "Failed to create the net");
+        Timer timer;
+        for (int run = 0; run < FLAGS_warmup + FLAGS_iter; ++run) {
+          if (run == FLAGS_warmup) {
+            timer.Start();
+          }
+          CAFFE_ENFORCE(net->Run(), "Failed to run the net");
+        }
+        const double us_per_run = timer.MicroSeconds() / FLAGS_iter;
+
+        const double ideal_us = serial
+            ? num_ops * cost_us
+            : std::max(
+                  critical_path * cost_us,
+                  static_cast<double>(num_ops) * cost_us / threads);
+        const double overhead_ns_per_op =
+            (us_per_run - ideal_us) * 1000 / num_ops;
+        printf(
+            "%-8s ops %5d  critical path %5d  cost %8.2f us  %-16s "
+            "threads %3d  %12.2f us/run  %10.1f ns/op overhead  "
+            "%6.1f%% efficiency\n",
+            topology.c_str(),
+            num_ops,
+            critical_path,
+            cost_us,
+            net_type.c_str(),
+            serial ? 1 : threads,
+            us_per_run,
+            overhead_ns_per_op,
+            us_per_run > 0 ? 100 * ideal_us / us_per_run : 100.);
+      }
+    }
+  }
+}
+
+} // namespace
+
+static int Run(int argc, char** argv) {
+  GlobalInit(&argc, &argv);
+  CAFFE_ENFORCE_GT(FLAGS_num_ops, 0, "--num_ops must be positive");
+  CAFFE_ENFORCE_GT(FLAGS_iter, 0, "--iter must be positive");
+  for (const auto& topology : SplitList(FLAGS_topologies)) {
+    Benchmark(topology);
+  }
+  return 0;
+}
+
+} // namespace caffe2
+
+int main(int argc, char** argv) {
+  return caffe2::Run(argc, argv);
+}
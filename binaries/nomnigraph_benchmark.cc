@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the passes over the nomnigraph representation of large nets:
+// converting a NetDef, matching a pattern and rewriting the graph.
+
+#include "benchmark/benchmark.h"
+
+#include "caffe2/opt/converter.h"
+#include "caffe2/opt/fusion.h"
+#include "nomnigraph/Transformations/Match.h"
+
+using namespace caffe2;
+using namespace nom;
+
+namespace {
+
+void AddOp(
+    NetDef* net,
+    const std::string& type,
+    const std::vector<std::string>& inputs,
+    const std::string& output) {
+  auto* def = net->add_op();
+  def->set_type(type);
+  for (const auto& input : inputs) {
+    def->add_input(input);
+  }
+  def->add_output(output);
+}
+
+// A chain of blocks Conv -> Relu -> Add, numOps operators in all
+NetDef CreateNet(int numOps) {
+  NetDef net;
+  std::string input = "X";
+  for (int i = 0; i < numOps / 3; ++i) {
+    const auto id = std::to_string(i);
+    AddOp(&net, "Conv", {input, "W" + id, "B" + id}, "conv" + id);
+    AddOp(&net, "Relu", {"conv" + id}, "relu" + id);
+    AddOp(&net, "Add", {"relu" + id, input}, "add" + id);
+    input = "add" + id;
+  }
+  return net;
+}
+
+struct NNEquality {
+  static bool equal(
+      const repr::NNGraph::NodeRef& a,
+      const repr::NNGraph::NodeRef& b) {
+    if (!repr::nn::is<repr::NeuralNetOperator>(a) ||
+        !repr::nn::is<repr::NeuralNetOperator>(b)) {
+      return false;
+    }
+    return repr::nn::get<repr::NeuralNetOperator>(a)->getName() ==
+        repr::nn::get<repr::NeuralNetOperator>(b)->getName();
+  }
+};
+
+// Conv -> Relu, the data node between them not being an operator
+repr::NNGraph CreatePattern() {
+  repr::NNGraph pattern;
+  auto conv =
+      pattern.createNode(util::make_unique<repr::GenericOperator>("Conv"));
+  auto relu =
+      pattern.createNode(util::make_unique<repr::GenericOperator>("Relu"));
+  pattern.createEdge(conv, relu);
+  return pattern;
+}
+
+void BM_ConvertToNNModule(benchmark::State& state) {
+  auto net = CreateNet(state.range(0));
+  while (state.KeepRunning()) {
+    auto nn = convertToNNModule(net);
+    benchmark::DoNotOptimize(nn.dataFlow.getNodesCount());
+  }
+}
+BENCHMARK(BM_ConvertToNNModule)->Arg(3000)->Arg(48000);
+
+void BM_ConvertToCaffe2Proto(benchmark::State& state) {
+  auto net = CreateNet(state.range(0));
+  auto nn = convertToNNModule(net);
+  while (state.KeepRunning()) {
+    auto newNet = convertToCaffe2Proto(nn, net);
+    benchmark::DoNotOptimize(newNet.op_size());
+  }
+}
+BENCHMARK(BM_ConvertToCaffe2Proto)->Arg(3000)->Arg(48000);
+
+// Operators are one node away from each other in the data flow, so this
+// pattern never matches, which is what most anchors of most patterns do.
+void BM_Match(benchmark::State& state) {
+  auto net = CreateNet(state.range(0));
+  auto nn = convertToNNModule(net);
+  auto pattern = CreatePattern();
+  Match<repr::NNGraph, NNEquality> match(pattern);
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(match.match(nn.dataFlow).size());
+  }
+}
+BENCHMARK(BM_Match)->Arg(3000)->Arg(48000);
+
+void BM_MatchIndexed(benchmark::State& state) {
+  auto net = CreateNet(state.range(0));
+  auto nn = convertToNNModule(net);
+  auto pattern = CreatePattern();
+  Match<repr::NNGraph, NNEquality> match(pattern);
+  while (state.KeepRunning()) {
+    NodeIndex<repr::NNGraph, repr::nn::OperatorKey> index(nn.dataFlow);
+    benchmark::DoNotOptimize(match.match(index).size());
+  }
+}
+BENCHMARK(BM_MatchIndexed)->Arg(3000)->Arg(48000);
+
+void BM_FuseActivation(benchmark::State& state) {
+  auto net = CreateNet(state.range(0));
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    auto nn = convertToNNModule(net);
+    state.ResumeTiming();
+    opt::fuseActivation<repr::Conv, repr::Relu>(
+        &nn,
+        [](const repr::Conv& /* unused */) { return true; },
+        [](repr::NNGraph::NodeRef /* unused */) {});
+    benchmark::DoNotOptimize(nn.dataFlow.getNodesCount());
+  }
+}
+BENCHMARK(BM_FuseActivation)->Arg(3000)->Arg(48000);
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,278 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Runs a net operator by operator and puts the measured time of each one
+// next to the cost its schema infers (OpSchema::CostInferenceFunction): the
+// achieved GFLOP/s and GB/s, and how far the operator is from the roofline of
+// a machine with the given peak compute and memory bandwidth. Operators are
+// listed by the time they would save running at the roofline, which is where
+// optimization effort pays off.
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "caffe2/core/init.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/utils/proto_utils.h"
+#include "caffe2/utils/string_utils.h"
+
+CAFFE2_DEFINE_string(net, "", "The given net to profile.");
+CAFFE2_DEFINE_string(
+    init_net,
+    "",
+    "The given net to initialize any parameters.");
+CAFFE2_DEFINE_string(
+    input,
+    "",
+    "Input that is needed for running the network. If "
+    "multiple input needed, use comma separated string.");
+CAFFE2_DEFINE_string(
+    input_dims,
+    "",
+    "The dimension of the inputs, using comma separated numbers. If "
+    "multiple input needed, use semicolon to separate the dimension of "
+    "different tensors.");
+CAFFE2_DEFINE_string(
+    input_type,
+    "float",
+    "Input type (uint8_t/float), using semicolon to separate the types of "
+    "different tensors.");
+CAFFE2_DEFINE_int(warmup, 1, "The number of iterations to warm up.");
+CAFFE2_DEFINE_int(iter, 10, "The number of iterations to run.");
+CAFFE2_DEFINE_double(
+    peak_gflops,
+    0,
+    "Peak compute of the machine, in GFLOP/s. Required for the roofline.");
+CAFFE2_DEFINE_double(
+    peak_gbps,
+    0,
+    "Peak memory bandwidth of the machine, in GB/s. Required for the "
+    "roofline.");
+CAFFE2_DEFINE_int(top, 0, "Only report this many operators, if positive.");
+
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace {
+
+struct OperatorProfile {
+  int index;
+  string type;
+  string name;
+  bool has_cost = false;
+  caffe2::OpSchema::Cost cost;
+  float millis = 0;
+
+  uint64_t bytes() const {
+    return cost.bytes_read + cost.bytes_written;
+  }
+
+  // Time of the operator running at the roofline, in milliseconds.
+  double rooflineMillis() const {
+    const double compute = caffe2::FLAGS_peak_gflops > 0
+        ? 1.0e-6 * cost.flops / caffe2::FLAGS_peak_gflops
+        : 0;
+    const double memory = caffe2::FLAGS_peak_gbps > 0
+        ? 1.0e-6 * bytes() / caffe2::FLAGS_peak_gbps
+        : 0;
+    return std::max(compute, memory);
+  }
+
+  double headroomMillis() const {
+    return has_cost ? std::max(0.0, millis - rooflineMillis()) : 0;
+  }
+};
+
+bool InferCost(const caffe2::OperatorBase& op, caffe2::OpSchema::Cost* cost) {
+  const auto* schema = caffe2::OpSchemaRegistry::Schema(op.debug_def().type());
+  if (!schema || !schema->HasCostInferenceFunction()) {
+    return false;
+  }
+  const auto shapes = op.InputTensorShapes();
+  for (const auto& shape : shapes) {
+    if (shape.unknown_shape()) {
+      return false;
+    }
+  }
+  try {
+    *cost = schema->InferCost(op.debug_def(), shapes);
+  } catch (const caffe2::EnforceNotMet& err) {
+    LOG(WARNING) << "Cost inference failed for " << op.debug_def().type()
+                 << ": " << err.msg();
+    return false;
+  }
+  return true;
+}
+
+void CreateInputs(caffe2::Workspace* workspace) {
+  if (caffe2::FLAGS_input.empty()) {
+    return;
+  }
+  const vector<string> input_names = caffe2::split(',', caffe2::FLAGS_input);
+  const vector<string> input_dims_list =
+      caffe2::split(';', caffe2::FLAGS_input_dims);
+  vector<string> input_type_list = caffe2::split(';', caffe2::FLAGS_input_type);
+  if (input_type_list.size() == 1) {
+    input_type_list.resize(input_names.size(), input_type_list[0]);
+  }
+  CAFFE_ENFORCE_EQ(
+      input_names.size(),
+      input_dims_list.size(),
+      "Input name and dims should have the same number of items.");
+  CAFFE_ENFORCE_EQ(
+      input_names.size(),
+      input_type_list.size(),
+      "Input name and type should have the same number of items.");
+  for (size_t i = 0; i < input_names.size(); ++i) {
+    vector<int> input_dims;
+    for (const string& s : caffe2::split(',', input_dims_list[i])) {
+      input_dims.push_back(caffe2::stoi(s));
+    }
+    auto* tensor = workspace->CreateBlob(input_names[i])
+                       ->GetMutable<caffe2::TensorCPU>();
+    tensor->Resize(input_dims);
+    if (input_type_list[i] == "uint8_t") {
+      tensor->mutable_data<uint8_t>();
+    } else if (input_type_list[i] == "float") {
+      tensor->mutable_data<float>();
+    } else {
+      CAFFE_THROW("Unsupported input type: ", input_type_list[i]);
+    }
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  caffe2::GlobalInit(&argc, &argv);
+  unique_ptr<caffe2::Workspace> workspace(new caffe2::Workspace());
+
+  caffe2::NetDef net_def;
+  if (!caffe2::FLAGS_init_net.empty()) {
+    CAFFE_ENFORCE(ReadProtoFromFile(caffe2::FLAGS_init_net, &net_def));
+    CAFFE_ENFORCE(workspace->RunNetOnce(net_def));
+  }
+  CreateInputs(workspace.get());
+
+  CAFFE_ENFORCE(ReadProtoFromFile(caffe2::FLAGS_net, &net_def));
+  if (!net_def.has_name()) {
+    net_def.set_name("roofline");
+  }
+  auto* net = workspace->CreateNet(net_def);
+  CHECK_NOTNULL(net);
+  CAFFE_ENFORCE(net->Run());
+
+  const auto operators = net->GetOperators();
+  vector<OperatorProfile> profiles(operators.size());
+  for (size_t i = 0; i < operators.size(); ++i) {
+    const auto& def = operators[i]->debug_def();
+    profiles[i].index = i;
+    profiles[i].type = def.type();
+    profiles[i].name = def.name().size()
+        ? def.name()
+        : (def.output_size() ? def.output(0) : "NO_OUTPUT");
+    profiles[i].has_cost = InferCost(*operators[i], &profiles[i].cost);
+  }
+
+  for (int i = 0; i < caffe2::FLAGS_warmup; ++i) {
+    CAFFE_ENFORCE(net->Run(), "Warmup run ", i, " has failed.");
+  }
+  caffe2::Timer timer;
+  for (int i = 0; i < caffe2::FLAGS_iter; ++i) {
+    for (size_t j = 0; j < operators.size(); ++j) {
+      timer.Start();
+      CAFFE_ENFORCE(operators[j]->Run(), "Operator ", j, " has failed.");
+      profiles[j].millis += timer.MilliSeconds();
+    }
+  }
+  float total_millis = 0;
+  for (auto& profile : profiles) {
+    profile.millis /= std::max(caffe2::FLAGS_iter, 1);
+    total_millis += profile.millis;
+  }
+
+  std::stable_sort(
+      profiles.begin(),
+      profiles.end(),
+      [](const OperatorProfile& a, const OperatorProfile& b) {
+        return a.headroomMillis() > b.headroomMillis() ||
+            (a.headroomMillis() == b.headroomMillis() && a.millis > b.millis);
+      });
+  if (caffe2::FLAGS_top > 0 && caffe2::FLAGS_top < (int)profiles.size()) {
+    profiles.resize(caffe2::FLAGS_top);
+  }
+
+  const bool roofline =
+      caffe2::FLAGS_peak_gflops > 0 && caffe2::FLAGS_peak_gbps > 0;
+  if (!roofline) {
+    std::cout << "Pass --peak_gflops and --peak_gbps to compare against the "
+              << "roofline of the machine." << std::endl;
+  }
+  std::cout << std::setw(6) << "#" << std::setw(24) << "type" << std::setw(12)
+            << "ms/iter" << std::setw(8) << "time%" << std::setw(12)
+            << "GFLOP/s" << std::setw(10) << "GB/s" << std::setw(10)
+            << "FLOP/B";
+  if (roofline) {
+    std::cout << std::setw(9) << "bound" << std::setw(9) << "%peak"
+              << std::setw(12) << "headroom";
+  }
+  std::cout << "  name" << std::endl;
+  std::cout << std::fixed;
+  for (const auto& profile : profiles) {
+    std::cout << std::setw(6) << profile.index << std::setw(24)
+              << profile.type << std::setw(12) << std::setprecision(4)
+              << profile.millis << std::setw(8) << std::setprecision(1)
+              << (total_millis > 0 ? 100 * profile.millis / total_millis : 0);
+    if (!profile.has_cost || profile.millis <= 0) {
+      std::cout << std::setw(12) << "n/a" << std::setw(10) << "n/a"
+                << std::setw(10) << "n/a";
+      if (roofline) {
+        std::cout << std::setw(9) << "" << std::setw(9) << "" << std::setw(12)
+                  << "";
+      }
+    } else {
+      const double gflops = 1.0e-6 * profile.cost.flops / profile.millis;
+      const double gbps = 1.0e-6 * profile.bytes() / profile.millis;
+      const double intensity = profile.bytes() > 0
+          ? static_cast<double>(profile.cost.flops) / profile.bytes()
+          : 0;
+      std::cout << std::setw(12) << std::setprecision(2) << gflops
+                << std::setw(10) << gbps << std::setw(10) << intensity;
+      if (roofline) {
+        // Below the ridge point, the bandwidth limits the attainable compute.
+        const bool memory_bound = intensity * caffe2::FLAGS_peak_gbps <
+            caffe2::FLAGS_peak_gflops;
+        const double efficiency = memory_bound
+            ? gbps / caffe2::FLAGS_peak_gbps
+            : gflops / caffe2::FLAGS_peak_gflops;
+        std::cout << std::setw(9) << (memory_bound ? "memory" : "compute")
+                  << std::setw(9) << std::setprecision(1) << 100 * efficiency
+                  << std::setw(12) << std::setprecision(4)
+                  << profile.headroomMillis();
+      }
+    }
+    std::cout << "  " << profile.name << std::endl;
+  }
+  std::cout << "Total: " << std::setprecision(4) << total_millis
+            << " ms/iter" << std::endl;
+  return 0;
+}
@@ -17,6 +17,13 @@
 // This binary provides an easy way to open a zeromq server and feeds data to
 // clients connect to it. It uses the Caffe2 db as the backend, thus allowing
 // one to convert any db-compliant storage to a zeromq service.
+//
+// Records are pushed round-robin to every ZmqDB reader connected to the
+// server. With --batch_size greater than one they are sent in framed batches
+// of that many records (see caffe2/utils/zmq_helper.h), which cuts the
+// per-message overhead. At most --send_hwm messages are queued for each
+// reader; once every reader's queue is full the server waits for one of them
+// to catch up.
 
 #include "caffe2/core/db.h"
 #include "caffe2/core/init.h"
@@ -26,6 +33,15 @@
 CAFFE2_DEFINE_string(server, "tcp://*:5555", "The server address.");
 CAFFE2_DEFINE_string(input_db, "", "The input db.");
 CAFFE2_DEFINE_string(input_db_type, "", "The input db type.");
+CAFFE2_DEFINE_int(
+    batch_size,
+    1,
+    "The number of records per message. 1 sends each record as a two-part "
+    "key / value message, which readers of any version understand.");
+CAFFE2_DEFINE_int(
+    send_hwm,
+    16,
+    "The number of messages queued for each reader before sending blocks.");
 
 using caffe2::db::DB;
 using caffe2::db::Cursor;
@@ -48,13 +64,24 @@ int main(int argc, char** argv) {
 
   //  Socket to talk to clients
   caffe2::ZmqSocket sender(ZMQ_PUSH);
+  sender.SetOption(ZMQ_SNDHWM, caffe2::FLAGS_send_hwm);
   sender.Bind(caffe2::FLAGS_server);
   LOG(INFO) << "Server created at " << caffe2::FLAGS_server;
 
+  caffe2::ZmqRecordBatchWriter batch;
   while (1) {
     VLOG(1) << "Sending " << cursor->key();
-    sender.SendTillSuccess(cursor->key(), ZMQ_SNDMORE);
-    sender.SendTillSuccess(cursor->value(), 0);
+    if (caffe2::FLAGS_batch_size > 1) {
+      batch.Add(cursor->key(), cursor->value());
+      if (batch.num_records() ==
+          static_cast<uint32_t>(caffe2::FLAGS_batch_size)) {
+        sender.SendTillSuccess(batch.data(), 0);
+        batch.Clear();
+      }
+    } else {
+      sender.SendTillSuccess(cursor->key(), ZMQ_SNDMORE);
+      sender.SendTillSuccess(cursor->value(), 0);
+    }
     cursor->Next();
     if (!cursor->Valid()) {
       cursor->SeekToFirst();
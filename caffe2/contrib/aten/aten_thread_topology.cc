@@ -0,0 +1,17 @@
+#include "caffe2/core/thread_topology.h"
+
+#include <ATen/CPUGeneral.h>
+#include <ATen/Parallel.h>
+
+namespace caffe2 {
+
+void SetATenIntraOpThreads(int num_threads, bool global) {
+  if (global) {
+    at::set_num_threads(num_threads);
+  } else {
+    at::set_intra_op_num_threads(num_threads);
+  }
+}
+REGISTER_INTRA_OP_THREADS_SETTER(ATen, &SetATenIntraOpThreads);
+
+} // namespace caffe2
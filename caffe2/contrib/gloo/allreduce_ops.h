@@ -1,10 +1,12 @@
 #pragma once
 
 #include <algorithm>
+#include <type_traits>
 
 #include "caffe2/contrib/gloo/common.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/thread_pool.h"
 
 #include <gloo/algorithm.h>
 #include <gloo/common/error.h>
@@ -26,15 +28,31 @@ class AllreduceOp final : public Operator<Context> {
         status_blob_(
             OperatorBase::GetSingleArgument<std::string>("status_blob", "")),
         gpu_direct_(
-            OperatorBase::GetSingleArgument<bool>("gpu_direct", false)) {
+            OperatorBase::GetSingleArgument<bool>("gpu_direct", false)),
+        async_(OperatorBase::GetSingleArgument<bool>("async", false)) {
     if (status_blob_ != "") {
       ws_->CreateBlob(status_blob_);
     }
+    CAFFE_ENFORCE(
+        !async_ || std::is_same<Context, CPUContext>::value,
+        "Async allreduce is only supported on CPU");
+    if (async_) {
+      worker_.reset(new TaskThreadPool(1));
+    }
   }
 
-  virtual ~AllreduceOp() {}
+  virtual ~AllreduceOp() {
+    if (worker_) {
+      worker_->waitWorkComplete();
+    }
+  }
 
   bool RunOnDevice() override {
+    // The previous run must be finished before the inputs are checked
+    if (worker_) {
+      worker_->waitWorkComplete();
+    }
+
     std::call_once(once_, [&] { initialize(); });
 
     // If any parameter has changed in between runs, the initialized
@@ -42,20 +60,36 @@ class AllreduceOp final : public Operator<Context> {
     update(current_);
     CAFFE_ENFORCE(current_ == init_, "Inputs/outputs have changed");
 
-    try {
-      algorithm_->run();
-    } catch (::gloo::IoException& ioe) {
-      LOG(ERROR) << "Caught gloo IO exception: " << ioe.what();
-      if (status_blob_ != "") {
-        signalFailure(ws_->GetBlob(status_blob_), ioe);
-        return false;
-      } else {
-        throw;
-      }
+    // Without an event (e.g. in the middle of a chain of operators), nobody
+    // would wait for the allreduce, so it is run inline
+    if (!async_ || this->IsEventDisabled()) {
+      return runAlgorithm();
     }
+
+    // The event of the operator is recorded when this returns, and is set
+    // finished by the worker when the allreduce is done
+    worker_->run([this] {
+      bool success = false;
+      std::string err_msg;
+      try {
+        success = runAlgorithm();
+        err_msg = "Gloo allreduce failed";
+      } catch (const std::exception& e) {
+        err_msg = e.what();
+      }
+      try {
+        this->SetEventFinished(success ? nullptr : err_msg.c_str());
+      } catch (const EnforceNotMet&) {
+        // The event was already set finished, e.g. cancelled by the net
+      }
+    });
     return true;
   }
 
+  bool HasAsyncPart() const override {
+    return async_ || Operator<Context>::HasAsyncPart();
+  }
+
  protected:
   void initialize() {
     Mode mode = HALVING_DOUBLING;
@@ -97,6 +131,21 @@ class AllreduceOp final : public Operator<Context> {
     CAFFE_ENFORCE(false, "Unreachable code");
   }
 
+  bool runAlgorithm() {
+    try {
+      algorithm_->run();
+    } catch (::gloo::IoException& ioe) {
+      LOG(ERROR) << "Caught gloo IO exception: " << ioe.what();
+      if (status_blob_ != "") {
+        signalFailure(ws_->GetBlob(status_blob_), ioe);
+        return false;
+      } else {
+        throw;
+      }
+    }
+    return true;
+  }
+
   void initializeHalvingDoubling();
   void initializeRingFull();
   void initializeRingChunked();
@@ -125,6 +174,11 @@ class AllreduceOp final : public Operator<Context> {
   Workspace* ws_;
   std::string status_blob_;
   const bool gpu_direct_;
+
+  // In async mode, the allreduce runs on a worker of the operator, and the
+  // operator completes through its event, which only async nets wait for
+  const bool async_;
+  std::unique_ptr<TaskThreadPool> worker_;
 };
 
 } // namespace gloo
@@ -347,6 +347,68 @@ class TestCase(hu.HypothesisTestCase):
                     tmpdir=tmpdir,
                     use_float16=use_float16)
 
+    def _test_allreduce_async(self,
+                              comm_rank=None,
+                              comm_size=None,
+                              tmpdir=None
+                              ):
+        _store_handler, common_world = self.create_common_world(
+            comm_rank=comm_rank,
+            comm_size=comm_size,
+            tmpdir=tmpdir)
+
+        blob_size = 1e4
+        num_blobs = 4
+
+        # The allreduces complete in the background, and the scaling of their
+        # outputs must wait for them
+        net = core.Net("allreduce_async")
+        net.Proto().type = "async_scheduling"
+        blobs = []
+        for i in range(num_blobs):
+            blob = "blob_{}".format(i)
+            value = np.full(blob_size, (comm_rank * num_blobs) + i, np.float32)
+            workspace.FeedBlob(blob, value)
+            blobs.append(blob)
+            net.Allreduce(
+                [common_world, blob],
+                [blob],
+                engine=op_engine,
+                priority=num_blobs - i,
+                **{'async': True})
+            net.Scale([blob], [blob + "_scaled"], scale=2.0)
+
+        workspace.CreateNet(net)
+        for _tmp in range(3):
+            for i in range(num_blobs):
+                workspace.FeedBlob(
+                    blobs[i],
+                    np.full(blob_size, (comm_rank * num_blobs) + i,
+                            np.float32))
+            workspace.RunNet(net.Name())
+            for i in range(num_blobs):
+                expected = comm_size * i + \
+                    num_blobs * comm_size * (comm_size - 1) / 2
+                np.testing.assert_array_equal(
+                    workspace.FetchBlob(blobs[i] + "_scaled"),
+                    2 * expected)
+
+    @given(comm_size=st.integers(min_value=2, max_value=8),
+           device_option=st.sampled_from([hu.cpu_do]))
+    def test_allreduce_async(self, comm_size, device_option):
+        TestCase.test_counter += 1
+        if os.getenv('COMM_RANK') is not None:
+            self.run_test_distributed(
+                self._test_allreduce_async,
+                device_option=device_option)
+        else:
+            with TemporaryDirectory() as tmpdir:
+                self.run_test_locally(
+                    self._test_allreduce_async,
+                    comm_size=comm_size,
+                    device_option=device_option,
+                    tmpdir=tmpdir)
+
     def _test_reduce_scatter(self,
                              comm_rank=None,
                              comm_size=None,
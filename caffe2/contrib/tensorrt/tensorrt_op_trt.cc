@@ -1,10 +1,12 @@
 #include "caffe2/contrib/tensorrt/tensorrt_op_trt.h"
 
+#include <algorithm>
 #include <numeric>
 #include <unordered_map>
 
 #include "caffe2/contrib/tensorrt/tensorrt_tranformer.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/core/timer.h"
 #include "onnx/onnx_pb.h"
 
 namespace caffe2 {
@@ -43,11 +45,16 @@ int64_t CheckDims(
 
 } // namespace
 
-// Upon construction, we build the inference engine by deserializing from
-// protobuf string. And since we know the input/output blobs, we can do the
+// Upon construction, we build the inference engines by deserializing from
+// protobuf string, or by building them from the onnx model for every batch
+// size bucket. And since we know the input/output blobs, we can do the
 // binding here too.
 TensorRTOp::TensorRTOp(const OperatorDef& operator_def, Workspace* ws)
     : Operator<CUDAContext>(operator_def, ws),
+      stats_(
+          "tensorrt/" +
+          (operator_def.name().empty() ? operator_def.type()
+                                       : operator_def.name())),
       logger_(
           (nvinfer1::ILogger::Severity)(OperatorBase::GetSingleArgument<int>(
               "log_verbosity",
@@ -55,14 +62,30 @@ TensorRTOp::TensorRTOp(const OperatorDef& operator_def, Workspace* ws)
       max_batch_size_(
           OperatorBase::GetSingleArgument<int>("max_batch_size", 1)) {
   {
+    auto batch_size_buckets =
+        OperatorBase::GetRepeatedArgument<int>("batch_size_buckets");
+    auto engine_strings =
+        OperatorBase::GetRepeatedArgument<std::string>("backend_buffers");
     auto engine_string =
         OperatorBase::GetSingleArgument<std::string>("backend_buffer", "");
     if (!engine_string.empty()) {
+      engine_strings = {engine_string};
+      batch_size_buckets = {max_batch_size_};
+    }
+    if (!engine_strings.empty()) {
+      CAFFE_ENFORCE_EQ(
+          engine_strings.size(),
+          batch_size_buckets.size(),
+          "backend_buffers should have an engine per batch size bucket");
       auto trt_runtime =
           tensorrt::TrtObject(nvinfer1::createInferRuntime(logger_));
-      // TODO(support trt plugin factory)
-      trt_engine_ = tensorrt::TrtObject(trt_runtime->deserializeCudaEngine(
-          engine_string.data(), engine_string.size(), nullptr));
+      for (int i = 0; i < engine_strings.size(); ++i) {
+        // TODO(support trt plugin factory)
+        AddEngine(
+            batch_size_buckets[i],
+            tensorrt::TrtObject(trt_runtime->deserializeCudaEngine(
+                engine_strings[i].data(), engine_strings[i].size(), nullptr)));
+      }
     } else {
       auto onnx_model_str =
           OperatorBase::GetSingleArgument<std::string>("onnx_model", "");
@@ -70,6 +93,9 @@ TensorRTOp::TensorRTOp(const OperatorDef& operator_def, Workspace* ws)
       auto debug_builder = OperatorBase::GetSingleArgument<int>("debug_builder", 0);
       auto max_workspace_size = OperatorBase::GetSingleArgument<int>(
           "max_workspace_size", 1024 * 1024 * 2);
+      const auto engine_cache_dir =
+          OperatorBase::GetSingleArgument<std::string>(
+              "engine_cache_dir", FLAGS_caffe2_tensorrt_engine_cache_dir);
 
       // Pull the weights from workspace and assembly it back to the onnx model,
       // notice that since we may have rewritten the net, we need to map the
@@ -91,24 +117,54 @@ TensorRTOp::TensorRTOp(const OperatorDef& operator_def, Workspace* ws)
       onnx_model_str.clear();
       onnx_model.SerializeToString(&onnx_model_str);
 
-      // Build the trt engine
-      trt_engine_ = tensorrt::BuildTrtEngine(
-          onnx_model_str,
-          &logger_,
-          max_batch_size_,
-          max_workspace_size,
-          debug_builder);
+      // Build the trt engines, or load them from the cache
+      if (batch_size_buckets.empty()) {
+        batch_size_buckets = {max_batch_size_};
+      }
+      for (const auto batch_size : batch_size_buckets) {
+        Timer timer;
+        bool cache_hit = false;
+        auto trt_engine = tensorrt::BuildOrLoadTrtEngine(
+            onnx_model_str,
+            &logger_,
+            batch_size,
+            max_workspace_size,
+            debug_builder,
+            engine_cache_dir,
+            &cache_hit);
+        if (cache_hit) {
+          CAFFE_EVENT(stats_, engine_cache_hits);
+        } else {
+          CAFFE_EVENT(stats_, engine_builds);
+          CAFFE_EVENT(stats_, engine_build_time_ns, timer.NanoSeconds());
+        }
+        AddEngine(batch_size, trt_engine);
+      }
     }
   }
 
-  CAFFE_ENFORCE(trt_engine_, "Cannot build TensorRT engine!");
+  CAFFE_ENFORCE(!engines_.empty(), "Cannot build TensorRT engine!");
+  std::sort(
+      engines_.begin(),
+      engines_.end(),
+      [](const Engine& a, const Engine& b) {
+        return a.max_batch_size < b.max_batch_size;
+      });
+  max_batch_size_ = engines_.back().max_batch_size;
 
-  // match and bind the input/output
-  const int num_bindings = trt_engine_->getNbBindings();
+  // match and bind the input/output, which are the same for every engine
+  const auto& trt_engine = engines_.front().engine;
+  const int num_bindings = trt_engine->getNbBindings();
+  for (const auto& engine : engines_) {
+    CAFFE_ENFORCE_EQ(
+        engine.engine->getNbBindings(),
+        num_bindings,
+        "Mismatched bindings between the TensorRT engines");
+  }
   int output_idx = 0;
   for (int b = 0; b < num_bindings; ++b) {
-    nv_dims_.push_back(trt_engine_->getBindingDimensions(b));
-    bool is_input = trt_engine_->bindingIsInput(b);
+    nv_dims_.push_back(trt_engine->getBindingDimensions(b));
+    bool is_input = trt_engine->bindingIsInput(b);
     is_input_.push_back(is_input);
     if (!is_input) {
       // For output, we try to get its output size hint
@@ -124,8 +180,24 @@ TensorRTOp::TensorRTOp(const OperatorDef& operator_def, Workspace* ws)
       ++output_idx;
     }
   }
+}
+
+void TensorRTOp::AddEngine(
+    int max_batch_size,
+    std::shared_ptr<nvinfer1::ICudaEngine> engine) {
+  CAFFE_ENFORCE(engine, "Cannot build TensorRT engine!");
+  CAFFE_ENFORCE_GT(max_batch_size, 0);
+  auto executor = tensorrt::TrtObject(engine->createExecutionContext());
+  engines_.push_back({max_batch_size, std::move(engine), std::move(executor)});
+}
 
-  trt_executor_ = tensorrt::TrtObject(trt_engine_->createExecutionContext());
+const TensorRTOp::Engine& TensorRTOp::GetEngine(size_t batch_size) const {
+  for (const auto& engine : engines_) {
+    if (engine.max_batch_size >= batch_size) {
+      return engine;
+    }
+  }
+  return engines_.back();
 }
 
 void TensorRTOp::MaybeAdjustOutputShape(
@@ -156,7 +228,6 @@ void TensorRTOp::MaybeAdjustOutputShape(
 }
 
 bool TensorRTOp::RunOnDevice() {
-  CAFFE_ENFORCE(trt_executor_);
   // Decide input batch size
   size_t N = 0;
   for (int i = 0; i < InputSize(); ++i) {
@@ -180,14 +251,17 @@ bool TensorRTOp::RunOnDevice() {
   // We need to do the binding at RunOnDevice time because we only know the
   // exact shapes of the tensors now. In addtion, since TensorRT engine has
   // max_batch_size, we need to call that multiple times if input batch size
-  // exceeeds this limit.
+  // exceeeds this limit, with the engine of the smallest batch size bucket
+  // fitting the rest of the batch.
   CAFFE_ENFORCE_EQ(is_input_.size(), nv_dims_.size());
+  CAFFE_EVENT(stats_, runs);
   std::vector<void*> bindings;
   bindings.reserve(is_input_.size());
-  auto batch_size = max_batch_size_;
+  size_t batch_size = 0;
   for (size_t offset = 0; offset < N; offset += batch_size) {
     bindings.clear();
-    batch_size = std::min<size_t>(N - offset, max_batch_size_);
+    const auto& engine = GetEngine(N - offset);
+    batch_size = std::min<size_t>(N - offset, engine.max_batch_size);
     VLOG(2) << "Offset: " << offset << ", batch_size: " << batch_size
             << ", N: " << N;
     int input_idx = 0;
@@ -223,9 +297,12 @@ bool TensorRTOp::RunOnDevice() {
     }
 
     CAFFE_ENFORCE_EQ(bindings.size(), InputSize() + OutputSize());
-    if (!trt_executor_->execute(batch_size, bindings.data())) {
+    Timer timer;
+    if (!engine.executor->execute(batch_size, bindings.data())) {
       CAFFE_THROW("Error running the TensorRT executor");
     }
+    CAFFE_EVENT(stats_, executions);
+    CAFFE_EVENT(stats_, execution_time_ns, timer.NanoSeconds());
   }
   return true;
 }
@@ -248,11 +325,25 @@ This is a GPU only operator.
         "(string default=\"\" blob for serialized TensorRT engine."
         "Note that serialized engine is not compatible across platform and "
         "different TensorRT version.")
+    .Arg(
+        "backend_buffers",
+        "(list of strings) serialized TensorRT engines of the batch size "
+        "buckets, instead of backend_buffer.")
     .Arg(
         "max_batch_size",
         "(int default 0) Batch size set by the TensorRT engine builder."
         "It must be no larger than the max_batch_size of the engine builder so "
-        "it is better not to edit this manually.");
+        "it is better not to edit this manually.")
+    .Arg(
+        "batch_size_buckets",
+        "(list of ints) max batch sizes of the engines built by the operator, "
+        "or of the engines of backend_buffers. Batches run with the engine of "
+        "the smallest bucket fitting them, and are split by the largest one.")
+    .Arg(
+        "engine_cache_dir",
+        "(string default=--caffe2_tensorrt_engine_cache_dir) directory where "
+        "the engines built from onnx_model are saved and loaded from, keyed by "
+        "the model, batch size, GPU model and TensorRT version.");
 
 REGISTER_CUDA_OPERATOR(TensorRT, TensorRTOp);
 } // namespace caffe2
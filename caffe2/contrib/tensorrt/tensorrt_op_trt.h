@@ -3,6 +3,7 @@
 #include "caffe2/contrib/tensorrt/trt_utils.h"
 #include "caffe2/core/context_gpu.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
 
 #include <NvInfer.h>
 #include <unordered_map>
@@ -17,15 +18,38 @@ class TensorRTOp final : public Operator<CUDAContext> {
   virtual ~TensorRTOp() noexcept {}
 
  private:
+  // An engine built for batches up to max_batch_size
+  struct Engine {
+    int max_batch_size;
+    std::shared_ptr<nvinfer1::ICudaEngine> engine;
+    std::shared_ptr<nvinfer1::IExecutionContext> executor;
+  };
+
+  void AddEngine(
+      int max_batch_size,
+      std::shared_ptr<nvinfer1::ICudaEngine> engine);
+  // The engine with the smallest batch size running the batch at once, or
+  // the largest one
+  const Engine& GetEngine(size_t batch_size) const;
   void MaybeAdjustOutputShape(int output_idx, std::vector<TIndex>* dims);
 
+  struct TensorRTOpStats {
+    CAFFE_STAT_CTOR(TensorRTOpStats);
+    CAFFE_EXPORTED_STAT(engine_builds);
+    CAFFE_EXPORTED_STAT(engine_build_time_ns);
+    CAFFE_EXPORTED_STAT(engine_cache_hits);
+    CAFFE_EXPORTED_STAT(runs);
+    CAFFE_EXPORTED_STAT(executions);
+    CAFFE_EXPORTED_STAT(execution_time_ns);
+  } stats_;
+
   tensorrt::TrtLogger logger_;
   int max_batch_size_;
   std::vector<nvinfer1::Dims> nv_dims_;
   std::vector<bool> is_input_;
   std::unordered_map<int, std::vector<TIndex>> output_size_hints_;
-  std::shared_ptr<nvinfer1::ICudaEngine> trt_engine_{nullptr};
-  std::shared_ptr<nvinfer1::IExecutionContext> trt_executor_{nullptr};
+  // Sorted by batch size
+  std::vector<Engine> engines_;
   bool batch_warning_issued_{false};
 };
 
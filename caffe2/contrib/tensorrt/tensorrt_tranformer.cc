@@ -178,6 +178,14 @@ void TensorRTTransformer::AddTrtOptions(
   max_batch_size_arg->set_name("max_batch_size");
   max_batch_size_arg->set_i(max_batch_size_);
 
+  if (!batch_size_buckets_.empty()) {
+    auto* batch_size_buckets_arg = op->add_arg();
+    batch_size_buckets_arg->set_name("batch_size_buckets");
+    for (const auto b : batch_size_buckets_) {
+      batch_size_buckets_arg->add_ints(b);
+    }
+  }
+
   auto* verbosity_arg = op->add_arg();
   verbosity_arg->set_name("log_verbosity");
   verbosity_arg->set_i(verbosity_);
@@ -245,15 +253,26 @@ OperatorDef TensorRTTransformer::BuildTrtOp(
   OperatorDef op;
   op.set_type("TensorRT");
 
+  // Build an engine per batch size bucket, reusing the ones cached in
+  // --caffe2_tensorrt_engine_cache_dir
   tensorrt::TrtLogger logger;
-  auto trt_engine = tensorrt::BuildTrtEngine(
-      onnx_model_str,
-      &logger,
-      max_batch_size_,
-      max_workspace_size_,
-      debug_builder_);
+  std::vector<std::shared_ptr<nvinfer1::ICudaEngine>> trt_engines;
+  const auto batch_size_buckets = batch_size_buckets_.empty()
+      ? std::vector<int>{static_cast<int>(max_batch_size_)}
+      : batch_size_buckets_;
+  for (const auto batch_size : batch_size_buckets) {
+    trt_engines.push_back(tensorrt::BuildOrLoadTrtEngine(
+        onnx_model_str,
+        &logger,
+        batch_size,
+        max_workspace_size_,
+        debug_builder_,
+        FLAGS_caffe2_tensorrt_engine_cache_dir));
+    CAFFE_ENFORCE(trt_engines.back(), "Cannot build TensorRT engine!");
+  }
 
   // Set up inputs/outputs in the order of they appearnce in getNbBindings
+  const auto& trt_engine = trt_engines.front();
   int num_bindings = trt_engine->getNbBindings();
   for (int b = 0; b < num_bindings; ++b) {
     const auto& name = trt_engine->getBindingName(b);
@@ -264,12 +283,20 @@ OperatorDef TensorRTTransformer::BuildTrtOp(
     }
   }
 
-  auto engine_plan = tensorrt::TrtObject(trt_engine->serialize());
   auto* serialized_engine_arg = op.add_arg();
-  serialized_engine_arg->set_s("");
-  serialized_engine_arg->set_name("backend_buffer");
-  auto* s = serialized_engine_arg->mutable_s();
-  s->assign((char*)engine_plan->data(), engine_plan->size());
+  serialized_engine_arg->set_name(
+      batch_size_buckets_.empty() ? "backend_buffer" : "backend_buffers");
+  for (const auto& engine : trt_engines) {
+    auto engine_plan = tensorrt::TrtObject(engine->serialize());
+    std::string* s = nullptr;
+    if (batch_size_buckets_.empty()) {
+      serialized_engine_arg->set_s("");
+      s = serialized_engine_arg->mutable_s();
+    } else {
+      s = serialized_engine_arg->add_strings();
+    }
+    s->assign((char*)engine_plan->data(), engine_plan->size());
+  }
 
   AddTrtOptions(&op, output_size_hints);
 
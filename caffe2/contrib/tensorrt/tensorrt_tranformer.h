@@ -26,9 +26,11 @@ class TensorRTTransformer {
       size_t max_workspace_size,
       int verbosity,
       bool debug_builder,
-      bool build_serializable_op = false)
+      bool build_serializable_op = false,
+      const std::vector<int>& batch_size_buckets = {})
       : build_serializable_op_(build_serializable_op),
         max_batch_size_(max_batch_size),
+        batch_size_buckets_(batch_size_buckets),
         max_workspace_size_(max_workspace_size),
         verbosity_(verbosity),
         debug_builder_(debug_builder) {}
@@ -85,6 +87,8 @@ class TensorRTTransformer {
 
   // TensorRT params
   size_t max_batch_size_{50};
+  // Max batch sizes of the engines of the trt ops, max_batch_size_ if empty
+  std::vector<int> batch_size_buckets_;
   size_t max_workspace_size_{1024 * 1024 * 2};
   int verbosity_{2};
   bool debug_builder_{false};
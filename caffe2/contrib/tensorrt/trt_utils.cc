@@ -1,9 +1,68 @@
 #include "caffe2/contrib/tensorrt/trt_utils.h"
 
 #include <NvOnnxParser.h>
+#include <unistd.h>
+
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+#include "caffe2/core/common_gpu.h"
+
+CAFFE2_DEFINE_string(
+    caffe2_tensorrt_engine_cache_dir,
+    "",
+    "Directory where the TensorRT operators save the engines that they build, "
+    "and load them from instead of building them again. Disabled if empty.");
 
 namespace caffe2 {
 namespace tensorrt {
+namespace {
+
+// FNV-1a, which unlike std::hash is the same for every build
+uint64_t HashString(const std::string& s) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const unsigned char c : s) {
+    hash = (hash ^ c) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+bool ReadFile(const std::string& path, std::string* content) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::ostringstream stream;
+  stream << file.rdbuf();
+  *content = stream.str();
+  return file.good() || file.eof();
+}
+
+// Writes a temporary file that is renamed, so that processes loading the
+// engine at the same time never read a partial one
+void WriteFile(const std::string& path, const void* data, size_t size) {
+  const auto tmp_path = MakeString(path, ".tmp", getpid());
+  {
+    std::ofstream file(tmp_path, std::ios::binary);
+    file.write(static_cast<const char*>(data), size);
+    if (!file) {
+      LOG(WARNING) << "Failed to write TensorRT engine " << tmp_path;
+      std::remove(tmp_path.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Failed to save TensorRT engine " << path;
+    std::remove(tmp_path.c_str());
+  }
+}
+
+} // namespace
 std::shared_ptr<nvinfer1::ICudaEngine> BuildTrtEngine(
     const std::string& onnx_model_str,
     TrtLogger* logger,
@@ -40,5 +99,87 @@ std::shared_ptr<nvinfer1::ICudaEngine> BuildTrtEngine(
   trt_builder->setDebugSync(debug_builder);
   return TrtObject(trt_builder->buildCudaEngine(*trt_network.get()));
 }
+
+std::string GetTrtEngineCacheKey(
+    const std::string& onnx_model_str,
+    size_t max_batch_size,
+    size_t max_workspace_size) {
+  const auto& prop = GetDeviceProperty(CaffeCudaGetDevice());
+  std::string gpu(prop.name);
+  for (auto& c : gpu) {
+    if (!std::isalnum(static_cast<unsigned char>(c))) {
+      c = '_';
+    }
+  }
+  std::ostringstream key;
+  key << std::hex << std::setw(16) << std::setfill('0')
+      << HashString(onnx_model_str) << std::dec << "_b" << max_batch_size
+      << "_w" << max_workspace_size << "_" << gpu << "_sm" << prop.major
+      << prop.minor << "_trt" << getInferLibVersion();
+  return key.str();
+}
+
+std::shared_ptr<nvinfer1::ICudaEngine> BuildOrLoadTrtEngine(
+    const std::string& onnx_model_str,
+    TrtLogger* logger,
+    size_t max_batch_size,
+    size_t max_workspace_size,
+    bool debug_builder,
+    const std::string& cache_dir,
+    bool* cache_hit) {
+  // Engines can be shared by the execution contexts of several operators, on
+  // the GPU that they were built for
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<nvinfer1::ICudaEngine>>
+      engines;
+  const auto key =
+      GetTrtEngineCacheKey(onnx_model_str, max_batch_size, max_workspace_size);
+  const auto process_key = MakeString(key, "_gpu", CaffeCudaGetDevice());
+  // Also keeps operators from building the same engine at the same time
+  std::lock_guard<std::mutex> lock(mutex);
+  auto engine = engines[process_key].lock();
+  if (cache_hit) {
+    *cache_hit = true;
+  }
+  if (engine) {
+    return engine;
+  }
+
+  const auto path = cache_dir.empty() ? "" : cache_dir + "/" + key + ".engine";
+  std::string plan;
+  if (!path.empty() && ReadFile(path, &plan)) {
+    auto trt_runtime = TrtObject(nvinfer1::createInferRuntime(*logger));
+    auto* deserialized_engine =
+        trt_runtime->deserializeCudaEngine(plan.data(), plan.size(), nullptr);
+    if (deserialized_engine) {
+      VLOG(1) << "Loaded TensorRT engine " << path;
+      engine = TrtObject(deserialized_engine);
+    } else {
+      LOG(WARNING) << "Failed to load TensorRT engine " << path
+                   << ", building it again";
+    }
+  }
+  if (!engine) {
+    if (cache_hit) {
+      *cache_hit = false;
+    }
+    engine = BuildTrtEngine(
+        onnx_model_str,
+        logger,
+        max_batch_size,
+        max_workspace_size,
+        debug_builder);
+    if (!engine) {
+      return engine;
+    }
+    if (!path.empty()) {
+      auto engine_plan = TrtObject(engine->serialize());
+      WriteFile(path, engine_plan->data(), engine_plan->size());
+    }
+  }
+  engines[process_key] = engine;
+  return engine;
+}
+
 } // namespace tensorrt
 } // namespace caffe2
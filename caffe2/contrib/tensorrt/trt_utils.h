@@ -3,8 +3,11 @@
 #include <iostream>
 #include <NvInfer.h>
 
+#include "caffe2/core/flags.h"
 #include "caffe2/core/logging.h"
 
+CAFFE2_DECLARE_string(caffe2_tensorrt_engine_cache_dir);
+
 namespace caffe2 { namespace tensorrt {
 
   // Logger for GIE info/warning/errors
@@ -50,6 +53,28 @@ std::shared_ptr<nvinfer1::ICudaEngine> BuildTrtEngine(
     size_t max_batch_size,
     size_t max_workspace_size,
     bool debug_builder);
+
+// Key of the engine built from the model with the batch and workspace sizes
+// on the current GPU. Serialized engines only run on the GPU model and with
+// the TensorRT version that built them, so the key has both besides a hash
+// of the model, which holds the weights.
+std::string GetTrtEngineCacheKey(
+    const std::string& onnx_model_str,
+    size_t max_batch_size,
+    size_t max_workspace_size);
+
+// BuildTrtEngine, which first looks for the engine in the engines built by
+// the process on the current GPU, loads it from cache_dir if not empty, where
+// it's saved once built otherwise. Building a large engine takes minutes.
+// Sets cache_hit, if not null, when the engine didn't need to be built.
+std::shared_ptr<nvinfer1::ICudaEngine> BuildOrLoadTrtEngine(
+    const std::string& onnx_model_str,
+    TrtLogger* logger,
+    size_t max_batch_size,
+    size_t max_workspace_size,
+    bool debug_builder,
+    const std::string& cache_dir,
+    bool* cache_hit = nullptr);
 }
 }
 
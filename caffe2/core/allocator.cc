@@ -1,5 +1,6 @@
 #include "caffe2/core/context.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/core/stats.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/core/typeid.h"
 
@@ -13,10 +14,62 @@ CAFFE2_DEFINE_bool(
     true,
     "If set, do memory zerofilling when allocating on CPU");
 
+CAFFE2_DEFINE_string(
+    caffe2_cpu_allocator_numa_policy,
+    "cpu",
+    "Where the CPU allocator places memory when NUMA is enabled. 'cpu': on "
+    "the node of the CPU the allocating thread runs on; 'thread': on the "
+    "node requested by the operator's DeviceOption.numa_node_id, else on "
+    "the node the allocating pool thread is bound to, else as 'cpu'");
+
 namespace caffe2 {
 
 void NoDelete(void*) {}
 
+namespace {
+struct NUMAAllocatorStats {
+  CAFFE_STAT_CTOR(NUMAAllocatorStats);
+  CAFFE_EXPORTED_STAT(placed_allocations);
+  CAFFE_EXPORTED_STAT(cross_node_allocations);
+  CAFFE_EXPORTED_STAT(cross_node_bytes);
+};
+
+bool UseThreadNUMAPolicy() {
+  static const bool use_thread = [] {
+    const auto& policy = FLAGS_caffe2_cpu_allocator_numa_policy;
+    CAFFE_ENFORCE(
+        policy == "cpu" || policy == "thread",
+        "Unknown --caffe2_cpu_allocator_numa_policy: ",
+        policy);
+    return policy == "thread";
+  }();
+  return use_thread;
+}
+} // namespace
+
+void PlaceOnNUMANode(void* data, size_t nbytes) {
+  if (!IsNUMAEnabled()) {
+    return;
+  }
+  static NUMAAllocatorStats stats("cpu_allocator_numa");
+
+  // The thread's home node: where it was pinned, or where it runs now.
+  int home_node = GetThreadNUMANode();
+  if (home_node < 0) {
+    home_node = GetCurrentNUMANode();
+  }
+  int node = home_node;
+  if (UseThreadNUMAPolicy() && GetNUMAAllocationNode() >= 0) {
+    node = GetNUMAAllocationNode();
+  }
+  NUMAMove(data, nbytes, node);
+  CAFFE_EVENT(stats, placed_allocations);
+  if (node != home_node) {
+    CAFFE_EVENT(stats, cross_node_allocations);
+    CAFFE_EVENT(stats, cross_node_bytes, nbytes);
+  }
+}
+
 static std::unique_ptr<CPUAllocator> g_cpu_allocator(new DefaultCPUAllocator());
 CPUAllocator* GetCPUAllocator() {
   return g_cpu_allocator.get();
@@ -8,6 +8,7 @@
 
 CAFFE2_DECLARE_bool(caffe2_report_cpu_memory_usage);
 CAFFE2_DECLARE_bool(caffe2_cpu_allocator_do_zero_fill);
+CAFFE2_DECLARE_string(caffe2_cpu_allocator_numa_policy);
 
 namespace caffe2 {
 
@@ -19,6 +20,12 @@ using MemoryDeleter = void (*)(void*);
 // A helper function that is basically doing nothing.
 void NoDelete(void*);
 
+// Moves freshly allocated CPU memory to the NUMA node chosen by
+// --caffe2_cpu_allocator_numa_policy, and counts allocations that end up
+// on a node other than the allocating thread's own. No-op unless NUMA is
+// enabled.
+void PlaceOnNUMANode(void* data, size_t nbytes);
+
 // A virtual allocator class to do memory allocation and deallocation.
 struct CPUAllocator {
   CPUAllocator() {}
@@ -54,8 +61,7 @@ struct DefaultCPUAllocator final : CPUAllocator {
     CAFFE_ENFORCE_EQ(posix_memalign(&data, gCaffe2Alignment, nbytes), 0);
 #endif
     CAFFE_ENFORCE(data);
-    // move data to a thread's NUMA node
-    NUMAMove(data, nbytes, GetCurrentNUMANode());
+    PlaceOnNUMANode(data, nbytes);
     if (FLAGS_caffe2_cpu_allocator_do_zero_fill) {
       memset(data, 0, nbytes);
     }
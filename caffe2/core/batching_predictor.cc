@@ -0,0 +1,248 @@
+#include "caffe2/core/batching_predictor.h"
+
+#include <stdexcept>
+
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+
+namespace {
+const char kSplitLengths[] = "batch_split_lengths";
+const char kConcatOutput[] = "batch_concat_output";
+const char kConcatSplitInfo[] = "batch_concat_split_info";
+const char kSplitInput[] = "batch_split_input";
+
+std::string concatInput(size_t i) {
+  return "batch_concat_input_" + caffe2::to_string(i);
+}
+
+std::string splitOutput(size_t i) {
+  return "batch_split_output_" + caffe2::to_string(i);
+}
+} // namespace
+
+BatchingPredictor::BatchingPredictor(
+    Predictor* predictor,
+    const Options& options)
+    : predictor_(predictor), options_(options), stats_(options.stats_name) {
+  CAFFE_ENFORCE(predictor_);
+  CAFFE_ENFORCE_GT(options_.max_batch_size, 0);
+  thread_ = std::thread([this]() { mainLoop(); });
+}
+
+BatchingPredictor::~BatchingPredictor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  cv_.notify_all();
+  thread_.join();
+  for (auto& request : queue_) {
+    request.outputs.set_exception(std::make_exception_ptr(
+        std::runtime_error("BatchingPredictor destroyed")));
+  }
+}
+
+std::future<BatchingPredictor::OutputMap> BatchingPredictor::run(
+    const TensorMap& inputs) {
+  CAFFE_ENFORCE(!inputs.empty(), "A request needs at least one input");
+  Request request;
+  request.rows = -1;
+  for (const auto& input : inputs) {
+    CAFFE_ENFORCE(input.second, "Null tensor for input ", input.first);
+    CAFFE_ENFORCE_GT(
+        input.second->ndim(), 0, "Input ", input.first, " has no batch dim");
+    if (request.rows < 0) {
+      request.rows = input.second->dim(0);
+    }
+    CAFFE_ENFORCE_EQ(
+        input.second->dim(0),
+        request.rows,
+        "All inputs of a request need the same first dimension");
+  }
+  request.inputs = inputs;
+  request.enqueued = std::chrono::steady_clock::now();
+  auto future = request.outputs.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CAFFE_ENFORCE(running_, "BatchingPredictor is shutting down");
+    queued_rows_ += request.rows;
+    queue_.push_back(std::move(request));
+  }
+  cv_.notify_one();
+  CAFFE_EVENT(stats_, requests);
+  return future;
+}
+
+bool BatchingPredictor::compatible(const Request& a, const Request& b) {
+  if (a.inputs.size() != b.inputs.size()) {
+    return false;
+  }
+  for (const auto& input : a.inputs) {
+    auto it = b.inputs.find(input.first);
+    if (it == b.inputs.end()) {
+      return false;
+    }
+    const auto& x = *input.second;
+    const auto& y = *it->second;
+    if (x.meta() != y.meta() || x.ndim() != y.ndim() ||
+        !std::equal(x.dims().begin() + 1, x.dims().end(), y.dims().begin() + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void BatchingPredictor::mainLoop() {
+  std::vector<Request> batch;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return !running_ || !queue_.empty(); });
+      if (!running_) {
+        return;
+      }
+      // Wait for a full batch, but no longer than the oldest request may.
+      const auto deadline = queue_.front().enqueued + options_.max_latency;
+      cv_.wait_until(lock, deadline, [this]() {
+        return !running_ || queued_rows_ >= options_.max_batch_size;
+      });
+      if (!running_) {
+        return;
+      }
+      TIndex rows = 0;
+      while (!queue_.empty() &&
+             (batch.empty() ||
+              (rows + queue_.front().rows <= options_.max_batch_size &&
+               compatible(batch.front(), queue_.front())))) {
+        rows += queue_.front().rows;
+        batch.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+      queued_rows_ -= rows;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    TIndex rows = 0;
+    for (const auto& request : batch) {
+      CAFFE_EVENT(
+          stats_,
+          queue_delay_us,
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              now - request.enqueued)
+              .count());
+      rows += request.rows;
+    }
+    CAFFE_EVENT(stats_, batches);
+    CAFFE_EVENT(stats_, batch_size, rows);
+    try {
+      runBatch(batch);
+    } catch (...) {
+      CAFFE_EVENT(stats_, failed_batches);
+      auto error = std::current_exception();
+      for (auto& request : batch) {
+        request.outputs.set_exception(error);
+      }
+    }
+    batch.clear();
+  }
+}
+
+OperatorBase* BatchingPredictor::concatOp(size_t n) {
+  auto& op = concat_ops_[n];
+  if (!op) {
+    OperatorDef def;
+    def.set_type("Concat");
+    for (size_t i = 0; i < n; ++i) {
+      def.add_input(concatInput(i));
+      ws_.CreateBlob(concatInput(i));
+    }
+    def.add_output(kConcatOutput);
+    def.add_output(kConcatSplitInfo);
+    def.add_arg()->CopyFrom(MakeArgument<int>("axis", 0));
+    op = CreateOperator(def, &ws_);
+  }
+  return op.get();
+}
+
+OperatorBase* BatchingPredictor::splitOp(size_t n) {
+  auto& op = split_ops_[n];
+  if (!op) {
+    OperatorDef def;
+    def.set_type("Split");
+    def.add_input(kSplitInput);
+    def.add_input(kSplitLengths);
+    ws_.CreateBlob(kSplitInput);
+    ws_.CreateBlob(kSplitLengths);
+    for (size_t i = 0; i < n; ++i) {
+      def.add_output(splitOutput(i));
+    }
+    def.add_arg()->CopyFrom(MakeArgument<int>("axis", 0));
+    op = CreateOperator(def, &ws_);
+  }
+  return op.get();
+}
+
+void BatchingPredictor::runBatch(std::vector<Request>& batch) {
+  const size_t n = batch.size();
+
+  // Concatenate every input across the batch. A single request runs as is.
+  std::unordered_map<std::string, TensorCPU> concatenated;
+  TensorMap inputs;
+  for (const auto& input : batch.front().inputs) {
+    if (n == 1) {
+      inputs[input.first] = input.second;
+      continue;
+    }
+    auto* op = concatOp(n);
+    for (size_t i = 0; i < n; ++i) {
+      auto* part = ws_.GetBlob(concatInput(i))->GetMutable<TensorCPU>();
+      const auto* source = batch[i].inputs.at(input.first);
+      part->ResizeLike(*source);
+      part->ShareData(*source);
+    }
+    CAFFE_ENFORCE(op->Run(), "Concat failed for input ", input.first);
+    for (size_t i = 0; i < n; ++i) {
+      ws_.GetBlob(concatInput(i))->GetMutable<TensorCPU>()->FreeMemory();
+    }
+    auto& batched = concatenated[input.first];
+    batched.swap(*ws_.GetBlob(kConcatOutput)->GetMutable<TensorCPU>());
+    inputs[input.first] = &batched;
+  }
+
+  Predictor::TensorVector outputs;
+  CAFFE_ENFORCE(predictor_->run_map(inputs, &outputs), "Predictor run failed");
+
+  // Split every output back into the requests.
+  std::vector<OutputMap> results(n);
+  auto* lengths = ws_.CreateBlob(kSplitLengths)->GetMutable<TensorCPU>();
+  lengths->Resize(n);
+  int* lengths_data = lengths->mutable_data<int>();
+  for (size_t i = 0; i < n; ++i) {
+    lengths_data[i] = batch[i].rows;
+  }
+  const auto& names = predictor_->def().external_output();
+  for (size_t j = 0; j < outputs.size(); ++j) {
+    const auto* output = outputs[j];
+    if (n == 1) {
+      results[0][names.Get(j)].CopyFrom(*output);
+      continue;
+    }
+    auto* op = splitOp(n);
+    auto* source = ws_.GetBlob(kSplitInput)->GetMutable<TensorCPU>();
+    source->ResizeLike(*output);
+    source->ShareData(*output);
+    CAFFE_ENFORCE(op->Run(), "Split failed for output ", names.Get(j));
+    source->FreeMemory();
+    for (size_t i = 0; i < n; ++i) {
+      results[i][names.Get(j)].swap(
+          *ws_.GetBlob(splitOutput(i))->GetMutable<TensorCPU>());
+    }
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    batch[i].outputs.set_value(std::move(results[i]));
+  }
+}
+
+} // namespace caffe2
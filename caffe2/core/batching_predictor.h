@@ -0,0 +1,107 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/predictor.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+// Dynamic batching front end for a Predictor.
+//
+// Requests arrive one at a time, each mapping the run net's inputs to
+// tensors whose first dimension is the request's number of examples. A
+// background thread collects queued requests until either max_batch_size
+// examples are waiting or the oldest request has waited max_latency,
+// concatenates them along the first dimension, runs the predictor once, and
+// splits every output back along the first dimension into the futures of
+// the requests. Concatenation and splitting go through the Concat and Split
+// operators.
+//
+// Only requests with the same inputs, types and non-batch dimensions are
+// batched together; a request that does not match the one at the head of
+// the queue waits for the next batch. Tensors passed to run() must stay
+// alive until its future is ready.
+//
+// The time requests spend queued and the batch sizes are exported as stats
+// (see stats.h) under options.stats_name.
+class BatchingPredictor {
+ public:
+  using TensorMap = Predictor::TensorMap;
+  using OutputMap = std::unordered_map<std::string, TensorCPU>;
+
+  struct Options {
+    // Largest batch, in examples. A single request larger than this still
+    // runs, on its own.
+    int max_batch_size = 32;
+    // Longest a request waits for others to batch with.
+    std::chrono::microseconds max_latency{1000};
+    std::string stats_name = "batching_predictor";
+  };
+
+  // predictor must outlive this object and not be run by anyone else.
+  BatchingPredictor(Predictor* predictor, const Options& options);
+  explicit BatchingPredictor(Predictor* predictor)
+      : BatchingPredictor(predictor, Options()) {}
+
+  // Fails the requests still queued.
+  ~BatchingPredictor();
+
+  // Enqueues one request. The future holds the outputs of the run net,
+  // keyed by name, or the exception that made its batch fail.
+  std::future<OutputMap> run(const TensorMap& inputs);
+
+ private:
+  struct Request {
+    TensorMap inputs;
+    TIndex rows;
+    std::chrono::steady_clock::time_point enqueued;
+    std::promise<OutputMap> outputs;
+  };
+
+  static bool compatible(const Request& a, const Request& b);
+  void mainLoop();
+  void runBatch(std::vector<Request>& batch);
+  OperatorBase* concatOp(size_t n);
+  OperatorBase* splitOp(size_t n);
+
+  Predictor* predictor_;
+  const Options options_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Request> queue_;
+  TIndex queued_rows_ = 0;
+  bool running_ = true;
+
+  // Scratch workspace and cached Concat / Split operators, by arity; only
+  // touched by the batching thread.
+  Workspace ws_;
+  std::unordered_map<size_t, unique_ptr<OperatorBase>> concat_ops_;
+  std::unordered_map<size_t, unique_ptr<OperatorBase>> split_ops_;
+
+  struct BatchingPredictorStats {
+    CAFFE_STAT_CTOR(BatchingPredictorStats);
+    CAFFE_EXPORTED_STAT(requests);
+    CAFFE_EXPORTED_STAT(batches);
+    CAFFE_EXPORTED_STAT(failed_batches);
+    CAFFE_AVG_EXPORTED_STAT(batch_size);
+    CAFFE_AVG_EXPORTED_STAT(queue_delay_us);
+  } stats_;
+
+  std::thread thread_;
+
+  DISABLE_COPY_AND_ASSIGN(BatchingPredictor);
+};
+
+} // namespace caffe2
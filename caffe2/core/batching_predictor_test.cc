@@ -0,0 +1,139 @@
+#include <algorithm>
+#include <vector>
+
+#include "caffe2/core/batching_predictor.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+const char* predictSpec = R"DOC(
+        name: "predict"
+        type: "simple"
+        external_input: "data"
+        external_input: "W"
+        external_input: "b"
+        external_output: "y"
+        op {
+          input: "data"
+          input: "W"
+          input: "b"
+          output: "y"
+          type: "FC"
+        }
+)DOC";
+
+const char* initSpec = R"DOC(
+        name: "init"
+        type: "simple"
+        op {
+          type: "ConstantFill"
+          output: "W"
+          arg {
+            name: "shape"
+            ints: 10
+            ints: 4
+          }
+          arg {
+            name: "value"
+            f: 2.0
+          }
+        }
+        op {
+          type: "ConstantFill"
+          output: "b"
+          arg {
+            name: "shape"
+            ints: 10
+          }
+          arg {
+            name: "value"
+            f: 1.0
+          }
+        }
+)DOC";
+
+NetDef parseNetDef(const std::string& value) {
+  NetDef def;
+  CAFFE_ENFORCE(
+      TextFormat::ParseFromString(value, &def),
+      "Failed to parse NetDef with value: ",
+      value);
+  return def;
+}
+
+std::unique_ptr<TensorCPU> makeInput(int rows, float x) {
+  auto tensor = make_unique<TensorCPU>(std::vector<TIndex>{rows, 4});
+  std::fill(
+      tensor->mutable_data<float>(), tensor->mutable_data<float>() + rows * 4, x);
+  return tensor;
+}
+
+// y = 2 * sum(data) + 1 = 8x + 1 for every output.
+void checkOutput(const BatchingPredictor::OutputMap& outputs, int rows, float x) {
+  ASSERT_EQ(outputs.count("y"), 1);
+  const auto& y = outputs.at("y");
+  ASSERT_EQ(y.ndim(), 2);
+  EXPECT_EQ(y.dim(0), rows);
+  EXPECT_EQ(y.dim(1), 10);
+  for (int i = 0; i < y.size(); ++i) {
+    EXPECT_EQ(y.data<float>()[i], 8 * x + 1);
+  }
+}
+
+} // namespace
+
+TEST(BatchingPredictorTest, BatchesAndScatters) {
+  Predictor predictor(parseNetDef(initSpec), parseNetDef(predictSpec));
+  BatchingPredictor::Options options;
+  options.max_batch_size = 8;
+  options.max_latency = std::chrono::seconds(10);
+  options.stats_name = "batching_predictor_test";
+  BatchingPredictor batching(&predictor, options);
+
+  // Four requests of two rows make exactly one full batch.
+  std::vector<std::unique_ptr<TensorCPU>> inputs;
+  std::vector<std::future<BatchingPredictor::OutputMap>> futures;
+  for (int i = 0; i < 4; ++i) {
+    inputs.push_back(makeInput(2, i));
+    futures.push_back(batching.run({{"data", inputs.back().get()}}));
+  }
+  for (int i = 0; i < 4; ++i) {
+    checkOutput(futures[i].get(), 2, i);
+  }
+
+  auto stats = toMap(StatRegistry::get().publish());
+  EXPECT_EQ(stats["batching_predictor_test/batches"], 1);
+  EXPECT_EQ(stats["batching_predictor_test/requests"], 4);
+}
+
+TEST(BatchingPredictorTest, DeadlineFlushesPartialBatch) {
+  Predictor predictor(parseNetDef(initSpec), parseNetDef(predictSpec));
+  BatchingPredictor::Options options;
+  options.max_batch_size = 64;
+  options.max_latency = std::chrono::milliseconds(1);
+  BatchingPredictor batching(&predictor, options);
+  auto input = makeInput(3, 0.5);
+  auto future = batching.run({{"data", input.get()}});
+  checkOutput(future.get(), 3, 0.5);
+}
+
+TEST(BatchingPredictorTest, IncompatibleRequestsRunSeparately) {
+  Predictor predictor(parseNetDef(initSpec), parseNetDef(predictSpec));
+  BatchingPredictor::Options options;
+  options.max_batch_size = 4;
+  options.max_latency = std::chrono::milliseconds(5);
+  BatchingPredictor batching(&predictor, options);
+  auto good = makeInput(1, 1);
+  TensorCPU bad(std::vector<TIndex>{1, 3});
+  bad.mutable_data<float>();
+  auto bad_future = batching.run({{"data", &bad}});
+  auto good_future = batching.run({{"data", good.get()}});
+  EXPECT_ANY_THROW(bad_future.get());
+  checkOutput(good_future.get(), 1, 1);
+}
+
+} // namespace caffe2
@@ -21,6 +21,13 @@ CAFFE2_DEFINE_bool(
     false,
     "Serialize FLOAT16 tensors using byte_data field");
 
+CAFFE2_DEFINE_bool(
+    caffe2_serialize_tensors_as_bytes,
+    false,
+    "Serialize the tensors of fixed-size types as their raw bytes in the "
+    "byte_data field, which is faster to encode and decode than the repeated "
+    "fields");
+
 namespace caffe2 {
 /**
  * @brief StringSerializer is the serializer for String.
@@ -16,6 +16,7 @@
 CAFFE2_DECLARE_int(caffe2_tensor_chunk_size);
 CAFFE2_DECLARE_int(caffe2_max_tensor_serializer_threads);
 CAFFE2_DECLARE_bool(caffe2_serialize_fp16_as_bytes);
+CAFFE2_DECLARE_bool(caffe2_serialize_tensors_as_bytes);
 
 namespace caffe2 {
 
@@ -103,6 +104,12 @@ class TensorDeserializer : public BlobDeserializerBase {
  public:
   void Deserialize(const BlobProto& proto, Blob* blob) override;
   void Deserialize(const TensorProto& proto, Tensor<Context>* tensor);
+
+  // Copies the data of the chunk of proto into tensor, which must already
+  // have the dims of proto. Only the data of the chunk is written once the
+  // tensor has the type of proto, so that the chunks of a tensor can be
+  // deserialized concurrently.
+  void DeserializeChunk(const TensorProto& proto, Tensor<Context>* tensor);
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -110,6 +117,58 @@ class TensorDeserializer : public BlobDeserializerBase {
 ////////////////////////////////////////////////////////////////////////////////
 
 namespace detail {
+// The data of the tensors of fixed-size types can be stored as its raw bytes
+// in byte_data, which is encoded and decoded with a single copy.
+inline bool CanSerializeAsBytes(TensorProto::DataType data_type) {
+  switch (data_type) {
+    case TensorProto_DataType_FLOAT:
+    case TensorProto_DataType_INT32:
+    case TensorProto_DataType_BOOL:
+    case TensorProto_DataType_UINT8:
+    case TensorProto_DataType_INT8:
+    case TensorProto_DataType_UINT16:
+    case TensorProto_DataType_INT16:
+    case TensorProto_DataType_INT64:
+    case TensorProto_DataType_FLOAT16:
+    case TensorProto_DataType_DOUBLE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+inline void EnforceLittleEndian() {
+  const int kValue = 1;
+  CAFFE_ENFORCE_EQ(
+      reinterpret_cast<const char*>(&kValue)[0],
+      1,
+      "Serialization of tensors as bytes on big endian platform "
+      "is not written yet.");
+}
+
+template <class Context>
+inline void CopyToProtoAsBytes(
+    const size_t nbytes,
+    const void* src,
+    string* field,
+    Context* context) {
+  EnforceLittleEndian();
+  field->resize(nbytes);
+  context->template CopyBytes<Context, CPUContext>(nbytes, src, &(*field)[0]);
+  context->FinishDeviceComputation();
+}
+
+template <class Context>
+inline void CopyFromProtoAsBytes(
+    const size_t nbytes,
+    const string& field,
+    void* dst,
+    Context* context) {
+  EnforceLittleEndian();
+  CAFFE_ENFORCE_EQ(nbytes, field.size(), "Incorrect proto field size.");
+  context->template CopyBytes<CPUContext, Context>(nbytes, field.data(), dst);
+}
+
 template <typename SrcType, typename DstType, class Context>
 inline void CopyToProtoAsIs(
     const size_t size,
@@ -297,6 +356,19 @@ void TensorSerializer<Context>::Serialize(
   proto.set_data_type(data_type);
   StoreDeviceDetail(input, &proto);
 
+  if (detail::CanSerializeAsBytes(data_type) &&
+      (FLAGS_caffe2_serialize_tensors_as_bytes ||
+       (data_type == TensorProto_DataType_FLOAT16 &&
+        FLAGS_caffe2_serialize_fp16_as_bytes))) {
+    detail::CopyToProtoAsBytes(
+        chunkSize * input.itemsize(),
+        static_cast<const char*>(input.raw_data()) +
+            chunkBegin * input.itemsize(),
+        proto.mutable_byte_data(),
+        &this->context_);
+    return;
+  }
+
   // A lot of copypaste is error prone. Should we create a macro for this?
   switch (data_type) {
   case TensorProto_DataType_FLOAT:
@@ -368,31 +440,14 @@ void TensorSerializer<Context>::Serialize(
         proto.mutable_int64_data(),
         &this->context_);
     break;
-  case TensorProto_DataType_FLOAT16: {
-    if (FLAGS_caffe2_serialize_fp16_as_bytes) {
-      const int kValue = 1;
-      CAFFE_ENFORCE_EQ(
-          reinterpret_cast<const char*>(&kValue)[0],
-          1,
-          "Serialization of FLOAT16 on big endian platform "
-          "is not written yet.");
-      unique_ptr<char[]> buffer(new char[2 * chunkSize]);
-      this->context_.template Copy<char, Context, CPUContext>(
-          2 * chunkSize,
-          reinterpret_cast<const char*>(
-              input.template data<float16>() + chunkBegin),
-          buffer.get());
-      this->context_.FinishDeviceComputation();
-      proto.set_byte_data(buffer.release(), 2 * chunkSize);
-    } else {
-      detail::CopyToProtoWithCast(
-          chunkSize,
-          reinterpret_cast<const uint16_t*>(input.template data<float16>()) +
-              chunkBegin,
-          proto.mutable_int32_data(),
-          &this->context_);
-    }
-  } break;
+  case TensorProto_DataType_FLOAT16:
+    detail::CopyToProtoWithCast(
+        chunkSize,
+        reinterpret_cast<const uint16_t*>(input.template data<float16>()) +
+            chunkBegin,
+        proto.mutable_int32_data(),
+        &this->context_);
+    break;
   case TensorProto_DataType_DOUBLE:
     detail::CopyToProtoAsIs(
         chunkSize,
@@ -426,15 +481,22 @@ template <class Context>
 void TensorDeserializer<Context>::Deserialize(
     const TensorProto& proto,
     Tensor<Context>* tensor) {
-  // We create a local context for deserializing. Since Caffe2 contexts are
-  // usually lightweighted, this should not involve too much overhead.
-  Context context(proto.device_detail());
-  context.SwitchToDevice(0);
   vector<TIndex> dims;
   for (const TIndex d : proto.dims()) {
     dims.push_back(d);
   }
   tensor->Resize(dims);
+  DeserializeChunk(proto, tensor);
+}
+
+template <class Context>
+void TensorDeserializer<Context>::DeserializeChunk(
+    const TensorProto& proto,
+    Tensor<Context>* tensor) {
+  // We create a local context for deserializing. Since Caffe2 contexts are
+  // usually lightweighted, this should not involve too much overhead.
+  Context context(proto.device_detail());
+  context.SwitchToDevice(0);
 
   int64_t chunkBegin = 0;
   auto chunkEnd = tensor->size();
@@ -452,6 +514,20 @@ void TensorDeserializer<Context>::Deserialize(
       tensor->size());
   auto chunkSize = chunkEnd - chunkBegin;
 
+  // The data of tensors of fixed-size types may be stored as raw bytes;
+  // byte_data isn't used for these types otherwise.
+  if (proto.has_byte_data() && detail::CanSerializeAsBytes(proto.data_type())) {
+    const auto& meta = DataTypeToTypeMeta(proto.data_type());
+    detail::CopyFromProtoAsBytes(
+        chunkSize * meta.itemsize(),
+        proto.byte_data(),
+        static_cast<char*>(tensor->raw_mutable_data(meta)) +
+            chunkBegin * meta.itemsize(),
+        &context);
+    context.FinishDeviceComputation();
+    return;
+  }
+
   switch (proto.data_type()) {
     case TensorProto_DataType_FLOAT:
       detail::CopyFromProtoAsIs(
@@ -529,31 +605,13 @@ void TensorDeserializer<Context>::Deserialize(
           &context);
       break;
     case TensorProto_DataType_FLOAT16:
-      if (proto.has_byte_data()) {
-        const int kValue = 1;
-        CAFFE_ENFORCE_EQ(
-            reinterpret_cast<const char*>(&kValue)[0],
-            1,
-            "Serialization of FLOAT16 on big endian platform "
-            "is not written yet.");
-        CAFFE_ENFORCE_EQ(
-            2 * chunkSize,
-            proto.byte_data().size(),
-            "Incorrect proto field size.");
-        context.template Copy<float16, Context, CPUContext>(
-            chunkSize,
-            reinterpret_cast<const float16*>(proto.byte_data().data()),
-            tensor->template mutable_data<float16>() + chunkBegin);
-      } else {
-        // Backward compatibility with models which used int32_data field
-        detail::CopyFromProtoWithCast(
-            chunkSize,
-            proto.int32_data(),
-            reinterpret_cast<uint16_t*>(
-                tensor->template mutable_data<float16>()) +
-                chunkBegin,
-            &context);
-      }
+      detail::CopyFromProtoWithCast(
+          chunkSize,
+          proto.int32_data(),
+          reinterpret_cast<uint16_t*>(
+              tensor->template mutable_data<float16>()) +
+              chunkBegin,
+          &context);
       break;
     case TensorProto_DataType_DOUBLE:
       detail::CopyFromProtoAsIs(
@@ -32,5 +32,10 @@ size_t sizeBytes(const Blob& blob) {
   return p ? p->sizeBytes(blob) : 0;
 }
 
+size_t numAllocations(const Blob& blob) {
+  auto* p = BlobStatRegistry::instance().get(blob.meta().id());
+  return p ? p->numAllocations(blob) : 0;
+}
+
 } // namespace BlobStats
 }
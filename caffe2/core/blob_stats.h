@@ -10,6 +10,9 @@ namespace caffe2 {
 
 struct BlobStatGetter {
   virtual size_t sizeBytes(const Blob& blob) const = 0;
+  virtual size_t numAllocations(const Blob& /* unused */) const {
+    return 0;
+  }
   virtual ~BlobStatGetter() {}
 };
 
@@ -42,5 +45,11 @@ namespace BlobStat {
  * If not available, return 0.
  */
 size_t sizeBytes(const Blob& blob);
+
+/**
+ * Return the number of times the blob allocated its storage, if available for
+ * a blob of given type. If not available, return 0.
+ */
+size_t numAllocations(const Blob& blob);
 }
 }
@@ -21,6 +21,7 @@
 CAFFE2_DEFINE_int64(caffe2_test_big_tensor_size, 100000000, "");
 CAFFE2_DECLARE_int(caffe2_tensor_chunk_size);
 CAFFE2_DECLARE_bool(caffe2_serialize_fp16_as_bytes);
+CAFFE2_DECLARE_bool(caffe2_serialize_tensors_as_bytes);
 
 namespace caffe2 {
 using namespace ::caffe2::db;
@@ -500,6 +501,34 @@ TYPED_TEST(TensorCPUTest, MaxKeepOnShrink) {
   FLAGS_caffe2_max_keep_on_shrink_memory = LLONG_MAX;
 }
 
+TYPED_TEST(TensorCPUTest, GrowthPct) {
+  FLAGS_caffe2_tensor_growth_pct = 50;
+
+  TensorCPU tensor(vector<int>{10});
+  TypeParam* ptr = tensor.mutable_data<TypeParam>();
+  EXPECT_TRUE(ptr != nullptr);
+  EXPECT_EQ(tensor.capacity_nbytes(), 10 * sizeof(TypeParam));
+  EXPECT_EQ(tensor.num_allocations(), 1);
+  // Growing - will reallocate, with room for 50% more
+  tensor.Resize(12);
+  TypeParam* larger_ptr = tensor.mutable_data<TypeParam>();
+  EXPECT_TRUE(larger_ptr != nullptr);
+  EXPECT_EQ(tensor.capacity_nbytes(), 15 * sizeof(TypeParam));
+  EXPECT_EQ(tensor.num_allocations(), 2);
+  // Growing but still under capacity - will not reallocate
+  tensor.Resize(15);
+  EXPECT_EQ(larger_ptr, tensor.mutable_data<TypeParam>());
+  EXPECT_EQ(tensor.num_allocations(), 2);
+  // Growing past the growth - will reallocate to the new size
+  tensor.Resize(40);
+  EXPECT_TRUE(tensor.mutable_data<TypeParam>() != nullptr);
+  EXPECT_EQ(tensor.capacity_nbytes(), 40 * sizeof(TypeParam));
+  EXPECT_EQ(tensor.num_allocations(), 3);
+
+  // Restore default flags
+  FLAGS_caffe2_tensor_growth_pct = 0;
+}
+
 TYPED_TEST(TensorCPUDeathTest, CannotAccessRawDataWhenEmpty) {
   TensorCPU tensor;
   EXPECT_EQ(tensor.ndim(), 0);
@@ -723,6 +752,36 @@ TEST(TensorTest, float16) {
   }
 }
 
+TEST(TensorTest, TensorSerializationAsBytes) {
+  FLAGS_caffe2_serialize_tensors_as_bytes = true;
+  const TIndex kSize = 123;
+  Blob blob;
+  TensorCPU* tensor = blob.GetMutable<TensorCPU>();
+  tensor->Resize(kSize, 2);
+  for (int i = 0; i < tensor->size(); ++i) {
+    tensor->mutable_data<int64_t>()[i] = (1LL << 40) + i;
+  }
+  string serialized = blob.Serialize("test");
+  FLAGS_caffe2_serialize_tensors_as_bytes = false;
+  BlobProto proto;
+  CHECK(proto.ParseFromString(serialized));
+  const TensorProto& tensor_proto = proto.tensor();
+  EXPECT_EQ(
+      tensor_proto.data_type(), TypeMetaToDataType(TypeMeta::Make<int64_t>()));
+  EXPECT_EQ(tensor_proto.byte_data().size(), sizeof(int64_t) * 2 * kSize);
+  EXPECT_EQ(tensor_proto.int64_data().size(), 0);
+  Blob new_blob;
+  EXPECT_NO_THROW(new_blob.Deserialize(serialized));
+  EXPECT_TRUE(new_blob.IsType<TensorCPU>());
+  const TensorCPU& new_tensor = new_blob.Get<TensorCPU>();
+  EXPECT_EQ(new_tensor.ndim(), 2);
+  EXPECT_EQ(new_tensor.dim(0), kSize);
+  EXPECT_EQ(new_tensor.dim(1), 2);
+  for (int i = 0; i < new_tensor.size(); ++i) {
+    EXPECT_EQ(new_tensor.data<int64_t>()[i], (1LL << 40) + i);
+  }
+}
+
 TEST(QTensorTest, QTensorSerialization) {
   Blob blob;
   QTensor<CPUContext>* qtensor = blob.GetMutable<QTensor<CPUContext>>();
@@ -0,0 +1,253 @@
+#include "caffe2/core/caching_cpu_allocator.h"
+
+#include <atomic>
+#include <vector>
+
+#include "caffe2/core/init.h"
+#include "caffe2/core/stats.h"
+
+CAFFE2_DEFINE_bool(
+    caffe2_cpu_caching_allocator,
+    false,
+    "If set, install CachingCPUAllocator as the CPU allocator on "
+    "caffe2::GlobalInit");
+
+CAFFE2_DEFINE_int64(
+    caffe2_cpu_caching_allocator_max_cached_bytes,
+    256 * 1024 * 1024,
+    "Upper bound on the number of bytes CachingCPUAllocator keeps in its "
+    "thread-local caches, summed over all threads");
+
+CAFFE2_DEFINE_int64(
+    caffe2_cpu_caching_allocator_max_block_bytes,
+    16 * 1024 * 1024,
+    "Allocations larger than this bypass the CachingCPUAllocator caches");
+
+namespace caffe2 {
+
+namespace {
+
+// Every block starts with a header recording its size class. Keeping the
+// header as large as the alignment keeps the returned pointer aligned.
+struct BlockHeader {
+  uint32_t size_class;
+};
+constexpr size_t kHeaderBytes = gCaffe2Alignment;
+static_assert(sizeof(BlockHeader) <= kHeaderBytes, "header too large");
+
+constexpr size_t kMinClassBytes = 64;
+constexpr int kMinClassLog2 = 6;
+constexpr uint32_t kUncached = ~uint32_t(0);
+// Four classes per power of two from 64 bytes up to 2^kMaxClassLog2.
+constexpr int kMaxClassLog2 = 40;
+constexpr int kNumClasses = 1 + 4 * (kMaxClassLog2 - kMinClassLog2);
+
+static_assert(
+    kMinClassBytes == (size_t(1) << kMinClassLog2),
+    "kMinClassBytes and kMinClassLog2 must agree");
+
+inline int HighestBit(size_t n) {
+  int k = 0;
+  while (n >>= 1) {
+    ++k;
+  }
+  return k;
+}
+
+// Class 0 holds blocks of up to 64 bytes; after that every octave
+// (2^k, 2^(k+1)] is split into four classes 2^k * {1.25, 1.5, 1.75, 2}.
+inline uint32_t SizeClass(size_t nbytes) {
+  if (nbytes <= kMinClassBytes) {
+    return 0;
+  }
+  const int k = HighestBit(nbytes - 1);
+  const size_t step = size_t(1) << (k - 2);
+  const size_t m = (nbytes + step - 1) / step;
+  return 1 + 4 * (k - kMinClassLog2) + (m - 5);
+}
+
+inline size_t ClassBytes(uint32_t size_class) {
+  if (size_class == 0) {
+    return kMinClassBytes;
+  }
+  const uint32_t j = size_class - 1;
+  const int k = kMinClassLog2 + j / 4;
+  return size_t(5 + j % 4) << (k - 2);
+}
+
+inline BlockHeader* HeaderOf(void* data) {
+  return reinterpret_cast<BlockHeader*>(
+      static_cast<char*>(data) - kHeaderBytes);
+}
+
+void* AllocateBlock(size_t nbytes, uint32_t size_class) {
+  void* base = nullptr;
+#ifdef __ANDROID__
+  base = memalign(gCaffe2Alignment, nbytes + kHeaderBytes);
+#elif defined(_MSC_VER)
+  base = _aligned_malloc(nbytes + kHeaderBytes, gCaffe2Alignment);
+#else
+  CAFFE_ENFORCE_EQ(
+      posix_memalign(&base, gCaffe2Alignment, nbytes + kHeaderBytes), 0);
+#endif
+  CAFFE_ENFORCE(base);
+  void* data = static_cast<char*>(base) + kHeaderBytes;
+  HeaderOf(data)->size_class = size_class;
+  PlaceOnNUMANode(data, nbytes);
+  return data;
+}
+
+void FreeBlock(void* data) {
+  void* base = HeaderOf(data);
+#ifdef _MSC_VER
+  _aligned_free(base);
+#else
+  free(base);
+#endif
+}
+
+// Bytes held by all thread caches.
+std::atomic<int64_t> g_cached_bytes{0};
+
+struct CachingCPUAllocatorStats {
+  CAFFE_STAT_CTOR(CachingCPUAllocatorStats);
+  CAFFE_EXPORTED_STAT(cache_hits);
+  CAFFE_EXPORTED_STAT(cache_misses);
+  CAFFE_EXPORTED_STAT(uncached_allocations);
+  CAFFE_EXPORTED_STAT(released_blocks);
+  CAFFE_EXPORTED_STAT(cached_bytes);
+};
+
+CachingCPUAllocatorStats& Stats() {
+  // Leaked so that blocks freed during static destruction can still count.
+  static auto* stats = new CachingCPUAllocatorStats("cpu_caching_allocator");
+  return *stats;
+}
+
+struct ThreadCache {
+  std::vector<void*> free_lists[kNumClasses];
+
+  void Empty() {
+    for (uint32_t c = 0; c < kNumClasses; ++c) {
+      auto& list = free_lists[c];
+      if (list.empty()) {
+        continue;
+      }
+      g_cached_bytes -= ClassBytes(c) * list.size();
+      for (void* data : list) {
+        FreeBlock(data);
+      }
+      list.clear();
+    }
+  }
+
+  ~ThreadCache();
+};
+
+// Blocks allocated or freed while the thread exits, after its cache is gone
+// (e.g. by the destructor of another thread_local, or during static
+// destruction on the main thread), bypass the cache.
+thread_local bool thread_cache_destroyed = false;
+
+ThreadCache::~ThreadCache() {
+  thread_cache_destroyed = true;
+  Empty();
+}
+
+ThreadCache* LocalCache() {
+  if (thread_cache_destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+} // namespace
+
+std::pair<void*, MemoryDeleter> CachingCPUAllocator::New(size_t nbytes) {
+  auto& stats = Stats();
+  void* data = nullptr;
+  if (nbytes > (size_t)FLAGS_caffe2_cpu_caching_allocator_max_block_bytes ||
+      SizeClass(nbytes) >= kNumClasses) {
+    data = AllocateBlock(nbytes, kUncached);
+    CAFFE_EVENT(stats, uncached_allocations);
+  } else {
+    const uint32_t size_class = SizeClass(nbytes);
+    const size_t class_bytes = ClassBytes(size_class);
+    auto* cache = LocalCache();
+    if (cache && !cache->free_lists[size_class].empty()) {
+      auto& list = cache->free_lists[size_class];
+      data = list.back();
+      list.pop_back();
+      g_cached_bytes -= class_bytes;
+      CAFFE_EVENT(stats, cache_hits);
+      CAFFE_EVENT(stats, cached_bytes, -(int64_t)class_bytes);
+    } else {
+      data = AllocateBlock(class_bytes, size_class);
+      CAFFE_EVENT(stats, cache_misses);
+    }
+  }
+  if (FLAGS_caffe2_cpu_allocator_do_zero_fill) {
+    memset(data, 0, nbytes);
+  }
+  return {data, Delete};
+}
+
+void CachingCPUAllocator::Delete(void* data) {
+  if (!data) {
+    return;
+  }
+  const uint32_t size_class = HeaderOf(data)->size_class;
+  if (size_class == kUncached) {
+    FreeBlock(data);
+    return;
+  }
+  const int64_t class_bytes = ClassBytes(size_class);
+  auto& stats = Stats();
+  if (g_cached_bytes.fetch_add(class_bytes) + class_bytes >
+      FLAGS_caffe2_cpu_caching_allocator_max_cached_bytes) {
+    g_cached_bytes -= class_bytes;
+    FreeBlock(data);
+    CAFFE_EVENT(stats, released_blocks);
+    return;
+  }
+  auto* cache = LocalCache();
+  if (!cache) {
+    g_cached_bytes -= class_bytes;
+    FreeBlock(data);
+    CAFFE_EVENT(stats, released_blocks);
+    return;
+  }
+  cache->free_lists[size_class].push_back(data);
+  CAFFE_EVENT(stats, cached_bytes, class_bytes);
+}
+
+void CachingCPUAllocator::EmptyThreadCache() {
+  auto* cache = LocalCache();
+  if (!cache) {
+    return;
+  }
+  const int64_t before = g_cached_bytes;
+  cache->Empty();
+  auto& stats = Stats();
+  CAFFE_EVENT(stats, cached_bytes, g_cached_bytes - before);
+}
+
+size_t CachingCPUAllocator::CachedBytes() {
+  return g_cached_bytes;
+}
+
+bool Caffe2InstallCachingCPUAllocator(int*, char***) {
+  if (FLAGS_caffe2_cpu_caching_allocator) {
+    VLOG(1) << "Using CachingCPUAllocator";
+    SetCPUAllocator(new CachingCPUAllocator());
+  }
+  return true;
+}
+
+REGISTER_CAFFE2_INIT_FUNCTION(
+    Caffe2InstallCachingCPUAllocator,
+    &Caffe2InstallCachingCPUAllocator,
+    "Install the thread-local caching CPU allocator if requested.");
+
+} // namespace caffe2
@@ -0,0 +1,47 @@
+#ifndef CAFFE2_CORE_CACHING_CPU_ALLOCATOR_H_
+#define CAFFE2_CORE_CACHING_CPU_ALLOCATOR_H_
+
+#include "caffe2/core/allocator.h"
+
+CAFFE2_DECLARE_bool(caffe2_cpu_caching_allocator);
+CAFFE2_DECLARE_int64(caffe2_cpu_caching_allocator_max_cached_bytes);
+CAFFE2_DECLARE_int64(caffe2_cpu_caching_allocator_max_block_bytes);
+
+namespace caffe2 {
+
+// A CPU allocator that keeps freed blocks in thread-local, size-class
+// segregated free lists and hands them out again on the next allocation of
+// the same class, in the spirit of THCCachingAllocator. It is meant for
+// serving workloads where the same set of per-request tensors is allocated
+// and freed on every run.
+//
+// Sizes are rounded up to one of four classes per power of two (at most
+// 25% slack). Blocks larger than
+// --caffe2_cpu_caching_allocator_max_block_bytes are not cached. The total
+// number of bytes held in all caches is capped by
+// --caffe2_cpu_caching_allocator_max_cached_bytes; a freed block that would
+// exceed the cap is returned to the system. Blocks freed on a thread other
+// than the one that allocated them go to the freeing thread's cache, and a
+// thread's cache is released when the thread exits. Blocks freed on a thread
+// after its cache was released go straight back to the system.
+//
+// Counters are exported through StatRegistry under "cpu_caching_allocator/".
+struct CachingCPUAllocator final : CPUAllocator {
+  CachingCPUAllocator() {}
+  ~CachingCPUAllocator() override {}
+  std::pair<void*, MemoryDeleter> New(size_t nbytes) override;
+  MemoryDeleter GetDeleter() override {
+    return Delete;
+  }
+
+  static void Delete(void* data);
+
+  // Returns every block cached by the calling thread to the system.
+  static void EmptyThreadCache();
+  // Number of bytes currently held in the caches of all threads.
+  static size_t CachedBytes();
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_CACHING_CPU_ALLOCATOR_H_
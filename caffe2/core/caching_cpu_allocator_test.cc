@@ -0,0 +1,92 @@
+#include <thread> // NOLINT
+
+#include <gtest/gtest.h>
+#include "caffe2/core/caching_cpu_allocator.h"
+#include "caffe2/core/stats.h"
+
+namespace caffe2 {
+
+namespace {
+int64_t StatValueOf(const std::string& name) {
+  auto stats = toMap(StatRegistry::get().publish());
+  return stats["cpu_caching_allocator/" + name];
+}
+
+// Frees its block when the thread exits.
+struct ThreadExitFree {
+  std::pair<void*, MemoryDeleter> block{nullptr, nullptr};
+  ~ThreadExitFree() {
+    if (block.first) {
+      block.second(block.first);
+    }
+  }
+};
+} // namespace
+
+TEST(CachingCPUAllocatorTest, ReusesFreedBlocks) {
+  CachingCPUAllocator allocator;
+  CachingCPUAllocator::EmptyThreadCache();
+  auto first = allocator.New(1000);
+  EXPECT_EQ(reinterpret_cast<size_t>(first.first) % gCaffe2Alignment, 0);
+  first.second(first.first);
+  EXPECT_GT(CachingCPUAllocator::CachedBytes(), 0);
+
+  const int64_t hits = StatValueOf("cache_hits");
+  // 1000 and 1020 bytes fall into the same size class.
+  auto second = allocator.New(1020);
+  EXPECT_EQ(second.first, first.first);
+  EXPECT_EQ(StatValueOf("cache_hits"), hits + 1);
+  second.second(second.first);
+  CachingCPUAllocator::EmptyThreadCache();
+  EXPECT_EQ(CachingCPUAllocator::CachedBytes(), 0);
+}
+
+TEST(CachingCPUAllocatorTest, DoesNotCacheLargeBlocks) {
+  CachingCPUAllocator allocator;
+  const size_t nbytes =
+      FLAGS_caffe2_cpu_caching_allocator_max_block_bytes + 1;
+  auto data = allocator.New(nbytes);
+  memset(data.first, 1, nbytes);
+  data.second(data.first);
+  EXPECT_EQ(CachingCPUAllocator::CachedBytes(), 0);
+}
+
+TEST(CachingCPUAllocatorTest, RespectsCap) {
+  CachingCPUAllocator allocator;
+  const auto old_cap = FLAGS_caffe2_cpu_caching_allocator_max_cached_bytes;
+  FLAGS_caffe2_cpu_caching_allocator_max_cached_bytes = 4096;
+  std::vector<std::pair<void*, MemoryDeleter>> blocks;
+  for (int i = 0; i < 16; ++i) {
+    blocks.push_back(allocator.New(1024));
+  }
+  for (auto& b : blocks) {
+    b.second(b.first);
+  }
+  EXPECT_LE(CachingCPUAllocator::CachedBytes(), 4096);
+  CachingCPUAllocator::EmptyThreadCache();
+  FLAGS_caffe2_cpu_caching_allocator_max_cached_bytes = old_cap;
+}
+
+TEST(CachingCPUAllocatorTest, CrossThreadFree) {
+  CachingCPUAllocator allocator;
+  auto data = allocator.New(256);
+  std::thread t([&data]() { data.second(data.first); });
+  t.join();
+  // The freeing thread's cache was released when it exited.
+  EXPECT_EQ(CachingCPUAllocator::CachedBytes(), 0);
+}
+
+TEST(CachingCPUAllocatorTest, FreeAfterThreadCacheDestroyed) {
+  CachingCPUAllocator allocator;
+  const int64_t released = StatValueOf("released_blocks");
+  std::thread t([&allocator]() {
+    // Constructed before the thread's cache, so destroyed after it.
+    static thread_local ThreadExitFree holder;
+    holder.block = allocator.New(256);
+  });
+  t.join();
+  EXPECT_EQ(CachingCPUAllocator::CachedBytes(), 0);
+  EXPECT_EQ(StatValueOf("released_blocks"), released + 1);
+}
+
+} // namespace caffe2
@@ -87,6 +87,10 @@ using std::vector;
 #endif // ANDROID / IOS / MACOS
 #endif // CAFFE2_MOBILE
 
+// Streams of ids from CAFFE2_PRIORITY_STREAM_ID_BASE on are created with the
+// highest priority of their device, the ones below with the default one.
+#define CAFFE2_PRIORITY_STREAM_ID_BASE 64
+
 // Define alignment macro that is cross platform
 #if defined(_MSC_VER)
 #define CAFFE2_ALIGNED(x) __declspec(align(x))
@@ -13,6 +13,44 @@ CuDNNWrapper::PerGPUCuDNNStates& CuDNNWrapper::cudnn_states() {
   return *p;
 }
 
+size_t CuDNNWrapper::workspace_nbytes_limit(
+    size_t state_idx,
+    size_t nbytes_limit) {
+  CAFFE_ENFORCE(
+      state_idx < CAFFE2_COMPILE_TIME_MAX_CUDNN_STATES, "Invalid state_idx");
+  auto& sync_state = cudnn_states()[context_->cuda_gpu_id()][state_idx];
+  size_t nbytes = 0;
+  {
+    std::lock_guard<std::mutex> g(sync_state.mutex);
+    if (sync_state.state.get()) {
+      nbytes = sync_state.state->workspace().nbytes();
+    }
+  }
+  if (nbytes >= nbytes_limit) {
+    return nbytes_limit;
+  }
+
+  DeviceGuard dg(context_->cuda_gpu_id());
+  size_t free_nbytes = 0;
+  size_t total_nbytes = 0;
+  CUDA_ENFORCE(cudaMemGetInfo(&free_nbytes, &total_nbytes));
+  // The workspace releases its buffer before allocating a bigger one
+  const size_t available_nbytes = nbytes + free_nbytes;
+  if (available_nbytes >= nbytes_limit) {
+    return nbytes_limit;
+  }
+  size_t limit = 0;
+  if (available_nbytes > 0) {
+    limit = 1;
+    while (limit <= available_nbytes / 2) {
+      limit *= 2;
+    }
+  }
+  VLOG(1) << "CuDNN workspace limit " << nbytes_limit << " capped to "
+          << limit << " by the free memory of GPU " << context_->cuda_gpu_id();
+  return limit;
+}
+
 namespace {
 bool PrintCuDNNInfo(int*, char***) {
   VLOG(1) << "Caffe2 is built with CuDNN version " << CUDNN_VERSION;
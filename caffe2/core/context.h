@@ -70,13 +70,18 @@ class CPUContext final {
   explicit CPUContext(const DeviceOption& option)
       : random_seed_(
             option.has_random_seed() ? option.random_seed()
-                                     : RandomNumberSeed()) {
+                                     : RandomNumberSeed()),
+        numa_node_id_(option.numa_node_id()) {
     CAFFE_ENFORCE_EQ(option.device_type(), CPU);
   }
 
   ~CPUContext() noexcept {}
 
-  inline void SwitchToDevice(int /*stream_id*/) {}
+  inline void SwitchToDevice(int /*stream_id*/) {
+    // Lets the allocator honor DeviceOption.numa_node_id for everything
+    // this operator allocates.
+    SetNUMAAllocationNode(numa_node_id_);
+  }
   inline void SwitchToDevice() {
     SwitchToDevice(0);
   }
@@ -154,6 +159,7 @@ class CPUContext final {
  protected:
   // TODO(jiayq): instead of hard-coding a generator, make it more flexible.
   int random_seed_{1701};
+  int numa_node_id_{-1};
   std::unique_ptr<rand_gen_type> random_generator_;
   CAFFE2_API static MemoryAllocationReporter reporter_;
 
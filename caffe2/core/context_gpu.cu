@@ -5,6 +5,7 @@
 #include <unordered_map>
 
 #include "THCCachingAllocator.h"
+#include "THCCachingHostAllocator.h"
 #include "cub/util_allocator.cuh"
 
 // Needed to be included first to check the CAFFE2_USE_CUDNN macros.
@@ -48,6 +49,14 @@ CAFFE2_DEFINE_bool(
     "If true CachingDeviceAllocator will print allocation and deallocation "
     "events to stdout.");
 
+CAFFE2_DEFINE_bool(
+    caffe2_cuda_caching_pinned_allocator,
+    true,
+    "If true, pinned CPU memory is allocated through a caching allocator "
+    "that reuses freed buffers once the copies using them are done, instead "
+    "of calling cudaMallocHost / cudaFreeHost for every tensor. Ignored when "
+    "NUMA is enabled.");
+
 CAFFE2_DEFINE_bool(
     caffe2_gpu_memory_tracking,
     false,
@@ -266,6 +275,10 @@ struct TensorCUDAStatGetter : BlobStatGetter {
     }
     return nbytes;
   }
+
+  size_t numAllocations(const Blob& blob) const override {
+    return blob.Get<TensorCUDA>().num_allocations();
+  }
 };
 REGISTER_BLOB_STAT_GETTER(TensorCUDA, TensorCUDAStatGetter);
 } // namespace
@@ -434,4 +447,96 @@ void CUDAContext::Delete(void* ptr) {
   }
 }
 
+namespace {
+// One host-to-device copy stream per device, shared by all threads. Streams
+// are created on first use and live for the rest of the process.
+cudaStream_t GetH2DCopyStream(int gpu_id) {
+  static std::mutex mutex;
+  static cudaStream_t streams[CAFFE2_COMPILE_TIME_MAX_GPUS] = {nullptr};
+  CAFFE_ENFORCE_LT(gpu_id, CAFFE2_COMPILE_TIME_MAX_GPUS);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!streams[gpu_id]) {
+    DeviceGuard guard(gpu_id);
+    CUDA_ENFORCE(
+        cudaStreamCreateWithFlags(&streams[gpu_id], cudaStreamNonBlocking));
+  }
+  return streams[gpu_id];
+}
+
+bool IsPinnedHostPointer(const void* ptr) {
+  cudaPointerAttributes attr;
+  cudaError_t err = cudaPointerGetAttributes(&attr, ptr);
+  if (err == cudaErrorInvalidValue) {
+    // Pageable memory unknown to CUDA; clear the sticky error state.
+    cudaGetLastError();
+    return false;
+  }
+  CUDA_ENFORCE(err);
+  return attr.memoryType == cudaMemoryTypeHost;
+}
+} // namespace
+
+void CUDAContext::CopyToDeviceAsync(
+    size_t nbytes,
+    const void* src,
+    void* dst) {
+  if (nbytes == 0) {
+    return;
+  }
+  DeviceGuard guard(gpu_id_);
+  cudaStream_t copy_stream = GetH2DCopyStream(gpu_id_);
+
+  void* staging = nullptr;
+  if (!IsPinnedHostPointer(src)) {
+    CUDA_ENFORCE(THCCachingHostAllocator_malloc(&staging, nbytes));
+    memcpy(staging, src, nbytes);
+    src = staging;
+  }
+  CUDA_ENFORCE(cudaMemcpyAsync(
+      dst, src, nbytes, cudaMemcpyHostToDevice, copy_stream));
+  CUDA_ENFORCE(THCCachingHostAllocator_recordEventOnStream(
+      const_cast<void*>(src), gpu_id_, copy_stream));
+  if (staging) {
+    // Only goes back to the pool once the copy above has completed.
+    CUDA_ENFORCE(THCCachingHostAllocator_free(staging));
+  }
+
+  // Destroying a recorded event is fine: the wait below still applies.
+  cudaEvent_t copied;
+  CUDA_ENFORCE(cudaEventCreateWithFlags(&copied, cudaEventDisableTiming));
+  CUDA_ENFORCE(cudaEventRecord(copied, copy_stream));
+  CUDA_ENFORCE(cudaStreamWaitEvent(cuda_stream(), copied, 0));
+  CUDA_ENFORCE(cudaEventDestroy(copied));
+}
+
+void CUDAContext::RecordHostMemoryUse(const void* ptr) {
+  if (!FLAGS_caffe2_cuda_caching_pinned_allocator) {
+    return;
+  }
+  CUDA_ENFORCE(THCCachingHostAllocator_recordEventOnStream(
+      const_cast<void*>(ptr), gpu_id_, cuda_stream()));
+}
+
+bool PinnedCPUAllocator::UseCachingAllocator() {
+  return FLAGS_caffe2_cuda_caching_pinned_allocator && !IsNUMAEnabled();
+}
+
+std::pair<void*, MemoryDeleter> PinnedCPUAllocator::NewCached(size_t nbytes) {
+  void* data = nullptr;
+  CUDA_ENFORCE(THCCachingHostAllocator_malloc(&data, nbytes));
+  memset(data, 0, nbytes);
+  return {data, DeleteCached};
+}
+
+void PinnedCPUAllocator::DeleteCached(void* data) {
+  cudaError_t err = THCCachingHostAllocator_free(data);
+  if (err == cudaErrorInvalidValue) {
+    // Allocated before the pinned allocator was installed, or by the
+    // uncached path.
+    Delete(data);
+  } else {
+    CUDA_ENFORCE(err);
+  }
+}
+
 }  // namespace caffe2
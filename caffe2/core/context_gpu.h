@@ -3,6 +3,7 @@
 
 #include <ctime>
 #include <mutex>
+#include <type_traits>
 
 #include "caffe2/core/common.h"
 #include "caffe2/core/common_gpu.h"
@@ -64,8 +65,16 @@ class ThreadLocalCUDAObjects {
     }
     if (!gpu_streams[stream_id]) {
       DeviceGuard guard(gpu);
-      CUDA_ENFORCE(cudaStreamCreateWithFlags(
-          &gpu_streams[stream_id], cudaStreamNonBlocking));
+      if (stream_id >= CAFFE2_PRIORITY_STREAM_ID_BASE) {
+        int least_priority, greatest_priority;
+        CUDA_ENFORCE(cudaDeviceGetStreamPriorityRange(
+            &least_priority, &greatest_priority));
+        CUDA_ENFORCE(cudaStreamCreateWithPriority(
+            &gpu_streams[stream_id], cudaStreamNonBlocking, greatest_priority));
+      } else {
+        CUDA_ENFORCE(cudaStreamCreateWithFlags(
+            &gpu_streams[stream_id], cudaStreamNonBlocking));
+      }
     }
     return gpu_streams[stream_id];
   }
@@ -231,8 +240,30 @@ class CUDAContext final {
         nbytes,
         cudaMemcpyDefault,
         cuda_objects_.GetStream(gpu_id_, stream_id_)));
+    // Keep cached pinned buffers from being handed out again while the copy
+    // may still be reading or writing them.
+    if (std::is_same<SrcContext, CPUContext>::value) {
+      RecordHostMemoryUse(src);
+    }
+    if (std::is_same<DstContext, CPUContext>::value) {
+      RecordHostMemoryUse(dst);
+    }
   }
 
+  // Copies nbytes of host memory at src to device memory at dst without
+  // blocking the host. The copy is enqueued on a dedicated host-to-device
+  // stream of this context's device, so it overlaps with the kernels
+  // already queued on the compute streams, and the current stream of this
+  // context waits for it, so work queued here afterwards sees the data.
+  // Pageable source memory is first staged into a cached pinned buffer;
+  // the staging buffer is recycled once the copy has completed, so src can
+  // be reused as soon as this returns.
+  void CopyToDeviceAsync(size_t nbytes, const void* src, void* dst);
+
+  // Marks the host memory at ptr as in use by work queued on the current
+  // stream. No-op unless ptr comes from the caching pinned allocator.
+  void RecordHostMemoryUse(const void* ptr);
+
   template <typename T, class SrcContext, class DstContext>
   inline void Copy(int n, const T* src, T* dst) {
     CopyBytes<SrcContext, DstContext>(n * sizeof(T),
@@ -306,6 +337,9 @@ struct PinnedCPUAllocator final : CPUAllocator {
   ~PinnedCPUAllocator() override {}
   std::pair<void*, MemoryDeleter> New(size_t nbytes) override {
     void* data;
+    if (UseCachingAllocator()) {
+      return NewCached(nbytes);
+    }
     std::lock_guard<std::mutex> lock(CUDAContext::mutex());
     if (IsNUMAEnabled()) {
       auto ptr_and_deleter = baseAllocator_.New(nbytes);
@@ -320,10 +354,18 @@ struct PinnedCPUAllocator final : CPUAllocator {
   }
 
   MemoryDeleter GetDeleter() override {
-    return Delete;
+    return UseCachingAllocator() ? DeleteCached : Delete;
   }
 
  private:
+  // Unless NUMA placement is on, pinned memory comes from the caching host
+  // allocator shared with ATen (see THCCachingHostAllocator.h), which reuses
+  // freed buffers once the copies recorded on them have completed instead of
+  // paying for cudaFreeHost, which synchronizes the device, on every free.
+  static bool UseCachingAllocator();
+  static std::pair<void*, MemoryDeleter> NewCached(size_t nbytes);
+  static void DeleteCached(void* data);
+
   static void Delete(void* data) {
     // Caffe2 uses a lazy way to figure out if one is actually going to use GPUs
     // or not. If a CUDAContext::New() call is made, inside the CUDAContext
@@ -1,8 +1,10 @@
+#include <algorithm>
 #include <chrono>
 #include <future>
 #include <random>
 #include <thread>
 #include <array>
+#include <vector>
 
 #include "caffe2/core/context_gpu.h"
 #include <gtest/gtest.h>
@@ -146,4 +148,48 @@ TEST(CUDAContextTest, TestDifferntThreadDifferentobject) {
   EXPECT_NE(temp[0], temp[1]);
 }
 
+TEST(CUDAContextTest, CopyToDeviceAsync) {
+  if (!HasCudaGPU()) return;
+  CUDAContext context(0);
+  context.SwitchToDevice();
+  const int n = 1 << 20;
+  auto gpu_data = shared_from_new(CUDAContext::New(n * sizeof(float)));
+  // Both a pageable source, which gets staged, and a pinned one.
+  std::vector<float> pageable(n, 1.0f);
+  auto pinned = shared_from_new(GetCPUAllocator()->New(n * sizeof(float)));
+  std::fill(
+      static_cast<float*>(pinned.get()),
+      static_cast<float*>(pinned.get()) + n,
+      2.0f);
+  for (const float* src :
+       {pageable.data(), static_cast<const float*>(pinned.get())}) {
+    context.CopyToDeviceAsync(n * sizeof(float), src, gpu_data.get());
+    std::vector<float> result(n, 0.0f);
+    context.CopyBytes<CUDAContext, CPUContext>(
+        n * sizeof(float), gpu_data.get(), result.data());
+    context.FinishDeviceComputation();
+    EXPECT_EQ(result[0], src[0]);
+    EXPECT_EQ(result[n - 1], src[n - 1]);
+  }
+}
+
+TEST(CUDAContextTest, PinnedMemoryReuse) {
+  if (!HasCudaGPU() || IsNUMAEnabled()) return;
+  CUDAContext context(0);
+  context.SwitchToDevice();
+  const size_t nbytes = 4096;
+  auto gpu_data = shared_from_new(CUDAContext::New(nbytes));
+  void* first = nullptr;
+  {
+    auto pinned = shared_from_new(GetCPUAllocator()->New(nbytes));
+    first = pinned.get();
+    context.CopyBytes<CPUContext, CUDAContext>(
+        nbytes, pinned.get(), gpu_data.get());
+  }
+  // Once the copy has completed the buffer is free to be handed out again.
+  context.FinishDeviceComputation();
+  auto pinned = shared_from_new(GetCPUAllocator()->New(nbytes));
+  EXPECT_EQ(pinned.get(), first);
+}
+
 }  // namespace caffe2
@@ -34,4 +34,15 @@ TEST(CPUContextTest, TestAllocDealloc) {
   dst_data_and_deleter.second(dst_data);
 }
 
+TEST(CPUContextTest, TestNUMAAllocationNode) {
+  DeviceOption option;
+  option.set_numa_node_id(1);
+  CPUContext context(option);
+  context.SwitchToDevice();
+  EXPECT_EQ(GetNUMAAllocationNode(), 1);
+  CPUContext default_context;
+  default_context.SwitchToDevice();
+  EXPECT_EQ(GetNUMAAllocationNode(), -1);
+}
+
 }  // namespace caffe2
@@ -37,6 +37,10 @@ struct CuDNNWorkspace {
     nbytes_ = 0;
   }
 
+  size_t nbytes() const {
+    return nbytes_;
+  }
+
  private:
   std::unique_ptr<void, MemoryDeleter> data_{nullptr, NoDelete};
   size_t nbytes_{0};
@@ -137,6 +141,16 @@ class CuDNNWrapper {
     CHECK_NOTNULL(sync_state.state.get())->execute(context_->cuda_stream(), f);
   }
 
+  /**
+   * Returns nbytes_limit, or less if the workspace of the CuDNNState
+   * associated with state_idx can not grow that big with the memory currently
+   * free on the device. Operators choosing their algorithms with it do not
+   * pick algorithms they could not run. A smaller limit is rounded down to a
+   * power of two, so that algorithms chosen under memory pressure are cached
+   * under few limits.
+   */
+  size_t workspace_nbytes_limit(size_t state_idx, size_t nbytes_limit);
+
  protected:
   // Pointer to an external cuda context that the cudnn wrapper will use.
   CUDAContext* context_;
@@ -16,6 +16,20 @@ namespace db {
  */
 enum Mode { READ, WRITE, NEW };
 
+/**
+ * A reference to a range of bytes owned by someone else, for example the
+ * mapped file of a database.
+ */
+struct Slice {
+  Slice() : data(nullptr), size(0) {}
+  Slice(const char* d, size_t n) : data(d), size(n) {}
+  explicit Slice(const string& s) : data(s.data()), size(s.size()) {}
+  string ToString() const { return string(data, size); }
+
+  const char* data;
+  size_t size;
+};
+
 /**
  * An abstract class for the cursor of the database while reading.
  */
@@ -51,6 +65,26 @@ class Cursor {
    * reached the end of the database, return false.
    */
   virtual bool Valid() = 0;
+  /**
+   * Returns whether keySlice() and valueSlice() are supported. Their slices
+   * point into storage owned by the database, which stays valid until the
+   * database is closed, so reading them does not copy the records. This is
+   * optional for dbs, and in default cursors only return copies with key()
+   * and value().
+   */
+  virtual bool SupportsZeroCopy() { return false; }
+  /**
+   * Returns the current key without copying it.
+   */
+  virtual Slice keySlice() {
+    CAFFE_THROW("This db cursor does not support zero copy reads.");
+  }
+  /**
+   * Returns the current value without copying it.
+   */
+  virtual Slice valueSlice() {
+    CAFFE_THROW("This db cursor does not support zero copy reads.");
+  }
 
   DISABLE_COPY_AND_ASSIGN(Cursor);
 };
@@ -90,6 +124,19 @@ class DB {
    * the pointer.
    */
   virtual std::unique_ptr<Cursor> NewCursor() = 0;
+  /**
+   * Returns a cursor over the shard_id-th of num_shards disjoint ranges of
+   * consecutive records, which wraps back to the start of its range rather
+   * than of the database. Cursors of different shards can be used from
+   * different threads at the same time. This is optional for dbs, and in
+   * default a nullptr is returned, in which case DBReader shards the
+   * database by skipping records instead.
+   */
+  virtual std::unique_ptr<Cursor> NewShardCursor(
+      int32_t /*num_shards*/,
+      int32_t /*shard_id*/) {
+    return nullptr;
+  }
   /**
    * Returns a transaction to write data to the database. The caller takes the
    * ownership of the pointer.
@@ -224,15 +271,26 @@ class DBReader {
     std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
     *key = cursor_->key();
     *value = cursor_->value();
+    MoveToNext();
+  }
 
-    // In sharded mode, each read skips num_shards_ records
-    for (uint32_t s = 0; s < num_shards_; s++) {
-      cursor_->Next();
-      if (!cursor_->Valid()) {
-        MoveToBeginning();
-        break;
-      }
+  /**
+   * Like Read(), but returns the value as a slice. If the cursor supports
+   * zero copy, the slice points straight into the db, and stays valid as
+   * long as the reader is open. Otherwise the value is copied into buffer,
+   * which the slice then points to. Thread safe.
+   */
+  void Read(string* key, Slice* value, string* buffer) const {
+    CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
+    std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+    *key = cursor_->key();
+    if (cursor_->SupportsZeroCopy()) {
+      *value = cursor_->valueSlice();
+    } else {
+      *buffer = cursor_->value();
+      *value = Slice(*buffer);
     }
+    MoveToNext();
   }
 
   /**
@@ -264,12 +322,43 @@ class DBReader {
     CAFFE_ENFORCE(shard_id < num_shards);
     num_shards_ = num_shards;
     shard_id_ = shard_id;
-    cursor_ = db_->NewCursor();
+    cursor_.reset();
+    if (num_shards > 1) {
+      cursor_ = db_->NewShardCursor(num_shards, shard_id);
+    }
+    shard_cursor_ = cursor_ != nullptr;
+    if (!shard_cursor_) {
+      cursor_ = db_->NewCursor();
+    }
     SeekToFirst();
+    if (shard_cursor_) {
+      CAFFE_ENFORCE(
+          cursor_->Valid(),
+          "Db has no rows in shard ",
+          shard_id_,
+          " of ",
+          num_shards_);
+    }
+  }
+
+  void MoveToNext() const {
+    // In sharded mode, each read skips num_shards_ records, unless the cursor
+    // only covers the range of our shard.
+    const uint32_t skip = shard_cursor_ ? 1 : num_shards_;
+    for (uint32_t s = 0; s < skip; s++) {
+      cursor_->Next();
+      if (!cursor_->Valid()) {
+        MoveToBeginning();
+        break;
+      }
+    }
   }
 
   void MoveToBeginning() const {
     cursor_->SeekToFirst();
+    if (shard_cursor_) {
+      return;
+    }
     for (uint32_t s = 0; s < shard_id_; s++) {
       cursor_->Next();
       CAFFE_ENFORCE(
@@ -284,6 +373,7 @@ class DBReader {
   mutable std::mutex reader_mutex_;
   uint32_t num_shards_;
   uint32_t shard_id_;
+  bool shard_cursor_ = false;
 
   DISABLE_COPY_AND_ASSIGN(DBReader);
 };
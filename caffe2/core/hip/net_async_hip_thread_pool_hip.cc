@@ -23,14 +23,14 @@ CAFFE2_DEFINE_int(
 
 namespace caffe2 {
 
-std::shared_ptr<TaskThreadPool>
+std::shared_ptr<TaskThreadPoolBase>
 GetAsyncNetHIPThreadPool(int hip_gpu_id, int pool_size, bool create_new) {
   // For GPU, use per device thread pools of predefined constant size
   if (pool_size != FLAGS_caffe2_threads_per_hip_gpu) {
     LOG(INFO) << "Overriding AMD HIP GPU pool size: using "
               << FLAGS_caffe2_threads_per_hip_gpu << " threads per GPU";
   }
-  static std::unordered_map<int, std::weak_ptr<TaskThreadPool>> pools;
+  static std::unordered_map<int, std::weak_ptr<TaskThreadPoolBase>> pools;
   static std::mutex pool_mutex;
 
   if (create_new) {
@@ -40,7 +40,7 @@ GetAsyncNetHIPThreadPool(int hip_gpu_id, int pool_size, bool create_new) {
   } else {
     std::lock_guard<std::mutex> lock(pool_mutex);
 
-    std::shared_ptr<TaskThreadPool> shared_pool = nullptr;
+    std::shared_ptr<TaskThreadPoolBase> shared_pool = nullptr;
     if (pools.count(hip_gpu_id)) {
       shared_pool = pools.at(hip_gpu_id).lock();
     }
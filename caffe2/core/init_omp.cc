@@ -11,6 +11,7 @@
 #endif // CAFFE2_USE_MKL
 
 #include "caffe2/core/init.h"
+#include "caffe2/core/thread_topology.h"
 
 CAFFE2_DEFINE_int(
     caffe2_omp_num_threads, 0,
@@ -27,6 +28,10 @@ namespace caffe2 {
 
 #ifdef _OPENMP
 bool Caffe2SetOpenMPThreads(int*, char***) {
+  if (FLAGS_caffe2_thread_topology) {
+    // Sized by the thread topology instead
+    return true;
+  }
   if (!getenv("OMP_NUM_THREADS")) {
     // OMP_NUM_THREADS not passed explicitly, so *disable* OMP by
     // default. The user can use the CLI flag to override.
@@ -44,10 +49,21 @@ bool Caffe2SetOpenMPThreads(int*, char***) {
 REGISTER_CAFFE2_INIT_FUNCTION(Caffe2SetOpenMPThreads,
                               &Caffe2SetOpenMPThreads,
                               "Set OpenMP threads.");
+
+// The number of threads of subsequent parallel regions is per thread, so
+// setting it globally and for the calling thread is the same.
+void SetOpenMPIntraOpThreads(int num_threads, bool /* global */) {
+  omp_set_num_threads(num_threads);
+}
+REGISTER_INTRA_OP_THREADS_SETTER(OpenMP, &SetOpenMPIntraOpThreads);
 #endif // _OPENMP
 
 #ifdef CAFFE2_USE_MKL
 bool Caffe2SetMKLThreads(int*, char***) {
+  if (FLAGS_caffe2_thread_topology) {
+    // Sized by the thread topology instead
+    return true;
+  }
   if (!getenv("MKL_NUM_THREADS")) {
     VLOG(1) << "MKL_NUM_THREADS not passed, defaulting to 1 thread";
     mkl_set_num_threads(1);
@@ -72,6 +88,15 @@ REGISTER_CAFFE2_INIT_FUNCTION(
     Caffe2SetMKLThreads,
     &Caffe2SetMKLThreads,
     "Set MKL threads.");
+
+void SetMKLIntraOpThreads(int num_threads, bool global) {
+  if (global) {
+    mkl_set_num_threads(num_threads);
+  } else {
+    mkl_set_num_threads_local(num_threads);
+  }
+}
+REGISTER_INTRA_OP_THREADS_SETTER(MKL, &SetMKLIntraOpThreads);
 #endif // CAFFE2_USE_MKL
 
 }  // namespace caffe2
@@ -1,8 +1,12 @@
 #include "caffe2/core/memonger.h"
 
+#include <algorithm>
+#include <limits>
 #include <set>
 #include <unordered_set>
 
+#include "caffe2/core/allocator.h"
+#include "caffe2/core/types.h"
 #include "caffe2/utils/proto_utils.h"
 
 namespace caffe2 {
@@ -589,5 +593,161 @@ NetDef compute_blob_recycling_for_dag(
       blob_shapes);
 }
 
+namespace {
+// Ops whose output shares the input's buffer instead of owning one.
+bool isAliasingOp(const OperatorDef& op) {
+  return op.type() == "Alias";
+}
+
+bool blobBytes(const TensorShape& shape, size_t* nbytes) {
+  if (shape.unknown_shape() ||
+      shape.data_type() == TensorProto_DataType_UNDEFINED) {
+    return false;
+  }
+  const TypeMeta* meta = nullptr;
+  try {
+    meta = &DataTypeToTypeMeta(shape.data_type());
+  } catch (const std::exception&) {
+    return false;
+  }
+  if (meta->ctor() || meta->dtor()) {
+    return false;
+  }
+  size_t size = 1;
+  for (auto d : shape.dims()) {
+    if (d < 0) {
+      return false;
+    }
+    size *= d;
+  }
+  *nbytes = size * meta->itemsize();
+  return true;
+}
+} // namespace
+
+MemoryPlan plan_static_memory(
+    const NetDef& net,
+    const CaffeMap<string, TensorShape>& blob_shapes,
+    const std::set<string>& static_blobs,
+    PlacementStrategy strategy) {
+  MemoryPlan plan;
+  if (net.type() != "" && net.type() != "simple") {
+    LOG(INFO) << "Cannot plan memory for nets of type: " << net.type();
+    return plan;
+  }
+
+  // Step 1: lifetimes. A blob lives from the first op writing it to the last
+  // op touching it; a blob that some other blob aliases lives as long as the
+  // alias does.
+  std::unordered_map<string, std::pair<int, int>> ranges;
+  std::vector<string> order;
+  std::unordered_set<string> unplannable;
+  std::unordered_map<string, string> alias_of;
+  auto root = [&alias_of](string name) {
+    while (alias_of.count(name)) {
+      name = alias_of[name];
+    }
+    return name;
+  };
+  auto touch = [&](const string& name, int i) {
+    auto it = ranges.find(root(name));
+    if (it != ranges.end()) {
+      it->second.second = std::max(it->second.second, i);
+    }
+  };
+  for (int i = 0; i < net.op_size(); ++i) {
+    const auto& op = net.op(i);
+    for (const auto& in : op.input()) {
+      touch(in, i);
+    }
+    for (const auto& out : op.output()) {
+      if (isAliasingOp(op) && op.input_size() > 0) {
+        if (out != op.input(0)) {
+          alias_of[out] = op.input(0);
+        }
+        unplannable.insert(out);
+        touch(out, i);
+        continue;
+      }
+      if (!static_blobs.count(out) && !ranges.count(out)) {
+        ranges[out] = std::make_pair(i, i);
+        order.push_back(out);
+      }
+      touch(out, i);
+    }
+  }
+  for (const auto& out : net.external_output()) {
+    touch(out, net.op_size());
+  }
+
+  // Step 2: sizes, rounded up to the CPU allocator alignment so that every
+  // offset stays aligned.
+  std::vector<BlobAllocation> blobs;
+  for (const auto& name : order) {
+    auto shape = blob_shapes.find(name);
+    size_t nbytes = 0;
+    if (unplannable.count(name) || shape == blob_shapes.end() ||
+        !blobBytes(shape->second, &nbytes) || nbytes == 0) {
+      continue;
+    }
+    nbytes = (nbytes + gCaffe2Alignment - 1) / gCaffe2Alignment *
+        gCaffe2Alignment;
+    const auto& range = ranges[name];
+    blobs.push_back({name, 0, nbytes, range.first, range.second});
+    plan.total_blob_bytes += nbytes;
+  }
+
+  // Step 3: offsets. Each blob goes in the smallest gap left between the
+  // already placed blobs it overlaps in time, or past all of them.
+  std::vector<size_t> placement_order(blobs.size());
+  for (size_t i = 0; i < blobs.size(); ++i) {
+    placement_order[i] = i;
+  }
+  if (strategy == PlacementStrategy::GREEDY_BY_SIZE) {
+    std::stable_sort(
+        placement_order.begin(),
+        placement_order.end(),
+        [&blobs](size_t a, size_t b) {
+          return blobs[a].nbytes > blobs[b].nbytes;
+        });
+  }
+  std::vector<const BlobAllocation*> placed;
+  for (size_t index : placement_order) {
+    auto& blob = blobs[index];
+    std::vector<const BlobAllocation*> live;
+    for (const auto* other : placed) {
+      if (other->first_op <= blob.last_op && blob.first_op <= other->last_op) {
+        live.push_back(other);
+      }
+    }
+    std::sort(
+        live.begin(),
+        live.end(),
+        [](const BlobAllocation* a, const BlobAllocation* b) {
+          return a->offset < b->offset;
+        });
+    size_t best_offset = 0;
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t cursor = 0;
+    for (const auto* other : live) {
+      if (other->offset >= cursor + blob.nbytes &&
+          other->offset - cursor < best_gap) {
+        best_gap = other->offset - cursor;
+        best_offset = cursor;
+      }
+      cursor = std::max(cursor, other->offset + other->nbytes);
+    }
+    blob.offset =
+        best_gap == std::numeric_limits<size_t>::max() ? cursor : best_offset;
+    plan.arena_bytes = std::max(plan.arena_bytes, blob.offset + blob.nbytes);
+    placed.push_back(&blob);
+  }
+
+  plan.allocations = std::move(blobs);
+  VLOG(1) << "planned " << plan.allocations.size() << " blobs into "
+          << plan.arena_bytes << " bytes, down from " << plan.total_blob_bytes;
+  return plan;
+}
+
 } // memonger
 } // caffe2
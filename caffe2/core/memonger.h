@@ -1,6 +1,7 @@
 #ifndef CAFFE2_CORE_MEMONGER_H_
 #define CAFFE2_CORE_MEMONGER_H_
 
+#include <set>
 #include <unordered_set>
 
 #include "caffe2/core/common.h"
@@ -23,6 +24,49 @@ NetDef compute_blob_recycling_for_dag(
     const std::unordered_set<string>& dont_share_blob_names,
     const std::unordered_map<string, vector<int>>& blob_shapes);
 
+// Ahead-of-time memory plan for a net with known blob shapes. Instead of
+// renaming blobs so that they share buffers, every planned blob is given a
+// fixed byte range of a single arena; two blobs whose lifetimes overlap never
+// overlap in the arena. Binding the blobs to their ranges before running the
+// net means the run itself allocates nothing as long as shapes don't grow.
+struct BlobAllocation {
+  string blob;
+  size_t offset;
+  size_t nbytes;
+  // Index of the op first writing the blob and of the op last touching it.
+  int first_op;
+  int last_op;
+};
+
+struct MemoryPlan {
+  std::vector<BlobAllocation> allocations;
+  // Size of the arena that holds all planned blobs.
+  size_t arena_bytes = 0;
+  // What allocating every planned blob separately would take.
+  size_t total_blob_bytes = 0;
+};
+
+enum class PlacementStrategy {
+  // Place the largest blobs first, each in the smallest gap that fits
+  // (Pisarchyk and Lee, "Efficient Memory Management for Deep Neural Net
+  // Inference"). Usually the smaller arena.
+  GREEDY_BY_SIZE,
+  // Place blobs in the order the net creates them, each in the smallest gap
+  // that fits, like a best-fit allocator would at run time.
+  BEST_FIT,
+};
+
+// Plans the blobs produced by the ops of a "simple" (sequential) net. Blobs
+// in static_blobs (e.g. weights and inputs), blobs without a known shape and
+// blobs of non-fundamental types are left out of the plan. External outputs
+// are kept alive until the end of the net. Returns an empty plan for other
+// net types, whose ops may run in a different order.
+MemoryPlan plan_static_memory(
+    const NetDef& net,
+    const CaffeMap<string, TensorShape>& blob_shapes,
+    const std::set<string>& static_blobs,
+    PlacementStrategy strategy = PlacementStrategy::GREEDY_BY_SIZE);
+
 } // memonger
 } // caffe2
 
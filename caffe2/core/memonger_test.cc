@@ -0,0 +1,95 @@
+#include "caffe2/core/memonger.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+// a -> b -> c -> d, with a also read by the last op.
+const char* kChainNet = R"DOC(
+    name: "chain"
+    type: "simple"
+    external_input: "x"
+    external_output: "d"
+    op { input: "x" output: "a" type: "Relu" }
+    op { input: "a" output: "b" type: "Relu" }
+    op { input: "b" output: "c" type: "Relu" }
+    op { input: "c" input: "a" output: "d" type: "Add" }
+)DOC";
+
+TensorShape floatShape(const std::vector<int>& dims) {
+  TensorShape shape;
+  for (auto d : dims) {
+    shape.add_dims(d);
+  }
+  shape.set_data_type(TensorProto_DataType_FLOAT);
+  return shape;
+}
+
+CaffeMap<string, TensorShape> chainShapes() {
+  CaffeMap<string, TensorShape> shapes;
+  shapes["x"] = floatShape({16, 16});
+  shapes["a"] = floatShape({16, 16});
+  shapes["b"] = floatShape({64, 16});
+  shapes["c"] = floatShape({16, 16});
+  shapes["d"] = floatShape({16, 16});
+  return shapes;
+}
+
+void checkNoLiveOverlap(const memonger::MemoryPlan& plan) {
+  for (const auto& x : plan.allocations) {
+    EXPECT_LE(x.offset + x.nbytes, plan.arena_bytes);
+    EXPECT_EQ(x.offset % gCaffe2Alignment, 0);
+    for (const auto& y : plan.allocations) {
+      if (&x == &y || x.last_op < y.first_op || y.last_op < x.first_op) {
+        continue;
+      }
+      EXPECT_TRUE(
+          x.offset + x.nbytes <= y.offset || y.offset + y.nbytes <= x.offset)
+          << x.blob << " and " << y.blob << " overlap";
+    }
+  }
+}
+
+} // namespace
+
+TEST(MemongerTest, StaticPlanReusesDeadBlobs) {
+  NetDef net;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(kChainNet, &net));
+  for (auto strategy : {memonger::PlacementStrategy::GREEDY_BY_SIZE,
+                        memonger::PlacementStrategy::BEST_FIT}) {
+    auto plan =
+        memonger::plan_static_memory(net, chainShapes(), {"x"}, strategy);
+    EXPECT_EQ(plan.allocations.size(), 4);
+    checkNoLiveOverlap(plan);
+    // b is dead once c is computed, so d can take its place.
+    EXPECT_LT(plan.arena_bytes, plan.total_blob_bytes);
+  }
+}
+
+TEST(MemongerTest, StaticPlanSkipsUnknownAndStatic) {
+  NetDef net;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(kChainNet, &net));
+  auto shapes = chainShapes();
+  shapes.erase("b");
+  auto plan = memonger::plan_static_memory(net, shapes, {"x", "c"});
+  std::set<string> planned;
+  for (const auto& allocation : plan.allocations) {
+    planned.insert(allocation.blob);
+  }
+  EXPECT_EQ(planned, (std::set<string>{"a", "d"}));
+  // a is still read by the op writing d.
+  EXPECT_EQ(plan.arena_bytes, 2 * 16 * 16 * sizeof(float));
+}
+
+TEST(MemongerTest, StaticPlanOnlySimpleNets) {
+  NetDef net;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(kChainNet, &net));
+  net.set_type("dag");
+  auto plan = memonger::plan_static_memory(net, chainShapes(), {"x"});
+  EXPECT_TRUE(plan.allocations.empty());
+}
+
+} // namespace caffe2
@@ -173,7 +173,34 @@ unique_ptr<NetBase> CreateNet(
   return net;
 }
 
-TaskThreadPool* ExecutorHelper::GetPool(
+namespace {
+
+std::shared_ptr<const NetDef> PrepareTemplateNetDef(const NetDef& net_def) {
+  std::shared_ptr<NetDef> prepared(new NetDef(net_def));
+  if (prepared->has_device_option()) {
+    for (auto& op : *prepared->mutable_op()) {
+      if (!op.has_device_option()) {
+        op.mutable_device_option()->CopyFrom(prepared->device_option());
+      }
+    }
+  }
+  return prepared;
+}
+
+} // namespace
+
+NetTemplate::NetTemplate(const NetDef& net_def)
+    : net_def_(PrepareTemplateNetDef(net_def)),
+      creator_cache_(new OperatorCreatorCache(net_def_)) {}
+
+NetTemplate::~NetTemplate() {}
+
+unique_ptr<NetBase> NetTemplate::CreateNet(Workspace* ws) const {
+  OperatorCreatorCache::Scope scope(creator_cache_.get());
+  return caffe2::CreateNet(net_def_, ws);
+}
+
+TaskThreadPoolBase* ExecutorHelper::GetPool(
     const DeviceOption& /* unused */) const {
   CAFFE_THROW("Not implemented");
 }
@@ -31,6 +31,7 @@ typedef std::function<std::unique_ptr<NetObserver>(NetBase*)>
     NetObserverCreator;
 
 class OperatorBase;
+class OperatorCreatorCache;
 class Workspace;
 
 // Net is a thin struct that owns all the operators together with the operator
@@ -130,7 +131,7 @@ class NetBase : public Observable<NetBase> {
 class ExecutorHelper {
  public:
   ExecutorHelper() {}
-  virtual TaskThreadPool* GetPool(const DeviceOption& option) const;
+  virtual TaskThreadPoolBase* GetPool(const DeviceOption& option) const;
   virtual ~ExecutorHelper() {}
 };
 
@@ -156,6 +157,34 @@ unique_ptr<NetBase> CreateNet(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws);
 
+/**
+ * @brief A net def prepared for creating many nets from it cheaply, e.g. one
+ * per request workspace.
+ *
+ * The first net created from the template checks its operators against their
+ * schemas and picks their engines, and the next ones only call the creators
+ * it picked, which construct the operators and bind their blobs. The nets
+ * share the net def of the template, whose operators are given the device
+ * option of the net rather than being copied by every net. Thread-safe.
+ */
+class NetTemplate {
+ public:
+  explicit NetTemplate(const NetDef& net_def);
+  ~NetTemplate();
+
+  unique_ptr<NetBase> CreateNet(Workspace* ws) const;
+
+  const std::shared_ptr<const NetDef>& net_def() const {
+    return net_def_;
+  }
+
+ private:
+  std::shared_ptr<const NetDef> net_def_;
+  std::unique_ptr<OperatorCreatorCache> creator_cache_;
+
+  DISABLE_COPY_AND_ASSIGN(NetTemplate);
+};
+
 void AddGlobalNetObserverCreator(NetObserverCreator creator);
 
 void ClearGlobalNetObservers();
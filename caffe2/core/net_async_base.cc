@@ -1,8 +1,13 @@
 #include "caffe2/core/net_async_base.h"
 
+#include <map>
+#include <sstream>
+
 #include "caffe2/core/net_async_tracing.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/thread_topology.h"
 #include "caffe2/core/timer.h"
+#include "caffe2/utils/lock_free_thread_pool.h"
 
 // experimental support for multiple streams per worker per GPU
 CAFFE2_DEFINE_int(
@@ -53,6 +58,56 @@ CAFFE2_DEFINE_bool(
     false,
     "Use per net thread pools");
 
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_lock_free_cpu_pool,
+    false,
+    "Use CPU thread pools backed by a lock-free MPMC task queue");
+
+CAFFE2_DEFINE_int(
+    caffe2_net_async_lock_free_queue_size,
+    4096,
+    "Capacity of the lock-free task queue of each CPU thread pool");
+
+CAFFE2_DEFINE_int(
+    caffe2_net_async_lock_free_spin_iterations,
+    4096,
+    "Number of times an idle lock-free pool worker polls the queue"
+    " before parking");
+
+CAFFE2_DEFINE_double(
+    caffe2_net_async_chain_coarsening_threshold_us,
+    0,
+    "Merge chains of operators into the chains they depend on as long as the"
+    " merged chains cost at most this many microseconds, 0 to disable; the"
+    " chain_coarsening_threshold_us argument of a net overrides it");
+
+CAFFE2_DEFINE_double(
+    caffe2_net_async_chain_coarsening_gflops,
+    10,
+    "Throughput used to convert the inferred flops of the operators into"
+    " their costs when coarsening chains without an op cost profile");
+
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_cpu_fast_path,
+    true,
+    "Only use the event of the last operator of the tasks made of synchronous"
+    " CPU operators, and don't wait for their parents' events if these are"
+    " such tasks too");
+
+CAFFE2_DEFINE_string(
+    caffe2_net_async_stream_assignment,
+    "round_robin",
+    "How tasks are assigned CUDA streams: 'round_robin' per worker thread, or"
+    " 'coloring' once per net, keeping dependency chains on one stream and"
+    " independent branches on different ones");
+
+CAFFE2_DEFINE_string(
+    caffe2_net_async_priority_stream_op_types,
+    "NCCLAllreduce,NCCLBroadcast,NCCLReduce,NCCLAllGather,NCCLReduceScatter",
+    "Comma separated types of the collective operators whose CUDA tasks, and"
+    " the ones feeding them, run on priority streams with 'coloring' stream"
+    " assignment");
+
 namespace caffe2 {
 
 thread_local std::vector<int> AsyncNetBase::stream_counters_;
@@ -71,18 +126,69 @@ AsyncNetBase::AsyncNetBase(
   }
 
   execution_chains_ = dag_utils::computeChains(operator_nodes_);
+  const float coarsening_threshold_us =
+      ArgumentHelper::GetSingleArgument<NetDef, float>(
+          *net_def,
+          "chain_coarsening_threshold_us",
+          FLAGS_caffe2_net_async_chain_coarsening_threshold_us);
+  if (coarsening_threshold_us > 0) {
+    // The costs come from the op cost profile of the net if it has one, and
+    // from the cost inference functions of the operators otherwise
+    std::vector<float> op_costs_us;
+    if (dag_utils::readOperatorCostProfile(*net_def, ws, &op_costs_us)) {
+      for (auto& cost : op_costs_us) {
+        cost *= 1000;
+      }
+    } else {
+      op_costs_us = dag_utils::inferOperatorCostsUs(
+          *net_def, ws, FLAGS_caffe2_net_async_chain_coarsening_gflops * 1000);
+    }
+    execution_chains_ = dag_utils::coarsenChains(
+        operator_nodes_,
+        execution_chains_,
+        op_costs_us,
+        coarsening_threshold_us);
+  }
   chains_.reserve(execution_chains_.size());
   for (const auto& kv : execution_chains_) {
     chains_.push_back(kv.second);
   }
   chain_nodes_ = dag_utils::prepareChainGraphNodes(operator_nodes_, chains_);
 
+  // A task of synchronous CPU operators is finished once it returns, and its
+  // children are only scheduled then, so the event of its last operator is
+  // all it needs, and its children don't wait for it
+  cpu_sync_tasks_.assign(chains_.size(), false);
+  skip_wait_tasks_.assign(chains_.size(), false);
+  if (FLAGS_caffe2_net_async_cpu_fast_path) {
+    for (int task_id = 0; task_id < (int)chains_.size(); ++task_id) {
+      bool cpu_sync = true;
+      for (auto op_id : chains_[task_id]) {
+        const auto* op = operators_[op_id];
+        if (op->device_option().device_type() != CPU || op->HasAsyncPart()) {
+          cpu_sync = false;
+          break;
+        }
+      }
+      cpu_sync_tasks_[task_id] = cpu_sync;
+    }
+    for (int task_id = 0; task_id < (int)chains_.size(); ++task_id) {
+      bool skip_wait = cpu_sync_tasks_[task_id];
+      for (auto parent_id : chain_nodes_[task_id].parents_) {
+        skip_wait = skip_wait && cpu_sync_tasks_[parent_id];
+      }
+      skip_wait_tasks_[task_id] = skip_wait;
+    }
+  }
+
   events_.reserve(chains_.size());
-  for (const auto& chain : chains_) {
+  for (int task_id = 0; task_id < (int)chains_.size(); ++task_id) {
+    const auto& chain = chains_[task_id];
     const auto& last_op = operators_[chain.back()];
     events_.push_back(&last_op->event());
     for (const auto& op_id : chain) {
-      if (op_id == chain.back() || op_id == chain.front()) {
+      if (op_id == chain.back() ||
+          (op_id == chain.front() && !cpu_sync_tasks_[task_id])) {
         continue;
       }
       const auto& op = operators_[op_id];
@@ -90,7 +196,11 @@ AsyncNetBase::AsyncNetBase(
     }
   }
 
-  num_workers_ = net_def->has_num_workers() ? net_def->num_workers() : -1;
+  // the "num_workers" argument replaces the deprecated NetDef field
+  num_workers_ = ArgumentHelper::GetSingleArgument<NetDef, int>(
+      *net_def,
+      "num_workers",
+      net_def->has_num_workers() ? net_def->num_workers() : -1);
 
   tracer_ = tracing::create(this, net_def->name());
   if (tracer_) {
@@ -98,6 +208,15 @@ AsyncNetBase::AsyncNetBase(
   }
 
   computeExecutionModeFlags();
+
+  const auto& stream_assignment = FLAGS_caffe2_net_async_stream_assignment;
+  CAFFE_ENFORCE(
+      stream_assignment == "round_robin" || stream_assignment == "coloring",
+      "Unknown stream assignment: ",
+      stream_assignment);
+  if (stream_assignment == "coloring") {
+    assignStreams();
+  }
 }
 
 bool AsyncNetBase::handleRunError() {
@@ -116,7 +235,7 @@ bool AsyncNetBase::RunAsync() {
   return DoRunAsync();
 }
 
-TaskThreadPool* AsyncNetBase::pool_getter(
+TaskThreadPoolBase* AsyncNetBase::pool_getter(
     PoolsMap& pools,
     int device_type,
     int device_id,
@@ -131,7 +250,7 @@ TaskThreadPool* AsyncNetBase::pool_getter(
   return pool.get();
 }
 
-TaskThreadPool* AsyncNetBase::pool(const DeviceOption& device_option) {
+TaskThreadPoolBase* AsyncNetBase::pool(const DeviceOption& device_option) {
   if (use_single_pool_) {
     return pool_getter(cpu_pools_, CPU, -1, num_workers_);
   }
@@ -162,6 +281,9 @@ TaskThreadPool* AsyncNetBase::pool(const DeviceOption& device_option) {
 }
 
 int AsyncNetBase::stream(int task_id) {
+  if (!task_streams_.empty()) {
+    return task_streams_[task_id];
+  }
   const auto& device_option = event(task_id).GetDeviceOption();
   int stream_id = 0;
   if (device_option.device_type() == CUDA) {
@@ -178,6 +300,105 @@ int AsyncNetBase::stream(int task_id) {
   return stream_id;
 }
 
+void AsyncNetBase::assignStreams() {
+  CAFFE_ENFORCE_LT(
+      streams_per_gpu_,
+      CAFFE2_PRIORITY_STREAM_ID_BASE,
+      "Too many streams per GPU");
+  std::unordered_set<std::string> priority_op_types;
+  {
+    std::stringstream stream(FLAGS_caffe2_net_async_priority_stream_op_types);
+    std::string op_type;
+    while (std::getline(stream, op_type, ',')) {
+      if (!op_type.empty()) {
+        priority_op_types.insert(op_type);
+      }
+    }
+  }
+
+  // Collective tasks and the ones they depend on run on priority streams
+  std::vector<bool> priority(tasksNum(), false);
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    for (auto op_id : chains_[task_id]) {
+      if (operators_[op_id]->has_debug_def() &&
+          priority_op_types.count(operators_[op_id]->type())) {
+        priority[task_id] = true;
+        for (auto parent_id : parents(task_id)) {
+          priority[parent_id] = true;
+        }
+        break;
+      }
+    }
+  }
+
+  // A task continues the stream of its first parent on the same device and
+  // of the same priority whose stream no other child continued already, and
+  // starts a new branch on the least used stream its parents don't use
+  // otherwise
+  task_streams_.assign(tasksNum(), 0);
+  std::vector<bool> continued(tasksNum(), false);
+  std::map<std::pair<int, bool>, std::vector<int>> stream_loads;
+  for (auto task_id : tasksInTopologicalOrder()) {
+    const auto& device_option = event(task_id).GetDeviceOption();
+    if (device_option.device_type() != CUDA) {
+      continue;
+    }
+    const int base = priority[task_id] ? CAFFE2_PRIORITY_STREAM_ID_BASE : 0;
+    int stream_id = -1;
+    std::unordered_set<int> parent_streams;
+    for (auto parent_id : parents(task_id)) {
+      const auto& parent_option = event(parent_id).GetDeviceOption();
+      if (!IsSameDevice(parent_option, device_option) ||
+          priority[parent_id] != priority[task_id]) {
+        continue;
+      }
+      parent_streams.insert(task_streams_[parent_id] - base);
+      if (stream_id == -1 && !continued[parent_id]) {
+        continued[parent_id] = true;
+        stream_id = task_streams_[parent_id] - base;
+      }
+    }
+
+    auto& loads = stream_loads[{device_option.cuda_gpu_id(),
+                                priority[task_id]}];
+    loads.resize(streams_per_gpu_, 0);
+    if (stream_id == -1) {
+      stream_id = 0;
+      for (int candidate = 1; candidate < streams_per_gpu_; ++candidate) {
+        auto key = [&](int id) {
+          return std::make_pair(parent_streams.count(id), loads[id]);
+        };
+        if (key(candidate) < key(stream_id)) {
+          stream_id = candidate;
+        }
+      }
+    }
+    ++loads[stream_id];
+    task_streams_[task_id] = base + stream_id;
+  }
+}
+
+std::vector<int> AsyncNetBase::tasksInTopologicalOrder() const {
+  std::vector<int> order;
+  std::vector<int> parents_left(tasksNum());
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    parents_left[task_id] = parents(task_id).size();
+    if (parents_left[task_id] == 0) {
+      order.push_back(task_id);
+    }
+  }
+  for (size_t idx = 0; idx < order.size(); ++idx) {
+    for (auto child_id : children(order[idx])) {
+      if (--parents_left[child_id] == 0) {
+        order.push_back(child_id);
+      }
+    }
+  }
+  CAFFE_ENFORCE_EQ(
+      static_cast<int>(order.size()), tasksNum(), "Cycle in net ", name_);
+  return order;
+}
+
 bool AsyncNetBase::isStreamFree(int task_id, int stream_id) const {
   auto& task = chains_[task_id];
   auto& last_task_op = operators_[task.back()];
@@ -208,7 +429,7 @@ bool AsyncNetBase::canSchedule(
     bool can_schedule = Event::CanSchedule(
         operators_[last_parent_op_id]->event().GetType(),
         parent_status,
-        operators_[first_child_op_id]->event().GetType(),
+        firstEventType(task_id),
         operators_[first_child_op_id]->SupportsAsyncScheduling());
     if (!can_schedule) {
       return false;
@@ -225,10 +446,18 @@ bool AsyncNetBase::canSchedule(int parent_id, int child_id) {
   return Event::CanSchedule(
       parent_event.GetType(),
       parent_event.Query(),
-      first_child_op->event().GetType(),
+      firstEventType(child_id),
       first_child_op->SupportsAsyncScheduling());
 }
 
+int AsyncNetBase::firstEventType(int task_id) const {
+  if (cpu_sync_tasks_[task_id]) {
+    // the event of the first operator may be disabled
+    return CPU;
+  }
+  return operators_[chains_[task_id].front()]->event().GetType();
+}
+
 int AsyncNetBase::tasksNum() const {
   return chains_.size();
 }
@@ -332,9 +561,10 @@ bool AsyncNetBase::run(int task_id, int stream_id) {
     // Optionally insert async wait ops,
     // skip when using --caffe2_net_async_finish_chain -
     // all parents are guaranteed to be finished
-    if (!finish_chain_) {
+    if (!finish_chain_ && !skip_wait_tasks_[task_id]) {
       asyncWait(task_id, stream_id, parents(task_id));
     }
+    const bool tracing = tracer_ && tracer_->isEnabled();
     for (auto& op_id : chains_[task_id]) {
       op = operators_[op_id];
       TRACE_EVENT(
@@ -344,7 +574,20 @@ bool AsyncNetBase::run(int task_id, int stream_id) {
           task_id,
           tracing::TRACE_STREAM,
           stream_id);
+      int stream_timing = -1;
+      if (tracing) {
+        if (op_id == chains_[task_id].front()) {
+          tracer_->recordFlows(op_id, task_id, parents(task_id), false);
+        }
+        stream_timing = tracer_->startStreamTiming(op_id, task_id, stream_id);
+      }
       bool success = op->RunAsync(stream_id);
+      if (tracing) {
+        tracer_->stopStreamTiming(stream_timing);
+        if (op_id == chains_[task_id].back()) {
+          tracer_->recordFlows(op_id, task_id, children(task_id), true);
+        }
+      }
       if (!success) {
         auto err_msg = "Failed to execute an op: " +
             (op->has_debug_def() ? op->type() : " unknown");
@@ -402,28 +645,54 @@ AsyncNetBase::~AsyncNetBase() {}
 
 CAFFE_DEFINE_SHARED_REGISTRY(
     ThreadPoolRegistry,
-    TaskThreadPool,
+    TaskThreadPoolBase,
     int,
     int,
     bool);
 
 CAFFE_REGISTER_CREATOR(ThreadPoolRegistry, CPU, GetAsyncNetCPUThreadPool);
 
+namespace {
+std::shared_ptr<TaskThreadPoolBase> createCPUThreadPool(
+    int pool_size,
+    int numa_node_id) {
+  if (FLAGS_caffe2_net_async_lock_free_cpu_pool) {
+    return std::make_shared<LockFreeTaskThreadPool>(
+        pool_size,
+        numa_node_id,
+        FLAGS_caffe2_net_async_lock_free_queue_size,
+        FLAGS_caffe2_net_async_lock_free_spin_iterations);
+  }
+  return std::make_shared<TaskThreadPool>(pool_size, numa_node_id);
+}
+} // namespace
+
 /* static */
-std::shared_ptr<TaskThreadPool>
+std::shared_ptr<TaskThreadPoolBase>
 GetAsyncNetCPUThreadPool(int numa_node_id, int pool_size, bool create_new) {
   // Note: numa_node_id = -1 (DeviceOption's default value) corresponds to
   // no NUMA used
-  static std::
-      unordered_map<int, std::unordered_map<int, std::weak_ptr<TaskThreadPool>>>
-          pools;
+  static std::unordered_map<
+      int,
+      std::unordered_map<int, std::weak_ptr<TaskThreadPoolBase>>>
+      pools;
   static std::mutex pool_mutex;
 
+  // With a thread topology, the pool of a NUMA node gets the inter-op
+  // threads of its socket, and the pool without one those of all sockets
+  const auto* topology = GetThreadTopology();
+  const auto* socket =
+      topology ? topology->FindSocket(numa_node_id) : nullptr;
   if (pool_size <= 0) {
     if (FLAGS_caffe2_net_async_cpu_pool_size > 0) {
       pool_size = FLAGS_caffe2_net_async_cpu_pool_size;
       LOG(INFO) << "Using default CPU pool size: " << pool_size
                 << "; NUMA node id: " << numa_node_id;
+    } else if (socket) {
+      pool_size = numa_node_id < 0 ? topology->TotalInterOpThreads()
+                                   : socket->inter_op_threads;
+      LOG(INFO) << "Using thread topology CPU pool size: " << pool_size
+                << "; NUMA node id: " << numa_node_id;
     } else {
       auto num_cores = std::thread::hardware_concurrency();
       CAFFE_ENFORCE(num_cores > 0, "Failed to get number of CPU cores");
@@ -439,7 +708,7 @@ GetAsyncNetCPUThreadPool(int numa_node_id, int pool_size, bool create_new) {
   if (create_new) {
     LOG(INFO) << "Created new CPU pool, size: " << pool_size
               << "; NUMA node id: " << numa_node_id;
-    return std::make_shared<TaskThreadPool>(pool_size, numa_node_id);
+    return createCPUThreadPool(pool_size, numa_node_id);
   } else {
     std::lock_guard<std::mutex> lock(pool_mutex);
 
@@ -447,7 +716,7 @@ GetAsyncNetCPUThreadPool(int numa_node_id, int pool_size, bool create_new) {
     if (!shared_pool) {
       LOG(INFO) << "Created shared CPU pool, size: " << pool_size
                 << "; NUMA node id: " << numa_node_id;
-      shared_pool = std::make_shared<TaskThreadPool>(pool_size, numa_node_id);
+      shared_pool = createCPUThreadPool(pool_size, numa_node_id);
       pools[numa_node_id][pool_size] = shared_pool;
     }
     return shared_pool;
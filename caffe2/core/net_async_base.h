@@ -22,6 +22,9 @@ CAFFE2_DECLARE_int(caffe2_net_async_cpu_pool_size);
 CAFFE2_DECLARE_bool(caffe2_net_async_check_stream_status);
 CAFFE2_DECLARE_bool(caffe2_net_async_use_single_pool);
 CAFFE2_DECLARE_bool(caffe2_net_async_use_per_net_pools);
+CAFFE2_DECLARE_bool(caffe2_net_async_cpu_fast_path);
+CAFFE2_DECLARE_string(caffe2_net_async_stream_assignment);
+CAFFE2_DECLARE_string(caffe2_net_async_priority_stream_op_types);
 
 namespace caffe2 {
 
@@ -50,12 +53,21 @@ class AsyncNetBase : public NetBase {
     return execution_chains_;
   }
 
+  const std::vector<std::vector<int>>& TEST_chains() const {
+    return chains_;
+  }
+
+  const std::vector<int>& TEST_task_streams() const {
+    return task_streams_;
+  }
+
  protected:
   bool canSchedule(
       int chain_id,
       const std::vector<EventStatus>* status = nullptr,
       bool* parent_failed = nullptr);
   bool canSchedule(int parent_id, int child_id);
+  int firstEventType(int task_id) const;
 
   int tasksNum() const;
   Event& event(int task_id) const;
@@ -73,7 +85,9 @@ class AsyncNetBase : public NetBase {
       const std::vector<int>& wait_task_ids) const;
   bool run(int task_id, int stream_id);
   int stream(int task_id);
-  TaskThreadPool* pool(const DeviceOption& device_option);
+  void assignStreams();
+  std::vector<int> tasksInTopologicalOrder() const;
+  TaskThreadPoolBase* pool(const DeviceOption& device_option);
 
   void finishTasks(const std::unordered_set<int>& task_ids);
   void finalizeEvents();
@@ -90,17 +104,22 @@ class AsyncNetBase : public NetBase {
   std::vector<std::vector<int>> chains_;
   std::vector<dag_utils::OpGraphNode> chain_nodes_; // chains' parents/children
   dag_utils::ExecutionChains execution_chains_; // for testing
+  // tasks of synchronous CPU operators, and the ones whose parents are too
+  std::vector<bool> cpu_sync_tasks_;
+  std::vector<bool> skip_wait_tasks_;
 
   // Pools and streams
   std::mutex pools_mutex_;
   // first int key - device id, second - pool size, one pool per (device, size)
   typedef std::unordered_map<
       int,
-      std::unordered_map<int, std::shared_ptr<TaskThreadPool>>>
+      std::unordered_map<int, std::shared_ptr<TaskThreadPoolBase>>>
       PoolsMap;
   PoolsMap cpu_pools_;
   PoolsMap gpu_pools_;
   static thread_local std::vector<int> stream_counters_;
+  // streams of the tasks with 'coloring' stream assignment, empty otherwise
+  std::vector<int> task_streams_;
   int num_workers_;
 
   // Exception/error handling
@@ -130,7 +149,7 @@ class AsyncNetBase : public NetBase {
  private:
   void storeExceptionPtr();
 
-  TaskThreadPool*
+  TaskThreadPoolBase*
   pool_getter(PoolsMap& pools, int device_type, int device_id, int pool_size);
 
   std::unique_ptr<AsyncNetExecutorHelper> helper_;
@@ -141,7 +160,7 @@ class AsyncNetBase : public NetBase {
 
 CAFFE_DECLARE_SHARED_REGISTRY(
     ThreadPoolRegistry,
-    TaskThreadPool,
+    TaskThreadPoolBase,
     int,
     int,
     bool);
@@ -149,7 +168,7 @@ CAFFE_DECLARE_SHARED_REGISTRY(
 class AsyncNetExecutorHelper : public ExecutorHelper {
  public:
   explicit AsyncNetExecutorHelper(AsyncNetBase* net) : net_(net) {}
-  TaskThreadPool* GetPool(const DeviceOption& option) const override {
+  TaskThreadPoolBase* GetPool(const DeviceOption& option) const override {
     return net_->pool(option);
   }
 
@@ -157,7 +176,7 @@ class AsyncNetExecutorHelper : public ExecutorHelper {
   AsyncNetBase* net_;
 };
 
-std::shared_ptr<TaskThreadPool>
+std::shared_ptr<TaskThreadPoolBase>
 GetAsyncNetCPUThreadPool(int numa_node_id, int pool_size, bool create_new);
 
 } // namespace caffe2
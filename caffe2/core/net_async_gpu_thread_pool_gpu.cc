@@ -8,14 +8,14 @@ namespace caffe2 {
 
 CAFFE_REGISTER_CREATOR(ThreadPoolRegistry, CUDA, GetAsyncNetGPUThreadPool);
 
-std::shared_ptr<TaskThreadPool>
+std::shared_ptr<TaskThreadPoolBase>
 GetAsyncNetGPUThreadPool(int gpu_id, int pool_size, bool create_new) {
   // For GPU, use per device thread pools of predefined constant size
   if (pool_size != FLAGS_caffe2_threads_per_gpu) {
     LOG(INFO) << "Overriding GPU pool size: using "
               << FLAGS_caffe2_threads_per_gpu << " threads per GPU";
   }
-  static std::unordered_map<int, std::weak_ptr<TaskThreadPool>> pools;
+  static std::unordered_map<int, std::weak_ptr<TaskThreadPoolBase>> pools;
   static std::mutex pool_mutex;
 
   if (create_new) {
@@ -25,7 +25,7 @@ GetAsyncNetGPUThreadPool(int gpu_id, int pool_size, bool create_new) {
   } else {
     std::lock_guard<std::mutex> lock(pool_mutex);
 
-    std::shared_ptr<TaskThreadPool> shared_pool = nullptr;
+    std::shared_ptr<TaskThreadPoolBase> shared_pool = nullptr;
     if (pools.count(gpu_id)) {
       shared_pool = pools.at(gpu_id).lock();
     }
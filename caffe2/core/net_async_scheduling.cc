@@ -1,5 +1,7 @@
 #include "caffe2/core/net_async_scheduling.h"
 
+#include <algorithm>
+
 #include "caffe2/core/net_async_tracing.h"
 
 CAFFE2_DEFINE_bool(
@@ -12,7 +14,11 @@ namespace caffe2 {
 AsyncSchedulingNet::AsyncSchedulingNet(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws)
-    : AsyncNetBase(net_def, ws), running_(false), use_dfs_scheduling_(false) {
+    : AsyncNetBase(net_def, ws),
+      running_(false),
+      use_dfs_scheduling_(false),
+      use_critical_path_scheduling_(false),
+      critical_path_ms_(0) {
   for (int arg_idx = 0; arg_idx < net_def->arg_size(); ++arg_idx) {
     auto& arg = net_def->arg(arg_idx);
     if (arg.has_name() && arg.name() == "deferrable_mode") {
@@ -21,6 +27,88 @@ AsyncSchedulingNet::AsyncSchedulingNet(
       break;
     }
   }
+  const auto policy = ArgumentHelper::GetSingleArgument<NetDef, std::string>(
+      *net_def, "scheduling_policy", "default");
+  CAFFE_ENFORCE(
+      policy == "default" || policy == "critical_path",
+      "Unknown scheduling policy: ",
+      policy);
+  use_critical_path_scheduling_ = policy == "critical_path";
+  if (use_critical_path_scheduling_) {
+    initRanks(*net_def, ws);
+  }
+  initPriorities();
+}
+
+void AsyncSchedulingNet::initRanks(const NetDef& net_def, Workspace* ws) {
+  std::vector<float> op_costs;
+  const bool has_profile =
+      dag_utils::readOperatorCostProfile(net_def, ws, &op_costs);
+
+  // The ranks are computed in reverse topological order of the tasks
+  const auto order = tasksInTopologicalOrder();
+
+  task_ranks_.assign(tasksNum(), 0);
+  critical_path_ms_ = 0;
+  for (auto it = order.rbegin(); it != order.rend(); ++it) {
+    const auto task_id = *it;
+    float cost = 0;
+    for (auto op_id : chains_[task_id]) {
+      cost += has_profile ? op_costs[op_id] : 1;
+    }
+    float children_rank = 0;
+    for (auto child_id : children(task_id)) {
+      children_rank = std::max(children_rank, task_ranks_[child_id]);
+    }
+    task_ranks_[task_id] = cost + children_rank;
+    critical_path_ms_ = std::max(critical_path_ms_, task_ranks_[task_id]);
+  }
+
+  if (has_profile) {
+    stats_ = caffe2::make_unique<SchedulingStats>(
+        "async_scheduling_net/" + net_def.name());
+  } else {
+    // Without a profile the ranks only count operators
+    critical_path_ms_ = 0;
+  }
+}
+
+bool AsyncSchedulingNet::runsBefore(int a, int b) const {
+  if (task_priorities_[a] != task_priorities_[b]) {
+    return task_priorities_[a] < task_priorities_[b];
+  }
+  return use_critical_path_scheduling_ && task_ranks_[a] > task_ranks_[b];
+}
+
+void AsyncSchedulingNet::initPriorities() {
+  // The priority of a task is the lowest priority of its operators
+  task_priorities_.assign(tasksNum(), 0);
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    for (auto op_id : chains_[task_id]) {
+      const auto* op = operators_[op_id];
+      if (op->has_debug_def() && op->HasArgument("priority")) {
+        task_priorities_[task_id] = std::min(
+            task_priorities_[task_id],
+            op->GetSingleArgument<int>("priority", 0));
+      }
+    }
+  }
+
+  // Tasks that become ready at the same time are scheduled in the order of
+  // their priorities, then of their ranks with critical path scheduling, and
+  // in the order of the net otherwise
+  auto by_priority = [this](int a, int b) { return runsBefore(a, b); };
+  for (auto& task_node : chain_nodes_) {
+    std::stable_sort(
+        task_node.children_.begin(), task_node.children_.end(), by_priority);
+  }
+  root_tasks_.clear();
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    if (parents(task_id).empty()) {
+      root_tasks_.push_back(task_id);
+    }
+  }
+  std::stable_sort(root_tasks_.begin(), root_tasks_.end(), by_priority);
 }
 
 void AsyncSchedulingNet::reset() {
@@ -42,7 +130,7 @@ void AsyncSchedulingNet::schedule(int task_id, bool run_inline) {
   auto schedule_func = [this, task_id]() {
     if (success_) {
       int stream_id = 0;
-      if (streams_per_gpu_ > 1) {
+      if (streams_per_gpu_ > 1 || !task_streams_.empty()) {
         stream_id = stream(task_id);
       }
       if (!run(task_id, stream_id)) {
@@ -157,8 +245,38 @@ void AsyncSchedulingNet::schedule(int task_id, bool run_inline) {
     schedule_func();
   } else {
     const auto& device_option = event(task_id).GetDeviceOption();
-    pool(device_option)->run(schedule_func);
+    auto* task_pool = pool(device_option);
+    if (use_critical_path_scheduling_) {
+      // The job runs whichever ready task of the pool comes first by then
+      {
+        std::unique_lock<std::mutex> lock(ready_tasks_mutex_);
+        auto& heap = ready_tasks_[task_pool];
+        heap.push_back({task_priorities_[task_id],
+                        task_ranks_[task_id],
+                        chains_[task_id].front(),
+                        std::move(schedule_func)});
+        std::push_heap(heap.begin(), heap.end());
+      }
+      task_pool->run(
+          std::bind(&AsyncSchedulingNet::runReadyTask, this, task_pool));
+    } else {
+      task_pool->run(schedule_func);
+    }
+  }
+}
+
+void AsyncSchedulingNet::runReadyTask(TaskThreadPoolBase* pool) {
+  // Every job pushes a task first, so the heap can't be empty
+  std::function<void()> func;
+  {
+    std::unique_lock<std::mutex> lock(ready_tasks_mutex_);
+    auto& heap = ready_tasks_[pool];
+    CAFFE_ENFORCE(!heap.empty());
+    std::pop_heap(heap.begin(), heap.end());
+    func = std::move(heap.back().func);
+    heap.pop_back();
   }
+  func();
 }
 
 void AsyncSchedulingNet::parentCallback(int parent_id) {
@@ -195,6 +313,15 @@ void AsyncSchedulingNet::pollAndSchedule(int task_id) {
 }
 
 void AsyncSchedulingNet::finishRun() {
+  if (stats_) {
+    const auto makespan_ms = run_timer_.MilliSeconds();
+    auto& stats = *stats_;
+    CAFFE_EVENT(stats, runs);
+    CAFFE_EVENT(stats, makespan_us, makespan_ms * 1000);
+    CAFFE_EVENT(stats, critical_path_us, critical_path_ms_ * 1000);
+    VLOG(1) << "Net " << name_ << " ran in " << makespan_ms
+            << " ms, critical path " << critical_path_ms_ << " ms";
+  }
   {
     std::unique_lock<std::mutex> lock(running_mutex_);
     running_ = false;
@@ -215,14 +342,13 @@ bool AsyncSchedulingNet::RunAsync() {
     }
     running_ = true;
     reset();
+    run_timer_.Start();
 
     StartAllObservers();
     tracing::startIter(tracer_);
 
-    for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
-      if (parents(task_id).empty()) {
-        schedule(task_id);
-      }
+    for (auto task_id : root_tasks_) {
+      schedule(task_id);
     }
   } catch (const std::exception& e) {
     LOG(ERROR) << "Exception while starting an async run: " << e.what();
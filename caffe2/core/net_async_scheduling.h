@@ -5,6 +5,20 @@
 
 namespace caffe2 {
 
+// Tasks that become ready at the same time are scheduled in the order of the
+// "priority" arguments of their operators, lower first (0 by default), e.g.
+// to start the allreduce of the gradients of the first layers first.
+//
+// With the "scheduling_policy" argument of the net set to "critical_path",
+// ties are broken by the upward rank of the tasks, the cost of the longest
+// path from a task to the end of the net, and each pool runs the ready task
+// of the highest priority first instead of the one that became ready first.
+// The costs of the operators are the mean execution times of a per-operator
+// ProfDAGProtos, e.g. the output of GetProfDagStats with per_op set, read from
+// the file of the "op_cost_profile" argument or from the blob of the
+// "op_cost_profile_blob" argument, and 1 for every operator otherwise. With a
+// profile, the makespan of every run and the critical path it is bounded by
+// are exported as the stats of "async_scheduling_net/<net name>".
 class AsyncSchedulingNet : public AsyncNetBase {
  public:
   AsyncSchedulingNet(
@@ -14,6 +28,10 @@ class AsyncSchedulingNet : public AsyncNetBase {
 
   void Wait() override;
 
+  float TEST_critical_path_ms() const {
+    return critical_path_ms_;
+  }
+
  protected:
   bool RunAsync() override;
 
@@ -22,11 +40,50 @@ class AsyncSchedulingNet : public AsyncNetBase {
   void reset() override;
   virtual void finishRun();
   void parentCallback(int parent_id);
+  void initPriorities();
+  void initRanks(const NetDef& net_def, Workspace* ws);
+  bool runsBefore(int a, int b) const;
+  void runReadyTask(TaskThreadPoolBase* pool);
 
   std::mutex running_mutex_;
   std::condition_variable running_cv_;
   std::atomic<bool> running_;
   bool use_dfs_scheduling_;
+  std::vector<int> root_tasks_;
+  std::vector<int> task_priorities_;
+
+  // Critical path scheduling
+  struct ReadyTask {
+    int priority;
+    float rank;
+    int first_op;
+    std::function<void()> func;
+
+    // Tasks of lower priority sort first, the top of the heap runs first
+    bool operator<(const ReadyTask& other) const {
+      if (priority != other.priority) {
+        return priority > other.priority;
+      }
+      if (rank != other.rank) {
+        return rank < other.rank;
+      }
+      return first_op > other.first_op;
+    }
+  };
+  struct SchedulingStats {
+    CAFFE_STAT_CTOR(SchedulingStats);
+    CAFFE_EXPORTED_STAT(runs);
+    CAFFE_EXPORTED_STAT(makespan_us);
+    CAFFE_EXPORTED_STAT(critical_path_us);
+  };
+  bool use_critical_path_scheduling_;
+  std::vector<float> task_ranks_;
+  float critical_path_ms_;
+  std::mutex ready_tasks_mutex_;
+  // heaps of the tasks ready to run on each pool
+  std::unordered_map<TaskThreadPoolBase*, std::vector<ReadyTask>> ready_tasks_;
+  std::unique_ptr<SchedulingStats> stats_;
+  Timer run_timer_;
 
   std::atomic<int> processed_tasks_num_;
 
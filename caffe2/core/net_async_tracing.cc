@@ -31,8 +31,8 @@ CAFFE2_DEFINE_string(
 
 CAFFE2_DEFINE_int(caffe2_net_async_tracing_nth, 100, "Trace every Nth batch");
 
-// For every Nth iterations, we will dump the tracing results to a json file
-// The file is appended with the iteration number.
+// Every Nth iterations, we start a new json file for the tracing results,
+// named after the number of the period of N iterations.
 CAFFE2_DEFINE_int(
     caffe2_net_async_tracing_dumping_nth,
     10000,
@@ -41,6 +41,25 @@ CAFFE2_DEFINE_int(
 namespace caffe2 {
 namespace tracing {
 
+CAFFE_DEFINE_TYPED_REGISTRY(
+    StreamTimerRegistry,
+    int,
+    StreamTimer,
+    std::unique_ptr);
+
+namespace {
+
+// Thread labels of the rows of the device streams, above the ones of the
+// CPU threads
+const long kStreamRowOffset = 1000000000000L;
+
+long streamRowLabel(const DeviceOption& option, int stream_id) {
+  return kStreamRowOffset +
+      (option.device_type() * 1000L + DeviceId(option)) * 1000L + stream_id;
+}
+
+} // namespace
+
 int getCounterForNetName(const std::string& net_name) {
   // Append a unique number suffix because there could be multiple instances
   // of the same net and we want to uniquely associate each instance with
@@ -66,6 +85,114 @@ void Tracer::recordEvent(const TracerEvent& event) {
   events_.push_back(event);
 }
 
+void Tracer::recordFlows(
+    int op_id,
+    int task_id,
+    const std::vector<int>& other_tasks,
+    bool to_children) {
+  if (other_tasks.empty()) {
+    return;
+  }
+  TracerEvent event;
+  event.op_id_ = op_id;
+  event.task_id_ = task_id;
+  event.tid_ = std::this_thread::get_id();
+  event.is_beginning_ = to_children;
+  event.timestamp_ = (long)caffe2::round(timer_.MicroSeconds());
+  // unique over the edges between the tasks (which are fewer than the ops) of
+  // all the iterations in a file
+  const int64_t num_ops = net_->GetOperators().size();
+  std::lock_guard<std::mutex> lock(tracer_mutex_);
+  for (auto other_task : other_tasks) {
+    const int64_t parent = to_children ? task_id : other_task;
+    const int64_t child = to_children ? other_task : task_id;
+    event.flow_id_ = ((int64_t)iter_ * num_ops + parent) * num_ops + child;
+    events_.push_back(event);
+  }
+}
+
+StreamTimer* Tracer::getStreamTimer(int device_type) {
+  auto it = stream_timers_.find(device_type);
+  if (it == stream_timers_.end()) {
+    std::unique_ptr<StreamTimer> timer;
+    if (StreamTimerRegistry()->Has(device_type)) {
+      timer = StreamTimerRegistry()->Create(device_type);
+    }
+    it = stream_timers_.emplace(device_type, std::move(timer)).first;
+  }
+  return it->second.get();
+}
+
+int Tracer::startStreamTiming(int op_id, int task_id, int stream_id) {
+  const auto& option = net_->GetOperators().at(op_id)->device_option();
+  std::lock_guard<std::mutex> lock(tracer_mutex_);
+  auto* timer = getStreamTimer(option.device_type());
+  if (!timer) {
+    return -1;
+  }
+  // The first operator of a device in the iteration synchronizes a marker
+  // with the CPU timer, which places the others on the time line. It only
+  // waits for the work queued before the iteration.
+  auto device = std::make_pair(option.device_type(), DeviceId(option));
+  if (!stream_references_.count(device)) {
+    void* marker = timer->record(option, stream_id);
+    timer->synchronize(marker);
+    stream_references_[device] = StreamReference{
+        timer, marker, (long)caffe2::round(timer_.MicroSeconds())};
+  }
+  stream_timings_.push_back(StreamTiming{op_id,
+                                         task_id,
+                                         stream_id,
+                                         timer,
+                                         timer->record(option, stream_id),
+                                         nullptr});
+  return stream_timings_.size() - 1;
+}
+
+void Tracer::stopStreamTiming(int timing_id) {
+  if (timing_id < 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(tracer_mutex_);
+  auto& timing = stream_timings_.at(timing_id);
+  const auto& option = net_->GetOperators().at(timing.op_id)->device_option();
+  timing.end = timing.timer->record(option, timing.stream_id);
+}
+
+void Tracer::resolveStreamTimings() {
+  for (const auto& timing : stream_timings_) {
+    const auto& option =
+        net_->GetOperators().at(timing.op_id)->device_option();
+    const auto& reference = stream_references_.at(
+        std::make_pair(option.device_type(), DeviceId(option)));
+    if (timing.end) {
+      TracerEvent event;
+      event.op_id_ = timing.op_id;
+      event.task_id_ = timing.task_id;
+      event.stream_id_ = timing.stream_id;
+      event.category_ = "stream";
+      event.thread_label_ = streamRowLabel(option, timing.stream_id);
+      event.is_beginning_ = true;
+      event.timestamp_ = reference.timestamp +
+          (long)caffe2::round(timing.timer->elapsedMicroSeconds(
+              reference.marker, timing.start));
+      events_.push_back(event);
+      event.is_beginning_ = false;
+      event.timestamp_ = reference.timestamp +
+          (long)caffe2::round(timing.timer->elapsedMicroSeconds(
+              reference.marker, timing.end));
+      events_.push_back(event);
+      timing.timer->release(timing.end);
+    }
+    timing.timer->release(timing.start);
+  }
+  stream_timings_.clear();
+  for (const auto& kv : stream_references_) {
+    kv.second.timer->release(kv.second.marker);
+  }
+  stream_references_.clear();
+}
+
 // Forward
 int getUniqueShardId(const OperatorDef& op_def);
 
@@ -108,7 +235,19 @@ std::string Tracer::serializeEvent(const TracerEvent& event) {
     serialized_event << " \"tid\": " << event.tid_ << ",\n";
   }
 
-  if (event.is_beginning_) {
+  if (event.flow_id_ >= 0) {
+    // bound to the op slice that encloses it, at the end of the parent task
+    // and at the beginning of the child one
+    serialized_event << " \"name\": \"dependency\",\n";
+    serialized_event << " \"cat\": \"flow\",\n";
+    serialized_event << " \"id\": " << event.flow_id_ << ",\n";
+    if (event.is_beginning_) {
+      serialized_event << " \"ph\": \"s\"";
+    } else {
+      serialized_event << " \"ph\": \"f\",\n";
+      serialized_event << " \"bp\": \"e\"";
+    }
+  } else if (event.is_beginning_) {
     std::unordered_map<std::string, int> int_args;
     std::unordered_map<std::string, std::string> string_args;
     if (event.name_) {
@@ -206,9 +345,9 @@ void Tracer::linearizeEvents() {
 }
 
 void Tracer::renameThreads() {
-  std::unordered_map<long, int> tids;
-  std::unordered_map<int, int> numa_counters;
-  std::unordered_map<long, int> tid_to_numa;
+  auto& tids = thread_ids_;
+  auto& numa_counters = numa_counters_;
+  auto& tid_to_numa = thread_to_numa_;
   std::hash<std::thread::id> hasher;
   const long numa_multiplier = 1000000000;
   for (auto& event : events_) {
@@ -250,30 +389,61 @@ int Tracer::bumpIter() {
   return iter_++;
 }
 
-void Tracer::dumpTracingResultAndClearEvents(const std::string& file_suffix) {
+void Tracer::flushEvents() {
+  std::lock_guard<std::mutex> lock(tracer_mutex_);
+  resolveStreamTimings();
   if (events_.empty() || filename_.empty()) {
     return;
   }
   linearizeEvents();
   renameThreads();
-  std::stringstream serialized;
-  serialized << "[\n";
-  for (size_t idx = 0; idx < events_.size(); ++idx) {
-    serialized << serializeEvent(events_[idx]);
-    if (idx != events_.size() - 1) {
-      serialized << ",\n";
+  if (!file_) {
+    auto output_file_name = filename_ + "_iter_" + file_suffix_ + ".json";
+    LOG(INFO) << "Dumping profiling result file to " << output_file_name;
+    file_.reset(new std::ofstream(output_file_name));
+    *file_ << "[\n";
+    file_has_events_ = false;
+    named_rows_.clear();
+  }
+  for (const auto& event : events_) {
+    if (file_has_events_) {
+      *file_ << ",\n";
+    }
+    file_has_events_ = true;
+    if (event.thread_label_ >= kStreamRowOffset &&
+        !named_rows_.count(event.thread_label_)) {
+      const auto& option =
+          net_->GetOperators().at(event.op_id_)->device_option();
+      *file_ << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+             << "\"tid\": " << event.thread_label_ << ", \"args\": {\"name\": \""
+             << DeviceTypeName(option.device_type()) << " "
+             << DeviceId(option) << " stream " << event.stream_id_
+             << "\"}},\n";
+      named_rows_.insert(event.thread_label_);
     }
+    *file_ << serializeEvent(event);
   }
-  serialized << "\n]\n";
-
-  auto output_file_name = filename_ + "_iter_" + file_suffix + ".json";
-  LOG(INFO) << "Dumping profiling result file to " << output_file_name;
-  WriteStringToFile(serialized.str(), output_file_name.c_str());
+  file_->flush();
   events_.clear();
 }
 
+void Tracer::closeFile() {
+  if (file_) {
+    *file_ << "\n]\n";
+    file_.reset();
+  }
+}
+
+void Tracer::startNewFile(const std::string& file_suffix) {
+  std::lock_guard<std::mutex> lock(tracer_mutex_);
+  closeFile();
+  file_suffix_ = file_suffix;
+}
+
 Tracer::~Tracer() {
-  dumpTracingResultAndClearEvents("final_batch");
+  flushEvents();
+  std::lock_guard<std::mutex> lock(tracer_mutex_);
+  closeFile();
 }
 
 void TracerGuard::init(Tracer* tracer) {
@@ -402,12 +572,14 @@ bool startIter(const std::shared_ptr<Tracer>& tracer) {
     return false;
   }
   auto iter = tracer->bumpIter();
-  auto is_enabled = iter % FLAGS_caffe2_net_async_tracing_nth == 0;
-  tracer->setEnabled(is_enabled);
+  // the previous iteration is over, write its events
+  tracer->flushEvents();
   if (iter % FLAGS_caffe2_net_async_tracing_dumping_nth == 0) {
     int dumping_iter = iter / FLAGS_caffe2_net_async_tracing_dumping_nth;
-    tracer->dumpTracingResultAndClearEvents(caffe2::to_string(dumping_iter));
+    tracer->startNewFile(caffe2::to_string(dumping_iter));
   }
+  auto is_enabled = iter % FLAGS_caffe2_net_async_tracing_nth == 0;
+  tracer->setEnabled(is_enabled);
   return is_enabled;
 }
 
@@ -17,9 +17,13 @@
 #ifndef CAFFE2_CORE_NET_ASYNC_TRACING_H_
 #define CAFFE2_CORE_NET_ASYNC_TRACING_H_
 
+#include <fstream>
+#include <unordered_set>
+
 #include "caffe2/core/common.h"
 #include "caffe2/core/net_async_base.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/registry.h"
 #include "caffe2/core/timer.h"
 
 CAFFE2_DECLARE_string(caffe2_net_async_tracing_filepath);
@@ -39,6 +43,9 @@ struct TracerEvent {
   bool is_beginning_ = false;
   long thread_label_ = -1;
   std::thread::id tid_;
+  // flow events link the end of a task to the beginning of a child task;
+  // is_beginning_ tells the start of the arrow from its end
+  int64_t flow_id_ = -1;
 };
 
 enum TracingField {
@@ -50,11 +57,54 @@ enum TracingField {
   TRACE_CATEGORY,
 };
 
+// Times the work queued on the streams of a type of device, e.g. with CUDA
+// events, so that the traces have a row per stream with the time its
+// operators actually ran on the device. Markers are only compared with the
+// ones of the same device.
+class StreamTimer {
+ public:
+  virtual ~StreamTimer() {}
+  // Returns a marker recorded on the stream stream_id of the device of
+  // option, after the work queued on it so far
+  virtual void* record(const DeviceOption& option, int stream_id) = 0;
+  // Waits until the work before the marker is done
+  virtual void synchronize(void* marker) = 0;
+  // Microseconds from start to end, waiting for end
+  virtual float elapsedMicroSeconds(void* start, void* end) = 0;
+  virtual void release(void* marker) = 0;
+};
+
+CAFFE_DECLARE_TYPED_REGISTRY(
+    StreamTimerRegistry,
+    int,
+    StreamTimer,
+    std::unique_ptr);
+#define REGISTER_STREAM_TIMER(device_type, ...) \
+  CAFFE_REGISTER_TYPED_CLASS(StreamTimerRegistry, device_type, __VA_ARGS__)
+
+// Records the events of the traced iterations of a net and writes them in
+// the Chrome trace format. The events of an iteration are appended to the
+// trace file when the next one starts, and a new file is started every
+// caffe2_net_async_tracing_dumping_nth iterations, so that only one
+// iteration is kept in memory.
 class Tracer {
  public:
   Tracer(const NetBase* net, const std::string& net_name);
 
   void recordEvent(const TracerEvent& event);
+  // Records the flow events between the task task_id, which runs the
+  // operator op_id, and its parents (at its beginning) or its children (at
+  // its end)
+  void recordFlows(
+      int op_id,
+      int task_id,
+      const std::vector<int>& other_tasks,
+      bool to_children);
+  // Records markers before and after the operator op_id on its stream when
+  // its device has a StreamTimer. Returns the timing to pass to
+  // stopStreamTiming, or -1.
+  int startStreamTiming(int op_id, int task_id, int stream_id);
+  void stopStreamTiming(int timing_id);
   std::string opTraceName(const OperatorBase* op);
   std::string opBlobsInfo(const OperatorBase& op);
   std::string serializeEvent(const TracerEvent& event);
@@ -63,16 +113,49 @@ class Tracer {
   void setEnabled(bool enabled);
   bool isEnabled() const;
   int bumpIter();
-  // Dump the tracing result to file with given suffix, and then
-  // clear current events.
-  void dumpTracingResultAndClearEvents(const std::string& file_suffix);
+  // Appends the events recorded so far to the trace file, and then clears
+  // them.
+  void flushEvents();
+  // Terminates the current trace file; the next events go to a file with the
+  // given suffix.
+  void startNewFile(const std::string& file_suffix);
 
   virtual ~Tracer();
 
  private:
+  struct StreamTiming {
+    int op_id;
+    int task_id;
+    int stream_id;
+    StreamTimer* timer;
+    void* start;
+    void* end;
+  };
+  // Marker of a device synchronized with the CPU timer at timestamp
+  struct StreamReference {
+    StreamTimer* timer;
+    void* marker;
+    long timestamp;
+  };
+
+  StreamTimer* getStreamTimer(int device_type);
+  void resolveStreamTimings();
+  void closeFile();
+
   const NetBase* net_ = nullptr;
   std::string filename_;
+  std::string file_suffix_ = "0";
+  std::unique_ptr<std::ofstream> file_;
+  bool file_has_events_ = false;
+  std::unordered_set<long> named_rows_;
   std::vector<TracerEvent> events_;
+  std::vector<StreamTiming> stream_timings_;
+  std::map<std::pair<int, int>, StreamReference> stream_references_;
+  std::unordered_map<int, std::unique_ptr<StreamTimer>> stream_timers_;
+  // thread labels of renameThreads, kept from one iteration to the next
+  std::unordered_map<long, int> thread_ids_;
+  std::unordered_map<int, int> numa_counters_;
+  std::unordered_map<long, int> thread_to_numa_;
   std::mutex tracer_mutex_;
   bool enabled_ = false;
   Timer timer_;
@@ -0,0 +1,43 @@
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/net_async_tracing.h"
+
+namespace caffe2 {
+namespace tracing {
+
+namespace {
+
+// The markers are CUDA events with timing, unlike the ones of the operators
+class CUDAStreamTimer final : public StreamTimer {
+ public:
+  void* record(const DeviceOption& option, int stream_id) override {
+    DeviceGuard g(option.cuda_gpu_id());
+    cudaEvent_t event;
+    CUDA_ENFORCE(cudaEventCreate(&event));
+    CUDA_ENFORCE(cudaEventRecord(
+        event, CUDAContext::cuda_stream(option.cuda_gpu_id(), stream_id)));
+    return static_cast<void*>(event);
+  }
+
+  void synchronize(void* marker) override {
+    CUDA_ENFORCE(cudaEventSynchronize(static_cast<cudaEvent_t>(marker)));
+  }
+
+  float elapsedMicroSeconds(void* start, void* end) override {
+    synchronize(end);
+    float ms = 0;
+    CUDA_ENFORCE(cudaEventElapsedTime(
+        &ms, static_cast<cudaEvent_t>(start), static_cast<cudaEvent_t>(end)));
+    return ms * 1000;
+  }
+
+  void release(void* marker) override {
+    CUDA_CHECK(cudaEventDestroy(static_cast<cudaEvent_t>(marker)));
+  }
+};
+
+} // namespace
+
+REGISTER_STREAM_TIMER(CUDA, CUDAStreamTimer);
+
+} // namespace tracing
+} // namespace caffe2
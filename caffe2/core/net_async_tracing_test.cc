@@ -15,6 +15,11 @@
  */
 
 #include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+
+#include <google/protobuf/text_format.h>
+#include "caffe2/core/net.h"
 #include "caffe2/core/net_async_tracing.h"
 
 namespace caffe2 {
@@ -37,6 +42,58 @@ TEST(NetAsyncTracingTest, ExtractShardId) {
   testExtractShardId("FC:shard:15", 15);
 }
 
+TEST(NetAsyncTracingTest, FlowEventsAreStreamedToFile) {
+  const std::string spec = R"DOC(
+        name: "tracing_flows"
+        type: "async_scheduling"
+        arg { name: "enable_tracing" i: 1 }
+        op {
+          output: "a"
+          type: "ConstantFill"
+          arg { name: "shape" ints: 16 }
+        }
+        op { input: "a" output: "b" type: "Relu" }
+        op { input: "a" output: "c" type: "Relu" }
+        op {
+          input: "b"
+          input: "c"
+          output: "d"
+          output: "d_info"
+          type: "Concat"
+          arg { name: "axis" i: 0 }
+        }
+  )DOC";
+  NetDef net_def;
+  CAFFE_ENFORCE(
+      google::protobuf::TextFormat::ParseFromString(spec, &net_def));
+  FLAGS_caffe2_net_async_tracing_filepath = "/tmp";
+  const int nth = FLAGS_caffe2_net_async_tracing_nth;
+  FLAGS_caffe2_net_async_tracing_nth = 2;
+  {
+    Workspace ws;
+    auto net = CreateNet(net_def, &ws);
+    for (int i = 0; i < 4; ++i) {
+      ASSERT_TRUE(net->Run());
+    }
+    // the events of the traced iterations are written as the nets run
+    std::ifstream streamed("/tmp/tracing_flows_id_1_iter_0.json");
+    ASSERT_TRUE(streamed.good());
+    std::stringstream content;
+    content << streamed.rdbuf();
+    EXPECT_NE(content.str().find("\"ph\": \"B\""), std::string::npos);
+  }
+  FLAGS_caffe2_net_async_tracing_nth = nth;
+
+  std::ifstream file("/tmp/tracing_flows_id_1_iter_0.json");
+  std::stringstream content;
+  content << file.rdbuf();
+  const auto trace = content.str();
+  // the fill, and both Relus, start flows to their children
+  EXPECT_NE(trace.find("\"ph\": \"s\""), std::string::npos);
+  EXPECT_NE(trace.find("\"bp\": \"e\""), std::string::npos);
+  EXPECT_EQ(trace.substr(trace.size() - 3), "\n]\n");
+}
+
 } // namespace tracing
 
 } // namespace caffe2
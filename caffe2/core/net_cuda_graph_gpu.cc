@@ -0,0 +1,177 @@
+#include "caffe2/core/net_cuda_graph_gpu.h"
+
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+CUDAGraphNet::CUDAGraphNet(
+    const std::shared_ptr<const NetDef>& net_def,
+    Workspace* ws)
+    : SimpleNet(net_def, ws),
+      capturable_(!operators_.empty()),
+      gpu_id_(-1),
+      capture_failed_(false),
+#if CUDA_VERSION >= 10000
+      graph_exec_(nullptr),
+#endif
+      captures_(0),
+      replays_(0) {
+#if CUDA_VERSION < 10000
+  capturable_ = false;
+  LOG(WARNING) << "CUDA graphs require CUDA 10, net " << name_
+               << " runs as a simple net";
+#endif
+  for (auto& op : operators_) {
+    // Events are recorded on the host and can't be captured
+    op->DisableEvent();
+    const auto& device_option = op->device_option();
+    if (device_option.device_type() != CUDA ||
+        (gpu_id_ >= 0 && device_option.cuda_gpu_id() != gpu_id_)) {
+      if (capturable_) {
+        LOG(WARNING) << "Net " << name_ << " has operators that are not on "
+                     << "a single GPU, it runs as a simple net";
+      }
+      capturable_ = false;
+      break;
+    }
+    gpu_id_ = device_option.cuda_gpu_id();
+  }
+}
+
+CUDAGraphNet::~CUDAGraphNet() {
+  resetGraph();
+}
+
+bool CUDAGraphNet::blobStates(std::vector<BlobState>* states) {
+  states->clear();
+  auto add_state = [states](const Blob* blob) {
+    if (!blob->IsType<TensorCUDA>()) {
+      return false;
+    }
+    const auto& tensor = blob->Get<TensorCUDA>();
+    states->push_back(BlobState{blob, tensor.raw_data(), tensor.dims()});
+    return true;
+  };
+  for (auto& op : operators_) {
+    for (const auto* blob : op->Inputs()) {
+      if (!add_state(blob)) {
+        return false;
+      }
+    }
+    for (const auto* blob : op->Outputs()) {
+      if (!add_state(blob)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void CUDAGraphNet::resetGraph() {
+#if CUDA_VERSION >= 10000
+  if (graph_exec_) {
+    DeviceGuard guard(gpu_id_);
+    CUDA_CHECK(cudaGraphExecDestroy(graph_exec_));
+    graph_exec_ = nullptr;
+  }
+#endif
+}
+
+bool CUDAGraphNet::capture() {
+#if CUDA_VERSION >= 10000
+  DeviceGuard guard(gpu_id_);
+  auto stream = CUDAContext::cuda_stream(gpu_id_, 0);
+  CUDA_ENFORCE(cudaStreamSynchronize(stream));
+#if CUDA_VERSION >= 10010
+  CUDA_ENFORCE(
+      cudaStreamBeginCapture(stream, cudaStreamCaptureModeThreadLocal));
+#else
+  CUDA_ENFORCE(cudaStreamBeginCapture(stream));
+#endif
+  bool captured = true;
+  try {
+    for (auto& op : operators_) {
+      if (!op->RunAsync(0)) {
+        captured = false;
+        break;
+      }
+    }
+  } catch (const std::exception& e) {
+    VLOG(1) << "Failed to capture net " << name_ << ": " << e.what();
+    captured = false;
+  }
+  cudaGraph_t graph = nullptr;
+  if (cudaStreamEndCapture(stream, &graph) != cudaSuccess) {
+    captured = false;
+  }
+  if (captured &&
+      cudaGraphInstantiate(&graph_exec_, graph, nullptr, nullptr, 0) !=
+          cudaSuccess) {
+    graph_exec_ = nullptr;
+    captured = false;
+  }
+  if (graph) {
+    CUDA_CHECK(cudaGraphDestroy(graph));
+  }
+  if (!captured) {
+    // Clears the error of the failed capture
+    cudaGetLastError();
+    LOG(WARNING) << "Net " << name_ << " can't be captured into a CUDA graph"
+                 << ", it runs as a simple net until its blobs change";
+    return false;
+  }
+  ++captures_;
+  CUDA_ENFORCE(cudaGraphLaunch(graph_exec_, stream));
+  CUDA_ENFORCE(cudaStreamSynchronize(stream));
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool CUDAGraphNet::Run() {
+  if (!capturable_) {
+    return SimpleNet::Run();
+  }
+
+  std::vector<BlobState> states;
+  if (blobStates(&states) && states == states_) {
+#if CUDA_VERSION >= 10000
+    if (graph_exec_) {
+      StartAllObservers();
+      DeviceGuard guard(gpu_id_);
+      auto stream = CUDAContext::cuda_stream(gpu_id_, 0);
+      CUDA_ENFORCE(cudaGraphLaunch(graph_exec_, stream));
+      CUDA_ENFORCE(cudaStreamSynchronize(stream));
+      ++replays_;
+      StopAllObservers();
+      return true;
+    }
+#endif
+    if (!capture_failed_) {
+      StartAllObservers();
+      if (capture()) {
+        StopAllObservers();
+        return true;
+      }
+      StopAllObservers();
+      capture_failed_ = true;
+    }
+    return SimpleNet::Run();
+  }
+
+  // The blobs changed, runs the net once so that the operators allocate
+  // their outputs before capturing it
+  resetGraph();
+  capture_failed_ = false;
+  const bool result = SimpleNet::Run();
+  if (!result || !blobStates(&states_)) {
+    states_.clear();
+  }
+  return result;
+}
+
+REGISTER_NET(cuda_graph, CUDAGraphNet);
+
+} // namespace caffe2
@@ -0,0 +1,80 @@
+#ifndef CAFFE2_CORE_NET_CUDA_GRAPH_GPU_H_
+#define CAFFE2_CORE_NET_CUDA_GRAPH_GPU_H_
+
+#include <vector>
+
+#include "caffe2/core/common_gpu.h"
+#include "caffe2/core/net_simple.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+
+// Runs its operators in sequence like SimpleNet, and captures them into a
+// CUDA graph that it replays in later runs instead of launching every kernel.
+//
+// The first run with a given set of blobs, i.e. the same shapes and buffers
+// of the inputs and outputs of every operator, runs the operators as
+// SimpleNet does, which allocates their outputs. The second one with the same
+// blobs captures the operators on stream 0 of the calling thread and launches
+// the graph, and the following ones only launch it. When a blob changes shape
+// or buffer, e.g. after being fed a new tensor, the net starts over. Binding
+// the blobs to fixed buffers, e.g. with Predictor::plan_memory, keeps them
+// from changing.
+//
+// Only nets of CUDA operators on a single GPU that only read CUDA tensors are
+// captured, since the graph doesn't replay host computations. Operators that
+// can't be captured, e.g. the ones that synchronize with the host, make the
+// capture fail, and the net then runs normally until its blobs change. So do
+// operators allocating scratch memory on every run rather than keeping it,
+// which must not be used with this net. Requires CUDA 10, runs like SimpleNet
+// otherwise.
+class CUDAGraphNet : public SimpleNet {
+ public:
+  CUDAGraphNet(const std::shared_ptr<const NetDef>& net_def, Workspace* ws);
+  ~CUDAGraphNet() override;
+
+  int TEST_captures() const {
+    return captures_;
+  }
+
+  int TEST_replays() const {
+    return replays_;
+  }
+
+ protected:
+  bool Run() override;
+
+ private:
+  struct BlobState {
+    const Blob* blob;
+    const void* data;
+    std::vector<TIndex> dims;
+
+    bool operator==(const BlobState& other) const {
+      return blob == other.blob && data == other.data && dims == other.dims;
+    }
+  };
+
+  // Returns false if a blob is not a CUDA tensor
+  bool blobStates(std::vector<BlobState>* states);
+  bool capture();
+  void resetGraph();
+
+  bool capturable_;
+  int gpu_id_;
+  // blobs after the last normal run, and whether capturing with them failed
+  std::vector<BlobState> states_;
+  bool capture_failed_;
+#if CUDA_VERSION >= 10000
+  cudaGraphExec_t graph_exec_;
+#endif
+  int captures_;
+  int replays_;
+
+  DISABLE_COPY_AND_ASSIGN(CUDAGraphNet);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_NET_CUDA_GRAPH_GPU_H_
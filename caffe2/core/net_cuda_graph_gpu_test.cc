@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <google/protobuf/text_format.h>
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/net_cuda_graph_gpu.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+namespace {
+
+const char kScaleNet[] = R"DOC(
+  name: "cuda_graph"
+  type: "cuda_graph"
+  op {
+    input: "X"
+    output: "Y"
+    type: "Scale"
+    arg { name: "scale" f: 2.0 }
+    device_option { device_type: 1 }
+  }
+  op {
+    input: "Y"
+    output: "Z"
+    type: "Scale"
+    arg { name: "scale" f: 3.0 }
+    device_option { device_type: 1 }
+  }
+)DOC";
+
+void FeedX(Workspace* ws, const std::vector<TIndex>& dims, float offset) {
+  TensorCPU x(dims);
+  for (int i = 0; i < x.size(); ++i) {
+    x.mutable_data<float>()[i] = i + offset;
+  }
+  ws->CreateBlob("X")->GetMutable<TensorCUDA>()->CopyFrom(x);
+}
+
+void CheckZ(Workspace* ws, const std::vector<TIndex>& dims, float offset) {
+  TensorCPU z(ws->GetBlob("Z")->Get<TensorCUDA>());
+  ASSERT_EQ(z.dims(), dims);
+  for (int i = 0; i < z.size(); ++i) {
+    EXPECT_FLOAT_EQ(z.data<float>()[i], 6 * (i + offset));
+  }
+}
+
+} // namespace
+
+TEST(CUDAGraphNetTest, CaptureAndReplay) {
+#if CUDA_VERSION < 10000
+  return;
+#endif
+  if (!HasCudaGPU()) {
+    return;
+  }
+  NetDef net_def;
+  CAFFE_ENFORCE(
+      google::protobuf::TextFormat::ParseFromString(kScaleNet, &net_def));
+  Workspace ws;
+  FeedX(&ws, {2, 3}, 0);
+  NetBase* net = ws.CreateNet(net_def);
+  auto* graph_net = dynamic_cast<CUDAGraphNet*>(net);
+  ASSERT_TRUE(graph_net != nullptr);
+
+  // The first run allocates the outputs, the second one captures the net
+  for (int run = 0; run < 2; ++run) {
+    ASSERT_TRUE(net->Run());
+    CheckZ(&ws, {2, 3}, 0);
+  }
+  EXPECT_EQ(graph_net->TEST_captures(), 1);
+  EXPECT_EQ(graph_net->TEST_replays(), 0);
+
+  // New contents in the same buffer are replayed
+  for (int run = 1; run <= 3; ++run) {
+    FeedX(&ws, {2, 3}, run);
+    ASSERT_TRUE(net->Run());
+    CheckZ(&ws, {2, 3}, run);
+  }
+  EXPECT_EQ(graph_net->TEST_captures(), 1);
+  EXPECT_EQ(graph_net->TEST_replays(), 3);
+
+  // A new shape runs the net normally, and captures it again
+  for (int run = 0; run < 3; ++run) {
+    FeedX(&ws, {4, 5}, run);
+    ASSERT_TRUE(net->Run());
+    CheckZ(&ws, {4, 5}, run);
+  }
+  EXPECT_EQ(graph_net->TEST_captures(), 2);
+  EXPECT_EQ(graph_net->TEST_replays(), 4);
+}
+
+} // namespace caffe2
@@ -58,7 +58,11 @@ DAGNetBase::DAGNetBase(
     }
   }
   // Finally, start the workers.
-  int num_workers = net_def->has_num_workers() ? net_def->num_workers() : 1;
+  // the "num_workers" argument replaces the deprecated NetDef field
+  int num_workers = ArgumentHelper::GetSingleArgument<NetDef, int>(
+      *net_def,
+      "num_workers",
+      net_def->has_num_workers() ? net_def->num_workers() : 1);
   CAFFE_ENFORCE(num_workers > 0, "Must have a positive number of workers.");
   if (num_workers == 1) {
     LOG(WARNING) << "Number of workers is 1: this means that all operators "
@@ -1,5 +1,7 @@
 #include "caffe2/core/net_dag_utils.h"
 
+#include <algorithm>
+#include <limits>
 #include <set>
 #include <stack>
 #include <unordered_map>
@@ -9,6 +11,7 @@
 #include "caffe2/core/static_tracepoint.h"
 #include "caffe2/core/timer.h"
 #include "caffe2/proto/caffe2.pb.h"
+#include "caffe2/proto/prof_dag.pb.h"
 #include "caffe2/utils/proto_utils.h"
 
 namespace caffe2 {
@@ -287,6 +290,174 @@ ExecutionChains singleChains(std::vector<OperatorNode>& nodes) {
   return chains;
 }
 
+ExecutionChains coarsenChains(
+    std::vector<OperatorNode>& nodes,
+    const ExecutionChains& chains,
+    const std::vector<float>& op_costs,
+    float threshold) {
+  CAFFE_ENFORCE_EQ(op_costs.size(), nodes.size());
+  std::vector<int> op_chain(nodes.size(), -1);
+  std::vector<int> starts;
+  for (const auto& kv : chains) {
+    for (auto op_idx : kv.second) {
+      op_chain[op_idx] = kv.first;
+    }
+    starts.push_back(kv.first);
+  }
+  // Operators only depend on the ones before them, so visiting the chains in
+  // the order of their first operators visits the parents first
+  std::sort(starts.begin(), starts.end());
+
+  // Every merged chain only depends on the chains outside of it through its
+  // first chain, hence merging never introduces cycles
+  std::unordered_map<int, int> merged_into;
+  std::unordered_map<int, float> merged_cost;
+  ExecutionChains coarse;
+  for (auto start : starts) {
+    const auto& chain = chains.at(start);
+    float cost = 0;
+    for (auto op_idx : chain) {
+      if (op_costs[op_idx] < 0 || nodes[op_idx].operator_->HasAsyncPart()) {
+        cost = std::numeric_limits<float>::infinity();
+        break;
+      }
+      cost += op_costs[op_idx];
+    }
+
+    int parent_start = -1;
+    bool single_parent = true;
+    for (auto op_idx : chain) {
+      for (auto parent_idx : nodes[op_idx].parents_) {
+        if (op_chain[parent_idx] == start) {
+          continue;
+        }
+        auto merged_start = merged_into.at(op_chain[parent_idx]);
+        if (parent_start == -1) {
+          parent_start = merged_start;
+        } else if (parent_start != merged_start) {
+          single_parent = false;
+        }
+      }
+    }
+
+    if (parent_start != -1 && single_parent &&
+        merged_cost[parent_start] + cost <= threshold &&
+        IsSameDevice(
+            nodes[start].operator_->device_option(),
+            nodes[parent_start].operator_->device_option())) {
+      merged_into[start] = parent_start;
+      merged_cost[parent_start] += cost;
+      auto& merged = coarse[parent_start];
+      merged.insert(merged.end(), chain.begin(), chain.end());
+    } else {
+      merged_into[start] = start;
+      merged_cost[start] = cost;
+      coarse[start] = chain;
+    }
+  }
+  for (auto& kv : coarse) {
+    std::sort(kv.second.begin(), kv.second.end());
+  }
+  VLOG(1) << "Coarsened " << chains.size() << " chains into " << coarse.size();
+
+  updateOperatorNodes(nodes, coarse);
+  return coarse;
+}
+
+bool readOperatorCostProfile(
+    const NetDef& net_def,
+    Workspace* ws,
+    std::vector<float>* costs_ms) {
+  const auto profile_file = ArgumentHelper::GetSingleArgument<NetDef, string>(
+      net_def, "op_cost_profile", "");
+  const auto profile_blob = ArgumentHelper::GetSingleArgument<NetDef, string>(
+      net_def, "op_cost_profile_blob", "");
+  CAFFE_ENFORCE(
+      profile_file.empty() || profile_blob.empty(),
+      "Only one of op_cost_profile and op_cost_profile_blob can be set");
+  if (profile_file.empty() && profile_blob.empty()) {
+    return false;
+  }
+
+  ProfDAGProtos profile;
+  if (!profile_file.empty()) {
+    CAFFE_ENFORCE(
+        ReadProtoFromFile(profile_file, &profile),
+        "Cannot read the op cost profile ",
+        profile_file);
+  } else {
+    const auto* blob = ws->GetBlob(profile_blob);
+    CAFFE_ENFORCE(blob, "Cannot find the op cost profile blob ", profile_blob);
+    const auto& tensor = blob->Get<TensorCPU>();
+    CAFFE_ENFORCE_EQ(tensor.size(), 1, "Malformed op cost profile blob");
+    CAFFE_ENFORCE(
+        profile.ParseFromString(tensor.data<std::string>()[0]),
+        "Cannot parse the op cost profile blob ",
+        profile_blob);
+  }
+  CAFFE_ENFORCE_EQ(
+      profile.stats_size(),
+      net_def.op_size(),
+      "The op cost profile doesn't match the operators of net ",
+      net_def.name());
+
+  costs_ms->clear();
+  for (const auto& stats : profile.stats()) {
+    costs_ms->push_back(
+        stats.has_execution_time() ? stats.execution_time().mean()
+                                   : stats.mean());
+  }
+  return true;
+}
+
+std::vector<float> inferOperatorCostsUs(
+    const NetDef& net_def,
+    Workspace* ws,
+    float flops_per_us) {
+  std::vector<float> costs(net_def.op_size(), -1);
+  TensorShapes shapes;
+  try {
+    NetDef net_copy(net_def);
+    shapes = InferBlobShapesAndTypesFromWorkspace(ws, {&net_copy});
+  } catch (const EnforceNotMet& e) {
+    VLOG(1) << "Shape inference of net " << net_def.name()
+            << " failed: " << e.what();
+    return costs;
+  }
+  std::unordered_map<std::string, const TensorShape*> shape_of;
+  for (const auto& shape : shapes.shapes()) {
+    if (shape.has_name() && !shape.unknown_shape()) {
+      shape_of[shape.name()] = &shape;
+    }
+  }
+
+  for (int idx = 0; idx < net_def.op_size(); ++idx) {
+    const auto& op_def = net_def.op(idx);
+    const auto* schema = OpSchemaRegistry::Schema(op_def.type());
+    if (!schema || !schema->HasCostInferenceFunction()) {
+      continue;
+    }
+    std::vector<TensorShape> input_shapes;
+    for (const auto& input : op_def.input()) {
+      auto it = shape_of.find(input);
+      if (it == shape_of.end()) {
+        break;
+      }
+      input_shapes.push_back(*it->second);
+    }
+    if ((int)input_shapes.size() != op_def.input_size()) {
+      continue;
+    }
+    try {
+      costs[idx] = schema->InferCost(op_def, input_shapes).flops / flops_per_us;
+    } catch (const EnforceNotMet& e) {
+      VLOG(1) << "Cost inference of operator #" << idx << " ("
+              << op_def.type() << ") failed: " << e.what();
+    }
+  }
+  return costs;
+}
+
 std::vector<OperatorNode> prepareOperatorNodes(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws) {
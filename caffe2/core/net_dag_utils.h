@@ -47,6 +47,34 @@ ExecutionChains computeChains(std::vector<OperatorNode>& orig_nodes);
 
 ExecutionChains singleChains(std::vector<OperatorNode>& nodes);
 
+// Merges every chain whose parents all belong to the same merged chain into
+// it, as long as the operators of the merged chain cost no more than
+// threshold in total, are on the same device and have no async part. The
+// operators of a merged chain run in the order of the net. Operators of a
+// negative cost are never merged.
+ExecutionChains coarsenChains(
+    std::vector<OperatorNode>& nodes,
+    const ExecutionChains& chains,
+    const std::vector<float>& op_costs,
+    float threshold);
+
+// Reads the per-operator ProfDAGProtos of the file of the "op_cost_profile"
+// argument of the net, or of the blob of its "op_cost_profile_blob" argument,
+// into the mean execution times of the operators in milliseconds. Returns
+// false if the net has neither argument.
+bool readOperatorCostProfile(
+    const NetDef& net_def,
+    Workspace* ws,
+    std::vector<float>* costs_ms);
+
+// Estimates the execution times of the operators in microseconds from the
+// flops of their cost inference functions at flops_per_us, given the shapes
+// of the blobs of the workspace; -1 for the operators it can't infer.
+std::vector<float> inferOperatorCostsUs(
+    const NetDef& net_def,
+    Workspace* ws,
+    float flops_per_us);
+
 std::vector<OperatorNode> prepareOperatorNodes(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws);
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "caffe2/core/common_gpu.h"
 #include "caffe2/core/net.h"
+#include "caffe2/core/net_async_base.h"
 #include "caffe2/core/net_dag.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/scope_guard.h"
@@ -133,4 +134,89 @@ TEST(NetTest, DISABLED_ChainingForDifferentDevices) {
   }
 }
 
+TEST(NetTest, StreamColoring) {
+  // op0 forks into op1 and op2, op3 is a collective following op2
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        external_input: "in"
+        op {
+          input: "in"
+          output: "a"
+          type: "NetTestDummy"
+          device_option {
+            device_type: 1
+          }
+        }
+        op {
+          input: "a"
+          output: "b"
+          type: "NetTestDummy"
+          device_option {
+            device_type: 1
+          }
+        }
+        op {
+          input: "a"
+          output: "c"
+          type: "NetTestDummy"
+          device_option {
+            device_type: 1
+          }
+        }
+        op {
+          input: "c"
+          output: "d"
+          type: "NetTestDummy2"
+          device_option {
+            device_type: 1
+          }
+        }
+)DOC";
+  if (!HasCudaGPU()) {
+    return;
+  }
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(spec, &net_def));
+  net_def.set_num_workers(4);
+
+  auto old_assignment = FLAGS_caffe2_net_async_stream_assignment;
+  auto old_streams = FLAGS_caffe2_streams_per_gpu;
+  auto old_types = FLAGS_caffe2_net_async_priority_stream_op_types;
+  auto g = MakeGuard([&]() {
+    FLAGS_caffe2_net_async_stream_assignment = old_assignment;
+    FLAGS_caffe2_streams_per_gpu = old_streams;
+    FLAGS_caffe2_net_async_priority_stream_op_types = old_types;
+  });
+  FLAGS_caffe2_net_async_stream_assignment = "coloring";
+  FLAGS_caffe2_streams_per_gpu = 2;
+
+  // Streams of the tasks of op1 and op2
+  auto streams = [&net_def]() {
+    Workspace ws;
+    ws.CreateBlob("in");
+    std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+    auto* async_net = dynamic_cast_if_rtti<AsyncNetBase*>(net.get());
+    CHECK_NOTNULL(async_net);
+    std::vector<int> op_streams(net_def.op_size());
+    const auto& chains = async_net->TEST_chains();
+    for (size_t task_id = 0; task_id < chains.size(); ++task_id) {
+      for (auto op_id : chains[task_id]) {
+        op_streams[op_id] = async_net->TEST_task_streams()[task_id];
+      }
+    }
+    testExecution(net, net_def.op().size());
+    return op_streams;
+  };
+
+  // One branch continues the stream of op0, the other one takes another
+  FLAGS_caffe2_net_async_priority_stream_op_types = "";
+  EXPECT_EQ(streams(), std::vector<int>({0, 0, 1, 1}));
+
+  // The collective and the tasks feeding it run on priority streams
+  FLAGS_caffe2_net_async_priority_stream_op_types = "NetTestDummy2";
+  const int priority = CAFFE2_PRIORITY_STREAM_ID_BASE;
+  EXPECT_EQ(streams(), std::vector<int>({priority, 0, priority, priority}));
+}
+
 } // namespace caffe2
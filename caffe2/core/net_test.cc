@@ -4,6 +4,7 @@
 #include "caffe2/core/net_dag.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/scope_guard.h"
+#include "caffe2/proto/prof_dag.pb.h"
 
 #include <google/protobuf/text_format.h>
 
@@ -51,6 +52,7 @@ REGISTER_CPU_OPERATOR(NetTestDummy, NetTestDummyOp);
 REGISTER_CUDA_OPERATOR(NetTestDummy, NetTestDummyOp);
 REGISTER_CPU_OPERATOR(NetTestDummy2, NetTestDummyOp);
 REGISTER_CUDA_OPERATOR(NetTestDummy2, NetTestDummyOp);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(NetTestDummy, TEMPLATE, NetTestDummyOp);
 
 OPERATOR_SCHEMA(NetTestDummy)
     .NumInputs(0, INT_MAX)
@@ -815,4 +817,356 @@ TEST(NetTest, PendingOpsAndNetFailure) {
   ASSERT_FALSE(net->Run());
 }
 
+std::mutex order_mutex;
+std::vector<int> order;
+
+class RecordOrderOp final : public Operator<CPUContext> {
+ public:
+  RecordOrderOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        id_(OperatorBase::GetSingleArgument<int>("id", 0)) {}
+
+  bool RunOnDevice() override {
+    std::unique_lock<std::mutex> lock(order_mutex);
+    order.push_back(id_);
+    return true;
+  }
+
+ protected:
+  const int id_;
+};
+
+REGISTER_CPU_OPERATOR(RecordOrderOp, RecordOrderOp);
+
+OPERATOR_SCHEMA(RecordOrderOp).NumInputs(0, 1).NumOutputs(0, 1);
+
+TEST(NetTest, AsyncSchedulingPriorities) {
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        num_workers: 1
+        op {
+          type: "RecordOrderOp"
+          output: "out0"
+          arg {
+            name: "id"
+            i: 0
+          }
+          arg {
+            name: "priority"
+            i: 2
+          }
+        }
+        op {
+          type: "RecordOrderOp"
+          output: "out1"
+          arg {
+            name: "id"
+            i: 1
+          }
+        }
+        op {
+          type: "RecordOrderOp"
+          output: "out2"
+          arg {
+            name: "id"
+            i: 2
+          }
+          arg {
+            name: "priority"
+            i: -1
+          }
+        }
+)DOC";
+
+  NetDef net_def;
+  CAFFE_ENFORCE(
+      ::google::protobuf::TextFormat::ParseFromString(spec, &net_def));
+
+  Workspace ws;
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  order.clear();
+  ASSERT_TRUE(net->Run());
+  ASSERT_EQ(order, std::vector<int>({2, 1, 0}));
+}
+
+TEST(NetTest, AsyncSchedulingCriticalPath) {
+  // op0 forks into op1 and op2, op2 forks into op3, the most expensive op,
+  // and op4
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        num_workers: 1
+        arg {
+          name: "scheduling_policy"
+          s: "critical_path"
+        }
+        arg {
+          name: "op_cost_profile_blob"
+          s: "profile"
+        }
+        op {
+          type: "RecordOrderOp"
+          output: "out0"
+          arg {
+            name: "id"
+            i: 0
+          }
+        }
+        op {
+          type: "RecordOrderOp"
+          input: "out0"
+          output: "out1"
+          arg {
+            name: "id"
+            i: 1
+          }
+        }
+        op {
+          type: "RecordOrderOp"
+          input: "out0"
+          output: "out2"
+          arg {
+            name: "id"
+            i: 2
+          }
+        }
+        op {
+          type: "RecordOrderOp"
+          input: "out2"
+          output: "out3"
+          arg {
+            name: "id"
+            i: 3
+          }
+        }
+        op {
+          type: "RecordOrderOp"
+          input: "out2"
+          output: "out4"
+          arg {
+            name: "id"
+            i: 4
+          }
+        }
+)DOC";
+
+  NetDef net_def;
+  CAFFE_ENFORCE(
+      ::google::protobuf::TextFormat::ParseFromString(spec, &net_def));
+
+  ProfDAGProtos profile;
+  for (float cost : {1, 5, 1, 20, 1}) {
+    auto* stats = profile.add_stats();
+    stats->set_name("RecordOrderOp");
+    stats->set_mean(cost);
+    stats->set_stddev(0);
+  }
+  Workspace ws;
+  auto* tensor = ws.CreateBlob("profile")->GetMutable<TensorCPU>();
+  tensor->Resize(1);
+  CAFFE_ENFORCE(
+      profile.SerializeToString(&tensor->mutable_data<std::string>()[0]));
+
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  auto* scheduling_net =
+      caffe2::dynamic_cast_if_rtti<AsyncSchedulingNet*>(net.get());
+  ASSERT_TRUE(scheduling_net);
+  ASSERT_FLOAT_EQ(scheduling_net->TEST_critical_path_ms(), 22);
+  // op3 becomes ready after op1 but runs first
+  order.clear();
+  ASSERT_TRUE(net->Run());
+  ASSERT_EQ(order, std::vector<int>({0, 2, 3, 1, 4}));
+
+  // Without a profile every operator costs the same, and the ready ops of
+  // the same rank run in the order of the net
+  net_def.mutable_arg(1)->set_name("unused");
+  net.reset();
+  net = CreateNet(net_def, &ws);
+  order.clear();
+  ASSERT_TRUE(net->Run());
+  ASSERT_EQ(order, std::vector<int>({0, 2, 1, 3, 4}));
+}
+
+TEST(NetTest, ChainCoarsening) {
+  // A diamond of four operators, op0 forks into op1 and op2 that op3 joins
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        external_input: "in"
+        arg {
+          name: "chain_coarsening_threshold_us"
+          f: 10
+        }
+        arg {
+          name: "op_cost_profile_blob"
+          s: "profile"
+        }
+        op {
+          input: "in"
+          output: "a"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "a"
+          output: "b"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "a"
+          output: "c"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "b"
+          input: "c"
+          output: "d"
+          type: "NetTestDummy"
+        }
+)DOC";
+
+  NetDef net_def;
+  CAFFE_ENFORCE(
+      ::google::protobuf::TextFormat::ParseFromString(spec, &net_def));
+  net_def.set_num_workers(4);
+
+  auto check = [&net_def](
+                   const std::vector<float>& costs_ms,
+                   const dag_utils::ExecutionChains& expected) {
+    ProfDAGProtos profile;
+    for (auto cost : costs_ms) {
+      auto* stats = profile.add_stats();
+      stats->set_name("NetTestDummy");
+      stats->set_mean(cost);
+      stats->set_stddev(0);
+    }
+    Workspace ws;
+    ws.CreateBlob("in");
+    auto* tensor = ws.CreateBlob("profile")->GetMutable<TensorCPU>();
+    tensor->Resize(1);
+    CAFFE_ENFORCE(
+        profile.SerializeToString(&tensor->mutable_data<std::string>()[0]));
+
+    std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+    auto* async_net = dynamic_cast_if_rtti<AsyncNetBase*>(net.get());
+    ASSERT_TRUE(async_net);
+    EXPECT_TRUE(async_net->TEST_execution_chains() == expected);
+    testExecution(net, net_def.op().size());
+  };
+
+  // Cheap operators all run in one task
+  check({0.001, 0.001, 0.001, 0.001}, {{0, {0, 1, 2, 3}}});
+  // An expensive op2 keeps its own task, and so does op3 that depends on two
+  // tasks then
+  check({0.001, 0.001, 1, 0.001}, {{0, {0, 1}}, {2, {2}}, {3, {3}}});
+  // The merged tasks cost no more than the threshold
+  check({0.004, 0.004, 0.004, 0.001}, {{0, {0, 1}}, {2, {2}}, {3, {3}}});
+}
+
+TEST(NetTest, CPUFastPath) {
+  // A chain of three synchronous CPU operators
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        external_input: "in"
+        op {
+          input: "in"
+          output: "a"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "a"
+          output: "b"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "b"
+          output: "c"
+          type: "NetTestDummy"
+        }
+)DOC";
+
+  NetDef net_def;
+  CAFFE_ENFORCE(
+      ::google::protobuf::TextFormat::ParseFromString(spec, &net_def));
+  net_def.set_num_workers(4);
+
+  for (bool fast_path : {true, false}) {
+    auto old = FLAGS_caffe2_net_async_cpu_fast_path;
+    auto g = MakeGuard([&]() { FLAGS_caffe2_net_async_cpu_fast_path = old; });
+    FLAGS_caffe2_net_async_cpu_fast_path = fast_path;
+
+    Workspace ws;
+    ws.CreateBlob("in");
+    std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+    auto* async_net = dynamic_cast_if_rtti<AsyncNetBase*>(net.get());
+    ASSERT_TRUE(async_net);
+    ASSERT_EQ(async_net->TEST_execution_chains().size(), 1);
+    const auto ops = net->GetOperators();
+    // Only the last operator keeps its event on the fast path
+    EXPECT_EQ(ops[0]->IsEventDisabled(), fast_path);
+    EXPECT_TRUE(ops[1]->IsEventDisabled());
+    EXPECT_FALSE(ops[2]->IsEventDisabled());
+    testExecution(net, net_def.op().size());
+  }
+}
+
+TEST(NetTest, NetTemplate) {
+  const auto spec = R"DOC(
+        name: "example"
+        device_option {
+          device_type: 0
+        }
+        op {
+          input: "in"
+          output: "hidden"
+          type: "NetTestDummy"
+          engine: "TEMPLATE"
+        }
+        op {
+          input: "hidden"
+          output: "out"
+          type: "NetTestDummy"
+        }
+)DOC";
+
+  for (const auto& net_type : {"simple", "async_scheduling"}) {
+    NetDef net_def;
+    CAFFE_ENFORCE(google::protobuf::TextFormat::ParseFromString(
+        string(spec), &net_def));
+    net_def.set_type(net_type);
+    NetTemplate net_template(net_def);
+
+    // The first net resolves the creators, the next ones reuse them
+    auto create_nets = [&net_template]() {
+      for (int i = 0; i < 10; ++i) {
+        Workspace ws;
+        ws.CreateBlob("in");
+        auto* net = ws.CreateNet(net_template);
+        ASSERT_TRUE(net != nullptr);
+        auto ops = net->GetOperators();
+        ASSERT_EQ(ops.size(), 2);
+        for (int idx = 0; idx < 2; ++idx) {
+          // The nets share the net def of the template
+          EXPECT_EQ(&ops[idx]->debug_def(), &net_template.net_def()->op(idx));
+          EXPECT_EQ(ops[idx]->device_option().device_type(), CPU);
+        }
+        EXPECT_EQ(ops[0]->engine(), "TEMPLATE");
+        EXPECT_EQ(ops[1]->engine(), "");
+        EXPECT_EQ(ops[0]->Outputs()[0], ws.GetBlob("hidden"));
+        EXPECT_EQ(ops[1]->Inputs()[0], ws.GetBlob("hidden"));
+        ASSERT_TRUE(net->Run());
+      }
+    };
+    create_nets();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+      threads.emplace_back(create_nets);
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+}
+
 } // namespace caffe2
@@ -61,7 +61,7 @@ Graph<typename G::NodeRef> dominatorTree(
     G* g,
     typename G::NodeRef source = nullptr) {
   assert(
-      g->getMutableNodes().size() > 0 &&
+      g->getNodesCount() > 0 &&
       "Cannot find dominator tree of empty graph.");
   if (!source) {
     auto rootSCC = tarjans(g).back();
@@ -12,11 +12,12 @@
 #ifndef NOM_GRAPH_GRAPH_H
 #define NOM_GRAPH_GRAPH_H
 
+#include "nomnigraph/Support/Arena.h"
 #include "nomnigraph/Support/Common.h"
 
 #include <algorithm>
 #include <iterator>
-#include <list>
+#include <memory>
 #include <unordered_set>
 #include <vector>
 
@@ -65,9 +66,15 @@ class Edge : public StorageType<U...> {
     Head = n;
   }
 
+  /// \brief Index of the edge in the graph holding it, see Node::getId.
+  size_t getId() const {
+    return Id;
+  }
+
  private:
   NodeRef Tail;
   NodeRef Head;
+  size_t Id = 0;
   friend class Graph<T, U...>;
 };
 
@@ -132,9 +139,20 @@ class Node : public StorageType<T>, public Notifier<Node<T, U...>> {
     outEdges = es;
   }
 
+  /// \brief Index of the node in the graph holding it.
+  ///
+  /// Ids are given in creation order and never reused within a graph, so
+  /// they do not change as long as the node lives in the graph, and can index
+  /// vectors of per-node state in algorithms. Importing the node into another
+  /// graph gives it a new id.
+  size_t getId() const {
+    return Id;
+  }
+
  protected:
   std::vector<EdgeRef> inEdges;
   std::vector<EdgeRef> outEdges;
+  size_t Id = 0;
   friend class Graph<T, U...>;
 };
 
@@ -204,6 +222,11 @@ class Subgraph {
 ///
 /// Everything is owned by the graph to simplify storage concerns.
 ///
+/// Nodes and edges are allocated in arenas and indexed by their ids, so that
+/// creating, finding and deleting them takes constant time and references to
+/// them stay valid until they are deleted. The slots of deleted nodes and
+/// edges are not reused.
+///
 template <typename T, typename... U>
 class Graph {
  public:
@@ -211,41 +234,66 @@ class Graph {
   using NodeRef = Node<T, U...>*;
   using EdgeRef = Edge<T, U...>*;
 
-  Graph() {
+  Graph()
+      : NodeArena(std::make_shared<Arena<Node<T, U...>>>()),
+        EdgeArena(std::make_shared<Arena<Edge<T, U...>>>()) {
     DEBUG_PRINT("Creating instance of Graph: %p\n", this);
   }
   Graph(const Graph&) = delete;
-  Graph(Graph&&) = default;
-  Graph& operator=(Graph&&) = default;
-  ~Graph() {}
+  Graph(Graph&& other) {
+    *this = std::move(other);
+  }
+  Graph& operator=(Graph&& other) {
+    if (this != &other) {
+      destroyAll();
+      NodeArena = std::move(other.NodeArena);
+      EdgeArena = std::move(other.EdgeArena);
+      ImportedArenas = std::move(other.ImportedArenas);
+      Nodes = std::move(other.Nodes);
+      Edges = std::move(other.Edges);
+      NodeCount = other.NodeCount;
+      EdgeCount = other.EdgeCount;
+      other.Nodes.clear();
+      other.Edges.clear();
+      other.NodeCount = 0;
+      other.EdgeCount = 0;
+    }
+    return *this;
+  }
+  ~Graph() {
+    destroyAll();
+  }
 
   /// \brief Creates a node and retains ownership of it.
   /// \p data An rvalue of the data being held in the node.
   /// \return A reference to the node created.
   NodeRef createNode(T&& data) {
-    Nodes.emplace_back(Node<T, U...>(std::move(data)));
-    DEBUG_PRINT("Creating node (%p)\n", &Nodes.back());
-    return &Nodes.back();
+    auto node = NodeArena->create(std::move(data));
+    DEBUG_PRINT("Creating node (%p)\n", node);
+    addNode(node);
+    return node;
   }
 
+  /// \brief Moves the ownership of a node to another graph. The node keeps
+  /// its address and edges, and gets a new id in the other graph.
   void importNode(NodeRef node, Graph<T, U...>& otherGraph) {
-    std::list<Node<T, U...>>& otherNodes = otherGraph.Nodes;
-    for (auto it = Nodes.begin(); it != Nodes.end(); ++it) {
-      if (&(*it) == node) {
-        otherNodes.splice(otherNodes.end(), Nodes, it, ++it);
-        break;
-      }
+    if (!hasNode(node)) {
+      return;
     }
+    Nodes[node->Id] = nullptr;
+    --NodeCount;
+    otherGraph.addNode(node);
+    otherGraph.retainArena(NodeArena);
   }
 
   void importEdge(EdgeRef edge, Graph<T, U...>& otherGraph) {
-    std::list<Edge<T, U...>>& otherEdges = otherGraph.Edges;
-    for (auto it = Edges.begin(); it != Edges.end(); ++it) {
-      if (&(*it) == edge) {
-        otherEdges.splice(otherEdges.end(), Edges, it, ++it);
-        break;
-      }
+    if (!hasEdge(edge)) {
+      return;
     }
+    Edges[edge->Id] = nullptr;
+    --EdgeCount;
+    otherGraph.addEdge(edge);
+    otherGraph.retainArena(EdgeArena);
   }
 
   void swapNodes(NodeRef n1, NodeRef n2) {
@@ -275,9 +323,10 @@ class Graph {
   }
 
   NodeRef createNode() {
-    Nodes.emplace_back(Node<T, U...>());
-    DEBUG_PRINT("Creating node (%p)\n", &Nodes.back());
-    return &Nodes.back();
+    auto node = NodeArena->create();
+    DEBUG_PRINT("Creating node (%p)\n", node);
+    addNode(node);
+    return node;
   }
 
   /// \brief Replace a node in the graph with a generic
@@ -316,9 +365,8 @@ class Graph {
   /// \return A reference to the edge created.
   EdgeRef createEdge(NodeRef tail, NodeRef head, U... data) {
     DEBUG_PRINT("Creating edge (%p -> %p)\n", tail, head);
-    this->Edges.emplace_back(
-        Edge<T, U...>(tail, head, std::forward<U...>(data)...));
-    EdgeRef e = &this->Edges.back();
+    EdgeRef e = EdgeArena->create(tail, head, std::forward<U...>(data)...);
+    addEdge(e);
     head->addInEdge(e);
     tail->addOutEdge(e);
     return e;
@@ -351,11 +399,10 @@ class Graph {
         deleteEdge(edge);
       }
     }
-    for (auto i = Nodes.begin(); i != Nodes.end(); ++i) {
-      if (&*i == n) {
-        Nodes.erase(i);
-        break;
-      }
+    if (hasNode(n)) {
+      Nodes[n->Id] = nullptr;
+      --NodeCount;
+      Arena<Node<T, U...>>::destroy(n);
     }
   }
 
@@ -366,47 +413,119 @@ class Graph {
       e->Tail->removeOutEdge(e);
       e->Head->removeInEdge(e);
     }
-    for (auto i = Edges.begin(); i != Edges.end(); ++i) {
-      if (&*i == e) {
-        Edges.erase(i);
-        break;
-      }
+    if (hasEdge(e)) {
+      Edges[e->Id] = nullptr;
+      --EdgeCount;
+      Arena<Edge<T, U...>>::destroy(e);
     }
   }
 
+  bool hasNode(NodeRef n) const {
+    return n->Id < Nodes.size() && Nodes[n->Id] == n;
+  }
+
+  bool hasEdge(EdgeRef e) const {
+    return e->Id < Edges.size() && Edges[e->Id] == e;
+  }
+
+  /// \brief Returns the nodes in creation order, in a copy that stays valid
+  /// when nodes are created or deleted.
   const std::vector<NodeRef> getMutableNodes() {
     std::vector<NodeRef> v;
-    for (auto& n : Nodes) {
-      DEBUG_PRINT("Adding node to mutable output (%p)\n", &n);
-      v.emplace_back(&n);
+    v.reserve(NodeCount);
+    for (auto n : Nodes) {
+      if (n) {
+        DEBUG_PRINT("Adding node to mutable output (%p)\n", n);
+        v.emplace_back(n);
+      }
     }
     return v;
   }
 
   const std::vector<EdgeRef> getMutableEdges() {
     std::vector<EdgeRef> v;
-    for (auto& e : Edges) {
-      DEBUG_PRINT("Adding edge to mutable output (%p)\n", &e);
-      v.emplace_back(&e);
+    v.reserve(EdgeCount);
+    for (auto e : Edges) {
+      if (e) {
+        DEBUG_PRINT("Adding edge to mutable output (%p)\n", e);
+        v.emplace_back(e);
+      }
     }
     return v;
   }
 
+  size_t getNodesCount() const {
+    return NodeCount;
+  }
+
+  size_t getEdgesCount() const {
+    return EdgeCount;
+  }
+
   void printEdges() {
-    for (const auto& edge : Edges) {
-      printf("Edge: %p (%p -> %p)\n", &edge, edge.tail(), edge.head());
+    for (const auto edge : Edges) {
+      if (edge) {
+        printf("Edge: %p (%p -> %p)\n", edge, edge->tail(), edge->head());
+      }
     }
   }
 
   void printNodes() const {
-    for (const auto& node : Nodes) {
-      printf("Node: %p\n", &node);
+    for (const auto node : Nodes) {
+      if (node) {
+        printf("Node: %p\n", node);
+      }
     }
   }
 
  protected:
-  std::list<Node<T, U...>> Nodes;
-  std::list<Edge<T, U...>> Edges;
+  std::shared_ptr<Arena<Node<T, U...>>> NodeArena;
+  std::shared_ptr<Arena<Edge<T, U...>>> EdgeArena;
+  // Arenas of the graphs that nodes or edges were imported from
+  std::vector<std::shared_ptr<void>> ImportedArenas;
+  // By id, null once deleted or imported into another graph
+  std::vector<NodeRef> Nodes;
+  std::vector<EdgeRef> Edges;
+  size_t NodeCount = 0;
+  size_t EdgeCount = 0;
+
+ private:
+  void addNode(NodeRef n) {
+    n->Id = Nodes.size();
+    Nodes.emplace_back(n);
+    ++NodeCount;
+  }
+
+  void addEdge(EdgeRef e) {
+    e->Id = Edges.size();
+    Edges.emplace_back(e);
+    ++EdgeCount;
+  }
+
+  void retainArena(std::shared_ptr<void> arena) {
+    if (arena != NodeArena && arena != EdgeArena &&
+        std::find(ImportedArenas.begin(), ImportedArenas.end(), arena) ==
+            ImportedArenas.end()) {
+      ImportedArenas.emplace_back(std::move(arena));
+    }
+  }
+
+  void destroyAll() {
+    for (auto e : Edges) {
+      if (e) {
+        Arena<Edge<T, U...>>::destroy(e);
+      }
+    }
+    for (auto n : Nodes) {
+      if (n) {
+        Arena<Node<T, U...>>::destroy(n);
+      }
+    }
+    Edges.clear();
+    Nodes.clear();
+    NodeCount = 0;
+    EdgeCount = 0;
+  }
 };
 
 } // namespace nom
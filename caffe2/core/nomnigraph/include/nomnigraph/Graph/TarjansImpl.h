@@ -1,165 +1,137 @@
 #ifndef NOM_GRAPH_TARJANSIMPL_H
 #define NOM_GRAPH_TARJANSIMPL_H
 
-#include <unordered_map>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 #include "nomnigraph/Graph/Graph.h"
 
 namespace nom {
 namespace algorithm {
 
-template <typename T, typename... U>
-struct GraphWrapper {
-  struct NodeWrapper {
-    using NodeRef = typename Graph<T, U...>::NodeRef;
-    NodeWrapper(NodeRef n) : node(n) {}
-    NodeRef node;
-    int Index = -1;
-    int LowLink = -1;
-    bool OnStack = false;
-  };
-
-  struct EdgeWrapper {
-    typename Graph<T, U...>::EdgeRef edge;
-  };
-};
-
 /// \brief Tarjans algorithm implementation.
 ///
 /// See details on how the algorithm works here:
 /// https://en.wikipedia.org/wiki/Tarjan%27s_strongly_connected_components_algorithm
 ///
 /// The algorithm works by annotating nodes, but we want to be able to
-/// handle generic graphs.  Thus, we wrap the input graph with nodes that
-/// contain data composed of references to the original graph (for later
-/// recovery) and the data required for the algorithm (see NodeWrapper).
+/// handle generic graphs.  Thus, we keep the data required for the algorithm
+/// (see NodeState) in a vector indexed by the ids of the nodes.
 ///
 /// We then run the algorithm and return a reverse-topologically sorted
 /// vector of strongly connect components in the form of Subgraphs on the Graph.
+/// The depth-first search keeps its own stack, so that it can go as deep as
+/// the chains of operators of large nets.
 ///
 /// \note Head/Tail is used in reverse in Tarjan's early papers.
-/// \bug Edges not included in returned subgraphs.
 ///
 template <typename T, typename... U>
 class Tarjans {
-  using NodeWrapper = typename GraphWrapper<T, U...>::NodeWrapper;
-  using EdgeWrapper = typename GraphWrapper<T, U...>::EdgeWrapper;
-  using WrappedGraph = Graph<NodeWrapper, EdgeWrapper>;
-  using WrappedSubgraph = Subgraph<NodeWrapper, EdgeWrapper>;
+  using NodeRef = typename Graph<T, U...>::NodeRef;
+
+  struct NodeState {
+    int Index = -1;
+    int LowLink = -1;
+    bool OnStack = false;
+  };
 
  private:
   int Index = 0;
-  std::vector<typename WrappedGraph::NodeRef> Stack;
+  std::vector<NodeRef> Stack;
   Graph<T, U...>* InputGraph;
-  WrappedGraph WrappedInputGraph;
-  std::vector<WrappedSubgraph> WrappedSCCs;
+  // By node id
+  std::vector<NodeState> States;
+  std::vector<Subgraph<T, U...>> SCCs;
+
+  NodeState& state(NodeRef n) {
+    return States[n->getId()];
+  }
+
+  void visit(NodeRef n) {
+    state(n).Index = Index;
+    state(n).LowLink = Index;
+    Index++;
+
+    Stack.emplace_back(n);
+    state(n).OnStack = true;
+  }
 
  public:
-  /// \brief Constructor wraps the input graph with an annotated graph
-  ///        set up with the datastructures needed for the algorithm.
+  /// \brief Constructor sets up the datastructures needed for the algorithm.
   /// \p g The graph Tarjan's will be run on.
   Tarjans(Graph<T, U...>* g) : InputGraph(g) {
-    // Wrap Graph with node labels
-    std::unordered_map<
-        typename Graph<T, U...>::NodeRef,
-        typename WrappedGraph::NodeRef>
-        n_to_wrappedNode;
-
+    size_t numIds = 0;
     for (const auto& n : InputGraph->getMutableNodes()) {
-      NodeWrapper wrappedNode(n);
-      n_to_wrappedNode[n] =
-          WrappedInputGraph.createNode(std::move(wrappedNode));
-    }
-
-    for (const auto& e : InputGraph->getMutableEdges()) {
-      EdgeWrapper wrappedEdge = {e};
-      WrappedInputGraph.createEdge(
-          n_to_wrappedNode[e->tail()],
-          n_to_wrappedNode[e->head()],
-          std::move(wrappedEdge));
+      numIds = std::max(numIds, n->getId() + 1);
     }
+    States.resize(numIds);
   }
 
   /// \brief Helper function for finding strongly connected components.
-  /// \p n A reference to a node within the wrapped graph.
-  void connect(typename WrappedGraph::NodeRef n) {
-    n->mutableData()->Index = Index;
-    n->mutableData()->LowLink = Index;
-    Index++;
+  /// \p root A reference to a node not visited yet.
+  void connect(NodeRef root) {
+    // The nodes being visited, with the index of their next out edge
+    std::vector<std::pair<NodeRef, size_t>> path;
+    visit(root);
+    path.emplace_back(root, 0);
+
+    while (!path.empty()) {
+      auto n = path.back().first;
+      const auto& outEdges = n->getOutEdges();
+      if (path.back().second < outEdges.size()) {
+        NodeRef newNode = outEdges[path.back().second++]->head();
+        // Check if we've considered this node before.
+        if (state(newNode).Index == -1) {
+          visit(newNode);
+          path.emplace_back(newNode, 0);
+          // Check if newNode is in the SCC.
+        } else if (state(newNode).OnStack) {
+          state(n).LowLink = std::min(state(n).LowLink, state(newNode).Index);
+        }
+        continue;
+      }
 
-    Stack.emplace_back(n);
-    n->mutableData()->OnStack = true;
-
-    for (const auto& outEdge : n->getOutEdges()) {
-      typename WrappedGraph::NodeRef newNode = outEdge->head();
-      // Check if we've considered this node before.
-      if (newNode->data().Index == -1) {
-        connect(newNode);
-        n->mutableData()->LowLink =
-            std::min(n->data().LowLink, newNode->data().LowLink);
-        // Check if newNode is in the SCC.
-      } else if (newNode->data().OnStack) {
-        n->mutableData()->LowLink =
-            std::min(n->data().LowLink, newNode->data().Index);
+      path.pop_back();
+      if (!path.empty()) {
+        auto parent = path.back().first;
+        state(parent).LowLink =
+            std::min(state(parent).LowLink, state(n).LowLink);
       }
-    }
 
-    // If our node is a root node, pop it from the stack (we've found an SCC)
-    if (n->data().LowLink == n->data().Index) {
-      WrappedSubgraph wrappedSCC;
-
-      typename WrappedGraph::NodeRef w;
-      do {
-        w = Stack.back();
-        w->mutableData()->OnStack = false;
-        Stack.pop_back();
-        wrappedSCC.addNode(w);
-      } while (w != n);
-
-      // Add all the edges into the SCC.
-      // TODO include edges in the SCC in a smarter way.
-      const auto& sccNodes = wrappedSCC.getNodes();
-      for (const auto& sccNode : sccNodes) {
-        for (const auto& outEdge : sccNode->getOutEdges()) {
-          if (std::find(sccNodes.begin(), sccNodes.end(), outEdge->head()) !=
-              sccNodes.end()) {
-            wrappedSCC.addEdge(outEdge);
+      // If our node is a root node, pop it from the stack (we've found an SCC)
+      if (state(n).LowLink == state(n).Index) {
+        Subgraph<T, U...> scc;
+
+        NodeRef w;
+        do {
+          w = Stack.back();
+          state(w).OnStack = false;
+          Stack.pop_back();
+          scc.addNode(w);
+        } while (w != n);
+
+        // Add all the edges into the SCC.
+        for (const auto& sccNode : scc.getNodes()) {
+          for (const auto& outEdge : sccNode->getOutEdges()) {
+            if (scc.hasNode(outEdge->head())) {
+              scc.addEdge(outEdge);
+            }
           }
         }
+        SCCs.emplace_back(std::move(scc));
       }
-      WrappedSCCs.emplace_back(wrappedSCC);
-    }
-  }
-
-  /// \brief Helper function for recovering a valid subgraph output.
-  /// \p wrappedS A wrapped subgraph.
-  /// \return A subgraph of the original input graph.
-  ///
-  inline Subgraph<T, U...> unwrapSubgraph(
-      const WrappedSubgraph& wrappedSubgraph) {
-    Subgraph<T, U...> s;
-    for (auto wrappedNode : wrappedSubgraph.getNodes()) {
-      s.addNode(wrappedNode->data().node);
-    }
-    for (auto wrappedEdge : wrappedSubgraph.getEdges()) {
-      s.addEdge(wrappedEdge->data().edge);
     }
-    return s;
   }
 
   std::vector<Subgraph<T, U...>> run() {
-    for (auto n : WrappedInputGraph.getMutableNodes()) {
-      if (n->data().Index == -1) {
+    for (auto n : InputGraph->getMutableNodes()) {
+      if (state(n).Index == -1) {
         connect(n);
       }
     }
 
-    std::vector<Subgraph<T, U...>> sccs;
-    for (auto wrappedSCC : WrappedSCCs) {
-      sccs.emplace_back(unwrapSubgraph(wrappedSCC));
-    }
-
-    return sccs;
+    return std::move(SCCs);
   }
 };
 
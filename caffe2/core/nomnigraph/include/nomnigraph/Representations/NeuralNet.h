@@ -405,6 +405,15 @@ std::vector<NNGraph::NodeRef> getOutputs(NNGraph::NodeRef n);
 
 void coalesceInsertedDataDependencies(repr::NNModule* m);
 
+/// \brief Key of the nodes of an NNGraph for nom::NodeIndex: the name of
+/// operators, e.g. "Conv", and an empty name for data.
+struct OperatorKey {
+  static std::string key(NNGraph::NodeRef n) {
+    return is<NeuralNetOperator>(n) ? get<NeuralNetOperator>(n)->getName()
+                                    : std::string();
+  }
+};
+
 template <NNGraph* G>
 struct NodeHelper {};
 
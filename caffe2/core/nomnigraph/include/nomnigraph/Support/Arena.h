@@ -0,0 +1,66 @@
+//===- nomnigraph/Support/Arena.h - Chunked object allocation ---*- C++ -*-===//
+//
+// TODO Licensing.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines an arena that allocates objects of a single type in
+// contiguous chunks.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef NOM_SUPPORT_ARENA_H
+#define NOM_SUPPORT_ARENA_H
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace nom {
+
+/// \brief Allocates objects of type T in chunks of growing size.
+///
+/// Objects never move, so pointers to them stay valid until the arena is
+/// destroyed. The arena does not run destructors: the owner of an object
+/// destroys it with Arena::destroy, and its memory is only reclaimed with the
+/// arena.
+template <typename T>
+class Arena {
+ public:
+  Arena() {}
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+
+  template <typename... Args>
+  T* create(Args&&... args) {
+    if (Used == ChunkSize) {
+      if (!ChunkSize) {
+        ChunkSize = kMinChunkSize;
+      } else if (ChunkSize < kMaxChunkSize) {
+        ChunkSize *= 2;
+      }
+      Chunks.emplace_back(new Slot[ChunkSize]);
+      Used = 0;
+    }
+    return new (&Chunks.back()[Used++]) T(std::forward<Args>(args)...);
+  }
+
+  static void destroy(T* t) {
+    t->~T();
+  }
+
+ private:
+  using Slot = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+  static constexpr size_t kMinChunkSize = 16;
+  static constexpr size_t kMaxChunkSize = 4096;
+
+  std::vector<std::unique_ptr<Slot[]>> Chunks;
+  size_t ChunkSize = 0;
+  size_t Used = 0;
+};
+
+} // namespace nom
+
+#endif // NOM_SUPPORT_ARENA_H
@@ -14,6 +14,8 @@
 #include "nomnigraph/Graph/Algorithms.h"
 
 #include <algorithm>
+#include <map>
+#include <type_traits>
 #include <vector>
 
 namespace nom {
@@ -25,6 +27,37 @@ struct NodeEqualityDefault {
   }
 };
 
+/// \brief Groups the nodes of a graph by a key, e.g. the type of an
+/// operator, so that matching a pattern only tries the nodes with the key of
+/// its first node as anchors.
+///
+/// KeyClass::key(NodeRef) must give the same key to the nodes the
+/// EqualityClass of the matcher considers equal. The index is a snapshot:
+/// build it again after nodes were created or deleted.
+template <typename G, typename KeyClass>
+class NodeIndex {
+ public:
+  using NodeRef = typename G::NodeRef;
+  using KeyType = typename std::decay<decltype(
+      KeyClass::key(std::declval<NodeRef>()))>::type;
+
+  explicit NodeIndex(G& g) {
+    for (auto n : g.getMutableNodes()) {
+      Index[KeyClass::key(n)].emplace_back(n);
+    }
+  }
+
+  /// \brief Returns the nodes with the key, in graph order.
+  const std::vector<NodeRef>& getNodes(const KeyType& key) const {
+    static const std::vector<NodeRef> empty;
+    auto it = Index.find(key);
+    return it == Index.end() ? empty : it->second;
+  }
+
+ private:
+  std::map<KeyType, std::vector<NodeRef>> Index;
+};
+
 template <
     typename G,
     typename EqualityClass = NodeEqualityDefault<typename G::NodeRef>>
@@ -46,50 +79,63 @@ class Match {
 
   std::vector<SubgraphType> recursiveMatch(
       typename G::NodeRef candidateNode,
-      std::vector<typename G::NodeRef> stack,
-      SubgraphType currentSubgraph) {
-    if (EqualityClass::equal(stack.back(), candidateNode)) {
-      currentSubgraph.addNode(candidateNode);
-
-      // Base case
-      if (stack.size() == MatchNodeList.size()) {
-        return std::vector<SubgraphType>{currentSubgraph};
-      }
+      const std::vector<typename G::NodeRef>& stack,
+      const SubgraphType& currentSubgraph) {
+    // No match here, early bailout
+    if (!EqualityClass::equal(stack.back(), candidateNode)) {
+      return std::vector<SubgraphType>{};
+    }
 
-      // Recurse and accumulate matches
-      stack.emplace_back(MatchNodeList.at(stack.size()));
+    SubgraphType subgraph = currentSubgraph;
+    subgraph.addNode(candidateNode);
 
-      std::vector<SubgraphType> matchingSubgraphs;
-      for (auto outEdge : candidateNode->getOutEdges()) {
-        for (auto subgraph :
-             recursiveMatch(outEdge->head(), stack, currentSubgraph)) {
-          matchingSubgraphs.emplace_back(subgraph);
-        }
-      }
-      return matchingSubgraphs;
+    // Base case
+    if (stack.size() == MatchNodeList.size()) {
+      return std::vector<SubgraphType>{std::move(subgraph)};
     }
 
-    // No match here, early bailout
-    return std::vector<SubgraphType>{};
+    // Recurse and accumulate matches
+    auto nextStack = stack;
+    nextStack.emplace_back(MatchNodeList.at(stack.size()));
+
+    std::vector<SubgraphType> matchingSubgraphs;
+    for (auto outEdge : candidateNode->getOutEdges()) {
+      for (auto& s : recursiveMatch(outEdge->head(), nextStack, subgraph)) {
+        matchingSubgraphs.emplace_back(std::move(s));
+      }
+    }
+    return matchingSubgraphs;
   }
 
   std::vector<SubgraphType> match(G& g) {
+    return matchAnchors(g.getMutableNodes());
+  }
+
+  /// \brief Matches the graph indexed by \p index, only trying the nodes
+  /// with the key of the first node of the pattern as anchors.
+  template <typename KeyClass>
+  std::vector<SubgraphType> match(const NodeIndex<G, KeyClass>& index) {
+    return matchAnchors(index.getNodes(KeyClass::key(MatchNodeList.front())));
+  }
+
+ private:
+  std::vector<SubgraphType> matchAnchors(
+      const std::vector<typename G::NodeRef>& anchors) {
     std::vector<SubgraphType> out;
 
     std::vector<typename G::NodeRef> stack;
     stack.emplace_back(MatchNodeList.front());
 
-    // Try each node in the candidate graph as the anchor.
-    for (auto n : g.getMutableNodes()) {
-      for (auto subgraph : recursiveMatch(n, stack, SubgraphType())) {
-        out.emplace_back(subgraph);
+    // Try each candidate node as the anchor.
+    for (auto n : anchors) {
+      for (auto& subgraph : recursiveMatch(n, stack, SubgraphType())) {
+        out.emplace_back(std::move(subgraph));
       }
     }
 
     return out;
   }
 
- private:
   G& MatchGraph;
   std::vector<typename G::NodeRef> MatchNodeList;
 };
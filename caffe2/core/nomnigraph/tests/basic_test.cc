@@ -37,3 +37,54 @@ TEST(Basic, DeleteEdge) {
   g.deleteEdge(e);
 }
 
+
+TEST(Basic, StableIds) {
+  nom::Graph<std::string> g;
+  auto n1 = g.createNode(std::string("1"));
+  auto n2 = g.createNode(std::string("2"));
+  auto n3 = g.createNode(std::string("3"));
+  g.createEdge(n1, n2);
+  g.createEdge(n2, n3);
+  EXPECT_EQ(n1->getId(), 0);
+  EXPECT_EQ(n3->getId(), 2);
+
+  g.deleteNode(n2);
+  EXPECT_EQ(g.getNodesCount(), 2);
+  EXPECT_EQ(g.getEdgesCount(), 0);
+  EXPECT_FALSE(g.hasNode(n2));
+  auto n4 = g.createNode(std::string("4"));
+  EXPECT_EQ(n3->getId(), 2);
+  EXPECT_EQ(n4->getId(), 3);
+  auto nodes = g.getMutableNodes();
+  ASSERT_EQ(nodes.size(), 3);
+  EXPECT_EQ(nodes[0], n1);
+  EXPECT_EQ(nodes[1], n3);
+  EXPECT_EQ(nodes[2], n4);
+}
+
+TEST(Basic, ImportNodeAndEdge) {
+  nom::Graph<std::string> g;
+  auto n1 = g.createNode(std::string("1"));
+  {
+    nom::Graph<std::string> other;
+    auto n2 = other.createNode(std::string("2"));
+    auto n3 = other.createNode(std::string("3"));
+    auto e = other.createEdge(n2, n3);
+    other.importNode(n2, g);
+    other.importNode(n3, g);
+    other.importEdge(e, g);
+    g.createEdge(n1, n2);
+    EXPECT_EQ(other.getNodesCount(), 0);
+    EXPECT_EQ(other.getEdgesCount(), 0);
+  }
+  // The imported nodes and edges outlive the graph they were created in
+  EXPECT_EQ(g.getNodesCount(), 3);
+  EXPECT_EQ(g.getEdgesCount(), 2);
+  auto n2 = n1->getOutEdges().front()->head();
+  EXPECT_EQ(n2->data(), "2");
+  EXPECT_EQ(n2->getId(), 1);
+  EXPECT_EQ(n2->getOutEdges().front()->head()->data(), "3");
+  g.deleteNode(n2);
+  EXPECT_EQ(g.getNodesCount(), 2);
+  EXPECT_EQ(g.getEdgesCount(), 0);
+}
@@ -35,3 +35,28 @@ TEST(Match, Basic) {
   nom::Match<decltype(graph)> m(match_graph);
   EXPECT_EQ(m.match(graph).size(), 1);
 }
+
+struct StringKey {
+  static std::string key(nom::Graph<std::string>::NodeRef n) {
+    return n->data();
+  }
+};
+
+TEST(Match, NodeIndex) {
+  auto graph = createGraph();
+  nom::Graph<std::string> match_graph;
+  auto m2 = match_graph.createNode(std::string("2"));
+  auto m3 = match_graph.createNode(std::string("3"));
+  auto m6 = match_graph.createNode(std::string("6"));
+  match_graph.createEdge(m2, m3);
+  match_graph.createEdge(m3, m6);
+
+  nom::Match<decltype(graph)> m(match_graph);
+  nom::NodeIndex<decltype(graph), StringKey> index(graph);
+  EXPECT_EQ(index.getNodes("2").size(), 1);
+  EXPECT_EQ(index.getNodes("unknown").size(), 0);
+  auto matches = m.match(index);
+  ASSERT_EQ(matches.size(), 1);
+  EXPECT_EQ(matches.front().getNodes().size(), 3);
+  EXPECT_EQ(m.match(graph).size(), 1);
+}
@@ -13,6 +13,23 @@ CAFFE2_DEFINE_bool(
 
 namespace caffe2 {
 
+namespace {
+thread_local int thread_numa_node_id = -1;
+thread_local int allocation_numa_node_id = -1;
+} // namespace
+
+int GetThreadNUMANode() {
+  return thread_numa_node_id;
+}
+
+void SetNUMAAllocationNode(int numa_node_id) {
+  allocation_numa_node_id = numa_node_id;
+}
+
+int GetNUMAAllocationNode() {
+  return allocation_numa_node_id;
+}
+
 #ifdef CAFFE2_NUMA_ENABLED
 bool IsNUMAEnabled() {
   return FLAGS_caffe2_cpu_numa_enabled && numa_available() >= 0;
@@ -36,6 +53,7 @@ void NUMABind(int numa_node_id) {
   numa_bitmask_setbit(bm, numa_node_id);
   numa_bind(bm);
   numa_bitmask_free(bm);
+  thread_numa_node_id = numa_node_id;
 }
 
 int GetNUMANode(const void* ptr) {
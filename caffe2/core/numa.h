@@ -19,6 +19,15 @@ void NUMAMove(void* ptr, size_t size, int numa_node_id);
 
 int GetCurrentNUMANode();
 
+// Node the calling thread was bound to by NUMABind, or -1 if it was not
+// bound. Unlike GetCurrentNUMANode this does not query the kernel.
+int GetThreadNUMANode();
+
+// Node requested for memory allocated by the calling thread, e.g. through
+// DeviceOption.numa_node_id of the operator being run; -1 if none.
+void SetNUMAAllocationNode(int numa_node_id);
+int GetNUMAAllocationNode();
+
 } // namespace caffe2
 
 #endif // CAFFE2_CORE_NUMA_H_
@@ -1,6 +1,7 @@
 #include "caffe2/core/operator.h"
 
 #include <algorithm>
+#include <functional>
 
 #include "caffe2/core/init.h"
 #include "caffe2/core/logging.h"
@@ -76,7 +77,10 @@ GlobalEnginePrefType& g_global_engine_pref() {
 }
 
 unique_ptr<OperatorBase> TryCreateOperator(
-    const string& key, const OperatorDef& operator_def, Workspace* ws) {
+    const string& key,
+    const OperatorDef& operator_def,
+    Workspace* ws,
+    OperatorRegistry::Creator* creator) {
   const auto& type = operator_def.device_option().device_type();
   CAFFE_ENFORCE(
       gDeviceTypeRegistry()->count(type),
@@ -86,7 +90,16 @@ unique_ptr<OperatorBase> TryCreateOperator(
   OperatorRegistry* registry = gDeviceTypeRegistry()->at(type);
   VLOG(1) << "Creating operator with device type " << type;
   try {
-    return registry->Create(key, operator_def, ws);
+    auto op_creator = registry->GetCreator(key);
+    if (!op_creator) {
+      // Returns nullptr if the key is not registered.
+      return nullptr;
+    }
+    auto op = op_creator(operator_def, ws);
+    if (op && creator) {
+      *creator = op_creator;
+    }
+    return op;
   } catch (const UnsupportedOperatorFeature& err) {
     LOG(WARNING) << "Operator " << operator_def.type()
                  << " does not support the requested feature. Msg: "
@@ -98,7 +111,8 @@ unique_ptr<OperatorBase> TryCreateOperator(
 
 unique_ptr<OperatorBase> _CreateOperator(
     const OperatorDef& operator_def,
-    Workspace* ws) {
+    Workspace* ws,
+    OperatorRegistry::Creator* creator) {
   static StaticLinkingProtector g_protector;
   const auto& op_type = operator_def.type();
   const auto& device_type = operator_def.device_option().device_type();
@@ -146,7 +160,7 @@ unique_ptr<OperatorBase> _CreateOperator(
     const std::string key = OpRegistryKey(op_type, engine);
     VLOG(1) << "Trying to create operator " << op_type << " with engine "
             << engine;
-    auto op = TryCreateOperator(key, operator_def, ws);
+    auto op = TryCreateOperator(key, operator_def, ws, creator);
     if (op) {
       if (engine.size() <= (unsigned)FLAGS_caffe2_operator_max_engine_name_length) {
         op->annotate_engine(engine);
@@ -173,7 +187,7 @@ unique_ptr<OperatorBase> _CreateOperator(
   VLOG(1) << "Using default implementation.";
 
   // Lastly, if the engine does not work here, try using the default engine.
-  auto op = TryCreateOperator(op_type, operator_def, ws);
+  auto op = TryCreateOperator(op_type, operator_def, ws, creator);
   CAFFE_ENFORCE(
       op,
       "Cannot create operator of type '",
@@ -269,7 +283,13 @@ unique_ptr<OperatorBase> CreateOperator(
     Workspace* ws,
     int net_position) {
   try {
-    auto op = _CreateOperator(operator_def, ws);
+    auto op = OperatorCreatorCache::TryCreate(operator_def, ws, net_position);
+    if (!op) {
+      OperatorRegistry::Creator creator;
+      op = _CreateOperator(operator_def, ws, &creator);
+      OperatorCreatorCache::Record(
+          operator_def, net_position, creator, op->engine());
+    }
     op->set_net_position(net_position);
     return op;
   } catch (...) {
@@ -284,6 +304,71 @@ unique_ptr<OperatorBase> CreateOperator(
   }
 }
 
+OperatorCreatorCache::OperatorCreatorCache(
+    const std::shared_ptr<const NetDef>& net_def)
+    : net_def_(net_def), entries_(net_def->op_size()), complete_(false) {}
+
+OperatorCreatorCache::Scope::Scope(OperatorCreatorCache* cache)
+    : cache_(cache), parent_(current()) {
+  if (!cache_->complete_) {
+    record_lock_ = std::unique_lock<std::mutex>(
+        cache_->record_mutex_, std::try_to_lock);
+  }
+  current() = this;
+}
+
+OperatorCreatorCache::Scope::~Scope() {
+  current() = parent_;
+  if (record_lock_.owns_lock()) {
+    cache_->complete_ = std::all_of(
+        cache_->entries_.begin(),
+        cache_->entries_.end(),
+        [](const Entry& entry) { return static_cast<bool>(entry.creator); });
+  }
+}
+
+OperatorCreatorCache::Scope*& OperatorCreatorCache::current() {
+  static thread_local Scope* scope = nullptr;
+  return scope;
+}
+
+bool OperatorCreatorCache::owns(
+    const OperatorDef& operator_def,
+    int net_position) const {
+  return net_position >= 0 && net_position < net_def_->op_size() &&
+      &net_def_->op(net_position) == &operator_def;
+}
+
+unique_ptr<OperatorBase> OperatorCreatorCache::TryCreate(
+    const OperatorDef& operator_def,
+    Workspace* ws,
+    int net_position) {
+  auto* scope = current();
+  if (!scope || !scope->cache_->complete_ ||
+      !scope->cache_->owns(operator_def, net_position)) {
+    return nullptr;
+  }
+  const auto& entry = scope->cache_->entries_[net_position];
+  auto op = entry.creator(operator_def, ws);
+  op->annotate_engine(entry.engine);
+  return op;
+}
+
+void OperatorCreatorCache::Record(
+    const OperatorDef& operator_def,
+    int net_position,
+    const OperatorRegistry::Creator& creator,
+    const std::string& engine) {
+  auto* scope = current();
+  if (!scope || !scope->record_lock_.owns_lock() ||
+      !scope->cache_->owns(operator_def, net_position)) {
+    return;
+  }
+  auto& entry = scope->cache_->entries_[net_position];
+  entry.creator = creator;
+  entry.engine = engine;
+}
+
 std::map<int32_t, OperatorRegistry*>* gDeviceTypeRegistry() {
   static std::map<int32_t, OperatorRegistry*> g_device_type_registry;
   return &g_device_type_registry;
@@ -369,153 +454,286 @@ GradientOpsMeta GetGradientForOp(
   return meta;
 }
 
-TensorShapes InferBlobShapesAndTypes(
+namespace {
+
+using InferTensorFn = std::function<std::vector<TensorShape>(
+    const OperatorDef&,
+    const OpSchema&,
+    const std::vector<TensorShape>&)>;
+
+// Infers the output shapes of one operator of a net into blob_desc. Returns
+// false if the inference of the whole net has to be given up.
+bool InferOperatorShapes(
+    const OperatorDef& op,
+    const InferTensorFn& infer_tensor,
     CaffeMap<string, TensorShape>& blob_desc,
-    const vector<NetDef*>& nets) {
-  for (auto& defptr : nets) {
-    // Hack to work with auto split gradients
-    CaffeMap<string, string> unmatched_sum_blobs;
-    CaffeMap<string, TensorShape> reshape_cache;
+    CaffeMap<string, string>& unmatched_sum_blobs,
+    CaffeMap<string, TensorShape>& reshape_cache) {
+  // Hack to ignore queues
+  if (op.type().find("Dequeue") != std::string::npos ||
+      op.type().find("Enqueue") != std::string::npos) {
+    return true;
+  }
 
-    for (const OperatorDef& op : defptr->op()) {
-      // Hack to ignore queues
-      if (op.type().find("Dequeue") != std::string::npos ||
-          op.type().find("Enqueue") != std::string::npos) {
-        continue;
-      }
+  vector<TensorShape> input_desc;
+  for (const string& in : op.input()) {
+    auto inp_desc = blob_desc.find(in);
+    if (inp_desc == blob_desc.end()) {
+      LOG(WARNING) << "Shape and type inference failed for input: " << in
+                   << " for op " << op.type() << ", skipping.";
+      return true;
+    }
+    input_desc.push_back(inp_desc->second);
+  }
+  auto op_schema = OpSchemaRegistry::Schema(op.type());
+  if (op_schema == nullptr) {
+    LOG(WARNING) << "Shape inference failed, no schema for: " << op.type();
+    return true;
+  }
 
-      vector<TensorShape> input_desc;
-      bool found_all = true;
-      for (const string& in : op.input()) {
-        auto inp_desc = blob_desc.find(in);
-        if (inp_desc == blob_desc.end()) {
-          LOG(WARNING) << "Shape and type inference failed for input: " << in
-                       << " for op " << op.type() << ", skipping.";
-          found_all = false;
+  // Special handling for Sum as it used with the autosplits, which have
+  // different naming convention. Assuming that all sum inputs must be of
+  // same size, we can infer their shapes.
+  if (op.type() == "Sum") {
+    TensorShape sum_shape;
+    for (auto inp : op.input()) {
+      auto it = blob_desc.find(inp);
+      if (it != blob_desc.end() && !it->second.unknown_shape()) {
+        if (it->second.dims_size() > 0) {
+          sum_shape = blob_desc[inp];
           break;
         }
-        input_desc.push_back(inp_desc->second);
-      }
-      if (!found_all) {
-        continue;
       }
-      auto op_schema = OpSchemaRegistry::Schema(op.type());
-      if (op_schema == nullptr) {
-        LOG(WARNING) << "Shape inference failed, no schema for: " << op.type();
-        continue;
+    }
+    for (auto inp : op.input()) {
+      auto it = blob_desc.find(inp);
+      if (it == blob_desc.end() || it->second.unknown_shape()) {
+        blob_desc[inp] = sum_shape;
+        if (sum_shape.dims_size() == 0) {
+          // Match later with the output
+          unmatched_sum_blobs[inp] = op.output(0);
+        }
       }
+    }
+  }
 
-      // Special handling for Sum as it used with the autosplits, which have
-      // different naming convention. Assuming that all sum inputs must be of
-      // same size, we can infer their shapes.
-      if (op.type() == "Sum") {
-        TensorShape sum_shape;
-        for (auto inp : op.input()) {
-          auto it = blob_desc.find(inp);
-          if (it != blob_desc.end() && !it->second.unknown_shape()) {
-            if (it->second.dims_size() > 0) {
-              sum_shape = blob_desc[inp];
-              break;
-            }
-          }
-        }
-        for (auto inp : op.input()) {
-          auto it = blob_desc.find(inp);
-          if (it == blob_desc.end() || it->second.unknown_shape()) {
-            blob_desc[inp] = sum_shape;
-            if (sum_shape.dims_size() == 0) {
-              // Match later with the output
-              unmatched_sum_blobs[inp] = op.output(0);
+  if (op.type() == "Reshape" && op.is_gradient_op()) {
+    CAFFE_ENFORCE(reshape_cache.find(op.input(1)) != reshape_cache.end());
+    TensorShape cached = reshape_cache[op.input(1)];
+    blob_desc[op.output(0)] = cached;
+    return true;
+  }
+
+  std::vector<TensorShape> out;
+  try {
+    out = infer_tensor(op, *op_schema, input_desc);
+    if (op.is_gradient_op() && out.size()) {
+      // Special handling for gradient ops. We can assume gradients
+      // are of same size as the corresponding variables. This is bit
+      // ugly to base on string matching, but we don't have the connection
+      // between variable and its gradient specified
+
+      CaffeMap<string, string> grads_to_params =
+          GradientMakerBase::MatchGradsToParams(op);
+
+      for (size_t i = 0; i < out.size(); i++) {
+        if (out[i].unknown_shape()) {
+          std::string gradout = op.output(i);
+
+          if (grads_to_params.find(gradout) != grads_to_params.end()) {
+            std::string var = grads_to_params[gradout];
+            if (blob_desc.find(var) != blob_desc.end()) {
+              out[i] = blob_desc[var];
             }
           }
         }
       }
+    }
 
-      if (op.type() == "Reshape" && op.is_gradient_op()) {
-        CAFFE_ENFORCE(reshape_cache.find(op.input(1)) != reshape_cache.end());
-        TensorShape cached = reshape_cache[op.input(1)];
-        blob_desc[op.output(0)] = cached;
-        continue;
-      }
+    if (op.type() == "Reshape") {
+      // Reshape stores the original input shape to its second output
+      // blob. We need this for gradient reshape.
+      reshape_cache[op.output(1)] = input_desc[0];
+    }
 
-      std::vector<TensorShape> out;
-      try {
-        out = op_schema->InferTensor(op, input_desc);
-        if (op.is_gradient_op() && out.size()) {
-          // Special handling for gradient ops. We can assume gradients
-          // are of same size as the corresponding variables. This is bit
-          // ugly to base on string matching, but we don't have the connection
-          // between variable and its gradient specified
-
-          CaffeMap<string, string> grads_to_params =
-              GradientMakerBase::MatchGradsToParams(op);
-
-          for (size_t i = 0; i < out.size(); i++) {
-            if (out[i].unknown_shape()) {
-              std::string gradout = op.output(i);
-
-              if (grads_to_params.find(gradout) != grads_to_params.end()) {
-                std::string var = grads_to_params[gradout];
-                if (blob_desc.find(var) != blob_desc.end()) {
-                  out[i] = blob_desc[var];
-                }
-              }
-            }
-          }
-        }
+  } catch (::caffe2::EnforceNotMet& enf) {
+    LOG(ERROR) << "Shape inference error: " << enf.msg();
+    LOG(ERROR) << "Operator: " << ProtoDebugString(op) << std::endl;
+    LOG(ERROR) << "Returning empty results.";
+    return false;
+  }
 
-        if (op.type() == "Reshape") {
-          // Reshape stores the original input shape to its second output
-          // blob. We need this for gradient reshape.
-          reshape_cache[op.output(1)] = input_desc[0];
-        }
+  if (out.size() != (unsigned)op.output_size()) {
+    if (op.type() == "Slice") {
+      CAFFE_ENFORCE(
+          out.size() == 0,
+          "For Slice operator, either shape of all output blobs are "
+          "inferred or shape of none can be inferred.");
+    } else {
+      CAFFE_THROW(
+          "Invalid shape inference for operator ",
+          op.type(),
+          " Expected ",
+          op.output_size(),
+          " outputs, but got ",
+          out.size());
+    }
+  } else {
+    for (size_t i = 0; i < out.size(); i++) {
+      blob_desc[op.output(i)] = out[i];
+    }
+  }
+  return true;
+}
+
+void MatchUnmatchedSumBlobs(
+    const CaffeMap<string, string>& unmatched_sum_blobs,
+    CaffeMap<string, TensorShape>& blob_desc) {
+  for (auto& unmatched : unmatched_sum_blobs) {
+    if (blob_desc.find(unmatched.second) != blob_desc.end()) {
+      blob_desc[unmatched.first] = blob_desc[unmatched.second];
+    }
+  }
+}
+
+TensorShapes ToTensorShapes(const CaffeMap<string, TensorShape>& blob_desc) {
+  TensorShapes tps;
+  for (const auto& kv : blob_desc) {
+    TensorShape* tpnew = tps.add_shapes();
+    tpnew->CopyFrom(kv.second);
+    tpnew->set_name(kv.first);
+  }
+  return tps;
+}
+
+bool SameShape(const TensorShape& a, const TensorShape& b) {
+  if (a.unknown_shape() != b.unknown_shape() ||
+      a.data_type() != b.data_type() || a.dims_size() != b.dims_size()) {
+    return false;
+  }
+  for (int i = 0; i < a.dims_size(); i++) {
+    if (a.dims(i) != b.dims(i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SameShapes(
+    const std::vector<TensorShape>& a,
+    const std::vector<TensorShape>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); i++) {
+    if (!SameShape(a[i], b[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string ShapesKey(const std::vector<TensorShape>& shapes) {
+  std::string key;
+  for (const auto& shape : shapes) {
+    key += shape.unknown_shape() ? "?" : std::to_string(shape.data_type());
+    for (auto d : shape.dims()) {
+      key += ",";
+      key += std::to_string(d);
+    }
+    key += ";";
+  }
+  return key;
+}
+
+} // namespace
 
-      } catch (::caffe2::EnforceNotMet& enf) {
-        LOG(ERROR) << "Shape inference error: " << enf.msg();
-        LOG(ERROR) << "Operator: " << ProtoDebugString(op) << std::endl;
-        LOG(ERROR) << "Returning empty results.";
+TensorShapes InferBlobShapesAndTypes(
+    CaffeMap<string, TensorShape>& blob_desc,
+    const vector<NetDef*>& nets) {
+  const InferTensorFn infer_tensor = [](const OperatorDef& op,
+                                        const OpSchema& schema,
+                                        const vector<TensorShape>& inputs) {
+    return schema.InferTensor(op, inputs);
+  };
+  for (auto& defptr : nets) {
+    // Hack to work with auto split gradients
+    CaffeMap<string, string> unmatched_sum_blobs;
+    CaffeMap<string, TensorShape> reshape_cache;
 
+    for (const OperatorDef& op : defptr->op()) {
+      if (!InferOperatorShapes(
+              op, infer_tensor, blob_desc, unmatched_sum_blobs, reshape_cache)) {
         TensorShapes tps;
         return tps;
       }
-
-      if (out.size() != (unsigned)op.output_size()) {
-        if (op.type() == "Slice") {
-          CAFFE_ENFORCE(
-              out.size() == 0,
-              "For Slice operator, either shape of all output blobs are "
-              "inferred or shape of none can be inferred.");
-        } else {
-          CAFFE_THROW(
-              "Invalid shape inference for operator ",
-              op.type(),
-              " Expected ",
-              op.output_size(),
-              " outputs, but got ",
-              out.size());
-        }
-      } else {
-        for (size_t i = 0; i < out.size(); i++) {
-          blob_desc[op.output(i)] = out[i];
-        }
-      }
     } // net.ops
 
-    for (auto& unmatched : unmatched_sum_blobs) {
-      if (blob_desc.find(unmatched.second) != blob_desc.end()) {
-        blob_desc[unmatched.first] = blob_desc[unmatched.second];
+    MatchUnmatchedSumBlobs(unmatched_sum_blobs, blob_desc);
+  } // nets
+  return ToTensorShapes(blob_desc);
+}
+
+constexpr size_t ShapeInferenceSession::kMaxMemoizedShapesPerOp;
+
+ShapeInferenceSession::ShapeInferenceSession(const NetDef& net)
+    : net_(net), op_caches_(net.op_size()) {}
+
+void ShapeInferenceSession::SetBlobShape(
+    const string& name,
+    const TensorShape& shape) {
+  input_desc_[name] = shape;
+}
+
+TensorShapes ShapeInferenceSession::Infer() {
+  blob_desc_ = input_desc_;
+  CaffeMap<string, string> unmatched_sum_blobs;
+  CaffeMap<string, TensorShape> reshape_cache;
+
+  for (int i = 0; i < net_.op_size(); i++) {
+    const auto& op = net_.op(i);
+    auto& cache = op_caches_[i];
+    const InferTensorFn infer_tensor = [this, &cache](
+                                           const OperatorDef& def,
+                                           const OpSchema& schema,
+                                           const vector<TensorShape>& inputs) {
+      // Gradient ops, and Sum with inputs of unknown shape, also depend on
+      // the shapes of other blobs. Their inference is not memoized.
+      bool cacheable = !def.is_gradient_op();
+      for (const auto& input : inputs) {
+        cacheable &= !input.unknown_shape();
+      }
+      if (!cacheable) {
+        num_inferences_++;
+        return schema.InferTensor(def, inputs);
+      }
+      if (cache.valid && SameShapes(cache.inputs, inputs)) {
+        return cache.outputs;
+      }
+      const auto key = ShapesKey(inputs);
+      auto it = cache.memo.find(key);
+      if (it == cache.memo.end()) {
+        if (cache.memo.size() >= kMaxMemoizedShapesPerOp) {
+          cache.memo.clear();
+        }
+        num_inferences_++;
+        it = cache.memo.emplace(key, schema.InferTensor(def, inputs)).first;
       }
+      cache.inputs = inputs;
+      cache.outputs = it->second;
+      cache.valid = true;
+      return cache.outputs;
+    };
+    if (!InferOperatorShapes(
+            op, infer_tensor, blob_desc_, unmatched_sum_blobs, reshape_cache)) {
+      blob_desc_.clear();
+      TensorShapes tps;
+      return tps;
     }
-
-  } // nets
-  TensorShapes tps;
-  for (auto kv : blob_desc) {
-    TensorShape& tp = kv.second;
-    TensorShape* tpnew = tps.add_shapes();
-    tpnew->CopyFrom(tp);
-    tpnew->set_name(kv.first);
   }
-  return tps;
+
+  MatchUnmatchedSumBlobs(unmatched_sum_blobs, blob_desc_);
+  return ToTensorShapes(blob_desc_);
 }
 
 TensorShape GetTensorShapeOfBlob(const Blob* b) {
@@ -2,11 +2,14 @@
 #define CAFFE2_CORE_OPERATOR_H_
 
 #include <array>
+#include <atomic>
 #include <climits>
 #include <cstddef>
 #include <exception>
+#include <mutex>
 #include <set>
 #include <typeinfo>
+#include <unordered_map>
 #include <vector>
 
 #include "caffe2/core/blob.h"
@@ -933,6 +936,66 @@ unique_ptr<OperatorBase> CreateOperator(
     Workspace* ws,
     int net_position = OperatorBase::kNoNetPositionSet);
 
+// The creators that CreateOperator picks for the ops of a net def, i.e. the
+// outcome of their schema checks and engine preferences, so that creating the
+// ops again only calls their creators, which bind their blobs. While a Scope
+// of the cache is alive on a thread, CreateOperator looks the ops of the net
+// def up by their net position, and until the cache is complete, records the
+// creators it picks for them. Used by NetTemplate.
+class OperatorCreatorCache {
+ public:
+  explicit OperatorCreatorCache(const std::shared_ptr<const NetDef>& net_def);
+
+  class Scope {
+   public:
+    explicit Scope(OperatorCreatorCache* cache);
+    ~Scope();
+
+   private:
+    OperatorCreatorCache* cache_;
+    Scope* parent_;
+    // Only one thread at a time records the creators
+    std::unique_lock<std::mutex> record_lock_;
+
+    friend class OperatorCreatorCache;
+    DISABLE_COPY_AND_ASSIGN(Scope);
+  };
+
+  bool complete() const {
+    return complete_;
+  }
+
+ private:
+  struct Entry {
+    OperatorRegistry::Creator creator;
+    std::string engine;
+  };
+
+  static Scope*& current();
+  bool owns(const OperatorDef& operator_def, int net_position) const;
+
+  // Creates the operator from its cached creator, returns nullptr if it is
+  // not cached
+  static unique_ptr<OperatorBase>
+  TryCreate(const OperatorDef& operator_def, Workspace* ws, int net_position);
+  // Records the creator and the engine picked for an operator
+  static void Record(
+      const OperatorDef& operator_def,
+      int net_position,
+      const OperatorRegistry::Creator& creator,
+      const std::string& engine);
+
+  friend unique_ptr<OperatorBase>
+  CreateOperator(const OperatorDef& operator_def, Workspace* ws, int net_position);
+
+  std::shared_ptr<const NetDef> net_def_;
+  std::vector<Entry> entries_;
+  std::atomic<bool> complete_;
+  std::mutex record_mutex_;
+
+  DISABLE_COPY_AND_ASSIGN(OperatorCreatorCache);
+};
+
 const std::string OpRegistryKey(
     const std::string& op_type,
     const std::string& engine = "");
@@ -968,6 +1031,56 @@ TensorShapes InferBlobShapesAndTypesFromMap(
     const CaffeMap<std::string, std::vector<TIndex>>& blob_dimensions,
     const vector<NetDef*>& nets);
 
+// Shape inference of one net that is run again as the shapes of some of its
+// blobs change, e.g. for every batch size it is served with. It gives the
+// same results as InferBlobShapesAndTypes, but the output shapes of each
+// operator are memoized by the shapes of its inputs: when one input shape
+// changes, only the operators whose inputs change with it run their
+// inference functions again.
+class ShapeInferenceSession {
+ public:
+  explicit ShapeInferenceSession(const NetDef& net);
+
+  // Sets the shape of a blob that is not produced by the net, e.g. an input
+  // or a weight. Shapes set stay set across calls to Infer().
+  void SetBlobShape(const string& name, const TensorShape& shape);
+
+  // Infers the shape of every blob of the net from the shapes set so far.
+  // As InferBlobShapesAndTypes, returns empty results if inference fails.
+  TensorShapes Infer();
+
+  // The shapes of the last call to Infer(), by blob name.
+  const CaffeMap<string, TensorShape>& blob_shapes() const {
+    return blob_desc_;
+  }
+
+  // Number of calls made to operator inference functions so far.
+  size_t num_inferences() const {
+    return num_inferences_;
+  }
+
+ private:
+  // Input shapes for which the memo of an op is flushed, bounding its size
+  // for nets that see many different shapes.
+  static constexpr size_t kMaxMemoizedShapesPerOp = 64;
+
+  struct OpCache {
+    // Shapes of the last inference of the op, to skip even the memo lookup
+    // when its inputs did not change.
+    bool valid = false;
+    std::vector<TensorShape> inputs;
+    std::vector<TensorShape> outputs;
+    // Output shapes by input shapes.
+    std::unordered_map<std::string, std::vector<TensorShape>> memo;
+  };
+
+  NetDef net_;
+  CaffeMap<string, TensorShape> input_desc_;
+  CaffeMap<string, TensorShape> blob_desc_;
+  std::vector<OpCache> op_caches_;
+  size_t num_inferences_ = 0;
+};
+
 std::map<string, std::pair<DeviceOption, DeviceOption>> ValidateTensorDevices(
     OperatorBase& op,
     const OperatorDef& op_def);
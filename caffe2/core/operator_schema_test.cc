@@ -276,4 +276,64 @@ TEST(OperatorSchemaTest, TestCostInference) {
   EXPECT_EQ(2000, schema->InferCost(def, shapes).flops);
 }
 
+OPERATOR_SCHEMA(OpSchemaDoubleTensorInference)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction(
+        [](const OperatorDef&, const vector<TensorShape>& in) {
+          vector<TensorShape> out(1, in[0]);
+          out[0].set_dims(0, 2 * in[0].dims(0));
+          return out;
+        });
+
+TEST(OperatorSchemaTest, ShapeInferenceSession) {
+#ifdef CAFFE2_NO_OPERATOR_SCHEMA
+  return;
+#endif
+  NetDef net;
+  *net.add_op() = CreateOperatorDef(
+      "OpSchemaDoubleTensorInference", "", {"x"}, {"y"});
+  *net.add_op() = CreateOperatorDef(
+      "OpSchemaDoubleTensorInference", "", {"y"}, {"z"});
+  *net.add_op() = CreateOperatorDef(
+      "OpSchemaDoubleTensorInference", "", {"w"}, {"v"});
+
+  auto shape = [](TIndex d) {
+    TensorShape s;
+    s.set_data_type(TensorProto::FLOAT);
+    s.add_dims(d);
+    s.add_dims(3);
+    return s;
+  };
+  ShapeInferenceSession session(net);
+  session.SetBlobShape("x", shape(2));
+  session.SetBlobShape("w", shape(5));
+  auto inferred = session.Infer();
+  EXPECT_EQ(session.num_inferences(), 3);
+  EXPECT_EQ(session.blob_shapes().at("z").dims(0), 8);
+  EXPECT_EQ(session.blob_shapes().at("v").dims(0), 10);
+
+  CaffeMap<string, TensorShape> blob_desc{{"x", shape(2)}, {"w", shape(5)}};
+  EXPECT_EQ(
+      InferBlobShapesAndTypes(blob_desc, {&net}).SerializeAsString(),
+      inferred.SerializeAsString());
+
+  // Nothing changed: no inference function runs.
+  session.Infer();
+  EXPECT_EQ(session.num_inferences(), 3);
+
+  // Only the ops downstream of x run their inference functions again.
+  session.SetBlobShape("x", shape(4));
+  session.Infer();
+  EXPECT_EQ(session.num_inferences(), 5);
+  EXPECT_EQ(session.blob_shapes().at("z").dims(0), 16);
+  EXPECT_EQ(session.blob_shapes().at("v").dims(0), 10);
+
+  // Shapes seen before are memoized.
+  session.SetBlobShape("x", shape(2));
+  session.Infer();
+  EXPECT_EQ(session.num_inferences(), 5);
+  EXPECT_EQ(session.blob_shapes().at("z").dims(0), 8);
+}
+
 }  // namespace caffe2
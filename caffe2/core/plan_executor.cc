@@ -3,10 +3,12 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <queue>
 #include <thread>
 #include <unordered_map>
 #include <vector>
 
+#include "caffe2/core/stats.h"
 #include "caffe2/core/timer.h"
 #include "caffe2/core/workspace.h"
 #include "caffe2/proto/caffe2.pb.h"
@@ -17,6 +19,15 @@ CAFFE2_DEFINE_bool(
     "If used we will handle exceptions in executor threads. "
     "This avoids SIGABRT but may cause process to deadlock");
 
+CAFFE2_DEFINE_int(
+    caffe2_plan_executor_max_threads,
+    0,
+    "If positive, the concurrent substeps of all plans run on at most this "
+    "many threads, higher priority substeps first, besides the threads "
+    "waiting for them. Substeps that wait for each other, e.g. over a "
+    "blocking queue, may then deadlock. If 0, a thread is added whenever a "
+    "substep finds none idle.");
+
 namespace caffe2 {
 
 namespace {
@@ -109,6 +120,128 @@ inline bool getShouldStop(const Blob* b) {
   return *(t.template data<bool>());
 }
 
+/**
+ * Runs the concurrent substeps of the steps of all plans. Its threads are
+ * kept for the lifetime of the process, so that steps that are run again and
+ * again (e.g. for every epoch) don't create and join a thread per substep
+ * every time.
+ *
+ * By default a thread is added whenever there is no idle one, so that all
+ * substeps of a step run at the same time as with a thread per substep. With
+ * --caffe2_plan_executor_max_threads the number of threads is bounded, the
+ * substeps wait for one in the order of their priority, and the threads
+ * waiting for their substeps run waiting substeps too.
+ */
+class SubstepExecutor {
+ public:
+  struct Task {
+    int priority;
+    std::function<void()> func;
+  };
+
+  static SubstepExecutor& instance() {
+    // Leaked, its threads may outlive static destruction.
+    static SubstepExecutor* executor =
+        new SubstepExecutor(FLAGS_caffe2_plan_executor_max_threads);
+    return *executor;
+  }
+
+  // Runs all tasks and returns once they all finished.
+  void run(std::vector<Task>&& tasks) {
+    Group group;
+    group.pending = tasks.size();
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto& task : tasks) {
+      queue_.push(
+          QueuedTask{task.priority, seq_++, std::move(task.func), &group});
+      if (idle_ > 0) {
+        --idle_;
+        ++wakeups_;
+        workCv_.notify_one();
+      } else if (maxThreads_ <= 0 || numThreads_ < maxThreads_) {
+        ++numThreads_;
+        std::thread([this]() { workerLoop(); }).detach();
+      }
+    }
+    while (group.pending > 0) {
+      if (maxThreads_ > 0 && !queue_.empty()) {
+        runNext(lock);
+      } else {
+        doneCv_.wait(lock);
+      }
+    }
+  }
+
+ private:
+  struct Group {
+    size_t pending;
+  };
+
+  struct QueuedTask {
+    int priority;
+    uint64_t seq;
+    std::function<void()> func;
+    Group* group;
+
+    // Higher priority first, then first in first out.
+    bool operator<(const QueuedTask& other) const {
+      return priority != other.priority ? priority < other.priority
+                                        : seq > other.seq;
+    }
+  };
+
+  explicit SubstepExecutor(int maxThreads) : maxThreads_(maxThreads) {}
+
+  // As with a thread per substep, an exception escaping a substep
+  // terminates the process.
+  static void runTask(const std::function<void()>& func) noexcept {
+    func();
+  }
+
+  void runNext(std::unique_lock<std::mutex>& lock) {
+    QueuedTask task = queue_.top();
+    queue_.pop();
+    lock.unlock();
+    runTask(task.func);
+    lock.lock();
+    if (--task.group->pending == 0) {
+      doneCv_.notify_all();
+    }
+  }
+
+  void workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      if (queue_.empty()) {
+        ++idle_;
+        workCv_.wait(lock, [this]() { return wakeups_ > 0; });
+        --wakeups_;
+        continue;
+      }
+      runNext(lock);
+    }
+  }
+
+  const int maxThreads_;
+  std::mutex mutex_;
+  std::condition_variable workCv_;
+  std::condition_variable doneCv_;
+  std::priority_queue<QueuedTask> queue_;
+  uint64_t seq_{0};
+  int numThreads_{0};
+  // Idle threads that haven't been woken for a task yet.
+  int idle_{0};
+  int wakeups_{0};
+};
+
+struct SubstepStats {
+  CAFFE_STAT_CTOR(SubstepStats);
+  // Time from starting the concurrent substeps of the parent step until
+  // the substep got a thread.
+  CAFFE_AVG_EXPORTED_STAT(queue_time_ns);
+  CAFFE_AVG_EXPORTED_STAT(run_time_ns);
+};
+
 /**
  * Injects a blob named 'GLOBAL_WORKSPACE_ID' for each workspace, only if
  * another blob named 'NODE_ID' is present. 'NODE_ID' blob can be used in a
@@ -178,7 +311,8 @@ struct ExecutionStepWrapper {
         externalWorkspace_(externalWorkspace),
         externalShouldContinue_(externalShouldContinue),
         netDefs_(netDefs),
-        ws_id_injector_(ws_id_injector) {
+        ws_id_injector_(ws_id_injector),
+        stats_("execution_step/" + step->name()) {
     // If this execution step does not create a child workspace,
     // then just eagerly-compile it. This will trigger CreateNet on the
     // nets used by this execution step.
@@ -213,6 +347,10 @@ struct ExecutionStepWrapper {
     return *step_;
   }
 
+  SubstepStats& stats() {
+    return stats_;
+  }
+
   CompiledGuard compiled() {
     CompiledGuard guard;
     if (compiledStep_) {
@@ -232,6 +370,7 @@ struct ExecutionStepWrapper {
   NetDefMap* netDefs_;
   std::unique_ptr<CompiledExecutionStep> compiledStep_;
   WorkspaceIdInjector* ws_id_injector_;
+  SubstepStats stats_;
 };
 
 struct CompiledExecutionStep {
@@ -401,19 +540,21 @@ bool ExecuteStepRecursive(ExecutionStepWrapper& stepWrapper) {
         VLOG(1) << "Executing step " << step.name() << " iteration " << iter
                 << " with " << step.substep().size() << " concurrent substeps";
 
-        std::atomic<int> next_substep{0};
         std::mutex exception_mutex;
         string first_exception;
-        auto worker = [&]() {
-          auto num_substeps = compiledStep->recurringSubsteps.size();
-          int substep_id = next_substep++ % num_substeps;
+        Timer timer;
+        auto worker = [&](ExecutionStepWrapper* substepWrapper) {
+          auto& stats = substepWrapper->stats();
+          CAFFE_EVENT(
+              stats, queue_time_ns, static_cast<int64_t>(timer.NanoSeconds()));
           if (compiledStep->gotFailure) {
             return;
           }
           try {
-            if (!ExecuteStepRecursive(
-                    *compiledStep->recurringSubsteps.at(substep_id))) {
-              compiledStep->gotFailure = true;
+            CAFFE_DURATION(stats, run_time_ns) {
+              if (!ExecuteStepRecursive(*substepWrapper)) {
+                compiledStep->gotFailure = true;
+              }
             }
           } catch (const std::exception& ex) {
             std::lock_guard<std::mutex> guard(exception_mutex);
@@ -432,17 +573,19 @@ bool ExecuteStepRecursive(ExecutionStepWrapper& stepWrapper) {
           }
         };
 
-        std::vector<std::thread> threads;
-        auto numThreads = compiledStep->recurringSubsteps.size();
+        std::vector<SubstepExecutor::Task> tasks;
+        const auto& substeps = compiledStep->recurringSubsteps;
+        auto numTasks = substeps.size();
         if (step.has_num_concurrent_instances()) {
-          numThreads *= step.num_concurrent_instances();
-        }
-        for (size_t i = 0; i < numThreads; ++i) {
-          threads.emplace_back(worker);
+          numTasks *= step.num_concurrent_instances();
         }
-        for (auto& thread : threads) {
-          thread.join();
+        for (size_t i = 0; i < numTasks; ++i) {
+          auto* substepWrapper = substeps[i % substeps.size()].get();
+          tasks.push_back(
+              {substepWrapper->step().priority(),
+               [&worker, substepWrapper]() { worker(substepWrapper); }});
         }
+        SubstepExecutor::instance().run(std::move(tasks));
         if (compiledStep->gotFailure) {
           LOG(ERROR) << "One of the workers failed.";
           if (first_exception.size()) {
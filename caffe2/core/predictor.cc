@@ -3,37 +3,58 @@
 #include "caffe2/opt/optimizer.h"
 #endif
 
+#include <set>
 #include <unordered_set>
 #include "caffe2/core/init.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/quantized/int8_net_rewrite.h"
 
 namespace caffe2 {
 
 namespace {
 
-void enforceIsTensor(Workspace* ws, const std::string& name) {
-  auto blob = ws->GetBlob(name);
+TensorCPU* blobTensor(Blob* blob, const std::string& name) {
   CAFFE_ENFORCE(blob, "Blob does not exist: ", name);
   CAFFE_ENFORCE(
       blob->template IsType<TensorCPU>(), "Blob is not a CPU Tensor: ", name);
+  return blob->template GetMutable<TensorCPU>();
 }
 
-void shareInputTensor(
-    Workspace* ws,
-    const std::string& name,
-    TensorCPU* input) {
-  enforceIsTensor(ws, name);
-  auto* blob = ws->GetBlob(name);
-  CAFFE_ENFORCE(blob, "Blob: ", name, " does not exist");
-  auto* tensor = blob->template GetMutable<TensorCPU>();
+void shareInputTensor(Blob* blob, const std::string& name, TensorCPU* input) {
+  auto* tensor = blobTensor(blob, name);
   tensor->ResizeLike(*input);
   tensor->ShareData(*input);
 }
 
-TensorCPU* extractOutputTensor(Workspace* ws, const std::string& name) {
-  enforceIsTensor(ws, name);
-  auto* blob = ws->GetBlob(name);
-  CAFFE_ENFORCE(blob, "Blob: ", name, " does not exist");
-  return blob->template GetMutable<TensorCPU>();
+// Switches the FC and Conv operators whose weights are constants, i.e. blobs
+// of the workspace that no operator of the net writes, to the engines that
+// pack the weights when they first run and reuse them: PACKED where the MKL
+// packed GEMMs are available, and NNPACK Conv with precomputed transforms.
+NetDef packConstantWeights(const NetDef& net, const Workspace& ws) {
+  std::unordered_set<std::string> written;
+  for (const auto& op : net.op()) {
+    written.insert(op.output().begin(), op.output().end());
+  }
+  NetDef packed = net;
+  for (auto& op : *packed.mutable_op()) {
+    const bool cpu = !op.has_device_option() ||
+        op.device_option().device_type() == CPU;
+    if (!cpu || (op.type() != "FC" && op.type() != "Conv") ||
+        op.input_size() < 2 || written.count(op.input(1)) ||
+        !ws.HasBlob(op.input(1))) {
+      continue;
+    }
+    if (op.engine().empty() &&
+        CPUOperatorRegistry()->Has(OpRegistryKey(op.type(), "PACKED"))) {
+      op.set_engine("PACKED");
+    } else if (
+        op.type() == "Conv" && op.engine() == "NNPACK" &&
+        !ArgumentHelper(op).HasArgument("convolution_transform_strategy")) {
+      op.add_arg()->CopyFrom(MakeArgument<std::string>(
+          "convolution_transform_strategy", "PRECOMPUTE"));
+    }
+  }
+  return packed;
 }
 
 // We don't use the getNet() from predictor_utils.cc here because that file
@@ -86,7 +107,9 @@ Predictor::Predictor(
     const NetDef& run_net,
     Workspace* parent,
     bool run_init,
-    int optimization)
+    int optimization,
+    bool dynamic_quantization,
+    bool pack_weights)
     : run_net_(run_net), ws_(parent) {
 
   if (run_init) {
@@ -107,47 +130,130 @@ Predictor::Predictor(
     LOG(WARNING) << "Caffe2 is compiled without optimization passes.";
 #endif
   }
+  if (dynamic_quantization) {
+    run_net_ = int8::RewriteDynamicQuantNet(run_net_);
+  }
+  if (pack_weights) {
+    run_net_ = packConstantWeights(run_net_, ws_);
+  }
 
   // real model inputs can be fed later in run* functions
   const auto& initialized_vec = ws_.Blobs();
   const std::unordered_set<std::string> initialized{initialized_vec.begin(),
                                                     initialized_vec.end()};
-  for (const auto& name : run_net.external_input()) {
+  for (const auto& name : run_net_.external_input()) {
     if (!initialized.count(name)) {
       auto* blob = ws_.CreateBlob(name);
       blob->template GetMutable<TensorCPU>();
     }
   }
 
-  CAFFE_ENFORCE(ws_.CreateNet(run_net));
+  CAFFE_ENFORCE(ws_.CreateNet(run_net_));
+
+  for (const auto& name : run_net_.external_input()) {
+    inputHandles_.emplace_back(name);
+  }
+  for (const auto& name : run_net_.external_output()) {
+    outputHandles_.emplace_back(name);
+  }
+}
+
+bool Predictor::plan_memory(
+    const TensorMap& inputs,
+    memonger::PlacementStrategy strategy) {
+  // Weights and inputs keep their own storage; only blobs written by the
+  // ops of run_net get planned.
+  std::unordered_set<string> produced;
+  for (const auto& op : run_net_.op()) {
+    produced.insert(op.output().begin(), op.output().end());
+  }
+  // Plans for other input shapes only infer the shapes that changed.
+  if (!shapeInference_) {
+    shapeInference_.reset(new ShapeInferenceSession(run_net_));
+  }
+  std::set<string> static_blobs;
+  for (const auto& name : ws_.Blobs()) {
+    shapeInference_->SetBlobShape(
+        name, GetTensorShapeOfBlob(ws_.GetBlob(name)));
+    if (!produced.count(name)) {
+      static_blobs.insert(name);
+    }
+  }
+  for (const auto& input : inputs) {
+    TensorShape shape;
+    for (auto d : input.second->dims()) {
+      shape.add_dims(d);
+    }
+    shape.set_data_type(TypeMetaToDataType(input.second->meta()));
+    shapeInference_->SetBlobShape(input.first, shape);
+    static_blobs.insert(input.first);
+  }
+  for (const auto& name : run_net_.external_input()) {
+    static_blobs.insert(name);
+  }
+
+  shapeInference_->Infer();
+  const auto& shapes = shapeInference_->blob_shapes();
+  auto plan =
+      memonger::plan_static_memory(run_net_, shapes, static_blobs, strategy);
+  if (plan.allocations.empty()) {
+    return false;
+  }
+
+  // Detach blobs of a previous plan before their arena goes away.
+  for (const auto& allocation : memoryPlan_.allocations) {
+    ws_.GetBlob(allocation.blob)->GetMutable<TensorCPU>()->FreeMemory();
+  }
+  auto ptr_and_deleter = CPUContext::New(plan.arena_bytes);
+  std::unique_ptr<void, MemoryDeleter> arena(
+      ptr_and_deleter.first, ptr_and_deleter.second);
+  for (const auto& allocation : plan.allocations) {
+    const auto& shape = shapes.at(allocation.blob);
+    std::vector<TIndex> dims(shape.dims().begin(), shape.dims().end());
+    auto* tensor = ws_.CreateBlob(allocation.blob)->GetMutable<TensorCPU>();
+    tensor->Resize(dims);
+    tensor->ShareExternalPointer(
+        static_cast<char*>(arena.get()) + allocation.offset,
+        DataTypeToTypeMeta(shape.data_type()),
+        allocation.nbytes);
+  }
+  arena_ = std::move(arena);
+  memoryPlan_ = std::move(plan);
+  return true;
 }
 
 bool Predictor::run(const TensorVector& inputs, TensorVector* outputs) {
   CAFFE_ENFORCE(inputs.size() <= (unsigned)run_net_.external_input_size());
   for (size_t i = 0; i < inputs.size(); ++i) {
-    shareInputTensor(&ws_, run_net_.external_input(i), inputs[i]);
+    shareInputTensor(
+        ws_.GetBlob(inputHandles_[i]), inputHandles_[i].name(), inputs[i]);
   }
 
   if (!ws_.RunNet(run_net_.name())) {
     return false;
   }
 
-  outputs->resize(run_net_.external_output_size());
+  extractOutputTensors(outputs);
+  return true;
+}
+
+void Predictor::extractOutputTensors(TensorVector* outputs) {
+  outputs->resize(outputHandles_.size());
   for (size_t i = 0; i < outputs->size(); ++i) {
-    (*outputs)[i] = extractOutputTensor(&ws_, run_net_.external_output(i));
+    (*outputs)[i] =
+        blobTensor(ws_.GetBlob(outputHandles_[i]), outputHandles_[i].name());
   }
-  return true;
 }
 
 bool Predictor::run_map_workspace(const TensorMap& inputs) {
   if (!inputNames_.empty()) {
     CAFFE_ENFORCE_EQ(inputs.size(), inputNames_.size());
   }
-  for (auto input : inputs) {
+  for (const auto& input : inputs) {
     if (!inputNames_.empty()) {
       CAFFE_ENFORCE_GT(inputNames_.count(input.first), 0);
     }
-    shareInputTensor(&ws_, input.first, input.second);
+    shareInputTensor(ws_.GetBlob(input.first), input.first, input.second);
   }
 
   return ws_.RunNet(run_net_.name());
@@ -158,10 +264,7 @@ bool Predictor::run_map(const TensorMap& inputs, TensorVector* outputs) {
     return false;
   }
 
-  outputs->resize(run_net_.external_output_size());
-  for (size_t i = 0; i < outputs->size(); ++i) {
-    (*outputs)[i] = extractOutputTensor(&ws_, run_net_.external_output(i));
-  }
+  extractOutputTensors(outputs);
   return true;
 }
 
@@ -172,7 +275,7 @@ bool Predictor::run_map_outputs(const TensorMap& inputs, TensorMap* outputs) {
 
   outputs->reserve(outputNames_.size());
   for (const std::string& outputName : outputNames_) {
-    (*outputs)[outputName] = extractOutputTensor(&ws_, outputName);
+    (*outputs)[outputName] = blobTensor(ws_.GetBlob(outputName), outputName);
   }
   return true;
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <unordered_set>
+#include "caffe2/core/memonger.h"
 #include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/proto/metanet.pb.h"
 #include "caffe2/proto/predictor_consts.pb.h"
@@ -21,13 +23,20 @@ class Predictor {
       bool run_init = true);
 
   // Runs the `init_net` once, then saves the `run_net` to be executed
-  // in `::run`
+  // in `::run`. With the optimizer, `optimization` is the level of
+  // opt::optimize applied to `run_net`, e.g. 2 for inference nets.
+  // `dynamic_quantization` runs its FC operators, including the recurrent
+  // ones of LSTMs, with int8 weights and activations (see FCDynamicQuant).
+  // `pack_weights` packs the constant weights of its FC and Conv operators
+  // once for the backend (see predictor_utils::packConstantWeights)
   Predictor(
       const NetDef& init_net,
       const NetDef& run_net,
       Workspace* parent = nullptr,
       bool run_init = true,
-      int optimization = 0);
+      int optimization = 0,
+      bool dynamic_quantization = false,
+      bool pack_weights = false);
 
   ~Predictor() {}
 
@@ -51,6 +60,24 @@ class Predictor {
   // string name to tensor.
   bool run_map_outputs(const TensorMap& inputs, TensorMap* outputs);
 
+  // Plans the memory of run_net ahead of time for inputs shaped like
+  // `inputs` (only their shapes and types are used): infers the shape of
+  // every intermediate and output blob, packs them into a single arena by
+  // lifetime, and binds each blob to its slice. After this, runs with inputs
+  // of the same shapes perform no allocations for the planned blobs; blobs
+  // that outgrow their slice fall back to allocating as usual.
+  //
+  // Only sequential ("simple") run_nets can be planned. Returns false, and
+  // leaves the workspace untouched, if nothing could be planned.
+  bool plan_memory(
+      const TensorMap& inputs,
+      memonger::PlacementStrategy strategy =
+          memonger::PlacementStrategy::GREEDY_BY_SIZE);
+
+  const memonger::MemoryPlan& memory_plan() const {
+    return memoryPlan_;
+  }
+
   const NetDef& def() const {
     return run_net_;
   };
@@ -69,6 +96,7 @@ class Predictor {
 
  private:
   bool run_map_workspace(const TensorMap& inputs);
+  void extractOutputTensors(TensorVector* outputs);
 
   NetDef run_net_;
   Workspace ws_;
@@ -76,5 +104,14 @@ class Predictor {
   // Outputs need to be ordered since TensorVector outputs rely on the outputs
   // being in a certain order.
   std::vector<std::string> outputNames_;
+  // The external inputs and outputs of run_net_, so that run() does not look
+  // their blobs up by name on every call.
+  std::vector<BlobHandle> inputHandles_;
+  std::vector<BlobHandle> outputHandles_;
+  memonger::MemoryPlan memoryPlan_;
+  // Shape inference of run_net_ for plan_memory, memoized across plans.
+  std::unique_ptr<ShapeInferenceSession> shapeInference_;
+  // Backs all blobs of memoryPlan_; the tensors only borrow it.
+  std::unique_ptr<void, MemoryDeleter> arena_{nullptr, [](void*) {}};
 };
 }
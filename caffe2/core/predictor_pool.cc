@@ -0,0 +1,154 @@
+#include "caffe2/core/predictor_pool.h"
+
+#include "caffe2/core/predictor_utils.h"
+
+namespace caffe2 {
+
+PredictorPool::PredictorPool(
+    const NetDef& init_net,
+    const NetDef& run_net,
+    size_t max_size,
+    int optimization)
+    : max_size_(max_size) {
+  CAFFE_ENFORCE_GT(max_size_, 0);
+  CAFFE_ENFORCE(parameters_.RunNetOnce(init_net));
+  checkRunNet(run_net);
+  // run() feeds the leading external inputs of the run net, which must
+  // therefore be the ones the init net doesn't create.
+  int num_inputs = 0;
+  while (num_inputs < run_net.external_input_size() &&
+         !parameters_.HasBlob(run_net.external_input(num_inputs))) {
+    ++num_inputs;
+  }
+  for (int i = num_inputs; i < run_net.external_input_size(); ++i) {
+    CAFFE_ENFORCE(
+        parameters_.HasBlob(run_net.external_input(i)),
+        "Run net input ",
+        run_net.external_input(i),
+        " follows parameter ",
+        run_net.external_input(num_inputs),
+        " in external_input; inputs must be listed before the parameters");
+  }
+  factory_ = [this, init_net, run_net, optimization]() {
+    return new Predictor(
+        init_net, run_net, &parameters_, false /* run_init */, optimization);
+  };
+}
+
+PredictorPool::PredictorPool(const MetaNetDef& net, size_t max_size)
+    : max_size_(max_size) {
+  CAFFE_ENFORCE_GT(max_size_, 0);
+  const auto& consts = PredictorConsts::default_instance();
+  CAFFE_ENFORCE(parameters_.RunNetOnce(
+      predictor_utils::getNet(net, consts.global_init_net_type())));
+  checkRunNet(predictor_utils::getNet(net, consts.predict_net_type()));
+  for (const auto& blobs : net.blobs()) {
+    if (blobs.key() == consts.inputs_blob_type()) {
+      for (const auto& input : blobs.value()) {
+        checkInput(input);
+      }
+    }
+  }
+  factory_ = [this, net]() {
+    return new Predictor(net, &parameters_, false /* run_init */);
+  };
+}
+
+PredictorPool::~PredictorPool() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (idle_.size() != predictors_.size()) {
+    LOG(ERROR) << "PredictorPool destroyed with "
+               << predictors_.size() - idle_.size()
+               << " predictors still checked out";
+  }
+}
+
+void PredictorPool::checkRunNet(const NetDef& run_net) const {
+  // A blob of the parameter workspace written by the run net would be
+  // shared, and raced on, by all predictors.
+  for (const auto& op : run_net.op()) {
+    for (const auto& output : op.output()) {
+      CAFFE_ENFORCE(
+          !parameters_.HasBlob(output),
+          "Run net writes parameter blob ",
+          output,
+          " (from op ",
+          op.type(),
+          "), which cannot be shared between predictors");
+    }
+  }
+}
+
+void PredictorPool::checkInput(const std::string& input) const {
+  // Feeding a blob of the parameter workspace would rebind the tensor that
+  // all predictors share, while they run.
+  CAFFE_ENFORCE(
+      !parameters_.HasBlob(input),
+      "Run net input ",
+      input,
+      " is created by the init net, and cannot be shared between predictors");
+}
+
+PredictorPool::PredictorPtr PredictorPool::checkout() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return checkoutLocked(lock, true);
+}
+
+PredictorPool::PredictorPtr PredictorPool::try_checkout() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return checkoutLocked(lock, false);
+}
+
+size_t PredictorPool::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return predictors_.size();
+}
+
+PredictorPool::PredictorPtr PredictorPool::checkoutLocked(
+    std::unique_lock<std::mutex>& lock,
+    bool wait) {
+  auto deleter = [this](Predictor* predictor) { release(predictor); };
+  while (idle_.empty() && predictors_.size() + creating_ >= max_size_) {
+    if (!wait) {
+      return PredictorPtr(nullptr, deleter);
+    }
+    released_.wait(lock);
+  }
+  if (!idle_.empty()) {
+    Predictor* predictor = idle_.back();
+    idle_.pop_back();
+    return PredictorPtr(predictor, deleter);
+  }
+
+  // Creating a predictor instantiates all operators of the run net, so it
+  // is done without holding up other checkouts and returns.
+  ++creating_;
+  lock.unlock();
+  std::unique_ptr<Predictor> predictor;
+  try {
+    predictor.reset(factory_());
+  } catch (...) {
+    lock.lock();
+    --creating_;
+    released_.notify_one();
+    throw;
+  }
+  lock.lock();
+  --creating_;
+  Predictor* raw = predictor.get();
+  predictors_.push_back(std::move(predictor));
+  return PredictorPtr(raw, deleter);
+}
+
+void PredictorPool::release(Predictor* predictor) {
+  if (!predictor) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    idle_.push_back(predictor);
+  }
+  released_.notify_one();
+}
+
+} // namespace caffe2
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "caffe2/core/predictor.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+// A pool of Predictors for serving concurrent requests from one model.
+//
+// The init net runs once, into a parameter workspace owned by the pool.
+// Every Predictor of the pool gets its own workspace, which only holds the
+// activations and reads the parameters from the shared one, so N
+// concurrent runs cost one copy of the weights plus N sets of activations.
+// The run net must therefore not write any blob the init net creates, and
+// its inputs must not be created by the init net either: they are fed into
+// the workspace of each predictor. With a NetDef run net, the inputs are
+// the external inputs listed before the first parameter.
+//
+// A Predictor is not safe to run concurrently; check one out for the
+// duration of a request instead:
+//
+//   auto predictor = pool.checkout();
+//   predictor->run(inputs, &outputs);
+//   // use outputs; they belong to predictor's workspace
+//   // predictor goes back to the pool when the handle is destroyed
+//
+// Predictors are created on demand, up to max_size.
+class PredictorPool {
+ public:
+  using PredictorPtr =
+      std::unique_ptr<Predictor, std::function<void(Predictor*)>>;
+
+  PredictorPool(
+      const NetDef& init_net,
+      const NetDef& run_net,
+      size_t max_size,
+      int optimization = 0);
+
+  PredictorPool(const MetaNetDef& net, size_t max_size);
+
+  // All checked out predictors must have been returned; an error is logged
+  // otherwise.
+  ~PredictorPool();
+
+  // Returns an idle predictor, creating one if none is idle and fewer than
+  // max_size exist, and otherwise blocks until one is returned.
+  PredictorPtr checkout();
+
+  // Like checkout(), but returns nullptr instead of blocking.
+  PredictorPtr try_checkout();
+
+  // Number of predictors created so far.
+  size_t size() const;
+
+  size_t max_size() const {
+    return max_size_;
+  }
+
+  // The shared, read-only parameter workspace.
+  const Workspace& parameters() const {
+    return parameters_;
+  }
+
+ private:
+  void checkRunNet(const NetDef& run_net) const;
+  void checkInput(const std::string& input) const;
+  PredictorPtr checkoutLocked(std::unique_lock<std::mutex>& lock, bool wait);
+  void release(Predictor* predictor);
+
+  Workspace parameters_;
+  std::function<Predictor*()> factory_;
+  const size_t max_size_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable released_;
+  std::vector<std::unique_ptr<Predictor>> predictors_;
+  std::vector<Predictor*> idle_;
+  // Number of creations in progress (done outside the lock).
+  size_t creating_ = 0;
+
+  DISABLE_COPY_AND_ASSIGN(PredictorPool);
+};
+
+} // namespace caffe2
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "caffe2/core/predictor_pool.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+const char* predictSpec = R"DOC(
+        name: "predict"
+        type: "simple"
+        external_input: "data"
+        external_input: "W"
+        external_input: "b"
+        external_output: "y"
+        op {
+          input: "data"
+          input: "W"
+          input: "b"
+          output: "y"
+          type: "FC"
+        }
+)DOC";
+
+const char* initSpec = R"DOC(
+        name: "init"
+        type: "simple"
+        op {
+          type: "ConstantFill"
+          output: "W"
+          arg {
+            name: "shape"
+            ints: 10
+            ints: 4
+          }
+          arg {
+            name: "value"
+            f: 2.0
+          }
+        }
+        op {
+          type: "ConstantFill"
+          output: "b"
+          arg {
+            name: "shape"
+            ints: 10
+          }
+          arg {
+            name: "value"
+            f: 1.0
+          }
+        }
+)DOC";
+
+NetDef parseNetDef(const std::string& value) {
+  NetDef def;
+  CAFFE_ENFORCE(
+      TextFormat::ParseFromString(value, &def),
+      "Failed to parse NetDef with value: ",
+      value);
+  return def;
+}
+
+// y = 2 * sum(data) + 1 for every output.
+bool runOnce(Predictor* predictor, float x) {
+  TensorCPU input(std::vector<TIndex>{1, 4});
+  std::fill(input.mutable_data<float>(), input.mutable_data<float>() + 4, x);
+  Predictor::TensorVector inputs{&input};
+  Predictor::TensorVector outputs;
+  if (!predictor->run(inputs, &outputs) || outputs.size() != 1) {
+    return false;
+  }
+  const float* y = outputs[0]->data<float>();
+  return std::all_of(y, y + 10, [x](float v) { return v == 8 * x + 1; });
+}
+
+} // namespace
+
+TEST(PredictorPoolTest, SharesParameters) {
+  PredictorPool pool(parseNetDef(initSpec), parseNetDef(predictSpec), 2);
+  EXPECT_TRUE(pool.parameters().HasBlob("W"));
+  auto first = pool.checkout();
+  auto second = pool.checkout();
+  EXPECT_NE(first.get(), second.get());
+  EXPECT_EQ(pool.size(), 2);
+  for (auto* predictor : {first.get(), second.get()}) {
+    auto local = predictor->ws()->LocalBlobs();
+    EXPECT_EQ(std::count(local.begin(), local.end(), "W"), 0);
+    EXPECT_EQ(
+        predictor->ws()->GetBlob("W"), pool.parameters().GetBlob("W"));
+    EXPECT_TRUE(runOnce(predictor, 1));
+  }
+  EXPECT_EQ(pool.try_checkout(), nullptr);
+  Predictor* returned = first.get();
+  first.reset();
+  auto third = pool.checkout();
+  EXPECT_EQ(third.get(), returned);
+  EXPECT_EQ(pool.size(), 2);
+}
+
+TEST(PredictorPoolTest, ConcurrentRuns) {
+  PredictorPool pool(parseNetDef(initSpec), parseNetDef(predictSpec), 3);
+  std::atomic<int> failures(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&pool, &failures, t]() {
+      for (int i = 0; i < 100; ++i) {
+        auto predictor = pool.checkout();
+        if (!runOnce(predictor.get(), t + i)) {
+          ++failures;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(failures, 0);
+  EXPECT_LE(pool.size(), 3);
+}
+
+TEST(PredictorPoolTest, RejectsWritesToParameters) {
+  auto predict = parseNetDef(predictSpec);
+  predict.mutable_op(0)->set_output(0, "b");
+  EXPECT_THROW(
+      PredictorPool(parseNetDef(initSpec), predict, 2), EnforceNotMet);
+}
+
+TEST(PredictorPoolTest, RejectsInputsAfterParameters) {
+  auto predict = parseNetDef(predictSpec);
+  predict.set_external_input(0, "W");
+  predict.set_external_input(1, "data");
+  EXPECT_THROW(
+      PredictorPool(parseNetDef(initSpec), predict, 2), EnforceNotMet);
+}
+
+TEST(PredictorPoolTest, RejectsInputsCreatedByInitNet) {
+  const auto& consts = PredictorConsts::default_instance();
+  auto init = parseNetDef(initSpec);
+  auto* fill = init.add_op();
+  fill->CopyFrom(init.op(0));
+  fill->set_output(0, "data");
+  MetaNetDef def;
+  auto* init_net = def.add_nets();
+  init_net->set_key(consts.global_init_net_type());
+  init_net->mutable_value()->CopyFrom(init);
+  auto* predict_net = def.add_nets();
+  predict_net->set_key(consts.predict_net_type());
+  predict_net->mutable_value()->CopyFrom(parseNetDef(predictSpec));
+  auto* inputs = def.add_blobs();
+  inputs->set_key(consts.inputs_blob_type());
+  inputs->add_value("data");
+  EXPECT_THROW(PredictorPool(def, 2), EnforceNotMet);
+}
+
+} // namespace caffe2
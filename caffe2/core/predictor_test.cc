@@ -201,6 +201,68 @@ TEST_F(PredictorTest, SimpleBatchSizedMapInput) {
   EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
 }
 
+TEST_F(PredictorTest, PlannedMemory) {
+  auto predict = parseNetDef(predictSpec);
+  predict.set_type("simple");
+  // An intermediate blob that is dead by the time y is written.
+  auto* relu = predict.add_op();
+  relu->set_type("Relu");
+  relu->add_input("y");
+  relu->add_output("z");
+  predict.set_external_output(0, "z");
+  Predictor p(parseNetDef(initSpec), predict);
+
+  auto inputData = randomTensor({1, 4}, ctx_.get());
+  Predictor::TensorMap input{
+      {"data", inputData->template GetMutable<TensorCPU>()}};
+  EXPECT_TRUE(p.plan_memory(input));
+  EXPECT_EQ(p.memory_plan().allocations.size(), 2);
+  const void* planned = p.ws()->GetBlob("z")->Get<TensorCPU>().raw_data();
+
+  Predictor::TensorVector output;
+  EXPECT_TRUE(p.run_map(input, &output));
+  EXPECT_EQ(output.size(), 1);
+  EXPECT_EQ(output.front()->raw_data(), planned);
+  EXPECT_TRUE(output.front()->dim(0) == 1);
+  EXPECT_TRUE(output.front()->dim(1) == 10);
+  EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
+}
+
+TEST_F(PredictorTest, PackedWeights) {
+  Predictor p(
+      parseNetDef(initSpec), parseNetDef(predictSpec), nullptr, true, 0,
+      false, true);
+  // The weights are constants of the init net
+  const bool packed = CPUOperatorRegistry()->Has(OpRegistryKey("FC", "PACKED"));
+  EXPECT_EQ(p.def().op(0).engine(), packed ? "PACKED" : "");
+
+  auto inputData = randomTensor({1, 4}, ctx_.get());
+  Predictor::TensorVector input{inputData->template GetMutable<TensorCPU>()};
+  Predictor::TensorVector output;
+  for (int run = 0; run < 2; ++run) {
+    EXPECT_TRUE(p.run(input, &output));
+    EXPECT_EQ(output.size(), 1);
+    EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
+  }
+}
+
+TEST_F(PredictorTest, PackedWeightsKeepsWrittenWeights) {
+  auto predict = parseNetDef(predictSpec);
+  auto* copy = predict.add_op();
+  copy->set_type("Copy");
+  copy->add_input("b");
+  copy->add_output("W");
+  Predictor p(parseNetDef(initSpec), predict, nullptr, true, 0, false, true);
+  EXPECT_EQ(p.def().op(0).engine(), "");
+}
+
+TEST_F(PredictorTest, PlannedMemoryNeedsSimpleNet) {
+  auto inputData = randomTensor({1, 4}, ctx_.get());
+  Predictor::TensorMap input{
+      {"data", inputData->template GetMutable<TensorCPU>()}};
+  EXPECT_FALSE(p_->plan_memory(input));
+}
+
 class PredictorMetaNetDefTest : public testing::Test {
  public:
   void SetUp() override {
@@ -2,10 +2,9 @@
  * Simple registry implementation in Caffe2 that uses static variables to
  * register object creators during program initialization time.
  *
- * WARNING: this registry is not entirely thread-safe, as reads to
- * the registry are not protected by a mutex.  The safest mode of use
- * is to dlopen() *all* dynamic libraries that may write to the library
- * and synchronize prior to performing any reads on the registry.
+ * Reads from the registry are wait-free and may run concurrently with
+ * registrations, e.g. from dlopen()ed libraries: the creators are kept in a
+ * LeftRight, so readers never contend on the mutex serializing the writers.
  */
 #ifndef CAFFE2_CORE_REGISTRY_H_
 #define CAFFE2_CORE_REGISTRY_H_
@@ -18,6 +17,7 @@
 #include <mutex>
 
 #include "caffe2/core/common.h"
+#include "caffe2/core/dispatch/LeftRight.h"
 #include "caffe2/core/typeid.h"
 
 namespace caffe2 {
@@ -57,38 +57,60 @@ class Registry {
     // carried out at static initialization time, we do not want to have an
     // explicit dependency on glog's initialization function.
     std::lock_guard<std::mutex> lock(register_mutex_);
-    if (registry_.count(key) != 0) {
+    if (Has(key)) {
       printf("Key already registered.\n");
       PrintOffendingKey(key);
       std::exit(1);
     }
-    registry_[key] = creator;
+    registry_.write([&key, &creator](CaffeMap<SrcType, Creator>& registry) {
+      registry[key] = creator;
+    });
   }
 
   void Register(const SrcType& key, Creator creator, const string& help_msg) {
     Register(key, creator);
+    std::lock_guard<std::mutex> lock(register_mutex_);
     help_message_[key] = help_msg;
   }
 
-  inline bool Has(const SrcType& key) { return (registry_.count(key) != 0); }
+  inline bool Has(const SrcType& key) {
+    return registry_.read([&key](const CaffeMap<SrcType, Creator>& registry) {
+      return registry.count(key) != 0;
+    });
+  }
+
+  /**
+   * Returns the creator registered with the key, or an empty one.
+   */
+  Creator GetCreator(const SrcType& key) {
+    return registry_.read([&key](const CaffeMap<SrcType, Creator>& registry) {
+      auto it = registry.find(key);
+      return it == registry.end() ? Creator() : it->second;
+    });
+  }
 
   ObjectPtrType Create(const SrcType& key, Args... args) {
-    if (registry_.count(key) == 0) {
+    // Copies the creator out so that the object is not constructed while
+    // holding up the writers
+    const Creator creator = GetCreator(key);
+    if (!creator) {
       // Returns nullptr if the key is not registered.
       return nullptr;
     }
-    return registry_[key](args...);
+    return creator(args...);
   }
 
   /**
    * Returns the keys currently registered as a vector.
    */
   vector<SrcType> Keys() {
-    vector<SrcType> keys;
-    for (const auto& it : registry_) {
-      keys.push_back(it.first);
-    }
-    return keys;
+    return registry_.read([](const CaffeMap<SrcType, Creator>& registry) {
+      vector<SrcType> keys;
+      for (const auto& it : registry) {
+        keys.push_back(it.first);
+      }
+      return keys;
+    });
   }
 
   const CaffeMap<SrcType, string>& HelpMessage() const {
@@ -104,7 +126,7 @@ class Registry {
   }
 
  private:
-  CaffeMap<SrcType, Creator> registry_;
+  c10::details::LeftRight<CaffeMap<SrcType, Creator>> registry_;
   CaffeMap<SrcType, string> help_message_;
   std::mutex register_mutex_;
 
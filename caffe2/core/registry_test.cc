@@ -1,5 +1,8 @@
+#include <atomic>
 #include <iostream>
 #include <memory>
+#include <thread>
+#include <vector>
 
 #include "caffe2/core/registry.h"
 #include <gtest/gtest.h>
@@ -42,5 +45,43 @@ TEST(RegistryTest, CanRunCreator) {
 TEST(RegistryTest, ReturnNullOnNonExistingCreator) {
   EXPECT_EQ(FooRegistry()->Create("Non-existing bar", 1), nullptr);
 }
+
+// Does not log, unlike Foo, as it is created in a loop
+class Baz {
+ public:
+  explicit Baz(int /* unused */) {}
+};
+
+CAFFE_DECLARE_REGISTRY(BazRegistry, Baz, int);
+CAFFE_DEFINE_REGISTRY(BazRegistry, Baz, int);
+
+TEST(RegistryTest, CreateWhileRegistering) {
+  BazRegistry()->Register(
+      "Baz", RegistererBazRegistry::DefaultCreator<Baz>);
+  std::atomic<bool> done(false);
+  std::atomic<int> failures(0);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&done, &failures]() {
+      while (!done) {
+        if (!BazRegistry()->Create("Baz", 0)) {
+          ++failures;
+        }
+      }
+    });
+  }
+  for (int i = 0; i < 100; ++i) {
+    BazRegistry()->Register(
+        "AnotherBaz" + caffe2::to_string(i),
+        RegistererBazRegistry::DefaultCreator<Baz>);
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(failures, 0);
+  EXPECT_EQ(BazRegistry()->Keys().size(), 101);
+  EXPECT_TRUE(BazRegistry()->Has("AnotherBaz99"));
+}
 }
 }  // namespace caffe2
@@ -5,6 +5,15 @@
 
 namespace caffe2 {
 
+constexpr size_t ShardedStatValue::kNumShards;
+constexpr int HistogramExportedStat::kNumBuckets;
+
+size_t ShardedStatValue::shard() {
+  static std::atomic<size_t> nextShard{0};
+  static thread_local size_t shard = nextShard++ % kNumShards;
+  return shard;
+}
+
 ExportedStatMap toMap(const ExportedStatList& stats) {
   ExportedStatMap statMap;
   for (const auto& stat : stats) {
@@ -26,9 +35,21 @@ StatValue* StatRegistry::add(const std::string& name) {
   return value;
 }
 
+ShardedStatValue* StatRegistry::addSharded(const std::string& name) {
+  std::lock_guard<std::mutex> lg(mutex_);
+  auto it = shardedStats_.find(name);
+  if (it != shardedStats_.end()) {
+    return it->second.get();
+  }
+  auto v = std::unique_ptr<ShardedStatValue>(new ShardedStatValue);
+  auto value = v.get();
+  shardedStats_.insert(std::make_pair(name, std::move(v)));
+  return value;
+}
+
 void StatRegistry::publish(ExportedStatList& exported, bool reset) {
   std::lock_guard<std::mutex> lg(mutex_);
-  exported.resize(stats_.size());
+  exported.resize(stats_.size() + shardedStats_.size());
   int i = 0;
   for (const auto& kv : stats_) {
     auto& out = exported.at(i++);
@@ -36,6 +57,12 @@ void StatRegistry::publish(ExportedStatList& exported, bool reset) {
     out.value = reset ? kv.second->reset() : kv.second->get();
     out.ts = std::chrono::high_resolution_clock::now();
   }
+  for (const auto& kv : shardedStats_) {
+    auto& out = exported.at(i++);
+    out.key = kv.first;
+    out.value = reset ? kv.second->reset() : kv.second->get();
+    out.ts = std::chrono::high_resolution_clock::now();
+  }
 }
 
 void StatRegistry::update(const ExportedStatList& data) {
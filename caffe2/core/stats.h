@@ -28,6 +28,55 @@ class StatValue {
   }
 };
 
+/**
+ * @brief A counter spread over padded cells, for counters that many threads
+ * update at the same time.
+ *
+ * Each thread adds to one of kNumShards cells, which are far enough apart
+ * that updates from different threads don't bounce a cache line between
+ * cores. The value of the counter is the sum of the cells, computed when it
+ * is read or published.
+ */
+class ShardedStatValue {
+ public:
+  static constexpr size_t kNumShards = 16;
+
+  void increment(int64_t inc) {
+    cells_[shard()].v.fetch_add(inc, std::memory_order_relaxed);
+  }
+
+  int64_t reset(int64_t value = 0) {
+    int64_t sum = 0;
+    for (auto& cell : cells_) {
+      sum += cell.v.exchange(0);
+    }
+    cells_[0].v += value;
+    return sum;
+  }
+
+  int64_t get() const {
+    int64_t sum = 0;
+    for (const auto& cell : cells_) {
+      sum += cell.v.load(std::memory_order_relaxed);
+    }
+    return sum;
+  }
+
+ private:
+  // Two cache lines per cell, so that cells never share a line even though
+  // operator new doesn't align the counter to one, and the adjacent line
+  // prefetcher doesn't pull in a neighbour.
+  struct Cell {
+    std::atomic<int64_t> v{0};
+    char padding[128 - sizeof(std::atomic<int64_t>)];
+  };
+
+  // The cell of the calling thread; threads are assigned cells round-robin.
+  static size_t shard();
+
+  Cell cells_[kNumShards];
+};
+
 struct ExportedStatValue {
   std::string key;
   int64_t value;
@@ -108,6 +157,12 @@ ExportedStatMap toMap(const ExportedStatList& stats);
  *   - Args ...: Arguments passed to CAFFE_EVENT, including update value
  *             when provided.
  *
+ * Counters bumped by many threads at once can be declared with
+ * CAFFE_SHARDED_EXPORTED_STAT, which keeps a cell per thread that is summed
+ * when published, and distributions with CAFFE_HISTOGRAM_EXPORTED_STAT.
+ * Their events pass -1 instead of the counter value to the USDT probe, since
+ * the total is only known when they are published.
+ *
  * It is also possible to create additional StatRegistry instances beyond
  * the singleton. These instances are not automatically populated with
  * CAFFE_EVENT. Instead, they can be populated from an ExportedStatList
@@ -117,6 +172,8 @@ ExportedStatMap toMap(const ExportedStatList& stats);
 class StatRegistry {
   std::mutex mutex_;
   std::unordered_map<std::string, std::unique_ptr<StatValue>> stats_;
+  std::unordered_map<std::string, std::unique_ptr<ShardedStatValue>>
+      shardedStats_;
 
  public:
   /**
@@ -131,6 +188,12 @@ class StatRegistry {
    */
   StatValue* add(const std::string& name);
 
+  /**
+   * Add a new sharded counter with given name. If a sharded counter for this
+   * name already exists, returns a pointer to it.
+   */
+  ShardedStatValue* addSharded(const std::string& name);
+
   /**
    * Populate an ExportedStatList with current counter values.
    * If `reset` is true, resets all counters to zero. It is guaranteed that no
@@ -181,6 +244,87 @@ class ExportedStat : public Stat {
   }
 };
 
+class ShardedExportedStat : public Stat {
+  ShardedStatValue* value_;
+
+ public:
+  ShardedExportedStat(const std::string& gn, const std::string& n)
+      : Stat(gn, n), value_(StatRegistry::get().addSharded(gn + "/" + n)) {}
+
+  int64_t increment(int64_t value = 1) {
+    value_->increment(value);
+    return -1;
+  }
+
+  template <typename T, typename Unused1, typename... Unused>
+  int64_t increment(T value, Unused1, Unused...) {
+    return increment(value);
+  }
+};
+
+/**
+ * Counts values into fixed power-of-two buckets, exported as
+ * <name>/bucket_<lower bound> next to <name>/count and <name>/sum. Bucket 0
+ * counts the values below 1, and bucket 2^k those in [2^k, 2^(k+1)). A
+ * bucket is only registered, and thus exported, once a value falls into it.
+ */
+class HistogramExportedStat : public Stat {
+ public:
+  static constexpr int kNumBuckets = 64;
+
+ private:
+  ShardedExportedStat count_;
+  ShardedExportedStat sum_;
+  std::atomic<ShardedStatValue*> buckets_[kNumBuckets];
+
+  ShardedStatValue* bucket(int index) {
+    auto* value = buckets_[index].load(std::memory_order_acquire);
+    if (!value) {
+      // Concurrent first hits register the same counter.
+      const uint64_t lowerBound = index == 0 ? 0 : uint64_t(1) << (index - 1);
+      value = StatRegistry::get().addSharded(
+          groupName + "/" + name + "/bucket_" + std::to_string(lowerBound));
+      buckets_[index].store(value, std::memory_order_release);
+    }
+    return value;
+  }
+
+ public:
+  HistogramExportedStat(const std::string& gn, const std::string& n)
+      : Stat(gn, n), count_(gn, n + "/count"), sum_(gn, n + "/sum") {
+    for (auto& b : buckets_) {
+      b.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  static int bucketIndex(int64_t value) {
+    if (value < 1) {
+      return 0;
+    }
+    uint64_t v = value;
+    int index = 1;
+    for (int shift = 32; shift > 0; shift /= 2) {
+      if (v >> shift) {
+        v >>= shift;
+        index += shift;
+      }
+    }
+    return index;
+  }
+
+  int64_t increment(int64_t value = 1) {
+    count_.increment();
+    sum_.increment(value);
+    bucket(bucketIndex(value))->increment(1);
+    return -1;
+  }
+
+  template <typename T, typename Unused1, typename... Unused>
+  int64_t increment(T value, Unused1, Unused...) {
+    return increment(value);
+  }
+};
+
 class AvgExportedStat : public ExportedStat {
  private:
   ExportedStat count_;
@@ -311,6 +455,16 @@ _ScopeGuard<T> ScopeGuard(T f) {
     groupName, #name                       \
   }
 
+#define CAFFE_SHARDED_EXPORTED_STAT(name) \
+  ShardedExportedStat name {              \
+    groupName, #name                      \
+  }
+
+#define CAFFE_HISTOGRAM_EXPORTED_STAT(name) \
+  HistogramExportedStat name {              \
+    groupName, #name                        \
+  }
+
 #define CAFFE_STAT(name) \
   Stat name {            \
     groupName, #name     \
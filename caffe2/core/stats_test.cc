@@ -117,5 +117,60 @@ TEST(StatsTest, StatsTestSimple) {
       toMap(reg2.publish()), ExportedStatMap({{"i1/s3", 0}, {"i2/s3", 0}}));
 }
 
+TEST(StatsTest, StatsTestSharded) {
+  struct TestStats {
+    CAFFE_STAT_CTOR(TestStats);
+    CAFFE_SHARDED_EXPORTED_STAT(hits);
+  };
+  TestStats stats("sharded");
+  const int numThreads = 8;
+  const int numIterations = 1000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numThreads; ++i) {
+    threads.emplace_back([&stats]() {
+      for (int j = 0; j < numIterations; ++j) {
+        CAFFE_EVENT(stats, hits);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_SUBSET(
+      toMap(StatRegistry::get().publish(true)),
+      ExportedStatMap({{"sharded/hits", numThreads * numIterations}}));
+  EXPECT_SUBSET(
+      toMap(StatRegistry::get().publish()),
+      ExportedStatMap({{"sharded/hits", 0}}));
+}
+
+TEST(StatsTest, StatsTestHistogram) {
+  struct TestStats {
+    CAFFE_STAT_CTOR(TestStats);
+    CAFFE_HISTOGRAM_EXPORTED_STAT(latency_ns);
+  };
+  TestStats stats("histogram");
+  for (int64_t value : {0, 1, 2, 3, 4, 1000}) {
+    CAFFE_EVENT(stats, latency_ns, value);
+  }
+  auto map = toMap(StatRegistry::get().publish());
+  EXPECT_SUBSET(
+      map,
+      ExportedStatMap({
+          {"histogram/latency_ns/count", 6},
+          {"histogram/latency_ns/sum", 1010},
+          {"histogram/latency_ns/bucket_0", 1},
+          {"histogram/latency_ns/bucket_1", 1},
+          {"histogram/latency_ns/bucket_2", 2},
+          {"histogram/latency_ns/bucket_4", 1},
+          {"histogram/latency_ns/bucket_512", 1},
+      }));
+  EXPECT_EQ(map.count("histogram/latency_ns/bucket_8"), 0);
+  EXPECT_EQ(HistogramExportedStat::bucketIndex(-5), 0);
+  EXPECT_EQ(
+      HistogramExportedStat::bucketIndex(std::numeric_limits<int64_t>::max()),
+      HistogramExportedStat::kNumBuckets - 1);
+}
+
 } // namespace
 } // namespace caffe2
@@ -14,6 +14,12 @@ CAFFE2_DEFINE_int64(
     "The maximum memory in bytes to keep on shrink, if the difference between "
     "tensor sizes is bigger than this then tensor will be reset.");
 
+CAFFE2_DEFINE_int(
+    caffe2_tensor_growth_pct,
+    0,
+    "If positive, a tensor growing beyond its capacity allocates this much "
+    "more than its previous capacity, in percent, to grow into later.");
+
 namespace caffe2 {
 // declaring it here instead of context.cc because tensor.h includes context.h
 CAFFE_KNOWN_TYPE(Tensor<CPUContext>);
@@ -90,6 +96,10 @@ struct TensorCPUStatGetter : BlobStatGetter {
     }
     return nbytes;
   }
+
+  size_t numAllocations(const Blob& blob) const override {
+    return blob.Get<TensorCPU>().num_allocations();
+  }
 };
 REGISTER_BLOB_STAT_GETTER(TensorCPU, TensorCPUStatGetter);
 }
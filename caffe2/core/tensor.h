@@ -25,6 +25,13 @@ CAFFE2_DECLARE_bool(caffe2_keep_on_shrink);
 // is larger than this flag in bytes.
 CAFFE2_DECLARE_int64(caffe2_max_keep_on_shrink_memory);
 
+// When a tensor has to reallocate to grow, it allocates this much more memory
+// than its previous capacity, in percent, so that tensors whose size varies
+// from run to run stop reallocating once they have reached their largest
+// size. Together with caffe2_keep_on_shrink, this amortizes the cost of
+// resizing like Extend does.
+CAFFE2_DECLARE_int(caffe2_tensor_growth_pct);
+
 namespace caffe2 {
 
 /**
@@ -311,6 +318,11 @@ class Tensor {
       }
 
       if (reset_tensor) {
+        if (capacity_ > 0 && capacity_ < new_size &&
+            FLAGS_caffe2_tensor_growth_pct > 0) {
+          growth_capacity_ = std::max<size_t>(
+              new_size, capacity_ * (100 + FLAGS_caffe2_tensor_growth_pct) / 100);
+        }
         FreeMemory();
       }
     }
@@ -392,6 +404,8 @@ class Tensor {
     std::swap(shares_data_, other.shares_data_);
     std::swap(capacity_, other.capacity_);
     std::swap(reserved_, other.reserved_);
+    std::swap(growth_capacity_, other.growth_capacity_);
+    std::swap(num_allocations_, other.num_allocations_);
   }
 
   /**
@@ -421,6 +435,7 @@ class Tensor {
     // Finally, do sharing.
     data_ = src.data_;
     capacity_ = src.capacity_;
+    growth_capacity_ = 0;
     shares_data_ = true;
   }
 
@@ -467,6 +482,7 @@ class Tensor {
     } else {
       capacity_ = nbytes();
     }
+    growth_capacity_ = 0;
     shares_data_ = true;
   }
 
@@ -550,12 +566,17 @@ class Tensor {
               deleter(ptr);
             });
         meta_.ctor()(data_.get(), size_);
+        capacity_ = size_ * meta_.itemsize();
       } else {
-        // For fundamental type, new and delete is easier.
-        auto ptr_and_deleter = Context::New(size_ * meta_.itemsize());
+        // For fundamental type, new and delete is easier. Only these get the
+        // extra capacity to grow into, since the items beyond size_ are not
+        // constructed.
+        capacity_ = std::max<size_t>(size_ * meta_.itemsize(), growth_capacity_);
+        auto ptr_and_deleter = Context::New(capacity_);
         data_.reset(ptr_and_deleter.first, ptr_and_deleter.second);
       }
-      capacity_ = size_ * meta_.itemsize();
+      growth_capacity_ = 0;
+      ++num_allocations_;
       return data_.get();
     }
   }
@@ -619,6 +640,15 @@ class Tensor {
   inline size_t capacity_nbytes() const {
     return capacity_;
   }
+
+  /**
+   * Returns the number of times the tensor allocated its storage. A count
+   * that keeps increasing from run to run points at a blob that is
+   * reallocated on every resize.
+   */
+  inline size_t num_allocations() const {
+    return num_allocations_;
+  }
   /**
    * Returns the dimensions of the tensor as a vector.
    */
@@ -713,6 +743,9 @@ class Tensor {
   bool shares_data_ = false;
   size_t capacity_ = 0;
   bool reserved_ = false;
+  // Capacity in bytes of the next allocation, when the tensor grows
+  size_t growth_capacity_ = 0;
+  size_t num_allocations_ = 0;
   // In case of chunk load we store how much data was already loaded
 
  private:
@@ -0,0 +1,329 @@
+#include "caffe2/core/thread_topology.h"
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include "caffe2/core/init.h"
+#include "caffe2/core/logging.h"
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+CAFFE2_DEFINE_bool(
+    caffe2_thread_topology,
+    false,
+    "Lay out inter-op and intra-op threads over the CPU sockets at init, "
+    "as configured by the caffe2_thread_topology_* flags. Overrides "
+    "caffe2_omp_num_threads and caffe2_mkl_num_threads.");
+CAFFE2_DEFINE_int(
+    caffe2_thread_topology_sockets,
+    0,
+    "Number of CPU sockets to use; 0 to use all of them");
+CAFFE2_DEFINE_int(
+    caffe2_thread_topology_inter_op_threads,
+    0,
+    "Number of inter-op threads per socket; 0 to derive it from the cores "
+    "of the socket and the number of intra-op threads");
+CAFFE2_DEFINE_int(
+    caffe2_thread_topology_intra_op_threads,
+    0,
+    "Number of intra-op threads per inter-op thread; 0 to derive it from "
+    "the cores of the socket and the number of inter-op threads");
+CAFFE2_DEFINE_bool(
+    caffe2_thread_topology_pin_threads,
+    true,
+    "Pin the inter-op threads of each socket to its CPUs");
+
+namespace caffe2 {
+
+namespace {
+
+std::vector<std::pair<std::string, IntraOpThreadsSetter>>&
+intraOpThreadsSetters() {
+  static std::vector<std::pair<std::string, IntraOpThreadsSetter>> setters;
+  return setters;
+}
+
+std::unique_ptr<ThreadTopology>& threadTopology() {
+  static std::unique_ptr<ThreadTopology> topology;
+  return topology;
+}
+
+#if defined(__linux__)
+const char* const kSysfsCPUDir = "/sys/devices/system/cpu/";
+
+bool readSysfsInt(const std::string& path, int* value) {
+  std::ifstream file(path);
+  return static_cast<bool>(file >> *value);
+}
+
+// The NUMA node of a CPU is the nodeN entry of its sysfs directory
+int sysfsNUMANodeOfCPU(int cpu) {
+  const std::string path = kSysfsCPUDir + ("cpu" + caffe2::to_string(cpu));
+  DIR* dir = opendir(path.c_str());
+  if (!dir) {
+    return -1;
+  }
+  int node = -1;
+  while (struct dirent* entry = readdir(dir)) {
+    const std::string name = entry->d_name;
+    if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+        name.find_first_not_of("0123456789", 4) == std::string::npos) {
+      node = std::stoi(name.substr(4));
+      break;
+    }
+  }
+  closedir(dir);
+  return node;
+}
+#endif
+
+} // namespace
+
+IntraOpThreadsSetterRegisterer::IntraOpThreadsSetterRegisterer(
+    const char* name,
+    IntraOpThreadsSetter setter) {
+  intraOpThreadsSetters().emplace_back(name, setter);
+}
+
+int ThreadTopology::TotalInterOpThreads() const {
+  int total = 0;
+  for (const auto& socket : sockets) {
+    total += socket.inter_op_threads;
+  }
+  return total;
+}
+
+const ThreadTopology::Socket* ThreadTopology::FindSocket(
+    int numa_node_id) const {
+  if (sockets.empty()) {
+    return nullptr;
+  }
+  if (numa_node_id < 0) {
+    return &sockets[0];
+  }
+  for (const auto& socket : sockets) {
+    if (socket.numa_node_id == numa_node_id) {
+      return &socket;
+    }
+  }
+  return nullptr;
+}
+
+std::vector<int> ThreadTopology::CPUsOf(int numa_node_id) const {
+  if (numa_node_id >= 0) {
+    const auto* socket = FindSocket(numa_node_id);
+    return socket ? socket->cpus : std::vector<int>();
+  }
+  std::vector<int> cpus;
+  for (const auto& socket : sockets) {
+    cpus.insert(cpus.end(), socket.cpus.begin(), socket.cpus.end());
+  }
+  return cpus;
+}
+
+std::string ThreadTopology::ToString() const {
+  std::stringstream ss;
+  ss << "Thread topology: " << sockets.size() << " socket(s), "
+     << TotalInterOpThreads() << " inter-op thread(s)"
+     << (pin_threads ? ", pinned" : "");
+  for (const auto& socket : sockets) {
+    ss << "\n  socket " << socket.id << " (NUMA node " << socket.numa_node_id
+       << "): " << socket.num_cores << " core(s), " << socket.cpus.size()
+       << " CPU(s), " << socket.inter_op_threads << " inter-op x "
+       << socket.intra_op_threads << " intra-op thread(s)";
+    if (socket.inter_op_threads * socket.intra_op_threads > socket.num_cores) {
+      ss << " (oversubscribed)";
+    }
+  }
+  return ss.str();
+}
+
+std::vector<int> ParseCPUList(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    const auto begin = range.find_first_not_of(" \t\n");
+    if (begin == std::string::npos) {
+      continue;
+    }
+    const auto dash = range.find('-', begin);
+    const int first = std::stoi(range.substr(begin, dash));
+    const int last = dash == std::string::npos
+        ? first
+        : std::stoi(range.substr(dash + 1));
+    CAFFE_ENFORCE_LE(first, last, "Invalid CPU list: ", list);
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+std::vector<ThreadTopology::Socket> DetectCPUSockets() {
+  std::vector<ThreadTopology::Socket> sockets;
+#if defined(__linux__)
+  std::ifstream online_file(std::string(kSysfsCPUDir) + "online");
+  std::string online;
+  if (std::getline(online_file, online)) {
+    std::map<int, ThreadTopology::Socket> by_id;
+    std::map<int, std::set<int>> cores_by_id;
+    for (int cpu : ParseCPUList(online)) {
+      const std::string topology_dir =
+          kSysfsCPUDir + ("cpu" + caffe2::to_string(cpu)) + "/topology/";
+      int package_id = 0;
+      int core_id = cpu;
+      readSysfsInt(topology_dir + "physical_package_id", &package_id);
+      readSysfsInt(topology_dir + "core_id", &core_id);
+
+      auto& socket = by_id[package_id];
+      socket.id = package_id;
+      socket.cpus.push_back(cpu);
+      if (socket.numa_node_id < 0) {
+        socket.numa_node_id = sysfsNUMANodeOfCPU(cpu);
+      }
+      cores_by_id[package_id].insert(core_id);
+    }
+    for (auto& entry : by_id) {
+      entry.second.num_cores = cores_by_id[entry.first].size();
+      sockets.push_back(std::move(entry.second));
+    }
+  }
+#endif
+  if (sockets.empty()) {
+    const int num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    ThreadTopology::Socket socket;
+    socket.id = 0;
+    socket.num_cores = num_cpus;
+    for (int cpu = 0; cpu < num_cpus; ++cpu) {
+      socket.cpus.push_back(cpu);
+    }
+    sockets.push_back(std::move(socket));
+  }
+  return sockets;
+}
+
+ThreadTopology MakeThreadTopology(
+    const std::vector<ThreadTopology::Socket>& sockets,
+    int num_sockets,
+    int inter_op_threads,
+    int intra_op_threads,
+    bool pin_threads) {
+  CAFFE_ENFORCE(!sockets.empty(), "No CPU sockets to lay out threads over");
+  if (num_sockets <= 0) {
+    num_sockets = sockets.size();
+  }
+  CAFFE_ENFORCE_LE(
+      num_sockets,
+      static_cast<int>(sockets.size()),
+      "Requested more CPU sockets than the host has");
+
+  ThreadTopology topology;
+  topology.pin_threads = pin_threads;
+  for (int i = 0; i < num_sockets; ++i) {
+    ThreadTopology::Socket socket = sockets[i];
+    const int cores = std::max(socket.num_cores, 1);
+    socket.intra_op_threads = intra_op_threads > 0
+        ? intra_op_threads
+        : (inter_op_threads > 0 ? std::max(cores / inter_op_threads, 1) : 1);
+    socket.inter_op_threads = inter_op_threads > 0
+        ? inter_op_threads
+        : std::max(cores / socket.intra_op_threads, 1);
+    if (socket.inter_op_threads * socket.intra_op_threads > cores) {
+      LOG(WARNING) << socket.inter_op_threads << " inter-op x "
+                   << socket.intra_op_threads
+                   << " intra-op threads oversubscribe the " << cores
+                   << " core(s) of socket " << socket.id;
+    }
+    topology.sockets.push_back(std::move(socket));
+  }
+  return topology;
+}
+
+void SetThreadTopology(const ThreadTopology& topology) {
+  CAFFE_ENFORCE(!topology.sockets.empty(), "Thread topology has no sockets");
+  threadTopology().reset(new ThreadTopology(topology));
+
+  const int intra_op_threads = topology.sockets[0].intra_op_threads;
+  for (const auto& setter : intraOpThreadsSetters()) {
+    VLOG(1) << "Setting " << setter.first << " intra-op threads to "
+            << intra_op_threads;
+    setter.second(intra_op_threads, true);
+  }
+  LOG(INFO) << topology.ToString();
+}
+
+const ThreadTopology* GetThreadTopology() {
+  return threadTopology().get();
+}
+
+void ApplyThreadTopologyToCurrentThread(int numa_node_id) {
+  const auto* topology = GetThreadTopology();
+  if (!topology) {
+    return;
+  }
+  const auto* socket = topology->FindSocket(numa_node_id);
+  if (!socket) {
+    VLOG(1) << "NUMA node " << numa_node_id << " is not in thread topology";
+    return;
+  }
+  if (topology->pin_threads &&
+      !SetCurrentThreadAffinity(topology->CPUsOf(numa_node_id))) {
+    VLOG(1) << "Failed to pin thread to the CPUs of NUMA node "
+            << numa_node_id;
+  }
+  for (const auto& setter : intraOpThreadsSetters()) {
+    setter.second(socket->intra_op_threads, false);
+  }
+}
+
+bool SetCurrentThreadAffinity(const std::vector<int>& cpus) {
+#if defined(__linux__)
+  if (cpus.empty()) {
+    return false;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      return false;
+    }
+    CPU_SET(cpu, &set);
+  }
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+namespace {
+
+bool Caffe2InitThreadTopology(int*, char***) {
+  if (!FLAGS_caffe2_thread_topology) {
+    return true;
+  }
+  SetThreadTopology(MakeThreadTopology(
+      DetectCPUSockets(),
+      FLAGS_caffe2_thread_topology_sockets,
+      FLAGS_caffe2_thread_topology_inter_op_threads,
+      FLAGS_caffe2_thread_topology_intra_op_threads,
+      FLAGS_caffe2_thread_topology_pin_threads));
+  return true;
+}
+
+} // namespace
+
+REGISTER_CAFFE2_INIT_FUNCTION(
+    Caffe2InitThreadTopology,
+    &Caffe2InitThreadTopology,
+    "Lay out threads over the CPU sockets.");
+
+} // namespace caffe2
@@ -0,0 +1,107 @@
+#ifndef CAFFE2_CORE_THREAD_TOPOLOGY_H_
+#define CAFFE2_CORE_THREAD_TOPOLOGY_H_
+
+#include <string>
+#include <vector>
+
+#include "caffe2/core/flags.h"
+
+CAFFE2_DECLARE_bool(caffe2_thread_topology);
+CAFFE2_DECLARE_int(caffe2_thread_topology_sockets);
+CAFFE2_DECLARE_int(caffe2_thread_topology_inter_op_threads);
+CAFFE2_DECLARE_int(caffe2_thread_topology_intra_op_threads);
+CAFFE2_DECLARE_bool(caffe2_thread_topology_pin_threads);
+
+namespace caffe2 {
+
+// How the CPU threads of the process are laid out over the sockets of the
+// host. Each socket in use runs inter_op_threads inter-op threads (the async
+// net pool of its NUMA node), and every inter-op thread runs intra-op work
+// (OpenMP, MKL, ATen, caffe2::ThreadPool) on a team of intra_op_threads
+// threads, itself included. With inter_op_threads * intra_op_threads no
+// larger than the cores of the socket, the libraries don't oversubscribe it.
+struct ThreadTopology {
+  struct Socket {
+    int id = -1;
+    // -1 if unknown
+    int numa_node_id = -1;
+    // Logical CPUs of the socket, hyperthreads included
+    std::vector<int> cpus;
+    int num_cores = 0;
+    int inter_op_threads = 1;
+    int intra_op_threads = 1;
+  };
+
+  std::vector<Socket> sockets;
+  // Whether the inter-op threads of each socket are pinned to its CPUs
+  bool pin_threads = false;
+
+  int TotalInterOpThreads() const;
+  // The socket of the given NUMA node, or nullptr if none is in use. With -1
+  // (no NUMA node), the first socket.
+  const Socket* FindSocket(int numa_node_id) const;
+  // The CPUs the inter-op threads of the given NUMA node may run on: those
+  // of its socket, or of all the sockets in use for -1.
+  std::vector<int> CPUsOf(int numa_node_id) const;
+  // A human readable report of the layout
+  std::string ToString() const;
+};
+
+// The sockets of the host, with their CPUs, cores and NUMA nodes, as listed
+// by sysfs. Where that isn't available, a single socket with all the CPUs.
+std::vector<ThreadTopology::Socket> DetectCPUSockets();
+
+// Lays out threads over the first num_sockets of the given sockets (all of
+// them if num_sockets <= 0). Non-positive thread counts are derived from the
+// cores of each socket: inter-op threads default to one per core divided by
+// the intra-op threads, which default to one.
+ThreadTopology MakeThreadTopology(
+    const std::vector<ThreadTopology::Socket>& sockets,
+    int num_sockets,
+    int inter_op_threads,
+    int intra_op_threads,
+    bool pin_threads);
+
+// Makes `topology` the layout of the process: sizes the intra-op thread
+// pools of all the libraries that registered a setter (see
+// REGISTER_INTRA_OP_THREADS_SETTER) and logs the effective layout. Async
+// net CPU pools created afterwards take their size, pinning and intra-op
+// team size from it. Called at init with the caffe2_thread_topology_* flags
+// if caffe2_thread_topology is set. Not thread safe: the topology is meant
+// to be set once, before any net runs.
+void SetThreadTopology(const ThreadTopology& topology);
+
+// The layout set by SetThreadTopology, or nullptr if none was.
+const ThreadTopology* GetThreadTopology();
+
+// Called by an inter-op thread of the given NUMA node (-1 if none) when it
+// starts: pins it to the CPUs of its socket if the topology says so, and
+// sets its intra-op team size. Does nothing without a topology.
+void ApplyThreadTopologyToCurrentThread(int numa_node_id);
+
+// Restricts the calling thread to the given CPUs; returns false if that's
+// not supported or failed.
+bool SetCurrentThreadAffinity(const std::vector<int>& cpus);
+
+// Parses a sysfs CPU list such as "0-3,8,10-11".
+std::vector<int> ParseCPUList(const std::string& list);
+
+// Sets the number of intra-op threads of a library. With global, the
+// default of all threads; otherwise that of the calling thread only, for
+// libraries that support it.
+typedef void (*IntraOpThreadsSetter)(int num_threads, bool global);
+
+class IntraOpThreadsSetterRegisterer {
+ public:
+  IntraOpThreadsSetterRegisterer(const char* name, IntraOpThreadsSetter setter);
+};
+
+#define REGISTER_INTRA_OP_THREADS_SETTER(name, setter)        \
+  namespace {                                                 \
+  ::caffe2::IntraOpThreadsSetterRegisterer                    \
+      g_caffe2_intra_op_threads_setter_##name(#name, setter); \
+  }
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_THREAD_TOPOLOGY_H_
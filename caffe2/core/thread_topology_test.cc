@@ -0,0 +1,77 @@
+#include "caffe2/core/thread_topology.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+namespace {
+
+std::vector<ThreadTopology::Socket> TwoSockets() {
+  std::vector<ThreadTopology::Socket> sockets(2);
+  for (int i = 0; i < 2; ++i) {
+    sockets[i].id = i;
+    sockets[i].numa_node_id = i;
+    sockets[i].num_cores = 8;
+    for (int cpu = 0; cpu < 16; ++cpu) {
+      sockets[i].cpus.push_back(i * 16 + cpu);
+    }
+  }
+  return sockets;
+}
+
+TEST(ThreadTopologyTest, ParseCPUList) {
+  EXPECT_EQ(std::vector<int>({0, 1, 2, 3, 8, 10, 11}),
+            ParseCPUList("0-3,8,10-11\n"));
+  EXPECT_EQ(std::vector<int>({5}), ParseCPUList("5"));
+  EXPECT_TRUE(ParseCPUList("").empty());
+}
+
+TEST(ThreadTopologyTest, DetectCPUSockets) {
+  auto sockets = DetectCPUSockets();
+  ASSERT_FALSE(sockets.empty());
+  for (const auto& socket : sockets) {
+    EXPECT_GT(socket.num_cores, 0);
+    EXPECT_GE(socket.cpus.size(), socket.num_cores);
+  }
+}
+
+TEST(ThreadTopologyTest, DefaultsToOneInterOpThreadPerCore) {
+  auto topology = MakeThreadTopology(TwoSockets(), 0, 0, 0, true);
+  ASSERT_EQ(2, topology.sockets.size());
+  EXPECT_EQ(8, topology.sockets[0].inter_op_threads);
+  EXPECT_EQ(1, topology.sockets[0].intra_op_threads);
+  EXPECT_EQ(16, topology.TotalInterOpThreads());
+  EXPECT_TRUE(topology.pin_threads);
+}
+
+TEST(ThreadTopologyTest, DerivesMissingThreadCounts) {
+  auto topology = MakeThreadTopology(TwoSockets(), 1, 0, 4, false);
+  ASSERT_EQ(1, topology.sockets.size());
+  EXPECT_EQ(2, topology.sockets[0].inter_op_threads);
+  EXPECT_EQ(4, topology.sockets[0].intra_op_threads);
+
+  topology = MakeThreadTopology(TwoSockets(), 0, 2, 0, false);
+  EXPECT_EQ(2, topology.sockets[1].inter_op_threads);
+  EXPECT_EQ(4, topology.sockets[1].intra_op_threads);
+
+  // Explicit counts are kept even if they oversubscribe the socket
+  topology = MakeThreadTopology(TwoSockets(), 0, 4, 4, false);
+  EXPECT_EQ(4, topology.sockets[1].inter_op_threads);
+  EXPECT_EQ(4, topology.sockets[1].intra_op_threads);
+
+  EXPECT_ANY_THROW(MakeThreadTopology(TwoSockets(), 3, 0, 0, false));
+}
+
+TEST(ThreadTopologyTest, FindsSocketsByNUMANode) {
+  auto topology = MakeThreadTopology(TwoSockets(), 0, 0, 0, true);
+  ASSERT_NE(nullptr, topology.FindSocket(1));
+  EXPECT_EQ(1, topology.FindSocket(1)->id);
+  EXPECT_EQ(0, topology.FindSocket(-1)->id);
+  EXPECT_EQ(nullptr, topology.FindSocket(2));
+
+  EXPECT_EQ(16, topology.CPUsOf(1).size());
+  EXPECT_EQ(16, topology.CPUsOf(1)[0]);
+  EXPECT_EQ(32, topology.CPUsOf(-1).size());
+  EXPECT_TRUE(topology.CPUsOf(2).empty());
+}
+
+} // namespace
+} // namespace caffe2
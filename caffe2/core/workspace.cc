@@ -78,15 +78,13 @@ vector<string> Workspace::LocalBlobs() const {
   for (auto& entry : blob_map_) {
     names.push_back(entry.first);
   }
+  // blob_map_ is hashed, keep listing the blobs in name order
+  std::sort(names.begin(), names.end());
   return names;
 }
 
 vector<string> Workspace::Blobs() const {
-  vector<string> names;
-  names.reserve(blob_map_.size());
-  for (auto& entry : blob_map_) {
-    names.push_back(entry.first);
-  }
+  vector<string> names = LocalBlobs();
   for (const auto& forwarded : forwarded_blobs_) {
     const auto parent_ws = forwarded.second.first;
     const auto& parent_name = forwarded.second.second;
@@ -111,6 +109,7 @@ Blob* Workspace::CreateBlob(const string& name) {
   } else {
     VLOG(1) << "Creating blob " << name;
     blob_map_[name] = unique_ptr<Blob>(new Blob());
+    ++blobs_version_;
   }
   return GetBlob(name);
 }
@@ -121,6 +120,7 @@ Blob* Workspace::CreateLocalBlob(const string& name) {
   } else {
     VLOG(1) << "Creating blob " << name;
     blob_map_[name] = unique_ptr<Blob>(new Blob());
+    ++blobs_version_;
   }
   return GetBlob(name);
 }
@@ -145,6 +145,7 @@ Blob* Workspace::RenameBlob(const string& old_name, const string& new_name) {
 
   auto* raw_ptr = value.get();
   blob_map_[new_name] = std::move(value);
+  ++blobs_version_;
   return raw_ptr;
 }
 
@@ -153,6 +154,7 @@ bool Workspace::RemoveBlob(const string& name) {
   if (it != blob_map_.end()) {
     VLOG(1) << "Removing blob " << name << " from this workspace.";
     blob_map_.erase(it);
+    ++blobs_version_;
     return true;
   }
 
@@ -162,12 +164,13 @@ bool Workspace::RemoveBlob(const string& name) {
 }
 
 const Blob* Workspace::GetBlob(const string& name) const {
-  if (blob_map_.count(name)) {
-    return blob_map_.at(name).get();
-  } else if (forwarded_blobs_.count(name)) {
-    const auto parent_ws = forwarded_blobs_.at(name).first;
-    const auto& parent_name = forwarded_blobs_.at(name).second;
-    return parent_ws->GetBlob(parent_name);
+  auto it = blob_map_.find(name);
+  if (it != blob_map_.end()) {
+    return it->second.get();
+  }
+  auto forwarded = forwarded_blobs_.find(name);
+  if (forwarded != forwarded_blobs_.end()) {
+    return forwarded->second.first->GetBlob(forwarded->second.second);
   } else if (shared_ && shared_->HasBlob(name)) {
     return shared_->GetBlob(name);
   }
@@ -207,14 +210,34 @@ void Workspace::AddBlobMapping(
       // blob name, blob value might change in the parent workspace
       forwarded_blobs_[forwarded.first] =
           std::make_pair(parent, forwarded.second);
+      ++blobs_version_;
     }
   }
+  if (std::find(forwarded_parents_.begin(), forwarded_parents_.end(), parent) ==
+      forwarded_parents_.end()) {
+    forwarded_parents_.push_back(parent);
+  }
 }
 
 Blob* Workspace::GetBlob(const string& name) {
   return const_cast<Blob*>(static_cast<const Workspace*>(this)->GetBlob(name));
 }
 
+const Blob* Workspace::GetBlob(const BlobHandle& handle) const {
+  const uint64_t version = BlobsVersion();
+  if (handle.ws_ != this || handle.version_ != version) {
+    handle.blob_ = const_cast<Blob*>(GetBlob(handle.name_));
+    handle.ws_ = this;
+    handle.version_ = version;
+  }
+  return handle.blob_;
+}
+
+Blob* Workspace::GetBlob(const BlobHandle& handle) {
+  return const_cast<Blob*>(
+      static_cast<const Workspace*>(this)->GetBlob(handle));
+}
+
 NetBase* Workspace::CreateNet(const NetDef& net_def, bool overwrite) {
   std::shared_ptr<NetDef> tmp_net_def(new NetDef(net_def));
   return CreateNet(tmp_net_def, overwrite);
@@ -223,6 +246,21 @@ NetBase* Workspace::CreateNet(const NetDef& net_def, bool overwrite) {
 NetBase* Workspace::CreateNet(
     const std::shared_ptr<const NetDef>& net_def,
     bool overwrite) {
+  return AddNet(net_def, overwrite, [this, &net_def]() {
+    return caffe2::CreateNet(net_def, this);
+  });
+}
+
+NetBase* Workspace::CreateNet(const NetTemplate& net_template, bool overwrite) {
+  return AddNet(net_template.net_def(), overwrite, [this, &net_template]() {
+    return net_template.CreateNet(this);
+  });
+}
+
+NetBase* Workspace::AddNet(
+    const std::shared_ptr<const NetDef>& net_def,
+    bool overwrite,
+    const std::function<unique_ptr<NetBase>()>& create_net) {
   CAFFE_ENFORCE(net_def->has_name(), "Net definition should have a name.");
   if (net_map_.count(net_def->name()) > 0) {
     if (!overwrite) {
@@ -241,8 +279,7 @@ NetBase* Workspace::CreateNet(
   }
   // Create a new net with its name.
   VLOG(1) << "Initializing network " << net_def->name();
-  net_map_[net_def->name()] =
-      unique_ptr<NetBase>(caffe2::CreateNet(net_def, this));
+  net_map_[net_def->name()] = create_net();
   if (net_map_[net_def->name()].get() == nullptr) {
     LOG(ERROR) << "Error when creating the network."
                << "Maybe net type: [" << net_def->type() << "] does not exist";
@@ -267,11 +304,12 @@ void Workspace::DeleteNet(const string& name) {
 }
 
 bool Workspace::RunNet(const string& name) {
-  if (!net_map_.count(name)) {
+  auto it = net_map_.find(name);
+  if (it == net_map_.end()) {
     LOG(ERROR) << "Network " << name << " does not exist yet.";
     return false;
   }
-  return net_map_[name]->Run();
+  return it->second->Run();
 }
 
 bool Workspace::RunOperatorOnce(const OperatorDef& op_def) {
@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <mutex>
 #include <typeinfo>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -23,6 +24,7 @@ CAFFE2_DECLARE_bool(caffe2_print_blob_sizes_at_exit);
 namespace caffe2 {
 
 class NetBase;
+class NetTemplate;
 
 struct StopOnSignal {
   StopOnSignal()
@@ -39,6 +41,32 @@ struct StopOnSignal {
   std::shared_ptr<SignalHandler> handler_;
 };
 
+class Workspace;
+
+/**
+ * A blob name resolved by a workspace, that callers can keep to look the blob
+ * up again without hashing the name or walking the parent workspaces. The
+ * workspace resolves the name again if blobs were created, removed, renamed
+ * or forwarded in it or in its parents since the last lookup.
+ */
+class BlobHandle {
+ public:
+  BlobHandle() {}
+  explicit BlobHandle(const string& name) : name_(name) {}
+
+  const string& name() const {
+    return name_;
+  }
+
+ private:
+  friend class Workspace;
+
+  string name_;
+  mutable const Workspace* ws_{nullptr};
+  mutable Blob* blob_{nullptr};
+  mutable uint64_t version_{0};
+};
+
 /**
  * Workspace is a class that holds all the related objects created during
  * runtime: (1) all blobs, and (2) all instantiated networks. It is the owner of
@@ -47,7 +75,7 @@ struct StopOnSignal {
 class Workspace {
  public:
   typedef std::function<bool(int)> ShouldContinue;
-  typedef CaffeMap<string, unique_ptr<Blob> > BlobMap;
+  typedef std::unordered_map<string, unique_ptr<Blob> > BlobMap;
   typedef CaffeMap<string, unique_ptr<NetBase> > NetMap;
   /**
    * Initializes an empty workspace.
@@ -92,6 +120,7 @@ class Workspace {
       forwarded_blobs_[forwarded.first] =
           std::make_pair(shared, forwarded.second);
     }
+    forwarded_parents_.push_back(shared);
   }
 
   /**
@@ -140,6 +169,7 @@ class Workspace {
           "Expected blob with tensor value",
           ws_blob.second);
       forwarded_blobs_.erase(blob);
+      ++blobs_version_;
       auto* to_blob = CreateBlob(blob);
       CAFFE_ENFORCE(to_blob);
       const auto& from_tensor = from_blob->template Get<Tensor<Context>>();
@@ -173,10 +203,10 @@ class Workspace {
     // Then, check the forwarding map, then the parent workspace
     if (blob_map_.count(name)) {
       return true;
-    } else if (forwarded_blobs_.count(name)) {
-      const auto parent_ws = forwarded_blobs_.at(name).first;
-      const auto& parent_name = forwarded_blobs_.at(name).second;
-      return parent_ws->HasBlob(parent_name);
+    }
+    auto forwarded = forwarded_blobs_.find(name);
+    if (forwarded != forwarded_blobs_.end()) {
+      return forwarded->second.first->HasBlob(forwarded->second.second);
     } else if (shared_) {
       return shared_->HasBlob(name);
     }
@@ -215,6 +245,28 @@ class Workspace {
    * not exist, a nullptr is returned.
    */
   Blob* GetBlob(const string& name);
+  /**
+   * Gets the blob of a handle, resolving its name only if the blobs of this
+   * workspace or of its parents changed since the handle was last used with
+   * this workspace. If the blob does not exist, a nullptr is returned.
+   */
+  const Blob* GetBlob(const BlobHandle& handle) const;
+  Blob* GetBlob(const BlobHandle& handle);
+
+  /**
+   * A counter that changes whenever a blob is created, removed, renamed or
+   * forwarded in this workspace or in one of its parents.
+   */
+  uint64_t BlobsVersion() const {
+    uint64_t version = blobs_version_;
+    if (shared_) {
+      version += shared_->BlobsVersion();
+    }
+    for (const auto* parent : forwarded_parents_) {
+      version += parent->BlobsVersion();
+    }
+    return version;
+  }
 
   /**
    * Renames a local workspace blob. If blob is not found in the local blob list
@@ -236,6 +288,11 @@ class Workspace {
   NetBase* CreateNet(
       const std::shared_ptr<const NetDef>& net_def,
       bool overwrite = false);
+  /**
+   * Creates a network from a net template, which is cheaper than creating it
+   * from its NetDef when many workspaces create the same network.
+   */
+  NetBase* CreateNet(const NetTemplate& net_template, bool overwrite = false);
   /**
    * Gets the pointer to a created net. The workspace keeps ownership of the
    * network.
@@ -288,12 +345,20 @@ class Workspace {
   std::atomic<int> last_failed_op_net_position;
 
  private:
+  NetBase* AddNet(
+      const std::shared_ptr<const NetDef>& net_def,
+      bool overwrite,
+      const std::function<unique_ptr<NetBase>()>& create_net);
+
   BlobMap blob_map_;
   NetMap net_map_;
   const string root_folder_;
   const Workspace* shared_;
   std::unordered_map<string, std::pair<const Workspace*, string>>
       forwarded_blobs_;
+  // The workspaces that forwarded_blobs_ refer to, once each.
+  std::vector<const Workspace*> forwarded_parents_;
+  uint64_t blobs_version_{1};
   std::unique_ptr<ThreadPool> thread_pool_;
   std::mutex thread_pool_creation_mutex_;
 
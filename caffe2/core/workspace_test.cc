@@ -115,4 +115,33 @@ TEST(WorkspaceTest, BlobMapping) {
   }
 }
 
+TEST(WorkspaceTest, BlobHandle) {
+  Workspace parent;
+  Blob* a = parent.CreateBlob("a");
+  std::unordered_map<string, string> forwarded_blobs;
+  forwarded_blobs["inner_a"] = "a";
+  Workspace child(&parent, forwarded_blobs);
+
+  BlobHandle inner_a("inner_a");
+  BlobHandle b("b");
+  EXPECT_EQ(a, child.GetBlob(inner_a));
+  EXPECT_EQ(nullptr, child.GetBlob(b));
+
+  // Changes of the parent are seen through the handle.
+  EXPECT_TRUE(parent.RemoveBlob("a"));
+  EXPECT_EQ(nullptr, child.GetBlob(inner_a));
+  a = parent.CreateBlob("a");
+  EXPECT_EQ(a, child.GetBlob(inner_a));
+
+  // So are changes of the workspace itself.
+  Blob* child_b = child.CreateBlob("b");
+  EXPECT_EQ(child_b, child.GetBlob(b));
+  EXPECT_EQ(child_b, child.RenameBlob("b", "c"));
+  EXPECT_EQ(nullptr, child.GetBlob(b));
+
+  // A handle can be used with other workspaces.
+  Blob* parent_b = parent.CreateBlob("b");
+  EXPECT_EQ(parent_b, parent.GetBlob(b));
+}
+
 }  // namespace caffe2
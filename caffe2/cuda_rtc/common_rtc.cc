@@ -0,0 +1,144 @@
+#include "caffe2/cuda_rtc/common_rtc.h"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <vector>
+
+CAFFE2_DEFINE_string(
+    caffe2_cuda_rtc_arch,
+    "compute_35",
+    "The virtual architecture NVRTC compiles kernels for. The driver "
+    "compiles the PTX further for the actual device when loading it.");
+CAFFE2_DEFINE_string(
+    caffe2_cuda_rtc_cache_dir,
+    "",
+    "If set, a directory in which the PTX of the kernels compiled with NVRTC "
+    "is kept, so that later processes do not compile them again.");
+
+namespace caffe2 {
+
+CudaRTCModuleCache& CudaRTCModuleCache::Instance() {
+  static CudaRTCModuleCache cache;
+  return cache;
+}
+
+CUmodule CudaRTCModuleCache::Get(const string& src) {
+  const string& arch = FLAGS_caffe2_cuda_rtc_arch;
+  const string module_key = caffe2::to_string(CaffeCudaGetDevice()) + '\0' +
+      arch + '\0' + src;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto module_it = modules_.find(module_key);
+  if (module_it != modules_.end()) {
+    return module_it->second;
+  }
+
+  const string ptx_key = arch + '\0' + src;
+  auto ptx_it = ptx_.find(ptx_key);
+  if (ptx_it == ptx_.end()) {
+    string ptx;
+    const string path = CachePath(src, arch);
+    if (path.empty() || !ReadCache(path, src, &ptx)) {
+      ptx = Compile(src, arch);
+      if (!path.empty()) {
+        WriteCache(path, src, ptx);
+      }
+    }
+    ptx_it = ptx_.emplace(ptx_key, std::move(ptx)).first;
+  }
+
+  CUmodule module;
+  CUDA_DRIVERAPI_ENFORCE(
+      cuModuleLoadDataEx(&module, ptx_it->second.c_str(), 0, 0, 0));
+  modules_.emplace(module_key, module);
+  return module;
+}
+
+string CudaRTCModuleCache::Compile(const string& src, const string& arch) {
+  nvrtcProgram prog;
+  NVRTC_CHECK(nvrtcCreateProgram(
+      &prog, src.c_str(), nullptr, 0, nullptr, nullptr));
+  const string arch_opt = "--gpu-architecture=" + arch;
+  const char* nvrtc_opts[] = {arch_opt.c_str(), "--use_fast_math"};
+  nvrtcResult compile_result = nvrtcCompileProgram(prog, 2, nvrtc_opts);
+  if (compile_result != NVRTC_SUCCESS) {
+    size_t log_size;
+    NVRTC_CHECK(nvrtcGetProgramLogSize(prog, &log_size));
+    vector<char> nvrtc_log(log_size);
+    NVRTC_CHECK(nvrtcGetProgramLog(prog, nvrtc_log.data()));
+    LOG(FATAL) << "Compilation failure for nvrtc("
+               << nvrtcGetErrorString(compile_result) << "): \n"
+               << nvrtc_log.data();
+  }
+  size_t ptx_size;
+  NVRTC_CHECK(nvrtcGetPTXSize(prog, &ptx_size));
+  vector<char> nvrtc_ptx(ptx_size);
+  NVRTC_CHECK(nvrtcGetPTX(prog, nvrtc_ptx.data()));
+  NVRTC_CHECK(nvrtcDestroyProgram(&prog));
+  num_compiled_++;
+  // The PTX is null terminated.
+  return string(nvrtc_ptx.data());
+}
+
+string CudaRTCModuleCache::CachePath(const string& src, const string& arch)
+    const {
+  if (FLAGS_caffe2_cuda_rtc_cache_dir.empty()) {
+    return "";
+  }
+  int nvrtc_major = 0;
+  int nvrtc_minor = 0;
+  NVRTC_CHECK(nvrtcVersion(&nvrtc_major, &nvrtc_minor));
+  std::stringstream ss;
+  ss << FLAGS_caffe2_cuda_rtc_cache_dir << "/nvrtc" << nvrtc_major << "."
+     << nvrtc_minor << "_" << arch << "_" << std::hex
+     << std::hash<string>()(src) << ".ptx";
+  return ss.str();
+}
+
+// A cache file holds the size of the source on its first line, then the
+// source, so that hash collisions are detected, then the PTX.
+bool CudaRTCModuleCache::ReadCache(
+    const string& path,
+    const string& src,
+    string* ptx) const {
+  std::ifstream file(path, std::ios::binary);
+  size_t src_size;
+  if (!(file >> src_size) || file.get() != '\n' || src_size != src.size()) {
+    return false;
+  }
+  string cached_src(src_size, '\0');
+  if (!file.read(&cached_src[0], src_size) || cached_src != src) {
+    return false;
+  }
+  ptx->assign(
+      std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  VLOG(1) << "Loaded NVRTC kernel from " << path;
+  return !ptx->empty();
+}
+
+void CudaRTCModuleCache::WriteCache(
+    const string& path,
+    const string& src,
+    const string& ptx) const {
+  // Processes sharing the directory may write the same entry: write to a
+  // file of our own and move it in place.
+  const string tmp_path =
+      path + ".tmp" + caffe2::to_string(std::random_device()());
+  {
+    std::ofstream file(tmp_path, std::ios::binary);
+    file << src.size() << '\n' << src << ptx;
+    if (!file) {
+      LOG(WARNING) << "Could not write the NVRTC cache file " << tmp_path;
+      std::remove(tmp_path.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Could not write the NVRTC cache file " << path;
+    std::remove(tmp_path.c_str());
+  }
+}
+
+} // namespace caffe2
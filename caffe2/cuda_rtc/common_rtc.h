@@ -1,12 +1,18 @@
 #ifndef CAFFE2_CUDA_RTC_COMMON_RTC_H_
 #define CAFFE2_CUDA_RTC_COMMON_RTC_H_
 
+#include <atomic>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 
 #include <cuda.h>
 #include <nvrtc.h>
 
+#include "caffe2/core/common_gpu.h"
+#include "caffe2/core/flags.h"
+
 #define NVRTC_CHECK(condition)                                                 \
   do {                                                                         \
     nvrtcResult result = condition;                                            \
@@ -16,58 +22,60 @@
     }                                                                          \
   } while(0)
 
+CAFFE2_DECLARE_string(caffe2_cuda_rtc_arch);
+CAFFE2_DECLARE_string(caffe2_cuda_rtc_cache_dir);
+
 namespace caffe2 {
 
+// Compiles kernels with NVRTC once per process. The PTX of a source is kept
+// by source and target architecture, in memory and, with
+// --caffe2_cuda_rtc_cache_dir, on disk across processes; the modules loaded
+// from it are kept for each device. Modules stay loaded until the process
+// exits, so that every function compiled from the same source shares one.
+class CudaRTCModuleCache {
+ public:
+  static CudaRTCModuleCache& Instance();
+
+  // The module of src loaded on the current device.
+  CUmodule Get(const string& src);
+
+  // Number of sources actually compiled by NVRTC so far.
+  size_t num_compiled() const {
+    return num_compiled_;
+  }
+
+ private:
+  CudaRTCModuleCache() {}
+
+  string Compile(const string& src, const string& arch);
+  string CachePath(const string& src, const string& arch) const;
+  bool ReadCache(const string& path, const string& src, string* ptx) const;
+  void WriteCache(const string& path, const string& src, const string& ptx)
+      const;
+
+  std::mutex mutex_;
+  // PTX by architecture and source
+  std::unordered_map<string, string> ptx_;
+  // Modules by device and source
+  std::unordered_map<string, CUmodule> modules_;
+  std::atomic<size_t> num_compiled_{0};
+};
+
 template <typename Derived>
 class CudaRTCFunction {
  public:
   CudaRTCFunction() : module_loaded_(false) {}
-  ~CudaRTCFunction() {
-    if (module_loaded_) {
-      CUDA_DRIVERAPI_ENFORCE(cuModuleUnload(module_));
-    }
-  }
 
-  // TODO: this function is nontrivial and since CudaRTCFunction uses CRTP, it
-  // may potentially increase the binary size. In that case, move common parts
-  // into a separate function.
+  // The kernels of different sources live in different modules, so a
+  // deterministic kernel name is enough: functions compiled from the same
+  // arguments get the same source and share the cached module.
   template <typename... Args>
   void Compile(Args... args) {
     string src = static_cast<Derived*>(this)->GetSource(args...);
     string name = static_cast<Derived*>(this)->KernelName(args...);
     VLOG(1) << "function name: " << name;
     VLOG(1) << "function src:\n" << src;
-    // Actually do the compiling.
-    nvrtcProgram prog;
-    NVRTC_CHECK(nvrtcCreateProgram(
-        &prog, src.c_str(), nullptr, 0, nullptr, nullptr));
-    // Compile the program.
-    // TODO(Yangqing): how to find the current gpu architecture instead of hard
-    // coding it?
-    const char *nvrtc_opts[] = {"--gpu-architecture=compute_35",
-                                "--use_fast_math"};
-    nvrtcResult compile_result = nvrtcCompileProgram(
-        prog, 2, nvrtc_opts);
-    if (compile_result != NVRTC_SUCCESS) {
-      size_t log_size;
-      NVRTC_CHECK(nvrtcGetProgramLogSize(prog, &log_size));
-      vector<char> nvrtc_log(log_size);
-      NVRTC_CHECK(nvrtcGetProgramLog(prog, nvrtc_log.data()));
-      LOG(FATAL) << "Compilation failure for nvrtc("
-                 << nvrtcGetErrorString(compile_result) << "): \n"
-                 << nvrtc_log.data();
-    }
-    size_t ptx_size;
-    NVRTC_CHECK(nvrtcGetPTXSize(prog, &ptx_size));
-    vector<char> nvrtc_ptx(ptx_size);
-    NVRTC_CHECK(nvrtcGetPTX(prog, nvrtc_ptx.data()));
-    NVRTC_CHECK(nvrtcDestroyProgram(&prog));
-    // After compilation, load the module.
-    if (module_loaded_) {
-      CUDA_DRIVERAPI_ENFORCE(cuModuleUnload(module_));
-    }
-    CUDA_DRIVERAPI_ENFORCE(
-        cuModuleLoadDataEx(&module_, nvrtc_ptx.data(), 0, 0, 0));
+    module_ = CudaRTCModuleCache::Instance().Get(src);
     module_loaded_ = true;
     CUDA_DRIVERAPI_ENFORCE(
         cuModuleGetFunction(&kernel_, module_, name.c_str()));
@@ -101,20 +109,6 @@ class CudaRTCFunction {
   CUfunction kernel_;
 };
 
-// TODO: this is in no way unique and is just a hack right now.
-inline std::string GetUniqueName() {
-  static constexpr int len = 20;
-  static const char alpha[] =
-      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
-
-  std::stringstream ss;
-  ss << "_cuda_kernel_";
-  for (int i = 0; i < len; ++i) {
-    ss << alpha[rand() % (sizeof(alpha) - 1)];
-  }
-  return ss.str();
-}
-
 }  // namepsace caffe2
 
 #endif  // CAFFE2_CUDA_RTC_COMMON_RTC_H_
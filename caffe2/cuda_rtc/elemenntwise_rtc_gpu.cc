@@ -8,7 +8,7 @@ namespace {
 class ElementwiseRTCFunction
     : public CudaRTCFunction<ElementwiseRTCFunction> {
  public:
-  ElementwiseRTCFunction() : CudaRTCFunction(), name_(GetUniqueName()) {}
+  ElementwiseRTCFunction() : CudaRTCFunction(), name_("elementwise_rtc") {}
 
   template <typename... Args>
   string KernelName(Args... /*args*/) {
@@ -0,0 +1,185 @@
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+#include "caffe2/core/common_gpu.h"
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/cuda_rtc/common_rtc.h"
+#include "caffe2/operators/fused_elementwise_op.h"
+
+namespace caffe2 {
+namespace {
+
+// Exact float literal of the kernel source
+string FloatLiteral(float value) {
+  uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  std::stringstream ss;
+  ss << "__int_as_float(0x" << std::hex << bits << ")";
+  return ss.str();
+}
+
+string StepExpression(const FusedElementwiseProgram::Step& step) {
+  using StepType = FusedElementwiseProgram::StepType;
+  const string a = "v" + caffe2::to_string(step.operands[0]);
+  const string b = step.operands.size() > 1
+      ? "v" + caffe2::to_string(step.operands[1])
+      : "";
+  switch (step.type) {
+    case StepType::Add:
+      return a + " + " + b;
+    case StepType::Sub:
+      return a + " - " + b;
+    case StepType::Mul:
+      return a + " * " + b;
+    case StepType::Div:
+      return a + " / " + b;
+    case StepType::Sigmoid:
+      return "1.0f / (1.0f + expf(-" + a + "))";
+    case StepType::Tanh:
+      return "tanhf(" + a + ")";
+    case StepType::Relu:
+      return "fmaxf(" + a + ", 0.0f)";
+    case StepType::Exp:
+      return "expf(" + a + ")";
+    case StepType::Log:
+      return "logf(" + a + ")";
+    case StepType::Abs:
+      return "fabsf(" + a + ")";
+    case StepType::Sqr:
+      return a + " * " + a;
+    case StepType::Sqrt:
+      return "sqrtf(" + a + ")";
+    case StepType::Negative:
+      return "-" + a;
+    case StepType::Scale:
+      return a + " * " + FloatLiteral(step.scale);
+  }
+  CAFFE_THROW("Unknown FusedElementwise step");
+}
+
+class FusedElementwiseRTCFunction
+    : public CudaRTCFunction<FusedElementwiseRTCFunction> {
+ public:
+  FusedElementwiseRTCFunction()
+      : CudaRTCFunction(), name_("fused_elementwise_rtc") {}
+
+  template <typename... Args>
+  string KernelName(Args... /*args*/) {
+    return name_;
+  }
+
+  template <typename... Args>
+  string GetSource(Args... args);
+
+ private:
+  string name_;
+};
+
+// Kernel computing the outputs of a group, which takes every input of the op
+// and the outputs of the group, and reads the values it needs into registers
+template <>
+string FusedElementwiseRTCFunction::GetSource(
+    const FusedElementwiseProgram* program,
+    const FusedElementwiseProgram::Group* group,
+    const std::vector<bool>* scalars) {
+  std::stringstream ss;
+  ss << "extern \"C\" __global__ void " << name_ << "(const size_t nthreads";
+  for (int i = 0; i < program->num_inputs(); ++i) {
+    ss << ",\nconst float* in" << i;
+  }
+  for (int i = 0; i < group->outputs.size(); ++i) {
+    ss << ",\nfloat* out" << i;
+  }
+  ss << ") {\n"
+        "for (int index = blockIdx.x * blockDim.x + threadIdx.x;\n"
+        "index < nthreads; index += blockDim.x * gridDim.x) {\n";
+  for (int i = 0; i < program->num_inputs(); ++i) {
+    if (group->needed[i]) {
+      ss << "const float v" << i << " = in" << i
+         << ((*scalars)[i] ? "[0]" : "[index]") << ";\n";
+    }
+  }
+  for (int value = program->num_inputs(); value < program->num_values();
+       ++value) {
+    if (group->needed[value]) {
+      ss << "const float v" << value << " = "
+         << StepExpression(program->steps()[value - program->num_inputs()])
+         << ";\n";
+    }
+  }
+  for (int i = 0; i < group->outputs.size(); ++i) {
+    ss << "out" << i << "[index] = v"
+       << program->outputs()[group->outputs[i]] << ";\n";
+  }
+  ss << "}\n}";
+  return ss.str();
+}
+} // namespace
+
+/**
+ * The CUDA implementation of FusedElementwise, which generates a kernel
+ * computing the steps of the program in registers and compiles it with NVRTC
+ * the first time it runs with a group of outputs and scalar inputs.
+ */
+class FusedElementwiseRTCOp final
+    : public FusedElementwiseOpBase<CUDAContext> {
+ public:
+  FusedElementwiseRTCOp(const OperatorDef& operator_def, Workspace* ws)
+      : FusedElementwiseOpBase<CUDAContext>(operator_def, ws) {}
+
+ protected:
+  void RunGroup(
+      const FusedElementwiseProgram::Group& group,
+      int size,
+      const std::vector<const float*>& inputs,
+      const std::vector<bool>& scalars,
+      const std::vector<float*>& outputs) override {
+    static_assert(sizeof(void*) == sizeof(size_t),
+                  "The argbuffer relies on the assumption that void* and "
+                  "size_t have the same size.");
+    std::stringstream key;
+    for (int output : group.outputs) {
+      key << output << ",";
+    }
+    for (int i = 0; i < inputs.size(); ++i) {
+      key << (group.needed[i] ? (scalars[i] ? "s" : "t") : "-");
+    }
+    auto& func = functions_[key.str()];
+    if (!func) {
+      func.reset(new FusedElementwiseRTCFunction());
+      func->Compile(&program_, &group, &scalars);
+    }
+
+    vector<size_t> argBuffer_vec(inputs.size() + outputs.size() + 1);
+    size_t* argBuffer = argBuffer_vec.data();
+    argBuffer[0] = size;
+    void** ptr_buffer = reinterpret_cast<void**>(argBuffer + 1);
+    for (int i = 0; i < inputs.size(); ++i) {
+      ptr_buffer[i] = const_cast<float*>(inputs[i]);
+    }
+    for (int i = 0; i < outputs.size(); ++i) {
+      ptr_buffer[i + inputs.size()] = outputs[i];
+    }
+    size_t argBufferSize = argBuffer_vec.size() * sizeof(size_t);
+    void* config[] = {
+      CU_LAUNCH_PARAM_BUFFER_POINTER, argBuffer,
+      CU_LAUNCH_PARAM_BUFFER_SIZE, &argBufferSize,
+      CU_LAUNCH_PARAM_END
+    };
+    func->LaunchEx(CAFFE_GET_BLOCKS(size), 1, 1,
+                   CAFFE_CUDA_NUM_THREADS, 1, 1,
+                   0, context_.cuda_stream(), config);
+  }
+
+ private:
+  std::unordered_map<string, std::unique_ptr<FusedElementwiseRTCFunction>>
+      functions_;
+};
+
+namespace {
+REGISTER_CUDA_OPERATOR(FusedElementwise, FusedElementwiseRTCOp);
+}
+
+}  // namespace caffe2
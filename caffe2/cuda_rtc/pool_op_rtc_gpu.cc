@@ -101,7 +101,7 @@ __global__ void %s(
 
 class MaxPoolRTCFunction : public CudaRTCFunction<MaxPoolRTCFunction> {
  public:
-  MaxPoolRTCFunction() : CudaRTCFunction(), name_(GetUniqueName()) {}
+  MaxPoolRTCFunction() : CudaRTCFunction(), name_("max_pool_rtc") {}
 
   template <typename... Args>
   string KernelName(Args... /*args*/) {
@@ -118,7 +118,8 @@ class MaxPoolRTCFunction : public CudaRTCFunction<MaxPoolRTCFunction> {
 class MaxPoolGradientRTCFunction
     : public CudaRTCFunction<MaxPoolGradientRTCFunction> {
  public:
-  MaxPoolGradientRTCFunction() : CudaRTCFunction(), name_(GetUniqueName()) {}
+  MaxPoolGradientRTCFunction()
+      : CudaRTCFunction(), name_("max_pool_gradient_rtc") {}
 
   template <typename... Args>
   string KernelName(Args... /*args*/) {
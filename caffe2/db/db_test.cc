@@ -196,5 +196,65 @@ TEST(DBReaderShardedTest, Reader) {
   EXPECT_EQ(value, "05");
 }
 
+TEST(MMapDBTest, ZeroCopyCursor) {
+  std::string name = std::tmpnam(nullptr);
+  ASSERT_TRUE(CreateAndFill("mmapdb", name));
+  std::unique_ptr<DB> db(CreateDB("mmapdb", name, READ));
+  std::unique_ptr<Cursor> cursor(db->NewCursor());
+  EXPECT_TRUE(cursor->SupportsZeroCopy());
+  EXPECT_FALSE(cursor->SupportsSeek());
+  for (int i = 0; i < kMaxItems; ++i) {
+    ASSERT_TRUE(cursor->Valid());
+    std::stringstream ss;
+    ss << std::setw(2) << std::setfill('0') << i;
+    EXPECT_EQ(cursor->keySlice().ToString(), ss.str());
+    EXPECT_EQ(cursor->value(), ss.str());
+    cursor->Next();
+  }
+  EXPECT_FALSE(cursor->Valid());
+  cursor->SeekToFirst();
+  EXPECT_EQ(cursor->key(), "00");
+
+  // Appending to an existing db keeps its records.
+  cursor.reset();
+  db.reset();
+  db = CreateDB("mmapdb", name, WRITE);
+  db->NewTransaction()->Put("10", "10");
+  db.reset();
+  db = CreateDB("mmapdb", name, READ);
+  cursor = db->NewCursor();
+  int count = 0;
+  for (; cursor->Valid(); cursor->Next()) {
+    ++count;
+  }
+  EXPECT_EQ(count, kMaxItems + 1);
+}
+
+TEST(MMapDBTest, ShardReaders) {
+  std::string name = std::tmpnam(nullptr);
+  ASSERT_TRUE(CreateAndFill("mmapdb", name));
+  // Every shard reads a disjoint range of consecutive records, and wraps
+  // back to the start of its range.
+  DBReader reader0("mmapdb", name, 3, 0);
+  DBReader reader2("mmapdb", name, 3, 2);
+  string key;
+  Slice value;
+  string buffer;
+  reader0.Read(&key, &value, &buffer);
+  EXPECT_EQ(key, "00");
+  EXPECT_EQ(value.ToString(), "00");
+  // The value points into the db rather than into the buffer.
+  EXPECT_TRUE(buffer.empty());
+  reader0.Read(&key, &value, &buffer);
+  EXPECT_EQ(key, "01");
+  reader0.Read(&key, &value, &buffer);
+  EXPECT_EQ(key, "02");
+  reader0.Read(&key, &value, &buffer);
+  EXPECT_EQ(key, "00");
+  reader2.Read(&key, &value, &buffer);
+  EXPECT_EQ(key, "06");
+  EXPECT_EQ(value.ToString(), "06");
+}
+
 }  // namespace db
 }  // namespace caffe2
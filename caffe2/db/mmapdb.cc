@@ -0,0 +1,312 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+#include "caffe2/core/db.h"
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+namespace db {
+
+// MMapDB stores its records in a single file that is memory mapped for
+// reading, so that cursors return the keys and values straight from the
+// mapped pages without copying them. The file is laid out as:
+//
+//   for every record: uint32 key size, uint32 value size, key, value
+//   for every record: uint64 offset of the record in the file
+//   uint64 number of records, uint64 magic
+//
+// The index of offsets at the end allows to reach any record directly, so
+// that a shard cursor can start reading in the middle of the file.
+// MMapDB does not support seeking to a specific key.
+
+namespace {
+
+constexpr uint64_t kMMapDBMagic = 0x4244504d4d324343ULL; // "CC2MMPDB"
+constexpr size_t kRecordHeaderSize = 2 * sizeof(uint32_t);
+constexpr size_t kFooterSize = 2 * sizeof(uint64_t);
+
+// The file may not be aligned for these, so they are read with memcpy.
+template <typename T>
+T ReadUnaligned(const char* ptr) {
+  T value;
+  memcpy(&value, ptr, sizeof(T));
+  return value;
+}
+
+} // namespace
+
+// The mapped file of a MMapDB in READ mode, shared by all of its cursors.
+class MMapDBFile {
+ public:
+  explicit MMapDBFile(const string& source) : data_(nullptr), size_(0) {
+    int fd = open(source.c_str(), O_RDONLY);
+    CAFFE_ENFORCE_NE(fd, -1, "Cannot open file: ", source);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)kFooterSize) {
+      close(fd);
+      CAFFE_THROW("Not a MMapDB file: ", source);
+    }
+    size_ = st.st_size;
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    // The mapping stays valid after the file is closed.
+    close(fd);
+    CAFFE_ENFORCE(data != MAP_FAILED, "Cannot mmap file: ", source);
+    data_ = static_cast<const char*>(data);
+    try {
+      ReadFooter(source);
+    } catch (...) {
+      munmap(data, size_);
+      throw;
+    }
+  }
+
+  ~MMapDBFile() {
+    munmap(const_cast<char*>(data_), size_);
+  }
+
+  size_t num_records() const {
+    return num_records_;
+  }
+
+  // The records take the first records_end() bytes of the file.
+  size_t records_end() const {
+    return records_end_;
+  }
+
+  uint64_t Offset(size_t i) const {
+    DCHECK_LT(i, num_records_);
+    return ReadUnaligned<uint64_t>(index_ + i * sizeof(uint64_t));
+  }
+
+  // Returns the key and the value of the i-th record.
+  void Record(size_t i, Slice* key, Slice* value) const {
+    const uint64_t offset = Offset(i);
+    CAFFE_ENFORCE_LE(offset + kRecordHeaderSize, records_end_);
+    const uint32_t key_size = ReadUnaligned<uint32_t>(data_ + offset);
+    const uint32_t value_size =
+        ReadUnaligned<uint32_t>(data_ + offset + sizeof(uint32_t));
+    CAFFE_ENFORCE_LE(
+        offset + kRecordHeaderSize + key_size + value_size, records_end_);
+    *key = Slice(data_ + offset + kRecordHeaderSize, key_size);
+    *value = Slice(key->data + key_size, value_size);
+  }
+
+ private:
+  void ReadFooter(const string& source) {
+    CAFFE_ENFORCE_EQ(
+        ReadUnaligned<uint64_t>(data_ + size_ - sizeof(uint64_t)),
+        kMMapDBMagic,
+        "Not a MMapDB file: ",
+        source);
+    num_records_ = ReadUnaligned<uint64_t>(data_ + size_ - kFooterSize);
+    CAFFE_ENFORCE_LE(
+        num_records_,
+        (size_ - kFooterSize) / sizeof(uint64_t),
+        "Corrupted MMapDB index: ",
+        source);
+    records_end_ = size_ - kFooterSize - num_records_ * sizeof(uint64_t);
+    index_ = data_ + records_end_;
+  }
+
+  const char* data_;
+  size_t size_;
+  size_t num_records_;
+  size_t records_end_;
+  const char* index_;
+
+  DISABLE_COPY_AND_ASSIGN(MMapDBFile);
+};
+
+class MMapDBCursor : public Cursor {
+ public:
+  // Iterates over the records [begin, end) of the file.
+  MMapDBCursor(const MMapDBFile* file, size_t begin, size_t end)
+      : file_(file), begin_(begin), end_(end), iter_(begin) {}
+  ~MMapDBCursor() {}
+
+  void Seek(const string& /*key*/) override {
+    CAFFE_THROW("MMapDB does not support seeking to a specific key.");
+  }
+
+  void SeekToFirst() override {
+    iter_ = begin_;
+  }
+  void Next() override {
+    ++iter_;
+  }
+  string key() override {
+    return keySlice().ToString();
+  }
+  string value() override {
+    return valueSlice().ToString();
+  }
+  bool Valid() override {
+    return iter_ < end_;
+  }
+
+  bool SupportsZeroCopy() override {
+    return true;
+  }
+  Slice keySlice() override {
+    CAFFE_ENFORCE(Valid(), "Cursor is at invalid location!");
+    Slice key, value;
+    file_->Record(iter_, &key, &value);
+    return key;
+  }
+  Slice valueSlice() override {
+    CAFFE_ENFORCE(Valid(), "Cursor is at invalid location!");
+    Slice key, value;
+    file_->Record(iter_, &key, &value);
+    return value;
+  }
+
+ private:
+  const MMapDBFile* file_;
+  size_t begin_;
+  size_t end_;
+  size_t iter_;
+};
+
+class MMapDBTransaction : public Transaction {
+ public:
+  MMapDBTransaction(FILE* f, std::vector<uint64_t>* offsets, std::mutex* mutex)
+      : file_(f), offsets_(offsets), lock_(*mutex) {}
+  ~MMapDBTransaction() {
+    Commit();
+  }
+
+  void Put(const string& key, const string& value) override {
+    CAFFE_ENFORCE(file_, "Transaction already committed.");
+    const uint32_t key_size = key.size();
+    const uint32_t value_size = value.size();
+    const long offset = ftell(file_);
+    CAFFE_ENFORCE_GE(offset, 0);
+    CAFFE_ENFORCE_EQ(fwrite(&key_size, sizeof(uint32_t), 1, file_), 1);
+    CAFFE_ENFORCE_EQ(fwrite(&value_size, sizeof(uint32_t), 1, file_), 1);
+    CAFFE_ENFORCE_EQ(fwrite(key.data(), 1, key_size, file_), key_size);
+    CAFFE_ENFORCE_EQ(fwrite(value.data(), 1, value_size, file_), value_size);
+    offsets_->push_back(offset);
+  }
+
+  // The records are flushed, but only become readable once the index is
+  // written when the db is closed.
+  void Commit() override {
+    if (file_ != nullptr) {
+      CAFFE_ENFORCE_EQ(fflush(file_), 0);
+      file_ = nullptr;
+    }
+  }
+
+ private:
+  FILE* file_;
+  std::vector<uint64_t>* offsets_;
+  std::lock_guard<std::mutex> lock_;
+
+  DISABLE_COPY_AND_ASSIGN(MMapDBTransaction);
+};
+
+class MMapDB : public DB {
+ public:
+  MMapDB(const string& source, Mode mode) : DB(source, mode), file_(nullptr) {
+    switch (mode) {
+      case NEW:
+        file_ = fopen(source.c_str(), "wb");
+        CAFFE_ENFORCE(file_, "Cannot open file: " + source);
+        break;
+      case WRITE: {
+        // Read the index of the existing records, and drop it from the file
+        // so that new records are appended after the existing ones.
+        size_t records_end = 0;
+        {
+          MMapDBFile existing(source);
+          for (size_t i = 0; i < existing.num_records(); ++i) {
+            offsets_.push_back(existing.Offset(i));
+          }
+          records_end = existing.records_end();
+        }
+        CAFFE_ENFORCE_EQ(
+            truncate(source.c_str(), records_end),
+            0,
+            "Cannot truncate file: ",
+            source);
+        file_ = fopen(source.c_str(), "ab");
+        CAFFE_ENFORCE(file_, "Cannot open file: " + source);
+        fseek(file_, 0, SEEK_END);
+        break;
+      }
+      case READ:
+        mapped_.reset(new MMapDBFile(source));
+        break;
+    }
+    VLOG(1) << "Opened MMapDB " << source;
+  }
+  ~MMapDB() {
+    Close();
+  }
+
+  void Close() override {
+    if (file_) {
+      // Write the index and the footer after the records. This runs in the
+      // destructor, so errors are logged rather than thrown.
+      std::lock_guard<std::mutex> lock(file_access_mutex_);
+      const uint64_t num_records = offsets_.size();
+      const bool written =
+          fwrite(offsets_.data(), sizeof(uint64_t), num_records, file_) ==
+              num_records &&
+          fwrite(&num_records, sizeof(uint64_t), 1, file_) == 1 &&
+          fwrite(&kMMapDBMagic, sizeof(uint64_t), 1, file_) == 1;
+      if (fclose(file_) != 0 || !written) {
+        LOG(ERROR) << "Cannot write the index of MMapDB";
+      }
+    }
+    file_ = nullptr;
+    mapped_.reset();
+  }
+
+  // Unlike MiniDB, any number of cursors can read the db at the same time.
+  unique_ptr<Cursor> NewCursor() override {
+    CAFFE_ENFORCE_EQ(this->mode_, READ);
+    return make_unique<MMapDBCursor>(
+        mapped_.get(), 0, mapped_->num_records());
+  }
+
+  unique_ptr<Cursor> NewShardCursor(int32_t num_shards, int32_t shard_id)
+      override {
+    CAFFE_ENFORCE_EQ(this->mode_, READ);
+    CAFFE_ENFORCE_GE(num_shards, 1);
+    CAFFE_ENFORCE(0 <= shard_id && shard_id < num_shards);
+    const size_t n = mapped_->num_records();
+    return make_unique<MMapDBCursor>(
+        mapped_.get(),
+        shard_id * n / num_shards,
+        (shard_id + 1) * n / num_shards);
+  }
+
+  unique_ptr<Transaction> NewTransaction() override {
+    CAFFE_ENFORCE(this->mode_ == NEW || this->mode_ == WRITE);
+    return make_unique<MMapDBTransaction>(
+        file_, &offsets_, &file_access_mutex_);
+  }
+
+ private:
+  FILE* file_;
+  // Offsets of the records written so far, in NEW or WRITE mode.
+  std::vector<uint64_t> offsets_;
+  // access mutex makes sure we don't have multiple transactions writing the
+  // same file.
+  std::mutex file_access_mutex_;
+  // The mapped file, in READ mode.
+  std::unique_ptr<MMapDBFile> mapped_;
+};
+
+REGISTER_CAFFE2_DB(MMapDB, MMapDB);
+REGISTER_CAFFE2_DB(mmapdb, MMapDB);
+
+} // namespace db
+} // namespace caffe2
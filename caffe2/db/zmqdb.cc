@@ -1,20 +1,39 @@
 #include <atomic>
 #include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <mutex>
 #include <thread>  // NOLINT
 
 #include "caffe2/core/db.h"
 #include "caffe2/utils/zmq_helper.h"
+#include "caffe2/core/flags.h"
 #include "caffe2/core/logging.h"
 
+CAFFE2_DEFINE_int(
+    caffe2_zmq_db_prefetch_batches,
+    16,
+    "The number of zmq messages (record batches) a ZmqDB cursor queues "
+    "ahead of the reader.");
+
 namespace caffe2 {
 namespace db {
 
+// Records arrive either one per two-part key / value message or in batches
+// framed as described in zmq_helper.h. Received messages are queued as they
+// are and the cursor reads the records in place, so a record is copied only
+// when key() or value() returns it. Up to caffe2_zmq_db_prefetch_batches
+// messages are queued; once the queue and the socket's receive buffer of the
+// same size are full, the feeder's PUSH socket blocks or moves on to the
+// other readers connected to it.
 class ZmqDBCursor : public Cursor {
  public:
   explicit ZmqDBCursor(const string& source)
-      : source_(source), socket_(ZMQ_PULL),
-        prefetched_(false), finalize_(false) {
+      : source_(source), socket_(ZMQ_PULL), finalize_(false) {
+    CAFFE_ENFORCE_GT(FLAGS_caffe2_zmq_db_prefetch_batches, 0);
+    socket_.SetOption(ZMQ_RCVHWM, FLAGS_caffe2_zmq_db_prefetch_batches);
+    // Wake up periodically so that the prefetch thread notices finalize_.
+    socket_.SetOption(ZMQ_RCVTIMEO, kRecvTimeoutMs);
     socket_.Connect(source_);
     // Start prefetching thread.
     prefetch_thread_.reset(
@@ -24,8 +43,10 @@ class ZmqDBCursor : public Cursor {
   }
 
   ~ZmqDBCursor() {
-    finalize_ = true;
-    prefetched_ = false;
+    {
+      std::lock_guard<std::mutex> lock(prefetch_access_mutex_);
+      finalize_ = true;
+    }
     producer_.notify_one();
     // Wait for the prefetch thread to finish elegantly.
     prefetch_thread_->join();
@@ -38,48 +59,122 @@ class ZmqDBCursor : public Cursor {
   void SeekToFirst() override { /* do nothing */ }
 
   void Next() override {
+    if (current_ && ++record_ < current_->records.size()) {
+      return;
+    }
     std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
-    while (!prefetched_) consumer_.wait(lock);
-    key_ = prefetch_key_;
-    value_ = prefetch_value_;
-    prefetched_ = false;
+    while (batches_.empty()) consumer_.wait(lock);
+    current_ = std::move(batches_.front());
+    batches_.pop_front();
+    record_ = 0;
     producer_.notify_one();
   }
 
-  string key() override { return key_; }
-  string value() override { return value_; }
+  string key() override {
+    const auto& record = current_->records[record_];
+    return string(record.key, record.key_size);
+  }
+  string value() override {
+    const auto& record = current_->records[record_];
+    return string(record.value, record.value_size);
+  }
   bool Valid() override { return true; }
 
  private:
+  static constexpr int kRecvTimeoutMs = 100;
+
+  struct Record {
+    const char* key;
+    size_t key_size;
+    const char* value;
+    size_t value_size;
+  };
+
+  // The received message parts and the records pointing into them.
+  struct Batch {
+    vector<unique_ptr<ZmqMessage>> parts;
+    vector<Record> records;
+  };
 
   void Prefetch() {
     while (!finalize_) {
+      unique_ptr<ZmqMessage> msg(new ZmqMessage());
+      if (socket_.Recv(msg.get()) == 0) {
+        continue;
+      }
+      unique_ptr<Batch> batch(new Batch());
+      if (msg->more()) {
+        unique_ptr<ZmqMessage> value_msg(new ZmqMessage());
+        // The parts of a multipart message are delivered together.
+        socket_.RecvTillSuccess(value_msg.get());
+        batch->records.push_back(
+            {static_cast<const char*>(msg->data()), msg->size(),
+             static_cast<const char*>(value_msg->data()), value_msg->size()});
+        batch->parts.push_back(std::move(msg));
+        batch->parts.push_back(std::move(value_msg));
+      } else {
+        if (!ParseBatch(msg.get(), &batch->records)) {
+          LOG(ERROR) << "Dropping a malformed record batch of " << msg->size()
+                     << " bytes from " << source_;
+          continue;
+        }
+        batch->parts.push_back(std::move(msg));
+      }
+      if (batch->records.empty()) {
+        continue;
+      }
       std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
-      while (prefetched_) producer_.wait(lock);
+      while (batches_.size() >=
+                 static_cast<size_t>(FLAGS_caffe2_zmq_db_prefetch_batches) &&
+             !finalize_) {
+        producer_.wait(lock);
+      }
       if (finalize_) {
         return;
       }
-      ZmqMessage msg;
-      socket_.RecvTillSuccess(&msg);
-      prefetch_key_.assign(static_cast<char*>(msg.data()), msg.size());
-      socket_.RecvTillSuccess(&msg);
-      prefetch_value_.assign(static_cast<char*>(msg.data()), msg.size());
-      prefetched_ = true;
+      batches_.push_back(std::move(batch));
       consumer_.notify_one();
     }
   }
 
+  static bool ParseBatch(ZmqMessage* msg, vector<Record>* records) {
+    const char* ptr = static_cast<const char*>(msg->data());
+    const char* end = ptr + msg->size();
+    auto read_size = [&ptr, end](uint32_t* size) {
+      if (end - ptr < static_cast<ptrdiff_t>(sizeof(*size))) {
+        return false;
+      }
+      std::memcpy(size, ptr, sizeof(*size));
+      ptr += sizeof(*size);
+      return true;
+    };
+    uint32_t num_records;
+    if (!read_size(&num_records)) {
+      return false;
+    }
+    records->reserve(num_records);
+    for (uint32_t i = 0; i < num_records; ++i) {
+      uint32_t key_size, value_size;
+      if (!read_size(&key_size) || !read_size(&value_size) ||
+          static_cast<uint64_t>(end - ptr) <
+              static_cast<uint64_t>(key_size) + value_size) {
+        return false;
+      }
+      records->push_back({ptr, key_size, ptr + key_size, value_size});
+      ptr += key_size + static_cast<size_t>(value_size);
+    }
+    return ptr == end;
+  }
+
   string source_;
   ZmqSocket socket_;
-  string key_;
-  string value_;
-  string prefetch_key_;
-  string prefetch_value_;
+  unique_ptr<Batch> current_;
+  size_t record_ = 0;
 
   unique_ptr<std::thread> prefetch_thread_;
   std::mutex prefetch_access_mutex_;
   std::condition_variable producer_, consumer_;
-  std::atomic<bool> prefetched_;
+  std::deque<unique_ptr<Batch>> batches_;
   // finalize_ is used to tell the prefetcher to quit.
   std::atomic<bool> finalize_;
 };
@@ -7,15 +7,23 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <iostream>
+#include <memory>
 #include <thread>
 
 #if defined(_MSC_VER)
 #include <direct.h> // for _mkdir
 #endif
 
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
 #include "caffe2/utils/murmur_hash3.h"
 
 namespace caffe2 {
@@ -34,6 +42,72 @@ static std::string encodeName(const std::string& name) {
   return std::string(buf.data(), buf.size() - 1);
 }
 
+namespace {
+
+constexpr std::chrono::milliseconds kMinPollInterval(10);
+constexpr std::chrono::milliseconds kMaxPollInterval(1000);
+
+// Waits for files to appear in a directory. On Linux, inotify wakes the
+// waiter up as soon as a process on this host renames a file into it, but it
+// doesn't see files created by other hosts on shared filesystems (such as
+// NFS). Every wait is therefore also bounded by a poll interval, which
+// doubles while nothing appears so that many waiting ranks don't hammer the
+// filesystem.
+class DirectoryWatcher {
+ public:
+  explicit DirectoryWatcher(const std::string& path)
+      : fd_(-1), interval_(kMinPollInterval) {
+#if defined(__linux__)
+    fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ >= 0 &&
+        inotify_add_watch(fd_, path.c_str(), IN_MOVED_TO | IN_CREATE) < 0) {
+      close(fd_);
+      fd_ = -1;
+    }
+#endif
+  }
+
+  ~DirectoryWatcher() {
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      close(fd_);
+    }
+#endif
+  }
+
+  // Blocks until a file may have appeared, for at most the current poll
+  // interval and limit.
+  void wait(std::chrono::milliseconds limit) {
+    const auto interval = std::min(interval_, limit);
+    interval_ = std::min(interval_ * 2, kMaxPollInterval);
+#if defined(__linux__)
+    if (fd_ >= 0) {
+      struct pollfd pfd = {fd_, POLLIN, 0};
+      auto rv = poll(&pfd, 1, static_cast<int>(interval.count()));
+      CAFFE_ENFORCE(rv >= 0 || errno == EINTR, "poll: ", strerror(errno));
+      // Drain the events; they only tell us to look for the files again.
+      char buf[4096];
+      while (read(fd_, buf, sizeof(buf)) > 0) {
+      }
+      return;
+    }
+#endif
+    /* sleep override */
+    std::this_thread::sleep_for(interval);
+  }
+
+  // Restarts the backoff after a file has appeared.
+  void reset() {
+    interval_ = kMinPollInterval;
+  }
+
+ private:
+  int fd_;
+  std::chrono::milliseconds interval_;
+};
+
+} // namespace
+
 FileStoreHandler::FileStoreHandler(
     const std::string& path,
     const std::string& prefix) {
@@ -144,17 +218,42 @@ bool FileStoreHandler::check(const std::vector<std::string>& names) {
 void FileStoreHandler::wait(
     const std::vector<std::string>& names,
     const std::chrono::milliseconds& timeout) {
-  // Not using inotify because it doesn't work on many
-  // shared filesystems (such as NFS).
   const auto start = std::chrono::steady_clock::now();
-  while (!check(names)) {
-    const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+  std::unique_ptr<DirectoryWatcher> watcher;
+  // Names that have been found are not looked up again.
+  std::vector<std::string> pending(names);
+  while (true) {
+    const auto numPending = pending.size();
+    pending.erase(
+        std::remove_if(
+            pending.begin(),
+            pending.end(),
+            [this](const std::string& name) { return check({name}); }),
+        pending.end());
+    if (pending.empty()) {
+      return;
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::steady_clock::now() - start);
     if (timeout != kNoTimeout && elapsed > timeout) {
       STORE_HANDLER_TIMEOUT("Wait timeout for name(s): ", Join(" ", names));
     }
-    /* sleep override */
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    if (!watcher) {
+      // Look for the files once more after starting to watch the directory,
+      // so that a file created in between is not missed.
+      watcher.reset(new DirectoryWatcher(basePath_));
+      continue;
+    }
+    if (pending.size() != numPending) {
+      watcher->reset();
+    }
+    auto limit = kMaxPollInterval;
+    if (timeout != kNoTimeout) {
+      limit = std::min(limit, timeout - elapsed);
+    }
+    watcher->wait(limit);
   }
 }
 }
@@ -0,0 +1,542 @@
+#include "sharded_embedding.h"
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <functional>
+#include <future>
+#include <random>
+
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+
+namespace {
+
+enum RequestType : uint8_t {
+  kGather = 0,
+  kScatterAdd = 1,
+};
+
+enum Status : uint8_t {
+  kOk = 0,
+  kError = 1,
+};
+
+// The size of a request is bounded, to fail on garbage instead of trying to
+// allocate it
+constexpr uint64_t kMaxRequestElements = 1 << 28;
+
+void sendAll(int fd, const void* data, size_t size) {
+  auto bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    auto sent = ::send(fd, bytes, size, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    CAFFE_ENFORCE_GT(sent, 0, "Sending to embedding shard: ", strerror(errno));
+    bytes += sent;
+    size -= sent;
+  }
+}
+
+// Returns false if the peer closed the connection before the first byte.
+bool recvAll(int fd, void* data, size_t size) {
+  auto bytes = static_cast<char*>(data);
+  bool first = true;
+  while (size > 0) {
+    auto received = ::recv(fd, bytes, size, 0);
+    if (received < 0 && errno == EINTR) {
+      continue;
+    }
+    if (received == 0 && first) {
+      return false;
+    }
+    CAFFE_ENFORCE_GT(
+        received,
+        0,
+        "Receiving from embedding shard: ",
+        received == 0 ? "connection closed" : strerror(errno));
+    bytes += received;
+    size -= received;
+    first = false;
+  }
+  return true;
+}
+
+void recvOrThrow(int fd, void* data, size_t size) {
+  CAFFE_ENFORCE(recvAll(fd, data, size), "Embedding shard connection closed");
+}
+
+template <typename T>
+void sendValue(int fd, const T& value) {
+  sendAll(fd, &value, sizeof(T));
+}
+
+template <typename T>
+T recvValue(int fd) {
+  T value;
+  recvOrThrow(fd, &value, sizeof(T));
+  return value;
+}
+
+void setNoDelay(int fd) {
+  int flag = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+}
+
+// Runs fn for every shard, in parallel if there are several of them.
+void forEachShard(
+    const std::vector<size_t>& shards,
+    const std::function<void(size_t)>& fn) {
+  if (shards.size() == 1) {
+    fn(shards[0]);
+    return;
+  }
+  std::vector<std::future<void>> futures;
+  futures.reserve(shards.size());
+  for (auto shard : shards) {
+    futures.push_back(std::async(std::launch::async, fn, shard));
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+}
+
+} // namespace
+
+EmbeddingShard::EmbeddingShard(
+    int64_t numRows,
+    int64_t dim,
+    float initRange,
+    int seed)
+    : numRows_(numRows), dim_(dim), table_(numRows * dim) {
+  CAFFE_ENFORCE_GE(numRows, 0);
+  CAFFE_ENFORCE_GT(dim, 0);
+  if (initRange > 0) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<float> distribution(-initRange, initRange);
+    for (auto& value : table_) {
+      value = distribution(generator);
+    }
+  }
+}
+
+void EmbeddingShard::checkIds(const int64_t* ids, size_t n) const {
+  for (size_t i = 0; i < n; i++) {
+    CAFFE_ENFORCE(
+        ids[i] >= 0 && ids[i] < numRows_,
+        "Row ",
+        ids[i],
+        " is out of the shard of ",
+        numRows_,
+        " rows");
+  }
+}
+
+void EmbeddingShard::gather(const int64_t* ids, size_t n, float* out) {
+  checkIds(ids, n);
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (size_t i = 0; i < n; i++) {
+    std::copy_n(&table_[ids[i] * dim_], dim_, out + i * dim_);
+  }
+}
+
+void EmbeddingShard::scatterAdd(
+    const int64_t* ids,
+    size_t n,
+    const float* values,
+    float scale) {
+  checkIds(ids, n);
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (size_t i = 0; i < n; i++) {
+    auto row = &table_[ids[i] * dim_];
+    auto value = values + i * dim_;
+    for (int64_t j = 0; j < dim_; j++) {
+      row[j] += scale * value[j];
+    }
+  }
+}
+
+EmbeddingShardServer::EmbeddingShardServer(
+    std::shared_ptr<EmbeddingShard> shard,
+    int port)
+    : shard_(std::move(shard)), stop_(false) {
+  listenFd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+  CAFFE_ENFORCE_GE(listenFd_, 0, "socket: ", strerror(errno));
+  int flag = 1;
+  ::setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+  struct sockaddr_in addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  if (::bind(listenFd_, reinterpret_cast<struct sockaddr*>(&addr),
+             sizeof(addr)) != 0 ||
+      ::listen(listenFd_, SOMAXCONN) != 0) {
+    auto err = errno;
+    ::close(listenFd_);
+    CAFFE_THROW("Listening on port ", port, ": ", strerror(err));
+  }
+
+  socklen_t addrLen = sizeof(addr);
+  ::getsockname(
+      listenFd_, reinterpret_cast<struct sockaddr*>(&addr), &addrLen);
+  port_ = ntohs(addr.sin_port);
+  listenThread_ = std::thread(&EmbeddingShardServer::listen, this);
+}
+
+EmbeddingShardServer::~EmbeddingShardServer() {
+  stop_ = true;
+  ::shutdown(listenFd_, SHUT_RDWR);
+  listenThread_.join();
+  ::close(listenFd_);
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  for (auto fd : clientFds_) {
+    ::shutdown(fd, SHUT_RDWR);
+  }
+  for (auto& thread : clientThreads_) {
+    thread.join();
+  }
+  for (auto fd : clientFds_) {
+    ::close(fd);
+  }
+}
+
+void EmbeddingShardServer::listen() {
+  while (!stop_) {
+    auto fd = ::accept(listenFd_, nullptr, nullptr);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (!stop_) {
+        LOG(ERROR) << "Embedding shard server stopped accepting: "
+                   << strerror(errno);
+      }
+      return;
+    }
+    setNoDelay(fd);
+    std::lock_guard<std::mutex> guard(mutex_);
+    clientFds_.push_back(fd);
+    clientThreads_.emplace_back(&EmbeddingShardServer::serve, this, fd);
+  }
+}
+
+void EmbeddingShardServer::serve(int fd) {
+  const auto dim = shard_->dim();
+  std::vector<int64_t> ids;
+  std::vector<float> values;
+  try {
+    uint8_t type;
+    while (recvAll(fd, &type, sizeof(type))) {
+      const auto n = recvValue<uint64_t>(fd);
+      const auto requestDim = recvValue<int64_t>(fd);
+      CAFFE_ENFORCE(
+          requestDim > 0 && n * std::max(requestDim, dim) <= kMaxRequestElements,
+          "Invalid embedding request");
+      ids.resize(n);
+      recvOrThrow(fd, ids.data(), n * sizeof(int64_t));
+
+      float scale = 0;
+      if (type == kScatterAdd) {
+        scale = recvValue<float>(fd);
+        values.resize(n * requestDim);
+        recvOrThrow(fd, values.data(), values.size() * sizeof(float));
+      } else {
+        values.resize(n * dim);
+      }
+
+      // Errors of the request are reported to the client, errors of the
+      // connection drop it
+      std::string error;
+      try {
+        CAFFE_ENFORCE_EQ(requestDim, dim, "Rows have ", dim, " elements");
+        if (type == kGather) {
+          shard_->gather(ids.data(), n, values.data());
+        } else if (type == kScatterAdd) {
+          shard_->scatterAdd(ids.data(), n, values.data(), scale);
+        } else {
+          CAFFE_THROW("Unknown embedding request ", int(type));
+        }
+      } catch (const std::exception& e) {
+        error = e.what();
+      }
+
+      if (!error.empty()) {
+        sendValue<uint8_t>(fd, kError);
+        sendValue<uint64_t>(fd, error.size());
+        sendAll(fd, error.data(), error.size());
+      } else {
+        sendValue<uint8_t>(fd, kOk);
+        if (type == kGather) {
+          sendAll(fd, values.data(), n * dim * sizeof(float));
+        }
+      }
+    }
+  } catch (const std::exception& e) {
+    if (!stop_) {
+      LOG(ERROR) << "Embedding shard client dropped: " << e.what();
+    }
+  }
+}
+
+EmbeddingShardClient::EmbeddingShardClient(
+    const std::string& host,
+    int port,
+    std::chrono::milliseconds timeout)
+    : fd_(-1) {
+  struct addrinfo hints;
+  std::memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  const auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (true) {
+    struct addrinfo* result = nullptr;
+    auto err = ::getaddrinfo(
+        host.c_str(), std::to_string(port).c_str(), &hints, &result);
+    CAFFE_ENFORCE_EQ(
+        err, 0, "Resolving ", host, ": ", ::gai_strerror(err));
+    for (auto info = result; info && fd_ < 0; info = info->ai_next) {
+      fd_ = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+      if (fd_ >= 0 && ::connect(fd_, info->ai_addr, info->ai_addrlen) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+      }
+    }
+    ::freeaddrinfo(result);
+
+    if (fd_ >= 0) {
+      break;
+    }
+    CAFFE_ENFORCE(
+        std::chrono::steady_clock::now() < deadline,
+        "Timed out connecting to embedding shard ",
+        host,
+        ":",
+        port);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  setNoDelay(fd_);
+}
+
+EmbeddingShardClient::~EmbeddingShardClient() {
+  ::close(fd_);
+}
+
+void EmbeddingShardClient::checkStatus() {
+  if (recvValue<uint8_t>(fd_) == kOk) {
+    return;
+  }
+  std::string error(recvValue<uint64_t>(fd_), '\0');
+  recvOrThrow(fd_, &error[0], error.size());
+  CAFFE_THROW("Embedding shard request failed: ", error);
+}
+
+void EmbeddingShardClient::gather(
+    const int64_t* ids,
+    size_t n,
+    int64_t dim,
+    float* out) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  sendValue<uint8_t>(fd_, kGather);
+  sendValue<uint64_t>(fd_, n);
+  sendValue<int64_t>(fd_, dim);
+  sendAll(fd_, ids, n * sizeof(int64_t));
+  checkStatus();
+  recvOrThrow(fd_, out, n * dim * sizeof(float));
+}
+
+void EmbeddingShardClient::scatterAdd(
+    const int64_t* ids,
+    size_t n,
+    int64_t dim,
+    const float* values,
+    float scale) {
+  std::lock_guard<std::mutex> guard(mutex_);
+  sendValue<uint8_t>(fd_, kScatterAdd);
+  sendValue<uint64_t>(fd_, n);
+  sendValue<int64_t>(fd_, dim);
+  sendAll(fd_, ids, n * sizeof(int64_t));
+  sendValue<float>(fd_, scale);
+  sendAll(fd_, values, n * dim * sizeof(float));
+  checkStatus();
+}
+
+ShardedEmbedding::ShardedEmbedding(
+    const std::vector<std::string>& addresses,
+    int64_t dim,
+    size_t cacheSize,
+    int64_t maxStaleness,
+    std::chrono::milliseconds timeout)
+    : dim_(dim),
+      cacheSize_(cacheSize),
+      maxStaleness_(maxStaleness),
+      iteration_(0),
+      numCacheHits_(0) {
+  CAFFE_ENFORCE(!addresses.empty(), "No embedding shards");
+  CAFFE_ENFORCE_GT(dim, 0);
+  CAFFE_ENFORCE_GE(maxStaleness, 0);
+  for (const auto& address : addresses) {
+    auto colon = address.rfind(':');
+    CAFFE_ENFORCE(
+        colon != std::string::npos,
+        "Embedding shard address isn't host:port: ",
+        address);
+    shards_.emplace_back(new EmbeddingShardClient(
+        address.substr(0, colon),
+        std::stoi(address.substr(colon + 1)),
+        timeout));
+  }
+}
+
+void ShardedEmbedding::gather(const int64_t* ids, size_t n, float* out) {
+  const int64_t numShards = shards_.size();
+
+  // Serve what the cache can, and deduplicate the rows to fetch
+  std::vector<int64_t> missingIds;
+  std::unordered_map<int64_t, size_t> missingIndices;
+  std::vector<std::pair<size_t, size_t>> missingPositions;
+  {
+    std::lock_guard<std::mutex> guard(cacheMutex_);
+    iteration_++;
+    for (size_t i = 0; i < n; i++) {
+      CAFFE_ENFORCE_GE(ids[i], 0, "Invalid embedding row");
+      auto it = cache_.find(ids[i]);
+      if (it != cache_.end() &&
+          iteration_ - it->second.iteration <= maxStaleness_) {
+        std::copy_n(it->second.data.data(), dim_, out + i * dim_);
+        numCacheHits_++;
+        continue;
+      }
+      auto inserted = missingIndices.emplace(ids[i], missingIds.size());
+      if (inserted.second) {
+        missingIds.push_back(ids[i]);
+      }
+      missingPositions.emplace_back(i, inserted.first->second);
+    }
+  }
+  if (missingIds.empty()) {
+    return;
+  }
+
+  // One request per shard
+  std::vector<std::vector<int64_t>> shardRows(numShards);
+  std::vector<std::vector<size_t>> shardIndices(numShards);
+  for (size_t k = 0; k < missingIds.size(); k++) {
+    auto shard = missingIds[k] % numShards;
+    shardRows[shard].push_back(missingIds[k] / numShards);
+    shardIndices[shard].push_back(k);
+  }
+  std::vector<size_t> shards;
+  for (int64_t shard = 0; shard < numShards; shard++) {
+    if (!shardRows[shard].empty()) {
+      shards.push_back(shard);
+    }
+  }
+
+  std::vector<float> rows(missingIds.size() * dim_);
+  forEachShard(shards, [&](size_t shard) {
+    const auto& localRows = shardRows[shard];
+    std::vector<float> buffer(localRows.size() * dim_);
+    shards_[shard]->gather(
+        localRows.data(), localRows.size(), dim_, buffer.data());
+    for (size_t j = 0; j < localRows.size(); j++) {
+      std::copy_n(
+          &buffer[j * dim_], dim_, &rows[shardIndices[shard][j] * dim_]);
+    }
+  });
+
+  for (const auto& position : missingPositions) {
+    std::copy_n(&rows[position.second * dim_], dim_, out + position.first * dim_);
+  }
+  if (cacheSize_ > 0) {
+    cacheRows(missingIds, rows);
+  }
+}
+
+void ShardedEmbedding::cacheRows(
+    const std::vector<int64_t>& ids,
+    const std::vector<float>& rows) {
+  std::lock_guard<std::mutex> guard(cacheMutex_);
+  bool evicted = false;
+  for (size_t k = 0; k < ids.size(); k++) {
+    auto it = cache_.find(ids[k]);
+    if (it == cache_.end()) {
+      if (cache_.size() >= cacheSize_ && !evicted) {
+        for (auto stale = cache_.begin(); stale != cache_.end();) {
+          if (iteration_ - stale->second.iteration > maxStaleness_) {
+            stale = cache_.erase(stale);
+          } else {
+            ++stale;
+          }
+        }
+        evicted = true;
+      }
+      if (cache_.size() >= cacheSize_) {
+        continue;
+      }
+      it = cache_.emplace(ids[k], CachedRow()).first;
+    }
+    it->second.data.assign(&rows[k * dim_], &rows[k * dim_] + dim_);
+    it->second.iteration = iteration_;
+  }
+}
+
+void ShardedEmbedding::scatterAdd(
+    const int64_t* ids,
+    size_t n,
+    const float* values,
+    float scale) {
+  const int64_t numShards = shards_.size();
+  std::vector<std::vector<int64_t>> shardRows(numShards);
+  std::vector<std::vector<float>> shardValues(numShards);
+  for (size_t i = 0; i < n; i++) {
+    CAFFE_ENFORCE_GE(ids[i], 0, "Invalid embedding row");
+    auto shard = ids[i] % numShards;
+    shardRows[shard].push_back(ids[i] / numShards);
+    shardValues[shard].insert(
+        shardValues[shard].end(), values + i * dim_, values + (i + 1) * dim_);
+  }
+  std::vector<size_t> shards;
+  for (int64_t shard = 0; shard < numShards; shard++) {
+    if (!shardRows[shard].empty()) {
+      shards.push_back(shard);
+    }
+  }
+  if (shards.empty()) {
+    return;
+  }
+
+  forEachShard(shards, [&](size_t shard) {
+    shards_[shard]->scatterAdd(
+        shardRows[shard].data(),
+        shardRows[shard].size(),
+        dim_,
+        shardValues[shard].data(),
+        scale);
+  });
+
+  // Keep the cached rows up to date with the updates of this process
+  std::lock_guard<std::mutex> guard(cacheMutex_);
+  for (size_t i = 0; i < n && !cache_.empty(); i++) {
+    auto it = cache_.find(ids[i]);
+    if (it != cache_.end()) {
+      auto& row = it->second.data;
+      for (int64_t j = 0; j < dim_; j++) {
+        row[j] += scale * values[i * dim_ + j];
+      }
+    }
+  }
+}
+
+} // namespace caffe2
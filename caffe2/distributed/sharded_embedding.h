@@ -0,0 +1,166 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace caffe2 {
+
+/*
+ * A shard of an embedding table of float rows, held in memory by the process
+ * that serves it.
+ */
+class EmbeddingShard {
+ public:
+  EmbeddingShard(int64_t numRows, int64_t dim, float initRange, int seed);
+
+  int64_t numRows() const {
+    return numRows_;
+  }
+
+  int64_t dim() const {
+    return dim_;
+  }
+
+  // Copies the rows to out, which holds n * dim floats.
+  void gather(const int64_t* ids, size_t n, float* out);
+
+  // Adds scale * values to the rows, values holding n * dim floats.
+  void scatterAdd(const int64_t* ids, size_t n, const float* values, float scale);
+
+ private:
+  void checkIds(const int64_t* ids, size_t n) const;
+
+  const int64_t numRows_;
+  const int64_t dim_;
+  std::mutex mutex_;
+  std::vector<float> table_;
+};
+
+/*
+ * Serves an EmbeddingShard over TCP, with a thread per client connection.
+ */
+class EmbeddingShardServer {
+ public:
+  // Listens on all the interfaces; port 0 picks any free port.
+  EmbeddingShardServer(std::shared_ptr<EmbeddingShard> shard, int port);
+  ~EmbeddingShardServer();
+
+  int port() const {
+    return port_;
+  }
+
+ private:
+  void listen();
+  void serve(int fd);
+
+  std::shared_ptr<EmbeddingShard> shard_;
+  int listenFd_;
+  int port_;
+  std::atomic<bool> stop_;
+  std::thread listenThread_;
+
+  std::mutex mutex_;
+  std::vector<int> clientFds_;
+  std::vector<std::thread> clientThreads_;
+};
+
+/*
+ * Connection to an EmbeddingShardServer. The requests of a client are
+ * serialized.
+ */
+class EmbeddingShardClient {
+ public:
+  // Retries to connect until the timeout, in case the server isn't up yet.
+  EmbeddingShardClient(
+      const std::string& host,
+      int port,
+      std::chrono::milliseconds timeout);
+  ~EmbeddingShardClient();
+
+  void gather(const int64_t* ids, size_t n, int64_t dim, float* out);
+  void scatterAdd(
+      const int64_t* ids,
+      size_t n,
+      int64_t dim,
+      const float* values,
+      float scale);
+
+ private:
+  void checkStatus();
+
+  std::mutex mutex_;
+  int fd_;
+};
+
+/*
+ * An embedding table sharded over several EmbeddingShardServers: row id is
+ * the row id / numShards of the shard id % numShards.
+ *
+ * The rows of a batch are deduplicated and requested with one request per
+ * shard, issued to all the shards in parallel.
+ *
+ * Up to cacheSize rows are cached locally. Every gather is an iteration, and
+ * a cached row is used for up to maxStaleness iterations after it was
+ * fetched, so it misses the updates of the other processes of at most that
+ * many iterations. The updates of this process are applied to the cached rows
+ * as well. With maxStaleness 0, rows are fetched once per iteration.
+ */
+class ShardedEmbedding {
+ public:
+  ShardedEmbedding(
+      const std::vector<std::string>& addresses,
+      int64_t dim,
+      size_t cacheSize,
+      int64_t maxStaleness,
+      std::chrono::milliseconds timeout);
+
+  int64_t dim() const {
+    return dim_;
+  }
+
+  size_t numShards() const {
+    return shards_.size();
+  }
+
+  // Copies the rows to out, which holds n * dim floats.
+  void gather(const int64_t* ids, size_t n, float* out);
+
+  // Adds scale * values to the rows, values holding n * dim floats. Rows
+  // repeated in ids are added up.
+  void scatterAdd(const int64_t* ids, size_t n, const float* values, float scale);
+
+  // Number of rows that were served from the cache, for monitoring.
+  int64_t numCacheHits() const {
+    return numCacheHits_;
+  }
+
+ private:
+  struct CachedRow {
+    std::vector<float> data;
+    int64_t iteration;
+  };
+
+  // Caches the fetched rows, dropping the stale ones when the cache is full.
+  void cacheRows(
+      const std::vector<int64_t>& ids,
+      const std::vector<float>& rows);
+
+  const int64_t dim_;
+  const size_t cacheSize_;
+  const int64_t maxStaleness_;
+  std::vector<std::unique_ptr<EmbeddingShardClient>> shards_;
+
+  std::mutex cacheMutex_;
+  std::unordered_map<int64_t, CachedRow> cache_;
+  int64_t iteration_;
+  std::atomic<int64_t> numCacheHits_;
+};
+
+} // namespace caffe2
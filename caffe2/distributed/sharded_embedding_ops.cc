@@ -0,0 +1,255 @@
+#include "sharded_embedding_ops.h"
+
+#include "store_handler.h"
+
+#include "caffe2/core/typeid.h"
+
+namespace caffe2 {
+
+CAFFE_KNOWN_TYPE(std::unique_ptr<EmbeddingShardServer>);
+CAFFE_KNOWN_TYPE(std::unique_ptr<ShardedEmbedding>);
+
+EmbeddingShardServeOp::EmbeddingShardServeOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws),
+      numRows_(GetSingleArgument<int64_t>("num_rows", -1)),
+      dim_(GetSingleArgument<int64_t>("dim", -1)),
+      port_(GetSingleArgument<int>("port", 0)),
+      initRange_(GetSingleArgument<float>("init_range", 0)),
+      seed_(GetSingleArgument<int>("seed", 0)) {
+  CAFFE_ENFORCE_GE(numRows_, 0, "num_rows is a required argument");
+  CAFFE_ENFORCE_GT(dim_, 0, "dim is a required argument");
+}
+
+bool EmbeddingShardServeOp::RunOnDevice() {
+  auto shard =
+      std::make_shared<EmbeddingShard>(numRows_, dim_, initRange_, seed_);
+  auto server = std::unique_ptr<EmbeddingShardServer>(
+      new EmbeddingShardServer(shard, port_));
+  if (OutputSize() > PORT) {
+    auto* port = Output(PORT);
+    port->Resize(std::vector<TIndex>());
+    *port->mutable_data<int>() = server->port();
+  }
+  *OperatorBase::Output<std::unique_ptr<EmbeddingShardServer>>(SERVER) =
+      std::move(server);
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(EmbeddingShardServe, EmbeddingShardServeOp);
+OPERATOR_SCHEMA(EmbeddingShardServe)
+    .NumInputs(0)
+    .NumOutputs(1, 2)
+    .SetDoc(R"DOC(
+Serves a shard of an embedding table of float rows over TCP, until the server
+blob is destroyed. The rows of the shard are the rows
+shard_id + k * num_shards of the table, that ShardedEmbedding ops access.
+)DOC")
+    .Arg("num_rows", "number of rows of the shard")
+    .Arg("dim", "number of elements of a row")
+    .Arg("port", "port to listen on, or 0 for any free port (default 0)")
+    .Arg(
+        "init_range",
+        "the rows are initialized uniformly in [-init_range, init_range] "
+        "(default 0)")
+    .Arg("seed", "seed of the initialization (default 0)")
+    .Output(0, "server", "unique_ptr<EmbeddingShardServer>")
+    .Output(1, "port", "the port listened on, int (optional)");
+
+NO_GRADIENT(EmbeddingShardServe);
+
+CreateShardedEmbeddingOp::CreateShardedEmbeddingOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws),
+      shards_(GetRepeatedArgument<std::string>("shards")),
+      dim_(GetSingleArgument<int64_t>("dim", -1)),
+      cacheSize_(GetSingleArgument<int64_t>("cache_size", 0)),
+      maxStaleness_(GetSingleArgument<int64_t>("max_staleness", 0)),
+      timeoutMs_(GetSingleArgument<int>(
+          "timeout",
+          StoreHandler::kDefaultTimeout.count())) {
+  CAFFE_ENFORCE(!shards_.empty(), "shards is a required argument");
+  CAFFE_ENFORCE_GT(dim_, 0, "dim is a required argument");
+  CAFFE_ENFORCE_GE(cacheSize_, 0);
+}
+
+bool CreateShardedEmbeddingOp::RunOnDevice() {
+  *OperatorBase::Output<std::unique_ptr<ShardedEmbedding>>(HANDLER) =
+      std::unique_ptr<ShardedEmbedding>(new ShardedEmbedding(
+          shards_,
+          dim_,
+          cacheSize_,
+          maxStaleness_,
+          std::chrono::milliseconds(timeoutMs_)));
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(CreateShardedEmbedding, CreateShardedEmbeddingOp);
+OPERATOR_SCHEMA(CreateShardedEmbedding)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Connects to the shards of an embedding table served by EmbeddingShardServe.
+Row id of the table is row id / num_shards of the shard id % num_shards.
+
+Up to cache_size rows are cached locally. A gather is an iteration, and a
+cached row is used for up to max_staleness iterations after it was fetched,
+so lookups may miss the updates of the other processes of that many
+iterations at most. The updates of this process are applied to its cache.
+)DOC")
+    .Arg("shards", "addresses of the shards, as host:port, in shard order")
+    .Arg("dim", "number of elements of a row")
+    .Arg("cache_size", "number of rows cached locally (default 0)")
+    .Arg(
+        "max_staleness",
+        "number of iterations a cached row is used for (default 0)")
+    .Arg("timeout", "timeout to connect to the shards in ms (default 30000)")
+    .Output(0, "handler", "unique_ptr<ShardedEmbedding>");
+
+NO_GRADIENT(CreateShardedEmbedding);
+
+ShardedEmbeddingAsyncOp::ShardedEmbeddingAsyncOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws),
+      async_(GetSingleArgument<bool>("async", false)) {
+  if (async_) {
+    worker_.reset(new TaskThreadPool(1));
+  }
+}
+
+ShardedEmbeddingAsyncOp::~ShardedEmbeddingAsyncOp() {
+  waitPrevious();
+}
+
+void ShardedEmbeddingAsyncOp::waitPrevious() {
+  if (worker_) {
+    worker_->waitWorkComplete();
+  }
+}
+
+bool ShardedEmbeddingAsyncOp::runMaybeAsync(std::function<void()> fn) {
+  // Without an event (e.g. in the middle of a chain of operators), nobody
+  // would wait for the requests, so they are run inline
+  if (!async_ || IsEventDisabled()) {
+    fn();
+    return true;
+  }
+  worker_->run([this, fn] {
+    std::string err_msg;
+    try {
+      fn();
+    } catch (const std::exception& e) {
+      err_msg = e.what();
+    }
+    try {
+      SetEventFinished(err_msg.empty() ? nullptr : err_msg.c_str());
+    } catch (const EnforceNotMet&) {
+      // The event was already set finished, e.g. cancelled by the net
+    }
+  });
+  return true;
+}
+
+std::vector<int64_t> ShardedEmbeddingAsyncOp::getIds(const TensorCPU& ids) {
+  if (ids.IsType<int64_t>()) {
+    return std::vector<int64_t>(
+        ids.data<int64_t>(), ids.data<int64_t>() + ids.size());
+  }
+  CAFFE_ENFORCE(ids.IsType<int>(), "ids must be int32 or int64");
+  return std::vector<int64_t>(ids.data<int>(), ids.data<int>() + ids.size());
+}
+
+bool ShardedEmbeddingGatherOp::RunOnDevice() {
+  waitPrevious();
+  auto* embedding =
+      OperatorBase::Input<std::unique_ptr<ShardedEmbedding>>(HANDLER).get();
+  auto ids = getIds(Input(IDS));
+
+  auto* output = Output(DATA);
+  auto dims = Input(IDS).dims();
+  dims.push_back(embedding->dim());
+  output->Resize(dims);
+  auto* out = output->mutable_data<float>();
+
+  return runMaybeAsync([embedding, ids, out] {
+    embedding->gather(ids.data(), ids.size(), out);
+  });
+}
+
+REGISTER_CPU_OPERATOR(ShardedEmbeddingGather, ShardedEmbeddingGatherOp);
+OPERATOR_SCHEMA(ShardedEmbeddingGather)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Gathers rows of a sharded embedding table, with one request per shard issued
+to all the shards in parallel. The output can be fed to the Lengths* reducers
+in place of the output of Gather on a local table.
+)DOC")
+    .Arg(
+        "async",
+        "(bool, default false) run the requests in the background; only async "
+        "nets (e.g. async_scheduling) wait for them")
+    .Input(0, "handler", "unique_ptr<ShardedEmbedding>")
+    .Input(1, "ids", "int32 or int64 tensor of row ids")
+    .Output(0, "data", "the rows, of shape ids.shape + [dim]");
+
+NO_GRADIENT(ShardedEmbeddingGather);
+
+ShardedEmbeddingScatterAddOp::ShardedEmbeddingScatterAddOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : ShardedEmbeddingAsyncOp(operator_def, ws),
+      scale_(GetSingleArgument<float>("scale", 1)) {}
+
+bool ShardedEmbeddingScatterAddOp::RunOnDevice() {
+  waitPrevious();
+  auto* embedding =
+      OperatorBase::Input<std::unique_ptr<ShardedEmbedding>>(HANDLER).get();
+  auto ids = getIds(Input(IDS));
+  const auto& values = Input(VALUES);
+  CAFFE_ENFORCE_EQ(
+      values.size(),
+      static_cast<TIndex>(ids.size()) * embedding->dim(),
+      "values must hold a row per id");
+
+  // The values are copied in async mode, since nothing keeps the net from
+  // overwriting them before the requests are done
+  const float scale = scale_;
+  if (!async_) {
+    embedding->scatterAdd(
+        ids.data(), ids.size(), values.data<float>(), scale);
+    return true;
+  }
+  std::vector<float> data(
+      values.data<float>(), values.data<float>() + values.size());
+  return runMaybeAsync([embedding, ids, data, scale] {
+    embedding->scatterAdd(ids.data(), ids.size(), data.data(), scale);
+  });
+}
+
+REGISTER_CPU_OPERATOR(
+    ShardedEmbeddingScatterAdd,
+    ShardedEmbeddingScatterAddOp);
+OPERATOR_SCHEMA(ShardedEmbeddingScatterAdd)
+    .NumInputs(3)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Adds scale * values to rows of a sharded embedding table, e.g. the sparse
+gradients of the rows with scale = -learning rate. Rows repeated in ids are
+added up.
+)DOC")
+    .Arg("scale", "(float, default 1) scale of the values")
+    .Arg(
+        "async",
+        "(bool, default false) run the requests in the background; only async "
+        "nets (e.g. async_scheduling) wait for them")
+    .Input(0, "handler", "unique_ptr<ShardedEmbedding>")
+    .Input(1, "ids", "int32 or int64 tensor of row ids")
+    .Input(2, "values", "float tensor of a row per id");
+
+NO_GRADIENT(ShardedEmbeddingScatterAdd);
+
+} // namespace caffe2
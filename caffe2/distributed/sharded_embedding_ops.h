@@ -0,0 +1,91 @@
+#pragma once
+
+#include "sharded_embedding.h"
+
+#include <functional>
+
+#include <caffe2/core/operator.h>
+#include <caffe2/utils/thread_pool.h>
+
+namespace caffe2 {
+
+class EmbeddingShardServeOp final : public Operator<CPUContext> {
+ public:
+  EmbeddingShardServeOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+ private:
+  int64_t numRows_;
+  int64_t dim_;
+  int port_;
+  float initRange_;
+  int seed_;
+
+  OUTPUT_TAGS(SERVER, PORT);
+};
+
+class CreateShardedEmbeddingOp final : public Operator<CPUContext> {
+ public:
+  CreateShardedEmbeddingOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+ private:
+  std::vector<std::string> shards_;
+  int64_t dim_;
+  int64_t cacheSize_;
+  int64_t maxStaleness_;
+  int timeoutMs_;
+
+  OUTPUT_TAGS(HANDLER);
+};
+
+/*
+ * With async=1, the requests of the operator run on a worker of its own, and
+ * the operator completes through its event, so that async nets can run dense
+ * compute in the meantime.
+ */
+class ShardedEmbeddingAsyncOp : public Operator<CPUContext> {
+ public:
+  ShardedEmbeddingAsyncOp(const OperatorDef& operator_def, Workspace* ws);
+  ~ShardedEmbeddingAsyncOp() override;
+
+  bool HasAsyncPart() const override {
+    return async_;
+  }
+
+ protected:
+  // Waits for the requests of the previous run.
+  void waitPrevious();
+
+  // Runs fn inline, or on the worker in async mode.
+  bool runMaybeAsync(std::function<void()> fn);
+
+  static std::vector<int64_t> getIds(const TensorCPU& ids);
+
+  const bool async_;
+  std::unique_ptr<TaskThreadPool> worker_;
+};
+
+class ShardedEmbeddingGatherOp final : public ShardedEmbeddingAsyncOp {
+ public:
+  ShardedEmbeddingGatherOp(const OperatorDef& operator_def, Workspace* ws)
+      : ShardedEmbeddingAsyncOp(operator_def, ws) {}
+  bool RunOnDevice() override;
+
+ private:
+  INPUT_TAGS(HANDLER, IDS);
+  OUTPUT_TAGS(DATA);
+};
+
+class ShardedEmbeddingScatterAddOp final : public ShardedEmbeddingAsyncOp {
+ public:
+  ShardedEmbeddingScatterAddOp(const OperatorDef& operator_def, Workspace* ws);
+  bool RunOnDevice() override;
+
+ private:
+  float scale_;
+
+  INPUT_TAGS(HANDLER, IDS, VALUES);
+};
+
+} // namespace caffe2
@@ -0,0 +1,108 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+
+from caffe2.python import core, workspace, dyndep
+from caffe2.python.test_util import TestCase
+
+dyndep.InitOpsLibrary("@/caffe2/caffe2/distributed:sharded_embedding_ops")
+
+
+class TestShardedEmbeddingOps(TestCase):
+    num_shards = 2
+    rows_per_shard = 5
+    dim = 3
+
+    def create_embedding(self, **kwargs):
+        shards = []
+        for i in range(self.num_shards):
+            server = "server_{}".format(i)
+            port = "port_{}".format(i)
+            workspace.RunOperatorOnce(
+                core.CreateOperator(
+                    "EmbeddingShardServe",
+                    [],
+                    [server, port],
+                    num_rows=self.rows_per_shard,
+                    dim=self.dim))
+            shards.append("localhost:{}".format(workspace.FetchBlob(port)))
+
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "CreateShardedEmbedding",
+                [],
+                ["embedding"],
+                shards=shards,
+                dim=self.dim,
+                **kwargs))
+        return "embedding"
+
+    def scatter_add(self, embedding, ids, values, scale):
+        workspace.FeedBlob("ids", ids)
+        workspace.FeedBlob("values", values)
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "ShardedEmbeddingScatterAdd",
+                [embedding, "ids", "values"],
+                [],
+                scale=scale))
+
+    def gather(self, embedding, ids):
+        workspace.FeedBlob("ids", ids)
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "ShardedEmbeddingGather",
+                [embedding, "ids"],
+                ["rows"]))
+        return workspace.FetchBlob("rows")
+
+    def test_gather_scatter_add(self):
+        embedding = self.create_embedding()
+        num_rows = self.num_shards * self.rows_per_shard
+        table = np.zeros((num_rows, self.dim), dtype=np.float32)
+
+        ids = np.array([0, 3, 3, 9, 4], dtype=np.int64)
+        values = np.random.rand(len(ids), self.dim).astype(np.float32)
+        self.scatter_add(embedding, ids, values, -0.5)
+        np.add.at(table, ids, -0.5 * values)
+
+        ids = np.array([[9, 1], [3, 0]], dtype=np.int32)
+        np.testing.assert_allclose(
+            self.gather(embedding, ids), table[ids], rtol=1e-6)
+
+    def test_cache_staleness(self):
+        embedding = self.create_embedding(cache_size=4, max_staleness=1)
+        other = "other"
+        workspace.RunOperatorOnce(
+            core.CreateOperator(
+                "CreateShardedEmbedding",
+                [],
+                [other],
+                shards=[
+                    "localhost:{}".format(
+                        workspace.FetchBlob("port_{}".format(i)))
+                    for i in range(self.num_shards)
+                ],
+                dim=self.dim))
+        ids = np.array([2, 7], dtype=np.int64)
+        ones = np.ones((len(ids), self.dim), dtype=np.float32)
+
+        np.testing.assert_array_equal(self.gather(embedding, ids), 0 * ones)
+
+        # The update of another process is missed by the cached rows for
+        # max_staleness iterations, while the updates of this process aren't
+        self.scatter_add(other, ids, ones, 1.0)
+        self.scatter_add(embedding, ids, ones, 2.0)
+        np.testing.assert_array_equal(self.gather(embedding, ids), 2 * ones)
+        np.testing.assert_array_equal(self.gather(embedding, ids), 3 * ones)
+
+    def test_invalid_row(self):
+        embedding = self.create_embedding()
+        with self.assertRaises(RuntimeError):
+            self.gather(
+                embedding,
+                np.array([self.num_shards * self.rows_per_shard],
+                         dtype=np.int64))
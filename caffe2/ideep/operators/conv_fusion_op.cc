@@ -79,21 +79,18 @@ class IDEEPConvFusionOp final : public IDEEPConvPoolOpBase {
         (cached_weights_descriptor_ != filter.get_descriptor());
     if (weights_changed && !training_mode_) {
       cached_weights_descriptor_ = filter.get_descriptor();
-      filter_ = filter;
       auto expected_descriptor =
           ideep::convolution_forward::expected_weights_descriptor(
               filter.get_dims());
-      if (filter_.get_descriptor() != expected_descriptor) {
-        filter_.init<ideep::utils::allocator, ideep::convolution_forward>(
-            expected_descriptor);
-        ideep::reorder::compute(filter, filter_);
-      }
+      filter_ = IDEEPWeightCache::Instance()
+                    .GetReordered<ideep::convolution_forward>(
+                        filter, expected_descriptor);
     }
 
     if (InputSize() > last_input()) {
       ideep::convolution_forward::compute(
           X,
-          training_mode_ ? filter : filter_,
+          training_mode_ ? filter : *filter_,
           Input(BIAS_OR_INPUT_S),
           Y_dims_conv,
           *Y,
@@ -106,7 +103,7 @@ class IDEEPConvFusionOp final : public IDEEPConvPoolOpBase {
     } else {
       ideep::convolution_forward::compute(
           X,
-          training_mode_ ? filter : filter_,
+          training_mode_ ? filter : *filter_,
           Y_dims_conv,
           *Y,
           stride_,
@@ -130,7 +127,7 @@ class IDEEPConvFusionOp final : public IDEEPConvPoolOpBase {
   FusionType fusion_type_;
 
   bool training_mode_;
-  ideep::tensor filter_;
+  std::shared_ptr<const ideep::tensor> filter_;
   ideep::tensor::descriptor cached_weights_descriptor_;
 
   INPUT_TAGS(INPUT_X, FILTER, BIAS_OR_INPUT_S, INPUT_S);
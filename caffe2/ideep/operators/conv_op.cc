@@ -51,9 +51,9 @@ class IDEEPConvOp final : public IDEEPConvPoolOpBase {
               pad_br(),
               dilation_,
               group_);
-      filter_.init<ideep::utils::allocator, ideep::convolution_forward>(
-          expected_descriptor);
-      ideep::reorder::compute(filter_in, filter_);
+      filter_ = IDEEPWeightCache::Instance()
+                    .GetReordered<ideep::convolution_forward>(
+                        filter_in, expected_descriptor);
     }
 
     // NB: actually, in the case when `group_ > 1`, IDEEP will create
@@ -65,7 +65,7 @@ class IDEEPConvOp final : public IDEEPConvPoolOpBase {
     if (InputSize() > BIAS) {
       ideep::convolution_forward::compute(
           X,
-          training_mode_ ? filter : filter_,
+          training_mode_ ? filter : *filter_,
           Input(BIAS),
           Y_dims,
           *Y,
@@ -77,7 +77,7 @@ class IDEEPConvOp final : public IDEEPConvPoolOpBase {
     } else {
       ideep::convolution_forward::compute(
           X,
-          training_mode_ ? filter : filter_,
+          training_mode_ ? filter : *filter_,
           Y_dims,
           *Y,
           stride_,
@@ -95,7 +95,8 @@ class IDEEPConvOp final : public IDEEPConvPoolOpBase {
   OUTPUT_TAGS(OUTPUT);
 
   bool training_mode_;
-  ideep::tensor filter_;
+  // Reordered weights, shared with the other operators using the same blob
+  std::shared_ptr<const ideep::tensor> filter_;
   ideep::tensor::descriptor cached_weights_descriptor_;
 };
 
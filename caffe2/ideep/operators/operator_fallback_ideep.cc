@@ -26,6 +26,21 @@
 
 // can add more non-IDEEP operators if needed
 namespace caffe2 {
+
+static std::set<string>& MutableIDEEPFallbackOperatorTypes() {
+  static std::set<string> types;
+  return types;
+}
+
+const std::set<string>& IDEEPFallbackOperatorTypes() {
+  return MutableIDEEPFallbackOperatorTypes();
+}
+
+IDEEPFallbackOperatorRegisterer::IDEEPFallbackOperatorRegisterer(
+    const string& type) {
+  MutableIDEEPFallbackOperatorTypes().insert(type);
+}
+
 namespace {
 
 struct SigmoidCPUFunctor {
@@ -40,75 +55,75 @@ struct SigmoidCPUFunctor {
 
 } // namespace
 
-REGISTER_IDEEP_OPERATOR(Softmax, IDEEPFallbackOp<SoftmaxOp<float, CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(Softmax, IDEEPFallbackOp<SoftmaxOp<float, CPUContext>>);
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     ChannelShuffle,
     IDEEPFallbackOp<ChannelShuffleOp<CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     LabelCrossEntropy,
     IDEEPFallbackOp<LabelCrossEntropyOp<float, CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     AveragedLoss,
     IDEEPFallbackOp<AveragedLoss<float, CPUContext>, SkipIndices<0>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     ConvTranspose,
     IDEEPFallbackOp<ConvTransposeOp<float, CPUContext>>);
-REGISTER_IDEEP_OPERATOR(Flatten, IDEEPFallbackOp<FlattenOp<CPUContext>>);
-REGISTER_IDEEP_OPERATOR(ResizeLike, IDEEPFallbackOp<ResizeLikeOp<CPUContext>>);
-REGISTER_IDEEP_OPERATOR(Transpose, IDEEPFallbackOp<TransposeOp<CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(Flatten, IDEEPFallbackOp<FlattenOp<CPUContext>>);
+REGISTER_IDEEP_FALLBACK_OPERATOR(ResizeLike, IDEEPFallbackOp<ResizeLikeOp<CPUContext>>);
+REGISTER_IDEEP_FALLBACK_OPERATOR(Transpose, IDEEPFallbackOp<TransposeOp<CPUContext>>);
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     Reshape,
     IDEEPFallbackOp<ReshapeOp<float, CPUContext>, SkipIndices<1>>);
 
 // filter operators
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     XavierFill,
     IDEEPFallbackOp<XavierFillOp<float, CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     ConstantFill,
     IDEEPFallbackOp<ConstantFillOp<CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     GaussianFill,
     IDEEPFallbackOp<GaussianFillOp<float, CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     MSRAFill,
     IDEEPFallbackOp<MSRAFillOp<float, CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     GivenTensorFill,
     IDEEPFallbackOp<GivenTensorFillOp<float, CPUContext>>);
-REGISTER_IDEEP_OPERATOR(Load, IDEEPFallbackOp<LoadOp<CPUContext>>);
-REGISTER_IDEEP_OPERATOR(Save, IDEEPFallbackOp<SaveOp<CPUContext>>);
+REGISTER_IDEEP_FALLBACK_OPERATOR(Load, IDEEPFallbackOp<LoadOp<CPUContext>>);
+REGISTER_IDEEP_FALLBACK_OPERATOR(Save, IDEEPFallbackOp<SaveOp<CPUContext>>);
 
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     Sigmoid,
     IDEEPFallbackOp<
         UnaryElementwiseOp<TensorTypes<float>, CPUContext, SigmoidCPUFunctor>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     RoIAlign,
     IDEEPFallbackOp<RoIAlignOp<float, CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     RoIAlignRotated,
     IDEEPFallbackOp<RoIAlignRotatedOp<float, CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     GenerateProposals,
     IDEEPFallbackOp<GenerateProposalsOp<CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     GenerateProposalsCPP,
     IDEEPFallbackOp<GenerateProposalsOp<CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     CollectAndDistributeFpnRpnProposals,
     IDEEPFallbackOp<CollectAndDistributeFpnRpnProposalsOp<CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     BoxWithNMSLimit,
     IDEEPFallbackOp<BoxWithNMSLimitOp<CPUContext>, SkipIndices<0,1,2>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     BBoxTransform,
     IDEEPFallbackOp<BBoxTransformOp<float, CPUContext>>);
 
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     PadImage,
     IDEEPFallbackOp<PadImageOp<float, CPUContext>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     PRelu,
     IDEEPFallbackOp<PReluOp<float, CPUContext>>);
 
@@ -6,8 +6,25 @@
 #include <caffe2/ideep/ideep_utils.h>
 #include <caffe2/proto/caffe2.pb.h>
 
+#include <set>
+
 namespace caffe2 {
 
+// The types of the operators registered with REGISTER_IDEEP_FALLBACK_OPERATOR.
+// Graph passes use them to plan the reorders between the IDEEP and CPU layouts,
+// see PlanFallbackReordersForIdeep.
+const std::set<string>& IDEEPFallbackOperatorTypes();
+
+class IDEEPFallbackOperatorRegisterer {
+ public:
+  explicit IDEEPFallbackOperatorRegisterer(const string& type);
+};
+
+#define REGISTER_IDEEP_FALLBACK_OPERATOR(name, ...) \
+  REGISTER_IDEEP_OPERATOR(name, __VA_ARGS__);       \
+  static IDEEPFallbackOperatorRegisterer            \
+      g_ideep_fallback_operator_##name(#name)
+
 /**
  * @brief A templated class to allow one to wrap a CPU operator as an IDEEP
  * operator.
@@ -25,14 +42,18 @@ namespace caffe2 {
  *     REGISTER_CPU_OPERATOR(MyMagic, MyMagicOp);
  * to register the CPU side, you can create its corresponding IDEEP operator
  * (with performance hits of course) via
- *     REGISTER_IDEEP_OPERATOR(MyMagic,
- *                            IDEEPFallbackOp<MyMagicOp>);
+ *     REGISTER_IDEEP_FALLBACK_OPERATOR(MyMagic,
+ *                                     IDEEPFallbackOp<MyMagicOp>);
+ *
+ * Inputs that are ideep::tensor in a non-public format are reordered to the
+ * plain layout at every run, while inputs that already are TensorCPU are used
+ * as they are.
  *
  * Advanced usage: if you want to have some specific outputs never copied, you
  * can use the SkipOutputCopy template argument to do that. For example, if
  * MyMagic produces two outputs and the first output is always going to live on
  * the CPU, you can do
- *     REGISTER_IDEEP_OPERATOR(MyMagic,
+ *     REGISTER_IDEEP_FALLBACK_OPERATOR(MyMagic,
  *                            IDEEPFallbackOp<MyMagicOp, SkipIndices<0>>);
  */
 template <class CPUOp, typename SkipOutputCopy = SkipIndices<>>
@@ -0,0 +1,10 @@
+#include <caffe2/ideep/utils/ideep_weight_cache.h>
+
+namespace caffe2 {
+
+IDEEPWeightCache& IDEEPWeightCache::Instance() {
+  static IDEEPWeightCache cache;
+  return cache;
+}
+
+} // namespace caffe2
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <ideep.hpp>
+#include <caffe2/core/common.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace caffe2 {
+
+// IDEEPWeightCache holds the weights of inference operators reordered to the
+// format their primitives expect, for the whole process. The operators that
+// reorder the same blob of weights the same way, e.g. the operators of several
+// Predictors sharing a workspace of parameters, share a single reordered copy
+// and only the first of them pays for the reorder.
+//
+// An entry lives as long as an operator holds the tensor it returned, and it
+// keeps the source tensor alive so that its buffer can not be reused for other
+// weights meanwhile. Like the operators caching their own reordered weights,
+// it assumes that weights are not modified in place during inference.
+class IDEEPWeightCache {
+ public:
+  static IDEEPWeightCache& Instance();
+
+  // Returns `weights` reordered to `expected`, or sharing the buffer of
+  // `weights` if they already are in that format.
+  template <typename computation_t>
+  std::shared_ptr<const ideep::tensor> GetReordered(
+      const ideep::tensor& weights,
+      const ideep::tensor::descriptor& expected) {
+    if (weights.get_descriptor() == expected) {
+      return std::make_shared<const ideep::tensor>(weights);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entries = entries_[weights.get_data_handle()];
+    for (auto it = entries.begin(); it != entries.end();) {
+      auto entry = it->lock();
+      if (!entry) {
+        it = entries.erase(it);
+        continue;
+      }
+      if (entry->source.get_descriptor() == weights.get_descriptor() &&
+          entry->reordered.get_descriptor() == expected) {
+        return std::shared_ptr<const ideep::tensor>(entry, &entry->reordered);
+      }
+      ++it;
+    }
+
+    auto entry = std::make_shared<Entry>();
+    entry->source = weights;
+    entry->reordered.init<ideep::utils::allocator, computation_t>(expected);
+    ideep::reorder::compute(weights, entry->reordered);
+    entries.push_back(entry);
+    return std::shared_ptr<const ideep::tensor>(entry, &entry->reordered);
+  }
+
+ private:
+  IDEEPWeightCache() {}
+
+  struct Entry {
+    ideep::tensor source;
+    ideep::tensor reordered;
+  };
+
+  std::mutex mutex_;
+  // By the data handle of the source weights
+  std::unordered_map<void*, std::vector<std::weak_ptr<Entry>>> entries_;
+};
+
+} // namespace caffe2
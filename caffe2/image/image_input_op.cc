@@ -86,8 +86,13 @@ The dimension of the output image will always be cropxcrop
     .Arg("use_caffe_datum", "1 if the input is in Caffe format. Defaults to 0")
     .Arg("use_gpu_transform", "1 if GPU acceleration should be used."
          " Defaults to 0. Can only be 1 in a CUDAContext")
+    .Arg("use_gpu_decode", "1 if the JPEG images should be decoded, cropped,"
+         " mirrored and resized on the GPU with nvJPEG. Defaults to 0."
+         " Requires use_gpu_transform, color images and a build with nvJPEG")
     .Arg("decode_threads", "Number of CPU decode/transform threads."
          " Defaults to 4")
+    .Arg("prefetch_depth", "Number of batches to prefetch ahead."
+         " Defaults to 1")
     .Arg("output_type", "If gpu_transform, can set to FLOAT or FLOAT16.")
     .Arg("db", "Name of the database (if not passed as input)")
     .Arg("db_type", "Type of database (if not passed as input)."
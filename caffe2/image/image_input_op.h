@@ -19,6 +19,7 @@
 namespace caffe2 {
 
 class CUDAContext;
+class NvJpegDecoder;
 
 template <class Context>
 class ImageInputOp final
@@ -74,15 +75,35 @@ class ImageInputOp final
     BoundingBox bounding_params;
   };
 
+  // The values are slices of the db records, when the db supports zero copy
+  // reads, or of copies that are kept alive until the batch is decoded.
   bool GetImageAndLabelAndInfoFromDBValue(
-      const string& value, cv::Mat* img, PerImageArg& info, int item_id,
+      const db::Slice& value, cv::Mat* img, PerImageArg& info, int item_id,
       std::mt19937* randgen);
   void DecodeAndTransform(
-      const std::string& value, float *image_data, int item_id,
+      const db::Slice& value, float *image_data, int item_id,
       const int channels, std::size_t thread_index);
   void DecodeAndTransposeOnly(
-      const std::string& value, uint8_t *image_data, int item_id,
+      const db::Slice& value, uint8_t *image_data, int item_id,
       const int channels, std::size_t thread_index);
+  // Parses the labels and the bounding box of a caffe2 format value.
+  void ParseLabelsAndInfo(
+      const TensorProtos& protos, PerImageArg& info, int item_id);
+  // Returns the size an image is scaled to before cropping, and false if it
+  // is not scaled.
+  bool GetScaledSize(
+      const int rows, const int cols, std::mt19937* randgen,
+      int* scaled_height, int* scaled_width);
+
+  // With use_gpu_decode, the decode threads only parse the values, and keep
+  // the encoded images. The images are then decoded by DecodeBatchOnGPU,
+  // which draws the same crops as the CPU path, and crops, mirrors and
+  // resizes them on the GPU into prefetched_image_on_device_.
+  void ParseForGPUDecode(const db::Slice& value, int item_id);
+  CropWindow GetCropWindow(
+      const int height, const int width, const PerImageArg& info,
+      std::mt19937* randgen);
+  void DecodeBatchOnGPU();
 
   unique_ptr<db::DBReader> owned_reader_;
   const db::DBReader* reader_;
@@ -124,8 +145,15 @@ class ImageInputOp final
   bool is_test_;
   bool use_caffe_datum_;
   bool gpu_transform_;
+  bool gpu_decode_;
   bool mean_std_copied_ = false;
 
+  // Encoded images of the batch and their info, with use_gpu_decode.
+  vector<string> encoded_images_;
+  vector<PerImageArg> encoded_image_info_;
+  // Created by the first batch, on the prefetch thread.
+  std::shared_ptr<NvJpegDecoder> nvjpeg_decoder_;
+
   // thread pool for parse + decode
   int num_decode_threads_;
   int additional_inputs_offset_;
@@ -195,6 +223,8 @@ ImageInputOp<Context>::ImageInputOp(
       gpu_transform_(OperatorBase::template GetSingleArgument<int>(
           "use_gpu_transform",
           0)),
+      gpu_decode_(
+          OperatorBase::template GetSingleArgument<int>("use_gpu_decode", 0)),
       num_decode_threads_(
           OperatorBase::template GetSingleArgument<int>("decode_threads", 4)),
       thread_pool_(std::make_shared<TaskThreadPool>(num_decode_threads_)),
@@ -300,6 +330,19 @@ ImageInputOp<Context>::ImageInputOp(
   CAFFE_ENFORCE_GE(random_scale_[1], random_scale_[0],
       "random scale must provide a range [min, max]");
 
+  if (gpu_decode_) {
+#ifndef CAFFE2_USE_NVJPEG
+    CAFFE_THROW("use_gpu_decode requires Caffe2 to be built with nvJPEG.");
+#endif
+    CAFFE_ENFORCE(
+        !std::is_same<Context, CPUContext>::value,
+        "use_gpu_decode is only supported on GPU");
+    CAFFE_ENFORCE(gpu_transform_, "use_gpu_decode requires use_gpu_transform");
+    CAFFE_ENFORCE(color_, "use_gpu_decode only supports color images");
+    encoded_images_.resize(batch_size_);
+    encoded_image_info_.resize(batch_size_);
+  }
+
   if (default_arg_.bounding_params.ymin < 0
       || default_arg_.bounding_params.xmin < 0
       || default_arg_.bounding_params.height < 0
@@ -320,6 +363,9 @@ ImageInputOp<Context>::ImageInputOp(
   if (gpu_transform_) {
     LOG(INFO) << "    Performing transformation on GPU";
   }
+  if (gpu_decode_) {
+    LOG(INFO) << "    Decoding images on GPU";
+  }
   LOG(INFO) << "    Outputting in batches of " << batch_size_ << " images;";
   LOG(INFO) << "    Treating input image as "
             << (color_ ? "color " : "grayscale ") << "image;";
@@ -390,21 +436,19 @@ ImageInputOp<Context>::ImageInputOp(
   }
 }
 
-// Inception-stype scale jittering
+// Finds the region of an Inception-style random crop, returns false if none
+// was found
 template <class Context>
-bool RandomSizedCropping(
-  cv::Mat* img,
-  const int crop,
-  std::mt19937* randgen
+bool RandomSizedCropRegion(
+  const int im_height,
+  const int im_width,
+  std::mt19937* randgen,
+  cv::Rect* roi
 ) {
-  cv::Mat scaled_img;
-  bool inception_scale_jitter = false;
-  int im_height = img->rows, im_width = img->cols;
   int area = im_height * im_width;
   std::uniform_real_distribution<> area_dis(0.08, 1.0);
   std::uniform_real_distribution<> aspect_ratio_dis(3.0 / 4.0, 4.0 / 3.0);
 
-  cv::Mat cropping;
   for (int i = 0; i < 10; ++i) {
     int target_area = int(ceil(area_dis(*randgen) * area));
     float aspect_ratio = aspect_ratio_dis(*randgen);
@@ -415,26 +459,202 @@ bool RandomSizedCropping(
         0, im_height - nh)(*randgen);
       int width_offset = std::uniform_int_distribution<>(
         0,im_width - nw)(*randgen);
-      cv::Rect ROI(width_offset, height_offset, nw, nh);
-      cropping = (*img)(ROI);
-      cv::resize(
-          cropping,
-          scaled_img,
-          cv::Size(crop, crop),
-          0,
-          0,
-          cv::INTER_AREA);
-      *img = scaled_img;
-      inception_scale_jitter = true;
-      break;
+      *roi = cv::Rect(width_offset, height_offset, nw, nh);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Inception-stype scale jittering
+template <class Context>
+bool RandomSizedCropping(
+  cv::Mat* img,
+  const int crop,
+  std::mt19937* randgen
+) {
+  cv::Mat scaled_img;
+  cv::Rect ROI;
+  if (!RandomSizedCropRegion<Context>(img->rows, img->cols, randgen, &ROI)) {
+    return false;
+  }
+  cv::Mat cropping = (*img)(ROI);
+  cv::resize(
+      cropping,
+      scaled_img,
+      cv::Size(crop, crop),
+      0,
+      0,
+      cv::INTER_AREA);
+  *img = scaled_img;
+  return true;
+}
+
+template <class Context>
+bool ImageInputOp<Context>::GetScaledSize(
+    const int rows,
+    const int cols,
+    std::mt19937* randgen,
+    int* scaled_height,
+    int* scaled_width) {
+  int scale_to_use = scale_ > 0 ? scale_ : minsize_;
+
+  // set the random minsize
+  if (random_scaling_) {
+    scale_to_use = std::uniform_int_distribution<>(random_scale_[0],
+                                                   random_scale_[1])(*randgen);
+  }
+
+  if (warp_) {
+    *scaled_width = scale_to_use;
+    *scaled_height = scale_to_use;
+  } else if (rows > cols) {
+    *scaled_width = scale_to_use;
+    *scaled_height = static_cast<float>(rows) * scale_to_use / cols;
+  } else {
+    *scaled_height = scale_to_use;
+    *scaled_width = static_cast<float>(cols) * scale_to_use / rows;
+  }
+  if ((scale_ > 0 && (*scaled_height != rows || *scaled_width != cols))
+      || (*scaled_height > rows || *scaled_width > cols)) {
+    // We rescale in all cases if we are using scale_
+    // but only to make the image bigger if using minsize_
+    return true;
+  }
+  *scaled_height = rows;
+  *scaled_width = cols;
+  return false;
+}
+
+template <class Context>
+void ImageInputOp<Context>::ParseLabelsAndInfo(
+    const TensorProtos& protos,
+    PerImageArg& info,
+    int item_id) {
+  const TensorProto& label_proto = protos.protos(1);
+  // add handle protos
+  vector<TensorProto> additional_output_protos;
+  int start = additional_inputs_offset_;
+  int end = start + additional_inputs_count_;
+  for (int i = start; i < end; ++i) {
+    additional_output_protos.push_back(protos.protos(i));
+  }
+
+  if (protos.protos_size() == end + 1) {
+    // We have bounding box information
+    const TensorProto& bounding_proto = protos.protos(end);
+    DCHECK_EQ(bounding_proto.data_type(), TensorProto::INT32);
+    DCHECK_EQ(bounding_proto.int32_data_size(), 4);
+    info.bounding_params.valid = true;
+    info.bounding_params.ymin = bounding_proto.int32_data(0);
+    info.bounding_params.xmin = bounding_proto.int32_data(1);
+    info.bounding_params.height = bounding_proto.int32_data(2);
+    info.bounding_params.width = bounding_proto.int32_data(3);
+  }
+
+  // TODO: if image decoding was unsuccessful, set label to 0
+  if (label_proto.data_type() == TensorProto::FLOAT) {
+    if (label_type_ == SINGLE_LABEL || label_type_ == SINGLE_LABEL_WEIGHTED) {
+      DCHECK_EQ(label_proto.float_data_size(), 1);
+      prefetched_label_.mutable_data<float>()[item_id] =
+          label_proto.float_data(0);
+    } else if (label_type_ == MULTI_LABEL_SPARSE) {
+      float* label_data = prefetched_label_.mutable_data<float>() +
+        item_id * num_labels_;
+      memset(label_data, 0, sizeof(float) * num_labels_);
+      for (int i = 0; i < label_proto.float_data_size(); ++i) {
+        label_data[(int)label_proto.float_data(i)] = 1.0;
+      }
+    } else if (label_type_ == MULTI_LABEL_WEIGHTED_SPARSE) {
+      const TensorProto& weight_proto = protos.protos(2);
+      float* label_data =
+          prefetched_label_.mutable_data<float>() + item_id * num_labels_;
+      memset(label_data, 0, sizeof(float) * num_labels_);
+      for (int i = 0; i < label_proto.float_data_size(); ++i) {
+        label_data[(int)label_proto.float_data(i)] =
+            weight_proto.float_data(i);
+      }
+    } else if (label_type_ == MULTI_LABEL_DENSE) {
+      CAFFE_ENFORCE(label_proto.float_data_size() == num_labels_);
+      float* label_data = prefetched_label_.mutable_data<float>() +
+        item_id * num_labels_;
+      for (int i = 0; i < label_proto.float_data_size(); ++i) {
+        label_data[i] = label_proto.float_data(i);
+      }
+    } else {
+      LOG(ERROR) << "Unknown label type:" << label_type_;
+    }
+  } else if (label_proto.data_type() == TensorProto::INT32) {
+    if (label_type_ == SINGLE_LABEL || label_type_ == SINGLE_LABEL_WEIGHTED) {
+      DCHECK_EQ(label_proto.int32_data_size(), 1);
+      prefetched_label_.mutable_data<int>()[item_id] =
+          label_proto.int32_data(0);
+    } else if (label_type_ == MULTI_LABEL_SPARSE) {
+      int* label_data = prefetched_label_.mutable_data<int>() +
+        item_id * num_labels_;
+      memset(label_data, 0, sizeof(int) * num_labels_);
+      for (int i = 0; i < label_proto.int32_data_size(); ++i) {
+        label_data[label_proto.int32_data(i)] = 1;
+      }
+    } else if (label_type_ == MULTI_LABEL_WEIGHTED_SPARSE) {
+      const TensorProto& weight_proto = protos.protos(2);
+      float* label_data =
+          prefetched_label_.mutable_data<float>() + item_id * num_labels_;
+      memset(label_data, 0, sizeof(float) * num_labels_);
+      for (int i = 0; i < label_proto.int32_data_size(); ++i) {
+        label_data[label_proto.int32_data(i)] = weight_proto.float_data(i);
+      }
+    } else if (label_type_ == MULTI_LABEL_DENSE) {
+      CAFFE_ENFORCE(label_proto.int32_data_size() == num_labels_);
+      int* label_data = prefetched_label_.mutable_data<int>() +
+        item_id * num_labels_;
+      for (int i = 0; i < label_proto.int32_data_size(); ++i) {
+        label_data[i] = label_proto.int32_data(i);
+      }
+    } else {
+      LOG(ERROR) << "Unknown label type:" << label_type_;
+    }
+  } else {
+    LOG(FATAL) << "Unsupported label data type.";
+  }
+
+  for (int i = 0; i < additional_output_protos.size(); ++i) {
+    auto additional_output_proto = additional_output_protos[i];
+
+    if (additional_output_proto.data_type() == TensorProto::FLOAT) {
+      float* additional_output =
+          prefetched_additional_outputs_[i].template mutable_data<float>() +
+          item_id * additional_output_proto.float_data_size();
+
+      for (int j = 0; j < additional_output_proto.float_data_size(); ++j) {
+        additional_output[j] = additional_output_proto.float_data(j);
+      }
+    } else if (additional_output_proto.data_type() == TensorProto::INT32) {
+      int* additional_output =
+          prefetched_additional_outputs_[i].template mutable_data<int>() +
+          item_id * additional_output_proto.int32_data_size();
+
+      for (int j = 0; j < additional_output_proto.int32_data_size(); ++j) {
+        additional_output[j] = additional_output_proto.int32_data(j);
+      }
+    } else if (additional_output_proto.data_type() == TensorProto::INT64) {
+      int64_t* additional_output =
+          prefetched_additional_outputs_[i].template mutable_data<int64_t>() +
+          item_id * additional_output_proto.int64_data_size();
+
+      for (int j = 0; j < additional_output_proto.int64_data_size(); ++j) {
+        additional_output[j] = additional_output_proto.int64_data(j);
+      }
+    }
+    else {
+      LOG(FATAL) << "Unsupported output type.";
     }
   }
-  return inception_scale_jitter;
 }
 
 template <class Context>
 bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
-    const string& value,
+    const db::Slice& value,
     cv::Mat* img,
     PerImageArg& info,
     int item_id,
@@ -451,7 +671,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
   if (use_caffe_datum_) {
     // The input is a caffe datum format.
     caffe::Datum datum;
-    CAFFE_ENFORCE(datum.ParseFromString(value));
+    CAFFE_ENFORCE(datum.ParseFromArray(value.data, value.size));
 
     prefetched_label_.mutable_data<int>()[item_id] = datum.label();
     if (datum.encoded()) {
@@ -502,28 +722,9 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
   } else {
     // The input is a caffe2 format.
     TensorProtos protos;
-    CAFFE_ENFORCE(protos.ParseFromString(value));
+    CAFFE_ENFORCE(protos.ParseFromArray(value.data, value.size));
     const TensorProto& image_proto = protos.protos(0);
-    const TensorProto& label_proto = protos.protos(1);
-    // add handle protos
-    vector<TensorProto> additional_output_protos;
-    int start = additional_inputs_offset_;
-    int end = start + additional_inputs_count_;
-    for (int i = start; i < end; ++i) {
-      additional_output_protos.push_back(protos.protos(i));
-    }
-
-    if (protos.protos_size() == end + 1) {
-      // We have bounding box information
-      const TensorProto& bounding_proto = protos.protos(end);
-      DCHECK_EQ(bounding_proto.data_type(), TensorProto::INT32);
-      DCHECK_EQ(bounding_proto.int32_data_size(), 4);
-      info.bounding_params.valid = true;
-      info.bounding_params.ymin = bounding_proto.int32_data(0);
-      info.bounding_params.xmin = bounding_proto.int32_data(1);
-      info.bounding_params.height = bounding_proto.int32_data(2);
-      info.bounding_params.width = bounding_proto.int32_data(3);
-    }
+    ParseLabelsAndInfo(protos, info, item_id);
 
     if (image_proto.data_type() == TensorProto::STRING) {
       // encoded image string.
@@ -564,105 +765,6 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
     } else {
       LOG(FATAL) << "Unknown image data type.";
     }
-
-    // TODO: if image decoding was unsuccessful, set label to 0
-    if (label_proto.data_type() == TensorProto::FLOAT) {
-      if (label_type_ == SINGLE_LABEL || label_type_ == SINGLE_LABEL_WEIGHTED) {
-        DCHECK_EQ(label_proto.float_data_size(), 1);
-        prefetched_label_.mutable_data<float>()[item_id] =
-            label_proto.float_data(0);
-      } else if (label_type_ == MULTI_LABEL_SPARSE) {
-        float* label_data = prefetched_label_.mutable_data<float>() +
-          item_id * num_labels_;
-        memset(label_data, 0, sizeof(float) * num_labels_);
-        for (int i = 0; i < label_proto.float_data_size(); ++i) {
-          label_data[(int)label_proto.float_data(i)] = 1.0;
-        }
-      } else if (label_type_ == MULTI_LABEL_WEIGHTED_SPARSE) {
-        const TensorProto& weight_proto = protos.protos(2);
-        float* label_data =
-            prefetched_label_.mutable_data<float>() + item_id * num_labels_;
-        memset(label_data, 0, sizeof(float) * num_labels_);
-        for (int i = 0; i < label_proto.float_data_size(); ++i) {
-          label_data[(int)label_proto.float_data(i)] =
-              weight_proto.float_data(i);
-        }
-      } else if (label_type_ == MULTI_LABEL_DENSE) {
-        CAFFE_ENFORCE(label_proto.float_data_size() == num_labels_);
-        float* label_data = prefetched_label_.mutable_data<float>() +
-          item_id * num_labels_;
-        for (int i = 0; i < label_proto.float_data_size(); ++i) {
-          label_data[i] = label_proto.float_data(i);
-        }
-      } else {
-        LOG(ERROR) << "Unknown label type:" << label_type_;
-      }
-    } else if (label_proto.data_type() == TensorProto::INT32) {
-      if (label_type_ == SINGLE_LABEL || label_type_ == SINGLE_LABEL_WEIGHTED) {
-        DCHECK_EQ(label_proto.int32_data_size(), 1);
-        prefetched_label_.mutable_data<int>()[item_id] =
-            label_proto.int32_data(0);
-      } else if (label_type_ == MULTI_LABEL_SPARSE) {
-        int* label_data = prefetched_label_.mutable_data<int>() +
-          item_id * num_labels_;
-        memset(label_data, 0, sizeof(int) * num_labels_);
-        for (int i = 0; i < label_proto.int32_data_size(); ++i) {
-          label_data[label_proto.int32_data(i)] = 1;
-        }
-      } else if (label_type_ == MULTI_LABEL_WEIGHTED_SPARSE) {
-        const TensorProto& weight_proto = protos.protos(2);
-        float* label_data =
-            prefetched_label_.mutable_data<float>() + item_id * num_labels_;
-        memset(label_data, 0, sizeof(float) * num_labels_);
-        for (int i = 0; i < label_proto.int32_data_size(); ++i) {
-          label_data[label_proto.int32_data(i)] = weight_proto.float_data(i);
-        }
-      } else if (label_type_ == MULTI_LABEL_DENSE) {
-        CAFFE_ENFORCE(label_proto.int32_data_size() == num_labels_);
-        int* label_data = prefetched_label_.mutable_data<int>() +
-          item_id * num_labels_;
-        for (int i = 0; i < label_proto.int32_data_size(); ++i) {
-          label_data[i] = label_proto.int32_data(i);
-        }
-      } else {
-        LOG(ERROR) << "Unknown label type:" << label_type_;
-      }
-    } else {
-      LOG(FATAL) << "Unsupported label data type.";
-    }
-
-    for (int i = 0; i < additional_output_protos.size(); ++i) {
-      auto additional_output_proto = additional_output_protos[i];
-
-      if (additional_output_proto.data_type() == TensorProto::FLOAT) {
-        float* additional_output =
-            prefetched_additional_outputs_[i].template mutable_data<float>() +
-            item_id * additional_output_proto.float_data_size();
-
-        for (int j = 0; j < additional_output_proto.float_data_size(); ++j) {
-          additional_output[j] = additional_output_proto.float_data(j);
-        }
-      } else if (additional_output_proto.data_type() == TensorProto::INT32) {
-        int* additional_output =
-            prefetched_additional_outputs_[i].template mutable_data<int>() +
-            item_id * additional_output_proto.int32_data_size();
-
-        for (int j = 0; j < additional_output_proto.int32_data_size(); ++j) {
-          additional_output[j] = additional_output_proto.int32_data(j);
-        }
-      } else if (additional_output_proto.data_type() == TensorProto::INT64) {
-        int64_t* additional_output =
-            prefetched_additional_outputs_[i].template mutable_data<int64_t>() +
-            item_id * additional_output_proto.int64_data_size();
-
-        for (int j = 0; j < additional_output_proto.int64_data_size(); ++j) {
-          additional_output[j] = additional_output_proto.int64_data(j);
-        }
-      }
-      else {
-        LOG(FATAL) << "Unsupported output type.";
-      }
-    }
   }
 
   //
@@ -719,31 +821,8 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
   if ((scale_jitter_type_ == NO_SCALE_JITTER) ||
     (scale_jitter_type_ == INCEPTION_STYLE && !inception_scale_jitter)) {
       int scaled_width, scaled_height;
-      int scale_to_use = scale_ > 0 ? scale_ : minsize_;
-
-      // set the random minsize
-      if (random_scaling_) {
-        scale_to_use = std::uniform_int_distribution<>(random_scale_[0],
-                                                       random_scale_[1])(*randgen);
-      }
-
-      if (warp_) {
-        scaled_width = scale_to_use;
-        scaled_height = scale_to_use;
-      } else if (img->rows > img->cols) {
-        scaled_width = scale_to_use;
-        scaled_height =
-            static_cast<float>(img->rows) * scale_to_use / img->cols;
-      } else {
-        scaled_height = scale_to_use;
-        scaled_width =
-            static_cast<float>(img->cols) * scale_to_use / img->rows;
-      }
-      if ((scale_ > 0 &&
-           (scaled_height != img->rows || scaled_width != img->cols))
-          || (scaled_height > img->rows || scaled_width > img->cols)) {
-        // We rescale in all cases if we are using scale_
-        // but only to make the image bigger if using minsize_
+      if (GetScaledSize(
+              img->rows, img->cols, randgen, &scaled_height, &scaled_width)) {
         /*
         LOG(INFO) << "Scaling to " << scaled_width << " x " << scaled_height
                   << " From " << img->cols << " x " << img->rows;
@@ -1050,7 +1129,7 @@ void CropTransposeImage(const cv::Mat& scaled_img, const int channels,
 // Intended as entry point for binding to thread pool
 template <class Context>
 void ImageInputOp<Context>::DecodeAndTransform(
-      const std::string& value, float *image_data, int item_id,
+      const db::Slice& value, float *image_data, int item_id,
       const int channels, std::size_t thread_index) {
 
   CAFFE_ENFORCE((int)thread_index < num_decode_threads_);
@@ -1073,7 +1152,7 @@ void ImageInputOp<Context>::DecodeAndTransform(
 
 template <class Context>
 void ImageInputOp<Context>::DecodeAndTransposeOnly(
-    const std::string& value, uint8_t *image_data, int item_id,
+    const db::Slice& value, uint8_t *image_data, int item_id,
     const int channels, std::size_t thread_index) {
 
   CAFFE_ENFORCE((int)thread_index < num_decode_threads_);
@@ -1092,6 +1171,101 @@ void ImageInputOp<Context>::DecodeAndTransposeOnly(
                               randgen, &mirror_this_image, is_test_);
 }
 
+template <class Context>
+void ImageInputOp<Context>::ParseForGPUDecode(
+    const db::Slice& value,
+    int item_id) {
+  string* encoded = &encoded_images_[item_id];
+  PerImageArg& info = encoded_image_info_[item_id];
+  info = default_arg_;
+  if (use_caffe_datum_) {
+    caffe::Datum datum;
+    CAFFE_ENFORCE(datum.ParseFromArray(value.data, value.size));
+    CAFFE_ENFORCE(
+        datum.encoded(), "use_gpu_decode only supports encoded images");
+    prefetched_label_.mutable_data<int>()[item_id] = datum.label();
+    encoded->assign(datum.data());
+  } else {
+    TensorProtos protos;
+    CAFFE_ENFORCE(protos.ParseFromArray(value.data, value.size));
+    const TensorProto& image_proto = protos.protos(0);
+    CAFFE_ENFORCE(
+        image_proto.data_type() == TensorProto::STRING,
+        "use_gpu_decode only supports encoded images");
+    DCHECK_EQ(image_proto.string_data_size(), 1);
+    ParseLabelsAndInfo(protos, info, item_id);
+    encoded->assign(image_proto.string_data(0));
+  }
+}
+
+// Same crops as GetImageAndLabelAndInfoFromDBValue and CropTransposeImage,
+// as a window of the decoded image.
+template <class Context>
+CropWindow ImageInputOp<Context>::GetCropWindow(
+    const int height,
+    const int width,
+    const PerImageArg& info,
+    std::mt19937* randgen) {
+  CropWindow window;
+  window.offset = 0;
+  window.height = height;
+  window.width = width;
+  window.valid = true;
+  std::bernoulli_distribution mirror_this_image(0.5f);
+
+  // Apply the bounding box if it is legit
+  int ymin = 0, xmin = 0, rows = height, cols = width;
+  if (info.bounding_params.valid &&
+      height >= info.bounding_params.ymin + info.bounding_params.height &&
+      width >= info.bounding_params.xmin + info.bounding_params.width) {
+    ymin = info.bounding_params.ymin;
+    xmin = info.bounding_params.xmin;
+    rows = info.bounding_params.height;
+    cols = info.bounding_params.width;
+  }
+
+  cv::Rect roi;
+  if (scale_jitter_type_ == INCEPTION_STYLE && !is_test_ &&
+      RandomSizedCropRegion<Context>(rows, cols, randgen, &roi)) {
+    window.y = ymin + roi.y;
+    window.x = xmin + roi.x;
+    window.crop_height = roi.height;
+    window.crop_width = roi.width;
+    window.mirror = mirror_ && mirror_this_image(*randgen);
+    return window;
+  }
+
+  int scaled_height, scaled_width;
+  GetScaledSize(rows, cols, randgen, &scaled_height, &scaled_width);
+  CAFFE_ENFORCE_GE(
+      scaled_height, crop_, "Image height must be bigger than crop.");
+  CAFFE_ENFORCE_GE(
+      scaled_width, crop_, "Image width must be bigger than crop.");
+  int width_offset, height_offset;
+  if (is_test_) {
+    width_offset = (scaled_width - crop_) / 2;
+    height_offset = (scaled_height - crop_) / 2;
+  } else {
+    width_offset =
+      std::uniform_int_distribution<>(0, scaled_width - crop_)(*randgen);
+    height_offset =
+      std::uniform_int_distribution<>(0, scaled_height - crop_)(*randgen);
+  }
+  const float scale_y = static_cast<float>(rows) / scaled_height;
+  const float scale_x = static_cast<float>(cols) / scaled_width;
+  window.y = ymin + height_offset * scale_y;
+  window.x = xmin + width_offset * scale_x;
+  window.crop_height = crop_ * scale_y;
+  window.crop_width = crop_ * scale_x;
+  window.mirror = mirror_ && mirror_this_image(*randgen);
+  return window;
+}
+
+// Only CUDAContext decodes on the GPU, see image_input_op_gpu.cc.
+template <class Context>
+void ImageInputOp<Context>::DecodeBatchOnGPU() {
+  CAFFE_THROW("use_gpu_decode is only supported on GPU");
+}
 
 template <class Context>
 bool ImageInputOp<Context>::Prefetch() {
@@ -1113,12 +1287,16 @@ bool ImageInputOp<Context>::Prefetch() {
   prefetched_label_.mutable_data<int>();
   // Prefetching handled with a thread pool of "decode_threads" threads.
 
+  // Copies of the values, if the db doesn't support zero copy reads. They
+  // must outlive the decoding of the whole batch.
+  std::vector<std::string> value_buffers(batch_size_);
   for (int item_id = 0; item_id < batch_size_; ++item_id) {
-    std::string key, value;
+    std::string key;
+    db::Slice value;
     cv::Mat img;
 
     // read data
-    reader_->Read(&key, &value);
+    reader_->Read(&key, &value, &value_buffers[item_id]);
 
     // determine label type based on first item
     if( item_id == 0 ) {
@@ -1126,7 +1304,7 @@ bool ImageInputOp<Context>::Prefetch() {
         prefetched_label_.mutable_data<int>();
       } else {
         TensorProtos protos;
-        CAFFE_ENFORCE(protos.ParseFromString(value));
+        CAFFE_ENFORCE(protos.ParseFromArray(value.data, value.size));
         TensorProto_DataType labeldt = protos.protos(1).data_type();
         if( labeldt == TensorProto::INT32 ) {
           prefetched_label_.mutable_data<int>();
@@ -1157,14 +1335,17 @@ bool ImageInputOp<Context>::Prefetch() {
 
     // launch into thread pool for processing
     // TODO: support color jitter and color lighting in gpu_transform
-    if (gpu_transform_) {
+    if (gpu_decode_) {
+      thread_pool_->runTask(std::bind(
+          &ImageInputOp<Context>::ParseForGPUDecode, this, value, item_id));
+    } else if (gpu_transform_) {
       // output of decode will still be int8
       uint8_t* image_data = prefetched_image_.mutable_data<uint8_t>() +
           crop_ * crop_ * channels * item_id;
       thread_pool_->runTaskWithID(std::bind(
           &ImageInputOp<Context>::DecodeAndTransposeOnly,
           this,
-          std::string(value),
+          value,
           image_data,
           item_id,
           channels,
@@ -1175,7 +1356,7 @@ bool ImageInputOp<Context>::Prefetch() {
       thread_pool_->runTaskWithID(std::bind(
           &ImageInputOp<Context>::DecodeAndTransform,
           this,
-          std::string(value),
+          value,
           image_data,
           item_id,
           channels,
@@ -1183,6 +1364,9 @@ bool ImageInputOp<Context>::Prefetch() {
     }
   }
   thread_pool_->waitWorkComplete();
+  if (gpu_decode_) {
+    DecodeBatchOnGPU();
+  }
 
   // we allow to get at most max_decode_error_ratio from
   // opencv imdecode until raising a runtime exception
@@ -1196,7 +1380,9 @@ bool ImageInputOp<Context>::Prefetch() {
   // If the context is not CPUContext, we will need to do a copy in the
   // prefetch function as well.
   if (!std::is_same<Context, CPUContext>::value) {
-    prefetched_image_on_device_.CopyFrom(prefetched_image_, &context_);
+    if (!gpu_decode_) {
+      prefetched_image_on_device_.CopyFrom(prefetched_image_, &context_);
+    }
     prefetched_label_on_device_.CopyFrom(prefetched_label_, &context_);
 
     for (int i = 0; i < prefetched_additional_outputs_on_device_.size(); ++i) {
@@ -1212,13 +1398,13 @@ bool ImageInputOp<Context>::Prefetch() {
 
 template <class Context>
 bool ImageInputOp<Context>::CopyPrefetched() {
-  auto* image_output = OperatorBase::Output<Tensor<Context> >(0);
-  auto* label_output = OperatorBase::Output<Tensor<Context> >(1);
+  auto* image_output = this->template PrefetchedOutput<Tensor<Context>>(0);
+  auto* label_output = this->template PrefetchedOutput<Tensor<Context>>(1);
   vector<Tensor<Context>*> additional_outputs_output;
 
   for (int i = 2; i < OutputSize(); ++i) {
     additional_outputs_output.push_back(
-        OperatorBase::Output<Tensor<Context>>(i));
+        this->template PrefetchedOutput<Tensor<Context>>(i));
   }
 
   // Note(jiayq): The if statement below should be optimized away by the
@@ -1268,6 +1454,10 @@ bool ImageInputOp<Context>::CopyPrefetched() {
   }
   return true;
 }
+
+template <>
+void ImageInputOp<CUDAContext>::DecodeBatchOnGPU();
+
 }  // namespace caffe2
 
 #endif  // CAFFE2_IMAGE_IMAGE_INPUT_OP_H_
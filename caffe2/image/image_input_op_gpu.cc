@@ -1,9 +1,48 @@
 #include "caffe2/core/common_gpu.h"
 #include "caffe2/core/context_gpu.h"
 #include "caffe2/image/image_input_op.h"
+#include "caffe2/image/nvjpeg_decoder_gpu.h"
 
 namespace caffe2 {
 
+template <>
+void ImageInputOp<CUDAContext>::DecodeBatchOnGPU() {
+#ifdef CAFFE2_USE_NVJPEG
+  if (!nvjpeg_decoder_) {
+    nvjpeg_decoder_ = std::make_shared<NvJpegDecoder>(num_decode_threads_);
+  }
+  // The decode threads are done, so the random generator of the first one
+  // draws the crops.
+  std::mt19937* randgen = &randgen_per_thread_[0];
+  vector<const string*> encoded(batch_size_);
+  vector<CropWindow> windows(batch_size_);
+  for (int item_id = 0; item_id < batch_size_; ++item_id) {
+    encoded[item_id] = &encoded_images_[item_id];
+    int height, width;
+    if (nvjpeg_decoder_->GetImageInfo(
+            encoded_images_[item_id], &height, &width)) {
+      windows[item_id] = GetCropWindow(
+          height, width, encoded_image_info_[item_id], randgen);
+    } else {
+      // As with the errors of cv::imdecode, the image is all zeros.
+      num_decode_errors_in_batch_++;
+      windows[item_id].valid = false;
+    }
+  }
+
+  prefetched_image_on_device_.Resize(
+      TIndex(batch_size_), TIndex(crop_), TIndex(crop_), TIndex(3));
+  nvjpeg_decoder_->DecodeBatch(
+      encoded,
+      &windows,
+      crop_,
+      prefetched_image_on_device_.mutable_data<uint8_t>(),
+      &context_);
+#else
+  CAFFE_THROW("use_gpu_decode requires Caffe2 to be built with nvJPEG.");
+#endif
+}
+
 REGISTER_CUDA_OPERATOR(ImageInput, ImageInputOp<CUDAContext>);
 
 }  // namespace caffe2
@@ -0,0 +1,124 @@
+#include "caffe2/image/nvjpeg_decoder_gpu.h"
+
+#ifdef CAFFE2_USE_NVJPEG
+
+#define NVJPEG_ENFORCE(condition)            \
+  do {                                       \
+    nvjpegStatus_t status = condition;       \
+    CAFFE_ENFORCE_EQ(                        \
+        status,                              \
+        NVJPEG_STATUS_SUCCESS,               \
+        "Error at: ",                        \
+        __FILE__,                            \
+        ":",                                 \
+        __LINE__,                            \
+        ": nvJPEG error ",                   \
+        static_cast<int>(status));           \
+  } while (0)
+
+namespace caffe2 {
+
+NvJpegDecoder::NvJpegDecoder(int max_cpu_threads)
+    : max_cpu_threads_(max_cpu_threads), batch_size_(0) {
+  NVJPEG_ENFORCE(nvjpegCreate(NVJPEG_BACKEND_DEFAULT, nullptr, &handle_));
+  NVJPEG_ENFORCE(nvjpegJpegStateCreate(handle_, &state_));
+}
+
+NvJpegDecoder::~NvJpegDecoder() {
+  nvjpegJpegStateDestroy(state_);
+  nvjpegDestroy(handle_);
+}
+
+bool NvJpegDecoder::GetImageInfo(
+    const string& encoded,
+    int* height,
+    int* width) {
+  int num_components;
+  nvjpegChromaSubsampling_t subsampling;
+  int widths[NVJPEG_MAX_COMPONENT];
+  int heights[NVJPEG_MAX_COMPONENT];
+  if (nvjpegGetImageInfo(
+          handle_,
+          reinterpret_cast<const unsigned char*>(encoded.data()),
+          encoded.size(),
+          &num_components,
+          &subsampling,
+          widths,
+          heights) != NVJPEG_STATUS_SUCCESS) {
+    return false;
+  }
+  *height = heights[0];
+  *width = widths[0];
+  return *height > 0 && *width > 0;
+}
+
+void NvJpegDecoder::DecodeBatch(
+    const vector<const string*>& encoded,
+    vector<CropWindow>* windows,
+    int crop,
+    uint8_t* output,
+    CUDAContext* context) {
+  CAFFE_ENFORCE_EQ(encoded.size(), windows->size());
+  // The decoded images are laid out one after the other in decoded_.
+  vector<const unsigned char*> data;
+  vector<size_t> lengths;
+  int64_t decoded_size = 0;
+  for (int i = 0; i < encoded.size(); ++i) {
+    CropWindow& window = (*windows)[i];
+    if (!window.valid) {
+      continue;
+    }
+    window.offset = decoded_size;
+    decoded_size += int64_t(window.height) * window.width * 3;
+    data.push_back(reinterpret_cast<const unsigned char*>(encoded[i]->data()));
+    lengths.push_back(encoded[i]->size());
+  }
+  decoded_.Resize(std::max(decoded_size, int64_t(1)));
+  uint8_t* decoded = decoded_.mutable_data<uint8_t>();
+
+  if (!data.empty()) {
+    vector<nvjpegImage_t> destinations(data.size());
+    int image_id = 0;
+    for (const auto& window : *windows) {
+      if (!window.valid) {
+        continue;
+      }
+      nvjpegImage_t& destination = destinations[image_id++];
+      memset(&destination, 0, sizeof(destination));
+      // BGRI is interleaved BGR, as OpenCV decodes images.
+      destination.channel[0] = decoded + window.offset;
+      destination.pitch[0] = window.width * 3;
+    }
+    if (batch_size_ != static_cast<int>(data.size())) {
+      NVJPEG_ENFORCE(nvjpegDecodeBatchedInitialize(
+          handle_, state_, data.size(), max_cpu_threads_, NVJPEG_OUTPUT_BGRI));
+      batch_size_ = data.size();
+    }
+    NVJPEG_ENFORCE(nvjpegDecodeBatched(
+        handle_,
+        state_,
+        data.data(),
+        lengths.data(),
+        destinations.data(),
+        context->cuda_stream()));
+  }
+
+  // The windows are copied from pageable memory, which returns once they
+  // have been staged, so the vector does not have to outlive the copy.
+  windows_on_device_.Resize(windows->size() * sizeof(CropWindow));
+  context->CopyBytes<CPUContext, CUDAContext>(
+      windows->size() * sizeof(CropWindow),
+      windows->data(),
+      windows_on_device_.mutable_data<uint8_t>());
+  CropMirrorResizeOnGPU<CUDAContext>(
+      decoded,
+      reinterpret_cast<const CropWindow*>(windows_on_device_.data<uint8_t>()),
+      windows->size(),
+      crop,
+      output,
+      context);
+}
+
+} // namespace caffe2
+
+#endif // CAFFE2_USE_NVJPEG
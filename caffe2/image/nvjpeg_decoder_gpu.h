@@ -0,0 +1,56 @@
+#ifndef CAFFE2_IMAGE_NVJPEG_DECODER_GPU_H_
+#define CAFFE2_IMAGE_NVJPEG_DECODER_GPU_H_
+
+#include "caffe2/core/common.h"
+
+#ifdef CAFFE2_USE_NVJPEG
+
+#include <nvjpeg.h>
+
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/image/transform_gpu.h"
+
+namespace caffe2 {
+
+// Decodes batches of JPEG images with nvJPEG. The Huffman decoding runs on
+// max_cpu_threads CPU threads of nvJPEG, and the rest of the decoding runs
+// on the GPU, on the stream of the context. The decoded images are then
+// cropped, mirrored and resized on the GPU as well, so that only the encoded
+// images are copied to the device.
+class NvJpegDecoder {
+ public:
+  explicit NvJpegDecoder(int max_cpu_threads);
+  ~NvJpegDecoder();
+
+  // Reads the size of an encoded image without decoding it. Returns false if
+  // it is not an image that nvJPEG can decode.
+  bool GetImageInfo(const string& encoded, int* height, int* width);
+
+  // Decodes the valid images to BGR, and resizes their crop windows into the
+  // NHWC uint8 output of windows->size() x crop x crop x 3. The sizes of the
+  // windows must be the ones given by GetImageInfo, and their offsets are
+  // set here.
+  void DecodeBatch(
+      const vector<const string*>& encoded,
+      vector<CropWindow>* windows,
+      int crop,
+      uint8_t* output,
+      CUDAContext* context);
+
+ private:
+  int max_cpu_threads_;
+  // The batch size the decoding state was initialized for.
+  int batch_size_;
+  nvjpegHandle_t handle_;
+  nvjpegJpegState_t state_;
+  Tensor<CUDAContext> decoded_;
+  Tensor<CUDAContext> windows_on_device_;
+
+  DISABLE_COPY_AND_ASSIGN(NvJpegDecoder);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_USE_NVJPEG
+
+#endif // CAFFE2_IMAGE_NVJPEG_DECODER_GPU_H_
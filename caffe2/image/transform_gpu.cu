@@ -80,4 +80,59 @@ template bool TransformOnGPU<uint8_t, float16, CUDAContext>(Tensor<CUDAContext>&
                                                             Tensor<CUDAContext>& std,
                                                             CUDAContext *context);
 
+namespace {
+
+__global__ void crop_mirror_resize_kernel(const int N, const int crop,
+                                          const uint8_t* images,
+                                          const CropWindow* windows,
+                                          uint8_t* out) {
+  CUDA_1D_KERNEL_LOOP(index, N * crop * crop) {
+    const int n = index / (crop * crop);
+    const int oy = (index / crop) % crop;
+    int ox = index % crop;
+    const CropWindow& window = windows[n];
+    uint8_t* output_ptr = &out[index * 3];
+    if (!window.valid) {
+      output_ptr[0] = output_ptr[1] = output_ptr[2] = 0;
+      continue;
+    }
+    if (window.mirror) {
+      ox = crop - 1 - ox;
+    }
+
+    // Sample the window at the centers of the output pixels.
+    const int H = window.height, W = window.width;
+    float sy = window.y + (oy + 0.5f) * window.crop_height / crop - 0.5f;
+    float sx = window.x + (ox + 0.5f) * window.crop_width / crop - 0.5f;
+    sy = fminf(fmaxf(sy, 0.f), H - 1);
+    sx = fminf(fmaxf(sx, 0.f), W - 1);
+    const int y0 = static_cast<int>(sy), x0 = static_cast<int>(sx);
+    const int y1 = min(y0 + 1, H - 1), x1 = min(x0 + 1, W - 1);
+    const float fy = sy - y0, fx = sx - x0;
+
+    const uint8_t* input_ptr = &images[window.offset];
+    for (int c = 0; c < 3; ++c) {
+      const float top = (1.f - fx) * input_ptr[(y0 * W + x0) * 3 + c] +
+          fx * input_ptr[(y0 * W + x1) * 3 + c];
+      const float bottom = (1.f - fx) * input_ptr[(y1 * W + x0) * 3 + c] +
+          fx * input_ptr[(y1 * W + x1) * 3 + c];
+      output_ptr[c] =
+          static_cast<uint8_t>((1.f - fy) * top + fy * bottom + 0.5f);
+    }
+  }
+}
+
+}
+
+template <>
+void CropMirrorResizeOnGPU<CUDAContext>(const uint8_t* images,
+                                        const CropWindow* windows,
+                                        const int N, const int crop,
+                                        uint8_t* Y, CUDAContext* context) {
+  crop_mirror_resize_kernel<<<CAFFE_GET_BLOCKS(N * crop * crop),
+                              CAFFE_CUDA_NUM_THREADS, 0,
+                              context->cuda_stream()>>>(
+      N, crop, images, windows, Y);
+}
+
 }  // namespace caffe2
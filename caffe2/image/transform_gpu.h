@@ -35,6 +35,30 @@ bool TransformOnGPU(Tensor<Context>& X, Tensor<Context>* Y,
                     Tensor<Context>& mean, Tensor<Context>& std,
                     Context* context);
 
+// The region of a decoded image that is resized to a crop x crop output
+// image, in the coordinates of the decoded image. The decoded images of a
+// batch are HWC with 3 channels, one after the other, and offset is where
+// this one starts. Invalid images give an output image of zeros.
+struct CropWindow {
+  int64_t offset;
+  int height;
+  int width;
+  float y;
+  float x;
+  float crop_height;
+  float crop_width;
+  bool mirror;
+  bool valid;
+};
+
+// Crops, mirrors and resizes the windows of N decoded images with bilinear
+// interpolation, into the NHWC uint8 batch Y of N x crop x crop x 3. The
+// windows are in the memory of the context.
+template <class Context>
+void CropMirrorResizeOnGPU(const uint8_t* images, const CropWindow* windows,
+                           const int N, const int crop, uint8_t* Y,
+                           Context* context);
+
 }  // namespace caffe2
 
 #endif
@@ -0,0 +1,155 @@
+#include <memory>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/mkl/mkl_utils.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/utils/cpuid.h"
+#include "caffe2/utils/math.h"
+
+#ifdef CAFFE2_HAS_MKL_SGEMM_PACK
+
+namespace caffe2 {
+
+namespace mkl {
+
+// Conv with the filter packed as the A matrix of the im2col GEMM. As
+// PackedFC, it is meant for inference: the filter is packed the first time
+// the operator runs, and again only when its data moves or is reshaped, or
+// the output image size changes.
+class PackedConvOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  PackedConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws) {
+    OPERATOR_NEEDS_FEATURE(
+        order_ == StorageOrder::NCHW && kernel_.size() == 2,
+        "PackedConv only supports 2D NCHW convolutions.");
+    // See PackedFCOp for the known issue of MKL on non-avx2 machines.
+    OPERATOR_NEEDS_FEATURE(
+        GetCpuId().avx2(), "PackedConv needs a machine with avx2.");
+  }
+  ~PackedConvOp() {}
+
+  bool RunOnDeviceWithOrderNCHW() override {
+    const auto& X = Input(0);
+    const auto& filter = Input(1);
+    auto* Y = Output(0);
+    const int N = X.dim32(0), C = X.dim32(1);
+    CAFFE_ENFORCE_EQ(X.ndim(), 4);
+    CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+    const int M = filter.dim32(0);
+    CAFFE_ENFORCE_EQ(C, filter.dim32(1) * group_);
+    CAFFE_ENFORCE_EQ(M % group_, 0);
+    CAFFE_ENFORCE_EQ(filter.dim32(2), kernel_h());
+    CAFFE_ENFORCE_EQ(filter.dim32(3), kernel_w());
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X, Y, M);
+
+    const int input_image_size = X.dim32(2) * X.dim32(3);
+    const int output_image_size = Y->dim32(2) * Y->dim32(3);
+    const int kernel_dim = C / group_ * kernel_h() * kernel_w();
+    const int input_offset = C / group_ * input_image_size;
+    const int output_offset = M / group_ * output_image_size;
+    const float* filter_data = filter.template data<float>();
+    if (filter_data != filter_data_ || filter.dims() != filter_dims_ ||
+        output_image_size != packed_image_size_) {
+      packed_filters_.clear();
+      for (int g = 0; g < group_; ++g) {
+        packed_filters_.emplace_back(new MKLPackedMatrix(
+            CblasAMatrix,
+            CblasNoTrans,
+            M / group_,
+            output_image_size,
+            kernel_dim,
+            1.f,
+            filter_data + g * (M / group_) * kernel_dim,
+            kernel_dim));
+      }
+      filter_data_ = filter_data;
+      filter_dims_ = filter.dims();
+      packed_image_size_ = output_image_size;
+    }
+    if (InputSize() == 3) {
+      const auto& bias = Input(2);
+      CAFFE_ENFORCE_EQ(bias.ndim(), 1);
+      CAFFE_ENFORCE_EQ(bias.dim32(0), M);
+      ConvPoolOpBase<CPUContext>::template SetBiasMultiplier<float>(
+          output_image_size, &bias_multiplier_);
+    }
+
+    col_buffer_.Resize(kernel_dim, output_image_size);
+    float* col_buffer_data = col_buffer_.template mutable_data<float>();
+    const float* Xdata = X.template data<float>();
+    float* Ydata = Y->template mutable_data<float>();
+    for (int image_id = 0; image_id < N; ++image_id) {
+      for (int group_id = 0; group_id < group_; ++group_id) {
+        math::Im2Col<float, CPUContext, StorageOrder::NCHW>(
+            C / group_,
+            X.dim32(2),
+            X.dim32(3),
+            kernel_h(),
+            kernel_w(),
+            dilation_h(),
+            dilation_w(),
+            pad_t(),
+            pad_l(),
+            pad_b(),
+            pad_r(),
+            stride_h(),
+            stride_w(),
+            Xdata + group_id * input_offset,
+            col_buffer_data,
+            &context_);
+        cblas_sgemm_compute(
+            CblasRowMajor,
+            CblasPacked,
+            CblasNoTrans,
+            M / group_,
+            output_image_size,
+            kernel_dim,
+            packed_filters_[group_id]->data_,
+            kernel_dim,
+            col_buffer_data,
+            output_image_size,
+            0,
+            Ydata + group_id * output_offset,
+            output_image_size);
+      }
+      if (InputSize() == 3) {
+        math::Gemm<float, CPUContext>(
+            CblasNoTrans,
+            CblasNoTrans,
+            M,
+            output_image_size,
+            1,
+            1,
+            Input(2).template data<float>(),
+            bias_multiplier_.template data<float>(),
+            1,
+            Ydata,
+            &context_);
+      }
+      Xdata += input_offset * group_;
+      Ydata += output_offset * group_;
+    }
+    return true;
+  }
+
+ private:
+  // The packed filters of the groups and the data they were packed from
+  const float* filter_data_{nullptr};
+  vector<TIndex> filter_dims_;
+  int packed_image_size_{0};
+  std::vector<std::unique_ptr<MKLPackedMatrix>> packed_filters_;
+  TensorCPU col_buffer_;
+  TensorCPU bias_multiplier_;
+};
+
+} // namespace mkl
+
+REGISTER_CPU_OPERATOR_WITH_ENGINE(Conv, PACKED, mkl::PackedConvOp);
+
+} // namespace caffe2
+
+#endif // CAFFE2_HAS_MKL_SGEMM_PACK
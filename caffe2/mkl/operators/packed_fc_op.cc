@@ -63,9 +63,10 @@ class PackedFCOp final : public Operator<CPUContext> {
           << "PackedFCOp is currently stateful: you should not change the "
              "weight during runtime. This is only sanity-checked in debug "
              "mode for speed considerations.";
-      if (!local_packed_matrix_.get() || local_packed_matrix_->n_ != M) {
-        // If there is no pre packed matrix, or the batch size changed, we
-        // do a re-pack.
+      if (!local_packed_matrix_.get() || local_packed_matrix_->m_ != M ||
+          W.raw_data() != W_data_ || W.dims() != W_dims_) {
+        // If there is no pre packed matrix, the batch size changed, or the
+        // weight blob was reallocated, we do a re-pack.
         local_packed_matrix_.reset(new MKLPackedMatrix(
             CblasBMatrix,
             CblasTrans,
@@ -75,6 +76,8 @@ class PackedFCOp final : public Operator<CPUContext> {
             1.f,
             W.template data<float>(),
             K));
+        W_data_ = W.raw_data();
+        W_dims_ = W.dims();
       }
       packed_matrix = local_packed_matrix_.get();
     } else if (OperatorBase::InputIsType<MKLPackedMatrix>(1)) {
@@ -141,6 +144,10 @@ class PackedFCOp final : public Operator<CPUContext> {
   }
   size_t axis_{1};
   uint32_t hash_{0};
+  // The data and shape of the weight that local_packed_matrix_ was packed
+  // from
+  const void* W_data_{nullptr};
+  vector<TIndex> W_dims_;
   vector<TIndex> Y_shape_cache_;
   Tensor<CPUContext> bias_multiplier_;
   std::unique_ptr<MKLPackedMatrix> local_packed_matrix_;
@@ -13,6 +13,7 @@ class MKLBNOp final : public SpatialBNOp<MKLContext> {
  public:
   MKLBNOp(const OperatorDef& operator_def, Workspace* ws)
       : SpatialBNOp<MKLContext>(operator_def, ws) {
+    OPERATOR_NEEDS_FEATURE(!fuse_relu_, "Fused ReLU not supported.");
     OPERATOR_NEEDS_FEATURE(
         order_ == StorageOrder::NCHW, "Only NCHW order supported.");
     OPERATOR_NEEDS_FEATURE(
@@ -1,5 +1,6 @@
 
 #include "AndroidGLContext.h"
+#include "../core/GLPlainTexture.h"
 
 std::unique_ptr<GLContext> GLContext::_glcontext = nullptr;
 
@@ -16,4 +17,11 @@ GLContext* GLContext::getGLContext() {
   return _glcontext.get();
 }
 
-void GLContext::deleteGLContext() { _glcontext.reset(nullptr); }
+void GLContext::deleteGLContext() {
+  if (_glcontext != nullptr) {
+    // The pooled textures belong to the context.
+    _glcontext->set_context();
+    GLTexturePool::getPool()->clear();
+  }
+  _glcontext.reset(nullptr);
+}
@@ -20,9 +20,24 @@ inline void vst1_u16_aligned8(uint16_t* address, uint16x4_t data) {
   vst1_u16(static_cast<uint16_t*>(__builtin_assume_aligned(address, 8)), data);
 }
 
-template <int input_channels>
-static void interleaveSlice(
-    void* output, const float* input, size_t width, size_t height, size_t row_stride) {
+// y = scale * x + bias, when the slice is normalized while converting it.
+template <bool normalize>
+static inline float32x4_t normalizeChannel(float32x4_t x, float scale, float bias) {
+  return normalize ? vmlaq_n_f32(vdupq_n_f32(bias), x, scale) : x;
+}
+
+template <int input_channels, bool normalize>
+static void interleaveSlice(void* output,
+                            const float* input,
+                            size_t width,
+                            size_t height,
+                            size_t row_stride,
+                            const float* scale,
+                            const float* bias) {
+  const auto load = [&](const float* channel, int c) {
+    return uint16x4_t(
+        vcvt_f16_f32(normalizeChannel<normalize>(vld1q_f32(channel), scale[c], bias[c])));
+  };
   const float* input_r = input;
   const float* input_g = input_r + height * width;
   const float* input_b = input_g + height * width;
@@ -32,18 +47,18 @@ static void interleaveSlice(
     for (size_t y = 0; y < height; y++) {
       size_t nx = width;
       while (nx >= 4) {
-        const uint16x4_t r = uint16x4_t(vcvt_f16_f32(vld1q_f32(input_r)));
+        const uint16x4_t r = load(input_r, 0);
         input_r += 4;
         uint16x4_t g, b, a;
         g = b = a = vdup_n_u16(0);
         if (input_channels >= 2) {
-          g = uint16x4_t(vcvt_f16_f32(vld1q_f32(input_g)));
+          g = load(input_g, 1);
           input_g += 4;
           if (input_channels >= 3) {
-            b = uint16x4_t(vcvt_f16_f32(vld1q_f32(input_b)));
+            b = load(input_b, 2);
             input_b += 4;
             if (input_channels >= 4) {
-              a = uint16x4_t(vcvt_f16_f32(vld1q_f32(input_a)));
+              a = load(input_a, 3);
               input_a += 4;
             }
           }
@@ -68,18 +83,18 @@ static void interleaveSlice(
           }
         }
 
-        const uint16x4_t r = uint16x4_t(vcvt_f16_f32(vld1q_f32(input_r)));
+        const uint16x4_t r = load(input_r, 0);
         input_r += 4;
         uint16x4_t g, b, a;
         g = b = a = vdup_n_u16(0);
         if (input_channels >= 2) {
-          g = uint16x4_t(vcvt_f16_f32(vld1q_f32(input_g)));
+          g = load(input_g, 1);
           input_g += 4;
           if (input_channels >= 3) {
-            b = uint16x4_t(vcvt_f16_f32(vld1q_f32(input_b)));
+            b = load(input_b, 2);
             input_b += 4;
             if (input_channels >= 4) {
-              a = uint16x4_t(vcvt_f16_f32(vld1q_f32(input_a)));
+              a = load(input_a, 3);
               input_a += 4;
             }
           }
@@ -104,6 +119,9 @@ static void interleaveSlice(
             }
           }
         }
+        if (normalize) {
+          rgba = vmlaq_f32(vld1q_f32(bias), rgba, vld1q_f32(scale));
+        }
         vst1_u16_aligned8(output_f16, uint16x4_t(vcvt_f16_f32(rgba)));
         output_f16 += 4;
       }
@@ -112,28 +130,57 @@ static void interleaveSlice(
   }
 }
 
-void interleaveSlice(void* output,
-                     const float* input,
-                     size_t width,
-                     size_t height,
-                     size_t row_stride,
-                     uint16_t input_channels) {
+template <bool normalize>
+static void interleaveSlice(void* output,
+                            const float* input,
+                            size_t width,
+                            size_t height,
+                            size_t row_stride,
+                            uint16_t input_channels,
+                            const float* scale,
+                            const float* bias) {
   switch (input_channels) {
   case 1:
-    interleaveSlice<1>(output, input, width, height, row_stride);
+    interleaveSlice<1, normalize>(output, input, width, height, row_stride, scale, bias);
     break;
   case 2:
-    interleaveSlice<2>(output, input, width, height, row_stride);
+    interleaveSlice<2, normalize>(output, input, width, height, row_stride, scale, bias);
     break;
   case 3:
-    interleaveSlice<3>(output, input, width, height, row_stride);
+    interleaveSlice<3, normalize>(output, input, width, height, row_stride, scale, bias);
     break;
   case 4:
-    interleaveSlice<4>(output, input, width, height, row_stride);
+    interleaveSlice<4, normalize>(output, input, width, height, row_stride, scale, bias);
     break;
   }
 }
 
+void interleaveSlice(void* output,
+                     const float* input,
+                     size_t width,
+                     size_t height,
+                     size_t row_stride,
+                     uint16_t input_channels,
+                     const float* scale,
+                     const float* bias) {
+  // All four lanes are read by the path for narrow images.
+  float scale4[4] = {1, 1, 1, 1};
+  float bias4[4] = {0, 0, 0, 0};
+  for (int c = 0; c < input_channels && c < 4; c++) {
+    if (scale) {
+      scale4[c] = scale[c];
+    }
+    if (bias) {
+      bias4[c] = bias[c];
+    }
+  }
+  if (scale || bias) {
+    interleaveSlice<true>(output, input, width, height, row_stride, input_channels, scale4, bias4);
+  } else {
+    interleaveSlice<false>(output, input, width, height, row_stride, input_channels, scale4, bias4);
+  }
+}
+
 template <int output_channels>
 static void deInterleaveSlice(
     float* output, const void* input, size_t width, size_t height, size_t row_stride) {
@@ -3,12 +3,16 @@
 
 #include "arm_neon_support.h"
 
+// Converts up to four planar channels to an interleaved FP16 slice. If given,
+// scale and bias normalize the channels on the way, as scale * x + bias.
 void interleaveSlice(void* output,
                      const float* input,
                      size_t width,
                      size_t height,
                      size_t row_stride,
-                     uint16_t input_channels);
+                     uint16_t input_channels,
+                     const float* scale = nullptr,
+                     const float* bias = nullptr);
 void deInterleaveSlice(float* output,
                        const void* input,
                        size_t width,
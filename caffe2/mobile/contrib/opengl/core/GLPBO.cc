@@ -4,10 +4,16 @@
 #include "caffe2/core/logging.h"
 
 GLPBO::~GLPBO() {
-  if (pboId != 0) {
-    gl_log(GL_LOG, "deleting PBO buffer %d\n", pboId);
-    glDeleteBuffers(1, &pboId);
-    pboId = 0;
+  for (auto& buffer : buffers) {
+    if (buffer.fence != 0) {
+      glDeleteSync(buffer.fence);
+      buffer.fence = 0;
+    }
+    if (buffer.pboId != 0) {
+      gl_log(GL_LOG, "deleting PBO buffer %d\n", buffer.pboId);
+      glDeleteBuffers(1, &buffer.pboId);
+      buffer.pboId = 0;
+    }
   }
   if (pboFrameBuffer != 0) {
     gl_log(GL_LOG, "deleting PBO frame buffer %d\n", pboFrameBuffer);
@@ -37,6 +43,23 @@ void GLPBO::mapTextureData(GLuint _textureId,
                                               size_t stride,
                                               size_t channels,
                                               const GLTexture::Type& type)> process) {
+  mapTexturesData({{_textureId, _width, _height, _stride, _channels, &_type}},
+                  [&](int index,
+                      const void* buffer,
+                      size_t width,
+                      size_t height,
+                      size_t stride,
+                      size_t channels,
+                      const GLTexture::Type& type) {
+                    process(buffer, width, height, stride, channels, type);
+                  });
+}
+
+void GLPBO::mapTexturesData(const std::vector<Texture>& textures, const Process& process) {
+  if (textures.empty()) {
+    return;
+  }
+
   GLint defaultFramebuffer = 0;
   glGetIntegerv(GL_FRAMEBUFFER_BINDING, &defaultFramebuffer);
 
@@ -47,7 +70,21 @@ void GLPBO::mapTextureData(GLuint _textureId,
 
   glBindFramebuffer(GL_FRAMEBUFFER, pboFrameBuffer);
 
-  glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, _textureId, 0);
+  readTexture(buffers[0], textures[0]);
+  for (int i = 0; i < textures.size(); i++) {
+    if (i + 1 < textures.size()) {
+      readTexture(buffers[(i + 1) % kNumBuffers], textures[i + 1]);
+    }
+    processBuffer(buffers[i % kNumBuffers], textures[i], i, process);
+  }
+
+  // Bind to the default FrameBuffer
+  glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebuffer);
+}
+
+void GLPBO::readTexture(Buffer& buffer, const Texture& texture) {
+  glFramebufferTexture2D(
+      GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.textureId, 0);
 
   int fbs = glCheckFramebufferStatus(GL_FRAMEBUFFER);
   if (fbs != GL_FRAMEBUFFER_COMPLETE) {
@@ -56,28 +93,56 @@ void GLPBO::mapTextureData(GLuint _textureId,
     throw std::runtime_error(errmsg.str());
   }
 
-  if (pboId == 0) {
-    glGenBuffers(1, &pboId);
-    gl_log(GL_VERBOSE, "created PBO buffer %d\n", pboId);
+  if (buffer.pboId == 0) {
+    glGenBuffers(1, &buffer.pboId);
+    gl_log(GL_VERBOSE, "created PBO buffer %d\n", buffer.pboId);
   }
-  glBindBuffer(GL_PIXEL_PACK_BUFFER, pboId);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pboId);
 
-  size_t buffer_size = _stride * _height * _channels * _type.dataSize();
+  size_t buffer_size = texture.stride * texture.height * texture.channels * texture.type->dataSize();
 
-  if (buffer_size > pboSize) {
+  if (buffer_size > buffer.pboSize) {
     LOG(INFO) << "Allocating PBO of capacity " << buffer_size;
 
     glBufferData(GL_PIXEL_PACK_BUFFER, buffer_size, NULL, GL_DYNAMIC_READ);
-    pboSize = buffer_size;
+    buffer.pboSize = buffer_size;
   }
 
+  // The read only starts the transfer: the buffer is mapped once the fence
+  // signals that it completed.
   glReadBuffer(GL_COLOR_ATTACHMENT0);
-  glReadPixels(0, 0, _stride, _height, _type.format, _type.type, 0);
+  glReadPixels(0, 0, texture.stride, texture.height, texture.type->format, texture.type->type, 0);
+  buffer.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
 
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void GLPBO::processBuffer(Buffer& buffer,
+                          const Texture& texture,
+                          int index,
+                          const Process& process) {
+  if (buffer.fence != 0) {
+    GLenum result;
+    do {
+      result = glClientWaitSync(buffer.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+    } while (result == GL_TIMEOUT_EXPIRED);
+    glDeleteSync(buffer.fence);
+    buffer.fence = 0;
+    if (result == GL_WAIT_FAILED) {
+      std::stringstream errmsg;
+      errmsg << ": glClientWaitSync on PBO read back failed";
+      throw std::runtime_error(errmsg.str());
+    }
+  }
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer.pboId);
+
+  size_t buffer_size = texture.stride * texture.height * texture.channels * texture.type->dataSize();
   GLhalf* ptr = (GLhalf*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, buffer_size, GL_MAP_READ_BIT);
 
   if (ptr) {
-    process(ptr, _width, _height, _stride, _channels, _type);
+    process(
+        index, ptr, texture.width, texture.height, texture.stride, texture.channels, *texture.type);
   } else {
     std::stringstream errmsg;
     errmsg << ": glMapBufferRange using PBO incomplete";
@@ -87,7 +152,4 @@ void GLPBO::mapTextureData(GLuint _textureId,
   // Unmap buffer
   glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
-
-  // Bind to the default FrameBuffer
-  glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebuffer);
 }
@@ -3,16 +3,49 @@
 
 #include "GLTexture.h"
 #include <functional>
+#include <vector>
 
 class GLPBO {
-  GLuint pboId = 0;
-  GLuint pboSize = 0;
+ public:
+  struct Texture {
+    GLuint textureId;
+    GLsizei width;
+    GLsizei height;
+    GLsizei stride;
+    GLsizei channels;
+    const GLTexture::Type* type;
+  };
+
+  typedef std::function<void(int index,
+                             const void* buffer,
+                             size_t width,
+                             size_t height,
+                             size_t stride,
+                             size_t channels,
+                             const GLTexture::Type& type)>
+      Process;
+
+ private:
+  struct Buffer {
+    GLuint pboId = 0;
+    size_t pboSize = 0;
+    GLsync fence = 0;
+  };
+
+  // The texture after the one being processed is read back into the other
+  // buffer, so the transfers overlap with the processing on the CPU.
+  static constexpr int kNumBuffers = 2;
+
+  Buffer buffers[kNumBuffers];
   GLuint pboFrameBuffer = 0;
 
   ~GLPBO();
 
   static GLPBO* pboContext;
 
+  void readTexture(Buffer& buffer, const Texture& texture);
+  void processBuffer(Buffer& buffer, const Texture& texture, int index, const Process& process);
+
  public:
   void mapTextureData(GLuint _textureId,
                       GLsizei _width,
@@ -27,5 +60,8 @@ class GLPBO {
                                          size_t channels,
                                          const GLTexture::Type& type)> process);
 
+  // Reads back the textures in order, calling process with the index of each.
+  void mapTexturesData(const std::vector<Texture>& textures, const Process& process);
+
   static GLPBO* getContext();
 };
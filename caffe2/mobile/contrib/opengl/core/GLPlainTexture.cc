@@ -14,6 +14,22 @@ GLPlainTexture::GLPlainTexture(
     : GLTexture(FIXED_TYPE(type), width, height, use_padding, filter, wrap) {
   //  caffe2::Timer timer;
   //  timer.Start();
+#if GL_EXT_texture_border_clamp
+  // Set the texture to use the border clamp wrapping mode.
+  _wrap = GL_CLAMP_TO_BORDER_EXT;
+#endif
+
+  _textureId = GLTexturePool::getPool()->acquire(_type, _stride, _height, _filter, _wrap);
+  if (_textureId != 0) {
+    gl_log(GL_VERBOSE, "GLPlainTexture() - reused textureId %d\n", _textureId);
+    if (input) {
+      glBindTexture(GL_TEXTURE_2D, _textureId);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, _stride, _height, _type.format, _type.type, input);
+      glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    return;
+  }
+
   glGenTextures(1, &_textureId);
   glBindTexture(GL_TEXTURE_2D, _textureId);
   glTexImage2D(GL_TEXTURE_2D, 0, _type.internalFormat, _stride, _height, 0, _type.format, _type.type, input);
@@ -32,8 +48,6 @@ GLPlainTexture::GLPlainTexture(
 #if GL_EXT_texture_border_clamp
   GLfloat borderColor[] = {0.0f, 0.0f, 0.0f, 0.0f};
   glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR_EXT, borderColor);
-  // Set the texture to use the border clamp wrapping mode.
-  _wrap = GL_CLAMP_TO_BORDER_EXT;
 #endif
 
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _wrap);
@@ -56,3 +70,52 @@ GLPlainTexture::GLPlainTexture(
       _type.format,
       _type.type);
 }
+
+// Textures beyond this many are deleted when released.
+static constexpr size_t kMaxPooledTextures = 256;
+
+GLTexturePool* GLTexturePool::pool = nullptr;
+
+GLTexturePool* GLTexturePool::getPool() {
+  if (pool == nullptr) {
+    pool = new GLTexturePool();
+  }
+  return pool;
+}
+
+GLuint GLTexturePool::acquire(
+    const GLTexture::Type& type, GLsizei stride, GLsizei height, GLint filter, GLint wrap) {
+  auto it = textures.find({type.internalFormat, stride, height, filter, wrap});
+  if (it == textures.end() || it->second.empty()) {
+    return 0;
+  }
+  const GLuint textureId = it->second.back();
+  it->second.pop_back();
+  size--;
+  return textureId;
+}
+
+void GLTexturePool::release(GLuint textureId,
+                            const GLTexture::Type& type,
+                            GLsizei stride,
+                            GLsizei height,
+                            GLint filter,
+                            GLint wrap) {
+  if (size >= kMaxPooledTextures) {
+    gl_log(GL_VERBOSE, "GLTexturePool - deleting texture %d\n", textureId);
+    glDeleteTextures(1, &textureId);
+    return;
+  }
+  textures[{type.internalFormat, stride, height, filter, wrap}].push_back(textureId);
+  size++;
+}
+
+void GLTexturePool::clear() {
+  for (auto& entry : textures) {
+    if (!entry.second.empty()) {
+      glDeleteTextures(entry.second.size(), entry.second.data());
+    }
+  }
+  textures.clear();
+  size = 0;
+}
@@ -4,6 +4,60 @@
 #include "GLContext.h"
 #include "GLTexture.h"
 
+#include <unordered_map>
+#include <vector>
+
+// Textures released by the images of a run, kept for the images of the next
+// ones. Nets allocate the same textures on every run, and creating a texture
+// with glTexImage2D is expensive on mobile GPUs. Textures are only reused for
+// the same format, size and sampling parameters, as the shaders address them
+// by texel.
+class GLTexturePool {
+  struct Key {
+    GLenum internalFormat;
+    GLsizei stride;
+    GLsizei height;
+    GLint filter;
+    GLint wrap;
+
+    bool operator==(const Key& other) const {
+      return internalFormat == other.internalFormat && stride == other.stride &&
+             height == other.height && filter == other.filter && wrap == other.wrap;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      size_t hash = key.internalFormat;
+      hash = hash * 31 + key.stride;
+      hash = hash * 31 + key.height;
+      hash = hash * 31 + key.filter;
+      return hash * 31 + key.wrap;
+    }
+  };
+
+  std::unordered_map<Key, std::vector<GLuint>, KeyHash> textures;
+  size_t size = 0;
+
+  static GLTexturePool* pool;
+
+ public:
+  // A released texture of these parameters, or 0 if there is none.
+  GLuint acquire(const GLTexture::Type& type, GLsizei stride, GLsizei height, GLint filter, GLint wrap);
+
+  void release(GLuint textureId,
+               const GLTexture::Type& type,
+               GLsizei stride,
+               GLsizei height,
+               GLint filter,
+               GLint wrap);
+
+  // Deletes the released textures. Their context must be current.
+  void clear();
+
+  static GLTexturePool* getPool();
+};
+
 class GLPlainTexture : public GLTexture {
  private:
   bool isOwner = true;
@@ -28,8 +82,8 @@ class GLPlainTexture : public GLTexture {
   ~GLPlainTexture() {
     if (glIsTexture(_textureId)) {
       if (isOwner) {
-        gl_log(GL_VERBOSE, "~GLPlainTexture() - deleting texture %d\n", _textureId);
-        glDeleteTextures(1, &_textureId);
+        gl_log(GL_VERBOSE, "~GLPlainTexture() - releasing texture %d\n", _textureId);
+        GLTexturePool::getPool()->release(_textureId, _type, _stride, _height, _filter, _wrap);
       }
     } else {
       gl_log(GL_ERR, "not deleting texture %d\n", _textureId);
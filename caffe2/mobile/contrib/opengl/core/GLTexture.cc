@@ -42,6 +42,26 @@ void GLTexture::map_read(std::function<void(const void* buffer,
   pbo->mapTextureData(_textureId, _width, _height, _stride, _channels, _type, process);
 }
 
+void GLTexture::map_read(const std::vector<const GLTexture*>& textures,
+                         std::function<void(int index,
+                                            const void* buffer,
+                                            size_t width,
+                                            size_t height,
+                                            size_t stride,
+                                            size_t channels,
+                                            const Type& type)> process) {
+  std::vector<GLPBO::Texture> pbo_textures;
+  for (const GLTexture* texture : textures) {
+    pbo_textures.push_back({texture->_textureId,
+                            texture->_width,
+                            texture->_height,
+                            texture->_stride,
+                            texture->_channels,
+                            &texture->_type});
+  }
+  GLPBO::getContext()->mapTexturesData(pbo_textures, process);
+}
+
 void GLTexture::map_load(std::function<void(void* buffer,
                                             size_t width,
                                             size_t height,
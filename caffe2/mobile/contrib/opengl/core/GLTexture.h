@@ -3,6 +3,9 @@
 #include "GL.h"
 #include "GLLogging.h"
 
+#include <functional>
+#include <vector>
+
 class GLTexture {
  public:
   struct Type {
@@ -94,6 +97,17 @@ class GLTexture {
                                            size_t channels,
                                            const Type& type)> process) const;
 
+  // Reads back the textures one after the other, the transfer of each
+  // overlapping with the processing of the previous one.
+  static void map_read(const std::vector<const GLTexture*>& textures,
+                       std::function<void(int index,
+                                          const void* buffer,
+                                          size_t width,
+                                          size_t height,
+                                          size_t stride,
+                                          size_t channels,
+                                          const Type& type)> process);
+
   virtual void map_load(std::function<void(void* buffer,
                                            size_t width,
                                            size_t height,
@@ -10,13 +10,16 @@
 #include "../core/ImageAllocator.h"
 
 #include <algorithm>
+#include <vector>
 
 namespace caffe2 {
 template <class T>
 class CopyToOpenGLOp final : public Operator<CPUContext>, ImageAllocator<T> {
  public:
   CopyToOpenGLOp(const OperatorDef& operator_def, Workspace* ws)
-      : Operator<CPUContext>(operator_def, ws) {}
+      : Operator<CPUContext>(operator_def, ws),
+        mean_(GetRepeatedArgument<float>("mean")),
+        std_(GetRepeatedArgument<float>("std")) {}
 
   bool RunOnDevice() override {
     // caffe2::Timer timer;
@@ -55,6 +58,20 @@ class CopyToOpenGLOp final : public Operator<CPUContext>, ImageAllocator<T> {
 
     Outputs()[0]->Reset(output_image);
 
+    // The input is normalized while it is converted to FP16, which saves a
+    // separate normalization pass over the textures.
+    const bool normalize = !mean_.empty() || !std_.empty();
+    if (normalize) {
+      scale_.resize(input_channels);
+      bias_.resize(input_channels);
+      for (int c = 0; c < input_channels; c++) {
+        const float mean = channelArgument(mean_, c, 0, "mean");
+        const float stddev = channelArgument(std_, c, 1, "std");
+        scale_[c] = 1 / stddev;
+        bias_[c] = -mean / stddev;
+      }
+    }
+
     for (int i = 0; i < num_images; i++) {
       const auto textures = (*output_image)[i]->textures;
       for (int slice = 0; slice < textures.size(); slice++) {
@@ -70,13 +87,16 @@ class CopyToOpenGLOp final : public Operator<CPUContext>, ImageAllocator<T> {
             for (int x = 0; x < tile_x; x++) {
               const int tiles = slice * tile_x * tile_y + y * tile_x + x;
               const int slice_channels = std::min(4, input_channels - 4 * tiles);
+              const bool normalize_slice = normalize && slice_channels > 0;
               interleaveSlice(
                   (float16_t*)buffer + 4 * (y * input_height * stride + x * input_width),
                   &input[i * input_channels * input_size + 4 * tiles * input_size],
                   input_width,
                   input_height,
                   stride, // texture stride
-                  slice_channels);
+                  slice_channels,
+                  normalize_slice ? &scale_[4 * tiles] : nullptr,
+                  normalize_slice ? &bias_[4 * tiles] : nullptr);
             }
           }
         });
@@ -86,10 +106,36 @@ class CopyToOpenGLOp final : public Operator<CPUContext>, ImageAllocator<T> {
 
     return true;
   }
+
+ private:
+  // The value of a per channel argument, one value standing for all channels.
+  float channelArgument(const std::vector<float>& values,
+                        int channel,
+                        float default_value,
+                        const char* name) const {
+    if (values.empty()) {
+      return default_value;
+    }
+    if (values.size() == 1) {
+      return values[0];
+    }
+    CAFFE_ENFORCE_EQ(values.size(), Input(0).dim32(1), "One ", name, " value per channel expected");
+    return values[channel];
+  }
+
+  const std::vector<float> mean_;
+  const std::vector<float> std_;
+  std::vector<float> scale_;
+  std::vector<float> bias_;
 };
 
 REGISTER_CPU_OPERATOR(CopyToOpenGL, CopyToOpenGLOp<float16_t>);
-OPERATOR_SCHEMA(CopyToOpenGL).NumInputs(1).NumOutputs(1).AllowInplace({{0, 0}});
+OPERATOR_SCHEMA(CopyToOpenGL)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .Arg("mean", "Per channel (or single) mean subtracted from the input while uploading it")
+    .Arg("std", "Per channel (or single) standard deviation the input is divided by");
 
 template <class T>
 class CopyFromOpenGLOp final : public Operator<CPUContext> {
@@ -115,58 +161,52 @@ class CopyFromOpenGLOp final : public Operator<CPUContext> {
 
     const int tile_x = X.tile_x();
     const int tile_y = X.tile_y();
+    const int slices = X.slices();
+    std::vector<const GLTexture*> textures;
     for (int i = 0; i < num_images; i++) {
-      for (int slice = 0; slice < X[i]->slices; slice++) {
-        timer.Start();
-        const GLTexture* texture = X[i]->textures[slice];
-
-        texture->map_read([&](const void* buffer,
-                              size_t width,
-                              size_t height,
-                              size_t stride,
-                              size_t channels,
-                              const GLTexture::Type& type) {
-          //#if CAFFE2_ANDROID && defined(__ARM_NEON__)
-          //        if (static_cast<AndroidGLContext*>(GLContext::getGLContext())->get_platform() ==
-          //        Mali) {
-          //          caffe2::Timer timer;
-          //          timer.Start();
-          //          float16_t* copy_buffer = (float16_t*)malloc(_capacity);
-          //          arm_memcpy(
-          //              (volatile unsigned char*)copy_buffer, (volatile unsigned char*)buffer,
-          //              _capacity);
-          //          deInterleaveSlice(
-          //              output + 4 * slice * output_size, copy_buffer, width, height, stride,
-          //              slice_channels);
-          //          free(copy_buffer);
-          //          LOG(INFO) << "memcpy takes " << timer.MilliSeconds() << " ms";
-          //        } else
-          //#endif
-          {
-            gl_log(GL_VERBOSE,
-                   "calling deInterleaveSlice width: %d, height: %d, stride: %d, channels: %d\n",
-                   width,
-                   height,
-                   stride,
-                   channels);
-
-            for (int y = 0; y < tile_y; y++) {
-              for (int x = 0; x < tile_x; x++) {
-                const int tiles = slice * tile_x * tile_y + y * tile_x + x;
-                const int slice_channels = std::min(4, input_channels - 4 * tiles);
-                deInterleaveSlice(
-                    output + i * input_channels * output_size + 4 * tiles * output_size,
-                    (float16_t*)buffer + 4 * (y * input_height * stride + x * input_width),
-                    input_width,
-                    input_height,
-                    stride,
-                    slice_channels);
-              }
-            }
-          }
-        });
+      for (int slice = 0; slice < slices; slice++) {
+        textures.push_back(X[i]->textures[slice]);
       }
     }
+
+    // The textures are read back together, so that each one is transferred
+    // while the previous one is being deinterleaved.
+    timer.Start();
+    GLTexture::map_read(textures,
+                        [&](int index,
+                            const void* buffer,
+                            size_t width,
+                            size_t height,
+                            size_t stride,
+                            size_t channels,
+                            const GLTexture::Type& type) {
+                          const int i = index / slices;
+                          const int slice = index % slices;
+                          gl_log(GL_VERBOSE,
+                                 "calling deInterleaveSlice width: %d, height: %d, stride: %d, "
+                                 "channels: %d\n",
+                                 width,
+                                 height,
+                                 stride,
+                                 channels);
+
+                          for (int y = 0; y < tile_y; y++) {
+                            for (int x = 0; x < tile_x; x++) {
+                              const int tiles = slice * tile_x * tile_y + y * tile_x + x;
+                              const int slice_channels = std::min(4, input_channels - 4 * tiles);
+                              deInterleaveSlice(
+                                  output + i * input_channels * output_size +
+                                      4 * tiles * output_size,
+                                  (float16_t*)buffer +
+                                      4 * (y * input_height * stride + x * input_width),
+                                  input_width,
+                                  input_height,
+                                  stride,
+                                  slice_channels);
+                            }
+                          }
+                        });
+    gl_log(GL_VERBOSE, "CopyFromOpenGL takes %.3f ms\n", timer.MilliSeconds());
     return true;
   }
 };
@@ -0,0 +1,241 @@
+#include "calibration_observer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace caffe2 {
+
+namespace {
+
+int GetBin(float value, float min, float width, int num_bins) {
+  if (width <= 0) {
+    return 0;
+  }
+  return std::min(
+      std::max(static_cast<int>((value - min) / width), 0), num_bins - 1);
+}
+
+// Quantized values of uint8 tensors, i.e. the intervals between them
+constexpr int kNumLevels = 255;
+
+// KL divergence between the distribution of the values clipped to the bins
+// [begin, end) and its quantization to kNumLevels levels
+double GetQuantizationDivergence(
+    const std::vector<double>& bins,
+    int begin,
+    int end) {
+  const int size = end - begin;
+  std::vector<double> p(bins.begin() + begin, bins.begin() + end);
+  p.front() += std::accumulate(bins.begin(), bins.begin() + begin, 0.0);
+  p.back() += std::accumulate(bins.begin() + end, bins.end(), 0.0);
+
+  // The quantization spreads the values of a level over its non-empty bins
+  std::vector<double> q(size, 0.0);
+  for (int level = 0; level < kNumLevels; ++level) {
+    const int level_begin = level * size / kNumLevels;
+    const int level_end = (level + 1) * size / kNumLevels;
+    double sum = 0;
+    int non_empty = 0;
+    for (int i = level_begin; i < level_end; ++i) {
+      sum += bins[begin + i];
+      non_empty += bins[begin + i] > 0;
+    }
+    for (int i = level_begin; i < level_end; ++i) {
+      q[i] = bins[begin + i] > 0 ? sum / non_empty : 0;
+    }
+  }
+
+  const double p_sum = std::accumulate(p.begin(), p.end(), 0.0);
+  const double q_sum = std::accumulate(q.begin(), q.end(), 0.0);
+  if (p_sum <= 0 || q_sum <= 0) {
+    return std::numeric_limits<double>::infinity();
+  }
+  // The outliers added to empty bins at the ends have no quantized value
+  const double epsilon = 1e-10;
+  double divergence = 0;
+  for (int i = 0; i < size; ++i) {
+    if (p[i] > 0) {
+      const double p_i = p[i] / p_sum;
+      divergence += p_i * std::log(p_i / std::max(q[i] / q_sum, epsilon));
+    }
+  }
+  return divergence;
+}
+
+} // namespace
+
+void CalibrationHistogram::Add(const float* data, int size) {
+  if (size == 0) {
+    return;
+  }
+  const auto minmax = std::minmax_element(data, data + size);
+  const float min = empty_ ? *minmax.first : std::min(min_, *minmax.first);
+  const float max = empty_ ? *minmax.second : std::max(max_, *minmax.second);
+  const int num_bins = bins_.size();
+  const float width = (max - min) / num_bins;
+  if (!empty_ && (min < min_ || max > max_)) {
+    // Moves the counts of the old bins to the bins of their centers
+    const float old_width = (max_ - min_) / num_bins;
+    std::vector<double> bins(num_bins, 0.0);
+    for (int i = 0; i < num_bins; ++i) {
+      bins[GetBin(min_ + (i + 0.5f) * old_width, min, width, num_bins)] +=
+          bins_[i];
+    }
+    bins_.swap(bins);
+  }
+  min_ = min;
+  max_ = max;
+  empty_ = false;
+  for (int i = 0; i < size; ++i) {
+    bins_[GetBin(data[i], min, width, num_bins)] += 1;
+  }
+}
+
+int8::Int8QuantizationParams ChooseInt8QuantizationParams(
+    const CalibrationHistogram& histogram,
+    CalibrationMethod method,
+    float percentile) {
+  const auto& bins = histogram.bins();
+  const int num_bins = bins.size();
+  const float min = histogram.min();
+  const float width = (histogram.max() - min) / num_bins;
+  if (method == CalibrationMethod::MinMax || width <= 0 ||
+      num_bins <= kNumLevels) {
+    return int8::ChooseInt8QuantizationParams(min, histogram.max());
+  }
+
+  int begin = 0;
+  int end = num_bins;
+  if (method == CalibrationMethod::Percentile) {
+    // Clips the tails of the sides of zero
+    const double total = std::accumulate(bins.begin(), bins.end(), 0.0);
+    const double tail = (1.0 - percentile) * total;
+    const bool negative = min < 0;
+    const bool positive = histogram.max() > 0;
+    const double lower_tail = negative ? (positive ? tail / 2 : tail) : 0;
+    const double upper_tail = positive ? (negative ? tail / 2 : tail) : 0;
+    double sum = 0;
+    while (begin < num_bins - 1 && sum + bins[begin] <= lower_tail) {
+      sum += bins[begin++];
+    }
+    sum = 0;
+    while (end > begin + 1 && sum + bins[end - 1] <= upper_tail) {
+      sum += bins[--end];
+    }
+  } else {
+    // The candidate ranges clip the magnitude of the values to a threshold,
+    // i.e. only clip large values for Relu outputs. They have a bin for
+    // every level at least, as the divergence of coarser ones is meaningless
+    const int zero = std::min(
+        std::max(static_cast<int>(std::round(-min / width)), 0), num_bins);
+    double best = std::numeric_limits<double>::infinity();
+    for (int threshold = std::max(zero, num_bins - zero); threshold > 0;
+         --threshold) {
+      const int candidate_begin = std::max(zero - threshold, 0);
+      const int candidate_end = std::min(zero + threshold, num_bins);
+      if (candidate_end - candidate_begin < kNumLevels) {
+        break;
+      }
+      const double divergence =
+          GetQuantizationDivergence(bins, candidate_begin, candidate_end);
+      if (divergence < best) {
+        best = divergence;
+        begin = candidate_begin;
+        end = candidate_end;
+      }
+    }
+  }
+  return int8::ChooseInt8QuantizationParams(
+      min + begin * width, min + end * width);
+}
+
+CalibrationOperatorObserver::CalibrationOperatorObserver(
+    OperatorBase* op,
+    CalibrationNetObserver* netObserver)
+    : ObserverBase<OperatorBase>(op), netObserver_(netObserver) {
+  CAFFE_ENFORCE(netObserver_, "Observers can't operate outside of the net");
+}
+
+void CalibrationOperatorObserver::Start() {
+  if (!subject_->has_debug_def()) {
+    return;
+  }
+  const auto& def = subject_->debug_def();
+  for (int i = 0; i < def.input_size(); ++i) {
+    if (netObserver_->external_inputs_.count(def.input(i))) {
+      netObserver_->RecordInput(def.input(i), subject_->InputBlob(i));
+    }
+  }
+}
+
+void CalibrationOperatorObserver::Stop() {
+  if (!subject_->has_debug_def()) {
+    return;
+  }
+  const auto& def = subject_->debug_def();
+  for (int i = 0; i < def.output_size(); ++i) {
+    netObserver_->Record(def.output(i), *subject_->OutputBlob(i));
+  }
+}
+
+std::unique_ptr<ObserverBase<OperatorBase>>
+CalibrationOperatorObserver::rnnCopy(OperatorBase* subject, int rnn_order)
+    const {
+  return std::unique_ptr<ObserverBase<OperatorBase>>(
+      new CalibrationOperatorObserver(subject, netObserver_));
+}
+
+CalibrationNetObserver::CalibrationNetObserver(NetBase* subject, int num_bins)
+    : OperatorAttachingNetObserver<
+          CalibrationOperatorObserver,
+          CalibrationNetObserver>(subject, this),
+      num_bins_(num_bins),
+      external_inputs_(
+          subject->external_input().begin(),
+          subject->external_input().end()) {}
+
+std::unordered_map<std::string, int8::Int8QuantizationParams>
+CalibrationNetObserver::GetQuantizationParams(
+    CalibrationMethod method,
+    float percentile) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unordered_map<std::string, int8::Int8QuantizationParams> params;
+  for (const auto& histogram : histograms_) {
+    params[histogram.first] =
+        ChooseInt8QuantizationParams(histogram.second, method, percentile);
+  }
+  return params;
+}
+
+void CalibrationNetObserver::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  recorded_inputs_.clear();
+}
+
+void CalibrationNetObserver::Stop() {}
+
+void CalibrationNetObserver::Record(const std::string& name, const Blob& blob) {
+  if (!blob.IsType<TensorCPU>() || !blob.Get<TensorCPU>().IsType<float>()) {
+    return;
+  }
+  const auto& tensor = blob.Get<TensorCPU>();
+  std::lock_guard<std::mutex> lock(mutex_);
+  histograms_.emplace(name, CalibrationHistogram(num_bins_))
+      .first->second.Add(tensor.data<float>(), tensor.size());
+}
+
+void CalibrationNetObserver::RecordInput(
+    const std::string& name,
+    const Blob& blob) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!recorded_inputs_.insert(name).second) {
+      return;
+    }
+  }
+  Record(name, blob);
+}
+
+} // namespace caffe2
@@ -0,0 +1,119 @@
+#ifndef CAFFE2_CONTRIB_OBSERVERS_CALIBRATION_OBSERVER_H_
+#define CAFFE2_CONTRIB_OBSERVERS_CALIBRATION_OBSERVER_H_
+
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/observers/operator_attaching_net_observer.h"
+#include "caffe2/operators/quantized/int8_net_rewrite.h"
+
+namespace caffe2 {
+
+// Histogram of the values of a blob over [min, max], which is extended when
+// new values fall out of it
+class CalibrationHistogram {
+ public:
+  explicit CalibrationHistogram(int num_bins = 2048) : bins_(num_bins, 0) {}
+
+  void Add(const float* data, int size);
+
+  float min() const {
+    return min_;
+  }
+  float max() const {
+    return max_;
+  }
+  const std::vector<double>& bins() const {
+    return bins_;
+  }
+
+ private:
+  float min_{0.0f};
+  float max_{0.0f};
+  bool empty_{true};
+  std::vector<double> bins_;
+};
+
+enum class CalibrationMethod {
+  // The range of the values
+  MinMax,
+  // The range of the given percentile of the values, which clips outliers
+  Percentile,
+  // The range whose quantized distribution has the smallest KL divergence
+  // from the distribution of the values
+  KLDivergence,
+};
+
+int8::Int8QuantizationParams ChooseInt8QuantizationParams(
+    const CalibrationHistogram& histogram,
+    CalibrationMethod method,
+    float percentile = 0.9999f);
+
+class CalibrationNetObserver;
+class CalibrationOperatorObserver final : public ObserverBase<OperatorBase> {
+ public:
+  explicit CalibrationOperatorObserver(OperatorBase* op) = delete;
+  CalibrationOperatorObserver(
+      OperatorBase* op,
+      CalibrationNetObserver* netObserver);
+  std::unique_ptr<ObserverBase<OperatorBase>> rnnCopy(
+      OperatorBase* subject,
+      int rnn_order) const override;
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+ private:
+  CalibrationNetObserver* netObserver_;
+};
+
+/**
+ * Records the histograms of the float CPU tensors that the operators of the
+ * net write, and of its external inputs, while the net runs on
+ * representative data. The quantization params chosen from them can rewrite
+ * the net to the Int8 operators with int8::RewriteInt8Net.
+ */
+class CalibrationNetObserver final
+    : public OperatorAttachingNetObserver<
+          CalibrationOperatorObserver,
+          CalibrationNetObserver> {
+ public:
+  explicit CalibrationNetObserver(NetBase* subject, int num_bins = 2048);
+
+  std::unordered_map<std::string, int8::Int8QuantizationParams>
+  GetQuantizationParams(
+      CalibrationMethod method,
+      float percentile = 0.9999f) const;
+
+  const std::unordered_map<std::string, CalibrationHistogram>& histograms()
+      const {
+    return histograms_;
+  }
+
+  friend class CalibrationOperatorObserver;
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  void Record(const std::string& name, const Blob& blob);
+  void RecordInput(const std::string& name, const Blob& blob);
+
+  int num_bins_;
+  std::unordered_set<std::string> external_inputs_;
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, CalibrationHistogram> histograms_;
+  // External inputs recorded in the current run
+  std::unordered_set<std::string> recorded_inputs_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CONTRIB_OBSERVERS_CALIBRATION_OBSERVER_H_
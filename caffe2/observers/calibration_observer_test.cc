@@ -0,0 +1,134 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/proto_utils.h"
+#include "calibration_observer.h"
+
+#include <gtest/gtest.h>
+#include <random>
+
+namespace caffe2 {
+
+namespace {
+
+void FillTensor(
+    Workspace* ws,
+    const string& name,
+    const vector<TIndex>& dims,
+    float mean,
+    float stddev,
+    std::mt19937* generator) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  tensor->Resize(dims);
+  std::normal_distribution<float> distribution(mean, stddev);
+  for (int i = 0; i < tensor->size(); ++i) {
+    tensor->mutable_data<float>()[i] = distribution(*generator);
+  }
+}
+
+NetDef CreateConvNet() {
+  NetDef net;
+  net.set_name("calibration_test");
+  net.add_op()->CopyFrom(CreateOperatorDef(
+      "Conv",
+      "",
+      vector<string>{"X", "W", "b"},
+      vector<string>{"C"},
+      vector<Argument>{MakeArgument<int>("kernel", 3),
+                       MakeArgument<int>("pad", 1)}));
+  net.add_op()->CopyFrom(CreateOperatorDef(
+      "Relu", "", vector<string>{"C"}, vector<string>{"R"}));
+  net.add_op()->CopyFrom(CreateOperatorDef(
+      "MaxPool",
+      "",
+      vector<string>{"R"},
+      vector<string>{"Y"},
+      vector<Argument>{MakeArgument<int>("kernel", 2),
+                       MakeArgument<int>("stride", 2)}));
+  for (const string input : {"X", "W", "b"}) {
+    net.add_external_input(input);
+  }
+  net.add_external_output("Y");
+  return net;
+}
+
+} // namespace
+
+TEST(CalibrationObserverTest, ClipsOutliers) {
+  std::mt19937 generator(0);
+  std::normal_distribution<float> distribution(0.0f, 1.0f);
+  vector<float> values(10000);
+  for (auto& value : values) {
+    value = distribution(generator);
+  }
+  values[0] = 100.0f;
+  CalibrationHistogram histogram;
+  histogram.Add(values.data(), values.size() / 2);
+  histogram.Add(values.data() + values.size() / 2, values.size() / 2);
+  EXPECT_FLOAT_EQ(
+      histogram.min(), *std::min_element(values.begin(), values.end()));
+  EXPECT_FLOAT_EQ(histogram.max(), 100.0f);
+
+  const auto minmax =
+      ChooseInt8QuantizationParams(histogram, CalibrationMethod::MinMax);
+  const auto percentile = ChooseInt8QuantizationParams(
+      histogram, CalibrationMethod::Percentile, 0.999f);
+  const auto kl =
+      ChooseInt8QuantizationParams(histogram, CalibrationMethod::KLDivergence);
+  EXPECT_NEAR(minmax.scale, (100.0f - histogram.min()) / 255, 1e-5);
+  EXPECT_LT(percentile.scale, minmax.scale / 5);
+  EXPECT_LT(kl.scale, minmax.scale / 5);
+}
+
+TEST(CalibrationObserverTest, RewriteInt8Net) {
+  std::mt19937 generator(1);
+  Workspace ws;
+  FillTensor(&ws, "W", {8, 3, 3, 3}, 0.0f, 0.3f, &generator);
+  FillTensor(&ws, "b", {8}, 0.1f, 0.1f, &generator);
+  FillTensor(&ws, "X", {2, 3, 8, 8}, 0.0f, 1.0f, &generator);
+  const auto net_def = CreateConvNet();
+  auto net = CreateNet(net_def, &ws);
+  auto observer = caffe2::make_unique<CalibrationNetObserver>(net.get());
+  const auto* calibration = observer.get();
+  net->AttachObserver(std::move(observer));
+  for (int i = 0; i < 4; ++i) {
+    FillTensor(&ws, "X", {2, 3, 8, 8}, 0.0f, 1.0f, &generator);
+    ASSERT_TRUE(net->Run());
+  }
+  for (const string blob : {"X", "C", "R", "Y"}) {
+    EXPECT_TRUE(calibration->histograms().count(blob)) << blob;
+  }
+
+  const auto params =
+      calibration->GetQuantizationParams(CalibrationMethod::MinMax);
+  const auto int8_net_def = int8::RewriteInt8Net(net_def, params, &ws);
+  vector<string> types;
+  for (const auto& op : int8_net_def.op()) {
+    types.push_back(op.type());
+  }
+  EXPECT_EQ(
+      types,
+      vector<string>({"NCHW2NHWC",
+                      "Int8Quantize",
+                      "Int8Conv",
+                      "Int8Relu",
+                      "Int8MaxPool",
+                      "Int8Dequantize",
+                      "NHWC2NCHW"}));
+
+  // The last input of the calibration is in the range of its params
+  ASSERT_TRUE(ws.RunNetOnce(net_def));
+  TensorCPU Y;
+  Y.CopyFrom(ws.GetBlob("Y")->Get<TensorCPU>());
+  ws.RemoveBlob("Y");
+  ASSERT_TRUE(ws.RunNetOnce(int8_net_def));
+  const auto& int8_Y = ws.GetBlob("Y")->Get<TensorCPU>();
+  ASSERT_EQ(int8_Y.dims(), Y.dims());
+  // The errors of the quantization of the input, weights and output add up
+  const float tolerance = 8 * params.at("Y").scale;
+  for (int i = 0; i < Y.size(); ++i) {
+    EXPECT_NEAR(int8_Y.data<float>()[i], Y.data<float>()[i], tolerance);
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,159 @@
+#include "perf_counter_observer.h"
+
+#include <cerrno>
+#include <cstring>
+
+#include "caffe2/core/logging.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define CAFFE2_HAS_PERF_EVENT 1
+#endif
+
+namespace caffe2 {
+
+namespace {
+
+#ifdef CAFFE2_HAS_PERF_EVENT
+int OpenPerfEvent(uint32_t type, uint64_t config, int group_fd) {
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.read_format = PERF_FORMAT_GROUP;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  // this thread, on any CPU
+  return syscall(
+      __NR_perf_event_open, &attr, 0 /* pid */, -1 /* cpu */, group_fd, 0);
+}
+#endif
+
+} // namespace
+
+PerfCounters& PerfCounters::ForCurrentThread() {
+  static thread_local PerfCounters counters;
+  return counters;
+}
+
+PerfCounters::PerfCounters() {
+  for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+    fds_[i] = -1;
+    slots_[i] = -1;
+  }
+#ifdef CAFFE2_HAS_PERF_EVENT
+  const uint64_t configs[NUM_PERF_EVENTS] = {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES,
+      PERF_COUNT_HW_BRANCH_MISSES,
+  };
+  for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+    fds_[i] = OpenPerfEvent(PERF_TYPE_HARDWARE, configs[i], group_fd_);
+    if (fds_[i] < 0) {
+      if (i == PERF_CYCLES) {
+        VLOG(1) << "perf_event_open failed: " << strerror(errno)
+                << ", the hardware counters are disabled on this thread.";
+        return;
+      }
+      continue;
+    }
+    if (i == PERF_CYCLES) {
+      group_fd_ = fds_[i];
+    }
+    slots_[i] = num_slots_++;
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef CAFFE2_HAS_PERF_EVENT
+  for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+    if (fds_[i] >= 0) {
+      close(fds_[i]);
+    }
+  }
+#endif
+}
+
+bool PerfCounters::Read(uint64_t* values) const {
+#ifdef CAFFE2_HAS_PERF_EVENT
+  if (group_fd_ < 0) {
+    return false;
+  }
+  // PERF_FORMAT_GROUP: the number of events then their values
+  uint64_t buffer[1 + NUM_PERF_EVENTS];
+  const ssize_t size = (1 + num_slots_) * sizeof(uint64_t);
+  if (read(group_fd_, buffer, size) != size) {
+    return false;
+  }
+  for (int i = 0; i < NUM_PERF_EVENTS; ++i) {
+    values[i] = slots_[i] >= 0 ? buffer[1 + slots_[i]] : 0;
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::atomic<bool> PerfCounterObserver::enabled_{true};
+
+std::string PerfCounterObserver::debugInfo() {
+  return std::string("Hardware counters are ") +
+      (enabled() && PerfCounters::ForCurrentThread().available()
+           ? "enabled."
+           : "disabled.");
+}
+
+PerfCounterOperatorObserver::PerfCounterOperatorObserver(
+    OperatorBase* subject,
+    PerfCounterObserver* netObserver)
+    : ObserverBase<OperatorBase>(subject),
+      netObserver_(netObserver),
+      stats_("perf_counters/" + subject->debug_def().type()) {
+  CAFFE_ENFORCE(netObserver_, "Observers can't operate outside of the net");
+}
+
+void PerfCounterOperatorObserver::Start() {
+  started_ = PerfCounterObserver::enabled() &&
+      PerfCounters::ForCurrentThread().Read(start_values_);
+}
+
+void PerfCounterOperatorObserver::Stop() {
+  if (!started_) {
+    return;
+  }
+  started_ = false;
+  uint64_t values[NUM_PERF_EVENTS];
+  // an operator runs on one thread, whose counters Start read
+  if (!PerfCounters::ForCurrentThread().Read(values)) {
+    return;
+  }
+  CAFFE_EVENT(stats_, runs);
+  CAFFE_EVENT(
+      stats_, cycles, values[PERF_CYCLES] - start_values_[PERF_CYCLES]);
+  CAFFE_EVENT(
+      stats_,
+      instructions,
+      values[PERF_INSTRUCTIONS] - start_values_[PERF_INSTRUCTIONS]);
+  CAFFE_EVENT(
+      stats_,
+      llc_misses,
+      values[PERF_LLC_MISSES] - start_values_[PERF_LLC_MISSES]);
+  CAFFE_EVENT(
+      stats_,
+      branch_misses,
+      values[PERF_BRANCH_MISSES] - start_values_[PERF_BRANCH_MISSES]);
+}
+
+std::unique_ptr<ObserverBase<OperatorBase>>
+PerfCounterOperatorObserver::rnnCopy(OperatorBase* subject, int rnn_order)
+    const {
+  return std::unique_ptr<ObserverBase<OperatorBase>>(
+      new PerfCounterOperatorObserver(subject, netObserver_));
+}
+
+} // namespace caffe2
@@ -0,0 +1,123 @@
+#ifndef CAFFE2_CONTRIB_OBSERVERS_PERF_COUNTER_OBSERVER_H_
+#define CAFFE2_CONTRIB_OBSERVERS_PERF_COUNTER_OBSERVER_H_
+
+#include <atomic>
+#include <cstdint>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/observers/operator_attaching_net_observer.h"
+
+namespace caffe2 {
+
+// Hardware events counted around each operator
+enum PerfEvent {
+  PERF_CYCLES = 0,
+  PERF_INSTRUCTIONS,
+  PERF_LLC_MISSES,
+  PERF_BRANCH_MISSES,
+  NUM_PERF_EVENTS,
+};
+
+// perf_event counters of the calling thread, opened on its first use and
+// counting user space for as long as the thread lives. They are unavailable
+// outside of Linux and when the kernel refuses them (see
+// /proc/sys/kernel/perf_event_paranoid); events that the CPU doesn't support
+// read as 0.
+class PerfCounters {
+ public:
+  static PerfCounters& ForCurrentThread();
+
+  ~PerfCounters();
+
+  bool available() const {
+    return group_fd_ >= 0;
+  }
+
+  // Reads the NUM_PERF_EVENTS counters into values, with a single system call
+  // for the group. Returns false if they can't be read.
+  bool Read(uint64_t* values) const;
+
+ private:
+  PerfCounters();
+
+  int group_fd_ = -1;
+  int fds_[NUM_PERF_EVENTS];
+  // index in the values read from the group of each event, -1 when it isn't
+  // counted
+  int slots_[NUM_PERF_EVENTS];
+  int num_slots_ = 0;
+};
+
+class PerfCounterObserver;
+
+// Adds the events counted while its operator runs to the stats
+// perf_counters/<type>/{runs,cycles,instructions,llc_misses,branch_misses},
+// which the operators of the same type share in the StatRegistry. Only the
+// thread that runs the operator is counted, not the work it hands to others
+// such as the workspace thread pool.
+class PerfCounterOperatorObserver final : public ObserverBase<OperatorBase> {
+ public:
+  explicit PerfCounterOperatorObserver(OperatorBase* subject) = delete;
+  PerfCounterOperatorObserver(
+      OperatorBase* subject,
+      PerfCounterObserver* netObserver);
+  std::unique_ptr<ObserverBase<OperatorBase>> rnnCopy(
+      OperatorBase* subject,
+      int rnn_order) const override;
+
+ private:
+  void Start() override;
+  void Stop() override;
+
+  struct PerfCounterStats {
+    CAFFE_STAT_CTOR(PerfCounterStats);
+    CAFFE_EXPORTED_STAT(runs);
+    CAFFE_EXPORTED_STAT(cycles);
+    CAFFE_EXPORTED_STAT(instructions);
+    CAFFE_EXPORTED_STAT(llc_misses);
+    CAFFE_EXPORTED_STAT(branch_misses);
+  };
+
+  PerfCounterObserver* netObserver_;
+  PerfCounterStats stats_;
+  uint64_t start_values_[NUM_PERF_EVENTS];
+  // Start read the counters; Stop only counts the run if it did, so that
+  // toggling in the middle of an operator doesn't record garbage.
+  bool started_ = false;
+};
+
+// Attaches a PerfCounterOperatorObserver to every operator of the net. The
+// counting can be switched off and on at runtime for all the nets with
+// SetEnabled, which leaves a single relaxed load per operator when off.
+class PerfCounterObserver final : public OperatorAttachingNetObserver<
+                                      PerfCounterOperatorObserver,
+                                      PerfCounterObserver> {
+ public:
+  explicit PerfCounterObserver(NetBase* subject)
+      : OperatorAttachingNetObserver<
+            PerfCounterOperatorObserver,
+            PerfCounterObserver>(subject, this) {}
+
+  static void SetEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+  static bool enabled() {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  std::string debugInfo() override;
+
+ private:
+  void Start() override {}
+  void Stop() override {}
+
+  static std::atomic<bool> enabled_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CONTRIB_OBSERVERS_PERF_COUNTER_OBSERVER_H_
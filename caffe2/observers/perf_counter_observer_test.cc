@@ -0,0 +1,79 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+#include "perf_counter_observer.h"
+
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+class PerfCounterBusyOp final : public OperatorBase {
+ public:
+  using OperatorBase::OperatorBase;
+  bool Run(int /* unused */) override {
+    StartAllObservers();
+    volatile float x = 0;
+    for (int i = 0; i < 1000000; ++i) {
+      x = x + 1.0f;
+    }
+    StopAllObservers();
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(PerfCounterBusyOp, PerfCounterBusyOp);
+
+OPERATOR_SCHEMA(PerfCounterBusyOp).NumInputs(0, INT_MAX).NumOutputs(0, INT_MAX);
+
+unique_ptr<NetBase> CreateNetTestHelper(Workspace* ws) {
+  NetDef net_def;
+  for (int i = 0; i < 2; ++i) {
+    auto& op = *(net_def.add_op());
+    op.set_type("PerfCounterBusyOp");
+    op.add_input("in");
+    op.add_output("out");
+  }
+  net_def.add_external_input("in");
+  net_def.add_external_output("out");
+
+  return CreateNet(net_def, ws);
+}
+
+int64_t GetStat(const std::string& name) {
+  return toMap(StatRegistry::get().publish())[name];
+}
+} // namespace
+
+TEST(PerfCounterObserverTest, CountsPerOperatorType) {
+  Workspace ws;
+  ws.CreateBlob("in");
+  unique_ptr<NetBase> net(CreateNetTestHelper(&ws));
+  net->AttachObserver(caffe2::make_unique<PerfCounterObserver>(net.get()));
+  const int64_t runs = GetStat("perf_counters/PerfCounterBusyOp/runs");
+  const int64_t cycles = GetStat("perf_counters/PerfCounterBusyOp/cycles");
+  const int64_t instructions =
+      GetStat("perf_counters/PerfCounterBusyOp/instructions");
+
+  net->Run();
+  if (!PerfCounters::ForCurrentThread().available()) {
+    LOG(INFO) << "perf_event is unavailable, nothing was counted";
+    EXPECT_EQ(runs, GetStat("perf_counters/PerfCounterBusyOp/runs"));
+    return;
+  }
+  // both operators add up in the stats of their type
+  EXPECT_EQ(runs + 2, GetStat("perf_counters/PerfCounterBusyOp/runs"));
+  EXPECT_GT(GetStat("perf_counters/PerfCounterBusyOp/cycles"), cycles);
+  EXPECT_GT(
+      GetStat("perf_counters/PerfCounterBusyOp/instructions"),
+      instructions + 2 * 1000000);
+
+  PerfCounterObserver::SetEnabled(false);
+  net->Run();
+  PerfCounterObserver::SetEnabled(true);
+  EXPECT_EQ(runs + 2, GetStat("perf_counters/PerfCounterBusyOp/runs"));
+}
+} // namespace caffe2
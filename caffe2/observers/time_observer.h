@@ -61,6 +61,15 @@ class TimeObserver final
     return sum / subject_->GetOperators().size();
   }
 
+  // Average time of each operator, in the order of the operators of the net
+  std::vector<float> average_time_operators() const {
+    std::vector<float> times;
+    for (const auto* observer : operator_observers_) {
+      times.push_back(observer->average_time());
+    }
+    return times;
+  }
+
  private:
   void Start() override;
   void Stop() override;
@@ -14,9 +14,15 @@
 #include "google/protobuf/io/coded_stream.h"
 #include "google/protobuf/io/zero_copy_stream_impl_lite.h"
 
+#include <atomic>
 #include <cmath>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -52,6 +58,21 @@ bool TryConvertingTensorRawValues(
   return true;
 }
 
+// PyTorch marks the tensors whose raw data is exported to external files with
+// this raw_data.
+bool IsExternalData(const TensorProto& onnx_tensor) {
+  return onnx_tensor.has_raw_data() && onnx_tensor.raw_data() == "__EXTERNAL";
+}
+
+std::string ReadExternalData(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  CAFFE_ENFORCE(file, "Cannot open external data file: ", path);
+  std::string data(
+      (std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  CAFFE_ENFORCE(!file.bad(), "Error reading external data file: ", path);
+  return data;
+}
+
 bool IsOperator(const std::string& op_type) {
   // pull in all the operators upon first invocation
   // Intentional leaky
@@ -1170,7 +1191,8 @@ void Caffe2Backend::OnnxToCaffe2(
     const std::string& device,
     int opset_version,
     bool include_initializers,
-    const std::vector<Caffe2Ops>& extras) {
+    const std::vector<Caffe2Ops>& extras,
+    const std::string& external_data_dir) {
   auto device_option = GetDeviceOption(Device(device));
 
 #if !CAFFE2_MOBILE
@@ -1187,10 +1209,8 @@ void Caffe2Backend::OnnxToCaffe2(
 
   // Convert initializer if necessary
   if (include_initializers) {
-    for (const auto& tp : onnx_model.graph().initializer()) {
-      auto* c2_op = init_net->add_op();
-      BuildTensorFillingOp(c2_op, tp);
-    }
+    BuildInitializerFillingOps(
+        init_net, onnx_model.graph(), external_data_dir);
   }
 
   auto name_set = AllNamesInGraph(init_model.graph());
@@ -1254,7 +1274,8 @@ void Caffe2Backend::OnnxToCaffe2(
 Caffe2BackendRep* Caffe2Backend::Prepare(
     const std::string& onnx_model_str,
     const std::string& device,
-    const std::vector<Caffe2Ops>& extras) {
+    const std::vector<Caffe2Ops>& extras,
+    const std::string& external_data_dir) {
   Caffe2BackendRep* rep = new Caffe2BackendRep();
   ModelProto onnx_model;
   ParseProtoFromLargeString(onnx_model_str, &onnx_model);
@@ -1299,7 +1320,8 @@ Caffe2BackendRep* Caffe2Backend::Prepare(
       device,
       opset_version,
       true,
-      extras);
+      extras,
+      external_data_dir);
 
   // Get a list of uninitialized inputs to help with the inference setup
   auto& uninitialized_inputs = rep->uninitialized_inputs();
@@ -1316,6 +1338,62 @@ Caffe2BackendRep* Caffe2Backend::Prepare(
   return rep;
 }
 
+void Caffe2Backend::BuildInitializerFillingOps(
+    caffe2::NetDef* init_net,
+    const GraphProto& graph,
+    const std::string& external_data_dir) {
+  const auto& initializers = graph.initializer();
+  std::vector<caffe2::OperatorDef*> c2_ops;
+  for (int i = 0; i < initializers.size(); ++i) {
+    c2_ops.push_back(init_net->add_op());
+  }
+
+  std::atomic<int> next{0};
+  std::mutex error_mutex;
+  std::exception_ptr error;
+  auto work = [&]() {
+    for (int i = next++; i < initializers.size(); i = next++) {
+      try {
+        const auto& tp = initializers.Get(i);
+        if (!IsExternalData(tp)) {
+          BuildTensorFillingOp(c2_ops[i], tp);
+          continue;
+        }
+        CAFFE_ENFORCE(
+            !external_data_dir.empty(),
+            "Initializer ",
+            tp.name(),
+            " has external data, but no external data directory was given");
+        TensorProto resolved(tp);
+        resolved.set_raw_data(
+            ReadExternalData(external_data_dir + "/" + tp.name()));
+        BuildTensorFillingOp(c2_ops[i], resolved);
+      } catch (...) {
+        std::lock_guard<std::mutex> guard(error_mutex);
+        if (!error) {
+          error = std::current_exception();
+        }
+        return;
+      }
+    }
+  };
+
+  const int num_threads = std::min<int>(
+      initializers.size(),
+      std::max<unsigned>(std::thread::hardware_concurrency(), 1));
+  std::vector<std::thread> threads;
+  for (int i = 1; i < num_threads; ++i) {
+    threads.emplace_back(work);
+  }
+  work();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
 void Caffe2Backend::BuildTensorFillingOp(
     caffe2::OperatorDef* c2_op,
     const TensorProto& onnx_tensor,
@@ -122,10 +122,14 @@ class Caffe2Backend {
     }
   }
 
+  // The raw data of the initializers exported externally (raw_data set to
+  // "__EXTERNAL", as in the directory exports of PyTorch) is read from the
+  // file of their name in external_data_dir.
   Caffe2BackendRep* Prepare(
       const std::string& onnx_model_str,
       const std::string& device,
-      const std::vector<Caffe2Ops>& extras);
+      const std::vector<Caffe2Ops>& extras,
+      const std::string& external_data_dir = "");
 
   bool SupportOp(const std::string tyep) const;
 
@@ -146,7 +150,15 @@ class Caffe2Backend {
       const std::string& device,
       int opset_version,
       bool include_initializers,
-      const std::vector<Caffe2Ops>& extras);
+      const std::vector<Caffe2Ops>& extras,
+      const std::string& external_data_dir = "");
+
+  // Converts the initializers of the graph in parallel, since they are
+  // independent and large models have many large ones.
+  void BuildInitializerFillingOps(
+      caffe2::NetDef* init_net,
+      const GraphProto& graph,
+      const std::string& external_data_dir);
 
   void CheckOpSchemaArguments(const caffe2::OpSchema& schema, const caffe2::OperatorDef& op);
 
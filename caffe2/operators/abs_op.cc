@@ -37,6 +37,7 @@ REGISTER_CPU_OPERATOR(
 OPERATOR_SCHEMA(Abs)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .IdenticalTypeAndShape()
     .SetDoc(R"DOC(
 Calculates the absolute value of the given input tensor, element-wise.
@@ -0,0 +1,170 @@
+#include "caffe2/operators/alias_sampling_op.h"
+
+namespace caffe2 {
+
+void BuildAliasTable(int n, const float* weights, float* prob, int* alias) {
+  double sum = 0;
+  for (int i = 0; i < n; ++i) {
+    CAFFE_ENFORCE_GE(weights[i], 0, "All weights must be non-negative.");
+    sum += weights[i];
+  }
+  CAFFE_ENFORCE_GT(sum, 0, "At least one weight must be positive.");
+
+  // Scale the weights to an average of 1 and split them into the ones below
+  // and above the average. Each step fills the slot of one small weight with
+  // the remainder from a large one.
+  std::vector<double> scaled(n);
+  std::vector<int> small, large;
+  for (int i = 0; i < n; ++i) {
+    scaled[i] = weights[i] * n / sum;
+    (scaled[i] < 1.0 ? small : large).push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    const int s = small.back();
+    small.pop_back();
+    const int l = large.back();
+    prob[s] = scaled[s];
+    alias[s] = l;
+    scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+    if (scaled[l] < 1.0) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+  // What is left is 1 up to rounding errors.
+  for (const int i : large) {
+    prob[i] = 1.0f;
+    alias[i] = i;
+  }
+  for (const int i : small) {
+    prob[i] = 1.0f;
+    alias[i] = i;
+  }
+}
+
+template <>
+bool BuildAliasTableOp<CPUContext>::RunOnDevice() {
+  const auto& weights = Input(0);
+  CAFFE_ENFORCE_EQ(weights.ndim(), 1, "Input should be 1-D vector");
+  auto* prob = Output(0);
+  auto* alias = Output(1);
+  prob->ResizeLike(weights);
+  alias->ResizeLike(weights);
+  float* prob_data = prob->template mutable_data<float>();
+  int* alias_data = alias->template mutable_data<int>();
+  if (weights.size() > 0) {
+    BuildAliasTable(
+        weights.dim32(0),
+        weights.template data<float>(),
+        prob_data,
+        alias_data);
+  }
+  return true;
+}
+
+template <>
+void AliasMultiSamplingOp<CPUContext>::ResolveAliases(
+    int64_t num_samples,
+    const float* prob,
+    const int* alias,
+    const float* coins,
+    int* indices) {
+  for (int64_t i = 0; i < num_samples; ++i) {
+    const int index = indices[i];
+    indices[i] = coins[i] < prob[index] ? index : alias[index];
+  }
+}
+
+REGISTER_CPU_OPERATOR(BuildAliasTable, BuildAliasTableOp<CPUContext>);
+REGISTER_CPU_OPERATOR(AliasMultiSampling, AliasMultiSamplingOp<CPUContext>);
+
+OPERATOR_SCHEMA(BuildAliasTable)
+    .NumInputs(1)
+    .NumOutputs(2)
+    .TensorInferenceFunction([](const OperatorDef& /* unused */,
+                                const vector<TensorShape>& in) {
+      vector<TensorShape> out(2);
+      std::vector<int64_t> dims = GetDimsVector(in[0]);
+      out[0] = CreateTensorShape(dims, TensorProto::FLOAT);
+      out[1] = CreateTensorShape(dims, TensorProto::INT32);
+      return out;
+    })
+    .SetDoc(R"DOC(
+Builds the Walker alias table of the distribution given by the input
+sampling weights, in time linear in the number of weights. The table is
+meant to be built once and kept in the workspace, so that
+AliasMultiSampling can then draw any number of samples from it in
+constant time per sample, however many weights there are.
+)DOC")
+    .Input(
+        0,
+        "sampling_weights",
+        "A 1-D Tensor<float> of non-negative, not necessarily normalized, "
+        "sampling weights, at least one of which is positive.")
+    .Output(
+        0,
+        "alias_prob",
+        "A 1-D Tensor<float> of the same size: the probability of keeping "
+        "each index once it is drawn.")
+    .Output(
+        1,
+        "alias_index",
+        "A 1-D Tensor<int> of the same size: the index taken instead of each "
+        "index when it is not kept.");
+
+OPERATOR_SCHEMA(AliasMultiSampling)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .TensorInferenceFunction([](const OperatorDef& def,
+                                const vector<TensorShape>& in) {
+      vector<TensorShape> out(1);
+      if (in[0].dims(0) == 0) {
+        out[0].set_data_type(TensorProto::INT32);
+        out[0].add_dims(0);
+        return out;
+      }
+
+      const ArgumentHelper args(def);
+      if (args.HasArgument("num_samples")) {
+        CAFFE_ENFORCE_EQ(
+            in.size(),
+            2,
+            "New shape must not be specified by the input blob and the "
+            "argument `num_samples` at the same time.");
+        int num_samples = args.GetSingleArgument<int64_t>("num_samples", 0);
+        out[0] =
+            CreateTensorShape(vector<int64_t>{num_samples}, TensorProto::INT32);
+        return out;
+      } else {
+        CAFFE_ENFORCE_EQ(
+            in.size(),
+            3,
+            "New shape must be specified by either the input blob or the "
+            "argument `num_samples`.");
+        std::vector<int64_t> output_dims = GetDimsVector(in[2]);
+        out[0] = CreateTensorShape(output_dims, TensorProto::INT32);
+        return out;
+      }
+    })
+    .SetDoc(R"DOC(
+Draws samples with replacement from the distribution of an alias table built
+by BuildAliasTable, in constant time per sample. The output is a Tensor<int>
+of indices into the original sampling weights. If a third input is given, it
+provides the shape of the output; otherwise the argument `num_samples`
+determines the number of samples to draw.
+)DOC")
+    .Input(0, "alias_prob", "The first output of BuildAliasTable.")
+    .Input(1, "alias_index", "The second output of BuildAliasTable.")
+    .Input(
+        2,
+        "shape_tensor (optional)",
+        "Tensor whose shape will be applied to output.")
+    .Output(
+        0,
+        "sampled_indexes",
+        "The indices sampled from the distribution of the alias table.")
+    .Arg("num_samples", "number of samples to draw from the alias table");
+
+SHOULD_NOT_DO_GRADIENT(BuildAliasTable);
+SHOULD_NOT_DO_GRADIENT(AliasMultiSampling);
+} // namespace caffe2
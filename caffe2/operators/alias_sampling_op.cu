@@ -0,0 +1,69 @@
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/operators/alias_sampling_op.h"
+
+namespace caffe2 {
+namespace {
+
+__global__ void ResolveAliasesKernel(
+    const int64_t num_samples,
+    const float* prob,
+    const int* alias,
+    const float* coins,
+    int* indices) {
+  CUDA_1D_KERNEL_LOOP(i, num_samples) {
+    const int index = indices[i];
+    indices[i] = coins[i] < prob[index] ? index : alias[index];
+  }
+}
+
+} // namespace
+
+// The table is built once per distribution, so it is built on the host with
+// the sequential O(n) method and copied to the device.
+template <>
+bool BuildAliasTableOp<CUDAContext>::RunOnDevice() {
+  const auto& weights = Input(0);
+  CAFFE_ENFORCE_EQ(weights.ndim(), 1, "Input should be 1-D vector");
+  auto* prob = Output(0);
+  auto* alias = Output(1);
+  prob->ResizeLike(weights);
+  alias->ResizeLike(weights);
+  prob->template mutable_data<float>();
+  alias->template mutable_data<int>();
+  if (weights.size() == 0) {
+    return true;
+  }
+
+  TensorCPU weights_host(weights, &context_);
+  TensorCPU prob_host(weights.dims());
+  TensorCPU alias_host(weights.dims());
+  context_.FinishDeviceComputation();
+  BuildAliasTable(
+      weights.dim32(0),
+      weights_host.data<float>(),
+      prob_host.mutable_data<float>(),
+      alias_host.mutable_data<int>());
+  prob->CopyFrom(prob_host, &context_);
+  alias->CopyFrom(alias_host, &context_);
+  // The host tables go away when this returns.
+  context_.FinishDeviceComputation();
+  return true;
+}
+
+template <>
+void AliasMultiSamplingOp<CUDAContext>::ResolveAliases(
+    int64_t num_samples,
+    const float* prob,
+    const int* alias,
+    const float* coins,
+    int* indices) {
+  ResolveAliasesKernel<<<
+      CAFFE_GET_BLOCKS(num_samples),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(num_samples, prob, alias, coins, indices);
+}
+
+REGISTER_CUDA_OPERATOR(BuildAliasTable, BuildAliasTableOp<CUDAContext>);
+REGISTER_CUDA_OPERATOR(AliasMultiSampling, AliasMultiSamplingOp<CUDAContext>);
+} // namespace caffe2
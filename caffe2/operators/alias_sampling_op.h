@@ -0,0 +1,100 @@
+#ifndef CAFFE2_OPERATORS_ALIAS_SAMPLING_OP_H_
+#define CAFFE2_OPERATORS_ALIAS_SAMPLING_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Builds the Walker alias table of the distribution given by n non-negative
+// weights with Vose's O(n) method. Drawing i uniformly from [0, n) and
+// keeping it with probability prob[i], or taking alias[i] otherwise, samples
+// i with probability weights[i] / sum(weights).
+void BuildAliasTable(int n, const float* weights, float* prob, int* alias);
+
+template <class Context>
+class BuildAliasTableOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(BuildAliasTableOp);
+
+  bool RunOnDevice() override;
+};
+
+template <class Context>
+class AliasMultiSamplingOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  AliasMultiSamplingOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        num_samples_(
+            OperatorBase::GetSingleArgument<int64_t>("num_samples", 0)) {
+    CAFFE_ENFORCE_GE(num_samples_, 0);
+  }
+
+  bool RunOnDevice() override {
+    const auto& prob = Input(PROB);
+    const auto& alias = Input(ALIAS);
+    CAFFE_ENFORCE_EQ(prob.ndim(), 1, "The alias table should be 1-D");
+    CAFFE_ENFORCE_EQ(prob.dims(), alias.dims());
+    auto* indices = Output(0);
+
+    auto num_samples = num_samples_;
+    if (InputSize() == 3) {
+      CAFFE_ENFORCE(
+          !OperatorBase::HasArgument("num_samples"),
+          "New shape is specified by the input blob, do not pass in "
+          "the argument `num_samples`.");
+      num_samples = Input(SHAPE).size();
+      indices->ResizeLike(Input(SHAPE));
+    } else {
+      indices->Resize(num_samples);
+    }
+
+    const int table_size = prob.dim32(0);
+    if (table_size == 0) {
+      indices->Resize(0);
+    }
+    int* indices_data = indices->template mutable_data<int>();
+    if (table_size == 0 || num_samples == 0) {
+      return true;
+    }
+
+    // Every sample costs two random numbers and two table lookups, however
+    // large the table is.
+    math::RandUniform<int, Context>(
+        num_samples, 0, table_size - 1, indices_data, &context_);
+    coins_.Resize(num_samples);
+    float* coins_data = coins_.template mutable_data<float>();
+    math::RandUniform<float, Context>(
+        num_samples, 0.0f, 1.0f, coins_data, &context_);
+    ResolveAliases(
+        num_samples,
+        prob.template data<float>(),
+        alias.template data<int>(),
+        coins_data,
+        indices_data);
+    return true;
+  }
+
+ private:
+  // Replaces every drawn index i by alias[i] unless its coin is below
+  // prob[i].
+  void ResolveAliases(
+      int64_t num_samples,
+      const float* prob,
+      const int* alias,
+      const float* coins,
+      int* indices);
+
+  INPUT_TAGS(PROB, ALIAS, SHAPE);
+
+  const int64_t num_samples_;
+  Tensor<Context> coins_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_ALIAS_SAMPLING_OP_H_
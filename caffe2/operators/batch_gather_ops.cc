@@ -48,7 +48,11 @@ Example:
 )DOC")
     .Input(0, "DATA", "Tensor of rank r >= 2.")
     .Input(1, "INDICES", "Tensor of int32/int64 indices, of any rank q.")
-    .Output(0, "OUTPUT", "Tensor of rank (q - 1) + (r - 1).");
+    .Output(0, "OUTPUT", "Tensor of rank (q - 1) + (r - 1).")
+    .Arg(
+        "intra_op_parallel",
+        "Copy the output in parallel on the thread pool of the workspace "
+        "(CPU only)");
 
 OPERATOR_SCHEMA(BatchGatherGradient).NumInputs(3).NumOutputs(1);
 
@@ -3,15 +3,22 @@
 
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/operators/gather_op_util.h"
 #include "caffe2/utils/math.h"
 
 namespace caffe2 {
 
+// With the argument intra_op_parallel set, the CPU op copies chunks of the
+// output on the thread pool of the workspace.
 template <class Context>
 class BatchGatherOp final : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
-  USE_SIMPLE_CTOR_DTOR(BatchGatherOp)
+  BatchGatherOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        intra_op_parallel_(
+            OperatorBase::GetSingleArgument<bool>("intra_op_parallel", false)),
+        ws_(ws) {}
 
   bool RunOnDevice() override {
     return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
@@ -32,36 +39,37 @@ class BatchGatherOp final : public Operator<Context> {
     shape.insert(shape.end(), data.dims().begin() + 2, data.dims().end());
     output->Resize(shape);
 
-    auto block_size = data.size_from_dim(2);
-    auto block_bytesize = block_size * data.meta().itemsize();
     auto N = indices.size();
-    auto data_batch_bytesize = data.size_from_dim(1) * data.meta().itemsize();
-    auto gathered_batch_bytesize =
-        N * data.size_from_dim(2) * data.meta().itemsize();
     const TInd* idxs = indices.template data<TInd>();
-    auto src_base = static_cast<const char*>(data.raw_data());
-    auto out = static_cast<char*>(output->raw_mutable_data(data.meta()));
-
-    for (auto batch = 0; batch < data.dim(0); ++batch) {
-      for (auto i = 0; i < N; ++i) {
-        auto idx = idxs[i];
-        CAFFE_ENFORCE(
-            0 <= idx && idx < data.dim(1),
-            "INDICES element is out of DATA bounds, id=",
-            idx,
-            " data_dim=",
-            data.dim(1));
-        auto src =
-            src_base + idx * block_bytesize + batch * data_batch_bytesize;
-        auto dst = out + i * block_bytesize + batch * gathered_batch_bytesize;
-        context_.template CopyItems<Context, Context>(
-            data.meta(), block_size, src, dst);
-      }
+    for (auto i = 0; i < N; ++i) {
+      auto idx = idxs[i];
+      CAFFE_ENFORCE(
+          0 <= idx && idx < data.dim(1),
+          "INDICES element is out of DATA bounds, id=",
+          idx,
+          " data_dim=",
+          data.dim(1));
     }
+
+    gather_op_util::GatherBlocks(
+        data.meta(),
+        data.raw_data(),
+        data.dim(0),
+        data.dim(1),
+        idxs,
+        N,
+        data.size_from_dim(2),
+        output->raw_mutable_data(data.meta()),
+        &context_,
+        intra_op_parallel_ ? ws_->GetThreadPool() : nullptr);
     return true;
   }
 
   INPUT_TAGS(DATA, INDICES);
+
+ private:
+  bool intra_op_parallel_;
+  Workspace* ws_;
 };
 
 template <class Context>
@@ -86,9 +86,82 @@ bool BoxWithNMSLimitOp<CPUContext>::RunOnDevice() {
     out_keeps_size->Resize(batch_size, num_classes);
   }
 
+  // Offsets of the boxes of every image in tscores and tboxes
+  vector<int> batch_offsets(batch_size + 1, 0);
+  for (int b = 0; b < batch_size; ++b) {
+    batch_offsets[b + 1] = batch_offsets[b] + batch_splits(b);
+  }
+
+  // To store updated scores if SoftNMS is used
+  vector<ERArrXXf> soft_nms_scores(batch_size);
+  if (soft_nms_enabled_) {
+    for (int b = 0; b < batch_size; ++b) {
+      soft_nms_scores[b].resize(batch_splits(b), num_classes);
+    }
+  }
+  vector<vector<vector<int>>> batch_keeps(
+      batch_size, vector<vector<int>>(num_classes));
+
+  // Perform nms to each class of each image
+  // skip j = 0, because it's the background class
+  auto nms_for_class = [&](int b, int j) {
+    const int offset = batch_offsets[b];
+    const int num_boxes = batch_splits(b);
+    Eigen::Map<const ERArrXXf> scores(
+        tscores.data<float>() + offset * tscores.dim(1),
+        num_boxes,
+        tscores.dim(1));
+    Eigen::Map<const ERArrXXf> boxes(
+        tboxes.data<float>() + offset * tboxes.dim(1),
+        num_boxes,
+        tboxes.dim(1));
+
+    auto cur_scores = scores.col(j);
+    auto inds = utils::GetArrayIndices(cur_scores > score_thres_);
+    auto cur_boxes = boxes.block(0, j * box_dim, boxes.rows(), box_dim);
+
+    auto& keep = batch_keeps[b][j];
+    if (soft_nms_enabled_) {
+      auto cur_soft_nms_scores = soft_nms_scores[b].col(j);
+      keep = utils::soft_nms_cpu(
+          &cur_soft_nms_scores,
+          cur_boxes,
+          cur_scores,
+          inds,
+          soft_nms_sigma_,
+          nms_thres_,
+          soft_nms_min_score_thres_,
+          soft_nms_method_);
+    } else {
+      std::sort(
+          inds.data(),
+          inds.data() + inds.size(),
+          [&cur_scores](int lhs, int rhs) {
+            return cur_scores(lhs) > cur_scores(rhs);
+          });
+      keep = utils::nms_cpu(cur_boxes, cur_scores, inds, nms_thres_);
+    }
+  };
+  const int num_fg_classes = std::max(num_classes - 1, 0);
+  const size_t num_tasks = static_cast<size_t>(batch_size) * num_fg_classes;
+  if (intra_op_parallel_ && num_tasks > 1) {
+    // Every task only writes to its own keep list and soft NMS score column
+    ws_->GetThreadPool()->run(
+        [&](int /* unused */, size_t task) {
+          nms_for_class(task / num_fg_classes, task % num_fg_classes + 1);
+        },
+        num_tasks);
+  } else {
+    for (int b = 0; b < batch_size; ++b) {
+      for (int j = 1; j < num_classes; j++) {
+        nms_for_class(b, j);
+      }
+    }
+  }
+
   vector<int> total_keep_per_batch(batch_size);
-  int offset = 0;
   for (int b = 0; b < batch_splits.size(); ++b) {
+    const int offset = batch_offsets[b];
     int num_boxes = batch_splits(b);
     Eigen::Map<const ERArrXXf> scores(
         tscores.data<float>() + offset * tscores.dim(1),
@@ -98,48 +171,19 @@ bool BoxWithNMSLimitOp<CPUContext>::RunOnDevice() {
         tboxes.data<float>() + offset * tboxes.dim(1),
         num_boxes,
         tboxes.dim(1));
+    auto& keeps = batch_keeps[b];
 
-    // To store updated scores if SoftNMS is used
-    ERArrXXf soft_nms_scores(num_boxes, tscores.dim(1));
-    vector<vector<int>> keeps(num_classes);
-
-    // Perform nms to each class
-    // skip j = 0, because it's the background class
     int total_keep_count = 0;
     for (int j = 1; j < num_classes; j++) {
-      auto cur_scores = scores.col(j);
-      auto inds = utils::GetArrayIndices(cur_scores > score_thres_);
-      auto cur_boxes = boxes.block(0, j * box_dim, boxes.rows(), box_dim);
-
-      if (soft_nms_enabled_) {
-        auto cur_soft_nms_scores = soft_nms_scores.col(j);
-        keeps[j] = utils::soft_nms_cpu(
-            &cur_soft_nms_scores,
-            cur_boxes,
-            cur_scores,
-            inds,
-            soft_nms_sigma_,
-            nms_thres_,
-            soft_nms_min_score_thres_,
-            soft_nms_method_);
-      } else {
-        std::sort(
-            inds.data(),
-            inds.data() + inds.size(),
-            [&cur_scores](int lhs, int rhs) {
-              return cur_scores(lhs) > cur_scores(rhs);
-            });
-        keeps[j] = utils::nms_cpu(cur_boxes, cur_scores, inds, nms_thres_);
-      }
       total_keep_count += keeps[j].size();
     }
 
     if (soft_nms_enabled_) {
       // Re-map scores to the updated SoftNMS scores
       new (&scores) Eigen::Map<const ERArrXXf>(
-          soft_nms_scores.data(),
-          soft_nms_scores.rows(),
-          soft_nms_scores.cols());
+          soft_nms_scores[b].data(),
+          soft_nms_scores[b].rows(),
+          soft_nms_scores[b].cols());
     }
 
     // Limit to max_per_image detections *over all classes*
@@ -232,8 +276,6 @@ bool BoxWithNMSLimitOp<CPUContext>::RunOnDevice() {
         cur_out_idx += keeps[j].size();
       }
     }
-
-    offset += num_boxes;
   }
 
   if (OutputSize() > 3) {
@@ -280,6 +322,10 @@ returned boxes.
         "bool (default false). If true, then boxes (rois and deltas) include "
         "angle info to handle rotation. The format will be "
         "[ctr_x, ctr_y, width, height, angle (in degrees)].")
+    .Arg(
+        "intra_op_parallel",
+        "bool (default false). If set, the CPU op applies NMS to the classes "
+        "of all images in parallel on the thread pool of the workspace.")
     .Input(0, "scores", "Scores, size (count, num_classes)")
     .Input(
         1,
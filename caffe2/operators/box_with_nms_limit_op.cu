@@ -0,0 +1,407 @@
+#include <algorithm>
+
+#include <cub/cub.cuh>
+
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/operators/box_with_nms_limit_op.h"
+#include "caffe2/operators/generate_proposals_op_util_nms_gpu.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Transposes the scores from (N, num_classes) to (num_classes, N), so that
+// the scores of every (image, class) pair are contiguous, and stores the row
+// of every score as the value to sort along.
+__global__ void TransposeClassScoresKernel(
+    const int N,
+    const int num_classes,
+    const float* scores,
+    float* transposed_scores,
+    int* rows) {
+  CUDA_1D_KERNEL_LOOP(index, N * num_classes) {
+    const int row = index / num_classes;
+    const int j = index % num_classes;
+    transposed_scores[j * N + row] = scores[index];
+    rows[j * N + row] = row;
+  }
+}
+
+// Counts the scores above the threshold at the start of every segment of
+// scores sorted from high to low.
+__global__ void CountAboveThresholdKernel(
+    const int num_segments,
+    const int* segment_begins,
+    const int* segment_ends,
+    const float* sorted_scores,
+    const float thresh,
+    int* counts) {
+  CUDA_1D_KERNEL_LOOP(s, num_segments) {
+    int lo = segment_begins[s];
+    int hi = segment_ends[s];
+    while (lo < hi) {
+      const int mid = lo + (hi - lo) / 2;
+      if (sorted_scores[mid] > thresh) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    counts[s] = lo - segment_begins[s];
+  }
+}
+
+// Gathers the boxes of all foreground classes in the order of the sorted
+// scores.
+__global__ void GatherClassBoxesKernel(
+    const int N,
+    const int num_classes,
+    const float4* boxes,
+    const int* sorted_rows,
+    float4* sorted_boxes) {
+  CUDA_1D_KERNEL_LOOP(index, N * (num_classes - 1)) {
+    const int p = index + N;
+    const int j = p / N;
+    sorted_boxes[p] = boxes[sorted_rows[p] * num_classes + j];
+  }
+}
+
+// Writes the detections at the given positions of the sorted (class, box)
+// pairs
+__global__ void WriteDetectionsKernel(
+    const int num_detections,
+    const int N,
+    const int* positions,
+    const float* sorted_scores,
+    const float4* sorted_boxes,
+    float* out_scores,
+    float4* out_boxes,
+    float* out_classes) {
+  CUDA_1D_KERNEL_LOOP(d, num_detections) {
+    const int p = positions[d];
+    out_scores[d] = sorted_scores[p];
+    out_boxes[d] = sorted_boxes[p];
+    out_classes[d] = p / N;
+  }
+}
+
+} // namespace
+
+template <>
+bool BoxWithNMSLimitOp<CUDAContext>::RunOnDevice() {
+  const auto& tscores = Input(0);
+  const auto& tboxes = Input(1);
+  auto* out_scores = Output(0);
+  auto* out_boxes = Output(1);
+  auto* out_classes = Output(2);
+
+  CAFFE_ENFORCE(
+      !rotated_, "The CUDA BoxWithNMSLimit op only supports upright boxes");
+  CAFFE_ENFORCE(
+      !soft_nms_enabled_,
+      "The CUDA BoxWithNMSLimit op doesn't support SoftNMS");
+  const int box_dim = 4;
+
+  // tscores: (num_boxes, num_classes), 0 for background
+  if (tscores.ndim() == 4) {
+    CAFFE_ENFORCE_EQ(tscores.dim(2), 1, tscores.dim(2));
+    CAFFE_ENFORCE_EQ(tscores.dim(3), 1, tscores.dim(3));
+  } else {
+    CAFFE_ENFORCE_EQ(tscores.ndim(), 2, tscores.ndim());
+  }
+  CAFFE_ENFORCE(tscores.template IsType<float>(), tscores.meta().name());
+  // tboxes: (num_boxes, num_classes * box_dim)
+  if (tboxes.ndim() == 4) {
+    CAFFE_ENFORCE_EQ(tboxes.dim(2), 1, tboxes.dim(2));
+    CAFFE_ENFORCE_EQ(tboxes.dim(3), 1, tboxes.dim(3));
+  } else {
+    CAFFE_ENFORCE_EQ(tboxes.ndim(), 2, tboxes.ndim());
+  }
+  CAFFE_ENFORCE(tboxes.template IsType<float>(), tboxes.meta().name());
+
+  int N = tscores.dim(0);
+  int num_classes = tscores.dim(1);
+
+  CAFFE_ENFORCE_EQ(N, tboxes.dim(0));
+  CAFFE_ENFORCE_EQ(num_classes * box_dim, tboxes.dim(1));
+
+  int batch_size = 1;
+  vector<float> batch_splits(1, N);
+  if (InputSize() > 2) {
+    // tscores and tboxes have items from multiple images in a batch. Get the
+    // corresponding batch splits from input.
+    const auto& tbatch_splits = Input(2);
+    CAFFE_ENFORCE_EQ(tbatch_splits.ndim(), 1);
+    batch_size = tbatch_splits.dim(0);
+    batch_splits.resize(batch_size);
+    context_.Copy<float, CUDAContext, CPUContext>(
+        batch_size, tbatch_splits.data<float>(), batch_splits.data());
+    context_.FinishDeviceComputation();
+  }
+  vector<int> batch_offsets(batch_size + 1, 0);
+  for (int b = 0; b < batch_size; ++b) {
+    batch_offsets[b + 1] = batch_offsets[b] + batch_splits[b];
+  }
+  CAFFE_ENFORCE_EQ(batch_offsets[batch_size], N);
+
+  // Segment s = b * (num_classes - 1) + j - 1 holds the scores of class j of
+  // image b; skip j = 0, because it's the background class
+  const int num_fg_classes = std::max(num_classes - 1, 0);
+  const int num_segments = batch_size * num_fg_classes;
+  vector<int> segments(2 * num_segments);
+  for (int b = 0; b < batch_size; ++b) {
+    for (int j = 1; j < num_classes; ++j) {
+      const int s = b * num_fg_classes + j - 1;
+      segments[s] = j * N + batch_offsets[b];
+      segments[num_segments + s] = j * N + batch_offsets[b + 1];
+    }
+  }
+
+  vector<int> counts(num_segments, 0);
+  vector<float> sorted_scores;
+  vector<int> sorted_rows;
+  vector<size_t> mask_offsets(num_segments + 1, 0);
+  const float* d_sorted_scores = nullptr;
+  const float4* d_sorted_boxes = nullptr;
+  const uint64_t* h_mask = nullptr;
+  if (N > 0 && num_segments > 0) {
+    dev_scores_.Resize(N * num_classes);
+    dev_rows_.Resize(N * num_classes);
+    dev_sorted_scores_.Resize(N * num_classes);
+    dev_sorted_rows_.Resize(N * num_classes);
+    dev_sorted_boxes_.Resize(N * num_classes, box_dim);
+    dev_segments_.Resize(2 * num_segments);
+    dev_counts_.Resize(num_segments);
+    float* d_scores = dev_scores_.mutable_data<float>();
+    int* d_rows = dev_rows_.mutable_data<int>();
+    float* d_sorted_scores_out = dev_sorted_scores_.mutable_data<float>();
+    int* d_sorted_rows = dev_sorted_rows_.mutable_data<int>();
+    float4* d_sorted_boxes_out =
+        reinterpret_cast<float4*>(dev_sorted_boxes_.mutable_data<float>());
+    int* d_segments = dev_segments_.mutable_data<int>();
+    int* d_counts = dev_counts_.mutable_data<int>();
+
+    TransposeClassScoresKernel<<<
+        CAFFE_GET_BLOCKS(N * num_classes),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        N, num_classes, tscores.data<float>(), d_scores, d_rows);
+    context_.CopyToDeviceAsync(
+        segments.size() * sizeof(int), segments.data(), d_segments);
+
+    // Sort the scores of all (image, class) pairs from high to low
+    size_t cub_bytes = 0;
+    cub::DeviceSegmentedRadixSort::SortPairsDescending(
+        nullptr,
+        cub_bytes,
+        d_scores,
+        d_sorted_scores_out,
+        d_rows,
+        d_sorted_rows,
+        N * num_classes,
+        num_segments,
+        d_segments,
+        d_segments + num_segments,
+        0,
+        8 * sizeof(float),
+        context_.cuda_stream());
+    dev_cub_buffer_.Resize(cub_bytes);
+    cub::DeviceSegmentedRadixSort::SortPairsDescending(
+        static_cast<void*>(dev_cub_buffer_.mutable_data<uint8_t>()),
+        cub_bytes,
+        d_scores,
+        d_sorted_scores_out,
+        d_rows,
+        d_sorted_rows,
+        N * num_classes,
+        num_segments,
+        d_segments,
+        d_segments + num_segments,
+        0,
+        8 * sizeof(float),
+        context_.cuda_stream());
+
+    CountAboveThresholdKernel<<<
+        CAFFE_GET_BLOCKS(num_segments),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        num_segments,
+        d_segments,
+        d_segments + num_segments,
+        d_sorted_scores_out,
+        score_thres_,
+        d_counts);
+    GatherClassBoxesKernel<<<
+        CAFFE_GET_BLOCKS(N * num_fg_classes),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        N,
+        num_classes,
+        reinterpret_cast<const float4*>(tboxes.data<float>()),
+        d_sorted_rows,
+        d_sorted_boxes_out);
+    context_.Copy<int, CUDAContext, CPUContext>(
+        num_segments, d_counts, counts.data());
+    context_.FinishDeviceComputation();
+
+    // Compute the NMS bitmasks of all segments before copying them, and the
+    // sorted scores and rows of the foreground classes, to the host at once
+    for (int s = 0; s < num_segments; ++s) {
+      mask_offsets[s + 1] = mask_offsets[s] +
+          static_cast<size_t>(counts[s]) * utils::nms_gpu_mask_words(counts[s]);
+    }
+    const size_t mask_size = std::max<size_t>(mask_offsets[num_segments], 1);
+    dev_nms_mask_.Resize(mask_size);
+    host_nms_mask_.Resize(mask_size);
+    uint64_t* d_mask =
+        reinterpret_cast<uint64_t*>(dev_nms_mask_.mutable_data<int64_t>());
+    for (int s = 0; s < num_segments; ++s) {
+      utils::nms_gpu_mask_upright(
+          reinterpret_cast<const float*>(d_sorted_boxes_out + segments[s]),
+          counts[s],
+          nms_thres_,
+          d_mask + mask_offsets[s],
+          &context_);
+    }
+    context_.CopyBytes<CUDAContext, CPUContext>(
+        mask_offsets[num_segments] * sizeof(uint64_t),
+        d_mask,
+        host_nms_mask_.mutable_data<int64_t>());
+    sorted_scores.resize(N * num_classes);
+    sorted_rows.resize(N * num_classes);
+    context_.Copy<float, CUDAContext, CPUContext>(
+        N * num_fg_classes, d_sorted_scores_out + N, sorted_scores.data() + N);
+    context_.Copy<int, CUDAContext, CPUContext>(
+        N * num_fg_classes, d_sorted_rows + N, sorted_rows.data() + N);
+    context_.FinishDeviceComputation();
+
+    d_sorted_scores = d_sorted_scores_out;
+    d_sorted_boxes = d_sorted_boxes_out;
+    h_mask = reinterpret_cast<const uint64_t*>(host_nms_mask_.data<int64_t>());
+  }
+
+  // positions: indices of the detections in the sorted (class, box) pairs
+  vector<int> positions;
+  vector<int> out_keeps_data;
+  vector<int> out_keeps_size_data(batch_size * num_classes, 0);
+  vector<float> total_keep_per_batch(batch_size);
+  for (int b = 0; b < batch_size; ++b) {
+    // keeps[j]: positions of the boxes of class j that survive NMS, from
+    // high to low score
+    vector<vector<int>> keeps(num_classes);
+    int total_keep_count = 0;
+    for (int j = 1; j < num_classes; j++) {
+      const int s = b * num_fg_classes + j - 1;
+      if (counts[s] == 0) {
+        continue;
+      }
+      for (int k : utils::nms_gpu_sweep(
+               h_mask + mask_offsets[s], counts[s], /* topN */ -1)) {
+        keeps[j].push_back(segments[s] + k);
+      }
+      total_keep_count += keeps[j].size();
+    }
+
+    // Limit to max_per_image detections *over all classes*
+    if (detections_per_im_ > 0 && total_keep_count > detections_per_im_) {
+      // merge all scores together and sort
+      vector<float> all_scores_sorted;
+      all_scores_sorted.reserve(total_keep_count);
+      for (int j = 1; j < num_classes; j++) {
+        for (int p : keeps[j]) {
+          all_scores_sorted.push_back(sorted_scores[p]);
+        }
+      }
+      std::sort(all_scores_sorted.begin(), all_scores_sorted.end());
+
+      // Compute image thres based on all classes
+      const float image_thresh =
+          all_scores_sorted[all_scores_sorted.size() - detections_per_im_];
+
+      total_keep_count = 0;
+      // filter results with image_thresh
+      for (int j = 1; j < num_classes; j++) {
+        auto& cur_keep = keeps[j];
+        cur_keep.erase(
+            std::remove_if(
+                cur_keep.begin(),
+                cur_keep.end(),
+                [&](int p) { return sorted_scores[p] < image_thresh; }),
+            cur_keep.end());
+        total_keep_count += cur_keep.size();
+      }
+    }
+    total_keep_per_batch[b] = total_keep_count;
+
+    for (int j = 1; j < num_classes; j++) {
+      for (int p : keeps[j]) {
+        positions.push_back(p);
+        // keeps are indices of the boxes within their image
+        out_keeps_data.push_back(sorted_rows[p] - batch_offsets[b]);
+      }
+      out_keeps_size_data[b * num_classes + j] = keeps[j].size();
+    }
+  }
+
+  // Write results
+  const int num_detections = positions.size();
+  out_scores->Resize(num_detections);
+  out_boxes->Resize(num_detections, box_dim);
+  out_classes->Resize(num_detections);
+  float* out_scores_ptr = out_scores->mutable_data<float>();
+  float* out_boxes_ptr = out_boxes->mutable_data<float>();
+  float* out_classes_ptr = out_classes->mutable_data<float>();
+  if (num_detections > 0) {
+    dev_positions_.Resize(num_detections);
+    int* d_positions = dev_positions_.mutable_data<int>();
+    context_.CopyToDeviceAsync(
+        num_detections * sizeof(int), positions.data(), d_positions);
+    WriteDetectionsKernel<<<
+        CAFFE_GET_BLOCKS(num_detections),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        num_detections,
+        N,
+        d_positions,
+        d_sorted_scores,
+        d_sorted_boxes,
+        out_scores_ptr,
+        reinterpret_cast<float4*>(out_boxes_ptr),
+        out_classes_ptr);
+  }
+
+  if (OutputSize() > 3) {
+    auto* batch_splits_out = Output(3);
+    batch_splits_out->Resize(batch_size);
+    context_.CopyToDeviceAsync(
+        batch_size * sizeof(float),
+        total_keep_per_batch.data(),
+        batch_splits_out->mutable_data<float>());
+  }
+
+  if (OutputSize() > 4) {
+    auto* out_keeps = Output(4);
+    auto* out_keeps_size = Output(5);
+    out_keeps->Resize(num_detections);
+    out_keeps_size->Resize(batch_size, num_classes);
+    int* out_keeps_ptr = out_keeps->mutable_data<int>();
+    if (num_detections > 0) {
+      context_.CopyToDeviceAsync(
+          num_detections * sizeof(int), out_keeps_data.data(), out_keeps_ptr);
+    }
+    context_.CopyToDeviceAsync(
+        out_keeps_size_data.size() * sizeof(int),
+        out_keeps_size_data.data(),
+        out_keeps_size->mutable_data<int>());
+  }
+
+  return true;
+}
+
+REGISTER_CUDA_OPERATOR(BoxWithNMSLimit, BoxWithNMSLimitOp<CUDAContext>);
+
+} // namespace caffe2
@@ -9,6 +9,13 @@
 namespace caffe2 {
 
 // C++ implementation of function insert_box_results_with_nms_and_limit()
+//
+// With the argument intra_op_parallel set, the CPU op applies NMS to every
+// (image, class) pair of the batch as a separate task on the thread pool of
+// the workspace; the detections_per_im limit and the outputs are still
+// computed on the calling thread. The CUDA op only supports upright boxes
+// without soft NMS; it sorts the scores of all (image, class) pairs with one
+// segmented radix sort and runs bitmask NMS on the device.
 template <class Context>
 class BoxWithNMSLimitOp final : public Operator<Context> {
  public:
@@ -30,7 +37,10 @@ class BoxWithNMSLimitOp final : public Operator<Context> {
         soft_nms_min_score_thres_(OperatorBase::GetSingleArgument<float>(
             "soft_nms_min_score_thres",
             0.001)),
-        rotated_(OperatorBase::GetSingleArgument<bool>("rotated", false)) {
+        rotated_(OperatorBase::GetSingleArgument<bool>("rotated", false)),
+        intra_op_parallel_(
+            OperatorBase::GetSingleArgument<bool>("intra_op_parallel", false)),
+        ws_(ws) {
     CAFFE_ENFORCE(
         soft_nms_method_str_ == "linear" || soft_nms_method_str_ == "gaussian",
         "Unexpected soft_nms_method");
@@ -60,6 +70,22 @@ class BoxWithNMSLimitOp final : public Operator<Context> {
   // Set for RRPN case to handle rotated boxes. Inputs should be in format
   // [ctr_x, ctr_y, width, height, angle (in degrees)].
   bool rotated_{false};
+  // Apply NMS to different images and classes in parallel on the CPU
+  bool intra_op_parallel_{false};
+  Workspace* ws_;
+
+  // Scratch space of the CUDA implementation
+  Tensor<Context> dev_scores_;
+  Tensor<Context> dev_rows_;
+  Tensor<Context> dev_sorted_scores_;
+  Tensor<Context> dev_sorted_rows_;
+  Tensor<Context> dev_sorted_boxes_;
+  Tensor<Context> dev_segments_;
+  Tensor<Context> dev_counts_;
+  Tensor<Context> dev_nms_mask_;
+  Tensor<Context> dev_positions_;
+  Tensor<Context> dev_cub_buffer_;
+  TensorCPU host_nms_mask_;
 };
 
 } // namespace caffe2
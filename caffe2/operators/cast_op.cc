@@ -88,6 +88,7 @@ REGISTER_CPU_OPERATOR(Cast, CastOp<CPUContext>);
 OPERATOR_SCHEMA(Cast)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<0>)
     .TensorInferenceFunction([](const OperatorDef& def,
                                 const vector<TensorShape>& in) {
       ArgumentHelper helper(def);
@@ -9,6 +9,7 @@ REGISTER_CPU_OPERATOR(Ceil, CeilOp<float, CPUContext>);
 OPERATOR_SCHEMA(Ceil)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .AllowInplace({{0, 0}})
     .SetDoc(R"DOC(
 Element-wise application of the ceil function ($y=ceil(x)$) to the input tensor
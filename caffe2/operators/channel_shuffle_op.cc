@@ -22,6 +22,7 @@ OPERATOR_SCHEMA(ChannelShuffle)
     .IdenticalTypeAndShape()
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<0>)
     .InheritOnnxSchema("ChannelShuffle");
 OPERATOR_SCHEMA(ChannelShuffleGradient)
     .IdenticalTypeAndShape()
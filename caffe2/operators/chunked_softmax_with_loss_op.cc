@@ -0,0 +1,286 @@
+#include "caffe2/operators/chunked_softmax_with_loss_op.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "caffe2/utils/eigen_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+// logits = X * W[begin:begin+C]^T + b[begin:begin+C], an N x C matrix.
+void ComputeLogits(
+    const float* X,
+    const float* W,
+    const float* b,
+    const float* bias_multiplier,
+    int N,
+    int D,
+    int C,
+    float* logits,
+    CPUContext* context) {
+  math::Gemm<float, CPUContext>(
+      CblasNoTrans, CblasTrans, N, C, D, 1, X, W, 0, logits, context);
+  math::Gemm<float, CPUContext>(
+      CblasNoTrans,
+      CblasNoTrans,
+      N,
+      C,
+      1,
+      1,
+      bias_multiplier,
+      b,
+      1,
+      logits,
+      context);
+}
+
+} // namespace
+
+template <>
+bool ChunkedSoftmaxWithLossOp<float, CPUContext>::RunOnDevice() {
+  const auto& X = Input(0);
+  const auto& W = Input(1);
+  const auto& b = Input(2);
+  const auto& labels = Input(3);
+  auto* avg_loss = Output(0);
+  auto* lse = Output(1);
+
+  CAFFE_ENFORCE_GE(X.ndim(), 2);
+  const int N = X.dim32(0);
+  const int D = X.size_from_dim(1);
+  CAFFE_ENFORCE_EQ(W.ndim(), 2);
+  CAFFE_ENFORCE_EQ(W.dim32(1), D, "W must be V x D");
+  const int V = W.dim32(0);
+  CAFFE_ENFORCE_EQ(b.size(), V);
+  CAFFE_ENFORCE_EQ(labels.size(), N);
+  CAFFE_ENFORCE_GT(V, 0);
+
+  const int* labels_data = labels.data<int>();
+  for (int i = 0; i < N; ++i) {
+    CAFFE_ENFORCE(
+        labels_data[i] >= 0 && labels_data[i] < V,
+        "Label ",
+        labels_data[i],
+        " is out of the range [0, ",
+        V,
+        ")");
+  }
+
+  const int C = std::min(chunk_size_, V);
+  logits_.Resize(N, C);
+  rowmax_.Resize(N);
+  rowsum_.Resize(N);
+  target_logit_.Resize(N);
+  lse->Resize(N);
+  if (bias_multiplier_.size() != N) {
+    bias_multiplier_.Resize(N);
+    math::Set<float, CPUContext>(
+        N, 1.f, bias_multiplier_.mutable_data<float>(), &context_);
+  }
+
+  float* logits_data = logits_.mutable_data<float>();
+  float* rowmax_data = rowmax_.mutable_data<float>();
+  float* rowsum_data = rowsum_.mutable_data<float>();
+  float* target_logit_data = target_logit_.mutable_data<float>();
+  std::fill(
+      rowmax_data, rowmax_data + N, std::numeric_limits<float>::lowest());
+  std::fill(rowsum_data, rowsum_data + N, 0.f);
+
+  for (int begin = 0; begin < V; begin += C) {
+    const int size = std::min(C, V - begin);
+    ComputeLogits(
+        X.data<float>(),
+        W.data<float>() + static_cast<TIndex>(begin) * D,
+        b.data<float>() + begin,
+        bias_multiplier_.data<float>(),
+        N,
+        D,
+        size,
+        logits_data,
+        &context_);
+    // Online log-sum-exp: rescale the sum of the previous chunks when the max
+    // of the row grows.
+    ConstEigenArrayMap<float> logits_mat(logits_data, size, N);
+    for (int i = 0; i < N; ++i) {
+      const float chunk_max = logits_mat.col(i).maxCoeff();
+      const float new_max = std::max(rowmax_data[i], chunk_max);
+      rowsum_data[i] = rowsum_data[i] * std::exp(rowmax_data[i] - new_max) +
+          (logits_mat.col(i) - new_max).exp().sum();
+      rowmax_data[i] = new_max;
+      const int label = labels_data[i] - begin;
+      if (label >= 0 && label < size) {
+        target_logit_data[i] = logits_mat(label, i);
+      }
+    }
+  }
+
+  float* lse_data = lse->mutable_data<float>();
+  float loss_sum = 0;
+  for (int i = 0; i < N; ++i) {
+    lse_data[i] = rowmax_data[i] + std::log(rowsum_data[i]);
+    loss_sum += lse_data[i] - target_logit_data[i];
+  }
+
+  avg_loss->Resize(vector<TIndex>());
+  float* avg_loss_data = avg_loss->mutable_data<float>();
+  avg_loss_data[0] = N > 0 ? loss_sum * scale_ / N : 0.f;
+  return true;
+}
+
+template <>
+bool ChunkedSoftmaxWithLossGradientOp<float, CPUContext>::RunOnDevice() {
+  const auto& X = Input(0);
+  const auto& W = Input(1);
+  const auto& b = Input(2);
+  const auto& labels = Input(3);
+  const auto& lse = Input(4);
+  const auto& d_avg_loss = Input(5);
+  auto* dX = Output(0);
+  auto* dW = Output(1);
+  auto* db = Output(2);
+
+  const int N = X.dim32(0);
+  const int D = X.size_from_dim(1);
+  const int V = W.dim32(0);
+  CAFFE_ENFORCE_EQ(lse.size(), N);
+  dX->ResizeLike(X);
+  dW->ResizeLike(W);
+  db->ResizeLike(b);
+  math::Set<float, CPUContext>(
+      dX->size(), 0.f, dX->mutable_data<float>(), &context_);
+  if (N == 0) {
+    math::Set<float, CPUContext>(
+        dW->size(), 0.f, dW->mutable_data<float>(), &context_);
+    math::Set<float, CPUContext>(
+        db->size(), 0.f, db->mutable_data<float>(), &context_);
+    return true;
+  }
+
+  const int C = std::min(chunk_size_, V);
+  dlogits_.Resize(N, C);
+  if (bias_multiplier_.size() != N) {
+    bias_multiplier_.Resize(N);
+    math::Set<float, CPUContext>(
+        N, 1.f, bias_multiplier_.mutable_data<float>(), &context_);
+  }
+
+  const int* labels_data = labels.data<int>();
+  const float* lse_data = lse.data<float>();
+  const float coef = scale_ / N * d_avg_loss.data<float>()[0];
+  float* dlogits_data = dlogits_.mutable_data<float>();
+
+  for (int begin = 0; begin < V; begin += C) {
+    const int size = std::min(C, V - begin);
+    const float* W_chunk = W.data<float>() + static_cast<TIndex>(begin) * D;
+    ComputeLogits(
+        X.data<float>(),
+        W_chunk,
+        b.data<float>() + begin,
+        bias_multiplier_.data<float>(),
+        N,
+        D,
+        size,
+        dlogits_data,
+        &context_);
+    // dlogits = (softmax(logits) - onehot(label)) * coef
+    EigenArrayMap<float> dlogits_mat(dlogits_data, size, N);
+    for (int i = 0; i < N; ++i) {
+      dlogits_mat.col(i) = (dlogits_mat.col(i) - lse_data[i]).exp() * coef;
+      const int label = labels_data[i] - begin;
+      if (label >= 0 && label < size) {
+        dlogits_mat(label, i) -= coef;
+      }
+    }
+    math::Gemm<float, CPUContext>(
+        CblasTrans,
+        CblasNoTrans,
+        size,
+        D,
+        N,
+        1,
+        dlogits_data,
+        X.data<float>(),
+        0,
+        dW->mutable_data<float>() + static_cast<TIndex>(begin) * D,
+        &context_);
+    math::Gemv<float, CPUContext>(
+        CblasTrans,
+        N,
+        size,
+        1,
+        dlogits_data,
+        bias_multiplier_.data<float>(),
+        0,
+        db->mutable_data<float>() + begin,
+        &context_);
+    math::Gemm<float, CPUContext>(
+        CblasNoTrans,
+        CblasNoTrans,
+        N,
+        D,
+        size,
+        1,
+        dlogits_data,
+        W_chunk,
+        1,
+        dX->mutable_data<float>(),
+        &context_);
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(
+    ChunkedSoftmaxWithLoss,
+    ChunkedSoftmaxWithLossOp<float, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    ChunkedSoftmaxWithLossGradient,
+    ChunkedSoftmaxWithLossGradientOp<float, CPUContext>);
+
+OPERATOR_SCHEMA(ChunkedSoftmaxWithLoss)
+    .NumInputs(4)
+    .NumOutputs(2)
+    .SetDoc(R"DOC(
+Computes the average cross entropy loss of a softmax over a large vocabulary
+projected from the input, i.e. FC followed by SoftmaxWithLoss, without
+materializing the N x V logits. The vocabulary is processed chunk_size classes
+at a time, keeping a running max and sum of exponentials for each row, so the
+scratch memory is bounded by N x chunk_size. The log-sum-exp of each row is
+returned for the gradient operator, which recomputes the logits chunk by chunk.
+)DOC")
+    .Arg("scale", "Average loss output scaling factor (must be >= 0).")
+    .Arg(
+        "chunk_size",
+        "*(type: int; default: 4096)* Number of classes whose logits are "
+        "computed at a time.")
+    .Input(0, "X", "Input of shape N x D (or N x ... flattened to N x D).")
+    .Input(1, "W", "Projection weights of shape V x D.")
+    .Input(2, "b", "Projection bias of shape V.")
+    .Input(3, "labels", "1D int tensor of N labels in [0, V).")
+    .Output(0, "avg_loss", "Scalar average loss.")
+    .Output(1, "lse", "1D tensor of the N log-sum-exp of the logits.");
+
+OPERATOR_SCHEMA(ChunkedSoftmaxWithLossGradient).NumInputs(6).NumOutputs(3);
+
+namespace {
+
+class GetChunkedSoftmaxWithLossGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "ChunkedSoftmaxWithLossGradient",
+        "",
+        // X, W, b, labels, lse, d_avg_loss
+        vector<string>{I(0), I(1), I(2), I(3), O(1), GO(0)},
+        // dX, dW, db
+        vector<string>{GI(0), GI(1), GI(2)});
+  }
+};
+
+} // namespace
+
+REGISTER_GRADIENT(ChunkedSoftmaxWithLoss, GetChunkedSoftmaxWithLossGradient);
+
+} // namespace caffe2
@@ -0,0 +1,65 @@
+#ifndef CAFFE2_OPERATORS_CHUNKED_SOFTMAX_WITH_LOSS_OP_H_
+#define CAFFE2_OPERATORS_CHUNKED_SOFTMAX_WITH_LOSS_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Fuses the FC projection X * W^T + b onto a large vocabulary with
+// SoftmaxWithLoss. The logits are computed chunk_size classes at a time and
+// folded into a running max and sum of exponentials per row, so the scratch
+// memory is N * chunk_size instead of N * V. Only the log-sum-exp of each row
+// is kept for the gradient, which recomputes the logits with the same chunks.
+template <typename T, class Context>
+class ChunkedSoftmaxWithLossOp final : public Operator<Context> {
+ public:
+  ChunkedSoftmaxWithLossOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        scale_(OperatorBase::GetSingleArgument<float>("scale", 1.)),
+        chunk_size_(OperatorBase::GetSingleArgument<int>("chunk_size", 4096)) {
+    CAFFE_ENFORCE(scale_ >= 0);
+    CAFFE_ENFORCE_GT(chunk_size_, 0);
+  }
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override;
+
+ protected:
+  float scale_;
+  int chunk_size_;
+
+  Tensor<Context> logits_; // N x chunk_size logits of the current chunk
+  Tensor<Context> rowmax_; // running max of each row
+  Tensor<Context> rowsum_; // running sum of exp(logit - rowmax) of each row
+  Tensor<Context> target_logit_; // logit of the label of each row
+  Tensor<Context> bias_multiplier_;
+};
+
+template <typename T, class Context>
+class ChunkedSoftmaxWithLossGradientOp final : public Operator<Context> {
+ public:
+  ChunkedSoftmaxWithLossGradientOp(const OperatorDef& def, Workspace* ws)
+      : Operator<Context>(def, ws),
+        scale_(OperatorBase::GetSingleArgument<float>("scale", 1.)),
+        chunk_size_(OperatorBase::GetSingleArgument<int>("chunk_size", 4096)) {
+    CAFFE_ENFORCE(scale_ >= 0);
+    CAFFE_ENFORCE_GT(chunk_size_, 0);
+  }
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  bool RunOnDevice() override;
+
+ protected:
+  float scale_;
+  int chunk_size_;
+
+  Tensor<Context> dlogits_; // N x chunk_size gradient of the current chunk
+  Tensor<Context> bias_multiplier_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_CHUNKED_SOFTMAX_WITH_LOSS_OP_H_
@@ -38,6 +38,7 @@ REGISTER_CPU_OPERATOR(ClipGradient, ClipGradientOp<float, CPUContext>);
 OPERATOR_SCHEMA(Clip)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<2>)
     .AllowInplace({{0, 0}})
     .IdenticalTypeAndShape()
     .SetDoc(R"DOC(
@@ -0,0 +1,718 @@
+#include "caffe2/operators/columnar_dataset_ops.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/types.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
+
+namespace caffe2 {
+
+CAFFE_KNOWN_TYPE(dataset_ops::SharedColumnarDatasetPtr);
+
+namespace dataset_ops {
+namespace {
+
+const char kColumnarDatasetMagic[8] = {'C', '2', 'C', 'O', 'L', 'D', 'S', '\0'};
+const uint32_t kColumnarDatasetVersion = 1;
+
+inline bool isString(const TypeMeta& meta) {
+  return meta.Match<std::string>();
+}
+
+inline uint64_t alignUp(uint64_t pos) {
+  const uint64_t alignment = ColumnarDataset::kColumnAlignment;
+  return (pos + alignment - 1) / alignment * alignment;
+}
+
+template <typename T>
+void appendPod(std::string& out, const T& value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Reads the header of a columnar dataset file, enforcing that it stays
+// within the file.
+class HeaderReader {
+ public:
+  HeaderReader(const char* data, size_t bytes, const std::string& path)
+      : data_(data), bytes_(bytes), path_(path) {}
+
+  template <typename T>
+  T read() {
+    T value;
+    std::memcpy(&value, advance(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  std::string readString(size_t size) {
+    return std::string(advance(size), size);
+  }
+
+ private:
+  const char* advance(size_t size) {
+    CAFFE_ENFORCE_LE(
+        size, bytes_ - pos_, "Truncated columnar dataset header: ", path_);
+    const char* ptr = data_ + pos_;
+    pos_ += size;
+    return ptr;
+  }
+
+  const char* data_;
+  size_t bytes_;
+  size_t pos_ = 0;
+  const std::string& path_;
+};
+
+} // namespace
+
+constexpr size_t ColumnarDataset::kColumnAlignment;
+
+void ColumnarDataset::Write(
+    const std::string& path,
+    const std::vector<std::string>& fields,
+    const std::vector<const TensorCPU*>& tensors) {
+  TreeIterator iterator(fields);
+  CAFFE_ENFORCE_EQ(fields.size(), tensors.size());
+  std::vector<bool> isLength(fields.size(), false);
+  for (const auto id : iterator.lengthFieldIds()) {
+    isLength[id] = true;
+  }
+
+  // the offsets of the length and string columns, and the size of every
+  // domain, to check that the fields are consistent
+  std::vector<std::vector<TOffset>> offsets(fields.size());
+  std::vector<TOffset> limits(
+      iterator.numOffsetFields(), std::numeric_limits<TOffset>::max());
+  for (int i = 0; i < fields.size(); ++i) {
+    const auto& tensor = *tensors[i];
+    CAFFE_ENFORCE_GT(tensor.ndim(), 0, "Field ", fields[i], " has no dims");
+    CAFFE_ENFORCE(
+        TypeMetaToDataType(tensor.meta()) != TensorProto_DataType_UNDEFINED,
+        "Field ",
+        fields[i],
+        " has an unsupported type: ",
+        tensor.meta().name());
+    const int domain = iterator.fields()[i].lengthFieldId + 1;
+    if (limits[domain] == std::numeric_limits<TOffset>::max()) {
+      limits[domain] = tensor.dim(0);
+    }
+    CAFFE_ENFORCE_EQ(
+        limits[domain],
+        tensor.dim(0),
+        "Inconsistent sizes for fields belonging to the same domain. Field: ",
+        fields[i]);
+    if (isLength[i]) {
+      CAFFE_ENFORCE_EQ(tensor.ndim(), 1, "Length field must be 1-D");
+      const TLength* lengths = tensor.data<TLength>();
+      auto& offs = offsets[i];
+      offs.resize(tensor.size() + 1);
+      offs[0] = 0;
+      for (TIndex k = 0; k < tensor.size(); ++k) {
+        CAFFE_ENFORCE_GE(lengths[k], 0, "Negative length in ", fields[i]);
+        offs[k + 1] = offs[k] + lengths[k];
+      }
+    } else if (isString(tensor.meta())) {
+      const std::string* strings = tensor.data<std::string>();
+      auto& offs = offsets[i];
+      offs.resize(tensor.size() + 1);
+      offs[0] = 0;
+      for (TIndex k = 0; k < tensor.size(); ++k) {
+        offs[k + 1] = offs[k] + strings[k].size();
+      }
+    }
+  }
+  for (int j = 0; j < iterator.numLengthFields(); ++j) {
+    const auto& offs = offsets[iterator.lengthField(j).id];
+    CAFFE_ENFORCE(
+        limits[j + 1] == std::numeric_limits<TOffset>::max() ||
+            limits[j + 1] == offs.back(),
+        "The lengths of ",
+        iterator.lengthField(j).name,
+        " add up to ",
+        offs.back(),
+        " but its domain has ",
+        limits[j + 1],
+        " entries");
+  }
+
+  // lay out the file: the header, then the offsets and values of every
+  // column
+  uint64_t headerBytes = sizeof(kColumnarDatasetMagic) + 2 * sizeof(uint32_t);
+  for (int i = 0; i < fields.size(); ++i) {
+    headerBytes += sizeof(uint32_t) + fields[i].size() + sizeof(int32_t) +
+        sizeof(uint32_t) + tensors[i]->ndim() * sizeof(int64_t) +
+        3 * sizeof(uint64_t);
+  }
+  std::vector<uint64_t> offsetsPos(fields.size(), 0);
+  std::vector<uint64_t> valuesPos(fields.size());
+  std::vector<uint64_t> valuesBytes(fields.size());
+  uint64_t pos = headerBytes;
+  for (int i = 0; i < fields.size(); ++i) {
+    if (!offsets[i].empty()) {
+      offsetsPos[i] = pos = alignUp(pos);
+      pos += offsets[i].size() * sizeof(TOffset);
+    }
+    valuesBytes[i] = isString(tensors[i]->meta()) ? offsets[i].back()
+                                                  : tensors[i]->nbytes();
+    valuesPos[i] = pos = alignUp(pos);
+    pos += valuesBytes[i];
+  }
+
+  std::string header;
+  header.reserve(headerBytes);
+  header.append(kColumnarDatasetMagic, sizeof(kColumnarDatasetMagic));
+  appendPod(header, kColumnarDatasetVersion);
+  appendPod(header, static_cast<uint32_t>(fields.size()));
+  for (int i = 0; i < fields.size(); ++i) {
+    appendPod(header, static_cast<uint32_t>(fields[i].size()));
+    header.append(fields[i]);
+    appendPod(
+        header, static_cast<int32_t>(TypeMetaToDataType(tensors[i]->meta())));
+    appendPod(header, static_cast<uint32_t>(tensors[i]->ndim()));
+    for (const auto d : tensors[i]->dims()) {
+      appendPod(header, static_cast<int64_t>(d));
+    }
+    appendPod(header, offsetsPos[i]);
+    appendPod(header, valuesPos[i]);
+    appendPod(header, valuesBytes[i]);
+  }
+  CAFFE_ENFORCE_EQ(header.size(), headerBytes);
+
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  CAFFE_ENFORCE(out, "Cannot open columnar dataset file for writing: ", path);
+  out.write(header.data(), header.size());
+  pos = headerBytes;
+  const auto padTo = [&](uint64_t target) {
+    static const char zeros[kColumnAlignment] = {};
+    out.write(zeros, target - pos);
+    pos = target;
+  };
+  for (int i = 0; i < fields.size(); ++i) {
+    if (!offsets[i].empty()) {
+      padTo(offsetsPos[i]);
+      const auto bytes = offsets[i].size() * sizeof(TOffset);
+      out.write(reinterpret_cast<const char*>(offsets[i].data()), bytes);
+      pos += bytes;
+    }
+    padTo(valuesPos[i]);
+    if (isString(tensors[i]->meta())) {
+      const std::string* strings = tensors[i]->data<std::string>();
+      for (TIndex k = 0; k < tensors[i]->size(); ++k) {
+        out.write(strings[k].data(), strings[k].size());
+      }
+    } else {
+      out.write(
+          static_cast<const char*>(tensors[i]->raw_data()), valuesBytes[i]);
+    }
+    pos += valuesBytes[i];
+  }
+  out.close();
+  CAFFE_ENFORCE(out, "Error writing columnar dataset file: ", path);
+}
+
+ColumnarDataset::ColumnarDataset(const std::string& path) : path_(path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  CAFFE_ENFORCE(
+      fd >= 0,
+      "Error opening columnar dataset file: ",
+      std::strerror(errno),
+      " Path=",
+      path);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    CAFFE_THROW("Error reading columnar dataset file: ", std::strerror(errno));
+  }
+  bytes_ = st.st_size;
+  if (bytes_ > 0) {
+    // A private writable mapping, so that ops that write to the tensors
+    // viewing the columns get copies of the pages instead of a crash.
+    data_ = mmap(
+        nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (data_ == MAP_FAILED || data_ == nullptr) {
+    data_ = nullptr;
+    CAFFE_THROW("Error mapping columnar dataset file: ", path);
+  }
+  const char* data = static_cast<const char*>(data_);
+
+  HeaderReader reader(data, bytes_, path_);
+  CAFFE_ENFORCE(
+      reader.readString(sizeof(kColumnarDatasetMagic)) ==
+          std::string(kColumnarDatasetMagic, sizeof(kColumnarDatasetMagic)),
+      "Not a columnar dataset file: ",
+      path);
+  const auto version = reader.read<uint32_t>();
+  CAFFE_ENFORCE_EQ(
+      version, kColumnarDatasetVersion, "Unsupported columnar dataset version");
+  const auto numColumns = reader.read<uint32_t>();
+  columns_.resize(numColumns);
+  std::vector<std::string> fields(numColumns);
+  std::vector<uint64_t> offsetsPos(numColumns);
+  std::vector<uint64_t> valuesPos(numColumns);
+  std::vector<uint64_t> valuesBytes(numColumns);
+  for (int i = 0; i < numColumns; ++i) {
+    auto& column = columns_[i];
+    column.name = fields[i] = reader.readString(reader.read<uint32_t>());
+    column.meta = DataTypeToTypeMeta(
+        static_cast<TensorProto_DataType>(reader.read<int32_t>()));
+    column.dims.resize(reader.read<uint32_t>());
+    for (auto& d : column.dims) {
+      d = reader.read<int64_t>();
+      CAFFE_ENFORCE_GE(d, 0);
+    }
+    CAFFE_ENFORCE(!column.dims.empty(), "Column ", column.name, " has no dims");
+    offsetsPos[i] = reader.read<uint64_t>();
+    valuesPos[i] = reader.read<uint64_t>();
+    valuesBytes[i] = reader.read<uint64_t>();
+  }
+
+  iterator_.reset(new TreeIterator(fields));
+  std::vector<bool> isLength(numColumns, false);
+  for (const auto id : iterator_->lengthFieldIds()) {
+    isLength[id] = true;
+  }
+  limits_.assign(
+      iterator_->numOffsetFields(), std::numeric_limits<TOffset>::max());
+  const auto enforceInFile = [&](uint64_t pos, uint64_t size) {
+    CAFFE_ENFORCE(
+        pos <= bytes_ && size <= bytes_ - pos,
+        "Truncated columnar dataset file: ",
+        path_);
+  };
+  for (int i = 0; i < numColumns; ++i) {
+    auto& column = columns_[i];
+    TIndex size = 1;
+    for (const auto d : column.dims) {
+      size *= d;
+    }
+    const bool hasOffsets = isLength[i] || isString(column.meta);
+    CAFFE_ENFORCE_EQ(
+        hasOffsets, offsetsPos[i] != 0, "Bad offsets of column ", column.name);
+    if (hasOffsets) {
+      CAFFE_ENFORCE_EQ(offsetsPos[i] % alignof(TOffset), 0);
+      enforceInFile(offsetsPos[i], (size + 1) * sizeof(TOffset));
+      column.offsets =
+          reinterpret_cast<const TOffset*>(data + offsetsPos[i]);
+    }
+    CAFFE_ENFORCE_EQ(
+        valuesBytes[i],
+        isString(column.meta) ? column.offsets[size]
+                              : size * column.meta.itemsize(),
+        "Bad values of column ",
+        column.name);
+    enforceInFile(valuesPos[i], valuesBytes[i]);
+    column.values = data + valuesPos[i];
+
+    const int domain = iterator_->fields()[i].lengthFieldId + 1;
+    if (limits_[domain] == std::numeric_limits<TOffset>::max()) {
+      limits_[domain] = column.dims[0];
+    }
+    CAFFE_ENFORCE_EQ(
+        limits_[domain],
+        column.dims[0],
+        "Inconsistent sizes for fields belonging to the same domain. Field: ",
+        column.name);
+  }
+  for (int j = 0; j < iterator_->numLengthFields(); ++j) {
+    const auto& column = columns_[iterator_->lengthField(j).id];
+    const TOffset total = column.offsets[column.dims[0]];
+    if (limits_[j + 1] == std::numeric_limits<TOffset>::max()) {
+      limits_[j + 1] = total;
+    }
+    CAFFE_ENFORCE_EQ(
+        limits_[j + 1], total, "Inconsistent lengths of ", column.name);
+  }
+}
+
+ColumnarDataset::~ColumnarDataset() {
+  if (data_) {
+    munmap(data_, bytes_);
+  }
+}
+
+void ColumnarDataset::domainRanges(
+    std::vector<TOffset>& begin,
+    std::vector<TOffset>& end) const {
+  CAFFE_ENFORCE(
+      0 <= begin.at(0) && begin[0] <= end.at(0) && end[0] <= size(),
+      "Entries [",
+      begin[0],
+      ", ",
+      end[0],
+      ") out of range in a dataset of ",
+      size());
+  begin.resize(numDomains());
+  end.resize(numDomains());
+  // length fields come before the fields of their domains, so the range of
+  // a parent domain is known when its child domain is reached
+  for (int j = 0; j < iterator_->numLengthFields(); ++j) {
+    const auto& lengthField = iterator_->lengthField(j);
+    const int parent = iterator_->offsetFieldIdFor(lengthField);
+    const TOffset* offsets = columns_[lengthField.id].offsets;
+    begin[j + 1] = offsets[begin[parent]];
+    end[j + 1] = offsets[end[parent]];
+  }
+}
+
+namespace {
+
+// Checks that the cursor iterates over the fields of the dataset.
+void enforceCursorFields(TreeCursor& cursor, const ColumnarDataset& dataset) {
+  const auto& fields = cursor.it.fields();
+  const auto& columns = dataset.columns();
+  CAFFE_ENFORCE_EQ(fields.size(), columns.size());
+  for (int i = 0; i < fields.size(); ++i) {
+    CAFFE_ENFORCE_EQ(
+        fields[i].name, columns[i].name, "Cursor and dataset fields differ");
+  }
+}
+
+// Resizes out to size entries of column and returns the number of bytes per
+// entry.
+size_t resizeOutput(
+    const ColumnarDataset::Column& column,
+    TOffset size,
+    TensorCPU* out) {
+  auto dims = column.dims;
+  dims[0] = size;
+  out->Resize(dims);
+  return out->size_from_dim(1) * column.meta.itemsize();
+}
+
+// Copies the count entries of column starting at entry src to the entries of
+// dst starting at entry dstBegin.
+void copyEntries(
+    const ColumnarDataset::Column& column,
+    TOffset src,
+    TOffset count,
+    TIndex innerSize,
+    void* dst,
+    TOffset dstBegin) {
+  if (isString(column.meta)) {
+    std::string* strings = static_cast<std::string*>(dst) + dstBegin * innerSize;
+    for (TOffset k = src * innerSize; k < (src + count) * innerSize; ++k) {
+      strings->assign(
+          column.values + column.offsets[k], column.values + column.offsets[k + 1]);
+      ++strings;
+    }
+  } else {
+    const size_t entryBytes = innerSize * column.meta.itemsize();
+    std::memcpy(
+        static_cast<char*>(dst) + dstBegin * entryBytes,
+        column.values + src * entryBytes,
+        count * entryBytes);
+  }
+}
+
+class WriteColumnarDatasetOp : public Operator<CPUContext> {
+ public:
+  WriteColumnarDatasetOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws),
+        fields_(OperatorBase::GetRepeatedArgument<std::string>("fields")),
+        filename_(OperatorBase::GetSingleArgument<std::string>("filename", "")) {
+    CAFFE_ENFORCE(!filename_.empty(), "filename arg must be non-empty");
+  }
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(InputSize(), fields_.size());
+    std::vector<const TensorCPU*> tensors;
+    for (int i = 0; i < InputSize(); ++i) {
+      tensors.push_back(&Input(i));
+    }
+    ColumnarDataset::Write(filename_, fields_, tensors);
+    return true;
+  }
+
+ private:
+  std::vector<std::string> fields_;
+  std::string filename_;
+};
+
+class OpenColumnarDatasetOp : public Operator<CPUContext> {
+ public:
+  OpenColumnarDatasetOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws),
+        filename_(OperatorBase::GetSingleArgument<std::string>("filename", "")) {
+    CAFFE_ENFORCE(!filename_.empty(), "filename arg must be non-empty");
+  }
+
+  bool RunOnDevice() override {
+    *OperatorBase::Output<SharedColumnarDatasetPtr>(0) =
+        std::make_shared<const ColumnarDataset>(filename_);
+    return true;
+  }
+
+ private:
+  std::string filename_;
+};
+
+class ReadNextColumnarBatchOp : public Operator<CPUContext> {
+ public:
+  ReadNextColumnarBatchOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws),
+        batchSize_(OperatorBase::GetSingleArgument<int>("batch_size", 1)),
+        enforceBatchSize_(OperatorBase::GetSingleArgument<bool>(
+            "enforce_batch_size",
+            false)) {}
+
+  bool RunOnDevice() override {
+    auto& cursor = OperatorBase::Input<std::unique_ptr<TreeCursor>>(0);
+    const auto& dataset = OperatorBase::Input<SharedColumnarDatasetPtr>(1);
+    CAFFE_ENFORCE(dataset, "Dataset is not open");
+    enforceCursorFields(*cursor, *dataset);
+    CAFFE_ENFORCE_EQ(OutputSize(), dataset->columns().size());
+
+    std::vector<TOffset> begin;
+    std::vector<TOffset> end;
+    {
+      std::lock_guard<std::mutex> lock(cursor->mutex_);
+      if (cursor->offsets.empty()) {
+        cursor->offsets.assign(dataset->numDomains(), 0);
+      }
+      CAFFE_ENFORCE_EQ(cursor->offsets.size(), dataset->numDomains());
+      begin = cursor->offsets;
+      end.assign(1, std::min<TOffset>(dataset->size(), begin[0] + batchSize_));
+      dataset->domainRanges(begin, end);
+      cursor->offsets = end;
+      if (enforceBatchSize_ && end[0] - begin[0] < batchSize_) {
+        // not enough rows left for a full batch, return empty for all
+        // columns to signal the end of the dataset
+        end = begin;
+      }
+    }
+
+    for (int i = 0; i < dataset->columns().size(); ++i) {
+      const auto& column = dataset->columns()[i];
+      const int domain = cursor->it.fields()[i].lengthFieldId + 1;
+      const TOffset size = end[domain] - begin[domain];
+      auto* out = Output(i);
+      const size_t entryBytes = resizeOutput(column, size, out);
+      if (size == 0 || isString(column.meta)) {
+        copyEntries(
+            column,
+            begin[domain],
+            size,
+            out->size_from_dim(1),
+            out->raw_mutable_data(column.meta),
+            0);
+        continue;
+      }
+      // a view of the mapped file, that keeps the dataset alive
+      out->ShareExternalPointer(
+          const_cast<char*>(column.values) + begin[domain] * entryBytes,
+          column.meta,
+          0,
+          [dataset](void*) {});
+    }
+    return true;
+  }
+
+ private:
+  int batchSize_;
+  bool enforceBatchSize_;
+};
+
+class ReadRandomColumnarBatchOp : public Operator<CPUContext> {
+ public:
+  ReadRandomColumnarBatchOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator(operator_def, ws),
+        batchSize_(OperatorBase::GetSingleArgument<int>("batch_size", 1)),
+        enforceBatchSize_(
+            OperatorBase::GetSingleArgument<bool>("enforce_batch_size", false)),
+        loopOver_(OperatorBase::GetSingleArgument<bool>("loop_over", false)),
+        intraOpParallel_(
+            OperatorBase::GetSingleArgument<bool>("intra_op_parallel", false)),
+        ws_(ws) {}
+
+  bool RunOnDevice() override {
+    auto& cursor = OperatorBase::Input<std::unique_ptr<TreeCursor>>(0);
+    const auto& dataset = OperatorBase::Input<SharedColumnarDatasetPtr>(1);
+    const auto& idxblob = Input(2);
+    CAFFE_ENFORCE(dataset, "Dataset is not open");
+    enforceCursorFields(*cursor, *dataset);
+    CAFFE_ENFORCE_EQ(OutputSize(), dataset->columns().size());
+    const auto* idxvec = idxblob.template data<int64_t>();
+
+    int64_t idx;
+    {
+      std::lock_guard<std::mutex> lock(cursor->mutex_);
+      cursor->offsets.resize(1);
+      idx = cursor->offsets.at(0);
+      // if we want to enforce batch size but we dont have a complete
+      // batch, skip the last rows.
+      if (enforceBatchSize_ && idx + batchSize_ > idxblob.size()) {
+        idx = idxblob.size();
+      }
+      if (loopOver_ && idx >= idxblob.size()) {
+        cursor->offsets.at(0) = 0;
+        idx = 0;
+      }
+      cursor->offsets.at(0) += batchSize_;
+    }
+    const int64_t numRows =
+        std::max<int64_t>(0, std::min<int64_t>(batchSize_, idxblob.size() - idx));
+
+    // the domain ranges of every row, and where they go in the outputs
+    const int numDomains = dataset->numDomains();
+    std::vector<TOffset> rowBegins(numRows * numDomains);
+    std::vector<TOffset> rowDstBegins(numRows * numDomains);
+    std::vector<TOffset> totals(numDomains, 0);
+    std::vector<TOffset> begin;
+    std::vector<TOffset> end;
+    for (int64_t k = 0; k < numRows; ++k) {
+      begin.assign(1, idxvec[idx + k]);
+      end.assign(1, idxvec[idx + k] + 1);
+      dataset->domainRanges(begin, end);
+      for (int d = 0; d < numDomains; ++d) {
+        rowBegins[k * numDomains + d] = begin[d];
+        rowDstBegins[k * numDomains + d] = totals[d];
+        totals[d] += end[d] - begin[d];
+      }
+    }
+
+    const auto& columns = dataset->columns();
+    std::vector<void*> dsts(columns.size());
+    std::vector<TIndex> innerSizes(columns.size());
+    std::vector<int> domains(columns.size());
+    for (int i = 0; i < columns.size(); ++i) {
+      domains[i] = cursor->it.fields()[i].lengthFieldId + 1;
+      auto* out = Output(i);
+      resizeOutput(columns[i], totals[domains[i]], out);
+      innerSizes[i] = out->size_from_dim(1);
+      dsts[i] = out->raw_mutable_data(columns[i].meta);
+    }
+
+    const auto copyRow = [&](int64_t k) {
+      const TOffset* rowBegin = &rowBegins[k * numDomains];
+      const TOffset* rowDstBegin = &rowDstBegins[k * numDomains];
+      const TOffset* nextDstBegin =
+          k + 1 < numRows ? &rowDstBegins[(k + 1) * numDomains] : totals.data();
+      for (int i = 0; i < columns.size(); ++i) {
+        const int d = domains[i];
+        copyEntries(
+            columns[i],
+            rowBegin[d],
+            nextDstBegin[d] - rowDstBegin[d],
+            innerSizes[i],
+            dsts[i],
+            rowDstBegin[d]);
+      }
+    };
+    if (intraOpParallel_ && numRows > 1) {
+      // every row is copied to its own part of the outputs
+      ws_->GetThreadPool()->run(
+          [&](int /* unused */, size_t k) { copyRow(k); }, numRows);
+    } else {
+      for (int64_t k = 0; k < numRows; ++k) {
+        copyRow(k);
+      }
+    }
+    return true;
+  }
+
+ private:
+  int batchSize_;
+  bool enforceBatchSize_;
+  bool loopOver_;
+  bool intraOpParallel_;
+  Workspace* ws_;
+};
+
+REGISTER_CPU_OPERATOR(WriteColumnarDataset, WriteColumnarDatasetOp);
+REGISTER_CPU_OPERATOR(OpenColumnarDataset, OpenColumnarDatasetOp);
+REGISTER_CPU_OPERATOR(ReadNextColumnarBatch, ReadNextColumnarBatchOp);
+REGISTER_CPU_OPERATOR(ReadRandomColumnarBatch, ReadRandomColumnarBatchOp);
+
+OPERATOR_SCHEMA(WriteColumnarDataset)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Writes the fields of a dataset, in the format of CreateTreeCursor, to a
+columnar dataset file that OpenColumnarDataset can map into memory.
+
+Every field is stored contiguously, together with the prefix sums of the
+lengths for the length fields and the string offsets for the string fields,
+so that any range of top-level entries can be located without reading the
+entries before it.
+)DOC")
+    .Input(0, "field_0", "Data for field 0.")
+    .Arg("filename", "Path of the file to write.")
+    .Arg(
+        "fields",
+        "List of strings representing the string names in the format"
+        "specified in the doc for CreateTreeCursor.");
+
+OPERATOR_SCHEMA(OpenColumnarDataset)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Maps a columnar dataset file written by WriteColumnarDataset into memory.
+The data is read from the file as it is accessed, so the dataset can be much
+larger than memory.
+)DOC")
+    .Arg("filename", "Path of the file to open.")
+    .Output(0, "dataset", "A blob pointing to the mapped dataset.");
+
+OPERATOR_SCHEMA(ReadNextColumnarBatch)
+    .NumInputs(2)
+    .NumOutputs(1, INT_MAX)
+    .SetDoc(R"DOC(
+Reads the next batch of top-level entries out of the given cursor and
+columnar dataset, like ReadNextBatch does for in-memory fields.
+
+The outputs of the non-string fields are views of the mapped file instead of
+copies, and keep the dataset mapped as long as they are. String fields are
+copied.
+
+ReadNextColumnarBatch is thread safe.
+)DOC")
+    .Input(0, "cursor", "A blob containing a pointer to the cursor.")
+    .Input(1, "dataset", "A blob pointing to a columnar dataset.")
+    .Output(0, "field_0", "Tensor containing the next batch for field 0.")
+    .Arg("batch_size", "Number of top-level entries to read.")
+    .Arg(
+        "enforce_batch_size",
+        "(bool) Return empty fields instead of a last partial batch.");
+
+OPERATOR_SCHEMA(ReadRandomColumnarBatch)
+    .NumInputs(3)
+    .NumOutputs(1, INT_MAX)
+    .SetDoc(R"DOC(
+Reads the next batch of top-level entries of the given index list out of the
+given cursor and columnar dataset, like ReadRandomBatch does for in-memory
+fields. The offsets of the entries are stored in the dataset, so no offsets
+matrix is needed.
+
+ReadRandomColumnarBatch is thread safe.
+)DOC")
+    .Input(0, "cursor", "A blob containing a pointer to the cursor.")
+    .Input(1, "dataset", "A blob pointing to a columnar dataset.")
+    .Input(2, "idx", "int64 indices of the top-level entries, e.g. shuffled.")
+    .Output(0, "field_0", "Tensor containing the next batch for field 0.")
+    .Arg("batch_size", "Number of top-level entries to read.")
+    .Arg(
+        "enforce_batch_size",
+        "(bool) Return empty fields instead of a last partial batch.")
+    .Arg("loop_over", "(bool) Repeat the dataset indefinitely")
+    .Arg(
+        "intra_op_parallel",
+        "(bool, default false) Copy the entries of the batch in parallel on "
+        "the thread pool of the workspace.");
+
+NO_GRADIENT(WriteColumnarDataset);
+NO_GRADIENT(OpenColumnarDataset);
+NO_GRADIENT(ReadNextColumnarBatch);
+NO_GRADIENT(ReadRandomColumnarBatch);
+
+} // namespace
+} // namespace dataset_ops
+} // namespace caffe2
@@ -0,0 +1,91 @@
+#ifndef CAFFE2_OPERATORS_COLUMNAR_DATASET_OPS_H_
+#define CAFFE2_OPERATORS_COLUMNAR_DATASET_OPS_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/tensor.h"
+#include "caffe2/operators/dataset_ops.h"
+
+namespace caffe2 {
+namespace dataset_ops {
+
+/**
+ * A dataset stored column by column in a file that is memory mapped for
+ * reading, so that batches can be read from files much larger than memory.
+ *
+ * Every field of the dataset (see CreateTreeCursor for the naming of the
+ * fields and domains) is a column with the values of the field, stored
+ * contiguously in the layout of a tensor, and for length fields and string
+ * fields an offsets array of size + 1 entries:
+ *  - the offsets of a length field are the prefix sums of the lengths, i.e.
+ *    the offset in the child domain at which every entry starts;
+ *  - the offsets of a string field are the byte offsets of the strings in
+ *    the values, which are the characters of all strings.
+ *
+ * The file starts with a header describing the columns, followed by the
+ * offsets and values of the columns, each aligned to kColumnAlignment
+ * bytes. Numbers are stored in the byte order of the host.
+ */
+class ColumnarDataset {
+ public:
+  static constexpr size_t kColumnAlignment = 64;
+
+  struct Column {
+    std::string name;
+    TypeMeta meta;
+    // dims[0] is the number of entries of the column in its domain
+    std::vector<TIndex> dims;
+    // size + 1 entries for length and string fields, nullptr otherwise
+    const TOffset* offsets = nullptr;
+    const char* values = nullptr;
+  };
+
+  // Writes the fields of a dataset to a new columnar dataset file.
+  static void Write(
+      const std::string& path,
+      const std::vector<std::string>& fields,
+      const std::vector<const TensorCPU*>& tensors);
+
+  explicit ColumnarDataset(const std::string& path);
+  ~ColumnarDataset();
+
+  const std::vector<Column>& columns() const {
+    return columns_;
+  }
+
+  // Number of top-level entries.
+  TOffset size() const {
+    return limits_[0];
+  }
+
+  // Number of domains, including the top-level domain 0.
+  int numDomains() const {
+    return limits_.size();
+  }
+
+  DISABLE_COPY_AND_ASSIGN(ColumnarDataset);
+
+  // Given the top-level entries [begin[0], end[0]), fills in the ranges
+  // [begin[i], end[i]) of the entries of every domain i that they hold.
+  void domainRanges(
+      std::vector<TOffset>& begin,
+      std::vector<TOffset>& end) const;
+
+ private:
+  std::string path_;
+  void* data_ = nullptr;
+  size_t bytes_ = 0;
+  std::vector<Column> columns_;
+  std::unique_ptr<TreeIterator> iterator_;
+  // total number of entries of every domain
+  std::vector<TOffset> limits_;
+};
+
+using SharedColumnarDatasetPtr = std::shared_ptr<const ColumnarDataset>;
+
+} // namespace dataset_ops
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_COLUMNAR_DATASET_OPS_H_
@@ -72,7 +72,18 @@ Does an allreduce operation among the nodes. Currently only Sum is supported.
 )DOC")
     .Input(0, "comm_world", "The common world.")
     .Input(1, "X", "A tensor to be allreduced.")
-    .Output(0, "Y", "The allreduced tensor, same on all nodes.");
+    .Output(0, "Y", "The allreduced tensor, same on all nodes.")
+    .Arg(
+        "async",
+        "(bool, default false) with the GLOO engine on CPU, run the allreduce "
+        "in the background and complete the operator through its event. Only "
+        "async nets (e.g. async_scheduling) wait for it, and they run the "
+        "operators that do not depend on it in the meantime.")
+    .Arg(
+        "priority",
+        "(int, default 0) in async_scheduling nets, operators that are ready "
+        "at the same time are scheduled lower priority first, e.g. to reduce "
+        "the gradients of the first layers first.");
 
 OPERATOR_SCHEMA(ReduceScatter)
     .NumInputsOutputs([](int in, int out) {
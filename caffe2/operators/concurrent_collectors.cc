@@ -0,0 +1,518 @@
+#include "caffe2/operators/concurrent_collectors.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <thread>
+
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+namespace {
+
+void enforceSameRowShape(const TensorCPU& rows, const TensorCPU& data) {
+  CAFFE_ENFORCE(
+      data.meta() == rows.meta(),
+      "Collected rows are of type ",
+      rows.meta().name(),
+      ", got ",
+      data.meta().name());
+  CAFFE_ENFORCE_EQ(data.ndim(), rows.ndim());
+  for (int i = 1; i < data.ndim(); ++i) {
+    CAFFE_ENFORCE_EQ(data.dim(i), rows.dim(i));
+  }
+}
+
+// Threads are numbered in the order they first append to any sharded
+// reservoir, which spreads them evenly over the shards.
+int threadShardSeed() {
+  static std::atomic<int> next_seed{0};
+  static thread_local int seed = next_seed.fetch_add(1);
+  return seed;
+}
+
+} // namespace
+
+LastNWindowBuffer::LastNWindowBuffer(int64_t num_to_collect)
+    : num_to_collect_(num_to_collect) {
+  CAFFE_ENFORCE_GT(num_to_collect_, 0);
+}
+
+void LastNWindowBuffer::initialize(const TensorCPU& data) {
+  std::lock_guard<std::mutex> guard(init_mutex_);
+  if (initialized_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  auto dims = data.dims();
+  dims[0] = num_to_collect_;
+  rows_.Resize(dims);
+  rows_data_ = static_cast<char*>(rows_.raw_mutable_data(data.meta()));
+  row_bytes_ = data.size_from_dim(1) * data.itemsize();
+  slot_turns_.reset(new std::atomic<int64_t>[num_to_collect_]);
+  for (int64_t i = 0; i < num_to_collect_; ++i) {
+    slot_turns_[i].store(0, std::memory_order_relaxed);
+  }
+  initialized_.store(true, std::memory_order_release);
+}
+
+void LastNWindowBuffer::enterAppend() {
+  while (true) {
+    num_appending_.fetch_add(1);
+    if (!reading_.load()) {
+      return;
+    }
+    exitAppend();
+    std::unique_lock<std::mutex> lock(gate_mutex_);
+    gate_cv_.wait(lock, [this]() { return !reading_.load(); });
+  }
+}
+
+void LastNWindowBuffer::exitAppend() {
+  num_appending_.fetch_sub(1);
+}
+
+void LastNWindowBuffer::waitForTurn(int64_t row) const {
+  const int64_t turn = row / num_to_collect_;
+  const auto& slot_turn = slot_turns_[row % num_to_collect_];
+  while (slot_turn.load(std::memory_order_acquire) != turn) {
+    std::this_thread::yield();
+  }
+}
+
+int64_t LastNWindowBuffer::Append(const TensorCPU& data, CPUContext* context) {
+  CAFFE_ENFORCE_GE(data.ndim(), 1);
+  if (!initialized_.load(std::memory_order_acquire)) {
+    initialize(data);
+  }
+  enforceSameRowShape(rows_, data);
+
+  const int64_t num_entries = data.dim(0);
+  const size_t row_size = data.size_from_dim(1);
+  const auto* data_ptr = static_cast<const char*>(data.raw_data());
+
+  enterAppend();
+  const int64_t start = num_rows_.fetch_add(num_entries);
+  const int64_t end = start + num_entries;
+  // Rows which the end of this append overwrites are not copied, but still
+  // take their turn, for the rows of later turns of the slot to be written.
+  int64_t row = start;
+  for (; row < end - num_to_collect_; ++row) {
+    waitForTurn(row);
+    slot_turns_[row % num_to_collect_].store(
+        row / num_to_collect_ + 1, std::memory_order_release);
+  }
+  data_ptr += (row - start) * row_bytes_;
+  while (row < end) {
+    const int64_t slot = row % num_to_collect_;
+    const int64_t run = std::min(end - row, num_to_collect_ - slot);
+    for (int64_t i = 0; i < run; ++i) {
+      waitForTurn(row + i);
+    }
+    context->CopyItems<CPUContext, CPUContext>(
+        data.meta(), run * row_size, data_ptr, rows_data_ + slot * row_bytes_);
+    for (int64_t i = 0; i < run; ++i) {
+      slot_turns_[slot + i].store(
+          (row + i) / num_to_collect_ + 1, std::memory_order_release);
+    }
+    data_ptr += run * row_bytes_;
+    row += run;
+  }
+  exitAppend();
+  return end;
+}
+
+int64_t LastNWindowBuffer::Read(TensorCPU* output, CPUContext* context) {
+  std::lock_guard<std::mutex> read_guard(read_mutex_);
+  if (!initialized_.load(std::memory_order_acquire)) {
+    return 0;
+  }
+
+  {
+    std::lock_guard<std::mutex> gate_guard(gate_mutex_);
+    reading_.store(true);
+  }
+  while (num_appending_.load() > 0) {
+    std::this_thread::yield();
+  }
+
+  const int64_t num_rows = num_rows_.load();
+  const int64_t num_collected = std::min(num_rows, num_to_collect_);
+  const int64_t oldest =
+      num_rows > num_to_collect_ ? num_rows % num_to_collect_ : 0;
+  const int64_t first_run = std::min(num_collected, num_to_collect_ - oldest);
+  const size_t row_size = rows_.size_from_dim(1);
+
+  auto dims = rows_.dims();
+  dims[0] = num_collected;
+  output->Resize(dims);
+  auto* output_data =
+      static_cast<char*>(output->raw_mutable_data(rows_.meta()));
+  context->CopyItems<CPUContext, CPUContext>(
+      rows_.meta(),
+      first_run * row_size,
+      rows_data_ + oldest * row_bytes_,
+      output_data);
+  context->CopyItems<CPUContext, CPUContext>(
+      rows_.meta(),
+      (num_collected - first_run) * row_size,
+      rows_data_,
+      output_data + first_run * row_bytes_);
+
+  {
+    std::lock_guard<std::mutex> gate_guard(gate_mutex_);
+    reading_.store(false);
+  }
+  gate_cv_.notify_all();
+  return num_rows;
+}
+
+ShardedReservoir::ShardedReservoir(int64_t num_to_collect, int num_shards)
+    : num_to_collect_(num_to_collect) {
+  CAFFE_ENFORCE_GT(num_to_collect_, 0);
+  CAFFE_ENFORCE_GT(num_shards, 0);
+  for (int i = 0; i < num_shards; ++i) {
+    shards_.emplace_back(new Shard());
+  }
+}
+
+int64_t ShardedReservoir::Append(const TensorCPU& data, CPUContext* context) {
+  CAFFE_ENFORCE_GE(data.ndim(), 1);
+  auto& shard = *shards_[threadShardSeed() % shards_.size()];
+  std::lock_guard<std::mutex> guard(shard.mutex);
+
+  if (shard.rows.ndim() == 0) {
+    auto dims = data.dims();
+    dims[0] = num_to_collect_;
+    shard.rows.Resize(dims);
+    shard.rows.raw_mutable_data(data.meta());
+  }
+  enforceSameRowShape(shard.rows, data);
+
+  const size_t row_size = data.size_from_dim(1);
+  const size_t row_bytes = row_size * data.itemsize();
+  const auto* data_ptr = static_cast<const char*>(data.raw_data());
+  auto* rows_data =
+      static_cast<char*>(shard.rows.raw_mutable_data(data.meta()));
+  auto& gen = context->RandGenerator();
+
+  for (int64_t i = 0; i < data.dim(0); ++i) {
+    int64_t pos = shard.num_visited;
+    if (pos >= num_to_collect_) {
+      // uniform between [0, num_visited]
+      std::uniform_int_distribution<int64_t> uniformDist(0, shard.num_visited);
+      pos = uniformDist(gen);
+    }
+    if (pos < num_to_collect_) {
+      context->CopyItems<CPUContext, CPUContext>(
+          data.meta(),
+          row_size,
+          data_ptr + i * row_bytes,
+          rows_data + pos * row_bytes);
+    }
+    ++shard.num_visited;
+  }
+  return shard.num_visited;
+}
+
+int64_t ShardedReservoir::Read(TensorCPU* output, CPUContext* context) {
+  std::vector<std::unique_lock<std::mutex>> locks;
+  for (auto& shard : shards_) {
+    locks.emplace_back(shard->mutex);
+  }
+
+  const TensorCPU* first_rows = nullptr;
+  int64_t num_visited = 0;
+  // What each shard can still contribute: the number of rows it saw, and
+  // the positions of its sample not taken yet
+  std::vector<int64_t> remaining(shards_.size());
+  std::vector<std::vector<int64_t>> positions(shards_.size());
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    const auto& shard = *shards_[i];
+    if (shard.num_visited == 0) {
+      continue;
+    }
+    if (first_rows) {
+      enforceSameRowShape(*first_rows, shard.rows);
+    } else {
+      first_rows = &shard.rows;
+    }
+    num_visited += shard.num_visited;
+    remaining[i] = shard.num_visited;
+    positions[i].resize(std::min(shard.num_visited, num_to_collect_));
+    std::iota(positions[i].begin(), positions[i].end(), 0);
+  }
+  if (!first_rows) {
+    return 0;
+  }
+
+  const int64_t num_collected = std::min(num_visited, num_to_collect_);
+  const size_t row_size = first_rows->size_from_dim(1);
+  const size_t row_bytes = row_size * first_rows->itemsize();
+  auto dims = first_rows->dims();
+  dims[0] = num_collected;
+  output->Resize(dims);
+  auto* output_data =
+      static_cast<char*>(output->raw_mutable_data(first_rows->meta()));
+  auto& gen = context->RandGenerator();
+
+  int64_t num_remaining = num_visited;
+  for (int64_t row = 0; row < num_collected; ++row) {
+    std::uniform_int_distribution<int64_t> rowDist(0, num_remaining - 1);
+    int64_t r = rowDist(gen);
+    size_t i = 0;
+    while (r >= remaining[i]) {
+      r -= remaining[i];
+      ++i;
+    }
+    // A shard never runs out of sampled positions before its row count,
+    // as it can't contribute more than num_to_collect_ rows.
+    auto& shard_positions = positions[i];
+    std::uniform_int_distribution<size_t> posDist(
+        0, shard_positions.size() - 1);
+    const size_t p = posDist(gen);
+    const int64_t pos = shard_positions[p];
+    shard_positions[p] = shard_positions.back();
+    shard_positions.pop_back();
+    --remaining[i];
+    --num_remaining;
+
+    const auto* rows_data =
+        static_cast<const char*>(shards_[i]->rows.raw_data());
+    context->CopyItems<CPUContext, CPUContext>(
+        first_rows->meta(),
+        row_size,
+        rows_data + pos * row_bytes,
+        output_data + row * row_bytes);
+  }
+  return num_visited;
+}
+
+namespace {
+
+template <class Context>
+class CreateLastNWindowBufferOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  CreateLastNWindowBufferOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        numToCollect_(
+            OperatorBase::GetSingleArgument<int>("num_to_collect", -1)) {
+    CAFFE_ENFORCE_GT(numToCollect_, 0);
+  }
+
+  bool RunOnDevice() override {
+    *OperatorBase::Output<std::unique_ptr<LastNWindowBuffer>>(0) =
+        caffe2::make_unique<LastNWindowBuffer>(numToCollect_);
+    return true;
+  }
+
+ private:
+  const int numToCollect_;
+};
+
+template <class Context>
+class CreateShardedReservoirOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  CreateShardedReservoirOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        numToCollect_(
+            OperatorBase::GetSingleArgument<int>("num_to_collect", -1)),
+        numShards_(OperatorBase::GetSingleArgument<int>("num_shards", 0)) {
+    CAFFE_ENFORCE_GT(numToCollect_, 0);
+    CAFFE_ENFORCE_GE(numShards_, 0);
+    if (numShards_ == 0) {
+      numShards_ = std::max(1u, std::thread::hardware_concurrency());
+    }
+  }
+
+  bool RunOnDevice() override {
+    *OperatorBase::Output<std::unique_ptr<ShardedReservoir>>(0) =
+        caffe2::make_unique<ShardedReservoir>(numToCollect_, numShards_);
+    return true;
+  }
+
+ private:
+  const int numToCollect_;
+  int numShards_;
+};
+
+// Appends DATA to the collector of input 0, and optionally outputs the
+// number of rows it counted so far
+template <typename Collector, class Context>
+class CollectorAppendOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(CollectorAppendOp);
+
+  bool RunOnDevice() override {
+    auto& collector =
+        OperatorBase::Input<std::unique_ptr<Collector>>(COLLECTOR);
+    CAFFE_ENFORCE(collector, "Collector is not initialized");
+    const auto num_visited = collector->Append(Input(DATA), &context_);
+    if (OutputSize() > NUM_VISITED) {
+      auto* output = Output(NUM_VISITED);
+      output->Resize();
+      *output->template mutable_data<int64_t>() = num_visited;
+    }
+    return true;
+  }
+
+ private:
+  INPUT_TAGS(COLLECTOR, DATA);
+  OUTPUT_TAGS(NUM_VISITED);
+};
+
+template <typename Collector, class Context>
+class CollectorReadOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(CollectorReadOp);
+
+  bool RunOnDevice() override {
+    auto& collector =
+        OperatorBase::Input<std::unique_ptr<Collector>>(COLLECTOR);
+    CAFFE_ENFORCE(collector, "Collector is not initialized");
+    const auto num_visited = collector->Read(Output(ROWS), &context_);
+    if (OutputSize() > NUM_VISITED) {
+      auto* output = Output(NUM_VISITED);
+      output->Resize();
+      *output->template mutable_data<int64_t>() = num_visited;
+    }
+    return true;
+  }
+
+ private:
+  INPUT_TAGS(COLLECTOR);
+  OUTPUT_TAGS(ROWS, NUM_VISITED);
+};
+
+REGISTER_CPU_OPERATOR(
+    CreateLastNWindowBuffer,
+    CreateLastNWindowBufferOp<CPUContext>);
+REGISTER_CPU_OPERATOR(
+    LastNWindowBufferAppend,
+    CollectorAppendOp<LastNWindowBuffer, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    LastNWindowBufferRead,
+    CollectorReadOp<LastNWindowBuffer, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    CreateShardedReservoir,
+    CreateShardedReservoirOp<CPUContext>);
+REGISTER_CPU_OPERATOR(
+    ShardedReservoirAppend,
+    CollectorAppendOp<ShardedReservoir, CPUContext>);
+REGISTER_CPU_OPERATOR(
+    ShardedReservoirRead,
+    CollectorReadOp<ShardedReservoir, CPUContext>);
+
+OPERATOR_SCHEMA(CreateLastNWindowBuffer)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Creates a buffer of the last `num_to_collect` rows appended to it by
+`LastNWindowBufferAppend`, which unlike `LastNWindowCollector` takes no mutex:
+any number of threads can append to the buffer at the same time. The first
+append fixes the type of the rows and their shape, i.e. all but the first
+dimension of `DATA`.
+)DOC")
+    .Arg("num_to_collect", "The number of rows to keep")
+    .Output(0, "buffer", "Pointer to the buffer");
+
+OPERATOR_SCHEMA(LastNWindowBufferAppend)
+    .NumInputs(2)
+    .NumOutputs(0, 1)
+    .SetDoc(R"DOC(
+Appends the rows of `DATA` to a buffer created by `CreateLastNWindowBuffer`.
+Thread safe and lock-free: an append reserves the slots of its rows with one
+atomic operation and copies them in at most two contiguous blocks.
+)DOC")
+    .Input(0, "buffer", "Buffer to append to")
+    .Input(
+        1,
+        "DATA",
+        "Tensor to collect from, the first dimension indexing the rows")
+    .Output(
+        0,
+        "NUM_VISITED",
+        "(Optional, int64) Number of rows appended to the buffer so far, "
+        "these included");
+
+OPERATOR_SCHEMA(LastNWindowBufferRead)
+    .NumInputs(1)
+    .NumOutputs(1, 2)
+    .SetDoc(R"DOC(
+Copies the rows of a buffer created by `CreateLastNWindowBuffer` out, oldest
+first. Appends running at the same time finish first, and new ones wait for
+the copy.
+)DOC")
+    .Input(0, "buffer", "Buffer to read")
+    .Output(0, "last-N buffer", "The last `num_to_collect` rows appended")
+    .Output(
+        1,
+        "NUM_VISITED",
+        "(Optional, int64) Number of rows appended to the buffer so far");
+
+OPERATOR_SCHEMA(CreateShardedReservoir)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Creates a reservoir of a uniform random sample of `num_to_collect` of the rows
+appended to it by `ShardedReservoirAppend`. Unlike `ReservoirSampling`, which
+serializes all the appends on a mutex, the reservoir is split into shards
+that threads append to separately, and which `ShardedReservoirRead` merges
+into one sample. Deduplication by object id isn't supported.
+)DOC")
+    .Arg("num_to_collect", "The number of rows to sample")
+    .Arg(
+        "num_shards",
+        "The number of shards, ideally that of the threads appending; "
+        "0 for the number of hardware threads")
+    .Output(0, "reservoir", "Pointer to the reservoir");
+
+OPERATOR_SCHEMA(ShardedReservoirAppend)
+    .NumInputs(2)
+    .NumOutputs(0, 1)
+    .SetDoc(R"DOC(
+Samples the rows of `DATA` into the shard of the calling thread of a reservoir
+created by `CreateShardedReservoir`. Thread safe.
+)DOC")
+    .Input(0, "reservoir", "Reservoir to append to")
+    .Input(
+        1,
+        "DATA",
+        "Tensor to collect from, the first dimension indexing the rows")
+    .Output(
+        0,
+        "NUM_VISITED",
+        "(Optional, int64) Number of rows the shard saw so far, these "
+        "included");
+
+OPERATOR_SCHEMA(ShardedReservoirRead)
+    .NumInputs(1)
+    .NumOutputs(1, 2)
+    .SetDoc(R"DOC(
+Merges the shards of a reservoir created by `CreateShardedReservoir` into a
+uniform random sample of all the rows appended to it so far.
+)DOC")
+    .Input(0, "reservoir", "Reservoir to read")
+    .Output(0, "RESERVOIR", "The sampled rows, in random order")
+    .Output(
+        1,
+        "NUM_VISITED",
+        "(Optional, int64) Number of rows appended to the reservoir so far");
+
+SHOULD_NOT_DO_GRADIENT(CreateLastNWindowBuffer);
+SHOULD_NOT_DO_GRADIENT(LastNWindowBufferAppend);
+SHOULD_NOT_DO_GRADIENT(LastNWindowBufferRead);
+SHOULD_NOT_DO_GRADIENT(CreateShardedReservoir);
+SHOULD_NOT_DO_GRADIENT(ShardedReservoirAppend);
+SHOULD_NOT_DO_GRADIENT(ShardedReservoirRead);
+
+} // namespace
+
+CAFFE_KNOWN_TYPE(std::unique_ptr<LastNWindowBuffer>);
+CAFFE_KNOWN_TYPE(std::unique_ptr<ShardedReservoir>);
+
+} // namespace caffe2
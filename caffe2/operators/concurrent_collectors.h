@@ -0,0 +1,109 @@
+#ifndef CAFFE2_OPERATORS_CONCURRENT_COLLECTORS_H_
+#define CAFFE2_OPERATORS_CONCURRENT_COLLECTORS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/tensor.h"
+
+namespace caffe2 {
+
+// Collections of rows that many threads append to at the same time, as the
+// LastNWindowCollector and ReservoirSampling operators do with a mutex.
+// The first append fixes the type and the shape of the rows (all but the
+// first dimension of the appended tensors); later ones must match them.
+
+// The last num_to_collect rows appended, in a ring buffer. An append
+// reserves its slots with a single atomic add on the row counter and copies
+// its rows into them in at most two contiguous copies, without locks. Every
+// slot counts the rows written to it, so that the rare writer that laps
+// another one still in the same slot waits for it instead of tearing its row.
+// Reads wait for the appends in flight, and hold back new ones while they
+// copy the buffer out.
+class LastNWindowBuffer {
+ public:
+  explicit LastNWindowBuffer(int64_t num_to_collect);
+
+  int64_t num_to_collect() const {
+    return num_to_collect_;
+  }
+
+  // Appends the rows of data, and returns the number of rows appended so far,
+  // these included.
+  int64_t Append(const TensorCPU& data, CPUContext* context);
+
+  // Copies the collected rows, oldest first, into output, and returns the
+  // number of rows appended so far. If nothing was appended yet, output is
+  // left as is.
+  int64_t Read(TensorCPU* output, CPUContext* context);
+
+ private:
+  void initialize(const TensorCPU& data);
+  void enterAppend();
+  void exitAppend();
+  void waitForTurn(int64_t row) const;
+
+  const int64_t num_to_collect_;
+
+  std::atomic<bool> initialized_{false};
+  std::mutex init_mutex_;
+  TensorCPU rows_;
+  char* rows_data_{nullptr};
+  size_t row_bytes_{0};
+  // Number of rows written to each slot: row r may be written to slot
+  // r % num_to_collect_ once that's r / num_to_collect_.
+  std::unique_ptr<std::atomic<int64_t>[]> slot_turns_;
+
+  std::atomic<int64_t> num_rows_{0};
+  std::atomic<int> num_appending_{0};
+  std::atomic<bool> reading_{false};
+  std::mutex read_mutex_;
+  std::mutex gate_mutex_;
+  std::condition_variable gate_cv_;
+};
+
+// A uniform sample without replacement of num_to_collect of the rows
+// appended, kept as independent reservoirs each updated under its own lock.
+// Every thread appends to the shard of its own (threads are spread over the
+// shards round-robin), so appends rarely contend. Reads merge the shards into
+// one sample: each row of it is drawn from a shard with probability
+// proportional to the rows that shard saw and hasn't contributed yet, which
+// keeps the merged sample uniform over all the rows appended.
+class ShardedReservoir {
+ public:
+  ShardedReservoir(int64_t num_to_collect, int num_shards);
+
+  int64_t num_to_collect() const {
+    return num_to_collect_;
+  }
+  int num_shards() const {
+    return shards_.size();
+  }
+
+  // Samples the rows of data into the shard of the calling thread, with the
+  // random generator of context, and returns the number of rows that shard
+  // saw so far.
+  int64_t Append(const TensorCPU& data, CPUContext* context);
+
+  // Merges the shards into output and returns the number of rows appended so
+  // far. If nothing was appended yet, output is left as is.
+  int64_t Read(TensorCPU* output, CPUContext* context);
+
+ private:
+  struct Shard {
+    std::mutex mutex;
+    TensorCPU rows;
+    int64_t num_visited{0};
+  };
+
+  const int64_t num_to_collect_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_CONCURRENT_COLLECTORS_H_
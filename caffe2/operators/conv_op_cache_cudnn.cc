@@ -1,14 +1,106 @@
 #include "caffe2/operators/conv_op_cache_cudnn.h"
 
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
 #include <cudnn.h>
 
+#include "caffe2/core/common_gpu.h"
+#include "caffe2/core/flags.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/tensor.h"
 
+CAFFE2_DEFINE_string(
+    caffe2_cudnn_algorithms_cache_file,
+    "",
+    "If set, the algorithms found by the exhaustive searches of the cuDNN "
+    "convolutions are loaded from and appended to this file, so that later "
+    "runs with the same shapes, cuDNN version and GPU skip the searches.");
+
 namespace caffe2 {
 
 template class AlgorithmsCache<cudnnConvolutionFwdAlgo_t>;
 template class AlgorithmsCache<cudnnConvolutionBwdFilterAlgo_t>;
 template class AlgorithmsCache<cudnnConvolutionBwdDataAlgo_t>;
 template class AlgorithmsCache<int>; // For testing.
+
+PersistentAlgorithmsCache::PersistentAlgorithmsCache(const std::string& path)
+    : path_(path) {
+  if (path_.empty()) {
+    return;
+  }
+  std::ifstream file(path_);
+  std::string line;
+  while (std::getline(file, line)) {
+    // The key is everything up to the last two fields.
+    std::istringstream fields(line);
+    std::vector<std::string> words;
+    std::string word;
+    while (fields >> word) {
+      words.push_back(word);
+    }
+    if (words.size() < 3) {
+      continue;
+    }
+    std::string key = words[0];
+    for (size_t i = 1; i < words.size() - 2; ++i) {
+      key += " " + words[i];
+    }
+    try {
+      algorithms_[key] = std::make_tuple(
+          std::stoi(words[words.size() - 2]),
+          std::stof(words[words.size() - 1]));
+    } catch (const std::exception&) {
+      LOG(WARNING) << "Ignoring malformed line of " << path_ << ": " << line;
+    }
+  }
+  VLOG(1) << "Loaded " << algorithms_.size() << " cuDNN algorithms from "
+          << path_;
+}
+
+PersistentAlgorithmsCache& PersistentAlgorithmsCache::Get() {
+  static PersistentAlgorithmsCache cache(
+      FLAGS_caffe2_cudnn_algorithms_cache_file);
+  return cache;
+}
+
+std::tuple<int, float> PersistentAlgorithmsCache::getAlgorithm(
+    const std::string& key,
+    std::function<std::tuple<int, float>()> generatingFunc) {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = algorithms_.find(key);
+    if (it != algorithms_.end()) {
+      return it->second;
+    }
+  }
+
+  // Searches can take seconds, so don't hold the lock while running them.
+  // Two operators that need the same algorithm at the same time may then
+  // both search for it, which is harmless.
+  const auto value = generatingFunc();
+  std::lock_guard<std::mutex> guard(mutex_);
+  algorithms_[key] = value;
+  if (!path_.empty()) {
+    std::ofstream file(path_, std::ios::app);
+    file << key << " " << std::get<0>(value) << " " << std::get<1>(value)
+         << "\n";
+    if (!file) {
+      LOG(WARNING) << "Failed to write the cuDNN algorithm of " << key
+                   << " to " << path_;
+    }
+  }
+  return value;
+}
+
+std::string CudnnAlgorithmsKeyPrefix() {
+  const auto& prop = GetDeviceProperty(CaffeCudaGetDevice());
+  std::string name(prop.name);
+  std::replace(name.begin(), name.end(), ' ', '_');
+  std::ostringstream prefix;
+  prefix << "caffe2 cudnn" << cudnnGetVersion() << " " << name << " sm"
+         << prop.major << prop.minor;
+  return prefix.str();
+}
 } // namespace caffe2
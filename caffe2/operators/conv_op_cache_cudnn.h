@@ -2,6 +2,9 @@
 #define CAFFE2_OPERATORS_CONV_OP_CACHE_H_
 
 #include <functional>
+#include <mutex>
+#include <string>
+#include <tuple>
 #include <unordered_map>
 #include <vector>
 
@@ -61,6 +64,52 @@ TAlgorithm AlgorithmsCache<TAlgorithm>::getAlgorithm(
 
   return hash_[seed];
 }
+
+// Caches the best algorithm and its cost for a given description of a
+// search, across all the operators of the process. The key has to describe
+// everything the choice depends on: shapes, data and compute types, storage
+// order, the arguments of the convolution, and the cuDNN version and GPU the
+// search runs on (see CudnnAlgorithmsKeyPrefix).
+//
+// When constructed with a path, the cache starts with the algorithms found
+// in that file and appends every new one to it, so that later runs on the
+// same setup skip the searches. Each line of the file is "<key> <algorithm>
+// <cost>", and the last line of a key wins. Runs can share a file, including
+// runs of ATen, whose keys start with a different prefix.
+class PersistentAlgorithmsCache {
+ public:
+  explicit PersistentAlgorithmsCache(const std::string& path = "");
+
+  // The cache of the process, backed by
+  // --caffe2_cudnn_algorithms_cache_file if it is set.
+  static PersistentAlgorithmsCache& Get();
+
+  std::tuple<int, float> getAlgorithm(
+      const std::string& key,
+      std::function<std::tuple<int, float>()> generatingFunc);
+
+  template <typename TAlgorithm>
+  std::tuple<TAlgorithm, float> getAlgorithm(
+      const std::string& key,
+      std::function<std::tuple<TAlgorithm, float>()> generatingFunc) {
+    const auto result = getAlgorithm(key, [&]() {
+      const auto value = generatingFunc();
+      return std::make_tuple(
+          static_cast<int>(std::get<0>(value)), std::get<1>(value));
+    });
+    return std::make_tuple(
+        static_cast<TAlgorithm>(std::get<0>(result)), std::get<1>(result));
+  }
+
+ private:
+  std::mutex mutex_;
+  std::string path_;
+  std::unordered_map<std::string, std::tuple<int, float>> algorithms_;
+};
+
+// The part of the keys of PersistentAlgorithmsCache that identifies the
+// cuDNN version and the current GPU.
+std::string CudnnAlgorithmsKeyPrefix();
 } // namespace caffe2
 
 #endif
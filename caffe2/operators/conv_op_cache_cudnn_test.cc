@@ -1,3 +1,6 @@
+#include <cstdio>
+#include <string>
+#include <tuple>
 #include <vector>
 
 #include "caffe2/core/context_gpu.h"
@@ -58,4 +61,45 @@ TEST(AlgorithmsCacheTest, KeysDifferIfFlagsAreDifferent) {
   EXPECT_EQ(res3, 10);
 }
 
+TEST(PersistentAlgorithmsCacheTest, CachesCorrectly) {
+  PersistentAlgorithmsCache cache;
+  auto result =
+      cache.getAlgorithm("a", []() { return std::make_tuple(5, 1.5f); });
+  EXPECT_EQ(std::get<0>(result), 5);
+
+  auto res2 =
+      cache.getAlgorithm("a", []() { return std::make_tuple(10, 0.5f); });
+  EXPECT_EQ(std::get<0>(res2), 5);
+  EXPECT_EQ(std::get<1>(res2), 1.5f);
+
+  auto res3 =
+      cache.getAlgorithm("a b", []() { return std::make_tuple(15, 0.5f); });
+  EXPECT_EQ(std::get<0>(res3), 15);
+}
+
+TEST(PersistentAlgorithmsCacheTest, LoadsWhatWasFound) {
+  std::string path = std::tmpnam(nullptr);
+  {
+    PersistentAlgorithmsCache cache(path);
+    cache.getAlgorithm(
+        "conv fwd 1,2", []() { return std::make_tuple(3, 2.f); });
+    cache.getAlgorithm(
+        "conv fwd 4,5", []() { return std::make_tuple(6, 1.f); });
+  }
+
+  PersistentAlgorithmsCache cache(path);
+  auto result = cache.getAlgorithm("conv fwd 1,2", []() {
+    ADD_FAILURE() << "The algorithm should have been loaded";
+    return std::make_tuple(0, 0.f);
+  });
+  EXPECT_EQ(std::get<0>(result), 3);
+  EXPECT_EQ(std::get<1>(result), 2.f);
+  auto res2 = cache.getAlgorithm("conv fwd 4,5", []() {
+    ADD_FAILURE() << "The algorithm should have been loaded";
+    return std::make_tuple(0, 0.f);
+  });
+  EXPECT_EQ(std::get<0>(res2), 6);
+  std::remove(path.c_str());
+}
+
 } // namespace caffe2
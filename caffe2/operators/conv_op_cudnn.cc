@@ -1,5 +1,7 @@
 #include "caffe2/core/context_gpu.h"
 
+#include <sstream>
+
 #include "caffe2/core/common_gpu.h"
 #include "caffe2/core/cudnn_wrappers.h"
 #include "caffe2/operators/conv_op.h"
@@ -17,6 +19,7 @@ class CudnnConvOpBase : public ConvPoolOpBase<CUDAContext> {
         cudnn_ws_nbytes_limit_(OperatorBase::GetSingleArgument<size_t>(
             "ws_nbytes_limit",
             kCONV_CUDNN_WORKSPACE_LIMIT_BYTES)),
+        ws_nbytes_limit_(cudnn_ws_nbytes_limit_),
         exhaustive_search_(
             OperatorBase::GetSingleArgument<int>("exhaustive_search", 0)),
         deterministic_(
@@ -411,6 +414,46 @@ class CudnnConvOpBase : public ConvPoolOpBase<CUDAContext> {
     }
   }
 
+  // Describes the exhaustive search of the algorithm of pass for
+  // PersistentAlgorithmsCache. data_types are those of the tensors of the
+  // pass.
+  std::string AlgorithmsCacheKey(
+      const char* pass,
+      const vector<TIndex>& input_dims,
+      const vector<TIndex>& filter_dims,
+      const vector<cudnnDataType_t>& data_types,
+      cudnnDataType_t compute_type) const {
+    std::ostringstream key;
+    key << CudnnAlgorithmsKeyPrefix() << " conv_" << pass << " order"
+        << static_cast<int>(order_) << " input";
+    for (auto d : input_dims) {
+      key << "," << d;
+    }
+    key << " filter";
+    for (auto d : filter_dims) {
+      key << "," << d;
+    }
+    key << " pads";
+    for (auto p : pads_) {
+      key << "," << p;
+    }
+    key << " stride";
+    for (auto s : stride_) {
+      key << "," << s;
+    }
+    key << " dilation";
+    for (auto d : dilation_) {
+      key << "," << d;
+    }
+    key << " group" << group_ << " types";
+    for (auto t : data_types) {
+      key << "," << static_cast<int>(t);
+    }
+    key << " compute" << static_cast<int>(compute_type) << " tensor_core"
+        << enable_tensor_core_ << " ws" << ws_nbytes_limit_;
+    return key.str();
+  }
+
   vector<TIndex> cudnn_input_dims_;
   vector<TIndex> cudnn_filter_dims_;
 
@@ -423,6 +466,9 @@ class CudnnConvOpBase : public ConvPoolOpBase<CUDAContext> {
   cudnnTensorDescriptor_t top_desc_for_bias_;
   cudnnConvolutionDescriptor_t conv_desc_;
   const size_t cudnn_ws_nbytes_limit_;
+  // cudnn_ws_nbytes_limit_, capped to the memory available when the
+  // algorithms were last chosen
+  size_t ws_nbytes_limit_;
   size_t cudnn_ws_nbytes_;
   bool exhaustive_search_;
   bool deterministic_;
@@ -447,7 +493,6 @@ class CudnnConvOp final : public CudnnConvOpBase {
  private:
   cudnnConvolutionFwdAlgo_t algo_;
   using ConvFwdAlgorithmWithCost = std::tuple<cudnnConvolutionFwdAlgo_t, float>;
-  AlgorithmsCache<ConvFwdAlgorithmWithCost> algo_cache_;
   // Input: X, W, b
   // Output: Y
   INPUT_TAGS(INPUT, FILTER, BIAS);
@@ -492,8 +537,6 @@ class CudnnConvGradientOp final : public CudnnConvOpBase {
       std::tuple<cudnnConvolutionBwdFilterAlgo_t, float>;
   using ConvBwdDataAlgorithmWithCost =
       std::tuple<cudnnConvolutionBwdDataAlgo_t, float>;
-  AlgorithmsCache<ConvBwdFilterAlgorithmWithCost> filter_algo_cache_;
-  AlgorithmsCache<ConvBwdDataAlgorithmWithCost> data_algo_cache_;
   bool no_bias_;
   // input: X, W, dY
   // output: dW, db, and optionally dX
@@ -679,6 +722,8 @@ bool CudnnConvOp::DoRunWithType() {
     CUDNN_CHECK(cudnnSetConvolutionGroupCount(conv_desc_, group_));
 #endif
 
+    ws_nbytes_limit_ = cudnn_wrapper_.workspace_nbytes_limit(
+        cudnn_state_, cudnn_ws_nbytes_limit_);
     if (force_algo_[ALGO_FWD] >= 0) {
       algo_ = (cudnnConvolutionFwdAlgo_t)force_algo_[ALGO_FWD];
     } else if (deterministic_) {
@@ -688,11 +733,20 @@ bool CudnnConvOp::DoRunWithType() {
       // because it may be faster. However, if FP32 compute is specified,
       // FP16 is not a suitable alternative - early out from the loop.
       std::array<ConvFwdAlgorithmWithCost, 2> algosToCompare;
+      auto& cache = PersistentAlgorithmsCache::Get();
       for (int i = 0; i < 2; i++) {
         SetConvDescComputeType(conv_desc_, kComputeTypesToTry[i]);
 
-        algosToCompare[i] = algo_cache_.getAlgorithm(
-            X.dims(), filter.dims(), kComputeTypesToTry[i], [&]() {
+        const auto key = AlgorithmsCacheKey(
+            "fwd",
+            X.dims(),
+            filter.dims(),
+            {cudnnTypeWrapper<T_X>::type,
+             cudnnTypeWrapper<T_W>::type,
+             cudnnTypeWrapper<T_Y>::type},
+            kComputeTypesToTry[i]);
+        algosToCompare[i] = cache.getAlgorithm<cudnnConvolutionFwdAlgo_t>(
+            key, [&]() {
               VLOG(1) << "CUDNN Convolution fwd: doing exhaustive "
                       << "search for " << kComputePassNames[i];
               // When we do an exhaustive search, we will ignore the workspace
@@ -718,8 +772,8 @@ bool CudnnConvOp::DoRunWithType() {
                         kNUM_CUDNN_FWD_ALGS,
                         &returned_algo_count,
                         fwd_perf_stat.data(),
-                        state->workspace().get(cudnn_ws_nbytes_limit_),
-                        cudnn_ws_nbytes_limit_));
+                        state->workspace().get(ws_nbytes_limit_),
+                        ws_nbytes_limit_));
                   });
               LogCuDNNPerfStats(fwd_perf_stat, returned_algo_count);
               float algo_time = fwd_perf_stat[0].status == CUDNN_STATUS_SUCCESS
@@ -755,7 +809,7 @@ bool CudnnConvOp::DoRunWithType() {
           conv_desc_,
           top_desc_,
           CUDNN_CONVOLUTION_FWD_SPECIFY_WORKSPACE_LIMIT,
-          cudnn_ws_nbytes_limit_,
+          ws_nbytes_limit_,
           &algo_));
     }
     CUDNN_ENFORCE(cudnnGetConvolutionForwardWorkspaceSize(
@@ -1042,6 +1096,8 @@ bool CudnnConvGradientOp::DoRunWithType() {
     CUDNN_CHECK(cudnnSetConvolutionGroupCount(bwd_data_conv_desc_, group_));
 #endif
 
+    ws_nbytes_limit_ = cudnn_wrapper_.workspace_nbytes_limit(
+        cudnn_state_, cudnn_ws_nbytes_limit_);
     // Choose dW algorithm
     if (force_algo_[ALGO_WGRAD] >= 0) {
       bwd_filter_algo_ =
@@ -1053,11 +1109,20 @@ bool CudnnConvGradientOp::DoRunWithType() {
       // because it may be faster. However, if FP32 compute is specified,
       // FP16 is not a suitable alternative - early out from the loop.
       std::array<ConvBwdFilterAlgorithmWithCost, 2> algosToCompare;
+      auto& cache = PersistentAlgorithmsCache::Get();
       for (int i = 0; i < 2; i++) {
         SetConvDescComputeType(bwd_filter_conv_desc_, kComputeTypesToTry[i]);
 
-        algosToCompare[i] = filter_algo_cache_.getAlgorithm(
-            X.dims(), filter.dims(), kComputeTypesToTry[i], [&]() {
+        const auto key = AlgorithmsCacheKey(
+            "wgrad",
+            X.dims(),
+            filter.dims(),
+            {cudnnTypeWrapper<T_X>::type,
+             cudnnTypeWrapper<T_DY>::type,
+             cudnnTypeWrapper<T_DW>::type},
+            kComputeTypesToTry[i]);
+        algosToCompare[i] = cache.getAlgorithm<cudnnConvolutionBwdFilterAlgo_t>(
+            key, [&]() {
               VLOG(1) << "CUDNN Convolution bwd: doing filter exhaustive"
                       << "search for " << kComputePassNames[i];
               // When we do an exhaustive search, we will ignore the workspace
@@ -1086,8 +1151,8 @@ bool CudnnConvGradientOp::DoRunWithType() {
                         kNUM_CUDNN_BWD_FILTER_ALGS,
                         &returned_algo_count,
                         filter_perf_stat.data(),
-                        state->workspace().get(cudnn_ws_nbytes_limit_),
-                        cudnn_ws_nbytes_limit_));
+                        state->workspace().get(ws_nbytes_limit_),
+                        ws_nbytes_limit_));
                   });
               LogCuDNNPerfStats(filter_perf_stat, returned_algo_count);
               float algo_time =
@@ -1126,7 +1191,7 @@ bool CudnnConvGradientOp::DoRunWithType() {
           bwd_filter_conv_desc_,
           filter_desc_,
           CUDNN_CONVOLUTION_BWD_FILTER_SPECIFY_WORKSPACE_LIMIT,
-          cudnn_ws_nbytes_limit_,
+          ws_nbytes_limit_,
           &bwd_filter_algo_));
     }
     // Pick dX algo if needed
@@ -1140,11 +1205,20 @@ bool CudnnConvGradientOp::DoRunWithType() {
         // because it may be faster. However, if FP32 compute is specified,
         // FP16 is not a suitable alternative - early out from the loop.
         std::array<ConvBwdDataAlgorithmWithCost, 2> algosToCompare;
+        auto& cache = PersistentAlgorithmsCache::Get();
         for (int i = 0; i < 2; i++) {
           SetConvDescComputeType(bwd_data_conv_desc_, kComputeTypesToTry[i]);
 
-          algosToCompare[i] = data_algo_cache_.getAlgorithm(
-              X.dims(), filter.dims(), kComputeTypesToTry[i], [&]() {
+          const auto key = AlgorithmsCacheKey(
+              "dgrad",
+              X.dims(),
+              filter.dims(),
+              {cudnnTypeWrapper<T_W>::type,
+               cudnnTypeWrapper<T_DY>::type,
+               cudnnTypeWrapper<T_DX>::type},
+              kComputeTypesToTry[i]);
+          algosToCompare[i] = cache.getAlgorithm<cudnnConvolutionBwdDataAlgo_t>(
+              key, [&]() {
                 VLOG(1) << "CUDNN Convolution bwd: doing data exhaustive"
                         << "search for " << kComputePassNames[i];
                 int returned_algo_count;
@@ -1173,8 +1247,8 @@ bool CudnnConvGradientOp::DoRunWithType() {
                           kNUM_CUDNN_BWD_DATA_ALGS,
                           &returned_algo_count,
                           data_perf_stat.data(),
-                          state->workspace().get(cudnn_ws_nbytes_limit_),
-                          cudnn_ws_nbytes_limit_));
+                          state->workspace().get(ws_nbytes_limit_),
+                          ws_nbytes_limit_));
                     });
 
                 LogCuDNNPerfStats(data_perf_stat, returned_algo_count);
@@ -1213,7 +1287,7 @@ bool CudnnConvGradientOp::DoRunWithType() {
             bwd_data_conv_desc_,
             bottom_desc_,
             CUDNN_CONVOLUTION_BWD_DATA_SPECIFY_WORKSPACE_LIMIT,
-            cudnn_ws_nbytes_limit_,
+            ws_nbytes_limit_,
             &bwd_data_algo_));
       }
     }
@@ -0,0 +1,387 @@
+#include <algorithm>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/perfkernels/direct_conv.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Winograd F(4x4, 3x3): 4x4 output tiles of 6x6 input tiles
+constexpr int kWinogradTile = 4;
+constexpr int kWinogradInputTile = 6;
+constexpr int kWinogradElements = kWinogradInputTile * kWinogradInputTile;
+
+// Copies the image into a zero padded buffer of height x width, with the
+// image at (pad_t, pad_l), so that the kernels never check bounds
+void PadImage(
+    const float* X,
+    int C,
+    int H,
+    int W,
+    int pad_t,
+    int pad_l,
+    int height,
+    int width,
+    float* padded) {
+  std::fill(padded, padded + C * height * width, 0.0f);
+  for (int c = 0; c < C; ++c) {
+    for (int h = 0; h < H; ++h) {
+      std::copy(
+          X + (c * H + h) * W,
+          X + (c * H + h + 1) * W,
+          padded + (c * height + h + pad_t) * width + pad_l);
+    }
+  }
+}
+
+// Packs the M x C x kernel_h x kernel_w filter to the blocks of
+// DirectConvRow, padded with zeros
+void PackDirectFilter(
+    const float* filter,
+    int M,
+    int C,
+    int kernel_size,
+    std::vector<float>* packed) {
+  const int num_blocks = (M + kDirectConvBlockM - 1) / kDirectConvBlockM;
+  packed->assign(num_blocks * C * kernel_size * kDirectConvBlockM, 0.0f);
+  for (int m = 0; m < M; ++m) {
+    float* block = packed->data() +
+        (m / kDirectConvBlockM) * C * kernel_size * kDirectConvBlockM +
+        m % kDirectConvBlockM;
+    for (int i = 0; i < C * kernel_size; ++i) {
+      block[i * kDirectConvBlockM] = filter[m * C * kernel_size + i];
+    }
+  }
+}
+
+// 1D transforms of the Winograd F(4x4, 3x3) algorithm, which are applied to
+// the rows and then the columns of the tiles. in and out are strided by
+// in_stride and out_stride.
+
+// g -> G g for the 3 values of a filter
+void WinogradFilterTransform(
+    const float* in,
+    int in_stride,
+    float* out,
+    int out_stride) {
+  const float g0 = in[0], g1 = in[in_stride], g2 = in[2 * in_stride];
+  out[0] = g0 / 4;
+  out[out_stride] = -(g0 + g1 + g2) / 6;
+  out[2 * out_stride] = -(g0 - g1 + g2) / 6;
+  out[3 * out_stride] = g0 / 24 + g1 / 12 + g2 / 6;
+  out[4 * out_stride] = g0 / 24 - g1 / 12 + g2 / 6;
+  out[5 * out_stride] = g2;
+}
+
+// d -> B^T d for the 6 values of an input tile
+void WinogradInputTransform(
+    const float* in,
+    int in_stride,
+    float* out,
+    int out_stride) {
+  float d[kWinogradInputTile];
+  for (int i = 0; i < kWinogradInputTile; ++i) {
+    d[i] = in[i * in_stride];
+  }
+  out[0] = 4 * d[0] - 5 * d[2] + d[4];
+  out[out_stride] = -4 * d[1] - 4 * d[2] + d[3] + d[4];
+  out[2 * out_stride] = 4 * d[1] - 4 * d[2] - d[3] + d[4];
+  out[3 * out_stride] = -2 * d[1] - d[2] + 2 * d[3] + d[4];
+  out[4 * out_stride] = 2 * d[1] - d[2] - 2 * d[3] + d[4];
+  out[5 * out_stride] = 4 * d[1] - 5 * d[3] + d[5];
+}
+
+// m -> A^T m for the 6 values of a tile of products
+void WinogradOutputTransform(
+    const float* in,
+    int in_stride,
+    float* out,
+    int out_stride) {
+  float m[kWinogradInputTile];
+  for (int i = 0; i < kWinogradInputTile; ++i) {
+    m[i] = in[i * in_stride];
+  }
+  out[0] = m[0] + m[1] + m[2] + m[3] + m[4];
+  out[out_stride] = m[1] - m[2] + 2 * (m[3] - m[4]);
+  out[2 * out_stride] = m[1] + m[2] + 4 * (m[3] + m[4]);
+  out[3 * out_stride] = m[1] - m[2] + 8 * (m[3] - m[4]) + m[5];
+}
+
+// Transforms the M x C x 3 x 3 filter to U = G g G^T, stored as the
+// kWinogradElements matrices of M x C
+void PackWinogradFilter(
+    const float* filter,
+    int M,
+    int C,
+    std::vector<float>* packed) {
+  packed->resize(kWinogradElements * M * C);
+  float rows[kWinogradInputTile * 3];
+  float u[kWinogradElements];
+  for (int m = 0; m < M; ++m) {
+    for (int c = 0; c < C; ++c) {
+      const float* g = filter + (m * C + c) * 9;
+      for (int j = 0; j < 3; ++j) {
+        WinogradFilterTransform(g + j, 3, rows + j, 3);
+      }
+      for (int i = 0; i < kWinogradInputTile; ++i) {
+        WinogradFilterTransform(rows + i * 3, 1, u + i * kWinogradInputTile, 1);
+      }
+      for (int e = 0; e < kWinogradElements; ++e) {
+        (*packed)[(e * M + m) * C + c] = u[e];
+      }
+    }
+  }
+}
+
+} // namespace
+
+/**
+ * Conv engine for small batch inference on CPU, without the im2col buffer of
+ * the default engine:
+ *
+ * - 1x1 convolutions with stride 1 and no padding are a single GEMM of the
+ *   filter and the image.
+ * - 3x3 convolutions with stride 1 and no dilation run with Winograd
+ *   F(4x4, 3x3), as 36 GEMMs of the transformed filters and input tiles.
+ * - Other convolutions run DirectConvRow, which accumulates blocks of
+ *   output channels by output pixels in registers.
+ *
+ * The filters are packed the first time the operator runs, and again only
+ * when their data moves or is reshaped, i.e. they are expected to be
+ * constants.
+ */
+class DirectConvOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  DirectConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws) {
+    OPERATOR_NEEDS_FEATURE(
+        order_ == StorageOrder::NCHW && kernel_.size() == 2,
+        "DIRECT only supports 2D NCHW convolutions.");
+    OPERATOR_NEEDS_FEATURE(group_ == 1, "Group convolution not supported.");
+  }
+  ~DirectConvOp() {}
+
+  bool RunOnDeviceWithOrderNCHW() override {
+    const auto& X = Input(INPUT);
+    const auto& filter = Input(FILTER);
+    auto* Y = Output(0);
+    CAFFE_ENFORCE_EQ(X.ndim(), 4);
+    CAFFE_ENFORCE_EQ(filter.ndim(), 4);
+    const int N = X.dim32(0), C = X.dim32(1);
+    const int M = filter.dim32(0);
+    CAFFE_ENFORCE_EQ(filter.dim32(1), C);
+    CAFFE_ENFORCE_EQ(filter.dim32(2), kernel_h());
+    CAFFE_ENFORCE_EQ(filter.dim32(3), kernel_w());
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X, Y, M);
+
+    const bool unit_stride = stride_h() == 1 && stride_w() == 1 &&
+        dilation_h() == 1 && dilation_w() == 1;
+    const bool pointwise = kernel_h() == 1 && kernel_w() == 1 &&
+        unit_stride && pad_t() == 0 && pad_l() == 0 && pad_b() == 0 &&
+        pad_r() == 0;
+    const bool winograd = kernel_h() == 3 && kernel_w() == 3 && unit_stride;
+    const float* filter_data = filter.template data<float>();
+    if (!pointwise &&
+        (filter_data != filter_data_ || filter.dims() != filter_dims_)) {
+      if (winograd) {
+        PackWinogradFilter(filter_data, M, C, &packed_filter_);
+      } else {
+        PackDirectFilter(
+            filter_data, M, C, kernel_h() * kernel_w(), &packed_filter_);
+      }
+      filter_data_ = filter_data;
+      filter_dims_ = filter.dims();
+    }
+
+    const int input_image_size = C * X.dim32(2) * X.dim32(3);
+    const int output_image_size = M * Y->dim32(2) * Y->dim32(3);
+    const float* Xdata = X.template data<float>();
+    float* Ydata = Y->template mutable_data<float>();
+    for (int image_id = 0; image_id < N; ++image_id) {
+      if (pointwise) {
+        // The image is already the matrix of the GEMM
+        math::Gemm<float, CPUContext>(
+            CblasNoTrans,
+            CblasNoTrans,
+            M,
+            Y->dim32(2) * Y->dim32(3),
+            C,
+            1,
+            filter_data,
+            Xdata,
+            0,
+            Ydata,
+            &context_);
+      } else if (winograd) {
+        RunWinograd(X, Xdata, Y, Ydata);
+      } else {
+        RunDirect(X, Xdata, Y, Ydata);
+      }
+      Xdata += input_image_size;
+      Ydata += output_image_size;
+    }
+
+    if (InputSize() == 3) {
+      const auto& bias = Input(BIAS);
+      CAFFE_ENFORCE_EQ(bias.ndim(), 1);
+      CAFFE_ENFORCE_EQ(bias.dim32(0), M);
+      const float* bias_data = bias.template data<float>();
+      const int image_size = Y->dim32(2) * Y->dim32(3);
+      Ydata = Y->template mutable_data<float>();
+      for (int i = 0; i < N * M; ++i) {
+        const float b = bias_data[i % M];
+        for (int j = 0; j < image_size; ++j) {
+          Ydata[i * image_size + j] += b;
+        }
+      }
+    }
+    return true;
+  }
+
+ private:
+  void RunDirect(
+      const TensorCPU& X,
+      const float* Xdata,
+      const TensorCPU* Y,
+      float* Ydata) {
+    const int C = X.dim32(1), H = X.dim32(2), W = X.dim32(3);
+    const int M = Y->dim32(1), OH = Y->dim32(2), OW = Y->dim32(3);
+    const int height = H + pad_t() + pad_b();
+    const int width = W + pad_l() + pad_r();
+    padded_.resize(C * height * width);
+    PadImage(Xdata, C, H, W, pad_t(), pad_l(), height, width, padded_.data());
+
+    const int block_size = C * kernel_h() * kernel_w() * kDirectConvBlockM;
+    for (int m = 0; m < M; m += kDirectConvBlockM) {
+      const float* block =
+          packed_filter_.data() + (m / kDirectConvBlockM) * block_size;
+      for (int oh = 0; oh < OH; ++oh) {
+        DirectConvRow(
+            OW,
+            padded_.data() + oh * stride_h() * width,
+            C,
+            height * width,
+            width,
+            block,
+            kernel_h(),
+            kernel_w(),
+            dilation_h(),
+            dilation_w(),
+            stride_w(),
+            std::min(kDirectConvBlockM, M - m),
+            Ydata + (m * OH + oh) * OW,
+            OH * OW);
+      }
+    }
+  }
+
+  void RunWinograd(
+      const TensorCPU& X,
+      const float* Xdata,
+      const TensorCPU* Y,
+      float* Ydata) {
+    const int C = X.dim32(1), H = X.dim32(2), W = X.dim32(3);
+    const int M = Y->dim32(1), OH = Y->dim32(2), OW = Y->dim32(3);
+    const int tiles_h = (OH + kWinogradTile - 1) / kWinogradTile;
+    const int tiles_w = (OW + kWinogradTile - 1) / kWinogradTile;
+    const int num_tiles = tiles_h * tiles_w;
+    // The padding of the image, extended to whole tiles
+    const int height = tiles_h * kWinogradTile + 2;
+    const int width = tiles_w * kWinogradTile + 2;
+    padded_.resize(C * height * width);
+    PadImage(Xdata, C, H, W, pad_t(), pad_l(), height, width, padded_.data());
+
+    // V = B^T d B of every tile, as kWinogradElements matrices of C x tiles
+    transformed_input_.resize(kWinogradElements * C * num_tiles);
+    float rows[kWinogradElements];
+    float v[kWinogradElements];
+    for (int c = 0; c < C; ++c) {
+      for (int t = 0; t < num_tiles; ++t) {
+        const float* d = padded_.data() +
+            (c * height + (t / tiles_w) * kWinogradTile) * width +
+            (t % tiles_w) * kWinogradTile;
+        for (int j = 0; j < kWinogradInputTile; ++j) {
+          WinogradInputTransform(d + j, width, rows + j, kWinogradInputTile);
+        }
+        for (int i = 0; i < kWinogradInputTile; ++i) {
+          WinogradInputTransform(
+              rows + i * kWinogradInputTile, 1, v + i * kWinogradInputTile, 1);
+        }
+        for (int e = 0; e < kWinogradElements; ++e) {
+          transformed_input_[(e * C + c) * num_tiles + t] = v[e];
+        }
+      }
+    }
+
+    // The elementwise products summed over the channels, as GEMMs of the
+    // transformed filters and input tiles
+    products_.resize(kWinogradElements * M * num_tiles);
+    for (int e = 0; e < kWinogradElements; ++e) {
+      math::Gemm<float, CPUContext>(
+          CblasNoTrans,
+          CblasNoTrans,
+          M,
+          num_tiles,
+          C,
+          1,
+          packed_filter_.data() + e * M * C,
+          transformed_input_.data() + e * C * num_tiles,
+          0,
+          products_.data() + e * M * num_tiles,
+          &context_);
+    }
+
+    // Y = A^T m A of every tile, clipped to the output image
+    float m_tile[kWinogradElements];
+    float y_tile[kWinogradTile * kWinogradTile];
+    for (int m = 0; m < M; ++m) {
+      for (int t = 0; t < num_tiles; ++t) {
+        for (int e = 0; e < kWinogradElements; ++e) {
+          m_tile[e] = products_[(e * M + m) * num_tiles + t];
+        }
+        for (int j = 0; j < kWinogradInputTile; ++j) {
+          WinogradOutputTransform(
+              m_tile + j, kWinogradInputTile, rows + j, kWinogradInputTile);
+        }
+        for (int i = 0; i < kWinogradTile; ++i) {
+          WinogradOutputTransform(
+              rows + i * kWinogradInputTile,
+              1,
+              y_tile + i * kWinogradTile,
+              1);
+        }
+        const int oh_begin = (t / tiles_w) * kWinogradTile;
+        const int ow_begin = (t % tiles_w) * kWinogradTile;
+        const int tile_h = std::min(kWinogradTile, OH - oh_begin);
+        const int tile_w = std::min(kWinogradTile, OW - ow_begin);
+        for (int i = 0; i < tile_h; ++i) {
+          std::copy(
+              y_tile + i * kWinogradTile,
+              y_tile + i * kWinogradTile + tile_w,
+              Ydata + (m * OH + oh_begin + i) * OW + ow_begin);
+        }
+      }
+    }
+  }
+
+  INPUT_TAGS(INPUT, FILTER, BIAS);
+
+  // The packed filter and the data it was packed from
+  const float* filter_data_{nullptr};
+  vector<TIndex> filter_dims_;
+  std::vector<float> packed_filter_;
+  std::vector<float> padded_;
+  std::vector<float> transformed_input_;
+  std::vector<float> products_;
+};
+
+REGISTER_CPU_OPERATOR_WITH_ENGINE(Conv, DIRECT, DirectConvOp);
+REGISTER_CPU_OPERATOR_WITH_ENGINE(Conv2D, DIRECT, DirectConvOp);
+
+} // namespace caffe2
@@ -568,6 +568,43 @@ class ConvPoolOpBase : public Operator<Context> {
     return TensorInferenceForSchema(def, in, num_channels);
   }
 
+  static struct OpSchema::Cost CostInferenceForPool(
+      const OperatorDef& def,
+      const vector<TensorShape>& inputs) {
+    struct OpSchema::Cost c;
+    const TensorShape X = inputs[0];
+    if (X.unknown_shape() || X.dims_size() == 0) {
+      return c;
+    }
+    const TensorShape Y = TensorInferenceForPool(def, inputs)[0];
+    const uint64_t nElemX = nElemFromDim(X);
+    const uint64_t nElemY = nElemFromDim(Y);
+    ArgumentHelper helper(def);
+    uint64_t window = 1;
+    if (helper.GetSingleArgument<int>("global_pooling", 0)) {
+      window = nElemY > 0 ? nElemX / nElemY : 0;
+    } else {
+      vector<int> kernel = helper.GetRepeatedArgument<int>("kernels");
+      if (helper.HasArgument("kernel")) {
+        kernel.resize(2, helper.GetSingleArgument<int>("kernel", 1));
+      } else if (
+          helper.HasArgument("kernel_h") && helper.HasArgument("kernel_w")) {
+        kernel.push_back(helper.GetSingleArgument<int>("kernel_h", 1));
+        kernel.push_back(helper.GetSingleArgument<int>("kernel_w", 1));
+      }
+      for (int k : kernel) {
+        window *= k;
+      }
+    }
+
+    // One comparison or addition per element of each window.
+    c.flops = nElemY * window;
+    c.bytes_read = nElemX * sizeof(X.data_type());
+    c.bytes_written = nElemY * sizeof(Y.data_type());
+    c.params_bytes = 0;
+    return c;
+  }
+
   static std::vector<TensorShape> TensorInferenceForLC(
       const OperatorDef& def,
       const std::vector<TensorShape>& in) {
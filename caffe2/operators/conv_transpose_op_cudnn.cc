@@ -310,7 +310,8 @@ bool CudnnConvTransposeOp<T>::RunOnDevice() {
           conv_desc_,
           top_desc_,
           CUDNN_CONVOLUTION_BWD_DATA_SPECIFY_WORKSPACE_LIMIT,
-          cudnn_ws_nbytes_limit_,
+          cudnn_wrapper_.workspace_nbytes_limit(
+              cudnn_state_, cudnn_ws_nbytes_limit_),
           &bwd_data_algo_));
     }
 
@@ -567,6 +568,8 @@ bool CudnnConvTransposeGradientOp<T>::RunOnDevice() {
             return fwd_perf_stat[0].algo;
           });
     } else {
+      const size_t ws_nbytes_limit = cudnn_wrapper_.workspace_nbytes_limit(
+          cudnn_state_, cudnn_ws_nbytes_limit_);
       // choose backward algorithm for filter
       CUDNN_ENFORCE(cudnnGetConvolutionBackwardFilterAlgorithm(
           cudnn_wrapper_.inline_cudnn_handle(),
@@ -575,7 +578,7 @@ bool CudnnConvTransposeGradientOp<T>::RunOnDevice() {
           conv_desc_,
           filter_desc_,
           CUDNN_CONVOLUTION_BWD_FILTER_SPECIFY_WORKSPACE_LIMIT,
-          cudnn_ws_nbytes_limit_,
+          ws_nbytes_limit,
           &bwd_filter_algo_));
       // choose backward algo for data
       CUDNN_ENFORCE(cudnnGetConvolutionForwardAlgorithm(
@@ -585,7 +588,7 @@ bool CudnnConvTransposeGradientOp<T>::RunOnDevice() {
           conv_desc_,
           bottom_desc_,
           CUDNN_CONVOLUTION_FWD_SPECIFY_WORKSPACE_LIMIT,
-          cudnn_ws_nbytes_limit_,
+          ws_nbytes_limit,
           &algo_));
     }
     // get workspace for backwards filter algorithm
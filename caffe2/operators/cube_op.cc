@@ -36,6 +36,7 @@ REGISTER_CPU_OPERATOR(
 OPERATOR_SCHEMA(Cube)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<2>)
     .IdenticalTypeAndShape()
     .Input(0, "X", "*(type: Tensor`<float>`)* Input tensor.")
     .Output(
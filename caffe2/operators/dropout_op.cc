@@ -21,9 +21,20 @@ bool DropoutOp<float, CPUContext>::RunOnDevice() {
     const float* Xdata = X.data<float>();
     float* Ydata = Y->mutable_data<float>();
     auto mask = Output(1);
+    auto& gen = context_.RandGenerator();
+    if (packed_mask_) {
+      mask->Resize(DropoutPackedMaskSize(X.size()));
+      uint8_t* mask_data = mask->mutable_data<uint8_t>();
+      std::fill(mask_data, mask_data + mask->size(), 0);
+      for (int i = 0; i < X.size(); ++i) {
+        const bool keep = dist(gen);
+        mask_data[i / 8] |= keep << (i % 8);
+        Ydata[i] = Xdata[i] * scale * keep;
+      }
+      return true;
+    }
     mask->Resize(X.dims());
     bool* mask_data = mask->mutable_data<bool>();
-    auto& gen = context_.RandGenerator();
     for (int i = 0; i < X.size(); ++i) {
       mask_data[i] = dist(gen);
       Ydata[i] = Xdata[i] * scale * mask_data[i];
@@ -45,11 +56,19 @@ bool DropoutGradientOp<float, CPUContext>::RunOnDevice() {
     return true;
   } else {
     auto& mask = Input(1);
-    CAFFE_ENFORCE_EQ(dY.size(), mask.size());
     const float* dYdata = dY.data<float>();
-    const bool* mask_data = mask.data<bool>();
     float* dXdata = dX->mutable_data<float>();
     float scale = 1. / (1. - ratio_);
+    if (packed_mask_) {
+      CAFFE_ENFORCE_EQ(DropoutPackedMaskSize(dY.size()), mask.size());
+      const uint8_t* mask_data = mask.data<uint8_t>();
+      for (int i = 0; i < dY.size(); ++i) {
+        dXdata[i] = dYdata[i] * ((mask_data[i / 8] >> (i % 8)) & 1) * scale;
+      }
+      return true;
+    }
+    CAFFE_ENFORCE_EQ(dY.size(), mask.size());
+    const bool* mask_data = mask.data<bool>();
     for (int i = 0; i < dY.size(); ++i) {
       dXdata[i] = dYdata[i] * mask_data[i] * scale;
     }
@@ -63,6 +82,7 @@ REGISTER_CPU_OPERATOR(DropoutGrad, DropoutGradientOp<float, CPUContext>);
 OPERATOR_SCHEMA(Dropout)
     .NumInputs(1)
     .NumOutputs(1, 2)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .AllowInplace({{0, 0}})
     .TensorInferenceFunction([](const OperatorDef& def,
                                 const vector<TensorShape>& in) {
@@ -71,8 +91,18 @@ OPERATOR_SCHEMA(Dropout)
       ArgumentHelper argsHelper(def);
       out.push_back(in[0]);
       if (def.output().size() == 2) {
-        out.push_back(in[0]);
-        out[1].set_data_type(TensorProto_DataType_BOOL);
+        if (argsHelper.GetSingleArgument<bool>("packed_mask", false)) {
+          TIndex size = 1;
+          for (auto d : in[0].dims()) {
+            size *= d;
+          }
+          out.push_back(CreateTensorShape(
+              vector<TIndex>{DropoutPackedMaskSize(size)},
+              TensorProto_DataType_UINT8));
+        } else {
+          out.push_back(in[0]);
+          out[1].set_data_type(TensorProto_DataType_BOOL);
+        }
       }
       return out;
     })
@@ -145,6 +175,11 @@ mask: [[False False False  True  True]
 
 )DOC")
     .Arg("ratio", "*(type: float; default: 0.5)* Probability of an element to be zeroed.")
+    .Arg(
+        "packed_mask",
+        "*(type: bool; default: False)* If set, `mask` is a 1D `uint8` tensor "
+        "of $\\lceil size(X) / 8 \\rceil$ bytes that holds one bit per element. "
+        "Bit $b$ of byte $j$ is set if element $8j + b$ is kept.")
     .ArgIsTest(
         "*(type: int; default: 0)* If zero (train mode), perform dropout. If non-zero"
         "(test mode), Y = X.")
@@ -16,6 +16,27 @@ __global__ void DropoutKernel(
     Ydata[i] = Xdata[i] * scale * maskdata[i];
   }
 }
+
+// Every thread writes one byte of the mask, from the uniforms in Ydata of its
+// 8 elements.
+__global__ void PackedDropoutKernel(
+    const int N,
+    const float ratio,
+    const float* Xdata,
+    float* Ydata,
+    uint8_t* maskdata) {
+  const float scale = 1. / (1. - ratio);
+  CUDA_1D_KERNEL_LOOP(j, (N + 7) / 8) {
+    uint8_t byte = 0;
+    for (int b = 0; b < 8 && 8 * j + b < N; ++b) {
+      const int i = 8 * j + b;
+      const bool keep = Ydata[i] > ratio;
+      byte |= keep << b;
+      Ydata[i] = Xdata[i] * scale * keep;
+    }
+    maskdata[j] = byte;
+  }
+}
 } // namespace
 
 template <>
@@ -35,10 +56,24 @@ bool DropoutOp<float, CUDAContext>::RunOnDevice() {
     // mask.
     float* Ydata = Y->mutable_data<float>();
     auto* mask = Output(1);
-    mask->Resize(X.dims());
     CAFFE_ENFORCE(X.data<float>() != Ydata, "In-place GPU dropout is broken");
     CURAND_ENFORCE(
         curandGenerateUniform(context_.curand_generator(), Ydata, X.size()));
+    if (packed_mask_) {
+      mask->Resize(DropoutPackedMaskSize(X.size()));
+      PackedDropoutKernel<<<
+          CAFFE_GET_BLOCKS(mask->size()),
+          CAFFE_CUDA_NUM_THREADS,
+          0,
+          context_.cuda_stream()>>>(
+          X.size(),
+          ratio_,
+          X.data<float>(),
+          Ydata,
+          mask->mutable_data<uint8_t>());
+      return true;
+    }
+    mask->Resize(X.dims());
     DropoutKernel<<<
         CAFFE_GET_BLOCKS(X.size()),
         CAFFE_CUDA_NUM_THREADS,
@@ -60,6 +95,17 @@ __global__ void DropoutGradientKernel(
     dXdata[i] = dYdata[i] * maskdata[i] * scale;
   }
 }
+
+__global__ void PackedDropoutGradientKernel(
+    const int N,
+    const float* dYdata,
+    const uint8_t* maskdata,
+    const float scale,
+    float* dXdata) {
+  CUDA_1D_KERNEL_LOOP(i, N) {
+    dXdata[i] = dYdata[i] * ((maskdata[i / 8] >> (i % 8)) & 1) * scale;
+  }
+}
 } // namespace
 
 template <>
@@ -75,8 +121,22 @@ bool DropoutGradientOp<float, CUDAContext>::RunOnDevice() {
     return true;
   } else {
     auto& mask = Input(1);
-    CAFFE_ENFORCE_EQ(dY.size(), mask.size());
     const float scale = 1. / (1. - ratio_);
+    if (packed_mask_) {
+      CAFFE_ENFORCE_EQ(DropoutPackedMaskSize(dY.size()), mask.size());
+      PackedDropoutGradientKernel<<<
+          CAFFE_GET_BLOCKS(dY.size()),
+          CAFFE_CUDA_NUM_THREADS,
+          0,
+          context_.cuda_stream()>>>(
+          dY.size(),
+          dY.data<float>(),
+          mask.data<uint8_t>(),
+          scale,
+          dX->mutable_data<float>());
+      return true;
+    }
+    CAFFE_ENFORCE_EQ(dY.size(), mask.size());
     DropoutGradientKernel<<<
         CAFFE_GET_BLOCKS(dY.size()),
         CAFFE_CUDA_NUM_THREADS,
@@ -8,6 +8,11 @@
 
 namespace caffe2 {
 
+// Number of bytes of a packed dropout mask for n elements.
+inline TIndex DropoutPackedMaskSize(TIndex n) {
+  return (n + 7) / 8;
+}
+
 template <typename T, class Context>
 class DropoutOp final : public Operator<Context> {
  public:
@@ -16,7 +21,9 @@ class DropoutOp final : public Operator<Context> {
       : Operator<Context>(operator_def, ws),
         ratio_(OperatorBase::GetSingleArgument<float>("ratio", 0.5)),
         is_test_(
-            OperatorBase::GetSingleArgument<int>(OpSchema::Arg_IsTest, 0)) {
+            OperatorBase::GetSingleArgument<int>(OpSchema::Arg_IsTest, 0)),
+        packed_mask_(
+            OperatorBase::GetSingleArgument<bool>("packed_mask", false)) {
     CAFFE_ENFORCE_GE(ratio_, 0);
     CAFFE_ENFORCE_LT(ratio_, 1);
   }
@@ -26,6 +33,9 @@ class DropoutOp final : public Operator<Context> {
  protected:
   float ratio_;
   bool is_test_;
+  // If set, mask holds one bit per element: bit b of byte j is set if
+  // element 8 * j + b is kept.
+  bool packed_mask_;
   // Input: X; Output: Y, mask.
 };
 
@@ -37,7 +47,9 @@ class DropoutGradientOp final : public Operator<Context> {
       : Operator<Context>(operator_def, ws),
         ratio_(OperatorBase::GetSingleArgument<float>("ratio", 0.5)),
         is_test_(
-            OperatorBase::GetSingleArgument<int>(OpSchema::Arg_IsTest, 0)) {
+            OperatorBase::GetSingleArgument<int>(OpSchema::Arg_IsTest, 0)),
+        packed_mask_(
+            OperatorBase::GetSingleArgument<bool>("packed_mask", false)) {
     CAFFE_ENFORCE_GE(ratio_, 0);
     CAFFE_ENFORCE_LT(ratio_, 1);
   }
@@ -47,6 +59,7 @@ class DropoutGradientOp final : public Operator<Context> {
  protected:
   float ratio_;
   bool is_test_;
+  bool packed_mask_;
   // Input: dY, mask; Output: dX
 };
 
@@ -9,6 +9,7 @@ REGISTER_CPU_OPERATOR(Where, WhereOp<CPUContext>);
 OPERATOR_SCHEMA(Where)
     .NumInputs(3)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .AllowInplace({{1, 2}})
     .IdenticalTypeAndShapeOfInput(1)
     .SetDoc(R"DOC(
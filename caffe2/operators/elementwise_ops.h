@@ -1,6 +1,7 @@
 #ifndef CAFFE2_OPERATORS_ELEMENTWISE_OPS_H_
 #define CAFFE2_OPERATORS_ELEMENTWISE_OPS_H_
 
+#include <atomic>
 #include <iterator>
 #include <string>
 #include <tuple>
@@ -95,6 +96,11 @@ using UnaryElementwiseOp = UnaryElementwiseWithArgsOp<
     UnaryFunctorWithDefaultCtor<Functor>,
     OutputTypeMap>;
 
+// With the argument intra_op_parallel set, the CPU ops split the output into
+// chunks of at least kMinElementsPerChunk elements along its outermost
+// dimension, and compute them on the thread pool of the workspace. Calls with
+// too few chunks to split stay on the calling thread (see
+// ThreadPool::setMinWorkSize).
 template <
     typename InputTypes,
     class Context,
@@ -104,12 +110,16 @@ class BinaryElementwiseWithArgsOp final : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
 
+  static constexpr int kMinElementsPerChunk = 4096;
+
   BinaryElementwiseWithArgsOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<Context>(operator_def, ws),
         OP_SINGLE_ARG(bool, "broadcast", legacy_broadcast_, false),
         OP_SINGLE_ARG(int, "axis", axis_, -1),
         OP_SINGLE_ARG(string, "axis_str", axis_str_, ""),
         OP_SINGLE_ARG(string, "order", order_, "NCHW"),
+        OP_SINGLE_ARG(bool, "intra_op_parallel", intra_op_parallel_, false),
+        ws_(ws),
         functor_(*this) {
     if (legacy_broadcast_) {
       if (axis_ != -1) {
@@ -187,14 +197,94 @@ class BinaryElementwiseWithArgsOp final : public Operator<Context> {
     }
     auto* C_data =
         C->template mutable_data<typename OutputTypeMap::template type<T>>();
-    return functor_.Forward(A_dims, B_dims, A_data, B_data, C_data, &context_);
+    return Forward(A_dims, B_dims, A_data, B_data, C_data, &context_);
   }
 
  private:
+  template <typename TIn, typename TOut, class OtherContext>
+  bool Forward(
+      const std::vector<int>& A_dims,
+      const std::vector<int>& B_dims,
+      const TIn* A_data,
+      const TIn* B_data,
+      TOut* C_data,
+      OtherContext* context) {
+    return functor_.Forward(A_dims, B_dims, A_data, B_data, C_data, context);
+  }
+
+  template <typename TIn, typename TOut>
+  bool Forward(
+      const std::vector<int>& A_dims,
+      const std::vector<int>& B_dims,
+      const TIn* A_data,
+      const TIn* B_data,
+      TOut* C_data,
+      CPUContext* context) {
+    const int ndim = std::max(A_dims.size(), B_dims.size());
+    std::vector<int> A_chunk_dims(ndim - A_dims.size(), 1);
+    std::vector<int> B_chunk_dims(ndim - B_dims.size(), 1);
+    A_chunk_dims.insert(A_chunk_dims.end(), A_dims.cbegin(), A_dims.cend());
+    B_chunk_dims.insert(B_chunk_dims.end(), B_dims.cbegin(), B_dims.cend());
+    // The chunks split the outermost dimension of C that is not 1
+    int axis = 0;
+    while (axis < ndim &&
+           std::max(A_chunk_dims[axis], B_chunk_dims[axis]) == 1) {
+      ++axis;
+    }
+    if (!intra_op_parallel_ || axis == ndim) {
+      return functor_.Forward(A_dims, B_dims, A_data, B_data, C_data, context);
+    }
+    const int axis_size = std::max(A_chunk_dims[axis], B_chunk_dims[axis]);
+    int A_inner_size = 1;
+    int B_inner_size = 1;
+    int C_inner_size = 1;
+    for (int i = axis + 1; i < ndim; ++i) {
+      A_inner_size *= A_chunk_dims[i];
+      B_inner_size *= B_chunk_dims[i];
+      C_inner_size *= std::max(A_chunk_dims[i], B_chunk_dims[i]);
+    }
+    const int num_chunks = std::min<TIndex>(
+        axis_size,
+        static_cast<TIndex>(axis_size) * C_inner_size / kMinElementsPerChunk);
+    if (num_chunks <= 1) {
+      return functor_.Forward(A_dims, B_dims, A_data, B_data, C_data, context);
+    }
+
+    const bool A_broadcast = A_chunk_dims[axis] == 1;
+    const bool B_broadcast = B_chunk_dims[axis] == 1;
+    std::atomic<bool> success(true);
+    ws_->GetThreadPool()->run(
+        [&](int /* unused */, size_t chunk) {
+          const int begin = chunk * axis_size / num_chunks;
+          const int end = (chunk + 1) * axis_size / num_chunks;
+          std::vector<int> A_dims_of_chunk = A_chunk_dims;
+          std::vector<int> B_dims_of_chunk = B_chunk_dims;
+          if (!A_broadcast) {
+            A_dims_of_chunk[axis] = end - begin;
+          }
+          if (!B_broadcast) {
+            B_dims_of_chunk[axis] = end - begin;
+          }
+          if (!functor_.Forward(
+                  A_dims_of_chunk,
+                  B_dims_of_chunk,
+                  A_data + (A_broadcast ? 0 : begin * A_inner_size),
+                  B_data + (B_broadcast ? 0 : begin * B_inner_size),
+                  C_data + begin * C_inner_size,
+                  context)) {
+            success = false;
+          }
+        },
+        num_chunks);
+    return success;
+  }
+
   const bool legacy_broadcast_;
   int axis_;
   const std::string axis_str_;
   const std::string order_;
+  const bool intra_op_parallel_;
+  Workspace* ws_;
 
   Functor functor_;
 };
@@ -877,6 +877,7 @@ CAFFE2_SCHEMA_FOR_BINARY_BITWISE_OP(BitwiseXor, "bitwise_xor");
 OPERATOR_SCHEMA(Not)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .SetDoc(R"DOC(
 Performs element-wise negation on input tensor `X`.
 
@@ -933,6 +934,7 @@ SHOULD_NOT_DO_GRADIENT(Not);
 OPERATOR_SCHEMA(Sign)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .SetDoc(R"DOC(
 Computes sign for each element of the input: -1, 0 or 1.
 
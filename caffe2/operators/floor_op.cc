@@ -9,6 +9,7 @@ REGISTER_CPU_OPERATOR(Floor, FloorOp<float, CPUContext>);
 OPERATOR_SCHEMA(Floor)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .AllowInplace({{0, 0}})
     .SetDoc(R"DOC(
 Element-wise application of the floor function ($y=floor(x)$) to the input
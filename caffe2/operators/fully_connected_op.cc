@@ -1,9 +1,140 @@
+#include <algorithm>
 #include <functional>
 
 #include "caffe2/operators/fully_connected_op.h"
+#include "caffe2/perfkernels/float16.h"
 
 namespace caffe2 {
 
+namespace {
+
+// The fp32 blocks of W are kept in L2
+constexpr int kFloat16WeightBlockSize = 64 * 1024;
+
+template <class FullyConnectedOp>
+bool RunFullyConnectedOpOnCPUDevice(FullyConnectedOp* op) {
+  if (op->Input(1).template IsType<float16>()) {
+    return op->RunWithFloat16Weight();
+  }
+  return op->template DoRunWithType<
+      float, // X
+      float, // W
+      float, // B
+      float, // Y
+      float>(); // Math
+}
+
+} // namespace
+
+template <class Context, class Engine, bool TransposeWeight>
+bool FullyConnectedOp<Context, Engine, TransposeWeight>::
+    RunWithFloat16Weight() {
+  const auto& X = Input(0);
+  const auto& W = Input(1);
+  const auto& b = Input(2);
+  auto* Y = Output(0);
+  CAFFE_ENFORCE(b.ndim() == 1, b.ndim());
+  const auto canonical_axis = X.canonical_axis_index(axis_);
+  const int M = X.size_to_dim(canonical_axis);
+  const int K = X.size_from_dim(canonical_axis);
+  const auto canonical_axis_w = W.canonical_axis_index(axis_w_);
+  const int N = TransposeWeight ? W.size_to_dim(canonical_axis_w)
+                                : W.size_from_dim(canonical_axis_w);
+  CAFFE_ENFORCE_EQ(M, X.size() / K, "X: ", X.dims(), ", W: ", W.dims());
+  CAFFE_ENFORCE_EQ(K, W.size() / N, "X: ", X.dims(), ", W: ", W.dims());
+  CAFFE_ENFORCE_EQ(N, b.size(), "W: ", W.dims(), ", b: ", b.dims());
+
+  Y_shape_cache_ = X.dims();
+  Y_shape_cache_.resize(canonical_axis + 1);
+  Y_shape_cache_[canonical_axis] = N;
+  Y->Resize(Y_shape_cache_);
+  float* Y_data = Y->template mutable_data<float>();
+  if (X.size() == 0) {
+    return true;
+  }
+
+  // W is N x K, and its blocks of rows make blocks of columns of Y, or K x N
+  // without transposition, and blocks of the sum over K
+  const float* X_data = X.template data<float>();
+  const float16* W_data = W.template data<float16>();
+  const int rows = TransposeWeight ? N : K;
+  const int cols = TransposeWeight ? K : N;
+  const int block =
+      std::max(1, std::min(rows, kFloat16WeightBlockSize / std::max(cols, 1)));
+  W_block_.Resize(block, cols);
+  float* W_block_data = W_block_.template mutable_data<float>();
+  for (int r = 0; r < rows; r += block) {
+    const int n = std::min(block, rows - r);
+    Float16ToFloat(n * cols, W_data + r * cols, W_block_data);
+    if (TransposeWeight) {
+      math::GemmEx<float, Context>(
+          CblasNoTrans,
+          CblasTrans,
+          M,
+          n,
+          K,
+          1,
+          X_data,
+          K,
+          W_block_data,
+          K,
+          0,
+          Y_data + r,
+          N,
+          &context_);
+    } else {
+      math::GemmEx<float, Context>(
+          CblasNoTrans,
+          CblasNoTrans,
+          M,
+          N,
+          n,
+          1,
+          X_data + r,
+          K,
+          W_block_data,
+          N,
+          r == 0 ? 0 : 1,
+          Y_data,
+          N,
+          &context_);
+    }
+  }
+
+  // Add bias term
+  if (bias_multiplier_.size() != M) {
+    bias_multiplier_.Resize(M);
+    math::Set<float, Context>(
+        M, 1, bias_multiplier_.template mutable_data<float>(), &context_);
+  }
+  math::Gemm<float, Context>(
+      CblasNoTrans,
+      CblasNoTrans,
+      M,
+      N,
+      1,
+      1,
+      bias_multiplier_.template data<float>(),
+      b.template data<float>(),
+      1,
+      Y_data,
+      &context_);
+  return true;
+}
+
+template <>
+bool FullyConnectedOp<CPUContext>::RunOnDevice() {
+  return RunFullyConnectedOpOnCPUDevice(this);
+}
+
+template <>
+bool FullyConnectedOp<
+    CPUContext,
+    DefaultEngine,
+    false /* don't transpose weight */>::RunOnDevice() {
+  return RunFullyConnectedOpOnCPUDevice(this);
+}
+
 REGISTER_CPU_OPERATOR(FC, FullyConnectedOp<CPUContext>);
 REGISTER_CPU_OPERATOR(FCGradient, FullyConnectedGradientOp<CPUContext>);
 
@@ -243,7 +374,7 @@ Y:
     .Input(
         1,
         "W",
-        "Input blob to be coerced into a 2D matrix of shape $(N,K)$ describing a fully connected weight matrix. Here, $K$ is the number of features in a single observation and $N$ is the number of nodes in the FC layer.")
+        "Input blob to be coerced into a 2D matrix of shape $(N,K)$ describing a fully connected weight matrix. Here, $K$ is the number of features in a single observation and $N$ is the number of nodes in the FC layer. On CPU, a float16 $W$ halves the memory of the weights of float FC layers, which still compute in float.")
     .Input(
         2,
         "b",
@@ -129,6 +129,10 @@ class FullyConnectedOp final : public Operator<Context> {
     return true;
   }
 
+  // CPU only: fp32 FC with W stored in fp16, which is converted to fp32 a
+  // block of rows at a time. See fully_connected_op.cc.
+  bool RunWithFloat16Weight();
+
   bool RunOnDevice() override {
     return DoRunWithType<
         float, // X
@@ -145,6 +149,8 @@ class FullyConnectedOp final : public Operator<Context> {
   // a vector object every time we run Run().
   vector<TIndex> Y_shape_cache_;
   Tensor<Context> bias_multiplier_;
+  // The fp32 block of W of RunWithFloat16Weight
+  Tensor<Context> W_block_;
 
   bool float16_compute_;
 };
@@ -0,0 +1,281 @@
+#include "caffe2/operators/fused_elementwise_op.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <sstream>
+
+#include "caffe2/operators/elementwise_ops_utils.h"
+#include "caffe2/utils/eigen_utils.h"
+
+namespace caffe2 {
+
+namespace {
+
+struct StepInfo {
+  const char* name;
+  FusedElementwiseProgram::StepType type;
+  int num_operands;
+};
+
+const StepInfo kStepInfos[] = {
+    {"Add", FusedElementwiseProgram::StepType::Add, 2},
+    {"Sub", FusedElementwiseProgram::StepType::Sub, 2},
+    {"Mul", FusedElementwiseProgram::StepType::Mul, 2},
+    {"Div", FusedElementwiseProgram::StepType::Div, 2},
+    {"Sigmoid", FusedElementwiseProgram::StepType::Sigmoid, 1},
+    {"Tanh", FusedElementwiseProgram::StepType::Tanh, 1},
+    {"Relu", FusedElementwiseProgram::StepType::Relu, 1},
+    {"Exp", FusedElementwiseProgram::StepType::Exp, 1},
+    {"Log", FusedElementwiseProgram::StepType::Log, 1},
+    {"Abs", FusedElementwiseProgram::StepType::Abs, 1},
+    {"Sqr", FusedElementwiseProgram::StepType::Sqr, 1},
+    {"Sqrt", FusedElementwiseProgram::StepType::Sqrt, 1},
+    {"Negative", FusedElementwiseProgram::StepType::Negative, 1},
+    {"Scale", FusedElementwiseProgram::StepType::Scale, 1},
+};
+
+const StepInfo* FindStepInfo(const std::string& name) {
+  for (const auto& info : kStepInfos) {
+    if (name == info.name) {
+      return &info;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+FusedElementwiseProgram::FusedElementwiseProgram(
+    int num_inputs,
+    const std::vector<std::string>& steps,
+    const std::vector<int>& outputs)
+    : num_inputs_(num_inputs), outputs_(outputs) {
+  for (const auto& step_str : steps) {
+    std::istringstream stream(step_str);
+    std::string name;
+    stream >> name;
+    const auto* info = FindStepInfo(name);
+    CAFFE_ENFORCE(info, "Unknown FusedElementwise step: ", step_str);
+    Step step;
+    step.type = info->type;
+    step.operands.resize(info->num_operands);
+    for (auto& operand : step.operands) {
+      CAFFE_ENFORCE(stream >> operand, "Missing operand: ", step_str);
+      CAFFE_ENFORCE(
+          operand >= 0 && operand < num_values(),
+          "Steps can only use earlier values: ",
+          step_str);
+    }
+    step.scale = 1.0f;
+    if (step.type == StepType::Scale) {
+      CAFFE_ENFORCE(stream >> step.scale, "Missing scale: ", step_str);
+    }
+    steps_.push_back(step);
+  }
+  for (int output : outputs_) {
+    CAFFE_ENFORCE(
+        output >= num_inputs_ && output < num_values(),
+        "Outputs must be results of steps, got value ",
+        output);
+  }
+}
+
+bool FusedElementwiseProgram::IsFusible(const OperatorDef& def) {
+  const auto* info = FindStepInfo(def.type());
+  if (!info || def.input_size() != info->num_operands ||
+      def.output_size() != 1) {
+    return false;
+  }
+  // Legacy broadcasting aligns the operands on an axis instead of the last
+  // dims
+  ArgumentHelper helper(def);
+  return info->num_operands == 1 ||
+      !helper.GetSingleArgument<bool>("broadcast", false);
+}
+
+std::string FusedElementwiseProgram::GetStep(
+    const OperatorDef& def,
+    const std::vector<int>& operands) {
+  CAFFE_ENFORCE(IsFusible(def), "Can't fuse operator ", def.type());
+  std::ostringstream stream;
+  stream << def.type();
+  for (int operand : operands) {
+    stream << " " << operand;
+  }
+  if (def.type() == "Scale") {
+    stream << " "
+           << std::setprecision(std::numeric_limits<float>::max_digits10)
+           << ArgumentHelper(def).GetSingleArgument<float>("scale", 1.0f);
+  }
+  return stream.str();
+}
+
+std::vector<FusedElementwiseProgram::Group> FusedElementwiseProgram::GetGroups(
+    const std::vector<std::vector<int>>& input_dims) const {
+  CAFFE_ENFORCE_EQ(input_dims.size(), num_inputs_);
+  std::vector<std::vector<int>> value_dims(input_dims);
+  for (const auto& step : steps_) {
+    auto dims = value_dims[step.operands[0]];
+    if (step.operands.size() > 1) {
+      dims = elementwise_ops_utils::ComputeBinaryBroadcastForwardDims(
+          dims, value_dims[step.operands[1]]);
+    }
+    value_dims.push_back(dims);
+  }
+
+  std::vector<Group> groups;
+  std::map<std::vector<int>, int> group_ids;
+  for (int i = 0; i < outputs_.size(); ++i) {
+    const auto& dims = value_dims[outputs_[i]];
+    auto it = group_ids.find(dims);
+    if (it == group_ids.end()) {
+      it = group_ids.emplace(dims, groups.size()).first;
+      Group group;
+      group.dims = dims;
+      group.size = std::accumulate(
+          dims.begin(), dims.end(), 1, std::multiplies<int>());
+      group.needed.assign(num_values(), false);
+      groups.push_back(group);
+    }
+    auto& group = groups[it->second];
+    group.outputs.push_back(i);
+    group.needed[outputs_[i]] = true;
+  }
+  // Steps only use earlier values, so the values the steps of a group need
+  // are found in reverse order
+  for (auto& group : groups) {
+    for (int value = num_values() - 1; value >= num_inputs_; --value) {
+      if (group.needed[value]) {
+        for (int operand : steps_[value - num_inputs_].operands) {
+          group.needed[operand] = true;
+        }
+      }
+    }
+  }
+  return groups;
+}
+
+constexpr int FusedElementwiseOp::kBlockSize;
+
+void FusedElementwiseOp::RunGroup(
+    const FusedElementwiseProgram::Group& group,
+    int size,
+    const std::vector<const float*>& inputs,
+    const std::vector<bool>& scalars,
+    const std::vector<float*>& outputs) {
+  using StepType = FusedElementwiseProgram::StepType;
+  const int num_inputs = program_.num_inputs();
+  const int num_values = program_.num_values();
+  // A block of every value, scalar inputs are filled once
+  buffer_.resize(num_values * kBlockSize);
+  auto block = [this](int value) {
+    return buffer_.data() + value * kBlockSize;
+  };
+  for (int i = 0; i < num_inputs; ++i) {
+    if (group.needed[i] && scalars[i]) {
+      std::fill(block(i), block(i) + kBlockSize, inputs[i][0]);
+    }
+  }
+
+  std::vector<const float*> values(num_values, nullptr);
+  for (int begin = 0; begin < size; begin += kBlockSize) {
+    const int n = std::min(kBlockSize, size - begin);
+    for (int i = 0; i < num_inputs; ++i) {
+      if (group.needed[i]) {
+        values[i] = scalars[i] ? block(i) : inputs[i] + begin;
+      }
+    }
+    for (int value = num_inputs; value < num_values; ++value) {
+      if (!group.needed[value]) {
+        continue;
+      }
+      const auto& step = program_.steps()[value - num_inputs];
+      ConstEigenVectorArrayMap<float> A(values[step.operands[0]], n);
+      EigenVectorArrayMap<float> C(block(value), n);
+      switch (step.type) {
+        case StepType::Add:
+          C = A + ConstEigenVectorArrayMap<float>(values[step.operands[1]], n);
+          break;
+        case StepType::Sub:
+          C = A - ConstEigenVectorArrayMap<float>(values[step.operands[1]], n);
+          break;
+        case StepType::Mul:
+          C = A * ConstEigenVectorArrayMap<float>(values[step.operands[1]], n);
+          break;
+        case StepType::Div:
+          C = A / ConstEigenVectorArrayMap<float>(values[step.operands[1]], n);
+          break;
+        case StepType::Sigmoid:
+          C = 1.0f / (1.0f + (-A).exp());
+          break;
+        case StepType::Tanh:
+          C = 1.0f - 2.0f / ((2.0f * A).exp() + 1.0f);
+          break;
+        case StepType::Relu:
+          C = A.cwiseMax(0.0f);
+          break;
+        case StepType::Exp:
+          C = A.exp();
+          break;
+        case StepType::Log:
+          C = A.log();
+          break;
+        case StepType::Abs:
+          C = A.abs();
+          break;
+        case StepType::Sqr:
+          C = A.square();
+          break;
+        case StepType::Sqrt:
+          C = A.sqrt();
+          break;
+        case StepType::Negative:
+          C = -A;
+          break;
+        case StepType::Scale:
+          C = A * step.scale;
+          break;
+      }
+      values[value] = block(value);
+    }
+    // The outputs are written after the block of every input is read, which
+    // makes the op safe to run in place
+    for (int i = 0; i < group.outputs.size(); ++i) {
+      const int value = program_.outputs()[group.outputs[i]];
+      std::memcpy(outputs[i] + begin, values[value], n * sizeof(float));
+    }
+  }
+}
+
+REGISTER_CPU_OPERATOR(FusedElementwise, FusedElementwiseOp);
+
+OPERATOR_SCHEMA(FusedElementwise)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(1, INT_MAX)
+    .AllowInplace([](int /* in */, int /* out */) { return true; })
+    .SetDoc(R"DOC(
+Computes a chain of elementwise operators on float tensors in a single pass
+over its inputs, without writing their intermediate results. The operator is
+made by the FuseElementwise optimization pass from the Add, Sub, Mul, Div,
+Sigmoid, Tanh, Relu, Exp, Log, Abs, Sqr, Sqrt, Negative and Scale operators of
+a net.
+
+The values of the program are the inputs followed by the results of the steps,
+every step is the type of an operator followed by the values it takes and, for
+Scale, its scale, e.g. the steps "Mul 0 1", "Add 3 2" and "Sigmoid 4" with the
+outputs [5] compute Sigmoid(X * W + B) from the inputs X, W and B. Binary steps
+broadcast their operands like the elementwise operators do.
+)DOC")
+    .Arg("steps", "(list of string) steps of the program")
+    .Arg("outputs", "(list of int) values of the outputs")
+    .Input(0, "inputs", "Variable number of float tensors")
+    .Output(0, "outputs", "Variable number of float tensors");
+
+SHOULD_NOT_DO_GRADIENT(FusedElementwise);
+
+} // namespace caffe2
@@ -0,0 +1,217 @@
+#ifndef CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
+#define CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
+
+#include <string>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Program of a FusedElementwise op. Its values are the inputs of the op
+// followed by the results of its steps, and every step applies an elementwise
+// op to earlier values, e.g. "Mul 0 1" multiplies the first two values and
+// "Scale 3 0.5" scales the fourth one by 0.5. Binary steps broadcast their
+// operands like the elementwise ops do without the legacy broadcast argument.
+class FusedElementwiseProgram {
+ public:
+  enum class StepType {
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Sigmoid,
+    Tanh,
+    Relu,
+    Exp,
+    Log,
+    Abs,
+    Sqr,
+    Sqrt,
+    Negative,
+    Scale,
+  };
+
+  struct Step {
+    StepType type;
+    std::vector<int> operands;
+    // factor of Scale
+    float scale;
+  };
+
+  // Outputs of the op that have the same dims, which are computed together
+  struct Group {
+    std::vector<int> dims;
+    int size;
+    std::vector<int> outputs;
+    // whether the outputs depend on each value
+    std::vector<bool> needed;
+  };
+
+  FusedElementwiseProgram(
+      int num_inputs,
+      const std::vector<std::string>& steps,
+      const std::vector<int>& outputs);
+
+  // Whether a step can compute the output of the operator
+  static bool IsFusible(const OperatorDef& def);
+  // Step computing the output of a fusible operator from the given values
+  static std::string GetStep(
+      const OperatorDef& def,
+      const std::vector<int>& operands);
+
+  int num_inputs() const {
+    return num_inputs_;
+  }
+
+  int num_values() const {
+    return num_inputs_ + steps_.size();
+  }
+
+  const std::vector<Step>& steps() const {
+    return steps_;
+  }
+
+  // values of the outputs of the op
+  const std::vector<int>& outputs() const {
+    return outputs_;
+  }
+
+  std::vector<Group> GetGroups(
+      const std::vector<std::vector<int>>& input_dims) const;
+
+ private:
+  int num_inputs_;
+  std::vector<Step> steps_;
+  std::vector<int> outputs_;
+};
+
+// Runs the program of the op over the outputs of every group, the kernels
+// read every input either with the dims of the group or as a single value.
+template <class Context>
+class FusedElementwiseOpBase : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+
+  FusedElementwiseOpBase(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        program_(
+            InputSize(),
+            this->template GetRepeatedArgument<std::string>("steps"),
+            this->template GetRepeatedArgument<int>("outputs")) {
+    CAFFE_ENFORCE_EQ(
+        program_.outputs().size(),
+        OutputSize(),
+        "FusedElementwise needs the value of every output");
+  }
+
+  bool RunOnDevice() override {
+    std::vector<std::vector<int>> input_dims(InputSize());
+    for (int i = 0; i < InputSize(); ++i) {
+      CAFFE_ENFORCE(
+          Input(i).template IsType<float>(),
+          "FusedElementwise only supports float tensors");
+      const auto& dims = Input(i).dims();
+      input_dims[i].assign(dims.begin(), dims.end());
+    }
+    const auto groups = program_.GetGroups(input_dims);
+
+    // Inputs that outputs overwrite are read from copies, unless all of the
+    // outputs are computed together and every element of the input is read
+    // before its output element is written
+    std::vector<const Tensor<Context>*> inputs(InputSize());
+    copies_.resize(InputSize());
+    for (int i = 0; i < InputSize(); ++i) {
+      inputs[i] = &Input(i);
+      bool overwritten = false;
+      for (int j = 0; j < OutputSize(); ++j) {
+        overwritten |=
+            OperatorBase::Outputs()[j] == OperatorBase::Inputs()[i];
+      }
+      if (overwritten &&
+          (groups.size() > 1 || Input(i).size() != groups[0].size)) {
+        copies_[i].CopyFrom(Input(i), &context_);
+        inputs[i] = &copies_[i];
+      }
+    }
+
+    broadcasts_.resize(InputSize());
+    for (const auto& group : groups) {
+      const int size = group.size;
+      std::vector<const float*> input_data(InputSize(), nullptr);
+      std::vector<bool> scalars(InputSize(), false);
+      for (int i = 0; i < InputSize(); ++i) {
+        if (!group.needed[i]) {
+          continue;
+        }
+        const auto& X = *inputs[i];
+        if (X.size() == 1 || X.size() == size) {
+          input_data[i] = X.template data<float>();
+          scalars[i] = X.size() == 1 && size != 1;
+        } else {
+          broadcasts_[i].Resize(group.dims);
+          math::Broadcast<float, Context>(
+              input_dims[i].size(),
+              input_dims[i].data(),
+              group.dims.size(),
+              group.dims.data(),
+              X.template data<float>(),
+              broadcasts_[i].template mutable_data<float>(),
+              &context_);
+          input_data[i] = broadcasts_[i].template data<float>();
+        }
+      }
+      std::vector<float*> output_data;
+      for (int output : group.outputs) {
+        Output(output)->Resize(group.dims);
+        output_data.push_back(Output(output)->template mutable_data<float>());
+      }
+      if (size > 0) {
+        RunGroup(group, size, input_data, scalars, output_data);
+      }
+    }
+    return true;
+  }
+
+ protected:
+  // Computes the outputs of the group with size elements from the inputs it
+  // needs, where the scalar inputs have a single value.
+  virtual void RunGroup(
+      const FusedElementwiseProgram::Group& group,
+      int size,
+      const std::vector<const float*>& inputs,
+      const std::vector<bool>& scalars,
+      const std::vector<float*>& outputs) = 0;
+
+  const FusedElementwiseProgram program_;
+
+ private:
+  std::vector<Tensor<Context>> copies_;
+  std::vector<Tensor<Context>> broadcasts_;
+};
+
+class FusedElementwiseOp final : public FusedElementwiseOpBase<CPUContext> {
+ public:
+  FusedElementwiseOp(const OperatorDef& operator_def, Workspace* ws)
+      : FusedElementwiseOpBase<CPUContext>(operator_def, ws) {}
+
+ protected:
+  void RunGroup(
+      const FusedElementwiseProgram::Group& group,
+      int size,
+      const std::vector<const float*>& inputs,
+      const std::vector<bool>& scalars,
+      const std::vector<float*>& outputs) override;
+
+ private:
+  // The steps are run over blocks of elements that stay in cache
+  static constexpr int kBlockSize = 1024;
+
+  std::vector<float> buffer_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
@@ -0,0 +1,100 @@
+#include "caffe2/operators/fused_rnn_sequence_ops.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(
+    FusedLSTMSequence,
+    FusedLSTMSequenceOp<float, CPUContext>);
+OPERATOR_SCHEMA(FusedLSTMSequence)
+    .NumInputs(5, 6)
+    .NumOutputs(4)
+    .SetDoc(R"DOC(
+Runs a single layer LSTM over a whole sequence, forward only. This computes
+the same outputs as a RecurrentNetwork over the step net of LSTMCell (an FC
+of the previous hidden state summed with the input, followed by LSTMUnit),
+but runs every step as one GEMM with the recurrent weights and one pointwise
+LSTMUnit kernel, without the step net.
+
+The input is the projection of the input sequence for all the gates, as
+computed by the FC of LSTMCell.prepare_input. The initial states are either
+N x D or a single row of D values shared by all the sequences.
+)DOC")
+    .Arg("forget_bias", "Bias term to add in while calculating forget gate")
+    .Arg(
+        "sequence_lengths",
+        "When false, the sequence lengths input is left out and all the "
+        "sequences are run over all the T steps.")
+    .Arg("drop_states", "Drop invalid states, as LSTMUnit does")
+    .Arg(
+        "packed",
+        "If set, the input is a packed sequence of M rows (see "
+        "PackSequences) and seq_lengths are its batch sizes, as a CPU "
+        "tensor. The states of all the steps are then packed as well.")
+    .Input(0, "input", "Projected input sequence, T x N x 4D (M x 4D packed)")
+    .Input(1, "hidden_init", "Initial hidden state, N x D or D")
+    .Input(2, "cell_init", "Initial cell state, N x D or D")
+    .Input(3, "recurrent_weight", "Weights of the recurrent FC, 4D x D")
+    .Input(4, "recurrent_bias", "Bias of the recurrent FC, 4D")
+    .Input(5, "seq_lengths", "Lengths of the sequences of the batch, N")
+    .Output(
+        0,
+        "hidden_all",
+        "Hidden states of all the steps, T x N x D (M x D packed)")
+    .Output(
+        1,
+        "hidden_last",
+        "Hidden state of the last step of every sequence, 1 x N x D")
+    .Output(
+        2,
+        "cell_all",
+        "Cell states of all the steps, T x N x D (M x D packed)")
+    .Output(
+        3,
+        "cell_last",
+        "Cell state of the last step of every sequence, 1 x N x D");
+SHOULD_NOT_DO_GRADIENT(FusedLSTMSequence);
+
+REGISTER_CPU_OPERATOR(
+    FusedGRUSequence,
+    FusedGRUSequenceOp<float, CPUContext>);
+OPERATOR_SCHEMA(FusedGRUSequence)
+    .NumInputs(4, 5)
+    .NumOutputs(2)
+    .SetDoc(R"DOC(
+Runs a single layer GRU over a whole sequence, forward only. This computes
+the same outputs as a RecurrentNetwork over the step net of GRUCell with
+linear_before_reset, but runs every step as one GEMM with the recurrent
+weights of the three gates and one pointwise kernel, without the step net.
+
+The input is the projection of the input sequence for all the gates, as
+computed by the FC of GRUCell.prepare_input. The recurrent weights and biases
+are those of the reset, update and output gate FCs of GRUCell, concatenated in
+this order. The initial state is either N x D or a single row of D values
+shared by all the sequences.
+)DOC")
+    .Arg(
+        "sequence_lengths",
+        "When false, the sequence lengths input is left out and all the "
+        "sequences are run over all the T steps.")
+    .Arg("drop_states", "Drop invalid states, as GRUUnit does")
+    .Arg(
+        "packed",
+        "If set, the input is a packed sequence of M rows (see "
+        "PackSequences) and seq_lengths are its batch sizes, as a CPU "
+        "tensor. The states of all the steps are then packed as well.")
+    .Input(0, "input", "Projected input sequence, T x N x 3D (M x 3D packed)")
+    .Input(1, "hidden_init", "Initial hidden state, N x D or D")
+    .Input(2, "recurrent_weight", "Weights of the recurrent FCs, 3D x D")
+    .Input(3, "recurrent_bias", "Biases of the recurrent FCs, 3D")
+    .Input(4, "seq_lengths", "Lengths of the sequences of the batch, N")
+    .Output(
+        0,
+        "hidden_all",
+        "Hidden states of all the steps, T x N x D (M x D packed)")
+    .Output(
+        1,
+        "hidden_last",
+        "Hidden state of the last step of every sequence, 1 x N x D");
+SHOULD_NOT_DO_GRADIENT(FusedGRUSequence);
+
+} // namespace caffe2
@@ -0,0 +1,422 @@
+#ifndef CAFFE2_OPERATORS_FUSED_RNN_SEQUENCE_OPS_H_
+#define CAFFE2_OPERATORS_FUSED_RNN_SEQUENCE_OPS_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/lstm_unit_op.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+namespace detail {
+
+// One step of a GRU with linear_before_reset, given the input projection X
+// (Nx3D) and the recurrent projection HG (Nx3D) of H_prev, without its bias.
+// The gates are ordered as (reset, update, output), as in GRUUnit.
+template <typename T, typename Context>
+void FusedGRUStep(
+    int N,
+    int D,
+    int t,
+    const T* H_prev,
+    const T* X,
+    const T* HG,
+    const T* bias,
+    const int32_t* seqLengths,
+    bool drop_states,
+    T* H,
+    Context* /*context*/) {
+  for (int n = 0; n < N; ++n) {
+    const bool valid = seqLengths == nullptr || t < seqLengths[n];
+
+    for (int d = 0; d < D; ++d) {
+      if (!valid) {
+        if (drop_states) {
+          H[d] = 0;
+        } else {
+          H[d] = H_prev[d];
+        }
+      } else {
+        const T reset = sigmoid(X[d] + HG[d] + bias[d]);
+        const T update = X[1 * D + d] + HG[1 * D + d] + bias[1 * D + d];
+        const T output =
+            X[2 * D + d] + reset * (HG[2 * D + d] + bias[2 * D + d]);
+        const T sigmoid_update = sigmoid(update);
+        H[d] = H_prev[d] * sigmoid_update +
+            host_tanh(output) * (1.0f - sigmoid_update);
+      }
+    }
+
+    H_prev += D;
+    X += 3 * D;
+    HG += 3 * D;
+    H += D;
+  }
+}
+
+} // namespace detail
+
+// Base class of the operators that run a recurrent network with a single
+// layer of LSTM or GRU over a whole sequence, the forward only equivalent of
+// a RecurrentNetwork over an LSTMUnit or GRUUnit step net. The input
+// projection of all the timesteps is computed beforehand (by the FC of
+// prepare_input), so that every step is one GEMM with the recurrent weights
+// and one pointwise kernel, without the step net and its per-step operators.
+//
+// With packed, the input is a packed sequence (see PackSequences) and every
+// step only computes the rows of the sequences that are still running, so
+// no work is spent on padding.
+template <class Context>
+class FusedRNNSequenceOpBase : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  FusedRNNSequenceOpBase(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        sequence_lengths_(OperatorBase::template GetSingleArgument<bool>(
+            "sequence_lengths",
+            true)),
+        drop_states_(OperatorBase::template GetSingleArgument<bool>(
+            "drop_states",
+            false)),
+        packed_(
+            OperatorBase::template GetSingleArgument<bool>("packed", false)) {
+    CAFFE_ENFORCE(
+        !packed_ || sequence_lengths_,
+        "A packed input needs its batch sizes");
+  }
+
+ protected:
+  // The rows of the input that every step computes, which are the N
+  // sequences of the batch for a padded input and the sequences longer than
+  // the step for a packed one. The rows of step t follow those of step t - 1.
+  struct Steps {
+    int N;
+    int rows;
+    std::vector<int> sizes;
+    // the sequence lengths of a padded input, if any
+    const int32_t* seqLengths;
+  };
+
+  Steps GetSteps(
+      const Tensor<Context>& X,
+      const Tensor<Context>& initialState,
+      int D,
+      int seq_lengths_input) {
+    Steps steps;
+    if (!packed_) {
+      CAFFE_ENFORCE_EQ(X.ndim(), 3, "INPUT must be T x N x G");
+      steps.N = X.dim32(1);
+      steps.rows = X.dim32(0) * steps.N;
+      steps.sizes.assign(X.dim32(0), steps.N);
+      steps.seqLengths = SequenceLengths(seq_lengths_input, steps.N);
+      return steps;
+    }
+    CAFFE_ENFORCE_EQ(X.ndim(), 2, "A packed INPUT must be M x G");
+    const auto& batchSizes = OperatorBase::Input<TensorCPU>(seq_lengths_input);
+    const int32_t* sizes = batchSizes.template data<int32_t>();
+    steps.rows = 0;
+    for (int t = 0; t < batchSizes.size(); ++t) {
+      CAFFE_ENFORCE(
+          sizes[t] > 0 && (t == 0 || sizes[t] <= sizes[t - 1]),
+          "The batch sizes must be positive and non-increasing");
+      steps.sizes.push_back(sizes[t]);
+      steps.rows += sizes[t];
+    }
+    CAFFE_ENFORCE_EQ(
+        steps.rows, X.dim32(0), "The batch sizes must add up to the input");
+    // Sequences of length 0 only show up in the initial states.
+    steps.N = initialState.ndim() > 1
+        ? initialState.size() / D
+        : (steps.sizes.empty() ? 0 : steps.sizes[0]);
+    CAFFE_ENFORCE(steps.sizes.empty() || steps.sizes[0] <= steps.N);
+    steps.seqLengths = nullptr;
+    return steps;
+  }
+
+  // Copies the state of the last step of every sequence, given the states
+  // of all the steps and the initial ones.
+  template <typename T>
+  void CopyLastStates(
+      const Steps& steps,
+      int D,
+      const T* init,
+      const T* all,
+      T* last) {
+    if (steps.sizes.empty() || steps.sizes.back() == steps.N) {
+      // All the sequences end at the last step.
+      const T* from =
+          steps.sizes.empty() ? init : all + (steps.rows - steps.N) * D;
+      context_.template Copy<T, Context, Context>(steps.N * D, from, last);
+      return;
+    }
+    std::vector<int> offsets(steps.sizes.size());
+    for (int t = 1; t < steps.sizes.size(); ++t) {
+      offsets[t] = offsets[t - 1] + steps.sizes[t - 1];
+    }
+    int length = steps.sizes.size();
+    for (int n = 0; n < steps.N; ++n) {
+      while (length > 0 && steps.sizes[length - 1] <= n) {
+        --length;
+      }
+      const T* from =
+          length == 0 ? init + n * D : all + (offsets[length - 1] + n) * D;
+      context_.template Copy<T, Context, Context>(D, from, last + n * D);
+    }
+  }
+
+  // Returns the initial state of a batch of N, which is either a tensor of N
+  // rows of D values or a single row of D values that all the sequences start
+  // from, as RecurrentNetwork accepts.
+  template <typename T>
+  const T* InitialState(
+      const Tensor<Context>& state,
+      int N,
+      int D,
+      Tensor<Context>* repeated) {
+    if (state.size() == N * D) {
+      return state.template data<T>();
+    }
+    CAFFE_ENFORCE_EQ(
+        state.size(),
+        D,
+        "The initial state must have N x ",
+        D,
+        " or ",
+        D,
+        " values");
+    repeated->Resize(N, D);
+    T* data = repeated->template mutable_data<T>();
+    for (int n = 0; n < N; ++n) {
+      context_.template Copy<T, Context, Context>(
+          D, state.template data<T>(), data + n * D);
+    }
+    return data;
+  }
+
+  const int32_t* SequenceLengths(int seq_lengths_input, int N) {
+    if (!sequence_lengths_) {
+      return nullptr;
+    }
+    CAFFE_ENFORCE_EQ(Input(seq_lengths_input).size(), N);
+    return Input(seq_lengths_input).template data<int32_t>();
+  }
+
+  bool sequence_lengths_;
+  bool drop_states_;
+  bool packed_;
+};
+
+template <typename T, class Context>
+class FusedLSTMSequenceOp final : public FusedRNNSequenceOpBase<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  FusedLSTMSequenceOp(const OperatorDef& operator_def, Workspace* ws)
+      : FusedRNNSequenceOpBase<Context>(operator_def, ws),
+        forget_bias_(OperatorBase::template GetSingleArgument<float>(
+            "forget_bias",
+            0.0)) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(INPUT);
+    const auto& W = Input(WEIGHT);
+    const auto& b = Input(BIAS);
+    CAFFE_ENFORCE_GE(X.ndim(), 2);
+    const int G = X.dim32(X.ndim() - 1);
+    CAFFE_ENFORCE_EQ(G % 4, 0, "INPUT must be T x N x 4D, or M x 4D packed");
+    const int D = G / 4;
+    CAFFE_ENFORCE_EQ(W.ndim(), 2);
+    CAFFE_ENFORCE_EQ(W.dim32(0), G);
+    CAFFE_ENFORCE_EQ(W.dim32(1), D);
+    CAFFE_ENFORCE_EQ(b.size(), G);
+
+    const auto steps = this->GetSteps(X, Input(HIDDEN_INIT), D, SEQ_LENGTHS);
+    const int N = steps.N;
+    const T* H_init = this->template InitialState<T>(
+        Input(HIDDEN_INIT), N, D, &hidden_init_);
+    const T* C_init =
+        this->template InitialState<T>(Input(CELL_INIT), N, D, &cell_init_);
+    const T* H_prev = H_init;
+    const T* C_prev = C_init;
+
+    auto* hidden_all = Output(HIDDEN_ALL);
+    auto* cell_all = Output(CELL_ALL);
+    auto dims = X.dims();
+    dims.back() = D;
+    hidden_all->Resize(dims);
+    cell_all->Resize(dims);
+    T* H = hidden_all->template mutable_data<T>();
+    T* C = cell_all->template mutable_data<T>();
+
+    // The input projection plus the bias of the recurrent FC, for all the
+    // steps at once.
+    gates_.ResizeLike(X);
+    T* gates = gates_.template mutable_data<T>();
+    context_.template Copy<T, Context, Context>(
+        X.size(), X.template data<T>(), gates);
+    if (bias_multiplier_.size() != steps.rows) {
+      bias_multiplier_.Resize(steps.rows);
+      math::Set<T, Context>(
+          steps.rows,
+          1,
+          bias_multiplier_.template mutable_data<T>(),
+          &context_);
+    }
+    math::Gemm<T, Context>(
+        CblasNoTrans,
+        CblasNoTrans,
+        steps.rows,
+        G,
+        1,
+        1,
+        bias_multiplier_.template data<T>(),
+        b.template data<T>(),
+        1,
+        gates,
+        &context_);
+
+    int offset = 0;
+    for (int t = 0; t < steps.sizes.size(); ++t) {
+      const int B = steps.sizes[t];
+      T* gates_t = gates + offset * G;
+      math::Gemm<T, Context>(
+          CblasNoTrans,
+          CblasTrans,
+          B,
+          G,
+          D,
+          1,
+          H_prev,
+          W.template data<T>(),
+          1,
+          gates_t,
+          &context_);
+      T* H_t = H + offset * D;
+      T* C_t = C + offset * D;
+      detail::LSTMUnit<T, Context>(
+          B,
+          D,
+          t,
+          H_prev,
+          C_prev,
+          gates_t,
+          steps.seqLengths,
+          this->drop_states_,
+          C_t,
+          H_t,
+          forget_bias_,
+          &context_);
+      H_prev = H_t;
+      C_prev = C_t;
+      offset += B;
+    }
+
+    auto* hidden_last = Output(HIDDEN_LAST);
+    auto* cell_last = Output(CELL_LAST);
+    hidden_last->Resize(1, N, D);
+    cell_last->Resize(1, N, D);
+    this->template CopyLastStates<T>(
+        steps, D, H_init, H, hidden_last->template mutable_data<T>());
+    this->template CopyLastStates<T>(
+        steps, D, C_init, C, cell_last->template mutable_data<T>());
+    return true;
+  }
+
+ protected:
+  INPUT_TAGS(INPUT, HIDDEN_INIT, CELL_INIT, WEIGHT, BIAS, SEQ_LENGTHS);
+  OUTPUT_TAGS(HIDDEN_ALL, HIDDEN_LAST, CELL_ALL, CELL_LAST);
+
+ private:
+  float forget_bias_;
+  Tensor<Context> hidden_init_;
+  Tensor<Context> cell_init_;
+  Tensor<Context> gates_;
+  Tensor<Context> bias_multiplier_;
+};
+
+template <typename T, class Context>
+class FusedGRUSequenceOp final : public FusedRNNSequenceOpBase<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  FusedGRUSequenceOp(const OperatorDef& operator_def, Workspace* ws)
+      : FusedRNNSequenceOpBase<Context>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(INPUT);
+    const auto& W = Input(WEIGHT);
+    const auto& b = Input(BIAS);
+    CAFFE_ENFORCE_GE(X.ndim(), 2);
+    const int G = X.dim32(X.ndim() - 1);
+    CAFFE_ENFORCE_EQ(G % 3, 0, "INPUT must be T x N x 3D, or M x 3D packed");
+    const int D = G / 3;
+    CAFFE_ENFORCE_EQ(W.ndim(), 2);
+    CAFFE_ENFORCE_EQ(W.dim32(0), G);
+    CAFFE_ENFORCE_EQ(W.dim32(1), D);
+    CAFFE_ENFORCE_EQ(b.size(), G);
+
+    const auto steps = this->GetSteps(X, Input(HIDDEN_INIT), D, SEQ_LENGTHS);
+    const int N = steps.N;
+    const T* H_init = this->template InitialState<T>(
+        Input(HIDDEN_INIT), N, D, &hidden_init_);
+    const T* H_prev = H_init;
+
+    auto* hidden_all = Output(HIDDEN_ALL);
+    auto dims = X.dims();
+    dims.back() = D;
+    hidden_all->Resize(dims);
+    T* H = hidden_all->template mutable_data<T>();
+    const T* x = X.template data<T>();
+
+    // The reset gate applies to the recurrent projection of the output gate
+    // (linear_before_reset), so the three gates share one GEMM per step.
+    hidden_gates_.Resize(N, G);
+    T* hidden_gates = hidden_gates_.template mutable_data<T>();
+    int offset = 0;
+    for (int t = 0; t < steps.sizes.size(); ++t) {
+      const int B = steps.sizes[t];
+      math::Gemm<T, Context>(
+          CblasNoTrans,
+          CblasTrans,
+          B,
+          G,
+          D,
+          1,
+          H_prev,
+          W.template data<T>(),
+          0,
+          hidden_gates,
+          &context_);
+      T* H_t = H + offset * D;
+      detail::FusedGRUStep<T, Context>(
+          B,
+          D,
+          t,
+          H_prev,
+          x + offset * G,
+          hidden_gates,
+          b.template data<T>(),
+          steps.seqLengths,
+          this->drop_states_,
+          H_t,
+          &context_);
+      H_prev = H_t;
+      offset += B;
+    }
+
+    auto* hidden_last = Output(HIDDEN_LAST);
+    hidden_last->Resize(1, N, D);
+    this->template CopyLastStates<T>(
+        steps, D, H_init, H, hidden_last->template mutable_data<T>());
+    return true;
+  }
+
+ protected:
+  INPUT_TAGS(INPUT, HIDDEN_INIT, WEIGHT, BIAS, SEQ_LENGTHS);
+  OUTPUT_TAGS(HIDDEN_ALL, HIDDEN_LAST);
+
+ private:
+  Tensor<Context> hidden_init_;
+  Tensor<Context> hidden_gates_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_FUSED_RNN_SEQUENCE_OPS_H_
@@ -0,0 +1,97 @@
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/operators/fused_rnn_sequence_ops.h"
+
+namespace caffe2 {
+
+namespace detail {
+
+// Defined with the LSTMUnit operator, in lstm_unit_op_gpu.cu.
+template <>
+void LSTMUnit<float, CUDAContext>(
+    int N,
+    int D,
+    int t,
+    const float* H_prev,
+    const float* C_prev,
+    const float* X,
+    const int32_t* seqLengths,
+    bool drop_states,
+    float* C,
+    float* H,
+    const float forget_bias,
+    CUDAContext* context);
+
+namespace {
+
+template <typename T>
+__device__ T fused_gru_sigmoid(const T x) {
+  return T(1) / (T(1) + exp(-x));
+}
+
+template <typename T>
+__global__ void FusedGRUStepKernel(
+    const int ND,
+    const int dim,
+    const int t,
+    const T* H_prev,
+    const T* X,
+    const T* HG,
+    const T* bias,
+    const int32_t* seqLengths,
+    bool drop_states,
+    T* H) {
+  CUDA_1D_KERNEL_LOOP(index, ND) {
+    const int n = index / dim;
+    const int d = index % dim;
+    const bool valid = seqLengths == nullptr || t < seqLengths[n];
+    if (!valid) {
+      H[index] = H_prev[index] * !drop_states;
+    } else {
+      const T* X_offset = X + 3 * dim * n;
+      const T* HG_offset = HG + 3 * dim * n;
+      const T reset =
+          fused_gru_sigmoid(X_offset[d] + HG_offset[d] + bias[d]);
+      const T update =
+          X_offset[1 * dim + d] + HG_offset[1 * dim + d] + bias[1 * dim + d];
+      const T output = X_offset[2 * dim + d] +
+          reset * (HG_offset[2 * dim + d] + bias[2 * dim + d]);
+      const T sigmoid_update = fused_gru_sigmoid(update);
+      H[index] = H_prev[index] * sigmoid_update +
+          tanh(output) * (1.0f - sigmoid_update);
+    }
+  }
+}
+
+} // namespace
+
+template <>
+void FusedGRUStep<float, CUDAContext>(
+    int N,
+    int D,
+    int t,
+    const float* H_prev,
+    const float* X,
+    const float* HG,
+    const float* bias,
+    const int32_t* seqLengths,
+    bool drop_states,
+    float* H,
+    CUDAContext* context) {
+  FusedGRUStepKernel<float><<<
+      CAFFE_GET_BLOCKS(N * D),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context->cuda_stream()>>>(
+      N * D, D, t, H_prev, X, HG, bias, seqLengths, drop_states, H);
+}
+
+} // namespace detail
+
+REGISTER_CUDA_OPERATOR(
+    FusedLSTMSequence,
+    FusedLSTMSequenceOp<float, CUDAContext>);
+REGISTER_CUDA_OPERATOR(
+    FusedGRUSequence,
+    FusedGRUSequenceOp<float, CUDAContext>);
+
+} // namespace caffe2
@@ -0,0 +1,73 @@
+#include "caffe2/operators/fused_rowwise_nbit_conversion_ops.h"
+#include "caffe2/core/registry.h"
+
+namespace caffe2 {
+
+#define REGISTER_FUSED_NBIT_ROWWISE_CONVERSION_OPS(BIT_RATE)                  \
+  REGISTER_CPU_OPERATOR(                                                      \
+      FloatToFused##BIT_RATE##BitRowwiseQuantized,                            \
+      FloatToFusedNBitRowwiseQuantizedOp<BIT_RATE, CPUContext>);              \
+  OPERATOR_SCHEMA(FloatToFused##BIT_RATE##BitRowwiseQuantized)                \
+      .NumInputs(1)                                                           \
+      .NumOutputs(1)                                                          \
+      .TensorInferenceFunction([](const OperatorDef& /* def */,               \
+                                  const vector<TensorShape>& in) {            \
+        vector<TensorShape> out;                                              \
+        TensorShape X = in[0];                                                \
+        X.set_dims(                                                           \
+            1, (X.dims(1) + 8 / BIT_RATE - 1) / (8 / BIT_RATE) + 4);          \
+        out.push_back(std::move(X));                                          \
+        out[0].set_data_type(TensorProto_DataType_UINT8);                     \
+        return out;                                                           \
+      })                                                                      \
+      .SetDoc(                                                                \
+          "Applies " #BIT_RATE "-bit row-wise quantization by determining "   \
+          "the range (maximum - minimum) and offset (minimum value) of each " \
+          "row in the input matrix, and then scaling each element to an "     \
+          "integer between 0 and 2^" #BIT_RATE " - 1. 8 / " #BIT_RATE         \
+          " integers are packed into each byte, the first one in the lowest " \
+          "bits. The scale and the offset (bias) of each row are stored "     \
+          "after its packed data as 16-bit floats, in the last 4 bytes of "   \
+          "the row. Rows are padded with zeros to a multiple of 8 / "         \
+          #BIT_RATE " elements.")                                             \
+      .Input(0, "input", "Float32 input data")                                \
+      .Output(0, "output", "Fused scale, bias and quantized data");           \
+  NO_GRADIENT(FloatToFused##BIT_RATE##BitRowwiseQuantized);                   \
+                                                                              \
+  REGISTER_CPU_OPERATOR(                                                      \
+      Fused##BIT_RATE##BitRowwiseQuantizedToFloat,                            \
+      FusedNBitRowwiseQuantizedToFloatOp<BIT_RATE, CPUContext>);              \
+  OPERATOR_SCHEMA(Fused##BIT_RATE##BitRowwiseQuantizedToFloat)                \
+      .NumInputs(1)                                                           \
+      .NumOutputs(1)                                                          \
+      .TensorInferenceFunction([](const OperatorDef& /* def */,               \
+                                  const vector<TensorShape>& in) {            \
+        vector<TensorShape> out;                                              \
+        TensorShape X = in[0];                                                \
+        X.set_dims(1, (X.dims(1) - 4) * (8 / BIT_RATE));                      \
+        out.push_back(std::move(X));                                          \
+        out[0].set_data_type(TensorProto_DataType_FLOAT);                     \
+        return out;                                                           \
+      })                                                                      \
+      .SetDoc(                                                                \
+          "De-quantizes the result of the FloatToFused" #BIT_RATE             \
+          "BitRowwiseQuantized operator. The input is expected to encode "    \
+          "the scale and the bias of each row as 16-bit floats in its last "  \
+          "4 bytes, and the packed quantized values in the preceding bytes. " \
+          "The output has 8 / " #BIT_RATE " values per packed byte, so it "   \
+          "includes the padding of rows whose length wasn't a multiple of "   \
+          "that. The de-quantized values will not be exactly equal to the "   \
+          "original, un-quantized floating point values.")                    \
+      .Input(                                                                 \
+          0,                                                                  \
+          "scale_bias_quantized_input",                                       \
+          "Fused scale, bias and quantized data")                             \
+      .Output(0, "float_input", "Float32 data");                              \
+  NO_GRADIENT(Fused##BIT_RATE##BitRowwiseQuantizedToFloat)
+
+REGISTER_FUSED_NBIT_ROWWISE_CONVERSION_OPS(4);
+REGISTER_FUSED_NBIT_ROWWISE_CONVERSION_OPS(2);
+
+#undef REGISTER_FUSED_NBIT_ROWWISE_CONVERSION_OPS
+
+} // namespace caffe2
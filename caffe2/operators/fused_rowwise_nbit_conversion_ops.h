@@ -0,0 +1,162 @@
+#ifndef CAFFE2_OPERATORS_FUSED_ROWWISE_NBIT_CONVERSION_OPS_H_
+#define CAFFE2_OPERATORS_FUSED_ROWWISE_NBIT_CONVERSION_OPS_H_
+
+#include <algorithm>
+#include <cmath>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/types.h"
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/eigen_utils.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+#define IS_LITTLE_ENDIAN                                      \
+  [] {                                                        \
+    const int32_t kValue = 1;                                 \
+    return reinterpret_cast<const uint8_t*>(&kValue)[0] == 1; \
+  }()
+
+template <int BIT_RATE, class Context>
+class FloatToFusedNBitRowwiseQuantizedOp : public Operator<Context> {
+ public:
+  static_assert(BIT_RATE == 2 || BIT_RATE == 4, "Unsupported bit rate");
+  static constexpr int kNumElemPerByte = 8 / BIT_RATE;
+
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(FloatToFusedNBitRowwiseQuantizedOp)
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE(IS_LITTLE_ENDIAN, "Unsupported endianness");
+
+    const auto& input = Input(DATA_FLOAT);
+    auto* output = Output(DATA_FUSED_SCALE_BIAS);
+
+    CAFFE_ENFORCE_EQ(input.ndim(), 2, "Expect input to be a matrix");
+    const auto input_rows = input.dim(0);
+    const auto input_columns = input.dim(1);
+
+    // The "fused" representation packs kNumElemPerByte values into each byte,
+    // lowest bits first, and stores the scale and bias of the row as 16-bit
+    // floats in its last 4 bytes. Rows with a number of columns that isn't a
+    // multiple of kNumElemPerByte are padded with zeros.
+    // | ... packed data ... | scale | bias |
+    // | ceil(columns / n)   |  2B   |  2B  |
+    const TIndex data_columns =
+        (input_columns + kNumElemPerByte - 1) / kNumElemPerByte;
+    const std::vector<TIndex> output_dimensions = {input_rows,
+                                                   data_columns + 4};
+    output->Resize(output_dimensions);
+
+    const auto* input_data = input.template data<float>();
+    auto* output_data = output->template mutable_data<uint8_t>();
+    const auto output_columns = output->dim(1);
+    const float max_quantized = (1 << BIT_RATE) - 1;
+
+    for (TIndex row = 0; row < input_rows; ++row) {
+      ConstEigenVectorArrayMap<float> input_row(
+          input_data + row * input_columns, input_columns);
+      uint8_t* output_row = output_data + row * output_columns;
+      float16* output_row_scale_bias =
+          reinterpret_cast<float16*>(output_row + data_columns);
+
+      // Quantize with the scale and bias as they are stored, so that
+      // dequantization doesn't add the fp16 rounding error on top.
+      const float16 bias = convert::cpu_float2half_rn(input_row.minCoeff());
+      const float minimum_element = convert::cpu_half2float(bias);
+      const float maximum_element = input_row.maxCoeff();
+      float16 scale = convert::cpu_float2half_rn(
+          (maximum_element - minimum_element) / max_quantized);
+      if (convert::cpu_half2float(scale) == 0.0f) {
+        // all elements of the row are the same
+        scale = convert::cpu_float2half_rn(1.0f);
+      }
+      const float inverse_scale = 1.0f / convert::cpu_half2float(scale);
+
+      output_row_scale_bias[0] = scale;
+      output_row_scale_bias[1] = bias;
+      std::fill(output_row, output_row + data_columns, 0);
+      for (TIndex col = 0; col < input_columns; ++col) {
+        const float quantized = std::max(
+            0.0f,
+            std::min(
+                std::round((input_row(col) - minimum_element) * inverse_scale),
+                max_quantized));
+        output_row[col / kNumElemPerByte] |= static_cast<uint8_t>(quantized)
+            << ((col % kNumElemPerByte) * BIT_RATE);
+      }
+    }
+
+    return true;
+  }
+
+ private:
+  INPUT_TAGS(DATA_FLOAT);
+  OUTPUT_TAGS(DATA_FUSED_SCALE_BIAS);
+};
+
+template <int BIT_RATE, class Context>
+class FusedNBitRowwiseQuantizedToFloatOp : public Operator<Context> {
+ public:
+  static_assert(BIT_RATE == 2 || BIT_RATE == 4, "Unsupported bit rate");
+  static constexpr int kNumElemPerByte = 8 / BIT_RATE;
+
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  USE_SIMPLE_CTOR_DTOR(FusedNBitRowwiseQuantizedToFloatOp)
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE(IS_LITTLE_ENDIAN, "Unsupported endianness");
+
+    const auto& input = Input(DATA_FUSED_SCALE_BIAS);
+    auto* output = Output(DATA_FLOAT);
+
+    CAFFE_ENFORCE_EQ(input.ndim(), 2, "Expect input to be a matrix");
+    CAFFE_ENFORCE_GT(
+        input.dim(1), 4, "Expect input to have more than 4 columns");
+    const auto input_rows = input.dim(0);
+    const auto input_columns = input.dim(1);
+
+    // The last 4 bytes per row are the scale and the bias. The padding of
+    // the original rows can't be told apart from data, so the output has
+    // kNumElemPerByte values for every remaining byte.
+    const TIndex data_columns = input_columns - 4;
+    const std::vector<TIndex> output_dimensions = {
+        input_rows, data_columns * kNumElemPerByte};
+    output->Resize(output_dimensions);
+    const auto output_columns = output->dim(1);
+
+    const auto* input_data = input.template data<uint8_t>();
+    auto* output_data = output->template mutable_data<float>();
+    const int mask = (1 << BIT_RATE) - 1;
+
+    for (TIndex row = 0; row < input_rows; ++row) {
+      const uint8_t* input_row = input_data + row * input_columns;
+      const float16* input_row_scale_bias =
+          reinterpret_cast<const float16*>(input_row + data_columns);
+      const float scale = convert::cpu_half2float(input_row_scale_bias[0]);
+      const float bias = convert::cpu_half2float(input_row_scale_bias[1]);
+
+      float* output_row = output_data + row * output_columns;
+      for (TIndex col = 0; col < output_columns; ++col) {
+        const int quantized = (input_row[col / kNumElemPerByte] >>
+                               ((col % kNumElemPerByte) * BIT_RATE)) &
+            mask;
+        output_row[col] = scale * quantized + bias;
+      }
+    }
+    return true;
+  }
+
+ private:
+  INPUT_TAGS(DATA_FUSED_SCALE_BIAS);
+  OUTPUT_TAGS(DATA_FLOAT);
+};
+
+#undef IS_LITTLE_ENDIAN
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_FUSED_ROWWISE_NBIT_CONVERSION_OPS_H_
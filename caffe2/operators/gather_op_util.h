@@ -0,0 +1,82 @@
+#ifndef CAFFE2_OPERATORS_GATHER_OP_UTIL_H_
+#define CAFFE2_OPERATORS_GATHER_OP_UTIL_H_
+
+#include <algorithm>
+#include <cstring>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/types.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
+
+namespace caffe2 {
+namespace gather_op_util {
+
+// Chunks of the output with fewer bytes than this aren't worth handing to
+// another thread.
+constexpr TIndex kMinBytesPerChunk = 16384;
+
+// Gathers the blocks of block_size items of data, which holds num_batches
+// batches of batch_rows blocks each: block i of batch b of the output is
+// block indices[i] of batch b of data. The indices must have been checked to
+// be in [0, batch_rows).
+//
+// With a thread pool, the output is split into chunks of contiguous blocks
+// that are copied in parallel. Types without a copy constructor are copied
+// with memcpy, of a constant size for blocks of 4 or 8 bytes so that it
+// compiles to a single move.
+template <typename Index>
+void GatherBlocks(
+    const TypeMeta& meta,
+    const void* data,
+    TIndex num_batches,
+    TIndex batch_rows,
+    const Index* indices,
+    TIndex num_indices,
+    TIndex block_size,
+    void* output,
+    CPUContext* context,
+    ThreadPool* pool) {
+  const TIndex block_bytesize = block_size * meta.itemsize();
+  const TIndex num_blocks = num_batches * num_indices;
+  const char* src_base = static_cast<const char*>(data);
+  char* out_base = static_cast<char*>(output);
+
+  auto copy_blocks = [&](TIndex begin, TIndex end) {
+    const bool pod = meta.copy() == nullptr;
+    for (TIndex r = begin; r < end; ++r) {
+      const TIndex batch = r / num_indices;
+      const TIndex row = batch * batch_rows + indices[r % num_indices];
+      const char* src = src_base + row * block_bytesize;
+      char* dst = out_base + r * block_bytesize;
+      if (!pod) {
+        context->CopyItems<CPUContext, CPUContext>(meta, block_size, src, dst);
+      } else if (block_bytesize == 4) {
+        std::memcpy(dst, src, 4);
+      } else if (block_bytesize == 8) {
+        std::memcpy(dst, src, 8);
+      } else {
+        std::memcpy(dst, src, block_bytesize);
+      }
+    }
+  };
+
+  const TIndex num_chunks = pool
+      ? std::min(num_blocks, num_blocks * block_bytesize / kMinBytesPerChunk)
+      : 1;
+  if (num_chunks <= 1) {
+    copy_blocks(0, num_blocks);
+    return;
+  }
+  pool->run(
+      [&](int /* unused */, size_t chunk) {
+        const TIndex c = chunk;
+        copy_blocks(
+            c * num_blocks / num_chunks, (c + 1) * num_blocks / num_chunks);
+      },
+      num_chunks);
+}
+
+} // namespace gather_op_util
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_GATHER_OP_UTIL_H_
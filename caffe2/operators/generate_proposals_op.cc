@@ -268,7 +268,7 @@ bool GenerateProposalsOp<CPUContext>::RunOnDevice() {
 
   std::vector<ERArrXXf> im_boxes(num_images);
   std::vector<EArrXf> im_probs(num_images);
-  for (int i = 0; i < num_images; i++) {
+  auto proposals_for_image = [&](int i) {
     auto cur_im_info = im_info.row(i);
     auto cur_bbox_deltas = GetSubTensorView<float>(bbox_deltas, i);
     auto cur_scores = GetSubTensorView<float>(scores, i);
@@ -282,6 +282,16 @@ bool GenerateProposalsOp<CPUContext>::RunOnDevice() {
         cur_scores,
         &im_i_boxes,
         &im_i_probs);
+  };
+  if (intra_op_parallel_ && num_images > 1) {
+    // Every task writes the results of its own image only
+    ws_->GetThreadPool()->run(
+        [&](int /* unused */, size_t i) { proposals_for_image(i); },
+        num_images);
+  } else {
+    for (int i = 0; i < num_images; i++) {
+      proposals_for_image(i);
+    }
   }
 
   int roi_counts = 0;
@@ -365,6 +375,11 @@ non-maximum suppression is applied to generate the final bounding boxes.
         "float (default 1.0 degrees). For RRPN, clip almost horizontal boxes "
         "within this threshold of tolerance for backward compatibility. "
         "Set to negative value for no clipping.")
+    .Arg(
+        "intra_op_parallel",
+        "bool (default false). If set, the CPU op generates the proposals "
+        "of different images in parallel on the thread pool of the "
+        "workspace.")
     .Input(0, "scores", "Scores from conv layer, size (img_count, A, H, W)")
     .Input(
         1,
@@ -0,0 +1,418 @@
+#include <cub/cub.cuh>
+
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/operators/generate_proposals_op.h"
+#include "caffe2/operators/generate_proposals_op_util_boxes.h"
+#include "caffe2/operators/generate_proposals_op_util_nms_gpu.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Transposes the scores of every image from (A, H, W) to (H, W, A), the
+// order of the enumerated anchors, and stores the index of every score
+// within its image as the value to sort along.
+__global__ void TransposeScoresKernel(
+    const int num_images,
+    const int A,
+    const int K,
+    const float* scores,
+    float* transposed_scores,
+    int* indices) {
+  const int KA = K * A;
+  CUDA_1D_KERNEL_LOOP(index, num_images * KA) {
+    const int i = index / KA;
+    const int n = index % KA;
+    const int a = n % A;
+    const int k = n / A;
+    transposed_scores[index] = scores[(i * A + a) * K + k];
+    indices[index] = n;
+  }
+}
+
+// Decodes the top pre_nms_topN anchors of every image into proposals,
+// clips them to the image and flags the ones that pass the min_size filter.
+// See bbox_transform_upright(), clip_boxes_upright() and
+// filter_boxes_upright() for the CPU equivalents.
+__global__ void DecodeBoxesKernel(
+    const int num_images,
+    const int pre_nms_topN,
+    const int A,
+    const int H,
+    const int W,
+    const float feat_stride,
+    const float bbox_xform_clip,
+    const float transform_offset,
+    const float min_size,
+    const float* anchors,
+    const float* bbox_deltas,
+    const float* im_info,
+    const float* sorted_scores,
+    const int* sorted_indices,
+    float4* proposals,
+    float* proposal_scores,
+    bool* proposal_flags) {
+  const int KA = H * W * A;
+  CUDA_1D_KERNEL_LOOP(index, num_images * pre_nms_topN) {
+    const int i = index / pre_nms_topN;
+    const int j = index % pre_nms_topN;
+    const int n = sorted_indices[i * KA + j];
+    const int a = n % A;
+    const int h = n / A / W;
+    const int w = n / A % W;
+
+    const float shift_x = w * feat_stride;
+    const float shift_y = h * feat_stride;
+    const float x1 = anchors[a * 4 + 0] + shift_x;
+    const float y1 = anchors[a * 4 + 1] + shift_y;
+    const float x2 = anchors[a * 4 + 2] + shift_x;
+    const float y2 = anchors[a * 4 + 3] + shift_y;
+
+    // bbox_deltas: (num_images, A * 4, H, W)
+    const float* delta = bbox_deltas + ((i * A + a) * 4 * H + h) * W + w;
+    const int delta_stride = H * W;
+    const float dx = delta[0];
+    const float dy = delta[delta_stride];
+    const float dw = fminf(delta[2 * delta_stride], bbox_xform_clip);
+    const float dh = fminf(delta[3 * delta_stride], bbox_xform_clip);
+
+    const float width = x2 - x1 + 1.0f;
+    const float height = y2 - y1 + 1.0f;
+    const float ctr_x = x1 + 0.5f * width;
+    const float ctr_y = y1 + 0.5f * height;
+    const float pred_ctr_x = dx * width + ctr_x;
+    const float pred_ctr_y = dy * height + ctr_y;
+    const float pred_w = expf(dw) * width;
+    const float pred_h = expf(dh) * height;
+
+    // Clip to [0, width - 1] x [0, height - 1] of the image, with the image
+    // size truncated to integers as in clip_boxes()
+    const float* cur_im_info = im_info + i * 3;
+    const float max_x = static_cast<int>(cur_im_info[1]) - 1;
+    const float max_y = static_cast<int>(cur_im_info[0]) - 1;
+    float4 box;
+    box.x = fmaxf(fminf(pred_ctr_x - 0.5f * pred_w, max_x), 0.0f);
+    box.y = fmaxf(fminf(pred_ctr_y - 0.5f * pred_h, max_y), 0.0f);
+    box.z = fmaxf(
+        fminf(pred_ctr_x + 0.5f * pred_w - transform_offset, max_x), 0.0f);
+    box.w = fmaxf(
+        fminf(pred_ctr_y + 0.5f * pred_h - transform_offset, max_y), 0.0f);
+
+    // Remove boxes with either height or width < min_size, scaled to the
+    // image, and boxes with their center outside of the image
+    const float scaled_min_size = min_size * cur_im_info[2];
+    const float box_w = box.z - box.x + 1.0f;
+    const float box_h = box.w - box.y + 1.0f;
+    const float box_ctr_x = box.x + box_w / 2.0f;
+    const float box_ctr_y = box.y + box_h / 2.0f;
+
+    proposals[index] = box;
+    proposal_scores[index] = sorted_scores[i * KA + j];
+    proposal_flags[index] = box_w >= scaled_min_size &&
+        box_h >= scaled_min_size && box_ctr_x < cur_im_info[1] &&
+        box_ctr_y < cur_im_info[0];
+  }
+}
+
+// Writes the proposals selected by NMS as rois [image_index, x1, y1, x2, y2]
+__global__ void WriteRoisKernel(
+    const int num_rois,
+    const int* keep,
+    const int* keep_images,
+    const float4* boxes,
+    const float* scores,
+    float* out_rois,
+    float* out_rois_probs) {
+  CUDA_1D_KERNEL_LOOP(r, num_rois) {
+    const int k = keep[r];
+    const float4 box = boxes[k];
+    float* roi = out_rois + r * 5;
+    roi[0] = keep_images[r];
+    roi[1] = box.x;
+    roi[2] = box.y;
+    roi[3] = box.z;
+    roi[4] = box.w;
+    out_rois_probs[r] = scores[k];
+  }
+}
+
+} // namespace
+
+template <>
+bool GenerateProposalsOp<CUDAContext>::RunOnDevice() {
+  const auto& scores = Input(0);
+  const auto& bbox_deltas = Input(1);
+  const auto& im_info_tensor = Input(2);
+  const auto& anchors = Input(3);
+  auto* out_rois = Output(0);
+  auto* out_rois_probs = Output(1);
+
+  CAFFE_ENFORCE_EQ(scores.ndim(), 4, scores.ndim());
+  CAFFE_ENFORCE(scores.template IsType<float>(), scores.meta().name());
+  const auto num_images = scores.dim(0);
+  const auto A = scores.dim(1);
+  const auto height = scores.dim(2);
+  const auto width = scores.dim(3);
+  const auto K = height * width;
+  const auto KA = K * A;
+  const auto box_dim = anchors.dim(1);
+  CAFFE_ENFORCE_EQ(
+      box_dim, 4, "The CUDA GenerateProposals op only supports upright boxes");
+
+  // bbox_deltas: (num_images, A * box_dim, H, W)
+  CAFFE_ENFORCE_EQ(
+      bbox_deltas.dims(),
+      (vector<TIndex>{num_images, box_dim * A, height, width}));
+
+  // im_info_tensor: (num_images, 3), format [height, width, scale; ...]
+  CAFFE_ENFORCE_EQ(im_info_tensor.dims(), (vector<TIndex>{num_images, 3}));
+  CAFFE_ENFORCE(
+      im_info_tensor.template IsType<float>(), im_info_tensor.meta().name());
+
+  // anchors: (A, box_dim)
+  CAFFE_ENFORCE_EQ(anchors.dims(), (vector<TIndex>{A, box_dim}));
+  CAFFE_ENFORCE(anchors.template IsType<float>(), anchors.meta().name());
+
+  const int roi_col_count = box_dim + 1;
+  const int pre_nms_topN = (rpn_pre_nms_topN_ <= 0 || rpn_pre_nms_topN_ >= KA)
+      ? KA
+      : rpn_pre_nms_topN_;
+  if (num_images == 0 || pre_nms_topN == 0) {
+    out_rois->Resize(0, roi_col_count);
+    out_rois_probs->Resize(0);
+    out_rois->mutable_data<float>();
+    out_rois_probs->mutable_data<float>();
+    return true;
+  }
+  const int num_proposals = num_images * pre_nms_topN;
+
+  // 4. sort all (proposal, score) pairs of every image by score from highest
+  // to lowest
+  dev_scores_.Resize(num_images * KA);
+  dev_indices_.Resize(num_images * KA);
+  dev_sorted_scores_.Resize(num_images * KA);
+  dev_sorted_indices_.Resize(num_images * KA);
+  TransposeScoresKernel<<<
+      CAFFE_GET_BLOCKS(num_images * KA),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(
+      num_images,
+      A,
+      K,
+      scores.data<float>(),
+      dev_scores_.mutable_data<float>(),
+      dev_indices_.mutable_data<int>());
+
+  std::vector<int> image_offsets(num_images + 1);
+  for (int i = 0; i <= num_images; ++i) {
+    image_offsets[i] = i * KA;
+  }
+  dev_image_offsets_.Resize(num_images + 1);
+  context_.CopyToDeviceAsync(
+      image_offsets.size() * sizeof(int),
+      image_offsets.data(),
+      dev_image_offsets_.mutable_data<int>());
+  const int* d_image_offsets = dev_image_offsets_.data<int>();
+
+  dev_proposals_.Resize(num_proposals, 4);
+  dev_proposal_scores_.Resize(num_proposals);
+  dev_proposal_flags_.Resize(num_proposals);
+  dev_nms_boxes_.Resize(num_proposals, 4);
+  dev_nms_scores_.Resize(num_proposals);
+  dev_num_valid_.Resize(2 * num_images);
+  float4* d_proposals =
+      reinterpret_cast<float4*>(dev_proposals_.mutable_data<float>());
+  float* d_proposal_scores = dev_proposal_scores_.mutable_data<float>();
+  bool* d_proposal_flags = dev_proposal_flags_.mutable_data<bool>();
+  float4* d_nms_boxes =
+      reinterpret_cast<float4*>(dev_nms_boxes_.mutable_data<float>());
+  float* d_nms_scores = dev_nms_scores_.mutable_data<float>();
+  int* d_num_valid = dev_num_valid_.mutable_data<int>();
+
+  // One scratch buffer for both the sort and the compaction
+  size_t sort_bytes = 0;
+  cub::DeviceSegmentedRadixSort::SortPairsDescending(
+      nullptr,
+      sort_bytes,
+      dev_scores_.data<float>(),
+      dev_sorted_scores_.mutable_data<float>(),
+      dev_indices_.data<int>(),
+      dev_sorted_indices_.mutable_data<int>(),
+      num_images * KA,
+      num_images,
+      d_image_offsets,
+      d_image_offsets + 1,
+      0,
+      8 * sizeof(float),
+      context_.cuda_stream());
+  size_t select_boxes_bytes = 0;
+  cub::DeviceSelect::Flagged(
+      nullptr,
+      select_boxes_bytes,
+      d_proposals,
+      d_proposal_flags,
+      d_nms_boxes,
+      d_num_valid,
+      pre_nms_topN,
+      context_.cuda_stream());
+  size_t select_scores_bytes = 0;
+  cub::DeviceSelect::Flagged(
+      nullptr,
+      select_scores_bytes,
+      d_proposal_scores,
+      d_proposal_flags,
+      d_nms_scores,
+      d_num_valid,
+      pre_nms_topN,
+      context_.cuda_stream());
+  size_t cub_bytes =
+      std::max(sort_bytes, std::max(select_boxes_bytes, select_scores_bytes));
+  dev_cub_buffer_.Resize(cub_bytes);
+  void* d_cub_buffer =
+      static_cast<void*>(dev_cub_buffer_.mutable_data<uint8_t>());
+
+  cub::DeviceSegmentedRadixSort::SortPairsDescending(
+      d_cub_buffer,
+      cub_bytes,
+      dev_scores_.data<float>(),
+      dev_sorted_scores_.mutable_data<float>(),
+      dev_indices_.data<int>(),
+      dev_sorted_indices_.mutable_data<int>(),
+      num_images * KA,
+      num_images,
+      d_image_offsets,
+      d_image_offsets + 1,
+      0,
+      8 * sizeof(float),
+      context_.cuda_stream());
+
+  // 5. take top pre_nms_topN (e.g. 6000)
+  // 1. transform anchors into proposals via bbox transformations
+  // 2. clip proposals to image
+  // 3. flag predicted boxes with either height or width < min_size
+  DecodeBoxesKernel<<<
+      CAFFE_GET_BLOCKS(num_proposals),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(
+      num_images,
+      pre_nms_topN,
+      A,
+      height,
+      width,
+      feat_stride_,
+      utils::BBOX_XFORM_CLIP_DEFAULT,
+      correct_transform_coords_ ? 1.0f : 0.0f,
+      rpn_min_size_,
+      anchors.data<float>(),
+      bbox_deltas.data<float>(),
+      im_info_tensor.data<float>(),
+      dev_sorted_scores_.data<float>(),
+      dev_sorted_indices_.data<int>(),
+      d_proposals,
+      d_proposal_scores,
+      d_proposal_flags);
+
+  // Remove the flagged boxes, keeping the proposals of image i at offset
+  // i * pre_nms_topN
+  for (int i = 0; i < num_images; ++i) {
+    const int offset = i * pre_nms_topN;
+    size_t bytes = cub_bytes;
+    cub::DeviceSelect::Flagged(
+        d_cub_buffer,
+        bytes,
+        d_proposals + offset,
+        d_proposal_flags + offset,
+        d_nms_boxes + offset,
+        d_num_valid + i,
+        pre_nms_topN,
+        context_.cuda_stream());
+    bytes = cub_bytes;
+    cub::DeviceSelect::Flagged(
+        d_cub_buffer,
+        bytes,
+        d_proposal_scores + offset,
+        d_proposal_flags + offset,
+        d_nms_scores + offset,
+        d_num_valid + num_images + i,
+        pre_nms_topN,
+        context_.cuda_stream());
+  }
+  std::vector<int> num_valid(num_images);
+  context_.Copy<int, CUDAContext, CPUContext>(
+      num_images, d_num_valid, num_valid.data());
+  context_.FinishDeviceComputation();
+
+  // 6. apply loose nms (e.g. threshold = 0.7), computing the bitmasks of all
+  // images before copying them to the host at once
+  std::vector<size_t> mask_offsets(num_images + 1, 0);
+  for (int i = 0; i < num_images; ++i) {
+    mask_offsets[i + 1] = mask_offsets[i] +
+        static_cast<size_t>(num_valid[i]) *
+            utils::nms_gpu_mask_words(num_valid[i]);
+  }
+  const size_t mask_size = std::max<size_t>(mask_offsets[num_images], 1);
+  dev_nms_mask_.Resize(mask_size);
+  host_nms_mask_.Resize(mask_size);
+  uint64_t* d_mask =
+      reinterpret_cast<uint64_t*>(dev_nms_mask_.mutable_data<int64_t>());
+  uint64_t* h_mask =
+      reinterpret_cast<uint64_t*>(host_nms_mask_.mutable_data<int64_t>());
+  for (int i = 0; i < num_images; ++i) {
+    utils::nms_gpu_mask_upright(
+        reinterpret_cast<const float*>(d_nms_boxes + i * pre_nms_topN),
+        num_valid[i],
+        rpn_nms_thresh_,
+        d_mask + mask_offsets[i],
+        &context_);
+  }
+  context_.CopyBytes<CUDAContext, CPUContext>(
+      mask_offsets[num_images] * sizeof(uint64_t), d_mask, h_mask);
+  context_.FinishDeviceComputation();
+
+  // 7. take after_nms_topN (e.g. 300)
+  std::vector<int> keep;
+  std::vector<int> keep_images;
+  const int post_nms_topN = rpn_post_nms_topN_ > 0 ? rpn_post_nms_topN_ : -1;
+  for (int i = 0; i < num_images; ++i) {
+    auto im_keep = utils::nms_gpu_sweep(
+        h_mask + mask_offsets[i], num_valid[i], post_nms_topN);
+    for (int k : im_keep) {
+      keep.push_back(i * pre_nms_topN + k);
+    }
+    keep_images.resize(keep.size(), i);
+  }
+
+  // 8. return the top proposals (-> RoIs top)
+  const int roi_counts = keep.size();
+  out_rois->Resize(roi_counts, roi_col_count);
+  out_rois_probs->Resize(roi_counts);
+  float* out_rois_ptr = out_rois->mutable_data<float>();
+  float* out_rois_probs_ptr = out_rois_probs->mutable_data<float>();
+  if (roi_counts == 0) {
+    return true;
+  }
+  keep.insert(keep.end(), keep_images.begin(), keep_images.end());
+  dev_keep_.Resize(keep.size());
+  int* d_keep = dev_keep_.mutable_data<int>();
+  context_.CopyToDeviceAsync(keep.size() * sizeof(int), keep.data(), d_keep);
+  WriteRoisKernel<<<
+      CAFFE_GET_BLOCKS(roi_counts),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context_.cuda_stream()>>>(
+      roi_counts,
+      d_keep,
+      d_keep + roi_counts,
+      d_nms_boxes,
+      d_nms_scores,
+      out_rois_ptr,
+      out_rois_probs_ptr);
+
+  return true;
+}
+
+REGISTER_CUDA_OPERATOR(GenerateProposals, GenerateProposalsOp<CUDAContext>);
+
+} // namespace caffe2
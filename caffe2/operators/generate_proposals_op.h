@@ -60,6 +60,13 @@ ERMatXf ComputeAllAnchors(
 //     'anchors'. Greedy non-maximum suppression is applied to generate the
 //     final bounding boxes.
 // Reference: detectron/lib/ops/generate_proposals.py
+//
+// With the argument intra_op_parallel set, the CPU op generates the proposals
+// of the images in the batch on the thread pool of the workspace, one image
+// per task. The CUDA op only supports upright boxes; it sorts the scores of
+// all images with one segmented radix sort, decodes, clips and filters the
+// top pre_nms_topN boxes in a single kernel and runs bitmask NMS on the
+// device (see nms_gpu_upright()).
 template <class Context>
 class GenerateProposalsOp final : public Operator<Context> {
  public:
@@ -86,7 +93,10 @@ class GenerateProposalsOp final : public Operator<Context> {
         angle_bound_hi_(
             OperatorBase::GetSingleArgument<int>("angle_bound_hi", 90)),
         clip_angle_thresh_(
-            OperatorBase::GetSingleArgument<float>("clip_angle_thresh", 1.0)) {}
+            OperatorBase::GetSingleArgument<float>("clip_angle_thresh", 1.0)),
+        intra_op_parallel_(
+            OperatorBase::GetSingleArgument<bool>("intra_op_parallel", false)),
+        ws_(ws) {}
 
   ~GenerateProposalsOp() {}
 
@@ -133,6 +143,26 @@ class GenerateProposalsOp final : public Operator<Context> {
   // tolerance for backward compatibility. Set to negative value for
   // no clipping.
   float clip_angle_thresh_{1.0};
+  // Generate the proposals of different images in parallel on the CPU
+  bool intra_op_parallel_{false};
+  Workspace* ws_;
+
+  // Scratch space of the CUDA implementation
+  Tensor<Context> dev_image_offsets_;
+  Tensor<Context> dev_scores_;
+  Tensor<Context> dev_indices_;
+  Tensor<Context> dev_sorted_scores_;
+  Tensor<Context> dev_sorted_indices_;
+  Tensor<Context> dev_proposals_;
+  Tensor<Context> dev_proposal_scores_;
+  Tensor<Context> dev_proposal_flags_;
+  Tensor<Context> dev_nms_boxes_;
+  Tensor<Context> dev_nms_scores_;
+  Tensor<Context> dev_num_valid_;
+  Tensor<Context> dev_nms_mask_;
+  Tensor<Context> dev_keep_;
+  Tensor<Context> dev_cub_buffer_;
+  TensorCPU host_nms_mask_;
 };
 
 } // namespace caffe2
@@ -0,0 +1,227 @@
+#include "caffe2/operators/generate_proposals_op.h"
+
+#include <random>
+
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/utils/eigen_utils.h"
+#include "caffe2/utils/math.h"
+#include "gtest/gtest.h"
+
+namespace caffe2 {
+namespace {
+
+template <class Context>
+void AddInput(
+    const vector<TIndex>& shape,
+    const vector<float>& values,
+    const string& name,
+    Workspace* ws);
+
+template <>
+void AddInput<CPUContext>(
+    const vector<TIndex>& shape,
+    const vector<float>& values,
+    const string& name,
+    Workspace* ws) {
+  Blob* blob = ws->CreateBlob(name);
+  auto* tensor = blob->GetMutable<TensorCPU>();
+  tensor->Resize(shape);
+  EigenVectorMap<float> tensor_vec(
+      tensor->mutable_data<float>(), tensor->size());
+  tensor_vec.array() = utils::AsEArrXt(values);
+}
+
+template <>
+void AddInput<CUDAContext>(
+    const vector<TIndex>& shape,
+    const vector<float>& values,
+    const string& name,
+    Workspace* ws) {
+  TensorCPU tmp(shape);
+  EigenVectorMap<float> tmp_vec(tmp.mutable_data<float>(), tmp.size());
+  tmp_vec.array() = utils::AsEArrXt(values);
+
+  Blob* blob = ws->CreateBlob(name);
+  auto* tensor = blob->template GetMutable<Tensor<CUDAContext>>();
+  tensor->CopyFrom(tmp);
+}
+
+template <class Context>
+DeviceType GetDeviceType() {
+  return CPU;
+}
+template <>
+DeviceType GetDeviceType<CUDAContext>() {
+  return CUDA;
+}
+
+vector<float> RandomValues(int size, float lo, float hi, std::mt19937* gen) {
+  std::uniform_real_distribution<float> dist(lo, hi);
+  vector<float> ret(size);
+  for (auto& value : ret) {
+    value = dist(*gen);
+  }
+  return ret;
+}
+
+struct TestInput {
+  string name;
+  vector<TIndex> shape;
+  vector<float> values;
+};
+
+// Runs the operator 'def' on the device of 'Context' and copies all of its
+// outputs to the CPU.
+template <class Context>
+vector<TensorCPU> CreateAndRun(
+    OperatorDef def,
+    const vector<TestInput>& inputs) {
+  Workspace ws;
+  Context context;
+  for (const auto& input : inputs) {
+    AddInput<Context>(input.shape, input.values, input.name, &ws);
+  }
+  def.mutable_device_option()->set_device_type(GetDeviceType<Context>());
+  unique_ptr<OperatorBase> op(CreateOperator(def, &ws));
+  EXPECT_NE(nullptr, op.get());
+  EXPECT_TRUE(op->Run());
+
+  vector<TensorCPU> outputs(def.output_size());
+  for (int i = 0; i < def.output_size(); ++i) {
+    const auto& output = ws.GetBlob(def.output(i))->Get<Tensor<Context>>();
+    outputs[i].CopyFrom(output, &context);
+  }
+  context.FinishDeviceComputation();
+  return outputs;
+}
+
+template <typename T>
+void ExpectTensorsNear(const TensorCPU& expected, const TensorCPU& actual) {
+  EXPECT_EQ(expected.dims(), actual.dims());
+  if (expected.dims() != actual.dims() || expected.size() == 0) {
+    return;
+  }
+  ConstEigenVectorArrayMap<T> expected_vec(
+      expected.data<T>(), expected.size());
+  ConstEigenVectorArrayMap<T> actual_vec(actual.data<T>(), actual.size());
+  EXPECT_NEAR(
+      (expected_vec.template cast<float>() - actual_vec.template cast<float>())
+          .abs()
+          .maxCoeff(),
+      0,
+      1e-3);
+}
+
+} // namespace
+
+TEST(GenerateProposalsTest, CheckCPUGPUEqual) {
+  if (!caffe2::HasCudaGPU())
+    return;
+
+  std::mt19937 gen(0);
+  const int img_count = 3;
+  const int A = 3;
+  const int H = 14;
+  const int W = 18;
+
+  OperatorDef def;
+  def.set_name("test");
+  def.set_type("GenerateProposals");
+  def.add_input("scores");
+  def.add_input("bbox_deltas");
+  def.add_input("im_info");
+  def.add_input("anchors");
+  def.add_output("rois");
+  def.add_output("rois_probs");
+  def.add_arg()->CopyFrom(MakeArgument("spatial_scale", 1.0f / 16.0f));
+  def.add_arg()->CopyFrom(MakeArgument("pre_nms_topN", 500));
+  def.add_arg()->CopyFrom(MakeArgument("post_nms_topN", 100));
+  def.add_arg()->CopyFrom(MakeArgument("nms_thresh", 0.7f));
+  def.add_arg()->CopyFrom(MakeArgument("min_size", 16.0f));
+  def.add_arg()->CopyFrom(MakeArgument("correct_transform_coords", true));
+
+  vector<TestInput> inputs{
+      {"scores",
+       {img_count, A, H, W},
+       RandomValues(img_count * A * H * W, 0, 1, &gen)},
+      {"bbox_deltas",
+       {img_count, 4 * A, H, W},
+       RandomValues(img_count * 4 * A * H * W, -0.3, 0.3, &gen)},
+      {"im_info", {img_count, 3}, {224, 288, 1, 200, 288, 1, 224, 250, 0.8}},
+      {"anchors",
+       {A, 4},
+       {-22, -10, 37, 25, -56, -56, 71, 71, -84, -40, 99, 55}}};
+
+  auto cpu_outputs = CreateAndRun<CPUContext>(def, inputs);
+  auto gpu_outputs = CreateAndRun<CUDAContext>(def, inputs);
+  def.add_arg()->CopyFrom(MakeArgument("intra_op_parallel", true));
+  auto parallel_outputs = CreateAndRun<CPUContext>(def, inputs);
+
+  EXPECT_GT(cpu_outputs[0].dim(0), 0);
+  for (const auto* outputs : {&gpu_outputs, &parallel_outputs}) {
+    ExpectTensorsNear<float>(cpu_outputs[0], (*outputs)[0]);
+    ExpectTensorsNear<float>(cpu_outputs[1], (*outputs)[1]);
+  }
+}
+
+TEST(BoxWithNMSLimitTest, CheckCPUGPUEqual) {
+  if (!caffe2::HasCudaGPU())
+    return;
+
+  std::mt19937 gen(0);
+  const vector<int> batch_splits{70, 0, 130};
+  const int num_boxes = 200;
+  const int num_classes = 6;
+
+  vector<float> boxes;
+  std::uniform_real_distribution<float> coord(0, 200);
+  std::uniform_real_distribution<float> size(5, 60);
+  for (int i = 0; i < num_boxes * num_classes; ++i) {
+    const float x1 = coord(gen);
+    const float y1 = coord(gen);
+    boxes.insert(boxes.end(), {x1, y1, x1 + size(gen), y1 + size(gen)});
+  }
+
+  OperatorDef def;
+  def.set_name("test");
+  def.set_type("BoxWithNMSLimit");
+  def.add_input("scores");
+  def.add_input("boxes");
+  def.add_input("batch_splits");
+  def.add_output("out_scores");
+  def.add_output("out_boxes");
+  def.add_output("out_classes");
+  def.add_output("out_batch_splits");
+  def.add_output("out_keeps");
+  def.add_output("out_keeps_size");
+  def.add_arg()->CopyFrom(MakeArgument("score_thresh", 0.3f));
+  def.add_arg()->CopyFrom(MakeArgument("nms", 0.5f));
+  def.add_arg()->CopyFrom(MakeArgument("detections_per_im", 40));
+
+  vector<TestInput> inputs{
+      {"scores",
+       {num_boxes, num_classes},
+       RandomValues(num_boxes * num_classes, 0, 1, &gen)},
+      {"boxes", {num_boxes, num_classes * 4}, boxes},
+      {"batch_splits",
+       {TIndex(batch_splits.size())},
+       vector<float>(batch_splits.begin(), batch_splits.end())}};
+
+  auto cpu_outputs = CreateAndRun<CPUContext>(def, inputs);
+  auto gpu_outputs = CreateAndRun<CUDAContext>(def, inputs);
+  def.add_arg()->CopyFrom(MakeArgument("intra_op_parallel", true));
+  auto parallel_outputs = CreateAndRun<CPUContext>(def, inputs);
+
+  EXPECT_GT(cpu_outputs[0].dim(0), 0);
+  for (const auto* outputs : {&gpu_outputs, &parallel_outputs}) {
+    ExpectTensorsNear<float>(cpu_outputs[0], (*outputs)[0]);
+    ExpectTensorsNear<float>(cpu_outputs[1], (*outputs)[1]);
+    ExpectTensorsNear<float>(cpu_outputs[2], (*outputs)[2]);
+    ExpectTensorsNear<float>(cpu_outputs[3], (*outputs)[3]);
+    ExpectTensorsNear<int>(cpu_outputs[4], (*outputs)[4]);
+    ExpectTensorsNear<int>(cpu_outputs[5], (*outputs)[5]);
+  }
+}
+
+} // namespace caffe2
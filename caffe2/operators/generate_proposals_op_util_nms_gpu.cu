@@ -0,0 +1,109 @@
+#include "caffe2/operators/generate_proposals_op_util_nms_gpu.h"
+
+namespace caffe2 {
+namespace utils {
+
+namespace {
+
+__device__ inline float IoUUpright(const float4& a, const float4& b) {
+  const float left = fmaxf(a.x, b.x);
+  const float right = fminf(a.z, b.z);
+  const float top = fmaxf(a.y, b.y);
+  const float bottom = fminf(a.w, b.w);
+  const float width = fmaxf(right - left + 1.0f, 0.0f);
+  const float height = fmaxf(bottom - top + 1.0f, 0.0f);
+  const float inter = width * height;
+  const float area_a = (a.z - a.x + 1.0f) * (a.w - a.y + 1.0f);
+  const float area_b = (b.z - b.x + 1.0f) * (b.w - b.y + 1.0f);
+  return inter / (area_a + area_b - inter);
+}
+
+// One block per (kNMSBoxesPerWord rows, kNMSBoxesPerWord columns) tile of
+// the N x N overlap matrix above the diagonal; thread t of the block computes
+// the word of row (blockIdx.y * kNMSBoxesPerWord + t) that covers the
+// columns of the tile.
+__global__ void NMSMaskKernel(
+    const float4* boxes,
+    const int N,
+    const float thresh,
+    const int mask_words,
+    uint64_t* mask) {
+  const int row_start = blockIdx.y;
+  const int col_start = blockIdx.x;
+  if (row_start > col_start) {
+    return;
+  }
+  const int row_size =
+      min(N - row_start * kNMSBoxesPerWord, kNMSBoxesPerWord);
+  const int col_size =
+      min(N - col_start * kNMSBoxesPerWord, kNMSBoxesPerWord);
+
+  __shared__ float4 col_boxes[kNMSBoxesPerWord];
+  if (threadIdx.x < col_size) {
+    col_boxes[threadIdx.x] =
+        boxes[col_start * kNMSBoxesPerWord + threadIdx.x];
+  }
+  __syncthreads();
+
+  if (threadIdx.x < row_size) {
+    const int i = row_start * kNMSBoxesPerWord + threadIdx.x;
+    const float4 box = boxes[i];
+    uint64_t bits = 0;
+    const int start = (row_start == col_start) ? threadIdx.x + 1 : 0;
+    for (int k = start; k < col_size; ++k) {
+      if (IoUUpright(box, col_boxes[k]) > thresh) {
+        bits |= uint64_t(1) << k;
+      }
+    }
+    mask[static_cast<size_t>(i) * mask_words + col_start] = bits;
+  }
+}
+
+} // namespace
+
+void nms_gpu_mask_upright(
+    const float* d_desc_sorted_boxes,
+    int N,
+    float thresh,
+    uint64_t* d_mask,
+    CUDAContext* context) {
+  if (N == 0) {
+    return;
+  }
+  const int mask_words = nms_gpu_mask_words(N);
+  const dim3 blocks(mask_words, mask_words);
+  NMSMaskKernel<<<blocks, kNMSBoxesPerWord, 0, context->cuda_stream()>>>(
+      reinterpret_cast<const float4*>(d_desc_sorted_boxes),
+      N,
+      thresh,
+      mask_words,
+      d_mask);
+}
+
+std::vector<int> nms_gpu_upright(
+    const float* d_desc_sorted_boxes,
+    int N,
+    float thresh,
+    int topN,
+    Tensor<CUDAContext>* dev_mask,
+    TensorCPU* host_mask,
+    CUDAContext* context) {
+  if (N == 0) {
+    return std::vector<int>();
+  }
+  const int mask_words = nms_gpu_mask_words(N);
+  dev_mask->Resize(N, mask_words);
+  host_mask->Resize(N, mask_words);
+  uint64_t* d_mask =
+      reinterpret_cast<uint64_t*>(dev_mask->mutable_data<int64_t>());
+  uint64_t* h_mask =
+      reinterpret_cast<uint64_t*>(host_mask->mutable_data<int64_t>());
+  nms_gpu_mask_upright(d_desc_sorted_boxes, N, thresh, d_mask, context);
+  context->CopyBytes<CUDAContext, CPUContext>(
+      dev_mask->nbytes(), d_mask, h_mask);
+  context->FinishDeviceComputation();
+  return nms_gpu_sweep(h_mask, N, topN);
+}
+
+} // namespace utils
+} // namespace caffe2
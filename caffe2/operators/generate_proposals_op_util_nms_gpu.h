@@ -0,0 +1,89 @@
+#ifndef CAFFE2_OPERATORS_UTILS_NMS_GPU_H_
+#define CAFFE2_OPERATORS_UTILS_NMS_GPU_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "caffe2/core/context_gpu.h"
+
+// Bitmask non-maximum suppression on the GPU for generate_proposals_op and
+//     box_with_nms_limit_op
+
+namespace caffe2 {
+namespace utils {
+
+// Number of boxes covered by one word of a NMS bitmask
+constexpr int kNMSBoxesPerWord = 64;
+
+// Number of words in one row of the NMS bitmask of N boxes
+inline int nms_gpu_mask_words(int N) {
+  return (N + kNMSBoxesPerWord - 1) / kNMSBoxesPerWord;
+}
+
+// Computes the suppression bitmask of greedy non-maximum suppression on the
+//    GPU, without waiting for the result.
+// d_desc_sorted_boxes: device pointer to the pixel coordinates of the boxes,
+//    sorted by score from high to low, size: (N, 4), format: [x1; y1; x2; y2],
+//    aligned to 16 bytes
+// thresh: boxes whose intersection-over-union (IoU) overlap with a higher
+//    scoring box is larger than thresh are suppressed by that box
+// d_mask: device pointer to N * nms_gpu_mask_words(N) words. Bit k of word w
+//    in row i is set if box i suppresses box (w * 64 + k) > i. Words that
+//    only cover boxes before box i are not written.
+void nms_gpu_mask_upright(
+    const float* d_desc_sorted_boxes,
+    int N,
+    float thresh,
+    uint64_t* d_mask,
+    CUDAContext* context);
+
+// Greedy sweep over a bitmask computed by nms_gpu_mask_upright() and copied
+//    to the host
+// h_mask: the bitmask of N boxes, size: (N, nms_gpu_mask_words(N))
+// topN: if non-negative, stop after selecting topN boxes
+// return: indices of the selected boxes from high to low score
+inline std::vector<int> nms_gpu_sweep(const uint64_t* h_mask, int N, int topN) {
+  const int mask_words = nms_gpu_mask_words(N);
+  std::vector<uint64_t> suppressed(mask_words, 0);
+  std::vector<int> keep;
+  for (int i = 0; i < N; ++i) {
+    if (topN >= 0 && static_cast<int>(keep.size()) >= topN) {
+      break;
+    }
+    const int word = i / kNMSBoxesPerWord;
+    const int bit = i % kNMSBoxesPerWord;
+    if (suppressed[word] & (uint64_t(1) << bit)) {
+      continue;
+    }
+    keep.push_back(i);
+    const uint64_t* row = h_mask + static_cast<size_t>(i) * mask_words;
+    for (int w = word; w < mask_words; ++w) {
+      suppressed[w] |= row[w];
+    }
+  }
+  return keep;
+}
+
+// Greedy non-maximum suppression for boxes that are already on the GPU.
+//    Selects the same boxes as nms_cpu_upright() with sorted_indices
+//    0, ..., N - 1, but compares all pairs of boxes in parallel on the GPU
+//    and only runs the greedy sweep over the resulting bitmask on the host.
+//    Blocks until the work queued on the stream of 'context' is done.
+// d_desc_sorted_boxes: device pointer to the pixel coordinates of the boxes,
+//    sorted by score from high to low, size: (N, 4), format: [x1; y1; x2; y2],
+//    aligned to 16 bytes
+// dev_mask, host_mask: scratch space for the bitmask
+// return: indices of the selected boxes from high to low score
+std::vector<int> nms_gpu_upright(
+    const float* d_desc_sorted_boxes,
+    int N,
+    float thresh,
+    int topN,
+    Tensor<CUDAContext>* dev_mask,
+    TensorCPU* host_mask,
+    CUDAContext* context);
+
+} // namespace utils
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_UTILS_NMS_GPU_H_
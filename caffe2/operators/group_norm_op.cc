@@ -9,9 +9,11 @@
 #include "group_norm_op.h"
 
 #include <array>
+#include <cmath>
 
 #include "caffe2/utils/eigen_utils.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/math_utils.h"
 
 namespace caffe2 {
 
@@ -121,12 +123,30 @@ bool GroupNormOp<T, Context>::RunOnDeviceImpl(
     T* Y_data,
     T* mu_data,
     T* rsig_data) {
-  const std::array<int, 4> dims = order_ == StorageOrder::NCHW
-      ? std::array<int, 4>{N, G, D, HxW}
-      : std::array<int, 4>{N, HxW, G, D};
-  const std::array<int, 2> axes = order_ == StorageOrder::NCHW
-      ? std::array<int, 2>{2, 3}
-      : std::array<int, 2>{1, 3};
+  if (order_ == StorageOrder::NCHW) {
+    // Each (n, g) group is a contiguous row of D * HxW values, so its moments
+    // take a single Welford pass, and Y = s * X + b with s = gamma * rsig and
+    // b = beta - s * mu is applied a channel at a time.
+    const int inner_size = D * HxW;
+    for (int i = 0; i < N * G; ++i) {
+      T var;
+      math::utils::WelfordMoments(
+          inner_size, X_data + i * inner_size, mu_data + i, &var);
+      rsig_data[i] = T(1) / std::sqrt(var + epsilon_);
+      for (int j = 0; j < D; ++j) {
+        const int c = i % G * D + j;
+        const T s = gamma_data[c] * rsig_data[i];
+        const T b = beta_data[c] - s * mu_data[i];
+        const int offset = (i * D + j) * HxW;
+        EigenVectorArrayMap<T>(Y_data + offset, HxW) =
+            ConstEigenVectorArrayMap<T>(X_data + offset, HxW) * s + b;
+      }
+    }
+    return true;
+  }
+
+  const std::array<int, 4> dims = {N, HxW, G, D};
+  const std::array<int, 2> axes = {1, 3};
 
   // Computes mean and variance.
   math::Moments<T, Context>(
@@ -137,13 +157,8 @@ bool GroupNormOp<T, Context>::RunOnDeviceImpl(
   math::Rsqrt<T, CPUContext>(N * G, rsig_data, rsig_data, &context_);
 
   // Computes Y = gamma * (X - mu) * rsig + beta.
-  if (order_ == StorageOrder::NCHW) {
-    GroupNormForward<T, StorageOrder::NCHW>(
-        dims, X_data, mu_data, rsig_data, gamma_data, beta_data, Y_data);
-  } else {
-    GroupNormForward<T, StorageOrder::NHWC>(
-        dims, X_data, mu_data, rsig_data, gamma_data, beta_data, Y_data);
-  }
+  GroupNormForward<T, StorageOrder::NHWC>(
+      dims, X_data, mu_data, rsig_data, gamma_data, beta_data, Y_data);
   return true;
 }
 
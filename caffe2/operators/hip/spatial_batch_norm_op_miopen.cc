@@ -33,6 +33,7 @@ class MIOpenSpatialBNOp final : public SpatialBNOp<HIPContext> {
         alpha_(OperatorBase::GetSingleArgument<float>("alpha", 1.0)),
         beta_(OperatorBase::GetSingleArgument<float>("beta", 0.0)),
         mode_(miopenBNSpatial) {
+    OPERATOR_NEEDS_FEATURE(!fuse_relu_, "Fused ReLU not supported.");
     MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&data_desc_));
     MIOPEN_ENFORCE(miopenCreateTensorDescriptor(&bn_param_desc_));
     if (epsilon_ <= MIOPEN_BN_MIN_EPSILON) {
@@ -1,12 +1,13 @@
 #include <atomic>
 #include <limits>
 #include <mutex>
+#include <numeric>
 #include <sstream>
-#include <unordered_map>
 #include <vector>
 #include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/tensor.h"
+#include "caffe2/utils/flat_hash_map/flat_hash_map.h"
 
 namespace caffe2 {
 namespace {
@@ -36,39 +37,90 @@ struct IndexBase {
   const TypeMeta& Type() const { return meta_; }
 
   TIndexValue Size() {
-    std::lock_guard<std::mutex> guard(dictMutex_);
     return nextId_;
   }
 
  protected:
+  // Reserves the next id, failing if the index is full.
+  TIndexValue NewId() {
+    TIndexValue id = nextId_;
+    do {
+      CAFFE_ENFORCE(id < maxElements_, "Dict max size reached");
+    } while (!nextId_.compare_exchange_weak(id, id + 1));
+    return id;
+  }
+
   int64_t maxElements_;
   TypeMeta meta_;
-  TIndexValue nextId_{1}; // guarded by dictMutex_
+  std::atomic<TIndexValue> nextId_{1};
   std::atomic<bool> frozen_{false};
-  std::mutex dictMutex_;
 };
 
+// The keys are split over kNumShards hash maps, each with its own lock, so
+// that concurrent IndexGet calls only contend when they touch the same
+// shard. An id is reserved and inserted while holding the lock of the shard
+// of its key, so holding all the shard locks gives a consistent view of the
+// whole index.
 template<typename T>
 struct Index: IndexBase {
   explicit Index(TIndexValue maxElements)
-    : IndexBase(maxElements, TypeMeta::Make<T>()) {}
+    : IndexBase(maxElements, TypeMeta::Make<T>()), shards_(kNumShards) {}
 
+  // Looks the keys up shard by shard, taking every shard lock once for the
+  // batch, then inserts the missing ones in order so that new keys get
+  // consecutive ids in order of first occurrence.
   void Get(const T* keys, TIndexValue* values, size_t numKeys) {
     if (frozen_) {
       FrozenGet(keys, values, numKeys);
       return;
     }
-    std::lock_guard<std::mutex> lock(dictMutex_);
-    for (int i = 0; i < numKeys; ++i) {
-      auto it = dict_.find(keys[i]);
-      if (it != dict_.end()) {
+    std::vector<size_t> shardIds(numKeys);
+    std::vector<size_t> offsets(kNumShards + 1, 0);
+    for (size_t i = 0; i < numKeys; ++i) {
+      shardIds[i] = ShardOf(keys[i]);
+      ++offsets[shardIds[i] + 1];
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<size_t> order(numKeys);
+    {
+      std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+      for (size_t i = 0; i < numKeys; ++i) {
+        order[next[shardIds[i]]++] = i;
+      }
+    }
+
+    bool missing = false;
+    for (size_t s = 0; s < kNumShards; ++s) {
+      if (offsets[s] == offsets[s + 1]) {
+        continue;
+      }
+      auto& shard = shards_[s];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (size_t j = offsets[s]; j < offsets[s + 1]; ++j) {
+        const size_t i = order[j];
+        auto it = shard.dict.find(keys[i]);
+        values[i] = it != shard.dict.end() ? it->second : 0;
+        missing |= values[i] == 0;
+      }
+    }
+    if (!missing) {
+      return;
+    }
+
+    for (size_t i = 0; i < numKeys; ++i) {
+      if (values[i] != 0) {
+        continue;
+      }
+      auto& shard = shards_[shardIds[i]];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      // the key may have been inserted by another thread or earlier in
+      // this batch
+      auto it = shard.dict.find(keys[i]);
+      if (it != shard.dict.end()) {
         values[i] = it->second;
-      } else if (nextId_ < maxElements_) {
-        auto newValue = nextId_++;
-        dict_.insert({keys[i], newValue});
-        values[i] = newValue;
       } else {
-        CAFFE_THROW("Dict max size reached");
+        values[i] = NewId();
+        shard.dict.emplace(keys[i], values[i]);
       }
     }
   }
@@ -77,17 +129,22 @@ struct Index: IndexBase {
     CAFFE_ENFORCE(
         numKeys <= maxElements_,
         "Cannot load index: Tensor is larger than max_elements.");
-    decltype(dict_) dict;
+    std::vector<Dict> dicts(kNumShards);
+    for (auto& dict : dicts) {
+      dict.reserve(numKeys / kNumShards);
+    }
     for (int i = 0; i < numKeys; ++i) {
       CAFFE_ENFORCE(
-          dict.insert({keys[i], i + 1}).second,
+          dicts[ShardOf(keys[i])].emplace(keys[i], i + 1).second,
           "Repeated elements found: cannot load into dictionary.");
     }
     // assume no `get` is inflight while this happens
     {
-      std::lock_guard<std::mutex> lock(dictMutex_);
-      // let the old dict get destructed outside of the lock
-      dict_.swap(dict);
+      auto locks = LockAll();
+      // let the old dicts get destructed outside of the locks
+      for (size_t s = 0; s < kNumShards; ++s) {
+        shards_[s].dict.swap(dicts[s]);
+      }
       nextId_ = numKeys + 1;
     }
     return true;
@@ -95,24 +152,54 @@ struct Index: IndexBase {
 
   template<typename Ctx>
   bool Store(Tensor<Ctx>* out) {
-    std::lock_guard<std::mutex> lock(dictMutex_);
+    auto locks = LockAll();
     out->Resize(nextId_ - 1);
     auto outData = out->template mutable_data<T>();
-    for (const auto& entry : dict_) {
-      outData[entry.second - 1] = entry.first;
+    for (const auto& shard : shards_) {
+      for (const auto& entry : shard.dict) {
+        outData[entry.second - 1] = entry.first;
+      }
     }
     return true;
   }
 
  private:
+  using Dict = ska::flat_hash_map<T, TIndexValue>;
+
+  struct Shard {
+    std::mutex mutex;
+    Dict dict;
+  };
+
+  enum : size_t { kShardBits = 6, kNumShards = 1 << kShardBits };
+
+  // Fibonacci hashing of the key's hash, so that keys whose hashes only
+  // differ in the high or the low bits are still spread over the shards.
+  static size_t ShardOf(const T& key) {
+    return static_cast<uint64_t>(std::hash<T>()(key)) * 0x9E3779B97F4A7C15ULL >>
+        (64 - kShardBits);
+  }
+
+  std::vector<std::unique_lock<std::mutex>> LockAll() {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(kNumShards);
+    for (auto& shard : shards_) {
+      locks.emplace_back(shard.mutex);
+    }
+    return locks;
+  }
+
+  // No insert can happen once the index is frozen, so the shards are read
+  // without locking.
   void FrozenGet(const T* keys, TIndexValue* values, size_t numKeys) {
     for (int i = 0; i < numKeys; ++i) {
-      auto it = dict_.find(keys[i]);
-      values[i] = it != dict_.end() ? it->second : 0;
+      const auto& dict = shards_[ShardOf(keys[i])].dict;
+      auto it = dict.find(keys[i]);
+      values[i] = it != dict.end() ? it->second : 0;
     }
   }
 
-  std::unordered_map<T, TIndexValue> dict_;
+  std::vector<Shard> shards_;
 };
 
 // TODO(azzolini): support sizes larger than int32
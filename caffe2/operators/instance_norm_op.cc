@@ -107,6 +107,7 @@ REGISTER_CPU_OPERATOR(InstanceNorm, InstanceNormOp<float, CPUContext>);
 OPERATOR_SCHEMA(InstanceNorm)
     .NumInputs(3)
     .NumOutputs(1, 3)
+    .CostInferenceFunction(PointwiseCostInference<5>)
     .AllowInplace({{0,0}})
     .SetDoc(R"DOC(
 The *InstanceNorm* op applies Instance Normalization over a 4D input as described in [Instance Normalization: The Missing Ingredient for Fast Stylization](https://arxiv.org/abs/1607.08022).
@@ -1,18 +1,9 @@
 #include "caffe2/operators/layer_norm_op.h"
 #include "caffe2/utils/eigen_utils.h"
+#include "caffe2/utils/math_utils.h"
 
 namespace caffe2 {
 
-namespace {
-template <typename T>
-using EigenMatrixMapRowMajor = Eigen::Map<
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>;
-
-template <typename T>
-using ConstEigenMatrixMapRowMajor = Eigen::Map<
-    const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>>;
-} // namespace
-
 template <>
 template <>
 bool LayerNormOp<CPUContext>::DoRunWithType<float>() {
@@ -34,26 +25,22 @@ bool LayerNormOp<CPUContext>::DoRunWithType<float>() {
   mean->Resize(stats_dims);
   stdev->Resize(stats_dims);
 
-  auto input_map = ConstEigenMatrixMapRowMajor<float>(
-      input.template data<float>(), left, right);
-  auto mean_map = EigenMatrixMapRowMajor<float>(
-      mean->template mutable_data<float>(), left, 1);
-  auto stdev_map = EigenMatrixMapRowMajor<float>(
-      stdev->template mutable_data<float>(), left, 1);
-  auto output_map = EigenMatrixMapRowMajor<float>(
-      output->template mutable_data<float>(), left, right);
-
-  auto sqr = [](float f) { return f * f; };
-  auto add_ep = [this](float f) { return f + epsilon_; };
-  auto fsqrt = [](float f) { return std::sqrt(f); };
-  // Calculate row-wise statistics
-  mean_map = input_map.rowwise().mean();
-  stdev_map =
-      (input_map.unaryExpr(sqr).rowwise().mean() - mean_map.unaryExpr(sqr))
-          .unaryExpr(add_ep)
-          .unaryExpr(fsqrt);
-  output_map = (input_map - mean_map.replicate(1, right))
-                   .cwiseQuotient(stdev_map.replicate(1, right));
+  const float* X = input.template data<float>();
+  float* Y = output->template mutable_data<float>();
+  float* mean_data = mean->template mutable_data<float>();
+  float* stdev_data = stdev->template mutable_data<float>();
+  // The moments of each row take one pass over it, and the normalization a
+  // second one while the row is still in cache.
+  for (int i = 0; i < left; ++i) {
+    float row_mean;
+    float row_var;
+    math::utils::WelfordMoments(right, X + i * right, &row_mean, &row_var);
+    mean_data[i] = row_mean;
+    stdev_data[i] = std::sqrt(row_var + epsilon_);
+    EigenVectorArrayMap<float>(Y + i * right, right) =
+        (ConstEigenVectorArrayMap<float>(X + i * right, right) - row_mean) /
+        stdev_data[i];
+  }
 
   return true;
 }
@@ -64,7 +51,6 @@ template <>
 template <>
 bool LayerNormGradientOp<CPUContext>::DoRunWithType<float>() {
   const auto& dout = Input(0);
-  const auto& norm_outputs = Input(1);
   const auto& means = Input(2);
   const auto& stdev = Input(3);
   const auto& norm_inputs = Input(4);
@@ -76,57 +62,25 @@ bool LayerNormGradientOp<CPUContext>::DoRunWithType<float>() {
 
   ginput->ResizeLike(norm_inputs);
 
-  auto dout_map = ConstEigenMatrixMapRowMajor<float>(
-      dout.template data<float>(), left, right);
-  auto means_map =
-      ConstEigenMatrixMapRowMajor<float>(means.template data<float>(), left, 1);
-  auto stdev_map =
-      ConstEigenMatrixMapRowMajor<float>(stdev.template data<float>(), left, 1);
-  auto norm_inputs_map = ConstEigenMatrixMapRowMajor<float>(
-      norm_inputs.template data<float>(), left, right);
-  auto ginput_map = EigenMatrixMapRowMajor<float>(
-      ginput->template mutable_data<float>(), left, right);
-
-  // Helper functors
-  auto sqr = [](float f) { return f * f; };
-  auto recip = [](float f) { return 1.0f / f; };
-  auto neg_recip = [](float f) { return -1.0f / f; };
-
-  // Gradients - output block
-  // -1 / (stdev + epsilon)^2 * \sum_j^D x_ij - mean * dout
-  // First part: -1 / (stdev + epsilon)^2
-  auto dstdev_end_0 = stdev_map.unaryExpr(sqr).unaryExpr(neg_recip);
-  // Second part: \sum_j^D x_ij - mean * dout
-  auto dstdev_end_1 = (norm_inputs_map - means_map.replicate(1, right))
-                          .cwiseProduct(dout_map)
-                          .rowwise()
-                          .sum();
-  auto dstdev_end = dstdev_end_0.cwiseProduct(dstdev_end_1);
-  // \sum_j^D -dout * 1/(std+epsilon)
-  auto dmean_end = stdev_map.unaryExpr(neg_recip)
-                       .replicate(1, right)
-                       .cwiseProduct(dout_map)
-                       .rowwise()
-                       .sum();
-  // 1.0 / (stdev + epsilon) * dout
-  auto dx_end =
-      stdev_map.unaryExpr(recip).replicate(1, right).cwiseProduct(dout_map);
-
-  // Gradients - standard deviation block
-  // -1.0*(mean / stdev) * dstdev_end
-  auto dmean_stdev = stdev_map.unaryExpr(neg_recip)
-                         .cwiseProduct(means_map)
-                         .cwiseProduct(dstdev_end);
-  // (mean / (D*stdev)) * dstdev
-  auto dx_stdev = (1.0f / right) *
-      norm_inputs_map.cwiseQuotient(stdev_map.replicate(1, right))
-          .cwiseProduct(dstdev_end.replicate(1, right));
-
-  // Gradients - mean block
-  auto dmean = dmean_end + dmean_stdev;
-  auto dx_mean = (1.0f / right) * dmean.replicate(1, right);
-
-  ginput_map = dx_end + dx_stdev + dx_mean;
+  const float* dY = dout.template data<float>();
+  const float* X = norm_inputs.template data<float>();
+  const float* mean_data = means.template data<float>();
+  const float* stdev_data = stdev.template data<float>();
+  float* dX = ginput->template mutable_data<float>();
+  // With x_hat = (X - mean) / stdev,
+  //   dX = (dY - mean(dY) - x_hat * mean(dY * x_hat)) / stdev
+  // which needs one pass over a row for the two sums and one to write it.
+  for (int i = 0; i < left; ++i) {
+    ConstEigenVectorArrayMap<float> dY_row(dY + i * right, right);
+    ConstEigenVectorArrayMap<float> X_row(X + i * right, right);
+    const float rstd = 1.0f / stdev_data[i];
+    const float dY_mean = dY_row.mean();
+    const float dY_x_hat_mean =
+        (dY_row * (X_row - mean_data[i])).mean() * rstd;
+    EigenVectorArrayMap<float>(dX + i * right, right) =
+        (dY_row - dY_mean - (X_row - mean_data[i]) * (rstd * dY_x_hat_mean)) *
+        rstd;
+  }
 
   return true;
 }
@@ -155,6 +109,7 @@ REGISTER_GRADIENT(LayerNorm, GetLayerNormGradient);
 OPERATOR_SCHEMA(LayerNorm)
     .NumInputs(1)
     .NumOutputs(3)
+    .CostInferenceFunction(PointwiseCostInference<5>)
     .TensorInferenceFunction([](const OperatorDef& def,
                                 const vector<TensorShape>& in) {
       vector<TensorShape> out(3);
@@ -1,80 +1,140 @@
 #include "caffe2/operators/layer_norm_op.h"
 
-#include <cub/cub.cuh>
+#include <algorithm>
+
+#include <cub/block/block_reduce.cuh>
 
 #include "caffe2/core/context_gpu.h"
 #include "caffe2/utils/math.h"
+#include "caffe2/utils/math_utils.h"
 
 namespace caffe2 {
 
 namespace {
+
+template <typename T>
+using BlockReduce = cub::BlockReduce<T, CAFFE_CUDA_NUM_THREADS>;
+
 template <typename T>
-struct SqrTransform {
-  inline __host__ __device__ T operator()(const T v) const {
-    return v * v;
+struct WelfordReducer {
+  inline __host__ __device__ math::utils::WelfordData<T> operator()(
+      const math::utils::WelfordData<T>& a,
+      const math::utils::WelfordData<T>& b) const {
+    return math::utils::WelfordCombine(a, b);
   }
 };
 
-// X = X - Y^2
-__global__ void sqrtXMinusYSquaredKernel(
+// One block per row: every thread runs Welford's update over its strided
+// slice of the row, the block merges them, and the row is normalized while
+// it is still in L2.
+template <typename T>
+__global__ void LayerNormForwardCUDAKernel(
+    const int M,
     const int N,
-    float* x,
-    const float* y,
-    const float epsilon) {
-  CUDA_1D_KERNEL_LOOP(i, N) {
-    x[i] = sqrtf(x[i] - y[i] * y[i] + epsilon);
+    const T epsilon,
+    const T* X,
+    T* mean,
+    T* stdev,
+    T* Y) {
+  __shared__
+      typename BlockReduce<math::utils::WelfordData<T>>::TempStorage storage;
+  __shared__ T row_mean;
+  __shared__ T row_stdev;
+  for (int i = blockIdx.x; i < M; i += gridDim.x) {
+    math::utils::WelfordData<T> val{0, 0, 0};
+    for (int j = threadIdx.x; j < N; j += blockDim.x) {
+      const int index = i * N + j;
+#if __CUDA_ARCH__ >= 350
+      const T x = __ldg(X + index);
+#else
+      const T x = X[index];
+#endif
+      val.n += 1;
+      const T delta = x - val.mean;
+      val.mean += delta / val.n;
+      val.m2 += delta * (x - val.mean);
+    }
+    val = BlockReduce<math::utils::WelfordData<T>>(storage).Reduce(
+        val, WelfordReducer<T>());
+    if (threadIdx.x == 0) {
+      row_mean = val.mean;
+      row_stdev = sqrt(val.m2 / N + epsilon);
+      mean[i] = row_mean;
+      stdev[i] = row_stdev;
+    }
+    __syncthreads();
+    for (int j = threadIdx.x; j < N; j += blockDim.x) {
+      const int index = i * N + j;
+#if __CUDA_ARCH__ >= 350
+      Y[index] = (__ldg(X + index) - row_mean) / row_stdev;
+#else
+      Y[index] = (X[index] - row_mean) / row_stdev;
+#endif
+    }
+    __syncthreads();
   }
 }
 
-// out[i, j] = (X[i, j] - mu[i]) / sigma[i]
-__global__ void normalizeKernel(
-    const int row_dim,
+// With x_hat = (X - mean) / stdev,
+//   dX = (dY - mean(dY) - x_hat * mean(dY * x_hat)) / stdev
+// so a block reduces db = sum(dY) and ds = sum(dY * (X - mean)) over its row
+// before writing dX.
+template <typename T>
+__global__ void LayerNormBackwardCUDAKernel(
+    const int M,
     const int N,
-    const float* x,
-    const float* mu,
-    const float* sigma,
-    float* out) {
-  CUDA_1D_KERNEL_LOOP(i, N) {
-    out[i] = (x[i] - mu[i / row_dim]) / (sigma[i / row_dim]);
+    const T* dY,
+    const T* X,
+    const T* mean,
+    const T* stdev,
+    T* dX) {
+  __shared__ typename BlockReduce<T>::TempStorage ds_storage;
+  __shared__ typename BlockReduce<T>::TempStorage db_storage;
+  __shared__ T row_ds;
+  __shared__ T row_db;
+  for (int i = blockIdx.x; i < M; i += gridDim.x) {
+#if __CUDA_ARCH__ >= 350
+    const T u = __ldg(mean + i);
+    const T rsig = T(1) / __ldg(stdev + i);
+#else
+    const T u = mean[i];
+    const T rsig = T(1) / stdev[i];
+#endif
+    T ds_val = 0;
+    T db_val = 0;
+    for (int j = threadIdx.x; j < N; j += blockDim.x) {
+      const int index = i * N + j;
+#if __CUDA_ARCH__ >= 350
+      ds_val += __ldg(dY + index) * (__ldg(X + index) - u);
+      db_val += __ldg(dY + index);
+#else
+      ds_val += dY[index] * (X[index] - u);
+      db_val += dY[index];
+#endif
+    }
+    ds_val = BlockReduce<T>(ds_storage).Reduce(ds_val, cub::Sum());
+    db_val = BlockReduce<T>(db_storage).Reduce(db_val, cub::Sum());
+    if (threadIdx.x == 0) {
+      row_ds = ds_val;
+      row_db = db_val;
+    }
+    __syncthreads();
+    const T db_mean = row_db / N;
+    const T ds_coef = row_ds * rsig * rsig / N;
+    for (int j = threadIdx.x; j < N; j += blockDim.x) {
+      const int index = i * N + j;
+#if __CUDA_ARCH__ >= 350
+      dX[index] =
+          (__ldg(dY + index) - db_mean - (__ldg(X + index) - u) * ds_coef) *
+          rsig;
+#else
+      dX[index] = (dY[index] - db_mean - (X[index] - u) * ds_coef) * rsig;
+#endif
+    }
+    __syncthreads();
   }
 }
 
-template <typename InputIterator_t>
-void allocScratchAndReduce(
-    InputIterator_t input,
-    float* output,
-    int num_segments,
-    int* seg_indices,
-    Tensor<CUDAContext>* scratch,
-    cudaStream_t stream) {
-  size_t temp_storage_bytes;
-  cub::DeviceSegmentedReduce::Sum(
-      nullptr, // To retrieve required temporary storage size
-      temp_storage_bytes, // size_t &temp_storage_bytes
-      input, // InputIteratorT d_i
-      output, // OutputIteratorT d_out
-      num_segments, // int num_segments
-      seg_indices, // int *d_begin_offsets
-      seg_indices + 1, // int *d_end_offsets
-      stream // cudaStream_t stream=0
-      );
-  size_t temp_storage_floats = temp_storage_bytes / sizeof(float) +
-      (temp_storage_bytes % sizeof(float) ? 1 : 0);
-  scratch->Resize(vector<size_t>{temp_storage_floats});
-
-  cub::DeviceSegmentedReduce::Sum(
-      scratch->mutable_data<float>(), // To retrieve required temporary storage
-                                      // size
-      temp_storage_bytes, // size_t &temp_storage_bytes
-      input, // InputIteratorT d_i
-      output, // OutputIteratorT d_out
-      num_segments, // int num_segments
-      seg_indices, // int *d_begin_offsets
-      seg_indices + 1, // int *d_end_offsets
-      stream // cudaStream_t stream=0
-      );
-}
-
 } //  namespace
 
 template <>
@@ -98,269 +158,57 @@ bool LayerNormOp<CUDAContext>::DoRunWithType<float>() {
   mean->Resize(stats_dims);
   stdev->Resize(stats_dims);
 
-  std::vector<int> segs(left + 1);
-  std::iota(segs.begin(), segs.end(), 0);
-  std::transform(
-      segs.begin(),
-      segs.end(),
-      segs.begin(),
-      std::bind1st(std::multiplies<int>(), right));
-
-  seg_indices_.Resize(vector<size_t>{segs.size()});
-  context_.CopyBytes<CPUContext, CUDAContext>(
-      sizeof(int) * segs.size(),
-      static_cast<void*>(segs.data()),
-      static_cast<void*>(seg_indices_.mutable_data<int>()));
-
-  if (right == 1) {
-    mean->CopyFrom(input);
-    mean->Resize(stats_dims);
-    math::Set<float, CUDAContext>(
-        left, std::sqrt(epsilon_), stdev->mutable_data<float>(), &context_);
-  } else {
-    // Calculate row-wise means
-    // First stage: sum up feature vectors
-    allocScratchAndReduce(
-        input.data<float>(),
-        mean->mutable_data<float>(),
-        left,
-        seg_indices_.mutable_data<int>(),
-        &scratch_,
-        context_.cuda_stream());
-
-    // Second stage: Normalize by feature vector dim
-    math::Scale<float, CUDAContext>(
-        left,
-        1.0f / right,
-        mean->mutable_data<float>(),
-        mean->mutable_data<float>(),
-        &context_);
-
-    // Calculate row-wise standard deviation
-
-    // First stage: sum up row-wise squared values
-    SqrTransform<float> transform;
-    cub::TransformInputIterator<float, SqrTransform<float>, const float*> it(
-        input.data<float>(), transform);
-    allocScratchAndReduce(
-        it,
-        stdev->mutable_data<float>(),
-        left,
-        seg_indices_.mutable_data<int>(),
-        &scratch_,
-        context_.cuda_stream());
-
-    // Second stage: Normalize by feature vector dim
-    math::Scale<float, CUDAContext>(
-        left,
-        1.0f / right,
-        stdev->mutable_data<float>(),
-        stdev->mutable_data<float>(),
-        &context_);
-
-    // stddev = sqrt(E(x^2) - E(x)^2 + epsilon)
-    sqrtXMinusYSquaredKernel<<<
-        CAFFE_GET_BLOCKS(left),
-        CAFFE_CUDA_NUM_THREADS,
-        0,
-        context_.cuda_stream()>>>(
-        left,
-        stdev->mutable_data<float>(),
-        mean->mutable_data<float>(),
-        epsilon_);
+  if (left == 0) {
+    return true;
   }
-
-  // out[i, j] = (in[i,j] - mu[i]) / (sigma[i])
-  normalizeKernel<<<
-      CAFFE_GET_BLOCKS(left),
-      CAFFE_CUDA_NUM_THREADS,
-      0,
-      context_.cuda_stream()>>>(
-      right,
-      left * right,
-      input.data<float>(),
-      mean->data<float>(),
-      stdev->data<float>(),
-      output->mutable_data<float>());
+  LayerNormForwardCUDAKernel<float>
+      <<<std::min(left, CAFFE_MAXIMUM_NUM_BLOCKS),
+         CAFFE_CUDA_NUM_THREADS,
+         0,
+         context_.cuda_stream()>>>(
+          left,
+          right,
+          epsilon_,
+          input.data<float>(),
+          mean->mutable_data<float>(),
+          stdev->mutable_data<float>(),
+          output->mutable_data<float>());
 
   return true;
 }
 
 REGISTER_CUDA_OPERATOR(LayerNorm, LayerNormOp<CUDAContext>);
 
-namespace {
-// x : [N, D]
-// y : [N, 1]
-// z : [N, D]
-// (x - broadcast(y)) * z
-__global__ void zTimesXminusYbroadcast(
-    int N,
-    int D,
-    const float* x,
-    const float* y,
-    const float* z,
-    float* out) {
-  CUDA_1D_KERNEL_LOOP(i, N * D) {
-    out[i] = (x[i] - y[i / D]) * z[i];
-  }
-}
-
-__global__ void normalizeByNegStdev(
-    int N,
-    bool var,
-    const float* x,
-    const float* stdev,
-    float* out) {
-  if (var) {
-    CUDA_1D_KERNEL_LOOP(i, N) {
-      out[i] = (-1.0f * x[i]) / (stdev[i] * stdev[i]);
-    }
-  } else {
-    CUDA_1D_KERNEL_LOOP(i, N) {
-      out[i] = (-1.0f * x[i]) / (stdev[i]);
-    }
-  }
-}
-
-__global__ void gradientMegaKernel(
-    int N,
-    int D,
-    const float* stdev,
-    const float* X,
-    const float* dstdev,
-    const float* dmean,
-    const float* dout,
-    float* out) {
-  CUDA_1D_KERNEL_LOOP(i, N * D) {
-    out[i] = 1.0f / stdev[i / D] * dout[i] +
-        X[i] / (D * stdev[i / D]) * dstdev[i / D] + 1.0f / D * dmean[i / D];
-  }
-}
-
-#define PRINT(X, N, D) printTensor<<<1, 1, 0, context_.cuda_stream()>>>(X, N, D)
-
-} // namespace
-
 template <>
 template <>
 bool LayerNormGradientOp<CUDAContext>::DoRunWithType<float>() {
   const auto& dout = Input(0);
-  const auto& norm_outputs = Input(1);
   const auto& means = Input(2);
   const auto& stdev = Input(3);
   const auto& norm_inputs = Input(4);
   auto* ginput = Output(0);
 
   const auto canonical_axis = norm_inputs.canonical_axis_index(axis_);
-  const unsigned long left = norm_inputs.size_to_dim(canonical_axis);
-  const unsigned long right = norm_inputs.size_from_dim(canonical_axis);
+  const int left = norm_inputs.size_to_dim(canonical_axis);
+  const int right = norm_inputs.size_from_dim(canonical_axis);
 
   ginput->ResizeLike(norm_inputs);
-  std::vector<TIndex> stats_dims(
-      norm_inputs.dims().begin(), norm_inputs.dims().begin() + canonical_axis);
-  stats_dims.push_back(1);
-  dmean_.Resize(stats_dims);
-  dstdev_.Resize(stats_dims);
-  gscratch_.Resize(std::vector<size_t>{left, right});
-
-  std::vector<int> segs(left + 1);
-  std::iota(segs.begin(), segs.end(), 0);
-  std::transform(
-      segs.begin(),
-      segs.end(),
-      segs.begin(),
-      std::bind1st(std::multiplies<int>(), right));
 
-  seg_indices_.Resize(vector<size_t>{segs.size()});
-  context_.CopyBytes<CPUContext, CUDAContext>(
-      sizeof(int) * segs.size(),
-      static_cast<void*>(segs.data()),
-      static_cast<void*>(seg_indices_.mutable_data<int>()));
-
-  // Calculate gradient of the standard deviation
-  // temp1 = (x - mean) * dout
-  zTimesXminusYbroadcast<<<
-      CAFFE_GET_BLOCKS(left * right),
-      CAFFE_CUDA_NUM_THREADS,
-      0,
-      context_.cuda_stream()>>>(
-      left,
-      right,
-      norm_inputs.data<float>(),
-      means.data<float>(),
-      dout.data<float>(),
-      gscratch_.mutable_data<float>());
-
-  dstdev_.Resize(vector<size_t>{left, 1});
-  // dstdev = reduce(temp1)
-  allocScratchAndReduce(
-      gscratch_.data<float>(),
-      dstdev_.mutable_data<float>(),
-      left,
-      seg_indices_.mutable_data<int>(),
-      &scratch_,
-      context_.cuda_stream());
-  // dstdev = -dstdev / sqrt(stdev)
-  normalizeByNegStdev<<<
-      CAFFE_GET_BLOCKS(left),
-      CAFFE_CUDA_NUM_THREADS,
-      0,
-      context_.cuda_stream()>>>(
-      left,
-      true,
-      dstdev_.data<float>(),
-      stdev.data<float>(),
-      dstdev_.mutable_data<float>());
-
-  // Calculate gradient of the mean
-  // dmean = reduce(dout)
-  allocScratchAndReduce(
-      dout.data<float>(),
-      dmean_.mutable_data<float>(),
-      left,
-      seg_indices_.mutable_data<int>(),
-      &scratch_,
-      context_.cuda_stream());
-  // mean * stdev
-  math::Mul(
-      left,
-      means.data<float>(),
-      dstdev_.data<float>(),
-      gscratch_.mutable_data<float>(),
-      &context_);
-  // [\sum dout] + mean * stdev
-  math::Add(
-      left,
-      dmean_.data<float>(),
-      gscratch_.data<float>(),
-      dmean_.mutable_data<float>(),
-      &context_);
-  // -1 / std * [[\sum dout] + mean * stdev]
-  normalizeByNegStdev<<<
-      CAFFE_GET_BLOCKS(left),
-      CAFFE_CUDA_NUM_THREADS,
-      0,
-      context_.cuda_stream()>>>(
-      left,
-      false,
-      dmean_.data<float>(),
-      stdev.data<float>(),
-      dmean_.mutable_data<float>());
-
-  // Calculate gradient of input
-  gradientMegaKernel<<<
-      CAFFE_GET_BLOCKS(left),
-      CAFFE_CUDA_NUM_THREADS,
-      0,
-      context_.cuda_stream()>>>(
-      left,
-      right,
-      stdev.data<float>(),
-      norm_inputs.data<float>(),
-      dstdev_.data<float>(),
-      dmean_.data<float>(),
-      dout.data<float>(),
-      ginput->mutable_data<float>());
+  if (left == 0) {
+    return true;
+  }
+  LayerNormBackwardCUDAKernel<float>
+      <<<std::min(left, CAFFE_MAXIMUM_NUM_BLOCKS),
+         CAFFE_CUDA_NUM_THREADS,
+         0,
+         context_.cuda_stream()>>>(
+          left,
+          right,
+          dout.data<float>(),
+          norm_inputs.data<float>(),
+          means.data<float>(),
+          stdev.data<float>(),
+          ginput->mutable_data<float>());
 
   return true;
 }
@@ -27,9 +27,6 @@ class LayerNormOp : public Operator<Context> {
  protected:
   int axis_;
   float epsilon_;
-
-  Tensor<Context> scratch_;
-  Tensor<Context> seg_indices_;
 };
 
 template <class Context>
@@ -52,12 +49,6 @@ class LayerNormGradientOp : public Operator<Context> {
  protected:
   int axis_;
   float epsilon_;
-
-  Tensor<Context> scratch_;
-  Tensor<Context> gscratch_;
-  Tensor<Context> seg_indices_;
-  Tensor<Context> dstdev_;
-  Tensor<Context> dmean_;
 };
 
 } // namespace caffe2
@@ -1,4 +1,7 @@
 #pragma once
+#include <algorithm>
+#include <vector>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/perfkernels/embedding_lookup.h"
@@ -6,6 +9,14 @@
 namespace caffe2 {
 
 // A templated class that implements SparseLengths[Sum,WeightedSum,Mean].
+//
+// With the argument intra_op_parallel set, the segments are split into
+// chunks of contiguous segments with about the same total length each, and
+// the chunks are reduced on the thread pool of the workspace. Every segment
+// is still reduced by a single EmbeddingLookup call in index order, so the
+// output doesn't depend on the number of chunks or threads. Calls with too
+// few chunks to split stay on the calling thread (see
+// ThreadPool::setMinWorkSize).
 template <
     typename T, // output type
     class InputTypes, // supported input types, such as TensorTypes<float>
@@ -19,7 +30,10 @@ class CPUSparseLengthsReductionOp : public Operator<CPUContext> {
  public:
   USE_OPERATOR_FUNCTIONS(CPUContext);
   CPUSparseLengthsReductionOp(const OperatorDef& operator_def, Workspace* ws)
-      : Operator<CPUContext>(operator_def, ws) {
+      : Operator<CPUContext>(operator_def, ws),
+        intra_op_parallel_(
+            OperatorBase::GetSingleArgument<bool>("intra_op_parallel", false)),
+        ws_(ws) {
     static_assert(
         !(USE_WEIGHT & USE_MEAN), "Cannot both specify weight and mean.");
   }
@@ -76,25 +90,81 @@ class CPUSparseLengthsReductionOp : public Operator<CPUContext> {
       in_weight = weightInput.template data<T>();
     }
 
-    // delegate work to perfkernel that branches based on architecture
-    EmbeddingLookup<IndexType, InputType, T, USE_POSITIONAL_WEIGHT>(
-        D,
-        M,
+    const TIndex num_chunks = intra_op_parallel_
+        ? std::min(M, indices_size / kMinIndicesPerChunk)
+        : 1;
+    if (num_chunks <= 1) {
+      // delegate work to perfkernel that branches based on architecture
+      EmbeddingLookup<IndexType, InputType, T, USE_POSITIONAL_WEIGHT>(
+          D,
+          M,
+          indices_size,
+          N,
+          in_data,
+          indices,
+          lengths,
+          in_weight,
+          nullptr, // scale_bias is only used in SparseLengths8BitsRowwiseOp
+          USE_MEAN,
+          out_data);
+      return true;
+    }
+
+    // offsets_[m] is the position in INDICES of the first index of segment m
+    offsets_.resize(M + 1);
+    offsets_[0] = 0;
+    for (TIndex m = 0; m < M; ++m) {
+      CAFFE_ENFORCE_GE(lengths[m], 0, "LENGTHS must be non negative");
+      offsets_[m + 1] = offsets_[m] + lengths[m];
+    }
+    CAFFE_ENFORCE_EQ(
+        offsets_[M],
         indices_size,
-        N,
-        in_data,
-        indices,
-        lengths,
-        in_weight,
-        nullptr, // scale_bias field is only used in SparseLengths8BitsRowwiseOp
-        USE_MEAN,
-        out_data);
+        "Your input seems to be incorrect: the sum of lengths values should be "
+        "the size of the indices tensor, but it appears not.");
+
+    // chunk c covers the segments [segment_begin(c), segment_begin(c + 1))
+    auto segment_begin = [&](TIndex c) {
+      return std::lower_bound(
+                 offsets_.begin(),
+                 offsets_.end() - 1,
+                 c * indices_size / num_chunks) -
+          offsets_.begin();
+    };
+    ws_->GetThreadPool()->run(
+        [&](int /* unused */, size_t chunk) {
+          const TIndex c = chunk;
+          const TIndex begin = segment_begin(c);
+          const TIndex end = c + 1 < num_chunks ? segment_begin(c + 1) : M;
+          if (begin == end) {
+            return;
+          }
+          const TIndex offset = offsets_[begin];
+          EmbeddingLookup<IndexType, InputType, T, USE_POSITIONAL_WEIGHT>(
+              D,
+              end - begin,
+              offsets_[end] - offset,
+              N,
+              in_data,
+              indices + offset,
+              lengths + begin,
+              in_weight && !USE_POSITIONAL_WEIGHT ? in_weight + offset
+                                                  : in_weight,
+              nullptr,
+              USE_MEAN,
+              out_data + begin * D);
+        },
+        num_chunks);
     return true;
   }
 
   USE_VALUE_KEY_LENGTH_INPUT_FILLERS(CPUContext, DATA, INDICES, LENGTHS)
 
  private:
+  // Chunks with fewer indices than this aren't worth handing to another
+  // thread.
+  static constexpr TIndex kMinIndicesPerChunk = 256;
+
   enum {
     DATA = 0, // Data input.
     WEIGHT = 1, // Weight input used in SparseLengthsWeightedSum
@@ -103,6 +173,10 @@ class CPUSparseLengthsReductionOp : public Operator<CPUContext> {
     LENGTHS = 2 + USE_WEIGHT, // 2 in SparseLengths[Sum, Mean],
                               // 3 in SparseLengthsWeightedSum
   };
+
+  bool intra_op_parallel_;
+  Workspace* ws_;
+  std::vector<TIndex> offsets_;
 };
 
 } // namespace caffe2
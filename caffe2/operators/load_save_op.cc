@@ -159,7 +159,13 @@ print("Y:", workspace.FetchBlob("Y"))
         "source_blob_names",
         "*(type: List(string))* If set, used instead of output blob names to "
         "specify which blobs in the db shall be loaded. Must be the same "
-        "length as number of output blobs.");
+        "length as number of output blobs.")
+    .Arg(
+        "num_threads",
+        "*(type: int; default: 1)* If greater than 1, the db is read by the "
+        "operator's thread while this many workers parse the entries and copy "
+        "the chunks of the CPU tensors into the preallocated tensors "
+        "concurrently.");
 
 OPERATOR_SCHEMA(Save)
     .NumInputs(1, INT_MAX)
@@ -222,6 +228,12 @@ workspace.RunOperatorOnce(op)
     "of the workspace.")
     .Arg("db_type", "*(type: string)* Type of db to save (options: \"lmdb\", "
     "\"leveldb\", \"minidb\").")
+    .Arg(
+        "num_threads",
+        "*(type: int; default: 1)* If greater than 1, this many blobs are "
+        "serialized and written to the db concurrently. The chunks of a blob "
+        "are written as soon as they are serialized, so at most a chunk per "
+        "serializing thread is held in memory.")
     .Input(0, "X", "*(type: Tensor)* Input tensor(s).");
 
 OPERATOR_SCHEMA(Checkpoint)
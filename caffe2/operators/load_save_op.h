@@ -1,8 +1,10 @@
 #ifndef CAFFE2_OPERATORS_LOAD_SAVE_OP_H_
 #define CAFFE2_OPERATORS_LOAD_SAVE_OP_H_
 
+#include <condition_variable>
 #include <cstdio>
 #include <map>
+#include <mutex>
 #include <unordered_set>
 
 #include "caffe2/core/blob_serialization.h"
@@ -10,8 +12,10 @@
 #include "caffe2/core/db.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/types.h"
 #include "caffe2/utils/math.h"
 #include "caffe2/utils/proto_utils.h"
+#include "caffe2/utils/thread_pool.h"
 
 namespace caffe2 {
 
@@ -86,7 +90,9 @@ class LoadOp final : public Operator<Context> {
         allow_incomplete_(
             OperatorBase::GetSingleArgument<bool>("allow_incomplete", false)),
         blob_names_(
-            OperatorBase::GetRepeatedArgument<string>("source_blob_names")) {
+            OperatorBase::GetRepeatedArgument<string>("source_blob_names")),
+        num_threads_(OperatorBase::GetSingleArgument<int>("num_threads", 1)),
+        in_flight_(0) {
     if (InputSize() == 0) {
       CAFFE_ENFORCE_GT(db_type_.size(), 0, "Must specify a db type.");
       if (db_names_.empty()) {
@@ -128,6 +134,9 @@ class LoadOp final : public Operator<Context> {
         output_indices_[name] = idx++;
       }
     }
+    if (num_threads_ > 1) {
+      pool_.reset(new TaskThreadPool(num_threads_));
+    }
   }
 
   void SetCurrentDevice(BlobProto* proto);
@@ -214,17 +223,12 @@ class LoadOp final : public Operator<Context> {
         key_to_dbid_[key] = db_id;
       }
 
-      BlobProto proto;
-      CAFFE_ENFORCE(
-          proto.ParseFromString(cursor->value()), "Couldn't parse Proto");
-      if (!keep_device_) {
-        // If we are not keeping the device as the one specified in the
-        // proto, we will set the current device.
-        SetCurrentDevice(&proto);
-      }
       Blob* blob = ws_->CreateBlob(key);
-      ProcessBlob(blob, proto, blob_states, key, &loaded_blobs);
+      if (!loadValue(blob, key, cursor->value(), blob_states, &loaded_blobs)) {
+        break;
+      }
     }
+    finishLoading();
     *total_loaded_blobs += loaded_blobs;
   }
 
@@ -248,26 +252,90 @@ class LoadOp final : public Operator<Context> {
         }
 
         VLOG(2) << "Deserializing blob " << key;
-        BlobProto proto;
-        CAFFE_ENFORCE(proto.ParseFromString(cursor->value()));
-        if (!keep_device_) {
-          // If we are not keeping the device as the one specified in the
-          // proto, we will set the current device.
-          SetCurrentDevice(&proto);
-        }
         auto blobIndex = output_indices_[key];
         Blob* blob = outputs.at(blobIndex);
-        ProcessBlob(blob, proto, blob_states, key, &loaded_blobs);
+        if (!loadValue(
+                blob, key, cursor->value(), blob_states, &loaded_blobs)) {
+          break;
+        }
 
+        std::lock_guard<std::mutex> guard(state_mutex_);
         if (*total_loaded_blobs + loaded_blobs == OutputSize()) {
           break;
         }
       }
     }
 
+    finishLoading();
     *total_loaded_blobs += loaded_blobs;
   }
 
+  void parseValue(const string& value, BlobProto* proto) {
+    CAFFE_ENFORCE(proto->ParseFromString(value), "Couldn't parse Proto");
+    if (!keep_device_) {
+      // If we are not keeping the device as the one specified in the
+      // proto, we will set the current device.
+      SetCurrentDevice(proto);
+    }
+  }
+
+  // Deserializes a value of the db into the blob, inline or on the pool.
+  // At most 2 values per thread of the pool are waiting or being processed,
+  // to bound the memory used. Returns false if loading on the pool failed.
+  bool loadValue(
+      Blob* blob,
+      const string& key,
+      const string& value,
+      std::unordered_map<string, BlobState>* blob_states,
+      int* loaded_blobs) {
+    if (!pool_) {
+      BlobProto proto;
+      parseValue(value, &proto);
+      ProcessBlob(blob, proto, blob_states, key, loaded_blobs);
+      return true;
+    }
+
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    in_flight_cv_.wait(lock, [this] { return in_flight_ < 2 * num_threads_; });
+    if (!error_.empty()) {
+      // Stop reading, finishLoading throws
+      return false;
+    }
+    in_flight_++;
+    lock.unlock();
+
+    pool_->run([this, blob, key, value, blob_states, loaded_blobs] {
+      try {
+        BlobProto proto;
+        parseValue(value, &proto);
+        ProcessBlobConcurrently(blob, proto, blob_states, key, loaded_blobs);
+      } catch (const std::exception& e) {
+        std::lock_guard<std::mutex> guard(state_mutex_);
+        if (error_.empty()) {
+          error_ = MakeString("Failed to load blob ", key, ": ", e.what());
+        }
+      }
+      std::lock_guard<std::mutex> guard(state_mutex_);
+      in_flight_--;
+      in_flight_cv_.notify_all();
+    });
+    return true;
+  }
+
+  // Waits for the values being deserialized on the pool.
+  void finishLoading() {
+    if (!pool_) {
+      return;
+    }
+    pool_->waitWorkComplete();
+    std::lock_guard<std::mutex> guard(state_mutex_);
+    if (!error_.empty()) {
+      auto error = error_;
+      error_.clear();
+      CAFFE_THROW(error);
+    }
+  }
+
   string buildBlobNameFromDbKey(const string& dbKey) {
     string key = dbKey.substr(0, dbKey.find(kChunkIdSeparator));
     if (!strip_prefix_.empty()) {
@@ -281,8 +349,7 @@ class LoadOp final : public Operator<Context> {
   }
 
  private:
-  // We are tracking sizes of already read tensor parts while reading data
-  // chunks. This way we can make sure that all chunks were loaded in the end.
+  // Deserializes the proto into the blob and updates the state of the blob.
   void ProcessBlob(
       Blob* blob,
       const BlobProto& proto,
@@ -299,6 +366,59 @@ class LoadOp final : public Operator<Context> {
       blob->Reset();
     }
     blob->Deserialize(proto);
+    UpdateBlobState(proto, blob_states_ptr, key, loaded_blobs);
+  }
+
+  // Deserializes the chunks of the CPU tensors without holding state_mutex_,
+  // directly into the tensor allocated for the first chunk. Other blobs are
+  // deserialized under the lock.
+  void ProcessBlobConcurrently(
+      Blob* blob,
+      const BlobProto& proto,
+      std::unordered_map<string, BlobState>* blob_states,
+      const string& key,
+      int* loaded_blobs) {
+    if (!proto.has_tensor() || proto.has_content_num_chunks() ||
+        proto.tensor().device_detail().device_type() != CPU ||
+        proto.tensor().data_type() == TensorProto_DataType_UNDEFINED) {
+      std::lock_guard<std::mutex> guard(state_mutex_);
+      ProcessBlob(blob, proto, blob_states, key, loaded_blobs);
+      return;
+    }
+
+    const auto& tensor_proto = proto.tensor();
+    vector<TIndex> dims(tensor_proto.dims().begin(), tensor_proto.dims().end());
+    const auto& meta = DataTypeToTypeMeta(tensor_proto.data_type());
+    TensorCPU* tensor = nullptr;
+    {
+      std::lock_guard<std::mutex> guard(state_mutex_);
+      if (blob_states->count(key) == 0) {
+        // See ProcessBlob for why the blob is reset
+        blob->Reset();
+        tensor = blob->GetMutable<TensorCPU>();
+        tensor->Resize(dims);
+        tensor->raw_mutable_data(meta);
+      } else {
+        CAFFE_ENFORCE(blob->IsType<TensorCPU>(), "Must be tensor ", key);
+        tensor = blob->GetMutable<TensorCPU>();
+        CAFFE_ENFORCE(
+            tensor->dims() == dims && tensor->meta() == meta,
+            "Tensor parts have different shapes or types for tensor: ",
+            key);
+      }
+      UpdateBlobState(proto, blob_states, key, loaded_blobs);
+    }
+    TensorDeserializer<CPUContext>().DeserializeChunk(tensor_proto, tensor);
+  }
+
+  // We are tracking sizes of already read tensor parts while reading data
+  // chunks. This way we can make sure that all chunks were loaded in the end.
+  void UpdateBlobState(
+      const BlobProto& proto,
+      std::unordered_map<string, BlobState>* blob_states_ptr,
+      const string& key,
+      int* loaded_blobs) {
+    auto& blob_states = *blob_states_ptr;
     if (proto.has_content_num_chunks()) {
       if (!blob_states.count(key)) {
         blob_states[key] = BlobState(proto.content_num_chunks());
@@ -402,6 +522,15 @@ class LoadOp final : public Operator<Context> {
   std::map<string, int> output_indices_;
   std::map<string, int> key_to_dbid_;
   std::vector<std::string> blob_names_;
+
+  // Parallel loading; state_mutex_ protects the blob states, the number of
+  // loaded blobs, in_flight_ and error_ while the pool is loading.
+  int num_threads_;
+  std::unique_ptr<TaskThreadPool> pool_;
+  std::mutex state_mutex_;
+  std::condition_variable in_flight_cv_;
+  int in_flight_;
+  std::string error_;
 };
 
 template <class Context>
@@ -418,7 +547,8 @@ class SaveOp final : public Operator<Context> {
         db_name_(OperatorBase::GetSingleArgument<string>("db", "")),
         db_type_(OperatorBase::GetSingleArgument<string>("db_type", "")),
         blob_names_(
-            OperatorBase::GetRepeatedArgument<string>("blob_name_overrides")) {
+            OperatorBase::GetRepeatedArgument<string>("blob_name_overrides")),
+        num_threads_(OperatorBase::GetSingleArgument<int>("num_threads", 1)) {
     CAFFE_ENFORCE_GT(db_name_.size(), 0, "Must specify a db name.");
     CAFFE_ENFORCE_GT(db_type_.size(), 0, "Must specify a db type.");
     CAFFE_ENFORCE(
@@ -470,8 +600,31 @@ class SaveOp final : public Operator<Context> {
     };
 
     const vector<const Blob*>& inputs = OperatorBase::Inputs();
-    for (int i = 0; i < inputs.size(); ++i) {
-      inputs[i]->Serialize(blob_names_[i], acceptor);
+    if (num_threads_ <= 1) {
+      for (int i = 0; i < inputs.size(); ++i) {
+        inputs[i]->Serialize(blob_names_[i], acceptor);
+      }
+    } else {
+      // The acceptor is already called concurrently for the chunks of a
+      // tensor, so the blobs can be serialized concurrently as well
+      std::mutex error_mutex;
+      std::string error;
+      TaskThreadPool pool(std::min<size_t>(num_threads_, inputs.size()));
+      for (int i = 0; i < inputs.size(); ++i) {
+        pool.run([&, i] {
+          try {
+            inputs[i]->Serialize(blob_names_[i], acceptor);
+          } catch (const std::exception& e) {
+            std::lock_guard<std::mutex> guard(error_mutex);
+            if (error.empty()) {
+              error = MakeString(
+                  "Failed to save blob ", blob_names_[i], ": ", e.what());
+            }
+          }
+        });
+      }
+      pool.waitWorkComplete();
+      CAFFE_ENFORCE(error.empty(), error);
     }
     out_db->Close();
     return true;
@@ -484,6 +637,7 @@ class SaveOp final : public Operator<Context> {
   string db_name_;
   string db_type_;
   std::vector<std::string> blob_names_;
+  int num_threads_;
 };
 
 template <typename... Ts>
@@ -303,9 +303,23 @@ bool LRNGradientOp<float, CPUContext>::RunOnDeviceWithOrderNHWC() {
 REGISTER_CPU_OPERATOR(LRN, LRNOp<float, CPUContext>);
 REGISTER_CPU_OPERATOR(LRNGradient, LRNGradientOp<float, CPUContext>);
 
+namespace {
+OpSchema::Cost CostInferenceForLRN(
+    const OperatorDef& def,
+    const vector<TensorShape>& in) {
+  ArgumentHelper helper(def);
+  const uint64_t size = helper.GetSingleArgument<int>("size", 0);
+  // A sum of squares over the window, then the scale and its power.
+  struct OpSchema::Cost c = PointwiseCostInference<4>(def, in);
+  c.flops += 2 * size * nElemFromDim(in[0]);
+  return c;
+}
+} // namespace
+
 OPERATOR_SCHEMA(LRN)
   .NumInputs(1)
   .NumOutputs(1, 2)
+  .CostInferenceFunction(CostInferenceForLRN)
   .SetDoc(R"DOC(
 
 `LRN` applies Local Response Normalization to an input blob. This operation performs
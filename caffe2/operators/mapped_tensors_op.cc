@@ -0,0 +1,366 @@
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "caffe2/core/blob_serialization.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+// A mapped tensor file holds an index of the tensors followed by their data,
+// each of which starts on a page boundary, so that the tensors can point
+// straight into the mapped file. The file is laid out as (native byte order):
+//
+//   uint64 magic, uint32 version, uint32 alignment, uint64 number of tensors
+//   for every tensor: uint64 name size, name, int32 TensorProto::DataType,
+//                     uint32 ndim, int64 dims[ndim], uint64 offset,
+//                     uint64 nbytes
+//   the data of every tensor at its offset, a multiple of the alignment
+
+namespace {
+
+constexpr uint64_t kMappedTensorsMagic = 0x444550504d324343ULL; // "CC2MPPED"
+constexpr uint32_t kMappedTensorsVersion = 1;
+constexpr uint64_t kMappedTensorsAlignment = 4096;
+
+uint64_t AlignOffset(uint64_t offset) {
+  return (offset + kMappedTensorsAlignment - 1) / kMappedTensorsAlignment *
+      kMappedTensorsAlignment;
+}
+
+template <typename T>
+void WriteValue(std::ostream& stream, const T& value) {
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void PadTo(std::ostream& stream, uint64_t* position, uint64_t offset) {
+  static const std::vector<char> zeros(kMappedTensorsAlignment, 0);
+  stream.write(zeros.data(), offset - *position);
+  *position = offset;
+}
+
+// The mapping of a mapped tensor file, kept alive by the tensors that point
+// into it. The mapping is private, so writes to the tensors stay in memory.
+class MappedTensorFile {
+ public:
+  explicit MappedTensorFile(const string& path) {
+#ifdef _WIN32
+    CAFFE_THROW("Mapped tensor files are not supported on Windows.");
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    CAFFE_ENFORCE_NE(fd, -1, "Cannot open file: ", path);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd);
+      CAFFE_THROW("Not a mapped tensor file: ", path);
+    }
+    size_ = st.st_size;
+    void* data =
+        mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    // The mapping stays valid after the file is closed.
+    close(fd);
+    CAFFE_ENFORCE(data != MAP_FAILED, "Cannot mmap file: ", path);
+    data_ = static_cast<char*>(data);
+#endif
+  }
+
+  ~MappedTensorFile() {
+#ifndef _WIN32
+    munmap(data_, size_);
+#endif
+  }
+
+  char* data() const {
+    return data_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  char* data_ = nullptr;
+  size_t size_ = 0;
+
+  DISABLE_COPY_AND_ASSIGN(MappedTensorFile);
+};
+
+// Reads the index of a mapped tensor file, checking every field against the
+// size of the file.
+class MappedTensorIndexReader {
+ public:
+  MappedTensorIndexReader(const MappedTensorFile& file, const string& path)
+      : file_(file), path_(path) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    // The fields may not be aligned for T.
+    memcpy(&value, Take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  string ReadString(uint64_t size) {
+    return string(Take(size), size);
+  }
+
+ private:
+  const char* Take(uint64_t size) {
+    CAFFE_ENFORCE_LE(
+        size,
+        file_.size() - position_,
+        "Truncated mapped tensor file: ",
+        path_);
+    const char* ptr = file_.data() + position_;
+    position_ += size;
+    return ptr;
+  }
+
+  const MappedTensorFile& file_;
+  const string& path_;
+  uint64_t position_ = 0;
+};
+
+string MappedTensorsPath(const OperatorBase& op, Workspace* ws) {
+  const auto path = op.GetSingleArgument<string>("path", "");
+  CAFFE_ENFORCE(!path.empty(), "Must specify the path of the file.");
+  return op.GetSingleArgument<int>("absolute_path", false)
+      ? path
+      : ws->RootFolder() + "/" + path;
+}
+
+} // namespace
+
+class SaveMappedOp final : public Operator<CPUContext> {
+ public:
+  SaveMappedOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        path_(MappedTensorsPath(*this, ws)),
+        blob_names_(
+            OperatorBase::GetRepeatedArgument<string>("blob_name_overrides")) {
+    if (blob_names_.empty()) {
+      blob_names_.assign(
+          operator_def.input().begin(), operator_def.input().end());
+    }
+    CAFFE_ENFORCE_EQ(
+        blob_names_.size(),
+        InputSize(),
+        "Number of blob_name_overrides must match the number of inputs.");
+  }
+
+  bool RunOnDevice() override {
+    uint64_t index_end = sizeof(uint64_t) + 2 * sizeof(uint32_t) +
+        sizeof(uint64_t);
+    std::vector<uint64_t> offsets;
+    for (int i = 0; i < InputSize(); ++i) {
+      const auto& tensor = Input(i);
+      CAFFE_ENFORCE(
+          detail::CanSerializeAsBytes(TypeMetaToDataType(tensor.meta())),
+          "Blob ",
+          blob_names_[i],
+          " is not a tensor of a fixed-size type: ",
+          tensor.meta().name());
+      index_end += sizeof(uint64_t) + blob_names_[i].size() +
+          sizeof(int32_t) + sizeof(uint32_t) + tensor.ndim() * sizeof(int64_t) +
+          2 * sizeof(uint64_t);
+    }
+    uint64_t offset = AlignOffset(index_end);
+    for (int i = 0; i < InputSize(); ++i) {
+      offsets.push_back(offset);
+      offset = AlignOffset(offset + Input(i).nbytes());
+    }
+
+    std::ofstream stream(path_, std::ios::binary);
+    CAFFE_ENFORCE(stream, "Cannot open file for writing: ", path_);
+    WriteValue(stream, kMappedTensorsMagic);
+    WriteValue(stream, kMappedTensorsVersion);
+    WriteValue(stream, static_cast<uint32_t>(kMappedTensorsAlignment));
+    WriteValue(stream, static_cast<uint64_t>(InputSize()));
+    for (int i = 0; i < InputSize(); ++i) {
+      const auto& tensor = Input(i);
+      WriteValue(stream, static_cast<uint64_t>(blob_names_[i].size()));
+      stream.write(blob_names_[i].data(), blob_names_[i].size());
+      WriteValue(
+          stream, static_cast<int32_t>(TypeMetaToDataType(tensor.meta())));
+      WriteValue(stream, static_cast<uint32_t>(tensor.ndim()));
+      for (auto d : tensor.dims()) {
+        WriteValue(stream, static_cast<int64_t>(d));
+      }
+      WriteValue(stream, offsets[i]);
+      WriteValue(stream, static_cast<uint64_t>(tensor.nbytes()));
+    }
+    uint64_t position = index_end;
+    for (int i = 0; i < InputSize(); ++i) {
+      const auto& tensor = Input(i);
+      PadTo(stream, &position, offsets[i]);
+      stream.write(
+          static_cast<const char*>(tensor.raw_data()), tensor.nbytes());
+      position += tensor.nbytes();
+    }
+    // Pads the end as well, so that the offsets of empty tensors are never
+    // past the end of the file.
+    PadTo(stream, &position, offset);
+    stream.flush();
+    CAFFE_ENFORCE(stream, "Error writing file: ", path_);
+    return true;
+  }
+
+ private:
+  string path_;
+  std::vector<string> blob_names_;
+};
+
+class LoadMappedOp final : public Operator<CPUContext> {
+ public:
+  LoadMappedOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        ws_(ws),
+        path_(MappedTensorsPath(*this, ws)),
+        load_all_(OperatorBase::GetSingleArgument<int>("load_all", 0)) {
+    CAFFE_ENFORCE(
+        !load_all_ || OutputSize() == 0,
+        "Cannot specify outputs with load_all.");
+    for (int i = 0; i < OutputSize(); ++i) {
+      output_indices_[operator_def.output(i)] = i;
+    }
+  }
+
+  bool RunOnDevice() override {
+    auto file = std::make_shared<MappedTensorFile>(path_);
+    MappedTensorIndexReader reader(*file, path_);
+    CAFFE_ENFORCE_EQ(
+        reader.Read<uint64_t>(),
+        kMappedTensorsMagic,
+        "Not a mapped tensor file: ",
+        path_);
+    const auto version = reader.Read<uint32_t>();
+    CAFFE_ENFORCE_EQ(
+        version,
+        kMappedTensorsVersion,
+        "Unsupported mapped tensor file version");
+    reader.Read<uint32_t>(); // the alignment, only needed by the writer
+    const auto num_tensors = reader.Read<uint64_t>();
+
+    std::vector<bool> loaded(OutputSize(), false);
+    for (uint64_t i = 0; i < num_tensors; ++i) {
+      const auto name = reader.ReadString(reader.Read<uint64_t>());
+      const auto data_type =
+          static_cast<TensorProto::DataType>(reader.Read<int32_t>());
+      const auto ndim = reader.Read<uint32_t>();
+      std::vector<TIndex> dims;
+      for (uint32_t d = 0; d < ndim; ++d) {
+        dims.push_back(reader.Read<int64_t>());
+      }
+      const auto offset = reader.Read<uint64_t>();
+      const auto nbytes = reader.Read<uint64_t>();
+
+      Blob* blob = nullptr;
+      if (load_all_) {
+        blob = ws_->CreateBlob(name);
+      } else {
+        auto it = output_indices_.find(name);
+        if (it == output_indices_.end()) {
+          continue;
+        }
+        CAFFE_ENFORCE(!loaded[it->second], "Blob duplicated in file: ", name);
+        loaded[it->second] = true;
+        blob = OperatorBase::Outputs()[it->second];
+      }
+
+      CAFFE_ENFORCE(
+          detail::CanSerializeAsBytes(data_type),
+          "Unsupported type of blob ",
+          name);
+      const auto& meta = DataTypeToTypeMeta(data_type);
+      CAFFE_ENFORCE(
+          offset <= file->size() && nbytes <= file->size() - offset,
+          "Data of blob ",
+          name,
+          " is out of the bounds of the file");
+      auto* tensor = blob->GetMutable<TensorCPU>();
+      tensor->Resize(dims);
+      CAFFE_ENFORCE_EQ(
+          tensor->size() * meta.itemsize(),
+          nbytes,
+          "Size of blob ",
+          name,
+          " doesn't match its shape");
+      // Each tensor holds a reference to the mapping, which is unmapped once
+      // the last of them goes away.
+      tensor->ShareExternalPointer(
+          file->data() + offset, meta, nbytes, [file](void*) {});
+    }
+
+    for (int i = 0; i < OutputSize(); ++i) {
+      CAFFE_ENFORCE(
+          loaded[i], "Blob not found in ", path_, ": ", debug_def().output(i));
+    }
+    return true;
+  }
+
+ private:
+  Workspace* ws_;
+  string path_;
+  bool load_all_;
+  std::unordered_map<string, int> output_indices_;
+};
+
+REGISTER_CPU_OPERATOR(SaveMapped, SaveMappedOp);
+REGISTER_CPU_OPERATOR(LoadMapped, LoadMappedOp);
+
+OPERATOR_SCHEMA(SaveMapped)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(0)
+    .SetDoc(R"DOC(
+Saves the input CPU tensors to a mapped tensor file, which LoadMapped maps
+into memory instead of deserializing it. The file holds an index of the
+tensors followed by their raw data, each starting on a page boundary. Only
+tensors of fixed-size types can be saved.
+)DOC")
+    .Arg("path", "(string) path of the file")
+    .Arg(
+        "absolute_path",
+        "(int, default 0) if set, use the path as is instead of relative to "
+        "the root folder of the workspace")
+    .Arg(
+        "blob_name_overrides",
+        "(list of strings) names to save the inputs under, instead of the "
+        "names of the input blobs");
+
+OPERATOR_SCHEMA(LoadMapped)
+    .NumInputs(0)
+    .NumOutputs(0, INT_MAX)
+    .SetDoc(R"DOC(
+Maps a file written by SaveMapped into memory, and makes the output tensors
+point into the mapping without copying their data. Only the index of the file
+is read; the data is paged in on demand when the tensors are first accessed,
+so a predictor whose init net loads its weights with LoadMapped starts in time
+proportional to the number of weights rather than their size.
+
+The mapping is private, so writes to the tensors never reach the file, and it
+is unmapped once the last tensor pointing into it is freed or resized.
+)DOC")
+    .Arg("path", "(string) path of the file")
+    .Arg(
+        "absolute_path",
+        "(int, default 0) if set, use the path as is instead of relative to "
+        "the root folder of the workspace")
+    .Arg(
+        "load_all",
+        "(int, default 0) load all the tensors of the file into blobs of the "
+        "same names, instead of only the outputs");
+
+NO_GRADIENT(SaveMapped);
+NO_GRADIENT(LoadMapped);
+
+} // namespace caffe2
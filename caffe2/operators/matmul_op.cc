@@ -4,9 +4,43 @@ namespace caffe2 {
 
 REGISTER_CPU_OPERATOR(MatMul, MatMulOp<float, CPUContext>);
 
+namespace {
+OpSchema::Cost CostInferenceForMatMul(
+    const OperatorDef& def,
+    const vector<TensorShape>& in) {
+  CAFFE_ENFORCE_GE(in.size(), 2, "MatMul requires two inputs");
+  struct OpSchema::Cost c;
+  ArgumentHelper helper(def);
+  const auto& A = in[0];
+  const auto& B = in[1];
+  const int axis_a = helper.GetSingleArgument<int>("axis_a", 1);
+  const int axis_b = helper.GetSingleArgument<int>("axis_b", 1);
+  const int canonical_axis_a = canonical_axis_index_(axis_a, A.dims().size());
+  const int canonical_axis_b = canonical_axis_index_(axis_b, B.dims().size());
+
+  uint64_t M = size_to_dim_(canonical_axis_a, GetDimsVector(A));
+  uint64_t K = size_from_dim_(canonical_axis_a, GetDimsVector(A));
+  if (helper.GetSingleArgument<bool>("trans_a", false)) {
+    std::swap(M, K);
+  }
+  uint64_t N = size_from_dim_(canonical_axis_b, GetDimsVector(B));
+  if (helper.GetSingleArgument<bool>("trans_b", false)) {
+    N = size_to_dim_(canonical_axis_b, GetDimsVector(B));
+  }
+
+  c.flops = 2 * M * N * K;
+  c.bytes_read = (nElemFromDim(A) + nElemFromDim(B)) * sizeof(A.data_type());
+  c.bytes_written = M * N * sizeof(A.data_type());
+  c.params_bytes = 0;
+  return c;
+}
+} // namespace
+
 OPERATOR_SCHEMA(MatMul)
     .NumInputs(2, 3)
     .NumOutputs(1)
+    .CostInferenceFunction(
+        OpSchema::CostInferenceFunctionType(CostInferenceForMatMul))
     .TensorInferenceFunction([](const OperatorDef& def,
                                 const vector<TensorShape>& in) {
       vector<TensorShape> out(1);
@@ -8,6 +8,7 @@ REGISTER_CPU_OPERATOR(MeanGradient, MeanGradientOp<CPUContext>);
 OPERATOR_SCHEMA(Mean)
     .NumInputs(1, INT_MAX)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .IdenticalTypeAndShapeOfInput(0)
     .AllowInplace({{0, 0}})
     .SetDoc(R"DOC(
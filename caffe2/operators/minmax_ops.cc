@@ -9,6 +9,7 @@ REGISTER_CPU_OPERATOR(Min, MinOp<float, CPUContext>);
 OPERATOR_SCHEMA(Max)
     .NumInputs(1, INT_MAX)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .IdenticalTypeAndShapeOfInput(0)
     .AllowInplace({{0, 0}})
     .SetDoc(R"DOC(
@@ -81,6 +82,7 @@ Max:
 OPERATOR_SCHEMA(Min)
     .NumInputs(1, INT_MAX)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .IdenticalTypeAndShapeOfInput(0)
     .AllowInplace({{0, 0}})
     .SetDoc(R"DOC(
@@ -1,5 +1,7 @@
 #include "caffe2/operators/onnxifi_op.h"
 
+#include <algorithm>
+
 namespace caffe2 {
 
 namespace {
@@ -40,8 +42,134 @@ void BlobToTensorDescriptor(
   shapes->emplace_back(shape.cbegin(), shape.cend());
   desc->shape = shapes->back().data();
 }
+
+// Points the descriptor to the float tensor, and returns whether it changed
+bool SetTensorDescriptor(
+    const std::vector<TIndex>& dims,
+    const float* data,
+    onnxTensorDescriptor* desc,
+    std::vector<uint64_t>* shape) {
+  const auto buffer = reinterpret_cast<onnxPointer>(data);
+  if (desc->buffer == buffer && shape->size() == dims.size() &&
+      std::equal(dims.cbegin(), dims.cend(), shape->cbegin())) {
+    return false;
+  }
+  desc->dataType = ONNXIFI_DATATYPE_FLOAT32;
+  desc->memoryType = ONNXIFI_MEMORY_TYPE_CPU;
+  desc->dimensions = dims.size();
+  shape->assign(dims.cbegin(), dims.cend());
+  desc->shape = shape->data();
+  desc->buffer = buffer;
+  return true;
+}
+
+std::mutex& OnnxifiMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
 } // namespace
 
+std::shared_ptr<OnnxifiBackend> OnnxifiBackend::Get(
+    onnxifi_library* lib,
+    const std::vector<uint64_t>& property_list) {
+  static std::weak_ptr<OnnxifiBackend> cached;
+  std::lock_guard<std::mutex> lock(OnnxifiMutex());
+  auto backend = cached.lock();
+  if (backend) {
+    return backend;
+  }
+
+  backend.reset(new OnnxifiBackend(lib));
+  size_t num_backends = 0;
+  CAFFE_ENFORCE_EQ(
+      lib->onnxGetBackendIDs(nullptr, &num_backends), ONNXIFI_STATUS_FALLBACK);
+  CAFFE_ENFORCE_GT(
+      num_backends, 0, "At least 1 onnxifi backend should be available");
+  backend->backend_ids_.resize(num_backends);
+  CAFFE_ENFORCE_EQ(
+      lib->onnxGetBackendIDs(backend->backend_ids_.data(), &num_backends),
+      ONNXIFI_STATUS_SUCCESS);
+  backend->backend_ids_.resize(num_backends);
+
+  // TODO: choose backend id
+  CAFFE_ENFORCE_EQ(
+      lib->onnxInitBackend(
+          backend->backend_ids_[0], property_list.data(), &backend->backend_),
+      ONNXIFI_STATUS_SUCCESS);
+  cached = backend;
+  return backend;
+}
+
+OnnxifiBackend::~OnnxifiBackend() {
+  if (backend_) {
+    if (lib_->onnxReleaseBackend(backend_) != ONNXIFI_STATUS_SUCCESS) {
+      LOG(ERROR) << "Error when calling onnxReleaseBackend";
+    }
+    backend_ = nullptr;
+  }
+  for (const auto id : backend_ids_) {
+    if (lib_->onnxReleaseBackendID(id) != ONNXIFI_STATUS_SUCCESS) {
+      LOG(ERROR) << "Error when calling onnxReleaseBackendID";
+    }
+  }
+}
+
+std::shared_ptr<OnnxifiGraph> OnnxifiGraph::Get(
+    onnxifi_library* lib,
+    std::shared_ptr<OnnxifiBackend> backend,
+    const std::string& model_id,
+    const std::function<onnxGraph(onnxBackend)>& init_graph) {
+  static std::unordered_map<std::string, std::weak_ptr<OnnxifiGraph>> cached;
+  std::unique_lock<std::mutex> lock(OnnxifiMutex(), std::defer_lock);
+  if (!model_id.empty()) {
+    lock.lock();
+    auto graph = cached[model_id].lock();
+    if (graph) {
+      CAFFE_ENFORCE(
+          graph->backend_ == backend,
+          "Onnxifi ops of model_id ",
+          model_id,
+          " must run on the same backend");
+      return graph;
+    }
+  }
+  std::shared_ptr<OnnxifiGraph> graph(
+      new OnnxifiGraph(lib, backend, init_graph(backend->backend())));
+  if (!model_id.empty()) {
+    cached[model_id] = graph;
+  }
+  return graph;
+}
+
+OnnxifiGraph::~OnnxifiGraph() {
+  if (graph_) {
+    if (lib_->onnxReleaseGraph(graph_) != ONNXIFI_STATUS_SUCCESS) {
+      LOG(ERROR) << "Error when calling onnxReleaseGraph";
+    }
+    graph_ = nullptr;
+  }
+}
+
+bool OnnxifiGraph::Acquire(const void* user) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return !busy_; });
+  busy_ = true;
+  const bool rebind = user_ != user;
+  user_ = user;
+  return rebind;
+}
+
+void OnnxifiGraph::Release(bool bound) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    busy_ = false;
+    if (!bound) {
+      user_ = nullptr;
+    }
+  }
+  cv_.notify_one();
+}
+
 template <>
 std::vector<onnxTensorDescriptor>
 OnnxifiOp<float, CPUContext>::BuildInitializationList(
@@ -69,17 +197,17 @@ OnnxifiOp<float, CPUContext>::BuildInitializationList(
 
 template <>
 bool OnnxifiOp<float, CPUContext>::RunOnDevice() {
+  // The IO stays bound to the graph, so that the backend only needs it again
+  // when the tensors move or are reshaped
+  WaitPrevious();
+  bool io_changed = false;
   for (unsigned i = 0U; i < InputSize(); ++i) {
     const auto& input_tensor = Input(i);
-    const auto& tensor_dims = input_tensor.dims();
-    auto& tensor_descriptor = input_desc_.at(i);
-    tensor_descriptor.dataType = ONNXIFI_DATATYPE_FLOAT32;
-    tensor_descriptor.memoryType = ONNXIFI_MEMORY_TYPE_CPU;
-    tensor_descriptor.dimensions = tensor_dims.size();
-    input_shapes_.emplace_back(tensor_dims.cbegin(), tensor_dims.cend());
-    tensor_descriptor.shape = input_shapes_.back().data();
-    tensor_descriptor.buffer =
-        reinterpret_cast<onnxPointer>(input_tensor.data<float>());
+    io_changed |= SetTensorDescriptor(
+        input_tensor.dims(),
+        input_tensor.data<float>(),
+        &input_desc_.at(i),
+        &input_shapes_.at(i));
   }
 
   for (unsigned i = 0U; i < OutputSize(); ++i) {
@@ -87,49 +215,81 @@ bool OnnxifiOp<float, CPUContext>::RunOnDevice() {
     std::vector<TIndex> tensor_dims;
     SetOutputShape(i, &tensor_dims);
     output_tensor->Resize(tensor_dims);
-    auto& tensor_descriptor = output_desc_.at(i);
-    tensor_descriptor.dataType = ONNXIFI_DATATYPE_FLOAT32;
-    tensor_descriptor.memoryType = ONNXIFI_MEMORY_TYPE_CPU;
-    tensor_descriptor.dimensions = tensor_dims.size();
-    output_shapes_.emplace_back(tensor_dims.cbegin(), tensor_dims.cend());
-    tensor_descriptor.shape = output_shapes_.back().data();
-    tensor_descriptor.buffer =
-        reinterpret_cast<onnxPointer>(output_tensor->mutable_data<float>());
+    io_changed |= SetTensorDescriptor(
+        tensor_dims,
+        output_tensor->mutable_data<float>(),
+        &output_desc_.at(i),
+        &output_shapes_.at(i));
   }
 
-  CAFFE_ENFORCE_EQ(
-      lib_->onnxSetGraphIO(
-          graph_,
-          input_desc_.size(),
-          input_desc_.data(),
-          output_desc_.size(),
-          output_desc_.data()),
-      ONNXIFI_STATUS_SUCCESS);
-
   onnxMemoryFence input_fence;
   input_fence.type = ONNXIFI_SYNCHRONIZATION_EVENT;
-  CAFFE_ENFORCE_EQ(
-      lib_->onnxInitEvent(backend_, &input_fence.event),
-      ONNXIFI_STATUS_SUCCESS);
+  input_fence.event = nullptr;
   onnxMemoryFence output_fence;
   output_fence.type = ONNXIFI_SYNCHRONIZATION_EVENT;
+  output_fence.event = nullptr;
 
-  // Call the asycn run on backend, singal event on input fence and wait for the
-  // event on output fence
-  CAFFE_ENFORCE_EQ(
-      lib_->onnxSignalEvent(input_fence.event), ONNXIFI_STATUS_SUCCESS);
-  CAFFE_ENFORCE_EQ(
-      lib_->onnxRunGraph(graph_, &input_fence, &output_fence),
-      ONNXIFI_STATUS_SUCCESS);
-  CAFFE_ENFORCE_EQ(
-      lib_->onnxWaitEvent(output_fence.event), ONNXIFI_STATUS_SUCCESS);
-
-  // Destroy the event objects
-  CAFFE_ENFORCE_EQ(
-      lib_->onnxReleaseEvent(input_fence.event), ONNXIFI_STATUS_SUCCESS);
-  CAFFE_ENFORCE_EQ(
-      lib_->onnxReleaseEvent(output_fence.event), ONNXIFI_STATUS_SUCCESS);
+  // Call the async run on backend and signal event on input fence
+  const bool rebind = graph_->Acquire(this);
+  bool bound = !io_changed && !rebind;
+  try {
+    if (!bound) {
+      CAFFE_ENFORCE_EQ(
+          lib_->onnxSetGraphIO(
+              graph_->graph(),
+              input_desc_.size(),
+              input_desc_.data(),
+              output_desc_.size(),
+              output_desc_.data()),
+          ONNXIFI_STATUS_SUCCESS);
+      bound = true;
+    }
+    CAFFE_ENFORCE_EQ(
+        lib_->onnxInitEvent(graph_->backend(), &input_fence.event),
+        ONNXIFI_STATUS_SUCCESS);
+    CAFFE_ENFORCE_EQ(
+        lib_->onnxSignalEvent(input_fence.event), ONNXIFI_STATUS_SUCCESS);
+    CAFFE_ENFORCE_EQ(
+        lib_->onnxRunGraph(graph_->graph(), &input_fence, &output_fence),
+        ONNXIFI_STATUS_SUCCESS);
+  } catch (...) {
+    if (input_fence.event) {
+      lib_->onnxReleaseEvent(input_fence.event);
+    }
+    graph_->Release(bound);
+    throw;
+  }
 
+  // Wait for the event on output fence, and destroy the event objects
+  auto wait = [this, input_fence, output_fence]() {
+    const auto status = lib_->onnxWaitEvent(output_fence.event);
+    if (lib_->onnxReleaseEvent(input_fence.event) != ONNXIFI_STATUS_SUCCESS ||
+        lib_->onnxReleaseEvent(output_fence.event) != ONNXIFI_STATUS_SUCCESS) {
+      LOG(ERROR) << "Error when calling onnxReleaseEvent";
+    }
+    graph_->Release();
+    CAFFE_ENFORCE_EQ(
+        status, ONNXIFI_STATUS_SUCCESS, "Error running the Onnxifi graph");
+  };
+  // Without an event (e.g. in the middle of a chain of operators), nobody
+  // would wait for the output fence, so it is waited for inline
+  if (!async_ || IsEventDisabled()) {
+    wait();
+    return true;
+  }
+  worker_->run([this, wait] {
+    std::string err_msg;
+    try {
+      wait();
+    } catch (const std::exception& e) {
+      err_msg = e.what();
+    }
+    try {
+      SetEventFinished(err_msg.empty() ? nullptr : err_msg.c_str());
+    } catch (const EnforceNotMet&) {
+      // The event was already set finished, e.g. cancelled by the net
+    }
+  });
   return true;
 }
 
@@ -145,5 +305,15 @@ OPERATOR_SCHEMA(Onnxifi)
         "(string default=\"\") Serialized ONNX model to be converted to backend representation")
     .Arg(
         "initializers",
-        "Initialization pair indicating the mapping of the name between NetDef and ONNX model");
+        "Initialization pair indicating the mapping of the name between NetDef and ONNX model")
+    .Arg(
+        "model_id",
+        "(string default=\"\") ops of the same model_id share the backend "
+        "graph and the weights uploaded to it, e.g. in the nets of several "
+        "threads")
+    .Arg(
+        "async",
+        "(bool default false) complete through the op event when the backend "
+        "signals the output fence; only async nets (e.g. async_scheduling) "
+        "wait for it");
 } // namespace caffe2
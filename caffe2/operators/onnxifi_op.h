@@ -1,5 +1,9 @@
 #pragma once
 
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 
 #include "onnx/onnx_pb.h"
@@ -9,15 +13,86 @@
 #include "caffe2/core/operator.h"
 #include "caffe2/onnx/onnxifi_init.h"
 #include "caffe2/utils/string_utils.h"
+#include "caffe2/utils/thread_pool.h"
 
 namespace caffe2 {
 
+// The first backend of the ONNXIFI library, initialized once for all the
+// Onnxifi ops (with the properties of the first one) and released with the
+// last one
+class OnnxifiBackend {
+ public:
+  static std::shared_ptr<OnnxifiBackend> Get(
+      onnxifi_library* lib,
+      const std::vector<uint64_t>& property_list);
+  ~OnnxifiBackend();
+
+  onnxBackend backend() const {
+    return backend_;
+  }
+
+ private:
+  explicit OnnxifiBackend(onnxifi_library* lib) : lib_(lib) {}
+
+  onnxifi_library* lib_;
+  std::vector<onnxBackendID> backend_ids_;
+  onnxBackend backend_{nullptr};
+};
+
+// A graph of the backend. Onnxifi ops of the same model_id share the graph,
+// and so the weights uploaded to the backend, taking turns to run it: the
+// IO bound to the graph stays valid until another op binds its own.
+class OnnxifiGraph {
+ public:
+  // Returns the graph of model_id, initialized by init_graph if there is
+  // none. An empty model_id is never shared.
+  static std::shared_ptr<OnnxifiGraph> Get(
+      onnxifi_library* lib,
+      std::shared_ptr<OnnxifiBackend> backend,
+      const std::string& model_id,
+      const std::function<onnxGraph(onnxBackend)>& init_graph);
+  ~OnnxifiGraph();
+
+  onnxBackend backend() const {
+    return backend_->backend();
+  }
+
+  onnxGraph graph() const {
+    return graph_;
+  }
+
+  // Waits for the run of another op to complete, and returns whether the IO
+  // of the graph needs to be bound again for the op
+  bool Acquire(const void* user);
+  // Lets the other ops run the graph. Unless bound, the op didn't manage to
+  // bind its IO.
+  void Release(bool bound = true);
+
+ private:
+  OnnxifiGraph(
+      onnxifi_library* lib,
+      std::shared_ptr<OnnxifiBackend> backend,
+      onnxGraph graph)
+      : lib_(lib), backend_(std::move(backend)), graph_(graph) {}
+
+  onnxifi_library* lib_;
+  std::shared_ptr<OnnxifiBackend> backend_;
+  onnxGraph graph_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool busy_{false};
+  // The op whose IO is bound to the graph
+  const void* user_{nullptr};
+};
+
 template <typename T, typename Context>
 class OnnxifiOp final : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   OnnxifiOp(const OperatorDef& operator_def, Workspace* ws)
-      : Operator<Context>(operator_def, ws) {
+      : Operator<Context>(operator_def, ws),
+        async_(OperatorBase::GetSingleArgument<bool>("async", false)) {
     lib_ = onnx::initOnnxifiLibrary();
     CAFFE_ENFORCE(lib_, "Cannot initialize ONNXIFI library");
     auto onnx_model_str =
@@ -46,6 +121,8 @@ class OnnxifiOp final : public Operator<Context> {
       }
       ++output_idx;
     }
+    input_shapes_.resize(input_desc_.size());
+    output_shapes_.resize(output_desc_.size());
 
     // Encode arguments starting with "custom_" to backend
     std::vector<uint64_t> property_pointers;
@@ -53,79 +130,65 @@ class OnnxifiOp final : public Operator<Context> {
     std::vector<float> float_args;
     BuildPropertyList(operator_def, &property_pointers, &int_args, &float_args);
 
-    // Pull the weights from workspace and feed it to the backend through
-    // setGraphIO. Notice that since we may have rewritten the net, we need to
-    // map the weight names
-    auto initializers =
-        OperatorBase::GetRepeatedArgument<std::string>("initializers");
-    CAFFE_ENFORCE_EQ(
-        initializers.size() % 2, 0, "initializers should come in pairs");
-    std::unordered_set<std::string> initializer_set;
-    std::unordered_map<std::string, std::string> input_mapping;
-    for (auto it = initializers.begin(); it != initializers.end(); ++it) {
-      auto key = *it++;
-      input_mapping.emplace(key, *it);
-      initializer_set.emplace(key);
-    }
-    Workspace mapped_ws(ws, input_mapping);
-    std::vector<std::string> weight_names;
-    std::vector<std::vector<uint64_t>> weight_shapes;
-    auto weight_descs = BuildInitializationList(
-        &mapped_ws, &initializer_set, &weight_names, &weight_shapes);
-
-    ::ONNX_NAMESPACE::ModelProto onnx_model;
-    ParseProtoFromLargeString(onnx_model_str, &onnx_model);
-    onnx_model_str.clear();
-    onnx_model.SerializeToString(&onnx_model_str);
-
-    // Build the Onnxifi engine
+    // Build the Onnxifi engine, unless an op of the same model_id did
     // TODO: In spec, backends are hot-pluggable, so two calls to
     // onnxGetBackendIDs may result in different number of backend. And we
     // should retry until it get consistent. For now, we don't do that.
-    CAFFE_ENFORCE_EQ(
-        lib_->onnxGetBackendIDs(nullptr, &num_backends_),
-        ONNXIFI_STATUS_FALLBACK);
-    CAFFE_ENFORCE_GT(
-        num_backends_, 0, "At least 1 onnxifi backend should be available");
-    backend_ids_.resize(num_backends_);
-    CAFFE_ENFORCE_EQ(
-        lib_->onnxGetBackendIDs(backend_ids_.data(), &num_backends_),
-        ONNXIFI_STATUS_SUCCESS);
-
-    // TODO: choose backend id
-    CAFFE_ENFORCE_EQ(
-        lib_->onnxInitBackend(
-            backend_ids_[0], property_pointers.data(), &backend_),
-        ONNXIFI_STATUS_SUCCESS);
-    CAFFE_ENFORCE_EQ(
-        lib_->onnxInitGraph(
-            backend_,
-            onnx_model_str.size(),
-            (void*)(onnx_model_str.c_str()),
-            weight_descs.size(),
-            weight_descs.data(),
-            &graph_),
-        ONNXIFI_STATUS_SUCCESS);
+    auto backend = OnnxifiBackend::Get(lib_, property_pointers);
+    graph_ = OnnxifiGraph::Get(
+        lib_,
+        backend,
+        OperatorBase::GetSingleArgument<std::string>("model_id", ""),
+        [&](onnxBackend backend_handle) {
+          // Pull the weights from workspace and feed it to the backend
+          // through onnxInitGraph. Notice that since we may have rewritten
+          // the net, we need to map the weight names
+          auto initializers =
+              OperatorBase::GetRepeatedArgument<std::string>("initializers");
+          CAFFE_ENFORCE_EQ(
+              initializers.size() % 2, 0, "initializers should come in pairs");
+          std::unordered_set<std::string> initializer_set;
+          std::unordered_map<std::string, std::string> input_mapping;
+          for (auto it = initializers.begin(); it != initializers.end(); ++it) {
+            auto key = *it++;
+            input_mapping.emplace(key, *it);
+            initializer_set.emplace(key);
+          }
+          Workspace mapped_ws(ws, input_mapping);
+          std::vector<std::string> weight_names;
+          std::vector<std::vector<uint64_t>> weight_shapes;
+          auto weight_descs = BuildInitializationList(
+              &mapped_ws, &initializer_set, &weight_names, &weight_shapes);
+
+          ::ONNX_NAMESPACE::ModelProto onnx_model;
+          ParseProtoFromLargeString(onnx_model_str, &onnx_model);
+          onnx_model_str.clear();
+          onnx_model.SerializeToString(&onnx_model_str);
+
+          onnxGraph graph{nullptr};
+          CAFFE_ENFORCE_EQ(
+              lib_->onnxInitGraph(
+                  backend_handle,
+                  onnx_model_str.size(),
+                  (void*)(onnx_model_str.c_str()),
+                  weight_descs.size(),
+                  weight_descs.data(),
+                  &graph),
+              ONNXIFI_STATUS_SUCCESS);
+          return graph;
+        });
+
+    if (async_) {
+      worker_.reset(new TaskThreadPool(1));
+    }
   }
 
   ~OnnxifiOp() {
-    if (graph_) {
-      if (lib_->onnxReleaseGraph(graph_) != ONNXIFI_STATUS_SUCCESS) {
-        LOG(ERROR) << "Error when calling onnxReleaseGraph";
-      }
-      graph_ = nullptr;
-    }
-    if (backend_) {
-      if (lib_->onnxReleaseBackend(backend_) != ONNXIFI_STATUS_SUCCESS) {
-        LOG(ERROR) << "Error when calling onnxReleaseBackend";
-      }
-      backend_ = nullptr;
-    }
-    for (unsigned i = 0; i < num_backends_; ++i) {
-      if (lib_->onnxReleaseBackendID(backend_ids_[i]) != ONNXIFI_STATUS_SUCCESS) {
-        LOG(ERROR) << "Error when calling onnxReleaseBackendID";
-      }
-    }
+    WaitPrevious();
+  }
+
+  bool HasAsyncPart() const override {
+    return async_;
   }
 
   bool RunOnDevice() override;
@@ -146,6 +209,14 @@ class OnnxifiOp final : public Operator<Context> {
     property_list->push_back(ONNXIFI_BACKEND_PROPERTY_NONE);
   }
 
+  // Waits for the output fence of the previous run, which still uses the
+  // bound buffers
+  void WaitPrevious() {
+    if (worker_) {
+      worker_->waitWorkComplete();
+    }
+  }
+
   std::vector<onnxTensorDescriptor> BuildInitializationList(
       Workspace* ws,
       std::unordered_set<std::string>* initialization_list,
@@ -155,12 +226,15 @@ class OnnxifiOp final : public Operator<Context> {
   // pointer to loaded onnxifi library
   onnxifi_library* lib_{nullptr};
 
-  std::vector<onnxBackendID> backend_ids_;
-  onnxBackend backend_{nullptr};
-  onnxGraph graph_{nullptr};
-  size_t num_backends_{0};
+  std::shared_ptr<OnnxifiGraph> graph_;
+
+  // With async, the op completes through its event once the output fence of
+  // the backend is signalled, waited for by worker_
+  const bool async_;
+  std::unique_ptr<TaskThreadPool> worker_;
 
-  // input/output descriptors
+  // input/output descriptors, bound to the graph until the tensors move or
+  // are reshaped
   std::vector<onnxTensorDescriptor> input_desc_;
   std::vector<onnxTensorDescriptor> output_desc_;
   std::vector<std::vector<uint64_t>> input_shapes_;
@@ -5,6 +5,8 @@
 #include "caffe2/core/context.h"
 #include "caffe2/core/context_gpu.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/timer.h"
 #include "caffe2/proto/caffe2.pb.h"
 
 namespace caffe2 {
@@ -35,13 +37,20 @@ namespace caffe2 {
  * the CPU, you can do
  *     REGISTER_CUDA_OPERATOR(MyMagic,
  *                            GPUFallbackOp<MyMagicOp, SkipIndices<0>>);
+ *
+ * Every run is counted in the exported stats gpu_fallback/<operator type>:
+ * the bytes copied to and from the CPU and the host time spent copying them,
+ * waiting for the inputs included, and running the CPU operator. Use
+ * workspace.GetGPUFallbackReport() to find the operators worth a CUDA
+ * implementation.
  */
 template <class CPUOp, typename SkipOutputCopy = SkipIndices<>>
 class GPUFallbackOp final : public Operator<CUDAContext> {
  public:
   USE_OPERATOR_FUNCTIONS(CUDAContext);
   GPUFallbackOp(const OperatorDef& def, Workspace* ws)
-      : Operator<CUDAContext>(def, ws) {
+      : Operator<CUDAContext>(def, ws),
+        stats_("gpu_fallback/" + def.type()) {
     CAFFE_ENFORCE_EQ(def.device_option().device_type(), CUDA);
     OperatorDef base_def_(def);
     // base_def_ runs on CPU, so we will set its device option to CPU.
@@ -60,11 +69,13 @@ class GPUFallbackOp final : public Operator<CUDAContext> {
   }
 
   bool RunOnDevice() override {
+    Timer timer;
     bool need_sync = false;
     for (int i = 0; i < InputSize(); ++i) {
       if (OperatorBase::InputIsType<TensorCUDA>(i)) {
         local_input_blobs_[i]->template GetMutable<TensorCPU>()->CopyFrom(
             Input(i), &context_);
+        CAFFE_EVENT(stats_, input_bytes, Input(i).nbytes());
         need_sync = true;
       } else {
         VLOG(1) << "Input " << i << " is not TensorCUDA. Skipping copy.";
@@ -81,12 +92,18 @@ class GPUFallbackOp final : public Operator<CUDAContext> {
     if (need_sync) {
       context_.FinishDeviceComputation();
     }
+    CAFFE_EVENT(stats_, runs);
+    CAFFE_EVENT(stats_, input_copy_time_ns, timer.NanoSeconds());
 
+    timer.Start();
     if (!base_op_->Run()) {
       LOG(ERROR) << "Base op run failed in GPUFallbackOp. Def: "
                  << ProtoDebugString(this->debug_def());
       return false;
     }
+    CAFFE_EVENT(stats_, run_time_ns, timer.NanoSeconds());
+
+    timer.Start();
     for (int i = 0; i < OutputSize(); ++i) {
       if (SkipOutputCopy::Contains(i)) {
         VLOG(1) << "Copy output: index " << i << " skipped.";
@@ -98,11 +115,23 @@ class GPUFallbackOp final : public Operator<CUDAContext> {
           "output type who needs copying.");
       Output(i)->CopyFrom(
           local_output_blobs_[i]->template Get<TensorCPU>(), &context_);
+      CAFFE_EVENT(stats_, output_bytes, Output(i)->nbytes());
     }
+    CAFFE_EVENT(stats_, output_copy_time_ns, timer.NanoSeconds());
     return true;
   }
 
  protected:
+  struct GPUFallbackStats {
+    CAFFE_STAT_CTOR(GPUFallbackStats);
+    CAFFE_EXPORTED_STAT(runs);
+    CAFFE_EXPORTED_STAT(input_bytes);
+    CAFFE_EXPORTED_STAT(input_copy_time_ns);
+    CAFFE_EXPORTED_STAT(run_time_ns);
+    CAFFE_EXPORTED_STAT(output_bytes);
+    CAFFE_EXPORTED_STAT(output_copy_time_ns);
+  } stats_;
+
   Workspace local_ws_;
   vector<Blob*> local_input_blobs_;
   vector<Blob*> local_output_blobs_;
@@ -79,4 +79,33 @@ TEST(OperatorFallbackTest, GPUIncrementByOneOp) {
   }
 }
 
+TEST(OperatorFallbackTest, GPUFallbackStats) {
+  if (!HasCudaGPU()) return;
+  OperatorDef op_def = CreateOperatorDef(
+      "IncrementByOne", "", vector<string>{"X"},
+      vector<string>{"Y"});
+  op_def.mutable_device_option()->set_device_type(CUDA);
+  Workspace ws;
+  TensorCPU source_tensor(vector<TIndex>{2, 3});
+  for (int i = 0; i < 6; ++i) {
+    source_tensor.mutable_data<float>()[i] = i;
+  }
+  ws.CreateBlob("X")->GetMutable<TensorCUDA>()->CopyFrom(source_tensor);
+  unique_ptr<OperatorBase> op(CreateOperator(op_def, &ws));
+  EXPECT_TRUE(op.get() != nullptr);
+
+  auto before = toMap(StatRegistry::get().publish());
+  EXPECT_TRUE(op->Run());
+  EXPECT_TRUE(op->Run());
+  auto after = toMap(StatRegistry::get().publish());
+  const string group = "gpu_fallback/IncrementByOne/";
+  EXPECT_EQ(after[group + "runs"] - before[group + "runs"], 2);
+  EXPECT_EQ(
+      after[group + "input_bytes"] - before[group + "input_bytes"],
+      static_cast<int64_t>(2 * 6 * sizeof(float)));
+  EXPECT_EQ(
+      after[group + "output_bytes"] - before[group + "output_bytes"],
+      static_cast<int64_t>(2 * 6 * sizeof(float)));
+}
+
 }  // namespace caffe2
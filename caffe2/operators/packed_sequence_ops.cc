@@ -0,0 +1,234 @@
+#include "caffe2/operators/packed_sequence_ops.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace caffe2 {
+
+namespace {
+
+// The row of the unpacked data that every row of the packed sequence holds,
+// given the lengths of the sequences in the order of the batch.
+std::vector<TIndex> PackedRows(
+    const int32_t* lengths,
+    const int32_t* sortedIndices,
+    int N,
+    const int32_t* batchSizes,
+    int T) {
+  std::vector<TIndex> offsets(N + 1, 0);
+  for (int n = 0; n < N; ++n) {
+    offsets[n + 1] = offsets[n] + lengths[n];
+  }
+  std::vector<TIndex> rows;
+  rows.reserve(offsets[N]);
+  for (int t = 0; t < T; ++t) {
+    for (int i = 0; i < batchSizes[t]; ++i) {
+      rows.push_back(offsets[sortedIndices[i]] + t);
+    }
+  }
+  return rows;
+}
+
+void CopyRows(
+    CPUContext& context,
+    const TensorCPU& from,
+    const std::vector<TIndex>& fromRows,
+    TensorCPU* to,
+    bool scatter) {
+  const auto rowSize = from.size_from_dim(1);
+  const auto rowBytes = rowSize * from.itemsize();
+  const char* src = static_cast<const char*>(from.raw_data());
+  char* dst = static_cast<char*>(to->raw_mutable_data(from.meta()));
+  for (TIndex i = 0; i < fromRows.size(); ++i) {
+    const auto srcRow = scatter ? i : fromRows[i];
+    const auto dstRow = scatter ? fromRows[i] : i;
+    context.CopyItems<CPUContext, CPUContext>(
+        from.meta(), rowSize, src + srcRow * rowBytes, dst + dstRow * rowBytes);
+  }
+}
+
+} // namespace
+
+bool PackSequencesOp::RunOnDevice() {
+  const auto& lengths = Input(LENGTHS);
+  const auto& data = Input(DATA);
+  CAFFE_ENFORCE_EQ(lengths.ndim(), 1, "LENGTHS must be 1-D");
+  CAFFE_ENFORCE_GE(data.ndim(), 1, "DATA should be at least 1-D");
+  const int N = lengths.size();
+  const int32_t* lengthsData = lengths.data<int32_t>();
+  TIndex totalLength = 0;
+  for (int n = 0; n < N; ++n) {
+    CAFFE_ENFORCE_GE(lengthsData[n], 0);
+    totalLength += lengthsData[n];
+  }
+  CAFFE_ENFORCE_EQ(
+      data.dim(0),
+      totalLength,
+      "PackSequences requires the sum of the lengths to be the first data "
+      "dimension");
+
+  auto* sortedIndices = Output(SORTED_INDICES);
+  sortedIndices->Resize(N);
+  int32_t* indices = sortedIndices->mutable_data<int32_t>();
+  std::iota(indices, indices + N, 0);
+  std::stable_sort(indices, indices + N, [lengthsData](int32_t a, int32_t b) {
+    return lengthsData[a] > lengthsData[b];
+  });
+
+  const int T = N > 0 ? lengthsData[indices[0]] : 0;
+  auto* batchSizes = Output(BATCH_SIZES);
+  batchSizes->Resize(T);
+  int32_t* sizes = batchSizes->mutable_data<int32_t>();
+  int batchSize = N;
+  for (int t = 0; t < T; ++t) {
+    while (lengthsData[indices[batchSize - 1]] <= t) {
+      --batchSize;
+    }
+    sizes[t] = batchSize;
+  }
+
+  auto* packed = Output(PACKED);
+  packed->ResizeLike(data);
+  CopyRows(
+      context_,
+      data,
+      PackedRows(lengthsData, indices, N, sizes, T),
+      packed,
+      false);
+  return true;
+}
+
+bool UnpackSequencesOp::RunOnDevice() {
+  const auto& batchSizes = Input(BATCH_SIZES);
+  const auto& sortedIndices = Input(SORTED_INDICES);
+  const auto& packed = Input(PACKED);
+  CAFFE_ENFORCE_EQ(batchSizes.ndim(), 1, "BATCH_SIZES must be 1-D");
+  CAFFE_ENFORCE_EQ(sortedIndices.ndim(), 1, "SORTED_INDICES must be 1-D");
+  CAFFE_ENFORCE_GE(packed.ndim(), 1, "PACKED should be at least 1-D");
+  const int T = batchSizes.size();
+  const int N = sortedIndices.size();
+  const int32_t* sizes = batchSizes.data<int32_t>();
+  const int32_t* indices = sortedIndices.data<int32_t>();
+
+  // The i-th longest sequence runs for the steps with more than i rows.
+  std::vector<int32_t> lengths(N, -1);
+  TIndex totalLength = 0;
+  int length = T;
+  for (int i = 0; i < N; ++i) {
+    CAFFE_ENFORCE(
+        indices[i] >= 0 && indices[i] < N && lengths[indices[i]] < 0,
+        "SORTED_INDICES must be a permutation of the batch");
+    while (length > 0 && sizes[length - 1] <= i) {
+      --length;
+    }
+    lengths[indices[i]] = length;
+    totalLength += length;
+  }
+  for (int t = 0; t < T; ++t) {
+    CAFFE_ENFORCE(
+        sizes[t] > 0 && sizes[t] <= N && (t == 0 || sizes[t] <= sizes[t - 1]),
+        "The batch sizes must be positive, non-increasing and at most the "
+        "batch size");
+  }
+  CAFFE_ENFORCE_EQ(
+      packed.dim(0), totalLength, "The batch sizes must add up to PACKED");
+
+  auto* data = Output(DATA);
+  data->ResizeLike(packed);
+  CopyRows(
+      context_,
+      packed,
+      PackedRows(lengths.data(), indices, N, sizes, T),
+      data,
+      true);
+
+  if (OutputSize() > LENGTHS) {
+    auto* lengthsOutput = Output(LENGTHS);
+    lengthsOutput->Resize(N);
+    std::copy(
+        lengths.begin(), lengths.end(), lengthsOutput->mutable_data<int32_t>());
+  }
+  return true;
+}
+
+REGISTER_CPU_OPERATOR(PackSequences, PackSequencesOp);
+REGISTER_CPU_OPERATOR(UnpackSequences, UnpackSequencesOp);
+
+OPERATOR_SCHEMA(PackSequences)
+    .NumInputs(2)
+    .NumOutputs(3)
+    .SetDoc(R"DOC(
+Packs a batch of sequences of different lengths without padding them. The
+sequences are sorted by decreasing length, and the packed sequence holds the
+rows of their first step, then those of their second step, and so on, where
+step t has a row for each of the batch_sizes[t] sequences longer than t.
+
+Unlike PackSegments, no work is spent on padding downstream: FC, LayerNorm,
+Softmax and the other row-wise operators run on the packed rows as they are,
+and FusedLSTMSequence and FusedGRUSequence with packed only compute the
+sequences that are still running at every step.
+
+Example:
+  LENGTHS = [2, 3, 1]
+  DATA = [a0, a1, b0, b1, b2, c0]
+  PACKED = [b0, a0, c0, b1, a1, b2]
+  BATCH_SIZES = [3, 2, 1]
+  SORTED_INDICES = [1, 0, 2]
+)DOC")
+    .Input(0, "lengths", "int32 lengths of the N sequences")
+    .Input(
+        1,
+        "data",
+        "The rows of the sequences one after the other, sum(lengths) x ...")
+    .Output(0, "packed", "Packed rows of the sequences, sum(lengths) x ...")
+    .Output(1, "batch_sizes", "int32 numbers of rows of the steps")
+    .Output(
+        2,
+        "sorted_indices",
+        "int32 indices of the sequences in decreasing order of length");
+
+OPERATOR_SCHEMA(UnpackSequences)
+    .NumInputs(3)
+    .NumOutputs(1, 2)
+    .SetDoc(R"DOC(
+Inverse of PackSequences: puts the rows of a packed sequence back in the order
+of the sequences of the batch.
+)DOC")
+    .Input(0, "batch_sizes", "int32 numbers of rows of the steps")
+    .Input(
+        1,
+        "sorted_indices",
+        "int32 indices of the sequences in decreasing order of length")
+    .Input(2, "packed", "Packed rows of the sequences")
+    .Output(0, "data", "The rows of the sequences one after the other")
+    .Output(1, "lengths", "(optional) int32 lengths of the sequences");
+
+class GetPackSequencesGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    return SingleGradientDef(
+        "UnpackSequences",
+        "",
+        vector<string>{O(1), O(2), GO(0)},
+        vector<string>{GI(1)});
+  }
+};
+REGISTER_GRADIENT(PackSequences, GetPackSequencesGradient);
+
+class GetUnpackSequencesGradient : public GradientMakerBase {
+  using GradientMakerBase::GradientMakerBase;
+  vector<OperatorDef> GetGradientDefs() override {
+    CAFFE_ENFORCE_EQ(
+        def_.output_size(),
+        2,
+        "The gradient of UnpackSequences needs its lengths output");
+    return SingleGradientDef(
+        "PackSequences",
+        "",
+        vector<string>{O(1), GO(0)},
+        vector<string>{GI(2), GI(2) + "_batch_sizes", GI(2) + "_sorted_indices"});
+  }
+};
+REGISTER_GRADIENT(UnpackSequences, GetUnpackSequencesGradient);
+
+} // namespace caffe2
@@ -0,0 +1,42 @@
+#ifndef CAFFE2_OPERATORS_PACKED_SEQUENCE_OPS_H_
+#define CAFFE2_OPERATORS_PACKED_SEQUENCE_OPS_H_
+
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+// A packed sequence holds the steps of a batch of sequences of different
+// lengths one after the other, without padding: the sequences are sorted by
+// decreasing length and step t holds one row for each of the batch_sizes[t]
+// sequences that are longer than t. sorted_indices[i] is the index in the
+// batch of the i-th longest sequence.
+class PackSequencesOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  PackSequencesOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override;
+
+  INPUT_TAGS(LENGTHS, DATA);
+  OUTPUT_TAGS(PACKED, BATCH_SIZES, SORTED_INDICES);
+};
+
+class UnpackSequencesOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  UnpackSequencesOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override;
+
+  INPUT_TAGS(BATCH_SIZES, SORTED_INDICES, PACKED);
+  OUTPUT_TAGS(DATA, LENGTHS);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_PACKED_SEQUENCE_OPS_H_
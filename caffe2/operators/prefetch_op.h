@@ -7,6 +7,8 @@
 
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/timer.h"
 
 namespace caffe2 {
 
@@ -17,6 +19,13 @@ namespace caffe2 {
 // For any operator that is derived from PrefetchOperator, it should
 // explicitly call the Finalize() function in its destructor, so that the
 // prefetching thread is properly destructed.
+//
+// With the argument prefetch_depth set to N > 1, the prefetching thread runs
+// up to N batches ahead, into a ring of N sets of output blobs: it runs both
+// Prefetch() and CopyPrefetched() for every batch, and Run() only swaps the
+// oldest batch of the ring into the outputs. This absorbs the variance of
+// the time to prefetch a batch. Derived classes must write their outputs in
+// CopyPrefetched() through PrefetchedOutput() rather than Output().
 
 // Note: We inherit from OperatorBase since we control the
 // synchronization properties of this operator ourselves (we inform
@@ -31,7 +40,19 @@ class PrefetchOperator : public OperatorBase {
         prefetched_(false),
         prefetch_success_(true),
         finalize_(false),
-        no_prefetch_(GetSingleArgument<bool>("no_prefetch", false)) {
+        no_prefetch_(GetSingleArgument<bool>("no_prefetch", false)),
+        prefetch_depth_(GetSingleArgument<int>("prefetch_depth", 1)),
+        stats_(
+            "prefetch/" +
+            (operator_def.name().empty() ? operator_def.type()
+                                         : operator_def.name())) {
+    CAFFE_ENFORCE_GE(prefetch_depth_, 1);
+    if (prefetch_depth_ > 1) {
+      ring_.resize(prefetch_depth_);
+      for (auto& slot : ring_) {
+        slot.blobs.resize(OutputSize());
+      }
+    }
     context_.SwitchToDevice(0);
   }
 
@@ -43,7 +64,15 @@ class PrefetchOperator : public OperatorBase {
   }
 
   void Finalize() {
-    if (prefetch_thread_.get()) {
+    if (prefetch_thread_.get() && prefetch_depth_ > 1) {
+      {
+        std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
+        finalize_ = true;
+      }
+      producer_.notify_one();
+      prefetch_thread_->join();
+      prefetch_thread_.reset();
+    } else if (prefetch_thread_.get()) {
       {
         std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
         while (!prefetched_)
@@ -72,13 +101,25 @@ class PrefetchOperator : public OperatorBase {
     // instead of in the constructor, because the prefetch_thread needs to start
     // after all derived classes' constructors finish.
     if (!prefetch_thread_) {
-      prefetch_thread_.reset(
-          new std::thread([this] { this->PrefetchWorker(); }));
+      prefetch_thread_.reset(new std::thread([this] {
+        if (prefetch_depth_ > 1) {
+          this->RingPrefetchWorker();
+        } else {
+          this->PrefetchWorker();
+        }
+      }));
     }
     context_.SwitchToDevice(0);
+    if (prefetch_depth_ > 1) {
+      return RunFromRing();
+    }
     std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
-    while (!prefetched_)
-      consumer_.wait(lock);
+    if (!prefetched_) {
+      Timer waitTimer;
+      while (!prefetched_)
+        consumer_.wait(lock);
+      CAFFE_EVENT(stats_, consumer_wait_time_ns, waitTimer.NanoSeconds());
+    }
     if (!prefetch_success_) {
       LOG(ERROR) << "Prefetching failed.";
       return false;
@@ -118,10 +159,81 @@ class PrefetchOperator : public OperatorBase {
   }
 
   // You will need to implement this instead of the Run function.
+  // With prefetch_depth_ > 1: fills the ring of batches, as far ahead as it
+  // has free slots.
+  void RingPrefetchWorker() {
+    context_.SwitchToDevice();
+    std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
+    while (true) {
+      while (!finalize_ && ring_filled_ == prefetch_depth_)
+        producer_.wait(lock);
+      if (finalize_) {
+        break;
+      }
+      RingSlot& slot = ring_[(ring_head_ + ring_filled_) % prefetch_depth_];
+      lock.unlock();
+      bool success = false;
+      try {
+        success = Prefetch();
+        if (success) {
+          copy_target_ = &slot.blobs;
+          success = CopyPrefetched();
+          copy_target_ = nullptr;
+        }
+        context_.FinishDeviceComputation();
+      } catch (const std::exception& e) {
+        LOG(ERROR) << "Prefetching error " << e.what();
+        copy_target_ = nullptr;
+        success = false;
+      }
+      lock.lock();
+      slot.success = success;
+      ++ring_filled_;
+      consumer_.notify_one();
+    }
+  }
+
+  bool RunFromRing() {
+    std::unique_lock<std::mutex> lock(prefetch_access_mutex_);
+    if (ring_filled_ == 0) {
+      Timer waitTimer;
+      while (ring_filled_ == 0)
+        consumer_.wait(lock);
+      CAFFE_EVENT(stats_, consumer_wait_time_ns, waitTimer.NanoSeconds());
+    }
+    CAFFE_EVENT(stats_, prefetched_batches, ring_filled_);
+    RingSlot& slot = ring_[ring_head_];
+    if (!slot.success) {
+      LOG(ERROR) << "Prefetching failed.";
+      return false;
+    }
+    // The batch was synchronized by the prefetching thread, and the previous
+    // contents of the outputs were consumed by the previous run of the net,
+    // so they can be handed back to the prefetching thread to be refilled.
+    for (int i = 0; i < OutputSize(); ++i) {
+      Outputs()[i]->swap(slot.blobs[i]);
+    }
+    ring_head_ = (ring_head_ + 1) % prefetch_depth_;
+    --ring_filled_;
+    producer_.notify_one();
+    return true;
+  }
+
   virtual bool Prefetch() = 0;
   virtual bool CopyPrefetched() = 0;
 
  protected:
+  // Returns output idx of the batch being copied by CopyPrefetched(): the
+  // output blob of the operator, or with prefetch_depth_ > 1, the blob of
+  // the slot of the ring that the prefetching thread fills.
+  template <typename T>
+  T* PrefetchedOutput(int idx) {
+    if (copy_target_) {
+      return (*copy_target_)[idx].template GetMutable<T>();
+    }
+    return Output<T>(idx);
+  }
+
   Context context_;
   std::mutex prefetch_access_mutex_;
   std::condition_variable producer_, consumer_;
@@ -135,6 +247,28 @@ class PrefetchOperator : public OperatorBase {
 
   // Whether to do prefetching or run this as a normal operator
   const bool no_prefetch_;
+
+  // The ring of prefetched batches, with prefetch_depth_ > 1, guarded by
+  // prefetch_access_mutex_. The ring_filled_ slots from ring_head_ on hold
+  // batches that are ready to be consumed.
+  struct RingSlot {
+    vector<Blob> blobs;
+    bool success = true;
+  };
+  const int prefetch_depth_;
+  vector<RingSlot> ring_;
+  int ring_head_ = 0;
+  int ring_filled_ = 0;
+  // Only set by the prefetching thread, while it runs CopyPrefetched().
+  vector<Blob>* copy_target_ = nullptr;
+
+  struct PrefetchStats {
+    CAFFE_STAT_CTOR(PrefetchStats);
+    // Time that Run() waited for the next batch, when it wasn't ready.
+    CAFFE_AVG_EXPORTED_STAT(consumer_wait_time_ns);
+    // Number of batches ready in the ring when Run() takes one.
+    CAFFE_AVG_EXPORTED_STAT(prefetched_batches);
+  } stats_;
 };
 
 } // namespace caffe2
@@ -260,6 +260,7 @@ REGISTER_CPU_OPERATOR(PReluGradient, PReluGradientOp<float, CPUContext>);
 OPERATOR_SCHEMA(PRelu)
     .NumInputs(2)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<2>)
     .AllowInplace({{0, 0}})
     .IdenticalTypeAndShapeOfInput(0)
     .SetDoc(R"DOC(
@@ -0,0 +1,33 @@
+#include "caffe2/operators/quantized/fc_dynamic_quant_op.h"
+
+#include <functional>
+
+#include "caffe2/operators/fc_inference.h"
+
+namespace caffe2 {
+
+using namespace std::placeholders;
+
+REGISTER_CPU_OPERATOR(FCDynamicQuant, int8::FCDynamicQuantOp);
+
+OPERATOR_SCHEMA(FCDynamicQuant)
+    .NumInputs(3)
+    .NumOutputs(1)
+    .TensorInferenceFunction(std::bind(FCShapeInference, _1, _2, false))
+    .CostInferenceFunction(CostInferenceForFC)
+    .SetDoc(R"DOC(
+FC of fp32 tensors with int8 weights and activations, for inference of
+layers bound by the bandwidth of their weights. The weights W of shape (N, K)
+are quantized to uint8 with their range and packed once, as they are expected
+to be constants, and X is quantized with its range on every run. The products
+are accumulated in int32 and dequantized to fp32, to which the bias b is
+added.
+)DOC")
+    .Arg("axis", "Axis of X at which it is flattened to (M, K), 1 by default")
+    .Arg("axis_w", "Axis of W at which it is flattened to (N, K), 1 by default")
+    .Input(0, "X", "fp32 input")
+    .Input(1, "W", "fp32 weights of shape (N, K)")
+    .Input(2, "b", "fp32 bias of shape (N)")
+    .Output(0, "Y", "fp32 output of shape (M, N)");
+
+} // namespace caffe2
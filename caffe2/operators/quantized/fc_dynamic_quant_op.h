@@ -0,0 +1,117 @@
+#ifndef CAFFE2_OPERATORS_FC_DYNAMIC_QUANT_OP_H_
+#define CAFFE2_OPERATORS_FC_DYNAMIC_QUANT_OP_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+/**
+ * FC of fp32 tensors which runs as an Int8GemmFloat: the weights are
+ * quantized to uint8 and packed the first time the operator runs, and again
+ * only when their data moves or is reshaped, and X is quantized to uint8
+ * with the range of every batch. The int32 accumulators are dequantized to
+ * fp32 and the fp32 bias is added.
+ */
+class FCDynamicQuantOp final : public Operator<CPUContext> {
+ public:
+  FCDynamicQuantOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        axis_(OperatorBase::GetSingleArgument<int32_t>("axis", 1)),
+        axis_w_(OperatorBase::GetSingleArgument<int32_t>("axis_w", 1)) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(0);
+    const auto& W = Input(1);
+    const auto& b = Input(2);
+    auto* Y = Output(0);
+    CAFFE_ENFORCE_EQ(b.ndim(), 1);
+    const auto canonical_axis = X.canonical_axis_index(axis_);
+    const int M = X.size_to_dim(canonical_axis);
+    const int K = X.size_from_dim(canonical_axis);
+    const auto canonical_axis_w = W.canonical_axis_index(axis_w_);
+    const int N = W.size_to_dim(canonical_axis_w);
+    CAFFE_ENFORCE(
+        K == W.size_from_dim(canonical_axis_w) && N == b.size(),
+        "Dimension mismatch: X ",
+        X.dims(),
+        ", W ",
+        W.dims(),
+        ", b ",
+        b.dims());
+
+    std::vector<TIndex> Y_shape(
+        X.dims().begin(), X.dims().begin() + canonical_axis);
+    Y_shape.push_back(N);
+    Y->Resize(Y_shape);
+    float* Y_data = Y->template mutable_data<float>();
+    if (X.size() == 0) {
+      return true;
+    }
+
+    PackWeights(W, N, K);
+    const float* X_data = X.template data<float>();
+    const auto X_minmax = std::minmax_element(X_data, X_data + X.size());
+    const auto X_params =
+        ChooseInt8QuantizationParams(*X_minmax.first, *X_minmax.second);
+    X_quantized_.resize(X.size());
+    for (int i = 0; i < X.size(); ++i) {
+      X_quantized_[i] =
+          QuantizeUint8(X_params.scale, X_params.zero_point, X_data[i]);
+    }
+
+    Int8GemmFloatOutputStage output;
+    output.scale = X_params.scale * W_params_.scale;
+    output.bias = b.template data<float>();
+    Int8GemmFloat(
+        M,
+        X_quantized_.data(),
+        K,
+        X_params.zero_point,
+        packed_W_,
+        output,
+        Y_data,
+        N);
+    return true;
+  }
+
+ private:
+  void PackWeights(const TensorCPU& W, int N, int K) {
+    if (W.raw_data() == W_data_ && W.dims() == W_dims_) {
+      return;
+    }
+    const float* W_data = W.template data<float>();
+    const auto W_minmax = std::minmax_element(W_data, W_data + W.size());
+    W_params_ = ChooseInt8QuantizationParams(*W_minmax.first, *W_minmax.second);
+    std::vector<uint8_t> W_quantized(W.size());
+    for (int i = 0; i < W.size(); ++i) {
+      W_quantized[i] =
+          QuantizeUint8(W_params_.scale, W_params_.zero_point, W_data[i]);
+    }
+    PackInt8Matrix(
+        N, K, W_quantized.data(), K, W_params_.zero_point, &packed_W_);
+    W_data_ = W.raw_data();
+    W_dims_ = W.dims();
+  }
+
+  int axis_;
+  int axis_w_;
+  // The packed weights and the data they were packed from
+  const void* W_data_{nullptr};
+  std::vector<TIndex> W_dims_;
+  Int8QuantizationParams W_params_;
+  PackedInt8Matrix packed_W_;
+  std::vector<uint8_t> X_quantized_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_FC_DYNAMIC_QUANT_OP_H_
@@ -0,0 +1,35 @@
+#include "caffe2/operators/quantized/int8_add_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Add, int8::Int8AddOp<false>);
+REGISTER_CPU_OPERATOR(Int8AddRelu, int8::Int8AddOp<true>);
+
+OPERATOR_SCHEMA(Int8Add)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}, {1, 0}})
+    .SetDoc(R"DOC(
+Elementwise sum of the uint8 Int8TensorCPU A and B of the same shape,
+quantized with Y_scale and Y_zero_point.
+)DOC")
+    .Arg("Y_scale", "Scale of the output")
+    .Arg("Y_zero_point", "Zero point of the output, in [0, 255]")
+    .Input(0, "A", "Int8TensorCPU")
+    .Input(1, "B", "Int8TensorCPU of the shape of A")
+    .Output(0, "Y", "Int8TensorCPU");
+
+OPERATOR_SCHEMA(Int8AddRelu)
+    .NumInputs(2)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}, {1, 0}})
+    .SetDoc(R"DOC(
+Int8Add followed by a Relu, which clamps the output to its zero point.
+)DOC")
+    .Arg("Y_scale", "Scale of the output")
+    .Arg("Y_zero_point", "Zero point of the output, in [0, 255]")
+    .Input(0, "A", "Int8TensorCPU")
+    .Input(1, "B", "Int8TensorCPU of the shape of A")
+    .Output(0, "Y", "Int8TensorCPU");
+
+} // namespace caffe2
@@ -0,0 +1,67 @@
+#ifndef CAFFE2_OPERATORS_INT8_ADD_OP_H_
+#define CAFFE2_OPERATORS_INT8_ADD_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+template <bool ReluFused>
+class Int8AddOp final : public Operator<CPUContext> {
+ public:
+  Int8AddOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        Y_scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1.0f)),
+        Y_zero_point_(
+            OperatorBase::GetSingleArgument<int>("Y_zero_point", 0)) {
+    CAFFE_ENFORCE_GT(Y_scale_, 0);
+    CAFFE_ENFORCE(Y_zero_point_ >= 0 && Y_zero_point_ <= 255);
+  }
+
+  bool RunOnDevice() override {
+    const auto& A = Inputs()[0]->template Get<Int8TensorCPU>();
+    const auto& B = Inputs()[1]->template Get<Int8TensorCPU>();
+    CAFFE_ENFORCE_EQ(
+        A.t.dims(), B.t.dims(), "Int8Add doesn't support broadcasting");
+    // Real values of the inputs in units of the output scale, which the
+    // outputs are rounded from
+    float A_values[256];
+    float B_values[256];
+    for (int q = 0; q < 256; ++q) {
+      A_values[q] = (q - A.zero_point) * (A.scale / Y_scale_);
+      B_values[q] = (q - B.zero_point) * (B.scale / Y_scale_);
+    }
+    const uint8_t* A_data = A.t.data<uint8_t>();
+    const uint8_t* B_data = B.t.data<uint8_t>();
+    const int size = A.t.size();
+
+    auto* Y = Outputs()[0]->template GetMutable<Int8TensorCPU>();
+    Y->t.ResizeLike(A.t);
+    Y->scale = Y_scale_;
+    Y->zero_point = Y_zero_point_;
+    uint8_t* Y_data = Y->t.mutable_data<uint8_t>();
+    const float min = ReluFused ? Y_zero_point_ : 0.0f;
+    for (int i = 0; i < size; ++i) {
+      const float value = std::nearbyint(A_values[A_data[i]] +
+                                         B_values[B_data[i]]) +
+          Y_zero_point_;
+      Y_data[i] =
+          static_cast<uint8_t>(std::min(std::max(value, min), 255.0f));
+    }
+    return true;
+  }
+
+ private:
+  float Y_scale_;
+  int32_t Y_zero_point_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_ADD_OP_H_
@@ -0,0 +1,23 @@
+#include "caffe2/operators/quantized/int8_concat_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Concat, int8::Int8ConcatOp);
+
+OPERATOR_SCHEMA(Int8Concat)
+    .NumInputs(1, INT_MAX)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Concatenates the uint8 Int8TensorCPU inputs along axis, the last one, i.e.
+the channels of NHWC images, by default. The inputs are requantized to
+Y_scale and Y_zero_point, which default to the ones of the first input.
+)DOC")
+    .Arg("axis", "Axis of the concatenation, -1 by default")
+    .Arg("Y_scale", "Scale of the output, the scale of the first input by "
+         "default")
+    .Arg("Y_zero_point", "Zero point of the output, the one of the first "
+         "input by default")
+    .Input(0, "X", "Int8TensorCPU inputs of the same shape except at axis")
+    .Output(0, "Y", "Int8TensorCPU");
+
+} // namespace caffe2
@@ -0,0 +1,100 @@
+#ifndef CAFFE2_OPERATORS_INT8_CONCAT_OP_H_
+#define CAFFE2_OPERATORS_INT8_CONCAT_OP_H_
+
+#include <cstring>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+/**
+ * Concatenation of uint8 tensors along axis, the channels of NHWC images by
+ * default. The output is quantized with Y_scale and Y_zero_point, which
+ * default to the ones of the first input, and inputs with another
+ * quantization are requantized.
+ */
+class Int8ConcatOp final : public Operator<CPUContext> {
+ public:
+  Int8ConcatOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        axis_(OperatorBase::GetSingleArgument<int>("axis", -1)) {}
+
+  bool RunOnDevice() override {
+    const auto& X0 = Inputs()[0]->template Get<Int8TensorCPU>();
+    auto* Y = Outputs()[0]->template GetMutable<Int8TensorCPU>();
+    const int ndim = X0.t.ndim();
+    const int axis = X0.t.canonical_axis_index(axis_);
+    const float Y_scale =
+        OperatorBase::GetSingleArgument<float>("Y_scale", X0.scale);
+    const int32_t Y_zero_point =
+        OperatorBase::GetSingleArgument<int>("Y_zero_point", X0.zero_point);
+    CAFFE_ENFORCE_GT(Y_scale, 0);
+
+    std::vector<TIndex> Y_dims = X0.t.dims();
+    for (int i = 1; i < InputSize(); ++i) {
+      const auto& X = Inputs()[i]->template Get<Int8TensorCPU>();
+      CAFFE_ENFORCE_EQ(X.t.ndim(), ndim);
+      for (int d = 0; d < ndim; ++d) {
+        if (d != axis) {
+          CAFFE_ENFORCE_EQ(
+              X.t.dim(d), X0.t.dim(d), "Input ", i, " has another shape");
+        }
+      }
+      Y_dims[axis] += X.t.dim(axis);
+    }
+    // The output can't be one of the inputs
+    for (int i = 0; i < InputSize(); ++i) {
+      CAFFE_ENFORCE(
+          &InputBlob(i) != OutputBlob(0), "Int8Concat can't run in place");
+    }
+    Y->t.Resize(Y_dims);
+    Y->scale = Y_scale;
+    Y->zero_point = Y_zero_point;
+
+    const int outer = X0.t.size_to_dim(axis);
+    const int inner = X0.t.size_from_dim(axis + 1);
+    const int Y_stride = Y_dims[axis] * inner;
+    uint8_t* Y_data = Y->t.template mutable_data<uint8_t>();
+    int offset = 0;
+    uint8_t requantized[256];
+    for (int i = 0; i < InputSize(); ++i) {
+      const auto& X = Inputs()[i]->template Get<Int8TensorCPU>();
+      const int X_stride = X.t.dim32(axis) * inner;
+      const uint8_t* X_data = X.t.template data<uint8_t>();
+      if (X.scale == Y_scale && X.zero_point == Y_zero_point) {
+        for (int o = 0; o < outer; ++o) {
+          std::memcpy(
+              Y_data + o * Y_stride + offset, X_data + o * X_stride, X_stride);
+        }
+      } else {
+        for (int q = 0; q < 256; ++q) {
+          requantized[q] = QuantizeUint8(
+              Y_scale, Y_zero_point, DequantizeUint8(X.scale, X.zero_point, q));
+        }
+        for (int o = 0; o < outer; ++o) {
+          uint8_t* y = Y_data + o * Y_stride + offset;
+          const uint8_t* x = X_data + o * X_stride;
+          for (int j = 0; j < X_stride; ++j) {
+            y[j] = requantized[x[j]];
+          }
+        }
+      }
+      offset += X_stride;
+    }
+    return true;
+  }
+
+ private:
+  int axis_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_CONCAT_OP_H_
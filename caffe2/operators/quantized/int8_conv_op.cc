@@ -0,0 +1,43 @@
+#include "caffe2/operators/quantized/int8_conv_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Conv, int8::Int8ConvOp<false>);
+REGISTER_CPU_OPERATOR(Int8ConvRelu, int8::Int8ConvOp<true>);
+
+OPERATOR_SCHEMA(Int8Conv)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForConv)
+    .SetDoc(R"DOC(
+2D convolution of the uint8 Int8TensorCPU X in NHWC order with the uint8
+filter W of shape (M, kernel_h, kernel_w, C / group) and the optional int32
+bias B, whose scale is X.scale * W.scale and zero point is 0. The int32
+accumulators are requantized to Y_scale and Y_zero_point, which requires
+X.scale * W.scale < Y_scale.
+)DOC")
+    .Arg("Y_scale", "Scale of the output")
+    .Arg("Y_zero_point", "Zero point of the output, in [0, 255]")
+    .Arg("order", "Must be NHWC")
+    .Input(0, "X", "Int8TensorCPU of shape (N, H, W, C)")
+    .Input(1, "W", "Int8TensorCPU of shape (M, kernel_h, kernel_w, C / group)")
+    .Input(2, "B", "Optional int32 Int8TensorCPU of shape (M)")
+    .Output(0, "Y", "Int8TensorCPU of shape (N, out_h, out_w, M)");
+
+OPERATOR_SCHEMA(Int8ConvRelu)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForConv)
+    .SetDoc(R"DOC(
+Int8Conv followed by a Relu, which clamps the output to its zero point in the
+requantization.
+)DOC")
+    .Arg("Y_scale", "Scale of the output")
+    .Arg("Y_zero_point", "Zero point of the output, in [0, 255]")
+    .Arg("order", "Must be NHWC")
+    .Input(0, "X", "Int8TensorCPU of shape (N, H, W, C)")
+    .Input(1, "W", "Int8TensorCPU of shape (M, kernel_h, kernel_w, C / group)")
+    .Input(2, "B", "Optional int32 Int8TensorCPU of shape (M)")
+    .Output(0, "Y", "Int8TensorCPU of shape (N, out_h, out_w, M)");
+
+} // namespace caffe2
@@ -0,0 +1,164 @@
+#ifndef CAFFE2_OPERATORS_INT8_CONV_OP_H_
+#define CAFFE2_OPERATORS_INT8_CONV_OP_H_
+
+#include <cstring>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+/**
+ * 2D convolution of uint8 NHWC images with uint8 filters of shape
+ * (M, kernel_h, kernel_w, C / group), as an im2col followed by Int8Gemm for
+ * every group, which requantizes the outputs to Y_scale and Y_zero_point.
+ * The optional bias is int32, with the scale X.scale * W.scale.
+ */
+template <bool ReluFused>
+class Int8ConvOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  Int8ConvOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws),
+        Y_scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1.0f)),
+        Y_zero_point_(
+            OperatorBase::GetSingleArgument<int>("Y_zero_point", 0)) {
+    OPERATOR_NEEDS_FEATURE(
+        order_ == StorageOrder::NHWC, "Int8Conv only supports NHWC order");
+    CAFFE_ENFORCE_EQ(
+        kernel_.size(), 2, "Int8Conv only supports 2D convolutions");
+    CAFFE_ENFORCE_GT(Y_scale_, 0);
+    CAFFE_ENFORCE(Y_zero_point_ >= 0 && Y_zero_point_ <= 255);
+  }
+
+  bool RunOnDeviceWithOrderNHWC() override {
+    const auto& X = Inputs()[0]->template Get<Int8TensorCPU>();
+    const auto& W = Inputs()[1]->template Get<Int8TensorCPU>();
+    auto* Y = Outputs()[0]->template GetMutable<Int8TensorCPU>();
+    CAFFE_ENFORCE_EQ(X.t.ndim(), 4);
+    CAFFE_ENFORCE_EQ(W.t.ndim(), 4);
+    const int N = X.t.dim32(0);
+    const int H = X.t.dim32(1);
+    const int W_in = X.t.dim32(2);
+    const int C = X.t.dim32(3);
+    const int M = W.t.dim32(0);
+    CAFFE_ENFORCE_EQ(C % group_, 0);
+    CAFFE_ENFORCE_EQ(M % group_, 0);
+    const int C_group = C / group_;
+    const int M_group = M / group_;
+    CAFFE_ENFORCE_EQ(W.t.dim32(1), kernel_h());
+    CAFFE_ENFORCE_EQ(W.t.dim32(2), kernel_w());
+    CAFFE_ENFORCE_EQ(W.t.dim32(3), C_group);
+
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X.t, &(Y->t), M);
+    Y->scale = Y_scale_;
+    Y->zero_point = Y_zero_point_;
+    const int Y_H = Y->t.dim32(1);
+    const int Y_W = Y->t.dim32(2);
+    const int Y_HxW = Y_H * Y_W;
+
+    const int K = kernel_h() * kernel_w() * C_group;
+    const auto& packed = packed_weights_.Get(W, M, K, group_);
+    auto output = GetOutputStage(
+        X.scale, W.scale, Y_scale_, Y_zero_point_, ReluFused);
+    const int32_t* bias = InputSize() == 3
+        ? GetBias(
+              Inputs()[2]->template Get<Int8TensorCPU>(), X.scale, W.scale, M)
+        : nullptr;
+
+    // A 1x1 convolution multiplies the pixels of the image directly
+    const bool use_im2col = !(kernel_h() == 1 && kernel_w() == 1 &&
+                              stride_h() == 1 && stride_w() == 1 &&
+                              pad_t() == 0 && pad_l() == 0 && pad_b() == 0 &&
+                              pad_r() == 0 && group_ == 1);
+    if (use_im2col) {
+      col_buffer_.Resize(Y_HxW, K);
+    }
+
+    const uint8_t* X_data = X.t.template data<uint8_t>();
+    uint8_t* Y_data = Y->t.template mutable_data<uint8_t>();
+    for (int n = 0; n < N; ++n) {
+      const uint8_t* X_image = X_data + n * H * W_in * C;
+      uint8_t* Y_image = Y_data + n * Y_HxW * M;
+      for (int g = 0; g < group_; ++g) {
+        const uint8_t* A = X_image;
+        int lda = C;
+        if (use_im2col) {
+          uint8_t* col = col_buffer_.template mutable_data<uint8_t>();
+          Im2Col(
+              X_image,
+              H,
+              W_in,
+              C,
+              g * C_group,
+              C_group,
+              Y_H,
+              Y_W,
+              X.zero_point,
+              col);
+          A = col;
+          lda = K;
+        }
+        output.bias = bias ? bias + g * M_group : nullptr;
+        Int8Gemm(
+            Y_HxW,
+            A,
+            lda,
+            X.zero_point,
+            packed[g],
+            output,
+            Y_image + g * M_group,
+            M);
+      }
+    }
+    return true;
+  }
+
+ private:
+  // Rows of the patches of the channels [channel, channel + channels) of an
+  // NHWC image, where the padding is the quantized zero
+  void Im2Col(
+      const uint8_t* X,
+      int H,
+      int W,
+      int C,
+      int channel,
+      int channels,
+      int out_h,
+      int out_w,
+      int32_t zero_point,
+      uint8_t* col) {
+    for (int oh = 0; oh < out_h; ++oh) {
+      for (int ow = 0; ow < out_w; ++ow) {
+        for (int kh = 0; kh < kernel_h(); ++kh) {
+          const int h = oh * stride_h() - pad_t() + kh * dilation_h();
+          for (int kw = 0; kw < kernel_w(); ++kw) {
+            const int w = ow * stride_w() - pad_l() + kw * dilation_w();
+            if (h >= 0 && h < H && w >= 0 && w < W) {
+              std::memcpy(col, X + (h * W + w) * C + channel, channels);
+            } else {
+              std::memset(col, zero_point, channels);
+            }
+            col += channels;
+          }
+        }
+      }
+    }
+  }
+
+  float Y_scale_;
+  int32_t Y_zero_point_;
+  Int8PackedWeights packed_weights_;
+  TensorCPU col_buffer_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_CONV_OP_H_
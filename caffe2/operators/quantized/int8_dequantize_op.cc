@@ -0,0 +1,17 @@
+#include "caffe2/operators/quantized/int8_dequantize_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Dequantize, int8::Int8DequantizeOp);
+
+OPERATOR_SCHEMA(Int8Dequantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Dequantizes the uint8 Int8TensorCPU X to the float tensor
+Y = X.scale * (X - X.zero_point).
+)DOC")
+    .Input(0, "X", "Int8TensorCPU")
+    .Output(0, "Y", "Float tensor");
+
+} // namespace caffe2
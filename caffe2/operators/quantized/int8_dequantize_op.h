@@ -0,0 +1,35 @@
+#ifndef CAFFE2_OPERATORS_INT8_DEQUANTIZE_OP_H_
+#define CAFFE2_OPERATORS_INT8_DEQUANTIZE_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+class Int8DequantizeOp final : public Operator<CPUContext> {
+ public:
+  Int8DequantizeOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Inputs()[0]->template Get<Int8TensorCPU>();
+    auto* Y = Output(0);
+    Y->ResizeLike(X.t);
+    const uint8_t* X_data = X.t.data<uint8_t>();
+    float* Y_data = Y->mutable_data<float>();
+    for (int i = 0; i < X.t.size(); ++i) {
+      Y_data[i] = DequantizeUint8(X.scale, X.zero_point, X_data[i]);
+    }
+    return true;
+  }
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_DEQUANTIZE_OP_H_
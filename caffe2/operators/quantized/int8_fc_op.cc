@@ -0,0 +1,25 @@
+#include "caffe2/operators/quantized/int8_fc_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8FC, int8::Int8FCOp);
+
+OPERATOR_SCHEMA(Int8FC)
+    .NumInputs(2, 3)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Fully connected layer of the uint8 Int8TensorCPU X with the uint8 weights W of
+shape (N, K) and the optional int32 bias B, whose scale is X.scale * W.scale
+and zero point is 0. The int32 accumulators are requantized to Y_scale and
+Y_zero_point, which requires X.scale * W.scale < Y_scale.
+)DOC")
+    .Arg("axis", "Axis of X at which it is flattened to (M, K), 1 by default")
+    .Arg("axis_w", "Axis of W at which it is flattened to (N, K), 1 by default")
+    .Arg("Y_scale", "Scale of the output")
+    .Arg("Y_zero_point", "Zero point of the output, in [0, 255]")
+    .Input(0, "X", "Int8TensorCPU")
+    .Input(1, "W", "Int8TensorCPU")
+    .Input(2, "B", "Optional int32 Int8TensorCPU of shape (N)")
+    .Output(0, "Y", "Int8TensorCPU of shape (M, N)");
+
+} // namespace caffe2
@@ -0,0 +1,86 @@
+#ifndef CAFFE2_OPERATORS_INT8_FC_OP_H_
+#define CAFFE2_OPERATORS_INT8_FC_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+/**
+ * Fully connected layer Y = X * W^T + b of uint8 tensors, as an Int8Gemm
+ * which requantizes the outputs to Y_scale and Y_zero_point. X and W are
+ * flattened to matrices at axis and axis_w as FC does.
+ */
+class Int8FCOp final : public Operator<CPUContext> {
+ public:
+  Int8FCOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        axis_(OperatorBase::GetSingleArgument<int32_t>("axis", 1)),
+        axis_w_(OperatorBase::GetSingleArgument<int32_t>("axis_w", 1)),
+        Y_scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1.0f)),
+        Y_zero_point_(
+            OperatorBase::GetSingleArgument<int>("Y_zero_point", 0)) {
+    CAFFE_ENFORCE_GT(Y_scale_, 0);
+    CAFFE_ENFORCE(Y_zero_point_ >= 0 && Y_zero_point_ <= 255);
+  }
+
+  bool RunOnDevice() override {
+    const auto& X = Inputs()[0]->template Get<Int8TensorCPU>();
+    const auto& W = Inputs()[1]->template Get<Int8TensorCPU>();
+    auto* Y = Outputs()[0]->template GetMutable<Int8TensorCPU>();
+    const auto canonical_axis = X.t.canonical_axis_index(axis_);
+    const int M = X.t.size_to_dim(canonical_axis);
+    const int K = X.t.size_from_dim(canonical_axis);
+    const auto canonical_axis_w = W.t.canonical_axis_index(axis_w_);
+    const int N = W.t.size_to_dim(canonical_axis_w);
+    CAFFE_ENFORCE_EQ(
+        K,
+        W.t.size_from_dim(canonical_axis_w),
+        "Dimension mismatch: X ",
+        X.t.dims(),
+        ", W ",
+        W.t.dims());
+
+    std::vector<TIndex> Y_shape(
+        X.t.dims().begin(), X.t.dims().begin() + canonical_axis);
+    Y_shape.push_back(N);
+    Y->t.Resize(Y_shape);
+    Y->scale = Y_scale_;
+    Y->zero_point = Y_zero_point_;
+
+    const auto& packed = packed_weights_.Get(W, N, K, 1);
+    auto output =
+        GetOutputStage(X.scale, W.scale, Y_scale_, Y_zero_point_, false);
+    if (InputSize() == 3) {
+      output.bias = GetBias(
+          Inputs()[2]->template Get<Int8TensorCPU>(), X.scale, W.scale, N);
+    }
+    Int8Gemm(
+        M,
+        X.t.template data<uint8_t>(),
+        K,
+        X.zero_point,
+        packed[0],
+        output,
+        Y->t.template mutable_data<uint8_t>(),
+        N);
+    return true;
+  }
+
+ private:
+  int axis_;
+  int axis_w_;
+  float Y_scale_;
+  int32_t Y_zero_point_;
+  Int8PackedWeights packed_weights_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_FC_OP_H_
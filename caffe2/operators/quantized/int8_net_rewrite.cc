@@ -0,0 +1,467 @@
+#include "caffe2/operators/quantized/int8_net_rewrite.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/rnn/recurrent_network_op.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+#include "caffe2/utils/proto_utils.h"
+
+namespace caffe2 {
+namespace int8 {
+
+namespace {
+
+// The value of a blob of the net while it is rewritten
+struct BlobState {
+  // Whether the fp32 blob holds the value
+  bool fp32{true};
+  // Whether the Int8TensorCPU <name>_int8 holds the value
+  bool int8{false};
+  // Whether the quantized value is the NHWC transpose of an NCHW image
+  bool transposed{false};
+  Int8QuantizationParams params;
+};
+
+string Int8Name(const string& name) {
+  return name + "_int8";
+}
+
+string NHWCName(const string& name) {
+  return name + "_nhwc";
+}
+
+bool IsNCHW(const OperatorDef& op) {
+  return ArgumentHelper::GetSingleArgument<OperatorDef, string>(
+             op, "order", "NCHW") == "NCHW";
+}
+
+// Copies the arguments of the fp32 operator to its NHWC Int8 version
+void CopyArguments(
+    const OperatorDef& op,
+    const Int8QuantizationParams* Y_params,
+    bool image,
+    OperatorDef* int8_op) {
+  for (const auto& arg : op.arg()) {
+    if (arg.name() != "order") {
+      int8_op->add_arg()->CopyFrom(arg);
+    }
+  }
+  if (image) {
+    int8_op->add_arg()->CopyFrom(MakeArgument<string>("order", "NHWC"));
+  }
+  if (Y_params) {
+    int8_op->add_arg()->CopyFrom(
+        MakeArgument<float>("Y_scale", Y_params->scale));
+    int8_op->add_arg()->CopyFrom(
+        MakeArgument<int>("Y_zero_point", Y_params->zero_point));
+  }
+}
+
+class Int8NetRewriter {
+ public:
+  Int8NetRewriter(
+      const NetDef& net,
+      const std::unordered_map<string, Int8QuantizationParams>& params,
+      Workspace* ws)
+      : net_(net), params_(params), ws_(ws) {
+    for (const auto& op : net.op()) {
+      for (const auto& output : op.output()) {
+        written_.insert(output);
+      }
+    }
+  }
+
+  NetDef Run() {
+    result_.CopyFrom(net_);
+    result_.clear_op();
+    for (int i = 0; i < net_.op_size(); ++i) {
+      const auto& op = net_.op(i);
+      const bool cpu = !op.has_device_option() ||
+          op.device_option().device_type() == CPU;
+      if (!(cpu &&
+            (RewriteConvOrFC(op) || RewriteRelu(op) || RewritePool(op) ||
+             RewriteAdd(op) || RewriteConcat(i, op)))) {
+        for (const auto& input : op.input()) {
+          EnsureFP32(input);
+        }
+        result_.add_op()->CopyFrom(op);
+        for (const auto& output : op.output()) {
+          blobs_[output] = BlobState();
+        }
+      }
+    }
+    for (const auto& output : net_.external_output()) {
+      EnsureFP32(output);
+    }
+    return result_;
+  }
+
+ private:
+  bool CanQuantize(const string& name, bool transposed) {
+    const auto& state = blobs_[name];
+    if (state.int8) {
+      return state.transposed == transposed;
+    }
+    return state.fp32 && params_.count(name);
+  }
+
+  // Params of a blob that CanQuantize
+  Int8QuantizationParams GetParams(const string& name) {
+    const auto& state = blobs_[name];
+    return state.int8 ? state.params : params_.at(name);
+  }
+
+  // Makes the quantized value of a blob that CanQuantize available
+  void EnsureInt8(const string& name, bool transposed) {
+    auto& state = blobs_[name];
+    if (state.int8) {
+      return;
+    }
+    const auto& params = params_.at(name);
+    string input = name;
+    if (transposed) {
+      input = NHWCName(name);
+      result_.add_op()->CopyFrom(
+          CreateOperatorDef("NCHW2NHWC", "", {name}, {input}));
+    }
+    result_.add_op()->CopyFrom(CreateOperatorDef(
+        "Int8Quantize",
+        "",
+        {input},
+        {Int8Name(name)},
+        {MakeArgument<float>("Y_scale", params.scale),
+         MakeArgument<int>("Y_zero_point", params.zero_point)}));
+    state.int8 = true;
+    state.transposed = transposed;
+    state.params = params;
+  }
+
+  // Makes the fp32 value of a blob available
+  void EnsureFP32(const string& name) {
+    auto& state = blobs_[name];
+    if (state.fp32 || !state.int8) {
+      return;
+    }
+    if (state.transposed) {
+      result_.add_op()->CopyFrom(CreateOperatorDef(
+          "Int8Dequantize", "", {Int8Name(name)}, {NHWCName(name)}));
+      result_.add_op()->CopyFrom(
+          CreateOperatorDef("NHWC2NCHW", "", {NHWCName(name)}, {name}));
+    } else {
+      result_.add_op()->CopyFrom(
+          CreateOperatorDef("Int8Dequantize", "", {Int8Name(name)}, {name}));
+    }
+    state.fp32 = true;
+  }
+
+  void WriteInt8(
+      const string& name,
+      bool transposed,
+      const Int8QuantizationParams& params) {
+    auto& state = blobs_[name];
+    state.fp32 = false;
+    state.int8 = true;
+    state.transposed = transposed;
+    state.params = params;
+  }
+
+  // Float tensor of the workspace that the net doesn't write
+  const TensorCPU* GetConstant(const string& name) {
+    if (written_.count(name) || !ws_->HasBlob(name) ||
+        !ws_->GetBlob(name)->IsType<TensorCPU>()) {
+      return nullptr;
+    }
+    const auto& tensor = ws_->GetBlob(name)->Get<TensorCPU>();
+    return tensor.IsType<float>() && tensor.size() > 0 ? &tensor : nullptr;
+  }
+
+  Int8QuantizationParams GetWeightsParams(const TensorCPU& W) {
+    const float* W_data = W.data<float>();
+    const auto minmax = std::minmax_element(W_data, W_data + W.size());
+    return ChooseInt8QuantizationParams(*minmax.first, *minmax.second);
+  }
+
+  // Quantizes the weights of Conv, transposed to (M, kernel_h, kernel_w, C)
+  // if they are NCHW, or FC
+  string QuantizeWeights(
+      const string& name,
+      const TensorCPU& W,
+      bool transposed,
+      const Int8QuantizationParams* params) {
+    const float* W_data = W.data<float>();
+    const string int8_name = Int8Name(name);
+    auto* W_int8 = ws_->CreateBlob(int8_name)->GetMutable<Int8TensorCPU>();
+    W_int8->scale = params->scale;
+    W_int8->zero_point = params->zero_point;
+    uint8_t* W_int8_data = nullptr;
+    if (transposed) {
+      const int M = W.dim32(0);
+      const int C = W.dim32(1);
+      const int HxW = W.dim32(2) * W.dim32(3);
+      W_int8->t.Resize(M, W.dim32(2), W.dim32(3), C);
+      W_int8_data = W_int8->t.mutable_data<uint8_t>();
+      for (int m = 0; m < M; ++m) {
+        for (int c = 0; c < C; ++c) {
+          for (int i = 0; i < HxW; ++i) {
+            W_int8_data[(m * HxW + i) * C + c] = QuantizeUint8(
+                params->scale,
+                params->zero_point,
+                W_data[(m * C + c) * HxW + i]);
+          }
+        }
+      }
+    } else {
+      W_int8->t.Resize(W.dims());
+      W_int8_data = W_int8->t.mutable_data<uint8_t>();
+      for (int i = 0; i < W.size(); ++i) {
+        W_int8_data[i] =
+            QuantizeUint8(params->scale, params->zero_point, W_data[i]);
+      }
+    }
+    return int8_name;
+  }
+
+  // Quantizes the bias to int32 with the scale of the products, in a blob
+  // for every scale
+  string QuantizeBias(const string& name, const TensorCPU& b, float scale) {
+    string int8_name = Int8Name(name);
+    for (int i = 1; bias_scales_.count(int8_name) &&
+         bias_scales_[int8_name] != scale;
+         ++i) {
+      int8_name = Int8Name(name) + "_" + caffe2::to_string(i);
+    }
+    bias_scales_[int8_name] = scale;
+    auto* b_int8 = ws_->CreateBlob(int8_name)->GetMutable<Int8TensorCPU>();
+    b_int8->scale = scale;
+    b_int8->zero_point = 0;
+    b_int8->t.Resize(b.size());
+    int32_t* b_int8_data = b_int8->t.mutable_data<int32_t>();
+    for (int i = 0; i < b.size(); ++i) {
+      b_int8_data[i] =
+          static_cast<int32_t>(std::nearbyint(b.data<float>()[i] / scale));
+    }
+    return int8_name;
+  }
+
+  bool RewriteConvOrFC(const OperatorDef& op) {
+    const bool conv = op.type() == "Conv";
+    if (!(conv || op.type() == "FC") || op.input_size() < 2 ||
+        op.input_size() > 3 || op.output_size() != 1) {
+      return false;
+    }
+    const auto& X = op.input(0);
+    const auto& Y = op.output(0);
+    const auto* W = GetConstant(op.input(1));
+    const auto* b = op.input_size() == 3 ? GetConstant(op.input(2)) : nullptr;
+    const bool transposed = conv && IsNCHW(op);
+    if (!W || (conv && W->ndim() != 4) || (op.input_size() == 3 && !b) ||
+        !CanQuantize(X, transposed) || !params_.count(Y)) {
+      return false;
+    }
+    const auto X_params = GetParams(X);
+    const auto& Y_params = params_.at(Y);
+
+    const auto W_params = GetWeightsParams(*W);
+    if (X_params.scale * W_params.scale >= Y_params.scale) {
+      // Int8Gemm can't requantize the products
+      return false;
+    }
+    EnsureInt8(X, transposed);
+    const auto W_int8 =
+        QuantizeWeights(op.input(1), *W, transposed, &W_params);
+    OperatorDef int8_op;
+    int8_op.set_type(conv ? "Int8Conv" : "Int8FC");
+    int8_op.set_name(op.name());
+    int8_op.add_input(Int8Name(X));
+    int8_op.add_input(W_int8);
+    if (b) {
+      int8_op.add_input(QuantizeBias(
+          op.input(2), *b, X_params.scale * W_params.scale));
+    }
+    int8_op.add_output(Int8Name(Y));
+    CopyArguments(op, &Y_params, conv, &int8_op);
+    result_.add_op()->CopyFrom(int8_op);
+    WriteInt8(Y, transposed, Y_params);
+    return true;
+  }
+
+  bool RewriteRelu(const OperatorDef& op) {
+    if (op.type() != "Relu" || !blobs_[op.input(0)].int8) {
+      return false;
+    }
+    const auto state = blobs_[op.input(0)];
+    result_.add_op()->CopyFrom(CreateOperatorDef(
+        "Int8Relu",
+        op.name(),
+        {Int8Name(op.input(0))},
+        {Int8Name(op.output(0))}));
+    WriteInt8(op.output(0), state.transposed, state.params);
+    return true;
+  }
+
+  bool RewritePool(const OperatorDef& op) {
+    const bool max = op.type() == "MaxPool";
+    if (!(max || op.type() == "AveragePool") || op.output_size() != 1) {
+      return false;
+    }
+    const auto& X = op.input(0);
+    const auto& Y = op.output(0);
+    ArgumentHelper args(op);
+    const bool transposed = IsNCHW(op);
+    if (!blobs_[X].int8 || blobs_[X].transposed != transposed ||
+        (args.HasArgument("kernels") &&
+         args.GetRepeatedArgument<int>("kernels").size() != 2) ||
+        (!max && !params_.count(Y))) {
+      return false;
+    }
+    const auto params = max ? blobs_[X].params : params_.at(Y);
+    OperatorDef int8_op;
+    int8_op.set_type(max ? "Int8MaxPool" : "Int8AveragePool");
+    int8_op.set_name(op.name());
+    int8_op.add_input(Int8Name(X));
+    int8_op.add_output(Int8Name(Y));
+    CopyArguments(op, max ? nullptr : &params, true, &int8_op);
+    result_.add_op()->CopyFrom(int8_op);
+    WriteInt8(Y, transposed, params);
+    return true;
+  }
+
+  bool RewriteAdd(const OperatorDef& op) {
+    if (op.type() != "Add" || op.input_size() != 2 ||
+        op.input(0) == op.input(1) ||
+        ArgumentHelper::GetSingleArgument<OperatorDef, int>(
+            op, "broadcast", 0) ||
+        !params_.count(op.output(0))) {
+      return false;
+    }
+    const auto A = blobs_[op.input(0)];
+    const auto B = blobs_[op.input(1)];
+    if (!A.int8 || !B.int8 || A.transposed != B.transposed) {
+      return false;
+    }
+    const auto& params = params_.at(op.output(0));
+    OperatorDef int8_op = CreateOperatorDef(
+        "Int8Add",
+        op.name(),
+        {Int8Name(op.input(0)), Int8Name(op.input(1))},
+        {Int8Name(op.output(0))});
+    CopyArguments(op, &params, false, &int8_op);
+    result_.add_op()->CopyFrom(int8_op);
+    WriteInt8(op.output(0), A.transposed, params);
+    return true;
+  }
+
+  // Whether an operator after the one at index reads the blob before it is
+  // written again
+  bool IsReadAfter(int index, const string& name) {
+    if (std::find(
+            net_.external_output().begin(),
+            net_.external_output().end(),
+            name) != net_.external_output().end()) {
+      return true;
+    }
+    for (int i = index + 1; i < net_.op_size(); ++i) {
+      const auto& op = net_.op(i);
+      for (const auto& input : op.input()) {
+        if (input == name) {
+          return true;
+        }
+      }
+      for (const auto& output : op.output()) {
+        if (output == name) {
+          return false;
+        }
+      }
+    }
+    return false;
+  }
+
+  bool RewriteConcat(int index, const OperatorDef& op) {
+    if (op.type() != "Concat" || !params_.count(op.output(0)) ||
+        (op.output_size() > 1 && IsReadAfter(index, op.output(1)))) {
+      return false;
+    }
+    ArgumentHelper args(op);
+    const auto state = blobs_[op.input(0)];
+    for (const auto& input : op.input()) {
+      if (!blobs_[input].int8 ||
+          blobs_[input].transposed != state.transposed) {
+        return false;
+      }
+    }
+    int axis = args.GetSingleArgument<int>("axis", IsNCHW(op) ? 1 : 3);
+    if (args.GetSingleArgument<int>("add_axis", 0) ||
+        (state.transposed && axis != 1)) {
+      return false;
+    }
+    if (state.transposed) {
+      axis = 3;
+    }
+    const auto& params = params_.at(op.output(0));
+    OperatorDef int8_op;
+    int8_op.set_type("Int8Concat");
+    int8_op.set_name(op.name());
+    for (const auto& input : op.input()) {
+      int8_op.add_input(Int8Name(input));
+    }
+    int8_op.add_output(Int8Name(op.output(0)));
+    int8_op.add_arg()->CopyFrom(MakeArgument<int>("axis", axis));
+    int8_op.add_arg()->CopyFrom(MakeArgument<float>("Y_scale", params.scale));
+    int8_op.add_arg()->CopyFrom(
+        MakeArgument<int>("Y_zero_point", params.zero_point));
+    result_.add_op()->CopyFrom(int8_op);
+    WriteInt8(op.output(0), state.transposed, params);
+    if (op.output_size() > 1) {
+      // The split info is dropped
+      blobs_[op.output(1)].fp32 = false;
+      blobs_[op.output(1)].int8 = false;
+    }
+    return true;
+  }
+
+  const NetDef& net_;
+  const std::unordered_map<string, Int8QuantizationParams>& params_;
+  Workspace* ws_;
+  std::unordered_set<string> written_;
+  std::unordered_map<string, BlobState> blobs_;
+  std::unordered_map<string, float> bias_scales_;
+  NetDef result_;
+};
+
+} // namespace
+
+NetDef RewriteInt8Net(
+    const NetDef& net,
+    const std::unordered_map<std::string, Int8QuantizationParams>& params,
+    Workspace* ws) {
+  return Int8NetRewriter(net, params, ws).Run();
+}
+
+NetDef RewriteDynamicQuantNet(const NetDef& net) {
+  NetDef rewritten = net;
+  for (auto& op : *rewritten.mutable_op()) {
+    const bool cpu = !op.has_device_option() ||
+        op.device_option().device_type() == CPU;
+    if (!cpu || !op.engine().empty()) {
+      continue;
+    }
+    if (op.type() == "FC") {
+      op.set_type("FCDynamicQuant");
+    } else if (op.type() == "RecurrentNetwork") {
+      const auto step_net = RewriteDynamicQuantNet(
+          detail::extractNetDef(op, "step_net"));
+      for (auto& arg : *op.mutable_arg()) {
+        if (arg.name() == "step_net") {
+          arg = MakeArgument<NetDef>("step_net", step_net);
+        }
+      }
+    }
+  }
+  return rewritten;
+}
+
+} // namespace int8
+} // namespace caffe2
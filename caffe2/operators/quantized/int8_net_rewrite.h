@@ -0,0 +1,47 @@
+#ifndef CAFFE2_OPERATORS_INT8_NET_REWRITE_H_
+#define CAFFE2_OPERATORS_INT8_NET_REWRITE_H_
+
+#include <string>
+#include <unordered_map>
+
+#include "caffe2/core/workspace.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+#include "caffe2/proto/caffe2.pb.h"
+
+namespace caffe2 {
+namespace int8 {
+
+/**
+ * Rewrites the fp32 CPU net to the Int8 operators, given the quantization
+ * params of its activations, e.g. from a CalibrationNetObserver:
+ *
+ * - Conv and FC are rewritten when the params of their input and output are
+ *   known and their weights and bias are constants of the workspace. The
+ *   quantized weights and bias are added to the workspace as <name>_int8.
+ * - Relu, MaxPool, AveragePool, Add and Concat are rewritten when their
+ *   inputs are already quantized, and otherwise stay in fp32. Add must add
+ *   tensors of the same shape.
+ *
+ * Int8Quantize and Int8Dequantize are inserted at the boundaries with the
+ * remaining fp32 operators and the external inputs and outputs, which keep
+ * their names and types. Int8 images are NHWC, so NCHW images are
+ * transposed at the boundaries.
+ */
+NetDef RewriteInt8Net(
+    const NetDef& net,
+    const std::unordered_map<std::string, Int8QuantizationParams>& params,
+    Workspace* ws);
+
+/**
+ * Rewrites the FC operators of the fp32 CPU inference net to FCDynamicQuant,
+ * which packs their weights as int8 once and quantizes their inputs on every
+ * run, e.g. for layers bound by the bandwidth of their weights at small
+ * batch sizes. The step nets of RecurrentNetwork are rewritten too, i.e. the
+ * recurrent FC of the gates of LSTMUnit.
+ */
+NetDef RewriteDynamicQuantNet(const NetDef& net);
+
+} // namespace int8
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_NET_REWRITE_H_
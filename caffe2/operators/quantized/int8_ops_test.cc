@@ -0,0 +1,357 @@
+#include <cmath>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_net_rewrite.h"
+#include "caffe2/utils/proto_utils.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+// Fills an Int8TensorCPU with a deterministic pattern of uint8 values
+int8::Int8TensorCPU* AddInt8Input(
+    const vector<TIndex>& shape,
+    float scale,
+    int32_t zero_point,
+    int seed,
+    const string& name,
+    Workspace* ws) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<int8::Int8TensorCPU>();
+  tensor->scale = scale;
+  tensor->zero_point = zero_point;
+  tensor->t.Resize(shape);
+  uint8_t* data = tensor->t.mutable_data<uint8_t>();
+  for (int i = 0; i < tensor->t.size(); ++i) {
+    data[i] = static_cast<uint8_t>((i * 37 + seed * 101) % 256);
+  }
+  return tensor;
+}
+
+float Dequantize(const int8::Int8TensorCPU& tensor, int i) {
+  return tensor.scale *
+      (static_cast<int32_t>(tensor.t.data<uint8_t>()[i]) - tensor.zero_point);
+}
+
+void RunOperator(const OperatorDef& def, Workspace* ws) {
+  unique_ptr<OperatorBase> op(CreateOperator(def, ws));
+  ASSERT_TRUE(op->Run());
+}
+
+// Checks that the quantized output is the closest value to the reference,
+// up to a rounding of the requantization
+void ExpectQuantized(
+    const int8::Int8TensorCPU& Y,
+    const vector<float>& reference) {
+  ASSERT_EQ(Y.t.size(), reference.size());
+  for (int i = 0; i < Y.t.size(); ++i) {
+    const float expected = std::min(
+        std::max(std::round(reference[i] / Y.scale) + Y.zero_point, 0.0f),
+        255.0f);
+    EXPECT_NEAR(Y.t.data<uint8_t>()[i], expected, 1) << "at " << i;
+  }
+}
+
+} // namespace
+
+TEST(Int8OpTest, QuantizeDequantize) {
+  Workspace ws;
+  auto* X = ws.CreateBlob("X")->GetMutable<TensorCPU>();
+  X->Resize(4, 8);
+  for (int i = 0; i < X->size(); ++i) {
+    X->mutable_data<float>()[i] = 0.05f * i - 0.5f;
+  }
+  RunOperator(
+      CreateOperatorDef(
+          "Int8Quantize",
+          "",
+          {"X"},
+          {"Xq"},
+          {MakeArgument<float>("Y_scale", 0.01f),
+           MakeArgument<int>("Y_zero_point", 60)}),
+      &ws);
+  RunOperator(CreateOperatorDef("Int8Dequantize", "", {"Xq"}, {"Y"}), &ws);
+
+  const auto& Xq = ws.GetBlob("Xq")->Get<int8::Int8TensorCPU>();
+  EXPECT_EQ(Xq.t.dims(), X->dims());
+  const auto& Y = ws.GetBlob("Y")->Get<TensorCPU>();
+  for (int i = 0; i < X->size(); ++i) {
+    const float x = X->data<float>()[i];
+    // Values below -0.6 saturate to 0
+    const float expected = std::max(x, -0.6f);
+    EXPECT_NEAR(Y.data<float>()[i], expected, 0.005f + 1e-6f);
+  }
+}
+
+TEST(Int8OpTest, Conv) {
+  Workspace ws;
+  const int N = 2, H = 5, W = 6, C = 4, M = 6, group = 2, kernel = 3;
+  const auto& X = *AddInt8Input({N, H, W, C}, 0.02f, 128, 1, "X", &ws);
+  const auto& F =
+      *AddInt8Input({M, kernel, kernel, C / group}, 0.01f, 120, 2, "W", &ws);
+  auto* B = ws.CreateBlob("B")->GetMutable<int8::Int8TensorCPU>();
+  B->scale = X.scale * F.scale;
+  B->zero_point = 0;
+  B->t.Resize(M);
+  for (int m = 0; m < M; ++m) {
+    B->t.mutable_data<int32_t>()[m] = 500 * m - 1000;
+  }
+  RunOperator(
+      CreateOperatorDef(
+          "Int8Conv",
+          "",
+          {"X", "W", "B"},
+          {"Y"},
+          {MakeArgument<int>("kernel", kernel),
+           MakeArgument<int>("stride", 2),
+           MakeArgument<int>("pad", 1),
+           MakeArgument<int>("group", group),
+           MakeArgument<string>("order", "NHWC"),
+           MakeArgument<float>("Y_scale", 0.05f),
+           MakeArgument<int>("Y_zero_point", 100)}),
+      &ws);
+
+  const auto& Y = ws.GetBlob("Y")->Get<int8::Int8TensorCPU>();
+  const int out_h = 3, out_w = 3;
+  ASSERT_EQ(Y.t.dims(), vector<TIndex>({N, out_h, out_w, M}));
+  vector<float> reference;
+  for (int n = 0; n < N; ++n) {
+    for (int oh = 0; oh < out_h; ++oh) {
+      for (int ow = 0; ow < out_w; ++ow) {
+        for (int m = 0; m < M; ++m) {
+          const int g = m / (M / group);
+          float value = B->t.data<int32_t>()[m] * B->scale;
+          for (int kh = 0; kh < kernel; ++kh) {
+            for (int kw = 0; kw < kernel; ++kw) {
+              const int h = oh * 2 - 1 + kh;
+              const int w = ow * 2 - 1 + kw;
+              if (h < 0 || h >= H || w < 0 || w >= W) {
+                continue;
+              }
+              for (int c = 0; c < C / group; ++c) {
+                value += Dequantize(
+                             X, ((n * H + h) * W + w) * C + g * C / group + c) *
+                    Dequantize(F, ((m * kernel + kh) * kernel + kw) *
+                                   (C / group) + c);
+              }
+            }
+          }
+          reference.push_back(value);
+        }
+      }
+    }
+  }
+  ExpectQuantized(Y, reference);
+}
+
+TEST(Int8OpTest, ConvReluPointwise) {
+  Workspace ws;
+  const auto& X = *AddInt8Input({1, 3, 3, 20}, 0.02f, 128, 3, "X", &ws);
+  const auto& F = *AddInt8Input({9, 1, 1, 20}, 0.01f, 128, 4, "W", &ws);
+  RunOperator(
+      CreateOperatorDef(
+          "Int8ConvRelu",
+          "",
+          {"X", "W"},
+          {"Y"},
+          {MakeArgument<int>("kernel", 1),
+           MakeArgument<string>("order", "NHWC"),
+           MakeArgument<float>("Y_scale", 0.05f),
+           MakeArgument<int>("Y_zero_point", 100)}),
+      &ws);
+
+  const auto& Y = ws.GetBlob("Y")->Get<int8::Int8TensorCPU>();
+  vector<float> reference;
+  for (int p = 0; p < 9; ++p) {
+    for (int m = 0; m < 9; ++m) {
+      float value = 0;
+      for (int c = 0; c < 20; ++c) {
+        value += Dequantize(X, p * 20 + c) * Dequantize(F, m * 20 + c);
+      }
+      reference.push_back(std::max(value, 0.0f));
+    }
+  }
+  ExpectQuantized(Y, reference);
+}
+
+TEST(Int8OpTest, FC) {
+  Workspace ws;
+  const int M = 5, K = 33, N = 11;
+  const auto& X = *AddInt8Input({M, K}, 0.02f, 130, 5, "X", &ws);
+  const auto& F = *AddInt8Input({N, K}, 0.01f, 125, 6, "W", &ws);
+  RunOperator(
+      CreateOperatorDef(
+          "Int8FC",
+          "",
+          {"X", "W"},
+          {"Y"},
+          {MakeArgument<float>("Y_scale", 0.1f),
+           MakeArgument<int>("Y_zero_point", 128)}),
+      &ws);
+
+  const auto& Y = ws.GetBlob("Y")->Get<int8::Int8TensorCPU>();
+  ASSERT_EQ(Y.t.dims(), vector<TIndex>({M, N}));
+  vector<float> reference;
+  for (int m = 0; m < M; ++m) {
+    for (int n = 0; n < N; ++n) {
+      float value = 0;
+      for (int k = 0; k < K; ++k) {
+        value += Dequantize(X, m * K + k) * Dequantize(F, n * K + k);
+      }
+      reference.push_back(value);
+    }
+  }
+  ExpectQuantized(Y, reference);
+}
+
+TEST(Int8OpTest, FCDynamicQuant) {
+  Workspace ws;
+  const int M = 3, K = 37, N = 13;
+  for (const auto& input : vector<std::pair<string, vector<TIndex>>>{
+           {"X", {M, K}}, {"W", {N, K}}, {"b", {N}}}) {
+    auto* tensor = ws.CreateBlob(input.first)->GetMutable<TensorCPU>();
+    tensor->Resize(input.second);
+    for (int i = 0; i < tensor->size(); ++i) {
+      tensor->mutable_data<float>()[i] = std::sin(i * 0.7f + K) * (i % 5);
+    }
+  }
+  const auto fc = CreateOperatorDef("FC", "", {"X", "W", "b"}, {"Y"});
+  RunOperator(fc, &ws);
+  TensorCPU Y;
+  Y.CopyFrom(ws.GetBlob("Y")->Get<TensorCPU>());
+
+  NetDef net;
+  net.add_op()->CopyFrom(fc);
+  const auto rewritten = int8::RewriteDynamicQuantNet(net);
+  ASSERT_EQ(rewritten.op(0).type(), "FCDynamicQuant");
+  // The weights are packed by the first run and reused by the second
+  for (int run = 0; run < 2; ++run) {
+    RunOperator(rewritten.op(0), &ws);
+    const auto& quantized_Y = ws.GetBlob("Y")->Get<TensorCPU>();
+    ASSERT_EQ(quantized_Y.dims(), Y.dims());
+    // X and W are in [-4, 4], which is quantized with steps of 8 / 255
+    for (int i = 0; i < Y.size(); ++i) {
+      EXPECT_NEAR(quantized_Y.data<float>()[i], Y.data<float>()[i], 0.5f);
+    }
+  }
+}
+
+TEST(Int8OpTest, DynamicQuantStepNet) {
+  NetDef step_net;
+  step_net.add_op()->CopyFrom(CreateOperatorDef(
+      "FC", "", {"hidden_t_prev", "gates_t_w", "gates_t_b"}, {"gates_t"}));
+  step_net.add_op()->CopyFrom(CreateOperatorDef(
+      "LSTMUnit",
+      "",
+      {"hidden_t_prev", "cell_t_prev", "gates_t", "seq_lengths", "timestep"},
+      {"hidden_t", "cell_t"}));
+  NetDef net;
+  net.add_op()->CopyFrom(CreateOperatorDef(
+      "RecurrentNetwork",
+      "",
+      {"input"},
+      {"output"},
+      {MakeArgument<NetDef>("step_net", step_net)}));
+
+  const auto rewritten = int8::RewriteDynamicQuantNet(net);
+  const auto& arg = rewritten.op(0).arg(0);
+  ASSERT_EQ(arg.name(), "step_net");
+  EXPECT_EQ(arg.n().op(0).type(), "FCDynamicQuant");
+  EXPECT_EQ(arg.n().op(1).type(), "LSTMUnit");
+}
+
+TEST(Int8OpTest, AddRelu) {
+  Workspace ws;
+  const auto& A = *AddInt8Input({2, 17}, 0.02f, 128, 7, "A", &ws);
+  const auto& B = *AddInt8Input({2, 17}, 0.03f, 100, 8, "B", &ws);
+  RunOperator(
+      CreateOperatorDef(
+          "Int8Add",
+          "",
+          {"A", "B"},
+          {"Y"},
+          {MakeArgument<float>("Y_scale", 0.04f),
+           MakeArgument<int>("Y_zero_point", 128)}),
+      &ws);
+  RunOperator(CreateOperatorDef("Int8Relu", "", {"Y"}, {"R"}), &ws);
+
+  const auto& Y = ws.GetBlob("Y")->Get<int8::Int8TensorCPU>();
+  const auto& R = ws.GetBlob("R")->Get<int8::Int8TensorCPU>();
+  vector<float> sum;
+  vector<float> relu;
+  for (int i = 0; i < A.t.size(); ++i) {
+    sum.push_back(Dequantize(A, i) + Dequantize(B, i));
+    relu.push_back(std::max(Dequantize(Y, i), 0.0f));
+  }
+  ExpectQuantized(Y, sum);
+  ExpectQuantized(R, relu);
+}
+
+TEST(Int8OpTest, Pool) {
+  Workspace ws;
+  const int H = 4, W = 4, C = 3;
+  const auto& X = *AddInt8Input({1, H, W, C}, 0.02f, 128, 9, "X", &ws);
+  for (const string type : {"Int8MaxPool", "Int8AveragePool"}) {
+    RunOperator(
+        CreateOperatorDef(
+            type,
+            "",
+            {"X"},
+            {"Y"},
+            {MakeArgument<int>("kernel", 3),
+             MakeArgument<int>("stride", 2),
+             MakeArgument<int>("pad", 1),
+             MakeArgument<string>("order", "NHWC")}),
+        &ws);
+    const auto& Y = ws.GetBlob("Y")->Get<int8::Int8TensorCPU>();
+    ASSERT_EQ(Y.t.dims(), vector<TIndex>({1, 2, 2, C}));
+    vector<float> reference;
+    for (int oh = 0; oh < 2; ++oh) {
+      for (int ow = 0; ow < 2; ++ow) {
+        for (int c = 0; c < C; ++c) {
+          float max = -1e10f;
+          float sum = 0;
+          int count = 0;
+          for (int h = std::max(oh * 2 - 1, 0); h < std::min(oh * 2 + 2, H);
+               ++h) {
+            for (int w = std::max(ow * 2 - 1, 0);
+                 w < std::min(ow * 2 + 2, W);
+                 ++w) {
+              const float x = Dequantize(X, (h * W + w) * C + c);
+              max = std::max(max, x);
+              sum += x;
+              ++count;
+            }
+          }
+          reference.push_back(type == "Int8MaxPool" ? max : sum / count);
+        }
+      }
+    }
+    ExpectQuantized(Y, reference);
+  }
+}
+
+TEST(Int8OpTest, Concat) {
+  Workspace ws;
+  const auto& A = *AddInt8Input({2, 3, 2}, 0.02f, 128, 10, "A", &ws);
+  const auto& B = *AddInt8Input({2, 3, 3}, 0.04f, 110, 11, "B", &ws);
+  RunOperator(CreateOperatorDef("Int8Concat", "", {"A", "B"}, {"Y"}), &ws);
+
+  const auto& Y = ws.GetBlob("Y")->Get<int8::Int8TensorCPU>();
+  ASSERT_EQ(Y.t.dims(), vector<TIndex>({2, 3, 5}));
+  EXPECT_EQ(Y.scale, A.scale);
+  EXPECT_EQ(Y.zero_point, A.zero_point);
+  vector<float> reference;
+  for (int i = 0; i < 6; ++i) {
+    for (int j = 0; j < 2; ++j) {
+      reference.push_back(Dequantize(A, i * 2 + j));
+    }
+    for (int j = 0; j < 3; ++j) {
+      reference.push_back(Dequantize(B, i * 3 + j));
+    }
+  }
+  ExpectQuantized(Y, reference);
+}
+
+} // namespace caffe2
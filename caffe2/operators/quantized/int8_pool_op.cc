@@ -0,0 +1,34 @@
+#include "caffe2/operators/quantized/int8_pool_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8MaxPool, int8::Int8PoolOp<true>);
+REGISTER_CPU_OPERATOR(Int8AveragePool, int8::Int8PoolOp<false>);
+
+OPERATOR_SCHEMA(Int8MaxPool)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForPool)
+    .SetDoc(R"DOC(
+Max pooling of the uint8 Int8TensorCPU X in NHWC order. The output has the
+scale and the zero point of the input.
+)DOC")
+    .Arg("order", "Must be NHWC")
+    .Input(0, "X", "Int8TensorCPU of shape (N, H, W, C)")
+    .Output(0, "Y", "Int8TensorCPU of shape (N, out_h, out_w, C)");
+
+OPERATOR_SCHEMA(Int8AveragePool)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .TensorInferenceFunction(ConvPoolOpBase<CPUContext>::TensorInferenceForPool)
+    .SetDoc(R"DOC(
+Average pooling of the uint8 Int8TensorCPU X in NHWC order, where the padding
+isn't averaged, requantized to Y_scale and Y_zero_point.
+)DOC")
+    .Arg("Y_scale", "Scale of the output, the scale of X by default")
+    .Arg("Y_zero_point", "Zero point of the output, the one of X by default")
+    .Arg("order", "Must be NHWC")
+    .Input(0, "X", "Int8TensorCPU of shape (N, H, W, C)")
+    .Output(0, "Y", "Int8TensorCPU of shape (N, out_h, out_w, C)");
+
+} // namespace caffe2
@@ -0,0 +1,103 @@
+#ifndef CAFFE2_OPERATORS_INT8_POOL_OP_H_
+#define CAFFE2_OPERATORS_INT8_POOL_OP_H_
+
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+/**
+ * 2D max or average pooling of uint8 NHWC images. As for MaxPool and
+ * AveragePool, the padding isn't part of the windows. Max pooling keeps the
+ * quantization of the input, and average pooling requantizes to Y_scale and
+ * Y_zero_point, which default to the ones of the input.
+ */
+template <bool Max>
+class Int8PoolOp final : public ConvPoolOpBase<CPUContext> {
+ public:
+  USE_CONV_POOL_BASE_FUNCTIONS(CPUContext);
+  Int8PoolOp(const OperatorDef& operator_def, Workspace* ws)
+      : ConvPoolOpBase<CPUContext>(operator_def, ws) {
+    OPERATOR_NEEDS_FEATURE(
+        order_ == StorageOrder::NHWC, "Int8 pooling only supports NHWC order");
+    CAFFE_ENFORCE_EQ(
+        kernel_.size(), 2, "Int8 pooling only supports 2D pooling");
+    CAFFE_ENFORCE(
+        !Max ||
+            !(OperatorBase::HasArgument("Y_scale") ||
+              OperatorBase::HasArgument("Y_zero_point")),
+        "Int8MaxPool keeps the quantization of the input");
+  }
+
+  bool RunOnDeviceWithOrderNHWC() override {
+    const auto& X = Inputs()[0]->template Get<Int8TensorCPU>();
+    auto* Y = Outputs()[0]->template GetMutable<Int8TensorCPU>();
+    CAFFE_ENFORCE_EQ(X.t.ndim(), 4);
+    const int N = X.t.dim32(0);
+    const int H = X.t.dim32(1);
+    const int W = X.t.dim32(2);
+    const int C = X.t.dim32(3);
+    const float X_scale = X.scale;
+    const int32_t X_zero_point = X.zero_point;
+    ConvPoolOpBase<CPUContext>::SetOutputSize(X.t, &(Y->t), C);
+    Y->scale = OperatorBase::GetSingleArgument<float>("Y_scale", X_scale);
+    Y->zero_point =
+        OperatorBase::GetSingleArgument<int>("Y_zero_point", X_zero_point);
+    CAFFE_ENFORCE_GT(Y->scale, 0);
+    const int out_h = Y->t.dim32(1);
+    const int out_w = Y->t.dim32(2);
+    const float multiplier = X_scale / Y->scale;
+
+    const uint8_t* X_data = X.t.template data<uint8_t>();
+    uint8_t* Y_data = Y->t.template mutable_data<uint8_t>();
+    std::vector<int32_t> acc(C);
+    for (int n = 0; n < N; ++n) {
+      const uint8_t* X_image = X_data + n * H * W * C;
+      for (int oh = 0; oh < out_h; ++oh) {
+        const int h_begin = std::max(oh * stride_h() - pad_t(), 0);
+        const int h_end = std::min(oh * stride_h() - pad_t() + kernel_h(), H);
+        for (int ow = 0; ow < out_w; ++ow) {
+          const int w_begin = std::max(ow * stride_w() - pad_l(), 0);
+          const int w_end =
+              std::min(ow * stride_w() - pad_l() + kernel_w(), W);
+          std::fill(acc.begin(), acc.end(), 0);
+          for (int h = h_begin; h < h_end; ++h) {
+            for (int w = w_begin; w < w_end; ++w) {
+              const uint8_t* x = X_image + (h * W + w) * C;
+              for (int c = 0; c < C; ++c) {
+                acc[c] = Max ? std::max<int32_t>(acc[c], x[c]) : acc[c] + x[c];
+              }
+            }
+          }
+          uint8_t* y = Y_data + ((n * out_h + oh) * out_w + ow) * C;
+          if (Max) {
+            for (int c = 0; c < C; ++c) {
+              y[c] = static_cast<uint8_t>(acc[c]);
+            }
+          } else {
+            const int count = (h_end - h_begin) * (w_end - w_begin);
+            const float scale = multiplier / std::max(count, 1);
+            for (int c = 0; c < C; ++c) {
+              y[c] = QuantizeUint8(
+                  1.0f, Y->zero_point, (acc[c] - count * X_zero_point) * scale);
+            }
+          }
+        }
+      }
+    }
+    return true;
+  }
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_POOL_OP_H_
@@ -0,0 +1,20 @@
+#include "caffe2/operators/quantized/int8_quantize_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Quantize, int8::Int8QuantizeOp);
+
+OPERATOR_SCHEMA(Int8Quantize)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .SetDoc(R"DOC(
+Quantizes the float tensor X to the uint8 Int8TensorCPU Y with the scale
+Y_scale and the zero point Y_zero_point, i.e.
+Y = clamp(round(X / Y_scale) + Y_zero_point, 0, 255).
+)DOC")
+    .Arg("Y_scale", "Scale of the output")
+    .Arg("Y_zero_point", "Zero point of the output, in [0, 255]")
+    .Input(0, "X", "Float tensor")
+    .Output(0, "Y", "Int8TensorCPU");
+
+} // namespace caffe2
@@ -0,0 +1,47 @@
+#ifndef CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
+#define CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+class Int8QuantizeOp final : public Operator<CPUContext> {
+ public:
+  Int8QuantizeOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        Y_scale_(OperatorBase::GetSingleArgument<float>("Y_scale", 1.0f)),
+        Y_zero_point_(
+            OperatorBase::GetSingleArgument<int>("Y_zero_point", 0)) {
+    CAFFE_ENFORCE_GT(Y_scale_, 0);
+    CAFFE_ENFORCE(Y_zero_point_ >= 0 && Y_zero_point_ <= 255);
+  }
+
+  bool RunOnDevice() override {
+    const auto& X = Input(0);
+    auto* Y = Outputs()[0]->template GetMutable<Int8TensorCPU>();
+    Y->t.ResizeLike(X);
+    Y->scale = Y_scale_;
+    Y->zero_point = Y_zero_point_;
+    const float* X_data = X.data<float>();
+    uint8_t* Y_data = Y->t.mutable_data<uint8_t>();
+    for (int i = 0; i < X.size(); ++i) {
+      Y_data[i] = QuantizeUint8(Y_scale_, Y_zero_point_, X_data[i]);
+    }
+    return true;
+  }
+
+ private:
+  float Y_scale_;
+  int32_t Y_zero_point_;
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_QUANTIZE_OP_H_
@@ -0,0 +1,18 @@
+#include "caffe2/operators/quantized/int8_relu_op.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(Int8Relu, int8::Int8ReluOp);
+
+OPERATOR_SCHEMA(Int8Relu)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .SetDoc(R"DOC(
+Relu of the uint8 Int8TensorCPU X, i.e. Y = max(X, X.zero_point). The output
+has the scale and the zero point of the input.
+)DOC")
+    .Input(0, "X", "Int8TensorCPU")
+    .Output(0, "Y", "Int8TensorCPU");
+
+} // namespace caffe2
@@ -0,0 +1,41 @@
+#ifndef CAFFE2_OPERATORS_INT8_RELU_OP_H_
+#define CAFFE2_OPERATORS_INT8_RELU_OP_H_
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/operators/quantized/int8_utils.h"
+
+namespace caffe2 {
+
+namespace int8 {
+
+class Int8ReluOp final : public Operator<CPUContext> {
+ public:
+  Int8ReluOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    const auto& X = Inputs()[0]->template Get<Int8TensorCPU>();
+    auto* Y = Outputs()[0]->template GetMutable<Int8TensorCPU>();
+    // The zero point is the quantized zero, and the output keeps the
+    // quantization of the input
+    const uint8_t zero = static_cast<uint8_t>(
+        std::min(std::max(X.zero_point, 0), 255));
+    Y->scale = X.scale;
+    Y->zero_point = X.zero_point;
+    Y->t.ResizeLike(X.t);
+    const uint8_t* X_data = X.t.data<uint8_t>();
+    uint8_t* Y_data = Y->t.mutable_data<uint8_t>();
+    for (int i = 0; i < X.t.size(); ++i) {
+      Y_data[i] = std::max(X_data[i], zero);
+    }
+    return true;
+  }
+};
+
+} // namespace int8
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_RELU_OP_H_
@@ -0,0 +1,133 @@
+#ifndef CAFFE2_OPERATORS_INT8_UTILS_H_
+#define CAFFE2_OPERATORS_INT8_UTILS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "caffe2/core/tensor_int8.h"
+#include "caffe2/perfkernels/int8_gemm.h"
+
+namespace caffe2 {
+namespace int8 {
+
+/*
+ * Int8 operators work on Int8TensorCPU with uint8 data, where the real value
+ * of a quantized value q is scale * (q - zero_point). The quantization of
+ * the output is given by the Y_scale and Y_zero_point arguments of the
+ * operators.
+ */
+
+inline uint8_t QuantizeUint8(float scale, int32_t zero_point, float value) {
+  const float q = std::nearbyint(value / scale) + zero_point;
+  return static_cast<uint8_t>(std::min(std::max(q, 0.0f), 255.0f));
+}
+
+inline float DequantizeUint8(float scale, int32_t zero_point, uint8_t value) {
+  return scale * (static_cast<int32_t>(value) - zero_point);
+}
+
+// Quantization of a blob, i.e. real = scale * (q - zero_point)
+struct Int8QuantizationParams {
+  float scale{1.0f};
+  int32_t zero_point{0};
+};
+
+// Quantization params of uint8 values covering [min, max], which is extended
+// to contain zero so that zero is exactly representable, e.g. for padding
+inline Int8QuantizationParams ChooseInt8QuantizationParams(
+    float min,
+    float max) {
+  min = std::min(min, 0.0f);
+  max = std::max(max, 0.0f);
+  Int8QuantizationParams params;
+  if (max - min <= 0) {
+    return params;
+  }
+  params.scale = (max - min) / 255;
+  params.zero_point = static_cast<int32_t>(
+      std::min(std::max(std::round(-min / params.scale), 0.0f), 255.0f));
+  return params;
+}
+
+// Requantization of the accumulators of X * W to Y, with the minimum of the
+// output raised to the zero point for a fused Relu
+inline Int8GemmOutputStage GetOutputStage(
+    float X_scale,
+    float W_scale,
+    float Y_scale,
+    int32_t Y_zero_point,
+    bool relu) {
+  Int8GemmOutputStage output;
+  QuantizeMultiplierSmallerThanOne(
+      static_cast<double>(X_scale) * W_scale / Y_scale,
+      &output.multiplier,
+      &output.shift);
+  output.zero_point = Y_zero_point;
+  output.min = relu ? std::min(std::max(Y_zero_point, 0), 255) : 0;
+  output.max = 255;
+  return output;
+}
+
+// The bias of Int8Conv and Int8FC is int32 with the scale of the products,
+// i.e. X_scale * W_scale, and a zero point of 0
+inline const int32_t* GetBias(
+    const Int8TensorCPU& B,
+    float X_scale,
+    float W_scale,
+    int size) {
+  CAFFE_ENFORCE(B.t.IsType<int32_t>(), "The bias must be int32");
+  CAFFE_ENFORCE_EQ(B.t.size(), size);
+  CAFFE_ENFORCE_EQ(B.zero_point, 0, "The bias must have a zero point of 0");
+  CAFFE_ENFORCE_LE(
+      std::fabs(B.scale - X_scale * W_scale),
+      1e-4 * X_scale * W_scale,
+      "The scale of the bias must be X_scale * W_scale");
+  return B.t.data<int32_t>();
+}
+
+/**
+ * The weights of Int8Conv and Int8FC as an M x K matrix, split into groups of
+ * rows and packed for Int8Gemm. They are packed the first time the operator
+ * runs, and again only when the data of the weights moves or is reshaped,
+ * i.e. the weights are expected to be constants.
+ */
+class Int8PackedWeights {
+ public:
+  const std::vector<PackedInt8Matrix>&
+  Get(const Int8TensorCPU& W, int M, int K, int group) {
+    CAFFE_ENFORCE_EQ(W.t.size(), static_cast<TIndex>(M) * K);
+    if (W.t.raw_data() != data_ || W.t.dims() != dims_ ||
+        W.zero_point != zero_point_ || packed_.size() != group) {
+      CAFFE_ENFORCE_EQ(M % group, 0);
+      const int M_group = M / group;
+      const uint8_t* W_data = W.t.data<uint8_t>();
+      packed_.resize(group);
+      for (int g = 0; g < group; ++g) {
+        PackInt8Matrix(
+            M_group,
+            K,
+            W_data + g * M_group * K,
+            K,
+            W.zero_point,
+            &packed_[g]);
+      }
+      data_ = W.t.raw_data();
+      dims_ = W.t.dims();
+      zero_point_ = W.zero_point;
+    }
+    return packed_;
+  }
+
+ private:
+  const void* data_{nullptr};
+  std::vector<TIndex> dims_;
+  int32_t zero_point_{0};
+  std::vector<PackedInt8Matrix> packed_;
+};
+
+} // namespace int8
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_INT8_UTILS_H_
@@ -23,6 +23,9 @@ std::unique_ptr<RecurrentNetworkExecutorBase> createRNNExecutor<CPUContext>(
     exec->setNumThreads(num_threads);
     LOG(INFO) << "Set num threads: " << num_threads;
   }
+  exec->SetWavefront(
+      rnn_args.GetSingleArgument<int>("rnn_executor.wavefront", 0),
+      rnn_args.GetSingleArgument<int>("rnn_executor.max_parallelism", 0));
   exec->debug_ = rnn_args.GetSingleArgument<int>("rnn_executor_debug", 0);
   return std::unique_ptr<RecurrentNetworkExecutorBase>(exec);
 }
@@ -34,6 +37,9 @@ bool ThreadedRecurrentNetworkExecutor::Run(int T) {
   CAFFE_ENFORCE(timestep_ops_.size() >= T);
   countdown_ = T * timestep_ops_[0].size();
   finished_timesteps_ = 0;
+  wavefront_ops_left_.assign(T, timestep_ops_[0].size());
+  wavefront_deferred_.assign(T, std::vector<OpTask>());
+  wavefront_finished_ = 0;
 
   CHECK(task_queue_.size() == 0);
 
@@ -55,6 +61,9 @@ bool ThreadedRecurrentNetworkExecutor::RunBackwards(int T) {
   CAFFE_ENFORCE(timestep_ops_.size() >= T);
   countdown_ = T * timestep_ops_[0].size();
   finished_timesteps_ = 0;
+  wavefront_ops_left_.assign(T, timestep_ops_[0].size());
+  wavefront_deferred_.assign(T, std::vector<OpTask>());
+  wavefront_finished_ = 0;
 
   // Frontier
   CHECK(task_queue_.size() == 0);
@@ -128,6 +137,10 @@ void ThreadedRecurrentNetworkExecutor::RunOp(OpTask job, int /*thread_id*/) {
     }
   }
 
+  if (wavefront_) {
+    WavefrontFinished(job);
+  }
+
   // Decrement countdown: when at zero, we have run all ops and can
   // notify the caller thread.
   if (countdown_.fetch_sub(1) == 1) {
@@ -137,6 +150,46 @@ void ThreadedRecurrentNetworkExecutor::RunOp(OpTask job, int /*thread_id*/) {
   }
 }
 
+/**
+ * Timesteps that share step workspaces can't run at the same time, so with
+ * wavefront scheduling a timestep only starts once all the timesteps that
+ * are max_parallel_timesteps_ or more before it have run all their ops.
+ */
+bool ThreadedRecurrentNetworkExecutor::WavefrontReady(const OpTask& job) {
+  if (max_parallel_timesteps_ <= 0) {
+    return true;
+  }
+  int step = job.forward() ? job.timestep : job.T - 1 - job.timestep;
+  std::lock_guard<std::mutex> lock(wavefront_mtx_);
+  if (step - wavefront_finished_ < max_parallel_timesteps_) {
+    return true;
+  }
+  wavefront_deferred_[step].push_back(job);
+  return false;
+}
+
+void ThreadedRecurrentNetworkExecutor::WavefrontFinished(const OpTask& job) {
+  int step = job.forward() ? job.timestep : job.T - 1 - job.timestep;
+  std::lock_guard<std::mutex> lock(wavefront_mtx_);
+  if (--wavefront_ops_left_[step] > 0) {
+    return;
+  }
+  while (wavefront_finished_ < job.T &&
+         wavefront_ops_left_[wavefront_finished_] == 0) {
+    wavefront_finished_++;
+    if (max_parallel_timesteps_ <= 0) {
+      continue;
+    }
+    int next = wavefront_finished_ + max_parallel_timesteps_ - 1;
+    if (next < job.T) {
+      for (const auto& task : wavefront_deferred_[next]) {
+        task_queue_.Push(task);
+      }
+      wavefront_deferred_[next].clear();
+    }
+  }
+}
+
 /**
  * Run-loop for executor threads: pop tasks from task_queue and execute
  * them with RunOp().
@@ -152,9 +205,13 @@ void ThreadedRecurrentNetworkExecutor::WorkerFunction() {
       break;
     }
 
-    // Check for limited timestep parallelism, and if too many timesteps would
-    // be started concurrently, return the task to task queue.
-    if (max_parallel_timesteps_ > 0) {
+    if (wavefront_) {
+      if (!WavefrontReady(job)) {
+        continue;
+      }
+    } else if (max_parallel_timesteps_ > 0) {
+      // Check for limited timestep parallelism, and if too many timesteps
+      // would be started concurrently, return the task to task queue.
       int t = (job.direction == 1 ? job.timestep : job.T - job.timestep + 1);
       if (t - finished_timesteps_ >= max_parallel_timesteps_) {
         // Return to queue
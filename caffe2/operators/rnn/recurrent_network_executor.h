@@ -1,6 +1,7 @@
 #ifndef CAFFE2_OPERATORS_RECURRENT_NETWORK_EXECUTOR_H_
 #define CAFFE2_OPERATORS_RECURRENT_NETWORK_EXECUTOR_H_
 
+#include <algorithm>
 #include <map>
 #include <unordered_set>
 #include <vector>
@@ -67,28 +68,7 @@ class RecurrentNetworkExecutorBase {
       Workspace* ws,
       const std::vector<std::unique_ptr<ObserverBase<OperatorBase>>>&
           observers_list) {
-    if (timestep_ops_template_.size() == 0) {
-      // Firsrt invocation -- compute dependencies
-      CalculateInternalDependencies();
-
-      // Label ops based on whether they contain reference to the timestep
-      // blob. This is an optimization to avoid string comparisons later.
-      for (auto& rnn_op : timestep_ops_template_) {
-        rnn_op.has_timestep_blob = false;
-        const OperatorDef& op = step_net_def_.op(rnn_op.order);
-        for (int i = 0; i < op.input_size(); i++) {
-          if (op.input(i) == timestep_blob_) {
-            rnn_op.has_timestep_blob = true;
-            break;
-          }
-        }
-        CAFFE_ENFORCE(
-            !HasOutput(op, timestep_blob_),
-            "Timestep cannot be output of an op: ",
-            timestep_blob_,
-            " op=" + ProtoDebugString(op));
-      }
-    }
+    EnsureDependenciesCalculated();
 
     // Initialize timestep if it is not initialized
     if (timestep_ops_.size() <= t ||
@@ -177,6 +157,90 @@ class RecurrentNetworkExecutorBase {
     max_parallel_timesteps_ = p;
   }
 
+  /**
+   * Enables wavefront scheduling. Timesteps then start as soon as the
+   * dependencies between the ops of the unrolled step nets allow: with
+   * stacked recurrent layers, step t of layer l + 1 runs alongside step t + 1
+   * of layer l. At most ParallelTimesteps() timesteps run at the same time,
+   * and the executor keeps track of which ones have finished to start the
+   * next ones.
+   *
+   * max_parallelism limits the number of timesteps in flight if positive,
+   * with or without wavefront scheduling.
+   */
+  void SetWavefront(bool wavefront, int max_parallelism) {
+    wavefront_ = wavefront;
+    max_parallelism_ = max_parallelism;
+    if (max_parallelism_ > 0) {
+      max_parallel_timesteps_ = max_parallelism_;
+    }
+  }
+
+  /**
+   * Number of timesteps that forward-only execution runs at the same time,
+   * and so the number of step workspaces it cycles over.
+   */
+  int ParallelTimesteps() {
+    if (!wavefront_) {
+      return max_parallelism_ > 0 ? max_parallelism_ : 4;
+    }
+    // One more than the width, as the ops at the end of a timestep (such
+    // as its links) still run when the next wavefront starts.
+    int width = WavefrontWidth() + 1;
+    if (max_parallelism_ > 0) {
+      width = std::min(width, max_parallelism_);
+    }
+    return width;
+  }
+
+  /**
+   * Width of the wavefront over the unrolled step nets: the largest number
+   * of timesteps that have ops ready to run at the same time when every op
+   * starts as soon as its dependencies finish. For a stack of L recurrent
+   * layers, this is L.
+   */
+  int WavefrontWidth() {
+    EnsureDependenciesCalculated();
+    if (wavefront_width_ > 0) {
+      return wavefront_width_;
+    }
+
+    // Earliest start of every op, in number of ops on its longest chain of
+    // dependencies, over enough timesteps for the wavefront to settle.
+    const int num_ops = timestep_ops_template_.size();
+    const int num_timesteps = num_ops + 1;
+    std::vector<std::vector<int>> level(
+        num_timesteps, std::vector<int>(num_ops));
+    std::map<int, std::unordered_set<int>> timesteps_at_level;
+    for (int t = 0; t < num_timesteps; t++) {
+      for (auto& rnn_op : timestep_ops_template_) {
+        const int i = rnn_op.order;
+        int l = 0;
+        for (int parent : rnn_op.parents) {
+          // Parents after the op are from the previous timestep
+          if (parent < i) {
+            l = std::max(l, level[t][parent] + 1);
+          } else if (t > 0) {
+            l = std::max(l, level[t - 1][parent] + 1);
+          }
+        }
+        level[t][i] = l;
+        // Link ops only alias blobs, and often have no dependencies at all
+        if (!rnn_op.link_op) {
+          timesteps_at_level[l].insert(t);
+        }
+      }
+    }
+
+    wavefront_width_ = 1;
+    for (const auto& it : timesteps_at_level) {
+      wavefront_width_ =
+          std::max(wavefront_width_, static_cast<int>(it.second.size()));
+    }
+    VLOG(1) << "Wavefront width of the step net: " << wavefront_width_;
+    return wavefront_width_;
+  }
+
   size_t NumObserversStepNet() {
     size_t num = 0;
     for (auto& ops_at_timestep_t : timestep_ops_) {
@@ -188,6 +252,32 @@ class RecurrentNetworkExecutorBase {
   }
 
  private:
+  void EnsureDependenciesCalculated() {
+    if (timestep_ops_template_.size() > 0) {
+      return;
+    }
+    // First invocation -- compute dependencies
+    CalculateInternalDependencies();
+
+    // Label ops based on whether they contain reference to the timestep
+    // blob. This is an optimization to avoid string comparisons later.
+    for (auto& rnn_op : timestep_ops_template_) {
+      rnn_op.has_timestep_blob = false;
+      const OperatorDef& op = step_net_def_.op(rnn_op.order);
+      for (int i = 0; i < op.input_size(); i++) {
+        if (op.input(i) == timestep_blob_) {
+          rnn_op.has_timestep_blob = true;
+          break;
+        }
+      }
+      CAFFE_ENFORCE(
+          !HasOutput(op, timestep_blob_),
+          "Timestep cannot be output of an op: ",
+          timestep_blob_,
+          " op=" + ProtoDebugString(op));
+    }
+  }
+
   // Utility method to check if any of the op inputs or control inputs
   // contain given blob 'input'
   bool has_input(std::string x, int opidx) {
@@ -455,6 +545,10 @@ class RecurrentNetworkExecutorBase {
 
   int max_parallel_timesteps_ = -1;
 
+  bool wavefront_ = false;
+  int max_parallelism_ = 0;
+  int wavefront_width_ = 0;
+
  public:
   bool debug_ = false;
 };
@@ -504,6 +598,14 @@ class ThreadedRecurrentNetworkExecutor : public RecurrentNetworkExecutorBase {
 
   void RunOp(OpTask job, int thread_id);
 
+  // Wavefront scheduling: returns false and puts job aside if its timestep
+  // can't start until earlier ones finish.
+  bool WavefrontReady(const OpTask& job);
+
+  // Wavefront scheduling: accounts for job having run, and schedules the
+  // tasks put aside for the timesteps this lets start.
+  void WavefrontFinished(const OpTask& job);
+
   SimpleQueue<OpTask> task_queue_;
   std::atomic<int> countdown_;
   std::atomic<bool> failed_;
@@ -513,6 +615,13 @@ class ThreadedRecurrentNetworkExecutor : public RecurrentNetworkExecutorBase {
   std::condition_variable cv_;
   std::vector<std::thread> workers_;
   int num_threads_ = 4;
+
+  // Wavefront scheduling state, indexed by the order in which the timesteps
+  // run (reversed on backward), guarded by wavefront_mtx_.
+  std::mutex wavefront_mtx_;
+  std::vector<int> wavefront_ops_left_;
+  std::vector<std::vector<OpTask>> wavefront_deferred_;
+  int wavefront_finished_ = 0;
 };
 
 } // namespace caffe2
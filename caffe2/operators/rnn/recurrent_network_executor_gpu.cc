@@ -17,6 +17,9 @@ std::unique_ptr<RecurrentNetworkExecutorBase> createRNNExecutor<CUDAContext>(
     exec->setMaxStreams(max_streams);
     LOG(INFO) << "Set max streams:" << max_streams;
   }
+  exec->SetWavefront(
+      arg_helper.GetSingleArgument<int>("rnn_executor.wavefront", 0),
+      arg_helper.GetSingleArgument<int>("rnn_executor.max_parallelism", 0));
   std::unique_ptr<RecurrentNetworkExecutorBase> ptr(exec);
   return ptr;
 }
@@ -41,6 +44,13 @@ void CUDARecurrentNetworkExecutor::_ExecRange(int from, int to) {
   int max_streams = max_parallel_timesteps_ > 0 ?
                     std::min(max_parallel_timesteps_, max_cuda_streams_)
                     : max_cuda_streams_;
+  if (wavefront_) {
+    // One stream per timestep of the wavefront, so that each layer of a
+    // stack can run its step on its own stream. Within a stream, timesteps
+    // run in order, which is what forward-only execution needs to reuse
+    // step workspaces.
+    max_streams = ParallelTimesteps();
+  }
   int stream_seq = 0;
   int num_ops = timestep_ops_[0].size();
 
@@ -330,8 +330,10 @@ class RecurrentNetworkOp final : public Operator<Context> {
 
     // In forward-only mode, we cycle over workspaces. This limits the amount
     // of parallelism over timesteps that the RNNExecutor provides. So with
-    // RNN executor we use more workspaces to get better perf.
-    int num_workspaces_on_fwd_only = rnnExecutor_ ? 4 : 2;
+    // RNN executor we use more workspaces to get better perf, as many as
+    // the timesteps it runs at the same time.
+    int num_workspaces_on_fwd_only =
+        rnnExecutor_ ? rnnExecutor_->ParallelTimesteps() : 2;
 
     if (!has_backward_pass && stepWorkspaces.size() < num_workspaces_on_fwd_only) {
       // Use alternating stepWorkspaces when forward_only=True.
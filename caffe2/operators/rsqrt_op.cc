@@ -40,6 +40,7 @@ REGISTER_CPU_OPERATOR(
 OPERATOR_SCHEMA(Rsqrt)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<2>)
     .AllowInplace({{0, 0}})
     .IdenticalTypeAndShape()
     .SetDoc("Computes the element-wise rsqrt of the input.")
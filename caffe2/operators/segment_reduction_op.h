@@ -1887,6 +1887,38 @@ struct LengthsOpGetGradient : public GradientMakerBase {
   }
 };
 
+// Cost of the Lengths{op} and SparseLengths{op} ops: reducing the slices of
+// DATA (the ones pulled in by INDICES if it has some) into len(LENGTHS)
+// segments, with one operation per element and input of the reducer.
+inline OpSchema::Cost CostInferenceForLengthsReduction(
+    const vector<TensorShape>& in,
+    int reducerInputCount,
+    bool sparse) {
+  struct OpSchema::Cost c;
+  const auto& data = in[0];
+  if (data.dims_size() == 0) {
+    return c;
+  }
+  const auto& lengths = in[reducerInputCount + (sparse ? 1 : 0)];
+  const uint64_t block = size_from_dim_(1, GetDimsVector(data));
+  const uint64_t nSlices =
+      sparse ? nElemFromDim(in[reducerInputCount]) : data.dims(0);
+  const uint64_t nSegments = nElemFromDim(lengths);
+
+  c.flops = nSlices * block * reducerInputCount;
+  c.bytes_read = nSlices * block * sizeof(data.data_type()) +
+      nSegments * sizeof(lengths.data_type());
+  for (int i = 1; i < reducerInputCount; ++i) {
+    c.bytes_read += nElemFromDim(in[i]) * sizeof(in[i].data_type());
+  }
+  if (sparse) {
+    c.bytes_read += nSlices * sizeof(in[reducerInputCount].data_type());
+  }
+  c.bytes_written = nSegments * block * sizeof(data.data_type());
+  c.params_bytes = 0;
+  return c;
+}
+
 template <
     typename T,
     typename SIndex,
@@ -1936,6 +1968,11 @@ segments, i.e. len(*LENGTHS*).
           out.push_back(output);
           return out;
         });
+    schema.CostInferenceFunction(
+        [](const OperatorDef& /* unused */, const vector<TensorShape>& in) {
+          return CostInferenceForLengthsReduction(
+              in, Reducer::kInputCount, false);
+        });
     ReducerDef::PopulateSchema(schema);
   }
   using Reducer = typename ReducerDef::template Reducer<T, Context>;
@@ -2007,6 +2044,11 @@ i.e. `len(LENGTHS)`. Other dimensions are inherited from the input tensor.
         "OUTPUT",
         "Aggregated output tensor. Has the first dimension of K "
         "(the number of segments).");
+    schema.CostInferenceFunction(
+        [](const OperatorDef& /* unused */, const vector<TensorShape>& in) {
+          return CostInferenceForLengthsReduction(
+              in, Reducer::kInputCount, true);
+        });
     ReducerDef::PopulateSchema(schema);
   }
   using Reducer = typename ReducerDef::template Reducer<T, Context>;
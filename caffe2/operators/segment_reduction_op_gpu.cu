@@ -39,47 +39,6 @@ void inclusive_scan_wrapper(
       context_->cuda_stream());
 }
 
-template <typename T, bool ExactBlock = false, bool Average = false>
-__global__ void length_sum_kernel(
-    const T* __restrict__ in,
-    T* __restrict__ out,
-    const int* __restrict__ prefix_sum_length_data,
-    int N,
-    int post,
-    int len_length) {
-  // len_length blocks
-  int group = blockIdx.x;
-
-  int start = group == 0 ? 0 : prefix_sum_length_data[group - 1];
-  int end = prefix_sum_length_data[group];
-  CUDA_KERNEL_ASSERT(start <= N);
-  CUDA_KERNEL_ASSERT(end <= N);
-
-  if (ExactBlock) {
-    in += threadIdx.x;
-
-    T sum = (T)0;
-    for (int line = start; line < end; ++line) {
-      sum += in[line * post];
-    }
-    if (Average && (end - start) > 1) {
-      sum /= (end - start);
-    }
-    out[group * post + threadIdx.x] = sum;
-  } else {
-    for (int i = threadIdx.x; i < post; i += blockDim.x) {
-      T sum = (T)0;
-      for (int line = start; line < end; ++line) {
-        sum += in[line * post + i];
-      }
-      if (Average && (end - start) > 1) {
-        sum /= (end - start);
-      }
-      out[group * post + i] = sum;
-    }
-  }
-}
-
 template <typename T, bool ExactBlock = false, bool Average = false>
 __global__ void length_sum_gradient_kernel(
     const T* __restrict__ grad_in,
@@ -235,66 +194,6 @@ __global__ void length_weighted_sum_with_main_input_gradient_kernel(
   }
 }
 
-template <
-    typename T,
-    typename IndexType,
-    bool ExactBlock = false,
-    bool Average = false>
-__global__ void sparse_length_sum_kernel(
-    const T* __restrict__ in,
-    T* __restrict__ out,
-    const int* __restrict__ prefix_sum_length_data,
-    const IndexType* __restrict__ indices,
-    int N,
-    int post,
-    int len_length,
-    int len_indices) {
-  // len_length blocks
-  int group = blockIdx.x;
-
-  int start = group == 0 ? 0 : prefix_sum_length_data[group - 1];
-  int end = prefix_sum_length_data[group];
-  CUDA_KERNEL_ASSERT(start <= len_indices);
-  CUDA_KERNEL_ASSERT(end <= len_indices);
-
-  extern __shared__ T reduceVals[];
-
-  if (ExactBlock) {
-    T sum = (T)0;
-
-    in += threadIdx.x;
-    for (int line = start + threadIdx.y; line < end; line += blockDim.y) {
-      sum += in[indices[line] * post];
-    }
-
-    reduceVals[threadIdx.y * blockDim.x + threadIdx.x] = sum;
-    __syncthreads();
-
-    if (threadIdx.y == 0) {
-      sum = (T)0;
-      for (int i = 0; i < blockDim.y; ++i) {
-        sum += reduceVals[i * blockDim.x + threadIdx.x];
-      }
-      if (Average && (end - start) > 1) {
-        sum /= (end - start);
-      }
-
-      out[group * post + threadIdx.x] = sum;
-    }
-  } else {
-    for (int i = threadIdx.x; i < post; i += blockDim.x) {
-      T sum = (T)0;
-      for (int line = start; line < end; ++line) {
-        sum += in[indices[line] * post + i];
-      }
-      if (Average && (end - start) > 1) {
-        sum /= (end - start);
-      }
-      out[group * post + i] = sum;
-    }
-  }
-}
-
 template <typename T, typename IndexType, bool ExactBlock = false>
 __global__ void sparse_length_max_kernel(
     const T* __restrict__ in,
@@ -353,55 +252,161 @@ __global__ void sparse_length_max_kernel(
   }
 }
 
-template <typename T, typename IndexType, bool ExactBlock = false>
-__global__ void sparse_length_weighted_sum_kernel(
+// The (weighted) sums of segments are load balanced over the lines to reduce
+// rather than over the segments, so that a few very long segments among many
+// short ones don't leave most of the GPU idle: the lines are split into tiles
+// of kSegmentTileLines and each thread sums one column of one tile. The
+// segments that lie in a single tile are written right away; the others leave
+// a partial sum in the tile, which balanced_length_sum_fixup_kernel adds up
+// in tile order, so the result doesn't depend on the scheduling.
+constexpr int kSegmentTileLines = 32;
+constexpr int kSegmentBlockThreads = 128;
+
+// Each tile has two slots of post partial sums: the head slot holds the sum
+// of the segment that started before the tile and the tail slot the one of
+// the segment that started in the tile and ends after it. A null indices
+// reduces the lines of in themselves and a null weights weighs them by 1.
+template <typename T, typename IndexType, bool Average>
+__global__ void balanced_length_sum_kernel(
     const T* __restrict__ in,
-    const T* __restrict__ in_weights,
+    const T* __restrict__ weights,
     T* __restrict__ out,
+    T* __restrict__ partials,
     const int* __restrict__ prefix_sum_length_data,
     const IndexType* __restrict__ indices,
-    int N,
     int post,
     int len_length,
-    int len_indices) {
-  // len_length blocks
-  int group = blockIdx.x;
-
-  int start = group == 0 ? 0 : prefix_sum_length_data[group - 1];
-  int end = prefix_sum_length_data[group];
-  CUDA_KERNEL_ASSERT(start <= len_indices);
-  CUDA_KERNEL_ASSERT(end <= len_indices);
-
-  extern __shared__ T reduceVals[];
+    int len_indices,
+    int num_tiles) {
+  const int tile = blockIdx.x * blockDim.y + threadIdx.y;
+  const int col = blockIdx.y * blockDim.x + threadIdx.x;
+  if (tile >= num_tiles || col >= post) {
+    return;
+  }
+  const int line_begin = tile * kSegmentTileLines;
+  const int line_end = min(line_begin + kSegmentTileLines, len_indices);
+
+  // first segment that ends after line_begin
+  int lo = 0;
+  int hi = len_length;
+  while (lo < hi) {
+    const int mid = (lo + hi) / 2;
+    if (prefix_sum_length_data[mid] <= line_begin) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
 
-  if (ExactBlock) {
+  int line = line_begin;
+  for (int seg = lo; seg < len_length && line < line_end; ++seg) {
+    const int seg_start = seg == 0 ? 0 : prefix_sum_length_data[seg - 1];
+    const int seg_end = prefix_sum_length_data[seg];
+    CUDA_KERNEL_ASSERT(seg_end <= len_indices);
+    const int stop = min(seg_end, line_end);
     T sum = (T)0;
-
-    in += threadIdx.x;
-    for (int line = start + threadIdx.y; line < end; line += blockDim.y) {
-      sum += in_weights[line] * in[indices[line] * post];
+    for (; line < stop; ++line) {
+      const TIndex row = indices ? (TIndex)indices[line] : (TIndex)line;
+      const T value = in[row * post + col];
+      sum += weights ? weights[line] * value : value;
     }
-
-    reduceVals[threadIdx.y * blockDim.x + threadIdx.x] = sum;
-    __syncthreads();
-
-    if (threadIdx.y == 0) {
-      sum = (T)0;
-      for (int i = 0; i < blockDim.y; ++i) {
-        sum += reduceVals[i * blockDim.x + threadIdx.x];
+    if (seg_start < line_begin) {
+      partials[(2 * tile) * post + col] = sum;
+    } else if (seg_end > line_end) {
+      partials[(2 * tile + 1) * post + col] = sum;
+    } else {
+      if (Average && (seg_end - seg_start) > 1) {
+        sum /= (seg_end - seg_start);
       }
+      out[seg * post + col] = sum;
+    }
+  }
+}
 
-      out[group * post + threadIdx.x] = sum;
+// Writes the segments that balanced_length_sum_kernel left partial or didn't
+// reach, i.e. the ones that span several tiles and the empty ones.
+template <typename T, bool Average>
+__global__ void balanced_length_sum_fixup_kernel(
+    T* __restrict__ out,
+    const T* __restrict__ partials,
+    const int* __restrict__ prefix_sum_length_data,
+    int post,
+    int len_length) {
+  CUDA_1D_KERNEL_LOOP(i, len_length * post) {
+    const int seg = i / post;
+    const int col = i % post;
+    const int seg_start = seg == 0 ? 0 : prefix_sum_length_data[seg - 1];
+    const int seg_end = prefix_sum_length_data[seg];
+    if (seg_end <= seg_start) {
+      out[i] = (T)0;
+      continue;
     }
-  } else {
-    for (int i = threadIdx.x; i < post; i += blockDim.x) {
-      T sum = (T)0;
-      for (int line = start; line < end; ++line) {
-        sum += in_weights[line] * in[indices[line] * post + i];
-      }
-      out[group * post + i] = sum;
+    const int first_tile = seg_start / kSegmentTileLines;
+    const int last_tile = (seg_end - 1) / kSegmentTileLines;
+    if (first_tile == last_tile) {
+      continue;
     }
+    T sum = partials[(2 * first_tile + 1) * post + col];
+    for (int tile = first_tile + 1; tile <= last_tile; ++tile) {
+      sum += partials[(2 * tile) * post + col];
+    }
+    if (Average) {
+      sum /= (seg_end - seg_start);
+    }
+    out[i] = sum;
+  }
+}
+
+// Sums the len_indices lines of in (or the rows indices[line] of it) in the
+// len_length segments of prefix_sum_length_data into out.
+template <typename T, typename IndexType, bool Average>
+void balanced_length_sum(
+    const T* in,
+    const T* weights,
+    T* out,
+    const int* prefix_sum_length_data,
+    const IndexType* indices,
+    int post,
+    int len_length,
+    int len_indices,
+    Tensor<CUDAContext>* partials_buffer,
+    CUDAContext* context) {
+  if (post <= 0) {
+    return;
   }
+  const int num_tiles =
+      (len_indices + kSegmentTileLines - 1) / kSegmentTileLines;
+  if (num_tiles > 0) {
+    partials_buffer->Resize(2 * num_tiles * post);
+    dim3 block(
+        std::min(post, kSegmentBlockThreads),
+        std::max(1, kSegmentBlockThreads / post));
+    dim3 grid(
+        (num_tiles + block.y - 1) / block.y,
+        (post + block.x - 1) / block.x);
+    balanced_length_sum_kernel<T, IndexType, Average>
+        <<<grid, block, 0, context->cuda_stream()>>>(
+            in,
+            weights,
+            out,
+            partials_buffer->template mutable_data<T>(),
+            prefix_sum_length_data,
+            indices,
+            post,
+            len_length,
+            len_indices,
+            num_tiles);
+  }
+  balanced_length_sum_fixup_kernel<T, Average>
+      <<<CAFFE_GET_BLOCKS(len_length * post),
+         CAFFE_CUDA_NUM_THREADS,
+         0,
+         context->cuda_stream()>>>(
+          out,
+          num_tiles > 0 ? partials_buffer->template data<T>() : nullptr,
+          prefix_sum_length_data,
+          post,
+          len_length);
 }
 
 } // namespace
@@ -448,7 +453,7 @@ class CUDASparseLengthsSumOp : public Operator<CUDAContext> {
       return true;
     }
 
-    const IndexType* indices;
+    const IndexType* indices = nullptr;
     if (SparseFused) { // static if
       auto& indicesInput = Input(INDICES);
       CAFFE_ENFORCE_EQ(1, indicesInput.ndim(), "INDICES must be a vector");
@@ -470,52 +475,19 @@ class CUDASparseLengthsSumOp : public Operator<CUDAContext> {
     const T* in_data = dataInput.template data<T>();
     auto* prefix_sum_length_data =
         inclusive_scan_length_buffer_.template data<int>();
-    int N = dataSize;
     int post = dataInput.size_from_dim(1);
 
-    auto maxThreads =
-        GetDeviceProperty(CaffeCudaGetDevice()).maxThreadsPerBlock;
-    if (SparseFused) {
-      if (post <= maxThreads) {
-        int multiple = std::min(maxThreads / post, 16);
-        dim3 block(post, multiple);
-        size_t smem = sizeof(T) * post * multiple;
-
-        // calling cuda kernel with ExactBlock = true, Average = false
-        sparse_length_sum_kernel<T, IndexType, true, false>
-            <<<len_length, block, smem, context_.cuda_stream()>>>(
-                in_data,
-                out_data,
-                prefix_sum_length_data,
-                indices,
-                N,
-                post,
-                len_length,
-                dataToReduceSize);
-      } else {
-        // calling cuda kernel with ExactBlock = false, Average = false
-        sparse_length_sum_kernel<T, IndexType, false, false>
-            <<<len_length, maxThreads, 0, context_.cuda_stream()>>>(
-                in_data,
-                out_data,
-                prefix_sum_length_data,
-                indices,
-                N,
-                post,
-                len_length,
-                dataToReduceSize);
-      }
-    } else {
-      if (post <= maxThreads) {
-        length_sum_kernel<T, true, false>
-            <<<len_length, post, 0, context_.cuda_stream()>>>(
-                in_data, out_data, prefix_sum_length_data, N, post, len_length);
-      } else {
-        length_sum_kernel<T, true, false>
-            <<<len_length, maxThreads, 0, context_.cuda_stream()>>>(
-                in_data, out_data, prefix_sum_length_data, N, post, len_length);
-      }
-    }
+    balanced_length_sum<T, IndexType, false>(
+        in_data,
+        nullptr,
+        out_data,
+        prefix_sum_length_data,
+        indices,
+        post,
+        len_length,
+        dataToReduceSize,
+        &partials_buffer_,
+        &context_);
     return true;
   }
 
@@ -525,6 +497,7 @@ class CUDASparseLengthsSumOp : public Operator<CUDAContext> {
   // menber field to manage memory
   Tensor<Context> inclusive_scan_buffer_;
   Tensor<Context> inclusive_scan_length_buffer_;
+  Tensor<Context> partials_buffer_;
 };
 
 template <typename T, class Context = CUDAContext, bool SparseFused = true>
@@ -569,7 +542,7 @@ class CUDASparseLengthsMeanOp : public Operator<CUDAContext> {
       return true;
     }
 
-    const IndexType* indices;
+    const IndexType* indices = nullptr;
     if (SparseFused) { // static if
       auto& indicesInput = Input(INDICES);
       CAFFE_ENFORCE_EQ(1, indicesInput.ndim(), "INDICES must be a vector");
@@ -591,53 +564,19 @@ class CUDASparseLengthsMeanOp : public Operator<CUDAContext> {
     const T* in_data = dataInput.template data<T>();
     auto* prefix_sum_length_data =
         inclusive_scan_length_buffer_.template data<int>();
-    int N = dataSize;
     int post = dataInput.size_from_dim(1);
 
-    auto maxThreads =
-        GetDeviceProperty(CaffeCudaGetDevice()).maxThreadsPerBlock;
-    if (SparseFused) {
-      if (post <= maxThreads) {
-        int multiple = std::min(maxThreads / post, 16);
-        dim3 block(post, multiple);
-        size_t smem = sizeof(T) * post * multiple;
-        // calling cuda kernel with ExactBlock = true, Average = true
-        sparse_length_sum_kernel<T, IndexType, true, true>
-            <<<len_length, block, smem, context_.cuda_stream()>>>(
-                in_data,
-                out_data,
-                prefix_sum_length_data,
-                indices,
-                N,
-                post,
-                len_length,
-                dataToReduceSize);
-      } else {
-        // calling cuda kernel with ExactBlock = false, Average = true
-        sparse_length_sum_kernel<T, IndexType, false, true>
-            <<<len_length, maxThreads, 0, context_.cuda_stream()>>>(
-                in_data,
-                out_data,
-                prefix_sum_length_data,
-                indices,
-                N,
-                post,
-                len_length,
-                dataToReduceSize);
-      }
-    } else {
-      if (post <= maxThreads) {
-        // calling cuda kernel with ExactBlock = true, Average = true
-        length_sum_kernel<T, true, true>
-            <<<len_length, post, 0, context_.cuda_stream()>>>(
-                in_data, out_data, prefix_sum_length_data, N, post, len_length);
-      } else {
-        // calling cuda kernel with ExactBlock = true, Average = true
-        length_sum_kernel<T, true, true>
-            <<<len_length, maxThreads, 0, context_.cuda_stream()>>>(
-                in_data, out_data, prefix_sum_length_data, N, post, len_length);
-      }
-    }
+    balanced_length_sum<T, IndexType, true>(
+        in_data,
+        nullptr,
+        out_data,
+        prefix_sum_length_data,
+        indices,
+        post,
+        len_length,
+        dataToReduceSize,
+        &partials_buffer_,
+        &context_);
     return true;
   }
 
@@ -647,6 +586,7 @@ class CUDASparseLengthsMeanOp : public Operator<CUDAContext> {
   // menber field to manage memory
   Tensor<Context> inclusive_scan_buffer_;
   Tensor<Context> inclusive_scan_length_buffer_;
+  Tensor<Context> partials_buffer_;
 };
 
 template <typename T, class Context = CUDAContext, bool SparseFused = true>
@@ -838,40 +778,19 @@ class CUDASparseLengthsWeightedSumOp : public Operator<CUDAContext> {
     const T* in_weights = weightsInput.template data<T>();
     auto* prefix_sum_length_data =
         inclusive_scan_length_buffer_.template data<int>();
-    int N = dataSize;
     int post = dataInput.size_from_dim(1);
 
-    auto maxThreads =
-        GetDeviceProperty(CaffeCudaGetDevice()).maxThreadsPerBlock;
-    if (post <= maxThreads) {
-      int multiple = std::min(maxThreads / post, 16);
-      dim3 block(post, multiple);
-      size_t smem = sizeof(T) * post * multiple;
-
-      sparse_length_weighted_sum_kernel<T, IndexType, true>
-          <<<len_length, block, smem, context_.cuda_stream()>>>(
-              in_data,
-              in_weights,
-              out_data,
-              prefix_sum_length_data,
-              indices,
-              N,
-              post,
-              len_length,
-              dataToReduceSize);
-    } else {
-      sparse_length_weighted_sum_kernel<T, IndexType, false>
-          <<<len_length, maxThreads, 0, context_.cuda_stream()>>>(
-              in_data,
-              in_weights,
-              out_data,
-              prefix_sum_length_data,
-              indices,
-              N,
-              post,
-              len_length,
-              dataToReduceSize);
-    }
+    balanced_length_sum<T, IndexType, false>(
+        in_data,
+        in_weights,
+        out_data,
+        prefix_sum_length_data,
+        indices,
+        post,
+        len_length,
+        dataToReduceSize,
+        &partials_buffer_,
+        &context_);
     return true;
   }
 
@@ -881,6 +800,7 @@ class CUDASparseLengthsWeightedSumOp : public Operator<CUDAContext> {
   // menber field to manage memory
   Tensor<Context> inclusive_scan_buffer_;
   Tensor<Context> inclusive_scan_length_buffer_;
+  Tensor<Context> partials_buffer_;
 };
 
 template <typename SIndex>
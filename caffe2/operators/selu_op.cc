@@ -41,6 +41,7 @@ REGISTER_CPU_OPERATOR(SeluGradient, SeluGradientOp<float, CPUContext>);
 OPERATOR_SCHEMA(Selu)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<4>)
     .AllowInplace({{0, 0}})
     .IdenticalTypeAndShape()
     .SetDoc(R"DOC(
@@ -36,6 +36,7 @@ REGISTER_CPU_OPERATOR(
 OPERATOR_SCHEMA(Sin)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<1>)
     .IdenticalTypeAndShape()
     .SetDoc(R"DOC(
 Calculates the sine of the given input tensor, element-wise.
@@ -84,6 +84,7 @@ REGISTER_CPU_OPERATOR(SoftmaxGradient, SoftmaxGradientOp<float, CPUContext>);
 OPERATOR_SCHEMA(Softmax)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<5>)
     .IdenticalTypeAndShape()
     .SetDoc(R"DOC(
 
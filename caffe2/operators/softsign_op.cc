@@ -50,6 +50,7 @@ REGISTER_CPU_OPERATOR(
 OPERATOR_SCHEMA(Softsign)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<3>)
     .AllowInplace({{0, 0}})
     .IdenticalTypeAndShape()
     .SetDoc(R"DOC(
@@ -0,0 +1,294 @@
+#include "caffe2/operators/sparse_to_dense_mask_op.h"
+
+#include "caffe2/core/context_gpu.h"
+
+#include <cub/cub.cuh>
+
+namespace caffe2 {
+
+namespace {
+__device__ int GetFeatureIdx(
+    const int64_t id,
+    const int64_t maxDenseSize,
+    const int* dense,
+    const int denseSize,
+    const int64_t* sparseIds,
+    const int* sparseFeatures,
+    const int sparseSize) {
+  if (id < maxDenseSize) {
+    return id < denseSize ? dense[id] : -1;
+  }
+  int lo = 0;
+  int hi = sparseSize;
+  while (lo < hi) {
+    const int mid = (lo + hi) / 2;
+    if (sparseIds[mid] < id) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo < sparseSize && sparseIds[lo] == id ? sparseFeatures[lo] : -1;
+}
+
+// Writes the position within its row of the last index mapped to each output
+// cell, so that later values win over earlier ones as on the CPU.
+template <typename TInd>
+__global__ void SparseToDenseMaskWinnersKernel(
+    const int rows,
+    const int cols,
+    const int numIndices,
+    const int32_t* lengths,
+    const TIndex* offsets,
+    const TInd* indices,
+    const TInd maxIndex,
+    const int64_t maxDenseSize,
+    const int* dense,
+    const int denseSize,
+    const int64_t* sparseIds,
+    const int* sparseFeatures,
+    const int sparseSize,
+    int* winners,
+    int* skipped) {
+  for (int r = blockIdx.x; r < rows; r += gridDim.x) {
+    const int length = lengths ? lengths[r] : numIndices;
+    const TIndex offset = lengths ? offsets[r] : 0;
+    for (int c = threadIdx.x; c < length; c += blockDim.x) {
+      const auto sparseIndex = indices[offset + c];
+      if (sparseIndex < 0 || sparseIndex >= maxIndex) {
+        atomicAdd(skipped, 1);
+        continue;
+      }
+      const int idx = GetFeatureIdx(
+          sparseIndex,
+          maxDenseSize,
+          dense,
+          denseSize,
+          sparseIds,
+          sparseFeatures,
+          sparseSize);
+      if (idx != -1) {
+        atomicMax(&winners[r * cols + idx], c);
+      }
+    }
+  }
+}
+
+__global__ void SparseToDenseMaskFillKernel(
+    const int rows,
+    const int cols,
+    const TIndex blockBytes,
+    const TIndex* offsets,
+    const int* winners,
+    const char* values,
+    const char* defaultValue,
+    char* output,
+    bool* presenceMask) {
+  for (int i = blockIdx.x; i < rows * cols; i += gridDim.x) {
+    const int winner = winners[i];
+    const char* src = defaultValue;
+    if (winner >= 0) {
+      const TIndex offset = offsets ? offsets[i / cols] : 0;
+      src = values + (offset + winner) * blockBytes;
+    }
+    char* dest = output + i * blockBytes;
+    for (TIndex j = threadIdx.x; j < blockBytes; j += blockDim.x) {
+      dest[j] = src[j];
+    }
+    if (presenceMask && threadIdx.x == 0) {
+      presenceMask[i] = winner >= 0;
+    }
+  }
+}
+} // namespace
+
+template <>
+class SparseToDenseMaskOp<CUDAContext> final
+    : public SparseToDenseMaskBase<CUDAContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CUDAContext);
+  SparseToDenseMaskOp(const OperatorDef& operator_def, Workspace* ws)
+      : SparseToDenseMaskBase<CUDAContext>(operator_def, ws) {
+    returnPresenceMask_ = OperatorBase::GetSingleArgument<bool>(
+        "return_presence_mask", false);
+    maxSkippedSparseIndices_ = OperatorBase::GetSingleArgument<int32_t>(
+        "max_skipped_indices", kMaxSkippedSparseIndices);
+
+    // Copy the mask to the device, with the ids too big for the dense map
+    // sorted for a binary search.
+    TensorCPU dense(vector<TIndex>{static_cast<TIndex>(dense_.size())});
+    std::copy(dense_.begin(), dense_.end(), dense.mutable_data<int>());
+    dense_device_.CopyFrom(dense, &context_);
+
+    std::vector<std::pair<int64_t, int>> sparse(sparse_.begin(), sparse_.end());
+    std::sort(sparse.begin(), sparse.end());
+    TensorCPU sparseIds(vector<TIndex>{static_cast<TIndex>(sparse.size())});
+    TensorCPU sparseFeatures(sparseIds.dims());
+    auto* sparseIdsData = sparseIds.mutable_data<int64_t>();
+    auto* sparseFeaturesData = sparseFeatures.mutable_data<int>();
+    for (int i = 0; i < sparse.size(); i++) {
+      sparseIdsData[i] = sparse[i].first;
+      sparseFeaturesData[i] = sparse[i].second;
+    }
+    sparse_ids_device_.CopyFrom(sparseIds, &context_);
+    sparse_features_device_.CopyFrom(sparseFeatures, &context_);
+  }
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(INDICES));
+  }
+
+  template <typename TInd>
+  bool DoRunWithType() {
+    auto& sparse_indices = Input(INDICES);
+    CAFFE_ENFORCE_EQ(sparse_indices.ndim(), 1);
+    auto& sparse_values = Input(VALUES);
+    CAFFE_ENFORCE_GE(sparse_values.ndim(), 1);
+    CAFFE_ENFORCE_EQ(sparse_indices.size(), sparse_values.dim(0));
+    auto& default_value = Input(DEFAULT);
+    CAFFE_ENFORCE_EQ(default_value.ndim() + 1, sparse_values.ndim());
+    CAFFE_ENFORCE_EQ(default_value.size(), sparse_values.size_from_dim(1));
+    CAFFE_ENFORCE(sparse_values.meta() == default_value.meta());
+
+    const int cols = this->featuresCount_;
+    int rows = 1;
+    const int32_t* lengths_vec = nullptr;
+    const TIndex* offsets_vec = nullptr;
+    auto* output = Output(OUTPUTVALUE);
+    Tensor<CUDAContext>* presence_mask = nullptr;
+    if (returnPresenceMask_) {
+      presence_mask = Output(PRESENCEMASK);
+    }
+    vector<TIndex> shape;
+    if (InputSize() == 4) {
+      auto& lengths = Input(LENGTHS);
+      CAFFE_ENFORCE_EQ(lengths.ndim(), 1);
+      lengths_vec = lengths.data<int32_t>();
+      rows = lengths.dim32(0);
+      shape.push_back(rows);
+    }
+    shape.push_back(cols);
+    if (returnPresenceMask_) {
+      presence_mask->Resize(shape);
+    }
+    shape.insert(
+        shape.end(), default_value.dims().begin(), default_value.dims().end());
+    output->Resize(shape);
+
+    char* output_data =
+        static_cast<char*>(output->raw_mutable_data(sparse_values.meta()));
+    bool* presence_mask_data = nullptr;
+    if (returnPresenceMask_) {
+      presence_mask_data = presence_mask->mutable_data<bool>();
+    }
+    if (rows == 0) {
+      return true;
+    }
+
+    if (lengths_vec) {
+      offsets_.Resize(rows);
+      auto* offsetsData = offsets_.mutable_data<TIndex>();
+      size_t numBytes = 0;
+      cub::DeviceScan::ExclusiveSum(
+          nullptr,
+          numBytes,
+          lengths_vec,
+          offsetsData,
+          rows,
+          context_.cuda_stream());
+      scratch_.Resize(static_cast<TIndex>(
+          (numBytes + sizeof(TIndex) - 1) / sizeof(TIndex)));
+      cub::DeviceScan::ExclusiveSum(
+          static_cast<void*>(scratch_.mutable_data<TIndex>()),
+          numBytes,
+          lengths_vec,
+          offsetsData,
+          rows,
+          context_.cuda_stream());
+      offsets_vec = offsetsData;
+    }
+
+    winners_.Resize(rows * cols);
+    auto* winnersData = winners_.mutable_data<int>();
+    math::Set<int, CUDAContext>(rows * cols, -1, winnersData, &context_);
+    skipped_.Resize(1);
+    auto* skippedData = skipped_.mutable_data<int>();
+    math::Set<int, CUDAContext>(1, 0, skippedData, &context_);
+
+    const int numIndices = sparse_indices.dim32(0);
+    if (numIndices > 0) {
+      SparseToDenseMaskWinnersKernel<TInd><<<
+          std::min(rows, CAFFE_MAXIMUM_NUM_BLOCKS),
+          CAFFE_CUDA_NUM_THREADS,
+          0,
+          context_.cuda_stream()>>>(
+          rows,
+          cols,
+          numIndices,
+          lengths_vec,
+          offsets_vec,
+          sparse_indices.data<TInd>(),
+          std::numeric_limits<TInd>::max(),
+          this->kMaxDenseSize,
+          dense_device_.data<int>(),
+          dense_device_.size(),
+          sparse_ids_device_.data<int64_t>(),
+          sparse_features_device_.data<int>(),
+          sparse_ids_device_.size(),
+          winnersData,
+          skippedData);
+    }
+
+    SparseToDenseMaskFillKernel<<<
+        std::min(rows * cols, CAFFE_MAXIMUM_NUM_BLOCKS),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        rows,
+        cols,
+        default_value.nbytes(),
+        offsets_vec,
+        winnersData,
+        static_cast<const char*>(sparse_values.raw_data()),
+        static_cast<const char*>(default_value.raw_data()),
+        output_data,
+        presence_mask_data);
+
+    if (numIndices > 0) {
+      // Copy the number of skipped indices from gpu to cpu
+      int skipped;
+      context_.Copy<int, CUDAContext, CPUContext>(1, skippedData, &skipped);
+      if (skipped > 0) {
+        skippedSparseIndices_ += skipped;
+        CAFFE_ENFORCE_LT(
+            skippedSparseIndices_,
+            maxSkippedSparseIndices_,
+            "Too many sparse indices skipped");
+      }
+    }
+    return true;
+  }
+
+ private:
+  static const uint32_t kMaxSkippedSparseIndices = 5;
+
+  bool returnPresenceMask_;
+  uint32_t maxSkippedSparseIndices_ = 0;
+  uint32_t skippedSparseIndices_ = 0;
+
+  Tensor<CUDAContext> dense_device_;
+  Tensor<CUDAContext> sparse_ids_device_;
+  Tensor<CUDAContext> sparse_features_device_;
+  Tensor<CUDAContext> offsets_;
+  Tensor<CUDAContext> scratch_;
+  Tensor<CUDAContext> winners_;
+  Tensor<CUDAContext> skipped_;
+
+  INPUT_TAGS(INDICES, VALUES, DEFAULT, LENGTHS);
+  OUTPUT_TAGS(OUTPUTVALUE, PRESENCEMASK);
+};
+
+REGISTER_CUDA_OPERATOR(SparseToDenseMask, SparseToDenseMaskOp<CUDAContext>);
+
+} // namespace caffe2
@@ -4,6 +4,62 @@
 
 namespace caffe2 {
 
+namespace {
+
+// dScale = inv_std * sum(dY * (X - mean)) and dBias = sum(dY) of each channel
+// of an NCHW tensor, in one pass over dY and X.
+void ComputeChannelGradientsNCHW(
+    const int N,
+    const int C,
+    const int HxW,
+    const float* dY,
+    const float* X,
+    const float* mean,
+    const float* inv_std,
+    float* dscale,
+    float* dbias) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (int c = 0; c < C; ++c) {
+    float ds = 0;
+    float db = 0;
+    for (int n = 0; n < N; ++n) {
+      ConstEigenVectorArrayMap<float> dY_arr(dY + (n * C + c) * HxW, HxW);
+      ConstEigenVectorArrayMap<float> X_arr(X + (n * C + c) * HxW, HxW);
+      ds += (dY_arr * (X_arr - mean[c])).sum();
+      db += dY_arr.sum();
+    }
+    dscale[c] = ds * inv_std[c];
+    dbias[c] = db;
+  }
+}
+
+// Same as above for an NHWC tensor with `rows` rows of C channels, which are
+// accumulated a whole row at a time.
+void ComputeChannelGradientsNHWC(
+    const int rows,
+    const int C,
+    const float* dY,
+    const float* X,
+    const float* mean,
+    const float* inv_std,
+    float* dscale,
+    float* dbias) {
+  ConstEigenVectorArrayMap<float> mean_arr(mean, C);
+  EigenVectorArrayMap<float> dscale_arr(dscale, C);
+  EigenVectorArrayMap<float> dbias_arr(dbias, C);
+  for (int i = 0; i < rows; ++i) {
+    ConstEigenVectorArrayMap<float> dY_arr(dY + i * C, C);
+    dscale_arr +=
+        dY_arr * (ConstEigenVectorArrayMap<float>(X + i * C, C) - mean_arr);
+    dbias_arr += dY_arr;
+  }
+  dscale_arr *= ConstEigenVectorArrayMap<float>(inv_std, C);
+}
+
+} // namespace
+
 template <>
 bool SpatialBNGradientOp<CPUContext>::RunOnDevice() {
   const auto& X = Input(INPUT);
@@ -55,62 +111,82 @@ bool SpatialBNGradientOp<CPUContext>::RunOnDevice() {
     dBias_arr.setZero();
     dScale_arr.setZero();
   }
+  if (N == 0) {
+    return true;
+  }
 
-  const auto scaleInvVarNHW = scale_arr * inv_var_arr / (N * sample_size);
+  const float* X_data = X.data<float>();
+  const float* dY_data = dY.data<float>();
+  float* dX_data = dX->mutable_data<float>();
+  if (num_batches_ == 1) {
+    switch (order_) {
+      case StorageOrder::NCHW: {
+        ComputeChannelGradientsNCHW(
+            N,
+            C,
+            sample_size,
+            dY_data,
+            X_data,
+            mean_arr.data(),
+            inv_var_arr.data(),
+            dScale_arr.data(),
+            dBias_arr.data());
+        break;
+      }
+      case StorageOrder::NHWC: {
+        ComputeChannelGradientsNHWC(
+            N * sample_size,
+            C,
+            dY_data,
+            X_data,
+            mean_arr.data(),
+            inv_var_arr.data(),
+            dScale_arr.data(),
+            dBias_arr.data());
+        break;
+      }
+      default:
+        CAFFE_THROW("Unknown storage order: ", order_);
+    }
+  } else {
+    dBias_arr /= num_batches_;
+    dScale_arr /= num_batches_;
+  }
 
+  // dX is affine in dY and X for each channel: dX = alpha * dY + beta * X +
+  // gamma, so the last pass is a single fused multiply-add per element.
+  const float inv_nhw = 1.0f / static_cast<float>(N * sample_size);
+  Eigen::Array<float, Eigen::Dynamic, 1> alpha = scale_arr * inv_var_arr;
+  Eigen::Array<float, Eigen::Dynamic, 1> beta =
+      -alpha * inv_var_arr * dScale_arr * inv_nhw;
+  Eigen::Array<float, Eigen::Dynamic, 1> gamma =
+      -beta * mean_arr - alpha * dBias_arr * inv_nhw;
   switch (order_) {
     case StorageOrder::NCHW: {
-      ConstEigenArrayMap<float> X_arr(X.data<float>(), sample_size, N * C);
-      ConstEigenArrayMap<float> dY_arr(dY.data<float>(), sample_size, N * C);
-      EigenArrayMap<float> dX_arr(
-          dX->mutable_data<float>(), sample_size, N * C);
-      dX_arr.setZero();
-      if (N == 0) {
-        return true;
-      }
-      if (num_batches_ == 1) {
-        for (int nc = 0; nc < N * C; ++nc) {
-          int c = nc % C;
-          dBias_arr(c) += dY_arr.col(nc).sum();
-          dScale_arr(c) +=
-              ((X_arr.col(nc) - mean_arr(c)) * inv_var_arr(c) * dY_arr.col(nc))
-                  .sum();
-        }
-      } else {
-        for (int c = 0; c < C; ++c) {
-          dBias_arr(c) /= num_batches_;
-          dScale_arr(c) /= num_batches_;
-        }
-      }
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
       for (int nc = 0; nc < N * C; ++nc) {
-        int c = nc % C;
-        dX_arr.col(nc) += scaleInvVarNHW(c) *
-            (dY_arr.col(nc) * N * sample_size - dBias_arr(c) -
-             (X_arr.col(nc) - mean_arr[c]) * dScale_arr(c) * inv_var_arr(c));
+        const int c = nc % C;
+        EigenVectorArrayMap<float>(dX_data + nc * sample_size, sample_size) =
+            ConstEigenVectorArrayMap<float>(
+                dY_data + nc * sample_size, sample_size) *
+                alpha(c) +
+            ConstEigenVectorArrayMap<float>(
+                X_data + nc * sample_size, sample_size) *
+                beta(c) +
+            gamma(c);
       }
       break;
     }
     case StorageOrder::NHWC: {
-      ConstEigenArrayMap<float> X_arr(X.data<float>(), C, N * sample_size);
-      ConstEigenArrayMap<float> dY_arr(dY.data<float>(), C, N * sample_size);
-      EigenArrayMap<float> dX_arr(
-          dX->mutable_data<float>(), C, N * sample_size);
-      dX_arr.setZero();
-      if (N == 0) {
-        return true;
-      }
-
-      const auto dYRowSum = dY_arr.rowwise().sum();
-      const auto XMinusMean = X_arr.colwise() - mean_arr;
-      const auto dYMulXMinusMeanRowSum = (dY_arr * XMinusMean).rowwise().sum();
-      const auto invVarSqr = inv_var_arr * inv_var_arr;
-      for (int nhw = 0; nhw < N * sample_size; ++nhw) {
-        dBias_arr += dY_arr.col(nhw);
-        dScale_arr +=
-            (X_arr.col(nhw) - mean_arr) * inv_var_arr * dY_arr.col(nhw);
-        dX_arr.col(nhw) += scaleInvVarNHW *
-            (dY_arr.col(nhw) * N * sample_size - dYRowSum -
-             XMinusMean.col(nhw) * invVarSqr * dYMulXMinusMeanRowSum);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+      for (int i = 0; i < N * sample_size; ++i) {
+        EigenVectorArrayMap<float>(dX_data + i * C, C) =
+            ConstEigenVectorArrayMap<float>(dY_data + i * C, C) * alpha +
+            ConstEigenVectorArrayMap<float>(X_data + i * C, C) * beta + gamma;
       }
       break;
     }
@@ -157,6 +233,19 @@ class GetSpatialBNGradient : public GradientMakerBase {
       CAFFE_ENFORCE_EQ(def_.output_size(), 5);
       grad_inputs = vector<string>{I(0), I(1), GO(0), O(3), O(4)};
     }
+    if (ArgumentHelper::GetSingleArgument(def_, "fuse_relu", 0)) {
+      // Y = max(BN(X), 0), so dY goes through the ReLU gradient first.
+      const string relu_grad = GO(0) + "_relu_grad";
+      grad_inputs[2] = relu_grad;
+      return vector<OperatorDef>{
+          CreateOperatorDef(
+              "ReluGradient",
+              "",
+              vector<string>{O(0), GO(0)},
+              vector<string>{relu_grad}),
+          CreateOperatorDef(
+              "SpatialBNGradient", "", grad_inputs, grad_outputs)};
+    }
     return SingleGradientDef(
         "SpatialBNGradient", "", grad_inputs, grad_outputs);
   }
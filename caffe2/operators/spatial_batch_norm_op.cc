@@ -1,9 +1,141 @@
 #include "caffe2/operators/spatial_batch_norm_op.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "caffe2/utils/eigen_utils.h"
+#include "caffe2/utils/math_utils.h"
 
 namespace caffe2 {
 
+namespace {
+
+// Welford moments of each channel of an NCHW tensor. The N rows of HxW values
+// of a channel are reduced one at a time and merged, and the channels are
+// independent of each other.
+void ComputeChannelMomentsNCHW(
+    const int N,
+    const int C,
+    const int HxW,
+    const float* X,
+    float* mean,
+    float* var) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (int c = 0; c < C; ++c) {
+    math::utils::WelfordData<float> moments{0, 0, 0};
+    for (int n = 0; n < N; ++n) {
+      float row_mean;
+      float row_var;
+      math::utils::WelfordMoments(
+          HxW, X + (n * C + c) * HxW, &row_mean, &row_var);
+      moments = math::utils::WelfordCombine(
+          moments,
+          math::utils::WelfordData<float>{row_mean, row_var * HxW,
+                                          static_cast<float>(HxW)});
+    }
+    mean[c] = moments.mean;
+    var[c] = moments.n > 0 ? moments.m2 / moments.n : 0.0f;
+  }
+}
+
+// Welford moments of each channel of an NHWC tensor with `rows` rows of C
+// channels. The rows are split into chunks which update their own moments a
+// whole row at a time, so the inner loop runs over contiguous channels, and
+// the chunks are merged at the end.
+void ComputeChannelMomentsNHWC(
+    const int rows,
+    const int C,
+    const float* X,
+    float* mean,
+    float* var) {
+  constexpr int kMaxNumChunks = 64;
+  const int num_chunks = std::max(std::min(rows, kMaxNumChunks), 1);
+  std::vector<float> chunk_mean(num_chunks * C, 0.0f);
+  std::vector<float> chunk_m2(num_chunks * C, 0.0f);
+  const auto chunk_begin = [rows, num_chunks](const int i) {
+    return static_cast<int>(static_cast<TIndex>(rows) * i / num_chunks);
+  };
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < num_chunks; ++i) {
+    const int begin = chunk_begin(i);
+    const int end = chunk_begin(i + 1);
+    float* mu = chunk_mean.data() + i * C;
+    float* m2 = chunk_m2.data() + i * C;
+    for (int r = begin; r < end; ++r) {
+      const float* x = X + r * C;
+      const float rk = 1.0f / static_cast<float>(r - begin + 1);
+      for (int c = 0; c < C; ++c) {
+        const float delta = x[c] - mu[c];
+        mu[c] += delta * rk;
+        m2[c] += delta * (x[c] - mu[c]);
+      }
+    }
+  }
+  for (int c = 0; c < C; ++c) {
+    math::utils::WelfordData<float> moments{0, 0, 0};
+    for (int i = 0; i < num_chunks; ++i) {
+      const int size = chunk_begin(i + 1) - chunk_begin(i);
+      moments = math::utils::WelfordCombine(
+          moments,
+          math::utils::WelfordData<float>{chunk_mean[i * C + c],
+                                          chunk_m2[i * C + c],
+                                          static_cast<float>(size)});
+    }
+    mean[c] = moments.mean;
+    var[c] = moments.n > 0 ? moments.m2 / moments.n : 0.0f;
+  }
+}
+
+// Y = max(X * alpha + beta, 0) if fuse_relu else X * alpha + beta, with alpha
+// and beta per channel.
+void AffineChannel(
+    const StorageOrder order,
+    const int N,
+    const int C,
+    const int HxW,
+    const float* X,
+    const float* alpha,
+    const float* beta,
+    const bool fuse_relu,
+    float* Y) {
+  if (order == StorageOrder::NCHW) {
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (int nc = 0; nc < N * C; ++nc) {
+      const int c = nc % C;
+      ConstEigenVectorArrayMap<float> X_arr(X + nc * HxW, HxW);
+      EigenVectorArrayMap<float> Y_arr(Y + nc * HxW, HxW);
+      if (fuse_relu) {
+        Y_arr = (X_arr * alpha[c] + beta[c]).cwiseMax(0.0f);
+      } else {
+        Y_arr = X_arr * alpha[c] + beta[c];
+      }
+    }
+  } else {
+    ConstEigenVectorArrayMap<float> alpha_arr(alpha, C);
+    ConstEigenVectorArrayMap<float> beta_arr(beta, C);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+    for (int i = 0; i < N * HxW; ++i) {
+      ConstEigenVectorArrayMap<float> X_arr(X + i * C, C);
+      EigenVectorArrayMap<float> Y_arr(Y + i * C, C);
+      if (fuse_relu) {
+        Y_arr = (X_arr * alpha_arr + beta_arr).cwiseMax(0.0f);
+      } else {
+        Y_arr = X_arr * alpha_arr + beta_arr;
+      }
+    }
+  }
+}
+
+} // namespace
+
 template <>
 bool SpatialBNOp<CPUContext>::RunOnDevice() {
   const auto& X = Input(INPUT);
@@ -56,34 +188,15 @@ bool SpatialBNOp<CPUContext>::RunOnDevice() {
         mean = sums / multi_batch_size;
         var = (sumsq - (sums * sums) / multi_batch_size) / multi_batch_size;
       } else {
-        mean.setZero();
-        var.setZero();
         switch (order_) {
           case StorageOrder::NCHW: {
-            ConstEigenArrayMap<float> X_arr(
-                X.data<float>(), sample_size, N * C);
-            for (int nc = 0; nc < N * C; ++nc) {
-              mean(nc % C) += X_arr.col(nc).sum();
-            }
-            mean /= N * sample_size;
-            for (int nc = 0; nc < N * C; ++nc) {
-              var(nc % C) +=
-                  (X_arr.col(nc) - mean(nc % C)).matrix().squaredNorm();
-            }
-            var /= N * sample_size;
+            ComputeChannelMomentsNCHW(
+                N, C, sample_size, X.data<float>(), mean.data(), var.data());
             break;
           }
           case StorageOrder::NHWC: {
-            ConstEigenArrayMap<float> X_arr(
-                X.data<float>(), C, N * sample_size);
-            for (int i = 0; i < N * sample_size; ++i) {
-              mean += X_arr.col(i);
-            }
-            mean /= N * sample_size;
-            for (int i = 0; i < N * sample_size; ++i) {
-              var += (X_arr.col(i) - mean) * (X_arr.col(i) - mean);
-            }
-            var /= N * sample_size;
+            ComputeChannelMomentsNHWC(
+                N * sample_size, C, X.data<float>(), mean.data(), var.data());
             break;
           }
           default:
@@ -146,27 +259,16 @@ bool SpatialBNOp<CPUContext>::RunOnDevice() {
   Eigen::Array<float, Eigen::Dynamic, 1> new_scale = inv_std * scale_arr;
   Eigen::Array<float, Eigen::Dynamic, 1> new_bias =
       bias_arr - mean_arr * inv_std * scale_arr;
-  switch (order_) {
-    case StorageOrder::NHWC: {
-      EigenArrayMap<float>(Y_data, C, N * sample_size) =
-          (ConstEigenArrayMap<float>(X.data<float>(), C, N * sample_size)
-               .colwise() *
-           new_scale)
-              .colwise() +
-          new_bias;
-      break;
-    }
-    case StorageOrder::NCHW: {
-      EigenArrayMap<float> Y_arr(Y_data, sample_size, N * C);
-      ConstEigenArrayMap<float> X_arr(X.data<float>(), sample_size, N * C);
-      for (int nc = 0; nc < N * C; ++nc) {
-        Y_arr.col(nc) = X_arr.col(nc) * new_scale(nc % C) + new_bias(nc % C);
-      }
-      break;
-    }
-    default:
-      CAFFE_THROW("Unknown storage order: ", order_);
-  }
+  AffineChannel(
+      order_,
+      N,
+      C,
+      sample_size,
+      X.data<float>(),
+      new_scale.data(),
+      new_bias.data(),
+      fuse_relu_,
+      Y_data);
   return true;
 }
 
@@ -244,6 +346,7 @@ Github Links:
     .Arg("epsilon", "*(type: float; default: 1e-5)* The epsilon value to use to avoid division by zero.")
     .Arg("order", "*(type: string; default: \"NCHW\")* Specifies the order of the input data blob, where $N$ is batch size, $C$ is number of channels, $H$ is spatial height, and $W$ is spatial width. The only other valid option is \"NHWC\".")
     .Arg("momentum", "*(type: float; default: 0.9)* Factor used in computing the running mean and variance. e.g., running_mean = running_mean x momentum + mean x (1 - momentum)")
+    .Arg("fuse_relu", "*(type: int; default: 0)* If set to nonzero, apply ReLU to the output, i.e. $Y = max(BN(X), 0)$, in the same pass. Only supported on CPU.")
     .Arg("num_batches", "*(type: int; default: 1)* Specifies the number of batches to apply normalization on. Requires specifying the optional sums and sumsq inputs that provide statistics across multiple batches from which mean and variance can be determined.")
     .Input(
         0,
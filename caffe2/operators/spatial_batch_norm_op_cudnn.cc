@@ -17,6 +17,7 @@ class CudnnSpatialBNOp final : public SpatialBNOp<CUDAContext> {
   USE_OPERATOR_FUNCTIONS(CUDAContext);
   CudnnSpatialBNOp(const OperatorDef& operator_def, Workspace* ws)
       : SpatialBNOp<CUDAContext>(operator_def, ws), cudnn_wrapper_(&context_) {
+    OPERATOR_NEEDS_FEATURE(!fuse_relu_, "Fused ReLU not supported.");
     CUDNN_ENFORCE(cudnnCreateTensorDescriptor(&data_desc_));
     CUDNN_ENFORCE(cudnnCreateTensorDescriptor(&bn_param_desc_));
     if (epsilon_ <= CUDNN_BN_MIN_EPSILON - FLT_EPSILON) {
@@ -587,10 +587,10 @@ OPERATOR_SCHEMA(BRGNCHWCToPackedInt8BGRAStylizerDeprocess)
     .NumOutputs(1);
 
 #ifdef CAFFE2_USE_IDEEP
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     BRGNCHWCToPackedInt8BGRAStylizerDeprocess,
     IDEEPFallbackOp<BRGNCHWCToPackedInt8BGRAStylizerDeprocessOp, SkipIndices<0>>);
-REGISTER_IDEEP_OPERATOR(
+REGISTER_IDEEP_FALLBACK_OPERATOR(
     PackedInt8BGRANHWCToNCHWCStylizerPreprocess,
     IDEEPFallbackOp<PackedInt8BGRANHWCToNCHWCStylizerPreprocessOp>);
 #endif
@@ -56,6 +56,7 @@ REGISTER_CPU_OPERATOR(SwishGradient, SwishGradientOp<CPUContext>);
 OPERATOR_SCHEMA(Swish)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<5>)
     .IdenticalTypeAndShape()
     .SetDoc(R"DOC(
 Swish takes one input data (Tensor<T>) and produces one output data
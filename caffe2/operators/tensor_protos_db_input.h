@@ -1,11 +1,13 @@
 #ifndef CAFFE2_OPERATORS_TENSOR_PROTOS_DB_INPUT_H_
 #define CAFFE2_OPERATORS_TENSOR_PROTOS_DB_INPUT_H_
 
+#include <exception>
 #include <iostream>
 #include <mutex>
 
 #include "caffe2/core/db.h"
 #include "caffe2/operators/prefetch_op.h"
+#include "caffe2/utils/thread_pool.h"
 
 namespace caffe2 {
 
@@ -13,6 +15,7 @@ template <class Context>
 class TensorProtosDBInput final : public PrefetchOperator<Context> {
  public:
   using OperatorBase::OutputSize;
+  using PrefetchOperator<Context>::context_;
   using PrefetchOperator<Context>::prefetch_thread_;
   explicit TensorProtosDBInput(const OperatorDef& operator_def, Workspace* ws);
   ~TensorProtosDBInput() {
@@ -23,12 +26,28 @@ class TensorProtosDBInput final : public PrefetchOperator<Context> {
   bool CopyPrefetched() override;
 
  private:
+  // Parses the TensorProtos of one record and copies it into the slot
+  // item_id of the batch. The shapes of the batch must already be set.
+  void DecodeItem(const db::Slice& value, int item_id, std::size_t thread_id);
+
   // Prefetch will always just happen on the CPU side.
   vector<Blob> prefetched_blobs_;
+  // On GPU, the batch is uploaded by the prefetch thread as well, so that
+  // CopyPrefetched only does a device copy.
+  vector<Tensor<Context>> prefetched_blobs_on_device_;
   int batch_size_;
-  bool shape_inferred_ = false;
+  int num_decode_threads_;
+  std::unique_ptr<TaskThreadPool> thread_pool_;
+  // Temporary tensors of DecodeItem, for every decode thread.
+  vector<vector<TensorCPU>> temp_tensors_;
+  CPUContext cpu_context_;
+  // First error of the decode threads in the current batch.
+  std::mutex decode_error_mutex_;
+  std::exception_ptr decode_error_;
   string key_;
-  string value_;
+  // Copies of the values of the batch, if the db doesn't support zero copy
+  // reads.
+  vector<string> values_;
 };
 
 template <class Context>
@@ -37,19 +56,64 @@ TensorProtosDBInput<Context>::TensorProtosDBInput(
     Workspace* ws)
     : PrefetchOperator<Context>(operator_def, ws),
       prefetched_blobs_(operator_def.output_size()),
+      prefetched_blobs_on_device_(operator_def.output_size()),
       batch_size_(
-          OperatorBase::template GetSingleArgument<int>("batch_size", 0)) {}
+          OperatorBase::template GetSingleArgument<int>("batch_size", 0)),
+      num_decode_threads_(
+          OperatorBase::template GetSingleArgument<int>("decode_threads", 1)) {
+  CAFFE_ENFORCE_GT(num_decode_threads_, 0);
+  if (num_decode_threads_ > 1 && batch_size_ > 1) {
+    thread_pool_.reset(new TaskThreadPool(num_decode_threads_));
+  }
+  temp_tensors_.resize(num_decode_threads_);
+  for (auto& tensors : temp_tensors_) {
+    tensors.resize(OutputSize());
+  }
+}
+
+template <class Context>
+void TensorProtosDBInput<Context>::DecodeItem(
+    const db::Slice& value,
+    int item_id,
+    std::size_t thread_id) {
+  TensorProtos protos;
+  CAFFE_ENFORCE(protos.ParseFromArray(value.data, value.size));
+  CAFFE_ENFORCE(protos.protos_size() == OutputSize());
+  TensorDeserializer<CPUContext> deserializer;
+  for (int i = 0; i < protos.protos_size(); ++i) {
+    TensorCPU* dst = prefetched_blobs_[i].template GetMutable<TensorCPU>();
+    TensorCPU& src = temp_tensors_[thread_id][i];
+    if (protos.protos(i).has_device_detail()) {
+      protos.mutable_protos(i)->clear_device_detail();
+    }
+    deserializer.Deserialize(protos.protos(i), &src);
+    CAFFE_ENFORCE_EQ(
+        src.size() * batch_size_,
+        dst->size(),
+        "All the records must have the same shapes");
+    // This runs on the decode threads, so the copy goes through a
+    // CPUContext rather than the context of the operator.
+    cpu_context_.template CopyItems<CPUContext, CPUContext>(
+        src.meta(),
+        src.size(),
+        src.raw_data(),
+        static_cast<char*>(dst->raw_mutable_data(src.meta())) +
+            src.nbytes() * item_id);
+  }
+}
 
 template <class Context>
 bool TensorProtosDBInput<Context>::Prefetch() {
   const db::DBReader& reader = OperatorBase::Input<db::DBReader>(0);
-  TensorDeserializer<CPUContext> deserializer;
   if (batch_size_ == 0) {
     // We do not need to construct a batch. As a result, we will simply
     // deserialize everything into the target prefetched blob.
-    reader.Read(&key_, &value_);
+    TensorDeserializer<CPUContext> deserializer;
+    db::Slice value;
+    values_.resize(1);
+    reader.Read(&key_, &value, &values_[0]);
     TensorProtos protos;
-    CAFFE_ENFORCE(protos.ParseFromString(value_));
+    CAFFE_ENFORCE(protos.ParseFromArray(value.data, value.size));
     CAFFE_ENFORCE(protos.protos_size() == OutputSize());
     for (int i = 0; i < protos.protos_size(); ++i) {
       if (protos.protos(i).has_device_detail()) {
@@ -60,46 +124,78 @@ bool TensorProtosDBInput<Context>::Prefetch() {
           prefetched_blobs_[i].template GetMutable<TensorCPU>());
     }
   } else {
-    vector<TensorCPU> temp_tensors(OutputSize());
+    // The records are read in order, and then decoded into their slots of
+    // the batch by the decode threads.
+    vector<db::Slice> values(batch_size_);
+    values_.resize(batch_size_);
     for (int item_id = 0; item_id < batch_size_; ++item_id) {
-      reader.Read(&key_, &value_);
+      reader.Read(&key_, &values[item_id], &values_[item_id]);
+    }
+
+    // The shapes of the batch are set from the first record, which is
+    // decoded here before the others.
+    {
       TensorProtos protos;
-      CAFFE_ENFORCE(protos.ParseFromString(value_));
+      CAFFE_ENFORCE(protos.ParseFromArray(values[0].data, values[0].size));
       CAFFE_ENFORCE(protos.protos_size() == OutputSize());
-      if (!shape_inferred_) {
-        // First, set the shape of all the blobs.
-        for (int i = 0; i < protos.protos_size(); ++i) {
-          vector<int> dims(
-              protos.protos(i).dims().begin(), protos.protos(i).dims().end());
-          dims.insert(dims.begin(), batch_size_);
-          prefetched_blobs_[i].template GetMutable<TensorCPU>()->Resize(dims);
-        }
-      }
       for (int i = 0; i < protos.protos_size(); ++i) {
-        TensorCPU* dst = prefetched_blobs_[i].template GetMutable<TensorCPU>();
-        TensorCPU& src = temp_tensors[i];
-        if (protos.protos(i).has_device_detail()) {
-          protos.mutable_protos(i)->clear_device_detail();
-        }
-        deserializer.Deserialize(protos.protos(i), &src);
-        DCHECK_EQ(src.size() * batch_size_, dst->size());
-        this->context_.template CopyItems<CPUContext, CPUContext>(
-            src.meta(),
-            src.size(),
-            src.raw_data(),
-            static_cast<char*>(dst->raw_mutable_data(src.meta())) +
-                src.nbytes() * item_id);
+        vector<int> dims(
+            protos.protos(i).dims().begin(), protos.protos(i).dims().end());
+        dims.insert(dims.begin(), batch_size_);
+        prefetched_blobs_[i].template GetMutable<TensorCPU>()->Resize(dims);
+      }
+    }
+    DecodeItem(values[0], 0, 0);
+
+    if (!thread_pool_) {
+      for (int item_id = 1; item_id < batch_size_; ++item_id) {
+        DecodeItem(values[item_id], item_id, 0);
+      }
+    } else {
+      decode_error_ = nullptr;
+      for (int item_id = 1; item_id < batch_size_; ++item_id) {
+        const db::Slice value = values[item_id];
+        thread_pool_->runTaskWithID(
+            [this, value, item_id](std::size_t thread_id) {
+              try {
+                DecodeItem(value, item_id, thread_id);
+              } catch (...) {
+                std::lock_guard<std::mutex> lock(decode_error_mutex_);
+                if (!decode_error_) {
+                  decode_error_ = std::current_exception();
+                }
+              }
+            });
+      }
+      thread_pool_->waitWorkComplete();
+      if (decode_error_) {
+        std::rethrow_exception(decode_error_);
       }
     }
   }
+
+  // If the context is not CPUContext, upload the batch in the prefetch thread
+  // as well. The CPU tensors are in pinned memory once a CUDAContext exists,
+  // so the copy is asynchronous, and the prefetch worker waits for it.
+  if (!std::is_same<Context, CPUContext>::value) {
+    for (int i = 0; i < OutputSize(); ++i) {
+      prefetched_blobs_on_device_[i].CopyFrom(
+          prefetched_blobs_[i].template Get<TensorCPU>(), &context_);
+    }
+  }
   return true;
 }
 
 template <class Context>
 bool TensorProtosDBInput<Context>::CopyPrefetched() {
   for (int i = 0; i < OutputSize(); ++i) {
-    OperatorBase::Output<Tensor<Context>>(i)->CopyFrom(
-        prefetched_blobs_[i].template Get<TensorCPU>(), &this->context_);
+    if (std::is_same<Context, CPUContext>::value) {
+      this->template PrefetchedOutput<Tensor<Context>>(i)->CopyFrom(
+          prefetched_blobs_[i].template Get<TensorCPU>(), &context_);
+    } else {
+      this->template PrefetchedOutput<Tensor<Context>>(i)->CopyFrom(
+          prefetched_blobs_on_device_[i], &context_);
+    }
   }
   return true;
 }
@@ -88,7 +88,9 @@ class TextFileReaderReadOp : public Operator<CPUContext> {
  public:
   TextFileReaderReadOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<CPUContext>(operator_def, ws),
-        batchSize_(GetSingleArgument<int>("batch_size", 1)) {}
+        batchSize_(GetSingleArgument<int>("batch_size", 1)),
+        intraOpParallel_(GetSingleArgument<bool>("intra_op_parallel", false)),
+        ws_(ws) {}
 
   bool RunOnDevice() override {
     const int numFields = OutputSize();
@@ -116,6 +118,8 @@ class TextFileReaderReadOp : public Operator<CPUContext> {
     {
       // TODO(azzolini): support multi-threaded reading
       std::lock_guard<std::mutex> guard(instance->globalMutex_);
+      instance->tokenizer.setThreadPool(
+          intraOpParallel_ ? ws_->GetThreadPool() : nullptr);
 
       bool finished = false;
       Token token;
@@ -157,6 +161,8 @@ class TextFileReaderReadOp : public Operator<CPUContext> {
 
  private:
   TIndex batchSize_;
+  bool intraOpParallel_;
+  Workspace* ws_;
 };
 
 CAFFE_KNOWN_TYPE(std::unique_ptr<TextFileReaderInstance>);
@@ -184,7 +190,12 @@ OPERATOR_SCHEMA(TextFileReaderRead)
         "Each output is a 1D tensor containing the values for the given field "
         "for each row. When end of file is reached, returns empty tensors.")
     .Input(0, "handler", "Pointer to an existing TextFileReaderInstance.")
-    .Arg("batch_size", "Maximum number of rows to read.");
+    .Arg("batch_size", "Maximum number of rows to read.")
+    .Arg(
+        "intra_op_parallel",
+        "(bool, default false) Tokenize the text that is read from the file "
+        "in parallel on the thread pool of the workspace, split at rows. The "
+        "rows are returned in the file order either way.");
 
 NO_GRADIENT(CreateTextFileReader);
 NO_GRADIENT(TextFileReaderRead);
@@ -1,12 +1,27 @@
 #include "caffe2/operators/text_file_reader_utils.h"
 
 #include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <sstream>
 
+#include "caffe2/perfkernels/text_scan.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
+
 namespace caffe2 {
 
+namespace {
+
+// Batches are tokenized in parallel in chunks of about this many bytes.
+constexpr size_t kParallelChunkSize = 1 << 15;
+
+constexpr size_t kFileReaderAlignment = 4096;
+
+} // namespace
+
 Tokenizer::Tokenizer(const std::vector<char>& delims, char escape)
     : escape_(escape) {
   reset();
@@ -14,6 +29,57 @@ Tokenizer::Tokenizer(const std::vector<char>& delims, char escape)
   for (int i = 0; i < delims.size(); ++i) {
     delimTable_[(unsigned char)delims.at(i)] = i + 1;
   }
+  // rows can only be told apart if delimiter 0 isn't overridden by the
+  // escape character or by a later delimiter
+  if (!delims.empty() && delims[0] != escape_ &&
+      delimTable_[(unsigned char)delims[0]] == 1) {
+    hasRowDelim_ = true;
+    rowDelim_ = delims[0];
+  }
+  scanChars_.push_back(escape_);
+  for (char delim : delims) {
+    if (std::find(scanChars_.begin(), scanChars_.end(), delim) ==
+        scanChars_.end()) {
+      scanChars_.push_back(delim);
+    }
+  }
+  if (scanChars_.size() > kFindFirstOfMaxChars) {
+    scanChars_.clear();
+  }
+}
+
+char* Tokenizer::findSpecial(char* start, char* end) const {
+  if (!scanChars_.empty()) {
+    return const_cast<char*>(
+        FindFirstOf(start, end, scanChars_.data(), scanChars_.size()));
+  }
+  while (start < end && *start != escape_ &&
+         delimTable_[(unsigned char)*start] == 0) {
+    ++start;
+  }
+  return start;
+}
+
+char* Tokenizer::nextRowStart(char* lowerBound, char* from, char* end) const {
+  if (!hasRowDelim_) {
+    return end;
+  }
+  while (from < end) {
+    char* delim = static_cast<char*>(std::memchr(from, rowDelim_, end - from));
+    if (!delim) {
+      return end;
+    }
+    // the delimiter is escaped if it follows an odd number of escapes
+    char* escapes = delim;
+    while (escapes > lowerBound && escapes[-1] == escape_) {
+      --escapes;
+    }
+    if ((delim - escapes) % 2 == 0) {
+      return delim + 1;
+    }
+    from = delim + 1;
+  }
+  return end;
 }
 
 void Tokenizer::reset() {
@@ -34,8 +100,12 @@ void Tokenizer::next(char* start, char* end, TokenizedString& tokenized) {
     *copied = std::move(leftover_);
   }
 
-  char* ch;
-  for (ch = start + toBeSkipped_; ch < end; ++ch) {
+  char* ch = start + toBeSkipped_;
+  while (ch < end) {
+    ch = findSpecial(ch, end);
+    if (ch == end) {
+      break;
+    }
     if (*ch == escape_) {
       if (!copied) {
         tokenized.modifiedStrings_.emplace_back(new std::string());
@@ -44,7 +114,7 @@ void Tokenizer::next(char* start, char* end, TokenizedString& tokenized) {
       copied->append(currentStart, ch);
       currentStart = ch + 1;
       // skip next character, since it's escaped
-      ++ch;
+      ch += 2;
       continue;
     }
     int newDelimId = delimTable_[(unsigned char)*ch];
@@ -66,6 +136,7 @@ void Tokenizer::next(char* start, char* end, TokenizedString& tokenized) {
       copied = nullptr;
       startDelimId_ = newDelimId - 1;
     }
+    ++ch;
   }
   tokenized.lastDelim_ = startDelimId_;
 
@@ -78,21 +149,82 @@ void Tokenizer::next(char* start, char* end, TokenizedString& tokenized) {
   }
 }
 
+void BufferedTokenizer::tokenize(char* start, char* end) {
+  const size_t numChunks = pool_ ? (end - start) / kParallelChunkSize : 1;
+  if (numChunks <= 1) {
+    tokenizer_.next(start, end, tokenized_);
+    return;
+  }
+
+  // chunk i is [bounds[i], bounds[i + 1]), and every chunk but the first
+  // starts a row, so it is tokenized from the initial state
+  char* lowerBound = start + tokenizer_.toBeSkipped();
+  std::vector<char*> bounds{start};
+  for (size_t i = 1; i < numChunks; ++i) {
+    char* from = std::max(bounds.back(), start + (end - start) * i / numChunks);
+    char* bound = tokenizer_.nextRowStart(lowerBound, from, end);
+    if (bound == end) {
+      break;
+    }
+    if (bound > bounds.back()) {
+      bounds.push_back(bound);
+    }
+  }
+  bounds.push_back(end);
+
+  const size_t numBounds = bounds.size() - 1;
+  chunkTokenizers_.assign(numBounds - 1, tokenizer_);
+  for (auto& tokenizer : chunkTokenizers_) {
+    tokenizer.reset();
+  }
+  chunkTokenized_.resize(numBounds);
+  pool_->run(
+      [&](int /* unused */, size_t i) {
+        auto& tokenizer = i == 0 ? tokenizer_ : chunkTokenizers_[i - 1];
+        tokenizer.next(bounds[i], bounds[i + 1], chunkTokenized_[i]);
+      },
+      numBounds);
+  if (numBounds > 1) {
+    // the state after the last chunk is carried over to the next batch
+    tokenizer_ = std::move(chunkTokenizers_.back());
+  }
+
+  tokenized_.modifiedStrings_.clear();
+  tokenized_.tokens_.clear();
+  for (size_t i = 0; i < numBounds; ++i) {
+    auto& chunk = chunkTokenized_[i];
+    tokenized_.tokens_.insert(
+        tokenized_.tokens_.end(), chunk.tokens_.begin(), chunk.tokens_.end());
+    // the strings are moved by pointer, so the tokens stay valid
+    for (auto& str : chunk.modifiedStrings_) {
+      tokenized_.modifiedStrings_.push_back(std::move(str));
+    }
+  }
+  tokenized_.lastDelim_ = chunkTokenized_[numBounds - 1].lastDelim_;
+}
+
 FileReader::FileReader(const std::string& path, size_t bufferSize)
-    : bufferSize_(bufferSize), buffer_(new char[bufferSize]) {
+    : bufferSize_(bufferSize), buffer_(nullptr, std::free) {
+  void* buffer = nullptr;
+  if (posix_memalign(&buffer, kFileReaderAlignment, bufferSize) != 0) {
+    throw std::runtime_error(
+        "Error allocating a read buffer of " + to_string(bufferSize) +
+        " bytes");
+  }
+  buffer_.reset(static_cast<char*>(buffer));
   fd_ = open(path.c_str(), O_RDONLY, 0777);
   if (fd_ < 0) {
     throw std::runtime_error(
         "Error opening file for reading: " + std::string(std::strerror(errno)) +
         " Path=" + path);
   }
+#ifdef POSIX_FADV_SEQUENTIAL
+  posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 }
 
 void FileReader::reset() {
-  if (lseek(fd_, 0, SEEK_SET) == -1) {
-    throw std::runtime_error(
-        "Error reseting file cursor: " + std::string(std::strerror(errno)));
-  }
+  offset_ = 0;
 }
 
 FileReader::~FileReader() {
@@ -103,7 +235,7 @@ FileReader::~FileReader() {
 
 void FileReader::operator()(CharRange& range) {
   char* buffer = buffer_.get();
-  auto numRead = read(fd_, buffer, bufferSize_);
+  auto numRead = pread(fd_, buffer, bufferSize_, offset_);
   if (numRead == -1) {
     throw std::runtime_error(
         "Error reading file: " + std::string(std::strerror(errno)));
@@ -113,6 +245,7 @@ void FileReader::operator()(CharRange& range) {
     range.end = nullptr;
     return;
   }
+  offset_ += numRead;
   range.start = buffer;
   range.end = buffer + numRead;
 }
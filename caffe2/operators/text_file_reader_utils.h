@@ -1,6 +1,8 @@
 #ifndef CAFFE2_OPERATORS_TEXT_FILE_READER_UTILS_H
 #define CAFFE2_OPERATORS_TEXT_FILE_READER_UTILS_H
 
+#include <sys/types.h>
+
 #include <memory>
 #include <string>
 #include <vector>
@@ -9,6 +11,8 @@
 
 namespace caffe2 {
 
+class ThreadPool;
+
 struct Token {
   int startDelimId;
   const char* start;
@@ -29,6 +33,7 @@ class TokenizedString {
     return lastDelim_;
   }
   friend class Tokenizer;
+  friend class BufferedTokenizer;
 };
 
 class Tokenizer {
@@ -40,12 +45,32 @@ class Tokenizer {
   // e.g. an escape char that was the last character of the last batch.
   int toBeSkipped_;
   int delimTable_[256];
-  const char escape_;
+  char escape_;
+  bool hasRowDelim_{false};
+  char rowDelim_{0};
+  // the delimiters and the escape character, if there are few enough of them
+  // to scan for with FindFirstOf, otherwise empty
+  std::vector<char> scanChars_;
+
+  // Returns the first delimiter or escape character of [start, end), or end.
+  char* findSpecial(char* start, char* end) const;
 
  public:
   Tokenizer(const std::vector<char>& delimiters, char escape);
   void reset();
   void next(char* start, char* end, TokenizedString& tokenized);
+
+  // Returns the position right after the first delimiter 0 at or after from
+  // that isn't escaped, or end if there is none. The characters at and after
+  // lowerBound are scanned to tell if a delimiter is escaped, so lowerBound
+  // must be a position where the tokenizer isn't escaping a character.
+  char* nextRowStart(char* lowerBound, char* from, char* end) const;
+
+  // The number of characters of the next batch that are escaped by the end
+  // of the last batch.
+  int toBeSkipped() const {
+    return toBeSkipped_;
+  }
 };
 
 struct CharRange {
@@ -64,6 +89,13 @@ class BufferedTokenizer {
   BufferedTokenizer(const Tokenizer& t, StringProvider* p, int numPasses = 1)
       : provider_(p), tokenizer_(t), tokenIndex_(0), numPasses_(numPasses) {}
 
+  // With a thread pool set, every batch of the provider is split at rows
+  // (delimiter 0) into chunks that are tokenized in parallel. The tokens are
+  // the same, and in the same order, as without a thread pool.
+  void setThreadPool(ThreadPool* pool) {
+    pool_ = pool;
+  }
+
   bool next(Token& token) {
     CharRange range;
     while (tokenIndex_ >= tokenized_.tokens().size()) {
@@ -81,7 +113,7 @@ class BufferedTokenizer {
       if (range.start == nullptr) {
         return false;
       }
-      tokenizer_.next(range.start, range.end, tokenized_);
+      tokenize(range.start, range.end);
       tokenIndex_ = 0;
     }
     token = tokenized_.tokens()[tokenIndex_++];
@@ -96,17 +128,24 @@ class BufferedTokenizer {
   }
 
  private:
+  void tokenize(char* start, char* end);
+
   StringProvider* provider_;
   Tokenizer tokenizer_;
   TokenizedString tokenized_;
   int tokenIndex_;
   int numPasses_;
   int pass_{0};
+  ThreadPool* pool_{nullptr};
+  // per chunk state of the parallel tokenization
+  std::vector<Tokenizer> chunkTokenizers_;
+  std::vector<TokenizedString> chunkTokenized_;
 };
 
+// Reads a file in batches of bufferSize bytes, into a page aligned buffer.
 class FileReader : public StringProvider {
  public:
-  explicit FileReader(const std::string& path, size_t bufferSize = 65536);
+  explicit FileReader(const std::string& path, size_t bufferSize = 1 << 22);
   ~FileReader();
   void operator()(CharRange& range) override;
   void reset() override;
@@ -114,7 +153,8 @@ class FileReader : public StringProvider {
  private:
   const size_t bufferSize_;
   int fd_;
-  std::unique_ptr<char[]> buffer_;
+  off_t offset_{0};
+  std::unique_ptr<char, void (*)(void*)> buffer_;
 };
 
 } // namespace caffe2
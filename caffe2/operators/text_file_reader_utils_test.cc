@@ -8,6 +8,7 @@
 
 #include "caffe2/operators/text_file_reader_utils.h"
 #include "caffe2/utils/string_utils.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
 
 #include <cstdio>
 #include <cstdlib>
@@ -119,4 +120,69 @@ TEST(TextFileReaderUtilsTest, TokenizeTest) {
   std::remove(tmpname);
 }
 
+TEST(TextFileReaderUtilsTest, ParallelTokenizeTest) {
+  // rows with escaped delimiters and escapes, long enough to be split into
+  // several chunks
+  std::string ch;
+  std::vector<std::pair<int, std::string>> expected;
+  for (int row = 0; ch.size() < (1 << 20); ++row) {
+    const std::string label = "label" + to_string(row);
+    std::string text = "text" + to_string(row);
+    std::string escaped = text;
+    if (row % 3 == 0) {
+      // an escaped row delimiter
+      text += "\\\n";
+      escaped += "\\\\\\\n";
+    }
+    if (row % 5 == 0) {
+      text += "\1";
+      escaped += "\\\1";
+    }
+    if (row % 7 == 0) {
+      // an escape right before the row delimiter
+      text += "\\";
+      escaped += "\\\\";
+    }
+    ch += label + "\1" + escaped + "\n";
+    expected.emplace_back(0, label);
+    expected.emplace_back(1, text);
+  }
+
+  struct StringRangeProvider : public StringProvider {
+    explicit StringRangeProvider(const std::string& str) : ch(str) {}
+    std::string ch;
+    bool done{false};
+    void operator()(CharRange& range) {
+      if (done) {
+        range.start = nullptr;
+        range.end = nullptr;
+      } else {
+        range.start = &ch.front();
+        range.end = &ch.back() + 1;
+        done = true;
+      }
+    }
+    void reset() {
+      done = false;
+    }
+  };
+
+  ThreadPool pool(4);
+  for (int numPasses = 1; numPasses <= 2; ++numPasses) {
+    StringRangeProvider provider(ch);
+    BufferedTokenizer bt(Tokenizer({'\n', '\1'}, '\\'), &provider, numPasses);
+    bt.setThreadPool(&pool);
+    Token token;
+    int i = 0;
+    for (i = 0; bt.next(token); ++i) {
+      ASSERT_GT(expected.size() * numPasses, i);
+      const auto& expectedToken = expected.at(i % expected.size());
+      EXPECT_EQ(expectedToken.first, token.startDelimId);
+      EXPECT_EQ(expectedToken.second, std::string(token.start, token.end));
+    }
+    EXPECT_EQ(expected.size() * numPasses, i);
+    EXPECT_EQ(0, bt.endDelim());
+  }
+}
+
 } // namespace caffe2
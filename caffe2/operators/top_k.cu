@@ -7,8 +7,7 @@
 #include <numeric>
 #include <vector>
 
-#include <thrust/sort.h>
-#include <thrust/system/cuda/execution_policy.h>
+#include <cub/cub.cuh>
 
 #include "caffe2/core/context.h"
 #include "caffe2/core/context_gpu.h"
@@ -46,6 +45,22 @@ void RunHeapSelectionImpl(
           k);
 }
 
+// Maps a row to the offset of its element 'shift' in the (outer_size, k)
+// output, for the segment boundaries of the segmented sort.
+struct RowOffsetOp {
+  RowOffsetOp(const int k, const int shift) : k(k), shift(shift) {}
+
+  __host__ __device__ __forceinline__ int operator()(const int& row) const {
+    return row * k + shift;
+  }
+
+  const int k;
+  const int shift;
+};
+
+using RowOffsetIterator = cub::
+    TransformInputIterator<int, RowOffsetOp, cub::CountingInputIterator<int>>;
+
 template <typename T, bool kSelectMax = true>
 void RunRadixSelectionImpl(
     const T* input,
@@ -54,24 +69,76 @@ void RunRadixSelectionImpl(
     const int k,
     T* values,
     TIndex* indices,
+    Tensor<CUDAContext>* values_buffer,
+    Tensor<CUDAContext>* indices_buffer,
+    Tensor<CUDAContext>* sort_buffer,
     CUDAContext* context) {
   const int block = std::min(
       math::roundUp(static_cast<int>(inner_size), kWarpSize),
       CAFFE_CUDA_NUM_THREADS);
+  // The selection does not sort its output, so select into scratch buffers
+  // and sort all of the rows from there into the output at once.
+  values_buffer->Resize(outer_size, k);
+  indices_buffer->Resize(outer_size, k);
+  T* values_unsorted = values_buffer->template mutable_data<T>();
+  TIndex* indices_unsorted = indices_buffer->template mutable_data<TIndex>();
   gatherTopK<T, kSelectMax, TIndex>
       <<<outer_size, block, 0, context->cuda_stream()>>>(
-          input, inner_size, k, outer_size, values, indices);
-  // Unfortunately the output is not currently sorted, and there is no batch
-  // sorting utility available. Iterate over all of the slices and sort them
-  // in-place using Thrust.
-  for (int i = 0; i < outer_size; ++i) {
-    thrust::sort_by_key(
-        thrust::cuda::par.on(context->cuda_stream()),
-        values + i * k,
-        values + i * k + (k <= inner_size ? k : inner_size),
-        indices + i * k,
-        thrust::greater<T>());
-  }
+          input,
+          inner_size,
+          k,
+          outer_size,
+          values_unsorted,
+          indices_unsorted);
+
+  CAFFE_ENFORCE_LE(
+      outer_size * k,
+      std::numeric_limits<int>::max(),
+      "TopK output is too large to sort");
+  // Only the first min(k, inner_size) entries of a row are selected; the
+  // remaining ones keep the default value set in the output.
+  const int row_size = static_cast<int>(std::min<TIndex>(k, inner_size));
+  const RowOffsetIterator row_begin(
+      cub::CountingInputIterator<int>(0), RowOffsetOp(k, 0));
+  const RowOffsetIterator row_end(
+      cub::CountingInputIterator<int>(0), RowOffsetOp(k, row_size));
+  size_t sort_bytes = 0;
+  const auto sort = [&](void* temp_storage) {
+    if (kSelectMax) {
+      cub::DeviceSegmentedRadixSort::SortPairsDescending(
+          temp_storage,
+          sort_bytes,
+          values_unsorted,
+          values,
+          indices_unsorted,
+          indices,
+          static_cast<int>(outer_size * k),
+          static_cast<int>(outer_size),
+          row_begin,
+          row_end,
+          0,
+          8 * sizeof(T),
+          context->cuda_stream());
+    } else {
+      cub::DeviceSegmentedRadixSort::SortPairs(
+          temp_storage,
+          sort_bytes,
+          values_unsorted,
+          values,
+          indices_unsorted,
+          indices,
+          static_cast<int>(outer_size * k),
+          static_cast<int>(outer_size),
+          row_begin,
+          row_end,
+          0,
+          8 * sizeof(T),
+          context->cuda_stream());
+    }
+  };
+  sort(nullptr);
+  sort_buffer->Resize(sort_bytes);
+  sort(static_cast<void*>(sort_buffer->template mutable_data<uint8_t>()));
 }
 
 template <typename T>
@@ -82,6 +149,9 @@ void RunTopKOnLastDimCUDAImpl(
     const int k,
     T* values,
     TIndex* indices,
+    Tensor<CUDAContext>* values_buffer,
+    Tensor<CUDAContext>* indices_buffer,
+    Tensor<CUDAContext>* sort_buffer,
     CUDAContext* context) {
   // If k is small, uses heap selection, otherwise uses radix selection.
   if (k < 32) {
@@ -95,7 +165,16 @@ void RunTopKOnLastDimCUDAImpl(
         input, outer_size, inner_size, k, values, indices, context);
   } else {
     RunRadixSelectionImpl<T>(
-        input, outer_size, inner_size, k, values, indices, context);
+        input,
+        outer_size,
+        inner_size,
+        k,
+        values,
+        indices,
+        values_buffer,
+        indices_buffer,
+        sort_buffer,
+        context);
   }
 }
 
@@ -170,6 +249,11 @@ class TopKCudaOp : public Operator<Context> {
   Tensor<Context> values_transposed_buffer_;
   Tensor<Context> indices_transposed_buffer_;
 
+  // Buffers for sorting the output of the radix selection.
+  Tensor<Context> values_sort_buffer_;
+  Tensor<Context> indices_sort_buffer_;
+  Tensor<Context> sort_buffer_;
+
   // Shape tensors on device for CUDAContext.
   Tensor<Context> input_dims_device_;
   Tensor<Context> input_transposed_dims_device_;
@@ -259,6 +343,9 @@ bool TopKCudaOp<T, Context>::RunOnDevice() {
       k_,
       values_data,
       indices_data,
+      &values_sort_buffer_,
+      &indices_sort_buffer_,
+      &sort_buffer_,
       &context_);
   if (need_transpose) {
     const std::array<int, 3> dims = {
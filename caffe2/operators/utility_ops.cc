@@ -357,6 +357,7 @@ Currently only works on CPU because of access to INDICES.
 OPERATOR_SCHEMA(Copy)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<0>)
     .IdenticalTypeAndShape()
     .InputsCanCrossDevices()
     .SetDoc(R"DOC(
@@ -613,9 +614,31 @@ is_empty:  True
     .Input(0, "tensor", "Input data tensor to check if empty.")
     .Output(0, "is_empty", "Output scalar boolean tensor. True if input has size == 0.");
 
+namespace {
+OpSchema::Cost CostInferenceForGather(
+    const OperatorDef& /* unused */,
+    const vector<TensorShape>& in) {
+  CAFFE_ENFORCE_EQ(in.size(), 2, "Gather requires two inputs");
+  struct OpSchema::Cost c;
+  const auto& data = in[0];
+  const auto& indices = in[1];
+  const uint64_t nIndices = nElemFromDim(indices);
+  const uint64_t block =
+      data.dims_size() > 0 ? size_from_dim_(1, GetDimsVector(data)) : 0;
+  c.flops = 0;
+  c.bytes_read = nIndices * block * sizeof(data.data_type()) +
+      nIndices * sizeof(indices.data_type());
+  c.bytes_written = nIndices * block * sizeof(data.data_type());
+  c.params_bytes = 0;
+  return c;
+}
+} // namespace
+
 OPERATOR_SCHEMA(Gather)
     .NumInputs(2)
     .NumOutputs(1)
+    .CostInferenceFunction(
+        OpSchema::CostInferenceFunctionType(CostInferenceForGather))
     .SetDoc(R"DOC(
 
 The *Gather* op accepts a *DATA* tensor of rank $r >= 1$ and *INDICES* tensor of rank $q$ as inputs. It then gathers entries of the outer-most dimension of *DATA*, indexed by *INDICES*, and concatenate them in an output tensor of rank $q + (r - 1)$.
@@ -682,6 +705,10 @@ OUTPUT:
     .Input(0, "DATA", "Input data tensor of rank $r>=1$")
     .Input(1, "INDICES", "Input indices tensor of rank $q$. This tensor must contain integers.")
     .Output(0, "OUTPUT", "Output tensor of rank $q+(r-1)$")
+    .Arg(
+        "intra_op_parallel",
+        "*(type: bool; default: False)* Copy the output in parallel on the "
+        "thread pool of the workspace (CPU only)")
     .TensorInferenceFunction([](const OperatorDef& def,
                                 const vector<TensorShape>& in) {
       vector<TensorShape> out(1);
@@ -931,6 +958,7 @@ caution.
 OPERATOR_SCHEMA(EnsureDense)
     .NumInputs(1)
     .NumOutputs(1)
+    .CostInferenceFunction(PointwiseCostInference<0>)
     .AllowInplace({{0, 0}})
     .IdenticalTypeAndShape()
     .SetDoc(R"DOC(
@@ -10,6 +10,7 @@
 #include "caffe2/operators/utility_ops.h"
 #include "caffe2/utils/math.h"
 
+#include <cub/cub.cuh>
 #include <thrust/device_vector.h>
 #include <thrust/sequence.h>
 #include <thrust/sort.h>
@@ -347,6 +348,163 @@ bool GatherOp<CUDAContext>::DoRunWithType() {
 
 REGISTER_CUDA_OPERATOR(Gather, GatherOp<CUDAContext>);
 
+namespace {
+template <typename Index>
+__global__ void GatherRangesLengthsKernel(
+    const TIndex numRanges,
+    const TIndex dataSize,
+    const Index* ranges,
+    TIndex* rangeLengths) {
+  CUDA_1D_KERNEL_LOOP(i, numRanges) {
+    const auto rangeStart = ranges[2 * i];
+    const auto rangeLength = ranges[2 * i + 1];
+    CUDA_KERNEL_ASSERT(
+        rangeStart >= 0 && rangeLength >= 0 &&
+        rangeStart + rangeLength <= dataSize);
+    rangeLengths[i] = rangeLength;
+  }
+}
+
+// rangeOffsets holds the inclusive sums of the range lengths
+__global__ void GatherRangesOutputLengthsKernel(
+    const TIndex batchSize,
+    const TIndex rangesPerExample,
+    const TIndex* rangeOffsets,
+    int32_t* outputLengths) {
+  CUDA_1D_KERNEL_LOOP(i, batchSize) {
+    const auto end = rangeOffsets[(i + 1) * rangesPerExample - 1];
+    const auto start = i == 0 ? 0 : rangeOffsets[i * rangesPerExample - 1];
+    outputLengths[i] = end - start;
+  }
+}
+
+template <typename Index>
+__global__ void GatherRangesCopyKernel(
+    const TIndex numRanges,
+    const TIndex itemsize,
+    const Index* ranges,
+    const TIndex* rangeOffsets,
+    const char* src,
+    char* dest) {
+  for (TIndex i = blockIdx.x; i < numRanges; i += gridDim.x) {
+    const auto numBytes = ranges[2 * i + 1] * itemsize;
+    const auto srcBase = ranges[2 * i] * itemsize;
+    const auto destBase = rangeOffsets[i] * itemsize - numBytes;
+    for (TIndex j = threadIdx.x; j < numBytes; j += blockDim.x) {
+      dest[destBase + j] = src[srcBase + j];
+    }
+  }
+}
+} // namespace
+
+template <>
+class GatherRangesOp<CUDAContext> final : public Operator<CUDAContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CUDAContext);
+  GatherRangesOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CUDAContext>(operator_def, ws) {}
+
+  bool RunOnDevice() override {
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(RANGES));
+  }
+
+  template <typename Index>
+  bool DoRunWithType() {
+    auto& data = Input(DATA);
+    auto& ranges = Input(RANGES);
+    auto* outputData = Output(0);
+    auto* outputLengths = Output(1);
+
+    CAFFE_ENFORCE(data.ndim() == 1, "Data has to be 1-D");
+    CAFFE_ENFORCE(ranges.ndim() == 3, "Ranges must be 3-D");
+    CAFFE_ENFORCE(ranges.dim(1) > 0, "There has to be at least one range");
+    CAFFE_ENFORCE_EQ(
+        ranges.dim(2), 2, "Ranges last dimention should be of size 2");
+
+    const auto batchSize = ranges.dim(0);
+    const auto rangesPerExample = ranges.dim(1);
+    const auto numRanges = batchSize * rangesPerExample;
+    const auto* rangesData = ranges.template data<Index>();
+
+    outputLengths->Resize(batchSize);
+    auto* outputLengthsData = outputLengths->template mutable_data<int32_t>();
+    if (numRanges == 0) {
+      outputData->Resize(0);
+      outputData->raw_mutable_data(data.meta());
+      return true;
+    }
+
+    rangeLengths_.Resize(numRanges);
+    rangeOffsets_.Resize(numRanges);
+    auto* rangeLengthsData = rangeLengths_.mutable_data<TIndex>();
+    auto* rangeOffsetsData = rangeOffsets_.mutable_data<TIndex>();
+    GatherRangesLengthsKernel<Index><<<
+        CAFFE_GET_BLOCKS(numRanges),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        numRanges, data.size(), rangesData, rangeLengthsData);
+
+    size_t numBytes = 0;
+    cub::DeviceScan::InclusiveSum(
+        nullptr,
+        numBytes,
+        rangeLengthsData,
+        rangeOffsetsData,
+        numRanges,
+        context_.cuda_stream());
+    scratch_.Resize(
+        static_cast<TIndex>((numBytes + sizeof(TIndex) - 1) / sizeof(TIndex)));
+    cub::DeviceScan::InclusiveSum(
+        static_cast<void*>(scratch_.mutable_data<TIndex>()),
+        numBytes,
+        rangeLengthsData,
+        rangeOffsetsData,
+        numRanges,
+        context_.cuda_stream());
+
+    GatherRangesOutputLengthsKernel<<<
+        CAFFE_GET_BLOCKS(batchSize),
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        batchSize, rangesPerExample, rangeOffsetsData, outputLengthsData);
+
+    // Copy the output size from gpu to cpu
+    TIndex outputSize;
+    context_.Copy<TIndex, CUDAContext, CPUContext>(
+        1, rangeOffsetsData + numRanges - 1, &outputSize);
+
+    outputData->Resize(outputSize);
+    auto* outputRawData =
+        static_cast<char*>(outputData->raw_mutable_data(data.meta()));
+    if (outputSize > 0) {
+      GatherRangesCopyKernel<Index><<<
+          std::min(numRanges, static_cast<TIndex>(CAFFE_MAXIMUM_NUM_BLOCKS)),
+          CAFFE_CUDA_NUM_THREADS,
+          0,
+          context_.cuda_stream()>>>(
+          numRanges,
+          data.meta().itemsize(),
+          rangesData,
+          rangeOffsetsData,
+          static_cast<const char*>(data.raw_data()),
+          outputRawData);
+    }
+    return true;
+  }
+
+  INPUT_TAGS(DATA, RANGES, LENGTHS);
+
+ private:
+  Tensor<CUDAContext> rangeLengths_;
+  Tensor<CUDAContext> rangeOffsets_;
+  Tensor<CUDAContext> scratch_;
+};
+
+REGISTER_CUDA_OPERATOR(GatherRanges, GatherRangesOp<CUDAContext>);
+
 /**
  * @brief Update slices of Y in-place with a batch of weighted X's.
  * Y[idx] = alpha[b] * X[b][i] + Y[idx]
@@ -8,6 +8,7 @@
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/types.h"
+#include "caffe2/operators/gather_op_util.h"
 #include "caffe2/utils/math.h"
 
 #include <map>
@@ -1018,11 +1019,17 @@ class LengthsToShapeOp : public Operator<Context> {
   }
 };
 
+// With the argument intra_op_parallel set, the CPU op copies chunks of the
+// output on the thread pool of the workspace.
 template <class Context>
 class GatherOp : public Operator<Context> {
  public:
   USE_OPERATOR_CONTEXT_FUNCTIONS;
-  USE_SIMPLE_CTOR_DTOR(GatherOp);
+  GatherOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        intra_op_parallel_(
+            OperatorBase::GetSingleArgument<bool>("intra_op_parallel", false)),
+        ws_(ws) {}
 
   bool RunOnDevice() override {
     return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
@@ -1042,14 +1049,8 @@ class GatherOp : public Operator<Context> {
     shape.insert(shape.end(), data.dims().begin() + 1, data.dims().end());
     output->Resize(shape);
 
-    int block_size = data.size_from_dim(1);
-    auto block_bytesize = data.size_from_dim(1) * data.meta().itemsize();
     int N = indices.size();
-
-    auto src_base = static_cast<const char*>(data.raw_data());
     const Index* idxs = indices.template data<Index>();
-    auto out = static_cast<char*>(output->raw_mutable_data(data.meta()));
-
     for (int i = 0; i < N; ++i) {
       auto idx = idxs[i];
       CAFFE_ENFORCE(
@@ -1058,14 +1059,27 @@ class GatherOp : public Operator<Context> {
           idx,
           " data_dim=",
           data.dim(0));
-      auto src = src_base + idx * block_bytesize;
-      context_.template CopyItems<Context, Context>(
-          data.meta(), block_size, src, out + block_bytesize * i);
     }
+
+    gather_op_util::GatherBlocks(
+        data.meta(),
+        data.raw_data(),
+        1,
+        data.dim(0),
+        idxs,
+        N,
+        data.size_from_dim(1),
+        output->raw_mutable_data(data.meta()),
+        &context_,
+        intra_op_parallel_ ? ws_->GetThreadPool() : nullptr);
     return true;
   }
 
   INPUT_TAGS(DATA, INDICES);
+
+ private:
+  bool intra_op_parallel_;
+  Workspace* ws_;
 };
 
 template <class Context>
@@ -1,12 +1,16 @@
 #include "caffe2/opt/backend_cutting.h"
 #include "caffe2/opt/converter.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/core/operator_schema.h"
+#include "caffe2/core/types.h"
 #include "nomnigraph/Converters/Dot.h"
 #include "nomnigraph/Representations/NeuralNet.h"
 
 #include <algorithm>
 #include <fstream>
+#include <iomanip>
 #include <queue>
+#include <sstream>
 
 namespace caffe2 {
 namespace opt {
@@ -301,14 +305,90 @@ void PruneUnrefereredNodes(NNGraph* g) {
   }
 }
 
-} // namespace
+// Index of each operator node in the net it was converted from
+std::unordered_map<NodeRef, int> IndexOperators(NNModule* nn) {
+  std::unordered_map<NodeRef, int> index;
+  for (const auto& bb_node : nn->controlFlow.getMutableNodes()) {
+    for (const auto& node : bb_node->data()->getInstructions()) {
+      index.emplace(node, index.size());
+    }
+  }
+  return index;
+}
 
-caffe2::NetDef OptimizeForBackend(
+BackendCutReport::Subgraph EstimateSubgraph(
+    const TransformSubgraph& sub,
+    const std::unordered_map<NodeRef, int>& op_index,
+    const BackendCostModel& cost_model) {
+  BackendCutReport::Subgraph estimate;
+  estimate.group_id = sub.group_id;
+  float host_cost = 0;
+  float backend_cost = cost_model.subgraph_overhead_us;
+  bool known = true;
+  for (auto node : sub.nodes) {
+    if (!nn::is<NeuralNetOperator>(node)) {
+      continue;
+    }
+    ++estimate.num_ops;
+    auto it = op_index.find(node);
+    if (it == op_index.end() ||
+        it->second >= (int)cost_model.host_costs_us.size() ||
+        it->second >= (int)cost_model.backend_costs_us.size() ||
+        cost_model.host_costs_us[it->second] < 0 ||
+        cost_model.backend_costs_us[it->second] < 0) {
+      known = false;
+      continue;
+    }
+    host_cost += cost_model.host_costs_us[it->second];
+    backend_cost += cost_model.backend_costs_us[it->second];
+  }
+
+  auto add_transfers =
+      [&](const std::unordered_map<std::string, NodeRef>& refs) {
+        for (const auto& kv : refs) {
+          if (cost_model.resident_blobs.count(kv.first)) {
+            continue;
+          }
+          auto it = cost_model.blob_bytes.find(kv.first);
+          if (it != cost_model.blob_bytes.end()) {
+            estimate.transfer_bytes += it->second;
+          }
+        }
+      };
+  add_transfers(sub.external_input_refs);
+  add_transfers(sub.external_output_refs);
+  backend_cost += estimate.transfer_bytes * cost_model.transfer_us_per_byte;
+
+  if (known) {
+    estimate.host_cost_us = host_cost;
+    estimate.backend_cost_us = backend_cost;
+    estimate.offloaded =
+        host_cost - backend_cost >= cost_model.min_benefit_us;
+  }
+  return estimate;
+}
+
+caffe2::NetDef OptimizeForBackendImpl(
     caffe2::NetDef& net,
     std::function<bool(const caffe2::OperatorDef&)> supports,
-    std::function<caffe2::NetDef(const caffe2::NetDef&)> transform_func) {
+    std::function<caffe2::NetDef(const caffe2::NetDef&)> transform_func,
+    const BackendCostModel* cost_model,
+    BackendCutReport* report) {
   auto nn = convertToNNModule(net);
   auto& dfg = nn.dataFlow;
+  std::unordered_map<NodeRef, int> op_index;
+  if (cost_model) {
+    op_index = IndexOperators(&nn);
+    if ((int)op_index.size() != net.op_size()) {
+      LOG(WARNING) << "Operators of " << net.name()
+                   << " don't map to the graph, ignoring their costs";
+      op_index.clear();
+    }
+    for (float cost : cost_model->host_costs_us) {
+      report->net_host_cost_us += std::max(cost, 0.0f);
+    }
+    report->net_cost_us = report->net_host_cost_us;
+  }
 
   // Initialize the group info and figure out the external/input output
   VisitorContext context(supports);
@@ -361,6 +441,17 @@ caffe2::NetDef OptimizeForBackend(
     // Generate boundary input/output edges
     DetectBoundaryReferences(&g, context.infos);
 
+    if (cost_model) {
+      auto estimate = EstimateSubgraph(g, op_index, *cost_model);
+      report->subgraphs.push_back(estimate);
+      if (!estimate.offloaded) {
+        continue;
+      }
+      if (estimate.host_cost_us >= 0) {
+        report->net_cost_us -= estimate.host_cost_us - estimate.backend_cost_us;
+      }
+    }
+
     caffe2::NetDef subnet = ConvertToC2Net(g, context.infos);
     // Transform the subgraph protobuf def, note that we can have less external
     // inputs/outputs but not more
@@ -384,5 +475,105 @@ caffe2::NetDef OptimizeForBackend(
   return new_net;
 }
 
+} // namespace
+
+std::string BackendCutReport::ToString() const {
+  std::stringstream ss;
+  ss << std::fixed << std::setprecision(1);
+  int offloaded = 0;
+  for (const auto& sub : subgraphs) {
+    ss << "Group " << sub.group_id << ": " << sub.num_ops << " ops";
+    if (sub.host_cost_us >= 0) {
+      ss << ", host " << sub.host_cost_us << " us, backend "
+         << sub.backend_cost_us << " us";
+    } else {
+      ss << ", no estimate";
+    }
+    ss << ", transfers " << sub.transfer_bytes << " bytes, "
+       << (sub.offloaded ? "offloaded" : "kept on host") << "\n";
+    offloaded += sub.offloaded;
+  }
+  ss << "Offloaded " << offloaded << " of " << subgraphs.size()
+     << " subgraphs, estimated " << net_host_cost_us << " us -> "
+     << net_cost_us << " us (" << std::setprecision(2) << EstimatedSpeedup()
+     << "x)";
+  return ss.str();
+}
+
+BackendCostModel InferBackendCostModel(
+    const caffe2::NetDef& net,
+    const caffe2::TensorShapes& shapes,
+    float host_flops_per_us,
+    float backend_flops_per_us,
+    float transfer_bytes_per_us) {
+  BackendCostModel cost_model;
+  cost_model.transfer_us_per_byte = 1 / transfer_bytes_per_us;
+  std::unordered_map<std::string, const TensorShape*> shape_of;
+  for (const auto& shape : shapes.shapes()) {
+    if (!shape.has_name() || shape.unknown_shape()) {
+      continue;
+    }
+    shape_of[shape.name()] = &shape;
+    uint64_t size = DataTypeToTypeMeta(shape.data_type()).itemsize();
+    for (const auto d : shape.dims()) {
+      size *= d;
+    }
+    cost_model.blob_bytes[shape.name()] = size;
+  }
+
+  for (const auto& op_def : net.op()) {
+    float flops = -1;
+    const auto* schema = OpSchemaRegistry::Schema(op_def.type());
+    if (schema && schema->HasCostInferenceFunction()) {
+      std::vector<TensorShape> input_shapes;
+      for (const auto& input : op_def.input()) {
+        auto it = shape_of.find(input);
+        if (it == shape_of.end()) {
+          break;
+        }
+        input_shapes.push_back(*it->second);
+      }
+      if ((int)input_shapes.size() == op_def.input_size()) {
+        try {
+          flops = schema->InferCost(op_def, input_shapes).flops;
+        } catch (const EnforceNotMet& e) {
+          VLOG(1) << "Cost inference of " << op_def.type()
+                  << " failed: " << e.what();
+        }
+      }
+    }
+    cost_model.host_costs_us.push_back(
+        flops < 0 ? -1 : flops / host_flops_per_us);
+    cost_model.backend_costs_us.push_back(
+        flops < 0 ? -1 : flops / backend_flops_per_us);
+  }
+  return cost_model;
+}
+
+caffe2::NetDef OptimizeForBackend(
+    caffe2::NetDef& net,
+    std::function<bool(const caffe2::OperatorDef&)> supports,
+    std::function<caffe2::NetDef(const caffe2::NetDef&)> transform_func) {
+  return OptimizeForBackendImpl(
+      net, supports, transform_func, nullptr, nullptr);
+}
+
+caffe2::NetDef OptimizeForBackend(
+    caffe2::NetDef& net,
+    std::function<bool(const caffe2::OperatorDef&)> supports,
+    std::function<caffe2::NetDef(const caffe2::NetDef&)> transform_func,
+    const BackendCostModel& cost_model,
+    BackendCutReport* report) {
+  BackendCutReport local_report;
+  if (!report) {
+    report = &local_report;
+  }
+  *report = BackendCutReport();
+  auto new_net = OptimizeForBackendImpl(
+      net, supports, transform_func, &cost_model, report);
+  LOG(INFO) << "Backend cut of " << net.name() << ":\n" << report->ToString();
+  return new_net;
+}
+
 } // namespace opt
 } // namespace caffe2
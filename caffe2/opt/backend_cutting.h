@@ -5,13 +5,81 @@
 #include "caffe2/proto/caffe2.pb.h"
 
 #include <functional>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace caffe2 {
 namespace opt {
 
+// Estimates used to decide whether offloading a subgraph to the backend pays
+// off. All costs are in microseconds.
+struct BackendCostModel {
+  // Run time of each operator of the net, by index, on the host and on the
+  // backend, e.g. from inferOperatorCostsUs or readOperatorCostProfile.
+  // Negative for operators without an estimate. Subgraphs containing one are
+  // offloaded, as without a cost model.
+  std::vector<float> host_costs_us;
+  std::vector<float> backend_costs_us;
+  // Sizes of the blobs crossing the boundary of a subgraph. Blobs missing
+  // here, and blobs kept on the backend (e.g. weights absorbed by the
+  // transform), aren't counted as transfers.
+  std::unordered_map<std::string, uint64_t> blob_bytes;
+  std::unordered_set<std::string> resident_blobs;
+  float transfer_us_per_byte{0};
+  // Fixed cost of running one offloaded subgraph, e.g. launching it.
+  float subgraph_overhead_us{0};
+  // Subgraphs which are estimated to save less than this stay on the host.
+  float min_benefit_us{0};
+};
+
+// What OptimizeForBackend decided with a cost model, and why.
+struct BackendCutReport {
+  struct Subgraph {
+    int group_id{-1};
+    int num_ops{0};
+    // Negative if any operator of the subgraph has no estimate.
+    float host_cost_us{-1};
+    // Including the transfers and the overhead of the subgraph.
+    float backend_cost_us{-1};
+    uint64_t transfer_bytes{0};
+    bool offloaded{true};
+  };
+
+  std::vector<Subgraph> subgraphs;
+  // Estimated run time of the net on the host (of the operators with an
+  // estimate), and after the cut.
+  float net_host_cost_us{0};
+  float net_cost_us{0};
+
+  float EstimatedSpeedup() const {
+    return net_cost_us > 0 ? net_host_cost_us / net_cost_us : 1;
+  }
+  std::string ToString() const;
+};
+
+// Fills the operator costs of a cost model from their cost inference
+// functions at the given rates, and the blob sizes, from the shapes of the
+// blobs of the net (e.g. as returned by InferBlobShapesAndTypes).
+BackendCostModel InferBackendCostModel(
+    const caffe2::NetDef& net,
+    const caffe2::TensorShapes& shapes,
+    float host_flops_per_us,
+    float backend_flops_per_us,
+    float transfer_bytes_per_us);
+
 caffe2::NetDef OptimizeForBackend(
     caffe2::NetDef& net,
     std::function<bool(const caffe2::OperatorDef&)> supports,
     std::function<caffe2::NetDef(const caffe2::NetDef&)> transform_func);
+
+// As above, but only offloads the subgraphs that are estimated to be faster
+// on the backend by at least min_benefit_us, transfers included. The chosen
+// cut is logged and, if report is given, returned in it.
+caffe2::NetDef OptimizeForBackend(
+    caffe2::NetDef& net,
+    std::function<bool(const caffe2::OperatorDef&)> supports,
+    std::function<caffe2::NetDef(const caffe2::NetDef&)> transform_func,
+    const BackendCostModel& cost_model,
+    BackendCutReport* report = nullptr);
 }
 } // namespace caffe2
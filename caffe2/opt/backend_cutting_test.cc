@@ -131,3 +131,48 @@ TEST(BackendCuttingTest, skipPath) {
   auto net_opt = caffe2::opt::OptimizeForBackend(net, Supports, Transform);
   EXPECT_EQ(4, net_opt.op_size());
 }
+
+// X -> CopyIn -> MyConv -> MyConv -> CopyOut -> Y, offloaded unless the
+// transfers of N0 and N2 cost more than running the convolutions on the host
+TEST(BackendCuttingTest, costModel) {
+  caffe2::NetDef net;
+  net.add_external_input("X");
+  net.add_external_output("Y");
+  auto* op = net.add_op();
+  op->set_type("CopyIn");
+  op->add_input("X");
+  op->add_output("N0");
+  for (int i = 0; i < 2; ++i) {
+    AddConv(&net, i);
+  }
+  op = net.add_op();
+  op->set_type("CopyOut");
+  op->add_input("N2");
+  op->add_output("Y");
+
+  caffe2::opt::BackendCostModel cost_model;
+  cost_model.host_costs_us = {1, 10, 10, 1};
+  cost_model.backend_costs_us = {1, 1, 1, 1};
+  cost_model.blob_bytes = {{"N0", 4000}, {"N2", 4000}, {"W0", 1000}};
+  cost_model.resident_blobs = {"W0"};
+  cost_model.transfer_us_per_byte = 0.001;
+
+  caffe2::opt::BackendCutReport report;
+  auto net_opt = caffe2::opt::OptimizeForBackend(
+      net, Supports, Transform, cost_model, &report);
+  EXPECT_EQ(3, net_opt.op_size());
+  ASSERT_EQ(1, report.subgraphs.size());
+  EXPECT_TRUE(report.subgraphs[0].offloaded);
+  EXPECT_EQ(2, report.subgraphs[0].num_ops);
+  EXPECT_EQ(8000, report.subgraphs[0].transfer_bytes);
+  EXPECT_FLOAT_EQ(22, report.net_host_cost_us);
+  EXPECT_FLOAT_EQ(12, report.net_cost_us);
+
+  cost_model.transfer_us_per_byte = 0.01;
+  net_opt = caffe2::opt::OptimizeForBackend(
+      net, Supports, Transform, cost_model, &report);
+  EXPECT_EQ(4, net_opt.op_size());
+  ASSERT_EQ(1, report.subgraphs.size());
+  EXPECT_FALSE(report.subgraphs[0].offloaded);
+  EXPECT_FLOAT_EQ(1, report.EstimatedSpeedup());
+}
@@ -1,12 +1,181 @@
+#include "caffe2/operators/fused_elementwise_op.h"
 #include "caffe2/opt/converter.h"
 #include "caffe2/opt/fusion.h"
 #include "caffe2/opt/passes.h"
 
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+#include <unordered_set>
+
 namespace caffe2 {
 namespace opt {
 
 using namespace nom;
 
+namespace {
+
+using NodeRef = repr::NNGraph::NodeRef;
+
+const Caffe2Annotation* getCaffe2Annotation(NodeRef node) {
+  auto annotation =
+      repr::nn::get<repr::NeuralNetOperator>(node)->getAnnotation();
+  if (!annotation || !isa<Caffe2Annotation>(annotation)) {
+    return nullptr;
+  }
+  return dyn_cast<Caffe2Annotation>(annotation);
+}
+
+const caffe2::OperatorDef* getOperatorDef(NodeRef node) {
+  if (!repr::nn::is<repr::NeuralNetOperator>(node)) {
+    return nullptr;
+  }
+  auto annotation = getCaffe2Annotation(node);
+  return annotation ? &annotation->getOperatorDef() : nullptr;
+}
+
+bool isOperator(NodeRef node, const std::string& type) {
+  auto def = getOperatorDef(node);
+  return def && def->type() == type;
+}
+
+std::string getName(NodeRef tensor) {
+  return repr::nn::get<repr::NeuralNetData>(tensor)->getName();
+}
+
+std::unordered_set<std::string> getWrittenBlobs(repr::NNModule* nn) {
+  std::unordered_set<std::string> written;
+  for (auto node : nn->dataFlow.getMutableNodes()) {
+    if (repr::nn::is<repr::NeuralNetData>(node) &&
+        repr::nn::hasProducer(node)) {
+      written.insert(getName(node));
+    }
+  }
+  return written;
+}
+
+// Float CPU tensor of the workspace that no operator of the net writes, e.g.
+// a weight from the init net, or nullptr
+TensorCPU* getConstant(
+    NodeRef tensor,
+    const std::unordered_set<std::string>& written,
+    caffe2::Workspace* ws) {
+  const auto& name = getName(tensor);
+  if (repr::nn::hasProducer(tensor) || written.count(name) ||
+      !ws->HasBlob(name)) {
+    return nullptr;
+  }
+  auto* blob = ws->GetBlob(name);
+  if (!blob->IsType<TensorCPU>()) {
+    return nullptr;
+  }
+  auto* constant = blob->GetMutable<TensorCPU>();
+  return constant->IsType<float>() ? constant : nullptr;
+}
+
+// Constant that only the operator reads, which can be changed in place
+TensorCPU* getExclusiveConstant(
+    NodeRef tensor,
+    const std::unordered_set<std::string>& written,
+    caffe2::Workspace* ws) {
+  return repr::nn::getConsumers(tensor).size() == 1
+      ? getConstant(tensor, written, ws)
+      : nullptr;
+}
+
+// Adds a zero bias of size M to a Conv without one
+TensorCPU* addBias(
+    repr::NNModule* nn,
+    caffe2::Workspace* ws,
+    NodeRef convNode,
+    int M) {
+  auto name = getName(repr::nn::getOutputs(convNode).front()) + "_bias";
+  const auto written = getWrittenBlobs(nn);
+  while (ws->HasBlob(name) || written.count(name)) {
+    name += "_";
+  }
+  auto* bias = ws->CreateBlob(name)->GetMutable<TensorCPU>();
+  bias->Resize(M);
+  std::fill(
+      bias->mutable_data<float>(), bias->mutable_data<float>() + M, 0.0f);
+  auto biasNode =
+      nn->dataFlow.createNode(util::make_unique<repr::Tensor>(name));
+  nn->dataFlow.createEdge(biasNode, convNode);
+  return bias;
+}
+
+// Whether an operator between first and last, in the same basic block,
+// reads or writes the blob
+bool isBlobUsedBetween(
+    repr::NNModule* nn,
+    NodeRef first,
+    NodeRef last,
+    const std::string& name) {
+  for (auto& bbNode : nn->controlFlow.getMutableNodes()) {
+    auto bb = bbNode->mutableData()->get();
+    if (!bb->hasInstruction(first)) {
+      continue;
+    }
+    const auto& instructions = bb->getInstructions();
+    auto it = std::find(instructions.begin(), instructions.end(), first);
+    for (++it; it != instructions.end() && *it != last; ++it) {
+      for (auto tensor : repr::nn::getInputs(*it)) {
+        if (getName(tensor) == name) {
+          return true;
+        }
+      }
+      for (auto tensor : repr::nn::getOutputs(*it)) {
+        if (getName(tensor) == name) {
+          return true;
+        }
+      }
+    }
+    return it == instructions.end();
+  }
+  return true;
+}
+
+// Makes the producer write the output of its only consumer, which is deleted
+void bypassConsumer(repr::NNModule* nn, NodeRef output, NodeRef consumer) {
+  auto consumerOutput = repr::nn::getOutputs(consumer).front();
+  nn->dataFlow.replaceNode(output, consumerOutput);
+  nn->dataFlow.deleteNode(consumer);
+  nn->dataFlow.deleteNode(output);
+}
+
+// The single output of the operator, if its only consumer is an operator of
+// the type with a single output and the producer can write the output of the
+// consumer instead
+NodeRef getFusibleOutput(
+    repr::NNModule* nn,
+    NodeRef node,
+    const std::string& consumerType,
+    const std::unordered_set<std::string>& outputs) {
+  auto nodeOutputs = repr::nn::getOutputs(node);
+  if (nodeOutputs.size() != 1 || outputs.count(getName(nodeOutputs[0]))) {
+    return nullptr;
+  }
+  auto consumers = repr::nn::getConsumers(nodeOutputs[0]);
+  if (consumers.size() != 1 || !isOperator(consumers[0], consumerType) ||
+      repr::nn::getOutputs(consumers[0]).size() != 1) {
+    return nullptr;
+  }
+  const auto& consumerOutput =
+      getName(repr::nn::getOutputs(consumers[0]).front());
+  for (auto input : repr::nn::getInputs(node)) {
+    // Conv and FC can't run in place
+    if (getName(input) == consumerOutput) {
+      return nullptr;
+    }
+  }
+  if (isBlobUsedBetween(nn, node, consumers[0], consumerOutput)) {
+    return nullptr;
+  }
+  return nodeOutputs[0];
+}
+
+} // namespace
+
 // $$ X_{bn} = \frac{s(X - m)}{\sqrt{\sigma + \epsilon}} + b_{bn}$$
 // $$ X_{conv} = X * W + b_{conv} $$
 // thus, substituting $X$ with $X_{conv}$ in the BN equation we get:
@@ -14,58 +183,69 @@ using namespace nom;
 // or
 // $$ W' = W\frac{s}{\sqrt{\sigma + \epsilon}}$$
 // $$ b' = (b_{conv} - m)\frac{s}{\sqrt{\sigma + \epsilon}} + b_{bn}$$
-bool fuseConvBNHelper(repr::NNModule* nn, caffe2::Workspace* ws) {
+bool fuseConvBNHelper(
+    repr::NNModule* nn,
+    caffe2::Workspace* ws,
+    const std::unordered_set<std::string>& outputs) {
+  const auto written = getWrittenBlobs(nn);
   for (auto node_pair : repr::nn::dataIterator<repr::Conv>(nn->dataFlow)) {
     repr::NNGraph::NodeRef convNode;
     repr::Conv* conv;
     std::tie(conv, convNode) = node_pair;
 
-    auto output = repr::nn::getOutputs(convNode).front();
-    auto consumers = repr::nn::getConsumers(output);
-    if (consumers.size() != 1) {
+    auto output = getFusibleOutput(nn, convNode, "SpatialBN", outputs);
+    if (!output) {
       continue;
     }
-    auto consumer = consumers.front();
-    if (!repr::nn::is<repr::BatchNormalization>(consumer)) {
+    auto bnNode = repr::nn::getConsumers(output).front();
+    auto convDef = getOperatorDef(convNode);
+    auto bnDef = getOperatorDef(bnNode);
+    ArgumentHelper convArgs(*convDef);
+    ArgumentHelper bnArgs(*bnDef);
+    if (!bnArgs.GetSingleArgument<int>("is_test", 0) ||
+        convArgs.GetSingleArgument<std::string>("order", "NCHW") !=
+            bnArgs.GetSingleArgument<std::string>("order", "NCHW")) {
       continue;
     }
-    auto bnNode = consumer;
-    auto bn = repr::nn::get<repr::BatchNormalization>(bnNode);
 
     auto convInputs = repr::nn::getInputs(convNode);
-    if (convInputs.size() < 3) {
-      assert(0 && "Invalid convolution input size (TODO: optional bias)");
+    auto bnInputs = repr::nn::getInputs(bnNode);
+    if (convInputs.size() < 2 || bnInputs.size() != 5) {
       continue;
     }
-
-    auto bnInputs = repr::nn::getInputs(bnNode);
-    if (bnInputs.size() < 5) {
-      assert(0 && "Invalid batch normalization input size");
+    auto filter = getExclusiveConstant(convInputs[1], written, ws);
+    auto biasConv = convInputs.size() > 2
+        ? getExclusiveConstant(convInputs[2], written, ws)
+        : nullptr;
+    auto scale = getConstant(bnInputs[1], written, ws);
+    auto biasBN = getConstant(bnInputs[2], written, ws);
+    auto mean = getConstant(bnInputs[3], written, ws);
+    auto variance = getConstant(bnInputs[4], written, ws);
+    if (!filter || (convInputs.size() > 2 && !biasConv) || !scale ||
+        !biasBN || !mean || !variance) {
       continue;
     }
+    const int M = filter->dim32(0);
+    if ((biasConv && biasConv->size() != M) || scale->size() != M ||
+        biasBN->size() != M || mean->size() != M || variance->size() != M) {
+      continue;
+    }
+    if (!biasConv) {
+      biasConv = addBias(nn, ws, convNode, M);
+    }
 
-#define EXPOSE_TENSOR_DATA(name, index, inputs)                              \
-  auto name = repr::nn::get<repr::Tensor>(inputs[index]);                    \
-  assert(ws->HasBlob(name->getName()) && "Blob not in workspace");           \
-  auto name##Tensor = ws->GetBlob(name->getName())->GetMutable<TensorCPU>(); \
-  auto name##Data = name##Tensor->mutable_data<float>();
-
-    EXPOSE_TENSOR_DATA(filter, 1, convInputs);
-    EXPOSE_TENSOR_DATA(biasConv, 2, convInputs);
-
-    EXPOSE_TENSOR_DATA(scale, 1, bnInputs);
-    EXPOSE_TENSOR_DATA(biasBN, 2, bnInputs);
-    EXPOSE_TENSOR_DATA(mean, 3, bnInputs);
-    EXPOSE_TENSOR_DATA(variance, 4, bnInputs);
-
-#undef EXPOSE_TENSOR_DATA
+    auto filterData = filter->mutable_data<float>();
+    auto biasConvData = biasConv->mutable_data<float>();
+    auto scaleData = scale->data<float>();
+    auto biasBNData = biasBN->data<float>();
+    auto meanData = mean->data<float>();
+    auto varianceData = variance->data<float>();
+    const float epsilon = bnArgs.GetSingleArgument<float>("epsilon", 1e-5f);
 
     // Assume M{CHW,HWC}
-    auto chwDim = filterTensor->dim32(1) * filterTensor->dim32(2) *
-        filterTensor->dim32(3);
-    for (auto c = 0; c < filterTensor->dim32(0); ++c) {
-      float coeff =
-          scaleData[c] / std::sqrt(varianceData[c] + bn->getEpsilon());
+    auto chwDim = filter->size_from_dim(1);
+    for (auto c = 0; c < M; ++c) {
+      float coeff = scaleData[c] / std::sqrt(varianceData[c] + epsilon);
       for (auto i = 0; i < chwDim; ++i) {
         filterData[c * chwDim + i] *= coeff;
       }
@@ -73,18 +253,377 @@ bool fuseConvBNHelper(repr::NNModule* nn, caffe2::Workspace* ws) {
       biasConvData[c] = bias;
     }
 
-    nn->dataFlow.deleteNode(bnNode);
+    bypassConsumer(nn, output, bnNode);
     return true;
   }
   return false;
 }
 
-void fuseConvBN(nom::repr::NNModule* nn, caffe2::Workspace* ws) {
-  while (fuseConvBNHelper(nn, ws)) {
+void fuseConvBN(
+    nom::repr::NNModule* nn,
+    caffe2::Workspace* ws,
+    const std::unordered_set<std::string>& outputs) {
+  while (fuseConvBNHelper(nn, ws, outputs)) {
   }
 }
 
 REGISTER_WS_OPT_PASS_FROM_FUNC(FuseConvBN, fuseConvBN);
 
+namespace {
+
+// Number of dims of the output of a Conv or FC and its channel axis
+void getOutputLayout(const caffe2::OperatorDef& def, int* ndim, int* axis) {
+  ArgumentHelper args(def);
+  if (def.type() == "FC") {
+    *ndim = 2;
+    *axis = 1;
+    return;
+  }
+  *ndim = 2 +
+      (args.HasArgument("kernels")
+           ? args.GetRepeatedArgument<int>("kernels").size()
+           : 2);
+  *axis = args.GetSingleArgument<std::string>("order", "NCHW") == "NCHW"
+      ? 1
+      : *ndim - 1;
+}
+
+bool fuseConvBiasHelper(
+    repr::NNModule* nn,
+    caffe2::Workspace* ws,
+    const std::unordered_set<std::string>& outputs) {
+  const auto written = getWrittenBlobs(nn);
+  for (auto node : nn->dataFlow.getMutableNodes()) {
+    auto def = getOperatorDef(node);
+    if (!def || (def->type() != "Conv" && def->type() != "FC")) {
+      continue;
+    }
+    // FC flattens its input at an axis, only the default one is handled
+    if (def->type() == "FC" &&
+        ArgumentHelper(*def).GetSingleArgument<int>("axis", 1) != 1) {
+      continue;
+    }
+    auto output = getFusibleOutput(nn, node, "Add", outputs);
+    if (!output) {
+      continue;
+    }
+    auto addNode = repr::nn::getConsumers(output).front();
+    auto addInputs = repr::nn::getInputs(addNode);
+    auto inputs = repr::nn::getInputs(node);
+    if (addInputs.size() != 2 || inputs.size() < 2 ||
+        (def->type() == "FC" && inputs.size() != 3)) {
+      continue;
+    }
+    ArgumentHelper addArgs(*getOperatorDef(addNode));
+    const bool legacyBroadcast =
+        addArgs.GetSingleArgument<bool>("broadcast", false);
+    const int outputIndex = addInputs[0] == output ? 0 : 1;
+    // Legacy broadcasting only broadcasts the second operand
+    if (legacyBroadcast && outputIndex != 0) {
+      continue;
+    }
+    auto b = getConstant(addInputs[1 - outputIndex], written, ws);
+    if (!ws->HasBlob(getName(inputs[1])) ||
+        !ws->GetBlob(getName(inputs[1]))->IsType<TensorCPU>()) {
+      continue;
+    }
+    const int M = ws->GetBlob(getName(inputs[1]))->Get<TensorCPU>().dim32(0);
+    if (!b || b->size() != M) {
+      continue;
+    }
+
+    // The bias has to broadcast over the channels of the output
+    int ndim, channelAxis;
+    getOutputLayout(*def, &ndim, &channelAxis);
+    const int channelsFromEnd = ndim - 1 - channelAxis;
+    bool matches;
+    if (legacyBroadcast) {
+      const int axis = addArgs.GetSingleArgument<int>("axis", -1);
+      matches = b->ndim() == 1 &&
+          ((axis == -1 && channelsFromEnd == 0) || axis == channelAxis);
+    } else {
+      // numpy style broadcasting aligns the trailing dims
+      matches = b->ndim() <= ndim && b->ndim() > channelsFromEnd &&
+          b->dim32(b->ndim() - 1 - channelsFromEnd) == M;
+    }
+    if (!matches) {
+      continue;
+    }
+
+    auto bias = inputs.size() > 2
+        ? getExclusiveConstant(inputs[2], written, ws)
+        : addBias(nn, ws, node, M);
+    if (!bias || bias->size() != M) {
+      continue;
+    }
+    auto biasData = bias->mutable_data<float>();
+    auto bData = b->data<float>();
+    for (int c = 0; c < M; ++c) {
+      biasData[c] += bData[c];
+    }
+
+    bypassConsumer(nn, output, addNode);
+    return true;
+  }
+  return false;
+}
+
+} // namespace
+
+void fuseConvBias(
+    repr::NNModule* nn,
+    caffe2::Workspace* ws,
+    const std::unordered_set<std::string>& outputs) {
+  while (fuseConvBiasHelper(nn, ws, outputs)) {
+  }
+}
+
+REGISTER_WS_OPT_PASS_FROM_FUNC(FuseConvBias, fuseConvBias);
+
+void fuseActivationInPlace(
+    repr::NNModule* nn,
+    const std::unordered_set<std::string>& outputs) {
+  // Tensors are replaced, so the operators are found first
+  std::vector<NodeRef> nodes;
+  for (auto node : nn->dataFlow.getMutableNodes()) {
+    auto def = getOperatorDef(node);
+    if (def && (def->type() == "Conv" || def->type() == "FC")) {
+      nodes.push_back(node);
+    }
+  }
+  for (auto node : nodes) {
+    for (const auto& activation : {"Relu", "Sigmoid", "Tanh"}) {
+      auto output = getFusibleOutput(nn, node, activation, outputs);
+      if (!output) {
+        continue;
+      }
+      auto activationNode = repr::nn::getConsumers(output).front();
+      const auto& name =
+          getName(repr::nn::getOutputs(activationNode).front());
+      if (name == getName(output)) {
+        break;
+      }
+      auto inPlaceOutput =
+          nn->dataFlow.createNode(util::make_unique<repr::Tensor>(name));
+      nn->dataFlow.replaceNode(output, inPlaceOutput);
+      nn->dataFlow.deleteNode(output);
+      break;
+    }
+  }
+}
+
+REGISTER_OPT_PASS_FROM_FUNC(FuseActivationInPlace, fuseActivationInPlace);
+
+namespace {
+
+// The CUDA operator is only built with NVRTC
+bool hasFusedElementwise(int deviceType) {
+  auto it = caffe2::gDeviceTypeRegistry()->find(deviceType);
+  return it != caffe2::gDeviceTypeRegistry()->end() &&
+      it->second->Has("FusedElementwise");
+}
+
+// Chain of elementwise operators of a basic block
+struct ElementwiseChain {
+  // positions of the operators in the basic block
+  std::vector<int> ops;
+  std::unordered_set<std::string> reads;
+  std::unordered_set<std::string> writes;
+};
+
+bool intersects(
+    const std::unordered_set<std::string>& a,
+    const std::unordered_set<std::string>& b) {
+  for (const auto& name : a) {
+    if (b.count(name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void fuseElementwiseChain(
+    repr::NNModule* nn,
+    repr::BasicBlockType<repr::NNGraph>* bb,
+    const std::vector<NodeRef>& ops) {
+  std::unordered_set<NodeRef> chainOps(ops.begin(), ops.end());
+
+  // The tensors the chain reads from outside come first in the values of the
+  // program, followed by the results of its steps
+  std::vector<NodeRef> inputs;
+  std::unordered_map<NodeRef, int> values;
+  for (auto op : ops) {
+    for (auto input : repr::nn::getInputs(op)) {
+      if (values.count(input) ||
+          (repr::nn::hasProducer(input) &&
+           chainOps.count(repr::nn::getProducer(input)))) {
+        continue;
+      }
+      values[input] = inputs.size();
+      inputs.push_back(input);
+    }
+  }
+
+  caffe2::OperatorDef def;
+  def.set_type("FusedElementwise");
+  auto firstAnnotation = getCaffe2Annotation(ops.front());
+  def.mutable_device_option()->CopyFrom(
+      firstAnnotation->getOperatorDef().device_option());
+  auto* stepsArg = def.add_arg();
+  stepsArg->set_name("steps");
+  auto* outputsArg = def.add_arg();
+  outputsArg->set_name("outputs");
+
+  std::vector<NodeRef> outputs;
+  std::vector<NodeRef> intermediates;
+  for (auto op : ops) {
+    std::vector<int> operands;
+    for (auto input : repr::nn::getInputs(op)) {
+      operands.push_back(values.at(input));
+    }
+    stepsArg->add_strings(caffe2::FusedElementwiseProgram::GetStep(
+        getCaffe2Annotation(op)->getOperatorDef(), operands));
+    auto output = repr::nn::getOutputs(op).front();
+    const int value = values.size();
+    values[output] = value;
+
+    // Tensors without consumers may be outputs of the net
+    auto consumers = repr::nn::getConsumers(output);
+    bool internal = !consumers.empty();
+    for (auto consumer : consumers) {
+      internal &= chainOps.count(consumer) > 0;
+    }
+    if (internal) {
+      intermediates.push_back(output);
+    } else {
+      outputs.push_back(output);
+      outputsArg->add_ints(value);
+    }
+  }
+
+  auto fusedOp = util::make_unique<repr::GenericOperator>("FusedElementwise");
+  auto annotation = util::make_unique<Caffe2Annotation>();
+  annotation->setOperatorDef(def);
+  annotation->setDevice(firstAnnotation->getDevice());
+  annotation->setDeviceType(firstAnnotation->getDeviceType());
+  fusedOp->setAnnotation(std::move(annotation));
+
+  auto fusedNode = nn->dataFlow.createNode(std::move(fusedOp));
+  for (auto input : inputs) {
+    nn->dataFlow.createEdge(input, fusedNode);
+  }
+  for (auto output : outputs) {
+    nn->dataFlow.createEdge(fusedNode, output);
+  }
+  bb->insertInstructionBefore(fusedNode, ops.back());
+  for (auto op : ops) {
+    nn->dataFlow.deleteNode(op);
+  }
+  for (auto intermediate : intermediates) {
+    nn->dataFlow.deleteNode(intermediate);
+  }
+}
+
+void fuseElementwiseBasicBlock(
+    repr::NNModule* nn,
+    repr::BasicBlockType<repr::NNGraph>* bb) {
+  // Copied, since fusing changes the instructions
+  const auto instructions = bb->getInstructions();
+  std::unordered_map<NodeRef, int> positions;
+  std::vector<std::unordered_set<std::string>> reads(instructions.size());
+  std::vector<std::unordered_set<std::string>> writes(instructions.size());
+  std::vector<int> chainIds(instructions.size(), -1);
+  std::vector<ElementwiseChain> chains;
+
+  for (int i = 0; i < instructions.size(); ++i) {
+    auto node = instructions[i];
+    positions[node] = i;
+    for (auto input : repr::nn::getInputs(node)) {
+      reads[i].insert(repr::nn::get<repr::NeuralNetData>(input)->getName());
+    }
+    for (auto output : repr::nn::getOutputs(node)) {
+      writes[i].insert(repr::nn::get<repr::NeuralNetData>(output)->getName());
+    }
+
+    auto annotation = getCaffe2Annotation(node);
+    if (!annotation || !hasFusedElementwise(annotation->getDeviceType()) ||
+        !caffe2::FusedElementwiseProgram::IsFusible(
+            annotation->getOperatorDef())) {
+      continue;
+    }
+    const auto deviceOption =
+        annotation->getOperatorDef().device_option().SerializeAsString();
+
+    // Joins the chain of a producer of an input that the operators in
+    // between commute with
+    for (auto input : repr::nn::getInputs(node)) {
+      if (!repr::nn::hasProducer(input)) {
+        continue;
+      }
+      auto it = positions.find(repr::nn::getProducer(input));
+      if (it == positions.end() || chainIds[it->second] < 0) {
+        continue;
+      }
+      auto& chain = chains[chainIds[it->second]];
+      auto chainAnnotation = getCaffe2Annotation(instructions[chain.ops[0]]);
+      if (chainAnnotation->getDeviceType() != annotation->getDeviceType() ||
+          chainAnnotation->getOperatorDef()
+                  .device_option()
+                  .SerializeAsString() != deviceOption) {
+        continue;
+      }
+      auto chainReads = chain.reads;
+      chainReads.insert(reads[i].begin(), reads[i].end());
+      auto chainWrites = chain.writes;
+      chainWrites.insert(writes[i].begin(), writes[i].end());
+      bool commutes = true;
+      for (int j = chain.ops[0] + 1; j < i && commutes; ++j) {
+        if (chainIds[j] != chainIds[it->second]) {
+          commutes = !intersects(reads[j], chainWrites) &&
+              !intersects(writes[j], chainReads) &&
+              !intersects(writes[j], chainWrites);
+        }
+      }
+      if (!commutes) {
+        continue;
+      }
+      chain.ops.push_back(i);
+      chain.reads = std::move(chainReads);
+      chain.writes = std::move(chainWrites);
+      chainIds[i] = chainIds[it->second];
+      break;
+    }
+    if (chainIds[i] < 0) {
+      chainIds[i] = chains.size();
+      ElementwiseChain chain;
+      chain.ops.push_back(i);
+      chain.reads = reads[i];
+      chain.writes = writes[i];
+      chains.push_back(std::move(chain));
+    }
+  }
+
+  for (const auto& chain : chains) {
+    if (chain.ops.size() < 2) {
+      continue;
+    }
+    std::vector<NodeRef> ops;
+    for (int position : chain.ops) {
+      ops.push_back(instructions[position]);
+    }
+    fuseElementwiseChain(nn, bb, ops);
+  }
+}
+
+} // namespace
+
+void fuseElementwise(repr::NNModule* nn) {
+  for (auto& bbNode : nn->controlFlow.getMutableNodes()) {
+    fuseElementwiseBasicBlock(nn, bbNode->mutableData()->get());
+  }
+}
+
+REGISTER_OPT_PASS_FROM_FUNC(FuseElementwise, fuseElementwise);
+
 } // namespace opt
 } // namespace caffe2
@@ -20,12 +20,44 @@
 #include "caffe2/core/workspace.h"
 #include "nomnigraph/Representations/NeuralNet.h"
 
+#include <string>
+#include <unordered_set>
+
 namespace caffe2 {
 namespace opt {
 
 using namespace nom;
 
-void fuseConvBN(repr::NNModule* nn, caffe2::Workspace* ws);
+// Folds the SpatialBN operators in test mode that follow Conv operators into
+// the weights of the Conv operators, which are changed in the workspace.
+// Operators whose outputs are in outputs, e.g. the external outputs of the
+// net, are left alone by this pass and the ones below.
+void fuseConvBN(
+    repr::NNModule* nn,
+    caffe2::Workspace* ws,
+    const std::unordered_set<std::string>& outputs = {});
+
+// Folds the Add operators adding a constant bias to the outputs of Conv and
+// FC operators into the biases of the operators.
+void fuseConvBias(
+    repr::NNModule* nn,
+    caffe2::Workspace* ws,
+    const std::unordered_set<std::string>& outputs = {});
+
+// Runs the Relu, Sigmoid and Tanh operators that follow Conv and FC operators
+// in place on their outputs, which saves writing a tensor.
+void fuseActivationInPlace(
+    repr::NNModule* nn,
+    const std::unordered_set<std::string>& outputs = {});
+
+// Replaces the chains of float elementwise operators of every basic block,
+// e.g. Mul -> Add -> Sigmoid -> Mul, with FusedElementwise operators that
+// compute them in a single pass over their inputs. An operator joins the
+// chain of an operator producing one of its inputs on the same device if the
+// operators between them don't touch the blobs of the chain, so that it can
+// run in place of the last one. Tensors only consumed within a chain aren't
+// written anymore.
+void fuseElementwise(repr::NNModule* nn);
 
 // Generic activation fusion helper.
 //
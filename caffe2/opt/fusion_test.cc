@@ -0,0 +1,169 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/opt/converter.h"
+#include "caffe2/opt/fusion.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+void AddOp(
+    caffe2::NetDef* net,
+    const std::string& type,
+    const std::vector<std::string>& inputs,
+    const std::string& output) {
+  caffe2::OperatorDef* def = net->add_op();
+  def->set_type(type);
+  for (const auto& input : inputs) {
+    def->add_input(input);
+  }
+  def->add_output(output);
+}
+
+void FeedTensor(
+    caffe2::Workspace* ws,
+    const std::string& name,
+    const std::vector<caffe2::TIndex>& dims,
+    float offset) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<caffe2::TensorCPU>();
+  tensor->Resize(dims);
+  for (int i = 0; i < tensor->size(); ++i) {
+    tensor->mutable_data<float>()[i] = 0.1f * i - offset;
+  }
+}
+
+// Runs the net and the fused one on the same inputs, and checks that they
+// compute the same outputs
+void CheckFusedNet(
+    const caffe2::NetDef& net,
+    const caffe2::NetDef& fused_net,
+    const std::vector<std::string>& outputs) {
+  caffe2::Workspace ws;
+  caffe2::Workspace fused_ws;
+  for (auto* workspace : {&ws, &fused_ws}) {
+    FeedTensor(workspace, "X", {2, 3}, 0.3f);
+    FeedTensor(workspace, "W", {1}, -1.5f);
+    FeedTensor(workspace, "B", {3}, 0.2f);
+    FeedTensor(workspace, "Z", {2, 3}, 0.1f);
+  }
+  ASSERT_TRUE(ws.RunNetOnce(net));
+  ASSERT_TRUE(fused_ws.RunNetOnce(fused_net));
+  for (const auto& output : outputs) {
+    const auto& Y = ws.GetBlob(output)->Get<caffe2::TensorCPU>();
+    const auto& fused_Y = fused_ws.GetBlob(output)->Get<caffe2::TensorCPU>();
+    ASSERT_EQ(Y.dims(), fused_Y.dims());
+    for (int i = 0; i < Y.size(); ++i) {
+      EXPECT_NEAR(Y.data<float>()[i], fused_Y.data<float>()[i], 1e-5);
+    }
+  }
+}
+
+} // namespace
+
+TEST(FuseElementwiseTest, Chain) {
+  caffe2::NetDef net;
+  AddOp(&net, "Mul", {"X", "W"}, "A");
+  AddOp(&net, "Add", {"A", "B"}, "A");
+  AddOp(&net, "Sigmoid", {"A"}, "S");
+  AddOp(&net, "Mul", {"S", "X"}, "Y");
+  AddOp(&net, "Scale", {"Y"}, "Y");
+  net.mutable_op(4)->add_arg()->set_name("scale");
+  net.mutable_op(4)->mutable_arg(0)->set_f(0.5);
+
+  auto nn = caffe2::convertToNNModule(net);
+  caffe2::opt::fuseElementwise(&nn);
+  auto fused_net = caffe2::convertToCaffe2Proto(nn, net);
+
+  ASSERT_EQ(fused_net.op_size(), 1);
+  const auto& op = fused_net.op(0);
+  EXPECT_EQ(op.type(), "FusedElementwise");
+  EXPECT_EQ(
+      std::vector<std::string>(op.input().begin(), op.input().end()),
+      std::vector<std::string>({"X", "W", "B"}));
+  EXPECT_EQ(
+      std::vector<std::string>(op.output().begin(), op.output().end()),
+      std::vector<std::string>({"Y"}));
+  CheckFusedNet(net, fused_net, {"Y"});
+}
+
+TEST(FuseElementwiseTest, OperatorsInBetween) {
+  caffe2::NetDef net;
+  AddOp(&net, "Mul", {"X", "W"}, "A");
+  // Commutes with the chain
+  AddOp(&net, "Copy", {"Z"}, "Z2");
+  AddOp(&net, "Relu", {"A"}, "R");
+  // Reads a tensor of the chain, which becomes an output of the fused
+  // operator, and starts a new chain
+  AddOp(&net, "Copy", {"R"}, "R2");
+  AddOp(&net, "Tanh", {"R"}, "T");
+  AddOp(&net, "Add", {"T", "R2"}, "Y");
+
+  auto nn = caffe2::convertToNNModule(net);
+  caffe2::opt::fuseElementwise(&nn);
+  auto fused_net = caffe2::convertToCaffe2Proto(nn, net);
+
+  std::vector<std::string> types;
+  for (const auto& op : fused_net.op()) {
+    types.push_back(op.type());
+  }
+  EXPECT_EQ(
+      types,
+      std::vector<std::string>(
+          {"Copy", "FusedElementwise", "Copy", "FusedElementwise"}));
+  EXPECT_EQ(
+      std::vector<std::string>(
+          fused_net.op(1).output().begin(), fused_net.op(1).output().end()),
+      std::vector<std::string>({"R"}));
+  CheckFusedNet(net, fused_net, {"Z2", "R2", "Y"});
+}
+
+TEST(FuseConvBNTest, ConvBNRelu) {
+  caffe2::NetDef net;
+  AddOp(&net, "Conv", {"X", "W"}, "C");
+  auto* kernel = net.mutable_op(0)->add_arg();
+  kernel->set_name("kernel");
+  kernel->set_i(1);
+  AddOp(&net, "SpatialBN", {"C", "scale", "bias", "mean", "var"}, "N");
+  auto* is_test = net.mutable_op(1)->add_arg();
+  is_test->set_name("is_test");
+  is_test->set_i(1);
+  auto* epsilon = net.mutable_op(1)->add_arg();
+  epsilon->set_name("epsilon");
+  epsilon->set_f(0.01);
+  AddOp(&net, "Relu", {"N"}, "Y");
+  net.add_external_output("Y");
+
+  caffe2::Workspace ws;
+  caffe2::Workspace fused_ws;
+  for (auto* workspace : {&ws, &fused_ws}) {
+    FeedTensor(workspace, "X", {1, 2, 2, 2}, 0.3f);
+    FeedTensor(workspace, "W", {3, 2, 1, 1}, 0.4f);
+    FeedTensor(workspace, "scale", {3}, -1.0f);
+    FeedTensor(workspace, "bias", {3}, 0.1f);
+    FeedTensor(workspace, "mean", {3}, 0.2f);
+    FeedTensor(workspace, "var", {3}, -0.5f);
+  }
+
+  auto nn = caffe2::convertToNNModule(net);
+  const std::unordered_set<std::string> outputs({"Y"});
+  caffe2::opt::fuseConvBN(&nn, &fused_ws, outputs);
+  caffe2::opt::fuseActivationInPlace(&nn, outputs);
+  auto fused_net = caffe2::convertToCaffe2Proto(nn, net);
+
+  ASSERT_EQ(fused_net.op_size(), 2);
+  EXPECT_EQ(fused_net.op(0).type(), "Conv");
+  EXPECT_EQ(fused_net.op(0).input_size(), 3);
+  EXPECT_EQ(fused_net.op(0).output(0), "Y");
+  EXPECT_EQ(fused_net.op(1).type(), "Relu");
+  EXPECT_EQ(fused_net.op(1).input(0), "Y");
+  EXPECT_EQ(fused_net.op(1).output(0), "Y");
+
+  ASSERT_TRUE(ws.RunNetOnce(net));
+  ASSERT_TRUE(fused_ws.RunNetOnce(fused_net));
+  const auto& Y = ws.GetBlob("Y")->Get<caffe2::TensorCPU>();
+  const auto& fused_Y = fused_ws.GetBlob("Y")->Get<caffe2::TensorCPU>();
+  ASSERT_EQ(Y.dims(), fused_Y.dims());
+  for (int i = 0; i < Y.size(); ++i) {
+    EXPECT_NEAR(Y.data<float>()[i], fused_Y.data<float>()[i], 1e-4);
+  }
+}
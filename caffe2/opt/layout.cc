@@ -0,0 +1,667 @@
+#include "caffe2/opt/layout.h"
+
+#include "caffe2/core/operator.h"
+#include "caffe2/opt/converter.h"
+#include "caffe2/opt/passes.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+namespace caffe2 {
+namespace opt {
+
+using namespace nom;
+
+namespace {
+
+using NodeRef = repr::NNGraph::NodeRef;
+using EdgeRef = repr::NNGraph::EdgeRef;
+using NNLayout = repr::NeuralNetOperator::NNLayout;
+
+NNLayout getOtherLayout(NNLayout layout) {
+  return layout == NNLayout::NHWC ? NNLayout::NCHW : NNLayout::NHWC;
+}
+
+std::string getName(NodeRef tensor) {
+  return repr::nn::get<repr::NeuralNetData>(tensor)->getName();
+}
+
+Caffe2Annotation* getCaffe2Annotation(NodeRef node) {
+  if (!repr::nn::is<repr::NeuralNetOperator>(node)) {
+    return nullptr;
+  }
+  auto annotation =
+      repr::nn::get<repr::NeuralNetOperator>(node)->getMutableAnnotation();
+  if (!annotation || !isa<Caffe2Annotation>(annotation)) {
+    return nullptr;
+  }
+  return dyn_cast<Caffe2Annotation>(annotation);
+}
+
+const caffe2::OperatorDef* getCPUOperatorDef(NodeRef node) {
+  auto annotation = getCaffe2Annotation(node);
+  if (!annotation || annotation->getDeviceType() != caffe2::CPU) {
+    return nullptr;
+  }
+  return &annotation->getOperatorDef();
+}
+
+NNLayout getLayout(NodeRef node) {
+  auto layout = repr::nn::get<repr::NeuralNetOperator>(node)->getLayout();
+  return layout == NNLayout::NHWC ? NNLayout::NHWC : NNLayout::NCHW;
+}
+
+// Whether the operator is a CPU NCHW2NHWC or NHWC2NCHW with a single output,
+// converting from the layout to the other one
+bool isTranspose(NodeRef node, NNLayout from) {
+  auto def = getCPUOperatorDef(node);
+  if (!def || repr::nn::getOutputs(node).size() != 1) {
+    return false;
+  }
+  return def->type() ==
+      (from == NNLayout::NCHW ? "NCHW2NHWC" : "NHWC2NCHW");
+}
+
+std::vector<int> getKernelShape(const ArgumentHelper& args) {
+  if (args.HasArgument("kernels")) {
+    return args.GetRepeatedArgument<int>("kernels");
+  }
+  if (args.HasArgument("kernel")) {
+    const int kernel = args.GetSingleArgument<int>("kernel", 0);
+    return {kernel, kernel};
+  }
+  if (args.HasArgument("kernel_h") && args.HasArgument("kernel_w")) {
+    return {args.GetSingleArgument<int>("kernel_h", 0),
+            args.GetSingleArgument<int>("kernel_w", 0)};
+  }
+  return {};
+}
+
+bool isConv(const caffe2::OperatorDef& def) {
+  return def.type() == "Conv" || def.type() == "Conv2D";
+}
+
+bool isPool(const caffe2::OperatorDef& def) {
+  return def.type() == "MaxPool" || def.type() == "MaxPool2D" ||
+      def.type() == "AveragePool" || def.type() == "AveragePool2D";
+}
+
+// Whether the operator runs with both orders, on 4D tensors if it has a
+// kernel, as NCHW2NHWC and NHWC2NCHW only handle those
+bool hasLayout(NodeRef node) {
+  auto def = getCPUOperatorDef(node);
+  if (!def || !def->engine().empty()) {
+    return false;
+  }
+  ArgumentHelper args(*def);
+  if (isConv(*def)) {
+    // The NHWC Conv doesn't support groups
+    return getKernelShape(args).size() == 2 &&
+        args.GetSingleArgument<int>("group", 1) == 1;
+  }
+  if (isPool(*def)) {
+    return getKernelShape(args).size() == 2 &&
+        !args.GetSingleArgument<int>("global_pooling", 0);
+  }
+  return def->type() == "SpatialBN";
+}
+
+// Whether the operator computes its output elementwise from inputs of the
+// same shape, so that it runs with any order
+bool isLayoutAgnostic(NodeRef node) {
+  auto def = getCPUOperatorDef(node);
+  if (!def || repr::nn::getOutputs(node).size() != 1) {
+    return false;
+  }
+  const auto& type = def->type();
+  return type == "Relu" || type == "Sigmoid" || type == "Tanh" ||
+      type == "Sum";
+}
+
+bool isFlexible(NodeRef node) {
+  return hasLayout(node) || isLayoutAgnostic(node);
+}
+
+// Whether the input of the operator is a tensor in its order, i.e. the data
+// of the operators with a layout and every input of the other ones
+bool isActivationInput(NodeRef node, int index) {
+  return index == 0 || isLayoutAgnostic(node);
+}
+
+int getInputIndex(NodeRef node, EdgeRef edge) {
+  const auto& inEdges = node->getInEdges();
+  return std::find(inEdges.begin(), inEdges.end(), edge) - inEdges.begin();
+}
+
+bool isPointwise(const ArgumentHelper& args) {
+  if (getKernelShape(args) != std::vector<int>{1, 1}) {
+    return false;
+  }
+  for (const auto name : {"stride", "stride_h", "stride_w"}) {
+    if (args.GetSingleArgument<int>(name, 1) != 1) {
+      return false;
+    }
+  }
+  for (const auto name : {"pad", "pad_t", "pad_l", "pad_b", "pad_r"}) {
+    if (args.GetSingleArgument<int>(name, 0) != 0) {
+      return false;
+    }
+  }
+  for (auto stride : args.GetRepeatedArgument<int>("strides")) {
+    if (stride != 1) {
+      return false;
+    }
+  }
+  for (auto pad : args.GetRepeatedArgument<int>("pads")) {
+    if (pad != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Passes over the tensors that the kernel of the operator needs in the
+// layout besides the ones of the other layout, in the same unit as a
+// transpose: the NCHW pooling doesn't vectorize over the channels, and the
+// NCHW Conv always runs im2col, even for 1x1 kernels
+int getKernelCost(NodeRef node, NNLayout layout) {
+  if (!hasLayout(node) || layout == NNLayout::NHWC) {
+    return 0;
+  }
+  const auto& def = *getCPUOperatorDef(node);
+  if (isPool(def)) {
+    return 1;
+  }
+  return isConv(def) && isPointwise(ArgumentHelper(def)) ? 1 : 0;
+}
+
+// Sets the order of the operator and of its OperatorDef, which the passes
+// running before the conversion to a NetDef read
+void setLayout(NodeRef node, NNLayout layout) {
+  repr::nn::get<repr::NeuralNetOperator>(node)->setLayout(layout);
+  auto def = getCaffe2Annotation(node)->getMutableOperatorDef();
+  const std::string order = layout == NNLayout::NHWC ? "NHWC" : "NCHW";
+  for (auto& arg : *def->mutable_arg()) {
+    if (arg.name() == "order") {
+      arg.set_s(order);
+      return;
+    }
+  }
+  auto arg = def->add_arg();
+  arg->set_name("order");
+  arg->set_s(order);
+}
+
+// Moves the out edge of the tensor to another tensor
+void moveEdge(EdgeRef edge, NodeRef tensor) {
+  edge->tail()->removeOutEdge(edge);
+  edge->setTail(tensor);
+  tensor->addOutEdge(edge);
+}
+
+void moveConsumers(NodeRef from, NodeRef to) {
+  // Copied, since moving the edges changes them
+  const auto outEdges = from->getOutEdges();
+  for (auto edge : outEdges) {
+    moveEdge(edge, to);
+  }
+}
+
+void deleteOperator(repr::NNModule* nn, NodeRef node) {
+  auto nodeOutputs = repr::nn::getOutputs(node);
+  nn->dataFlow.deleteNode(node);
+  for (auto output : nodeOutputs) {
+    nn->dataFlow.deleteNode(output);
+  }
+}
+
+bool isUnused(NodeRef tensor, const std::unordered_set<std::string>& outputs) {
+  return repr::nn::getConsumers(tensor).empty() &&
+      !outputs.count(getName(tensor));
+}
+
+class LayoutOptimizer {
+ public:
+  LayoutOptimizer(
+      repr::NNModule* nn,
+      const std::unordered_set<std::string>& outputs)
+      : nn_(nn), outputs_(outputs) {
+    for (auto node : nn_->dataFlow.getMutableNodes()) {
+      if (repr::nn::is<repr::NeuralNetData>(node)) {
+        const auto& name = getName(node);
+        names_.insert(name);
+        writes_[name] += repr::nn::hasProducer(node);
+      }
+    }
+  }
+
+  // Removes a pair of transposes or changes the order of a region, if it
+  // saves work
+  bool run() {
+    for (auto& bbNode : nn_->controlFlow.getMutableNodes()) {
+      auto bb = bbNode->mutableData()->get();
+      if (cancelTransposes(bb) || switchRegion(bb)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  struct Region {
+    std::unordered_set<NodeRef> ops;
+    // Ops in the order they run
+    std::vector<NodeRef> instructions;
+    NNLayout layout = NNLayout::Undefined;
+  };
+
+  // A tensor read by the region, with the edges to its operators
+  struct Input {
+    NodeRef tensor;
+    std::vector<EdgeRef> edges;
+    bool filter;
+  };
+
+  // Whether the blob of the tensor isn't written after it, so that operators
+  // later than its consumers can read it too
+  bool isReadable(NodeRef tensor) const {
+    auto it = writes_.find(getName(tensor));
+    return it == writes_.end() ||
+        it->second <= (repr::nn::hasProducer(tensor) ? 1 : 0);
+  }
+
+  // Cost of a transpose of the tensor. Transposes of constants, e.g. of the
+  // filters, are folded, while there is no telling for the other inputs.
+  static int getTransposeCost(NodeRef tensor, bool filter) {
+    return !filter || repr::nn::hasProducer(tensor) ? 1 : 0;
+  }
+
+  // The input of the transpose producing the tensor from the layout, if its
+  // consumers can read it instead
+  NodeRef getTransposeInput(NodeRef tensor, NNLayout from) const {
+    if (!repr::nn::hasProducer(tensor)) {
+      return nullptr;
+    }
+    auto producer = repr::nn::getProducer(tensor);
+    if (!isTranspose(producer, from)) {
+      return nullptr;
+    }
+    auto input = repr::nn::getInputs(producer).front();
+    return isReadable(input) ? input : nullptr;
+  }
+
+  std::string getUniqueName(const std::string& prefix) {
+    auto name = prefix;
+    while (names_.count(name)) {
+      name += "_";
+    }
+    names_.insert(name);
+    return name;
+  }
+
+  NodeRef createTensor(const std::string& prefix, NNLayout layout) {
+    const auto suffix = layout == NNLayout::NHWC ? "_nhwc" : "_nchw";
+    return nn_->dataFlow.createNode(
+        util::make_unique<repr::Tensor>(getUniqueName(prefix + suffix)));
+  }
+
+  // Adds a transpose of input from the layout to output before the
+  // instruction, or at the end of the basic block if it's nullptr
+  void insertTranspose(
+      repr::BasicBlockType<repr::NNGraph>* bb,
+      NodeRef input,
+      NodeRef output,
+      NNLayout from,
+      NodeRef instruction,
+      const caffe2::OperatorDef& like) {
+    const std::string type =
+        from == NNLayout::NCHW ? "NCHW2NHWC" : "NHWC2NCHW";
+    caffe2::OperatorDef def;
+    def.set_type(type);
+    def.mutable_device_option()->CopyFrom(like.device_option());
+    auto op = util::make_unique<repr::GenericOperator>(type);
+    auto annotation = util::make_unique<Caffe2Annotation>();
+    annotation->setOperatorDef(def);
+    annotation->setDeviceType(caffe2::CPU);
+    op->setAnnotation(std::move(annotation));
+    auto node = nn_->dataFlow.createNode(std::move(op));
+    nn_->dataFlow.createEdge(input, node);
+    nn_->dataFlow.createEdge(node, output);
+    bb->insertInstructionBefore(node, instruction);
+    ++writes_[getName(output)];
+  }
+
+  // Makes the consumers of the output of a transpose read the input of
+  // another one that it undoes
+  bool cancelTransposes(repr::BasicBlockType<repr::NNGraph>* bb) {
+    for (auto node : bb->getInstructions()) {
+      for (auto from : {NNLayout::NCHW, NNLayout::NHWC}) {
+        if (!isTranspose(node, from)) {
+          continue;
+        }
+        auto input = repr::nn::getInputs(node).front();
+        auto output = repr::nn::getOutputs(node).front();
+        auto source = getTransposeInput(input, getOtherLayout(from));
+        if (!source || outputs_.count(getName(output))) {
+          continue;
+        }
+        moveConsumers(output, source);
+        deleteOperator(nn_, node);
+        if (isUnused(input, outputs_)) {
+          deleteOperator(nn_, repr::nn::getProducer(input));
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<Region> getRegions(repr::BasicBlockType<repr::NNGraph>* bb) {
+    const auto& instructions = bb->getInstructions();
+    std::unordered_map<NodeRef, int> regionIds;
+    std::vector<Region> regions;
+    for (auto node : instructions) {
+      if (!isFlexible(node) || regionIds.count(node)) {
+        continue;
+      }
+      const int id = regions.size();
+      regions.emplace_back();
+      std::vector<NodeRef> stack{node};
+      regionIds[node] = id;
+      while (!stack.empty()) {
+        auto op = stack.back();
+        stack.pop_back();
+        regions[id].ops.insert(op);
+        std::vector<NodeRef> neighbors;
+        const auto& inEdges = op->getInEdges();
+        for (int i = 0; i < inEdges.size(); ++i) {
+          auto input = inEdges[i]->tail();
+          if (isActivationInput(op, i) && repr::nn::hasProducer(input) &&
+              repr::nn::getOutputs(repr::nn::getProducer(input)).front() ==
+                  input) {
+            neighbors.push_back(repr::nn::getProducer(input));
+          }
+        }
+        auto output = repr::nn::getOutputs(op).front();
+        for (auto edge : output->getOutEdges()) {
+          auto consumer = edge->head();
+          if (isActivationInput(consumer, getInputIndex(consumer, edge))) {
+            neighbors.push_back(consumer);
+          }
+        }
+        for (auto neighbor : neighbors) {
+          if (isFlexible(neighbor) && bb->hasInstruction(neighbor) &&
+              !regionIds.count(neighbor)) {
+            regionIds[neighbor] = id;
+            stack.push_back(neighbor);
+          }
+        }
+      }
+    }
+    for (auto node : instructions) {
+      auto it = regionIds.find(node);
+      if (it != regionIds.end()) {
+        regions[it->second].instructions.push_back(node);
+      }
+    }
+    return regions;
+  }
+
+  bool isInternal(const Region& region, EdgeRef edge) const {
+    auto consumer = edge->head();
+    return region.ops.count(consumer) &&
+        isActivationInput(consumer, getInputIndex(consumer, edge));
+  }
+
+  std::vector<Input> getInputs(const Region& region) const {
+    std::vector<Input> inputs;
+    std::unordered_map<NodeRef, int> indices;
+    for (auto op : region.instructions) {
+      const auto& inEdges = op->getInEdges();
+      for (int i = 0; i < inEdges.size(); ++i) {
+        auto tensor = inEdges[i]->tail();
+        const bool filter =
+            i == 1 && isConv(*getCPUOperatorDef(op)) && hasLayout(op);
+        if ((!isActivationInput(op, i) && !filter) ||
+            (repr::nn::hasProducer(tensor) &&
+             region.ops.count(repr::nn::getProducer(tensor)))) {
+          continue;
+        }
+        auto it = indices.find(tensor);
+        if (it == indices.end()) {
+          it = indices.emplace(tensor, inputs.size()).first;
+          inputs.push_back({tensor, {}, filter});
+        }
+        inputs[it->second].edges.push_back(inEdges[i]);
+      }
+    }
+    return inputs;
+  }
+
+  // The order of the region, from its operators or the transposes around it
+  NNLayout getRegionLayout(const Region& region) const {
+    NNLayout layout = NNLayout::Undefined;
+    auto join = [&layout](NNLayout other) {
+      if (layout == NNLayout::Undefined || layout == other) {
+        layout = other;
+        return true;
+      }
+      return false;
+    };
+    for (auto op : region.instructions) {
+      if (hasLayout(op) && !join(getLayout(op))) {
+        return NNLayout::Undefined;
+      }
+    }
+    if (layout != NNLayout::Undefined) {
+      return layout;
+    }
+    for (const auto& input : getInputs(region)) {
+      for (auto from : {NNLayout::NCHW, NNLayout::NHWC}) {
+        if (repr::nn::hasProducer(input.tensor) &&
+            isTranspose(repr::nn::getProducer(input.tensor), from) &&
+            !join(getOtherLayout(from))) {
+          return NNLayout::Undefined;
+        }
+      }
+    }
+    for (auto op : region.instructions) {
+      for (auto consumer :
+           repr::nn::getConsumers(repr::nn::getOutputs(op).front())) {
+        for (auto from : {NNLayout::NCHW, NNLayout::NHWC}) {
+          if (!region.ops.count(consumer) && isTranspose(consumer, from) &&
+              !join(from)) {
+            return NNLayout::Undefined;
+          }
+        }
+      }
+    }
+    return layout;
+  }
+
+  // The transposes consuming the output of the region that convert it to the
+  // layout, which can be removed
+  std::vector<NodeRef> getRemovableTransposes(
+      const Region& region,
+      NodeRef output,
+      NNLayout to) const {
+    std::vector<NodeRef> transposes;
+    for (auto edge : output->getOutEdges()) {
+      auto consumer = edge->head();
+      if (!isInternal(region, edge) &&
+          isTranspose(consumer, getOtherLayout(to)) &&
+          !outputs_.count(getName(repr::nn::getOutputs(consumer).front()))) {
+        transposes.push_back(consumer);
+      }
+    }
+    return transposes;
+  }
+
+  // Whether operators that are not in the region read the output as it is
+  bool hasOtherConsumers(
+      const Region& region,
+      NodeRef output,
+      const std::vector<NodeRef>& transposes) const {
+    if (outputs_.count(getName(output))) {
+      return true;
+    }
+    for (auto edge : output->getOutEdges()) {
+      if (!isInternal(region, edge) &&
+          std::find(transposes.begin(), transposes.end(), edge->head()) ==
+              transposes.end()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool switchRegion(repr::BasicBlockType<repr::NNGraph>* bb) {
+    for (const auto& region : getRegions(bb)) {
+      const auto layout = getRegionLayout(region);
+      if (layout == NNLayout::Undefined) {
+        continue;
+      }
+      const auto other = getOtherLayout(layout);
+      int keepCost = 0;
+      int switchCost = 0;
+      for (auto op : region.instructions) {
+        keepCost += getKernelCost(op, layout);
+        switchCost += getKernelCost(op, other);
+      }
+      for (const auto& input : getInputs(region)) {
+        auto source = getTransposeInput(input.tensor, other);
+        if (!source) {
+          switchCost += getTransposeCost(input.tensor, input.filter);
+        } else if (
+            input.edges.size() == input.tensor->getOutEdges().size() &&
+            !outputs_.count(getName(input.tensor))) {
+          // The transpose is removed
+          keepCost += getTransposeCost(source, input.filter);
+        }
+      }
+      for (auto op : region.instructions) {
+        auto output = repr::nn::getOutputs(op).front();
+        const auto transposes = getRemovableTransposes(region, output, other);
+        keepCost += transposes.size();
+        switchCost += hasOtherConsumers(region, output, transposes);
+      }
+      if (switchCost < keepCost) {
+        switchLayout(bb, region, layout);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void switchLayout(
+      repr::BasicBlockType<repr::NNGraph>* bb,
+      const Region& region,
+      NNLayout layout) {
+    const auto other = getOtherLayout(layout);
+    const auto& instructions = bb->getInstructions();
+    const auto inputs = getInputs(region);
+    for (auto op : region.instructions) {
+      if (hasLayout(op)) {
+        setLayout(op, other);
+      }
+    }
+
+    for (const auto& input : inputs) {
+      auto source = getTransposeInput(input.tensor, other);
+      if (source) {
+        for (auto edge : input.edges) {
+          moveEdge(edge, source);
+        }
+        if (isUnused(input.tensor, outputs_)) {
+          deleteOperator(nn_, repr::nn::getProducer(input.tensor));
+        }
+        continue;
+      }
+      // Before the first consumer in the region
+      auto first = std::find_if(
+          instructions.begin(), instructions.end(), [&input](NodeRef node) {
+            for (auto edge : input.edges) {
+              if (edge->head() == node) {
+                return true;
+              }
+            }
+            return false;
+          });
+      auto transposed = createTensor(getName(input.tensor), other);
+      insertTranspose(
+          bb,
+          input.tensor,
+          transposed,
+          layout,
+          *first,
+          *getCPUOperatorDef(*first));
+      for (auto edge : input.edges) {
+        moveEdge(edge, transposed);
+      }
+    }
+
+    for (auto op : region.instructions) {
+      auto output = repr::nn::getOutputs(op).front();
+      const auto transposes = getRemovableTransposes(region, output, other);
+      const bool otherConsumers = hasOtherConsumers(region, output, transposes);
+      auto tensor = output;
+      if (otherConsumers || (!transposes.empty() && !isReadable(output))) {
+        // The region writes a new blob, so that the transposed one keeps the
+        // name, and so that the consumers of the removed transposes can read
+        // it after the blob of the output is written again
+        tensor = createTensor(getName(output), other);
+        auto producerEdge = output->getInEdges().front();
+        output->removeInEdge(producerEdge);
+        producerEdge->setHead(tensor);
+        tensor->addInEdge(producerEdge);
+        ++writes_[getName(tensor)];
+        const auto outEdges = output->getOutEdges();
+        for (auto edge : outEdges) {
+          if (isInternal(region, edge)) {
+            moveEdge(edge, tensor);
+          }
+        }
+        if (otherConsumers) {
+          auto next = std::find(instructions.begin(), instructions.end(), op);
+          insertTranspose(
+              bb,
+              tensor,
+              output,
+              other,
+              ++next == instructions.end() ? nullptr : *next,
+              *getCPUOperatorDef(op));
+        }
+      }
+      for (auto transpose : transposes) {
+        moveConsumers(repr::nn::getOutputs(transpose).front(), tensor);
+        deleteOperator(nn_, transpose);
+      }
+      if (tensor != output && !otherConsumers) {
+        nn_->dataFlow.deleteNode(output);
+      }
+    }
+  }
+
+  repr::NNModule* nn_;
+  const std::unordered_set<std::string>& outputs_;
+  std::unordered_set<std::string> names_;
+  // Number of operators writing every blob
+  std::unordered_map<std::string, int> writes_;
+};
+
+} // namespace
+
+void optimizeLayout(
+    repr::NNModule* nn,
+    const std::unordered_set<std::string>& outputs) {
+  // Every change saves work, but bounds the number of rounds all the same
+  int rounds = nn->dataFlow.getNodesCount();
+  while (rounds-- > 0 && LayoutOptimizer(nn, outputs).run()) {
+  }
+}
+
+REGISTER_OPT_PASS_FROM_FUNC(OptimizeLayout, optimizeLayout);
+
+} // namespace opt
+} // namespace caffe2
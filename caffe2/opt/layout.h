@@ -0,0 +1,32 @@
+#ifndef CAFFE2_OPT_LAYOUT_H_
+#define CAFFE2_OPT_LAYOUT_H_
+
+#include "nomnigraph/Representations/NeuralNet.h"
+
+#include <string>
+#include <unordered_set>
+
+namespace caffe2 {
+namespace opt {
+
+using namespace nom;
+
+// Chooses the storage order of the regions of CPU operators that support
+// both NCHW and NHWC, i.e. 2D Conv, MaxPool and AveragePool with the default
+// engine and SpatialBN, joined by the elementwise operators that don't
+// depend on it. A region switches order when the kernels of the other one,
+// e.g. the pooling and the 1x1 Conv that vectorize over the channels in
+// NHWC, save more passes over the tensors than the NCHW2NHWC and NHWC2NCHW
+// operators at its boundaries cost. Transposes are only inserted at the
+// boundaries, where the ones converting back are removed, and so are pairs
+// of transposes undoing each other. The filters of the Conv operators are
+// transposed by operators that foldConstants can run once. The blobs of
+// outputs, e.g. the external outputs of the net, keep their order.
+void optimizeLayout(
+    repr::NNModule* nn,
+    const std::unordered_set<std::string>& outputs = {});
+
+} // namespace opt
+} // namespace caffe2
+
+#endif // CAFFE2_OPT_LAYOUT_H_
@@ -0,0 +1,133 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/opt/converter.h"
+#include "caffe2/opt/layout.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace {
+
+caffe2::OperatorDef* AddOp(
+    caffe2::NetDef* net,
+    const std::string& type,
+    const std::vector<std::string>& inputs,
+    const std::string& output) {
+  caffe2::OperatorDef* def = net->add_op();
+  def->set_type(type);
+  for (const auto& input : inputs) {
+    def->add_input(input);
+  }
+  def->add_output(output);
+  return def;
+}
+
+std::vector<std::string> GetTypes(const caffe2::NetDef& net) {
+  std::vector<std::string> types;
+  for (const auto& op : net.op()) {
+    types.push_back(op.type());
+  }
+  return types;
+}
+
+void FillTensor(
+    caffe2::Workspace* ws,
+    const std::string& name,
+    const std::vector<caffe2::TIndex>& dims,
+    std::mt19937* generator) {
+  auto* tensor = ws->CreateBlob(name)->GetMutable<caffe2::TensorCPU>();
+  tensor->Resize(dims);
+  std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+  for (int i = 0; i < tensor->size(); ++i) {
+    tensor->mutable_data<float>()[i] = distribution(*generator);
+  }
+}
+
+caffe2::NetDef Optimize(caffe2::NetDef net) {
+  auto nn = caffe2::convertToNNModule(net);
+  caffe2::opt::optimizeLayout(
+      &nn, {net.external_output().begin(), net.external_output().end()});
+  return caffe2::convertToCaffe2Proto(nn, net);
+}
+
+} // namespace
+
+TEST(OptimizeLayoutTest, SwitchesToNHWC) {
+  caffe2::NetDef net;
+  AddOp(&net, "Conv", {"X", "W1"}, "A")
+      ->add_arg()
+      ->CopyFrom(caffe2::MakeArgument<int>("kernel", 1));
+  AddOp(&net, "Relu", {"A"}, "A");
+  auto* maxPool = AddOp(&net, "MaxPool", {"A"}, "B");
+  maxPool->add_arg()->CopyFrom(caffe2::MakeArgument<int>("kernel", 2));
+  maxPool->add_arg()->CopyFrom(caffe2::MakeArgument<int>("stride", 2));
+  AddOp(&net, "Conv", {"B", "W2"}, "C")
+      ->add_arg()
+      ->CopyFrom(caffe2::MakeArgument<int>("kernel", 1));
+  AddOp(&net, "AveragePool", {"C"}, "Y")
+      ->add_arg()
+      ->CopyFrom(caffe2::MakeArgument<int>("kernel", 3));
+  net.add_external_output("Y");
+
+  auto optimized = Optimize(net);
+  EXPECT_EQ(
+      GetTypes(optimized),
+      std::vector<std::string>({"NCHW2NHWC",
+                                "NCHW2NHWC",
+                                "Conv",
+                                "Relu",
+                                "MaxPool",
+                                "NCHW2NHWC",
+                                "Conv",
+                                "AveragePool",
+                                "NHWC2NCHW"}));
+  EXPECT_EQ(optimized.op(8).output(0), "Y");
+
+  std::mt19937 generator(0);
+  caffe2::Workspace ws;
+  FillTensor(&ws, "X", {2, 4, 6, 6}, &generator);
+  FillTensor(&ws, "W1", {8, 4, 1, 1}, &generator);
+  FillTensor(&ws, "W2", {3, 8, 1, 1}, &generator);
+  ASSERT_TRUE(ws.RunNetOnce(net));
+  caffe2::TensorCPU expected;
+  expected.CopyFrom(ws.GetBlob("Y")->Get<caffe2::TensorCPU>());
+  ASSERT_TRUE(ws.RunNetOnce(optimized));
+  const auto& Y = ws.GetBlob("Y")->Get<caffe2::TensorCPU>();
+  ASSERT_EQ(Y.dims(), expected.dims());
+  for (int i = 0; i < Y.size(); ++i) {
+    EXPECT_NEAR(Y.data<float>()[i], expected.data<float>()[i], 1e-5);
+  }
+}
+
+TEST(OptimizeLayoutTest, KeepsCheaperLayout) {
+  caffe2::NetDef net;
+  AddOp(&net, "Conv", {"X", "W"}, "A")
+      ->add_arg()
+      ->CopyFrom(caffe2::MakeArgument<int>("kernel", 3));
+  AddOp(&net, "Relu", {"A"}, "Y");
+  net.add_external_output("Y");
+
+  auto optimized = Optimize(net);
+  EXPECT_EQ(GetTypes(optimized), std::vector<std::string>({"Conv", "Relu"}));
+}
+
+TEST(OptimizeLayoutTest, RemovesTransposes) {
+  caffe2::NetDef net;
+  AddOp(&net, "NCHW2NHWC", {"X"}, "A");
+  AddOp(&net, "Relu", {"A"}, "B");
+  AddOp(&net, "NHWC2NCHW", {"B"}, "C");
+  AddOp(&net, "Sigmoid", {"C"}, "D");
+  AddOp(&net, "NCHW2NHWC", {"D"}, "E");
+  AddOp(&net, "NHWC2NCHW", {"E"}, "F");
+  AddOp(&net, "Tanh", {"F"}, "Y");
+  net.add_external_output("Y");
+
+  auto optimized = Optimize(net);
+  EXPECT_EQ(
+      GetTypes(optimized),
+      std::vector<std::string>({"Relu", "Sigmoid", "Tanh"}));
+  EXPECT_EQ(optimized.op(0).input(0), "X");
+  EXPECT_EQ(optimized.op(2).input(0), optimized.op(1).output(0));
+}
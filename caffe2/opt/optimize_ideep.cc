@@ -2,8 +2,12 @@
 #include "caffe2/opt/converter.h"
 #include "caffe2/opt/fusion.h"
 
+#include <map>
+#include <set>
+
 #ifdef CAFFE2_USE_IDEEP
 #include "caffe2/ideep/ideep_utils.h"
+#include "caffe2/ideep/operators/operator_fallback_ideep.h"
 #endif
 
 namespace caffe2 {
@@ -19,6 +23,10 @@ void OptimizeForIdeep(
   LOG(WARNING) << "Only support optimizations for IDEEP";
 }
 
+void PlanFallbackReordersForIdeep(caffe2::NetDef* net) {
+  LOG(WARNING) << "Only support optimizations for IDEEP";
+}
+
 #else
 USE_IDEEP_DEF_ALIASES();
 
@@ -381,6 +389,93 @@ void OptimizeForIdeep(
   enforceFusionInplaceForIdeep(nn);
 }
 
+void PlanFallbackReordersForIdeep(caffe2::NetDef* net) {
+  const auto& fallbackTypes = IDEEPFallbackOperatorTypes();
+  auto isIdeep = [](const caffe2::OperatorDef& op) {
+    return op.device_option().device_type() == DeviceType::IDEEP;
+  };
+  auto isFallback = [&](const caffe2::OperatorDef& op) {
+    return isIdeep(op) && fallbackTypes.count(op.type());
+  };
+  // Outputs of the other IDEEP operators may be in a non-public format
+  auto mayReorder = [&](const caffe2::OperatorDef& op) {
+    return isIdeep(op) && !fallbackTypes.count(op.type()) &&
+        op.type() != "CopyCPUToIDEEP" && op.type() != "CopyIDEEPToCPU";
+  };
+
+  // For the blobs written last by an operator that may reorder them: the
+  // index of that operator, and the fallback operators reading them since
+  std::unordered_map<string, int> producers;
+  std::unordered_map<string, std::vector<int>> consumers;
+  // Copies to insert after the operator with this index, blob names
+  std::map<int, std::vector<string>> copies;
+
+  auto plan = [&](const string& blob) {
+    auto it = consumers.find(blob);
+    if (it != consumers.end() && it->second.size() >= 2) {
+      const auto cpuBlob = blob + "_cpu_fallback_input";
+      copies[producers.at(blob)].push_back(blob);
+      for (auto index : it->second) {
+        for (auto& input : *net->mutable_op(index)->mutable_input()) {
+          if (input == blob) {
+            input = cpuBlob;
+          }
+        }
+      }
+    }
+    producers.erase(blob);
+    consumers.erase(blob);
+  };
+
+  for (int i = 0; i < net->op_size(); i++) {
+    const auto& op = net->op(i);
+    if (isFallback(op)) {
+      std::set<string> outputs(op.output().begin(), op.output().end());
+      for (const auto& input : op.input()) {
+        // In-place operators have to keep working on the IDEEP tensor
+        if (producers.count(input) && !outputs.count(input)) {
+          auto& readers = consumers[input];
+          if (readers.empty() || readers.back() != i) {
+            readers.push_back(i);
+          }
+        }
+      }
+    }
+
+    for (const auto& output : op.output()) {
+      plan(output);
+      if (mayReorder(op)) {
+        producers[output] = i;
+      }
+    }
+  }
+  while (!producers.empty()) {
+    const auto blob = producers.begin()->first;
+    plan(blob);
+  }
+
+  if (copies.empty()) {
+    return;
+  }
+
+  google::protobuf::RepeatedPtrField<caffe2::OperatorDef> ops;
+  ops.Swap(net->mutable_op());
+  for (int i = 0; i < ops.size(); i++) {
+    *net->add_op() = ops.Get(i);
+    auto it = copies.find(i);
+    if (it == copies.end()) {
+      continue;
+    }
+    for (const auto& blob : it->second) {
+      auto* copy = net->add_op();
+      copy->set_type("CopyIDEEPToCPU");
+      copy->add_input(blob);
+      copy->add_output(blob + "_cpu_fallback_input");
+      *copy->mutable_device_option() = ops.Get(i).device_option();
+    }
+  }
+}
+
 #endif // CAFFE2_USE_IDEEP
 
 } // namespace opt
@@ -12,5 +12,11 @@ void OptimizeForIdeep(
     nom::repr::NNModule* nn,
     caffe2::Workspace* ws,
     bool training_mode = false);
+
+// Fallback operators reorder their inputs from the IDEEP layouts to the plain
+// layout at every run. When several of them read the same output of an IDEEP
+// operator, this inserts a single CopyIDEEPToCPU after its producer and makes
+// them read the CPU copy instead, so it is reordered once per run.
+void PlanFallbackReordersForIdeep(caffe2::NetDef* net);
 }
 } // namespace caffe2
@@ -1,16 +1,32 @@
 #include "caffe2/opt/optimizer.h"
 
 #include "caffe2/opt/converter.h"
-#include "caffe2/opt/mobile.h"
 #include "caffe2/opt/fusion.h"
+#include "caffe2/opt/layout.h"
+#include "caffe2/opt/mobile.h"
+#include "caffe2/opt/simplify.h"
 
 namespace caffe2 {
 namespace opt {
 
-void workspaceOptimizations(nom::repr::NNModule* nn, Workspace* ws, int level) {
+void workspaceOptimizations(
+    nom::repr::NNModule* nn,
+    Workspace* ws,
+    const std::unordered_set<std::string>& outputs,
+    int level) {
   switch (level) {
+    case 2:
+      // Inference nets on any backend. The transposes of the filters that
+      // the layout optimization adds are folded.
+      opt::optimizeLayout(nn, outputs);
+      opt::foldConstants(nn, ws);
+      opt::eliminateIdentities(nn, outputs);
+      opt::fuseConvBN(nn, ws, outputs);
+      opt::fuseConvBias(nn, ws, outputs);
+      opt::fuseActivationInPlace(nn, outputs);
+      break;
     case 1:
-      opt::fuseConvBN(nn, ws);
+      opt::fuseConvBN(nn, ws, outputs);
     case 0:
     default:
       break;
@@ -19,8 +35,9 @@ void workspaceOptimizations(nom::repr::NNModule* nn, Workspace* ws, int level) {
 
 void graphOptimzations(nom::repr::NNModule* nn, int level) {
   switch (level) {
+    case 2:
     case 1:
-#ifdef USE_NNPACK 
+#ifdef USE_NNPACK
       opt::addNNPACK(nn, false);
       opt::fuseNNPACKConvRelu(nn);
 #endif
@@ -33,7 +50,9 @@ void graphOptimzations(nom::repr::NNModule* nn, int level) {
 NetDef optimize(NetDef net, Workspace* ws, int level) {
   auto nn = convertToNNModule(net);
   graphOptimzations(&nn, level);
-  workspaceOptimizations(&nn, ws, level);
+  const std::unordered_set<std::string> outputs(
+      net.external_output().begin(), net.external_output().end());
+  workspaceOptimizations(&nn, ws, outputs, level);
   return convertToCaffe2Proto(nn, net);
 }
 
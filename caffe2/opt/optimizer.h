@@ -8,6 +8,11 @@
 namespace caffe2 {
 namespace opt {
 
+// Level 1 folds SpatialBN into Conv and picks NNPACK where available. Level 2
+// also prepares inference nets for any backend: it folds the operators over
+// constant blobs of the workspace, removes identity operators and Reshape
+// chains, and folds SpatialBN, bias Add and activations into Conv and FC. The
+// external outputs of the net are kept.
 NetDef optimize(NetDef net, Workspace* ws, int level = 1);
 NetDef optimize(NetDef net, int level = 1);
 
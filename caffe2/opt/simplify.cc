@@ -0,0 +1,244 @@
+#include "caffe2/opt/simplify.h"
+
+#include "caffe2/core/operator.h"
+#include "caffe2/opt/converter.h"
+#include "caffe2/opt/passes.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace caffe2 {
+namespace opt {
+
+using namespace nom;
+
+namespace {
+
+using NodeRef = repr::NNGraph::NodeRef;
+
+const Caffe2Annotation* getCaffe2Annotation(NodeRef node) {
+  if (!repr::nn::is<repr::NeuralNetOperator>(node)) {
+    return nullptr;
+  }
+  auto annotation =
+      repr::nn::get<repr::NeuralNetOperator>(node)->getAnnotation();
+  if (!annotation || !isa<Caffe2Annotation>(annotation)) {
+    return nullptr;
+  }
+  return dyn_cast<Caffe2Annotation>(annotation);
+}
+
+std::string getName(NodeRef tensor) {
+  return repr::nn::get<repr::NeuralNetData>(tensor)->getName();
+}
+
+// Operators in the order they run, so that the inputs of an operator are
+// simplified before it
+std::vector<NodeRef> getOperators(repr::NNModule* nn) {
+  std::vector<NodeRef> operators;
+  for (auto& bbNode : nn->controlFlow.getMutableNodes()) {
+    for (auto node : bbNode->mutableData()->get()->getInstructions()) {
+      if (getCaffe2Annotation(node)) {
+        operators.push_back(node);
+      }
+    }
+  }
+  return operators;
+}
+
+// Number of operators writing every blob
+std::unordered_map<std::string, int> countWrites(repr::NNModule* nn) {
+  std::unordered_map<std::string, int> writes;
+  for (auto node : nn->dataFlow.getMutableNodes()) {
+    if (repr::nn::is<repr::NeuralNetData>(node) &&
+        repr::nn::hasProducer(node)) {
+      ++writes[getName(node)];
+    }
+  }
+  return writes;
+}
+
+bool isUnused(NodeRef tensor, const std::unordered_set<std::string>& outputs) {
+  return repr::nn::getConsumers(tensor).empty() &&
+      !outputs.count(getName(tensor));
+}
+
+// Whether the first output of the operator is a copy of its input, and its
+// other outputs are unused
+bool isIdentity(
+    NodeRef node,
+    const caffe2::OperatorDef& def,
+    const std::unordered_set<std::string>& outputs) {
+  ArgumentHelper args(def);
+  const auto& type = def.type();
+  if (!(type == "Copy" || type == "Alias" || type == "StopGradient" ||
+        type == "Sum" ||
+        (type == "Scale" &&
+         args.GetSingleArgument<float>("scale", 1.0f) == 1.0f) ||
+        (type == "Dropout" && args.GetSingleArgument<int>("is_test", 0)))) {
+    return false;
+  }
+  auto nodeOutputs = repr::nn::getOutputs(node);
+  if (repr::nn::getInputs(node).size() != 1 || nodeOutputs.empty()) {
+    return false;
+  }
+  for (int i = 1; i < nodeOutputs.size(); ++i) {
+    if (!isUnused(nodeOutputs[i], outputs)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Whether the consumers of the output of an operator can read the tensor
+// instead, i.e. no other operator writes the blob of the tensor
+bool canReadInstead(
+    NodeRef tensor,
+    NodeRef node,
+    const std::unordered_map<std::string, int>& writes) {
+  const auto& name = getName(tensor);
+  int allowed = repr::nn::hasProducer(tensor) ? 1 : 0;
+  for (auto output : repr::nn::getOutputs(node)) {
+    allowed += getName(output) == name;
+  }
+  auto it = writes.find(name);
+  return it == writes.end() || it->second <= allowed;
+}
+
+void deleteOperator(repr::NNModule* nn, NodeRef node) {
+  auto nodeOutputs = repr::nn::getOutputs(node);
+  nn->dataFlow.deleteNode(node);
+  for (auto output : nodeOutputs) {
+    nn->dataFlow.deleteNode(output);
+  }
+}
+
+} // namespace
+
+void eliminateIdentities(
+    repr::NNModule* nn,
+    const std::unordered_set<std::string>& outputs) {
+  const auto writes = countWrites(nn);
+  for (auto node : getOperators(nn)) {
+    const auto& def = getCaffe2Annotation(node)->getOperatorDef();
+    if (isIdentity(node, def, outputs)) {
+      auto input = repr::nn::getInputs(node).front();
+      auto output = repr::nn::getOutputs(node).front();
+      if (outputs.count(getName(output)) ||
+          !canReadInstead(input, node, writes)) {
+        continue;
+      }
+      // Moves the consumers of the output to the input
+      nn->dataFlow.replaceNode(output, input);
+      deleteOperator(nn, node);
+      continue;
+    }
+
+    // A Reshape to a fixed shape of the output of another Reshape can reshape
+    // the input of the other one
+    if (def.type() != "Reshape" || repr::nn::getInputs(node).size() != 1) {
+      continue;
+    }
+    const auto shape = ArgumentHelper(def).GetRepeatedArgument<int>("shape");
+    auto nodeOutputs = repr::nn::getOutputs(node);
+    if (std::find(shape.begin(), shape.end(), 0) != shape.end() ||
+        (nodeOutputs.size() > 1 && !isUnused(nodeOutputs[1], outputs))) {
+      continue;
+    }
+    auto reshaped = repr::nn::getInputs(node).front();
+    if (!repr::nn::hasProducer(reshaped)) {
+      continue;
+    }
+    auto producer = repr::nn::getProducer(reshaped);
+    auto producerAnnotation = getCaffe2Annotation(producer);
+    if (!producerAnnotation ||
+        producerAnnotation->getOperatorDef().type() != "Reshape" ||
+        repr::nn::getInputs(producer).size() != 1) {
+      continue;
+    }
+    auto input = repr::nn::getInputs(producer).front();
+    if (!canReadInstead(input, producer, writes)) {
+      continue;
+    }
+    auto edge = nn->dataFlow.getEdge(reshaped, node);
+    reshaped->removeOutEdge(edge);
+    edge->setTail(input);
+    input->addOutEdge(edge);
+
+    bool unused = true;
+    for (auto output : repr::nn::getOutputs(producer)) {
+      unused &= isUnused(output, outputs);
+    }
+    if (unused) {
+      deleteOperator(nn, producer);
+    }
+  }
+}
+
+REGISTER_OPT_PASS_FROM_FUNC(EliminateIdentities, eliminateIdentities);
+
+void foldConstants(repr::NNModule* nn, caffe2::Workspace* ws) {
+  auto writes = countWrites(nn);
+  for (auto node : getOperators(nn)) {
+    auto annotation = getCaffe2Annotation(node);
+    auto def = annotation->getOperatorDef();
+    const auto& type = def.type();
+    // Fill operators make random or shaped tensors from their inputs, which
+    // are better left to the init net
+    if (annotation->getDeviceType() != caffe2::CPU ||
+        (type.size() >= 4 && type.compare(type.size() - 4, 4, "Fill") == 0) ||
+        !OpSchemaRegistry::Schema(type)) {
+      continue;
+    }
+    auto inputs = repr::nn::getInputs(node);
+    auto nodeOutputs = repr::nn::getOutputs(node);
+    bool constant = !inputs.empty();
+    for (auto input : inputs) {
+      const auto& name = getName(input);
+      constant &= !repr::nn::hasProducer(input) && !writes.count(name) &&
+          ws->HasBlob(name) && ws->GetBlob(name)->IsType<TensorCPU>();
+    }
+    // The outputs must be new blobs that nothing else writes
+    for (auto output : nodeOutputs) {
+      const auto& name = getName(output);
+      auto it = writes.find(name);
+      constant &= it != writes.end() && it->second == 1 && !ws->HasBlob(name);
+    }
+    if (!constant) {
+      continue;
+    }
+
+    def.clear_input();
+    def.clear_output();
+    for (auto input : inputs) {
+      def.add_input(getName(input));
+    }
+    for (auto output : nodeOutputs) {
+      def.add_output(getName(output));
+    }
+    bool folded = false;
+    try {
+      auto op = CreateOperator(def, ws);
+      folded = op->Run();
+    } catch (const std::exception& e) {
+      VLOG(1) << "Failed to fold " << type << ": " << e.what();
+    }
+    if (!folded) {
+      for (auto output : nodeOutputs) {
+        ws->RemoveBlob(getName(output));
+      }
+      continue;
+    }
+
+    // The outputs are constants now
+    for (auto output : nodeOutputs) {
+      writes.erase(getName(output));
+    }
+    nn->dataFlow.deleteNode(node);
+  }
+}
+
+REGISTER_WS_OPT_PASS_FROM_FUNC(FoldConstants, foldConstants);
+
+} // namespace opt
+} // namespace caffe2
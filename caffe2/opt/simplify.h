@@ -0,0 +1,34 @@
+#ifndef CAFFE2_OPT_SIMPLIFY_H_
+#define CAFFE2_OPT_SIMPLIFY_H_
+
+#include "caffe2/core/workspace.h"
+#include "nomnigraph/Representations/NeuralNet.h"
+
+#include <string>
+#include <unordered_set>
+
+namespace caffe2 {
+namespace opt {
+
+using namespace nom;
+
+// Removes the operators that copy their input, i.e. Copy, Alias,
+// StopGradient, single input Sum, Scale by 1 and Dropout in test mode, and
+// merges chains of Reshape operators, making the consumers of their outputs
+// read their inputs. Operators whose outputs are in outputs, e.g. the
+// external outputs of the net, are kept, and so are the ones whose input is
+// overwritten later.
+void eliminateIdentities(
+    repr::NNModule* nn,
+    const std::unordered_set<std::string>& outputs = {});
+
+// Runs the CPU operators that only read constants, i.e. blobs of the
+// workspace that the net doesn't write such as the weights from the init
+// net, once and removes them from the net. Their outputs are stored in the
+// workspace, and other operators can be folded over them in turn.
+void foldConstants(repr::NNModule* nn, caffe2::Workspace* ws);
+
+} // namespace opt
+} // namespace caffe2
+
+#endif // CAFFE2_OPT_SIMPLIFY_H_
@@ -0,0 +1,120 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/opt/converter.h"
+#include "caffe2/opt/simplify.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+void AddOp(
+    caffe2::NetDef* net,
+    const std::string& type,
+    const std::vector<std::string>& inputs,
+    const std::string& output) {
+  caffe2::OperatorDef* def = net->add_op();
+  def->set_type(type);
+  for (const auto& input : inputs) {
+    def->add_input(input);
+  }
+  def->add_output(output);
+}
+
+std::vector<std::string> GetTypes(const caffe2::NetDef& net) {
+  std::vector<std::string> types;
+  for (const auto& op : net.op()) {
+    types.push_back(op.type());
+  }
+  return types;
+}
+
+} // namespace
+
+TEST(EliminateIdentitiesTest, Copies) {
+  caffe2::NetDef net;
+  AddOp(&net, "Copy", {"X"}, "A");
+  AddOp(&net, "StopGradient", {"A"}, "B");
+  AddOp(&net, "Relu", {"B"}, "C");
+  // An external output
+  AddOp(&net, "Copy", {"C"}, "Y");
+
+  auto nn = caffe2::convertToNNModule(net);
+  caffe2::opt::eliminateIdentities(&nn, {"Y"});
+  auto optimized = caffe2::convertToCaffe2Proto(nn, net);
+
+  EXPECT_EQ(GetTypes(optimized), std::vector<std::string>({"Relu", "Copy"}));
+  EXPECT_EQ(optimized.op(0).input(0), "X");
+}
+
+TEST(EliminateIdentitiesTest, OverwrittenInput) {
+  caffe2::NetDef net;
+  AddOp(&net, "Copy", {"X"}, "A");
+  AddOp(&net, "Relu", {"X"}, "X");
+  AddOp(&net, "Sigmoid", {"A"}, "Y");
+
+  auto nn = caffe2::convertToNNModule(net);
+  caffe2::opt::eliminateIdentities(&nn, {"Y"});
+  auto optimized = caffe2::convertToCaffe2Proto(nn, net);
+
+  EXPECT_EQ(
+      GetTypes(optimized),
+      std::vector<std::string>({"Copy", "Relu", "Sigmoid"}));
+}
+
+TEST(EliminateIdentitiesTest, ReshapeChain) {
+  caffe2::NetDef net;
+  AddOp(&net, "Reshape", {"X"}, "A");
+  AddOp(&net, "Reshape", {"A"}, "Y");
+  for (int i = 0; i < 2; ++i) {
+    auto* arg = net.mutable_op(i)->add_arg();
+    arg->set_name("shape");
+    arg->add_ints(i == 0 ? 6 : 3);
+    if (i == 1) {
+      arg->add_ints(2);
+    }
+  }
+
+  caffe2::Workspace ws;
+  auto* X = ws.CreateBlob("X")->GetMutable<caffe2::TensorCPU>();
+  X->Resize(2, 3);
+  X->mutable_data<float>();
+
+  auto nn = caffe2::convertToNNModule(net);
+  caffe2::opt::eliminateIdentities(&nn, {"Y"});
+  auto optimized = caffe2::convertToCaffe2Proto(nn, net);
+
+  ASSERT_EQ(optimized.op_size(), 1);
+  EXPECT_EQ(optimized.op(0).input(0), "X");
+  EXPECT_EQ(optimized.op(0).output(0), "Y");
+  ASSERT_TRUE(ws.RunNetOnce(optimized));
+  EXPECT_EQ(
+      ws.GetBlob("Y")->Get<caffe2::TensorCPU>().dims(),
+      std::vector<caffe2::TIndex>({3, 2}));
+}
+
+TEST(FoldConstantsTest, InitBlobs) {
+  caffe2::NetDef net;
+  AddOp(&net, "Scale", {"W"}, "W2");
+  net.mutable_op(0)->add_arg()->set_name("scale");
+  net.mutable_op(0)->mutable_arg(0)->set_f(2.0);
+  AddOp(&net, "Mul", {"X", "W2"}, "Y");
+
+  caffe2::Workspace ws;
+  auto* W = ws.CreateBlob("W")->GetMutable<caffe2::TensorCPU>();
+  W->Resize(3);
+  for (int i = 0; i < 3; ++i) {
+    W->mutable_data<float>()[i] = i;
+  }
+
+  auto nn = caffe2::convertToNNModule(net);
+  caffe2::opt::foldConstants(&nn, &ws);
+  auto optimized = caffe2::convertToCaffe2Proto(nn, net);
+
+  EXPECT_EQ(GetTypes(optimized), std::vector<std::string>({"Mul"}));
+  ASSERT_TRUE(ws.HasBlob("W2"));
+  const auto& W2 = ws.GetBlob("W2")->Get<caffe2::TensorCPU>();
+  ASSERT_EQ(W2.size(), 3);
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_FLOAT_EQ(W2.data<float>()[i], 2.0f * i);
+  }
+}
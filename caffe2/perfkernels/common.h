@@ -40,11 +40,16 @@ In foo.cc, do:
 //    the compiler provides. Note that we do not use the compiler flags but
 //    rely on the build system flags, because the common files (like foo.cc
 //    above) will always be built without __AVX__ and __AVX2__.
+//    Likewise, CAFFE2_PERF_WITH_NEON builds the foo__neon implementations
+//    in foo_neon.cc on ARM.
 // During run time:
 //    we use cpuid to identify cpu support and run the proper functions.
 
 #pragma once
 
+// The build system flags below are defined in macros.h.
+#include "caffe2/core/macros.h"
+
 // DO macros: these should be used in your entry function, similar to foo()
 // above, that routes implementations based on CPU capability.
 
@@ -81,3 +86,13 @@ In foo.cc, do:
 #define AVX_DO(funcname, ...)
 #define AVX_F16C_DO(funcname, ...)
 #endif // CAFFE2_PERF_WITH_AVX
+
+#ifdef CAFFE2_PERF_WITH_NEON
+#define NEON_DO(funcname, ...)                 \
+  decltype(funcname##__base) funcname##__neon; \
+  if (GetCpuId().neon()) {                     \
+    return funcname##__neon(__VA_ARGS__);      \
+  }
+#else // CAFFE2_PERF_WITH_NEON
+#define NEON_DO(funcname, ...)
+#endif // CAFFE2_PERF_WITH_NEON
@@ -0,0 +1,94 @@
+#include "caffe2/perfkernels/direct_conv.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void DirectConvRow__base(
+    int output_w,
+    const float* input,
+    int C,
+    int channel_stride,
+    int row_stride,
+    const float* block,
+    int kernel_h,
+    int kernel_w,
+    int dilation_h,
+    int dilation_w,
+    int stride_w,
+    int block_m,
+    float* Y,
+    int Y_stride) {
+  for (int ow = 0; ow < output_w; ++ow) {
+    float acc[kDirectConvBlockM] = {};
+    for (int c = 0; c < C; ++c) {
+      for (int kh = 0; kh < kernel_h; ++kh) {
+        const float* x = input + c * channel_stride +
+            kh * dilation_h * row_stride + ow * stride_w;
+        const float* w = block + (c * kernel_h + kh) * kernel_w *
+            kDirectConvBlockM;
+        for (int kw = 0; kw < kernel_w; ++kw) {
+          const float value = x[kw * dilation_w];
+          for (int j = 0; j < kDirectConvBlockM; ++j) {
+            acc[j] += value * w[kw * kDirectConvBlockM + j];
+          }
+        }
+      }
+    }
+    for (int j = 0; j < block_m; ++j) {
+      Y[j * Y_stride + ow] = acc[j];
+    }
+  }
+}
+
+void DirectConvRow(
+    int output_w,
+    const float* input,
+    int C,
+    int channel_stride,
+    int row_stride,
+    const float* block,
+    int kernel_h,
+    int kernel_w,
+    int dilation_h,
+    int dilation_w,
+    int stride_w,
+    int block_m,
+    float* Y,
+    int Y_stride) {
+  AVX2_FMA_DO(
+      DirectConvRow,
+      output_w,
+      input,
+      C,
+      channel_stride,
+      row_stride,
+      block,
+      kernel_h,
+      kernel_w,
+      dilation_h,
+      dilation_w,
+      stride_w,
+      block_m,
+      Y,
+      Y_stride);
+  BASE_DO(
+      DirectConvRow,
+      output_w,
+      input,
+      C,
+      channel_stride,
+      row_stride,
+      block,
+      kernel_h,
+      kernel_w,
+      dilation_h,
+      dilation_w,
+      stride_w,
+      block_m,
+      Y,
+      Y_stride);
+}
+
+} // namespace caffe2
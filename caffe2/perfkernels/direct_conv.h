@@ -0,0 +1,33 @@
+#pragma once
+
+namespace caffe2 {
+
+// Output channels computed together by DirectConvRow, i.e. the lanes of its
+// accumulators. The filters are packed in blocks of kDirectConvBlockM output
+// channels laid out as C x kernel_h x kernel_w x kDirectConvBlockM.
+constexpr int kDirectConvBlockM = 8;
+
+/**
+ * Computes a row of width output_w of a direct convolution for a block of
+ * output channels, of which the first block_m are written to Y with a stride
+ * of Y_stride between channels. The input is the zero padded image from the
+ * first row read by the output row, with strides of channel_stride between
+ * channels and row_stride between rows, so that no bounds are checked.
+ */
+void DirectConvRow(
+    int output_w,
+    const float* input,
+    int C,
+    int channel_stride,
+    int row_stride,
+    const float* block,
+    int kernel_h,
+    int kernel_w,
+    int dilation_h,
+    int dilation_w,
+    int stride_w,
+    int block_m,
+    float* Y,
+    int Y_stride);
+
+} // namespace caffe2
@@ -0,0 +1,118 @@
+#include "caffe2/perfkernels/direct_conv.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+namespace {
+
+// Output pixels of the row computed together, which share the loads of the
+// filters: with a register per pixel, the accumulators take 8 of the 16
+// registers
+constexpr int kDirectConvTileW = 8;
+
+// Accumulates Tile output pixels for the block of output channels: the input
+// value of every pixel is broadcast and multiplied with the filters of the
+// block
+template <int Tile>
+void DirectConvTile(
+    const float* input,
+    int C,
+    int channel_stride,
+    int row_stride,
+    const float* block,
+    int kernel_h,
+    int kernel_w,
+    int dilation_h,
+    int dilation_w,
+    int stride_w,
+    __m256* out) {
+  // The accumulators are local so that they stay in registers
+  __m256 acc[Tile];
+  for (int p = 0; p < Tile; ++p) {
+    acc[p] = _mm256_setzero_ps();
+  }
+  for (int c = 0; c < C; ++c) {
+    for (int kh = 0; kh < kernel_h; ++kh) {
+      const float* x =
+          input + c * channel_stride + kh * dilation_h * row_stride;
+      const float* w =
+          block + (c * kernel_h + kh) * kernel_w * kDirectConvBlockM;
+      for (int kw = 0; kw < kernel_w; ++kw) {
+        const __m256 w_v = _mm256_loadu_ps(w + kw * kDirectConvBlockM);
+        const float* x_kw = x + kw * dilation_w;
+        for (int p = 0; p < Tile; ++p) {
+          acc[p] = _mm256_fmadd_ps(
+              _mm256_broadcast_ss(x_kw + p * stride_w), w_v, acc[p]);
+        }
+      }
+    }
+  }
+  for (int p = 0; p < Tile; ++p) {
+    out[p] = acc[p];
+  }
+}
+
+} // namespace
+
+void DirectConvRow__avx2_fma(
+    int output_w,
+    const float* input,
+    int C,
+    int channel_stride,
+    int row_stride,
+    const float* block,
+    int kernel_h,
+    int kernel_w,
+    int dilation_h,
+    int dilation_w,
+    int stride_w,
+    int block_m,
+    float* Y,
+    int Y_stride) {
+  __m256 acc[kDirectConvTileW];
+  alignas(32) float values[kDirectConvTileW][kDirectConvBlockM];
+  int ow = 0;
+  while (ow < output_w) {
+    // Whole tiles, then a half tile and single pixels at the end of the row
+    const int remaining = output_w - ow;
+    const int tile = remaining >= kDirectConvTileW
+        ? kDirectConvTileW
+        : (remaining >= kDirectConvTileW / 2 ? kDirectConvTileW / 2 : 1);
+    const float* x = input + ow * stride_w;
+#define DIRECT_CONV_TILE(Tile)                                           \
+  DirectConvTile<Tile>(                                                  \
+      x,                                                                 \
+      C,                                                                 \
+      channel_stride,                                                    \
+      row_stride,                                                        \
+      block,                                                             \
+      kernel_h,                                                          \
+      kernel_w,                                                          \
+      dilation_h,                                                        \
+      dilation_w,                                                        \
+      stride_w,                                                          \
+      acc)
+    if (tile == kDirectConvTileW) {
+      DIRECT_CONV_TILE(kDirectConvTileW);
+    } else if (tile == kDirectConvTileW / 2) {
+      DIRECT_CONV_TILE(kDirectConvTileW / 2);
+    } else {
+      DIRECT_CONV_TILE(1);
+    }
+#undef DIRECT_CONV_TILE
+    // Transposes the pixels by channels tile to the rows of the channels
+    for (int p = 0; p < tile; ++p) {
+      _mm256_store_ps(values[p], acc[p]);
+    }
+    for (int j = 0; j < block_m; ++j) {
+      float* y = Y + j * Y_stride + ow;
+      for (int p = 0; p < tile; ++p) {
+        y[p] = values[p][j];
+      }
+    }
+    ow += tile;
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,56 @@
+#include "caffe2/perfkernels/elementwise_binary.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+#define ELEMENTWISE_BINARY_BASE(Func, op)                             \
+  void ElementwiseBinary##Func##__base(                               \
+      int N,                                                          \
+      const float* A,                                                 \
+      int A_stride,                                                   \
+      const float* B,                                                 \
+      int B_stride,                                                   \
+      float* C) {                                                     \
+    if (A_stride && B_stride) {                                       \
+      for (int i = 0; i < N; ++i) {                                   \
+        C[i] = A[i] op B[i];                                          \
+      }                                                               \
+    } else if (A_stride) {                                            \
+      const float b = B[0];                                           \
+      for (int i = 0; i < N; ++i) {                                   \
+        C[i] = A[i] op b;                                             \
+      }                                                               \
+    } else if (B_stride) {                                            \
+      const float a = A[0];                                           \
+      for (int i = 0; i < N; ++i) {                                   \
+        C[i] = a op B[i];                                             \
+      }                                                               \
+    } else {                                                          \
+      const float c = A[0] op B[0];                                   \
+      for (int i = 0; i < N; ++i) {                                   \
+        C[i] = c;                                                     \
+      }                                                               \
+    }                                                                 \
+  }                                                                   \
+  void ElementwiseBinary##Func(                                       \
+      int N,                                                          \
+      const float* A,                                                 \
+      int A_stride,                                                   \
+      const float* B,                                                 \
+      int B_stride,                                                   \
+      float* C) {                                                     \
+    AVX2_DO(ElementwiseBinary##Func, N, A, A_stride, B, B_stride, C); \
+    NEON_DO(ElementwiseBinary##Func, N, A, A_stride, B, B_stride, C); \
+    BASE_DO(ElementwiseBinary##Func, N, A, A_stride, B, B_stride, C); \
+  }
+
+ELEMENTWISE_BINARY_BASE(Add, +)
+ELEMENTWISE_BINARY_BASE(Sub, -)
+ELEMENTWISE_BINARY_BASE(Mul, *)
+ELEMENTWISE_BINARY_BASE(Div, /)
+
+#undef ELEMENTWISE_BINARY_BASE
+
+} // namespace caffe2
@@ -0,0 +1,39 @@
+#pragma once
+
+namespace caffe2 {
+
+/**
+ * Binary elementwise kernels of the broadcast math functions: computes
+ * C[i] = A[i * A_stride] op B[i * B_stride] for i in [0, N), where each
+ * stride is either 1, or 0 for an operand broadcast along the run.
+ */
+void ElementwiseBinaryAdd(
+    int N,
+    const float* A,
+    int A_stride,
+    const float* B,
+    int B_stride,
+    float* C);
+void ElementwiseBinarySub(
+    int N,
+    const float* A,
+    int A_stride,
+    const float* B,
+    int B_stride,
+    float* C);
+void ElementwiseBinaryMul(
+    int N,
+    const float* A,
+    int A_stride,
+    const float* B,
+    int B_stride,
+    float* C);
+void ElementwiseBinaryDiv(
+    int N,
+    const float* A,
+    int A_stride,
+    const float* B,
+    int B_stride,
+    float* C);
+
+} // namespace caffe2
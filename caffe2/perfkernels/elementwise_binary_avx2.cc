@@ -0,0 +1,60 @@
+#include "caffe2/perfkernels/elementwise_binary.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+#define ELEMENTWISE_BINARY_AVX2(Func, op, mm256_op)                    \
+  void ElementwiseBinary##Func##__avx2(                                \
+      int N,                                                           \
+      const float* A,                                                  \
+      int A_stride,                                                    \
+      const float* B,                                                  \
+      int B_stride,                                                    \
+      float* C) {                                                      \
+    int i = 0;                                                         \
+    if (A_stride && B_stride) {                                        \
+      for (; i + 8 <= N; i += 8) {                                     \
+        _mm256_storeu_ps(                                              \
+            C + i,                                                     \
+            mm256_op(_mm256_loadu_ps(A + i), _mm256_loadu_ps(B + i))); \
+      }                                                                \
+      for (; i < N; ++i) {                                             \
+        C[i] = A[i] op B[i];                                           \
+      }                                                                \
+    } else if (A_stride) {                                             \
+      const __m256 b = _mm256_set1_ps(B[0]);                           \
+      for (; i + 8 <= N; i += 8) {                                     \
+        _mm256_storeu_ps(C + i, mm256_op(_mm256_loadu_ps(A + i), b));  \
+      }                                                                \
+      for (; i < N; ++i) {                                             \
+        C[i] = A[i] op B[0];                                           \
+      }                                                                \
+    } else if (B_stride) {                                             \
+      const __m256 a = _mm256_set1_ps(A[0]);                           \
+      for (; i + 8 <= N; i += 8) {                                     \
+        _mm256_storeu_ps(C + i, mm256_op(a, _mm256_loadu_ps(B + i)));  \
+      }                                                                \
+      for (; i < N; ++i) {                                             \
+        C[i] = A[0] op B[i];                                           \
+      }                                                                \
+    } else {                                                           \
+      const float c_value = A[0] op B[0];                              \
+      const __m256 c = _mm256_set1_ps(c_value);                        \
+      for (; i + 8 <= N; i += 8) {                                     \
+        _mm256_storeu_ps(C + i, c);                                    \
+      }                                                                \
+      for (; i < N; ++i) {                                             \
+        C[i] = c_value;                                                \
+      }                                                                \
+    }                                                                  \
+  }
+
+ELEMENTWISE_BINARY_AVX2(Add, +, _mm256_add_ps)
+ELEMENTWISE_BINARY_AVX2(Sub, -, _mm256_sub_ps)
+ELEMENTWISE_BINARY_AVX2(Mul, *, _mm256_mul_ps)
+ELEMENTWISE_BINARY_AVX2(Div, /, _mm256_div_ps)
+
+#undef ELEMENTWISE_BINARY_AVX2
+
+} // namespace caffe2
@@ -0,0 +1,85 @@
+#include "caffe2/perfkernels/elementwise_binary.h"
+
+#include <arm_neon.h>
+
+namespace caffe2 {
+
+namespace {
+
+#if defined(__aarch64__)
+inline float32x4_t vdivq_f32_compat(float32x4_t a, float32x4_t b) {
+  return vdivq_f32(a, b);
+}
+#else
+// 32-bit NEON has no division, and its reciprocal estimate isn't exact, so
+// the lanes are divided by VFP
+inline float32x4_t vdivq_f32_compat(float32x4_t a, float32x4_t b) {
+  float c[4], d[4];
+  vst1q_f32(c, a);
+  vst1q_f32(d, b);
+  for (int i = 0; i < 4; ++i) {
+    c[i] /= d[i];
+  }
+  return vld1q_f32(c);
+}
+#endif
+
+} // namespace
+
+#define ELEMENTWISE_BINARY_NEON(Func, op, neon_op)                       \
+  void ElementwiseBinary##Func##__neon(                                  \
+      int N,                                                             \
+      const float* A,                                                    \
+      int A_stride,                                                      \
+      const float* B,                                                    \
+      int B_stride,                                                      \
+      float* C) {                                                        \
+    int i = 0;                                                           \
+    if (A_stride && B_stride) {                                          \
+      for (; i + 8 <= N; i += 8) {                                       \
+        vst1q_f32(C + i, neon_op(vld1q_f32(A + i), vld1q_f32(B + i)));   \
+        vst1q_f32(                                                       \
+            C + i + 4,                                                   \
+            neon_op(vld1q_f32(A + i + 4), vld1q_f32(B + i + 4)));        \
+      }                                                                  \
+      for (; i < N; ++i) {                                               \
+        C[i] = A[i] op B[i];                                             \
+      }                                                                  \
+    } else if (A_stride) {                                               \
+      const float32x4_t b = vdupq_n_f32(B[0]);                           \
+      for (; i + 8 <= N; i += 8) {                                       \
+        vst1q_f32(C + i, neon_op(vld1q_f32(A + i), b));                  \
+        vst1q_f32(C + i + 4, neon_op(vld1q_f32(A + i + 4), b));          \
+      }                                                                  \
+      for (; i < N; ++i) {                                               \
+        C[i] = A[i] op B[0];                                             \
+      }                                                                  \
+    } else if (B_stride) {                                               \
+      const float32x4_t a = vdupq_n_f32(A[0]);                           \
+      for (; i + 8 <= N; i += 8) {                                       \
+        vst1q_f32(C + i, neon_op(a, vld1q_f32(B + i)));                  \
+        vst1q_f32(C + i + 4, neon_op(a, vld1q_f32(B + i + 4)));          \
+      }                                                                  \
+      for (; i < N; ++i) {                                               \
+        C[i] = A[0] op B[i];                                             \
+      }                                                                  \
+    } else {                                                             \
+      const float c_value = A[0] op B[0];                                \
+      const float32x4_t c = vdupq_n_f32(c_value);                        \
+      for (; i + 4 <= N; i += 4) {                                       \
+        vst1q_f32(C + i, c);                                             \
+      }                                                                  \
+      for (; i < N; ++i) {                                               \
+        C[i] = c_value;                                                  \
+      }                                                                  \
+    }                                                                    \
+  }
+
+ELEMENTWISE_BINARY_NEON(Add, +, vaddq_f32)
+ELEMENTWISE_BINARY_NEON(Sub, -, vsubq_f32)
+ELEMENTWISE_BINARY_NEON(Mul, *, vmulq_f32)
+ELEMENTWISE_BINARY_NEON(Div, /, vdivq_f32_compat)
+
+#undef ELEMENTWISE_BINARY_NEON
+
+} // namespace caffe2
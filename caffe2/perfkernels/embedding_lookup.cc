@@ -1,12 +1,25 @@
 #include "caffe2/perfkernels/embedding_lookup.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "caffe2/core/flags.h"
 #include "caffe2/core/types.h"
 #include "caffe2/perfkernels/common.h"
+#include "caffe2/perfkernels/embedding_lookup_prefetch.h"
 #include "caffe2/perfkernels/typed_axpy.h"
 #include "caffe2/utils/cpuid.h"
 #include "caffe2/utils/eigen_utils.h"
 #include "caffe2/utils/math.h"
 
+CAFFE2_DEFINE_bool(
+    caffe2_embedding_lookup_sort_indices,
+    false,
+    "If true, EmbeddingLookup sorts the indices of each call and loads every "
+    "distinct row once for all the bags that use it. This pays off on tables "
+    "much larger than the cache with many repeated indices per call.");
+
 namespace caffe2 {
 
 // Base implementation does runtime dispatch for each segment of reduction
@@ -26,7 +39,8 @@ static void EmbeddingLookupGenericSlow(
     const float* weights, // optional, can be null for sum reducer
     const float* scale_bias, // optional scale & bias params for uint8 input
     bool normalize_by_lengths,
-    OutType* out) {
+    OutType* out,
+    const int prefetch_distance) {
   TIndex current = 0;
   for (int m = 0; m < output_size; ++m) {
     memset(out, 0, sizeof(OutType) * block_size);
@@ -44,8 +58,9 @@ static void EmbeddingLookupGenericSlow(
           data_size);
       CAFFE_ENFORCE_LT(idx, data_size);
 #ifdef __GNUC__
-      if (current + 1 < index_size) {
-        __builtin_prefetch(input + block_size * indices[current + 1], 0, 1);
+      if (current + prefetch_distance < index_size) {
+        __builtin_prefetch(
+            input + block_size * indices[current + prefetch_distance], 0, 1);
       }
 #endif // __GNUC__
 
@@ -81,6 +96,105 @@ static void EmbeddingLookupGenericSlow(
       "the size of the indices tensor, but it appears not.");
 }
 
+// Implementation of --caffe2_embedding_lookup_sort_indices: visits the
+// distinct rows of the call in increasing order, and accumulates each of them
+// into all the bags that use it while it is in cache.
+template <
+    typename IndexType,
+    typename InType,
+    typename OutType,
+    bool IS_WEIGHT_POSITIONAL = false>
+static void EmbeddingLookupSortedIndices(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const InType* input,
+    const IndexType* indices,
+    const int* lengths,
+    const float* weights, // optional, can be null for sum reducer
+    const float* scale_bias, // optional scale & bias params for uint8 input
+    bool normalize_by_lengths,
+    OutType* out,
+    const int prefetch_distance) {
+  // the bag of every index, and the first index of every bag
+  std::vector<TIndex> bags(index_size);
+  std::vector<TIndex> bag_starts(output_size);
+  TIndex current = 0;
+  for (TIndex m = 0; m < output_size; ++m) {
+    bag_starts[m] = current;
+    for (int i = 0; i < lengths[m]; ++i) {
+      CAFFE_ENFORCE_LT(current, index_size);
+      bags[current++] = m;
+    }
+  }
+  CAFFE_ENFORCE_EQ(
+      current,
+      index_size,
+      "Your input seems to be incorrect: the sum of lengths values should be "
+      "the size of the indices tensor, but it appears not.");
+
+  std::vector<std::pair<IndexType, TIndex>> sorted_indices(index_size);
+  for (TIndex pos = 0; pos < index_size; ++pos) {
+    TIndex idx = indices[pos];
+    CAFFE_ENFORCE(
+        0 <= idx && idx < data_size,
+        "Index ",
+        pos,
+        " is out of bounds: ",
+        idx,
+        ", range 0 to ",
+        data_size);
+    sorted_indices[pos] = std::make_pair(indices[pos], pos);
+  }
+  std::sort(sorted_indices.begin(), sorted_indices.end());
+
+  memset(out, 0, sizeof(OutType) * output_size * block_size);
+  for (TIndex j = 0; j < index_size; ++j) {
+    const TIndex idx = sorted_indices[j].first;
+    const TIndex pos = sorted_indices[j].second;
+    const TIndex bag = bags[pos];
+#ifdef __GNUC__
+    if (j + prefetch_distance < index_size) {
+      __builtin_prefetch(
+          input + block_size * sorted_indices[j + prefetch_distance].first,
+          0,
+          1);
+    }
+#endif // __GNUC__
+
+    float w = 1.f, b = 0.f;
+    if (weights) {
+      w = weights[IS_WEIGHT_POSITIONAL ? pos - bag_starts[bag] : pos];
+    }
+    if (scale_bias) {
+      b = w * scale_bias[2 * idx + 1];
+      w = w * scale_bias[2 * idx];
+    }
+
+    OutType* out_row = out + block_size * bag;
+    TypedAxpy<InType, OutType>(block_size, w, input + block_size * idx, out_row);
+
+    if (scale_bias) {
+      EigenVectorArrayMap<OutType> out_vector(out_row, block_size);
+      out_vector = out_vector + b;
+    }
+  }
+  if (normalize_by_lengths) {
+    for (TIndex m = 0; m < output_size; ++m) {
+      if (lengths[m]) {
+        // hack: context is not really used
+        math::Scale<OutType, CPUContext>(
+            block_size,
+            1.f / lengths[m],
+            out + block_size * m,
+            out + block_size * m,
+            nullptr);
+      }
+    }
+  }
+}
+
 // Proxy back to generic implementation
 #define EMBEDDING_SPECIALIZATION(                                                          \
     IndexType, InType, OutType, IS_WEIGHT_POSITIONAL)                                      \
@@ -96,7 +210,8 @@ static void EmbeddingLookupGenericSlow(
           const float* weights,                                                            \
           const float* scale_bias,                                                         \
           bool normalize_by_lengths,                                                       \
-          OutType* out) {                                                                  \
+          OutType* out,                                                                    \
+          const int prefetch_distance) {                                                   \
     EmbeddingLookupGenericSlow<                                                            \
         IndexType,                                                                         \
         InType,                                                                            \
@@ -112,7 +227,8 @@ static void EmbeddingLookupGenericSlow(
         weights,                                                                           \
         scale_bias,                                                                        \
         normalize_by_lengths,                                                              \
-        out);                                                                              \
+        out,                                                                               \
+        prefetch_distance);                                                                \
   }                                                                                        \
   template <>                                                                              \
   void EmbeddingLookup<IndexType, InType, OutType, IS_WEIGHT_POSITIONAL>(                  \
@@ -127,6 +243,32 @@ static void EmbeddingLookupGenericSlow(
       const float* scale_bias,                                                             \
       bool normalize_by_lengths,                                                           \
       OutType* out) {                                                                      \
+    /* the sorted mode has its own access pattern, do not tune on it */                    \
+    EmbeddingLookupPrefetch prefetch(                                                      \
+        data_size,                                                                         \
+        block_size * sizeof(InType),                                                       \
+        index_size,                                                                        \
+        !FLAGS_caffe2_embedding_lookup_sort_indices);                                      \
+    if (FLAGS_caffe2_embedding_lookup_sort_indices) {                                      \
+      EmbeddingLookupSortedIndices<                                                        \
+          IndexType,                                                                       \
+          InType,                                                                          \
+          OutType,                                                                         \
+          IS_WEIGHT_POSITIONAL>(                                                           \
+          block_size,                                                                      \
+          output_size,                                                                     \
+          index_size,                                                                      \
+          data_size,                                                                       \
+          input,                                                                           \
+          indices,                                                                         \
+          lengths,                                                                         \
+          weights,                                                                         \
+          scale_bias,                                                                      \
+          normalize_by_lengths,                                                            \
+          out,                                                                             \
+          prefetch.distance());                                                            \
+      return;                                                                              \
+    }                                                                                      \
     AVX2_FMA_DO(                                                                           \
         EmbeddingLookup_##IndexType##_##InType##_##OutType##_##IS_WEIGHT_POSITIONAL,       \
         block_size,                                                                        \
@@ -139,7 +281,8 @@ static void EmbeddingLookupGenericSlow(
         weights,                                                                           \
         scale_bias,                                                                        \
         normalize_by_lengths,                                                              \
-        out);                                                                              \
+        out,                                                                               \
+        prefetch.distance());                                                              \
     BASE_DO(                                                                               \
         EmbeddingLookup_##IndexType##_##InType##_##OutType##_##IS_WEIGHT_POSITIONAL,       \
         block_size,                                                                        \
@@ -152,7 +295,8 @@ static void EmbeddingLookupGenericSlow(
         weights,                                                                           \
         scale_bias,                                                                        \
         normalize_by_lengths,                                                              \
-        out);                                                                              \
+        out,                                                                               \
+        prefetch.distance());                                                              \
   }
 
 EMBEDDING_SPECIALIZATION(int32_t, float, float, false);
@@ -29,6 +29,11 @@ namespace caffe2 {
  *     for (k = 0..block_size-1)
  *       out[i*block_size + k] /= lengths[i]
  *
+ * Rows are prefetched a few indices ahead of their use, with a distance that
+ * is autotuned per table size (see embedding_lookup_prefetch.h). With
+ * --caffe2_embedding_lookup_sort_indices the indices are sorted and each
+ * distinct row is loaded once for all the bags of the call that use it.
+ *
  */
 template <
     typename IndexType,
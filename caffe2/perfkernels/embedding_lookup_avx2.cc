@@ -23,8 +23,8 @@ static void EmbeddingLookup_int32_t_float_float__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
-  const int32_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int32_t fused_block_size = block_size + 0;
   CAFFE_ENFORCE(scale_bias == nullptr, "scale_bias must be nullptr");
   if (block_size == 128) {
@@ -386,7 +386,8 @@ void EmbeddingLookup_int32_t_float_float_false__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int32_t_float_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -398,7 +399,8 @@ void EmbeddingLookup_int32_t_float_float_false__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void EmbeddingLookup_int32_t_float_float_true__avx2_fma(
     const TIndex block_size,
@@ -411,7 +413,8 @@ void EmbeddingLookup_int32_t_float_float_true__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int32_t_float_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -423,7 +426,8 @@ void EmbeddingLookup_int32_t_float_float_true__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 template <bool IS_WEIGHT_POSITIONAL>
@@ -438,8 +442,8 @@ static void EmbeddingLookup_int64_t_float_float__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
-  const int64_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int64_t fused_block_size = block_size + 0;
   CAFFE_ENFORCE(scale_bias == nullptr, "scale_bias must be nullptr");
   if (block_size == 128) {
@@ -801,7 +805,8 @@ void EmbeddingLookup_int64_t_float_float_false__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int64_t_float_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -813,7 +818,8 @@ void EmbeddingLookup_int64_t_float_float_false__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void EmbeddingLookup_int64_t_float_float_true__avx2_fma(
     const TIndex block_size,
@@ -826,7 +832,8 @@ void EmbeddingLookup_int64_t_float_float_true__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int64_t_float_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -838,7 +845,8 @@ void EmbeddingLookup_int64_t_float_float_true__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 template <bool IS_WEIGHT_POSITIONAL>
@@ -853,8 +861,8 @@ static void EmbeddingLookup_int32_t_float16_float__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
-  const int32_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int32_t fused_block_size = block_size + 0;
   CAFFE_ENFORCE(scale_bias == nullptr, "scale_bias must be nullptr");
   if (block_size == 128) {
@@ -1342,7 +1350,8 @@ void EmbeddingLookup_int32_t_float16_float_false__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int32_t_float16_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -1354,7 +1363,8 @@ void EmbeddingLookup_int32_t_float16_float_false__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void EmbeddingLookup_int32_t_float16_float_true__avx2_fma(
     const TIndex block_size,
@@ -1367,7 +1377,8 @@ void EmbeddingLookup_int32_t_float16_float_true__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int32_t_float16_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -1379,7 +1390,8 @@ void EmbeddingLookup_int32_t_float16_float_true__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 template <bool IS_WEIGHT_POSITIONAL>
@@ -1394,8 +1406,8 @@ static void EmbeddingLookup_int64_t_float16_float__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
-  const int64_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int64_t fused_block_size = block_size + 0;
   CAFFE_ENFORCE(scale_bias == nullptr, "scale_bias must be nullptr");
   if (block_size == 128) {
@@ -1883,7 +1895,8 @@ void EmbeddingLookup_int64_t_float16_float_false__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int64_t_float16_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -1895,7 +1908,8 @@ void EmbeddingLookup_int64_t_float16_float_false__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void EmbeddingLookup_int64_t_float16_float_true__avx2_fma(
     const TIndex block_size,
@@ -1908,7 +1922,8 @@ void EmbeddingLookup_int64_t_float16_float_true__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int64_t_float16_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -1920,7 +1935,8 @@ void EmbeddingLookup_int64_t_float16_float_true__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 template <bool IS_WEIGHT_POSITIONAL>
@@ -1935,8 +1951,8 @@ static void EmbeddingLookup_int32_t_uint8_t_float__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
-  const int32_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int32_t fused_block_size = block_size + 0;
   CAFFE_ENFORCE(scale_bias != nullptr, "scale_bias must not be nullptr");
   if (block_size == 128) {
@@ -2442,7 +2458,8 @@ void EmbeddingLookup_int32_t_uint8_t_float_false__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int32_t_uint8_t_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -2454,7 +2471,8 @@ void EmbeddingLookup_int32_t_uint8_t_float_false__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void EmbeddingLookup_int32_t_uint8_t_float_true__avx2_fma(
     const TIndex block_size,
@@ -2467,7 +2485,8 @@ void EmbeddingLookup_int32_t_uint8_t_float_true__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int32_t_uint8_t_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -2479,7 +2498,8 @@ void EmbeddingLookup_int32_t_uint8_t_float_true__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 template <bool IS_WEIGHT_POSITIONAL>
@@ -2494,8 +2514,8 @@ static void EmbeddingLookup_int64_t_uint8_t_float__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
-  const int64_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int64_t fused_block_size = block_size + 0;
   CAFFE_ENFORCE(scale_bias != nullptr, "scale_bias must not be nullptr");
   if (block_size == 128) {
@@ -3001,7 +3021,8 @@ void EmbeddingLookup_int64_t_uint8_t_float_false__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int64_t_uint8_t_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -3013,7 +3034,8 @@ void EmbeddingLookup_int64_t_uint8_t_float_false__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void EmbeddingLookup_int64_t_uint8_t_float_true__avx2_fma(
     const TIndex block_size,
@@ -3026,7 +3048,8 @@ void EmbeddingLookup_int64_t_uint8_t_float_true__avx2_fma(
     const float* weights,
     const float* scale_bias,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   EmbeddingLookup_int64_t_uint8_t_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -3038,7 +3061,8 @@ void EmbeddingLookup_int64_t_uint8_t_float_true__avx2_fma(
       weights,
       scale_bias,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 } // namespace caffe2
@@ -22,8 +22,8 @@ static void Fused8BitRowwiseEmbeddingLookup_int32_t_float_float__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
-  const int32_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int32_t fused_block_size = block_size + 2;
   if (block_size == 128) {
     // unrolling 16 times
@@ -383,7 +383,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_float_float_false__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int32_t_float_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -394,7 +395,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_float_float_false__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void Fused8BitRowwiseEmbeddingLookup_int32_t_float_float_true__avx2_fma(
     const TIndex block_size,
@@ -406,7 +408,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_float_float_true__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int32_t_float_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -417,7 +420,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_float_float_true__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 template <bool IS_WEIGHT_POSITIONAL>
@@ -431,8 +435,8 @@ static void Fused8BitRowwiseEmbeddingLookup_int64_t_float_float__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
-  const int64_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int64_t fused_block_size = block_size + 2;
   if (block_size == 128) {
     // unrolling 16 times
@@ -792,7 +796,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_float_float_false__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int64_t_float_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -803,7 +808,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_float_float_false__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void Fused8BitRowwiseEmbeddingLookup_int64_t_float_float_true__avx2_fma(
     const TIndex block_size,
@@ -815,7 +821,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_float_float_true__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int64_t_float_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -826,7 +833,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_float_float_true__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 template <bool IS_WEIGHT_POSITIONAL>
@@ -840,8 +848,8 @@ static void Fused8BitRowwiseEmbeddingLookup_int32_t_float16_float__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
-  const int32_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int32_t fused_block_size = block_size + 4;
   if (block_size == 128) {
     // unrolling 16 times
@@ -1327,7 +1335,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_float16_float_false__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int32_t_float16_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -1338,7 +1347,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_float16_float_false__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void Fused8BitRowwiseEmbeddingLookup_int32_t_float16_float_true__avx2_fma(
     const TIndex block_size,
@@ -1350,7 +1360,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_float16_float_true__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int32_t_float16_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -1361,7 +1372,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_float16_float_true__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 template <bool IS_WEIGHT_POSITIONAL>
@@ -1375,8 +1387,8 @@ static void Fused8BitRowwiseEmbeddingLookup_int64_t_float16_float__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
-  const int64_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int64_t fused_block_size = block_size + 4;
   if (block_size == 128) {
     // unrolling 16 times
@@ -1862,7 +1874,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_float16_float_false__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int64_t_float16_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -1873,7 +1886,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_float16_float_false__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void Fused8BitRowwiseEmbeddingLookup_int64_t_float16_float_true__avx2_fma(
     const TIndex block_size,
@@ -1885,7 +1899,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_float16_float_true__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int64_t_float16_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -1896,7 +1911,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_float16_float_true__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 template <bool IS_WEIGHT_POSITIONAL>
@@ -1910,8 +1926,8 @@ static void Fused8BitRowwiseEmbeddingLookup_int32_t_uint8_t_float__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
-  const int32_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int32_t fused_block_size = block_size + 8;
   if (block_size == 128) {
     // unrolling 16 times
@@ -2424,7 +2440,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_uint8_t_float_false__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int32_t_uint8_t_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -2435,7 +2452,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_uint8_t_float_false__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void Fused8BitRowwiseEmbeddingLookup_int32_t_uint8_t_float_true__avx2_fma(
     const TIndex block_size,
@@ -2447,7 +2465,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_uint8_t_float_true__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int32_t_uint8_t_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -2458,7 +2477,8 @@ void Fused8BitRowwiseEmbeddingLookup_int32_t_uint8_t_float_true__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 template <bool IS_WEIGHT_POSITIONAL>
@@ -2472,8 +2492,8 @@ static void Fused8BitRowwiseEmbeddingLookup_int64_t_uint8_t_float__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
-  const int64_t prefdist_T0 = 16;
+    float* out,
+    const int prefdist_T0) {
   const int64_t fused_block_size = block_size + 8;
   if (block_size == 128) {
     // unrolling 16 times
@@ -2986,7 +3006,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_uint8_t_float_false__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int64_t_uint8_t_float__avx2_fma<false>(
       block_size,
       output_size,
@@ -2997,7 +3018,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_uint8_t_float_false__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 void Fused8BitRowwiseEmbeddingLookup_int64_t_uint8_t_float_true__avx2_fma(
     const TIndex block_size,
@@ -3009,7 +3031,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_uint8_t_float_true__avx2_fma(
     const int* lengths,
     const float* weights,
     bool normalize_by_lengths,
-    float* out) {
+    float* out,
+    const int prefdist_T0) {
   Fused8BitRowwiseEmbeddingLookup_int64_t_uint8_t_float__avx2_fma<true>(
       block_size,
       output_size,
@@ -3020,7 +3043,8 @@ void Fused8BitRowwiseEmbeddingLookup_int64_t_uint8_t_float_true__avx2_fma(
       lengths,
       weights,
       normalize_by_lengths,
-      out);
+      out,
+      prefdist_T0);
 }
 
 } // namespace caffe2
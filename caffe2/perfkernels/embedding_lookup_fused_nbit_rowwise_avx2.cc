@@ -0,0 +1,1563 @@
+//// --------------------------
+//// ATTENTION:
+//// THIS CODE IS AUTOGENERATED
+//// BY hp_emblookup_codegen.py
+//// DO NOT MODIFY!!!
+//// --------------------------
+
+#include <caffe2/core/types.h>
+#include <caffe2/core/common.h>
+#include <immintrin.h>
+#include <caffe2/perfkernels/cvtsh_ss_bugfix.h>
+
+namespace caffe2 {
+
+template <bool IS_WEIGHT_POSITIONAL>
+static void Fused4BitRowwiseEmbeddingLookup_int32_t_uint8_t_float__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int32_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  const int32_t fused_block_size = (block_size + 1) / 2 + 4;
+  const __m128i vshuffle = _mm_setr_epi8(0, 0, 1, 1, 2, 2, 3, 3, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i vshift = _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4);
+  const __m256i vmask = _mm256_set1_epi32(15);
+  if (block_size == 128) {
+    // unrolling 16 times
+    int32_t dataInd = 0;
+    for (int32_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      __m256 vop32 = _mm256_setzero_ps();
+      __m256 vop40 = _mm256_setzero_ps();
+      __m256 vop48 = _mm256_setzero_ps();
+      __m256 vop56 = _mm256_setzero_ps();
+      __m256 vop64 = _mm256_setzero_ps();
+      __m256 vop72 = _mm256_setzero_ps();
+      __m256 vop80 = _mm256_setzero_ps();
+      __m256 vop88 = _mm256_setzero_ps();
+      __m256 vop96 = _mm256_setzero_ps();
+      __m256 vop104 = _mm256_setzero_ps();
+      __m256 vop112 = _mm256_setzero_ps();
+      __m256 vop120 = _mm256_setzero_ps();
+      for (int32_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int32_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 1) / 2]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int32_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int32_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (8))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[8])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (12))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[12])
+        vop32 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (16))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop32, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[16])
+        vop40 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (20))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop40, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[20])
+        vop48 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (24))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop48, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[24])
+        vop56 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (28))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop56, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[28])
+        vop64 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (32))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop64, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[32])
+        vop72 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (36))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop72, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[36])
+        vop80 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (40))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop80, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[40])
+        vop88 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (44))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop88, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[44])
+        vop96 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (48))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop96, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[48])
+        vop104 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (52))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop104, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[52])
+        vop112 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (56))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop112, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[56])
+        vop120 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (60))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop120, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[60])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+        _mm256_storeu_ps(&op[32], vop32);
+        _mm256_storeu_ps(&op[40], vop40);
+        _mm256_storeu_ps(&op[48], vop48);
+        _mm256_storeu_ps(&op[56], vop56);
+        _mm256_storeu_ps(&op[64], vop64);
+        _mm256_storeu_ps(&op[72], vop72);
+        _mm256_storeu_ps(&op[80], vop80);
+        _mm256_storeu_ps(&op[88], vop88);
+        _mm256_storeu_ps(&op[96], vop96);
+        _mm256_storeu_ps(&op[104], vop104);
+        _mm256_storeu_ps(&op[112], vop112);
+        _mm256_storeu_ps(&op[120], vop120);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+        _mm256_storeu_ps(&op[32], _mm256_mul_ps(vop32, vlen_inv));
+        _mm256_storeu_ps(&op[40], _mm256_mul_ps(vop40, vlen_inv));
+        _mm256_storeu_ps(&op[48], _mm256_mul_ps(vop48, vlen_inv));
+        _mm256_storeu_ps(&op[56], _mm256_mul_ps(vop56, vlen_inv));
+        _mm256_storeu_ps(&op[64], _mm256_mul_ps(vop64, vlen_inv));
+        _mm256_storeu_ps(&op[72], _mm256_mul_ps(vop72, vlen_inv));
+        _mm256_storeu_ps(&op[80], _mm256_mul_ps(vop80, vlen_inv));
+        _mm256_storeu_ps(&op[88], _mm256_mul_ps(vop88, vlen_inv));
+        _mm256_storeu_ps(&op[96], _mm256_mul_ps(vop96, vlen_inv));
+        _mm256_storeu_ps(&op[104], _mm256_mul_ps(vop104, vlen_inv));
+        _mm256_storeu_ps(&op[112], _mm256_mul_ps(vop112, vlen_inv));
+        _mm256_storeu_ps(&op[120], _mm256_mul_ps(vop120, vlen_inv));
+      }
+    }
+  } else if (block_size == 64) {
+    // unrolling 8 times
+    int32_t dataInd = 0;
+    for (int32_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      __m256 vop32 = _mm256_setzero_ps();
+      __m256 vop40 = _mm256_setzero_ps();
+      __m256 vop48 = _mm256_setzero_ps();
+      __m256 vop56 = _mm256_setzero_ps();
+      for (int32_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int32_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 1) / 2]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int32_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int32_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (8))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[8])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (12))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[12])
+        vop32 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (16))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop32, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[16])
+        vop40 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (20))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop40, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[20])
+        vop48 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (24))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop48, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[24])
+        vop56 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (28))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop56, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[28])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+        _mm256_storeu_ps(&op[32], vop32);
+        _mm256_storeu_ps(&op[40], vop40);
+        _mm256_storeu_ps(&op[48], vop48);
+        _mm256_storeu_ps(&op[56], vop56);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+        _mm256_storeu_ps(&op[32], _mm256_mul_ps(vop32, vlen_inv));
+        _mm256_storeu_ps(&op[40], _mm256_mul_ps(vop40, vlen_inv));
+        _mm256_storeu_ps(&op[48], _mm256_mul_ps(vop48, vlen_inv));
+        _mm256_storeu_ps(&op[56], _mm256_mul_ps(vop56, vlen_inv));
+      }
+    }
+  } else if (block_size == 32) {
+    // unrolling 4 times
+    int32_t dataInd = 0;
+    for (int32_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      for (int32_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int32_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 1) / 2]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int32_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int32_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (8))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[8])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (12))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[12])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+      }
+    }
+  } else if (block_size == 16) {
+    // unrolling 2 times
+    int32_t dataInd = 0;
+    for (int32_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      for (int32_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int32_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 1) / 2]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int32_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int32_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+      }
+    }
+  } else {
+    // generic code
+    int32_t dataInd = 0;
+    for (int32_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      TIndex j = 0;
+      for(; j + 8 <= block_size; j += 8) {
+        _mm256_storeu_ps(op + j, _mm256_setzero_ps());
+      }
+      for(; j < block_size; j++) {
+        op[j] = 0.0f;
+      }
+      for (int32_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int32_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 1) / 2]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int32_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int32_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        j = 0;
+        for(; j + 8 <= block_size; j += 8) {
+          _mm256_storeu_ps(&op[j],                    _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(&ip[j / 2])), vshuffle)), vshift), vmask)),                      _mm256_add_ps(_mm256_loadu_ps(&op[j]), vbio) )                                    );
+          _mm_prefetch((&ip_next_T0[j / 2]), _MM_HINT_T0);
+        }
+        for(; j < block_size; j++) {
+          op[j] += wgt * ((ip[j / 2] >> ((j % 2) * 4)) & 15) + bio;
+        }
+      }
+      if (normalize_by_lengths && lengths[rangeIndex]) {
+        float len_inv = 1.0f / lengths[rangeIndex];
+        __m256 vlen_inv = _mm256_set1_ps(len_inv);
+        j = 0;
+        for(; j + 8 <= block_size; j += 8) {
+          _mm256_storeu_ps(&op[j], _mm256_mul_ps(_mm256_loadu_ps(&op[j]), vlen_inv));
+        }
+        for(; j < block_size; j++) {
+          op[j] = len_inv * op[j];
+        }
+      }
+    }
+  }
+}
+void Fused4BitRowwiseEmbeddingLookup_int32_t_uint8_t_float_false__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int32_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  Fused4BitRowwiseEmbeddingLookup_int32_t_uint8_t_float__avx2_fma<false>(
+      block_size,
+      output_size,
+      index_size,
+      data_size,
+      input,
+      indices,
+      lengths,
+      weights,
+      normalize_by_lengths,
+      out,
+      prefdist_T0);
+}
+void Fused4BitRowwiseEmbeddingLookup_int32_t_uint8_t_float_true__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int32_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  Fused4BitRowwiseEmbeddingLookup_int32_t_uint8_t_float__avx2_fma<true>(
+      block_size,
+      output_size,
+      index_size,
+      data_size,
+      input,
+      indices,
+      lengths,
+      weights,
+      normalize_by_lengths,
+      out,
+      prefdist_T0);
+}
+
+template <bool IS_WEIGHT_POSITIONAL>
+static void Fused4BitRowwiseEmbeddingLookup_int64_t_uint8_t_float__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int64_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  const int64_t fused_block_size = (block_size + 1) / 2 + 4;
+  const __m128i vshuffle = _mm_setr_epi8(0, 0, 1, 1, 2, 2, 3, 3, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i vshift = _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4);
+  const __m256i vmask = _mm256_set1_epi32(15);
+  if (block_size == 128) {
+    // unrolling 16 times
+    int64_t dataInd = 0;
+    for (int64_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      __m256 vop32 = _mm256_setzero_ps();
+      __m256 vop40 = _mm256_setzero_ps();
+      __m256 vop48 = _mm256_setzero_ps();
+      __m256 vop56 = _mm256_setzero_ps();
+      __m256 vop64 = _mm256_setzero_ps();
+      __m256 vop72 = _mm256_setzero_ps();
+      __m256 vop80 = _mm256_setzero_ps();
+      __m256 vop88 = _mm256_setzero_ps();
+      __m256 vop96 = _mm256_setzero_ps();
+      __m256 vop104 = _mm256_setzero_ps();
+      __m256 vop112 = _mm256_setzero_ps();
+      __m256 vop120 = _mm256_setzero_ps();
+      for (int64_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int64_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 1) / 2]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int64_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int64_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (8))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[8])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (12))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[12])
+        vop32 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (16))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop32, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[16])
+        vop40 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (20))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop40, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[20])
+        vop48 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (24))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop48, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[24])
+        vop56 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (28))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop56, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[28])
+        vop64 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (32))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop64, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[32])
+        vop72 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (36))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop72, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[36])
+        vop80 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (40))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop80, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[40])
+        vop88 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (44))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop88, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[44])
+        vop96 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (48))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop96, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[48])
+        vop104 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (52))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop104, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[52])
+        vop112 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (56))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop112, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[56])
+        vop120 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (60))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop120, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[60])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+        _mm256_storeu_ps(&op[32], vop32);
+        _mm256_storeu_ps(&op[40], vop40);
+        _mm256_storeu_ps(&op[48], vop48);
+        _mm256_storeu_ps(&op[56], vop56);
+        _mm256_storeu_ps(&op[64], vop64);
+        _mm256_storeu_ps(&op[72], vop72);
+        _mm256_storeu_ps(&op[80], vop80);
+        _mm256_storeu_ps(&op[88], vop88);
+        _mm256_storeu_ps(&op[96], vop96);
+        _mm256_storeu_ps(&op[104], vop104);
+        _mm256_storeu_ps(&op[112], vop112);
+        _mm256_storeu_ps(&op[120], vop120);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+        _mm256_storeu_ps(&op[32], _mm256_mul_ps(vop32, vlen_inv));
+        _mm256_storeu_ps(&op[40], _mm256_mul_ps(vop40, vlen_inv));
+        _mm256_storeu_ps(&op[48], _mm256_mul_ps(vop48, vlen_inv));
+        _mm256_storeu_ps(&op[56], _mm256_mul_ps(vop56, vlen_inv));
+        _mm256_storeu_ps(&op[64], _mm256_mul_ps(vop64, vlen_inv));
+        _mm256_storeu_ps(&op[72], _mm256_mul_ps(vop72, vlen_inv));
+        _mm256_storeu_ps(&op[80], _mm256_mul_ps(vop80, vlen_inv));
+        _mm256_storeu_ps(&op[88], _mm256_mul_ps(vop88, vlen_inv));
+        _mm256_storeu_ps(&op[96], _mm256_mul_ps(vop96, vlen_inv));
+        _mm256_storeu_ps(&op[104], _mm256_mul_ps(vop104, vlen_inv));
+        _mm256_storeu_ps(&op[112], _mm256_mul_ps(vop112, vlen_inv));
+        _mm256_storeu_ps(&op[120], _mm256_mul_ps(vop120, vlen_inv));
+      }
+    }
+  } else if (block_size == 64) {
+    // unrolling 8 times
+    int64_t dataInd = 0;
+    for (int64_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      __m256 vop32 = _mm256_setzero_ps();
+      __m256 vop40 = _mm256_setzero_ps();
+      __m256 vop48 = _mm256_setzero_ps();
+      __m256 vop56 = _mm256_setzero_ps();
+      for (int64_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int64_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 1) / 2]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int64_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int64_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (8))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[8])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (12))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[12])
+        vop32 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (16))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop32, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[16])
+        vop40 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (20))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop40, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[20])
+        vop48 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (24))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop48, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[24])
+        vop56 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (28))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop56, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[28])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+        _mm256_storeu_ps(&op[32], vop32);
+        _mm256_storeu_ps(&op[40], vop40);
+        _mm256_storeu_ps(&op[48], vop48);
+        _mm256_storeu_ps(&op[56], vop56);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+        _mm256_storeu_ps(&op[32], _mm256_mul_ps(vop32, vlen_inv));
+        _mm256_storeu_ps(&op[40], _mm256_mul_ps(vop40, vlen_inv));
+        _mm256_storeu_ps(&op[48], _mm256_mul_ps(vop48, vlen_inv));
+        _mm256_storeu_ps(&op[56], _mm256_mul_ps(vop56, vlen_inv));
+      }
+    }
+  } else if (block_size == 32) {
+    // unrolling 4 times
+    int64_t dataInd = 0;
+    for (int64_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      for (int64_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int64_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 1) / 2]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int64_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int64_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (8))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[8])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (12))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[12])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+      }
+    }
+  } else if (block_size == 16) {
+    // unrolling 2 times
+    int64_t dataInd = 0;
+    for (int64_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      for (int64_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int64_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 1) / 2]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int64_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int64_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+      }
+    }
+  } else {
+    // generic code
+    int64_t dataInd = 0;
+    for (int64_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      TIndex j = 0;
+      for(; j + 8 <= block_size; j += 8) {
+        _mm256_storeu_ps(op + j, _mm256_setzero_ps());
+      }
+      for(; j < block_size; j++) {
+        op[j] = 0.0f;
+      }
+      for (int64_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int64_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 1) / 2]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int64_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int64_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        j = 0;
+        for(; j + 8 <= block_size; j += 8) {
+          _mm256_storeu_ps(&op[j],                    _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const int32_t*>(&ip[j / 2])), vshuffle)), vshift), vmask)),                      _mm256_add_ps(_mm256_loadu_ps(&op[j]), vbio) )                                    );
+          _mm_prefetch((&ip_next_T0[j / 2]), _MM_HINT_T0);
+        }
+        for(; j < block_size; j++) {
+          op[j] += wgt * ((ip[j / 2] >> ((j % 2) * 4)) & 15) + bio;
+        }
+      }
+      if (normalize_by_lengths && lengths[rangeIndex]) {
+        float len_inv = 1.0f / lengths[rangeIndex];
+        __m256 vlen_inv = _mm256_set1_ps(len_inv);
+        j = 0;
+        for(; j + 8 <= block_size; j += 8) {
+          _mm256_storeu_ps(&op[j], _mm256_mul_ps(_mm256_loadu_ps(&op[j]), vlen_inv));
+        }
+        for(; j < block_size; j++) {
+          op[j] = len_inv * op[j];
+        }
+      }
+    }
+  }
+}
+void Fused4BitRowwiseEmbeddingLookup_int64_t_uint8_t_float_false__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int64_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  Fused4BitRowwiseEmbeddingLookup_int64_t_uint8_t_float__avx2_fma<false>(
+      block_size,
+      output_size,
+      index_size,
+      data_size,
+      input,
+      indices,
+      lengths,
+      weights,
+      normalize_by_lengths,
+      out,
+      prefdist_T0);
+}
+void Fused4BitRowwiseEmbeddingLookup_int64_t_uint8_t_float_true__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int64_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  Fused4BitRowwiseEmbeddingLookup_int64_t_uint8_t_float__avx2_fma<true>(
+      block_size,
+      output_size,
+      index_size,
+      data_size,
+      input,
+      indices,
+      lengths,
+      weights,
+      normalize_by_lengths,
+      out,
+      prefdist_T0);
+}
+
+template <bool IS_WEIGHT_POSITIONAL>
+static void Fused2BitRowwiseEmbeddingLookup_int32_t_uint8_t_float__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int32_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  const int32_t fused_block_size = (block_size + 3) / 4 + 4;
+  const __m128i vshuffle = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i vshift = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  const __m256i vmask = _mm256_set1_epi32(3);
+  if (block_size == 128) {
+    // unrolling 16 times
+    int32_t dataInd = 0;
+    for (int32_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      __m256 vop32 = _mm256_setzero_ps();
+      __m256 vop40 = _mm256_setzero_ps();
+      __m256 vop48 = _mm256_setzero_ps();
+      __m256 vop56 = _mm256_setzero_ps();
+      __m256 vop64 = _mm256_setzero_ps();
+      __m256 vop72 = _mm256_setzero_ps();
+      __m256 vop80 = _mm256_setzero_ps();
+      __m256 vop88 = _mm256_setzero_ps();
+      __m256 vop96 = _mm256_setzero_ps();
+      __m256 vop104 = _mm256_setzero_ps();
+      __m256 vop112 = _mm256_setzero_ps();
+      __m256 vop120 = _mm256_setzero_ps();
+      for (int32_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int32_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 3) / 4]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int32_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int32_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (2))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[2])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (6))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[6])
+        vop32 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (8))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop32, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[8])
+        vop40 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (10))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop40, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[10])
+        vop48 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (12))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop48, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[12])
+        vop56 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (14))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop56, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[14])
+        vop64 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (16))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop64, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[16])
+        vop72 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (18))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop72, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[18])
+        vop80 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (20))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop80, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[20])
+        vop88 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (22))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop88, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[22])
+        vop96 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (24))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop96, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[24])
+        vop104 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (26))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop104, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[26])
+        vop112 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (28))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop112, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[28])
+        vop120 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (30))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop120, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[30])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+        _mm256_storeu_ps(&op[32], vop32);
+        _mm256_storeu_ps(&op[40], vop40);
+        _mm256_storeu_ps(&op[48], vop48);
+        _mm256_storeu_ps(&op[56], vop56);
+        _mm256_storeu_ps(&op[64], vop64);
+        _mm256_storeu_ps(&op[72], vop72);
+        _mm256_storeu_ps(&op[80], vop80);
+        _mm256_storeu_ps(&op[88], vop88);
+        _mm256_storeu_ps(&op[96], vop96);
+        _mm256_storeu_ps(&op[104], vop104);
+        _mm256_storeu_ps(&op[112], vop112);
+        _mm256_storeu_ps(&op[120], vop120);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+        _mm256_storeu_ps(&op[32], _mm256_mul_ps(vop32, vlen_inv));
+        _mm256_storeu_ps(&op[40], _mm256_mul_ps(vop40, vlen_inv));
+        _mm256_storeu_ps(&op[48], _mm256_mul_ps(vop48, vlen_inv));
+        _mm256_storeu_ps(&op[56], _mm256_mul_ps(vop56, vlen_inv));
+        _mm256_storeu_ps(&op[64], _mm256_mul_ps(vop64, vlen_inv));
+        _mm256_storeu_ps(&op[72], _mm256_mul_ps(vop72, vlen_inv));
+        _mm256_storeu_ps(&op[80], _mm256_mul_ps(vop80, vlen_inv));
+        _mm256_storeu_ps(&op[88], _mm256_mul_ps(vop88, vlen_inv));
+        _mm256_storeu_ps(&op[96], _mm256_mul_ps(vop96, vlen_inv));
+        _mm256_storeu_ps(&op[104], _mm256_mul_ps(vop104, vlen_inv));
+        _mm256_storeu_ps(&op[112], _mm256_mul_ps(vop112, vlen_inv));
+        _mm256_storeu_ps(&op[120], _mm256_mul_ps(vop120, vlen_inv));
+      }
+    }
+  } else if (block_size == 64) {
+    // unrolling 8 times
+    int32_t dataInd = 0;
+    for (int32_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      __m256 vop32 = _mm256_setzero_ps();
+      __m256 vop40 = _mm256_setzero_ps();
+      __m256 vop48 = _mm256_setzero_ps();
+      __m256 vop56 = _mm256_setzero_ps();
+      for (int32_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int32_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 3) / 4]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int32_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int32_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (2))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[2])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (6))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[6])
+        vop32 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (8))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop32, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[8])
+        vop40 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (10))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop40, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[10])
+        vop48 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (12))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop48, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[12])
+        vop56 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (14))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop56, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[14])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+        _mm256_storeu_ps(&op[32], vop32);
+        _mm256_storeu_ps(&op[40], vop40);
+        _mm256_storeu_ps(&op[48], vop48);
+        _mm256_storeu_ps(&op[56], vop56);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+        _mm256_storeu_ps(&op[32], _mm256_mul_ps(vop32, vlen_inv));
+        _mm256_storeu_ps(&op[40], _mm256_mul_ps(vop40, vlen_inv));
+        _mm256_storeu_ps(&op[48], _mm256_mul_ps(vop48, vlen_inv));
+        _mm256_storeu_ps(&op[56], _mm256_mul_ps(vop56, vlen_inv));
+      }
+    }
+  } else if (block_size == 32) {
+    // unrolling 4 times
+    int32_t dataInd = 0;
+    for (int32_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      for (int32_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int32_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 3) / 4]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int32_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int32_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (2))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[2])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (6))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[6])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+      }
+    }
+  } else if (block_size == 16) {
+    // unrolling 2 times
+    int32_t dataInd = 0;
+    for (int32_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      for (int32_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int32_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 3) / 4]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int32_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int32_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (2))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[2])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+      }
+    }
+  } else {
+    // generic code
+    int32_t dataInd = 0;
+    for (int32_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      TIndex j = 0;
+      for(; j + 8 <= block_size; j += 8) {
+        _mm256_storeu_ps(op + j, _mm256_setzero_ps());
+      }
+      for(; j < block_size; j++) {
+        op[j] = 0.0f;
+      }
+      for (int32_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int32_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 3) / 4]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int32_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int32_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        j = 0;
+        for(; j + 8 <= block_size; j += 8) {
+          _mm256_storeu_ps(&op[j],                    _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(&ip[j / 4])), vshuffle)), vshift), vmask)),                      _mm256_add_ps(_mm256_loadu_ps(&op[j]), vbio) )                                    );
+          _mm_prefetch((&ip_next_T0[j / 4]), _MM_HINT_T0);
+        }
+        for(; j < block_size; j++) {
+          op[j] += wgt * ((ip[j / 4] >> ((j % 4) * 2)) & 3) + bio;
+        }
+      }
+      if (normalize_by_lengths && lengths[rangeIndex]) {
+        float len_inv = 1.0f / lengths[rangeIndex];
+        __m256 vlen_inv = _mm256_set1_ps(len_inv);
+        j = 0;
+        for(; j + 8 <= block_size; j += 8) {
+          _mm256_storeu_ps(&op[j], _mm256_mul_ps(_mm256_loadu_ps(&op[j]), vlen_inv));
+        }
+        for(; j < block_size; j++) {
+          op[j] = len_inv * op[j];
+        }
+      }
+    }
+  }
+}
+void Fused2BitRowwiseEmbeddingLookup_int32_t_uint8_t_float_false__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int32_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  Fused2BitRowwiseEmbeddingLookup_int32_t_uint8_t_float__avx2_fma<false>(
+      block_size,
+      output_size,
+      index_size,
+      data_size,
+      input,
+      indices,
+      lengths,
+      weights,
+      normalize_by_lengths,
+      out,
+      prefdist_T0);
+}
+void Fused2BitRowwiseEmbeddingLookup_int32_t_uint8_t_float_true__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int32_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  Fused2BitRowwiseEmbeddingLookup_int32_t_uint8_t_float__avx2_fma<true>(
+      block_size,
+      output_size,
+      index_size,
+      data_size,
+      input,
+      indices,
+      lengths,
+      weights,
+      normalize_by_lengths,
+      out,
+      prefdist_T0);
+}
+
+template <bool IS_WEIGHT_POSITIONAL>
+static void Fused2BitRowwiseEmbeddingLookup_int64_t_uint8_t_float__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int64_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  const int64_t fused_block_size = (block_size + 3) / 4 + 4;
+  const __m128i vshuffle = _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i vshift = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  const __m256i vmask = _mm256_set1_epi32(3);
+  if (block_size == 128) {
+    // unrolling 16 times
+    int64_t dataInd = 0;
+    for (int64_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      __m256 vop32 = _mm256_setzero_ps();
+      __m256 vop40 = _mm256_setzero_ps();
+      __m256 vop48 = _mm256_setzero_ps();
+      __m256 vop56 = _mm256_setzero_ps();
+      __m256 vop64 = _mm256_setzero_ps();
+      __m256 vop72 = _mm256_setzero_ps();
+      __m256 vop80 = _mm256_setzero_ps();
+      __m256 vop88 = _mm256_setzero_ps();
+      __m256 vop96 = _mm256_setzero_ps();
+      __m256 vop104 = _mm256_setzero_ps();
+      __m256 vop112 = _mm256_setzero_ps();
+      __m256 vop120 = _mm256_setzero_ps();
+      for (int64_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int64_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 3) / 4]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int64_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int64_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (2))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[2])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (6))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[6])
+        vop32 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (8))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop32, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[8])
+        vop40 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (10))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop40, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[10])
+        vop48 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (12))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop48, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[12])
+        vop56 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (14))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop56, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[14])
+        vop64 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (16))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop64, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[16])
+        vop72 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (18))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop72, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[18])
+        vop80 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (20))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop80, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[20])
+        vop88 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (22))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop88, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[22])
+        vop96 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (24))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop96, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[24])
+        vop104 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (26))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop104, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[26])
+        vop112 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (28))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop112, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[28])
+        vop120 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (30))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop120, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[30])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+        _mm256_storeu_ps(&op[32], vop32);
+        _mm256_storeu_ps(&op[40], vop40);
+        _mm256_storeu_ps(&op[48], vop48);
+        _mm256_storeu_ps(&op[56], vop56);
+        _mm256_storeu_ps(&op[64], vop64);
+        _mm256_storeu_ps(&op[72], vop72);
+        _mm256_storeu_ps(&op[80], vop80);
+        _mm256_storeu_ps(&op[88], vop88);
+        _mm256_storeu_ps(&op[96], vop96);
+        _mm256_storeu_ps(&op[104], vop104);
+        _mm256_storeu_ps(&op[112], vop112);
+        _mm256_storeu_ps(&op[120], vop120);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+        _mm256_storeu_ps(&op[32], _mm256_mul_ps(vop32, vlen_inv));
+        _mm256_storeu_ps(&op[40], _mm256_mul_ps(vop40, vlen_inv));
+        _mm256_storeu_ps(&op[48], _mm256_mul_ps(vop48, vlen_inv));
+        _mm256_storeu_ps(&op[56], _mm256_mul_ps(vop56, vlen_inv));
+        _mm256_storeu_ps(&op[64], _mm256_mul_ps(vop64, vlen_inv));
+        _mm256_storeu_ps(&op[72], _mm256_mul_ps(vop72, vlen_inv));
+        _mm256_storeu_ps(&op[80], _mm256_mul_ps(vop80, vlen_inv));
+        _mm256_storeu_ps(&op[88], _mm256_mul_ps(vop88, vlen_inv));
+        _mm256_storeu_ps(&op[96], _mm256_mul_ps(vop96, vlen_inv));
+        _mm256_storeu_ps(&op[104], _mm256_mul_ps(vop104, vlen_inv));
+        _mm256_storeu_ps(&op[112], _mm256_mul_ps(vop112, vlen_inv));
+        _mm256_storeu_ps(&op[120], _mm256_mul_ps(vop120, vlen_inv));
+      }
+    }
+  } else if (block_size == 64) {
+    // unrolling 8 times
+    int64_t dataInd = 0;
+    for (int64_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      __m256 vop32 = _mm256_setzero_ps();
+      __m256 vop40 = _mm256_setzero_ps();
+      __m256 vop48 = _mm256_setzero_ps();
+      __m256 vop56 = _mm256_setzero_ps();
+      for (int64_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int64_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 3) / 4]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int64_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int64_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (2))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[2])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (6))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[6])
+        vop32 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (8))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop32, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[8])
+        vop40 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (10))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop40, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[10])
+        vop48 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (12))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop48, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[12])
+        vop56 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (14))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop56, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[14])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+        _mm256_storeu_ps(&op[32], vop32);
+        _mm256_storeu_ps(&op[40], vop40);
+        _mm256_storeu_ps(&op[48], vop48);
+        _mm256_storeu_ps(&op[56], vop56);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+        _mm256_storeu_ps(&op[32], _mm256_mul_ps(vop32, vlen_inv));
+        _mm256_storeu_ps(&op[40], _mm256_mul_ps(vop40, vlen_inv));
+        _mm256_storeu_ps(&op[48], _mm256_mul_ps(vop48, vlen_inv));
+        _mm256_storeu_ps(&op[56], _mm256_mul_ps(vop56, vlen_inv));
+      }
+    }
+  } else if (block_size == 32) {
+    // unrolling 4 times
+    int64_t dataInd = 0;
+    for (int64_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      __m256 vop16 = _mm256_setzero_ps();
+      __m256 vop24 = _mm256_setzero_ps();
+      for (int64_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int64_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 3) / 4]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int64_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int64_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (2))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[2])
+        vop16 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (4))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop16, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[4])
+        vop24 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (6))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop24, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[6])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+        _mm256_storeu_ps(&op[16], vop16);
+        _mm256_storeu_ps(&op[24], vop24);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+        _mm256_storeu_ps(&op[16], _mm256_mul_ps(vop16, vlen_inv));
+        _mm256_storeu_ps(&op[24], _mm256_mul_ps(vop24, vlen_inv));
+      }
+    }
+  } else if (block_size == 16) {
+    // unrolling 2 times
+    int64_t dataInd = 0;
+    for (int64_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      __m256 vop0 = _mm256_setzero_ps();
+      __m256 vop8 = _mm256_setzero_ps();
+      for (int64_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int64_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 3) / 4]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int64_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int64_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        vop0 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (0))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop0, vbio));
+        _mm_prefetch((&ip_next_T0[0]), _MM_HINT_T0);
+        vop8 = _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(ip + (2))), vshuffle)), vshift), vmask)), _mm256_add_ps(vop8, vbio));
+        // skip unnecessary prefetch of (&ip_next_T0[2])
+      }
+      if (normalize_by_lengths == false) {
+        _mm256_storeu_ps(&op[0], vop0);
+        _mm256_storeu_ps(&op[8], vop8);
+      } else if (lengths[rangeIndex]) {
+        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);
+        _mm256_storeu_ps(&op[0], _mm256_mul_ps(vop0, vlen_inv));
+        _mm256_storeu_ps(&op[8], _mm256_mul_ps(vop8, vlen_inv));
+      }
+    }
+  } else {
+    // generic code
+    int64_t dataInd = 0;
+    for (int64_t rangeIndex = 0; rangeIndex < output_size; ++rangeIndex) {
+      float *op = &out[rangeIndex * block_size];
+      TIndex j = 0;
+      for(; j + 8 <= block_size; j += 8) {
+        _mm256_storeu_ps(op + j, _mm256_setzero_ps());
+      }
+      for(; j < block_size; j++) {
+        op[j] = 0.0f;
+      }
+      for (int64_t start = dataInd; dataInd < start + lengths[rangeIndex]; ++dataInd) {
+        const  int64_t idx = indices[dataInd];
+        CAFFE_ENFORCE(idx >=0 && idx < data_size, "Index ", dataInd, " is out of bounds: ", idx, ", range 0 to ", data_size);
+        float wgt = 1.f;
+        float bio;
+        if (weights) {
+          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];
+        }
+        const float16* scale_bias = reinterpret_cast<const float16*>(&input[idx * fused_block_size + (block_size + 3) / 4]);
+        bio = wgt * _cvtsh_ss(scale_bias[1].x);
+        wgt = wgt * _cvtsh_ss(scale_bias[0].x);
+        __m256 vbio = _mm256_set1_ps(bio);
+        __m256 vwgt = _mm256_set1_ps(wgt);
+        const uint8_t *ip = &input[idx * fused_block_size];
+        const int64_t next_T0 = (dataInd < index_size - prefdist_T0) ? (dataInd + prefdist_T0) : dataInd;
+        const  int64_t idx_pref_T0 = indices[next_T0];
+        CAFFE_ENFORCE(idx_pref_T0 >= 0 && idx_pref_T0 < data_size);
+        const uint8_t *ip_next_T0 = &input[idx_pref_T0 * fused_block_size];
+        j = 0;
+        for(; j + 8 <= block_size; j += 8) {
+          _mm256_storeu_ps(&op[j],                    _mm256_fmadd_ps(vwgt, _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32(_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128(*reinterpret_cast<const uint16_t*>(&ip[j / 4])), vshuffle)), vshift), vmask)),                      _mm256_add_ps(_mm256_loadu_ps(&op[j]), vbio) )                                    );
+          _mm_prefetch((&ip_next_T0[j / 4]), _MM_HINT_T0);
+        }
+        for(; j < block_size; j++) {
+          op[j] += wgt * ((ip[j / 4] >> ((j % 4) * 2)) & 3) + bio;
+        }
+      }
+      if (normalize_by_lengths && lengths[rangeIndex]) {
+        float len_inv = 1.0f / lengths[rangeIndex];
+        __m256 vlen_inv = _mm256_set1_ps(len_inv);
+        j = 0;
+        for(; j + 8 <= block_size; j += 8) {
+          _mm256_storeu_ps(&op[j], _mm256_mul_ps(_mm256_loadu_ps(&op[j]), vlen_inv));
+        }
+        for(; j < block_size; j++) {
+          op[j] = len_inv * op[j];
+        }
+      }
+    }
+  }
+}
+void Fused2BitRowwiseEmbeddingLookup_int64_t_uint8_t_float_false__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int64_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  Fused2BitRowwiseEmbeddingLookup_int64_t_uint8_t_float__avx2_fma<false>(
+      block_size,
+      output_size,
+      index_size,
+      data_size,
+      input,
+      indices,
+      lengths,
+      weights,
+      normalize_by_lengths,
+      out,
+      prefdist_T0);
+}
+void Fused2BitRowwiseEmbeddingLookup_int64_t_uint8_t_float_true__avx2_fma(
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const uint8_t* input,
+    const int64_t* indices,
+    const int* lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    const int prefdist_T0) {
+  Fused2BitRowwiseEmbeddingLookup_int64_t_uint8_t_float__avx2_fma<true>(
+      block_size,
+      output_size,
+      index_size,
+      data_size,
+      input,
+      indices,
+      lengths,
+      weights,
+      normalize_by_lengths,
+      out,
+      prefdist_T0);
+}
+
+} // namespace caffe2
@@ -0,0 +1,119 @@
+#include "caffe2/perfkernels/embedding_lookup_prefetch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+
+#include "caffe2/core/flags.h"
+#include "caffe2/core/logging.h"
+
+CAFFE2_DEFINE_int(
+    caffe2_embedding_lookup_prefetch_distance,
+    -1,
+    "If non-negative, the number of indices ahead the EmbeddingLookup "
+    "kernels prefetch rows. Otherwise the distance is autotuned for each "
+    "table size.");
+
+namespace caffe2 {
+
+namespace {
+constexpr int kCandidates[] = {2, 4, 8, 16, 32, 64};
+constexpr int kNumCandidates = sizeof(kCandidates) / sizeof(kCandidates[0]);
+constexpr int kDefaultDistance = 16;
+// each candidate is timed this many times, and its fastest trial counts
+constexpr int kTrialsPerCandidate = 3;
+constexpr int kNumTrials = kNumCandidates * kTrialsPerCandidate;
+// shorter calls are too noisy to time
+constexpr TIndex kMinTuningIndices = 1024;
+// the keys of the table sizes, see the constructor
+constexpr int kNumKeys = 64 * 64;
+
+int Log2Ceil(TIndex x) {
+  int log2 = 0;
+  while ((TIndex(1) << log2) < x && log2 < 62) {
+    ++log2;
+  }
+  return log2;
+}
+} // namespace
+
+struct EmbeddingLookupPrefetchState {
+  int started = 0;
+  int finished = 0;
+  float best_ns_per_index[kNumCandidates];
+
+  EmbeddingLookupPrefetchState() {
+    std::fill(
+        best_ns_per_index,
+        best_ns_per_index + kNumCandidates,
+        std::numeric_limits<float>::max());
+  }
+};
+
+namespace {
+std::mutex& TuningMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// keyed by the rounded table size and row size. The references stay valid
+// when the map rehashes.
+std::unordered_map<int, EmbeddingLookupPrefetchState>& TuningStates() {
+  static std::unordered_map<int, EmbeddingLookupPrefetchState> states;
+  return states;
+}
+
+// the autotuned distance of every key, or 0 while it is being tuned. Lets the
+// calls that don't time themselves skip the lock.
+std::atomic<int> tuned_distances[kNumKeys];
+} // namespace
+
+EmbeddingLookupPrefetch::EmbeddingLookupPrefetch(
+    const TIndex data_size,
+    const TIndex row_bytes,
+    const TIndex index_size,
+    const bool tune)
+    : index_size_(index_size) {
+  if (FLAGS_caffe2_embedding_lookup_prefetch_distance >= 0) {
+    distance_ = FLAGS_caffe2_embedding_lookup_prefetch_distance;
+    return;
+  }
+  key_ = Log2Ceil(data_size * row_bytes) * 64 + Log2Ceil(row_bytes);
+  const int tuned = tuned_distances[key_].load(std::memory_order_relaxed);
+  distance_ = tuned ? tuned : kDefaultDistance;
+  if (tuned || !tune || index_size < kMinTuningIndices) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(TuningMutex());
+  auto& state = TuningStates()[key_];
+  if (state.started < kNumTrials) {
+    candidate_ = state.started++ % kNumCandidates;
+    distance_ = kCandidates[candidate_];
+    state_ = &state;
+    // start timing after taking the lock
+    timer_.Start();
+  }
+}
+
+EmbeddingLookupPrefetch::~EmbeddingLookupPrefetch() {
+  if (!state_) {
+    return;
+  }
+  const float ns_per_index = timer_.NanoSeconds() / index_size_;
+  std::lock_guard<std::mutex> lock(TuningMutex());
+  state_->best_ns_per_index[candidate_] =
+      std::min(state_->best_ns_per_index[candidate_], ns_per_index);
+  if (++state_->finished == kNumTrials) {
+    const int distance = kCandidates[
+        std::min_element(
+            state_->best_ns_per_index,
+            state_->best_ns_per_index + kNumCandidates) -
+        state_->best_ns_per_index];
+    tuned_distances[key_].store(distance, std::memory_order_relaxed);
+    VLOG(1) << "EmbeddingLookup prefetch distance autotuned to " << distance;
+  }
+}
+
+} // namespace caffe2
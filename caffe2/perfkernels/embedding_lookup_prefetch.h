@@ -0,0 +1,54 @@
+#pragma once
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/timer.h"
+
+namespace caffe2 {
+
+struct EmbeddingLookupPrefetchState;
+
+/**
+ * Chooses the software prefetch distance, in indices, of one call to an
+ * EmbeddingLookup kernel: while row i is accumulated, the kernels prefetch
+ * row i + distance.
+ *
+ * With --caffe2_embedding_lookup_prefetch_distance >= 0 the distance is fixed.
+ * Otherwise it is autotuned per table size: the first large enough calls on
+ * tables of a given size and row size (both rounded up to powers of 2) try
+ * each candidate distance in turn, and time themselves when this object goes
+ * out of scope. Later calls use the fastest candidate, without locking.
+ * Calls constructed with tune = false, like the ones of kernel variants with
+ * a different access pattern, use the tuned distance but are never timed.
+ *
+ * Usage, in the entry function of a kernel:
+ *
+ *   EmbeddingLookupPrefetch prefetch(data_size, row_bytes, index_size);
+ *   AVX2_FMA_DO(kernel, ..., prefetch.distance());
+ *   BASE_DO(kernel, ..., prefetch.distance());
+ */
+class EmbeddingLookupPrefetch {
+ public:
+  EmbeddingLookupPrefetch(
+      const TIndex data_size,
+      const TIndex row_bytes,
+      const TIndex index_size,
+      const bool tune = true);
+  ~EmbeddingLookupPrefetch();
+
+  int distance() const {
+    return distance_;
+  }
+
+ private:
+  int distance_;
+  // set if this call is one of the timed trials of candidate_
+  EmbeddingLookupPrefetchState* state_ = nullptr;
+  int candidate_ = 0;
+  int key_ = 0;
+  TIndex index_size_;
+  Timer timer_;
+
+  DISABLE_COPY_AND_ASSIGN(EmbeddingLookupPrefetch);
+};
+
+} // namespace caffe2
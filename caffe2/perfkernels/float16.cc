@@ -0,0 +1,21 @@
+#include "caffe2/perfkernels/float16.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void Float16ToFloat__base(int N, const float16* X, float* Y) {
+  for (int i = 0; i < N; ++i) {
+    Y[i] = convert::cpu_half2float(X[i]);
+  }
+}
+
+void Float16ToFloat(int N, const float16* X, float* Y) {
+  AVX_F16C_DO(Float16ToFloat, N, X, Y);
+  NEON_DO(Float16ToFloat, N, X, Y);
+  BASE_DO(Float16ToFloat, N, X, Y);
+}
+
+} // namespace caffe2
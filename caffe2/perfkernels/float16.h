@@ -0,0 +1,11 @@
+#pragma once
+
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+// Converts N fp16 values to fp32, e.g. the weights of the kernels that store
+// them in fp16 and compute in fp32.
+void Float16ToFloat(int N, const float16* X, float* Y);
+
+} // namespace caffe2
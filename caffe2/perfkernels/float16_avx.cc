@@ -0,0 +1,22 @@
+#include "caffe2/perfkernels/cvtsh_ss_bugfix.h"
+#include "caffe2/perfkernels/float16.h"
+
+#include <emmintrin.h>
+#include <immintrin.h>
+
+namespace caffe2 {
+
+void Float16ToFloat__avx_f16c(int N, const float16* X, float* Y) {
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    _mm256_storeu_ps(
+        Y + i,
+        _mm256_cvtph_ps(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(X + i))));
+  }
+  for (; i < N; ++i) {
+    Y[i] = _cvtsh_ss(X[i].x);
+  }
+}
+
+} // namespace caffe2
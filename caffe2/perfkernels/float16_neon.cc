@@ -0,0 +1,30 @@
+#include "caffe2/perfkernels/float16.h"
+
+#include <arm_neon.h>
+
+namespace caffe2 {
+
+void Float16ToFloat__neon(int N, const float16* X, float* Y) {
+  const uint16_t* x = reinterpret_cast<const uint16_t*>(X);
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    const uint16x8_t h = vld1q_u16(x + i);
+    vst1q_f32(Y + i, vcvt_f32_f16(vreinterpret_f16_u16(vget_low_u16(h))));
+    vst1q_f32(Y + i + 4, vcvt_f32_f16(vreinterpret_f16_u16(vget_high_u16(h))));
+  }
+  if (i < N) {
+    uint16_t tail[8] = {0};
+    float y[8];
+    for (int j = 0; i + j < N; ++j) {
+      tail[j] = x[i + j];
+    }
+    const uint16x8_t h = vld1q_u16(tail);
+    vst1q_f32(y, vcvt_f32_f16(vreinterpret_f16_u16(vget_low_u16(h))));
+    vst1q_f32(y + 4, vcvt_f32_f16(vreinterpret_f16_u16(vget_high_u16(h))));
+    for (int j = 0; i + j < N; ++j) {
+      Y[i + j] = y[j];
+    }
+  }
+}
+
+} // namespace caffe2
@@ -2,6 +2,7 @@
 
 #include "caffe2/core/types.h"
 #include "caffe2/perfkernels/common.h"
+#include "caffe2/perfkernels/embedding_lookup_prefetch.h"
 #include "caffe2/perfkernels/typed_axpy.h"
 #include "caffe2/utils/cpuid.h"
 #include "caffe2/utils/eigen_utils.h"
@@ -25,7 +26,8 @@ static void Fused8BitRowwiseEmbeddingLookupGenericSlow(
     const int* lengths,
     const float* weights, // optional, can be null for sum reducer
     bool normalize_by_lengths,
-    OutType* out) {
+    OutType* out,
+    const int prefetch_distance) {
   // block_size is the number of elements and fused_block_size is the size of
   // an entire row, including scale and bias.
   const auto scale_bias_offset = 8 / sizeof(InType);
@@ -47,9 +49,11 @@ static void Fused8BitRowwiseEmbeddingLookupGenericSlow(
           data_size);
       CAFFE_ENFORCE_LT(idx, data_size);
 #ifdef __GNUC__
-      if (current + 1 < index_size) {
+      if (current + prefetch_distance < index_size) {
         __builtin_prefetch(
-            input + fused_block_size * indices[current + 1], 0, 1);
+            input + fused_block_size * indices[current + prefetch_distance],
+            0,
+            1);
       }
 #endif // __GNUC__
 
@@ -98,7 +102,8 @@ static void Fused8BitRowwiseEmbeddingLookupGenericSlow(
           const int* lengths,                                                           \
           const float* weights,                                                         \
           bool normalize_by_lengths,                                                    \
-          OutType* out) {                                                               \
+          OutType* out,                                                                 \
+          const int prefetch_distance) {                                                \
     Fused8BitRowwiseEmbeddingLookupGenericSlow<                                         \
         IndexType,                                                                      \
         InType,                                                                         \
@@ -113,7 +118,8 @@ static void Fused8BitRowwiseEmbeddingLookupGenericSlow(
         lengths,                                                                        \
         weights,                                                                        \
         normalize_by_lengths,                                                           \
-        out);                                                                           \
+        out,                                                                            \
+        prefetch_distance);                                                             \
   }                                                                                     \
   template <>                                                                           \
   void Fused8BitRowwiseEmbeddingLookup<IndexType, InType, OutType, false>(              \
@@ -132,6 +138,8 @@ static void Fused8BitRowwiseEmbeddingLookupGenericSlow(
         reinterpret_cast<const uint8_t*>(&one)[0],                                      \
         1,                                                                              \
         "Fused8BitRowwiseEmbeddingLookup is not supported on this platform");           \
+    EmbeddingLookupPrefetch prefetch(                                                   \
+        data_size, block_size + 8, index_size);                                         \
     AVX2_FMA_DO(                                                                        \
         Fused8BitRowwiseEmbeddingLookup_##IndexType##_##InType##_##OutType##_false,     \
         block_size,                                                                     \
@@ -143,7 +151,8 @@ static void Fused8BitRowwiseEmbeddingLookupGenericSlow(
         lengths,                                                                        \
         weights,                                                                        \
         normalize_by_lengths,                                                           \
-        out);                                                                           \
+        out,                                                                            \
+        prefetch.distance());                                                           \
     BASE_DO(                                                                            \
         Fused8BitRowwiseEmbeddingLookup_##IndexType##_##InType##_##OutType##_false,     \
         block_size,                                                                     \
@@ -155,7 +164,8 @@ static void Fused8BitRowwiseEmbeddingLookupGenericSlow(
         lengths,                                                                        \
         weights,                                                                        \
         normalize_by_lengths,                                                           \
-        out);                                                                           \
+        out,                                                                            \
+        prefetch.distance());                                                           \
   }
 
 FUSED_8BIT_ROWWISE_EMBEDDING_SPECIALIZATION(int32_t, uint8_t, float);
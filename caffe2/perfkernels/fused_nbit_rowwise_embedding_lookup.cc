@@ -0,0 +1,228 @@
+#include "caffe2/perfkernels/fused_nbit_rowwise_embedding_lookup.h"
+
+#include "caffe2/core/types.h"
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/perfkernels/embedding_lookup_prefetch.h"
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/cpuid.h"
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+// Base implementation does runtime dispatch for each segment of reduction
+template <
+    typename IndexType,
+    typename InType,
+    typename OutType,
+    bool IS_WEIGHT_POSITIONAL = false>
+static void FusedNBitRowwiseEmbeddingLookupGenericSlow(
+    const int bit_rate,
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const InType* input,
+    const IndexType* indices,
+    const int* lengths,
+    const float* weights, // optional, can be null for sum reducer
+    bool normalize_by_lengths,
+    OutType* out,
+    const int prefetch_distance) {
+  // block_size is the number of elements and fused_block_size is the size of
+  // an entire row, including scale and bias.
+  const int num_elem_per_byte = 8 / bit_rate;
+  const int mask = (1 << bit_rate) - 1;
+  const TIndex block_bytes =
+      (block_size + num_elem_per_byte - 1) / num_elem_per_byte;
+  const TIndex fused_block_size = block_bytes + 4;
+  TIndex current = 0;
+  for (int m = 0; m < output_size; ++m) {
+    memset(out, 0, sizeof(OutType) * block_size);
+    for (int i = 0; i < lengths[m]; ++i) {
+      CAFFE_ENFORCE_LT(current, index_size);
+      TIndex idx = indices[current];
+      CAFFE_ENFORCE(
+          0 <= idx && idx < data_size,
+          "Index ",
+          current,
+          " is out of bounds: ",
+          idx,
+          ", range 0 to ",
+          data_size);
+#ifdef __GNUC__
+      if (current + prefetch_distance < index_size) {
+        __builtin_prefetch(
+            input + fused_block_size * indices[current + prefetch_distance],
+            0,
+            1);
+      }
+#endif // __GNUC__
+
+      const InType* row = input + fused_block_size * idx;
+      const float16* scale_bias =
+          reinterpret_cast<const float16*>(row + block_bytes);
+
+      float weight = 1.0f;
+      if (weights) {
+        weight = weights[IS_WEIGHT_POSITIONAL ? i : current];
+      }
+      const float scale = weight * convert::cpu_half2float(scale_bias[0]);
+      const float bias = weight * convert::cpu_half2float(scale_bias[1]);
+
+      for (TIndex k = 0; k < block_size; ++k) {
+        const int quantized = (row[k / num_elem_per_byte] >>
+                               ((k % num_elem_per_byte) * bit_rate)) &
+            mask;
+        out[k] += scale * quantized + bias;
+      }
+
+      ++current;
+    }
+    if (normalize_by_lengths && lengths[m]) {
+      // hack: context is not really used
+      math::Scale<OutType, CPUContext>(
+          block_size, 1.f / lengths[m], out, out, nullptr);
+    }
+    out += block_size;
+  }
+  CAFFE_ENFORCE_EQ(
+      current,
+      index_size,
+      "Your input seems to be incorrect: the sum of lengths values should be "
+      "the size of the indices tensor, but it appears not.");
+}
+
+// Proxy back to generic implementation
+#define FUSED_NBIT_ROWWISE_EMBEDDING_SPECIALIZATION(                                              \
+    BitRate, IndexType, InType, OutType)                                                          \
+  void                                                                                            \
+      Fused##BitRate##BitRowwiseEmbeddingLookup_##IndexType##_##InType##_##OutType##_false__base( \
+          const TIndex block_size,                                                                \
+          const TIndex output_size,                                                               \
+          const TIndex index_size,                                                                \
+          const TIndex data_size,                                                                 \
+          const InType* input,                                                                    \
+          const IndexType* indices,                                                               \
+          const int* lengths,                                                                     \
+          const float* weights,                                                                   \
+          bool normalize_by_lengths,                                                              \
+          OutType* out,                                                                           \
+          const int prefetch_distance) {                                                          \
+    FusedNBitRowwiseEmbeddingLookupGenericSlow<                                                   \
+        IndexType,                                                                                \
+        InType,                                                                                   \
+        OutType,                                                                                  \
+        false>(                                                                                   \
+        BitRate,                                                                                  \
+        block_size,                                                                               \
+        output_size,                                                                              \
+        index_size,                                                                               \
+        data_size,                                                                                \
+        input,                                                                                    \
+        indices,                                                                                  \
+        lengths,                                                                                  \
+        weights,                                                                                  \
+        normalize_by_lengths,                                                                     \
+        out,                                                                                      \
+        prefetch_distance);                                                                       \
+  }                                                                                               \
+  static void Fused##BitRate##BitRowwiseEmbeddingLookup_##IndexType##_##InType##_##OutType(       \
+      const TIndex block_size,                                                                    \
+      const TIndex output_size,                                                                   \
+      const TIndex index_size,                                                                    \
+      const TIndex data_size,                                                                     \
+      const InType* input,                                                                        \
+      const IndexType* indices,                                                                   \
+      const int* lengths,                                                                         \
+      const float* weights,                                                                       \
+      bool normalize_by_lengths,                                                                  \
+      OutType* out) {                                                                             \
+    EmbeddingLookupPrefetch prefetch(                                                             \
+        data_size,                                                                                \
+        (block_size + 8 / BitRate - 1) / (8 / BitRate) + 4,                                       \
+        index_size);                                                                              \
+    AVX2_FMA_DO(                                                                                  \
+        Fused##BitRate##BitRowwiseEmbeddingLookup_##IndexType##_##InType##_##OutType##_false,     \
+        block_size,                                                                               \
+        output_size,                                                                              \
+        index_size,                                                                               \
+        data_size,                                                                                \
+        input,                                                                                    \
+        indices,                                                                                  \
+        lengths,                                                                                  \
+        weights,                                                                                  \
+        normalize_by_lengths,                                                                     \
+        out,                                                                                      \
+        prefetch.distance());                                                                     \
+    BASE_DO(                                                                                      \
+        Fused##BitRate##BitRowwiseEmbeddingLookup_##IndexType##_##InType##_##OutType##_false,     \
+        block_size,                                                                               \
+        output_size,                                                                              \
+        index_size,                                                                               \
+        data_size,                                                                                \
+        input,                                                                                    \
+        indices,                                                                                  \
+        lengths,                                                                                  \
+        weights,                                                                                  \
+        normalize_by_lengths,                                                                     \
+        out,                                                                                      \
+        prefetch.distance());                                                                     \
+  }
+
+FUSED_NBIT_ROWWISE_EMBEDDING_SPECIALIZATION(4, int32_t, uint8_t, float);
+FUSED_NBIT_ROWWISE_EMBEDDING_SPECIALIZATION(4, int64_t, uint8_t, float);
+FUSED_NBIT_ROWWISE_EMBEDDING_SPECIALIZATION(2, int32_t, uint8_t, float);
+FUSED_NBIT_ROWWISE_EMBEDDING_SPECIALIZATION(2, int64_t, uint8_t, float);
+
+#undef FUSED_NBIT_ROWWISE_EMBEDDING_SPECIALIZATION
+
+#define FUSED_NBIT_ROWWISE_EMBEDDING_DISPATCH(IndexType, InType, OutType)          \
+  template <>                                                                      \
+  void FusedNBitRowwiseEmbeddingLookup<IndexType, InType, OutType, false>(         \
+      const int bit_rate,                                                          \
+      const TIndex block_size,                                                     \
+      const TIndex output_size,                                                    \
+      const TIndex index_size,                                                     \
+      const TIndex data_size,                                                      \
+      const InType* input,                                                         \
+      const IndexType* indices,                                                    \
+      const int* lengths,                                                          \
+      const float* weights,                                                        \
+      bool normalize_by_lengths,                                                   \
+      OutType* out) {                                                              \
+    switch (bit_rate) {                                                            \
+      case 4:                                                                      \
+        return Fused4BitRowwiseEmbeddingLookup_##IndexType##_##InType##_##OutType( \
+            block_size,                                                            \
+            output_size,                                                           \
+            index_size,                                                            \
+            data_size,                                                             \
+            input,                                                                 \
+            indices,                                                               \
+            lengths,                                                               \
+            weights,                                                               \
+            normalize_by_lengths,                                                  \
+            out);                                                                  \
+      case 2:                                                                      \
+        return Fused2BitRowwiseEmbeddingLookup_##IndexType##_##InType##_##OutType( \
+            block_size,                                                            \
+            output_size,                                                           \
+            index_size,                                                            \
+            data_size,                                                             \
+            input,                                                                 \
+            indices,                                                               \
+            lengths,                                                               \
+            weights,                                                               \
+            normalize_by_lengths,                                                  \
+            out);                                                                  \
+      default:                                                                     \
+        CAFFE_THROW("Unsupported bit rate ", bit_rate);                            \
+    }                                                                              \
+  }
+
+FUSED_NBIT_ROWWISE_EMBEDDING_DISPATCH(int32_t, uint8_t, float);
+FUSED_NBIT_ROWWISE_EMBEDDING_DISPATCH(int64_t, uint8_t, float);
+
+#undef FUSED_NBIT_ROWWISE_EMBEDDING_DISPATCH
+
+} // namespace caffe2
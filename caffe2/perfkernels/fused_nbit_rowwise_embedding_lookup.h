@@ -0,0 +1,58 @@
+#pragma once
+
+#include "caffe2/core/common.h"
+
+namespace caffe2 {
+
+/**
+ * Embedding lookup with reduction on fused N-bit rowwise quantized tables.
+ *
+ * `input` of size data_size * (ceil(block_size / (8 / bit_rate)) + 4B)
+ * `indices` of size index_size
+ * `lengths` of size output_size
+ * `weights` nullptr or array of size index_size
+ * `out` of size output_size * block_size
+ * sum(lengths[i]) == index_size
+ *
+ * bit_rate is 4 or 2. Each byte of a row packs 8 / bit_rate quantized values,
+ * element k in bits [(k % (8 / bit_rate)) * bit_rate, ...) of byte
+ * k / (8 / bit_rate). The packed values are followed by the scale and the
+ * bias of the row as 16-bit floats, 2 bytes each.
+ *
+ * Behavior is roughly equivalent to pseudocode:
+ *
+ * pos = 0
+ * for (i = 0..index_size-1)
+ *   for (k = 0..block_size-1)
+ *     out[i*block_size + k] = 0
+ *   for (j = 0..lengths[i]-1)
+ *     row = indices[pos]
+ *     for (k = 0..block_size-1)
+ *       out[i*block_size + k] +=
+ *           (scale[row] * value(row, k) + bias[row]) *
+ *           (weights ? weights[IS_WEIGHT_POSITIONAL ? j : pos] : 1.0)
+ *     pos += 1
+ *   if (normalize_weights && lengths[i] > 0)
+ *     for (k = 0..block_size-1)
+ *       out[i*block_size + k] /= lengths[i]
+ *
+ */
+
+template <
+    typename IndexType,
+    typename InType,
+    typename OutType,
+    bool IS_WEIGHT_POSITIONAL = false>
+void FusedNBitRowwiseEmbeddingLookup(
+    const int bit_rate,
+    const TIndex block_size,
+    const TIndex output_size,
+    const TIndex index_size,
+    const TIndex data_size,
+    const InType* input,
+    const IndexType* indices,
+    const int* lengths,
+    const float* weights, // optional, can be null for non-weighted sum
+    bool normalize_by_lengths,
+    OutType* out);
+} // namespace caffe2
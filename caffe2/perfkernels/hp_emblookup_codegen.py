@@ -8,11 +8,57 @@ import sys
 sizeof = {'float': 4, 'float16': 2, 'uint8_t': 1}
 
 
-def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused):
+# Loads 8 bit_rate-bit values starting at byte ptr of a fused n-bit rowwise
+# row and converts them to a __m256. The packed bytes are duplicated into the
+# 32-bit lanes with vshuffle, and each lane is shifted by vshift and masked by
+# vmask to extract its value.
+def nbit_load(bit_rate, ptr):
+    load_type = {4: "int32_t", 2: "uint16_t"}[bit_rate]
+    return (
+        "_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srlv_epi32("
+        "_mm256_cvtepu8_epi32(_mm_shuffle_epi8(_mm_cvtsi32_si128("
+        "*reinterpret_cast<const {}*>({})), vshuffle)), vshift), vmask))".format(
+            load_type, ptr)
+    )
+
+
+def nbit_constants(bit_rate):
+    elems_per_byte = 8 // bit_rate
+    shuffle = [i // elems_per_byte for i in range(8)] + [-1] * 8
+    shift = [(i % elems_per_byte) * bit_rate for i in range(8)]
+    return [
+        "const __m128i vshuffle = _mm_setr_epi8({});".format(
+            ", ".join(str(i) for i in shuffle)),
+        "const __m256i vshift = _mm256_setr_epi32({});".format(
+            ", ".join(str(i) for i in shift)),
+        "const __m256i vmask = _mm256_set1_epi32({});".format(
+            (1 << bit_rate) - 1),
+    ]
+
+
+def nbit_scale_bias(bit_rate):
+    elems_per_byte = 8 // bit_rate
+    return [
+        'const float16* scale_bias = reinterpret_cast<const float16*>('
+        '&input[idx * fused_block_size + (block_size + {}) / {}]);'.format(
+            elems_per_byte - 1, elems_per_byte),
+        "bio = wgt * _cvtsh_ss(scale_bias[1].x);",
+        "wgt = wgt * _cvtsh_ss(scale_bias[0].x);",
+    ]
+
+
+def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused,
+           bit_rate=None):
     def compute(regid, InType, use_weights, isa, prefetch):
         code = []
 
-        if InType == "float":
+        if bit_rate:
+            code.append(
+                "vop%d = _mm256_fmadd_ps(vwgt, %s, _mm256_add_ps(vop%d, vbio));"
+                % (regid, nbit_load(bit_rate, "ip + (%d)" % (regid * bit_rate // 8)),
+                   regid)
+            )
+        elif InType == "float":
             code.append(
                 "vop%d = _mm256_fmadd_ps(vwgt,  \
                   _mm256_loadu_ps(ip + (%d)), vop%d);"
@@ -35,10 +81,11 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused):
         else:
             assert False
 
+        offset = regid * bit_rate // 8 if bit_rate else regid
         if prefetch:
-            code.append("_mm_prefetch((&ip_next_T0[%d]), _MM_HINT_T0);" % (regid))
+            code.append("_mm_prefetch((&ip_next_T0[%d]), _MM_HINT_T0);" % (offset))
         else:
-            code.append("// skip unnecessary prefetch of (&ip_next_T0[%d])" % (regid))
+            code.append("// skip unnecessary prefetch of (&ip_next_T0[%d])" % (offset))
 
         return code
 
@@ -67,7 +114,9 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused):
         code.append(
             "wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];")
         code.append("}")
-        if fused:
+        if bit_rate:
+            code.extend(nbit_scale_bias(bit_rate))
+        elif fused:
             code.append(
                 'const float* scale_bias = reinterpret_cast<'
                 'const float*>(&input[idx * fused_block_size + block_size]);'
@@ -103,7 +152,7 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused):
     for i in range(0, uf):
         j = 8 * i
         cachelinesize = 64
-        byteoffset = sizeof[InType] * j
+        byteoffset = j * bit_rate // 8 if bit_rate else sizeof[InType] * j
         prefetch = (byteoffset % cachelinesize) == 0
         code.extend(compute(j, InType, use_weights, isa, prefetch))
     code.append("}")
@@ -127,11 +176,22 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused):
     return code
 
 
-def generic(IndexType, InType, OutType, use_weights, isa, fused):
+def generic(IndexType, InType, OutType, use_weights, isa, fused,
+            bit_rate=None):
 
     def compute(InType, use_weights, isa):
         code = []
-        if InType == "float":
+        if bit_rate:
+            code.append(
+                "_mm256_storeu_ps(&op[j], \
+                   _mm256_fmadd_ps(vwgt, %s, \
+                     _mm256_add_ps(_mm256_loadu_ps(&op[j]), vbio) ) \
+                                   );"
+                % nbit_load(bit_rate, "&ip[j / %d]" % (8 // bit_rate))
+            )
+            code.append("_mm_prefetch((&ip_next_T0[j / %d]), _MM_HINT_T0);" % (8 // bit_rate))
+            return code
+        elif InType == "float":
             code.append(
                 "_mm256_storeu_ps(&op[j], \
                                  _mm256_fmadd_ps(vwgt,_mm256_loadu_ps(&ip[j]), _mm256_loadu_ps(&op[j])) \
@@ -189,7 +249,9 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused):
         code.append(
             "wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];")
         code.append("}")
-        if fused:
+        if bit_rate:
+            code.extend(nbit_scale_bias(bit_rate))
+        elif fused:
             code.append(
                 'const float* scale_bias = reinterpret_cast<'
                 'const float*>(&input[idx * fused_block_size + block_size]);'
@@ -237,6 +299,10 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused):
         code.append("vtmp1[0] = ip[j];")
         code.append("__m256 vtmp2 = _mm256_cvtph_ps(*((__m128i*)vtmp1));")
         code.append("op[j] += wgt * ((float*)(&vtmp2))[0];")
+    elif bit_rate:
+        code.append(
+            "op[j] += wgt * ((ip[j / {0}] >> ((j % {0}) * {1})) & {2}) + bio;".format(
+                8 // bit_rate, bit_rate, (1 << bit_rate) - 1))
     elif InType == "uint8_t":
         code.append("op[j] += wgt * ((float)ip[j]) + bio;")
     else:
@@ -268,9 +334,15 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused):
 parser = argparse.ArgumentParser()
 parser.add_argument('-f', '--filename', help="file name")
 parser.add_argument('--fused', action='store_true')
+parser.add_argument('--fused-nbit', action='store_true',
+                    help="fused 4-bit and 2-bit rowwise quantized tables")
 opts = parser.parse_args()
+# the n-bit tables are fused as well, with fp16 scale and bias
+opts.fused = opts.fused or opts.fused_nbit
 if opts.filename:
     filename = opts.filename
+elif opts.fused_nbit:
+    filename = "embedding_lookup_fused_nbit_rowwise_avx2.cc"
 elif opts.fused:
     filename = "embedding_lookup_fused_8bit_rowwise_avx2.cc"
 else:
@@ -283,6 +355,12 @@ options = [["int32_t", "float", "float"],
            ["int64_t", "float16", "float"],
            ["int32_t", "uint8_t", "float"],
            ["int64_t", "uint8_t", "float"]]
+# the n-bit tables are stored as uint8_t, the last entry is the bit rate
+if opts.fused_nbit:
+    options = [["int32_t", "uint8_t", "float", 4],
+               ["int64_t", "uint8_t", "float", 4],
+               ["int32_t", "uint8_t", "float", 2],
+               ["int64_t", "uint8_t", "float", 2]]
 
 code = []
 # includes
@@ -296,13 +374,19 @@ code.append("//// --------------------------\n\n")
 code.append("#include <caffe2/core/types.h>")
 code.append("#include <caffe2/core/common.h>")
 code.append("#include <immintrin.h>")
+if opts.fused_nbit:
+    code.append("#include <caffe2/perfkernels/cvtsh_ss_bugfix.h>")
 code.append("\n")
 
 code.append("namespace caffe2 {\n")
 for o in options:
-    [IndexType, InType, OutType] = o
+    [IndexType, InType, OutType] = o[:3]
+    bit_rate = o[3] if opts.fused_nbit else None
 
-    prefix = 'Fused8BitRowwise' if opts.fused else ''
+    if bit_rate:
+        prefix = 'Fused{}BitRowwise'.format(bit_rate)
+    else:
+        prefix = 'Fused8BitRowwise' if opts.fused else ''
     code.append('template <bool IS_WEIGHT_POSITIONAL>')
     fn_base = '{}EmbeddingLookup_{}_{}_{}'.format(
         prefix, IndexType, InType, OutType
@@ -323,18 +407,28 @@ for o in options:
     if not opts.fused:
         args.append("const float* scale_bias,")
     args.append("bool normalize_by_lengths,")
-    args.append(OutType + "* out)")
+    args.append(OutType + "* out,")
+    # in indices, chosen by EmbeddingLookupPrefetch at runtime
+    args.append("const int prefdist_T0)")
     code += args
 
     code.append("{")
-    code.append("const " + IndexType + " prefdist_T0 = 16;")
     # block_size is the number of elements and fused_block_size is the size of
     # an entire row, including scale and bias.
-    offset = (8 // sizeof[InType]) if opts.fused else 0
-    code.append(
-        "const {} fused_block_size = block_size + {};".
-        format(IndexType, offset)
-    )
+    if bit_rate:
+        # packed values, then 2 bytes of scale and 2 bytes of bias
+        elems_per_byte = 8 // bit_rate
+        code.append(
+            "const {} fused_block_size = (block_size + {}) / {} + 4;".
+            format(IndexType, elems_per_byte - 1, elems_per_byte)
+        )
+        code += nbit_constants(bit_rate)
+    else:
+        offset = (8 // sizeof[InType]) if opts.fused else 0
+        code.append(
+            "const {} fused_block_size = block_size + {};".
+            format(IndexType, offset)
+        )
 
     #code.append("printf(\"calling " + fn + "\\n\");");
     if not opts.fused:
@@ -350,16 +444,21 @@ for o in options:
             )
 
     code.append("if (block_size == 128) {")
-    code += unroll(16, IndexType, InType, OutType, True, "AVX2", opts.fused)
+    code += unroll(16, IndexType, InType, OutType, True, "AVX2", opts.fused,
+                   bit_rate)
     code.append("} else if (block_size == 64) {")
-    code += unroll(8, IndexType, InType, OutType, True, "AVX2", opts.fused)
+    code += unroll(8, IndexType, InType, OutType, True, "AVX2", opts.fused,
+                   bit_rate)
     code.append("} else if (block_size == 32) {")
-    code += unroll(4, IndexType, InType, OutType, True, "AVX2", opts.fused)
+    code += unroll(4, IndexType, InType, OutType, True, "AVX2", opts.fused,
+                   bit_rate)
     code.append("} else if (block_size == 16) {")
-    code += unroll(2, IndexType, InType, OutType, True, "AVX2", opts.fused)
+    code += unroll(2, IndexType, InType, OutType, True, "AVX2", opts.fused,
+                   bit_rate)
     code.append("} else {")
     code.append("// generic code")
-    code += generic(IndexType, InType, OutType, True, "AVX2", opts.fused)
+    code += generic(IndexType, InType, OutType, True, "AVX2", opts.fused,
+                    bit_rate)
     code.append("}")
 
     code.append("}")
@@ -381,7 +480,8 @@ for o in options:
         if not opts.fused:
             code.append("scale_bias,")
         code.append("normalize_by_lengths,")
-        code.append("out);")
+        code.append("out,")
+        code.append("prefdist_T0);")
         code.append("}")
 
     code.append("\n")
@@ -0,0 +1,166 @@
+#include "caffe2/perfkernels/int8_gemm.h"
+
+#include <cmath>
+
+#include "caffe2/core/logging.h"
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+void PackInt8Matrix(
+    int N,
+    int K,
+    const uint8_t* B,
+    int ldb,
+    int32_t zero_point,
+    PackedInt8Matrix* packed) {
+  CAFFE_ENFORCE_LT(K, 1 << 15, "K is too large for int32 accumulation");
+  packed->N = N;
+  packed->K = K;
+  const int num_pairs = packed->num_pairs();
+  packed->data.assign(
+      packed->num_blocks() * num_pairs * kInt8GemmBlockN * 2, 0);
+  for (int n = 0; n < N; ++n) {
+    int16_t* block = packed->data.data() +
+        (n / kInt8GemmBlockN) * num_pairs * kInt8GemmBlockN * 2;
+    for (int k = 0; k < K; ++k) {
+      block[((k / 2) * kInt8GemmBlockN + n % kInt8GemmBlockN) * 2 + k % 2] =
+          static_cast<int16_t>(B[n * ldb + k]) - zero_point;
+    }
+  }
+}
+
+void QuantizeMultiplierSmallerThanOne(
+    double real_multiplier,
+    int32_t* multiplier,
+    int* shift) {
+  CAFFE_ENFORCE(
+      real_multiplier > 0 && real_multiplier < 1,
+      "The requantization multiplier must be in (0, 1), got ",
+      real_multiplier);
+  int exponent;
+  const double q = std::frexp(real_multiplier, &exponent);
+  int64_t q_fixed = static_cast<int64_t>(std::round(q * (1ll << 31)));
+  if (q_fixed == (1ll << 31)) {
+    q_fixed /= 2;
+    ++exponent;
+  }
+  *shift = -exponent;
+  // Multipliers below 2^-31 round every accumulator of the GEMM to zero
+  if (*shift > 31) {
+    *shift = 31;
+    q_fixed = 0;
+  }
+  *multiplier = static_cast<int32_t>(q_fixed);
+}
+
+namespace {
+
+// Accumulates the blocks of every row of A with the packed B, and passes
+// them to epilogue(m, n_begin, n_end, acc)
+template <typename Epilogue>
+void Int8GemmBlocks(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t A_zero_point,
+    const PackedInt8Matrix& B,
+    Epilogue epilogue) {
+  const int K = B.K;
+  const int num_pairs = B.num_pairs();
+  int32_t acc[kInt8GemmBlockN];
+  for (int m = 0; m < M; ++m) {
+    const uint8_t* a = A + m * lda;
+    for (int nb = 0; nb < B.num_blocks(); ++nb) {
+      const int16_t* block =
+          B.data.data() + nb * num_pairs * kInt8GemmBlockN * 2;
+      std::fill(acc, acc + kInt8GemmBlockN, 0);
+      for (int k = 0; k < K; ++k) {
+        const int32_t value = static_cast<int32_t>(a[k]) - A_zero_point;
+        const int16_t* b = block + (k / 2) * kInt8GemmBlockN * 2 + k % 2;
+        for (int j = 0; j < kInt8GemmBlockN; ++j) {
+          acc[j] += value * b[j * 2];
+        }
+      }
+      const int n_begin = nb * kInt8GemmBlockN;
+      epilogue(m, n_begin, std::min(n_begin + kInt8GemmBlockN, B.N), acc);
+    }
+  }
+}
+
+} // namespace
+
+void Int8Gemm__base(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t A_zero_point,
+    const PackedInt8Matrix& B,
+    const Int8GemmOutputStage& output,
+    uint8_t* C,
+    int ldc) {
+  Int8GemmBlocks(
+      M,
+      A,
+      lda,
+      A_zero_point,
+      B,
+      [&](int m, int n_begin, int n_end, const int32_t* acc) {
+        for (int n = n_begin; n < n_end; ++n) {
+          const int32_t bias = output.bias ? output.bias[n] : 0;
+          C[m * ldc + n] = Int8Requantize(acc[n - n_begin] + bias, output);
+        }
+      });
+}
+
+void Int8GemmFloat__base(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t A_zero_point,
+    const PackedInt8Matrix& B,
+    const Int8GemmFloatOutputStage& output,
+    float* C,
+    int ldc) {
+  Int8GemmBlocks(
+      M,
+      A,
+      lda,
+      A_zero_point,
+      B,
+      [&](int m, int n_begin, int n_end, const int32_t* acc) {
+        for (int n = n_begin; n < n_end; ++n) {
+          const float bias = output.bias ? output.bias[n] : 0.0f;
+          C[m * ldc + n] = output.scale * acc[n - n_begin] + bias;
+        }
+      });
+}
+
+void Int8Gemm(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t A_zero_point,
+    const PackedInt8Matrix& B,
+    const Int8GemmOutputStage& output,
+    uint8_t* C,
+    int ldc) {
+  AVX2_DO(Int8Gemm, M, A, lda, A_zero_point, B, output, C, ldc);
+  BASE_DO(Int8Gemm, M, A, lda, A_zero_point, B, output, C, ldc);
+}
+
+void Int8GemmFloat(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t A_zero_point,
+    const PackedInt8Matrix& B,
+    const Int8GemmFloatOutputStage& output,
+    float* C,
+    int ldc) {
+  AVX2_DO(Int8GemmFloat, M, A, lda, A_zero_point, B, output, C, ldc);
+  BASE_DO(Int8GemmFloat, M, A, lda, A_zero_point, B, output, C, ldc);
+}
+
+} // namespace caffe2
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace caffe2 {
+
+// Columns of B in a block of the packed matrix, i.e. the int32 lanes of an
+// AVX2 register
+constexpr int kInt8GemmBlockN = 8;
+
+/**
+ * The N x K uint8 matrix B of an int8 GEMM minus its zero point, packed once.
+ * Values are stored as int16 in blocks of kInt8GemmBlockN rows of B, with
+ * the values of the block for k and k + 1 interleaved, so that the kernel
+ * multiplies a pair of values of A with a whole block in one vpmaddwd. K is
+ * padded to an even size and N to a whole block with zeros.
+ */
+struct PackedInt8Matrix {
+  int N{0};
+  int K{0};
+  std::vector<int16_t> data;
+
+  int num_blocks() const {
+    return (N + kInt8GemmBlockN - 1) / kInt8GemmBlockN;
+  }
+  int num_pairs() const {
+    return (K + 1) / 2;
+  }
+};
+
+void PackInt8Matrix(
+    int N,
+    int K,
+    const uint8_t* B,
+    int ldb,
+    int32_t zero_point,
+    PackedInt8Matrix* packed);
+
+/**
+ * Requantization of the int32 accumulators in the epilogue of the GEMM:
+ * the accumulator plus the bias is multiplied by the real multiplier
+ * multiplier * 2^-(31 + shift), rounded, offset by the zero point of the
+ * output and clamped to [min, max].
+ */
+struct Int8GemmOutputStage {
+  // Bias of size N, or nullptr
+  const int32_t* bias{nullptr};
+  int32_t multiplier{0};
+  int shift{0};
+  int32_t zero_point{0};
+  uint8_t min{0};
+  uint8_t max{255};
+};
+
+// Fixed point multiplier and right shift of a real multiplier in (0, 1)
+void QuantizeMultiplierSmallerThanOne(
+    double real_multiplier,
+    int32_t* multiplier,
+    int* shift);
+
+// acc * multiplier * 2^-31, rounded to the nearest, as gemmlowp does
+inline int32_t Int8SaturatingRoundingDoublingHighMul(
+    int32_t acc,
+    int32_t multiplier) {
+  const bool overflow =
+      acc == multiplier && acc == std::numeric_limits<int32_t>::min();
+  const int64_t ab = static_cast<int64_t>(acc) * multiplier;
+  const int32_t nudge = ab >= 0 ? (1 << 30) : (1 - (1 << 30));
+  const int32_t high = static_cast<int32_t>((ab + nudge) / (1ll << 31));
+  return overflow ? std::numeric_limits<int32_t>::max() : high;
+}
+
+// value * 2^-shift, rounded to the nearest with ties away from zero
+inline int32_t Int8RoundingDivideByPOT(int32_t value, int shift) {
+  const int32_t mask = (1ll << shift) - 1;
+  const int32_t remainder = value & mask;
+  const int32_t threshold = (mask >> 1) + (value < 0 ? 1 : 0);
+  return (value >> shift) + (remainder > threshold ? 1 : 0);
+}
+
+inline uint8_t Int8Requantize(int32_t acc, const Int8GemmOutputStage& output) {
+  const int32_t high =
+      Int8SaturatingRoundingDoublingHighMul(acc, output.multiplier);
+  const int32_t value =
+      output.zero_point + Int8RoundingDivideByPOT(high, output.shift);
+  return static_cast<uint8_t>(std::min<int32_t>(
+      std::max<int32_t>(value, output.min), output.max));
+}
+
+/**
+ * Computes the quantized M x N matrix
+ * C[m][n] = requantize(bias[n] + sum_k (A[m][k] - A_zero_point) * B'[n][k])
+ * where B' is the packed matrix, i.e. B minus its zero point. The products
+ * are accumulated exactly in int32 for any K below 2^15.
+ */
+void Int8Gemm(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t A_zero_point,
+    const PackedInt8Matrix& B,
+    const Int8GemmOutputStage& output,
+    uint8_t* C,
+    int ldc);
+
+/**
+ * Dequantization of the int32 accumulators in the epilogue of Int8GemmFloat:
+ * the accumulator is multiplied by scale, i.e. the product of the scales of
+ * A and B, and the bias is added in fp32.
+ */
+struct Int8GemmFloatOutputStage {
+  // Bias of size N, or nullptr
+  const float* bias{nullptr};
+  float scale{1.0f};
+};
+
+// Int8Gemm with the fp32 output
+// C[m][n] = bias[n] + scale * sum_k (A[m][k] - A_zero_point) * B'[n][k]
+void Int8GemmFloat(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t A_zero_point,
+    const PackedInt8Matrix& B,
+    const Int8GemmFloatOutputStage& output,
+    float* C,
+    int ldc);
+
+} // namespace caffe2
@@ -0,0 +1,203 @@
+#include "caffe2/perfkernels/int8_gemm.h"
+
+#include <immintrin.h>
+#include <cstring>
+
+namespace caffe2 {
+
+namespace {
+
+// Rows of A sharing the loads of a block of B
+constexpr int kInt8GemmRows = 4;
+
+// Rows of A as int16 minus the zero point, padded with zeros to an even K
+void ConvertRows(
+    int rows,
+    const uint8_t* A,
+    int lda,
+    int K,
+    int padded_K,
+    int32_t zero_point,
+    int16_t* buffer) {
+  const __m256i zero_point_v = _mm256_set1_epi16(zero_point);
+  for (int r = 0; r < rows; ++r) {
+    const uint8_t* a = A + r * lda;
+    int16_t* row = buffer + r * padded_K;
+    int k = 0;
+    for (; k + 16 <= K; k += 16) {
+      const __m256i values = _mm256_cvtepu8_epi16(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + k)));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(row + k),
+          _mm256_sub_epi16(values, zero_point_v));
+    }
+    for (; k < K; ++k) {
+      row[k] = static_cast<int16_t>(a[k]) - zero_point;
+    }
+    for (; k < padded_K; ++k) {
+      row[k] = 0;
+    }
+  }
+}
+
+// Multiplies rows of A with a block of B: a pair of values of a row is
+// broadcast and multiplied with the pairs of the block by vpmaddwd, which
+// adds the two products of every column
+template <int Rows>
+void Int8GemmBlock(
+    const int16_t* a,
+    int padded_K,
+    const int16_t* block,
+    int num_pairs,
+    __m256i* acc) {
+  for (int r = 0; r < Rows; ++r) {
+    acc[r] = _mm256_setzero_si256();
+  }
+  for (int p = 0; p < num_pairs; ++p) {
+    const __m256i b = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(block + p * kInt8GemmBlockN * 2));
+    for (int r = 0; r < Rows; ++r) {
+      int32_t pair;
+      std::memcpy(&pair, a + r * padded_K + p * 2, sizeof(pair));
+      acc[r] = _mm256_add_epi32(
+          acc[r], _mm256_madd_epi16(_mm256_set1_epi32(pair), b));
+    }
+  }
+}
+
+// Accumulates tiles of up to kInt8GemmRows rows of A and a block of the
+// packed B, and passes them to epilogue(m_begin, rows, n_begin, n_end, acc)
+// while they are in registers
+template <typename Epilogue>
+void Int8GemmTiles(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t A_zero_point,
+    const PackedInt8Matrix& B,
+    Epilogue epilogue) {
+  const int num_pairs = B.num_pairs();
+  const int padded_K = num_pairs * 2;
+  std::vector<int16_t> rows_buffer(kInt8GemmRows * padded_K);
+  __m256i acc[kInt8GemmRows];
+
+  for (int m_begin = 0; m_begin < M; m_begin += kInt8GemmRows) {
+    const int rows = std::min(kInt8GemmRows, M - m_begin);
+    ConvertRows(
+        rows,
+        A + m_begin * lda,
+        lda,
+        B.K,
+        padded_K,
+        A_zero_point,
+        rows_buffer.data());
+    for (int nb = 0; nb < B.num_blocks(); ++nb) {
+      const int16_t* block =
+          B.data.data() + nb * num_pairs * kInt8GemmBlockN * 2;
+      switch (rows) {
+        case 4:
+          Int8GemmBlock<4>(
+              rows_buffer.data(), padded_K, block, num_pairs, acc);
+          break;
+        case 3:
+          Int8GemmBlock<3>(
+              rows_buffer.data(), padded_K, block, num_pairs, acc);
+          break;
+        case 2:
+          Int8GemmBlock<2>(
+              rows_buffer.data(), padded_K, block, num_pairs, acc);
+          break;
+        default:
+          Int8GemmBlock<1>(
+              rows_buffer.data(), padded_K, block, num_pairs, acc);
+          break;
+      }
+      const int n_begin = nb * kInt8GemmBlockN;
+      const int n_end = std::min(n_begin + kInt8GemmBlockN, B.N);
+      epilogue(m_begin, rows, n_begin, n_end, acc);
+    }
+  }
+}
+
+// The values of a bias for the columns [n_begin, n_end) of a block, padded
+// with zeros
+template <typename T>
+void LoadBlockBias(const T* bias, int n_begin, int n_end, T* block_bias) {
+  std::fill(block_bias, block_bias + kInt8GemmBlockN, T(0));
+  if (bias) {
+    std::copy(bias + n_begin, bias + n_end, block_bias);
+  }
+}
+
+} // namespace
+
+void Int8Gemm__avx2(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t A_zero_point,
+    const PackedInt8Matrix& B,
+    const Int8GemmOutputStage& output,
+    uint8_t* C,
+    int ldc) {
+  alignas(32) int32_t bias[kInt8GemmBlockN];
+  alignas(32) int32_t values[kInt8GemmBlockN];
+  Int8GemmTiles(
+      M,
+      A,
+      lda,
+      A_zero_point,
+      B,
+      [&](int m_begin, int rows, int n_begin, int n_end, const __m256i* acc) {
+        // Requantizes the tile
+        LoadBlockBias(output.bias, n_begin, n_end, bias);
+        const __m256i bias_v =
+            _mm256_load_si256(reinterpret_cast<const __m256i*>(bias));
+        for (int r = 0; r < rows; ++r) {
+          _mm256_store_si256(
+              reinterpret_cast<__m256i*>(values),
+              _mm256_add_epi32(acc[r], bias_v));
+          uint8_t* c = C + (m_begin + r) * ldc;
+          for (int n = n_begin; n < n_end; ++n) {
+            c[n] = Int8Requantize(values[n - n_begin], output);
+          }
+        }
+      });
+}
+
+void Int8GemmFloat__avx2(
+    int M,
+    const uint8_t* A,
+    int lda,
+    int32_t A_zero_point,
+    const PackedInt8Matrix& B,
+    const Int8GemmFloatOutputStage& output,
+    float* C,
+    int ldc) {
+  alignas(32) float bias[kInt8GemmBlockN];
+  alignas(32) float values[kInt8GemmBlockN];
+  const __m256 scale_v = _mm256_set1_ps(output.scale);
+  Int8GemmTiles(
+      M,
+      A,
+      lda,
+      A_zero_point,
+      B,
+      [&](int m_begin, int rows, int n_begin, int n_end, const __m256i* acc) {
+        LoadBlockBias(output.bias, n_begin, n_end, bias);
+        const __m256 bias_v = _mm256_load_ps(bias);
+        for (int r = 0; r < rows; ++r) {
+          const __m256 value = _mm256_add_ps(
+              _mm256_mul_ps(_mm256_cvtepi32_ps(acc[r]), scale_v), bias_v);
+          float* c = C + (m_begin + r) * ldc;
+          if (n_end - n_begin == kInt8GemmBlockN) {
+            _mm256_storeu_ps(c + n_begin, value);
+          } else {
+            _mm256_store_ps(values, value);
+            std::copy(values, values + n_end - n_begin, c + n_begin);
+          }
+        }
+      });
+}
+
+} // namespace caffe2
@@ -0,0 +1,90 @@
+#include "caffe2/perfkernels/stochastic_rounding.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/conversions.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+StochasticRoundingRNG::StochasticRoundingRNG(uint32_t seed) {
+  // splitmix32 of the seed, so that every generator starts from a different
+  // nonzero state
+  for (int i = 0; i < 8; ++i) {
+    uint32_t z = seed + (i + 1) * 0x9e3779b9u;
+    z = (z ^ (z >> 16)) * 0x85ebca6bu;
+    z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+    z ^= z >> 16;
+    state[i] = z ? z : 1;
+  }
+}
+
+namespace {
+
+// fp32 to fp16, rounding towards zero
+uint16_t float_to_half_rtz(float f) {
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  const uint16_t sign = (bits >> 16) & 0x8000;
+  const uint32_t abs = bits & 0x7fffffff;
+  if (abs > 0x7f800000) { // NaN
+    return sign | 0x7e00;
+  }
+  if (abs == 0x7f800000) { // Inf
+    return sign | 0x7c00;
+  }
+  if (abs >= 0x477fe000) { // >= 65504, the largest finite fp16 value
+    return sign | 0x7bff;
+  }
+  if (abs < 0x38800000) { // < 2^-14, subnormal in fp16
+    // exact power of 2 scaling, and the conversion truncates
+    return sign | static_cast<uint16_t>(std::fabs(f) * 16777216.0f);
+  }
+  const uint32_t exponent = (abs >> 23) - 127 + 15;
+  return sign | (exponent << 10) | ((abs >> 13) & 0x3ff);
+}
+
+} // namespace
+
+void Float16AxpyStochasticRounding__base(
+    int N,
+    const float a,
+    const float* x,
+    float16* y,
+    StochasticRoundingRNG* rng) {
+  for (int i = 0; i < N; ++i) {
+    uint32_t& s = rng->state[i % 8];
+    if (i % 8 == 0) {
+      // advance all the generators at the start of each block of 8, as the
+      // vectorized versions do
+      for (int k = 0; k < 8; ++k) {
+        uint32_t& t = rng->state[k];
+        t ^= t << 13;
+        t ^= t >> 17;
+        t ^= t << 5;
+      }
+    }
+    const float u = (s >> 8) * (1.0f / (1 << 24));
+
+    const float v = convert::cpu_half2float(y[i]) + a * x[i];
+    float16 lo{float_to_half_rtz(v)};
+    const float16 hi{static_cast<uint16_t>(lo.x + 1)};
+    const float lo_f = convert::cpu_half2float(lo);
+    const float hi_f = convert::cpu_half2float(hi);
+    y[i] = std::fabs(v - lo_f) > u * std::fabs(hi_f - lo_f) ? hi : lo;
+  }
+}
+
+void Float16AxpyStochasticRounding(
+    int N,
+    const float a,
+    const float* x,
+    float16* y,
+    StochasticRoundingRNG* rng) {
+  AVX2_FMA_DO(Float16AxpyStochasticRounding, N, a, x, y, rng);
+  BASE_DO(Float16AxpyStochasticRounding, N, a, x, y, rng);
+}
+
+} // namespace caffe2
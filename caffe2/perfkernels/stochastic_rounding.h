@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+/**
+ * Random number generator of the stochastic rounding kernels: 8 xorshift32
+ * generators, where element i of a call uses generator i % 8. A kernel call
+ * advances every generator once per 8 elements, so the random numbers only
+ * depend on the seed and the sequence of calls, not on the implementation
+ * that runs them.
+ */
+struct StochasticRoundingRNG {
+  explicit StochasticRoundingRNG(uint32_t seed);
+  uint32_t state[8];
+};
+
+/**
+ * Computes y[i] + a * x[i] in fp32 for i in [0, N), and writes it back to
+ * the fp16 y[i] with stochastic rounding: a value v between the adjacent fp16
+ * values lo and hi is rounded to hi with probability (v - lo) / (hi - lo),
+ * so that the rounding is unbiased, and updates that are smaller than half
+ * the fp16 spacing of y[i] aren't lost on average.
+ *
+ * Values that are exact in fp16, infinities and NaNs aren't changed by the
+ * rounding, and finite values beyond the fp16 range are rounded to the
+ * largest finite fp16 value.
+ */
+void Float16AxpyStochasticRounding(
+    int N,
+    const float a,
+    const float* x,
+    float16* y,
+    StochasticRoundingRNG* rng);
+
+} // namespace caffe2
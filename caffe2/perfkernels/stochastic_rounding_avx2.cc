@@ -0,0 +1,73 @@
+#include "caffe2/perfkernels/stochastic_rounding.h"
+
+#include <algorithm>
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+namespace {
+
+// y[0:8] = stochastic_round(y[0:8] + a * x[0:8])
+inline void axpy8(
+    __m256 a,
+    const float* x,
+    float16* y,
+    __m256i* state) {
+  __m256i s = *state;
+  s = _mm256_xor_si256(s, _mm256_slli_epi32(s, 13));
+  s = _mm256_xor_si256(s, _mm256_srli_epi32(s, 17));
+  s = _mm256_xor_si256(s, _mm256_slli_epi32(s, 5));
+  *state = s;
+  const __m256 u = _mm256_mul_ps(
+      _mm256_cvtepi32_ps(_mm256_srli_epi32(s, 8)),
+      _mm256_set1_ps(1.0f / (1 << 24)));
+
+  const __m256 v = _mm256_fmadd_ps(
+      a,
+      _mm256_loadu_ps(x),
+      _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(y))));
+  const __m128i lo = _mm256_cvtps_ph(v, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+  const __m128i hi = _mm_add_epi16(lo, _mm_set1_epi16(1));
+  const __m256 lo_f = _mm256_cvtph_ps(lo);
+  const __m256 hi_f = _mm256_cvtph_ps(hi);
+
+  const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+  const __m256 up = _mm256_cmp_ps(
+      _mm256_and_ps(_mm256_sub_ps(v, lo_f), abs_mask),
+      _mm256_mul_ps(u, _mm256_and_ps(_mm256_sub_ps(hi_f, lo_f), abs_mask)),
+      _CMP_GT_OQ);
+  const __m256i up32 = _mm256_castps_si256(up);
+  const __m128i up16 = _mm_packs_epi32(
+      _mm256_castsi256_si128(up32), _mm256_extracti128_si256(up32, 1));
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(y), _mm_blendv_epi8(lo, hi, up16));
+}
+
+} // namespace
+
+void Float16AxpyStochasticRounding__avx2_fma(
+    int N,
+    const float a,
+    const float* x,
+    float16* y,
+    StochasticRoundingRNG* rng) {
+  __m256i state =
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rng->state));
+  const __m256 mma = _mm256_set1_ps(a);
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    axpy8(mma, x + i, y + i, &state);
+  }
+  if (i < N) {
+    float x_tail[8] = {0};
+    float16 y_tail[8] = {};
+    std::copy(x + i, x + N, x_tail);
+    std::copy(y + i, y + N, y_tail);
+    axpy8(mma, x_tail, y_tail, &state);
+    std::copy(y_tail, y_tail + N - i, y + i);
+  }
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(rng->state), state);
+}
+
+} // namespace caffe2
@@ -0,0 +1,32 @@
+#include "caffe2/perfkernels/text_scan.h"
+
+#include "caffe2/perfkernels/common.h"
+#include "caffe2/utils/cpuid.h"
+
+namespace caffe2 {
+
+const char* FindFirstOf__base(
+    const char* begin,
+    const char* end,
+    const char* chars,
+    int numChars) {
+  for (; begin < end; ++begin) {
+    for (int k = 0; k < numChars; ++k) {
+      if (*begin == chars[k]) {
+        return begin;
+      }
+    }
+  }
+  return end;
+}
+
+const char* FindFirstOf(
+    const char* begin,
+    const char* end,
+    const char* chars,
+    int numChars) {
+  AVX2_DO(FindFirstOf, begin, end, chars, numChars);
+  BASE_DO(FindFirstOf, begin, end, chars, numChars);
+}
+
+} // namespace caffe2
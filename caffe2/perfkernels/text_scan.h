@@ -0,0 +1,20 @@
+#pragma once
+
+namespace caffe2 {
+
+// The most characters FindFirstOf looks for at once.
+constexpr int kFindFirstOfMaxChars = 4;
+
+/**
+ * Returns a pointer to the first character of [begin, end) that is one of
+ * chars[0], ..., chars[numChars - 1], or end if there is none, where
+ * numChars is in [1, kFindFirstOfMaxChars]. Used by the text tokenizers to
+ * skip to the next delimiter or escape character.
+ */
+const char* FindFirstOf(
+    const char* begin,
+    const char* end,
+    const char* chars,
+    int numChars);
+
+} // namespace caffe2
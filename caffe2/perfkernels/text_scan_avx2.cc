@@ -0,0 +1,41 @@
+#include "caffe2/perfkernels/text_scan.h"
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+const char* FindFirstOf__avx2(
+    const char* begin,
+    const char* end,
+    const char* chars,
+    int numChars) {
+  // compare 32 characters at a time against all of chars, padded to
+  // kFindFirstOfMaxChars with repeats of chars[0]
+  static_assert(kFindFirstOfMaxChars == 4, "the loop compares 4 characters");
+  __m256i c[kFindFirstOfMaxChars];
+  for (int k = 0; k < kFindFirstOfMaxChars; ++k) {
+    c[k] = _mm256_set1_epi8(chars[k < numChars ? k : 0]);
+  }
+  const char* p = begin;
+  for (; end - p >= 32; p += 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i eq = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, c[0]), _mm256_cmpeq_epi8(v, c[1])),
+        _mm256_or_si256(
+            _mm256_cmpeq_epi8(v, c[2]), _mm256_cmpeq_epi8(v, c[3])));
+    const unsigned mask = _mm256_movemask_epi8(eq);
+    if (mask) {
+      return p + __builtin_ctz(mask);
+    }
+  }
+  for (; p < end; ++p) {
+    for (int k = 0; k < numChars; ++k) {
+      if (*p == chars[k]) {
+        return p;
+      }
+    }
+  }
+  return end;
+}
+
+} // namespace caffe2
@@ -44,6 +44,7 @@ void TypedAxpy<float16, float>(
     float* y) {
   AVX2_FMA_DO(TypedAxpy_float16_float, N, a, x, y);
   AVX_F16C_DO(TypedAxpy_float16_float, N, a, x, y);
+  NEON_DO(TypedAxpy_float16_float, N, a, x, y);
   BASE_DO(TypedAxpy_float16_float, N, a, x, y);
 }
 
@@ -64,6 +65,7 @@ void TypedAxpy<std::uint8_t, float>(
     const std::uint8_t* x,
     float* y) {
   AVX2_FMA_DO(TypedAxpy_uint8_float, N, a, x, y);
+  NEON_DO(TypedAxpy_uint8_float, N, a, x, y);
   BASE_DO(TypedAxpy_uint8_float, N, a, x, y);
 }
 
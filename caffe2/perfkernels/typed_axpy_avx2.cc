@@ -62,8 +62,8 @@ void TypedAxpy_uint8_float__avx2_fma(
   const int bound = (N % 8) ? N - 8 : N;
 
   for (; current < bound; current += 8) {
-    __m256i mmx_int32 = _mm256_cvtepi8_epi32(
-        _mm_loadu_si128(reinterpret_cast<const __m128i*>(x + current)));
+    __m256i mmx_int32 = _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(x + current)));
     __m256 mmx_fp32 = _mm256_cvtepi32_ps(mmx_int32);
 
     __m256 mmy = _mm256_loadu_ps(y + current);
@@ -0,0 +1,52 @@
+#include "caffe2/core/types.h"
+#include "caffe2/perfkernels/typed_axpy.h"
+
+#include <arm_neon.h>
+
+namespace caffe2 {
+
+void TypedAxpy_float16_float__neon(
+    int N,
+    const float a,
+    const float16* x,
+    float* y) {
+  const uint16_t* h = reinterpret_cast<const uint16_t*>(x);
+  const float32x4_t mma = vdupq_n_f32(a);
+  int i = 0;
+  for (; i + 4 <= N; i += 4) {
+    const float32x4_t mmx = vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(h + i)));
+    vst1q_f32(y + i, vmlaq_f32(vld1q_f32(y + i), mmx, mma));
+  }
+  if (i < N) {
+    uint16_t tail[4] = {0};
+    float tail_x[4];
+    for (int j = 0; i + j < N; ++j) {
+      tail[j] = h[i + j];
+    }
+    vst1q_f32(tail_x, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(tail))));
+    for (int j = 0; i + j < N; ++j) {
+      y[i + j] += tail_x[j] * a;
+    }
+  }
+}
+
+void TypedAxpy_uint8_float__neon(
+    int N,
+    const float a,
+    const std::uint8_t* x,
+    float* y) {
+  const float32x4_t mma = vdupq_n_f32(a);
+  int i = 0;
+  for (; i + 8 <= N; i += 8) {
+    const uint16x8_t x16 = vmovl_u8(vld1_u8(x + i));
+    const float32x4_t x_lo = vcvtq_f32_u32(vmovl_u16(vget_low_u16(x16)));
+    const float32x4_t x_hi = vcvtq_f32_u32(vmovl_u16(vget_high_u16(x16)));
+    vst1q_f32(y + i, vmlaq_f32(vld1q_f32(y + i), x_lo, mma));
+    vst1q_f32(y + i + 4, vmlaq_f32(vld1q_f32(y + i + 4), x_hi, mma));
+  }
+  for (; i < N; ++i) {
+    y[i] += (float)(x[i]) * a;
+  }
+}
+
+} // namespace caffe2
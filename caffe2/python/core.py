@@ -2543,6 +2543,10 @@ class ExecutionStep(object):
         self._assert_can_mutate()
         self._step.only_once = only_once
 
+    def SetPriority(self, priority):
+        self._assert_can_mutate()
+        self._step.priority = priority
+
     def SetShouldStopBlob(self, should_stop_blob):
         assert isinstance(should_stop_blob, BlobReference), (
             "expects BlobReference here, got {}".format(type(should_stop_blob)))
@@ -2643,6 +2647,8 @@ class ExecutionStep(object):
             step_proto.HasField('create_workspace') else None
         run_every_ms = step_proto.run_every_ms if\
             step_proto.HasField('run_every_ms') else None
+        priority = step_proto.priority if\
+            step_proto.HasField('priority') else None
 
         return execution_step(
             step_proto.name,
@@ -2655,7 +2661,8 @@ class ExecutionStep(object):
             only_once=only_once,
             num_concurrent_instances=num_concurrent_instances,
             create_workspace=create_workspace,
-            run_every_ms=run_every_ms)
+            run_every_ms=run_every_ms,
+            priority=priority)
 
 
 def add_nets_in_order(step, net_list):
@@ -2772,7 +2779,8 @@ def execution_step(default_name,
                    only_once=None,
                    num_concurrent_instances=None,
                    create_workspace=False,
-                   run_every_ms=None):
+                   run_every_ms=None,
+                   priority=None):
     """
     Helper for creating an ExecutionStep.
     - steps_or_nets can be:
@@ -2810,6 +2818,8 @@ def execution_step(default_name,
         step.SetCreateWorkspace(True)
     if run_every_ms:
         step.RunEveryMillis(run_every_ms)
+    if priority is not None:
+        step.SetPriority(priority)
 
     if isinstance(steps_or_nets, ExecutionStep):
         step.AddSubstep(steps_or_nets)
@@ -492,6 +492,26 @@ class TestCreatePlan(test_util.TestCase):
             trim_size = len(net_1.Name())
             self.assertEqual(net_1.Name(), net_2.Name()[:trim_size])
 
+    def test_run_prioritized_concurrent_substeps(self):
+        steps = []
+        for i in range(4):
+            net = core.Net('net_{}'.format(i))
+            net.ConstantFill([], ['out_{}'.format(i)], shape=[1], value=i)
+            steps.append(core.execution_step(
+                'step_{}'.format(i), net, priority=i))
+        plan = core.Plan('plan')
+        plan.AddStep(core.execution_step(
+            'concurrent', steps, concurrent_substeps=True, num_iter=10))
+
+        test_plan = core.Plan.create_from_proto(plan.Proto())
+        substeps = test_plan.Steps()[0].Substeps()
+        self.assertEqual(
+            [s.Proto().priority for s in substeps], [0, 1, 2, 3])
+
+        workspace.RunPlan(plan)
+        for i in range(4):
+            self.assertEqual(workspace.FetchBlob('out_{}'.format(i))[0], i)
+
 
 class TestOpRegistryKey(test_util.TestCase):
     def test_is_operator(self):
@@ -0,0 +1,107 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+
+import numpy as np
+from hypothesis import given
+import hypothesis.strategies as st
+
+def fused_rowwise_nbit_quantize_reference(data, bit_rate):
+    num_elem_per_byte = 8 // bit_rate
+    max_quantized = (1 << bit_rate) - 1
+    minimum = np.min(data, axis=1, keepdims=True)
+    maximum = np.max(data, axis=1, keepdims=True)
+    # scale and bias are rounded to fp16 before quantizing
+    bias = minimum.astype(np.float16)
+    scale = (
+        (maximum - bias.astype(np.float32)) / np.float32(max_quantized)
+    ).astype(np.float16)
+    scale[scale == 0] = 1
+    inverse_scale = np.float32(1) / scale.astype(np.float32)
+    # std::round rounds 0.5 away from 0, Numpy rounds to even
+    quantized = np.floor(
+        (data - bias.astype(np.float32)) * inverse_scale + np.float32(0.5))
+    quantized = np.clip(quantized, 0, max_quantized).astype(np.uint8)
+
+    rows, columns = data.shape
+    packed_columns = (columns + num_elem_per_byte - 1) // num_elem_per_byte
+    packed = np.zeros([rows, packed_columns], dtype=np.uint8)
+    for col in range(columns):
+        packed[:, col // num_elem_per_byte] |= (
+            quantized[:, col] << ((col % num_elem_per_byte) * bit_rate)
+        ).astype(np.uint8)
+    scale_bytes = scale.view(np.uint8).reshape(rows, 2)
+    bias_bytes = bias.view(np.uint8).reshape(rows, 2)
+    return np.concatenate([packed, scale_bytes, bias_bytes], axis=1)
+
+
+def fused_rowwise_nbit_quantize_dequantize_reference(data, bit_rate):
+    num_elem_per_byte = 8 // bit_rate
+    fused_quantized = fused_rowwise_nbit_quantize_reference(data, bit_rate)
+    scale = fused_quantized[:, -4:-2].copy().view(np.float16)
+    bias = fused_quantized[:, -2:].copy().view(np.float16)
+    packed = fused_quantized[:, :-4]
+    columns = packed.shape[1] * num_elem_per_byte
+    quantized = np.empty([packed.shape[0], columns], dtype=np.uint8)
+    for col in range(columns):
+        quantized[:, col] = (
+            packed[:, col // num_elem_per_byte] >>
+            ((col % num_elem_per_byte) * bit_rate)
+        ) & ((1 << bit_rate) - 1)
+    return (quantized * scale.astype(np.float32) + bias.astype(np.float32))
+
+
+class TestFusedNBitRowwiseQuantizationConversion(hu.HypothesisTestCase):
+    @given(
+        input_data=hu.tensor(min_dim=2, max_dim=2),
+        bit_rate=st.sampled_from([2, 4]),
+    )
+    def test_quantize_op(self, input_data, bit_rate):
+        quantize = core.CreateOperator(
+            'FloatToFused{}BitRowwiseQuantized'.format(bit_rate),
+            ['input_data'],
+            ['quantized_data'],
+        )
+        workspace.FeedBlob('input_data', input_data)
+        workspace.RunOperatorOnce(quantize)
+
+        quantized_data = workspace.FetchBlob('quantized_data')
+
+        reference = fused_rowwise_nbit_quantize_reference(
+            input_data.astype(np.float32), bit_rate
+        )
+        np.testing.assert_array_equal(quantized_data, reference)
+
+    @given(
+        input_data=hu.tensor(min_dim=2, max_dim=2),
+        bit_rate=st.sampled_from([2, 4]),
+    )
+    def test_quantize_and_dequantize_op(self, input_data, bit_rate):
+        quantize = core.CreateOperator(
+            'FloatToFused{}BitRowwiseQuantized'.format(bit_rate),
+            ['input_data'],
+            ['quantized_data'],
+        )
+        workspace.FeedBlob('input_data', input_data)
+        workspace.RunOperatorOnce(quantize)
+
+        quantized_data = workspace.FetchBlob('quantized_data')
+
+        dequantize = core.CreateOperator(
+            'Fused{}BitRowwiseQuantizedToFloat'.format(bit_rate),
+            ['quantized_data'],
+            ['dequantized_data'],
+        )
+        workspace.FeedBlob('quantized_data', quantized_data)
+        workspace.RunOperatorOnce(dequantize)
+
+        dequantized_data = workspace.FetchBlob('dequantized_data')
+
+        reference = fused_rowwise_nbit_quantize_dequantize_reference(
+            input_data, bit_rate
+        )
+        np.testing.assert_array_almost_equal(dequantized_data, reference)
@@ -4,7 +4,7 @@ from __future__ import print_function
 from __future__ import unicode_literals
 
 import functools
-from caffe2.python import brew, rnn_cell
+from caffe2.python import brew, core, rnn_cell
 
 
 class GRUCell(rnn_cell.RNNCell):
@@ -17,6 +17,7 @@ class GRUCell(rnn_cell.RNNCell):
         memory_optimization,
         drop_states=False,
         linear_before_reset=False,
+        fused=False,
         **kwargs
     ):
         super(GRUCell, self).__init__(**kwargs)
@@ -26,6 +27,7 @@ class GRUCell(rnn_cell.RNNCell):
         self.memory_optimization = memory_optimization
         self.drop_states = drop_states
         self.linear_before_reset = linear_before_reset
+        self.fused = fused
 
     # Unlike LSTMCell, GRUCell needs the output of one gate to feed into another.
     # (reset gate -> output_gate)
@@ -152,6 +154,47 @@ class GRUCell(rnn_cell.RNNCell):
         model.net.AddExternalOutputs(hidden_t)
         return (hidden_t,)
 
+    def _apply_fused_over_sequence(
+        self, model, inputs, seq_lengths, initial_states
+    ):
+        # Only with linear_before_reset do all the recurrent FCs take
+        # hidden_t_prev, so that they can be run as one.
+        if not self.fused or not self.linear_before_reset:
+            return None
+
+        weights, biases = zip(*[
+            rnn_cell._create_fc_params(
+                model, self.scope(gate), self.hidden_size, self.hidden_size)
+            for gate in ['reset_gate_t', 'update_gate_t', 'output_gate_t']
+        ])
+        weight, _ = model.net.Concat(
+            list(weights),
+            [
+                self.scope('gates_t_w'),
+                self.scope('_gates_t_w_concat_dims'),
+            ],
+            axis=0,
+        )
+        bias, _ = model.net.Concat(
+            list(biases),
+            [
+                self.scope('gates_t_b'),
+                self.scope('_gates_t_b_concat_dims'),
+            ],
+            axis=0,
+        )
+
+        op_inputs = [inputs, initial_states[0], weight, bias]
+        if seq_lengths is not None:
+            op_inputs.append(seq_lengths)
+        hidden_t = str(core.ScopedBlobReference(self.get_state_names()[0]))
+        return model.net.FusedGRUSequence(
+            op_inputs,
+            [hidden_t + '_all', hidden_t + '_last'],
+            drop_states=self.drop_states,
+            sequence_lengths=(seq_lengths is not None),
+        )
+
     def prepare_input(self, model, input_blob):
         return brew.fc(
             model,
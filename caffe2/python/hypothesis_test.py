@@ -4,6 +4,7 @@ from __future__ import print_function
 
 import numpy as np
 import copy
+import os
 import time
 from functools import partial, reduce
 from future.utils import viewitems, viewkeys
@@ -1192,9 +1193,10 @@ class TestOperators(hu.HypothesisTestCase):
            num_elements=st.integers(1, 100),
            capacity=st.integers(1, 5),
            num_blobs=st.integers(1, 3),
+           mode=st.sampled_from(["locked", "spsc", "mpmc"]),
            do=st.sampled_from(hu.device_options))
     def test_blobs_queue_threading(self, num_threads, num_elements,
-                                   capacity, num_blobs, do):
+                                   capacity, num_blobs, mode, do):
         """
         - Construct matrices of size N x D
         - Start K threads
@@ -1209,12 +1211,16 @@ class TestOperators(hu.HypothesisTestCase):
         except ImportError:
             # Py3
             import Queue as queue
+        if mode == "spsc":
+            # A single producer thread, for the single main thread consumer.
+            num_threads = 1
         op = core.CreateOperator(
             "CreateBlobsQueue",
             [],
             ["queue"],
             capacity=capacity,
             num_blobs=num_blobs,
+            mode=mode,
             device_option=do)
         self.ws.run(op)
 
@@ -1277,16 +1283,60 @@ class TestOperators(hu.HypothesisTestCase):
                     any(np.array_equal(xs[i][j], ys[i][k])
                         for k in range(num_elements)))
 
+    @unittest.skipIf(not hasattr(os, "fork"), "Needs fork")
+    def test_shm_blobs_queue_across_processes(self):
+        """
+        A forked process attaches to a shared memory queue and writes the
+        records, which are read in this process.
+        """
+        shm_name = "/caffe2_test_shm_queue_{}".format(os.getpid())
+        num_records = 20
+        xs = [np.random.randn(4, 3).astype(np.float32),
+              np.random.randint(0, 100, size=(4,)).astype(np.int32)]
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "CreateBlobsQueue", [], ["queue"], capacity=3, num_blobs=2,
+            mode="shm", shm_name=shm_name, max_blob_bytes=1024))
+        pid = os.fork()
+        if pid == 0:
+            status = 1
+            try:
+                workspace.SwitchWorkspace("shm_queue_writer", True)
+                workspace.RunOperatorOnce(core.CreateOperator(
+                    "CreateBlobsQueue", [], ["queue"], capacity=3,
+                    num_blobs=2, mode="shm", shm_name=shm_name,
+                    max_blob_bytes=1024, attach=True))
+                for i in range(num_records):
+                    workspace.FeedBlob("x", xs[0] + i)
+                    workspace.FeedBlob("y", xs[1] + i)
+                    workspace.RunOperatorOnce(core.CreateOperator(
+                        "EnqueueBlobs", ["queue", "x", "y"], ["x", "y"]))
+                status = 0
+            finally:
+                os._exit(status)
+        for i in range(num_records):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "DequeueBlobs", ["queue"], ["x", "y"], timeout_secs=10.0))
+            np.testing.assert_array_equal(workspace.FetchBlob("x"), xs[0] + i)
+            np.testing.assert_array_equal(workspace.FetchBlob("y"), xs[1] + i)
+        _, status = os.waitpid(pid, 0)
+        self.assertEqual(status, 0)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "CloseBlobsQueue", ["queue"], []))
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "DequeueBlobs", ["queue"], ["x", "y"]))
+
     @given(num_producers=st.integers(1, 10),
            num_consumers=st.integers(1, 10),
            capacity=st.integers(1, 5),
            num_blobs=st.integers(1, 3),
+           mode=st.sampled_from(["locked", "mpmc"]),
            do=st.sampled_from(hu.device_options))
     def test_safe_blobs_queue(self, num_producers, num_consumers,
-                              capacity, num_blobs, do):
+                              capacity, num_blobs, mode, do):
         init_net = core.Net('init_net')
         queue = init_net.CreateBlobsQueue(
-            [], 1, capacity=capacity, num_blobs=num_blobs)
+            [], 1, capacity=capacity, num_blobs=num_blobs, mode=mode)
         producer_steps = []
         truth = 0
         for i in range(num_producers):
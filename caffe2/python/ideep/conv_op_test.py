@@ -119,6 +119,36 @@ class ConvTest(hu.HypothesisTestCase):
             print(np.max(np.abs(Y2 - Y0)))
             self.assertTrue(False)
 
+    def test_shared_weights_and_fallback_reorders(self):
+        device = caffe2_pb2.DeviceOption(device_type=caffe2_pb2.IDEEP)
+        X = np.random.rand(2, 8, 10, 10).astype(np.float32) - 0.5
+        w = np.random.rand(16, 8, 3, 3).astype(np.float32) - 0.5
+        b = np.random.rand(16).astype(np.float32) - 0.5
+
+        workspace.ResetWorkspace()
+        workspace.FeedBlob('X', X, device)
+        workspace.FeedBlob('w', w, device)
+        workspace.FeedBlob('b', b, device)
+        net = core.Net("net")
+        # Both convolutions share the reordered weights
+        net.Conv(["X", "w", "b"], "Y", kernel=3, device_option=device)
+        net.Conv(["X", "w", "b"], "Y1", kernel=3, device_option=device)
+        # Both fallback operators read a single copy of Y on the CPU
+        net.Sigmoid("Y", "Z0", device_option=device)
+        net.Sigmoid("Y", "Z1", device_option=device)
+        optimizeForIDEEP(net)
+        self.assertEqual(
+            [op.type for op in net.Proto().op],
+            ["Conv", "CopyIDEEPToCPU", "Conv", "Sigmoid", "Sigmoid"])
+
+        for _ in range(2):
+            workspace.RunNetOnce(net)
+            Y = workspace.FetchBlob('Y')
+            np.testing.assert_allclose(Y, workspace.FetchBlob('Y1'))
+            Z = 1. / (1. + np.exp(-Y))
+            np.testing.assert_allclose(Z, workspace.FetchBlob('Z0'), rtol=1e-5)
+            np.testing.assert_allclose(Z, workspace.FetchBlob('Z1'), rtol=1e-5)
+
 
 if __name__ == "__main__":
     unittest.main()
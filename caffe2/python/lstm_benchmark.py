@@ -156,6 +156,8 @@ def create_model(args, queue, label_queue, input_shape):
                     op,
                     num_threads=args.rnn_executor_num_threads,
                     max_cuda_streams=args.rnn_executor_max_cuda_streams,
+                    wavefront=args.rnn_executor_wavefront,
+                    max_parallelism=args.rnn_executor_max_parallelism,
                 )
     return model, output
 
@@ -235,6 +237,27 @@ def Benchmark(args):
     return Caffe2LSTM(args)
 
 
+def BenchmarkDepths(args):
+    '''
+    Runs the benchmark for each number of layers of args.depths, to compare
+    how the throughput goes down with depth.
+    '''
+    results = []
+    for num_layers in args.depths:
+        args.num_layers = num_layers
+        results.append((num_layers, Benchmark(args)))
+        workspace.ResetWorkspace()
+
+    for num_layers, t in results:
+        log.info(
+            "Layers: {}. Time: {:.3f}s. Time per layer: {:.3f}s. "
+            "Layer throughput relative to {} layers: {:.2f}".format(
+                num_layers, t, t / num_layers, results[0][0],
+                results[0][1] * num_layers / results[0][0] / t,
+            )
+        )
+
+
 def GetArgumentParser():
     parser = argparse.ArgumentParser(description="LSTM benchmark.")
 
@@ -325,6 +348,26 @@ def GetArgumentParser():
         default=None,
         help="Maximum number of CUDA streams used by RNN executor on GPU"
     )
+    parser.add_argument(
+        "--rnn_executor_wavefront",
+        action="store_true",
+        help="Whether the RNN executor runs the timesteps of the layers as a "
+             "wavefront, e.g. step t of layer l + 1 along with step t + 1 of "
+             "layer l"
+    )
+    parser.add_argument(
+        "--rnn_executor_max_parallelism",
+        type=int,
+        default=None,
+        help="Maximum number of timesteps the RNN executor runs at once"
+    )
+    parser.add_argument(
+        "--depths",
+        type=lambda s: [int(d) for d in s.split(',')],
+        default=None,
+        help="Comma separated numbers of layers to benchmark one after the "
+             "other instead of --num_layers, e.g. 1,2,4,8",
+    )
     return parser
 
 
@@ -344,4 +387,7 @@ if __name__ == '__main__':
         caffe2_pb2.CUDA if args.gpu else caffe2_pb2.CPU, 4)
 
     with core.DeviceScope(device):
-        Benchmark(args)
+        if args.depths:
+            BenchmarkDepths(args)
+        else:
+            Benchmark(args)
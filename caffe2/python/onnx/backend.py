@@ -710,6 +710,24 @@ class Caffe2Backend(Backend):
 
         return cls.prepare(model, device, raw_values_dict=raw_values_dict, **kwargs)
 
+    @classmethod
+    def prepare_directory(cls, directory, device='CPU', **kwargs):
+        '''
+        Prepares a model exported by PyTorch with ExportTypes.DIRECTORY, which
+        keeps the raw data of the initializers in files named after them next
+        to the model, so that it isn't limited by the 2GB size of protobufs.
+        '''
+        with open(os.path.join(directory, '__MODEL_PROTO'), 'rb') as f:
+            model = onnx.load(f)
+        raw_values_dict = {}
+        for name in os.listdir(directory):
+            if name == '__MODEL_PROTO':
+                continue
+            with open(os.path.join(directory, name), 'rb') as blob_file:
+                raw_values_dict[name] = blob_file.read()
+
+        return cls.prepare(model, device, raw_values_dict=raw_values_dict, **kwargs)
+
     @classmethod
     def prepare(cls, model, device='CPU', raw_values_dict=None, **kwargs):
         '''
@@ -1000,6 +1018,8 @@ prepare = Caffe2Backend.prepare
 
 prepare_zip_archive = Caffe2Backend.prepare_zip_archive
 
+prepare_directory = Caffe2Backend.prepare_directory
+
 run_node = Caffe2Backend.run_node
 
 run_model = Caffe2Backend.run_model
@@ -6,6 +6,8 @@ from __future__ import division
 from __future__ import print_function
 
 import json
+import os
+import shutil
 import tempfile
 import textwrap
 import traceback
@@ -172,6 +174,39 @@ class TestConversion(TestCase):
         Y = c2_model.run(X).Y
         np.testing.assert_allclose(Y, Y_expect)
 
+    def test_onnx_to_caffe2_directory(self):
+        directory = tempfile.mkdtemp()
+        node_def = helper.make_node(
+            "MatMul", ["X", "W"], ["Y"])
+        X = np.random.rand(2, 3).astype(np.float32)
+        W = np.random.rand(3, 2).flatten().astype(np.float32)
+        graph_def = helper.make_graph(
+            [node_def],
+            "test",
+            [helper.make_tensor_value_info("X", TensorProto.FLOAT, (2, 3)),
+             helper.make_tensor_value_info("W", TensorProto.FLOAT, (3, 2))],
+            [helper.make_tensor_value_info("Y", TensorProto.FLOAT, (2, 2))],
+            initializer=[helper.make_tensor("W",
+                                            TensorProto.FLOAT,
+                                            [3, 2],
+                                            b'__EXTERNAL',
+                                            raw=True)])
+        model_def = helper.make_model(graph_def, producer_name='onnx-to-caffe2-test')
+        try:
+            with open(os.path.join(directory, '__MODEL_PROTO'), 'wb') as f:
+                f.write(model_def.SerializeToString())
+            with open(os.path.join(directory, 'W'), 'wb') as f:
+                f.write(W.tobytes())
+
+            W = W.reshape((3, 2))
+            Y_expect = np.matmul(X, W)
+
+            c2_model = c2.prepare_directory(directory)
+            Y = c2_model.run(X).Y
+            np.testing.assert_allclose(Y, Y_expect)
+        finally:
+            shutil.rmtree(directory)
+
     def _make_fake_if_op(self, true_nodes, false_nodes, output_types):
         true = helper.make_tensor("condition", TensorProto.BOOL, (), [True])
         true_graph = helper.make_graph(true_nodes, "true_graph", [], [
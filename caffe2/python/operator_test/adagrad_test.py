@@ -10,7 +10,7 @@ from hypothesis import given, settings, HealthCheck
 import hypothesis.strategies as st
 import numpy as np
 
-from caffe2.python import core
+from caffe2.python import core, workspace
 import caffe2.python.hypothesis_test_util as hu
 from caffe2.python.operator_test.adagrad_test_helper import (
     ref_adagrad, adagrad_sparse_test_helper
@@ -220,6 +220,135 @@ class TestAdagrad(hu.HypothesisTestCase):
             [param, momentum, indices, grad, lr],
             ref_row_wise_sparse)
 
+    @given(inputs=hu.tensors(n=3),
+           lr=st.floats(min_value=0.01, max_value=0.99,
+                        allow_nan=False, allow_infinity=False),
+           epsilon=st.floats(min_value=0.01, max_value=0.99,
+                             allow_nan=False, allow_infinity=False),
+           row_wise=st.booleans(),
+           **hu.gcs_cpu_only)
+    def test_sparse_adagrad_fp16_param(self, inputs, lr, epsilon, row_wise,
+                                       gc, dc):
+        param, momentum, grad = inputs
+        param = param.astype(np.float16)
+        if row_wise:
+            momentum = momentum.reshape(param.shape[0], -1)[:, 0]
+        momentum = np.abs(momentum)
+        lr = np.array([lr], dtype=np.float32)
+        indices = np.random.choice(np.arange(grad.shape[0]),
+            size=np.random.randint(grad.shape[0]), replace=False)
+        grad = grad[indices]
+
+        workspace.FeedBlob("param", param)
+        workspace.FeedBlob("momentum", momentum)
+        workspace.FeedBlob("indices", indices)
+        workspace.FeedBlob("grad", grad)
+        workspace.FeedBlob("lr", lr)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "RowWiseSparseAdagrad" if row_wise else "SparseAdagrad",
+            ["param", "momentum", "indices", "grad", "lr"],
+            ["param", "momentum"],
+            epsilon=epsilon,
+            device_option=gc))
+        param_out = workspace.FetchBlob("param")
+        momentum_out = workspace.FetchBlob("momentum")
+        self.assertEqual(param_out.dtype, np.float16)
+
+        # the result in float32 rounded to one of the fp16 values around it
+        param_ref = param.astype(np.float32)
+        momentum_ref = np.copy(momentum)
+        for i, index in enumerate(indices):
+            ref = self.ref_row_wise_adagrad if row_wise else ref_adagrad
+            param_ref[index], momentum_ref[index] = ref(
+                param_ref[index], momentum[index], grad[i], lr, epsilon)
+        np.testing.assert_allclose(momentum_out, momentum_ref, rtol=1e-5)
+        spacing = np.spacing(np.abs(param_ref).astype(np.float16))
+        self.assertTrue(np.all(
+            np.abs(param_out.astype(np.float32) - param_ref) <=
+            spacing.astype(np.float32) * 1.01))
+
+    def test_row_wise_sparse_adagrad_fp16_param_is_unbiased(self):
+        # updates well below the fp16 spacing of 1.0, which round to nearest
+        # would drop
+        param = np.ones((1, 4096), dtype=np.float16)
+        momentum = np.ones(1, dtype=np.float32)
+        grad = np.full((1, 4096), 1e-4, dtype=np.float32)
+        lr = np.array([1.], dtype=np.float32)
+        workspace.FeedBlob("param", param)
+        workspace.FeedBlob("momentum", momentum)
+        workspace.FeedBlob("indices", np.zeros(1, dtype=np.int64))
+        workspace.FeedBlob("grad", grad)
+        workspace.FeedBlob("lr", lr)
+        op = core.CreateOperator(
+            "RowWiseSparseAdagrad",
+            ["param", "momentum", "indices", "grad", "lr"],
+            ["param", "momentum"],
+            epsilon=0.0)
+        expected = 1.
+        for _ in range(100):
+            workspace.RunOperatorOnce(op)
+            momentum = momentum + 1e-8
+            expected += 1e-4 / np.sqrt(momentum[0])
+        param_out = workspace.FetchBlob("param").astype(np.float64)
+        self.assertAlmostEqual(param_out.mean(), expected, delta=5e-4)
+
+    @given(num_rows=st.integers(min_value=1, max_value=100),
+           block_size=st.integers(min_value=1, max_value=10),
+           num_segments=st.integers(min_value=0, max_value=20),
+           lr=st.floats(min_value=0.01, max_value=0.99,
+                        allow_nan=False, allow_infinity=False),
+           epsilon=st.floats(min_value=0.01, max_value=0.99,
+                             allow_nan=False, allow_infinity=False),
+           hogwild=st.booleans(),
+           **hu.gcs_cpu_only)
+    def test_row_wise_sparse_adagrad_fused_with_sparse_lengths_sum_gradient(
+            self, num_rows, block_size, num_segments, lr, epsilon, hogwild,
+            gc, dc):
+        param = np.random.rand(num_rows, block_size).astype(np.float32)
+        momentum = np.random.rand(num_rows).astype(np.float32)
+        lengths = np.random.randint(
+            0, 10, size=num_segments).astype(np.int32)
+        if hogwild:
+            # enough indices to run on several threads, all distinct so that
+            # the result is deterministic
+            param = np.random.rand(30000, block_size).astype(np.float32)
+            momentum = np.random.rand(30000).astype(np.float32)
+            lengths = np.full(1000, 25, dtype=np.int32)
+            indices = np.random.permutation(30000)[:25000].astype(np.int64)
+        else:
+            indices = np.random.randint(
+                0, num_rows, size=lengths.sum()).astype(np.int64)
+        grad = np.random.rand(
+            lengths.size, param.shape[1]).astype(np.float32)
+        lr = np.array([lr], dtype=np.float32)
+
+        op = core.CreateOperator(
+            "RowWiseSparseAdagradFusedWithSparseLengthsSumGradient",
+            ["param", "momentum", "indices", "grad", "lr", "lengths"],
+            ["param", "momentum"],
+            epsilon=epsilon,
+            hogwild=hogwild,
+            device_option=gc)
+
+        def ref_fused(param, momentum, indices, grad, lr, lengths):
+            # the gradient of every row, summed over the segments reading it
+            row_grad = {}
+            segment_ids = np.repeat(np.arange(lengths.size), lengths)
+            for index, segment in zip(indices, segment_ids):
+                row_grad[index] = row_grad.get(index, 0) + grad[segment]
+            param_out = np.copy(param)
+            momentum_out = np.copy(momentum)
+            for index, g in row_grad.items():
+                param_out[index], momentum_out[index] = \
+                    self.ref_row_wise_adagrad(
+                        param[index], momentum[index], g, lr, epsilon)
+            return (param_out, momentum_out)
+
+        self.assertReferenceChecks(
+            gc, op,
+            [param, momentum, indices, grad, lr, lengths],
+            ref_fused)
+
     @given(inputs=hu.tensors(n=1),
            lr=st.floats(min_value=0.01, max_value=0.99,
                         allow_nan=False, allow_infinity=False),
@@ -252,6 +252,61 @@ class TestAdam(hu.HypothesisTestCase):
             ref_row_wise_sparse,
             input_device_options=input_device_options)
 
+    @given(num_rows=st.integers(min_value=1, max_value=100),
+           block_size=st.integers(min_value=1, max_value=10),
+           num_segments=st.integers(min_value=0, max_value=20),
+           ITER=st.integers(min_value=0, max_value=10000),
+           LR=st.floats(min_value=0.01, max_value=0.99,
+                        allow_nan=False, allow_infinity=False),
+           beta1=st.floats(min_value=0.01, max_value=0.99,
+                           allow_nan=False, allow_infinity=False),
+           beta2=st.floats(min_value=0.01, max_value=0.99,
+                           allow_nan=False, allow_infinity=False),
+           epsilon=st.floats(min_value=0.01, max_value=0.99,
+                             allow_nan=False, allow_infinity=False),
+           **hu.gcs_cpu_only)
+    def test_row_wise_sparse_adam_fused_with_sparse_lengths_sum_gradient(
+            self, num_rows, block_size, num_segments, ITER, LR, beta1, beta2,
+            epsilon, gc, dc):
+        param = np.random.rand(num_rows, block_size).astype(np.float32)
+        mom1 = np.random.rand(num_rows, block_size).astype(np.float32)
+        mom2 = np.random.rand(num_rows).astype(np.float32)
+        lengths = np.random.randint(
+            0, 10, size=num_segments).astype(np.int32)
+        indices = np.random.randint(
+            0, num_rows, size=lengths.sum()).astype(np.int64)
+        grad = np.random.rand(num_segments, block_size).astype(np.float32)
+        ITER = np.array([ITER], dtype=np.int64)
+        LR = np.array([LR], dtype=np.float32)
+
+        op = core.CreateOperator(
+            "RowWiseSparseAdamFusedWithSparseLengthsSumGradient",
+            ["param", "mom1", "mom2", "indices", "grad", "lr", "iter",
+             "lengths"],
+            ["param", "mom1", "mom2"],
+            beta1=beta1, beta2=beta2, epsilon=epsilon)
+
+        def ref_fused(param, mom1, mom2, indices, grad, LR, ITER, lengths):
+            # the gradient of every row, summed over the segments reading it
+            row_grad = {}
+            segment_ids = np.repeat(np.arange(lengths.size), lengths)
+            for index, segment in zip(indices, segment_ids):
+                row_grad[index] = row_grad.get(index, 0) + grad[segment]
+            param_out = np.copy(param)
+            mom1_out = np.copy(mom1)
+            mom2_out = np.copy(mom2)
+            for index, g in row_grad.items():
+                param_out[index], mom1_out[index], mom2_out[index] = \
+                    self.ref_row_wise_adam(param[index], mom1[index],
+                                           mom2[index], g, LR, ITER,
+                                           beta1, beta2, epsilon)
+            return (param_out, mom1_out, mom2_out)
+
+        self.assertReferenceChecks(
+            gc, op,
+            [param, mom1, mom2, indices, grad, LR, ITER, lengths],
+            ref_fused)
+
 
 if __name__ == "__main__":
     import unittest
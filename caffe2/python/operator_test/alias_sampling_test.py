@@ -0,0 +1,101 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+
+from hypothesis import given
+import hypothesis.strategies as st
+
+from caffe2.python import core
+from caffe2.python import workspace
+import caffe2.python.hypothesis_test_util as hu
+
+
+class TestAliasSampling(hu.HypothesisTestCase):
+    @given(
+        data_len=st.integers(min_value=1, max_value=1000),
+        **hu.gcs
+    )
+    def test_build_alias_table(self, data_len, gc, dc):
+        weights = np.random.rand(data_len).astype(np.float32)
+        weights[np.random.rand(data_len) < 0.2] = 0.0
+        weights[np.random.randint(0, data_len)] = 1.0
+
+        op = core.CreateOperator(
+            "BuildAliasTable", ["weights"], ["prob", "alias"],
+            device_option=gc,
+        )
+        self.ws.create_blob("weights").feed(weights, device_option=gc)
+        self.ws.run(op)
+        prob = self.ws.blobs["prob"].fetch()
+        alias = self.ws.blobs["alias"].fetch()
+
+        # Each index keeps its own slot with probability prob and receives
+        # what the slots aliased to it give up.
+        mass = prob.astype(np.float64)
+        np.add.at(mass, alias, 1.0 - prob)
+        np.testing.assert_allclose(
+            mass / data_len, weights / weights.sum(), rtol=1e-4, atol=1e-6)
+
+    @given(
+        num_samples=st.integers(min_value=0, max_value=128),
+        data_len=st.integers(min_value=0, max_value=10000),
+        **hu.gcs
+    )
+    def test_alias_multi_sampling(self, num_samples, data_len, gc, dc):
+        weights = np.zeros((data_len)).astype(np.float32)
+        expected_indices = []
+        if data_len > 0:
+            weights[-1] = 1.5
+            expected_indices = np.repeat(data_len - 1, num_samples)
+
+        workspace.FeedBlob("weights", weights)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "BuildAliasTable", ["weights"], ["prob", "alias"]))
+        prob = workspace.FetchBlob("prob")
+        alias = workspace.FetchBlob("alias")
+
+        op = core.CreateOperator(
+            "AliasMultiSampling",
+            ["prob", "alias"],
+            ["sample_indices"],
+            num_samples=num_samples,
+        )
+        workspace.RunOperatorOnce(op)
+        result_indices = workspace.FetchBlob("sample_indices")
+        np.testing.assert_allclose(expected_indices, result_indices)
+        self.assertDeviceChecks(dc, op, [prob, alias], [0])
+
+        # test shape input
+        shape = np.zeros((num_samples))
+        workspace.FeedBlob("shape", shape)
+        op2 = core.CreateOperator(
+            "AliasMultiSampling",
+            ["prob", "alias", "shape"],
+            ["sample_indices_2"]
+        )
+        workspace.RunOperatorOnce(op2)
+        result_indices_2 = workspace.FetchBlob("sample_indices_2")
+        self.assertEqual(
+            len(result_indices_2), num_samples if data_len > 0 else 0)
+
+    def test_alias_multi_sampling_distribution(self):
+        weights = np.array([1.0, 0.0, 3.0, 0.5, 5.5], dtype=np.float32)
+        workspace.FeedBlob("weights", weights)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "BuildAliasTable", ["weights"], ["prob", "alias"]))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "AliasMultiSampling", ["prob", "alias"], ["sample_indices"],
+            num_samples=100000))
+        counts = np.bincount(
+            workspace.FetchBlob("sample_indices"), minlength=len(weights))
+        self.assertEqual(counts[1], 0)
+        np.testing.assert_allclose(
+            counts / counts.sum(), weights / weights.sum(), atol=0.01)
+
+
+if __name__ == "__main__":
+    import unittest
+    unittest.main()
@@ -52,7 +52,7 @@ class TestConvolution(hu.HypothesisTestCase):
            output_channels=st.integers(1, 3),
            batch_size=st.integers(1, 3),
            order=st.sampled_from(["NCHW", "NHWC"]),
-           engine=st.sampled_from(["", "EIGEN"]),
+           engine=st.sampled_from(["", "EIGEN", "DIRECT"]),
            shared_buffer=st.booleans(),
            use_bias=st.booleans(),
            **hu.gcs)
@@ -116,7 +116,7 @@ class TestConvolution(hu.HypothesisTestCase):
            input_channels=st.integers(1, 8),
            output_channels=st.integers(1, 8),
            batch_size=st.integers(1, 3),
-           engine=st.sampled_from(["", "EIGEN"]),
+           engine=st.sampled_from(["", "EIGEN", "DIRECT"]),
            use_bias=st.booleans(),
            **hu.gcs)
     def test_convolution_separate_stride_pad_layout(self, op_type,
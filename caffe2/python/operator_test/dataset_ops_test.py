@@ -3,6 +3,8 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 import numpy as np
+import os
+import tempfile
 from caffe2.python import core, workspace, dataset
 from caffe2.python.dataset import Const
 from caffe2.python.schema import (
@@ -537,6 +539,91 @@ class TestDatasetOps(TestCase):
         actual_sizes = [d.shape[0] for d in trimmed.field_blobs()]
         self.assertEquals(EXPECTED_SIZES, actual_sizes)
 
+    def test_columnar_dataset_ops(self):
+        fields = [
+            'dense', 'b:lengths', 'b:values:lengths', 'b:values:values',
+            'c:lengths', 'c:c1', 'c:c2:lengths', 'c:c2:values',
+        ]
+        dtypes = [
+            np.float32, np.int32, np.int32, np.int64,
+            np.int32, object, np.int32, np.int64,
+        ]
+        # the values of every field for each top-level entry
+        entries = [
+            [[[1.0, 1.5]], [2], [2, 1], [4, 5, 6],
+             [1], [b'x'], [2], [10, 11]],
+            [[[2.0, 2.5]], [0], [], [],
+             [2], [b'yy', b'zzz'], [0, 1], [12]],
+            [[[3.0, 3.5]], [1], [3], [7, 8, 9],
+             [0], [], [], []],
+        ]
+
+        def batch(rows):
+            arrays = []
+            for i, dtype in enumerate(dtypes):
+                values = [v for r in rows for v in entries[r][i]]
+                array = np.array(values, dtype=dtype)
+                if i == 0:
+                    array = array.reshape(-1, 2)
+                arrays.append(array)
+            return arrays
+
+        def check(actual_blobs, rows):
+            for name, blob, ref in zip(fields, actual_blobs, batch(rows)):
+                actual = workspace.FetchBlob(blob)
+                self.assertEqual(ref.shape, actual.shape, name)
+                if ref.dtype == object:
+                    self.assertEqual(list(ref), list(actual), name)
+                else:
+                    npt.assert_array_equal(ref, actual, err_msg=name)
+
+        path = os.path.join(tempfile.mkdtemp(), 'dataset.bin')
+        data_blobs = ['data_' + str(i) for i in range(len(fields))]
+        for blob, array in zip(data_blobs, batch([0, 1, 2])):
+            workspace.FeedBlob(blob, array)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'WriteColumnarDataset', data_blobs, [],
+            filename=path, fields=fields))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'OpenColumnarDataset', [], ['dataset'], filename=path))
+
+        out_blobs = ['out_' + str(i) for i in range(len(fields))]
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'CreateTreeCursor', [], ['cursor'], fields=fields))
+        read_next = core.CreateOperator(
+            'ReadNextColumnarBatch', ['cursor', 'dataset'], out_blobs,
+            batch_size=2)
+        workspace.RunOperatorOnce(read_next)
+        check(out_blobs, [0, 1])
+        workspace.RunOperatorOnce(read_next)
+        check(out_blobs, [2])
+        workspace.RunOperatorOnce(read_next)
+        check(out_blobs, [])
+
+        # the views of the file outlive the dataset blob
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'ResetCursor', ['cursor'], []))
+        workspace.RunOperatorOnce(read_next)
+        workspace.FeedBlob('dataset', np.zeros(1))
+        check(out_blobs, [0, 1])
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'OpenColumnarDataset', [], ['dataset'], filename=path))
+
+        workspace.FeedBlob('idx', np.array([2, 0, 1], dtype=np.int64))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'CreateTreeCursor', [], ['random_cursor'], fields=fields))
+        for intra_op_parallel in [False, True]:
+            workspace.RunOperatorOnce(core.CreateOperator(
+                'ResetCursor', ['random_cursor'], []))
+            read_random = core.CreateOperator(
+                'ReadRandomColumnarBatch',
+                ['random_cursor', 'dataset', 'idx'], out_blobs,
+                batch_size=2, intra_op_parallel=intra_op_parallel)
+            workspace.RunOperatorOnce(read_random)
+            check(out_blobs, [2, 0])
+            workspace.RunOperatorOnce(read_random)
+            check(out_blobs, [1])
+
     def test_last_n_window_ops(self):
         collect_net = core.Net('collect_net')
         collect_net.GivenTensorFill(
@@ -584,6 +671,86 @@ class TestDatasetOps(TestCase):
         npt.assert_array_equal(input_array[[2, 0, 1, 2, 2, 0, 1]],
                                reference_result)
 
+    def _run_concurrent_appends(self, collector, append_op, num_writers,
+                                num_iter):
+        init_net = core.Net('init_net')
+        writer_steps = []
+        for i in range(num_writers):
+            init_net.GivenTensorFill(
+                [],
+                'input_{}'.format(i),
+                shape=[10, 2],
+                values=[float(i * 10 + j // 2) for j in range(20)],
+            )
+            writer_net = core.Net('writer_net_{}'.format(i))
+            getattr(writer_net, append_op)(
+                [collector, 'input_{}'.format(i)], [])
+            writer_steps.append(core.execution_step(
+                'writer_{}'.format(i), writer_net, num_iter=num_iter))
+        workspace.RunNetOnce(init_net)
+
+        plan = core.Plan('collect_data')
+        plan.AddStep(core.execution_step(
+            'collect_data', writer_steps, concurrent_substeps=True))
+        workspace.RunPlan(plan)
+
+    def test_last_n_window_buffer_ops(self):
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'CreateLastNWindowBuffer', [], ['buffer'], num_to_collect=16))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'LastNWindowBufferRead', ['buffer'], ['output', 'num_visited']))
+        self.assertEqual(0, workspace.FetchBlob('num_visited'))
+
+        self._run_concurrent_appends('buffer', 'LastNWindowBufferAppend',
+                                     num_writers=4, num_iter=5)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'LastNWindowBufferRead', ['buffer'], ['output', 'num_visited']))
+        self.assertEqual(4 * 10 * 5, workspace.FetchBlob('num_visited'))
+        output = workspace.FetchBlob('output')
+        self.assertEqual((16, 2), output.shape)
+        # Rows are never torn by concurrent appends
+        npt.assert_array_equal(output[:, 0], output[:, 1])
+        self.assertTrue(np.all(output < 4 * 10))
+
+        # A single append of more rows than the buffer keeps its last ones
+        workspace.FeedBlob(
+            'data', np.arange(40, dtype=np.int64).reshape(20, 2))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'CreateLastNWindowBuffer', [], ['buffer'], num_to_collect=6))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'LastNWindowBufferAppend', ['buffer', 'data'], []))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'LastNWindowBufferRead', ['buffer'], ['output']))
+        npt.assert_array_equal(
+            workspace.FetchBlob('data')[14:], workspace.FetchBlob('output'))
+
+    def test_sharded_reservoir_ops(self):
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'CreateShardedReservoir', [], ['reservoir'],
+            num_to_collect=16, num_shards=3))
+        self._run_concurrent_appends('reservoir', 'ShardedReservoirAppend',
+                                     num_writers=4, num_iter=5)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'ShardedReservoirRead', ['reservoir'], ['output', 'num_visited']))
+        self.assertEqual(4 * 10 * 5, workspace.FetchBlob('num_visited'))
+        output = workspace.FetchBlob('output')
+        self.assertEqual((16, 2), output.shape)
+        npt.assert_array_equal(output[:, 0], output[:, 1])
+        self.assertTrue(np.all(output < 4 * 10))
+
+        # With fewer rows than num_to_collect, all of them are kept
+        workspace.FeedBlob(
+            'data', np.arange(10, dtype=np.int64).reshape(5, 2))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'CreateShardedReservoir', [], ['reservoir'], num_to_collect=8))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'ShardedReservoirAppend', ['reservoir', 'data'], []))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'ShardedReservoirRead', ['reservoir'], ['output']))
+        output = workspace.FetchBlob('output')
+        npt.assert_array_equal(
+            workspace.FetchBlob('data'), output[np.argsort(output[:, 0])])
+
     def test_collect_tensor_ops(self):
         init_net = core.Net('init_net')
         blobs = ['blob_1', 'blob_2', 'blob_3']
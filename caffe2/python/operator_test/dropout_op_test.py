@@ -72,3 +72,31 @@ class TestDropout(hu.HypothesisTestCase):
             gc, op, [X], reference_dropout_ratio0,
             # Don't check the mask with cuDNN because it's packed data
             outputs_to_check=None if engine != 'CUDNN' else [0])
+
+    @given(X=hu.tensor(),
+           ratio=st.floats(0.1, 0.9),
+           **hu.gcs)
+    def test_dropout_packed_mask(self, X, ratio, gc, dc):
+        op = core.CreateOperator("Dropout", ["X"], ["Y", "mask"],
+                                 ratio=ratio, packed_mask=True,
+                                 device_option=gc)
+        self.ws.create_blob("X").feed(X, device_option=gc)
+        self.ws.run(op)
+        Y = self.ws.blobs["Y"].fetch()
+        mask = self.ws.blobs["mask"].fetch()
+        self.assertEqual(mask.dtype, np.uint8)
+        self.assertEqual(mask.shape, ((X.size + 7) // 8,))
+
+        bits = (mask.reshape(-1, 1).astype(np.int64) >> np.arange(8)) & 1
+        keep = bits.reshape(-1)[:X.size].reshape(X.shape)
+        scale = 1. / (1. - ratio)
+        np.testing.assert_allclose(Y, X * keep * scale, rtol=1e-5)
+
+        dY = np.random.rand(*X.shape).astype(np.float32)
+        grad_op = core.CreateOperator("DropoutGrad", ["dY", "mask"], ["dX"],
+                                      ratio=ratio, packed_mask=True,
+                                      device_option=gc)
+        self.ws.create_blob("dY").feed(dY, device_option=gc)
+        self.ws.run(grad_op)
+        np.testing.assert_allclose(
+            self.ws.blobs["dX"].fetch(), dY * keep * scale, rtol=1e-5)
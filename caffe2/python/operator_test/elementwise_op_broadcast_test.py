@@ -325,6 +325,32 @@ class TestElementwiseBroadcast(hu.HypothesisTestCase):
         np.testing.assert_array_almost_equal(out, X + Y)
         self.assertDeviceChecks(dc, op, [X, Y], [0])
 
+    def test_intra_op_parallel(self):
+        # Large enough outputs to be split into chunks, with the operands
+        # broadcast along the split dimension, some inner ones or none
+        shapes = [
+            ((512, 64), (512, 64)),
+            ((512, 64), (64,)),
+            ((512, 1, 64), (1, 8, 64)),
+            ((1, 3, 40000), (3, 1)),
+            ((1, 70000), (1,)),
+        ]
+        for op_type, ref in [("Add", np.add), ("Sub", np.subtract),
+                             ("Mul", np.multiply), ("Div", np.divide),
+                             ("GT", np.greater)]:
+            for X_shape, Y_shape in shapes:
+                X = np.random.rand(*X_shape).astype(np.float32) + 0.5
+                Y = np.random.rand(*Y_shape).astype(np.float32) + 0.5
+                workspace.FeedBlob("X", X)
+                workspace.FeedBlob("Y", Y)
+                workspace.RunOperatorOnce(core.CreateOperator(
+                    op_type, ["X", "Y"], "out", intra_op_parallel=1))
+                out = workspace.FetchBlob("out")
+                if out.dtype == np.bool:
+                    np.testing.assert_array_equal(out, ref(X, Y))
+                else:
+                    np.testing.assert_allclose(out, ref(X, Y), rtol=1e-6)
+
     @given(**hu.gcs)
     def test_sum_reduce_empty_blob(self, gc, dc):
         net = core.Net('test')
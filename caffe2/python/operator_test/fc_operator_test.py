@@ -97,6 +97,33 @@ class TestFcOperator(hu.HypothesisTestCase):
     def test_fc_transposed(self, **kwargs):
         self._run_test(transposed=True, **kwargs)
 
+    @given(n=st.integers(1, 5),
+           m=st.integers(0, 5),
+           k=st.integers(1, 5),
+           transposed=st.booleans(),
+           **hu.gcs_cpu_only)
+    def test_fc_float16_weight(self, n, m, k, transposed, gc, dc):
+        X = np.random.rand(m, k).astype(np.float32) - 0.5
+        W = (np.random.rand(k, n) if transposed else np.random.rand(n, k)) - 0.5
+        W = W.astype(np.float16)
+        b = np.random.rand(n).astype(np.float32) - 0.5
+
+        def fc_op(X, W, b):
+            W = W.astype(np.float32)
+            return [np.dot(X, W if transposed else W.transpose()) + b]
+
+        op = core.CreateOperator(
+            'FCTransposed' if transposed else 'FC',
+            ['X', 'W', 'b'],
+            'out',
+        )
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X, W, b],
+            reference=fc_op,
+        )
+
 
 if __name__ == "__main__":
     import unittest
@@ -14,14 +14,16 @@ import hypothesis.extra.numpy as hnp
 class TestGatherOps(hu.HypothesisTestCase):
     @given(rows_num=st.integers(1, 10000),
            index_num=st.integers(0, 5000),
+           intra_op_parallel=st.booleans(),
            **hu.gcs)
-    def test_gather_ops(self, rows_num, index_num, gc, dc):
+    def test_gather_ops(self, rows_num, index_num, intra_op_parallel, gc, dc):
         data = np.random.random((rows_num, 10, 20)).astype(np.float32)
         ind = np.random.randint(rows_num, size=(index_num, )).astype('int32')
         op = core.CreateOperator(
             'Gather',
             ['data', 'ind'],
-            ['output'])
+            ['output'],
+            intra_op_parallel=intra_op_parallel)
 
         def ref_gather(data, ind):
             if ind.size == 0:
@@ -54,13 +56,15 @@ def _inputs(draw):
 
 class TestBatchGatherOps(hu.HypothesisTestCase):
     @given(inputs=_inputs(),
+           intra_op_parallel=st.booleans(),
            **hu.gcs)
-    def test_batch_gather_ops(self, inputs, gc, dc):
+    def test_batch_gather_ops(self, inputs, intra_op_parallel, gc, dc):
         data, ind = inputs
         op = core.CreateOperator(
             'BatchGather',
             ['data', 'ind'],
-            ['output'])
+            ['output'],
+            intra_op_parallel=intra_op_parallel)
 
         def ref_batch_gather(data, ind):
             output = []
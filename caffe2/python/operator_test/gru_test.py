@@ -5,7 +5,9 @@ from __future__ import unicode_literals
 
 from caffe2.python import workspace, core, scope, gru_cell
 from caffe2.python.model_helper import ModelHelper
-from caffe2.python.rnn.rnn_cell_test_util import sigmoid, tanh, _prepare_rnn
+from caffe2.python.rnn.rnn_cell_test_util import (
+    sigmoid, tanh, _prepare_rnn, _compare_fused_rnn
+)
 import caffe2.python.hypothesis_test_util as hu
 from caffe2.proto import caffe2_pb2
 
@@ -326,6 +328,24 @@ class GRUCellTest(hu.HypothesisTestCase):
                           outputs_with_grads=outputs_with_grads,
                           **kwargs)
 
+    @given(
+        seed=st.integers(0, 2**32 - 1),
+        input_tensor=gru_input(),
+        drop_states=st.booleans(),
+        **hu.gcs
+    )
+    @ht_settings(max_examples=20)
+    def test_fused_gru(self, seed, input_tensor, drop_states, gc, dc):
+        t, n, d = input_tensor.shape
+        assert d % 3 == 0
+        _compare_fused_rnn(
+            self, t, n, d // 3, gru_cell.GRU, 'FusedGRUSequence', seed, gc,
+            forget_bias=0.0,
+            drop_states=drop_states,
+            linear_before_reset=True,
+            num_states=1,
+        )
+
     def gru_base(self, create_rnn, ref, outputs_with_grads,
                  input_tensor, fwd_only, drop_states, linear_before_reset, gc, dc):
 
@@ -132,6 +132,31 @@ class TestIndexOps(TestCase):
     def test_long_index_ops(self):
         self._test_index_ops(list(range(8)), np.int64, 'LongIndexCreate')
 
+    def test_index_get_large_batch(self):
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'LongIndexCreate', [], ['index']))
+        # enough keys to reach every shard, each one repeated
+        keys = np.random.permutation(5000).astype(np.int64) * 1000
+        query = np.concatenate((keys, keys[::-1]))
+        workspace.FeedBlob('query', query)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'IndexGet', ['index', 'query'], ['result']))
+        result = workspace.FetchBlob('result')
+        # new keys get consecutive ids in order of first occurrence
+        np.testing.assert_array_equal(np.arange(1, 5001), result[:5000])
+        np.testing.assert_array_equal(result[:5000][::-1], result[5000:])
+
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'IndexStore', ['index'], ['stored']))
+        np.testing.assert_array_equal(keys, workspace.FetchBlob('stored'))
+
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'IndexFreeze', ['index'], ['index']))
+        workspace.FeedBlob('query', np.array([keys[7], 1], dtype=np.int64))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'IndexGet', ['index', 'query'], ['result']))
+        np.testing.assert_array_equal([8, 0], workspace.FetchBlob('result'))
+
 if __name__ == "__main__":
     import unittest
     unittest.main()
@@ -0,0 +1,132 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import argparse
+import numpy as np
+import datetime
+
+from caffe2.proto import caffe2_pb2
+from caffe2.python import core, workspace
+
+
+def uniform_lengths(num_segments, average_len):
+    return np.random.randint(
+        int(average_len * 0.75),
+        int(average_len * 1.25) + 1,
+        num_segments)
+
+
+def zipf_lengths(num_segments, average_len):
+    lengths = np.random.zipf(1.5, num_segments).astype(np.float64)
+    return np.round(lengths * average_len / lengths.mean())
+
+
+def skewed_lengths(num_segments, average_len):
+    # a handful of segments hold half of the elements, the others get 1 or 2
+    lengths = np.random.randint(1, 3, num_segments)
+    num_long = max(1, num_segments // 10000)
+    lengths[:num_long] = average_len * num_segments // (2 * num_long)
+    np.random.shuffle(lengths)
+    return lengths
+
+
+DISTRIBUTIONS = {
+    'uniform': uniform_lengths,
+    'zipf': zipf_lengths,
+    'skewed': skewed_lengths,
+}
+
+
+def benchmark_lengths_reduction(
+        op_name,
+        distribution,
+        categorical_limit,
+        embedding_size,
+        average_len,
+        num_segments,
+        iterations,
+        device_option):
+    print('{} over {} lengths. {}'.format(
+        op_name, distribution, datetime.datetime.now()))
+
+    np.random.seed(1701)
+    lengths = DISTRIBUTIONS[distribution](
+        num_segments, average_len).astype(np.int32)
+    sparse = op_name.startswith('Sparse')
+    rows = categorical_limit if sparse else lengths.sum()
+    print('{} segments, {} elements, longest {}'.format(
+        num_segments, lengths.sum(), lengths.max()))
+
+    with core.DeviceScope(device_option):
+        workspace.FeedBlob(
+            "X", np.random.rand(rows, embedding_size).astype(np.float32))
+        workspace.FeedBlob("L", lengths)
+        workspace.FeedBlob(
+            "I",
+            np.random.randint(0, rows, lengths.sum()).astype(np.int64))
+        workspace.FeedBlob(
+            "W", np.random.rand(lengths.sum()).astype(np.float32))
+
+    net = core.Net("lengths_reduction_" + op_name + "_" + distribution)
+    net.Proto().device_option.CopyFrom(device_option)
+    if 'Weighted' in op_name:
+        inputs = ["X", "W", "I", "L"]
+    elif sparse:
+        inputs = ["X", "I", "L"]
+    else:
+        inputs = ["X", "L"]
+    getattr(net, op_name)(inputs, "Y")
+    workspace.CreateNet(net)
+    workspace.BenchmarkNet(net.Name(), 1, iterations, True)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(
+        description="benchmark of the lengths reductions over distributions "
+        "of the segment lengths.")
+    parser.add_argument(
+        "--op", default="SparseLengthsSum",
+        choices=["LengthsSum", "LengthsMean", "SparseLengthsSum",
+                 "SparseLengthsMean", "SparseLengthsWeightedSum"],
+        help="The reduction to benchmark.")
+    parser.add_argument(
+        "--distribution", choices=list(DISTRIBUTIONS.keys()) + ['all'],
+        default='all',
+        help="The distribution of the segment lengths.")
+    parser.add_argument(
+        '-e', "--embedding-size", type=int, default=1000000,
+        help="Lookup table size of the sparse reductions.")
+    parser.add_argument(
+        "--embedding-dim", type=int, default=64,
+        help="Embedding dimension.")
+    parser.add_argument(
+        "--average_len", type=int, default=8,
+        help="Average segment length.")
+    parser.add_argument(
+        "--num_segments", type=int, default=100000,
+        help="The number of segments.")
+    parser.add_argument(
+        '-i', "--iteration", type=int, default=100,
+        help="The number of iterations.")
+    parser.add_argument(
+        "--cpu", action='store_true',
+        help="Run on CPU even when a GPU is available.")
+    args, extra_args = parser.parse_known_args()
+    core.GlobalInit(['python'] + extra_args)
+    device_option = core.DeviceOption(
+        caffe2_pb2.CUDA if workspace.has_gpu_support and not args.cpu
+        else caffe2_pb2.CPU)
+    distributions = list(DISTRIBUTIONS.keys()) \
+        if args.distribution == 'all' else [args.distribution]
+    for distribution in distributions:
+        benchmark_lengths_reduction(
+            args.op,
+            distribution,
+            args.embedding_size,
+            args.embedding_dim,
+            args.average_len,
+            args.num_segments,
+            args.iteration,
+            device_option)
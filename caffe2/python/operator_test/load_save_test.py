@@ -455,6 +455,53 @@ class TestLoadSave(TestLoadSaveBase):
             if e.errno != errno.ENOENT:
                 raise
 
+    def testParallelLoadSave(self):
+        workspace.ResetWorkspace()
+        # The large tensor is split in chunks of caffe2_tensor_chunk_size
+        arrays = [
+            np.random.rand(1500000).astype(np.float32),
+            np.random.permutation(6).reshape(2, 3).astype(np.int64),
+            np.array([b"a", b"bc"], dtype=object),
+        ] + [np.random.rand(3, 4).astype(np.float16) for _ in range(8)]
+        for i, arr in enumerate(arrays):
+            workspace.FeedBlob(str(i), arr)
+
+        tmp_folder = tempfile.mkdtemp()
+        tmp_file = os.path.join(tmp_folder, "db")
+        self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+            "Save",
+            [str(i) for i in range(len(arrays))], [],
+            absolute_path=1,
+            db=tmp_file, db_type=self._db_type,
+            num_threads=4)))
+
+        workspace.ResetWorkspace()
+        self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+            "Load",
+            [], [str(i) for i in range(len(arrays))],
+            absolute_path=1,
+            db=tmp_file, db_type=self._db_type,
+            num_threads=4)))
+        for i, arr in enumerate(arrays):
+            np.testing.assert_array_equal(workspace.FetchBlob(str(i)), arr)
+
+        workspace.ResetWorkspace()
+        self.assertTrue(workspace.RunOperatorOnce(core.CreateOperator(
+            "Load",
+            [], [],
+            absolute_path=1,
+            db=tmp_file, db_type=self._db_type,
+            load_all=1,
+            num_threads=3)))
+        self.assertEqual(len(workspace.Blobs()), len(arrays))
+        for i, arr in enumerate(arrays):
+            np.testing.assert_array_equal(workspace.FetchBlob(str(i)), arr)
+        try:
+            shutil.rmtree(tmp_folder)
+        except OSError as e:
+            if e.errno != errno.ENOENT:
+                raise
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,109 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import numpy as np
+import os
+import shutil
+import tempfile
+
+from caffe2.python import core, test_util, workspace
+
+
+class TestMappedTensors(test_util.TestCase):
+
+    def setUp(self):
+        super(TestMappedTensors, self).setUp()
+        self.tmp_folder = tempfile.mkdtemp()
+        self.path = os.path.join(self.tmp_folder, "weights")
+
+    def tearDown(self):
+        shutil.rmtree(self.tmp_folder)
+        super(TestMappedTensors, self).tearDown()
+
+    def save(self, arrays, **kwargs):
+        for name, arr in arrays.items():
+            workspace.FeedBlob(name, arr)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "SaveMapped", sorted(arrays), [],
+            path=self.path, absolute_path=1, **kwargs))
+
+    def test_save_load(self):
+        dtypes = [np.float16, np.float32, np.float64, np.bool, np.int8,
+                  np.int16, np.int32, np.int64, np.uint8, np.uint16]
+        arrays = {
+            "blob_{}".format(i): np.random.permutation(6).reshape(2, 3)
+            .astype(T) for i, T in enumerate(dtypes)}
+        arrays["empty"] = np.zeros((0, 4), dtype=np.float32)
+        self.save(arrays)
+
+        workspace.ResetWorkspace()
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "LoadMapped", [], ["blob_3", "empty"],
+            path=self.path, absolute_path=1))
+        self.assertFalse(workspace.HasBlob("blob_0"))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob("blob_3"), arrays["blob_3"])
+        self.assertEqual(workspace.FetchBlob("empty").shape, (0, 4))
+
+        workspace.ResetWorkspace()
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "LoadMapped", [], [], path=self.path, absolute_path=1,
+            load_all=1))
+        for name, arr in arrays.items():
+            loaded = workspace.FetchBlob(name)
+            self.assertEqual(loaded.dtype, arr.dtype)
+            np.testing.assert_array_equal(loaded, arr)
+
+    def test_blob_name_overrides(self):
+        x = np.random.rand(3, 2).astype(np.float32)
+        self.save({"x": x}, blob_name_overrides=["w"])
+        workspace.ResetWorkspace()
+        workspace.RunOperatorOnce(core.CreateOperator(
+            "LoadMapped", [], ["w"], path=self.path, absolute_path=1))
+        np.testing.assert_array_equal(workspace.FetchBlob("w"), x)
+
+    def test_init_net(self):
+        w = np.random.rand(4, 3).astype(np.float32)
+        b = np.random.rand(4).astype(np.float32)
+        self.save({"w": w, "b": b})
+        workspace.ResetWorkspace()
+
+        # Loads the weights the way the init net of a predictor would, and
+        # updates them in place, which must not reach the file
+        init_net = core.Net("init")
+        init_net.LoadMapped([], ["w", "b"], path=self.path, absolute_path=1)
+        workspace.RunNetOnce(init_net)
+        net = core.Net("update")
+        net.FC(["data", "w", "b"], "y")
+        net.Scale("w", "w", scale=2.0)
+        data = np.random.rand(2, 3).astype(np.float32)
+        workspace.FeedBlob("data", data)
+        workspace.RunNetOnce(net)
+        np.testing.assert_allclose(
+            workspace.FetchBlob("y"), data.dot(w.T) + b, rtol=1e-5)
+        np.testing.assert_allclose(
+            workspace.FetchBlob("w"), 2 * w, rtol=1e-6)
+
+        workspace.ResetWorkspace()
+        workspace.RunNetOnce(init_net)
+        np.testing.assert_array_equal(workspace.FetchBlob("w"), w)
+
+    def test_missing_blob(self):
+        self.save({"x": np.ones(3, dtype=np.float32)})
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "LoadMapped", [], ["y"], path=self.path, absolute_path=1))
+
+    def test_not_mapped_file(self):
+        with open(self.path, "wb") as f:
+            f.write(b"not a mapped tensor file")
+        with self.assertRaises(RuntimeError):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "LoadMapped", [], ["x"], path=self.path, absolute_path=1))
+
+
+if __name__ == '__main__':
+    import unittest
+    unittest.main()
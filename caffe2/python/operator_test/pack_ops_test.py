@@ -307,6 +307,52 @@ class TestTensorPackOps(hu.HypothesisTestCase):
             exception=RuntimeError
         )
 
+    @given(
+        lengths=st.lists(st.integers(0, 5), min_size=1, max_size=10),
+        cell_size=st.integers(1, 5),
+        **hu.gcs_cpu_only
+    )
+    def test_pack_sequences(self, lengths, cell_size, gc, dc):
+        lengths = np.array(lengths, dtype=np.int32)
+        data = np.random.rand(np.sum(lengths), cell_size).astype(np.float32)
+
+        def pack_sequences_ref(lengths, data):
+            offsets = np.concatenate([[0], np.cumsum(lengths)])
+            sorted_indices = np.argsort(-lengths, kind='mergesort')
+            batch_sizes = np.array(
+                [np.sum(lengths > t) for t in range(np.max(lengths))],
+                dtype=np.int32
+            )
+            rows = [
+                offsets[sorted_indices[i]] + t
+                for t in range(len(batch_sizes))
+                for i in range(batch_sizes[t])
+            ]
+            return (
+                data[rows].reshape(data.shape),
+                batch_sizes,
+                sorted_indices.astype(np.int32),
+            )
+
+        op = core.CreateOperator(
+            'PackSequences', ['l', 'd'], ['p', 'bs', 'si'])
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[lengths, data],
+            reference=pack_sequences_ref,
+        )
+        if data.size > 0:
+            self.assertGradientChecks(gc, op, [lengths, data], 1, [0])
+
+        workspace.FeedBlob('l', lengths)
+        workspace.FeedBlob('d', data)
+        workspace.RunOperatorOnce(op)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'UnpackSequences', ['bs', 'si', 'p'], ['u', 'ul']))
+        np.testing.assert_array_equal(workspace.FetchBlob('u'), data)
+        np.testing.assert_array_equal(workspace.FetchBlob('ul'), lengths)
+
 
 if __name__ == "__main__":
     import unittest
@@ -77,6 +77,67 @@ class TestReBatchingQueue(TestCase):
             workspace.FetchBlob(results[1]), workspace.FetchBlob("tensors")[5:]
         )
 
+    def test_rebatching_queue_bucketed_dequeue(self):
+        net = core.Net('net')
+
+        sequences = [
+            np.array([1, 2], np.float32),
+            np.array([3, 4, 5, 6], np.float32),
+            np.array([7], np.float32),
+        ]
+        for idx, sequence in enumerate(sequences):
+            workspace.FeedBlob("sequence_{}".format(idx), sequence)
+
+        queue = net.CreateRebatchingQueue(
+            [], 1, capacity=10, num_blobs=1, bucket_boundaries=[3]
+        )
+
+        for idx in range(len(sequences)):
+            net.EnqueueRebatchingQueue([queue, "sequence_{}".format(idx)], [])
+        net.CloseRebatchingQueue([queue], 0)
+
+        short, short_lengths = net.DequeueRebatchingQueue(
+            [queue], 2, num_elements=2
+        )
+        long_batch, long_lengths = net.DequeueRebatchingQueue(
+            [queue], 2, num_elements=2
+        )
+
+        workspace.RunNetOnce(net)
+
+        npt.assert_array_equal(
+            workspace.FetchBlob(short), [[1, 2], [7, 0]]
+        )
+        npt.assert_array_equal(workspace.FetchBlob(short_lengths), [2, 1])
+        npt.assert_array_equal(workspace.FetchBlob(long_batch), [[3, 4, 5, 6]])
+        npt.assert_array_equal(workspace.FetchBlob(long_lengths), [4])
+
+    def test_rebatching_queue_single_consumer(self):
+        net = core.Net('net')
+        workspace.FeedBlob(
+            "tensors", np.array([x for x in range(10)], np.int32)
+        )
+
+        queue = net.CreateRebatchingQueue(
+            [], 1, capacity=10, num_blobs=1, single_consumer=True
+        )
+
+        net.EnqueueRebatchingQueue([queue, "tensors"], [], enqueue_batch=True)
+        net.CloseRebatchingQueue([queue], 0)
+
+        results = [
+            net.DequeueRebatchingQueue([queue], 1, num_elements=4),
+            net.DequeueRebatchingQueue([queue], 1, num_elements=4),
+            net.DequeueRebatchingQueue([queue], 1, num_elements=4),
+        ]
+
+        workspace.RunNetOnce(net)
+
+        npt.assert_array_equal(
+            np.concatenate([workspace.FetchBlob(r) for r in results]),
+            workspace.FetchBlob("tensors")
+        )
+
     def test_rebatching_queue_closes_properly(self):
         net = core.Net('net')
         workspace.FeedBlob(
@@ -3,7 +3,7 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
-from caffe2.python import model_helper, workspace, core, rnn_cell
+from caffe2.python import model_helper, workspace, core, recurrent, rnn_cell
 from caffe2.python.attention import AttentionType
 
 import numpy as np
@@ -112,8 +112,12 @@ class TestRNNExecutor(unittest.TestCase):
         num_layers=st.integers(1, 8),
         T=st.integers(4, 100),
         forward_only=st.booleans(),
+        wavefront=st.booleans(),
+        max_parallelism=st.sampled_from([None, 1, 3]),
         **hu.gcs)
-    def test_lstm_equal_simplenet(self, num_layers, T, forward_only, gc, dc):
+    def test_lstm_equal_simplenet(
+        self, num_layers, T, forward_only, wavefront, max_parallelism, gc, dc
+    ):
         '''
         Test that the RNN executor produces same results as
         the non-executor (i.e running step nets as sequence of simple nets).
@@ -170,6 +174,14 @@ class TestRNNExecutor(unittest.TestCase):
             if not forward_only:
                 model.AddGradientOperators([loss])
 
+            for op in model.net.Proto().op:
+                if op.type.startswith('RecurrentNetwork'):
+                    recurrent.set_rnn_executor_config(
+                        op,
+                        wavefront=wavefront,
+                        max_parallelism=max_parallelism,
+                    )
+
             # init
             for init_blob in init_blobs:
                 workspace.FeedBlob(init_blob, np.zeros(
@@ -8,7 +8,9 @@ from caffe2.python import (
 )
 from caffe2.python.attention import AttentionType
 from caffe2.python.model_helper import ModelHelper, ExtractPredictorNet
-from caffe2.python.rnn.rnn_cell_test_util import sigmoid, tanh, _prepare_rnn
+from caffe2.python.rnn.rnn_cell_test_util import (
+    sigmoid, tanh, _prepare_rnn, _compare_fused_rnn
+)
 from caffe2.proto import caffe2_pb2
 import caffe2.python.hypothesis_test_util as hu
 
@@ -1616,6 +1618,80 @@ class RNNCellTest(hu.HypothesisTestCase):
                 input_device_options=input_device_options,
                 **kwargs)
 
+    @given(seed=st.integers(0, 2**32 - 1),
+           input_tensor=lstm_input(),
+           drop_states=st.booleans(),
+           forget_bias=st.floats(-10.0, 10.0),
+           **hu.gcs)
+    @ht_settings(max_examples=20)
+    def test_fused_lstm(
+            self, seed, input_tensor, drop_states, forget_bias, gc, dc):
+        t, n, d = input_tensor.shape
+        assert d % 4 == 0
+        _compare_fused_rnn(
+            self, t, n, d // 4, rnn_cell.LSTM, 'FusedLSTMSequence', seed, gc,
+            forget_bias=forget_bias,
+            drop_states=drop_states,
+        )
+
+    @given(lengths=st.lists(st.integers(0, 5), min_size=1, max_size=5),
+           d=st.integers(1, 4),
+           op_type=st.sampled_from(['FusedLSTMSequence', 'FusedGRUSequence']),
+           **hu.gcs_cpu_only)
+    @ht_settings(max_examples=20)
+    def test_fused_rnn_packed(self, lengths, d, op_type, gc, dc):
+        '''
+        The fused RNNs over a packed sequence compute the same states as over
+        the padded sequence, for the steps of every sequence.
+        '''
+        lstm = op_type == 'FusedLSTMSequence'
+        num_gates = 4 if lstm else 3
+        lengths = np.array(lengths, dtype=np.int32)
+        t, n = max(1, np.max(lengths)), len(lengths)
+        x = np.random.randn(t, n, num_gates * d).astype(np.float32)
+        inputs = {
+            'h0': np.random.randn(n, d).astype(np.float32),
+            'c0': np.random.randn(n, d).astype(np.float32),
+            'w': np.random.randn(num_gates * d, d).astype(np.float32),
+            'b': np.random.randn(num_gates * d).astype(np.float32),
+        }
+        for name, value in inputs.items():
+            workspace.FeedBlob(name, value)
+        states = ['h0', 'c0'] if lstm else ['h0']
+        outputs = ['h_all', 'h_last', 'c_all', 'c_last'][:len(states) * 2]
+
+        workspace.FeedBlob('x', x)
+        workspace.FeedBlob('lengths', lengths)
+        workspace.RunOperatorOnce(core.CreateOperator(
+            op_type, ['x'] + states + ['w', 'b', 'lengths'], outputs))
+        padded = {o: workspace.FetchBlob(o) for o in outputs}
+
+        # x in the layout of PackSequences, one sequence after the other
+        workspace.FeedBlob('x_seq', np.concatenate(
+            [x[:lengths[i], i] for i in range(n)]))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            'PackSequences', ['lengths', 'x_seq'], ['x_packed', 'bs', 'si']))
+        sorted_indices = workspace.FetchBlob('si')
+        for state in states:
+            workspace.FeedBlob(state, inputs[state][sorted_indices])
+        workspace.RunOperatorOnce(core.CreateOperator(
+            op_type, ['x_packed'] + states + ['w', 'b', 'bs'], outputs,
+            packed=True))
+
+        for all_states, last_states in zip(outputs[0::2], outputs[1::2]):
+            workspace.RunOperatorOnce(core.CreateOperator(
+                'UnpackSequences', ['bs', 'si', all_states], ['unpacked']))
+            np.testing.assert_allclose(
+                workspace.FetchBlob('unpacked').reshape(-1, d),
+                np.concatenate(
+                    [padded[all_states][:lengths[i], i] for i in range(n)]
+                ).reshape(-1, d),
+                atol=1e-4, rtol=1e-4)
+            np.testing.assert_allclose(
+                workspace.FetchBlob(last_states)[0],
+                padded[last_states][0][sorted_indices],
+                atol=1e-4, rtol=1e-4)
+
     @given(input_length=st.integers(2, 5),
            dim_in=st.integers(1, 3),
            max_num_units=st.integers(1, 3),
@@ -671,6 +671,80 @@ class TestSegmentOps(hu.HypothesisTestCase):
         self.assertReferenceChecks(
             gc, op, [D, W, indices, L], ref_sparse)
 
+    @given(
+        op_name=st.sampled_from([
+            "SparseLengthsSum",
+            "SparseLengthsMean",
+            "SparseLengthsWeightedSum",
+            "SparseLengthsPositionalWeightedSum",
+        ]),
+        num_segments=st.sampled_from([1, 10, 1000]),
+        **hu.gcs_cpu_only
+    )
+    def test_sparse_lengths_reduction_intra_op_parallel(
+            self, op_name, num_segments, gc, dc):
+        # enough indices to be split into more chunks than the minimum work
+        # size of the thread pool
+        D = np.random.rand(1000, 16).astype(np.float32)
+        L = np.random.randint(0, 60, size=num_segments).astype(np.int32)
+        L[0] = 40000 // num_segments
+        I = np.random.randint(0, 1000, size=L.sum()).astype(np.int64)
+        W = np.random.rand(
+            L.max() if op_name == "SparseLengthsPositionalWeightedSum"
+            else L.sum()).astype(np.float32)
+        inputs = ["D", "W", "I", "L"] if "Weighted" in op_name \
+            else ["D", "I", "L"]
+        workspace.FeedBlob("D", D)
+        workspace.FeedBlob("W", W)
+        workspace.FeedBlob("I", I)
+        workspace.FeedBlob("L", L)
+
+        workspace.RunOperatorOnce(core.CreateOperator(
+            op_name, inputs, "out_serial"))
+        workspace.RunOperatorOnce(core.CreateOperator(
+            op_name, inputs, "out_parallel", intra_op_parallel=True))
+        np.testing.assert_array_equal(
+            workspace.FetchBlob("out_serial"),
+            workspace.FetchBlob("out_parallel"))
+
+        if num_segments > 1:
+            workspace.FeedBlob("L", L + 1)
+            with self.assertRaises(RuntimeError):
+                workspace.RunOperatorOnce(core.CreateOperator(
+                    op_name, inputs, "out_parallel", intra_op_parallel=True))
+
+    @given(
+        op_name=st.sampled_from([
+            "LengthsSum",
+            "LengthsMean",
+            "SparseLengthsSum",
+            "SparseLengthsMean",
+            "SparseLengthsWeightedSum",
+        ]),
+        post=st.sampled_from([1, 3, 64, 200]),
+        **hu.gcs
+    )
+    def test_lengths_reduction_skewed(self, op_name, post, gc, dc):
+        # a few segments spanning many tiles of the GPU kernels among many
+        # empty or short ones
+        L = np.random.randint(0, 3, size=500).astype(np.int32)
+        L[[0, 17, 499]] = [1000, 33, 2000]
+        I = np.random.randint(0, 100, size=L.sum()).astype(np.int64)
+        W = np.random.rand(L.sum()).astype(np.float32)
+        if op_name.startswith("Sparse"):
+            D = np.random.rand(100, post).astype(np.float32)
+        else:
+            D = np.random.rand(L.sum(), post).astype(np.float32)
+        if "Weighted" in op_name:
+            inputs = [D, W, I, L]
+        elif op_name.startswith("Sparse"):
+            inputs = [D, I, L]
+        else:
+            inputs = [D, L]
+        op = core.CreateOperator(
+            op_name, ["X{}".format(i) for i in range(len(inputs))], "out")
+        self.assertDeviceChecks(dc, op, inputs, [0], threshold=1e-3)
+
    # @given(
    #     inputs=hu.lengths_tensor(
    #         dtype=np.float32,
@@ -610,6 +610,45 @@ class TestSoftmaxOps(hu.HypothesisTestCase):
             reference=label_softmax_crossent,
         )
 
+    @given(n=st.integers(0, 6), D=st.integers(1, 8), V=st.integers(1, 40),
+           chunk_size=st.integers(1, 16), **hu.gcs_cpu_only)
+    def test_chunked_softmax_with_loss(self, n, D, V, chunk_size, gc, dc):
+        np.random.seed(2603)
+        X = np.random.randn(n, D).astype(np.float32)
+        W = np.random.randn(V, D).astype(np.float32)
+        b = np.random.randn(V).astype(np.float32)
+        label = (np.random.rand(n) * V).astype(np.int32)
+
+        # FC followed by SoftmaxWithLoss on the whole vocabulary
+        def fc_softmax_crossent(X, W, b, label):
+            logits = X.dot(W.T) + b
+            rowmax = logits.max(axis=1, keepdims=True) if n > 0 \
+                else np.zeros((0, 1), dtype=np.float32)
+            lse = np.log(np.exp(logits - rowmax).sum(axis=1)) + rowmax[:, 0]
+            losses = lse - logits[np.arange(n), label]
+            avgloss = losses.sum() / n if n > 0 else 0.
+            return (avgloss, lse)
+
+        op = core.CreateOperator(
+            "ChunkedSoftmaxWithLoss",
+            ["X", "W", "b", "label"],
+            ["avgloss", "lse"],
+            chunk_size=chunk_size,
+        )
+
+        self.assertReferenceChecks(
+            device_option=gc,
+            op=op,
+            inputs=[X, W, b, label],
+            reference=fc_softmax_crossent,
+        )
+
+        if n > 0:
+            for i in range(3):
+                self.assertGradientChecks(
+                    gc, op, [X, W, b, label], i, [0],
+                    stepsize=1e-3, threshold=1e-2)
+
     @unittest.skipIf(not workspace.has_gpu_support, "No gpu support")
     def test_compare_cpugpu(self):
         '''
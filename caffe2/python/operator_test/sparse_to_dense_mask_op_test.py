@@ -13,7 +13,7 @@ import numpy as np
 class TestFcOperator(hu.HypothesisTestCase):
 
     @given(n=st.integers(1, 10), k=st.integers(1, 5),
-           use_length=st.booleans(), **hu.gcs_cpu_only)
+           use_length=st.booleans(), **hu.gcs)
     def test_sparse_to_dense_mask(self, n, k, use_length, gc, dc):
         lengths = np.random.randint(k, size=n).astype(np.int32) + 1
         N = sum(lengths)
@@ -40,12 +40,12 @@ class TestFcOperator(hu.HypothesisTestCase):
         # Check over multiple devices
         self.assertDeviceChecks(
             dc, op, input_data, [0])
-        # Gradient check for values
+        # Gradient check for values, which only run on the CPU
         self.assertGradientChecks(
-            gc, op, input_data, 1, [0])
+            hu.cpu_do, op, input_data, 1, [0])
 
     @given(n=st.integers(1, 10), k=st.integers(1, 5),
-           use_length=st.booleans(), **hu.gcs_cpu_only)
+           use_length=st.booleans(), **hu.gcs)
     def test_sparse_to_dense_mask_with_int64(self, n, k, use_length, gc, dc):
         lengths = np.random.randint(k, size=n).astype(np.int32) + 1
         N = sum(lengths)
@@ -73,12 +73,12 @@ class TestFcOperator(hu.HypothesisTestCase):
         # Check over multiple devices
         self.assertDeviceChecks(
             dc, op, input_data, [0])
-        # Gradient check for values
+        # Gradient check for values, which only run on the CPU
         self.assertGradientChecks(
-            gc, op, input_data, 1, [0])
+            hu.cpu_do, op, input_data, 1, [0])
 
     @given(n=st.integers(1, 10), k=st.integers(1, 5),
-           dim=st.integers(1, 3), **hu.gcs_cpu_only)
+           dim=st.integers(1, 3), **hu.gcs)
     def test_sparse_to_dense_mask_high_dim(self, n, k, dim, gc, dc):
         lengths = np.random.randint(k, size=n).astype(np.int32) + 1
         N = sum(lengths)
@@ -99,9 +99,9 @@ class TestFcOperator(hu.HypothesisTestCase):
         # Check over multiple devices
         self.assertDeviceChecks(
             dc, op, [indices, values, default, lengths], [0])
-        # Gradient check for values
+        # Gradient check for values, which only run on the CPU
         self.assertGradientChecks(
-            gc, op, [indices, values, default, lengths], 1, [0])
+            hu.cpu_do, op, [indices, values, default, lengths], 1, [0])
 
 
 if __name__ == "__main__":
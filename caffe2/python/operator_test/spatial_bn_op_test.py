@@ -183,6 +183,56 @@ class TestSpatialBN(hu.HypothesisTestCase):
         self.assertDeviceChecks(dc, op, [X, scale, bias, mean, var],
                                 [0, 1, 2, 3, 4])
 
+    @given(size=st.integers(7, 10),
+           input_channels=st.integers(1, 10),
+           batch_size=st.integers(1, 3),
+           seed=st.integers(0, 65535),
+           order=st.sampled_from(["NCHW", "NHWC"]),
+           epsilon=st.floats(1e-5, 1e-2),
+           fuse_relu=st.booleans(),
+           **hu.gcs_cpu_only)
+    def test_spatialbn_train_mode_reference(
+            self, size, input_channels, batch_size, seed, order, epsilon,
+            fuse_relu, gc, dc):
+        op = core.CreateOperator(
+            "SpatialBN",
+            ["X", "scale", "bias", "running_mean", "running_var"],
+            ["Y", "running_mean", "running_var", "saved_mean", "saved_var"],
+            order=order,
+            is_test=False,
+            epsilon=epsilon,
+            momentum=0.9,
+            fuse_relu=fuse_relu,
+        )
+
+        def reference_spatialbn_train(X, scale, bias, running_mean,
+                                      running_var):
+            axes = (0, 2, 3) if order == "NCHW" else (0, 1, 2)
+            shape = (1, -1, 1, 1) if order == "NCHW" else (1, 1, 1, -1)
+            mean = X.mean(axis=axes)
+            var = X.var(axis=axes)
+            inv_std = 1.0 / np.sqrt(var + epsilon)
+            Y = (X - mean.reshape(shape)) * inv_std.reshape(shape) * \
+                scale.reshape(shape) + bias.reshape(shape)
+            if fuse_relu:
+                Y = np.maximum(Y, 0)
+            return (Y, running_mean * 0.9 + mean * 0.1,
+                    running_var * 0.9 + var * 0.1, mean, inv_std)
+
+        np.random.seed(seed)
+        scale = np.random.rand(input_channels).astype(np.float32) + 0.5
+        bias = np.random.rand(input_channels).astype(np.float32) - 0.5
+        mean = np.random.randn(input_channels).astype(np.float32)
+        var = np.random.rand(input_channels).astype(np.float32) + 0.5
+        # Offset the input so that the variance does not come for free.
+        X = np.random.rand(
+            batch_size, input_channels, size, size).astype(np.float32) + 10
+        if order == "NHWC":
+            X = X.swapaxes(1, 2).swapaxes(2, 3)
+
+        self.assertReferenceChecks(gc, op, [X, scale, bias, mean, var],
+                                   reference_spatialbn_train)
+
     @given(size=st.integers(7, 10),
            input_channels=st.integers(1, 10),
            batch_size=st.integers(0, 3),
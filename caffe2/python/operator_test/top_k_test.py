@@ -191,6 +191,26 @@ class TestTopK(hu.HypothesisTestCase):
         self.assertReferenceChecks(gc, op, [X], bind_ref)
         self.assertDeviceChecks(dc, op, [X], [0])
 
+    @given(bs=st.integers(10, 50), n=st.integers(600, 2000),
+           flatten_indices=st.booleans(), **hu.gcs)
+    def test_top_k_7(self, bs, n, flatten_indices, gc, dc):
+        # Many rows with k >= 512, which are sorted by one segmented sort on
+        # GPU after the radix selection
+        k = np.random.randint(512, n)
+        X = np.random.rand(bs, n).astype(dtype=np.float32)
+
+        output_list = ["Values", "Indices"]
+        if flatten_indices:
+            output_list.append("FlattenIndices")
+        op = core.CreateOperator("TopK", ["X"], output_list,
+                                 k=k, device_option=gc)
+
+        def bind_ref(X_loc):
+            return self.top_k_ref(X_loc, k, flatten_indices)
+
+        self.assertReferenceChecks(gc, op, [X], bind_ref)
+        self.assertDeviceChecks(dc, op, [X], [0])
+
     @given(X=hu.tensor(dtype=np.float32), k=st.integers(1, 5),
            axis=st.integers(-1, 5), flatten_indices=st.booleans(),
            **hu.gcs)
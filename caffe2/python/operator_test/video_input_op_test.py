@@ -15,7 +15,7 @@ import shutil
 import tempfile
 
 from caffe2.proto import caffe2_pb2
-from caffe2.python import workspace, model_helper
+from caffe2.python import core, workspace, model_helper
 import numpy as np
 
 
@@ -114,6 +114,96 @@ class VideoInputOpTest(unittest.TestCase):
         os.remove(temp_list)
         shutil.rmtree(video_db_dir)
 
+    # sample clips randomly with a keyframe index and a decode cache, twice
+    # so that the second run can be served from the cache
+    def test_rgb_with_temporal_jittering_and_decode_cache(self):
+        random_label = np.random.randint(0, 100)
+        VIDEO = "/mnt/vol/gfsdataswarm-oregon/users/trandu/sample.avi"
+        if not os.path.exists(VIDEO):
+            raise unittest.SkipTest('Missing data')
+        temp_list = tempfile.NamedTemporaryFile(delete=False).name
+        line_str = '{} 0 {}\n'.format(VIDEO, random_label)
+        self.create_a_list(temp_list, line_str, 16)
+        video_db_dir = tempfile.mkdtemp()
+
+        self.create_video_db(temp_list, video_db_dir)
+        model = model_helper.ModelHelper(name="Video Loader from LMDB")
+        reader = model.CreateDB("sample", db=video_db_dir, db_type="lmdb")
+
+        # build the model
+        model.net.VideoInput(
+            reader,
+            ["data", "label"],
+            name="data",
+            batch_size=8,
+            clip_per_video=1,
+            crop_size=112,
+            scale_w=171,
+            scale_h=128,
+            length_rgb=8,
+            sampling_rate_rgb=1,
+            decode_type=0,
+            video_res_type=0,
+            use_keyframe_index=True,
+            decode_cache_size_mb=64)
+
+        workspace.RunNetOnce(model.param_init_net)
+        workspace.CreateNet(model.net)
+        for _ in range(2):
+            workspace.RunNet(model.net.Proto().name)
+            data = workspace.FetchBlob("data")
+            label = workspace.FetchBlob("label")
+
+            np.testing.assert_equal(label, random_label)
+            np.testing.assert_equal(data.shape, [8, 3, 8, 112, 112])
+        os.remove(temp_list)
+        shutil.rmtree(video_db_dir)
+
+    # transform the rgb clips on the GPU, which should give the same shape as
+    # the CPU transform
+    @unittest.skipIf(not workspace.has_gpu_support, "No gpu support")
+    def test_rgb_with_gpu_transform(self):
+        random_label = np.random.randint(0, 100)
+        VIDEO = "/mnt/vol/gfsdataswarm-oregon/users/trandu/sample.avi"
+        if not os.path.exists(VIDEO):
+            raise unittest.SkipTest('Missing data')
+        temp_list = tempfile.NamedTemporaryFile(delete=False).name
+        line_str = '{} 0 {}\n'.format(VIDEO, random_label)
+        self.create_a_list(temp_list, line_str, 16)
+        video_db_dir = tempfile.mkdtemp()
+
+        self.create_video_db(temp_list, video_db_dir)
+        model = model_helper.ModelHelper(name="Video Loader from LMDB")
+        reader = model.CreateDB("sample", db=video_db_dir, db_type="lmdb")
+
+        # build the model
+        with core.DeviceScope(core.DeviceOption(caffe2_pb2.CUDA, 0)):
+            model.net.VideoInput(
+                reader,
+                ["data", "label"],
+                name="data",
+                batch_size=8,
+                clip_per_video=1,
+                crop_size=112,
+                scale_w=171,
+                scale_h=128,
+                length_rgb=8,
+                sampling_rate_rgb=1,
+                decode_type=0,
+                video_res_type=0,
+                use_gpu_transform=True)
+
+        workspace.RunNetOnce(model.param_init_net)
+        workspace.RunNetOnce(model.net)
+        data = workspace.FetchBlob("data")
+        label = workspace.FetchBlob("label")
+
+        np.testing.assert_equal(label, random_label)
+        np.testing.assert_equal(data.dtype, np.float32)
+        np.testing.assert_equal(data.shape, [8, 3, 8, 112, 112])
+        os.remove(temp_list)
+        shutil.rmtree(video_db_dir)
+
     # sample multiple clips uniformly from the video
     def test_rgb_with_uniform_sampling(self):
         random_label = np.random.randint(0, 100)
@@ -13,6 +13,7 @@
 #include "caffe2/core/stats.h"
 #include "caffe2/core/transform.h"
 #include "caffe2/mkl/mkl_utils.h"
+#include "caffe2/observers/perf_counter_observer.h"
 #include "caffe2/observers/runcnt_observer.h"
 #include "caffe2/observers/time_observer.h"
 #include "caffe2/onnx/backend.h"
@@ -166,12 +167,13 @@ const Func& getGradientFunc(const std::string& token) {
   return getOpFunc(token + "_gradient");
 }
 
-py::object fetchBlob(Workspace* ws, const std::string& name) {
+py::object
+fetchBlob(Workspace* ws, const std::string& name, bool zero_copy) {
   CAFFE_ENFORCE(ws->HasBlob(name), "Can't find blob: ", name);
   const caffe2::Blob& blob = *(ws->GetBlob(name));
   auto fetcher = CreateFetcher(blob.meta().id());
   if (fetcher) {
-    return fetcher->Fetch(blob);
+    return zero_copy ? fetcher->FetchView(blob) : fetcher->Fetch(blob);
   } else {
     // If there is no fetcher registered, return a metainfo string.
     // If all branches failed, we will return a metainfo string.
@@ -459,7 +461,11 @@ void addObjectMethods(py::module& m) {
             return py::cast(self->CreateBlob(name));
           },
           py::return_value_policy::reference_internal)
-      .def("fetch_blob", &python_detail::fetchBlob)
+      .def(
+          "fetch_blob",
+          &python_detail::fetchBlob,
+          py::arg("name"),
+          py::arg("zero_copy") = kPyBindFalse)
       .def(
           "has_blob",
           [](Workspace* self, const std::string& name) {
@@ -748,11 +754,19 @@ void addObjectMethods(py::module& m) {
           [](caffe2::onnx::Caffe2Backend& instance,
              const py::bytes& onnx_model_str,
              const std::string& device,
-             const std::vector<caffe2::onnx::Caffe2Ops>& extras) {
+             const std::vector<caffe2::onnx::Caffe2Ops>& extras,
+             const std::string& external_data_dir) {
             auto* rep = instance.Prepare(
-                onnx_model_str.cast<std::string>(), device, extras);
+                onnx_model_str.cast<std::string>(),
+                device,
+                extras,
+                external_data_dir);
             return rep;
-          })
+          },
+          py::arg("onnx_model_str"),
+          py::arg("device"),
+          py::arg("extras"),
+          py::arg("external_data_dir") = "")
       .def(
           "convert_node",
           [](caffe2::onnx::Caffe2Backend& instance,
@@ -1086,6 +1100,7 @@ void addGlobalMethods(py::module& m) {
   }
 
         REGISTER_PYTHON_EXPOSED_OBSERVER(TimeObserver);
+        REGISTER_PYTHON_EXPOSED_OBSERVER(PerfCounterObserver);
 #undef REGISTER_PYTHON_EXPOSED_OBSERVER
 
         if (observer_type.compare("RunCountObserver") == 0) {
@@ -1108,6 +1123,9 @@ void addGlobalMethods(py::module& m) {
         NetBase* net = gWorkspace->GetNet(net_name);
         net->DetachObserver(observer);
       });
+  m.def("set_perf_counters_enabled", [](bool enabled) {
+    PerfCounterObserver::SetEnabled(enabled);
+  });
   m.def("num_observers_on_net", [](const std::string& net_name) {
     CAFFE_ENFORCE(gWorkspace);
     CAFFE_ENFORCE(gWorkspace->GetNet(net_name), "Can't find net ", net_name);
@@ -1316,12 +1334,19 @@ void addGlobalMethods(py::module& m) {
     CAFFE_ENFORCE(gWorkspace->CreateBlob(name));
     return true;
   });
-  m.def("fetch_blob", [](const std::string& name) -> py::object {
-    return python_detail::fetchBlob(gWorkspace, name);
-  });
+  m.def(
+      "fetch_blob",
+      [](const std::string& name, bool zero_copy) -> py::object {
+        return python_detail::fetchBlob(gWorkspace, name, zero_copy);
+      },
+      py::arg("name"),
+      py::arg("zero_copy") = kPyBindFalse);
   m.def(
       "feed_blob",
-      [](const std::string& name, py::object arg, py::object device_option) {
+      [](const std::string& name,
+         py::object arg,
+         py::object device_option,
+         bool zero_copy) {
         DeviceOption option;
         if (!device_option.is(py::none())) {
           // If we have a device option passed in, read it.
@@ -1336,7 +1361,11 @@ void addGlobalMethods(py::module& m) {
               feeder,
               "Unknown device type encountered in FeedBlob: ",
               option.device_type());
-          feeder->Feed(option, array, blob);
+          if (zero_copy) {
+            feeder->FeedZeroCopy(option, array, blob);
+          } else {
+            feeder->Feed(option, array, blob);
+          }
           return true;
         }
         if (PyBytes_Check(arg.ptr()) || PyUnicode_Check(arg.ptr())) { // string
@@ -1351,7 +1380,8 @@ void addGlobalMethods(py::module& m) {
       "",
       py::arg("name"),
       py::arg("arg"),
-      py::arg("device_option") = py::none());
+      py::arg("device_option") = py::none(),
+      py::arg("zero_copy") = kPyBindFalse);
   m.def("serialize_blob", [](const std::string& name) {
     CAFFE_ENFORCE(gWorkspace);
     auto* blob = gWorkspace->GetBlob(name);
@@ -1440,6 +1470,12 @@ void addGlobalMethods(py::module& m) {
     CAFFE_ENFORCE(blob);
     return BlobStat::sizeBytes(*blob);
   });
+  m.def("get_blob_num_allocations", [](const std::string& blob_name) {
+    CAFFE_ENFORCE(gWorkspace);
+    auto* blob = gWorkspace->GetBlob(blob_name);
+    CAFFE_ENFORCE(blob);
+    return BlobStat::numAllocations(*blob);
+  });
   m.def("support_onnx_export", [](const std::string& op) -> bool {
     const OpSchema* schema = caffe2::OpSchemaRegistry::Schema(op);
     if (!schema) {
@@ -1540,6 +1576,9 @@ void addGlobalMethods(py::module& m) {
     auto nn = caffe2::convertToNNModule(proto);
     opt::OptimizeForIdeep(&nn, gWorkspace, training_mode);
     auto new_proto = caffe2::convertToCaffe2Proto(nn, proto);
+    if (!training_mode) {
+      opt::PlanFallbackReordersForIdeep(&new_proto);
+    }
 
     std::string out;
     new_proto.SerializeToString(&out);
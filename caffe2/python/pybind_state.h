@@ -51,6 +51,11 @@ class CAFFE2_EXPORT BlobFetcherBase {
   };
   virtual ~BlobFetcherBase();
   virtual pybind11::object Fetch(const Blob& blob) = 0;
+  // Returns a numpy array sharing the blob's memory if the fetcher can, and
+  // a copy otherwise. Fetchers that cannot share memory need not override it.
+  virtual pybind11::object FetchView(const Blob& blob) {
+    return Fetch(blob);
+  }
 };
 
 class BlobFeederBase {
@@ -58,6 +63,12 @@ class BlobFeederBase {
   virtual ~BlobFeederBase();
   virtual void
   Feed(const DeviceOption& option, PyArrayObject* array, Blob* blob) = 0;
+  // Like Feed, but lets the blob use the array's buffer as its storage where
+  // the feeder supports it. Feeders that always copy need not override it.
+  virtual void
+  FeedZeroCopy(const DeviceOption& option, PyArrayObject* array, Blob* blob) {
+    Feed(option, array, blob);
+  }
 };
 
 CAFFE2_EXPORT CAFFE_DECLARE_TYPED_REGISTRY(
@@ -97,6 +108,10 @@ class TensorFetcher : public BlobFetcherBase {
     return FetchTensor(blob.Get<Tensor<Context>>(), true).obj;
   }
 
+  pybind11::object FetchView(const Blob& blob) override {
+    return FetchTensor(blob.Get<Tensor<Context>>(), false).obj;
+  }
+
   bool NeedsCopy(const TypeMeta& meta) const {
     return !std::is_same<Context, CPUContext>::value ||
         CaffeToNumpyType(meta) == NPY_OBJECT;
@@ -126,6 +141,26 @@ class TensorFetcher : public BlobFetcherBase {
       outPtr = const_cast<Tensor<Context>&>(tensor).raw_mutable_data();
       result.obj = py::reinterpret_steal<py::object>(PyArray_SimpleNewFromData(
           tensor.ndim(), npy_dims.data(), numpy_type, outPtr));
+      // The view holds a reference to the tensor's storage through its base
+      // object, so it stays valid after the tensor is resized, reset or
+      // deleted. It only stops seeing the tensor's writes once the tensor
+      // reallocates. Storage shared from an external pointer without a
+      // deleter is not owned by the tensor and cannot be kept alive.
+      auto* storage = new Tensor<Context>(tensor.dims());
+      storage->ShareData(tensor);
+      PyObject* base = PyCapsule_New(storage, nullptr, [](PyObject* capsule) {
+        delete static_cast<Tensor<Context>*>(
+            PyCapsule_GetPointer(capsule, nullptr));
+      });
+      if (!base) {
+        delete storage;
+        CAFFE_THROW("Failed to create the base object of a numpy view.");
+      }
+      // PyArray_SetBaseObject steals the reference to base, also on failure.
+      CAFFE_ENFORCE_EQ(
+          PyArray_SetBaseObject(
+              reinterpret_cast<PyArrayObject*>(result.obj.ptr()), base),
+          0);
     }
 
     if (numpy_type == NPY_OBJECT) {
@@ -158,10 +193,16 @@ class TensorFetcher : public BlobFetcherBase {
 template <class Context>
 class TensorFeeder : public BlobFeederBase {
  public:
+  // With zero_copy, a CPU tensor shares the buffer of a writeable, aligned
+  // numeric array instead of copying it (non-contiguous arrays are made
+  // contiguous first, and the tensor shares that copy). The tensor holds a
+  // reference to the array until it reallocates or is destroyed, and writes
+  // through either one are visible to the other. Other arrays are copied.
   void FeedTensor(
       const DeviceOption& option,
       PyArrayObject* original_array,
-      Tensor<Context>* tensor) {
+      Tensor<Context>* tensor,
+      bool zero_copy = false) {
     PyArrayObject* array = PyArray_GETCONTIGUOUS(original_array);
     auto g = MakeGuard([&]() { Py_XDECREF(array); });
 
@@ -183,6 +224,27 @@ class TensorFeeder : public BlobFeederBase {
     }
     tensor->Resize(dims);
 
+    if (zero_copy && std::is_same<Context, CPUContext>::value &&
+        npy_type != NPY_OBJECT && npy_type != NPY_UNICODE &&
+        PyArray_ISWRITEABLE(array) && PyArray_ISALIGNED(array)) {
+      PyArrayObject* owner = array;
+      tensor->ShareExternalPointer(
+          PyArray_DATA(array),
+          meta,
+          PyArray_NBYTES(array),
+          [owner](void*) {
+            // The interpreter may be gone when a workspace is destroyed at
+            // exit, in which case the array has been freed with it.
+            if (Py_IsInitialized()) {
+              py::gil_scoped_acquire g;
+              Py_DECREF(owner);
+            }
+          });
+      // The deleter owns the reference from PyArray_GETCONTIGUOUS now.
+      array = nullptr;
+      return;
+    }
+
     // Now, copy the data to the tensor.
     switch (npy_type) {
       case NPY_OBJECT: {
@@ -232,6 +294,14 @@ class TensorFeeder : public BlobFeederBase {
   Feed(const DeviceOption& option, PyArrayObject* original_array, Blob* blob) {
     FeedTensor(option, original_array, blob->GetMutable<Tensor<Context>>());
   }
+
+  void FeedZeroCopy(
+      const DeviceOption& option,
+      PyArrayObject* original_array,
+      Blob* blob) override {
+    FeedTensor(
+        option, original_array, blob->GetMutable<Tensor<Context>>(), true);
+  }
 };
 
 namespace python_detail {
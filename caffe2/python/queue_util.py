@@ -74,24 +74,34 @@ class QueueWrapper(dataio.Pipe):
 
 class Queue(QueueWrapper):
     def __init__(self, capacity, schema=None, name='queue',
-                 num_dequeue_records=1):
+                 num_dequeue_records=1, mode=None):
+        """
+        mode is the synchronization mode of the BlobsQueue (see the mode
+        argument of CreateBlobsQueue); 'spsc' requires that the queue has a
+        single reader and a single writer.
+        """
         # find a unique blob name for the queue
         net = core.Net(name)
         queue_blob = net.AddExternalInput(net.NextName('handler'))
         QueueWrapper.__init__(
             self, queue_blob, schema, num_dequeue_records=num_dequeue_records)
         self.capacity = capacity
+        self.mode = mode
         self._setup_done = False
 
     def setup(self, global_init_net):
         assert self._schema, 'This queue does not have a schema.'
         self._setup_done = True
+        kwargs = {}
+        if self.mode is not None:
+            kwargs['mode'] = self.mode
         global_init_net.CreateBlobsQueue(
             [],
             [self._queue],
             capacity=self.capacity,
             num_blobs=len(self._schema.field_names()),
-            field_names=self._schema.field_names())
+            field_names=self._schema.field_names(),
+            **kwargs)
 
 
 def enqueue(net, queue, data_blobs, status=None):
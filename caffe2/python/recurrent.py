@@ -286,7 +286,17 @@ def recurrent_net(
     return results[:-1]
 
 
-def set_rnn_executor_config(rnn_op, num_threads=None, max_cuda_streams=None):
+def set_rnn_executor_config(rnn_op, num_threads=None, max_cuda_streams=None,
+                            wavefront=None, max_parallelism=None):
+    '''
+    wavefront: if true, the RNN executor starts timesteps as soon as the
+    dependencies between their ops allow, e.g. step t of layer l + 1 along
+    with step t + 1 of layer l of a multi-layer LSTM, and runs as many
+    timesteps at the same time as the layers allow.
+
+    max_parallelism: maximum number of timesteps the RNN executor runs at the
+    same time.
+    '''
     from caffe2.proto import caffe2_pb2
     assert rnn_op.type in {'RecurrentNetwork', 'RecurrentNetworkGradient'}
 
@@ -300,6 +310,10 @@ def set_rnn_executor_config(rnn_op, num_threads=None, max_cuda_streams=None):
         add_arg('num_threads', num_threads)
     if max_cuda_streams is not None:
         add_arg('max_cuda_streams', max_cuda_streams)
+    if wavefront is not None:
+        add_arg('wavefront', int(wavefront))
+    if max_parallelism is not None:
+        add_arg('max_parallelism', max_parallelism)
 
 
 def retrieve_step_blobs(net, prefix='rnn'):
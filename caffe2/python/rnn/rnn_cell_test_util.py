@@ -3,7 +3,7 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
-from caffe2.python import workspace, scope
+from caffe2.python import core, workspace, scope
 from caffe2.python.model_helper import ModelHelper
 
 import numpy as np
@@ -73,3 +73,47 @@ def _prepare_rnn(
         np.random.randint(1, t + 1, size=(n,)).astype(np.int32)
     )
     return outputs, model.net, states + [input_blob]
+
+
+def _compare_fused_rnn(test, t, n, dim_in, create_rnn, fused_op, seed, gc,
+                       **kwargs):
+    '''
+    Checks that the forward only create_rnn with fused=True runs as a single
+    fused_op with the same outputs (and names) as the one over a
+    RecurrentNetwork, for the same parameters, states and inputs.
+    '''
+    results = []
+    params = {}
+    for fused in [False, True]:
+        np.random.seed(seed)
+        with core.DeviceScope(gc):
+            outputs, net, inputs = _prepare_rnn(
+                t, n, dim_in, create_rnn,
+                outputs_with_grads=[0],
+                forward_only=True,
+                fused=fused,
+                **kwargs
+            )
+        op_types = [op.type for op in net.Proto().op]
+        test.assertEqual(fused_op in op_types, fused)
+        test.assertEqual('RecurrentNetwork' in op_types, not fused)
+        if not fused:
+            params = {
+                blob: workspace.FetchBlob(blob) for blob in workspace.Blobs()
+                if blob.endswith('_w') or blob.endswith('_b')
+            }
+        else:
+            for blob, value in params.items():
+                workspace.FeedBlob(blob, value, device_option=gc)
+        workspace.FeedBlob(
+            inputs[-1],
+            np.random.randn(t, n, dim_in).astype(np.float32),
+            device_option=gc,
+        )
+        workspace.RunNetOnce(net)
+        results.append(
+            [(str(o), workspace.FetchBlob(o)) for o in outputs])
+
+    for (name, value), (fused_name, fused_value) in zip(*results):
+        test.assertEqual(name, fused_name)
+        np.testing.assert_allclose(value, fused_value, atol=1e-4, rtol=1e-4)
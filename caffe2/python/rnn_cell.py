@@ -25,7 +25,10 @@ from caffe2.python.attention import (
 from caffe2.python import core, recurrent, workspace, brew, scope, utils
 from caffe2.python.modeling.parameter_sharing import ParameterSharing
 from caffe2.python.modeling.parameter_info import ParameterTags
-from caffe2.python.modeling.initializers import Initializer
+from caffe2.python.modeling.initializers import (
+    ExternalInitializer,
+    Initializer,
+)
 from caffe2.python.model_helper import ModelHelper
 
 
@@ -91,6 +94,20 @@ class RNNCell(object):
                 initial_states = self.initializer.create_states(model)
 
         preprocessed_inputs = self.prepare_input(model, inputs)
+        if self.forward_only:
+            states_for_all_steps = self._apply_fused_over_sequence(
+                model=model,
+                inputs=preprocessed_inputs,
+                seq_lengths=seq_lengths,
+                initial_states=initial_states,
+            )
+            if states_for_all_steps is not None:
+                output = self._prepare_output_sequence(
+                    model,
+                    states_for_all_steps,
+                )
+                return output, states_for_all_steps
+
         step_model = ModelHelper(name=self.name, param_model=model)
         input_t, timestep = step_model.net.AddScopedExternalInputs(
             'input_t',
@@ -142,6 +159,20 @@ class RNNCell(object):
         )
         return output, states_for_all_steps
 
+    def _apply_fused_over_sequence(
+        self, model, inputs, seq_lengths, initial_states
+    ):
+        '''
+        Override this function in cells that can run a whole forward only
+        sequence as a single operator instead of a RecurrentNetwork.
+
+        inputs is the output of prepare_input. Returns the same
+        (state_1_all, state_1_final, state_2_all, state_2_final, ...) the
+        RecurrentNetwork would, with the same names and over the same
+        parameters, or None to use the RecurrentNetwork.
+        '''
+        return None
+
     def apply(self, model, input_t, seq_lengths, states, timestep):
         input_t = self.prepare_input(model, input_t)
         states = self._apply(
@@ -271,6 +302,31 @@ class RNNCell(object):
         return state_outputs[output_sequence_index]
 
 
+def _create_fc_params(model, blob_out, dim_in, dim_out):
+    '''
+    Creates the weights and the bias brew.fc would create for an FC with
+    output blob_out on a step model of model.
+    '''
+    weight_initializer = Initializer("XavierFill")
+    bias_initializer = Initializer("ConstantFill")
+    if not model.init_params:
+        weight_initializer = ExternalInitializer()
+        bias_initializer = ExternalInitializer()
+    weight = model.create_param(
+        param_name=blob_out + '_w',
+        shape=[dim_out, dim_in],
+        initializer=weight_initializer,
+        tags=ParameterTags.WEIGHT,
+    )
+    bias = model.create_param(
+        param_name=blob_out + '_b',
+        shape=[dim_out, ],
+        initializer=bias_initializer,
+        tags=ParameterTags.BIAS,
+    )
+    return weight, bias
+
+
 class LSTMInitializer(object):
     def __init__(self, hidden_size):
         self.hidden_size = hidden_size
@@ -404,6 +460,7 @@ class LSTMCell(RNNCell):
         memory_optimization,
         drop_states=False,
         initializer=None,
+        fused=False,
         **kwargs
     ):
         super(LSTMCell, self).__init__(initializer=initializer, **kwargs)
@@ -416,6 +473,7 @@ class LSTMCell(RNNCell):
         self.memory_optimization = memory_optimization
         self.drop_states = drop_states
         self.gates_size = 4 * self.hidden_size
+        self.fused = fused
 
     def apply_override(
         self,
@@ -469,6 +527,35 @@ class LSTMCell(RNNCell):
 
         return hidden_t, cell_t
 
+    def _apply_fused_over_sequence(
+        self, model, inputs, seq_lengths, initial_states
+    ):
+        # Subclasses change the step, only the one of LSTMCell is fused.
+        if not self.fused or type(self) is not LSTMCell:
+            return None
+
+        with core.NameScope(self.name):
+            weight, bias = _create_fc_params(
+                model, 'gates_t', self.hidden_size, self.gates_size)
+            hidden_t = core.ScopedBlobReference('hidden_state')
+            cell_t = core.ScopedBlobReference('cell_state')
+
+        op_inputs = [inputs] + list(initial_states) + [weight, bias]
+        if seq_lengths is not None:
+            op_inputs.append(seq_lengths)
+        return model.net.FusedLSTMSequence(
+            op_inputs,
+            [
+                str(hidden_t) + '_all',
+                str(hidden_t) + '_last',
+                str(cell_t) + '_all',
+                str(cell_t) + '_last',
+            ],
+            forget_bias=self.forget_bias,
+            drop_states=self.drop_states,
+            sequence_lengths=(seq_lengths is not None),
+        )
+
     def get_input_params(self):
         return {
             'weights': self.scope('i2h') + '_w',
@@ -1532,6 +1619,11 @@ def _LSTM(
     static_rnn_unroll_size: if not None, we will use static RNN which is
     unrolled into Caffe2 graph. The size of the unroll is the value of
     this parameter.
+
+    cell_kwargs: passed to cell_class. With forward_only, fused=True runs a
+    single layer LSTM (or GRU with linear_before_reset) as one
+    FusedLSTMSequence (or FusedGRUSequence) operator instead of a
+    RecurrentNetwork, over the same parameters.
     '''
     if type(dim_out) is not list and type(dim_out) is not tuple:
         dim_out = [dim_out]
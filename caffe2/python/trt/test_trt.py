@@ -79,7 +79,8 @@ def _download_onnx_model(model_name):
     return model_dir
 
 class TensorRTOpTest(TestCase):
-    def _test_relu_graph(self, X, batch_size, trt_max_batch_size):
+    def _test_relu_graph(self, X, batch_size, trt_max_batch_size,
+                         batch_size_buckets=None):
         node_def = make_node("Relu", ["X"], ["Y"])
         Y_c2 = c2.run_node(node_def, {"X": X})
         graph_def = make_graph(
@@ -89,7 +90,10 @@ class TensorRTOpTest(TestCase):
             outputs=[make_tensor_value_info("Y", onnx.TensorProto.FLOAT, [batch_size, 1, 3, 2])])
         model_def = make_model(graph_def, producer_name='relu-test')
         op_outputs = [x.name for x in model_def.graph.output]
-        op = convert_onnx_model_to_trt_op(model_def, max_batch_size=trt_max_batch_size)
+        op = convert_onnx_model_to_trt_op(
+            model_def,
+            max_batch_size=trt_max_batch_size,
+            batch_size_buckets=batch_size_buckets)
         device_option = core.DeviceOption(caffe2_pb2.CUDA, 0)
         op.device_option.CopyFrom(device_option)
         Y_trt = None
@@ -113,6 +117,12 @@ class TensorRTOpTest(TestCase):
         X = np.random.randn(52, 1, 3, 2).astype(np.float32)
         self._test_relu_graph(X, 52, 50)
 
+
+    @unittest.skipIf(not workspace.C.use_trt, "No TensortRT support")
+    def test_relu_graph_batch_size_buckets(self):
+        X = np.random.randn(21, 1, 3, 2).astype(np.float32)
+        self._test_relu_graph(X, 21, 16, batch_size_buckets=[4, 16])
+
     def _test_onnx_importer(self, model_name, data_input_index = 0):
         model_dir = _download_onnx_model(model_name)
         model_def = onnx.load(os.path.join(model_dir, 'model.onnx'))
@@ -38,9 +38,11 @@ def convert_onnx_model_to_trt_op(onnx_model,
         max_batch_size=50,
         max_workspace_size=2*1024*1024,
         verbosity=1,
-        debug_builder=False):
+        debug_builder=False,
+        batch_size_buckets=None):
     """
-    Convert the whole ONNX model to a TensorRT C2 op
+    Convert the whole ONNX model to a TensorRT C2 op, with an engine per batch
+    size of batch_size_buckets if given
     """
     check_gpu_()
     trt_str = C.onnx_to_trt_op(onnx_model.SerializeToString(),
@@ -48,7 +50,8 @@ def convert_onnx_model_to_trt_op(onnx_model,
                                max_batch_size,
                                max_workspace_size,
                                verbosity,
-                               debug_builder)
+                               debug_builder,
+                               list(batch_size_buckets or []))
     op = caffe2_pb2.OperatorDef()
     op.ParseFromString(trt_str)
     return op
@@ -78,7 +81,8 @@ def transform_caffe2_net(
         max_workspace_size=2*1024*1024,
         verbosity=1,
         debug_builder=False,
-        build_serializable_op=True):
+        build_serializable_op=True,
+        batch_size_buckets=None):
     """
     Transfrom the caffe2_net by collapsing TRT-runnable nodes into trt c2 ops
     """
@@ -101,7 +105,8 @@ def transform_caffe2_net(
                                    max_workspace_size,
                                    verbosity,
                                    debug_builder,
-                                   build_serializable_op)
+                                   build_serializable_op,
+                                   list(batch_size_buckets or []))
     pred_net_cut = caffe2_pb2.NetDef()
     pred_net_cut.ParseFromString(pred_net_str)
     return pred_net_cut
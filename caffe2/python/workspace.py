@@ -62,6 +62,29 @@ IsNUMAEnabled = C.is_numa_enabled
 GetNumNUMANodes = C.get_num_numa_nodes
 GetBlobNUMANode = C.get_blob_numa_node
 GetBlobSizeBytes = C.get_blob_size_bytes
+GetBlobNumAllocations = C.get_blob_num_allocations
+
+
+def GetGPUFallbackReport():
+    """Returns the stats of the CUDA operators that run on the CPU.
+
+    The result is a list of (operator type, stats) pairs, sorted by total time,
+    for every operator type that ran through GPUFallbackOp. The stats are the
+    runs, the bytes copied to and from the CPU, and the host time spent copying
+    and running in nanoseconds.
+    """
+    prefix = 'gpu_fallback/'
+    report = defaultdict(dict)
+    for key, value in GetStats().items():
+        if key.startswith(prefix):
+            op_type, stat = key[len(prefix):].rsplit('/', 1)
+            report[op_type][stat] = value
+    for stats in report.values():
+        stats['total_time_ns'] = (
+            stats.get('input_copy_time_ns', 0) + stats.get('run_time_ns', 0) +
+            stats.get('output_copy_time_ns', 0))
+    return sorted(report.items(), key=lambda item: -item[1]['total_time_ns'])
+
 
 def _GetFreeFlaskPort():
     """Get a free flask port."""
@@ -287,7 +310,7 @@ def GetNetName(net):
     raise Exception("Not a Net object: {}".format(str(net)))
 
 
-def FeedBlob(name, arr, device_option=None):
+def FeedBlob(name, arr, device_option=None, zero_copy=False):
     """Feeds a blob into the workspace.
 
     Inputs:
@@ -295,6 +318,11 @@ def FeedBlob(name, arr, device_option=None):
       arr: either a TensorProto object or a numpy array object to be fed into
           the workspace.
       device_option (optional): the device option to feed the data with.
+      zero_copy (optional): if True and the blob is fed on CPU from a
+          writeable, aligned numeric array, the blob uses the array's buffer
+          as its storage instead of a copy. The blob keeps the array alive
+          until it reallocates or is reset, and writes through either one
+          are visible to the other. Other arrays are copied as usual.
     Returns:
       True or False, stating whether the feed is successful.
     """
@@ -318,9 +346,10 @@ def FeedBlob(name, arr, device_option=None):
 
     name = StringifyBlobName(name)
     if device_option is not None:
-        return C.feed_blob(name, arr, StringifyProto(device_option))
+        return C.feed_blob(
+            name, arr, StringifyProto(device_option), zero_copy=zero_copy)
     else:
-        return C.feed_blob(name, arr)
+        return C.feed_blob(name, arr, zero_copy=zero_copy)
 
 
 def FetchBlobs(names):
@@ -334,15 +363,19 @@ def FetchBlobs(names):
     return [FetchBlob(name) for name in names]
 
 
-def FetchBlob(name):
+def FetchBlob(name, zero_copy=False):
     """Fetches a blob from the workspace.
 
     Inputs:
       name: the name of the blob - a string or a BlobReference
+      zero_copy (optional): if True, a CPU tensor is returned as a numpy view
+          of the blob's memory instead of a copy. The view keeps that memory
+          alive on its own, but stops reflecting the blob once the blob
+          reallocates (e.g. when an operator grows it).
     Returns:
       Fetched blob (numpy array or string) if successful
     """
-    result = C.fetch_blob(StringifyBlobName(name))
+    result = C.fetch_blob(StringifyBlobName(name), zero_copy=zero_copy)
     if isinstance(result, tuple):
         raise TypeError(
             "Use FetchInt8Blob to fetch Int8 Blob {}".format(
@@ -189,6 +189,42 @@ class TestWorkspace(unittest.TestCase):
         self.assertEqual(fetched_back.dtype, np.bool)
         np.testing.assert_array_equal(fetched_back, data)
 
+    def testFetchFeedBlobZeroCopy(self):
+        data = np.random.rand(2, 3).astype(np.float32)
+        self.assertEqual(
+            workspace.FeedBlob("testblob_zc", data, zero_copy=True), True)
+        view = workspace.FetchBlob("testblob_zc", zero_copy=True)
+        np.testing.assert_array_equal(view, data)
+        # The blob and both arrays share the same buffer.
+        data[0, 0] = 7.0
+        self.assertEqual(view[0, 0], 7.0)
+        self.assertEqual(workspace.FetchBlob("testblob_zc")[0, 0], 7.0)
+        # The copying fetch does not share it.
+        fetched = workspace.FetchBlob("testblob_zc")
+        fetched[0, 0] = 8.0
+        self.assertEqual(data[0, 0], 7.0)
+        # The blob keeps the fed array alive, and the view outlives the blob.
+        expected = data.copy()
+        del data
+        np.testing.assert_array_equal(
+            workspace.FetchBlob("testblob_zc"), expected)
+        workspace.ResetWorkspace()
+        np.testing.assert_array_equal(view, expected)
+
+    def testFeedBlobZeroCopyFallsBackToCopy(self):
+        data = np.random.rand(2, 3).astype(np.float32)
+        data.setflags(write=False)
+        self.assertEqual(
+            workspace.FeedBlob("testblob_zc", data, zero_copy=True), True)
+        view = workspace.FetchBlob("testblob_zc", zero_copy=True)
+        view[0, 0] = 7.0
+        self.assertNotEqual(data[0, 0], 7.0)
+        strs = np.array([b'a', b'bc'], dtype=np.object)
+        self.assertEqual(
+            workspace.FeedBlob("testblob_zc_str", strs, zero_copy=True), True)
+        np.testing.assert_array_equal(
+            workspace.FetchBlob("testblob_zc_str", zero_copy=True), strs)
+
     def testGetBlobSizeBytes(self):
         for dtype in [np.float16, np.float32, np.float64, np.bool,
                       np.int8, np.int16, np.int32, np.int64,
@@ -5,6 +5,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <thread>
 
 #include "caffe2/core/blob_stats.h"
 #include "caffe2/core/logging.h"
@@ -22,14 +23,30 @@ static constexpr uint64_t SDT_TIMEOUT = (uint64_t)-1;
 static constexpr uint64_t SDT_ABORT = (uint64_t)-2;
 static constexpr uint64_t SDT_CANCEL = (uint64_t)-3;
 
+// Number of attempts of a lock free read or write on an empty or full queue
+// before blocking on the condition variable.
+static constexpr int kLockFreeSpins = 64;
+
+BlobsQueue::Mode BlobsQueue::modeFromName(const std::string& name) {
+  if (name == "locked") {
+    return Mode::LOCKED;
+  } else if (name == "spsc") {
+    return Mode::SPSC;
+  } else if (name == "mpmc") {
+    return Mode::MPMC;
+  }
+  CAFFE_THROW("Unknown BlobsQueue mode: ", name);
+}
+
 BlobsQueue::BlobsQueue(
     Workspace* ws,
     const std::string& queueName,
     size_t capacity,
     size_t numBlobs,
     bool enforceUniqueName,
-    const std::vector<std::string>& fieldNames)
-    : numBlobs_(numBlobs), name_(queueName), stats_(queueName) {
+    const std::vector<std::string>& fieldNames,
+    Mode mode)
+    : stats_(queueName), numBlobs_(numBlobs), mode_(mode), name_(queueName) {
   if (!fieldNames.empty()) {
     CAFFE_ENFORCE_EQ(
         fieldNames.size(), numBlobs, "Wrong number of fieldNames provided.");
@@ -52,11 +69,21 @@ BlobsQueue::BlobsQueue(
     queue_.push_back(blobs);
   }
   DCHECK_EQ(queue_.size(), capacity);
+  if (mode_ != Mode::LOCKED) {
+    CAFFE_ENFORCE_GT(capacity, 0);
+    sequence_.reset(new std::atomic<int64_t>[capacity]);
+    for (auto i = 0; i < capacity; ++i) {
+      sequence_[i] = i;
+    }
+  }
 }
 
 bool BlobsQueue::blockingRead(
     const std::vector<Blob*>& inputs,
     float timeout_secs) {
+  if (mode_ != Mode::LOCKED) {
+    return blockingReadLockFree(inputs, timeout_secs);
+  }
   Timer readTimer;
   auto keeper = this->shared_from_this();
   const auto& name = name_.c_str();
@@ -69,12 +96,16 @@ bool BlobsQueue::blockingRead(
   // Decrease queue balance before reading to indicate queue read pressure
   // is being increased (-ve queue balance indicates more reads than writes)
   CAFFE_EVENT(stats_, queue_balance, -1);
-  if (timeout_secs > 0) {
-    std::chrono::milliseconds timeout_ms(int(timeout_secs * 1000));
-    cv_.wait_for(
-        g, timeout_ms, [this, canRead]() { return closing_ || canRead(); });
-  } else {
-    cv_.wait(g, [this, canRead]() { return closing_ || canRead(); });
+  if (!canRead() && !closing_) {
+    Timer waitTimer;
+    if (timeout_secs > 0) {
+      std::chrono::milliseconds timeout_ms(int(timeout_secs * 1000));
+      cv_.wait_for(
+          g, timeout_ms, [this, canRead]() { return closing_ || canRead(); });
+    } else {
+      cv_.wait(g, [this, canRead]() { return closing_ || canRead(); });
+    }
+    CAFFE_EVENT(stats_, read_wait_time_ns, waitTimer.NanoSeconds());
   }
   if (!canRead()) {
     if (timeout_secs > 0 && !closing_) {
@@ -86,6 +117,7 @@ bool BlobsQueue::blockingRead(
     return false;
   }
   DCHECK(canRead());
+  CAFFE_EVENT(stats_, queue_depth, writer_ - reader_);
   auto& result = queue_[reader_ % queue_.size()];
   CAFFE_ENFORCE(inputs.size() >= result.size());
   for (auto i = 0; i < result.size(); ++i) {
@@ -107,6 +139,16 @@ bool BlobsQueue::tryWrite(const std::vector<Blob*>& inputs) {
   auto keeper = this->shared_from_this();
   const auto& name = name_.c_str();
   CAFFE_SDT(queue_write_start, name, (void*)this, SDT_NONBLOCKING_OP);
+  if (mode_ != Mode::LOCKED) {
+    if (!tryWriteLockFree(inputs)) {
+      CAFFE_SDT(queue_write_end, name, (void*)this, SDT_ABORT);
+      return false;
+    }
+    notifyWaiters(readersWaiting_);
+    CAFFE_EVENT(stats_, queue_balance, 1);
+    CAFFE_EVENT(stats_, write_time_ns, writeTimer.NanoSeconds());
+    return true;
+  }
   std::unique_lock<std::mutex> g(mutex_);
   if (!canWrite()) {
     CAFFE_SDT(queue_write_end, name, (void*)this, SDT_ABORT);
@@ -122,6 +164,9 @@ bool BlobsQueue::tryWrite(const std::vector<Blob*>& inputs) {
 }
 
 bool BlobsQueue::blockingWrite(const std::vector<Blob*>& inputs) {
+  if (mode_ != Mode::LOCKED) {
+    return blockingWriteLockFree(inputs);
+  }
   Timer writeTimer;
   auto keeper = this->shared_from_this();
   const auto& name = name_.c_str();
@@ -130,7 +175,11 @@ bool BlobsQueue::blockingWrite(const std::vector<Blob*>& inputs) {
   // Increase queue balance before writing to indicate queue write pressure is
   // being increased (+ve queue balance indicates more writes than reads)
   CAFFE_EVENT(stats_, queue_balance, 1);
-  cv_.wait(g, [this]() { return closing_ || canWrite(); });
+  if (!canWrite() && !closing_) {
+    Timer waitTimer;
+    cv_.wait(g, [this]() { return closing_ || canWrite(); });
+    CAFFE_EVENT(stats_, write_wait_time_ns, waitTimer.NanoSeconds());
+  }
   if (!canWrite()) {
     CAFFE_SDT(queue_write_end, name, (void*)this, SDT_ABORT);
     return false;
@@ -170,4 +219,185 @@ void BlobsQueue::doWrite(const std::vector<Blob*>& inputs) {
   cv_.notify_all();
 }
 
+bool BlobsQueue::tryReadLockFree(const std::vector<Blob*>& inputs) {
+  const int64_t capacity = queue_.size();
+  int64_t pos = readPos_.load(std::memory_order_relaxed);
+  while (true) {
+    const int64_t seq =
+        sequence_[pos % capacity].load(std::memory_order_acquire);
+    if (seq < pos + 1) {
+      // Empty: the record of pos hasn't been written yet.
+      return false;
+    }
+    if (seq == pos + 1) {
+      if (mode_ == Mode::SPSC) {
+        readPos_.store(pos + 1, std::memory_order_relaxed);
+        break;
+      }
+      // On failure pos is reloaded with the position of the next read.
+      if (readPos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else {
+      // Another reader took this record.
+      pos = readPos_.load(std::memory_order_relaxed);
+    }
+  }
+  CAFFE_EVENT(
+      stats_,
+      queue_depth,
+      writePos_.load(std::memory_order_relaxed) - pos);
+  auto& result = queue_[pos % capacity];
+  CAFFE_ENFORCE(inputs.size() >= result.size());
+  for (auto i = 0; i < result.size(); ++i) {
+    auto bytes = BlobStat::sizeBytes(*result[i]);
+    CAFFE_EVENT(stats_, queue_dequeued_bytes, bytes, i);
+    using std::swap;
+    swap(*(inputs[i]), *(result[i]));
+  }
+  sequence_[pos % capacity].store(pos + capacity, std::memory_order_release);
+  return true;
+}
+
+bool BlobsQueue::tryWriteLockFree(const std::vector<Blob*>& inputs) {
+  const int64_t capacity = queue_.size();
+  int64_t pos = writePos_.load(std::memory_order_relaxed);
+  while (true) {
+    const int64_t seq =
+        sequence_[pos % capacity].load(std::memory_order_acquire);
+    if (seq < pos) {
+      // Full: the record of pos - capacity hasn't been read yet.
+      return false;
+    }
+    if (seq == pos) {
+      if (mode_ == Mode::SPSC) {
+        writePos_.store(pos + 1, std::memory_order_relaxed);
+        break;
+      }
+      if (writePos_.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else {
+      // Another writer took this slot.
+      pos = writePos_.load(std::memory_order_relaxed);
+    }
+  }
+  auto& result = queue_[pos % capacity];
+  CAFFE_ENFORCE(inputs.size() >= result.size());
+  for (auto i = 0; i < result.size(); ++i) {
+    using std::swap;
+    swap(*(inputs[i]), *(result[i]));
+  }
+  sequence_[pos % capacity].store(pos + 1, std::memory_order_release);
+  return true;
+}
+
+void BlobsQueue::notifyWaiters(const std::atomic<int>& waiters) {
+  // Pairs with the fence of the waiters: either they see the slot that was
+  // just published, or we see them waiting and wake them up.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiters.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> g(mutex_);
+    cv_.notify_all();
+  }
+}
+
+bool BlobsQueue::blockingReadLockFree(
+    const std::vector<Blob*>& inputs,
+    float timeout_secs) {
+  Timer readTimer;
+  auto keeper = this->shared_from_this();
+  const auto& name = name_.c_str();
+  CAFFE_SDT(queue_read_start, name, (void*)this, SDT_BLOCKING_OP);
+  CAFFE_EVENT(stats_, queue_balance, -1);
+  bool read = false;
+  for (int i = 0; i < kLockFreeSpins && !read; ++i) {
+    read = tryReadLockFree(inputs);
+    if (!read) {
+      std::this_thread::yield();
+    }
+  }
+  if (!read) {
+    Timer waitTimer;
+    // The reads attempted by ready() run with the mutex held, so they must
+    // not notify: that is done below, once the mutex is released.
+    std::unique_lock<std::mutex> g(mutex_);
+    ++readersWaiting_;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto ready = [this, &inputs, &read]() {
+      read = tryReadLockFree(inputs);
+      return read || closing_;
+    };
+    if (timeout_secs > 0) {
+      std::chrono::milliseconds timeout_ms(int(timeout_secs * 1000));
+      cv_.wait_for(g, timeout_ms, ready);
+    } else {
+      cv_.wait(g, ready);
+    }
+    --readersWaiting_;
+    CAFFE_EVENT(stats_, read_wait_time_ns, waitTimer.NanoSeconds());
+  }
+  if (!read) {
+    if (timeout_secs > 0 && !closing_) {
+      LOG(ERROR) << "DequeueBlobs timed out in " << timeout_secs << " secs";
+      CAFFE_SDT(queue_read_end, name, (void*)this, SDT_TIMEOUT);
+    } else {
+      CAFFE_SDT(queue_read_end, name, (void*)this, SDT_CANCEL);
+    }
+    return false;
+  }
+  notifyWaiters(writersWaiting_);
+  CAFFE_SDT(
+      queue_read_end,
+      name,
+      (void*)this,
+      writePos_.load(std::memory_order_relaxed) -
+          readPos_.load(std::memory_order_relaxed));
+  CAFFE_EVENT(stats_, queue_dequeued_records);
+  CAFFE_EVENT(stats_, read_time_ns, readTimer.NanoSeconds());
+  return true;
+}
+
+bool BlobsQueue::blockingWriteLockFree(const std::vector<Blob*>& inputs) {
+  Timer writeTimer;
+  auto keeper = this->shared_from_this();
+  const auto& name = name_.c_str();
+  CAFFE_SDT(queue_write_start, name, (void*)this, SDT_BLOCKING_OP);
+  CAFFE_EVENT(stats_, queue_balance, 1);
+  bool written = false;
+  for (int i = 0; i < kLockFreeSpins && !written; ++i) {
+    written = tryWriteLockFree(inputs);
+    if (!written) {
+      std::this_thread::yield();
+    }
+  }
+  if (!written) {
+    Timer waitTimer;
+    std::unique_lock<std::mutex> g(mutex_);
+    ++writersWaiting_;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    cv_.wait(g, [this, &inputs, &written]() {
+      written = tryWriteLockFree(inputs);
+      return written || closing_;
+    });
+    --writersWaiting_;
+    CAFFE_EVENT(stats_, write_wait_time_ns, waitTimer.NanoSeconds());
+  }
+  if (!written) {
+    CAFFE_SDT(queue_write_end, name, (void*)this, SDT_ABORT);
+    return false;
+  }
+  notifyWaiters(readersWaiting_);
+  CAFFE_SDT(
+      queue_write_end,
+      name,
+      (void*)this,
+      readPos_.load(std::memory_order_relaxed) + queue_.size() -
+          writePos_.load(std::memory_order_relaxed));
+  CAFFE_EVENT(stats_, write_time_ns, writeTimer.NanoSeconds());
+  return true;
+}
+
 } // namespace caffe2
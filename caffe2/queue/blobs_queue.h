@@ -16,55 +16,98 @@ namespace caffe2 {
 
 // A thread-safe, bounded, blocking queue.
 // Modelled as a circular buffer.
+//
+// In the default LOCKED mode, one mutex protects the buffer. In the SPSC and
+// MPMC modes, records are handed off through a sequence number per slot of
+// the buffer, without taking the mutex; it is only used to block while the
+// queue is empty (for readers) or full (for writers). SPSC requires that at
+// most one thread reads and one thread writes at a time.
+//
+// ShmBlobsQueue (shm_blobs_queue.h) overrides the reads and writes to keep
+// the records in shared memory, so that they can cross processes.
 
 // Containing blobs are owned by the workspace.
 // On read, we swap out the underlying data for the blob passed in for blobs
 
 class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
  public:
+  enum class Mode { LOCKED, SPSC, MPMC };
+
+  // Parses the mode argument of CreateBlobsQueue: "locked", "spsc" or "mpmc".
+  static Mode modeFromName(const std::string& name);
+
   BlobsQueue(
       Workspace* ws,
       const std::string& queueName,
       size_t capacity,
       size_t numBlobs,
       bool enforceUniqueName,
-      const std::vector<std::string>& fieldNames = {});
+      const std::vector<std::string>& fieldNames = {},
+      Mode mode = Mode::LOCKED);
 
-  ~BlobsQueue() {
+  virtual ~BlobsQueue() {
     close();
   }
 
-  bool blockingRead(
+  virtual bool blockingRead(
       const std::vector<Blob*>& inputs,
       float timeout_secs = 0.0f);
-  bool tryWrite(const std::vector<Blob*>& inputs);
-  bool blockingWrite(const std::vector<Blob*>& inputs);
-  void close();
+  virtual bool tryWrite(const std::vector<Blob*>& inputs);
+  virtual bool blockingWrite(const std::vector<Blob*>& inputs);
+  virtual void close();
   size_t getNumBlobs() const {
     return numBlobs_;
   }
 
+ protected:
+  struct QueueStats {
+    CAFFE_STAT_CTOR(QueueStats);
+    CAFFE_EXPORTED_STAT(queue_balance);
+    CAFFE_EXPORTED_STAT(queue_dequeued_records);
+    CAFFE_DETAILED_EXPORTED_STAT(queue_dequeued_bytes);
+    CAFFE_AVG_EXPORTED_STAT(read_time_ns);
+    CAFFE_AVG_EXPORTED_STAT(write_time_ns);
+    // Number of records in the queue when one is read.
+    CAFFE_AVG_EXPORTED_STAT(queue_depth);
+    // Time spent blocked on an empty or full queue, only counted for the
+    // reads and writes that had to wait.
+    CAFFE_AVG_EXPORTED_STAT(read_wait_time_ns);
+    CAFFE_AVG_EXPORTED_STAT(write_wait_time_ns);
+  } stats_;
+
  private:
   bool canWrite();
   void doWrite(const std::vector<Blob*>& inputs);
 
+  // Lock free counterparts of the above, for the SPSC and MPMC modes. The
+  // try* functions return false without waiting when the queue is empty or
+  // full.
+  bool tryReadLockFree(const std::vector<Blob*>& inputs);
+  bool tryWriteLockFree(const std::vector<Blob*>& inputs);
+  bool blockingReadLockFree(
+      const std::vector<Blob*>& inputs,
+      float timeout_secs);
+  bool blockingWriteLockFree(const std::vector<Blob*>& inputs);
+  void notifyWaiters(const std::atomic<int>& waiters);
+
   std::atomic<bool> closing_{false};
 
   size_t numBlobs_;
-  std::mutex mutex_; // protects all variables in the class.
+  const Mode mode_;
+  std::mutex mutex_; // protects all variables in the class in LOCKED mode.
   std::condition_variable cv_;
   int64_t reader_{0};
   int64_t writer_{0};
   std::vector<std::vector<Blob*>> queue_;
   const std::string name_;
 
-  struct QueueStats {
-    CAFFE_STAT_CTOR(QueueStats);
-    CAFFE_EXPORTED_STAT(queue_balance);
-    CAFFE_EXPORTED_STAT(queue_dequeued_records);
-    CAFFE_DETAILED_EXPORTED_STAT(queue_dequeued_bytes);
-    CAFFE_AVG_EXPORTED_STAT(read_time_ns);
-    CAFFE_AVG_EXPORTED_STAT(write_time_ns);
-  } stats_;
+  // State of the SPSC and MPMC modes. The slot of position p holds a record
+  // when its sequence number is p + 1, and is free for writing it when its
+  // sequence number is p.
+  std::atomic<int64_t> readPos_{0};
+  std::atomic<int64_t> writePos_{0};
+  std::unique_ptr<std::atomic<int64_t>[]> sequence_;
+  std::atomic<int> readersWaiting_{0};
+  std::atomic<int> writersWaiting_{0};
 };
 } // namespace caffe2
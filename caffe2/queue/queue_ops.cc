@@ -17,7 +17,33 @@ REGISTER_CPU_OPERATOR(
     WeightedSampleDequeueBlobs,
     WeightedSampleDequeueBlobsOp<CPUContext>);
 
-OPERATOR_SCHEMA(CreateBlobsQueue).NumInputs(0).NumOutputs(1);
+OPERATOR_SCHEMA(CreateBlobsQueue)
+    .NumInputs(0)
+    .NumOutputs(1)
+    .Arg("capacity", "Number of records the queue holds, default 1")
+    .Arg("num_blobs", "Number of blobs of a record, default 1")
+    .Arg(
+        "mode",
+        "How readers and writers synchronize: \"locked\" (default) guards the "
+        "queue with a mutex; \"spsc\" (at most one reader and one writer at a "
+        "time) and \"mpmc\" hand off records without locking, and only block "
+        "when the queue is empty or full. \"shm\" keeps the records in POSIX "
+        "shared memory, so that other processes can attach to the queue; it "
+        "only holds CPU tensors of fixed size types.")
+    .Arg(
+        "shm_name",
+        "Name of the shared memory object of a \"shm\" queue, such as "
+        "\"/my_queue\"")
+    .Arg(
+        "max_blob_bytes",
+        "Size of the preallocated space for each blob of a record, in a "
+        "\"shm\" queue")
+    .Arg(
+        "attach",
+        "If true, a \"shm\" queue attaches to the queue created under "
+        "shm_name by another process, with the same capacity, num_blobs and "
+        "max_blob_bytes. Otherwise, the queue is created, and its name is "
+        "removed when it is destroyed (default false).");
 OPERATOR_SCHEMA(EnqueueBlobs)
     .NumInputsOutputs([](int inputs, int outputs) {
       return inputs >= 2 && outputs >= 1 && inputs == outputs + 1;
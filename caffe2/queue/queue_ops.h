@@ -2,6 +2,7 @@
 
 #include <memory>
 #include "blobs_queue.h"
+#include "shm_blobs_queue.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/utils/math.h"
 
@@ -24,12 +25,35 @@ class CreateBlobsQueueOp final : public Operator<Context> {
         GetSingleArgument("enforce_unique_name", false);
     const auto fieldNames =
         OperatorBase::template GetRepeatedArgument<std::string>("field_names");
+    const auto modeName =
+        OperatorBase::template GetSingleArgument<std::string>(
+            "mode", "locked");
     CAFFE_ENFORCE_EQ(this->OutputSize(), 1);
     auto queuePtr = Operator<Context>::Outputs()[0]
                         ->template GetMutable<std::shared_ptr<BlobsQueue>>();
     CAFFE_ENFORCE(queuePtr);
+    if (modeName == "shm") {
+      *queuePtr = std::make_shared<ShmBlobsQueue>(
+          ws_,
+          name,
+          OperatorBase::template GetSingleArgument<std::string>(
+              "shm_name", ""),
+          capacity,
+          numBlobs,
+          OperatorBase::template GetSingleArgument<int64_t>(
+              "max_blob_bytes", 0),
+          GetSingleArgument("attach", false),
+          fieldNames);
+      return true;
+    }
     *queuePtr = std::make_shared<BlobsQueue>(
-        ws_, name, capacity, numBlobs, enforceUniqueName, fieldNames);
+        ws_,
+        name,
+        capacity,
+        numBlobs,
+        enforceUniqueName,
+        fieldNames,
+        BlobsQueue::modeFromName(modeName));
     return true;
   }
 
@@ -1,104 +1,69 @@
 #include "rebatching_queue.h"
-#include "caffe2/utils/smart_tensor_printer.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace caffe2 {
 
 namespace {
 
-// This concat function will always create a new first dimension to concat
-void concat(
-    CPUContext& context,
-    const std::vector<std::vector<TensorCPU>>& inputs,
-    const std::vector<TensorCPU*>& outputs) {
-  CAFFE_ENFORCE(!inputs.empty());
-
-  const auto& inputZero = inputs[0];
-  const auto numTensors = inputZero.size();
-  const auto numRows = inputs.size();
-
-  // Precompute the output sizes to avoid resizing
-  std::vector<std::vector<TIndex>> outputDims(numTensors);
-
-  for (int i = 0; i < numTensors; ++i) {
-    SmartTensorPrinter::PrintTensor(inputZero.at(i));
-    outputDims[i] = inputZero.at(i).dims();
-    outputDims[i].insert(outputDims[i].begin(), numRows);
-  }
-
-  // Resize to the final output size
-  std::vector<void*> destinations(numTensors);
-  for (int i = 0; i < numTensors; ++i) {
-    outputs[i]->Resize(outputDims[i]);
-    destinations[i] = outputs[i]->raw_mutable_data(inputZero[i].meta());
+// The tensors of an element are the tensors of a batch without their first
+// dimension if the element is a row of the batch.
+std::vector<TIndex> elementDims(const TensorCPU& tensor, TIndex row) {
+  auto dims = tensor.dims();
+  if (row >= 0) {
+    dims.erase(dims.begin());
   }
+  return dims;
+}
 
-  for (int i = 0; i < numRows; ++i) {
-    CAFFE_ENFORCE_EQ(inputs[i].size(), numTensors);
-
-    for (int j = 0; j < numTensors; ++j) {
-      const auto& input = inputs[i][j];
-
-      CAFFE_ENFORCE(inputZero[j].meta() == input.meta());
-      CAFFE_ENFORCE_EQ(inputZero[j].itemsize(), input.itemsize());
-      CAFFE_ENFORCE_EQ(inputZero[j].ndim(), input.ndim());
-      for (int k = 0; k < input.ndim(); ++k) {
-        CAFFE_ENFORCE_EQ(input.dims()[k], inputZero[j].dims()[k]);
-      }
-
-      // Skip empty tensors
-      if (input.size() == 0) {
-        continue;
-      }
-
-      context.CopyItems<CPUContext, CPUContext>(
-          input.meta(),
-          input.size(),
-          input.raw_data() /* src */,
-          destinations[j] /* dst */
-          );
-
-      destinations[j] =
-          (char*)destinations[j] + input.size() * input.itemsize();
-    }
+const void* elementData(const TensorCPU& tensor, TIndex row) {
+  if (row < 0) {
+    return tensor.raw_data();
   }
+  return static_cast<const char*>(tensor.raw_data()) +
+      row * tensor.size_from_dim(1) * tensor.itemsize();
 }
 
-std::vector<std::vector<TensorCPU>> split(
-    CPUContext& context,
-    const std::vector<const TensorCPU*>& inputs) {
-  CAFFE_ENFORCE(!inputs.empty());
-
-  const auto outputSize = inputs[0]->dims().at(0);
-  std::vector<std::vector<TensorCPU>> outputs(outputSize);
-
-  for (const auto* inputPtr : inputs) {
-    CAFFE_ENFORCE(inputPtr);
-
-    const auto& input = *inputPtr;
-    const auto innerSize = input.size_from_dim(1);
-    const auto itemSize = input.meta().itemsize();
+TIndex elementSize(const TensorCPU& tensor, TIndex row) {
+  return row < 0 ? tensor.size() : tensor.size_from_dim(1);
+}
 
-    auto outputDims = input.dims();
-    CAFFE_ENFORCE(!outputDims.empty());
-    outputDims.erase(outputDims.begin());
-    CAFFE_ENFORCE_EQ(input.dims().at(0), outputSize);
+} // anonymous namespace
 
-    for (int i = 0; i < outputSize; ++i) {
-      outputs[i].push_back(TensorCPU(outputDims));
-      context.CopyItems<CPUContext, CPUContext>(
-          input.meta(),
-          innerSize,
-          (char*)input.raw_data() + i * innerSize * itemSize /* src */,
-          outputs[i].back().raw_mutable_data(input.meta()) /* dst */);
+RebatchingQueue::RebatchingQueue(
+    size_t capacity,
+    size_t numBlobs,
+    const std::string& name,
+    const std::vector<TIndex>& bucketBoundaries,
+    int bucketBlob,
+    bool singleConsumer)
+    : capacity_(capacity),
+      numBlobs_(numBlobs),
+      bucketBoundaries_(bucketBoundaries),
+      bucketBlob_(bucketBlob),
+      singleConsumer_(singleConsumer),
+      stats_(name) {
+  CAFFE_ENFORCE(
+      std::is_sorted(bucketBoundaries_.begin(), bucketBoundaries_.end()),
+      "bucket_boundaries must be sorted");
+  CAFFE_ENFORCE(
+      bucketBlob_ >= 0 && bucketBlob_ < numBlobs_,
+      "bucket_blob out of range: ",
+      bucketBlob_);
+  if (bucketed()) {
+    buckets_.resize(bucketBoundaries_.size() + 1);
+    std::vector<std::string> bucketNames;
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      bucketNames.push_back("bucket_" + to_string(i));
     }
+    stats_.dequeued_batches.setDetails(bucketNames);
+    stats_.dequeued_rows.setDetails(bucketNames);
+    stats_.padded_items.setDetails(bucketNames);
+  } else {
+    queue_.resize(capacity_);
   }
-
-  return outputs;
 }
-} // anonymous namespace
-
-RebatchingQueue::RebatchingQueue(size_t capacity, size_t numBlobs)
-    : capacity_(capacity), numBlobs_(numBlobs), queue_(capacity) {}
 
 RebatchingQueue::~RebatchingQueue() {
   close();
@@ -112,85 +77,279 @@ bool RebatchingQueue::dequeue(
     CPUContext& context,
     size_t numElements,
     const std::vector<TensorCPU*>& outputs) {
-  std::vector<std::vector<TensorCPU>> results;
+  CAFFE_ENFORCE(
+      outputs.size() == numBlobs_ || outputs.size() == numBlobs_ + 1,
+      "Expected ",
+      numBlobs_,
+      " outputs, or one more for the lengths, but got ",
+      outputs.size());
+  std::vector<Element> results;
   results.reserve(numElements);
 
-  for (;;) {
-    if (results.size() == numElements) {
-      break;
+  if (bucketed()) {
+    if (!dequeueBucketed(numElements, results)) {
+      return false;
     }
+  } else if (singleConsumer_) {
+    if (!dequeueSingleConsumer(numElements, results)) {
+      return false;
+    }
+  } else {
+    for (;;) {
+      if (results.size() == numElements) {
+        break;
+      }
 
-    {
-      std::unique_lock<std::mutex> lock(mutex_);
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
 
-      cvEmpty_.wait(lock, [this] { return canRead() || isClosed_; });
+        cvEmpty_.wait(lock, [this] { return canRead() || isClosed_; });
+
+        // We only want to stop reading if the queue is empty and closed
+        if (!canRead() && isClosed_) {
+          break;
+        }
+
+        do {
+          results.push_back(std::move(queue_[tail_++ % capacity()]));
+        } while (canRead() && results.size() < numElements);
+      }
+
+      if (numElements == 1) {
+        cvOverflow_.notify_one();
+      } else {
+        cvOverflow_.notify_all();
+      }
+    }
+
+    if (results.empty()) {
+      return false;
+    }
+  }
 
+  // Copy the rows straight into the outputs, with a new first dimension.
+  // Only bucketed queues pad the elements to the longest one.
+  const auto numRows = results.size();
+  const auto& rowZero = results[0];
+  const int bucket = bucketed() ? bucketOf(rowZero) : 0;
+  TIndex paddedItems = 0;
+  for (int j = 0; j < numBlobs_; ++j) {
+    const auto& tensorZero = rowZero.tensors->at(j);
+    auto outputDims = elementDims(tensorZero, rowZero.row);
+    for (const auto& result : results) {
+      const auto& tensor = result.tensors->at(j);
+      const auto dims = elementDims(tensor, result.row);
+      CAFFE_ENFORCE(tensorZero.meta() == tensor.meta());
+      CAFFE_ENFORCE_EQ(outputDims.size(), dims.size());
+      for (int k = 0; k < dims.size(); ++k) {
+        if (k == 0 && bucketed()) {
+          outputDims[0] = std::max(outputDims[0], dims[0]);
+        } else {
+          CAFFE_ENFORCE_EQ(dims[k], outputDims[k]);
+        }
+      }
+    }
+    outputDims.insert(outputDims.begin(), numRows);
+    auto* output = outputs[j];
+    output->Resize(outputDims);
+    char* dst =
+        static_cast<char*>(output->raw_mutable_data(tensorZero.meta()));
+    const TIndex rowSize = output->size_from_dim(1);
+    const size_t itemSize = tensorZero.itemsize();
+    const bool isPod = tensorZero.meta().ctor() == nullptr;
+    for (const auto& result : results) {
+      const auto& tensor = result.tensors->at(j);
+      const TIndex size = elementSize(tensor, result.row);
+      if (size > 0) {
+        context.CopyItems<CPUContext, CPUContext>(
+            tensor.meta(), size, elementData(tensor, result.row), dst);
+      }
+      if (size < rowSize) {
+        // non-POD items are already default constructed
+        if (isPod) {
+          std::memset(dst + size * itemSize, 0, (rowSize - size) * itemSize);
+        }
+        paddedItems += rowSize - size;
+      }
+      dst += rowSize * itemSize;
+    }
+  }
+
+  if (outputs.size() > numBlobs_) {
+    auto* lengths = outputs[numBlobs_];
+    lengths->Resize(numRows);
+    auto* lengthsData = lengths->mutable_data<int32_t>();
+    for (size_t i = 0; i < numRows; ++i) {
+      const auto& tensor = results[i].tensors->at(bucketBlob_);
+      const auto dims = elementDims(tensor, results[i].row);
+      lengthsData[i] = dims.empty() ? 1 : dims[0];
+    }
+  }
+
+  CAFFE_EVENT(stats_, dequeued_batches, 1, bucket);
+  CAFFE_EVENT(stats_, dequeued_rows, numRows, bucket);
+  CAFFE_EVENT(stats_, padded_items, paddedItems, bucket);
+  return true;
+}
+
+bool RebatchingQueue::dequeueSingleConsumer(
+    size_t numElements,
+    std::vector<Element>& results) {
+  // Only this thread moves tail_, so the elements in [tail_, head_) can be
+  // read without the mutex; enqueue publishes them with the store of head_.
+  while (results.size() < numElements) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    if (tail == head) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cvEmpty_.wait(lock, [this] { return canRead() || isClosed_; });
       // We only want to stop reading if the queue is empty and closed
       if (!canRead() && isClosed_) {
         break;
       }
-
-      do {
-        results.push_back(std::move(queue_[tail_++ % capacity()]));
-      } while (canRead() && results.size() < numElements);
+      continue;
     }
+    do {
+      results.push_back(std::move(queue_[tail++ % capacity()]));
+    } while (tail < head && results.size() < numElements);
+    tail_.store(tail);
+    notifyWriters();
+  }
+  return !results.empty();
+}
 
-    if (numElements == 1) {
-      cvOverflow_.notify_one();
-    } else {
-      cvOverflow_.notify_all();
+bool RebatchingQueue::dequeueBucketed(
+    size_t numElements,
+    std::vector<Element>& results) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    int bucket = -1;
+    cvEmpty_.wait(lock, [&] {
+      bucket = readableBucket(numElements);
+      return bucket >= 0 || (isClosed_ && size_ == 0);
+    });
+    if (bucket < 0) {
+      return false;
+    }
+    auto& elements = buckets_[bucket];
+    while (!elements.empty() && results.size() < numElements) {
+      results.push_back(std::move(elements.front()));
+      elements.pop_front();
     }
+    size_ -= results.size();
   }
+  cvOverflow_.notify_all();
+  return true;
+}
 
-  if (results.empty()) {
-    return false;
+int RebatchingQueue::readableBucket(size_t numElements) const {
+  // the full bucket whose oldest element is the oldest, so that no bucket
+  // starves; otherwise, if the queue can't fill up a bucket because it is
+  // full or closed, the largest bucket
+  int full = -1;
+  int largest = -1;
+  for (int i = 0; i < buckets_.size(); ++i) {
+    const auto& elements = buckets_[i];
+    if (elements.empty()) {
+      continue;
+    }
+    if (elements.size() >= numElements &&
+        (full < 0 ||
+         elements.front().sequence < buckets_[full].front().sequence)) {
+      full = i;
+    }
+    if (largest < 0 || elements.size() > buckets_[largest].size()) {
+      largest = i;
+    }
+  }
+  if (full >= 0) {
+    return full;
   }
+  return isClosed_ || size_ >= capacity_ ? largest : -1;
+}
 
-  concat(context, results, outputs);
+int RebatchingQueue::bucketOf(const Element& element) const {
+  const auto& tensor = element.tensors->at(bucketBlob_);
+  const auto dims = elementDims(tensor, element.row);
+  const TIndex length = dims.empty() ? 1 : dims[0];
+  return std::upper_bound(
+             bucketBoundaries_.begin(), bucketBoundaries_.end(), length) -
+      bucketBoundaries_.begin();
+}
 
-  return true;
+void RebatchingQueue::notifyWriters() {
+  // A writer that is about to wait registers in writersWaiting_ before it
+  // checks for room under the mutex, so taking the mutex here makes sure it
+  // either sees the new tail_ or is already waiting for the notification.
+  if (writersWaiting_.load() > 0) {
+    { std::lock_guard<std::mutex> g(mutex_); }
+    cvOverflow_.notify_all();
+  }
 }
 
 bool RebatchingQueue::canWrite() const {
+  if (bucketed()) {
+    return size_ < capacity_;
+  }
   return tail_ + capacity() > head_;
 }
 
 bool RebatchingQueue::enqueueOne(
     CPUContext& /*context*/,
     const std::vector<const TensorCPU*>& inputs) {
-  std::vector<std::vector<TensorCPU>> splittedInputs;
-  splittedInputs.emplace_back();
-  auto& tensorVector = splittedInputs.back();
-  tensorVector.reserve(inputs.size());
+  CAFFE_ENFORCE_EQ(numBlobs_, inputs.size());
+  auto tensors = std::make_shared<std::vector<TensorCPU>>();
+  tensors->reserve(inputs.size());
   for (const auto* tensorPtr : inputs) {
-    tensorVector.push_back(tensorPtr->Clone());
+    tensors->push_back(tensorPtr->Clone());
   }
 
-  return enqueue(std::move(splittedInputs));
+  std::vector<Element> elements;
+  elements.push_back(Element{std::move(tensors), -1, 0});
+  return enqueue(std::move(elements));
 }
 
 bool RebatchingQueue::enqueueMany(
-    CPUContext& context,
+    CPUContext& /*context*/,
     const std::vector<const TensorCPU*>& inputs) {
   CAFFE_ENFORCE_EQ(numBlobs_, inputs.size());
+  CAFFE_ENFORCE(!inputs.empty());
+
+  // the elements share one copy of the batch
+  const auto numRows = inputs[0]->dims().at(0);
+  auto tensors = std::make_shared<std::vector<TensorCPU>>();
+  tensors->reserve(inputs.size());
+  for (const auto* inputPtr : inputs) {
+    CAFFE_ENFORCE(inputPtr);
+    CAFFE_ENFORCE(!inputPtr->dims().empty());
+    CAFFE_ENFORCE_EQ(inputPtr->dims().at(0), numRows);
+    tensors->push_back(inputPtr->Clone());
+  }
 
-  std::vector<std::vector<TensorCPU>> splittedInputs;
-  splittedInputs = split(context, inputs);
-  return enqueue(std::move(splittedInputs));
+  std::shared_ptr<const std::vector<TensorCPU>> batch = std::move(tensors);
+  std::vector<Element> elements;
+  elements.reserve(numRows);
+  for (TIndex i = 0; i < numRows; ++i) {
+    elements.push_back(Element{batch, i, 0});
+  }
+  return enqueue(std::move(elements));
 }
 
-bool RebatchingQueue::enqueue(
-    std::vector<std::vector<TensorCPU>> splittedInputs) {
+bool RebatchingQueue::enqueue(std::vector<Element> elements) {
   int idx = 0;
   for (;;) {
-    if (idx >= splittedInputs.size()) {
+    if (idx >= elements.size()) {
       break;
     }
 
     {
       std::unique_lock<std::mutex> lock(mutex_);
 
-      cvOverflow_.wait(lock, [this] { return canWrite() || isClosed_; });
+      if (!canWrite() && !isClosed_) {
+        ++writersWaiting_;
+        cvOverflow_.wait(lock, [this] { return canWrite() || isClosed_; });
+        --writersWaiting_;
+      }
 
       if (isClosed_) {
         // If we are here it means that we didn't apply the entire batch and if
@@ -199,8 +358,8 @@ bool RebatchingQueue::enqueue(
       }
 
       do {
-        queue_[head_++ % capacity()] = std::move(splittedInputs[idx++]);
-      } while (canWrite() && idx < splittedInputs.size());
+        push(std::move(elements[idx++]));
+      } while (canWrite() && idx < elements.size());
     }
 
     cvEmpty_.notify_all();
@@ -209,6 +368,18 @@ bool RebatchingQueue::enqueue(
   return true;
 }
 
+void RebatchingQueue::push(Element element) {
+  element.sequence = sequence_++;
+  if (bucketed()) {
+    buckets_[bucketOf(element)].push_back(std::move(element));
+    ++size_;
+  } else {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    queue_[head % capacity()] = std::move(element);
+    head_.store(head + 1, std::memory_order_release);
+  }
+}
+
 size_t RebatchingQueue::capacity() const {
   return capacity_;
 }
@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -13,13 +14,34 @@
 
 namespace caffe2 {
 
-// TODO: This is a very naive implementation with a single mutex. We can do the
-// atomic index + circular queue optimizations or pull something more
-// heavy-weight later
-
+// A bounded, blocking queue of elements, i.e. tuples of numBlobs tensors, that
+// can be enqueued one at a time or as batches split along their first
+// dimension, and are dequeued in batches concatenated along a new first
+// dimension.
+//
+// A batch enqueued with enqueueMany is copied once and shared by all of its
+// elements, which point to their rows in it, and dequeue copies every row
+// straight into the output batch.
+//
+// With bucket boundaries, elements are kept in buckets by the first dimension
+// of their tensor bucketBlob, where bucket i holds the lengths in
+// [boundaries[i - 1], boundaries[i]), and dequeue returns a batch from a
+// single bucket, padding the tensors of shorter elements with zeros up to
+// the longest element of the batch. This keeps the padding of batches of
+// variable length sequences low. Per bucket counts of the dequeued rows and
+// of the padding are exported as stats of the queue.
+//
+// With singleConsumer, dequeue reads the elements without taking the mutex
+// unless it has to wait. At most one thread may dequeue at a time then.
 class RebatchingQueue {
  public:
-  RebatchingQueue(size_t capacity, size_t numBlobs);
+  RebatchingQueue(
+      size_t capacity,
+      size_t numBlobs,
+      const std::string& name = "",
+      const std::vector<TIndex>& bucketBoundaries = {},
+      int bucketBlob = 0,
+      bool singleConsumer = false);
 
   ~RebatchingQueue();
 
@@ -31,6 +53,9 @@ class RebatchingQueue {
       CPUContext& context,
       const std::vector<const TensorCPU*>& inputs);
 
+  // Dequeues up to numElements elements into the first numBlobs() outputs.
+  // If there is one more output, it is set to the int32 lengths (first
+  // dimensions) of the bucketBlob tensors of the dequeued elements.
   bool dequeue(
       CPUContext& context,
       size_t numElements,
@@ -45,24 +70,70 @@ class RebatchingQueue {
   void close();
 
  private:
-  bool enqueue(std::vector<std::vector<TensorCPU>> splittedInputs);
+  struct Element {
+    std::shared_ptr<const std::vector<TensorCPU>> tensors;
+    // the row of the tensors that is the element, or -1 if the tensors are
+    // the element
+    TIndex row;
+    // position in the order of enqueueing
+    uint64_t sequence;
+  };
+
+  bool enqueue(std::vector<Element> elements);
+  void push(Element element);
+
+  bool dequeueSingleConsumer(
+      size_t numElements,
+      std::vector<Element>& results);
+  bool dequeueBucketed(size_t numElements, std::vector<Element>& results);
+
+  // Returns the bucket to dequeue numElements elements from, or -1 if
+  // dequeue has to wait.
+  int readableBucket(size_t numElements) const;
+
+  int bucketOf(const Element& element) const;
+
+  void notifyWriters();
 
   bool canWrite() const;
   bool canRead() const;
 
+  bool bucketed() const {
+    return !bucketBoundaries_.empty();
+  }
+
   const size_t capacity_;
   const size_t numBlobs_;
+  const std::vector<TIndex> bucketBoundaries_;
+  const int bucketBlob_;
+  const bool singleConsumer_;
 
   mutable std::mutex mutex_;
 
   bool isClosed_{false};
 
-  uint64_t head_{0};
-  uint64_t tail_{0};
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  // number of enqueue calls waiting for room, so that the single consumer
+  // only takes the mutex to wake them up when there are any
+  std::atomic<int> writersWaiting_{0};
+  uint64_t sequence_{0};
 
   std::condition_variable cvEmpty_;
   std::condition_variable cvOverflow_;
 
-  std::vector<std::vector<TensorCPU>> queue_;
+  std::vector<Element> queue_;
+
+  // the buckets and their total size, when bucketed
+  std::vector<std::deque<Element>> buckets_;
+  size_t size_{0};
+
+  struct RebatchingQueueStats {
+    CAFFE_STAT_CTOR(RebatchingQueueStats);
+    CAFFE_DETAILED_EXPORTED_STAT(dequeued_batches);
+    CAFFE_DETAILED_EXPORTED_STAT(dequeued_rows);
+    // number of padding items added to the dequeued batches
+    CAFFE_DETAILED_EXPORTED_STAT(padded_items);
+  } stats_;
 };
 } // caffe2
@@ -26,7 +26,21 @@ Creates the Queue.
     .Arg("num_blobs", "Number of input tensors the queue will support")
     .Arg(
         "capacity",
-        "Maximal number of elements the queue can hold at any given point");
+        "Maximal number of elements the queue can hold at any given point")
+    .Arg(
+        "bucket_boundaries",
+        "(optional) Sorted lengths at which the elements are split into "
+        "buckets by the first dimension of their bucket_blob tensor. Each "
+        "dequeued batch is taken from a single bucket and is padded with "
+        "zeros to its longest element.")
+    .Arg(
+        "bucket_blob",
+        "Index of the tensor whose first dimension is the length of an "
+        "element, 0 by default")
+    .Arg(
+        "single_consumer",
+        "If set, dequeue doesn't take the lock unless it has to wait. Only "
+        "one DequeueRebatchingQueue may run on the queue at a time then.");
 
 OPERATOR_SCHEMA(CloseRebatchingQueue)
     .NumInputs(1)
@@ -62,6 +76,10 @@ Dequeue Tensors from the Queue.
 If the Queue is closed this might return less elements than asked.
 If num_elements > 1 the returned elements will be concatenated into one
 tensor per component.
+If the queue has bucket_boundaries, the elements of a dequeued batch come from
+one bucket and are padded with zeros along their first dimension to the
+longest of them. An extra output after the num_blobs components receives the
+int32 lengths of the bucket_blob tensors of the elements.
 )DOC")
     .Input(0, "rebatching_queue", "object representing the queue")
     .Input(1, "tensor", "First tensor to enqueue")
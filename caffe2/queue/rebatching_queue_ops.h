@@ -15,7 +15,11 @@ class CreateRebatchingQueueOp : public Operator<CPUContext> {
     *OperatorBase::Output<RebatchingQueuePtr>(0) =
         RebatchingQueuePtr(new RebatchingQueue(
             OperatorBase::GetSingleArgument<int>("capacity", 1),
-            OperatorBase::GetSingleArgument<int>("num_blobs", 1)));
+            OperatorBase::GetSingleArgument<int>("num_blobs", 1),
+            debug_def().output(0),
+            OperatorBase::GetRepeatedArgument<TIndex>("bucket_boundaries"),
+            OperatorBase::GetSingleArgument<int>("bucket_blob", 0),
+            OperatorBase::GetSingleArgument<bool>("single_consumer", false)));
     return true;
   }
 };
@@ -0,0 +1,352 @@
+#include "caffe2/queue/shm_blobs_queue.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "caffe2/core/blob_stats.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/core/timer.h"
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+
+namespace {
+
+constexpr uint64_t kShmQueueMagic = 0x4555455551324343ULL; // "CC2QUEUE"
+constexpr size_t kAlignment = 64;
+// Number of attempts of a read or write on an empty or full queue before
+// sleeping between the attempts, and the longest sleep.
+constexpr int kShmSpins = 64;
+constexpr int kMaxSleepUs = 1000;
+
+size_t alignUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// Waits for a record or a slot after a failed attempt. Returns false if the
+// timeout expired.
+bool backoff(int attempt, Timer& timer, float timeout_secs) {
+  if (timeout_secs > 0 && timer.Seconds() > timeout_secs) {
+    return false;
+  }
+  if (attempt < kShmSpins) {
+    std::this_thread::yield();
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds(
+        std::min(kMaxSleepUs, 1 << std::min(attempt - kShmSpins, 10))));
+  }
+  return true;
+}
+
+} // namespace
+
+constexpr int ShmBlobsQueue::kMaxDims;
+
+// Sequence numbers follow the header, and the slots follow the sequence
+// numbers, all aligned on cache lines.
+struct ShmBlobsQueue::Header {
+  uint64_t magic;
+  uint64_t capacity;
+  uint64_t numBlobs;
+  uint64_t maxBlobBytes;
+  std::atomic<bool> initialized;
+  std::atomic<bool> closed;
+  alignas(kAlignment) std::atomic<int64_t> readPos;
+  alignas(kAlignment) std::atomic<int64_t> writePos;
+};
+
+// Type and shape of the tensor in a slot, followed by its data.
+struct ShmBlobsQueue::BlobHeader {
+  int32_t dataType;
+  int32_t ndim;
+  int64_t dims[kMaxDims];
+  uint64_t nbytes;
+};
+
+ShmBlobsQueue::ShmBlobsQueue(
+    Workspace* ws,
+    const std::string& queueName,
+    const std::string& shmName,
+    size_t capacity,
+    size_t numBlobs,
+    size_t maxBlobBytes,
+    bool attach,
+    const std::vector<std::string>& fieldNames)
+    // The base queue holds no records.
+    : BlobsQueue(ws, queueName, 0, numBlobs, false, fieldNames),
+      shmName_(shmName),
+      owner_(!attach),
+      capacity_(capacity),
+      maxBlobBytes_(maxBlobBytes),
+      blobStride_(alignUp(sizeof(BlobHeader) + maxBlobBytes)) {
+  CAFFE_ENFORCE(!shmName_.empty(), "The queue needs a shared memory name");
+  CAFFE_ENFORCE_GT(capacity_, 0);
+  CAFFE_ENFORCE_GT(numBlobs, 0);
+  const size_t sequenceOffset = alignUp(sizeof(Header));
+  const size_t slotsOffset =
+      sequenceOffset + alignUp(capacity_ * sizeof(std::atomic<int64_t>));
+  const size_t totalBytes = slotsOffset + capacity_ * numBlobs * blobStride_;
+
+  int fd = -1;
+  if (owner_) {
+    shm_unlink(shmName_.c_str());
+    fd = shm_open(shmName_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    CAFFE_ENFORCE(
+        fd != -1, "shm_open ", shmName_, " failed: ", strerror(errno));
+    // The whole object is sized before the header is written, so that
+    // attaching processes can map it as soon as it is initialized.
+    if (ftruncate(fd, totalBytes) != 0) {
+      const int error = errno;
+      ::close(fd);
+      shm_unlink(shmName_.c_str());
+      CAFFE_THROW("ftruncate ", shmName_, " failed: ", strerror(error));
+    }
+  } else {
+    fd = shm_open(shmName_.c_str(), O_RDWR, 0);
+    CAFFE_ENFORCE(
+        fd != -1, "shm_open ", shmName_, " failed: ", strerror(errno));
+    struct stat st;
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) != totalBytes) {
+      ::close(fd);
+      CAFFE_THROW(
+          "Shared memory queue ",
+          shmName_,
+          " does not have the expected capacity, number of blobs or "
+          "maximum blob size");
+    }
+  }
+  void* data = mmap(
+      nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  // The mapping stays valid after the object is closed.
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    if (owner_) {
+      shm_unlink(shmName_.c_str());
+    }
+    CAFFE_THROW("mmap ", shmName_, " failed: ", strerror(errno));
+  }
+  mappedBytes_ = totalBytes;
+  header_ = static_cast<Header*>(data);
+  slots_ = static_cast<char*>(data) + slotsOffset;
+
+  if (owner_) {
+    // A new object is all zeros.
+    header_->magic = kShmQueueMagic;
+    header_->capacity = capacity_;
+    header_->numBlobs = numBlobs;
+    header_->maxBlobBytes = maxBlobBytes_;
+    header_->readPos.store(0, std::memory_order_relaxed);
+    header_->writePos.store(0, std::memory_order_relaxed);
+    for (size_t i = 0; i < capacity_; ++i) {
+      sequence(i).store(i, std::memory_order_relaxed);
+    }
+    header_->initialized.store(true, std::memory_order_release);
+  } else {
+    while (!header_->initialized.load(std::memory_order_acquire)) {
+      // Spin; the creator is about to write the header.
+      std::this_thread::yield();
+    }
+    if (header_->magic != kShmQueueMagic || header_->capacity != capacity_ ||
+        header_->numBlobs != numBlobs ||
+        header_->maxBlobBytes != maxBlobBytes_) {
+      munmap(data, mappedBytes_);
+      header_ = nullptr;
+      CAFFE_THROW(
+          "Shared memory queue ", shmName_, " has a different configuration");
+    }
+  }
+}
+
+ShmBlobsQueue::~ShmBlobsQueue() {
+  if (header_ != nullptr) {
+    munmap(header_, mappedBytes_);
+    // The processes attached to the queue keep their mappings.
+    if (owner_) {
+      shm_unlink(shmName_.c_str());
+    }
+  }
+}
+
+std::atomic<int64_t>& ShmBlobsQueue::sequence(int64_t pos) {
+  auto* sequences = reinterpret_cast<std::atomic<int64_t>*>(
+      reinterpret_cast<char*>(header_) + alignUp(sizeof(Header)));
+  return sequences[pos % capacity_];
+}
+
+char* ShmBlobsQueue::slot(int64_t pos, size_t blob) {
+  return slots_ + ((pos % capacity_) * getNumBlobs() + blob) * blobStride_;
+}
+
+void ShmBlobsQueue::writeSlot(int64_t pos, const std::vector<Blob*>& inputs) {
+  for (size_t i = 0; i < getNumBlobs(); ++i) {
+    const auto& tensor = inputs[i]->template Get<TensorCPU>();
+    char* dst = slot(pos, i);
+    auto* blobHeader = reinterpret_cast<BlobHeader*>(dst);
+    blobHeader->dataType = TypeMetaToDataType(tensor.meta());
+    blobHeader->ndim = tensor.ndim();
+    for (int d = 0; d < tensor.ndim(); ++d) {
+      blobHeader->dims[d] = tensor.dim(d);
+    }
+    blobHeader->nbytes = tensor.nbytes();
+    if (tensor.nbytes() > 0) {
+      memcpy(dst + sizeof(BlobHeader), tensor.raw_data(), tensor.nbytes());
+    }
+  }
+}
+
+void ShmBlobsQueue::readSlot(int64_t pos, const std::vector<Blob*>& inputs) {
+  for (size_t i = 0; i < getNumBlobs(); ++i) {
+    const char* src = slot(pos, i);
+    const auto* blobHeader = reinterpret_cast<const BlobHeader*>(src);
+    auto* tensor = inputs[i]->template GetMutable<TensorCPU>();
+    tensor->Resize(std::vector<TIndex>(
+        blobHeader->dims, blobHeader->dims + blobHeader->ndim));
+    void* data = tensor->raw_mutable_data(DataTypeToTypeMeta(
+        static_cast<TensorProto::DataType>(blobHeader->dataType)));
+    if (blobHeader->nbytes > 0) {
+      memcpy(data, src + sizeof(BlobHeader), blobHeader->nbytes);
+    }
+    CAFFE_EVENT(stats_, queue_dequeued_bytes, blobHeader->nbytes, i);
+  }
+}
+
+bool ShmBlobsQueue::tryRead(const std::vector<Blob*>& inputs) {
+  const int64_t capacity = capacity_;
+  int64_t pos = header_->readPos.load(std::memory_order_relaxed);
+  while (true) {
+    const int64_t seq = sequence(pos).load(std::memory_order_acquire);
+    if (seq < pos + 1) {
+      // Empty: the record of pos hasn't been written yet.
+      return false;
+    }
+    if (seq == pos + 1) {
+      // On failure pos is reloaded with the position of the next read.
+      if (header_->readPos.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else {
+      // Another reader took this record.
+      pos = header_->readPos.load(std::memory_order_relaxed);
+    }
+  }
+  CAFFE_EVENT(
+      stats_,
+      queue_depth,
+      header_->writePos.load(std::memory_order_relaxed) - pos);
+  readSlot(pos, inputs);
+  sequence(pos).store(pos + capacity, std::memory_order_release);
+  return true;
+}
+
+bool ShmBlobsQueue::tryWrite(const std::vector<Blob*>& inputs) {
+  CAFFE_ENFORCE(inputs.size() >= getNumBlobs());
+  // The records are checked before taking a slot, because the slot must be
+  // published once taken.
+  for (size_t i = 0; i < getNumBlobs(); ++i) {
+    CAFFE_ENFORCE(
+        inputs[i]->IsType<TensorCPU>(),
+        "Shared memory queues only hold CPU tensors");
+    const auto& tensor = inputs[i]->template Get<TensorCPU>();
+    CAFFE_ENFORCE(
+        tensor.meta().copy() == nullptr &&
+            TypeMetaToDataType(tensor.meta()) != TensorProto_DataType_UNDEFINED,
+        "Shared memory queues do not support tensors of ",
+        tensor.meta().name());
+    CAFFE_ENFORCE_LE(tensor.ndim(), kMaxDims);
+    CAFFE_ENFORCE_LE(
+        tensor.nbytes(),
+        maxBlobBytes_,
+        "Blob ",
+        i,
+        " does not fit in the slots of shared memory queue ",
+        shmName_);
+  }
+  if (header_->closed.load(std::memory_order_acquire)) {
+    return false;
+  }
+  Timer writeTimer;
+  int64_t pos = header_->writePos.load(std::memory_order_relaxed);
+  while (true) {
+    const int64_t seq = sequence(pos).load(std::memory_order_acquire);
+    if (seq < pos) {
+      // Full: the record of pos - capacity hasn't been read yet.
+      return false;
+    }
+    if (seq == pos) {
+      if (header_->writePos.compare_exchange_weak(
+              pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else {
+      // Another writer took this slot.
+      pos = header_->writePos.load(std::memory_order_relaxed);
+    }
+  }
+  writeSlot(pos, inputs);
+  sequence(pos).store(pos + 1, std::memory_order_release);
+  CAFFE_EVENT(stats_, queue_balance, 1);
+  CAFFE_EVENT(stats_, write_time_ns, writeTimer.NanoSeconds());
+  return true;
+}
+
+bool ShmBlobsQueue::blockingWrite(const std::vector<Blob*>& inputs) {
+  Timer waitTimer;
+  for (int attempt = 0;; ++attempt) {
+    if (tryWrite(inputs)) {
+      if (attempt > 0) {
+        CAFFE_EVENT(stats_, write_wait_time_ns, waitTimer.NanoSeconds());
+      }
+      return true;
+    }
+    if (header_->closed.load(std::memory_order_acquire)) {
+      return false;
+    }
+    backoff(attempt, waitTimer, 0);
+  }
+}
+
+bool ShmBlobsQueue::blockingRead(
+    const std::vector<Blob*>& inputs,
+    float timeout_secs) {
+  CAFFE_ENFORCE(inputs.size() >= getNumBlobs());
+  Timer readTimer;
+  CAFFE_EVENT(stats_, queue_balance, -1);
+  for (int attempt = 0;; ++attempt) {
+    if (tryRead(inputs)) {
+      if (attempt > 0) {
+        CAFFE_EVENT(stats_, read_wait_time_ns, readTimer.NanoSeconds());
+      }
+      CAFFE_EVENT(stats_, queue_dequeued_records);
+      CAFFE_EVENT(stats_, read_time_ns, readTimer.NanoSeconds());
+      return true;
+    }
+    // The records written before the queue was closed are still read.
+    if (header_->closed.load(std::memory_order_acquire)) {
+      if (!tryRead(inputs)) {
+        return false;
+      }
+      CAFFE_EVENT(stats_, queue_dequeued_records);
+      return true;
+    }
+    if (!backoff(attempt, readTimer, timeout_secs)) {
+      LOG(ERROR) << "DequeueBlobs timed out in " << timeout_secs << " secs";
+      return false;
+    }
+  }
+}
+
+void ShmBlobsQueue::close() {
+  header_->closed.store(true, std::memory_order_release);
+  BlobsQueue::close();
+}
+
+} // namespace caffe2
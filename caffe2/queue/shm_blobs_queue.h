@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "caffe2/queue/blobs_queue.h"
+
+namespace caffe2 {
+
+// A BlobsQueue whose circular buffer lives in POSIX shared memory, so that
+// reader processes can feed a trainer running in another process.
+//
+// One process creates the queue, which maps a new shared memory object of
+// the given name, and the other processes attach to it by name. Every slot of
+// the buffer is preallocated with maxBlobBytes bytes for each blob of a
+// record: writers copy the data of their CPU tensors in place into the slot,
+// and readers copy it out into their blobs, without serializing the tensors.
+// Only tensors of fixed size types (not strings) can be written.
+//
+// Records are handed off with a sequence number per slot, as in the MPMC
+// mode of BlobsQueue, so any number of processes can read and write. There is
+// no condition variable shared by the processes: readers and writers spin,
+// and then sleep, while the queue is empty or full.
+class ShmBlobsQueue : public BlobsQueue {
+ public:
+  // If attach is true, maps the queue created by another process under
+  // shmName, which must have the same capacity and number of blobs.
+  // Otherwise, creates the queue, replacing any existing object of the same
+  // name, and removes the name when destroyed.
+  ShmBlobsQueue(
+      Workspace* ws,
+      const std::string& queueName,
+      const std::string& shmName,
+      size_t capacity,
+      size_t numBlobs,
+      size_t maxBlobBytes,
+      bool attach,
+      const std::vector<std::string>& fieldNames = {});
+  ~ShmBlobsQueue();
+
+  bool blockingRead(const std::vector<Blob*>& inputs, float timeout_secs = 0.0f)
+      override;
+  bool tryWrite(const std::vector<Blob*>& inputs) override;
+  bool blockingWrite(const std::vector<Blob*>& inputs) override;
+  // Closes the queue for all the processes.
+  void close() override;
+
+  // Tensors have at most this number of dimensions.
+  static constexpr int kMaxDims = 8;
+
+ private:
+  struct Header;
+  struct BlobHeader;
+
+  bool tryRead(const std::vector<Blob*>& inputs);
+  void writeSlot(int64_t pos, const std::vector<Blob*>& inputs);
+  void readSlot(int64_t pos, const std::vector<Blob*>& inputs);
+  std::atomic<int64_t>& sequence(int64_t pos);
+  char* slot(int64_t pos, size_t blob);
+
+  const std::string shmName_;
+  const bool owner_;
+  size_t capacity_;
+  size_t maxBlobBytes_;
+  size_t blobStride_;
+  size_t mappedBytes_{0};
+  Header* header_{nullptr};
+  char* slots_{nullptr};
+};
+
+} // namespace caffe2
@@ -48,6 +48,11 @@ Given inputs (param, moment, indices, grad, lr), runs the dense AdaGrad
 update on (param, grad, moment[indices], lr), and returns (new_param,
 new_moment) as in the dense case.
 
+param may also be float16, with a float moment and grad. The update is then
+computed in float and written back to param with stochastic rounding, which
+rounds up or down with probabilities such that the expected value of the
+stored param is the exact result.
+
 )DOC")
     .Input(0, "param", "Parameters to be updated")
     .Input(1, "moment", "Moment history")
@@ -75,6 +80,9 @@ applied to an entire row of param, and the new moment is calculated by adding
 the average squared sum of gradients across each row. Note that indices must
 also be a 1D tensor indexing into the rows of param.
 
+As in SparseAdagrad, param may also be float16, and is then updated with
+stochastic rounding.
+
 )DOC")
     .Input(0, "param", "Parameters to be updated")
     .Input(1, "moment", "Moment history")
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+
 #include "caffe2/core/operator.h"
+#include "caffe2/perfkernels/stochastic_rounding.h"
 
 namespace caffe2 {
 
@@ -174,6 +178,10 @@ class SparseAdagradOp final : public Operator<Context> {
 
   template <typename SIndex>
   bool DoRunWithType() {
+    if (Input(PARAM).template IsType<float16>()) {
+      return DoRunWithFloat16Param<SIndex>();
+    }
+
     const auto* lr = Input(LR).template data<T>();
     const auto* indices = Input(INDICES).template data<SIndex>();
     const auto* gradIn = Input(GRAD).template data<T>();
@@ -234,8 +242,56 @@ class SparseAdagradOp final : public Operator<Context> {
     return true;
   }
 
+  // fp16 param with fp32 moment and grad, in place. The new values of a row
+  // are computed in fp32 and written back with stochastic rounding, so that
+  // updates smaller than the fp16 resolution of the param still count on
+  // average.
+  template <typename SIndex>
+  bool DoRunWithFloat16Param() {
+    const auto* lr = Input(LR).template data<T>();
+    const auto* indices = Input(INDICES).template data<SIndex>();
+    const auto* gradIn = Input(GRAD).template data<T>();
+    const auto* momentIn = Input(MOMENT_1).template data<T>();
+    auto* paramOut = Output(OUTPUT_PARAM)->template mutable_data<float16>();
+    auto* momentOut = Output(OUTPUT_MOMENT_1)->template mutable_data<T>();
+
+    auto n = Input(INDICES).size();
+    if (n == 0) {
+      return true;
+    }
+    if (!rng_) {
+      rng_.reset(new StochasticRoundingRNG(context_.RandGenerator()()));
+    }
+
+    auto block_size = Input(GRAD).size() / n;
+    update_.resize(block_size);
+    for (auto i = 0; i < n; ++i) {
+      auto idx = indices[i];
+      CAFFE_ENFORCE(
+          0 <= idx && idx < Input(PARAM).size() / block_size,
+          this->debug_def().input(PARAM),
+          ", out of bound,  idx:",
+          idx,
+          " for input i:",
+          i);
+      auto offsetI = i * block_size;
+      auto offsetIdx = idx * block_size;
+      for (auto j = 0; j < block_size; ++j) {
+        float gj = gradIn[offsetI + j];
+        float hj = momentOut[offsetIdx + j] =
+            momentIn[offsetIdx + j] + gj * gj;
+        update_[j] = lr[0] * gj / (std::sqrt(hj) + epsilon_);
+      }
+      Float16AxpyStochasticRounding(
+          block_size, 1.0f, update_.data(), paramOut + offsetIdx, rng_.get());
+    }
+    return true;
+  }
+
  protected:
   T epsilon_;
+  std::vector<float> update_;
+  std::unique_ptr<StochasticRoundingRNG> rng_;
   INPUT_TAGS(PARAM, MOMENT_1, INDICES, GRAD, LR);
   OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
 };
@@ -262,6 +318,10 @@ class RowWiseSparseAdagradOp final : public Operator<Context> {
 
   template <typename SIndex>
   bool DoRunWithType() {
+    if (Input(PARAM).template IsType<float16>()) {
+      return DoRunWithFloat16Param<SIndex>();
+    }
+
     const auto* lr = Input(LR).template data<T>();
     const auto* indices = Input(INDICES).template data<SIndex>();
     const auto* gradIn = Input(GRAD).template data<T>();
@@ -328,8 +388,51 @@ class RowWiseSparseAdagradOp final : public Operator<Context> {
     return true;
   }
 
+  // fp16 param with fp32 moment and grad, in place, with stochastic rounding
+  // as in SparseAdagradOp
+  template <typename SIndex>
+  bool DoRunWithFloat16Param() {
+    const auto* lr = Input(LR).template data<T>();
+    const auto* indices = Input(INDICES).template data<SIndex>();
+    const auto* gradIn = Input(GRAD).template data<T>();
+    const auto* momentIn = Input(MOMENT_1).template data<T>();
+    auto* paramOut = Output(OUTPUT_PARAM)->template mutable_data<float16>();
+    auto* momentOut = Output(OUTPUT_MOMENT_1)->template mutable_data<T>();
+
+    auto n = Input(INDICES).size();
+    if (n == 0) {
+      return true;
+    }
+    if (!rng_) {
+      rng_.reset(new StochasticRoundingRNG(context_.RandGenerator()()));
+    }
+
+    auto block_size = Input(GRAD).size() / n;
+    for (auto i = 0; i < n; ++i) {
+      auto idx = indices[i];
+      CAFFE_ENFORCE(
+          0 <= idx && idx < Input(PARAM).dim(0),
+          this->debug_def().input(PARAM),
+          ", out of bound,  idx:",
+          idx,
+          " for input i:",
+          i);
+      const float* g = gradIn + i * block_size;
+      float hs = 0.;
+      for (auto j = 0; j < block_size; ++j) {
+        hs += g[j] * g[j];
+      }
+      float hi = momentOut[idx] = momentIn[idx] + hs / block_size;
+      float step = lr[0] / (std::sqrt(hi) + epsilon_);
+      Float16AxpyStochasticRounding(
+          block_size, step, g, paramOut + idx * block_size, rng_.get());
+    }
+    return true;
+  }
+
  protected:
   T epsilon_;
+  std::unique_ptr<StochasticRoundingRNG> rng_;
   INPUT_TAGS(PARAM, MOMENT_1, INDICES, GRAD, LR);
   OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
 };
@@ -0,0 +1,94 @@
+#include "caffe2/sgd/sparse_lengths_sum_fused_ops.h"
+
+namespace caffe2 {
+
+REGISTER_CPU_OPERATOR(
+    RowWiseSparseAdagradFusedWithSparseLengthsSumGradient,
+    RowWiseSparseAdagradFusedWithSparseLengthsSumGradientOp<float>);
+OPERATOR_SCHEMA(RowWiseSparseAdagradFusedWithSparseLengthsSumGradient)
+    .NumInputs(6)
+    .NumOutputs(2)
+    .EnforceOneToOneInplace()
+    .SetDoc(R"DOC(
+
+Fused operator of SparseLengthsSumGradient and RowWiseSparseAdagrad. Given
+inputs (param, moment, indices, grad, lr, lengths), where grad is the gradient
+of the output of SparseLengthsSum(param, indices, lengths), runs the
+RowWiseSparseAdagrad update once for every distinct row of param in indices,
+with the sum of the gradients of all the segments that read it, and returns
+(new_param, new_moment) in place.
+
+Unlike SparseLengthsSumGradient followed by RowWiseSparseAdagrad, this never
+writes out a gradient row per index, and duplicate indices get a single
+update with their summed gradient.
+
+With hogwild set, the indices are split into chunks that are run on the thread
+pool of the workspace and update param and moment without locking. Duplicate
+indices are then only coalesced within a chunk, and concurrent updates of the
+same row can race, so the result is not deterministic.
+
+)DOC")
+    .Input(0, "param", "Parameters to be updated")
+    .Input(1, "moment", "Moment history, with one value per row of param")
+    .Input(
+        2,
+        "indices",
+        "Integer vector of the rows of param read by the SparseLengthsSum")
+    .Input(3, "grad", "Gradient of the output of the SparseLengthsSum")
+    .Input(4, "lr", "learning rate")
+    .Input(
+        5,
+        "lengths",
+        "Non negative vector with sum of elements equal to indices length")
+    .Output(0, "output_param", "Updated parameters")
+    .Output(1, "output_moment_1", "Updated moment")
+    .Arg("epsilon", "Default 1e-5")
+    .Arg("hogwild", "Default false. Run lock-free updates on several threads.");
+
+REGISTER_CPU_OPERATOR(
+    RowWiseSparseAdamFusedWithSparseLengthsSumGradient,
+    RowWiseSparseAdamFusedWithSparseLengthsSumGradientOp<float>);
+OPERATOR_SCHEMA(RowWiseSparseAdamFusedWithSparseLengthsSumGradient)
+    .NumInputs(8)
+    .NumOutputs(3)
+    .EnforceInplace({{0, 0}, {1, 1}, {2, 2}})
+    .SetDoc(R"DOC(
+
+Fused operator of SparseLengthsSumGradient and RowWiseSparseAdam. Given
+inputs (param, moment_1, moment_2, indices, grad, lr, iter, lengths), where
+grad is the gradient of the output of SparseLengthsSum(param, indices,
+lengths), runs the RowWiseSparseAdam update once for every distinct row of
+param in indices, with the sum of the gradients of all the segments that read
+it, and returns (new_param, new_moment_1, new_moment_2) in place.
+
+hogwild works as in RowWiseSparseAdagradFusedWithSparseLengthsSumGradient.
+
+)DOC")
+    .Input(0, "param", "Parameters to be updated")
+    .Input(1, "moment_1", "First moment history")
+    .Input(
+        2,
+        "moment_2",
+        "Second moment history, with one value per row of param")
+    .Input(
+        3,
+        "indices",
+        "Integer vector of the rows of param read by the SparseLengthsSum")
+    .Input(4, "grad", "Gradient of the output of the SparseLengthsSum")
+    .Input(5, "lr", "learning rate")
+    .Input(6, "iter", "iteration number")
+    .Input(
+        7,
+        "lengths",
+        "Non negative vector with sum of elements equal to indices length")
+    .Output(0, "output_param", "Updated parameters")
+    .Output(1, "output_moment_1", "Updated first moment")
+    .Output(2, "output_moment_2", "Updated second moment")
+    .Arg("beta1", "Default 0.9")
+    .Arg("beta2", "Default 0.999")
+    .Arg("epsilon", "Default 1e-5")
+    .Arg("hogwild", "Default false. Run lock-free updates on several threads.");
+
+SHOULD_NOT_DO_GRADIENT(RowWiseSparseAdagradFusedWithSparseLengthsSumGradient);
+SHOULD_NOT_DO_GRADIENT(RowWiseSparseAdamFusedWithSparseLengthsSumGradient);
+} // namespace caffe2
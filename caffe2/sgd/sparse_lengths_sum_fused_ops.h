@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+// Runs f(idx, g) once for every distinct row idx read by a SparseLengthsSum
+// over (indices, lengths) in [begin, end), where g points to the block_size
+// gradient values of row idx: the sum of the output gradients of all the
+// segments that read it. segment_ids[i] is the segment of indices[i].
+//
+// Rows read by one segment only are passed straight from grad. The others
+// are summed into row_grad, whose contents are only valid during the call
+// of f.
+template <typename SIndex, typename F>
+void for_each_sparse_lengths_sum_gradient_row(
+    TIndex block_size,
+    const float* grad,
+    const SIndex* indices,
+    const int* segment_ids,
+    TIndex begin,
+    TIndex end,
+    std::vector<std::pair<SIndex, int>>* sorted,
+    std::vector<float>* row_grad,
+    const F& f) {
+  sorted->clear();
+  sorted->reserve(end - begin);
+  for (TIndex i = begin; i < end; ++i) {
+    sorted->emplace_back(indices[i], segment_ids[i]);
+  }
+  std::sort(sorted->begin(), sorted->end());
+  row_grad->resize(block_size);
+
+  for (size_t i = 0; i < sorted->size();) {
+    const SIndex idx = (*sorted)[i].first;
+    const float* g = grad + (*sorted)[i].second * block_size;
+    size_t j = i + 1;
+    if (j < sorted->size() && (*sorted)[j].first == idx) {
+      float* sum = row_grad->data();
+      std::copy(g, g + block_size, sum);
+      for (; j < sorted->size() && (*sorted)[j].first == idx; ++j) {
+        const float* gj = grad + (*sorted)[j].second * block_size;
+        for (TIndex k = 0; k < block_size; ++k) {
+          sum[k] += gj[k];
+        }
+      }
+      g = sum;
+    }
+    f(idx, g);
+    i = j;
+  }
+}
+
+// Base class of the optimizers fused with the gradient of SparseLengthsSum.
+// Instead of the gradient of every index, which SparseLengthsSumGradient
+// would write out, these take the gradient of the SparseLengthsSum output
+// and the lengths, and apply one update per distinct row with the summed
+// gradient of all the indices that read it. This is the same update as
+// that of the unfused optimizer on coalesced gradients (for example after
+// a SparseLengthsSumGradient and a UnsortedSegmentSum over the indices).
+//
+// With the argument hogwild set, the indices are split into chunks that are
+// run on the thread pool of the workspace. Duplicate rows are only
+// coalesced within a chunk, and chunks that touch the same row update it
+// at the same time without any locking, as in Hogwild!. The result then
+// depends on the scheduling of the chunks.
+//
+// Derived classes pass the update of one row of their optimizer to
+// RunWithSparseLengthsSumGradient. They run in place: the updates only touch
+// the rows read by the indices.
+class SparseLengthsSumGradientFusedOptimizerBase : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  SparseLengthsSumGradientFusedOptimizerBase(
+      const OperatorDef& operator_def,
+      Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        hogwild_(OperatorBase::GetSingleArgument<bool>("hogwild", false)),
+        ws_(ws) {}
+
+ protected:
+  // Calls update(idx, g) for every distinct row of param that is read by
+  // indices. grad is the gradient of the output of SparseLengthsSum, with a
+  // row of block_size values per segment of lengths.
+  template <typename SIndex, typename Update>
+  void RunWithSparseLengthsSumGradient(
+      const TensorCPU& indices_input,
+      const TensorCPU& grad_input,
+      const TensorCPU& lengths_input,
+      TIndex num_rows,
+      TIndex block_size,
+      const Update& update) {
+    CAFFE_ENFORCE_EQ(1, indices_input.ndim(), "INDICES must be a vector");
+    CAFFE_ENFORCE_EQ(1, lengths_input.ndim(), "LENGTHS must be a vector");
+    CAFFE_ENFORCE_EQ(
+        grad_input.dim(0),
+        lengths_input.dim(0),
+        "GRAD must have a row per segment");
+    CAFFE_ENFORCE_EQ(grad_input.size_from_dim(1), block_size);
+
+    const auto* indices = indices_input.template data<SIndex>();
+    const auto* lengths = lengths_input.template data<int>();
+    const auto* grad = grad_input.template data<float>();
+    const TIndex n = indices_input.size();
+
+    segment_ids_.resize(n);
+    TIndex current = 0;
+    for (TIndex m = 0; m < lengths_input.size(); ++m) {
+      CAFFE_ENFORCE_GE(lengths[m], 0, "LENGTHS must be non negative");
+      CAFFE_ENFORCE_LE(
+          current + lengths[m],
+          n,
+          "The sum of LENGTHS is larger than the size of INDICES");
+      std::fill(
+          segment_ids_.begin() + current,
+          segment_ids_.begin() + current + lengths[m],
+          m);
+      current += lengths[m];
+    }
+    CAFFE_ENFORCE_EQ(
+        current,
+        n,
+        "Your input seems to be incorrect: the sum of lengths values should be "
+        "the size of the indices tensor, but it appears not.");
+    for (TIndex i = 0; i < n; ++i) {
+      CAFFE_ENFORCE(
+          0 <= indices[i] && indices[i] < num_rows,
+          "Index ",
+          i,
+          " is out of bounds: ",
+          indices[i],
+          ", range 0 to ",
+          num_rows);
+    }
+
+    const TIndex num_chunks =
+        hogwild_ ? std::max<TIndex>(1, n / kMinIndicesPerChunk) : 1;
+    auto run_chunk = [&](int /* unused */, size_t chunk) {
+      const TIndex c = chunk;
+      std::vector<std::pair<SIndex, int>> sorted;
+      std::vector<float> row_grad;
+      for_each_sparse_lengths_sum_gradient_row(
+          block_size,
+          grad,
+          indices,
+          segment_ids_.data(),
+          c * n / num_chunks,
+          (c + 1) * n / num_chunks,
+          &sorted,
+          &row_grad,
+          update);
+    };
+    if (num_chunks == 1) {
+      run_chunk(0, 0);
+    } else {
+      ws_->GetThreadPool()->run(run_chunk, num_chunks);
+    }
+  }
+
+ private:
+  // Chunks with fewer indices than this aren't worth handing to another
+  // thread.
+  static constexpr TIndex kMinIndicesPerChunk = 256;
+
+  bool hogwild_;
+  Workspace* ws_;
+  std::vector<int> segment_ids_;
+};
+
+// RowWiseSparseAdagrad on the gradient of SparseLengthsSum.
+template <typename T>
+class RowWiseSparseAdagradFusedWithSparseLengthsSumGradientOp final
+    : public SparseLengthsSumGradientFusedOptimizerBase {
+ public:
+  RowWiseSparseAdagradFusedWithSparseLengthsSumGradientOp(
+      const OperatorDef& operator_def,
+      Workspace* ws)
+      : SparseLengthsSumGradientFusedOptimizerBase(operator_def, ws),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+
+  bool RunOnDevice() override {
+    // Enforce shapes
+    CAFFE_ENFORCE_EQ(Input(PARAM).dims()[0], Input(MOMENT_1).size());
+    CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(INDICES));
+  }
+
+  template <typename SIndex>
+  bool DoRunWithType() {
+    const auto& param = Input(PARAM);
+    const TIndex block_size = param.size_from_dim(1);
+    const float lr = Input(LR).template data<T>()[0];
+    const float epsilon = epsilon_;
+    auto* paramOut = Output(OUTPUT_PARAM)->template mutable_data<T>();
+    auto* momentOut = Output(OUTPUT_MOMENT_1)->template mutable_data<T>();
+
+    RunWithSparseLengthsSumGradient<SIndex>(
+        Input(INDICES),
+        Input(GRAD),
+        Input(LENGTHS),
+        param.dim(0),
+        block_size,
+        [&](TIndex idx, const float* g) {
+          float* w = paramOut + idx * block_size;
+          float hs = 0.;
+          for (TIndex j = 0; j < block_size; ++j) {
+            hs += g[j] * g[j];
+          }
+          float hi = momentOut[idx] = momentOut[idx] + hs / block_size;
+          float step = lr / (std::sqrt(hi) + epsilon);
+          for (TIndex j = 0; j < block_size; ++j) {
+            w[j] += g[j] * step;
+          }
+        });
+    return true;
+  }
+
+ protected:
+  T epsilon_;
+  INPUT_TAGS(PARAM, MOMENT_1, INDICES, GRAD, LR, LENGTHS);
+  OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
+};
+
+// RowWiseSparseAdam on the gradient of SparseLengthsSum.
+template <typename T>
+class RowWiseSparseAdamFusedWithSparseLengthsSumGradientOp final
+    : public SparseLengthsSumGradientFusedOptimizerBase {
+ public:
+  RowWiseSparseAdamFusedWithSparseLengthsSumGradientOp(
+      const OperatorDef& operator_def,
+      Workspace* ws)
+      : SparseLengthsSumGradientFusedOptimizerBase(operator_def, ws),
+        beta1_(OperatorBase::GetSingleArgument<float>("beta1", 0.9f)),
+        beta2_(OperatorBase::GetSingleArgument<float>("beta2", 0.999f)),
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+
+  bool RunOnDevice() override {
+    // Enforce shapes
+    CAFFE_ENFORCE_EQ(Input(PARAM).size(), Input(MOMENT_1).size());
+    CAFFE_ENFORCE_EQ(Input(PARAM).dims()[0], Input(MOMENT_2).size());
+    CAFFE_ENFORCE_EQ(Input(LR).size(), 1);
+
+    return DispatchHelper<TensorTypes<int32_t, int64_t>>::call(
+        this, Input(INDICES));
+  }
+
+  template <typename SIndex>
+  bool DoRunWithType() {
+    const auto& param = Input(PARAM);
+    const TIndex block_size = param.size_from_dim(1);
+    const float lr = Input(LR).template data<T>()[0];
+    const auto iter =
+        OperatorBase::Input<TensorCPU>(ITER).template data<int64_t>()[0];
+
+    const auto t = iter + 1;
+    const float correction =
+        std::sqrt(T(1.) - std::pow(beta2_, t)) / (T(1.) - std::pow(beta1_, t));
+    const float beta1 = beta1_;
+    const float beta2 = beta2_;
+    const float epsilon = epsilon_;
+
+    auto* paramOut = Output(OUTPUT_PARAM)->template mutable_data<T>();
+    auto* moment1Out = Output(OUTPUT_MOMENT_1)->template mutable_data<T>();
+    auto* moment2Out = Output(OUTPUT_MOMENT_2)->template mutable_data<T>();
+
+    RunWithSparseLengthsSumGradient<SIndex>(
+        Input(INDICES),
+        Input(GRAD),
+        Input(LENGTHS),
+        param.dim(0),
+        block_size,
+        [&](TIndex idx, const float* g) {
+          float* w = paramOut + idx * block_size;
+          float* m1 = moment1Out + idx * block_size;
+          float m2_sum = 0.;
+          for (TIndex j = 0; j < block_size; ++j) {
+            m2_sum += g[j] * g[j];
+          }
+          float vi = moment2Out[idx] = moment2Out[idx] * beta2 +
+              (m2_sum / block_size) * (1 - beta2);
+          float step = lr * correction / (std::sqrt(vi) + epsilon);
+          for (TIndex j = 0; j < block_size; ++j) {
+            float mi = m1[j] = m1[j] * beta1 + g[j] * (1 - beta1);
+            w[j] += step * mi;
+          }
+        });
+    return true;
+  }
+
+ protected:
+  T beta1_;
+  T beta2_;
+  T epsilon_;
+  INPUT_TAGS(PARAM, MOMENT_1, MOMENT_2, INDICES, GRAD, LR, ITER, LENGTHS);
+  OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1, OUTPUT_MOMENT_2);
+};
+
+} // namespace caffe2
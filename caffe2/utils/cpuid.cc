@@ -1,5 +1,9 @@
 #include "caffe2/utils/cpuid.h"
 
+#if defined(__linux__) && (defined(__aarch64__) || defined(__arm__))
+#include <sys/auxv.h>
+#endif
+
 namespace caffe2 {
 
 const CpuId& GetCpuId() {
@@ -11,6 +15,7 @@ CAFFE2_API uint32_t CpuId::f1c_ = 0;
 CAFFE2_API uint32_t CpuId::f1d_ = 0;
 CAFFE2_API uint32_t CpuId::f7b_ = 0;
 CAFFE2_API uint32_t CpuId::f7c_ = 0;
+CAFFE2_API uint32_t CpuId::hwcap_ = 0;
 
 CpuId::CpuId() {
 #ifdef _MSC_VER
@@ -74,6 +79,16 @@ CpuId::CpuId() {
             : "a"(7), "c"(0)
             : "edx");
   }
+#elif defined(__linux__) && defined(__aarch64__)
+  hwcap_ = uint32_t(getauxval(AT_HWCAP));
+#elif defined(__linux__) && defined(__arm__)
+  // 32-bit ARM has its own HWCAP bits, VFP being bit 6 and NEON bit 12
+  const unsigned long hwcap = getauxval(AT_HWCAP);
+  hwcap_ = (hwcap & (1UL << 6) ? 1U << 0 : 0) |
+      (hwcap & (1UL << 12) ? 1U << 1 : 0);
+#elif defined(__aarch64__) || defined(__ARM_NEON__) || defined(__ARM_NEON)
+  // Without a way to ask the OS, e.g. on iOS, report what the build targets
+  hwcap_ = 1U << 0 | 1U << 1;
 #endif
 }
 
@@ -23,6 +23,9 @@ CAFFE2_API const CpuId& GetCpuId();
  * Supports CPUID feature flags (EAX=1) and extended features (EAX=7, ECX=0).
  * Values from
  * http://www.intel.com/content/www/us/en/processors/processor-identification-cpuid-instruction-note.html
+ *
+ * On ARM, the features of the other architecture are all false, and the ARM
+ * ones are read from the HWCAP of Linux.
  */
 class CpuId {
  public:
@@ -131,6 +134,18 @@ class CpuId {
   E(avx512vbmi, 1)
 #undef E
 
+// ARM: the HWCAP bits that Linux reports through getauxval(AT_HWCAP), which
+// are normalized to the AArch64 ones on 32-bit ARM for the features below.
+#define H(name, bit) X(name, hwcap_, bit)
+  H(fp, 0)
+  H(neon, 1)
+  // Half-precision arithmetic in the scalar and NEON units (ARMv8.2). Loads
+  // and stores of fp16 only need neon.
+  H(fphp, 9)
+  H(asimdhp, 10)
+  H(asimddp, 20)
+#undef H
+
 #undef X
 
  private:
@@ -138,6 +153,7 @@ class CpuId {
   CAFFE2_API static uint32_t f1d_;
   CAFFE2_API static uint32_t f7b_;
   CAFFE2_API static uint32_t f7c_;
+  CAFFE2_API static uint32_t hwcap_;
 };
 
 } // namespace caffe2
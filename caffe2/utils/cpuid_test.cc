@@ -3,8 +3,17 @@
 
 namespace caffe2 {
 
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__)
 TEST(CpuIdTest, ShouldAlwaysHaveMMX) {
   EXPECT_TRUE(GetCpuId().mmx());
 }
+#endif
+
+#if defined(__aarch64__)
+TEST(CpuIdTest, ShouldAlwaysHaveNEON) {
+  EXPECT_TRUE(GetCpuId().neon());
+  EXPECT_FALSE(GetCpuId().avx());
+}
+#endif
 
 } // namespace caffe2
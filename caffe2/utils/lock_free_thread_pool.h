@@ -0,0 +1,215 @@
+#ifndef CAFFE2_UTILS_LOCK_FREE_THREAD_POOL_H_
+#define CAFFE2_UTILS_LOCK_FREE_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/numa.h"
+#include "caffe2/core/thread_topology.h"
+#include "caffe2/utils/mpmc_queue.h"
+#include "caffe2/utils/thread_name.h"
+#include "caffe2/utils/thread_pool.h"
+#include "caffe2/utils/threadpool/WorkersPool.h"
+
+namespace caffe2 {
+
+// A TaskThreadPoolBase that hands tasks to its workers through a bounded
+// lock-free MPMC queue instead of a mutex-guarded std::queue. Idle workers
+// spin on the queue for a while before parking on a condition variable,
+// and producers only touch the mutex when some worker is actually parked,
+// so a busy pool scheduling many tiny tasks never goes through the kernel.
+//
+// Tasks that do not fit in the bounded queue go to a locked overflow queue
+// rather than blocking the producer (which is often a worker itself).
+class LockFreeTaskThreadPool : public TaskThreadPoolBase {
+ public:
+  explicit LockFreeTaskThreadPool(
+      std::size_t pool_size,
+      int numa_node_id = -1,
+      std::size_t queue_capacity = 4096,
+      int spin_iterations = 4096)
+      : queue_(queue_capacity),
+        pending_(0),
+        active_(0),
+        sleeping_(0),
+        overflow_size_(0),
+        running_(true),
+        numa_node_id_(numa_node_id),
+        spin_iterations_(spin_iterations) {
+    threads_.reserve(pool_size);
+    for (std::size_t i = 0; i < pool_size; ++i) {
+      threads_.emplace_back([this, i]() { this->main_loop(i); });
+    }
+  }
+
+  ~LockFreeTaskThreadPool() override {
+    {
+      std::lock_guard<std::mutex> lock(park_mutex_);
+      running_ = false;
+      park_cond_.notify_all();
+    }
+    for (auto& t : threads_) {
+      t.join();
+    }
+  }
+
+  size_t size() const override {
+    return threads_.size();
+  }
+
+  size_t num_available() const override {
+    return threads_.size() - active_.load(std::memory_order_relaxed);
+  }
+
+  void run(const std::function<void()>& func) override {
+    push(Element(func));
+  }
+
+  void runWithID(const std::function<void(std::size_t)>& func) override {
+    push(Element(func));
+  }
+
+  void waitWorkComplete() override {
+    std::unique_lock<std::mutex> lock(completed_mutex_);
+    completed_cond_.wait(lock, [this]() {
+      return pending_.load() == 0 && active_.load() == 0;
+    });
+  }
+
+ private:
+  struct Element {
+    Element() {}
+    explicit Element(const std::function<void()>& f) : no_id(f) {}
+    explicit Element(const std::function<void(std::size_t)>& f) : with_id(f) {}
+
+    std::function<void()> no_id;
+    std::function<void(std::size_t)> with_id;
+  };
+
+  void push(Element&& element) {
+    // Count the task before it becomes visible so that a worker popping
+    // it can never drive pending_ below zero. Publishing through pending_
+    // and then checking for sleepers pairs with the worker registering in
+    // sleeping_ and then checking pending_ (both seq_cst): at least one of
+    // the two sees the other.
+    pending_.fetch_add(1);
+    if (!queue_.TryPush(std::move(element))) {
+      std::lock_guard<std::mutex> lock(overflow_mutex_);
+      overflow_.push(std::move(element));
+      overflow_size_.fetch_add(1, std::memory_order_release);
+    }
+    if (sleeping_.load() > 0) {
+      std::lock_guard<std::mutex> lock(park_mutex_);
+      park_cond_.notify_one();
+    }
+  }
+
+  bool pop(Element* element) {
+    if (queue_.TryPop(element)) {
+      return true;
+    }
+    if (overflow_size_.load(std::memory_order_acquire) == 0) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(overflow_mutex_);
+    if (overflow_.empty()) {
+      return false;
+    }
+    *element = std::move(overflow_.front());
+    overflow_.pop();
+    overflow_size_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Returns false once the pool is shutting down.
+  bool wait_for_task(Element* element) {
+    for (int spin = 0; spin < spin_iterations_; ++spin) {
+      if (pending_.load(std::memory_order_relaxed) > 0 && pop(element)) {
+        return true;
+      }
+      Do256NOPs();
+    }
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    while (running_) {
+      sleeping_.fetch_add(1);
+      park_cond_.wait(
+          lock, [this]() { return pending_.load() > 0 || !running_; });
+      sleeping_.fetch_sub(1);
+      if (!running_) {
+        break;
+      }
+      lock.unlock();
+      if (pop(element)) {
+        return true;
+      }
+      lock.lock();
+    }
+    return false;
+  }
+
+  /// @brief Entry point for pool threads.
+  void main_loop(std::size_t index) {
+    setThreadName("CaffeTaskThread");
+    NUMABind(numa_node_id_);
+    ApplyThreadTopologyToCurrentThread(numa_node_id_);
+
+    Element element;
+    while (true) {
+      // Count the task as active before giving up pending_ so that
+      // waitWorkComplete never sees both at zero in the middle of a task.
+      if (!pop(&element) && !wait_for_task(&element)) {
+        return;
+      }
+      active_.fetch_add(1);
+      pending_.fetch_sub(1);
+      try {
+        if (element.with_id) {
+          element.with_id(index);
+        } else {
+          element.no_id();
+        }
+      } catch (const std::exception&) {
+      }
+      // Destroy the task (and anything it captured) right away.
+      element = Element();
+      if (active_.fetch_sub(1) == 1 && pending_.load() == 0) {
+        std::lock_guard<std::mutex> lock(completed_mutex_);
+        completed_cond_.notify_all();
+      }
+    }
+  }
+
+  BoundedMPMCQueue<Element> queue_;
+  std::vector<std::thread> threads_;
+
+  // Tasks pushed but not yet picked up by a worker, and tasks running.
+  std::atomic<std::size_t> pending_;
+  std::atomic<std::size_t> active_;
+  std::atomic<int> sleeping_;
+
+  std::mutex overflow_mutex_;
+  std::queue<Element> overflow_;
+  std::atomic<std::size_t> overflow_size_;
+
+  std::mutex park_mutex_;
+  std::condition_variable park_cond_;
+  bool running_;
+
+  std::mutex completed_mutex_;
+  std::condition_variable completed_cond_;
+
+  const int numa_node_id_;
+  const int spin_iterations_;
+
+  DISABLE_COPY_AND_ASSIGN(LockFreeTaskThreadPool);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_LOCK_FREE_THREAD_POOL_H_
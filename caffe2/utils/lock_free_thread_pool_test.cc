@@ -0,0 +1,107 @@
+#include <atomic>
+#include <thread> // NOLINT
+#include <vector>
+
+#include "caffe2/utils/lock_free_thread_pool.h"
+#include "caffe2/utils/mpmc_queue.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+TEST(BoundedMPMCQueueTest, FifoAndBounded) {
+  BoundedMPMCQueue<int> queue(3);
+  EXPECT_EQ(queue.capacity(), 4);
+  int value;
+  EXPECT_FALSE(queue.TryPop(&value));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.TryPush(int(i)));
+  }
+  EXPECT_FALSE(queue.TryPush(4));
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.TryPop(&value));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.TryPop(&value));
+}
+
+TEST(BoundedMPMCQueueTest, ManyProducersManyConsumers) {
+  const int kProducers = 4;
+  const int kPerProducer = 20000;
+  BoundedMPMCQueue<int> queue(64);
+  std::vector<std::atomic<int>> seen(kProducers * kPerProducer);
+  for (auto& s : seen) {
+    s = 0;
+  }
+  std::atomic<int> consumed(0);
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&, p]() {
+      for (int i = 0; i < kPerProducer; ++i) {
+        int v = p * kPerProducer + i;
+        while (!queue.TryPush(std::move(v))) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int c = 0; c < 4; ++c) {
+    threads.emplace_back([&]() {
+      int v;
+      while (consumed < kProducers * kPerProducer) {
+        if (queue.TryPop(&v)) {
+          seen[v]++;
+          consumed++;
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  for (auto& s : seen) {
+    EXPECT_EQ(s, 1);
+  }
+}
+
+TEST(LockFreeTaskThreadPoolTest, RunsAllTasks) {
+  // A tiny queue exercises the overflow path as well.
+  LockFreeTaskThreadPool pool(4, -1, 8, 16);
+  EXPECT_EQ(pool.size(), 4);
+  std::atomic<int> counter(0);
+  std::atomic<bool> bad_id(false);
+  for (int i = 0; i < 10000; ++i) {
+    if (i % 2) {
+      pool.run([&counter]() { counter++; });
+    } else {
+      pool.runTaskWithID([&](std::size_t id) {
+        if (id >= 4) {
+          bad_id = true;
+        }
+        counter++;
+      });
+    }
+  }
+  pool.waitWorkComplete();
+  EXPECT_EQ(counter, 10000);
+  EXPECT_FALSE(bad_id);
+  EXPECT_EQ(pool.num_available(), 4);
+}
+
+TEST(LockFreeTaskThreadPoolTest, TasksScheduleTasks) {
+  LockFreeTaskThreadPool pool(3);
+  std::atomic<int> counter(0);
+  std::function<void(int)> spawn = [&](int depth) {
+    counter++;
+    if (depth > 0) {
+      pool.run([&spawn, depth]() { spawn(depth - 1); });
+      pool.run([&spawn, depth]() { spawn(depth - 1); });
+    }
+  };
+  pool.run([&spawn]() { spawn(12); });
+  pool.waitWorkComplete();
+  EXPECT_EQ(counter, (1 << 13) - 1);
+}
+
+} // namespace caffe2
@@ -29,6 +29,7 @@
 #include <vector>
 
 #include "caffe2/core/context.h"
+#include "caffe2/perfkernels/elementwise_binary.h"
 #include "caffe2/utils/cpu_neon.h"
 
 #include "Eigen/Core"
@@ -1418,6 +1419,53 @@ void BinaryOpWith2DBroadcasting(
   }
 }
 
+// Computes C[i] = op(A[i * A_stride], B[i * B_stride]) for i in [0, N), where
+// the strides are 0 or 1, so that the loops vectorize.
+template <typename TIn, typename TOut, class BinaryOperator>
+void BinaryOpRun(
+    const int N,
+    const BinaryOperator& op,
+    const TIn* A,
+    const int A_stride,
+    const TIn* B,
+    const int B_stride,
+    TOut* C) {
+  if (A_stride && B_stride) {
+    for (int i = 0; i < N; ++i) {
+      C[i] = op(A[i], B[i]);
+    }
+  } else if (A_stride) {
+    const TIn b = B[0];
+    for (int i = 0; i < N; ++i) {
+      C[i] = op(A[i], b);
+    }
+  } else if (B_stride) {
+    const TIn a = A[0];
+    for (int i = 0; i < N; ++i) {
+      C[i] = op(a, B[i]);
+    }
+  } else {
+    std::fill(C, C + N, op(A[0], B[0]));
+  }
+}
+
+#define DELEGATE_FLOAT_BINARY_OP_RUN(Op, Func)               \
+  void BinaryOpRun(                                          \
+      const int N,                                           \
+      const Op<float>& /* op */,                             \
+      const float* A,                                        \
+      const int A_stride,                                    \
+      const float* B,                                        \
+      const int B_stride,                                    \
+      float* C) {                                            \
+    ElementwiseBinary##Func(N, A, A_stride, B, B_stride, C); \
+  }
+DELEGATE_FLOAT_BINARY_OP_RUN(std::plus, Add)
+DELEGATE_FLOAT_BINARY_OP_RUN(std::minus, Sub)
+DELEGATE_FLOAT_BINARY_OP_RUN(std::multiplies, Mul)
+DELEGATE_FLOAT_BINARY_OP_RUN(std::divides, Div)
+#undef DELEGATE_FLOAT_BINARY_OP_RUN
+
 template <typename TIn, typename TOut, class BinaryOperator>
 void BroadcastBinaryOpImpl(
     const int ndim,
@@ -1428,14 +1476,55 @@ void BroadcastBinaryOpImpl(
     const TIn* A,
     const TIn* B,
     TOut* C) {
-  std::vector<int> index(ndim, 0);
-  const int C_size =
-      std::accumulate(C_dims, C_dims + ndim, 1, std::multiplies<int>());
-  for (int C_index = 0; C_index < C_size; ++C_index) {
-    const int A_index = utils::GetIndexFromDims(ndim, A_dims, index.data());
-    const int B_index = utils::GetIndexFromDims(ndim, B_dims, index.data());
-    C[C_index] = op(A[A_index], B[B_index]);
-    utils::IncreaseIndexInDims(ndim, C_dims, index.data());
+  // Merges the adjacent dimensions along which both A and B are either
+  // broadcast or not, so that the innermost runs are as long as possible
+  std::vector<int> A_merged;
+  std::vector<int> B_merged;
+  std::vector<int> C_merged;
+  for (int i = 0; i < ndim; ++i) {
+    if (C_dims[i] == 1) {
+      continue;
+    }
+    const bool A_broadcast = A_dims[i] == 1;
+    const bool B_broadcast = B_dims[i] == 1;
+    if (!C_merged.empty() && (A_merged.back() == 1) == A_broadcast &&
+        (B_merged.back() == 1) == B_broadcast) {
+      A_merged.back() *= A_dims[i];
+      B_merged.back() *= B_dims[i];
+      C_merged.back() *= C_dims[i];
+    } else {
+      A_merged.push_back(A_dims[i]);
+      B_merged.push_back(B_dims[i]);
+      C_merged.push_back(C_dims[i]);
+    }
+  }
+  if (C_merged.empty()) {
+    C[0] = op(A[0], B[0]);
+    return;
+  }
+
+  // Runs the innermost dimension at once for every index of the outer ones
+  const int merged_ndim = C_merged.size();
+  const int inner_size = C_merged.back();
+  const int A_stride = A_merged.back() == 1 ? 0 : 1;
+  const int B_stride = B_merged.back() == 1 ? 0 : 1;
+  const int outer_size = std::accumulate(
+      C_merged.cbegin(), C_merged.cend() - 1, 1, std::multiplies<int>());
+  std::vector<int> index(merged_ndim, 0);
+  for (int outer = 0; outer < outer_size; ++outer) {
+    const int A_index =
+        utils::GetIndexFromDims(merged_ndim, A_merged.data(), index.data());
+    const int B_index =
+        utils::GetIndexFromDims(merged_ndim, B_merged.data(), index.data());
+    BinaryOpRun(
+        inner_size,
+        op,
+        A + A_index,
+        A_stride,
+        B + B_index,
+        B_stride,
+        C + outer * inner_size);
+    utils::IncreaseIndexInDims(merged_ndim - 1, C_merged.data(), index.data());
   }
 }
 
@@ -9,6 +9,35 @@ namespace caffe2 {
 namespace math {
 namespace utils {
 
+void WelfordMoments(const int N, const float* X, float* mean, float* var) {
+  // The lanes are updated in lockstep and hold the same number of values, so
+  // a step needs a single reciprocal and the inner loop vectorizes.
+  constexpr int kLanes = 8;
+  float lane_mean[kLanes] = {0};
+  float lane_m2[kLanes] = {0};
+  const int steps = N / kLanes;
+  for (int k = 0; k < steps; ++k) {
+    const float inv = 1.0f / static_cast<float>(k + 1);
+    const float* x = X + k * kLanes;
+    for (int j = 0; j < kLanes; ++j) {
+      const float delta = x[j] - lane_mean[j];
+      lane_mean[j] += delta * inv;
+      lane_m2[j] += delta * (x[j] - lane_mean[j]);
+    }
+  }
+  WelfordData<float> data{0.0f, 0.0f, 0.0f};
+  for (int j = 0; j < kLanes; ++j) {
+    data = WelfordCombine(
+        data,
+        WelfordData<float>{lane_mean[j], lane_m2[j], static_cast<float>(steps)});
+  }
+  for (int i = steps * kLanes; i < N; ++i) {
+    data = WelfordCombine(data, WelfordData<float>{X[i], 0.0f, 1.0f});
+  }
+  *mean = data.mean;
+  *var = N > 0 ? data.m2 / static_cast<float>(N) : 0.0f;
+}
+
 void IncreaseIndexInDims(const int n, const int* dims, int* index) {
   for (int i = n - 1; i >= 0; --i) {
     ++index[i];
@@ -40,6 +40,33 @@ MATH_UTILS_DECL T Cube(const T x) {
   return x * x * x;
 }
 
+// The moments of a set of n values accumulated with Welford's algorithm:
+// their mean and the sum m2 of their squared deviations from it.
+template <typename T>
+struct WelfordData {
+  T mean;
+  T m2;
+  T n;
+};
+
+// The moments of the union of the values of a and b.
+template <typename T>
+MATH_UTILS_DECL WelfordData<T> WelfordCombine(
+    const WelfordData<T>& a,
+    const WelfordData<T>& b) {
+  const T n = a.n + b.n;
+  if (n == T(0)) {
+    return a;
+  }
+  const T delta = b.mean - a.mean;
+  const T ratio = b.n / n;
+  return WelfordData<T>{
+      a.mean + delta * ratio, a.m2 + b.m2 + delta * delta * a.n * ratio, n};
+}
+
+// Computes the mean and the biased variance of X[0:N] in a single pass.
+void WelfordMoments(const int N, const float* X, float* mean, float* var);
+
 // Increase the index digits by one based on dims.
 void IncreaseIndexInDims(const int n, const int* dims, int* index);
 
@@ -0,0 +1,116 @@
+#ifndef CAFFE2_UTILS_MPMC_QUEUE_H_
+#define CAFFE2_UTILS_MPMC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+
+// A bounded multi-producer multi-consumer queue without locks, after
+// Dmitry Vyukov's "Bounded MPMC queue". Every cell carries a sequence
+// number telling producers and consumers whose turn it is, so a push or a
+// pop costs one CAS on the shared head or tail counter and no other
+// cross-thread synchronization. TryPush fails when the queue is full and
+// TryPop when it is empty; neither ever blocks.
+template <typename T>
+class BoundedMPMCQueue {
+ public:
+  // capacity is rounded up to a power of two.
+  explicit BoundedMPMCQueue(size_t capacity)
+      : mask_(RoundUpToPowerOfTwo(capacity) - 1),
+        cells_(new Cell[mask_ + 1]),
+        enqueue_pos_(0),
+        dequeue_pos_(0) {
+    CAFFE_ENFORCE_GT(capacity, 0);
+    for (size_t i = 0; i <= mask_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  size_t capacity() const {
+    return mask_ + 1;
+  }
+
+  bool TryPush(T&& value) {
+    Cell* cell;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // Full.
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->value = std::move(value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPop(T* value) {
+    Cell* cell;
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      const size_t seq = cell->sequence.load(std::memory_order_acquire);
+      const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // Empty.
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    *value = std::move(cell->value);
+    // Release whatever the moved-from value still holds before handing the
+    // cell back to producers.
+    cell->value = T();
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+ private:
+  static size_t RoundUpToPowerOfTwo(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T value;
+  };
+
+  // Producers and consumers hammer different counters; keep them, and the
+  // read-only part, on separate cache lines.
+  const size_t mask_;
+  const std::unique_ptr<Cell[]> cells_;
+  alignas(64) std::atomic<size_t> enqueue_pos_;
+  alignas(64) std::atomic<size_t> dequeue_pos_;
+
+  DISABLE_COPY_AND_ASSIGN(BoundedMPMCQueue);
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_MPMC_QUEUE_H_
@@ -9,11 +9,43 @@
 #include <utility>
 
 #include "caffe2/core/numa.h"
+#include "caffe2/core/thread_topology.h"
 #include "caffe2/utils/thread_name.h"
 
 namespace caffe2 {
 
-class TaskThreadPool {
+// Interface of the pools that back async nets; see
+// GetAsyncNetCPUThreadPool for how an implementation is chosen.
+class TaskThreadPoolBase {
+ public:
+  virtual ~TaskThreadPoolBase() {}
+
+  virtual size_t size() const = 0;
+
+  /**
+   * The number of available (i.e. idle) threads in this thread pool.
+   */
+  virtual size_t num_available() const = 0;
+
+  virtual void run(const std::function<void()>& func) = 0;
+
+  virtual void runWithID(const std::function<void(std::size_t)>& func) = 0;
+
+  /// @brief Wait for queue to be empty
+  virtual void waitWorkComplete() = 0;
+
+  template <typename Task>
+  void runTask(Task task) {
+    run(static_cast<std::function<void()>>(task));
+  }
+
+  template <typename Task>
+  void runTaskWithID(Task task) {
+    runWithID(static_cast<std::function<void(std::size_t)>>(task));
+  }
+};
+
+class TaskThreadPool : public TaskThreadPoolBase {
  private:
   struct task_element_t {
     bool run_with_id;
@@ -51,7 +83,7 @@ class TaskThreadPool {
   }
 
   // Set running flag to false then notify all threads.
-  ~TaskThreadPool() {
+  ~TaskThreadPool() override {
     {
       std::unique_lock<std::mutex> lock(mutex_);
       running_ = false;
@@ -66,47 +98,36 @@ class TaskThreadPool {
     }
   }
 
-  size_t size() const {
+  size_t size() const override {
     return threads_.size();
   }
 
-  /**
-   * The number of available (i.e. idle) threads in this thread pool.
-   */
-  size_t num_available() const {
+  size_t num_available() const override {
     return available_;
   }
 
   /// @brief Add task to the thread pool if a thread is currently available.
-  template <typename Task>
-  void runTask(Task task) {
+  void run(const std::function<void()>& func) override {
     std::unique_lock<std::mutex> lock(mutex_);
 
     // Set task and signal condition variable so that a worker thread will
     // wake up and use the task.
-    tasks_.push(task_element_t(static_cast<std::function<void()>>(task)));
+    tasks_.push(task_element_t(func));
     complete_ = false;
     condition_.notify_one();
   }
 
-  void run(const std::function<void()>& func) {
-    runTask(func);
-  }
-
-  template <typename Task>
-  void runTaskWithID(Task task) {
+  void runWithID(const std::function<void(std::size_t)>& func) override {
     std::unique_lock<std::mutex> lock(mutex_);
 
     // Set task and signal condition variable so that a worker thread will
     // wake up and use the task.
-    tasks_.push(
-        task_element_t(static_cast<std::function<void(std::size_t)>>(task)));
+    tasks_.push(task_element_t(func));
     complete_ = false;
     condition_.notify_one();
   }
 
-  /// @brief Wait for queue to be empty
-  void waitWorkComplete() {
+  void waitWorkComplete() override {
     std::unique_lock<std::mutex> lock(mutex_);
     while (!complete_) {
       completed_.wait(lock);
@@ -118,6 +139,7 @@ class TaskThreadPool {
   void main_loop(std::size_t index) {
     setThreadName("CaffeTaskThread");
     NUMABind(numa_node_id_);
+    ApplyThreadTopologyToCurrentThread(numa_node_id_);
 
     while (running_) {
       // Wait on condition variable while the task is empty and
@@ -1,6 +1,11 @@
 #include "caffe2/utils/threadpool/ThreadPool.h"
+#include "WorkStealingDeque.h"
 #include "WorkersPool.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/core/thread_topology.h"
+#include "caffe2/utils/thread_name.h"
+
+#include <exception>
 
 #include <cpuinfo.h>
 
@@ -13,6 +18,12 @@ CAFFE2_DEFINE_int(caffe2_threadpool_android_cap, true, "");
 // Whether or not threadpool caps apply to iOS
 CAFFE2_DEFINE_int(caffe2_threadpool_ios_cap, true, "");
 
+CAFFE2_DEFINE_int(
+    caffe2_threadpool_num_threads,
+    0,
+    "Number of threads of the default thread pool; 0 picks it from the "
+    "number of processors and the caps above");
+
 
 namespace caffe2 {
 
@@ -24,6 +35,56 @@ constexpr size_t kDefaultMinWorkSize = 8;
 constexpr size_t kDefaultMinWorkSize = 80;
 #endif
 
+// Number of threads that may be inside run() at the same time and still
+// get help from the workers; further concurrent callers run inline
+constexpr size_t kNumCallerSlots = 16;
+static_assert(kNumCallerSlots < 64, "caller slots are kept in a bitmask");
+
+// A range is bisected until its pieces are no larger than
+// range / (numThreads * kSplitsPerThread), so that stealing has something
+// left to balance with once the first pieces finish unevenly
+constexpr size_t kSplitsPerThread = 4;
+
+// Number of unsuccessful steal sweeps a worker spins through before it
+// parks on the condition variable
+constexpr int kStealSpins = 1024;
+
+// State shared by all the pieces of one call to run(). It lives on the
+// stack of the calling thread, which does not return before remaining
+// drops to zero.
+struct ThreadPoolJob {
+  const std::function<void(int, size_t)>* fn;
+  size_t grain;
+  std::atomic<size_t> remaining;
+  std::atomic<bool> done{false};
+  std::mutex mutex;
+  std::condition_variable cond;
+  std::exception_ptr exception;
+
+  void finish(size_t count) {
+    if (remaining.fetch_sub(count, std::memory_order_acq_rel) == count) {
+      std::lock_guard<std::mutex> g(mutex);
+      done.store(true, std::memory_order_release);
+      cond.notify_one();
+    }
+  }
+
+  void wait() {
+    WaitForVariableChange(&done, false, &cond, &mutex);
+    // The finishing thread may still hold the mutex; make sure it has
+    // released it before the job goes out of scope.
+    std::lock_guard<std::mutex> g(mutex);
+  }
+};
+
+namespace {
+
+void deleteDeque(WorkStealingDeque<ThreadPoolJob, 256>* d) {
+  AllocAligned<WorkStealingDeque<ThreadPoolJob, 256>>::release(d);
+}
+
+} // namespace
+
 std::unique_ptr<ThreadPool> ThreadPool::defaultThreadPool() {
   CAFFE_ENFORCE(cpuinfo_initialize(), "cpuinfo initialization failed");
   int numThreads = cpuinfo_get_processors_count();
@@ -76,18 +137,44 @@ std::unique_ptr<ThreadPool> ThreadPool::defaultThreadPool() {
         break;
     }
   }
+  if (caffe2::FLAGS_caffe2_threadpool_num_threads > 0) {
+    numThreads = caffe2::FLAGS_caffe2_threadpool_num_threads;
+  } else if (const auto* topology = GetThreadTopology()) {
+    // Callers get help from the workers like from an intra-op team
+    numThreads = topology->FindSocket(-1)->intra_op_threads;
+  }
   LOG(INFO) << "Constructing thread pool with " << numThreads << " threads";
   return caffe2::make_unique<ThreadPool>(numThreads);
 }
 
 ThreadPool::ThreadPool(int numThreads)
-    : minWorkSize_(kDefaultMinWorkSize), numThreads_(numThreads),
-      workersPool_(std::make_shared<WorkersPool>()) {}
+    : minWorkSize_(kDefaultMinWorkSize),
+      numThreads_(numThreads),
+      freeCallerSlots_((uint64_t(1) << kNumCallerSlots) - 1),
+      workEpoch_(0),
+      sleepingWorkers_(0),
+      exiting_(false) {
+  const size_t numWorkers = numThreads_ > 1 ? numThreads_ - 1 : 0;
+  deques_.reserve(numWorkers + kNumCallerSlots);
+  for (size_t i = 0; i < numWorkers + kNumCallerSlots; ++i) {
+    deques_.emplace_back(AllocAligned<Deque>::alloc(), &deleteDeque);
+    CAFFE_ENFORCE(deques_.back(), "Failed to allocate work-stealing deque");
+  }
+  workers_.reserve(numWorkers);
+  for (size_t i = 0; i < numWorkers; ++i) {
+    workers_.emplace_back([this, i]() { this->workerLoop(i); });
+  }
+}
 
-ThreadPool::~ThreadPool() {}
+ThreadPool::~ThreadPool() {
+  exiting_.store(true);
+  notifyWorkers(true);
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
 
 int ThreadPool::getNumThreads() const {
-  std::lock_guard<std::mutex> guard(executionMutex_);
   return numThreads_;
 }
 
@@ -95,66 +182,187 @@ int ThreadPool::getNumThreads() const {
 // threadpool; work sizes smaller than this will just be run on the
 // main (calling) thread
 void ThreadPool::setMinWorkSize(size_t size) {
-  std::lock_guard<std::mutex> guard(executionMutex_);
-  minWorkSize_ = size;
+  minWorkSize_.store(size, std::memory_order_relaxed);
+}
+
+int ThreadPool::acquireCallerSlot() {
+  uint64_t free = freeCallerSlots_.load(std::memory_order_relaxed);
+  while (free) {
+    int slot = 0;
+    while (!(free & (uint64_t(1) << slot))) {
+      ++slot;
+    }
+    if (freeCallerSlots_.compare_exchange_weak(
+            free,
+            free & ~(uint64_t(1) << slot),
+            std::memory_order_acquire,
+            std::memory_order_relaxed)) {
+      return slot;
+    }
+  }
+  return -1;
+}
+
+void ThreadPool::releaseCallerSlot(int slot) {
+  freeCallerSlots_.fetch_or(uint64_t(1) << slot, std::memory_order_release);
+}
+
+void ThreadPool::notifyWorkers(bool all) {
+  workEpoch_.fetch_add(1);
+  if (sleepingWorkers_.load() > 0) {
+    // Taking the lock orders us after a worker that has registered as
+    // sleeping but not yet started waiting.
+    { std::lock_guard<std::mutex> g(parkMutex_); }
+    if (all) {
+      parkCond_.notify_all();
+    } else {
+      parkCond_.notify_one();
+    }
+  }
+}
+
+void ThreadPool::process(
+    Deque* own,
+    int threadId,
+    ThreadPoolJob* job,
+    size_t begin,
+    size_t end) {
+  while (end - begin > job->grain) {
+    const size_t mid = begin + (end - begin) / 2;
+    if (!own->push({job, mid, end})) {
+      break;
+    }
+    notifyWorkers(false);
+    end = mid;
+  }
+  try {
+    for (size_t i = begin; i < end; ++i) {
+      (*job->fn)(threadId, i);
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> g(job->mutex);
+    if (!job->exception) {
+      job->exception = std::current_exception();
+    }
+  }
+  job->finish(end - begin);
+}
+
+bool ThreadPool::steal(
+    size_t self,
+    size_t* cursor,
+    ThreadPoolJob** job,
+    size_t* begin,
+    size_t* end) {
+  const size_t n = deques_.size();
+  for (size_t k = 0; k < n; ++k) {
+    const size_t victim = (*cursor + k) % n;
+    if (victim == self) {
+      continue;
+    }
+    Deque* d = deques_[victim].get();
+    Deque::Range r;
+    // A failed steal may just mean another thief won the race for the
+    // top element; keep trying while there is something left.
+    while (!d->empty()) {
+      if (d->steal(&r)) {
+        // Start the next sweep where this one succeeded, which is where
+        // the rest of this range most likely still is.
+        *cursor = victim;
+        *job = r.job;
+        *begin = r.begin;
+        *end = r.end;
+        return true;
+      }
+    }
+  }
+  *cursor = (*cursor + 1) % n;
+  return false;
+}
+
+void ThreadPool::workerLoop(size_t workerIdx) {
+  setThreadName("CaffeThreadPool");
+  Deque* own = deques_[workerIdx].get();
+  const int threadId = workerIdx + 1;
+  size_t cursor = workerIdx;
+  while (true) {
+    const uint64_t epoch = workEpoch_.load(std::memory_order_acquire);
+    if (exiting_.load(std::memory_order_relaxed)) {
+      return;
+    }
+    Deque::Range r;
+    ThreadPoolJob* job;
+    size_t begin, end;
+    if (own->pop(&r)) {
+      process(own, threadId, r.job, r.begin, r.end);
+      continue;
+    }
+    if (steal(workerIdx, &cursor, &job, &begin, &end)) {
+      process(own, threadId, job, begin, end);
+      continue;
+    }
+    bool changed = false;
+    for (int spin = 0; spin < kStealSpins; ++spin) {
+      if (workEpoch_.load(std::memory_order_relaxed) != epoch) {
+        changed = true;
+        break;
+      }
+      Do256NOPs();
+    }
+    if (changed) {
+      continue;
+    }
+    std::unique_lock<std::mutex> g(parkMutex_);
+    sleepingWorkers_.fetch_add(1);
+    parkCond_.wait(g, [&]() {
+      return workEpoch_.load() != epoch || exiting_.load();
+    });
+    sleepingWorkers_.fetch_sub(1);
+  }
 }
 
 void ThreadPool::run(const std::function<void(int, size_t)>& fn, size_t range) {
-  std::lock_guard<std::mutex> guard(executionMutex_);
   // If there are no worker threads, or if the range is too small (too
   // little work), just run locally
-  const bool runLocally = range < minWorkSize_ ||
+  const bool runLocally = range < getMinWorkSize() ||
                           FLAGS_caffe2_threadpool_force_inline ||
-                          (numThreads_ == 0);
-  if (runLocally) {
+                          workers_.empty();
+  const int slot = runLocally ? -1 : acquireCallerSlot();
+  if (slot < 0) {
     // Work is small enough to just run locally; multithread overhead
-    // is too high
+    // is too high. We also get here when every caller slot is taken.
     for (size_t i = 0; i < range; ++i) {
       fn(0, i);
     }
     return;
   }
 
-  struct FnTask : public Task {
-    FnTask(){};
-    virtual ~FnTask(){};
-    const std::function<void(int, size_t)> *fn_;
-    int idx_;
-    size_t start_;
-    size_t end_;
-    virtual void Run() override {
-      for (auto i = start_; i < end_; ++i) {
-        (*fn_)(idx_, i);
-      }
-    }
-  };
-
-  CAFFE_ENFORCE_GE(numThreads_, 1);
-  const size_t unitsPerTask = (range + numThreads_ - 1) / numThreads_;
-  tasks_.resize(numThreads_);
-  for (size_t i = 0; i < numThreads_; ++i) {
-    if (!tasks_[i]) {
-      tasks_[i].reset(new FnTask());
-    }
-    auto *task = (FnTask *)tasks_[i].get();
-    task->fn_ = &fn;
-    task->idx_ = i;
-    task->start_ = std::min<size_t>(range, i * unitsPerTask);
-    task->end_ = std::min<size_t>(range, (i + 1) * unitsPerTask);
-    if (task->start_ >= task->end_) {
-      tasks_.resize(i);
-      break;
-    }
-    CAFFE_ENFORCE_LE(task->start_, range);
-    CAFFE_ENFORCE_LE(task->end_, range);
+  ThreadPoolJob job;
+  job.fn = &fn;
+  job.grain = std::max<size_t>(1, range / (numThreads_ * kSplitsPerThread));
+  job.remaining.store(range, std::memory_order_relaxed);
+
+  Deque* own = deques_[workers_.size() + slot].get();
+  CAFFE_ENFORCE(own->push({&job, 0, range}));
+  notifyWorkers(true);
+  // Only drain our own deque: the calling thread runs with threadId 0,
+  // so it must not pick up pieces of another caller's job.
+  Deque::Range r;
+  while (own->pop(&r)) {
+    process(own, 0, r.job, r.begin, r.end);
+  }
+  job.wait();
+  releaseCallerSlot(slot);
+  if (job.exception) {
+    std::rethrow_exception(job.exception);
   }
-  CAFFE_ENFORCE_LE(tasks_.size(), numThreads_);
-  CAFFE_ENFORCE_GE(tasks_.size(), 1);
-  workersPool_->Execute(tasks_);
 }
 
 void ThreadPool::withPool(const std::function<void(WorkersPool*)>& f) {
-  std::lock_guard<std::mutex> guard(executionMutex_);
+  std::lock_guard<std::mutex> guard(withPoolMutex_);
+  if (!workersPool_) {
+    workersPool_ = std::make_shared<WorkersPool>();
+  }
   f(workersPool_.get());
 }
 
@@ -3,19 +3,33 @@
 
 #include "ThreadPoolCommon.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
 #include <vector>
 
 //
 // A work-stealing threadpool loosely based off of pthreadpool
 //
+// Every worker thread owns a Chase-Lev deque. A call to run() claims one
+// of a fixed number of caller slots (each with its own deque), pushes the
+// whole range there and starts bisecting it; idle workers steal the
+// upper halves and keep bisecting what they stole. Several threads may
+// call run() at the same time, in which case the workers are shared
+// between the concurrent ranges instead of being serialized behind a
+// single mutex.
+//
 
 namespace caffe2 {
 
 struct Task;
 class WorkersPool;
+struct ThreadPoolJob;
+template <typename Job, size_t kCapacity>
+class WorkStealingDeque;
 
 constexpr size_t kCacheLineSize = 64;
 
@@ -37,7 +51,14 @@ class alignas(kCacheLineSize) ThreadPool {
   // threadpool; work sizes smaller than this will just be run on the
   // main (calling) thread
   void setMinWorkSize(size_t size);
-  size_t getMinWorkSize() const { return minWorkSize_; }
+  size_t getMinWorkSize() const {
+    return minWorkSize_.load(std::memory_order_relaxed);
+  }
+
+  // Runs fn(threadId, i) for every i in [0, range). threadId is in
+  // [0, getNumThreads()); the calling thread always runs with threadId 0
+  // and no two threads run the same threadId for one call. Safe to call
+  // concurrently from several threads.
   void run(const std::function<void(int, size_t)>& fn, size_t range);
 
   // Run an arbitrary function in a thread-safe manner accessing the Workers
@@ -45,11 +66,41 @@ class alignas(kCacheLineSize) ThreadPool {
   void withPool(const std::function<void(WorkersPool*)>& fn);
 
  private:
-  mutable std::mutex executionMutex_;
-  size_t minWorkSize_;
-  size_t numThreads_;
+  using Deque = WorkStealingDeque<ThreadPoolJob, 256>;
+
+  void workerLoop(size_t workerIdx);
+  // Pulls one range from any deque other than `self`.
+  bool steal(size_t self, size_t* cursor, ThreadPoolJob** job,
+             size_t* begin, size_t* end);
+  // Bisects [begin, end) onto `own` down to the job's grain size and runs
+  // what is left on the current thread.
+  void process(Deque* own, int threadId, ThreadPoolJob* job,
+               size_t begin, size_t end);
+  void notifyWorkers(bool all);
+
+  int acquireCallerSlot();
+  void releaseCallerSlot(int slot);
+
+  std::atomic<size_t> minWorkSize_;
+  const size_t numThreads_;
+
+  // Deques [0, numThreads_ - 1) belong to the workers, the rest to the
+  // caller slots.
+  std::vector<std::unique_ptr<Deque, void (*)(Deque*)>> deques_;
+  std::vector<std::thread> workers_;
+  std::atomic<uint64_t> freeCallerSlots_;
+
+  // Workers spin for a while when they run out of work and then park
+  // here until workEpoch_ changes.
+  std::atomic<uint64_t> workEpoch_;
+  std::atomic<int> sleepingWorkers_;
+  std::atomic<bool> exiting_;
+  std::mutex parkMutex_;
+  std::condition_variable parkCond_;
+
+  // Only used by withPool().
+  std::mutex withPoolMutex_;
   std::shared_ptr<WorkersPool> workersPool_;
-  std::vector<std::shared_ptr<Task>> tasks_;
 };
 
 } // namespace caffe2
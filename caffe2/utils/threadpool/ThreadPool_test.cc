@@ -0,0 +1,113 @@
+#include <atomic>
+#include <thread> // NOLINT
+#include <vector>
+
+#include "caffe2/utils/threadpool/ThreadPool.h"
+#include "caffe2/utils/threadpool/WorkStealingDeque.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+void expectVisitedOnce(ThreadPool* pool, size_t range) {
+  std::vector<std::atomic<int>> visits(range);
+  for (auto& v : visits) {
+    v = 0;
+  }
+  std::atomic<bool> badThreadId(false);
+  const int numThreads = pool->getNumThreads();
+  pool->run(
+      [&](int threadId, size_t i) {
+        if (threadId < 0 || threadId >= numThreads) {
+          badThreadId = true;
+        }
+        visits[i]++;
+      },
+      range);
+  EXPECT_FALSE(badThreadId);
+  for (size_t i = 0; i < range; ++i) {
+    EXPECT_EQ(visits[i], 1) << "index " << i;
+  }
+}
+
+} // namespace
+
+TEST(WorkStealingDequeTest, OwnerIsLifoThiefIsFifo) {
+  struct Job {};
+  WorkStealingDeque<Job, 4> deque;
+  WorkStealingDeque<Job, 4>::Range r;
+  EXPECT_FALSE(deque.pop(&r));
+  EXPECT_FALSE(deque.steal(&r));
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_TRUE(deque.push({nullptr, i, i + 1}));
+  }
+  // Full: the caller is expected to run the range itself.
+  EXPECT_FALSE(deque.push({nullptr, 4, 5}));
+  EXPECT_TRUE(deque.steal(&r));
+  EXPECT_EQ(r.begin, 0);
+  EXPECT_TRUE(deque.pop(&r));
+  EXPECT_EQ(r.begin, 3);
+  EXPECT_TRUE(deque.pop(&r));
+  EXPECT_EQ(r.begin, 2);
+  EXPECT_TRUE(deque.steal(&r));
+  EXPECT_EQ(r.begin, 1);
+  EXPECT_TRUE(deque.empty());
+}
+
+TEST(ThreadPoolTest, RunsEveryIndexOnce) {
+  ThreadPool pool(4);
+  pool.setMinWorkSize(0);
+  for (size_t range : {1, 3, 4, 17, 1000, 100000}) {
+    expectVisitedOnce(&pool, range);
+  }
+}
+
+TEST(ThreadPoolTest, SmallRangeRunsOnCallingThread) {
+  ThreadPool pool(4);
+  pool.setMinWorkSize(100);
+  const auto caller = std::this_thread::get_id();
+  std::atomic<bool> elsewhere(false);
+  pool.run(
+      [&](int threadId, size_t) {
+        if (threadId != 0 || std::this_thread::get_id() != caller) {
+          elsewhere = true;
+        }
+      },
+      99);
+  EXPECT_FALSE(elsewhere);
+}
+
+TEST(ThreadPoolTest, ConcurrentCallers) {
+  ThreadPool pool(4);
+  pool.setMinWorkSize(0);
+  std::vector<std::thread> callers;
+  for (int t = 0; t < 24; ++t) {
+    callers.emplace_back([&pool]() {
+      for (int iter = 0; iter < 20; ++iter) {
+        expectVisitedOnce(&pool, 5000);
+      }
+    });
+  }
+  for (auto& t : callers) {
+    t.join();
+  }
+}
+
+TEST(ThreadPoolTest, PropagatesExceptions) {
+  ThreadPool pool(4);
+  pool.setMinWorkSize(0);
+  EXPECT_THROW(
+      pool.run(
+          [](int, size_t i) {
+            if (i == 777) {
+              throw std::runtime_error("boom");
+            }
+          },
+          1000),
+      std::runtime_error);
+  // The pool is still usable afterwards.
+  expectVisitedOnce(&pool, 1000);
+}
+
+} // namespace caffe2
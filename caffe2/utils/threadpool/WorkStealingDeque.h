@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace caffe2 {
+
+// A fixed-capacity Chase-Lev work-stealing deque holding index ranges.
+//
+// The owning thread pushes and pops at the bottom; any other thread may
+// steal from the top. Memory orderings follow Le, Pop, Cohen and Zappa
+// Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models"
+// (PPoPP 2013). The buffer never grows: push() returns false when it is
+// full and the owner is expected to run the range itself instead. Since
+// the thread pool only pushes halves of a range it is currently
+// bisecting, the occupancy is bounded by the depth of the split, which
+// is logarithmic in the range.
+//
+// Elements are stored field-by-field in relaxed atomics so that a thief
+// reading a slot the owner is concurrently rewriting is not a data race;
+// such a read is simply discarded once the CAS on top_ fails.
+template <typename Job, size_t kCapacity = 256>
+class WorkStealingDeque {
+  static_assert(
+      (kCapacity & (kCapacity - 1)) == 0,
+      "WorkStealingDeque capacity must be a power of two");
+
+ public:
+  struct Range {
+    Job* job;
+    size_t begin;
+    size_t end;
+  };
+
+  WorkStealingDeque() : top_(0), bottom_(0) {}
+
+  // Owner only.
+  bool push(const Range& r) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed);
+    const int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t >= static_cast<int64_t>(kCapacity)) {
+      return false;
+    }
+    slot(b).store(r);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Owner only.
+  bool pop(Range* r) {
+    const int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    if (t > b) {
+      // Empty.
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+    *r = slot(b).load();
+    if (t == b) {
+      // Last element: race against thieves for it.
+      const bool won = top_.compare_exchange_strong(
+          t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return won;
+    }
+    return true;
+  }
+
+  // Any thread.
+  bool steal(Range* r) {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return false;
+    }
+    const Range candidate = slot(t).load();
+    if (!top_.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return false;
+    }
+    *r = candidate;
+    return true;
+  }
+
+  // Approximate; only meaningful as a hint.
+  bool empty() const {
+    return bottom_.load(std::memory_order_relaxed) <=
+        top_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Slot {
+    std::atomic<Job*> job;
+    std::atomic<size_t> begin;
+    std::atomic<size_t> end;
+
+    void store(const Range& r) {
+      job.store(r.job, std::memory_order_relaxed);
+      begin.store(r.begin, std::memory_order_relaxed);
+      end.store(r.end, std::memory_order_relaxed);
+    }
+    Range load() const {
+      return Range{job.load(std::memory_order_relaxed),
+                   begin.load(std::memory_order_relaxed),
+                   end.load(std::memory_order_relaxed)};
+    }
+  };
+
+  Slot& slot(int64_t i) {
+    return buffer_[static_cast<size_t>(i) & (kCapacity - 1)];
+  }
+
+  // top_ and bottom_ are written by different threads; keep them on
+  // separate cache lines.
+  alignas(64) std::atomic<int64_t> top_;
+  alignas(64) std::atomic<int64_t> bottom_;
+  alignas(64) Slot buffer_[kCapacity];
+};
+
+} // namespace caffe2
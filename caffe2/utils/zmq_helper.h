@@ -3,10 +3,47 @@
 
 #include <zmq.h>
 
+#include <cstdint>
+#include <cstring>
+
 #include "caffe2/core/logging.h"
 
 namespace caffe2 {
 
+// Records can be sent in batches of one single-part zmq message each. A batch
+// is a uint32 record count followed by, for each record, its uint32 key and
+// value sizes and then the key and value bytes, in host byte order. A key and
+// value sent as the two parts of a multipart message is a single record.
+class ZmqRecordBatchWriter {
+ public:
+  ZmqRecordBatchWriter() { Clear(); }
+
+  void Add(const string& key, const string& value) {
+    Append(static_cast<uint32_t>(key.size()));
+    Append(static_cast<uint32_t>(value.size()));
+    data_.append(key);
+    data_.append(value);
+    num_records_++;
+    std::memcpy(&data_[0], &num_records_, sizeof(num_records_));
+  }
+
+  uint32_t num_records() const { return num_records_; }
+  const string& data() const { return data_; }
+
+  void Clear() {
+    num_records_ = 0;
+    data_.assign(sizeof(num_records_), '\0');
+  }
+
+ private:
+  void Append(uint32_t value) {
+    data_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  uint32_t num_records_;
+  string data_;
+};
+
 class ZmqContext {
  public:
   explicit ZmqContext(int io_threads) : ptr_(zmq_ctx_new()) {
@@ -45,6 +82,8 @@ class ZmqMessage {
 
   void* data() { return zmq_msg_data(&msg_); }
   size_t size() { return zmq_msg_size(&msg_); }
+  // Whether more parts of the same multipart message follow this one.
+  bool more() { return zmq_msg_more(&msg_); }
 
  private:
   zmq_msg_t msg_;
@@ -63,6 +102,11 @@ class ZmqSocket {
     CAFFE_ENFORCE_EQ(rc, 0);
   }
 
+  void SetOption(int option, int value) {
+    int rc = zmq_setsockopt(ptr_, option, &value, sizeof(value));
+    CAFFE_ENFORCE_EQ(rc, 0, "Cannot set zmq socket option ", option);
+  }
+
   void Bind(const string& addr) {
     int rc = zmq_bind(ptr_, addr.c_str());
     CAFFE_ENFORCE_EQ(rc, 0);
@@ -1,12 +1,111 @@
 #include <caffe2/video/optical_flow.h>
 
+#include <map>
+#include <utility>
+
+#ifdef HAVE_OPENCV_CUDAOPTFLOW
+#include <opencv2/cudaoptflow.hpp>
+#endif
+
 namespace caffe2 {
 
+bool CUDAOpticalFlowAvailable() {
+#ifdef HAVE_OPENCV_CUDAOPTFLOW
+  return cv::cuda::getCudaEnabledDeviceCount() > 0;
+#else
+  return false;
+#endif
+}
+
+namespace {
+
+#ifdef HAVE_OPENCV_CUDAOPTFLOW
+struct CUDAOpticalFlow {
+  cv::Ptr<cv::cuda::DenseOpticalFlow> alg;
+  cv::cuda::GpuMat prev;
+  cv::cuda::GpuMat curr;
+  cv::cuda::GpuMat flow;
+};
+
+// The algorithms and the frames keep their buffers on the device between
+// calls, so each decode thread creates them once per GPU and algorithm type.
+CUDAOpticalFlow& GetCUDAOpticalFlow(
+    const int flow_alg_type,
+    const int cuda_gpu_id) {
+  static thread_local std::map<std::pair<int, int>, CUDAOpticalFlow> flows;
+  auto& flow = flows[std::make_pair(cuda_gpu_id, flow_alg_type)];
+  if (flow.alg) {
+    return flow;
+  }
+  switch (flow_alg_type) {
+    case FLowAlgType::FarnebackOpticalFlow:
+      // Same parameters as the CPU version
+      flow.alg = cv::cuda::FarnebackOpticalFlow::create(
+          5,
+          std::sqrt(2) / 2.0,
+          false,
+          10,
+          2,
+          7,
+          1.5,
+          cv::OPTFLOW_FARNEBACK_GAUSSIAN);
+      break;
+    case FLowAlgType::DensePyrLKOpticalFlow:
+      flow.alg = cv::cuda::DensePyrLKOpticalFlow::create();
+      break;
+    case FLowAlgType::BroxOpticalFlow:
+      flow.alg = cv::cuda::BroxOpticalFlow::create();
+      break;
+    case FLowAlgType::OpticalFlowDual_TVL1:
+      flow.alg = cv::cuda::OpticalFlowDual_TVL1::create();
+      break;
+    default:
+      CAFFE_THROW("Unsupported optical flow type ", flow_alg_type);
+  }
+  return flow;
+}
+#endif
+
+void CUDAOpticalFlowExtractor(
+    const cv::Mat& prev_gray,
+    const cv::Mat& curr_gray,
+    const int flow_alg_type,
+    cv::Mat& flow,
+    const int cuda_gpu_id) {
+#ifdef HAVE_OPENCV_CUDAOPTFLOW
+  cv::cuda::setDevice(cuda_gpu_id);
+  auto& cuda_flow = GetCUDAOpticalFlow(flow_alg_type, cuda_gpu_id);
+  if (flow_alg_type == FLowAlgType::BroxOpticalFlow) {
+    // Brox takes floating point images in [0, 1]
+    cv::Mat prev_float, curr_float;
+    prev_gray.convertTo(prev_float, CV_32F, 1.0 / 255);
+    curr_gray.convertTo(curr_float, CV_32F, 1.0 / 255);
+    cuda_flow.prev.upload(prev_float);
+    cuda_flow.curr.upload(curr_float);
+  } else {
+    cuda_flow.prev.upload(prev_gray);
+    cuda_flow.curr.upload(curr_gray);
+  }
+  cuda_flow.alg->calc(cuda_flow.prev, cuda_flow.curr, cuda_flow.flow);
+  cuda_flow.flow.download(flow);
+#else
+  CAFFE_THROW("OpenCV was built without its CUDA optical flow module");
+#endif
+}
+
+} // namespace
+
 void OpticalFlowExtractor(
     const cv::Mat& prev_gray,
     const cv::Mat& curr_gray,
     const int flow_alg_type,
-    cv::Mat& flow) {
+    cv::Mat& flow,
+    const int cuda_gpu_id) {
+  if (cuda_gpu_id >= 0) {
+    CUDAOpticalFlowExtractor(
+        prev_gray, curr_gray, flow_alg_type, flow, cuda_gpu_id);
+    return;
+  }
   cv::Ptr<cv::DualTVL1OpticalFlow> tvl1 = cv::DualTVL1OpticalFlow::create();
   switch (flow_alg_type) {
     case FLowAlgType::FarnebackOpticalFlow:
@@ -59,7 +158,8 @@ void MergeOpticalFlow(cv::Mat& prev_flow, const cv::Mat& curr_flow) {
 void MultiFrameOpticalFlowExtractor(
     const std::vector<cv::Mat>& grays,
     const int optical_flow_alg_type,
-    cv::Mat& flow) {
+    cv::Mat& flow,
+    const int cuda_gpu_id) {
   int num_frames = grays.size();
   CAFFE_ENFORCE_GE(num_frames, 2, "need at least 2 frames!");
 
@@ -67,7 +167,8 @@ void MultiFrameOpticalFlowExtractor(
   std::vector<cv::Mat> flows;
   for (int i = 0; i < num_frames - 1; i++) {
     cv::Mat tmp;
-    OpticalFlowExtractor(grays[i], grays[i + 1], optical_flow_alg_type, tmp);
+    OpticalFlowExtractor(
+        grays[i], grays[i + 1], optical_flow_alg_type, tmp, cuda_gpu_id);
     flows.push_back(tmp);
   }
 
@@ -32,18 +32,26 @@ enum FlowDataType {
   FlowWithRGB = 3,
 };
 
+// Whether OpenCV was built with its CUDA optical flow module, which
+// implements all four algorithms on the GPU.
+bool CUDAOpticalFlowAvailable();
+
+// Computes the flow on the GPU cuda_gpu_id if it's not negative, and on the
+// CPU otherwise.
 void OpticalFlowExtractor(
     const cv::Mat& prev_gray,
     const cv::Mat& curr_gray,
     const int optical_flow_alg_type,
-    cv::Mat& flow);
+    cv::Mat& flow,
+    const int cuda_gpu_id = -1);
 
 void MergeOpticalFlow(cv::Mat& prev_flow, const cv::Mat& curr_flow);
 
 void MultiFrameOpticalFlowExtractor(
     const std::vector<cv::Mat>& grays,
     const int optical_flow_alg_type,
-    cv::Mat& flow);
+    cv::Mat& flow,
+    const int cuda_gpu_id = -1);
 
 } // namespace caffe2
 
@@ -0,0 +1,70 @@
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/video/transform_gpu.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Each thread writes one output value, so that writes are coalesced; reads
+// of consecutive w are C bytes apart.
+__global__ void clip_transform_kernel(
+    const int size,
+    const int C,
+    const int L,
+    const int H,
+    const int W,
+    const uint8_t* X,
+    const int* mirror,
+    const float* mean,
+    const float* inv_std,
+    float* Y) {
+  CUDA_1D_KERNEL_LOOP(index, size) {
+    int w = index % W;
+    const int h = (index / W) % H;
+    const int l = (index / (W * H)) % L;
+    const int c = (index / (W * H * L)) % C;
+    const int n = index / (W * H * L * C);
+    if (mirror[n]) {
+      w = W - 1 - w;
+    }
+    const int x_index = (((n * L + l) * H + h) * W + w) * C + c;
+    Y[index] = (static_cast<float>(X[x_index]) - mean[c]) * inv_std[c];
+  }
+}
+
+} // namespace
+
+template <>
+void ClipTransformOnGPU<CUDAContext>(
+    const Tensor<CUDAContext>& X,
+    const Tensor<CUDAContext>& mirror,
+    const Tensor<CUDAContext>& mean,
+    const Tensor<CUDAContext>& inv_std,
+    Tensor<CUDAContext>* Y,
+    CUDAContext* context) {
+  CAFFE_ENFORCE_EQ(X.ndim(), 5);
+  const int N = X.dim32(0), L = X.dim32(1), H = X.dim32(2), W = X.dim32(3),
+            C = X.dim32(4);
+  CAFFE_ENFORCE_EQ(mirror.size(), N);
+  CAFFE_ENFORCE_EQ(mean.size(), C);
+  CAFFE_ENFORCE_EQ(inv_std.size(), C);
+  Y->Resize(std::vector<int>{N, C, L, H, W});
+  const int size = Y->size();
+  clip_transform_kernel<<<
+      CAFFE_GET_BLOCKS(size),
+      CAFFE_CUDA_NUM_THREADS,
+      0,
+      context->cuda_stream()>>>(
+      size,
+      C,
+      L,
+      H,
+      W,
+      X.data<uint8_t>(),
+      mirror.data<int>(),
+      mean.data<float>(),
+      inv_std.data<float>(),
+      Y->mutable_data<float>());
+}
+
+} // namespace caffe2
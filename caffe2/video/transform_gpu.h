@@ -0,0 +1,22 @@
+#ifndef CAFFE2_VIDEO_TRANSFORM_GPU_H_
+#define CAFFE2_VIDEO_TRANSFORM_GPU_H_
+
+#include "caffe2/core/context.h"
+
+namespace caffe2 {
+
+// Transforms the N clips of X, uint8 in N x L x H x W x C order as cropped by
+// ClipCropRGB, into the normalized clips of Y, in N x C x L x H x W order:
+// Y = (X - mean[c]) * inv_std[c], with clip n mirrored if mirror[n].
+template <class Context>
+void ClipTransformOnGPU(
+    const Tensor<Context>& X,
+    const Tensor<Context>& mirror,
+    const Tensor<Context>& mean,
+    const Tensor<Context>& inv_std,
+    Tensor<Context>* Y,
+    Context* context);
+
+} // namespace caffe2
+
+#endif // CAFFE2_VIDEO_TRANSFORM_GPU_H_
@@ -0,0 +1,253 @@
+#include <caffe2/video/video_decode_cache.h>
+#include <caffe2/core/common.h>
+#include <caffe2/core/logging.h>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace caffe2 {
+
+namespace {
+
+constexpr uint64_t kSidecarMagic = 0x5844494b46324343ULL; // "CC2FKIDX"
+
+bool statVideo(const std::string& videoFile, int64_t* size, int64_t* mtime) {
+  struct stat st;
+  if (stat(videoFile.c_str(), &st) != 0) {
+    return false;
+  }
+  *size = st.st_size;
+  *mtime = st.st_mtime;
+  return true;
+}
+
+template <typename T>
+bool readValues(FILE* f, T* values, size_t count) {
+  return fread(values, sizeof(T), count, f) == count;
+}
+
+template <typename T>
+bool writeValues(FILE* f, const T* values, size_t count) {
+  return fwrite(values, sizeof(T), count, f) == count;
+}
+
+} // namespace
+
+bool KeyframeIndex::build(AVFormatContext* inputContext, int streamIndex) {
+  framePts_.clear();
+  keyframePts_.clear();
+  AVPacket packet;
+  av_init_packet(&packet);
+  bool valid = true;
+  while (av_read_frame(inputContext, &packet) >= 0) {
+    if (packet.stream_index == streamIndex) {
+      const int64_t pts =
+          packet.pts != AV_NOPTS_VALUE ? packet.pts : packet.dts;
+      if (pts == AV_NOPTS_VALUE) {
+        valid = false;
+      } else {
+        framePts_.push_back(pts);
+        if (packet.flags & AV_PKT_FLAG_KEY) {
+          keyframePts_.push_back(pts);
+        }
+      }
+    }
+    av_free_packet(&packet);
+  }
+  // The packets are in decoding order.
+  std::sort(framePts_.begin(), framePts_.end());
+  std::sort(keyframePts_.begin(), keyframePts_.end());
+  return valid && !keyframePts_.empty();
+}
+
+std::string KeyframeIndex::sidecarPath(const std::string& videoFile) {
+  return videoFile + ".kfidx";
+}
+
+bool KeyframeIndex::load(const std::string& videoFile) {
+  int64_t videoSize, videoMtime;
+  if (!statVideo(videoFile, &videoSize, &videoMtime)) {
+    return false;
+  }
+  FILE* f = fopen(sidecarPath(videoFile).c_str(), "rb");
+  if (f == nullptr) {
+    return false;
+  }
+  uint64_t header[5];
+  bool loaded = readValues(f, header, 5) && header[0] == kSidecarMagic &&
+      int64_t(header[1]) == videoSize && int64_t(header[2]) == videoMtime;
+  if (loaded) {
+    framePts_.resize(header[3]);
+    keyframePts_.resize(header[4]);
+    loaded = readValues(f, framePts_.data(), framePts_.size()) &&
+        readValues(f, keyframePts_.data(), keyframePts_.size()) &&
+        !keyframePts_.empty();
+  }
+  fclose(f);
+  if (!loaded) {
+    framePts_.clear();
+    keyframePts_.clear();
+  }
+  return loaded;
+}
+
+bool KeyframeIndex::save(const std::string& videoFile) const {
+  int64_t videoSize, videoMtime;
+  if (!statVideo(videoFile, &videoSize, &videoMtime)) {
+    return false;
+  }
+  // Other decode threads or processes may read the same sidecar, so it is
+  // written to a temporary file first and renamed.
+  const std::string path = sidecarPath(videoFile);
+  const std::string tmpPath = path + ".tmp." + caffe2::to_string(getpid());
+  FILE* f = fopen(tmpPath.c_str(), "wb");
+  if (f == nullptr) {
+    VLOG(1) << "Cannot write keyframe index " << path;
+    return false;
+  }
+  const uint64_t header[5] = {kSidecarMagic,
+                              uint64_t(videoSize),
+                              uint64_t(videoMtime),
+                              framePts_.size(),
+                              keyframePts_.size()};
+  bool written = writeValues(f, header, 5) &&
+      writeValues(f, framePts_.data(), framePts_.size()) &&
+      writeValues(f, keyframePts_.data(), keyframePts_.size());
+  written = (fclose(f) == 0) && written;
+  if (!written || rename(tmpPath.c_str(), path.c_str()) != 0) {
+    unlink(tmpPath.c_str());
+    VLOG(1) << "Cannot write keyframe index " << path;
+    return false;
+  }
+  return true;
+}
+
+int64_t KeyframeIndex::keyframeBefore(int64_t pts) const {
+  auto it = std::upper_bound(keyframePts_.begin(), keyframePts_.end(), pts);
+  return it == keyframePts_.begin() ? keyframePts_.front() : *(it - 1);
+}
+
+int KeyframeIndex::frameIndex(int64_t pts) const {
+  auto it = std::lower_bound(framePts_.begin(), framePts_.end(), pts);
+  if (it == framePts_.end() || *it != pts) {
+    return -1;
+  }
+  return it - framePts_.begin();
+}
+
+VideoDecodeCache::VideoDecodeCache(size_t capacityBytes)
+    : capacity_(capacityBytes) {}
+
+std::shared_ptr<const KeyframeIndex> VideoDecodeCache::getIndex(
+    const std::string& video) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(indexKey(video));
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return it->second->index;
+}
+
+void VideoDecodeCache::putIndex(
+    const std::string& video,
+    std::shared_ptr<const KeyframeIndex> index) {
+  Entry entry;
+  entry.key = indexKey(video);
+  entry.bytes = index->bytes() + entry.key.size();
+  entry.index = std::move(index);
+  std::lock_guard<std::mutex> lock(mutex_);
+  insertLocked(std::move(entry));
+}
+
+bool VideoDecodeCache::getClip(
+    const std::string& key,
+    int start,
+    int count,
+    std::vector<std::unique_ptr<DecodedFrame>>& frames) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::list<Entry>::iterator> clip;
+  for (int i = start; i < start + count; ++i) {
+    auto it = entries_.find(frameKey(key, i));
+    if (it == entries_.end()) {
+      return false;
+    }
+    clip.push_back(it->second);
+  }
+  for (int i = 0; i < count; ++i) {
+    const Entry& entry = *clip[i];
+    unique_ptr<DecodedFrame> frame = make_unique<DecodedFrame>();
+    frame->data_.reset((uint8_t*)av_malloc(entry.data.size()));
+    memcpy(frame->data_.get(), entry.data.data(), entry.data.size());
+    frame->size_ = entry.data.size();
+    frame->width_ = entry.width;
+    frame->height_ = entry.height;
+    frame->timestamp_ = entry.timestamp;
+    frame->keyFrame_ = entry.keyFrame;
+    frame->index_ = start + i;
+    frame->outputFrameIndex_ = i;
+    frames.push_back(std::move(frame));
+    lru_.splice(lru_.begin(), lru_, clip[i]);
+  }
+  return true;
+}
+
+void VideoDecodeCache::putFrame(
+    const std::string& key,
+    const DecodedFrame& frame) {
+  Entry entry;
+  entry.key = frameKey(key, frame.index_);
+  entry.data.assign(frame.data_.get(), frame.data_.get() + frame.size_);
+  entry.width = frame.width_;
+  entry.height = frame.height_;
+  entry.timestamp = frame.timestamp_;
+  entry.keyFrame = frame.keyFrame_;
+  entry.bytes = entry.data.size() + entry.key.size();
+  std::lock_guard<std::mutex> lock(mutex_);
+  insertLocked(std::move(entry));
+}
+
+std::string VideoDecodeCache::memoryVideoKey(const char* buffer, int size) {
+  // 64 bit FNV-1a of the whole buffer, which is much cheaper than decoding
+  // it.
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (int i = 0; i < size; ++i) {
+    hash = (hash ^ static_cast<unsigned char>(buffer[i])) *
+        0x100000001b3ULL;
+  }
+  return "memory:" + caffe2::to_string(size) + ":" + caffe2::to_string(hash);
+}
+
+std::string VideoDecodeCache::indexKey(const std::string& video) {
+  return "index:" + video;
+}
+
+std::string VideoDecodeCache::frameKey(const std::string& key, int index) {
+  return key + "#" + caffe2::to_string(index);
+}
+
+void VideoDecodeCache::insertLocked(Entry&& entry) {
+  if (entry.bytes > capacity_) {
+    return;
+  }
+  auto it = entries_.find(entry.key);
+  if (it != entries_.end()) {
+    size_ -= it->second->bytes;
+    lru_.erase(it->second);
+    entries_.erase(it);
+  }
+  size_ += entry.bytes;
+  lru_.push_front(std::move(entry));
+  entries_[lru_.front().key] = lru_.begin();
+  while (size_ > capacity_) {
+    size_ -= lru_.back().bytes;
+    entries_.erase(lru_.back().key);
+    lru_.pop_back();
+  }
+}
+
+} // namespace caffe2
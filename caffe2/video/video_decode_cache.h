@@ -0,0 +1,113 @@
+#ifndef CAFFE2_VIDEO_VIDEO_DECODE_CACHE_H_
+#define CAFFE2_VIDEO_VIDEO_DECODE_CACHE_H_
+
+#include <caffe2/video/video_decoder.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+namespace caffe2 {
+
+// Timestamps of all the frames and key frames of a video stream, in the
+// time base of the stream. With the index, the decoder seeks straight to the
+// key frame before the first frame of a clip, instead of estimating the
+// timestamp of the clip from the duration of the video.
+class KeyframeIndex {
+ public:
+  KeyframeIndex() {}
+
+  // Builds the index from the packets of the stream, without decoding them.
+  // Reads the whole input, and returns false if the packets do not have
+  // timestamps.
+  bool build(AVFormatContext* inputContext, int streamIndex);
+
+  // Sidecar files are written next to the video files, and are only loaded
+  // if the size and the modification time of the video did not change.
+  static std::string sidecarPath(const std::string& videoFile);
+  bool load(const std::string& videoFile);
+  bool save(const std::string& videoFile) const;
+
+  int numFrames() const {
+    return framePts_.size();
+  }
+  int64_t framePts(int index) const {
+    return framePts_[index];
+  }
+  // Returns the timestamp of the last key frame at or before pts.
+  int64_t keyframeBefore(int64_t pts) const;
+  // Returns the index of the frame with this timestamp, or -1.
+  int frameIndex(int64_t pts) const;
+
+  size_t bytes() const {
+    return (framePts_.size() + keyframePts_.size()) * sizeof(int64_t);
+  }
+
+ private:
+  // Both sorted.
+  std::vector<int64_t> framePts_;
+  std::vector<int64_t> keyframePts_;
+};
+
+// LRU cache of decoded frames and of keyframe indices, shared by the decode
+// threads of a VideoInputOp. The frames are cached under a key of the video
+// and of the output format, so that the clips drawn from the same GOPs in
+// later epochs are not decoded again. The memory of all the entries is
+// bounded by the capacity of the cache.
+class VideoDecodeCache {
+ public:
+  explicit VideoDecodeCache(size_t capacityBytes);
+
+  std::shared_ptr<const KeyframeIndex> getIndex(const std::string& video);
+  void putIndex(
+      const std::string& video,
+      std::shared_ptr<const KeyframeIndex> index);
+
+  // Appends copies of the count frames from start if they are all cached,
+  // and returns false otherwise.
+  bool getClip(
+      const std::string& key,
+      int start,
+      int count,
+      std::vector<std::unique_ptr<DecodedFrame>>& frames);
+  // Caches a copy of the frame, under its index_.
+  void putFrame(const std::string& key, const DecodedFrame& frame);
+
+  // The key of the video in a memory buffer, from its content.
+  static std::string memoryVideoKey(const char* buffer, int size);
+
+ private:
+  struct Entry {
+    std::string key;
+    std::shared_ptr<const KeyframeIndex> index;
+    std::vector<uint8_t> data;
+    int width = 0;
+    int height = 0;
+    double timestamp = 0;
+    bool keyFrame = false;
+    size_t bytes = 0;
+  };
+
+  static std::string indexKey(const std::string& video);
+  static std::string frameKey(const std::string& key, int index);
+  // Inserts the entry as the most recently used one, and evicts the least
+  // recently used ones beyond the capacity. mutex_ must be held.
+  void insertLocked(Entry&& entry);
+
+  std::mutex mutex_;
+  size_t capacity_;
+  size_t size_ = 0;
+  std::list<Entry> lru_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> entries_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_VIDEO_VIDEO_DECODE_CACHE_H_
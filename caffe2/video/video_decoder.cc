@@ -1,7 +1,9 @@
 #include <caffe2/video/video_decoder.h>
 #include <caffe2/core/logging.h>
+#include <caffe2/video/video_decode_cache.h>
 
 #include <stdio.h>
+#include <algorithm>
 #include <mutex>
 #include <random>
 
@@ -45,8 +47,92 @@ void VideoDecoder::ResizeAndKeepAspectRatio(
   }
 }
 
+std::shared_ptr<const KeyframeIndex> VideoDecoder::getKeyframeIndex(
+    const string& videoKey,
+    const bool isFile,
+    const Params& params,
+    AVFormatContext* inputContext,
+    const int streamIndex) {
+  // Without a cache, the index of a video in memory would be built again on
+  // every decode.
+  if (!params.useKeyframeIndex_ || videoKey.empty() ||
+      (!isFile && params.decodeCache_ == nullptr)) {
+    return nullptr;
+  }
+  if (params.decodeCache_) {
+    auto index = params.decodeCache_->getIndex(videoKey);
+    if (index) {
+      return index;
+    }
+  }
+  auto index = std::make_shared<KeyframeIndex>();
+  if (!isFile || !index->load(videoKey)) {
+    const bool built = index->build(inputContext, streamIndex);
+    // Building reads the whole stream, so go back to its start.
+    av_seek_frame(inputContext, streamIndex, 0, AVSEEK_FLAG_BACKWARD);
+    if (!built) {
+      LOG(INFO) << "Cannot build a keyframe index of " << videoKey;
+      return nullptr;
+    }
+    if (isFile) {
+      index->save(videoKey);
+    }
+  }
+  if (params.decodeCache_) {
+    params.decodeCache_->putIndex(videoKey, index);
+  }
+  return index;
+}
+
+unique_ptr<DecodedFrame> VideoDecoder::convertFrame(
+    SwsContext* scaleContext,
+    AVFrame* frame,
+    const AVPixelFormat pixFormat,
+    const int outWidth,
+    const int outHeight,
+    const int height) {
+  AVFrame* rgbFrame = av_frame_alloc();
+  if (!rgbFrame) {
+    LOG(ERROR) << "Error allocating AVframe";
+    return nullptr;
+  }
+
+  unique_ptr<DecodedFrame> decodedFrame;
+  try {
+    // Determine required buffer size and allocate buffer
+    int numBytes = avpicture_get_size(pixFormat, outWidth, outHeight);
+    DecodedFrame::AvDataPtr buffer(
+        (uint8_t*)av_malloc(numBytes * sizeof(uint8_t)));
+
+    int size = avpicture_fill(
+        (AVPicture*)rgbFrame, buffer.get(), pixFormat, outWidth, outHeight);
+
+    sws_scale(
+        scaleContext,
+        frame->data,
+        frame->linesize,
+        0,
+        height,
+        rgbFrame->data,
+        rgbFrame->linesize);
+
+    decodedFrame = make_unique<DecodedFrame>();
+    decodedFrame->width_ = outWidth;
+    decodedFrame->height_ = outHeight;
+    decodedFrame->data_ = move(buffer);
+    decodedFrame->size_ = size;
+    decodedFrame->keyFrame_ = frame->key_frame;
+  } catch (const std::exception&) {
+    decodedFrame.reset();
+  }
+  av_frame_free(&rgbFrame);
+  return decodedFrame;
+}
+
 void VideoDecoder::decodeLoop(
     const string& videoName,
+    const string& videoKey,
+    const bool isFile,
     VideoIOContext& ioctx,
     const Params& params,
     const int start_frm,
@@ -243,7 +329,59 @@ void VideoDecoder::decodeLoop(
     std::mt19937 meta_randgen(time(nullptr));
     long int start_ts = -1;
     bool mustDecodeAll = false;
-    if (videoStream_->duration > 0 && videoStream_->nb_frames > 0) {
+
+    // With a keyframe index, the clip starts at an exact frame, after a seek
+    // to the key frame before it, and all the frames of the clip are looked
+    // up in the decode cache first.
+    std::shared_ptr<const KeyframeIndex> keyframeIndex;
+    if (params.decode_type_ == DecodeType::DO_TMP_JITTER ||
+        params.decode_type_ == DecodeType::USE_START_FRM) {
+      keyframeIndex = getKeyframeIndex(
+          videoKey, isFile, params, inputContext, videoStreamIndex_);
+    }
+    string cacheKey;
+    bool cacheFrames = false;
+    bool cacheHit = false;
+
+    if (keyframeIndex) {
+      const int numFrames = keyframeIndex->numFrames();
+      int startFrame;
+      if (params.decode_type_ == DecodeType::DO_TMP_JITTER) {
+        startFrame = std::uniform_int_distribution<>(
+            0,
+            std::max(numFrames - params.num_of_required_frame_, 0))(
+            meta_randgen);
+      } else {
+        startFrame = std::max(std::min(start_frm, numFrames - 1), 0);
+      }
+      start_ts = keyframeIndex->framePts(startFrame);
+
+      if (params.decodeCache_ && !params.keyFrames_ &&
+          params.intervals_.size() == 1 &&
+          params.intervals_[0].fps == SpecialFps::SAMPLE_ALL_FRAMES) {
+        cacheKey = videoKey + ":" + caffe2::to_string(outWidth) + "x" +
+            caffe2::to_string(outHeight) + ":" + caffe2::to_string(pixFormat);
+        cacheFrames = true;
+        cacheHit = params.decodeCache_->getClip(
+            cacheKey, startFrame, params.num_of_required_frame_, sampledFrames);
+      }
+
+      if (!cacheHit) {
+        ret = av_seek_frame(
+            inputContext,
+            videoStreamIndex_,
+            keyframeIndex->keyframeBefore(start_ts),
+            AVSEEK_FLAG_BACKWARD);
+        if (ret < 0) {
+          LOG(ERROR) << "Unable to seek to the key frame of the clip";
+          av_seek_frame(
+              inputContext, videoStreamIndex_, 0, AVSEEK_FLAG_BACKWARD);
+          mustDecodeAll = true;
+          keyframeIndex.reset();
+          cacheFrames = false;
+        }
+      }
+    } else if (videoStream_->duration > 0 && videoStream_->nb_frames > 0) {
       /* we have a valid duration and nb_frames. We can safely
        * detect an intermediate timestamp to start decoding from. */
 
@@ -310,7 +448,7 @@ void VideoDecoder::decodeLoop(
     // Therefore, after EOF, continue going while
     // the decoder is still giving us frames.
     int ipacket = 0;
-    while ((!eof || gotPicture) &&
+    while (!cacheHit && (!eof || gotPicture) &&
            /* either you must decode all frames or decode upto maxFrames
             * based on status of the mustDecodeAll flag */
            (mustDecodeAll ||
@@ -362,6 +500,26 @@ void VideoDecoder::decodeLoop(
           long int frame_ts =
               av_frame_get_best_effort_timestamp(videoStreamFrame_);
           double timestamp = frame_ts * av_q2d(videoStream_->time_base);
+          // The index of the frame in the whole video, when it is known.
+          const int videoFrameIndex =
+              keyframeIndex ? keyframeIndex->frameIndex(frame_ts) : -1;
+
+          // The frames from the key frame to the clip are decoded anyway, so
+          // they are cached too, for the other clips of the same GOP.
+          if (cacheFrames && frame_ts < start_ts && videoFrameIndex >= 0) {
+            unique_ptr<DecodedFrame> frame = convertFrame(
+                scaleContext_,
+                videoStreamFrame_,
+                pixFormat,
+                outWidth,
+                outHeight,
+                videoCodecContext_->height);
+            if (frame) {
+              frame->index_ = videoFrameIndex;
+              frame->timestamp_ = timestamp;
+              params.decodeCache_->putFrame(cacheKey, *frame);
+            }
+          }
 
           if ((frame_ts >= start_ts && !mustDecodeAll) || mustDecodeAll) {
             /* process current frame if:
@@ -432,48 +590,24 @@ void VideoDecoder::decodeLoop(
               break;
             }
 
-            AVFrame* rgbFrame = av_frame_alloc();
-            if (!rgbFrame) {
-              LOG(ERROR) << "Error allocating AVframe";
-            }
-
-            try {
-              // Determine required buffer size and allocate buffer
-              int numBytes = avpicture_get_size(pixFormat, outWidth, outHeight);
-              DecodedFrame::AvDataPtr buffer(
-                  (uint8_t*)av_malloc(numBytes * sizeof(uint8_t)));
-
-              int size = avpicture_fill(
-                  (AVPicture*)rgbFrame,
-                  buffer.get(),
-                  pixFormat,
-                  outWidth,
-                  outHeight);
-
-              sws_scale(
-                  scaleContext_,
-                  videoStreamFrame_->data,
-                  videoStreamFrame_->linesize,
-                  0,
-                  videoCodecContext_->height,
-                  rgbFrame->data,
-                  rgbFrame->linesize);
-
-              unique_ptr<DecodedFrame> frame = make_unique<DecodedFrame>();
-              frame->width_ = outWidth;
-              frame->height_ = outHeight;
-              frame->data_ = move(buffer);
-              frame->size_ = size;
-              frame->index_ = frameIndex;
+            unique_ptr<DecodedFrame> frame = convertFrame(
+                scaleContext_,
+                videoStreamFrame_,
+                pixFormat,
+                outWidth,
+                outHeight,
+                videoCodecContext_->height);
+            if (frame) {
+              frame->index_ =
+                  videoFrameIndex >= 0 ? videoFrameIndex : frameIndex;
               frame->outputFrameIndex_ = outputFrameIndex;
               frame->timestamp_ = timestamp;
-              frame->keyFrame_ = videoStreamFrame_->key_frame;
+              if (cacheFrames && videoFrameIndex >= 0) {
+                params.decodeCache_->putFrame(cacheKey, *frame);
+              }
 
               sampledFrames.push_back(move(frame));
               selectiveDecodedFrames++;
-              av_frame_free(&rgbFrame);
-            } catch (const std::exception&) {
-              av_frame_free(&rgbFrame);
             }
           }
           av_frame_unref(videoStreamFrame_);
@@ -513,7 +647,18 @@ void VideoDecoder::decodeMemory(
     const int start_frm,
     std::vector<std::unique_ptr<DecodedFrame>>& sampledFrames) {
   VideoIOContext ioctx(buffer, size);
-  decodeLoop(string("Memory Buffer"), ioctx, params, start_frm, sampledFrames);
+  // The cache is keyed by the content of the buffer.
+  const string videoKey = params.useKeyframeIndex_ && params.decodeCache_
+      ? VideoDecodeCache::memoryVideoKey(buffer, size)
+      : string();
+  decodeLoop(
+      string("Memory Buffer"),
+      videoKey,
+      false,
+      ioctx,
+      params,
+      start_frm,
+      sampledFrames);
 }
 
 void VideoDecoder::decodeFile(
@@ -522,7 +667,7 @@ void VideoDecoder::decodeFile(
     const int start_frm,
     std::vector<std::unique_ptr<DecodedFrame>>& sampledFrames) {
   VideoIOContext ioctx(file);
-  decodeLoop(file, ioctx, params, start_frm, sampledFrames);
+  decodeLoop(file, file, true, ioctx, params, start_frm, sampledFrames);
 }
 
 string VideoDecoder::ffmpegErrorStr(int result) {
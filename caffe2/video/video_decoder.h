@@ -10,10 +10,14 @@
 extern "C" {
 #include <libavformat/avformat.h>
 #include <libavformat/avio.h>
+#include <libswscale/swscale.h>
 }
 
 namespace caffe2 {
 
+class KeyframeIndex;
+class VideoDecodeCache;
+
 #define VIO_BUFFER_SZ 32768
 #define MAX_DECODING_FRAMES 10000
 
@@ -108,6 +112,16 @@ class Params {
   // fps must be either the 3 special fps defined in SpecialFps, or > 0
   std::vector<SampleInterval> intervals_ = {{0, SpecialFps::SAMPLE_ALL_FRAMES}};
 
+  // With DO_TMP_JITTER or USE_START_FRM, seek to the key frame before the
+  // clip with a keyframe index of the video. The index is built on the first
+  // decode, and kept in a sidecar file next to local files.
+  bool useKeyframeIndex_ = false;
+
+  // Cache of decoded frames and keyframe indices, shared by the decoders of
+  // the decode threads. Requires useKeyframeIndex_, and is only used when
+  // sampling all the frames of a clip.
+  VideoDecodeCache* decodeCache_ = nullptr;
+
   Params() {}
 
   /**
@@ -411,8 +425,29 @@ class VideoDecoder {
       int& outHeight,
       int& outWidth);
 
+  // Returns the keyframe index of the video, or nullptr if it cannot be
+  // used. videoKey identifies the video in the cache, and is the name of the
+  // video if isFile.
+  std::shared_ptr<const KeyframeIndex> getKeyframeIndex(
+      const std::string& videoKey,
+      const bool isFile,
+      const Params& params,
+      AVFormatContext* inputContext,
+      const int streamIndex);
+
+  // Converts a decoded frame to the output pixel format and size.
+  std::unique_ptr<DecodedFrame> convertFrame(
+      SwsContext* scaleContext,
+      AVFrame* frame,
+      const AVPixelFormat pixFormat,
+      const int outWidth,
+      const int outHeight,
+      const int height);
+
   void decodeLoop(
       const std::string& videoName,
+      const std::string& videoKey,
+      const bool isFile,
       VideoIOContext& ioctx,
       const Params& params,
       const int start_frm,
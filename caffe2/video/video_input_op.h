@@ -11,6 +11,8 @@
 #include <caffe2/operators/prefetch_op.h>
 #include <caffe2/utils/math.h>
 #include <caffe2/utils/thread_pool.h>
+#include <caffe2/video/transform_gpu.h>
+#include <caffe2/video/video_decode_cache.h>
 #include <caffe2/video/video_io.h>
 
 namespace caffe2 {
@@ -44,6 +46,8 @@ class VideoInputOp final : public PrefetchOperator<Context> {
   void DecodeAndTransform(
       const std::string& value,
       float* clip_rgb_data,
+      unsigned char* clip_rgb_cropped_data,
+      int* clip_mirror_data,
       float* clip_of_data,
       int* label_data,
       int* video_id_data,
@@ -60,6 +64,14 @@ class VideoInputOp final : public PrefetchOperator<Context> {
   Tensor<Context> prefetched_clip_of_on_device_;
   Tensor<Context> prefetched_label_on_device_;
   Tensor<Context> prefetched_video_id_on_device_;
+  // With gpu_transform, the decode threads only crop the rgb clips, into
+  // prefetched_clip_rgb_ as uint8, and the rest of the transform runs on the
+  // device, from prefetched_clip_rgb_on_device_ straight into the output.
+  TensorCPU prefetched_clip_mirror_;
+  Tensor<Context> prefetched_clip_mirror_on_device_;
+  Tensor<Context> mean_rgb_on_device_;
+  Tensor<Context> inv_std_rgb_on_device_;
+  bool mean_std_copied_ = false;
   int batch_size_;
   int clip_per_video_;
   std::vector<float> mean_rgb_;
@@ -103,6 +115,14 @@ class VideoInputOp final : public PrefetchOperator<Context> {
   bool get_optical_flow_;
   bool get_video_id_;
   bool do_multi_label_;
+  bool use_keyframe_index_;
+  bool gpu_transform_;
+  // GPU computing the optical flow, -1 to compute it on the CPU
+  int optical_flow_gpu_id_;
+
+  // cache of decoded frames shared by the decode threads, if
+  // decode_cache_size_mb is set
+  std::unique_ptr<VideoDecodeCache> decode_cache_;
 
   // thread pool for parse + decode
   int num_decode_threads_;
@@ -241,6 +261,31 @@ void VideoInputOp<Context>::CheckParamsAndPrint() {
   } else {
     LOG(ERROR) << "    Unknown video decoding type";
   }
+  if (use_keyframe_index_) {
+    LOG(INFO) << "    Seeking with keyframe indices";
+  }
+  if (gpu_transform_) {
+    CAFFE_ENFORCE(
+        !std::is_same<Context, CPUContext>::value,
+        "use_gpu_transform requires a CUDA device");
+    CAFFE_ENFORCE(get_rgb_, "use_gpu_transform requires get_rgb");
+    // TODO: support color jitter and color lighting in gpu_transform
+    CAFFE_ENFORCE(
+        !color_jitter_ && !color_lighting_,
+        "use_gpu_transform doesn't support color jittering and lighting");
+    LOG(INFO) << "    Transforming rgb clips on the GPU";
+  }
+  if (get_optical_flow_ && optical_flow_gpu_id_ >= 0) {
+    CAFFE_ENFORCE(
+        CUDAOpticalFlowAvailable(),
+        "use_gpu_optical_flow requires OpenCV with CUDA optical flow");
+    LOG(INFO) << "    Computing optical flow on GPU " << optical_flow_gpu_id_;
+  }
+  if (decode_cache_) {
+    CAFFE_ENFORCE(
+        use_keyframe_index_, "The decode cache requires use_keyframe_index");
+    LOG(INFO) << "    Caching decoded frames";
+  }
 }
 
 template <class Context>
@@ -343,10 +388,29 @@ VideoInputOp<Context>::VideoInputOp(
       do_multi_label_(OperatorBase::template GetSingleArgument<bool>(
           "do_multi_label",
           false)),
+      use_keyframe_index_(OperatorBase::template GetSingleArgument<bool>(
+          "use_keyframe_index",
+          false)),
+      gpu_transform_(OperatorBase::template GetSingleArgument<bool>(
+          "use_gpu_transform",
+          false)),
+      optical_flow_gpu_id_(
+          OperatorBase::template GetSingleArgument<bool>(
+              "use_gpu_optical_flow",
+              false)
+              ? operator_def.device_option().cuda_gpu_id()
+              : -1),
       num_decode_threads_(OperatorBase::template GetSingleArgument<int>(
           "num_decode_threads",
           4)),
       thread_pool_(std::make_shared<TaskThreadPool>(num_decode_threads_)) {
+  const int decode_cache_size_mb =
+      OperatorBase::template GetSingleArgument<int>("decode_cache_size_mb", 0);
+  if (decode_cache_size_mb > 0) {
+    decode_cache_.reset(
+        new VideoDecodeCache(size_t(decode_cache_size_mb) << 20));
+  }
+
   // hard-coded PCA eigenvectors and eigenvalues, based on RBG channel order
   color_lighting_eigvecs_.push_back(
       std::vector<float>{-144.7125, 183.396, 102.2295});
@@ -471,7 +535,14 @@ VideoInputOp<Context>::VideoInputOp(
   data_shape[2] = length_rgb_;
   data_shape[3] = crop_height_;
   data_shape[4] = crop_width_;
-  prefetched_clip_rgb_.Resize(data_shape);
+  if (gpu_transform_) {
+    // N x L x H x W x C, as cropped by ClipCropRGB
+    prefetched_clip_rgb_.Resize(
+        data_shape[0], length_rgb_, crop_height_, crop_width_, channels_rgb_);
+    prefetched_clip_mirror_.Resize(data_shape[0]);
+  } else {
+    prefetched_clip_rgb_.Resize(data_shape);
+  }
 
   // for optical flow data
   data_shape[1] = channels_of_;
@@ -573,6 +644,8 @@ bool VideoInputOp<Context>::GetClipsAndLabelsFromDBValue(
   params.scale_h_ = scale_h_;
   params.decode_type_ = decode_type_;
   params.num_of_required_frame_ = num_of_required_frame_;
+  params.useKeyframeIndex_ = use_keyframe_index_;
+  params.decodeCache_ = decode_cache_.get();
 
   char* video_buffer = nullptr; // for decoding from buffer
   std::string video_filename; // for decoding from file
@@ -616,6 +689,8 @@ template <class Context>
 void VideoInputOp<Context>::DecodeAndTransform(
     const std::string& value,
     float* clip_rgb_data,
+    unsigned char* clip_rgb_cropped_data,
+    int* clip_mirror_data,
     float* clip_of_data,
     int* label_data,
     int* video_id_data,
@@ -670,7 +745,25 @@ void VideoInputOp<Context>::DecodeAndTransform(
 
     // randomly mirror the image or not
     bool mirror_me = random_mirror_ && (*mirror_this_clip)(*randgen);
-    if (get_rgb_ && clip_rgb_data) {
+    if (get_rgb_ && clip_rgb_cropped_data) {
+      ClipCropRGB(
+          buffer_rgb[i],
+          multi_crop_count_,
+          crop_height_,
+          crop_width_,
+          length_rgb_,
+          channels_rgb_,
+          sampling_rate_rgb_,
+          height,
+          width,
+          h_off,
+          w_off,
+          multi_crop_h_off,
+          multi_crop_w_off,
+          mirror_me,
+          clip_rgb_cropped_data + (i * clip_offset_rgb),
+          clip_mirror_data + (i * multi_crop_count_));
+    } else if (get_rgb_ && clip_rgb_data) {
       ClipTransformRGB(
           buffer_rgb[i],
           multi_crop_count_,
@@ -731,6 +824,7 @@ void VideoInputOp<Context>::DecodeAndTransform(
             do_flow_aggregation_,
             mean_of_,
             inv_std_of_,
+            optical_flow_gpu_id_,
             clip_of_data + (i * clip_offset_of) + j * clip_crop_offset_of);
       }
     }
@@ -752,7 +846,13 @@ bool VideoInputOp<Context>::Prefetch() {
   reader_ = &OperatorBase::Input<db::DBReader>(0);
 
   // Call mutable_data() once to allocate the underlying memory.
-  prefetched_clip_rgb_.mutable_data<float>();
+  if (gpu_transform_) {
+    // we'll transfer up in uint8, then transform later
+    prefetched_clip_rgb_.mutable_data<unsigned char>();
+    prefetched_clip_mirror_.mutable_data<int>();
+  } else {
+    prefetched_clip_rgb_.mutable_data<float>();
+  }
   prefetched_clip_of_.mutable_data<float>();
   prefetched_label_.mutable_data<int>();
   prefetched_video_id_.mutable_data<int>();
@@ -770,9 +870,20 @@ bool VideoInputOp<Context>::Prefetch() {
 
     int frame_size = crop_height_ * crop_width_;
     // get the clip data pointer for the item_id -th example
-    float* clip_rgb_data = prefetched_clip_rgb_.mutable_data<float>() +
-        frame_size * length_rgb_ * channels_rgb_ * item_id * clip_per_video_ *
-            multi_crop_count_;
+    const int clip_rgb_offset = frame_size * length_rgb_ * channels_rgb_ *
+        item_id * clip_per_video_ * multi_crop_count_;
+    float* clip_rgb_data = nullptr;
+    unsigned char* clip_rgb_cropped_data = nullptr;
+    int* clip_mirror_data = nullptr;
+    if (gpu_transform_) {
+      clip_rgb_cropped_data =
+          prefetched_clip_rgb_.mutable_data<unsigned char>() + clip_rgb_offset;
+      clip_mirror_data = prefetched_clip_mirror_.mutable_data<int>() +
+          item_id * clip_per_video_ * multi_crop_count_;
+    } else {
+      clip_rgb_data =
+          prefetched_clip_rgb_.mutable_data<float>() + clip_rgb_offset;
+    }
 
     // get the optical flow data for the current clip
     float* clip_of_data = prefetched_clip_of_.mutable_data<float>() +
@@ -797,6 +908,8 @@ bool VideoInputOp<Context>::Prefetch() {
         this,
         std::string(value),
         clip_rgb_data,
+        clip_rgb_cropped_data,
+        clip_mirror_data,
         clip_of_data,
         label_data,
         video_id_data,
@@ -811,6 +924,10 @@ bool VideoInputOp<Context>::Prefetch() {
     if (get_rgb_) {
       prefetched_clip_rgb_on_device_.CopyFrom(prefetched_clip_rgb_, &context_);
     }
+    if (gpu_transform_) {
+      prefetched_clip_mirror_on_device_.CopyFrom(
+          prefetched_clip_mirror_, &context_);
+    }
     if (get_optical_flow_) {
       prefetched_clip_of_on_device_.CopyFrom(prefetched_clip_of_, &context_);
     }
@@ -826,29 +943,56 @@ template <class Context>
 bool VideoInputOp<Context>::CopyPrefetched() {
   int index = 0;
   if (get_rgb_) {
-    auto* clip_rgb_output = OperatorBase::Output<Tensor<Context>>(index++);
+    auto* clip_rgb_output =
+        this->template PrefetchedOutput<Tensor<Context>>(index++);
+    // Note: the if statements below should be optimized away by the
+    // compiler since std::is_same is a constexpr.
     if (std::is_same<Context, CPUContext>::value) {
       clip_rgb_output->CopyFrom(prefetched_clip_rgb_, &context_);
+    } else if (gpu_transform_) {
+      if (!mean_std_copied_) {
+        mean_rgb_on_device_.Resize(mean_rgb_.size());
+        inv_std_rgb_on_device_.Resize(inv_std_rgb_.size());
+        context_.template Copy<float, CPUContext, Context>(
+            mean_rgb_.size(),
+            mean_rgb_.data(),
+            mean_rgb_on_device_.template mutable_data<float>());
+        context_.template Copy<float, CPUContext, Context>(
+            inv_std_rgb_.size(),
+            inv_std_rgb_.data(),
+            inv_std_rgb_on_device_.template mutable_data<float>());
+        mean_std_copied_ = true;
+      }
+      ClipTransformOnGPU<Context>(
+          prefetched_clip_rgb_on_device_,
+          prefetched_clip_mirror_on_device_,
+          mean_rgb_on_device_,
+          inv_std_rgb_on_device_,
+          clip_rgb_output,
+          &context_);
     } else {
       clip_rgb_output->CopyFrom(prefetched_clip_rgb_on_device_, &context_);
     }
   }
   if (get_optical_flow_) {
-    auto* clip_of_output = OperatorBase::Output<Tensor<Context>>(index++);
+    auto* clip_of_output =
+        this->template PrefetchedOutput<Tensor<Context>>(index++);
     if (std::is_same<Context, CPUContext>::value) {
       clip_of_output->CopyFrom(prefetched_clip_of_, &context_);
     } else {
       clip_of_output->CopyFrom(prefetched_clip_of_on_device_, &context_);
     }
   }
-  auto* label_output = OperatorBase::Output<Tensor<Context>>(index++);
+  auto* label_output =
+      this->template PrefetchedOutput<Tensor<Context>>(index++);
   if (std::is_same<Context, CPUContext>::value) {
     label_output->CopyFrom(prefetched_label_, &context_);
   } else {
     label_output->CopyFrom(prefetched_label_on_device_, &context_);
   }
   if (get_video_id_) {
-    auto* video_id_output = OperatorBase::Output<Tensor<Context>>(index);
+    auto* video_id_output =
+        this->template PrefetchedOutput<Tensor<Context>>(index);
     if (std::is_same<Context, CPUContext>::value) {
       video_id_output->CopyFrom(prefetched_video_id_, &context_);
     } else {
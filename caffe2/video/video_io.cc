@@ -328,6 +328,47 @@ void ClipTransformRGB(
   }
 }
 
+void ClipCropRGB(
+    const unsigned char* buffer_rgb,
+    const int multi_crop_count,
+    const int crop_height,
+    const int crop_width,
+    const int length_rgb,
+    const int channels_rgb,
+    const int sampling_rate_rgb,
+    const int height,
+    const int width,
+    const int h_off,
+    const int w_off,
+    const int* multi_crop_h_off,
+    const int* multi_crop_w_off,
+    const bool mirror_me,
+    unsigned char* cropped_clip,
+    int* mirror) {
+  const int row_size = crop_width * channels_rgb;
+  // Multi cropping takes the crops of multi_crop_h/w_off, and then the same
+  // ones mirrored, as in ClipTransformRGB
+  const int num_crops = multi_crop_count == 1 ? 1 : multi_crop_count / 2;
+  for (int j = 0; j < multi_crop_count; ++j) {
+    const int k = j % num_crops;
+    const int crop_h_off = multi_crop_count == 1 ? h_off : multi_crop_h_off[k];
+    const int crop_w_off = multi_crop_count == 1 ? w_off : multi_crop_w_off[k];
+    mirror[j] = multi_crop_count == 1 ? mirror_me : j / num_crops;
+
+    for (int l = 0; l < length_rgb; ++l) {
+      const unsigned char* frame =
+          buffer_rgb + l * sampling_rate_rgb * height * width * channels_rgb;
+      for (int h = 0; h < crop_height; ++h) {
+        memcpy(
+            cropped_clip,
+            frame + ((h + crop_h_off) * width + crop_w_off) * channels_rgb,
+            row_size);
+        cropped_clip += row_size;
+      }
+    }
+  }
+}
+
 void ClipTransformOpticalFlow(
     const unsigned char* buffer_rgb,
     const int crop_height,
@@ -346,6 +387,7 @@ void ClipTransformOpticalFlow(
     const bool do_flow_aggregation,
     const std::vector<float>& mean_of,
     const std::vector<float>& inv_std_of,
+    const int cuda_gpu_id,
     float* transformed_clip) {
   const int frame_size = crop_height * crop_width;
   const int channel_size_flow = length_of * frame_size;
@@ -385,7 +427,7 @@ void ClipTransformOpticalFlow(
 
     cv::Mat first_gray, first_rgb;
     cv::Mat flow = cv::Mat::zeros(crop_height, crop_width, CV_32FC2);
-    MultiFrameOpticalFlowExtractor(grays, flow_alg_type, flow);
+    MultiFrameOpticalFlowExtractor(grays, flow_alg_type, flow, cuda_gpu_id);
 
     std::vector<cv::Mat> imgs;
     cv::split(flow, imgs);
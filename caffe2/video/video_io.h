@@ -41,6 +41,29 @@ void ClipTransformRGB(
     std::mt19937* randgen,
     float* transformed_clip);
 
+// Crops the frames of a clip as ClipTransformRGB does, but leaves the rest of
+// the transform to ClipTransformOnGPU: writes the multi_crop_count crops of
+// length_rgb x crop_height x crop_width x channels_rgb pixels one after the
+// other, and whether each is to be mirrored.
+void ClipCropRGB(
+    const unsigned char* buffer_rgb,
+    const int multi_crop_count,
+    const int crop_height,
+    const int crop_width,
+    const int length_rgb,
+    const int channels_rgb,
+    const int sampling_rate_rgb,
+    const int height,
+    const int width,
+    const int h_off,
+    const int w_off,
+    const int* multi_crop_h_off,
+    const int* multi_crop_w_off,
+    const bool mirror_me,
+    unsigned char* cropped_clip,
+    int* mirror);
+
+// The optical flow is computed on the GPU cuda_gpu_id if it's not negative.
 void ClipTransformOpticalFlow(
     const unsigned char* buffer_rgb,
     const int crop_height,
@@ -59,6 +82,7 @@ void ClipTransformOpticalFlow(
     const bool do_flow_aggregation,
     const std::vector<float>& mean_of,
     const std::vector<float>& inv_std_of,
+    const int cuda_gpu_id,
     float* transformed_clip);
 
 void FreeDecodedData(std::vector<std::unique_ptr<DecodedFrame>>& sampledFrames);
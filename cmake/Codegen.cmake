@@ -42,7 +42,7 @@ if (BUILD_ATEN)
     IF(MSVC)
       SET_SOURCE_FILES_PROPERTIES(${CMAKE_CURRENT_LIST_DIR}/../aten/src/TH/vector/AVX2.cpp PROPERTIES COMPILE_FLAGS "${MSVC_OPT_FLAG}/arch:AVX2 ${CXX_AVX2_FLAGS}")
     ELSE(MSVC)
-      SET_SOURCE_FILES_PROPERTIES(${CMAKE_CURRENT_LIST_DIR}/../aten/src/TH/vector/AVX2.cpp PROPERTIES COMPILE_FLAGS "-O3 ${CXX_AVX2_FLAGS}")
+      SET_SOURCE_FILES_PROPERTIES(${CMAKE_CURRENT_LIST_DIR}/../aten/src/TH/vector/AVX2.cpp PROPERTIES COMPILE_FLAGS "-O3 ${CXX_AVX2_FLAGS} -mf16c")
     ENDIF(MSVC)
   ENDIF(C_AVX2_FOUND)
 
@@ -83,10 +83,20 @@ if (BUILD_ATEN)
     IF(MSVC)
       LIST(APPEND CPU_CAPABILITY_FLAGS "${MSVC_OPT_FLAG}/arch:AVX2")
     ELSE(MSVC)
-      LIST(APPEND CPU_CAPABILITY_FLAGS "-O3 -mavx2 -mfma")
+      LIST(APPEND CPU_CAPABILITY_FLAGS "-O3 -mavx2 -mfma -mf16c")
     ENDIF(MSVC)
   ENDIF(CXX_AVX2_FOUND)
 
+  IF(CXX_AVX512_FOUND)
+    SET(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DHAVE_AVX512_CPU_DEFINITION")
+    LIST(APPEND CPU_CAPABILITY_NAMES "AVX512")
+    IF(MSVC)
+      LIST(APPEND CPU_CAPABILITY_FLAGS "${MSVC_OPT_FLAG}/arch:AVX512")
+    ELSE(MSVC)
+      LIST(APPEND CPU_CAPABILITY_FLAGS "-O3 -mavx512f -mavx2 -mfma -mf16c")
+    ENDIF(MSVC)
+  ENDIF(CXX_AVX512_FOUND)
+
   list(LENGTH CPU_CAPABILITY_NAMES NUM_CPU_CAPABILITY_NAMES)
   math(EXPR NUM_CPU_CAPABILITY_NAMES "${NUM_CPU_CAPABILITY_NAMES}-1")
 
@@ -468,6 +468,7 @@ if(USE_CUDA)
   set(CAFFE2_USE_CUDNN ${USE_CUDNN})
   set(CAFFE2_USE_NVRTC ${USE_NVRTC})
   set(CAFFE2_USE_TENSORRT ${USE_TENSORRT})
+  set(CAFFE2_USE_NVJPEG ${USE_NVJPEG})
   include(${CMAKE_CURRENT_LIST_DIR}/public/cuda.cmake)
   if(CAFFE2_USE_CUDA)
     # A helper variable recording the list of Caffe2 dependent libraries
@@ -498,6 +499,11 @@ if(USE_CUDA)
     else()
       caffe2_update_option(USE_TENSORRT OFF)
     endif()
+    if(CAFFE2_USE_NVJPEG)
+      list(APPEND Caffe2_PUBLIC_CUDA_DEPENDENCY_LIBS caffe2::nvjpeg)
+    else()
+      caffe2_update_option(USE_NVJPEG OFF)
+    endif()
   else()
     message(WARNING
       "Not compiling with CUDA. Suppress this warning with "
@@ -506,10 +512,12 @@ if(USE_CUDA)
     caffe2_update_option(USE_CUDNN OFF)
     caffe2_update_option(USE_NVRTC OFF)
     caffe2_update_option(USE_TENSORRT OFF)
+    caffe2_update_option(USE_NVJPEG OFF)
     set(CAFFE2_USE_CUDA OFF)
     set(CAFFE2_USE_CUDNN OFF)
     set(CAFFE2_USE_NVRTC OFF)
     set(CAFFE2_USE_TENSORRT OFF)
+    set(CAFFE2_USE_NVJPEG OFF)
   endif()
 endif()
 
@@ -1218,6 +1226,15 @@ if (BUILD_ATEN)
     set(AT_CUDNN_ENABLED 1)
   ENDIF()
 
+  # ---[ Backend of at::parallel_for and at::parallel_reduce
+  if (NOT ATEN_THREADING OR ATEN_THREADING STREQUAL "OMP")
+    set(AT_PARALLEL_NATIVE 0)
+  elseif (ATEN_THREADING STREQUAL "NATIVE")
+    set(AT_PARALLEL_NATIVE 1)
+  else()
+    message(FATAL_ERROR "Unknown ATEN_THREADING ${ATEN_THREADING}, expected OMP or NATIVE")
+  endif()
+
   if (NO_MKLDNN)
     message("disabling MKLDNN because NO_MKLDNN is set")
     set(AT_MKLDNN_ENABLED 0)
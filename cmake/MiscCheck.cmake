@@ -149,6 +149,28 @@ if (CAFFE2_COMPILER_SUPPORTS_AVX2_EXTENSIONS)
 endif()
 cmake_pop_check_state()
 
+# ---[ Check if the compiler targets ARM with NEON, which the perfkernels then
+# use when the cpu reports it at runtime. 32-bit ARM needs -mfpu for the fp16
+# conversions, while AArch64 always has them.
+cmake_push_check_state(RESET)
+if (CMAKE_SYSTEM_PROCESSOR MATCHES "^(arm|ARM)")
+  set(CAFFE2_PERF_NEON_FLAGS "-mfpu=neon-fp16 -mfp16-format=ieee")
+endif()
+set(CMAKE_REQUIRED_FLAGS "${CAFFE2_PERF_NEON_FLAGS}")
+CHECK_CXX_SOURCE_COMPILES(
+    "#include <arm_neon.h>
+     int main() {
+       float32x4_t a = vdupq_n_f32(1.f);
+       uint16_t h[4] = {0, 0, 0, 0};
+       a = vaddq_f32(a, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(h))));
+       return (int)vgetq_lane_f32(a, 0);
+     }" CAFFE2_COMPILER_SUPPORTS_NEON_EXTENSIONS)
+if (CAFFE2_COMPILER_SUPPORTS_NEON_EXTENSIONS)
+  message(STATUS "Current compiler supports neon extention. Will build perfkernels.")
+  set(CAFFE2_PERF_WITH_NEON 1)
+endif()
+cmake_pop_check_state()
+
 # ---[ Checks if compiler supports -fvisibility=hidden
 check_cxx_compiler_flag("-fvisibility=hidden" COMPILER_SUPPORTS_HIDDEN_VISIBILITY)
 check_cxx_compiler_flag("-fvisibility-inlines-hidden" COMPILER_SUPPORTS_HIDDEN_INLINE_VISIBILITY)
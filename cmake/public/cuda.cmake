@@ -117,6 +117,23 @@ if(CAFFE2_USE_TENSORRT)
   endif()
 endif()
 
+# Optionally, find nvJPEG, which comes with the CUDA toolkit since CUDA 10
+if(CAFFE2_USE_NVJPEG)
+  find_path(NVJPEG_INCLUDE_DIR nvjpeg.h
+    HINTS ${NVJPEG_ROOT} ${CUDA_TOOLKIT_ROOT_DIR}
+    PATH_SUFFIXES include)
+  find_library(NVJPEG_LIBRARY nvjpeg
+    HINTS ${NVJPEG_ROOT} ${CUDA_TOOLKIT_ROOT_DIR}
+    PATH_SUFFIXES lib lib64 lib/x64)
+  find_package_handle_standard_args(
+    NVJPEG DEFAULT_MSG NVJPEG_INCLUDE_DIR NVJPEG_LIBRARY)
+  if(NOT NVJPEG_FOUND)
+    message(WARNING
+      "Caffe2: Cannot find nvJPEG library. Turning the option off")
+    set(CAFFE2_USE_NVJPEG OFF)
+  endif()
+endif()
+
 # ---[ Extract versions
 if(CAFFE2_USE_CUDNN)
   # Get cuDNN version
@@ -242,6 +259,17 @@ if(CAFFE2_USE_TENSORRT)
       ${TENSORRT_INCLUDE_DIR})
 endif()
 
+# nvJPEG
+if(CAFFE2_USE_NVJPEG)
+  add_library(caffe2::nvjpeg UNKNOWN IMPORTED)
+  set_property(
+      TARGET caffe2::nvjpeg PROPERTY IMPORTED_LOCATION
+      ${NVJPEG_LIBRARY})
+  set_property(
+      TARGET caffe2::nvjpeg PROPERTY INTERFACE_INCLUDE_DIRECTORIES
+      ${NVJPEG_INCLUDE_DIR})
+endif()
+
 # cublas. CUDA_CUBLAS_LIBRARIES is actually a list, so we will make an
 # interface library similar to cudart.
 add_library(caffe2::cublas INTERFACE IMPORTED)
@@ -759,11 +759,13 @@ main_sources = [
     "torch/csrc/finalizer.cpp",
     "torch/csrc/jit/init.cpp",
     "torch/csrc/jit/interpreter.cpp",
+    "torch/csrc/jit/parallel_interpreter.cpp",
     "torch/csrc/jit/register_prim_ops.cpp",
     "torch/csrc/jit/python_interpreter.cpp",
     "torch/csrc/jit/ir.cpp",
     "torch/csrc/jit/fusion_compiler.cpp",
     "torch/csrc/jit/graph_executor.cpp",
+    "torch/csrc/jit/graph_profiler.cpp",
     "torch/csrc/jit/python_ir.cpp",
     "torch/csrc/jit/test_jit.cpp",
     "torch/csrc/jit/tracer.cpp",
@@ -793,6 +795,10 @@ main_sources = [
     "torch/csrc/jit/passes/specialize_undef.cpp",
     "torch/csrc/jit/passes/erase_number_types.cpp",
     "torch/csrc/jit/passes/loop_unrolling.cpp",
+    "torch/csrc/jit/passes/constant_propagation.cpp",
+    "torch/csrc/jit/passes/loop_invariant_code_motion.cpp",
+    "torch/csrc/jit/passes/inplace_ops.cpp",
+    "torch/csrc/jit/passes/memory_planning.cpp",
     "torch/csrc/jit/passes/to_batch.cpp",
     "torch/csrc/jit/passes/onnx/peephole.cpp",
     "torch/csrc/jit/passes/onnx/fixup_onnx_loop.cpp",
@@ -811,6 +817,7 @@ main_sources = [
     "torch/csrc/autograd/python_anomaly_mode.cpp",
     "torch/csrc/autograd/engine.cpp",
     "torch/csrc/autograd/function.cpp",
+    "torch/csrc/autograd/small_object_pool.cpp",
     "torch/csrc/autograd/variable.cpp",
     "torch/csrc/autograd/saved_variable.cpp",
     "torch/csrc/autograd/input_buffer.cpp",
@@ -831,6 +838,7 @@ main_sources = [
     "torch/csrc/autograd/functions/basic_ops.cpp",
     "torch/csrc/autograd/functions/tensor.cpp",
     "torch/csrc/autograd/functions/accumulate_grad.cpp",
+    "torch/csrc/autograd/functions/checkpoint.cpp",
     "torch/csrc/autograd/functions/utils.cpp",
     "torch/csrc/autograd/functions/init.cpp",
     "torch/csrc/nn/THNN.cpp",
@@ -864,7 +872,10 @@ if USE_DISTRIBUTED:
 
 if USE_C10D:
     extra_compile_args += ['-DUSE_C10D']
-    main_sources += ['torch/csrc/distributed/c10d/init.cpp']
+    main_sources += [
+        'torch/csrc/distributed/c10d/init.cpp',
+        'torch/csrc/distributed/c10d/reducer.cpp',
+    ]
     main_link_args += [C10D_LIB]
 
 if USE_CUDA:
@@ -0,0 +1,41 @@
+"""Measures the round-trip overhead of calling torch.add from Python.
+
+The tensors are tiny, so the time per call is dominated by parsing the
+arguments and dispatching to ATen rather than by the addition itself.
+
+    python test/benchmarks/add_overhead.py --iters 100000
+"""
+import argparse
+import timeit
+
+import torch
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--iters', type=int, default=100000,
+                        help='calls per measurement')
+    parser.add_argument('--repeat', type=int, default=5,
+                        help='measurements per case, the best one is reported')
+    args = parser.parse_args()
+
+    x = torch.randn(1)
+    y = torch.randn(1)
+    s = torch.tensor(2.)
+    cases = [
+        ('torch.add(x, y)', lambda: torch.add(x, y)),
+        ('torch.add(x, 2)', lambda: torch.add(x, 2)),
+        ('torch.add(x, s)', lambda: torch.add(x, s)),
+        ('torch.add(x, 2, y)', lambda: torch.add(x, 2, y)),
+        ('x.add(y)', lambda: x.add(y)),
+        ('x + y', lambda: x + y),
+        ('x.add(y, alpha=2)', lambda: x.add(y, alpha=2)),
+    ]
+    for name, fn in cases:
+        fn()
+        best = min(timeit.repeat(fn, number=args.iters, repeat=args.repeat))
+        print('{:<20} {:8.3f} us'.format(name, best / args.iters * 1e6))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,69 @@
+"""Compares the CPU convolution paths over batch sizes and thread counts.
+
+thnn_conv2d is the im2col + GEMM of THNN, which spreads the frames over the
+threads when the batch has enough of them and runs a single GEMM over the whole
+batch otherwise. F.conv2d goes through MKL-DNN when PyTorch was built with it,
+and to the same THNN code when it wasn't.
+
+    python test/benchmarks/conv2d_cpu.py --threads 1 4 16 --batch-sizes 1 8 64
+"""
+import argparse
+import timeit
+
+import torch
+import torch.nn.functional as F
+
+# (channels in, channels out, input size, kernel size, stride, padding),
+# typical of the early, middle and late layers of a ResNet
+SHAPES = [
+    (64, 64, 56, 3, 1, 1),
+    (128, 128, 28, 3, 1, 1),
+    (256, 256, 14, 3, 1, 1),
+    (512, 512, 7, 3, 1, 1),
+    (256, 1024, 14, 1, 1, 0),
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--threads', type=int, nargs='+',
+                        default=[1, torch.get_num_threads()])
+    parser.add_argument('--batch-sizes', type=int, nargs='+', default=[1, 4, 32])
+    parser.add_argument('--iters', type=int, default=10,
+                        help='calls per measurement')
+    parser.add_argument('--backward', action='store_true',
+                        help='time the forward and backward together')
+    args = parser.parse_args()
+
+    def thnn(x, w, b, k, s, p):
+        return torch._C._nn.thnn_conv2d(x, w, (k, k), b, (s, s), (p, p))
+
+    def default(x, w, b, k, s, p):
+        return F.conv2d(x, w, b, s, p)
+
+    paths = [('thnn', thnn), ('conv2d', default)]
+    print('{:>7} {:>5} {:>26} {}'.format(
+        'threads', 'batch', 'shape', ' '.join('{:>10}'.format(name) for name, _ in paths)))
+    for threads in args.threads:
+        torch.set_num_threads(threads)
+        for batch in args.batch_sizes:
+            for cin, cout, size, k, s, p in SHAPES:
+                x = torch.randn(batch, cin, size, size, requires_grad=args.backward)
+                w = torch.randn(cout, cin, k, k, requires_grad=args.backward)
+                b = torch.randn(cout, requires_grad=args.backward)
+                times = []
+                for _, conv in paths:
+                    def run():
+                        out = conv(x, w, b, k, s, p)
+                        if args.backward:
+                            out.sum().backward()
+                    run()
+                    best = min(timeit.repeat(run, number=args.iters, repeat=3))
+                    times.append(best / args.iters * 1e3)
+                shape = '{}x{}x{}x{} k{}'.format(cin, cout, size, size, k)
+                print('{:>7} {:>5} {:>26} {}'.format(
+                    threads, batch, shape, ' '.join('{:8.2f}ms'.format(t) for t in times)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,51 @@
+"""Measures the time per op of a graph executor running tiny tensors.
+
+The graph is a long chain of elementwise ops on a one element tensor, so the
+time is spent dispatching rather than computing. Ops dispatch through
+VariableType, unless the executor runs unwrapped Variables
+(unwrap_variables in torch._C._jit_set_executor_options), in which case they
+go straight to the backend Type.
+
+    python test/benchmarks/jit_op_overhead.py --ops 1000
+"""
+import argparse
+import timeit
+
+import torch
+
+
+def chain(num_ops):
+    def fn(x):
+        for i in range(num_ops // 2):
+            x = torch.sigmoid(x) * x
+        return x
+    return fn
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--ops', type=int, default=1000,
+                        help='ops in the graph')
+    parser.add_argument('--iters', type=int, default=100,
+                        help='runs per measurement')
+    parser.add_argument('--repeat', type=int, default=5,
+                        help='measurements per case, the best one is reported')
+    args = parser.parse_args()
+
+    fn = chain(args.ops)
+    x = torch.randn(1)
+    for unwrap_variables in (False, True):
+        # memory planning would hide the allocation of the intermediates
+        torch._C._jit_set_executor_options(plan_memory=False,
+                                           unwrap_variables=unwrap_variables)
+        ge = torch._C.GraphExecutor(fn, (x,))
+        with torch.no_grad():
+            ge(x)
+            best = min(timeit.repeat(lambda: ge(x), number=args.iters, repeat=args.repeat))
+        print('unwrap_variables={:<5} {:8.3f} us/op'.format(
+            str(unwrap_variables), best / args.iters / args.ops * 1e6))
+    torch._C._jit_set_executor_options()
+
+
+if __name__ == '__main__':
+    main()
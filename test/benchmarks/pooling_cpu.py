@@ -0,0 +1,68 @@
+"""Times the CPU pooling and upsampling kernels over layouts and thread counts.
+
+The kernels of max_pool2d, avg_pool2d and of the nearest and bilinear
+upsample spread the batch and channels over the threads. Channels-last
+inputs, contiguous in (N, H, W, C) order, run without a copy to the
+contiguous layout and vectorize over the channels.
+
+    python test/benchmarks/pooling_cpu.py --threads 1 4 16 --backward
+"""
+import argparse
+import timeit
+
+import torch
+import torch.nn.functional as F
+
+# (batch, channels, input size), typical of the early and late layers of a
+# ResNet
+SHAPES = [
+    (32, 64, 112),
+    (32, 256, 56),
+    (32, 512, 14),
+]
+
+OPS = [
+    ('max_pool2d', lambda x: F.max_pool2d(x, 3, 2, 1)),
+    ('avg_pool2d', lambda x: F.avg_pool2d(x, 3, 2, 1)),
+    ('nearest', lambda x: F.upsample(x, scale_factor=2, mode='nearest')),
+    ('bilinear', lambda x: F.upsample(x, scale_factor=2, mode='bilinear', align_corners=False)),
+]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--threads', type=int, nargs='+',
+                        default=[1, torch.get_num_threads()])
+    parser.add_argument('--iters', type=int, default=10,
+                        help='calls per measurement')
+    parser.add_argument('--backward', action='store_true',
+                        help='time the forward and backward together')
+    args = parser.parse_args()
+
+    layouts = ['contiguous', 'channels_last']
+    print('{:>7} {:>10} {:>14} {}'.format(
+        'threads', 'op', 'shape', ' '.join('{:>13}'.format(name) for name in layouts)))
+    for threads in args.threads:
+        torch.set_num_threads(threads)
+        for name, op in OPS:
+            for n, c, size in SHAPES:
+                x = torch.randn(n, c, size, size)
+                inputs = [x, x.permute(0, 2, 3, 1).contiguous().permute(0, 3, 1, 2)]
+                times = []
+                for input in inputs:
+                    input.requires_grad_(args.backward)
+
+                    def run():
+                        out = op(input)
+                        if args.backward:
+                            out.sum().backward()
+                    run()
+                    best = min(timeit.repeat(run, number=args.iters, repeat=3))
+                    times.append(best / args.iters * 1e3)
+                shape = '{}x{}x{}x{}'.format(n, c, size, size)
+                print('{:>7} {:>10} {:>14} {}'.format(
+                    threads, name, shape, ' '.join('{:11.2f}ms'.format(t) for t in times)))
+
+
+if __name__ == '__main__':
+    main()
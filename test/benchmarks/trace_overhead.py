@@ -0,0 +1,45 @@
+"""Measures how many operations per second the tracer records.
+
+The model is a long chain of elementwise operations on a tiny tensor, so the
+time is spent recording the trace rather than computing. It is traced with
+and without recording the source location of every operation, see
+torch.jit.record_source_locations.
+
+    python test/benchmarks/trace_overhead.py --ops 10000
+"""
+import argparse
+import timeit
+
+import torch
+
+
+def chain(num_ops):
+    def fn(x):
+        for i in range(num_ops // 4):
+            x = torch.sigmoid(x * 2 + 1) - x
+        return x
+    return fn
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('--ops', type=int, default=10000,
+                        help='operations in the traced function')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='traces per case, the best one is reported')
+    args = parser.parse_args()
+
+    fn = chain(args.ops)
+    x = torch.randn(1)
+    for source_locations in (True, False):
+        def trace():
+            with torch.jit.record_source_locations(source_locations):
+                torch.jit.get_trace_graph(fn, (x,))
+        trace()
+        best = min(timeit.repeat(trace, number=1, repeat=args.repeat))
+        print('source locations {:<5} {:10.0f} ops/s'.format(
+            str(source_locations), args.ops / best))
+
+
+if __name__ == '__main__':
+    main()
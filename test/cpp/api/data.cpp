@@ -0,0 +1,172 @@
+#include <catch.hpp>
+
+#include <torch/data.h>
+#include <torch/tensor.h>
+#include <torch/utils.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace torch::data;
+
+namespace {
+/// Returns the example index as both input and target, after a delay that
+/// makes later examples finish first when loaded on several workers.
+struct SlowDataset : public Dataset {
+  explicit SlowDataset(size_t size) : size_(size) {}
+
+  Example<> get(size_t index) override {
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(2 * ((size_ - index) % 5)));
+    const auto value = static_cast<int64_t>(index);
+    return {torch::full({2}, value, torch::kInt64),
+            torch::full({}, value, torch::kInt64)};
+  }
+
+  size_t size() const override {
+    return size_;
+  }
+
+  size_t size_;
+};
+
+struct ThrowingDataset : public SlowDataset {
+  using SlowDataset::SlowDataset;
+
+  Example<> get(size_t index) override {
+    if (index == 3) {
+      throw std::runtime_error("cannot load example 3");
+    }
+    return SlowDataset::get(index);
+  }
+};
+
+std::vector<int64_t> targets_of(const Example<>& batch) {
+  const at::Tensor target = batch.target;
+  const auto* data = target.data<int64_t>();
+  return std::vector<int64_t>(data, data + target.numel());
+}
+} // namespace
+
+TEST_CASE("Data/SequentialSampler") {
+  SequentialSampler sampler(5);
+  REQUIRE(*sampler.next(2) == std::vector<size_t>({0, 1}));
+  REQUIRE(*sampler.next(2) == std::vector<size_t>({2, 3}));
+  REQUIRE(*sampler.next(2) == std::vector<size_t>({4}));
+  REQUIRE(!sampler.next(2).has_value());
+  sampler.reset();
+  REQUIRE(*sampler.next(10) == std::vector<size_t>({0, 1, 2, 3, 4}));
+}
+
+TEST_CASE("Data/RandomSampler") {
+  torch::manual_seed(0);
+  RandomSampler sampler(10);
+  std::vector<size_t> indices;
+  while (auto batch = sampler.next(3)) {
+    REQUIRE(batch->size() <= 3);
+    indices.insert(indices.end(), batch->begin(), batch->end());
+  }
+  std::sort(indices.begin(), indices.end());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    REQUIRE(indices[i] == i);
+  }
+  REQUIRE(indices.size() == 10);
+}
+
+TEST_CASE("Data/TensorDataset") {
+  TensorDataset dataset(torch::arange(6).view({3, 2}), torch::arange(3));
+  REQUIRE(dataset.size() == 3);
+  auto batch = stack(dataset.get_batch({2, 0}));
+  REQUIRE(batch.data.size(0) == 2);
+  REQUIRE(batch.data.size(1) == 2);
+  REQUIRE(batch.data[0][1].toCFloat() == 5);
+  REQUIRE(batch.target[1].toCFloat() == 0);
+}
+
+TEST_CASE("Data/DataLoader/OrderedDelivery") {
+  for (size_t workers : {0, 1, 4}) {
+    DataLoader<SlowDataset, SequentialSampler> loader(
+        SlowDataset(23), DataLoaderOptions(4).workers(workers));
+    for (size_t epoch = 0; epoch < 2; ++epoch) {
+      std::vector<int64_t> targets;
+      size_t batches = 0;
+      for (auto& batch : loader) {
+        REQUIRE(batch.data.size(1) == 2);
+        const auto batch_targets = targets_of(batch);
+        targets.insert(
+            targets.end(), batch_targets.begin(), batch_targets.end());
+        ++batches;
+      }
+      REQUIRE(batches == 6);
+      REQUIRE(targets.size() == 23);
+      for (size_t i = 0; i < targets.size(); ++i) {
+        REQUIRE(targets[i] == static_cast<int64_t>(i));
+      }
+    }
+  }
+}
+
+TEST_CASE("Data/DataLoader/UnorderedDelivery") {
+  DataLoader<SlowDataset> loader(
+      SlowDataset(23),
+      DataLoaderOptions(4).workers(4).max_jobs(8).enforce_ordering(false));
+  std::vector<int64_t> targets;
+  for (auto& batch : loader) {
+    const auto batch_targets = targets_of(batch);
+    targets.insert(targets.end(), batch_targets.begin(), batch_targets.end());
+  }
+  std::sort(targets.begin(), targets.end());
+  REQUIRE(targets.size() == 23);
+  for (size_t i = 0; i < targets.size(); ++i) {
+    REQUIRE(targets[i] == static_cast<int64_t>(i));
+  }
+}
+
+TEST_CASE("Data/DataLoader/DropLast") {
+  auto loader = make_data_loader(
+      SlowDataset(10), DataLoaderOptions(4).workers(2).drop_last(true));
+  size_t batches = 0;
+  for (auto& batch : *loader) {
+    REQUIRE(batch.data.size(0) == 4);
+    ++batches;
+  }
+  REQUIRE(batches == 2);
+}
+
+TEST_CASE("Data/DataLoader/ResetDiscardsPendingBatches") {
+  DataLoader<SlowDataset, SequentialSampler> loader(
+      SlowDataset(40), DataLoaderOptions(2).workers(3));
+  loader.reset();
+  REQUIRE(targets_of(*loader.next()) == std::vector<int64_t>({0, 1}));
+  loader.reset();
+  REQUIRE(targets_of(*loader.next()) == std::vector<int64_t>({0, 1}));
+  REQUIRE(targets_of(*loader.next()) == std::vector<int64_t>({2, 3}));
+}
+
+TEST_CASE("Data/DataLoader/RethrowsWorkerExceptions") {
+  DataLoader<ThrowingDataset, SequentialSampler> loader(
+      ThrowingDataset(8), DataLoaderOptions(2).workers(2));
+  loader.reset();
+  REQUIRE(targets_of(*loader.next()) == std::vector<int64_t>({0, 1}));
+  REQUIRE_THROWS_WITH(loader.next(), "cannot load example 3");
+  REQUIRE(targets_of(*loader.next()) == std::vector<int64_t>({4, 5}));
+}
+
+TEST_CASE("Data/DataLoader/PinsAndMovesBatchesToCUDA", "[cuda]") {
+  DataLoader<SlowDataset, SequentialSampler> loader(
+      SlowDataset(8),
+      DataLoaderOptions(4).workers(2).pin_memory(true).device(
+          torch::Device(torch::kCUDA, 0)));
+  size_t batches = 0;
+  for (auto& batch : loader) {
+    REQUIRE(batch.data.device().is_cuda());
+    REQUIRE(batch.target.device().is_cuda());
+    ++batches;
+  }
+  REQUIRE(batches == 2);
+}
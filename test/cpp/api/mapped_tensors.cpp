@@ -0,0 +1,86 @@
+#include <catch.hpp>
+
+#include <torch/mapped_tensors.h>
+#include <torch/tensor.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+struct TempFile {
+  TempFile() {
+    char name[] = "/tmp/torch_mapped_XXXXXX";
+    int fd = mkstemp(name);
+    REQUIRE(fd != -1);
+    close(fd);
+    path = name;
+  }
+  ~TempFile() {
+    std::remove(path.c_str());
+  }
+  std::string path;
+};
+} // namespace
+
+TEST_CASE("mapped_tensors") {
+  TempFile file;
+
+  SECTION("roundtrip") {
+    auto x = torch::randn({3, 4});
+    auto y = torch::ones({10}, torch::getType(torch::kCPU, torch::kInt64))
+                 .slice(0, 2, 8, 2);
+    auto empty = torch::ones({0, 5});
+    torch::save_mapped(file.path, {{"x", x}, {"empty", empty}, {"y", y}});
+
+    auto loaded = torch::load_mapped(file.path);
+    REQUIRE(loaded.size() == 3);
+    REQUIRE(loaded[0].first == "x");
+    REQUIRE(loaded[0].second.sizes().vec() == x.sizes().vec());
+    REQUIRE(loaded[0].second.equal(x));
+    REQUIRE(loaded[1].first == "empty");
+    REQUIRE(loaded[1].second.sizes().vec() == empty.sizes().vec());
+    REQUIRE(loaded[2].first == "y");
+    REQUIRE(loaded[2].second.type().scalarType() == torch::kInt64);
+    REQUIRE(loaded[2].second.equal(y));
+  }
+
+  SECTION("data is page aligned") {
+    torch::save_mapped(
+        file.path, {{"a", torch::randn({7})}, {"b", torch::randn({3})}});
+    auto loaded = torch::load_mapped(file.path);
+    for (const auto& named : loaded) {
+      REQUIRE(reinterpret_cast<uintptr_t>(named.second.data_ptr()) % 4096 == 0);
+    }
+  }
+
+  SECTION("tensors outlive the rest") {
+    auto x = torch::randn({16});
+    torch::save_mapped(file.path, {{"x", x}});
+    torch::Tensor y;
+    {
+      auto loaded = torch::load_mapped(file.path);
+      y = loaded[0].second;
+    }
+    REQUIRE(y.equal(x));
+  }
+
+  SECTION("writes don't reach the file") {
+    auto x = torch::zeros({4});
+    torch::save_mapped(file.path, {{"x", x}});
+    torch::load_mapped(file.path)[0].second.data().fill_(1);
+    REQUIRE(torch::load_mapped(file.path)[0].second.equal(x));
+  }
+
+  SECTION("rejects other files") {
+    {
+      std::ofstream stream(file.path, std::ios::binary);
+      stream << "not a mapped tensor file";
+    }
+    REQUIRE_THROWS(torch::load_mapped(file.path));
+  }
+}
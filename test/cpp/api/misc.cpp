@@ -5,12 +5,21 @@
 #include <torch/nn/init.h>
 #include <torch/nn/modules/linear.h>
 #include <torch/tensor.h>
+#include <torch/tensor_list_view.h>
 #include <torch/utils.h>
 
+#include <torch/csrc/autograd/engine.h>
+#include <torch/csrc/autograd/small_object_pool.h>
 #include <torch/csrc/utils/memory.h>
 
 #include <ATen/optional.h>
 
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
 using namespace torch::nn;
 
 template <typename T>
@@ -50,6 +59,184 @@ TEST_CASE("autograd") {
   // Assume everything else is safe from PyTorch tests.
 }
 
+namespace {
+// many independent towers of pointwise ops over separate leaves, summed
+torch::Tensor wideGraph(const std::vector<torch::Tensor>& leaves) {
+  std::vector<torch::Tensor> towers;
+  for (auto& leaf : leaves) {
+    auto t = leaf;
+    for (int i = 0; i < 8; ++i) {
+      t = (t * t).tanh() + leaf;
+    }
+    towers.push_back(t.sum());
+  }
+  return torch::stack(torch::TensorListView(towers)).sum();
+}
+
+std::vector<torch::Tensor> wideGraphGrads(std::vector<torch::Tensor>& leaves) {
+  for (auto& leaf : leaves) {
+    if (leaf.grad().defined()) {
+      leaf.grad().zero_();
+    }
+  }
+  wideGraph(leaves).backward();
+  std::vector<torch::Tensor> grads;
+  for (auto& leaf : leaves) {
+    grads.push_back(leaf.grad().clone());
+  }
+  return grads;
+}
+
+std::vector<torch::Tensor> wideGraphLeaves(int64_t towers, int64_t size) {
+  std::vector<torch::Tensor> leaves;
+  for (int64_t i = 0; i < towers; ++i) {
+    leaves.push_back(torch::randn({size}, torch::requires_grad()));
+  }
+  return leaves;
+}
+} // namespace
+
+TEST_CASE("autograd/cpu-threads") {
+  torch::manual_seed(0);
+  auto& engine = torch::autograd::Engine::get_default_engine();
+  REQUIRE(engine.get_num_cpu_threads() == 1);
+  REQUIRE_THROWS(engine.set_num_cpu_threads(0));
+
+  auto leaves = wideGraphLeaves(32, 100);
+  auto expected = wideGraphGrads(leaves);
+  engine.set_num_cpu_threads(4);
+  REQUIRE(engine.get_num_cpu_threads() == 4);
+  for (int i = 0; i < 5; ++i) {
+    auto grads = wideGraphGrads(leaves);
+    for (size_t j = 0; j < leaves.size(); ++j) {
+      REQUIRE(grads[j].allclose(expected[j]));
+    }
+  }
+  SECTION("shared leaf accumulates from every use") {
+    auto x = torch::randn({10}, torch::requires_grad());
+    std::vector<torch::Tensor> uses;
+    for (int i = 0; i < 16; ++i) {
+      uses.push_back((x * (i + 1)).sum());
+    }
+    torch::stack(torch::TensorListView(uses)).sum().backward();
+    REQUIRE(x.grad().allclose(torch::full({10}, 136)));
+  }
+  engine.set_num_cpu_threads(1);
+}
+
+TEST_CASE("autograd/cpu-threads-benchmark", "[.][benchmark]") {
+  torch::manual_seed(0);
+  auto& engine = torch::autograd::Engine::get_default_engine();
+  auto leaves = wideGraphLeaves(64, 10000);
+  for (int num_threads : {1, 2, 4, 8}) {
+    engine.set_num_cpu_threads(num_threads);
+    wideGraphGrads(leaves); // warm up
+    const int iters = 20;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iters; ++i) {
+      wideGraphGrads(leaves);
+    }
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << "cpu threads: " << num_threads
+              << ", backward: " << elapsed.count() / iters << "ms\n";
+  }
+  engine.set_num_cpu_threads(1);
+}
+
+TEST_CASE("autograd/small-object-pool") {
+  using namespace torch::autograd;
+  SECTION("reuses freed blocks of the same size class") {
+    auto* a = allocateSmallObject(100);
+    freeSmallObject(a, 100);
+    auto cached = numCachedSmallObjects();
+    REQUIRE(cached > 0);
+    auto* b = allocateSmallObject(112);
+    REQUIRE(a == b);
+    REQUIRE(numCachedSmallObjects() == cached - 1);
+    freeSmallObject(b, 112);
+  }
+  SECTION("large blocks bypass the cache") {
+    auto cached = numCachedSmallObjects();
+    auto* a = allocateSmallObject(kMaxSmallObjectSize + 1);
+    freeSmallObject(a, kMaxSmallObjectSize + 1);
+    REQUIRE(numCachedSmallObjects() == cached);
+  }
+  SECTION("blocks can be freed on another thread") {
+    std::vector<void*> blocks;
+    for (int i = 0; i < 100; ++i) {
+      blocks.push_back(allocateSmallObject(64));
+    }
+    size_t cached_on_thread = 0;
+    std::thread t([&] {
+      for (auto* block : blocks) {
+        freeSmallObject(block, 64);
+      }
+      cached_on_thread = numCachedSmallObjects();
+    });
+    t.join();
+    REQUIRE(cached_on_thread == blocks.size());
+  }
+  SECTION("graphs recorded on one thread can be freed on another") {
+    auto x = torch::randn({3}, torch::requires_grad());
+    auto y = x;
+    for (int i = 0; i < 100; ++i) {
+      y = y * 2 + 1;
+    }
+    std::thread t([&] { y = torch::Tensor(); });
+    t.join();
+    auto z = (x * x).sum();
+    z.backward();
+    REQUIRE(x.grad().allclose(x * 2));
+  }
+  SECTION("arenas hand out aligned memory for standard containers") {
+    Arena arena;
+    ArenaAllocator<std::pair<const int, int>> allocator(arena);
+    std::unordered_map<
+        int,
+        int,
+        std::hash<int>,
+        std::equal_to<int>,
+        ArenaAllocator<std::pair<const int, int>>>
+        map(allocator);
+    for (int i = 0; i < 10000; ++i) {
+      map[i] = i * 2;
+    }
+    for (int i = 0; i < 10000; i += 2) {
+      map.erase(i);
+    }
+    REQUIRE(map.size() == 5000);
+    REQUIRE(map.at(9999) == 19998);
+    for (size_t size : {1, 24, 100, 10000}) {
+      auto ptr = reinterpret_cast<uintptr_t>(arena.allocate(size));
+      REQUIRE(ptr % alignof(std::max_align_t) == 0);
+    }
+  }
+}
+
+TEST_CASE("autograd/graph-construction-benchmark", "[.][benchmark]") {
+  // Tiny ops, so that the time goes into recording the graph rather than
+  // into the kernels.
+  auto x = torch::randn({1}, torch::requires_grad());
+  const int ops_per_iteration = 1000;
+  const int iterations = 100;
+  for (bool record : {false, true}) {
+    torch::autograd::AutoGradMode grad_mode(record);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+      auto y = x;
+      for (int j = 0; j < ops_per_iteration; ++j) {
+        y = y * 1.0001;
+      }
+    }
+    std::chrono::duration<double, std::nano> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << (record ? "with" : "without")
+              << " grad: " << elapsed.count() / (iterations * ops_per_iteration)
+              << "ns per op\n";
+  }
+}
+
 TEST_CASE("nn::init") {
   auto tensor = torch::empty({3, 4}, torch::requires_grad());
   REQUIRE_THROWS_WITH(
@@ -210,6 +210,55 @@ TEST_CASE("Optim/ProducesPyTorchValues/SGD") {
       expected_parameters::SGD);
 }
 
+template <typename OptimizerClass, typename Options>
+void check_grouped_step_matches_separate_steps(Options options) {
+  torch::manual_seed(0);
+
+  // Mixed dtypes, a non-contiguous parameter and one without a gradient.
+  std::vector<torch::Tensor> parameters = {
+      torch::randn({3, 4}),
+      torch::randn({5}, torch::kFloat64),
+      torch::randn({4, 3}).t(),
+      torch::randn({2, 2}, torch::kFloat64),
+      torch::randn({6})};
+  std::vector<torch::Tensor> copies;
+  for (const auto& parameter : parameters) {
+    copies.push_back(parameter.clone());
+  }
+
+  OptimizerClass grouped(parameters, options);
+  std::vector<OptimizerClass> separate;
+  for (const auto& copy : copies) {
+    separate.emplace_back(std::vector<torch::Tensor>{copy}, options);
+  }
+
+  for (size_t step = 0; step < 3; ++step) {
+    for (size_t i = 0; i + 1 < parameters.size(); ++i) {
+      auto grad = torch::randn(parameters[i].sizes(), parameters[i].dtype());
+      parameters[i].grad() = grad;
+      copies[i].grad() = grad.clone();
+    }
+    grouped.step();
+    for (auto& optimizer : separate) {
+      optimizer.step();
+    }
+  }
+
+  for (size_t i = 0; i < parameters.size(); ++i) {
+    REQUIRE(parameters[i].allclose(copies[i]));
+  }
+}
+
+TEST_CASE("Optim/GroupedStepMatchesSeparateSteps/SGD") {
+  check_grouped_step_matches_separate_steps<SGD>(
+      SGDOptions(0.1).momentum(0.9).weight_decay(1e-4));
+}
+
+TEST_CASE("Optim/GroupedStepMatchesSeparateSteps/Adam") {
+  check_grouped_step_matches_separate_steps<Adam>(
+      AdamOptions(0.1).weight_decay(1e-4).amsgrad(true));
+}
+
 TEST_CASE("Optim/ZeroGrad") {
   torch::manual_seed(0);
 
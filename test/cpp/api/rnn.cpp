@@ -8,6 +8,9 @@
 
 #include <test/cpp/api/util.h>
 
+#include <type_traits>
+#include <vector>
+
 using namespace torch::nn;
 using namespace torch::test;
 
@@ -84,6 +87,39 @@ void check_lstm_sizes(RNNOutput output) {
   REQUIRE(output.state.norm().toCFloat() > 0);
 }
 
+// Runs every sequence of a padded batch on its own and checks that the packed
+// forward produces the same outputs and final states.
+template <typename R>
+void check_packed_matches_unpacked(R model, torch::Device device) {
+  const std::vector<int64_t> lengths = {5, 3, 3, 1};
+  // LSTM states are (2, layers, batch, hidden), others (layers, batch, hidden).
+  const int64_t state_batch_dimension = std::is_same<R, LSTM>::value ? 2 : 1;
+  auto input = torch::randn({5, 4, 3}, device);
+  auto packed = pack_padded_sequence(input, lengths);
+  REQUIRE(packed.batch_sizes == std::vector<int64_t>({4, 3, 3, 1, 1}));
+  REQUIRE(packed.data.size(0) == 12);
+
+  auto output = model->packed_forward(packed);
+  REQUIRE(output.output.size(0) == 12);
+  REQUIRE(output.state.size(state_batch_dimension) == 4);
+
+  int64_t row = 0;
+  for (int64_t t = 0; t < 5; ++t) {
+    for (int64_t b = 0; b < packed.batch_sizes[t]; ++b, ++row) {
+      auto sequence = input.narrow(0, 0, lengths[b]).narrow(1, b, 1);
+      auto expected = model->forward(sequence);
+      REQUIRE(output.output[row].allclose(expected.output[t][0], 1e-4, 1e-5));
+      if (t == lengths[b] - 1) {
+        REQUIRE(output.state.select(state_batch_dimension, b)
+                    .allclose(
+                        expected.state.select(state_batch_dimension, 0),
+                        1e-4,
+                        1e-5));
+      }
+    }
+  }
+}
+
 TEST_CASE("rnn") {
   torch::manual_seed(0);
   SECTION("sizes") {
@@ -164,6 +200,13 @@ TEST_CASE("rnn") {
       REQUIRE(std::abs(flat[i].toCFloat() - h_out[i]) < 1e-3);
     }
   }
+
+  SECTION("packed") {
+    check_packed_matches_unpacked(
+        LSTM(LSTMOptions(3, 4).layers(2)), torch::kCPU);
+    check_packed_matches_unpacked(
+        RNN(RNNOptions(3, 4).tanh().layers(2)), torch::kCPU);
+  }
 }
 
 TEST_CASE("rnn/integration/LSTM") {
@@ -210,6 +253,28 @@ TEST_CASE("rnn_cuda", "[cuda]") {
     REQUIRE(diff.data().abs().sum().toCFloat() > 1e-3);
   }
 
+  SECTION("packed") {
+    torch::manual_seed(0);
+    LSTM model(LSTMOptions(3, 4).layers(2));
+    model->to(torch::kCUDA);
+    check_packed_matches_unpacked(model, torch::kCUDA);
+  }
+
+  SECTION("reflattens replaced parameters") {
+    torch::manual_seed(0);
+    LSTM model(LSTMOptions(3, 4).layers(2).dropout(0.5));
+    model->to(torch::kCUDA);
+    model->eval();
+    auto x = torch::randn({6, 2, 3}, torch::kCUDA);
+    auto before = model->forward(x);
+    for (auto& parameter : model->parameters()) {
+      parameter->data().set_(parameter->data().clone());
+    }
+    auto after = model->forward(x);
+    REQUIRE(after.output.allclose(before.output));
+    REQUIRE(after.state.allclose(before.state));
+  }
+
   SECTION("lstm") {
     REQUIRE(test_RNN_xor<LSTM>(
         [](int s) { return LSTM(LSTMOptions(s, s).layers(2)); }, true));
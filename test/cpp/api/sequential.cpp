@@ -303,3 +303,61 @@ TEST_CASE("sequential") {
     }
   }
 }
+
+TEST_CASE("sequential/checkpointing") {
+  torch::manual_seed(0);
+  Sequential sequential(
+      Linear(10, 20),
+      Functional(torch::tanh),
+      Dropout(0.5),
+      Linear(20, 20),
+      Functional(torch::tanh),
+      Linear(20, 5));
+  Sequential clone =
+      std::static_pointer_cast<SequentialImpl>(sequential->clone());
+
+  auto run = [](Sequential& model, torch::Tensor input, size_t segments) {
+    torch::manual_seed(42);
+    auto output = segments == 0 ? model->forward(input)
+                                : model->forward_checkpointed(input, segments);
+    output.sum().backward();
+    return output;
+  };
+
+  SECTION("matches forward() in outputs and gradients") {
+    for (bool input_requires_grad : {true, false}) {
+      auto input = torch::randn({8, 10}, torch::requires_grad(input_requires_grad));
+      auto input_clone = input.detach().clone();
+      input_clone.set_requires_grad(input_requires_grad);
+      for (size_t segments : {1, 2, 3, 6, 10}) {
+        sequential->zero_grad();
+        clone->zero_grad();
+        auto expected = run(sequential, input, 0);
+        auto output = run(clone, input_clone, segments);
+        REQUIRE(output.allclose(expected));
+        auto params = sequential->parameters();
+        for (auto& param : clone->parameters()) {
+          REQUIRE(param->grad().allclose(params[param.key].grad()));
+        }
+        if (input_requires_grad) {
+          REQUIRE(input_clone.grad().allclose(input.grad()));
+          input.grad().zero_();
+          input_clone.grad().zero_();
+        }
+      }
+    }
+  }
+
+  SECTION("backward twice through a checkpoint throws") {
+    auto input = torch::randn({8, 10}, torch::requires_grad());
+    auto output = sequential->forward_checkpointed(input, 2).sum();
+    output.backward();
+    REQUIRE_THROWS(output.backward());
+  }
+
+  SECTION("zero segments are rejected") {
+    REQUIRE_THROWS_WITH(
+        sequential->forward_checkpointed(torch::ones({2, 10}), 0),
+        StartsWith("Expected at least one segment"));
+  }
+}
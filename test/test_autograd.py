@@ -2,6 +2,7 @@ import contextlib
 import gc
 import sys
 import math
+import threading
 import torch
 import unittest
 import warnings
@@ -1849,6 +1850,41 @@ class TestAutograd(TestCase):
         out.sum().backward()
         self.assertEqual(x.grad.data, y_data)
 
+    def test_backward_from_threads(self):
+        # Graphs without Python functions or hooks run on the calling thread,
+        # the others on the engine's CPU worker.
+        def run(x, hook, grads, errors):
+            try:
+                for _ in range(10):
+                    x.grad = None
+                    y = (x * x).tanh()
+                    if hook:
+                        y.register_hook(lambda grad: grad * 2)
+                    y.sum().backward()
+                    grads.append(x.grad.clone())
+            except Exception as e:
+                errors.append(e)
+
+        errors = []
+        runs = []
+        for hook in [False, True, False, True]:
+            x = torch.randn(100, requires_grad=True)
+            expected = (1 - (x * x).tanh().pow(2)) * 2 * x
+            if hook:
+                expected = expected * 2
+            grads = []
+            thread = threading.Thread(target=run, args=(x, hook, grads, errors))
+            runs.append((thread, expected.detach(), grads))
+        for thread, _, _ in runs:
+            thread.start()
+        for thread, _, _ in runs:
+            thread.join()
+        self.assertEqual(errors, [])
+        for _, expected, grads in runs:
+            self.assertEqual(len(grads), 10)
+            for grad in grads:
+                self.assertEqual(grad, expected)
+
     def test_cat(self):
         f_args_variable = (torch.randn(1, S, S, requires_grad=True),
                            torch.randn(2, S, S, requires_grad=True),
@@ -2096,6 +2132,49 @@ class TestAutograd(TestCase):
             self.assertEqual(info.name, expected_name)
             last_end = info.cpu_interval.end
 
+    def test_profiler_correlation_ids(self):
+        x = torch.randn(10, 10)
+        torch.autograd._enable_profiler(torch.autograd.ProfilerState.CPU)
+        with torch.autograd.profiler.range('outer'):
+            y = x * 2
+        records = torch.autograd._disable_profiler()
+        events = [e for thread in records for e in thread if not e.name().startswith('__')]
+        open_ids = []
+        ids = set()
+        for e in events:
+            if e.kind() == 'push':
+                self.assertNotIn(e.correlation_id(), ids)
+                ids.add(e.correlation_id())
+                open_ids.append(e.correlation_id())
+            elif e.kind() == 'pop':
+                self.assertEqual(open_ids.pop(), e.correlation_id())
+        self.assertEqual(len(ids), 2)  # outer and mul
+
+    def test_profiler_sampling(self):
+        x = torch.randn(10, 10)
+        with torch.autograd.profiler.sample(period=1) as s:
+            s.drain()
+            for _ in range(10):
+                y = x * 2 + 4
+            samples = {op.name: op for op in s.drain()}
+            self.assertEqual(samples['mul'].samples, 10)
+            self.assertEqual(samples['add'].samples, 10)
+            self.assertEqual(sum(samples['mul'].histogram), 10)
+            self.assertGreater(samples['mul'].total_ns, 0)
+            # drained
+            self.assertEqual(s.drain(), [])
+
+        with torch.autograd.profiler.sample(period=5) as s:
+            for _ in range(50):
+                y = x * 2
+            samples = {op.name: op for op in s.drain()}
+            self.assertEqual(samples['mul'].samples, 10)
+
+        # no range events are recorded in sampling mode
+        with torch.autograd.profiler.sample(period=1):
+            self.assertRaises(RuntimeError, torch.autograd._disable_profiler)
+        self.assertRaises(RuntimeError, torch.autograd._disable_profiler_sampling)
+
     def test_dir(self):
         x = torch.randn(10, 10)
         keys = dir(x)
@@ -2390,6 +2469,25 @@ class TestAutograd(TestCase):
         out.sum().backward()
         self.assertFalse(s.grad is None or s.grad.abs().sum().item() == 0)
 
+    @unittest.skipIf(not torch.cuda.is_available(), "CUDA unavailable")
+    def test_offload_saved_tensors(self):
+        def run(offload):
+            torch.manual_seed(0)
+            x = torch.randn(64, 64, device='cuda', requires_grad=True)
+            with torch.autograd.offload_saved_tensors(offload, min_bytes=0):
+                out = x
+                for _ in range(8):
+                    out = out.tanh().mm(out.t())
+                loss = out.sum()
+            # Backward twice, to fetch the offloaded tensors again
+            loss.backward(retain_graph=True)
+            loss.backward()
+            return x.grad
+
+        self.assertFalse(torch._C._is_offload_enabled())
+        self.assertEqual(run(True), run(False))
+        self.assertFalse(torch._C._is_offload_enabled())
+
     def test_anomaly_detect_nan(self):
         size = 10
 
@@ -2995,6 +3093,7 @@ method_tests = [
     ('index_fill', (), (0, torch.tensor([0], dtype=torch.int64), 2), 'scalar_input_dim', [0]),
     ('index_fill', (), (0, torch.tensor(0, dtype=torch.int64), 2), 'scalar_both_dim', [0]),
     ('inverse', (S, S), NO_ARGS, '', NO_ARGS, [skipIfNoLapack]),
+    ('inverse', (S, 2, 2), NO_ARGS, 'batched', NO_ARGS, [skipIfNoLapack]),
     ('det', (S, S), NO_ARGS, '', NO_ARGS, [skipIfNoLapack]),
     ('det', (1, 1), NO_ARGS, '1x1', NO_ARGS, [skipIfNoLapack]),
     ('det', lambda: random_symmetric_matrix(S), NO_ARGS, 'symmetric', NO_ARGS, [skipIfNoLapack]),
@@ -49,6 +49,16 @@ class StoreTestBase(object):
     def test_set_get(self):
         self._test_set_get(self._create_store())
 
+    def _test_multi_set_get(self, fs):
+        fs.multi_set(["key0", "key1", "key2"], ["value0", "value1", "value2"])
+        self.assertEqual(
+            [b"value0", b"value1", b"value2"],
+            fs.multi_get(["key0", "key1", "key2"]))
+        self.assertEqual(b"value1", fs.get("key1"))
+
+    def test_multi_set_get(self):
+        self._test_multi_set_get(self._create_store())
+
 
 class FileStoreTest(TestCase, StoreTestBase):
     def setUp(self):
@@ -266,6 +276,168 @@ class ProcessGroupGlooTest(TestCase):
         work.wait()
         self.assertEqual(torch.Tensor([float(self.size * (self.size + 1) / 2)]), x)
 
+    def test_allreduce_size_classes(self):
+        store = c10d.FileStore(self.file.name)
+        opts = self.opts()
+        opts.cacheSizeClasses = True
+        opts.cacheMaxBytes = 4096
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.size, opts)
+
+        # 1000 and 1024 elements share the entry of their size class
+        pg.warm_up_allreduce([torch.Tensor(1024)])
+        self.assertEqual(4096, pg.cache_bytes())
+        for n in [1000, 1024, 300, 1000]:
+            x = torch.arange(n).float() + self.rank
+            pg.allreduce(x).wait()
+            base = self.size * (self.size - 1) / 2
+            self.assertEqual(torch.arange(n).float() * self.size + base, x)
+            self.assertLessEqual(pg.cache_bytes(), 4096)
+
+        # Broadcast of a tensor that is not a size class
+        x = torch.Tensor(10, 10).fill_(self.rank)
+        pg.broadcast(x, root=1).wait()
+        self.assertEqual(torch.Tensor(10, 10).fill_(1), x)
+
+    def test_reduce_scatter_ops(self):
+        store = c10d.FileStore(self.file.name)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.size, self.opts())
+
+        # Rank i contributes i + j to the element j of the input
+        x = torch.arange(self.size * 2).float() + self.rank
+        y = torch.Tensor(2)
+        pg.reduce_scatter([y], [x]).wait()
+        base = self.size * (self.size - 1) / 2
+        expected = [base + self.size * (self.rank * 2 + i) for i in range(2)]
+        self.assertEqual(torch.Tensor(expected), y)
+
+    def test_allgather_ops(self):
+        store = c10d.FileStore(self.file.name)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.size, self.opts())
+
+        x = torch.Tensor([self.rank, self.rank + 0.5])
+        y = torch.Tensor(self.size * 2)
+        pg.allgather([y], [x]).wait()
+        expected = [i + j for i in range(self.size) for j in [0.0, 0.5]]
+        self.assertEqual(torch.Tensor(expected), y)
+
+    def test_alltoall_ops(self):
+        store = c10d.FileStore(self.file.name)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.size, self.opts())
+
+        # Run twice to go through the cached algorithm
+        for k in range(2):
+            x = torch.arange(self.size).float() + self.rank * self.size + k
+            y = torch.Tensor(self.size)
+            pg.alltoall([y], [x]).wait()
+            expected = [i * self.size + self.rank + k for i in range(self.size)]
+            self.assertEqual(torch.Tensor(expected), y)
+
+    def test_send_recv_ops(self):
+        store = c10d.FileStore(self.file.name)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.size, self.opts())
+
+        # Every rank sends to the next one, twice with the same tag
+        dst = (self.rank + 1) % self.size
+        src = (self.rank - 1) % self.size
+        for k in range(2):
+            send = pg.send([torch.Tensor([self.rank + k])], dst, tag=7)
+            y = torch.Tensor(1)
+            pg.recv([y], src, tag=7).wait()
+            send.wait()
+            self.assertEqual(torch.Tensor([src + k]), y)
+
+    def test_barrier(self):
+        store = c10d.FileStore(self.file.name)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.size, self.opts())
+        pg.barrier().wait()
+        store.add('barrier', 1)
+        pg.barrier().wait()
+        self.assertEqual(self.size, store.add('barrier', 0))
+
+    def test_compressed_allreduce_ops(self):
+        store = c10d.FileStore(self.file.name)
+        gloo_pg = c10d.ProcessGroupGloo(store, self.rank, self.size, self.opts())
+        total = float(self.size * (self.size + 1) / 2)
+
+        # Small integers are exact in half precision
+        pg = c10d.ProcessGroupCompressed(gloo_pg, c10d.Fp16Codec())
+        x = torch.Tensor([self.rank + 1.0, -(self.rank + 1.0)])
+        pg.allreduce(x).wait()
+        self.assertEqual(torch.Tensor([total, -total]), x)
+
+        # Only the larger half of the elements is sent, and the rest follows
+        # with the next allreduce under the same key, whatever the tensor
+        pg = c10d.ProcessGroupCompressed(gloo_pg, c10d.TopKCodec(0.5))
+        x = torch.Tensor([self.rank + 1.0, 0.5])
+        pg.allreduce(x, 'bucket0').wait()
+        self.assertEqual(torch.Tensor([total, 0.0]), x)
+        y = torch.Tensor([0.0, 0.0])
+        pg.allreduce(y, 'bucket0').wait()
+        self.assertEqual(torch.Tensor([0.0, 0.5 * self.size]), y)
+
+        # A dropped residual isn't carried over
+        x = torch.Tensor([self.rank + 1.0, 0.5])
+        pg.allreduce(x, 'bucket0').wait()
+        pg.drop_residual('bucket0')
+        y = torch.Tensor([0.0, 0.0])
+        pg.allreduce(y, 'bucket0').wait()
+        self.assertEqual(torch.Tensor([0.0, 0.0]), y)
+
+        # Error feedback needs a key
+        with self.assertRaises(ValueError):
+            pg.allreduce(torch.Tensor([1.0, 0.5]))
+
+        # Every element is decoded to the mean magnitude with its sign
+        pg = c10d.ProcessGroupCompressed(gloo_pg, c10d.SignCodec())
+        x = torch.Tensor([1.0, -3.0] * 5)
+        pg.allreduce(x, 'bucket0').wait()
+        self.assertEqual(torch.Tensor([2.0 * self.size, -2.0 * self.size] * 5), x)
+
+    def test_reducer(self):
+        store = c10d.FileStore(self.file.name)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.size, self.opts())
+
+        def make_model():
+            torch.manual_seed(0)
+            return torch.nn.Sequential(
+                torch.nn.Linear(10, 20),
+                torch.nn.Tanh(),
+                torch.nn.Linear(20, 5),
+            )
+
+        def rank_input(rank):
+            torch.manual_seed(rank + 1)
+            return torch.randn(4, 10)
+
+        # The gradients every rank would get on its own, averaged
+        expected = None
+        for rank in range(self.size):
+            model = make_model()
+            model(rank_input(rank)).sum().backward()
+            grads = [p.grad / self.size for p in model.parameters()]
+            if expected is None:
+                expected = grads
+            else:
+                expected = [e + g for e, g in zip(expected, grads)]
+
+        model = make_model()
+        # small enough to put every parameter in a bucket of its own
+        reducer = c10d.Reducer(list(model.parameters()), pg, 64)
+        self.assertEqual(4, reducer.num_buckets())
+        # in reverse registration order
+        self.assertEqual([[3], [2], [1], [0]], reducer.bucket_assignment())
+        for _ in range(2):
+            for p in model.parameters():
+                p.grad = None
+            model(rank_input(self.rank)).sum().backward()
+            for p, e in zip(model.parameters(), expected):
+                self.assertEqual(e, p.grad)
+
+        # every parameter has to receive a gradient
+        model[0].weight.grad = None
+        with self.assertRaisesRegex(RuntimeError, "receive a gradient"):
+            model[2](torch.randn(4, 20)).sum().backward()
+
 
 class ProcessGroupNCCLTest(TestCase):
     MAIN_PROCESS_RANK = 0
@@ -312,6 +484,23 @@ class ProcessGroupNCCLTest(TestCase):
             for i in range(self.num_gpus):
                 self.assertEqual(tensors[i], tensors[rt])
 
+    def test_warm_up_and_stats(self):
+        store = c10d.FileStore(self.file.name)
+        pg = c10d.ProcessGroupNCCL(store, self.rank, self.size)
+        devices = list(range(self.num_gpus))
+        pg.warm_up(devices)
+        self.assertEqual(1, pg.stats().num_communicator_inits)
+
+        # The collectives use the warmed up communicators, and reuse the
+        # events of the work items that are gone
+        for _ in range(3):
+            tensors = [torch.Tensor([i]).cuda(i) for i in devices]
+            pg.allreduce(tensors).wait()
+        stats = pg.stats()
+        self.assertEqual(1, stats.num_communicator_inits)
+        self.assertEqual(3, stats.num_collectives)
+        self.assertEqual(self.num_gpus, stats.num_events_created)
+
     def test_allreduce_ops(self):
         store = c10d.FileStore(self.file.name)
         pg = c10d.ProcessGroupNCCL(store, self.rank, self.size)
@@ -1,5 +1,6 @@
 import io
 import math
+import json
 import tempfile
 import re
 import unittest
@@ -622,6 +623,16 @@ def compare_cpu_gpu(tensor_constructor, arg_constructor, fn, t, precision=1e-5):
     return tmp
 
 
+@contextmanager
+def plan_cache_max_size(n, cache=None):
+    if cache is None:
+        cache = torch.backends.cuda.cufft_plan_cache
+    original = cache.max_size
+    cache.max_size = n
+    yield
+    cache.max_size = original
+
+
 class TestCuda(TestCase):
     _do_cuda_memory_leak_check = True
 
@@ -752,6 +763,34 @@ class TestCuda(TestCase):
         for _ in self._test_memory_stats_generator(self):
             pass
 
+    def test_memory_snapshot(self):
+        torch.cuda.empty_cache()
+        with torch.cuda.allocation_tag("snapshot_test"):
+            x = torch.cuda.FloatTensor(1000)
+        segments = [s for s in torch.cuda.memory_snapshot()
+                    if s['device'] == x.get_device()]
+        blocks = [b for s in segments for b in s['blocks']]
+        self.assertTrue(any(b['allocated'] and b['tag'] == "snapshot_test" for b in blocks))
+        for s in segments:
+            self.assertEqual(s['total_size'], sum(b['size'] for b in s['blocks']))
+            self.assertEqual(s['allocated_size'],
+                             sum(b['size'] for b in s['blocks'] if b['allocated']))
+        self.assertEqual(sum(s['allocated_size'] for s in segments),
+                         torch.cuda.memory_allocated(x.get_device()))
+        del x
+
+    def test_memory_history(self):
+        torch.cuda.record_memory_history(True, 100)
+        try:
+            x = torch.cuda.FloatTensor(1000)
+            del x
+            trace = json.loads(torch.cuda.memory_trace_chrome_json())
+        finally:
+            torch.cuda.record_memory_history(False)
+        names = [e['name'] for e in trace['traceEvents'] if e['ph'] == 'i']
+        self.assertIn('alloc', names)
+        self.assertIn('free', names)
+
     @unittest.skipIf(not TEST_MULTIGPU, "only one GPU detected")
     def test_memory_stats_multigpu(self):
         # advance a generator with a end flag
@@ -1259,6 +1298,39 @@ class TestCuda(TestCase):
     def test_cuda_synchronize(self):
         torch.cuda.synchronize()
 
+    def test_deterministic_accumulate(self):
+        # Few distinct destinations take the sorted path even by default
+        index = torch.randint(0, 4, (4096,), dtype=torch.long)
+        src = torch.randn(4096, 8)
+        dst = torch.randn(4, 8)
+        scatter_index = index.view(-1, 1).expand(4096, 8)
+
+        def run():
+            return (dst.cuda().index_add_(0, index.cuda(), src.cuda()),
+                    dst.cuda().scatter_add_(0, scatter_index.cuda(), src.cuda()))
+
+        self.assertFalse(torch.cuda.is_deterministic_accumulate())
+        default_results = run()
+        torch.cuda.set_deterministic_accumulate(True)
+        try:
+            self.assertTrue(torch.cuda.is_deterministic_accumulate())
+            first, second = run(), run()
+        finally:
+            torch.cuda.set_deterministic_accumulate(False)
+
+        expected = dst.clone().index_add_(0, index, src)
+        for result in first + default_results:
+            self.assertEqual(result.cpu(), expected, prec=1e-3)
+        for a, b in zip(first, second):
+            self.assertTrue(torch.equal(a, b))
+
+    def test_init_times(self):
+        torch.cuda.init()
+        times = torch.cuda.init_times()
+        self.assertEqual(list(times)[:3], ['check_driver', 'thc_state', 'storage_types'])
+        self.assertIn('queued_calls', times)
+        self.assertTrue(all(t >= 0 for t in times.values()))
+
     def test_streams(self):
         default_stream = torch.cuda.current_stream()
         user_stream = torch.cuda.Stream()
@@ -1421,13 +1493,6 @@ class TestCuda(TestCase):
     def test_fft_ifft_rfft_irfft(self):
         TestTorch._test_fft_ifft_rfft_irfft(self, device=torch.device('cuda'))
 
-        @contextmanager
-        def plan_cache_max_size(n):
-            original = torch.backends.cuda.cufft_plan_cache.max_size
-            torch.backends.cuda.cufft_plan_cache.max_size = n
-            yield
-            torch.backends.cuda.cufft_plan_cache.max_size = original
-
         with plan_cache_max_size(max(1, torch.backends.cuda.cufft_plan_cache.size - 10)):
             TestTorch._test_fft_ifft_rfft_irfft(self, device=torch.device('cuda'))
 
@@ -1446,6 +1511,50 @@ class TestCuda(TestCase):
         with self.assertRaisesRegex(RuntimeError, r"read-only property"):
             torch.backends.cuda.cufft_plan_cache.size = -1
 
+        with self.assertRaisesRegex(RuntimeError, r"read-only property"):
+            torch.backends.cuda.cufft_plan_cache.hits = 0
+
+        with self.assertRaisesRegex(RuntimeError, r"but got device with index"):
+            torch.backends.cuda.cufft_plan_cache[torch.cuda.device_count() + 10]
+
+    def test_cufft_plan_cache_stats(self):
+        cache = torch.backends.cuda.cufft_plan_cache
+        with plan_cache_max_size(10):
+            cache.clear()
+            self.assertEqual(cache.hits, 0)
+            self.assertEqual(cache.misses, 0)
+            x = torch.randn(3, 100, 2, device='cuda')
+            x.fft(1)
+            self.assertEqual(cache.size, 1)
+            self.assertEqual(cache.misses, 1)
+            x.fft(1)
+            self.assertEqual(cache.size, 1)
+            self.assertEqual(cache.hits, 1)
+            torch.randn(3, 50, 2, device='cuda').fft(1)
+            self.assertEqual(cache.size, 2)
+            self.assertEqual(cache.misses, 2)
+            cache.clear()
+            self.assertEqual(cache.size, 0)
+            self.assertEqual(cache.hits, 0)
+
+    @unittest.skipIf(not TEST_MULTIGPU, "only one GPU detected")
+    def test_cufft_plan_cache_per_device(self):
+        caches = torch.backends.cuda.cufft_plan_cache
+        with plan_cache_max_size(10, caches[0]), plan_cache_max_size(10, caches[1]):
+            caches[0].clear()
+            caches[1].clear()
+            x = torch.randn(3, 100, 2, device='cuda:1')
+            x.fft(1)
+            self.assertEqual(caches[0].size, 0)
+            self.assertEqual(caches[1].size, 1)
+            self.assertIs(caches['cuda:1'], caches[1])
+            x.fft(1)
+            with torch.cuda.device(1):
+                self.assertEqual(caches.size, 1)
+                self.assertEqual(caches.hits, 1)
+                caches.clear()
+                self.assertEqual(caches[1].size, 0)
+
     def test_stft(self):
         TestTorch._test_stft(self, device=torch.device('cuda'))
 
@@ -1514,6 +1623,10 @@ class TestCuda(TestCase):
     def test_contiguous(self):
         TestTorch._test_contiguous(self, lambda t: t.cuda())
 
+    def test_permute_contiguous(self):
+        TestTorch._test_permute_contiguous(self, lambda t: t.cuda())
+        TestTorch._test_permute_contiguous(self, lambda t: t.cuda().half())
+
     def test_broadcast_fused_matmul(self):
         TestTorch._test_broadcast_fused_matmul(self, lambda t: t.cuda())
 
@@ -413,6 +413,31 @@ class TestJit(JitTestCase):
         ge = self.checkTrace(LSTMCellC, inputs)
         self.assertExpectedGraph(ge.graph_for(*inputs))
 
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    @unittest.skipIf(not RUN_CUDA, "fuser requires CUDA")
+    def test_lstm_fusion_backward(self):
+        inputs = [t.requires_grad_() for t in get_lstm_inputs('cuda')]
+        ge = torch._C.GraphExecutor(LSTMCellF, inputs)
+        hy, cy = ge(*inputs)
+
+        # the derivative is compiled and fused along with the forward
+        def grad_state():
+            plan, = ge.get_debug_state().execution_plans.values()
+            return plan.grad_executor
+
+        grad_plan, = grad_state().execution_plans.values()
+        self.assertIn('prim::FusionGroup', str(grad_plan.graph))
+
+        grad_hy, grad_cy = torch.randn_like(hy), torch.randn_like(cy)
+        grads = torch.autograd.grad((hy, cy), inputs, (grad_hy, grad_cy))
+        stats = grad_state().plan_cache_stats
+        self.assertEqual(stats.hits, 1)
+        self.assertEqual(stats.misses, 0)
+
+        inputs = [t.detach().requires_grad_() for t in inputs]
+        expected = torch.autograd.grad(LSTMCellF(*inputs), inputs, (grad_hy, grad_cy))
+        self.assertEqual(grads, expected)
+
     @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
     @unittest.skipIf(not RUN_CUDA, "fuser requires CUDA")
     def test_concat_fusion(self):
@@ -985,6 +1010,16 @@ class TestJit(JitTestCase):
         g2result2 = torch.autograd.grad(l3, [da2, db2])
         self.assertEqual(g2result, g2result2)
 
+    def test_trace_without_source_locations(self):
+        def foo(x):
+            return torch.sigmoid(x * 2) + x
+
+        x = torch.randn(3)
+        trace, _ = torch.jit.get_trace_graph(foo, (x,))
+        with torch.jit.record_source_locations(False):
+            fast_trace, _ = torch.jit.get_trace_graph(foo, (x,))
+        self.assertEqual(str(trace), str(fast_trace))
+
     def test_trace_annotation(self):
         @torch.jit.trace(torch.rand(1))
         def foo(a):
@@ -3512,6 +3547,44 @@ def func(t):
         check(fn, 'add_const')
         check(fn2, 'add_iter')
 
+    def test_constant_propagation(self):
+        def fn(x):
+            b = 7 + 1 + 3
+            return x + b
+
+        graph = torch.jit._script_graph(fn)
+        self.run_pass('constant_propagation', graph)
+        # only x + b is left to compute
+        kinds = [n.kind() for n in graph.nodes()]
+        self.assertEqual(kinds.count('aten::add'), 1)
+        self.checkScript(fn, (torch.tensor(2),))
+
+    def test_licm(self):
+        def fn(x, w):
+            y = x
+            for i in range(4):
+                y = y + w.t()
+            return y
+
+        def fn_print(x, w):
+            y = x
+            for i in range(4):
+                y = y + w.t()
+                print(y)
+            return y
+
+        def body_kinds(fn):
+            graph = torch.jit._script_graph(fn)
+            self.run_pass('licm', graph)
+            loop, = [n for n in graph.nodes() if n.kind() == 'prim::Loop']
+            body, = loop.blocks()
+            return [n.kind() for n in body.nodes()]
+
+        self.assertNotIn('aten::t', body_kinds(fn))
+        # loops with side effects are left alone
+        self.assertIn('aten::t', body_kinds(fn_print))
+        self.checkScript(fn, (torch.randn(3, 3), torch.randn(3, 3)))
+
     def test_loop_unrolling_nested(self):
         def fn(x):
             y = FIXME_zerol()
@@ -4725,8 +4798,42 @@ class TestPytorchExportModes(JitTestCase):
         d = tempfile.mkdtemp()
         torch.onnx._export(torch_model, (fake_input), d, verbose=False,
                            export_type=torch.onnx.ExportTypes.DIRECTORY)
+        self.assertTrue(os.path.isfile(
+            os.path.join(d, torch.onnx.ONNX_ARCHIVE_MODEL_PROTO_NAME)))
         shutil.rmtree(d)
 
+    def test_directory_params(self):
+        torch_model = nn.Linear(3, 2)
+        fake_input = Variable(torch.randn(4, 3))
+        d = tempfile.mkdtemp()
+        try:
+            torch.onnx._export(torch_model, (fake_input), d, verbose=False,
+                               export_type=torch.onnx.ExportTypes.DIRECTORY)
+            # The weights are written to files of their own, and only
+            # referenced from the model
+            files = set(os.listdir(d)) - {torch.onnx.ONNX_ARCHIVE_MODEL_PROTO_NAME}
+            self.assertEqual(len(files), 2)
+            sizes = sorted(os.path.getsize(os.path.join(d, name)) for name in files)
+            self.assertEqual(sizes, [2 * 4, 2 * 3 * 4])
+        finally:
+            shutil.rmtree(d)
+
+    def test_protobuf_file_path(self):
+        torch_model = nn.Linear(3, 2)
+        fake_input = Variable(torch.randn(4, 3))
+        d = tempfile.mkdtemp()
+        try:
+            path = os.path.join(d, "model.onnx")
+            torch.onnx._export(torch_model, (fake_input), path, verbose=False,
+                               export_type=torch.onnx.ExportTypes.PROTOBUF_FILE)
+            f = io.BytesIO()
+            torch.onnx._export(torch_model, (fake_input), f, verbose=False,
+                               export_type=torch.onnx.ExportTypes.PROTOBUF_FILE)
+            with open(path, "rb") as streamed:
+                self.assertEqual(streamed.read(), f.getvalue())
+        finally:
+            shutil.rmtree(d)
+
     def test_aten_fallback(self):
         class ModelWithAtenNotONNXOp(nn.Module):
             def forward(self, x, y):
@@ -51,6 +51,14 @@ def send_tensor(queue, event, tp):
     event.wait()
 
 
+def send_tensors_in_rounds(queue, ack, rounds):
+    for i in range(rounds):
+        batch = [torch.full((i + 1, 10), i) for _ in range(50)]
+        queue.put(batch)
+        del batch
+        ack.get()
+
+
 def call_backward():
     x = torch.autograd.Variable(torch.randn(3, 3), requires_grad=True)
     x.sum().backward()
@@ -103,15 +111,23 @@ def autograd_sharing(queue, ready, master_modified):
 
 
 @contextlib.contextmanager
-def fs_sharing():
+def sharing_strategy(strategy):
     prev_strategy = mp.get_sharing_strategy()
-    mp.set_sharing_strategy('file_system')
+    mp.set_sharing_strategy(strategy)
     try:
         yield
     finally:
         mp.set_sharing_strategy(prev_strategy)
 
 
+def fs_sharing():
+    return sharing_strategy('file_system')
+
+
+def fs_pool_sharing():
+    return sharing_strategy('file_system_pool')
+
+
 class leak_checker(object):
 
     def __init__(self, test_case):
@@ -156,7 +172,11 @@ class leak_checker(object):
 
     def _has_shm_files(self):
         gc.collect()
-        names = list('torch_' + str(pid) for pid in self.checked_pids)
+        pids = self.checked_pids
+        if mp.get_sharing_strategy() == 'file_system_pool':
+            # the pool of this process keeps its segments for the next storages
+            pids = pids[1:]
+        names = list('torch_' + str(pid) for pid in pids)
         for filename in os.listdir('/dev/shm'):
             for name in names:
                 if filename.startswith(name):
@@ -270,6 +290,68 @@ class TestMultiprocessing(TestCase):
         with fs_sharing():
             self._test_pool(repeat=TEST_REPEATS)
 
+    @unittest.skipIf(IS_WINDOWS, "file system pool strategy is not supported on Windows")
+    def test_fs_pool_sharing(self):
+        with fs_pool_sharing():
+            x = torch.zeros(5, 5)
+            q = mp.Queue()
+            e = mp.Event()
+            data = [x, x[:, 1]]
+            q.put(data)
+            p = mp.Process(target=simple_fill, args=(q, e))
+            p.daemon = True
+            p.start()
+            e.wait(10)
+            self.assertTrue(e.is_set())
+            self.assertTrue(data[0].eq(4).all())
+            self.assertTrue(data[1].eq(4).all())
+            p.join(1)
+            self.assertFalse(p.is_alive())
+
+            q = mp.Queue()
+            ack = mp.Queue()
+            rounds = 5
+            p = mp.Process(target=send_tensors_in_rounds, args=(q, ack, rounds))
+            p.daemon = True
+            p.start()
+            segments = set()
+            for i in range(rounds):
+                batch = q.get(timeout=10)
+                self.assertEqual(len(batch), 50)
+                for t in batch:
+                    self.assertEqual(t, torch.full((i + 1, 10), i), 0)
+                    segments.add(t.storage()._share_pool_()[1])
+                del batch, t
+                ack.put(None)
+            p.join(10)
+            self.assertFalse(p.is_alive())
+            # the child allocates all of its storages in one segment, which
+            # this process maps only once
+            self.assertEqual(len(segments), 1)
+
+    @unittest.skipIf(IS_WINDOWS, "file system pool strategy is not supported on Windows")
+    def test_fs_pool_preserve_sharing(self):
+        with fs_pool_sharing():
+            self._test_preserve_sharing(repeat=TEST_REPEATS)
+
+    @unittest.skipIf(IS_WINDOWS, "file system pool strategy is not supported on Windows")
+    def test_fs_pool_reuse(self):
+        with fs_pool_sharing():
+            # the memory of freed storages is reused rather than new segments
+            # created
+            segments = set()
+            for _ in range(40):
+                storage = torch.FloatStorage(1 << 18)
+                storage.share_memory_()
+                segments.add(storage._share_pool_()[1])
+                del storage
+            self.assertEqual(len(segments), 1)
+
+    @unittest.skipIf(IS_WINDOWS, "file system pool strategy is not supported on Windows")
+    def test_fs_pool_is_shared(self):
+        with fs_pool_sharing():
+            self._test_is_shared()
+
     @unittest.skipIf(not HAS_SHM_FILES, "don't not how to check if shm files exist")
     def test_fs(self):
         def queue_put():
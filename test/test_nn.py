@@ -2046,6 +2046,50 @@ class TestNN(NNTestCase):
         self._test_EmbeddingBag(False, 'sum', True)
         self._test_EmbeddingBag(False, 'mean', True)
 
+    def test_embedding_bag_many_bags(self):
+        # enough bags to be split across threads, with a weight that is not
+        # contiguous along the embedding dimension and bags of varying size
+        N, D, B = 1000, 37, 3000
+        weight = torch.randn(D, N, dtype=torch.double).t().requires_grad_()
+        lengths = torch.randint(0, 8, (B,), dtype=torch.long)
+        offsets = torch.cat([torch.zeros(1, dtype=torch.long), lengths.cumsum(0)[:-1]])
+        input = torch.randint(N, (int(lengths.sum()),), dtype=torch.long)
+        for mode in ('sum', 'mean', 'max'):
+            output = F.embedding_bag(input, weight, offsets, mode=mode)
+            expected = []
+            for b in range(B):
+                bag = weight[input[offsets[b]:offsets[b] + lengths[b]]]
+                if lengths[b] == 0:
+                    expected.append(torch.zeros(D, dtype=torch.double))
+                elif mode == 'sum':
+                    expected.append(bag.sum(0))
+                elif mode == 'mean':
+                    expected.append(bag.mean(0))
+                else:
+                    expected.append(bag.max(0)[0])
+            self.assertEqual(output, torch.stack(expected))
+
+        for mode in ('sum', 'mean'):
+            dense_weight = weight.detach().contiguous().requires_grad_()
+            sparse_weight = weight.detach().contiguous().requires_grad_()
+            grad_output = torch.randn(B, D, dtype=torch.double)
+            F.embedding_bag(input, dense_weight, offsets, mode=mode).backward(grad_output)
+            F.embedding_bag(input, sparse_weight, offsets, mode=mode, sparse=True).backward(grad_output)
+            self.assertEqual(sparse_weight.grad.to_dense(), dense_weight.grad)
+
+    def test_embedding_bag_half_cpu(self):
+        # half weights are summed in float and rounded once
+        N, D, B = 100, 37, 50
+        weight = torch.randn(N, D).half()
+        lengths = torch.randint(0, 40, (B,), dtype=torch.long)
+        offsets = torch.cat([torch.zeros(1, dtype=torch.long), lengths.cumsum(0)[:-1]])
+        input = torch.randint(N, (int(lengths.sum()),), dtype=torch.long)
+        for mode in ('sum', 'mean', 'max'):
+            output = F.embedding_bag(input, weight, offsets, mode=mode)
+            self.assertEqual(output.dtype, torch.half)
+            expected = F.embedding_bag(input, weight.float(), offsets, mode=mode)
+            self.assertEqual(output.float(), expected.half().float(), 0)
+
     @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
     @repeat_test_for_types(ALL_TENSORTYPES)
     def test_embedding_bag_cuda(self, dtype=torch.float):
@@ -2079,6 +2123,35 @@ class TestNN(NNTestCase):
         input = torch.Tensor(1000)
         self._test_dropout(nn.Dropout, input)
 
+    def _test_fused_dropout(self, device):
+        p = 0.3
+        # 1001 elements leave a partly used last byte in the mask
+        input = torch.randn(7, 143, device=device, requires_grad=True)
+        output, mask = torch._fused_dropout(input, p)
+        self.assertEqual(mask.dtype, torch.uint8)
+        self.assertEqual(mask.numel(), (input.numel() + 7) // 8)
+
+        bits = torch.arange(8, device=device, dtype=torch.uint8)
+        keep = ((mask.unsqueeze(1) >> bits) & 1).view(-1)[:input.numel()].view_as(input)
+        expected = input.detach() * keep.type_as(input) / (1 - p)
+        self.assertEqual(output, expected)
+        self.assertLess(abs(keep.double().mean() - (1 - p)), 0.05)
+
+        grad = torch.randn_like(input)
+        output.backward(grad)
+        self.assertEqual(input.grad, grad * keep.type_as(input) / (1 - p))
+
+        # input without autograd goes through dropout() too
+        output = F.dropout(input.detach(), p, training=True)
+        self.assertEqual((output != 0).double().mean(), 1 - p, 0.05)
+
+    def test_fused_dropout(self):
+        self._test_fused_dropout('cpu')
+
+    @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
+    def test_fused_dropout_cuda(self):
+        self._test_fused_dropout('cuda')
+
     def test_Dropout2d(self):
         b = random.randint(1, 5)
         w = random.randint(1, 5)
@@ -2300,6 +2373,32 @@ class TestNN(NNTestCase):
         self._test_LayerNorm_general("cuda")
         self._test_LayerNorm_cuda_half()
 
+    def _test_LayerNorm_large_mean(self, device="cpu"):
+        # the statistics are accumulated in one pass, which must not lose the
+        # variance of rows whose mean is large compared to their spread
+        x = torch.randn(7, 67, device=device, dtype=torch.double).add_(1e4).float()
+        weight = torch.randn(67, device=device)
+        bias = torch.randn(67, device=device)
+        output = F.layer_norm(x, (67,), weight, bias, eps=1e-5)
+        x_double = x.double()
+        mean = x_double.mean(-1, keepdim=True)
+        var = x_double.var(-1, unbiased=False, keepdim=True)
+        expected = (x_double - mean) / (var + 1e-5).sqrt() * weight.double() + bias.double()
+        self.assertEqual(output.double(), expected, prec=1e-3)
+
+        x = torch.randn(3, 5, 9, device=device, dtype=torch.double, requires_grad=True)
+        weight = torch.randn(5, 9, device=device, dtype=torch.double, requires_grad=True)
+        bias = torch.randn(5, 9, device=device, dtype=torch.double, requires_grad=True)
+        _assertGradAndGradgradChecks(
+            self, lambda x, w, b: F.layer_norm(x, (5, 9), w, b), (x, weight, bias))
+
+    def test_LayerNorm_large_mean(self):
+        self._test_LayerNorm_large_mean()
+
+    @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
+    def test_LayerNorm_large_mean_cuda(self):
+        self._test_LayerNorm_large_mean("cuda")
+
     def _test_GroupNorm_general(self, device="cpu", dtype=torch.float):
         good_shape_g = {
             (1, 2, 3, 4): 2,
@@ -2558,6 +2657,56 @@ class TestNN(NNTestCase):
     def test_max_pool_nan(self, dtype=torch.float):
         self._test_max_pool_nan(self, device="cpu")
 
+    def _test_channels_last(self, fn, input):
+        # the CPU kernels run channels-last inputs, contiguous in (N, H, W, C)
+        # order, without making them contiguous, and return channels-last
+        # outputs and gradients
+        channels_last = input.permute(0, 2, 3, 1).contiguous().permute(0, 3, 1, 2)
+        x = input.clone().requires_grad_()
+        x_cl = channels_last.clone().requires_grad_()
+        out = fn(x)
+        out_cl = fn(x_cl)
+        self.assertTrue(out_cl.permute(0, 2, 3, 1).is_contiguous())
+        self.assertEqual(out, out_cl)
+        grad = torch.randn_like(out)
+        out.backward(grad)
+        out_cl.backward(grad)
+        self.assertEqual(x.grad, x_cl.grad)
+
+    def test_pooling_channels_last(self):
+        # enough channels for the vectorized loops to have a remainder
+        input = torch.randn(2, 19, 9, 8, dtype=torch.double)
+        for ceil_mode in [False, True]:
+            self._test_channels_last(
+                lambda x: F.max_pool2d(x, 3, 2, 1, ceil_mode=ceil_mode), input)
+            self._test_channels_last(
+                lambda x: F.max_pool2d(x, 2, 1, 0, dilation=2, ceil_mode=ceil_mode), input)
+            for count_include_pad in [False, True]:
+                self._test_channels_last(
+                    lambda x: F.avg_pool2d(x, 3, 2, 1, ceil_mode, count_include_pad), input)
+        x = input.permute(0, 2, 3, 1).contiguous().permute(0, 3, 1, 2).requires_grad_()
+        gradcheck(lambda x: F.max_pool2d(x, 3, 2, 1), [x])
+        gradcheck(lambda x: F.avg_pool2d(x, 3, 2, 1), [x])
+
+    def test_pooling_channels_last_nan(self):
+        x = torch.randn(1, 2, 3, 3).permute(0, 2, 3, 1).contiguous().permute(0, 3, 1, 2)
+        x[0, 1, 1, 1] = nan
+        out, indices = F.max_pool2d(x, 3, return_indices=True)
+        self.assertFalse(math.isnan(out[0, 0].item()))
+        self.assertTrue(math.isnan(out[0, 1].item()))
+        self.assertEqual(indices[0, 1].item(), 4)
+
+    def test_upsampling_channels_last(self):
+        input = torch.randn(2, 19, 5, 7, dtype=torch.double)
+        for size in [(10, 14), (3, 4), (5, 7)]:
+            self._test_channels_last(lambda x: F.upsample(x, size, mode='nearest'), input)
+            for align_corners in [False, True]:
+                self._test_channels_last(
+                    lambda x: F.upsample(x, size, mode='bilinear', align_corners=align_corners), input)
+        x = input.permute(0, 2, 3, 1).contiguous().permute(0, 3, 1, 2).requires_grad_()
+        gradcheck(lambda x: F.upsample(x, (8, 9), mode='nearest'), [x])
+        gradcheck(lambda x: F.upsample(x, (8, 9), mode='bilinear', align_corners=False), [x])
+
     def _test_scatter(self, tensor):
         x = torch.tensor(tensor, requires_grad=True)
         result = dp.scatter(x, (0, 1))
@@ -2827,6 +2976,32 @@ class TestNN(NNTestCase):
             dp.data_parallel(l, i, (0, 1))
         self.assertRaises(AssertionError, lambda: dp.data_parallel(l, i, (0, 1)))
 
+    @unittest.skipIf(not TEST_MULTIGPU, "multi-GPU not supported")
+    def test_data_parallel_cached_replicas(self):
+        l = nn.Sequential(nn.Linear(10, 5), nn.BatchNorm1d(5)).cuda().eval()
+        i = torch.randn(20, 10, device='cuda')
+        net = nn.DataParallel(l, device_ids=[0, 1], cache_replicas=True)
+        with torch.no_grad():
+            self.assertEqual(net(i), l(i))
+            replicas = net.replicate(l, [0, 1])
+            self.assertIs(net.replicate(l, [0, 1])[1], replicas[1])
+
+            # In-place updates of parameters and buffers are picked up.
+            l[0].weight.add_(1)
+            l[1].running_mean.fill_(0.5)
+            self.assertEqual(net(i), l(i))
+            self.assertIs(net.replicate(l, [0, 1])[1], replicas[1])
+
+            # So are replaced parameters and changed attributes.
+            l[0].bias = nn.Parameter(torch.randn(5, device='cuda'))
+            l[1].eps = 0.5
+            self.assertEqual(net(i), l(i))
+
+        # Forward passes with gradients don't use the cache.
+        self.assertEqual(net(i), l(i))
+        with torch.no_grad():
+            self.assertIsNot(net.replicate(l, [0, 1])[1], replicas[1])
+
     @unittest.skipIf(not TEST_MULTIGPU, "multi-GPU not supported")
     def test_data_parallel(self):
         l = nn.Linear(10, 5).float().cuda()
@@ -3306,6 +3481,28 @@ class TestNN(NNTestCase):
         self.assertRaisesRegex(RuntimeError, 'Specify retain_graph=True',
                                lambda: o1.sum().backward())
 
+    def test_thnn_conv2d_num_threads(self):
+        # batches smaller than the number of threads go through a single GEMM
+        # over all the frames instead of one GEMM per frame
+        num_threads = torch.get_num_threads()
+        input = torch.randn(3, 4, 7, 6, dtype=torch.double)
+        weight = torch.randn(5, 4, 3, 2, dtype=torch.double)
+        bias = torch.randn(5, dtype=torch.double)
+        try:
+            results = []
+            for threads in [1, 8]:
+                torch.set_num_threads(threads)
+                x = input.clone().requires_grad_()
+                w = weight.clone().requires_grad_()
+                b = bias.clone().requires_grad_()
+                out = torch._C._nn.thnn_conv2d(x, w, (3, 2), b, (2, 1), (1, 1))
+                out.backward(torch.arange(out.numel(), dtype=torch.double).view_as(out))
+                results.append((out.detach(), x.grad, w.grad, b.grad))
+        finally:
+            torch.set_num_threads(num_threads)
+        for per_frame, batched in zip(*results):
+            self.assertEqual(per_frame, batched)
+
     @unittest.skipIf(not TEST_CUDA, 'CUDA not available')
     @repeat_test_for_types(ALL_TENSORTYPES)
     def test_Conv2d_large_workspace(self, dtype=torch.float):
@@ -4766,6 +4963,26 @@ class TestNN(NNTestCase):
         self.assertEqual(F.margin_ranking_loss(input1, input2, target, margin=0.5, reduction='none'),
                          loss_reference_fns['MarginRankingLoss'](input1, input2, target, margin=0.5, reduction='none'))
 
+    def test_cross_entropy_gives_same_result_as_log_softmax_and_nll_loss(self):
+        for n, c in [(8, 5), (4, 3000)]:
+            input = torch.randn(n, c, dtype=torch.double, requires_grad=True)
+            target = torch.randint(c, (n,), dtype=torch.long)
+            target[0] = -100
+            for reduction in ['none', 'elementwise_mean', 'sum']:
+                expected = F.nll_loss(F.log_softmax(input, 1), target, reduction=reduction)
+                self.assertEqual(F.cross_entropy(input, target, reduction=reduction), expected)
+                grad, = torch.autograd.grad(expected.sum(), input)
+                fused_grad, = torch.autograd.grad(
+                    F.cross_entropy(input, target, reduction=reduction).sum(), input)
+                self.assertEqual(fused_grad, grad)
+
+        input = torch.randn(5, 4, dtype=torch.double, requires_grad=True)
+        target = torch.tensor([0, 3, 1, 1, 2])
+        for reduction in ['none', 'elementwise_mean', 'sum']:
+            fn = lambda i: F.cross_entropy(i, target, reduction=reduction, ignore_index=1)
+            self.assertTrue(gradcheck(fn, (input,)))
+            self.assertTrue(gradgradcheck(fn, (input,)))
+
     def test_triplet_margin_loss(self):
         input1 = torch.randn(5, 10, requires_grad=True)
         input2 = torch.randn(5, 10, requires_grad=True)
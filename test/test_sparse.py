@@ -444,6 +444,22 @@ class TestSparse(TestCase):
         test_shape(10, 100, 100)
         test_shape(100, 1000, 200)
         test_shape(64, 10000, 300)
+        test_shape(100, 1000, 1)
+
+    @cpu_only
+    def test_mm_coalesced_reuse(self):
+        x = self._gen_sparse(2, 20, [10, 30])[0].coalesce()
+        y = torch.randn(30, 5)
+        expected = torch.mm(self.safeToDense(x), y)
+        self.assertEqual(torch.mm(x, y), expected)
+        self.assertEqual(torch.mm(x, y), expected)
+
+        v = torch.randn(30, 1)
+        self.assertEqual(torch.mm(x, v), torch.mm(self.safeToDense(x), v))
+
+        # new indices must not reuse the layout of the previous products
+        x.add_(self._gen_sparse(2, 20, [10, 30])[0].coalesce())
+        self.assertEqual(torch.mm(x, y), torch.mm(self.safeToDense(x), y))
 
     @cpu_only
     def test_saddmm(self):
@@ -887,6 +903,24 @@ class TestSparse(TestCase):
 
         self.assertFalse(z._indices().numel() != 2 and z.is_coalesced())
 
+    def test_coalesce_sorted_and_duplicate(self):
+        # sorted and unique, sorted with duplicates and unsorted indices
+        for rows in ([0, 1, 3, 4], [0, 1, 1, 3, 3, 3], [4, 0, 3, 0, 2, 4]):
+            i = self.IndexTensor([rows, [r % 2 for r in rows]])
+            v = self.ValueTensor(len(rows), 3).normal_()
+            x = self.SparseTensor(i, v, torch.Size([5, 2, 3]))
+            y = x.coalesce()
+            self.assertTrue(y.is_coalesced())
+            self.assertEqual(self.safeToDense(y), self.safeToDense(x))
+            linear = y._indices()[0] * 2 + y._indices()[1]
+            self.assertTrue((linear[1:] > linear[:-1]).all())
+
+    def test_coalesce_large(self):
+        x = self._gen_sparse(2, 100000, [300, 400])[0]
+        y = x.coalesce()
+        self.assertTrue(y.is_coalesced())
+        self.assertEqual(self.safeToDense(y), self.safeToDense(x))
+
     @cuda_only
     def test_storage_not_null(self):
         x = torch.cuda.sparse.FloatTensor(2)
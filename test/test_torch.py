@@ -1047,6 +1047,21 @@ class TestTorch(TestCase):
 
         # [res] torch.add([res,] tensor1, value, tensor2)
 
+    def test_add_overloads_repeated(self):
+        # the parser remembers the overload the last call with the same kinds
+        # of arguments matched, so alternate between them
+        x = torch.randn(5)
+        y = torch.randn(5)
+        for _ in range(3):
+            self.assertEqual(torch.add(x, y), x + y)
+            self.assertEqual(torch.add(x, 2), x + 2)
+            self.assertEqual(torch.add(x, 2, y), x + 2 * y)
+            self.assertEqual(torch.add(x, torch.tensor(2.)), x + 2)
+            z = torch.tensor(2., requires_grad=True)
+            self.assertTrue(torch.add(x, z).requires_grad)
+            self.assertEqual(x.add(torch.tensor(3)), x + 3)
+            self.assertEqual(x.add(y, alpha=2), x + 2 * y)
+
     def test_csub(self):
         # with a tensor
         a = torch.randn(100, 90)
@@ -1323,6 +1338,29 @@ class TestTorch(TestCase):
             r = torch.mm(b1[i], b2[i])
             self.assertEqual(r, res[i])
 
+    def test_bmm_small_and_strided(self):
+        # small matrices are multiplied directly, larger ones with a batched
+        # GEMM if every matrix is laid out alike, and one GEMM each otherwise
+        for M, N, O in [(3, 3, 3), (4, 4, 4), (3, 3, 1), (4, 4, 1), (2, 7, 5), (1, 1, 1), (3, 0, 2),
+                        (23, 8, 12), (1, 9, 1), (9, 1, 9)]:
+            for transpose1, transpose2 in product([False, True], repeat=2):
+                b1 = torch.randn(50, M, N, dtype=torch.double)
+                b2 = torch.randn(50, N, O, dtype=torch.double)
+                if transpose1:
+                    b1 = b1.transpose(1, 2).contiguous().transpose(1, 2)
+                if transpose2:
+                    b2 = b2.transpose(1, 2).contiguous().transpose(1, 2)
+                expected = torch.stack([torch.mm(b1[i], b2[i]) for i in range(50)])
+                self.assertEqual(torch.bmm(b1, b2), expected)
+                strided = torch.stack([torch.mm(b1[2 * i], b2[2 * i + 1]) for i in range(25)])
+                self.assertEqual(torch.bmm(b1[::2], b2[1::2]), strided)
+
+                res = torch.full((50, M, O), nan, dtype=torch.double)
+                # beta == 0 ignores the NaNs of res, like BLAS
+                self.assertEqual(torch.baddbmm(0, res, 2, b1, b2), expected * 2)
+                res = torch.randn(50, M, O, dtype=torch.double)
+                self.assertEqual(res.clone().baddbmm_(.5, 2, b1, b2), res * .5 + expected * 2)
+
     def test_addbmm(self):
         # num_batches = 10
         # M, N, O = 12, 8, 5
@@ -2891,6 +2929,29 @@ class TestTorch(TestCase):
     def test_contiguous(self):
         return self._test_contiguous(self, lambda t: t)
 
+    @staticmethod
+    def _test_permute_contiguous(self, cast):
+        def check(x, *dims):
+            y = x.permute(*dims)
+            # the reference copies element by element through a list
+            expected = torch.tensor(y.tolist(), dtype=y.dtype, device=y.device)
+            self.assertEqual(y.contiguous(), expected, 0)
+            self.assertEqual(torch.empty_like(y).copy_(y), expected, 0)
+
+        for dtype in [torch.uint8, torch.int16, torch.float, torch.double]:
+            x = cast(torch.arange(2 * 30 * 17 * 9).view(2, 30, 17, 9).to(dtype))
+            check(x, 0, 2, 3, 1)  # NCHW -> NHWC
+            check(x, 0, 3, 1, 2)  # NHWC -> NCHW
+            check(x, 0, 2, 1, 3)  # [B, T, H, D] -> [B, H, T, D]
+            check(x, 3, 2, 1, 0)
+            check(x[:, ::2, :, 1:], 1, 0, 3, 2)
+            check(x[0], 1, 0, 2)
+            check(x.view(60, 153), 1, 0)
+            check(x[:, :1], 3, 1, 2, 0)
+
+    def test_permute_contiguous(self):
+        self._test_permute_contiguous(self, lambda t: t)
+
     def test_empty_tensor_props(self):
         sizes = [(0,)]
         if torch._C._use_zero_size_dim():
@@ -3155,6 +3216,23 @@ class TestTorch(TestCase):
         # Test that we still have proper sorting with duplicate keys
         self.assertIsOrdered('descending', x, res2val, res2ind, 'random with duplicate keys')
 
+    def test_sort_large_slices(self):
+        # Integer slices this long are radix sorted, which is stable, and
+        # there are enough slices to sort them in parallel
+        for dtype in (torch.uint8, torch.int8, torch.int16, torch.int32, torch.int64):
+            x = torch.randint(0, 100, (300, 2000), dtype=dtype)
+            for dim in (0, 1):
+                for descending in (False, True):
+                    values, indices = x.sort(dim, descending)
+                    self.assertEqual(values, x.gather(dim, indices), 0)
+                    order = -1 if descending else 1
+                    diff = (values.narrow(dim, 1, values.size(dim) - 1).long() -
+                            values.narrow(dim, 0, values.size(dim) - 1).long()) * order
+                    self.assertTrue((diff >= 0).all())
+                    index_diff = (indices.narrow(dim, 1, indices.size(dim) - 1) -
+                                  indices.narrow(dim, 0, indices.size(dim) - 1))
+                    self.assertTrue(((diff > 0) | (index_diff > 0)).all())
+
     def test_topk(self):
         def topKViaSort(t, k, dim, dir):
             sorted, indices = t.sort(dim, dir)
@@ -3212,6 +3290,28 @@ class TestTorch(TestCase):
         self.assertEqual(top1, top2)
         self.assertEqual(idx1, idx2)
 
+    @unittest.skipIf(not torch.cuda.is_available(), 'no CUDA')
+    def test_sort_gpu(self):
+        # Many short slices (sorted several per block), slices longer than
+        # the in-place sort supports (segmented radix sort), and slices that
+        # are not innermost
+        for size, dim in (((1000, 17), 1), ((7, 5000), 1), ((5000, 3), 0)):
+            x = torch.randn(*size)
+            for descending in (False, True):
+                cpu_val, cpu_ind = x.sort(dim, descending)
+                gpu_val, gpu_ind = x.cuda().sort(dim, descending)
+                self.assertEqual(cpu_val, gpu_val.cpu(), 0)
+                self.assertEqual(cpu_ind, gpu_ind.cpu(), 0)
+
+    @unittest.skipIf(not torch.cuda.is_available(), 'no CUDA')
+    def test_topk_large_k_gpu(self):
+        x = torch.randn(5, 5000)
+        for k in (100, 3000, 5000):
+            cpu_val, cpu_ind = x.topk(k, 1, True, True)
+            gpu_val, gpu_ind = x.cuda().topk(k, 1, True, True)
+            self.assertEqual(cpu_val, gpu_val.cpu(), 0)
+            self.assertEqual(cpu_ind, gpu_ind.cpu(), 0)
+
     def test_kthvalue(self):
         SIZE = 50
         x = torch.rand(SIZE, SIZE, SIZE)
@@ -3693,6 +3793,23 @@ class TestTorch(TestCase):
     def test_gesv_batched(self):
         self._test_gesv_batched(self, lambda t: t)
 
+    @skipIfNoLapack
+    def test_gesv_batched_small(self):
+        # systems of up to 4 unknowns are solved without LAPACK
+        for n in [1, 2, 3, 4]:
+            A = torch.randn(100, n, n, dtype=torch.double)
+            b = torch.randn(100, n, 3, dtype=torch.double)
+            x, LU = torch.gesv(b, A)
+            self.assertEqual(torch.matmul(A, x), b)
+            for i in [0, 57, 99]:
+                x_exp, LU_exp = torch.gesv(b[i], A[i])
+                self.assertEqual(x[i], x_exp)
+                self.assertEqual(LU[i], LU_exp)
+
+        A = torch.randn(3, 3, 3, dtype=torch.double)
+        A[1, :, 1] = 0
+        self.assertRaisesRegex(RuntimeError, 'For batch 1', lambda: torch.gesv(torch.randn(3, 3, 1), A))
+
     @staticmethod
     def _test_gesv_batched_dims(self, cast):
         if not TEST_NUMPY:
@@ -4202,6 +4319,19 @@ class TestTorch(TestCase):
         self.assertFalse(MII.is_contiguous(), 'MII is contiguous')
         self.assertEqual(MII, MI, 0, 'inverse value in-place')
 
+    @skipIfNoLapack
+    def test_inverse_batched(self):
+        for n in [3, 4, 7]:
+            M = torch.randn(2, 10, n, n, dtype=torch.double)
+            MI = torch.inverse(M)
+            self.assertEqual(MI.size(), M.size())
+            self.assertEqual(torch.matmul(M, MI), torch.eye(n, dtype=torch.double).expand_as(M))
+            self.assertEqual(MI[1, 3], torch.inverse(M[1, 3]))
+            MII = torch.empty(0, dtype=torch.double)
+            torch.inverse(M, out=MII)
+            self.assertEqual(MII, MI, 0)
+        self.assertEqual(torch.inverse(torch.randn(0, 3, 3)).size(), (0, 3, 3))
+
     @staticmethod
     def _test_pinverse(self, conv_fn):
         def run_test(M):
@@ -4463,6 +4593,33 @@ class TestTorch(TestCase):
     def test_fft_ifft_rfft_irfft(self):
         self._test_fft_ifft_rfft_irfft(self)
 
+    @unittest.skipIf(not TEST_MKL, "PyTorch is built without MKL support")
+    def test_fft_plan_reuse(self):
+        # transforms of the same signal sizes with another batch size, other
+        # strides, other flags or another number of threads must not run with
+        # the cached plan of the previous ones
+        x = torch.randn(600, 8, 2, dtype=torch.double)
+        num_threads = torch.get_num_threads()
+        try:
+            for _ in range(2):
+                for threads in [1, 4]:
+                    torch.set_num_threads(threads)
+                    for batch in [600, 3, 1]:
+                        transposed = x.transpose(0, 1).contiguous().transpose(0, 1)
+                        for input in [x[:batch], x[:batch * 2:2], transposed[:batch]]:
+                            real = input.select(-1, 0)
+                            expected = input.contiguous()
+                            expected_real = real.contiguous()
+                            self.assertEqual(input.fft(1), expected.fft(1), 1e-12)
+                            self.assertEqual(input.fft(1, normalized=True), expected.fft(1, normalized=True), 1e-12)
+                            self.assertEqual(input.ifft(1), expected.ifft(1), 1e-12)
+                            self.assertEqual(real.rfft(1), expected_real.rfft(1), 1e-12)
+                            self.assertEqual(real.rfft(1, onesided=False), expected_real.rfft(1, onesided=False), 1e-12)
+                            self.assertEqual(input[:, :5].irfft(1, signal_sizes=(8,)),
+                                             expected[:, :5].contiguous().irfft(1, signal_sizes=(8,)), 1e-12)
+        finally:
+            torch.set_num_threads(num_threads)
+
     @staticmethod
     def _test_stft(self, device='cpu'):
         if not TEST_LIBROSA:
@@ -6872,6 +7029,38 @@ class TestTorch(TestCase):
         self.assertEqual(r[:, :50].std(), 4, 0.3)
         self.assertEqual(r[:, 50:].std(), 1, 0.2)
 
+    def test_random_fill_num_threads(self):
+        # large contiguous fills run in parallel and must not depend on the
+        # number of threads; 100003 leaves a tail for the normal fill
+        num_threads = torch.get_num_threads()
+        try:
+            results = []
+            for threads in [1, 4]:
+                torch.set_num_threads(threads)
+                torch.manual_seed(123)
+                results.append((torch.rand(100003),
+                                torch.randn(100003),
+                                torch.DoubleTensor(100003).normal_(2, 3),
+                                torch.ByteTensor(100003).bernoulli_(0.3)))
+        finally:
+            torch.set_num_threads(num_threads)
+        for first, second in zip(*results):
+            self.assertEqual(first, second, 0)
+
+        uniform, normal, double_normal, bernoulli = results[0]
+        self.assertTrue(uniform.min() >= 0 and uniform.max() < 1)
+        self.assertEqual(uniform.mean(), 0.5, 0.01)
+        self.assertEqual(normal.mean(), 0, 0.02)
+        self.assertEqual(normal.std(), 1, 0.02)
+        self.assertEqual(double_normal.mean(), 2, 0.05)
+        self.assertEqual(double_normal.std(), 3, 0.05)
+        self.assertEqual(bernoulli.double().mean(), 0.3, 0.01)
+
+        # the same seed gives the same fill, a new draw gives a new one
+        torch.manual_seed(123)
+        self.assertEqual(torch.rand(100003), uniform, 0)
+        self.assertNotEqual(torch.rand(100003), uniform)
+
     def test_parsing_int64(self):
         # accepts integer arguments
         x = torch.cumsum(torch.ones(5, 5), 0)
@@ -7056,6 +7245,40 @@ class TestTorch(TestCase):
             xh2 = torch.load(f)
             self.assertEqual(xh.float(), xh2.float())
 
+    def test_half_tensor_cpu_ops(self):
+        # CPU half tensors are computed in float and rounded to half once
+        xh = torch.randn(37, 53).half()
+        yh = (torch.rand(37, 53) + 0.5).half()
+        xf, yf = xh.float(), yh.float()
+        for op in (torch.add, torch.sub, torch.mul, torch.div):
+            self.assertEqual(op(xh, yh).float(), op(xf, yf).half().float(), 0)
+            self.assertEqual(op(xh, yh[:, :1]).float(), op(xf, yf[:, :1]).half().float(), 0)
+            self.assertEqual(op(xh.t(), yh.t()).float(), op(xf.t(), yf.t()).half().float(), 0)
+        for op in (torch.sigmoid, torch.tanh, torch.floor, torch.sqrt):
+            self.assertEqual(op(yh).float(), op(yf).half().float(), 1e-3)
+
+        self.assertEqual(xh.sum().float(), xf.sum(), 5e-2)
+        self.assertEqual(xh.sum(0).float(), xf.sum(0), 1e-2)
+        self.assertEqual(xh.sum(1).float(), xf.sum(1), 1e-2)
+        self.assertEqual(yh[:4, :5].contiguous().prod().float(), yf[:4, :5].prod(), 1e-2)
+        # half accumulators would stop at 2048
+        self.assertEqual(torch.ones(10000).half().sum().item(), 10000)
+        self.assertEqual(torch.ones(3000, 3).half().sum(0).float(), torch.full((3,), 3000), 0)
+        self.assertEqual(torch.zeros(3, 4, dtype=torch.half).float(), torch.zeros(3, 4), 0)
+
+    def test_copy_large(self):
+        # large enough to be split across threads
+        x = torch.randn(1000, 700)
+        xh = x.half()
+        self.assertEqual(xh.float(), x, 1e-3)
+        self.assertEqual(torch.empty(1000, 700).copy_(xh), xh.float(), 0)
+        self.assertEqual(x.t().half().float(), x.t(), 1e-3)
+        self.assertEqual(x.t().contiguous(), torch.from_numpy(x.numpy().T.copy()), 0)
+        self.assertEqual(xh.t().contiguous().float(), x.t().half().float(), 0)
+        self.assertEqual(x.double()[:, ::3].float(), x[:, ::3], 0)
+        self.assertEqual(x.t().long(), torch.tensor(x.numpy().T.astype('int64')), 0)
+        self.assertEqual(x.byte().t().contiguous(), x.t().byte(), 0)
+
     def test_serialize_device(self):
         device_str = ['cpu', 'cpu:0', 'cuda', 'cuda:0']
         device_obj = [torch.device(d) for d in device_str]
@@ -7662,6 +7885,22 @@ class TestTorch(TestCase):
         z = from_dlpack(to_dlpack(x))
         self.assertEqual(z, x)
 
+    @unittest.skipIf(not torch.cuda.is_available(), "No CUDA")
+    def test_dlpack_cuda_stream(self):
+        # the consumer's stream waits for the producer's one through the
+        # event carried by the capsule
+        producer = torch.cuda.Stream()
+        consumer = torch.cuda.Stream()
+        with torch.cuda.stream(producer):
+            x = torch.randn(1000, 1000, device='cuda').mm(torch.ones(1000, 1000, device='cuda'))
+        capsule = to_dlpack(x, producer)
+        self.assertIsNotNone(torch._C._dlpack_event(capsule))
+        z = from_dlpack(capsule, consumer)
+        with torch.cuda.stream(consumer):
+            y = z.sum()
+        consumer.synchronize()
+        self.assertEqual(y, x.sum(), prec=1e-1)
+
     @unittest.skipIf(not TEST_NUMPY, "Numpy not found")
     def test_from_numpy(self):
         dtypes = [
@@ -7714,6 +7953,10 @@ class TestTorch(TestCase):
         x.strides = (3,)
         self.assertRaises(ValueError, lambda: torch.from_numpy(x))
 
+        # check non-native byte order raises exception
+        x = np.array([3., 5., 8.], dtype=np.dtype(np.float64).newbyteorder())
+        self.assertRaises(ValueError, lambda: torch.from_numpy(x))
+
     @unittest.skipIf(not TEST_NUMPY, "Numpy not found")
     def test_ctor_with_numpy_array(self):
         dtypes = [
@@ -8117,6 +8360,20 @@ class TestTorch(TestCase):
         self.assertEqual(torch.ByteTensor([7, 42, 128, 133]), byte_unique)
         self.assertEqual(torch.LongTensor([3, 0, 0, 0, 1, 2]), byte_inverse)
 
+    @unittest.skipIf(not TEST_NUMPY, "Numpy not found")
+    def test_unique_large(self):
+        # Large enough to be sorted and written out in several chunks
+        for dtype in (torch.long, torch.int, torch.double):
+            x = torch.randint(-1000, 1000, (200000,), dtype=dtype)
+            expected_unique, expected_inverse = np.unique(
+                x.numpy(), return_inverse=True)
+            x_unique, x_inverse = torch.unique(
+                x, sorted=True, return_inverse=True)
+            self.assertEqual(torch.from_numpy(expected_unique), x_unique)
+            self.assertEqual(
+                torch.from_numpy(expected_inverse).long(), x_inverse)
+            self.assertEqual(x_unique, torch.unique(x, sorted=True))
+
     @staticmethod
     def _test_bincount(self, device):
         # negative input throws
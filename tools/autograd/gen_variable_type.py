@@ -52,6 +52,8 @@ RENAME_TRACE = {
     's_native_sub': 'sub',
     'th_mul': 'mul',
     's_native_mul': 'mul',
+    'th_div': 'div',
+    's_native_div': 'div',
     'th_addmm': 'addmm',
     's_native_addmm': 'addmm',
 }
@@ -101,7 +103,7 @@ if (compute_requires_grad( ${args_with_derivatives} )) {
 """)
 
 ASSIGN_GRAD_FN = CodeTemplate("""\
-grad_fn = std::shared_ptr<${op}>(new ${op}(${op_ctor}), deleteFunction);
+grad_fn = std::shared_ptr<${op}>(new ${op}(${op_ctor}), deleteFunction, SmallObjectAllocator<${op}>());
 grad_fn->set_next_edges(collect_next_edges( ${args_with_derivatives} ));
 """)
 
@@ -182,6 +184,8 @@ def should_trace(declaration):
         return False
     if base_name == 'mul' and overload == ['Tensor', 'Tensor', 'Scalar']:
         return False
+    if base_name == 'div' and overload == ['Tensor', 'Tensor']:
+        return False
     if base_name == 'addmm' and overload == ['Tensor', 'Tensor', 'Tensor', 'Scalar', 'Scalar']:
         return False
     return True
@@ -739,6 +739,28 @@ Tensor log_softmax_double_backward(const Tensor & grad, const Tensor & grad_outp
   return z * grad_output.sum(dim, true) * ((grad * z).sum(dim, true) - grad);
 }
 
+Tensor cross_entropy_double_backward_grad_output(const Tensor & grad, const Tensor & input, const Tensor & target, const Tensor & logsumexp, int64_t reduction, int64_t ignore_index) {
+  auto output = (grad * at::_cross_entropy_backward(at::ones({input.size(0)}, input.type()), input, target, logsumexp, Reduction::None, ignore_index)).sum(1);
+  if (reduction == Reduction::ElementwiseMean) {
+    return output.sum() / target.ne(ignore_index).sum().type_as(output);
+  } else if (reduction == Reduction::Sum) {
+    return output.sum();
+  }
+  return output;
+}
+
+// The logsumexp saved by the forward is a function of input, its dependence
+// is folded in here rather than differentiated separately.
+Tensor cross_entropy_double_backward(const Tensor & grad, const Tensor & grad_output, const Tensor & input, const Tensor & target, const Tensor & logsumexp, int64_t reduction, int64_t ignore_index) {
+  auto scale = target.ne(ignore_index).type_as(input);
+  if (reduction == Reduction::ElementwiseMean) {
+    scale = scale / scale.sum();
+  }
+  scale = (scale * grad_output).unsqueeze(1);
+  auto z = (input - logsumexp.unsqueeze(1)).exp();
+  return scale * z * (grad - (grad * z).sum(1, true));
+}
+
 Tensor l1_loss_double_backward_grad_output(const Tensor & grad, const Tensor & input, const Tensor & target, int64_t reduction) {
   auto output = l1_loss_backward(grad, input, target, Reduction::None);
   if (reduction == Reduction::ElementwiseMean) {
@@ -1375,6 +1397,32 @@ std::tuple<Tensor, Tensor> atan2_backward(const Tensor& grad, const Tensor& self
             output_mask[1] ? grad * -self * recip : Tensor() };
 }
 
+// The fused kernel is used unless the graph of the backward is recorded for a
+// double backward. Then the same formula is composed from differentiable ops,
+// with the moments recomputed from input rather than taken from the forward.
+std::tuple<Tensor, Tensor, Tensor> layer_norm_backward(const Tensor & grad, const Tensor & input, const Tensor & mean, const Tensor & rstd, const Tensor & weight, int64_t M, int64_t N, double eps, std::array<bool, 3> output_mask) {
+  if (!GradMode::is_enabled()) {
+    return at::_layer_norm_backward(grad, input, mean, rstd, weight, M, N, output_mask);
+  }
+  auto x = input.contiguous().view({M, N});
+  auto dy = grad.contiguous().view({M, N});
+  auto x_centered = x - x.mean(1, true);
+  auto r = (x_centered.pow(2).mean(1, true) + eps).rsqrt();
+  auto x_hat = x_centered * r;
+  Tensor grad_input, grad_weight, grad_bias;
+  if (output_mask[0]) {
+    auto g = weight.defined() ? dy * weight : dy;
+    grad_input = (r * (g - g.mean(1, true) - x_hat * (g * x_hat).mean(1, true))).view(input.sizes());
+  }
+  if (output_mask[1]) {
+    grad_weight = (dy * x_hat).sum(0);
+  }
+  if (output_mask[2]) {
+    grad_bias = dy.sum(0);
+  }
+  return std::make_tuple(grad_input, grad_weight, grad_bias);
+}
+
 // TODO: Seriously consider writing the derivative formulas for
 // each output separately; there is not all that much sharing
 // of computation going on here.
@@ -127,6 +127,11 @@ const auto options = TensorOptions()
 auto result = torch::${name}(${args}, options);
 """)
 
+CALL_OUT = CodeTemplate("""\
+DeviceGuard device_guard(deviceForInputs(stack, ${num_dynamic_inputs}));
+auto result = at::${name}(${args});
+""")
+
 CONSTRUCTOR = CodeTemplate("""\
 [](Node *node) {
   ${kw_assignments}
@@ -141,6 +146,23 @@ CONSTRUCTOR = CodeTemplate("""\
 }
 """)
 
+# out variants take the tensor to write to as an extra input after the
+# regular ones, and return it
+OUT_CONSTRUCTOR = CodeTemplate("""\
+[](Node *node) {
+  ${kw_assignments}
+  return Operation([=](Stack & stack) {
+    autograd::profiler::RecordFunction record("${name}");
+    auto out = pop(stack).toTensor();
+    ${pos_assignments}
+    ${call}
+    drop(stack, ${num_dynamic_inputs});
+    pack(stack, std::move(result));
+    return 0;
+  });
+}
+""")
+
 OPERATOR = CodeTemplate("""\
 Operator(
     "${signature}",
@@ -191,6 +213,40 @@ def is_tensor_arg(arg):
     return arg['simple_type'] in {'Tensor', 'TensorList'}
 
 
+def out_variant_key(name, arguments):
+    return (name,) + tuple((arg['name'], arg['simple_type']) for arg in arguments
+                           if not arg.get('output', False))
+
+
+def find_out_variants(aten_decls):
+    """Returns a map from out_variant_key of a functional signature to the
+    declaration of its out= variant, for variants with a single Tensor output"""
+    out_variants = {}
+    for decl in aten_decls:
+        if not decl['name'].endswith('_out') or 'namespace' not in decl['method_of']:
+            continue
+        outputs = [arg for arg in decl['arguments'] if arg.get('output', False)]
+        if len(outputs) != 1 or outputs[0]['simple_type'] != 'Tensor':
+            continue
+        out_variants[out_variant_key(decl['name'][:-len('_out')], decl['arguments'])] = decl
+    return out_variants
+
+
+def find_inplace_variants(aten_decls):
+    """Returns a map from out_variant_key of a functional signature to the
+    declaration of its in-place Tensor method (foo_ for foo), which takes the
+    same arguments"""
+    inplace_variants = {}
+    for decl in aten_decls:
+        name = decl['name']
+        if (not name.endswith('_') or is_magic_method(name) or
+                'Tensor' not in decl['method_of'] or len(decl['returns']) != 1 or
+                decl['returns'][0]['simple_type'] != 'Tensor'):
+            continue
+        inplace_variants[out_variant_key(name[:-1], decl['arguments'])] = decl
+    return inplace_variants
+
+
 def is_sized_intlist_arg(arg):
     """Returns True for arguments declared as IntList[k], but False for IntList."""
     return (arg['simple_type'] == 'IntList') and ('size' in arg)
@@ -212,10 +268,12 @@ def gen_jit_dispatch(declarations, out, template_path):
                 name=decl['name'], first=args[0], args=args[1:],
                 num_dynamic_inputs=num_dynamic_inputs)
 
-    def emit_decl_variant(decl, is_positional_arg, has_tensorlist):
+    def emit_decl_variant(decl, is_positional_arg, has_tensorlist, out_decl=None, inplace_decl=None):
         # is_positional_arg is a boolean list the same length as decl['arguments']
         # that indicates if the argument should come from the postional list
         # of inputs. If false, the argument comes from the constant attributes
+        # if out_decl is given, emit an operation calling it instead, see OUT_CONSTRUCTOR
+        # if inplace_decl is given, emit an operation calling it instead
         kw_assignments = []
         pos_assignments = []
         arguments = []
@@ -289,12 +347,26 @@ def gen_jit_dispatch(declarations, out, template_path):
                 kw_assignments.append(assign)
                 arguments.append(arg['name'])
 
-        call = get_invocation(decl, arguments, num_dynamic_inputs)
+        if out_decl is not None:
+            by_name = {arg['name']: actual for arg, actual in zip(decl['arguments'], arguments)}
+            out_arguments = ['out' if arg.get('output', False) else by_name[arg['name']]
+                             for arg in out_decl['arguments']]
+            call = CALL_OUT.substitute(name=out_decl['name'], args=out_arguments,
+                                       num_dynamic_inputs=num_dynamic_inputs)
+            template = OUT_CONSTRUCTOR
+        elif inplace_decl is not None:
+            # the method also binds the Tensor & of self to the popped input
+            call = CALL_METHOD.substitute(name=inplace_decl['name'], first=arguments[0], args=arguments[1:],
+                                          num_dynamic_inputs=num_dynamic_inputs)
+            template = CONSTRUCTOR
+        else:
+            call = get_invocation(decl, arguments, num_dynamic_inputs)
+            template = CONSTRUCTOR
 
         returns = decl['returns']
         all_scalars = all(r['dynamic_type'] != 'TensorList' for r in returns)
 
-        constructor = CONSTRUCTOR.substitute(name=decl['name'],
+        constructor = template.substitute(name=(inplace_decl or decl)['name'],
                                              call=[call],  # in an array so that substitute handles newlines correctly
                                              kw_assignments=kw_assignments,
                                              pos_assignments=pos_assignments,
@@ -315,15 +387,44 @@ def gen_jit_dispatch(declarations, out, template_path):
         all_real_arguments_are_inputs = tuple(arg['simple_type'] not in default_only_types for arg in arguments)
         only_tensors_are_inputs = tuple(is_tensor_arg(arg) for arg in arguments)
 
-        variants = [emit_decl_variant(decl, all_real_arguments_are_inputs, has_tensorlist)]
         # in some cases there are no inputs that are possibly attributes, so the
         # variants are actually the same. If so avoid generating both to save compilation
         # time.
-        if all_real_arguments_are_inputs != only_tensors_are_inputs:
-            variants += [',', emit_decl_variant(decl, only_tensors_are_inputs, has_tensorlist)]
+        has_attribute_variant = all_real_arguments_are_inputs != only_tensors_are_inputs
+
+        # out= variants are used by the interpreter to write into preallocated
+        # memory, see passes/memory_planning.h, and in-place variants to write
+        # into the memory of the first input, see passes/inplace_ops.h
+        out_decl = None
+        inplace_decl = None
+        if (not decl.get('has_tensor_options') and len(decl['returns']) == 1 and
+                decl['returns'][0]['simple_type'] == 'Tensor'):
+            out_decl = out_variants.get(out_variant_key(decl['name'], arguments))
+            if arguments and arguments[0]['simple_type'] == 'Tensor':
+                inplace_decl = inplace_variants.get(out_variant_key(decl['name'], arguments))
+
+        # the Operator constructor takes the op and the op with constant
+        # attributes of the functional, the out= and the in-place variants
+        variants = []
+        for kwargs in [{}, {'out_decl': out_decl}, {'inplace_decl': inplace_decl}]:
+            if kwargs and list(kwargs.values())[0] is None:
+                variants += ['nullptr', 'nullptr']
+                continue
+            variants.append(emit_decl_variant(decl, all_real_arguments_are_inputs, has_tensorlist, **kwargs))
+            if has_attribute_variant:
+                variants.append(emit_decl_variant(decl, only_tensors_are_inputs, has_tensorlist, **kwargs))
+            else:
+                variants.append('nullptr')
+        # leave out the trailing defaults
+        while variants[-1] == 'nullptr':
+            variants.pop()
+        ops_list = []
+        for variant in variants:
+            ops_list += [variant, ',']
+        ops_list.pop()
 
         ops.append(OPERATOR.substitute(signature=signature(decl),
-                                       ops=variants))
+                                       ops=ops_list))
 
     # This function declares an order on declarations. This is necessary because
     # there is some ambiguity in the choice of overload: if an argument is overloaded
@@ -362,6 +463,8 @@ def gen_jit_dispatch(declarations, out, template_path):
         'returns': [{'name': 'result', 'type': 'int64_t', 'dynamic_type': 'int64_t', 'simple_type': 'int64_t'}],
     } for name in ['sizes', 'strides', 'dim']]
     aten_decls = load_aten_declarations(declarations) + tensor_impl_methods
+    out_variants = find_out_variants(aten_decls)
+    inplace_variants = find_inplace_variants(aten_decls)
 
     jit_decls = [d for d in aten_decls if is_jit_op(d)]
 
@@ -1985,15 +1985,17 @@ add_docstr(torch.inverse,
            r"""
 inverse(input, out=None) -> Tensor
 
-Takes the inverse of the square matrix :attr:`input`.
+Takes the inverse of the square matrix :attr:`input`. :attr:`input` can
+also be batches of square matrices, in which case each of them is inverted.
 
 .. note::
 
-    Irrespective of the original strides, the returned matrix will be
+    Irrespective of the original strides, the returned matrices will be
     transposed, i.e. with strides `(1, m)` instead of `(m, 1)`
 
 Args:
-    input (Tensor): the input 2-D square tensor
+    input (Tensor): the input tensor of size `(*, m, m)`, where `*` is zero
+        or more batch dimensions
     out (Tensor, optional): the optional output tensor
 
 Example::
@@ -5308,11 +5310,13 @@ The inverse of this function is :func:`~torch.ifft`.
     repeatedly running FFT methods on tensors of same geometry with same
     same configuration.
 
-    Changing ``torch.backends.cuda.cufft_plan_cache.max_size`` (default 1023)
-    controls the capacity of this cache. Some cuFFT plans may allocate GPU
-    memory. You may use ``torch.backends.cuda.cufft_plan_cache.size`` to query
-    the number of plans currently in cache, and
-    ``torch.backends.cuda.cufft_plan_cache.clear()`` to clear the cache.
+    Each device has its own cache, ``torch.backends.cuda.cufft_plan_cache[i]``
+    for device ``i``, and ``torch.backends.cuda.cufft_plan_cache`` refers to
+    the one of the current device. Changing its ``max_size`` (default 1023)
+    controls the capacity of the cache. Some cuFFT plans may allocate GPU
+    memory. You may use its ``size`` to query the number of plans currently in
+    cache, ``hits`` and ``misses`` to count the FFTs that found or had to
+    create their plan, and ``clear()`` to clear the cache.
 
 .. warning::
     For CPU tensors, this method is currently only available with MKL. Use
@@ -5408,11 +5412,13 @@ The inverse of this function is :func:`~torch.fft`.
     repeatedly running FFT methods on tensors of same geometry with same
     same configuration.
 
-    Changing ``torch.backends.cuda.cufft_plan_cache.max_size`` (default 1023)
-    controls the capacity of this cache. Some cuFFT plans may allocate GPU
-    memory. You may use ``torch.backends.cuda.cufft_plan_cache.size`` to query
-    the number of plans currently in cache, and
-    ``torch.backends.cuda.cufft_plan_cache.clear()`` to clear the cache.
+    Each device has its own cache, ``torch.backends.cuda.cufft_plan_cache[i]``
+    for device ``i``, and ``torch.backends.cuda.cufft_plan_cache`` refers to
+    the one of the current device. Changing its ``max_size`` (default 1023)
+    controls the capacity of the cache. Some cuFFT plans may allocate GPU
+    memory. You may use its ``size`` to query the number of plans currently in
+    cache, ``hits`` and ``misses`` to count the FFTs that found or had to
+    create their plan, and ``clear()`` to clear the cache.
 
 .. warning::
     For CPU tensors, this method is currently only available with MKL. Use
@@ -5497,11 +5503,13 @@ The inverse of this function is :func:`~torch.irfft`.
     repeatedly running FFT methods on tensors of same geometry with same
     same configuration.
 
-    Changing ``torch.backends.cuda.cufft_plan_cache.max_size`` (default 1023)
-    controls the capacity of this cache. Some cuFFT plans may allocate GPU
-    memory. You may use ``torch.backends.cuda.cufft_plan_cache.size`` to query
-    the number of plans currently in cache, and
-    ``torch.backends.cuda.cufft_plan_cache.clear()`` to clear the cache.
+    Each device has its own cache, ``torch.backends.cuda.cufft_plan_cache[i]``
+    for device ``i``, and ``torch.backends.cuda.cufft_plan_cache`` refers to
+    the one of the current device. Changing its ``max_size`` (default 1023)
+    controls the capacity of the cache. Some cuFFT plans may allocate GPU
+    memory. You may use its ``size`` to query the number of plans currently in
+    cache, ``hits`` and ``misses`` to count the FFTs that found or had to
+    create their plan, and ``clear()`` to clear the cache.
 
 .. warning::
     For CPU tensors, this method is currently only available with MKL. Use
@@ -5578,11 +5586,13 @@ The inverse of this function is :func:`~torch.rfft`.
     repeatedly running FFT methods on tensors of same geometry with same
     same configuration.
 
-    Changing ``torch.backends.cuda.cufft_plan_cache.max_size`` (default 1023)
-    controls the capacity of this cache. Some cuFFT plans may allocate GPU
-    memory. You may use ``torch.backends.cuda.cufft_plan_cache.size`` to query
-    the number of plans currently in cache, and
-    ``torch.backends.cuda.cufft_plan_cache.clear()`` to clear the cache.
+    Each device has its own cache, ``torch.backends.cuda.cufft_plan_cache[i]``
+    for device ``i``, and ``torch.backends.cuda.cufft_plan_cache`` refers to
+    the one of the current device. Changing its ``max_size`` (default 1023)
+    controls the capacity of the cache. Some cuFFT plans may allocate GPU
+    memory. You may use its ``size`` to query the number of plans currently in
+    cache, ``hits`` and ``misses`` to count the FFTs that found or had to
+    create their plan, and ``clear()`` to clear the cache.
 
 .. warning::
     For CPU tensors, this method is currently only available with MKL. Use
@@ -0,0 +1,45 @@
+import torch
+
+
+class offload_saved_tensors(object):
+    r"""Context-manager that offloads the tensors saved for backward to the host.
+
+    While enabled, the CUDA tensors of at least :attr:`min_bytes` bytes that
+    the forward pass saves for the backward pass are copied to pinned host
+    memory on a side stream, and their device memory is released once the
+    copy completes. The backward pass copies them back ahead of use: unpacking
+    a saved tensor prefetches the ones saved just before it.
+
+    This lets models whose activations do not fit in device memory train
+    without recomputing them (see :mod:`torch.utils.checkpoint`), at the cost
+    of the PCIe bandwidth of the copies. Only the forward pass needs to run
+    within the context manager.
+
+    Example:
+
+        >>> with torch.autograd.offload_saved_tensors():
+        ...     loss = model(input).sum()
+        >>> loss.backward()
+
+    Arguments:
+        enabled (bool): Flag whether to offload saved tensors (``True``), or
+                        not (``False``). Default: ``True``.
+        min_bytes (int): Saved tensors smaller than this stay on the device,
+                         as offloading them saves little. Default: 1 MiB.
+
+    """
+
+    def __init__(self, enabled=True, min_bytes=1 << 20):
+        self.enabled = enabled
+        self.min_bytes = min_bytes
+
+    def __enter__(self):
+        self.prev = torch._C._is_offload_enabled()
+        self.prev_min_bytes = torch._C._get_offload_min_bytes()
+        torch._C._set_offload_enabled(self.enabled)
+        torch._C._set_offload_min_bytes(self.min_bytes)
+
+    def __exit__(self, *args):
+        torch._C._set_offload_enabled(self.prev)
+        torch._C._set_offload_min_bytes(self.prev_min_bytes)
+        return False
@@ -222,6 +222,52 @@ class profile(object):
     total_average.__doc__ = EventList.total_average.__doc__
 
 
+class sample(object):
+    """Context manager that samples autograd operations with low overhead.
+
+    Only one in every ``period`` operations (counted per thread) is timed,
+    and the times are aggregated per operation name, so that it can stay
+    enabled in long-running jobs. :meth:`drain` returns what was recorded
+    since the previous call without stopping the sampling.
+
+    Arguments:
+        period (int, optional): Sample one in this many operations.
+            Default: ``100``.
+
+    Example:
+        >>> with torch.autograd.profiler.sample(period=10) as s:
+        ...     for _ in range(1000):
+        ...         y = (x * 2).sum()
+        ...         if should_report():
+        ...             for op in s.drain():
+        ...                 report(op.name, op.samples * s.period, op.total_ns)
+    """
+
+    def __init__(self, period=100):
+        self.period = period
+        self.entered = False
+
+    def __enter__(self):
+        if self.entered:
+            raise RuntimeError("autograd profiler sampling is not reentrant")
+        self.entered = True
+        torch.autograd._enable_profiler_sampling(self.period)
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        torch.autograd._disable_profiler_sampling()
+        self.entered = False
+        return False
+
+    def drain(self):
+        """Returns the samples recorded since the previous call, as a list
+        with an entry per operation name, which has ``name``, ``samples``,
+        ``total_ns`` and ``histogram`` attributes. Bucket ``i`` of the
+        histogram counts the samples that took between ``2 ** i`` and
+        ``2 ** (i + 1)`` nanoseconds."""
+        return torch.autograd._drain_profiler_samples()
+
+
 class emit_nvtx(object):
     """Context manager that makes every autograd operation emit an NVTX range.
 
@@ -154,6 +154,16 @@ static PyObject * THPModule_setNumThreads(PyObject *module, PyObject *arg)
   Py_RETURN_NONE;
 }
 
+#ifndef _WIN32
+static PyObject * THPModule_retireSharedPool(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  libshm_retire_pool();
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+#endif
+
 PyObject * THPModule_setDefaultTensorType(PyObject *_unused, PyObject *type)
 {
   HANDLE_TH_ERRORS
@@ -293,15 +303,52 @@ void DLPack_Capsule_Destructor(PyObject* data) {
     // PyCapsule_GetPointer has set an error indicator
     PyErr_Clear();
   }
+  Py_XDECREF((PyObject*)PyCapsule_GetContext(data));
   END_HANDLE_TH_ERRORS_RET()
 }
 
-PyObject *THPModule_toDLPack(PyObject *_unused, PyObject *data)
+// The optional second argument, e.g. the CUDA event recorded after the work
+// producing the tensor, travels with the capsule as its context, so that
+// from_dlpack can wait on it instead of synchronizing the device.
+PyObject *THPModule_toDLPack(PyObject *_unused, PyObject *args)
 {
   HANDLE_TH_ERRORS
+  PyObject *data = nullptr;
+  PyObject *event = Py_None;
+  if (!PyArg_ParseTuple(args, "O|O", &data, &event)) {
+    return nullptr;
+  }
   THPUtils_assert(THPVariable_Check(data), "data must be a Tensor");
   DLManagedTensor* dlMTensor = at::toDLPack(THPVariable_UnpackData(data));
-  return PyCapsule_New(dlMTensor, "dltensor", DLPack_Capsule_Destructor);
+  THPObjectPtr capsule(PyCapsule_New(dlMTensor, "dltensor", DLPack_Capsule_Destructor));
+  if (!capsule) {
+    dlMTensor->deleter(dlMTensor);
+    return nullptr;
+  }
+  if (event != Py_None) {
+    Py_INCREF(event);
+    if (PyCapsule_SetContext(capsule.get(), event) != 0) {
+      Py_DECREF(event);
+      return nullptr;
+    }
+  }
+  return capsule.release();
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject *THPModule_dlpackEvent(PyObject *_unused, PyObject *data)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyCapsule_CheckExact(data), "expected a DLPack capsule");
+  PyObject *event = (PyObject*)PyCapsule_GetContext(data);
+  if (!event) {
+    if (PyErr_Occurred()) {
+      return nullptr;
+    }
+    Py_RETURN_NONE;
+  }
+  Py_INCREF(event);
+  return event;
   END_HANDLE_TH_ERRORS
 }
 
@@ -431,13 +478,17 @@ static PyMethodDef TorchMethods[] = {
   {"_get_backcompat_keepdim_warn", (PyCFunction)THPModule_getBackcompatKeepdimWarn, METH_NOARGS, NULL},
   {"get_num_threads", (PyCFunction)THPModule_getNumThreads,     METH_NOARGS,  NULL},
   {"set_num_threads", (PyCFunction)THPModule_setNumThreads,     METH_O,       NULL},
+#ifndef _WIN32
+  {"_retire_shared_pool", (PyCFunction)THPModule_retireSharedPool, METH_NOARGS, NULL},
+#endif
   {"_get_cudnn_enabled", (PyCFunction)THPModule_userEnabledCuDNN, METH_NOARGS,     NULL},
   {"_set_cudnn_enabled", (PyCFunction)THPModule_setUserEnabledCuDNN, METH_O,  NULL},
   {"_get_cudnn_benchmark", (PyCFunction)THPModule_benchmarkCuDNN, METH_NOARGS,     NULL},
   {"_set_cudnn_benchmark", (PyCFunction)THPModule_setBenchmarkCuDNN, METH_O,  NULL},
   {"_get_cudnn_deterministic", (PyCFunction)THPModule_deterministicCuDNN, METH_NOARGS,     NULL},
   {"_set_cudnn_deterministic", (PyCFunction)THPModule_setDeterministicCuDNN, METH_O,  NULL},
-  {"_to_dlpack",      (PyCFunction)THPModule_toDLPack,          METH_O,       NULL},
+  {"_to_dlpack",      (PyCFunction)THPModule_toDLPack,          METH_VARARGS, NULL},
+  {"_dlpack_event",   (PyCFunction)THPModule_dlpackEvent,       METH_O,       NULL},
   {"_from_dlpack",    (PyCFunction)THPModule_fromDLPack,        METH_O,       NULL},
   {"set_flush_denormal", (PyCFunction)THPModule_setFlushDenormal, METH_O,     NULL},
   {"get_default_dtype", (PyCFunction)THPModule_getDefaultDtype, METH_NOARGS,  NULL},
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <torch/data/collate.h>
+#include <torch/data/data_loader.h>
+#include <torch/data/dataset.h>
+#include <torch/data/example.h>
+#include <torch/data/samplers.h>
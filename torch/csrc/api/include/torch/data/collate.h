@@ -0,0 +1,18 @@
+#pragma once
+
+#include <torch/data/example.h>
+
+#include <ATen/ArrayRef.h>
+
+namespace torch {
+namespace data {
+
+/// Stacks the inputs and the targets of `examples` along a new first
+/// dimension. Targets are left undefined if the examples have none.
+Example<> stack(at::ArrayRef<Example<>> examples);
+
+/// Copies the tensors of `batch` into page-locked memory, from which they can
+/// be copied to a CUDA device asynchronously.
+Example<> pin_memory(const Example<>& batch);
+} // namespace data
+} // namespace torch
@@ -0,0 +1,335 @@
+#pragma once
+
+#include <torch/data/collate.h>
+#include <torch/data/dataset.h>
+#include <torch/data/detail/queue.h>
+#include <torch/data/example.h>
+#include <torch/data/samplers.h>
+#include <torch/nn/pimpl.h>
+#include <torch/tensor.h>
+
+#include <ATen/Error.h>
+#include <ATen/optional.h>
+
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace data {
+
+struct DataLoaderOptions {
+  /* implicit */ DataLoaderOptions(size_t batch_size)
+      : batch_size_(batch_size) {}
+
+  /// The number of examples per batch.
+  TORCH_ARG(size_t, batch_size);
+
+  /// The number of worker threads that load and collate batches. With zero
+  /// workers, batches are loaded on the thread that asks for them.
+  TORCH_ARG(size_t, workers) = 0;
+
+  /// The maximum number of batches being loaded or waiting to be consumed at
+  /// any time. Defaults to twice the number of workers.
+  TORCH_ARG(at::optional<size_t>, max_jobs);
+
+  /// Whether to drop the last batch of an epoch if it is incomplete.
+  TORCH_ARG(bool, drop_last) = false;
+
+  /// Whether batches are returned in the order the sampler produced their
+  /// indices. Otherwise they are returned as soon as a worker finishes them.
+  TORCH_ARG(bool, enforce_ordering) = true;
+
+  /// Whether the workers copy each collated batch into page-locked memory.
+  TORCH_ARG(bool, pin_memory) = false;
+
+  /// If set, every batch is moved to this device before it is returned. The
+  /// copy is asynchronous when the batch lives in pinned memory.
+  TORCH_ARG(at::optional<Device>, device);
+};
+
+/// Loads batches of a dataset, optionally on a pool of worker threads.
+///
+/// The loader asks the sampler for the indices of up to `max_jobs` batches
+/// ahead and hands them to its workers, which fetch the examples, stack them
+/// into one `Example<>` and, if requested, pin it. Iterating the loader runs
+/// one epoch:
+///
+///   DataLoader<MyDataset> loader(dataset, DataLoaderOptions(64).workers(4));
+///   for (auto& batch : loader) { ... }
+///
+/// Exceptions thrown while loading a batch are rethrown by the call that
+/// would have returned it.
+template <typename DatasetType, typename SamplerType = RandomSampler>
+class DataLoader {
+ public:
+  using Batch = Example<>;
+
+  class Iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Batch;
+    using difference_type = std::ptrdiff_t;
+    using pointer = Batch*;
+    using reference = Batch&;
+
+    Iterator(DataLoader* loader, at::optional<Batch> batch)
+        : loader_(loader), batch_(std::move(batch)) {}
+
+    Batch& operator*() {
+      AT_CHECK(batch_.has_value(), "Dereferencing the end of a DataLoader");
+      return *batch_;
+    }
+
+    Batch* operator->() {
+      return &**this;
+    }
+
+    Iterator& operator++() {
+      batch_ = loader_->next();
+      return *this;
+    }
+
+    /// Two iterators compare equal if both are exhausted; a live iterator
+    /// only equals itself.
+    bool operator==(const Iterator& other) const {
+      return this == &other ||
+          (!batch_.has_value() && !other.batch_.has_value());
+    }
+
+    bool operator!=(const Iterator& other) const {
+      return !(*this == other);
+    }
+
+   private:
+    DataLoader* loader_;
+    at::optional<Batch> batch_;
+  };
+
+  /// Constructs a loader that samples `dataset` with a `SamplerType`
+  /// constructed from the size of the dataset.
+  DataLoader(DatasetType dataset, DataLoaderOptions options)
+      : options_(std::move(options)),
+        dataset_(std::move(dataset)),
+        sampler_(dataset_.size()) {
+    start_workers();
+  }
+
+  DataLoader(
+      DatasetType dataset,
+      DataLoaderOptions options,
+      SamplerType sampler)
+      : options_(std::move(options)),
+        dataset_(std::move(dataset)),
+        sampler_(std::move(sampler)) {
+    start_workers();
+  }
+
+  DataLoader(const DataLoader&) = delete;
+  DataLoader& operator=(const DataLoader&) = delete;
+
+  ~DataLoader() {
+    jobs_.clear();
+    jobs_.close();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  /// Starts a new epoch and returns an iterator to its first batch.
+  Iterator begin() {
+    reset();
+    return Iterator(this, next());
+  }
+
+  Iterator end() {
+    return Iterator(this, at::nullopt);
+  }
+
+  /// Starts a new epoch. Batches of the previous epoch that are still being
+  /// loaded are discarded.
+  void reset() {
+    sampler_.reset();
+    jobs_.clear();
+    reorder_buffer_.clear();
+    ++epoch_;
+    in_flight_ = 0;
+    next_sequence_number_ = 0;
+    next_expected_sequence_number_ = 0;
+    exhausted_ = false;
+    prefetch();
+  }
+
+  /// Returns the next batch of the current epoch, or `nullopt` once the epoch
+  /// is exhausted.
+  at::optional<Batch> next() {
+    at::optional<Batch> batch;
+    if (workers_.empty()) {
+      auto indices = next_indices();
+      if (!indices) {
+        return at::nullopt;
+      }
+      batch = load(*indices);
+    } else {
+      prefetch();
+      if (in_flight_ == 0) {
+        return at::nullopt;
+      }
+      Result result = pop_result();
+      --in_flight_;
+      prefetch();
+      if (result.exception) {
+        std::rethrow_exception(result.exception);
+      }
+      batch = std::move(result.batch);
+    }
+    if (options_.device_) {
+      batch->data = batch->data.to(*options_.device_, /*non_blocking=*/true);
+      if (batch->target.defined()) {
+        batch->target =
+            batch->target.to(*options_.device_, /*non_blocking=*/true);
+      }
+    }
+    return batch;
+  }
+
+  const DataLoaderOptions& options() const noexcept {
+    return options_;
+  }
+
+ private:
+  struct Job {
+    size_t epoch;
+    size_t sequence_number;
+    std::vector<size_t> indices;
+  };
+
+  struct Result {
+    size_t epoch;
+    size_t sequence_number;
+    Batch batch;
+    std::exception_ptr exception;
+  };
+
+  void start_workers() {
+    AT_CHECK(
+        options_.batch_size_ > 0, "DataLoader: batch_size must be positive");
+    max_jobs_ = options_.max_jobs_.value_or(2 * options_.workers_);
+    AT_CHECK(
+        options_.workers_ == 0 || max_jobs_ > 0,
+        "DataLoader: max_jobs must be positive");
+    for (size_t i = 0; i < options_.workers_; ++i) {
+      workers_.emplace_back([this] { worker_loop(); });
+    }
+  }
+
+  void worker_loop() {
+    while (auto job = jobs_.pop()) {
+      Result result;
+      result.epoch = job->epoch;
+      result.sequence_number = job->sequence_number;
+      try {
+        result.batch = load(job->indices);
+      } catch (...) {
+        result.exception = std::current_exception();
+      }
+      results_.push(std::move(result));
+    }
+  }
+
+  Batch load(const std::vector<size_t>& indices) {
+    auto batch = stack(dataset_.get_batch(indices));
+    if (options_.pin_memory_) {
+      batch = pin_memory(batch);
+    }
+    return batch;
+  }
+
+  at::optional<std::vector<size_t>> next_indices() {
+    if (exhausted_) {
+      return at::nullopt;
+    }
+    auto indices = sampler_.next(options_.batch_size_);
+    if (!indices || indices->empty() ||
+        (options_.drop_last_ && indices->size() < options_.batch_size_)) {
+      exhausted_ = true;
+      return at::nullopt;
+    }
+    return indices;
+  }
+
+  /// Keeps up to `max_jobs_` batches of the current epoch in flight.
+  void prefetch() {
+    while (!workers_.empty() && in_flight_ < max_jobs_) {
+      auto indices = next_indices();
+      if (!indices) {
+        break;
+      }
+      jobs_.push(Job{epoch_, next_sequence_number_++, std::move(*indices)});
+      ++in_flight_;
+    }
+  }
+
+  /// Waits for the next batch of the current epoch to return: the next one
+  /// in sampling order when ordering is enforced, any one otherwise. Results
+  /// of earlier epochs are dropped.
+  Result pop_result() {
+    while (true) {
+      if (options_.enforce_ordering_) {
+        auto it = reorder_buffer_.find(next_expected_sequence_number_);
+        if (it != reorder_buffer_.end()) {
+          Result result = std::move(it->second);
+          reorder_buffer_.erase(it);
+          ++next_expected_sequence_number_;
+          return result;
+        }
+      }
+      auto result = results_.pop();
+      AT_ASSERT(result.has_value());
+      if (result->epoch != epoch_) {
+        continue;
+      }
+      if (!options_.enforce_ordering_ ||
+          result->sequence_number == next_expected_sequence_number_) {
+        ++next_expected_sequence_number_;
+        return std::move(*result);
+      }
+      const auto sequence_number = result->sequence_number;
+      reorder_buffer_.emplace(sequence_number, std::move(*result));
+    }
+  }
+
+  DataLoaderOptions options_;
+  DatasetType dataset_;
+  SamplerType sampler_;
+  size_t max_jobs_ = 0;
+
+  detail::Queue<Job> jobs_;
+  detail::Queue<Result> results_;
+  std::vector<std::thread> workers_;
+
+  // State of the current epoch, only touched by the thread that consumes
+  // batches.
+  size_t epoch_ = 0;
+  size_t in_flight_ = 0;
+  size_t next_sequence_number_ = 0;
+  size_t next_expected_sequence_number_ = 0;
+  bool exhausted_ = false;
+  std::unordered_map<size_t, Result> reorder_buffer_;
+};
+
+/// Constructs a `DataLoader` over `dataset` with a `RandomSampler`.
+template <typename DatasetType>
+std::unique_ptr<DataLoader<DatasetType>> make_data_loader(
+    DatasetType dataset,
+    DataLoaderOptions options) {
+  return std::unique_ptr<DataLoader<DatasetType>>(
+      new DataLoader<DatasetType>(std::move(dataset), std::move(options)));
+}
+} // namespace data
+} // namespace torch
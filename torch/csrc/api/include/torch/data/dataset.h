@@ -0,0 +1,50 @@
+#pragma once
+
+#include <torch/data/example.h>
+#include <torch/tensor.h>
+
+#include <ATen/ArrayRef.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace torch {
+namespace data {
+
+/// A dataset indexable by position. Subclasses implement `get()` and
+/// `size()`, and may override `get_batch()` when loading several examples at
+/// once is cheaper than loading them one by one.
+///
+/// NOTE: A `DataLoader` with worker threads calls `get_batch()` concurrently
+/// from all of its workers, so implementations must be safe to call from
+/// several threads at once.
+class Dataset {
+ public:
+  virtual ~Dataset() = default;
+
+  /// Returns the example at `index`.
+  virtual Example<> get(size_t index) = 0;
+
+  /// Returns the number of examples in the dataset.
+  virtual size_t size() const = 0;
+
+  /// Returns the examples at the given indices.
+  virtual std::vector<Example<>> get_batch(at::ArrayRef<size_t> indices);
+};
+
+/// A dataset over tensors whose first dimension indexes the examples.
+class TensorDataset : public Dataset {
+ public:
+  /// Constructs a dataset from inputs and, optionally, the matching targets.
+  /// If given, `target` must have as many rows as `data`.
+  explicit TensorDataset(Tensor data, Tensor target = {});
+
+  Example<> get(size_t index) override;
+  size_t size() const override;
+
+ private:
+  Tensor data_;
+  Tensor target_;
+};
+} // namespace data
+} // namespace torch
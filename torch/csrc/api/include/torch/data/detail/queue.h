@@ -0,0 +1,65 @@
+#pragma once
+
+#include <ATen/optional.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <queue>
+#include <utility>
+
+namespace torch {
+namespace data {
+namespace detail {
+
+/// A multi-producer, multi-consumer FIFO queue. `pop()` blocks until a value
+/// arrives or the queue is closed; once closed and drained, `pop()` returns
+/// `nullopt`.
+template <typename T>
+class Queue {
+ public:
+  void push(T value) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queue_.push(std::move(value));
+    }
+    cv_.notify_one();
+  }
+
+  at::optional<T> pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return !queue_.empty() || closed_; });
+    if (queue_.empty()) {
+      return at::nullopt;
+    }
+    T value = std::move(queue_.front());
+    queue_.pop();
+    return std::move(value);
+  }
+
+  /// Drops all values that have not been popped yet, returning their number.
+  size_t clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const size_t size = queue_.size();
+    queue_ = std::queue<T>();
+    return size;
+  }
+
+  /// Wakes up all consumers; values already in the queue can still be popped.
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    cv_.notify_all();
+  }
+
+ private:
+  std::queue<T> queue_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool closed_ = false;
+};
+} // namespace detail
+} // namespace data
+} // namespace torch
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <torch/tensor.h>
+
+#include <utility>
+
+namespace torch {
+namespace data {
+
+/// A single training example, or a collated batch of them: an input and the
+/// target it should map to. The target may be left undefined for datasets
+/// without labels.
+template <typename Data = Tensor, typename Target = Tensor>
+struct Example {
+  Example() = default;
+  Example(Data data, Target target)
+      : data(std::move(data)), target(std::move(target)) {}
+
+  Data data;
+  Target target;
+};
+} // namespace data
+} // namespace torch
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <ATen/optional.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace torch {
+namespace data {
+
+/// Produces the indices a `DataLoader` loads, one batch at a time.
+class Sampler {
+ public:
+  virtual ~Sampler() = default;
+
+  /// Rewinds the sampler to the start of a new epoch.
+  virtual void reset() = 0;
+
+  /// Returns the indices of the next batch, at most `batch_size` of them, or
+  /// `nullopt` once the epoch is exhausted.
+  virtual at::optional<std::vector<size_t>> next(size_t batch_size) = 0;
+};
+
+/// Returns the indices `0, ..., size - 1` in order.
+class SequentialSampler : public Sampler {
+ public:
+  explicit SequentialSampler(size_t size);
+
+  void reset() override;
+  at::optional<std::vector<size_t>> next(size_t batch_size) override;
+
+ private:
+  size_t size_;
+  size_t index_ = 0;
+};
+
+/// Returns the indices `0, ..., size - 1` in a new random order every epoch.
+/// The order is drawn from the default generator, so `torch::manual_seed()`
+/// makes it reproducible.
+class RandomSampler : public Sampler {
+ public:
+  explicit RandomSampler(size_t size);
+
+  void reset() override;
+  at::optional<std::vector<size_t>> next(size_t batch_size) override;
+
+ private:
+  std::vector<size_t> indices_;
+  size_t index_ = 0;
+};
+} // namespace data
+} // namespace torch
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <torch/tensor.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace torch {
+using NamedTensors = std::vector<std::pair<std::string, Tensor>>;
+
+/// Saves the tensors to a file that `load_mapped` maps into memory. The file
+/// holds an index of the tensors followed by their data, each starting on a
+/// page boundary. CUDA tensors are saved from a CPU copy.
+void save_mapped(const std::string& path, const NamedTensors& tensors);
+
+/// Maps the file written by `save_mapped` and returns CPU tensors whose
+/// storage points into the mapping, which stays alive as long as any of them
+/// does. Only the index is read up front; the data of a tensor is paged in
+/// when it is first accessed. The mapping is private, so writes to the
+/// tensors never reach the file.
+NamedTensors load_mapped(const std::string& path);
+} // namespace torch
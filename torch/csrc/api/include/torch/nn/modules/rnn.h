@@ -22,6 +22,19 @@ struct RNNOutput {
   Tensor state;
 };
 
+/// A batch of variable-length sequences packed into one tensor without
+/// padding. The rows of `data` hold, for each time step `t` in turn, the
+/// `batch_sizes[t]` sequences that are still running at that step. Sequences
+/// must therefore be sorted by decreasing length.
+struct PackedSequence {
+  Tensor data;
+  std::vector<int64_t> batch_sizes;
+};
+
+/// Packs a padded `(time, batch, features)` tensor whose sequences have the
+/// given `lengths`, which must be sorted in decreasing order.
+PackedSequence pack_padded_sequence(Tensor input, std::vector<int64_t> lengths);
+
 namespace detail {
 struct RNNOptionsBase {
   RNNOptionsBase(int64_t input_size, int64_t hidden_size);
@@ -48,6 +61,12 @@ class RNNImplBase : public torch::nn::Cloneable<Derived> {
 
   RNNOutput forward(Tensor input, Tensor state = {});
 
+  /// Runs the RNN over a batch of packed sequences, without computing
+  /// anything for the padding of shorter sequences. The returned output is
+  /// packed like `input.data`; the returned state holds the final state of
+  /// every sequence, in the order of the batch.
+  RNNOutput packed_forward(const PackedSequence& input, Tensor state = {});
+
   void reset() override;
 
   /// Recursively casts all parameters to the given device and dtype.
@@ -60,9 +79,10 @@ class RNNImplBase : public torch::nn::Cloneable<Derived> {
   /// Recursively moves all parameters to the given device.
   void to(torch::Device device, bool non_blocking = false) override;
 
-  /// Fills the internal flattened parameter buffers passed to cuDNN. Call this
-  /// method if you mess around with the variable storages and want to use
-  /// cuDNN.
+  /// Moves the parameters into the single contiguous buffer passed to cuDNN,
+  /// leaving each parameter a view into it. This happens automatically when
+  /// the module is moved and on the first cuDNN forward after the parameter
+  /// storages changed.
   void flatten_parameters_for_cudnn();
 
   RNNOptionsBase options;
@@ -77,12 +97,17 @@ class RNNImplBase : public torch::nn::Cloneable<Derived> {
  protected:
   virtual Tensor cell_forward(Tensor input, Tensor state, int64_t layer) = 0;
 
-  RNNOutput CUDNN_forward(Tensor input, Tensor state);
+  RNNOutput CUDNN_forward(
+      Tensor input,
+      Tensor state,
+      at::IntList batch_sizes = {});
   RNNOutput autograd_forward(Tensor input, Tensor state);
+  RNNOutput autograd_packed_forward(const PackedSequence& input, Tensor state);
 
   std::vector<Tensor> flat_weights() const;
   bool use_cudnn(Tensor sample) const;
-  Tensor create_dropout_state(Tensor input) const;
+  std::vector<void*> parameter_data_ptrs() const;
+  Tensor dropout_state(Tensor input);
 
   int64_t number_of_gates_;
   bool has_cell_state_;
@@ -96,6 +121,10 @@ class RNNImplBase : public torch::nn::Cloneable<Derived> {
   // the parameters are flat, instead of relying on data pointers and stuff.
   std::vector<void*> data_ptrs_;
   Tensor flat_weights_;
+
+  // The cuDNN dropout RNG state. Initializing it is expensive, so it is
+  // created once per device and reused by every forward.
+  Tensor dropout_state_;
 };
 } // namespace detail
 
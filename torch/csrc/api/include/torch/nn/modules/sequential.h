@@ -1,5 +1,6 @@
 #pragma once
 
+#include <torch/csrc/autograd/functions/checkpoint.h>
 #include <torch/detail/static.h>
 #include <torch/nn/module.h>
 #include <torch/nn/modules/any.h>
@@ -8,6 +9,7 @@
 
 #include <ATen/Error.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <string>
@@ -74,6 +76,40 @@ class SequentialImpl : public Cloneable<SequentialImpl> {
         at::demangle(typeid(ReturnType).name()));
   }
 
+  /// Like `forward()` for modules that take and return a single `Tensor`, but
+  /// trades compute for memory. The modules are split into at most
+  /// `segments` contiguous segments of equal length, and all but the last are
+  /// run with `torch::autograd::checkpoint`: only the input of each segment is
+  /// kept for backward, and the segment is run again during backward to
+  /// recompute the activations in between. As checkpointed segments only
+  /// record a graph if their input requires grad, the first segment runs
+  /// normally when `input` doesn't.
+  Tensor forward_checkpointed(Tensor input, size_t segments) {
+    AT_CHECK(!is_empty(), "Cannot call forward() on an empty Sequential");
+    AT_CHECK(segments > 0, "Expected at least one segment");
+    segments = std::min(segments, size());
+    const size_t segment_size = (size() + segments - 1) / segments;
+    for (size_t begin = 0; begin < size(); begin += segment_size) {
+      const size_t end = std::min(begin + segment_size, size());
+      std::vector<AnyModule> segment(
+          modules_.begin() + begin, modules_.begin() + end);
+      auto run_segment =
+          [segment](const autograd::variable_list& inputs) mutable {
+            auto value = inputs[0];
+            for (auto& module : segment) {
+              value = module.forward(std::move(value)).template get<Tensor>();
+            }
+            return autograd::variable_list{std::move(value)};
+          };
+      if (end == size() || (begin == 0 && !input.requires_grad())) {
+        input = run_segment({std::move(input)})[0];
+      } else {
+        input = autograd::checkpoint(run_segment, {std::move(input)})[0];
+      }
+    }
+    return input;
+  }
+
   /// Adds a new (boxed) `Module` to the `Sequential` container.
   template <typename ModuleType>
   void push_back(std::shared_ptr<ModuleType> module_ptr) {
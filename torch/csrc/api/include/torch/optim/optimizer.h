@@ -76,6 +76,11 @@ class OptimizerBase {
     return buffers[index];
   }
 
+  /// Returns the indices of the parameters that have a gradient, grouped by
+  /// device and dtype, so that each group can be updated by a single fused
+  /// step. Indices keep their relative order within a group.
+  std::vector<std::vector<size_t>> parameter_groups() const;
+
   /// The parameters this optimizer optimizes.
   std::vector<Tensor> parameters_;
 };
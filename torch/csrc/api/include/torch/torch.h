@@ -1,6 +1,8 @@
 #pragma once
 
 #include <torch/cuda.h>
+#include <torch/data.h>
+#include <torch/mapped_tensors.h>
 #include <torch/nn.h>
 #include <torch/optim.h>
 #include <torch/serialization.h>
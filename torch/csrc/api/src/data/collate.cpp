@@ -0,0 +1,37 @@
+#include <torch/data/collate.h>
+
+#include <torch/data/example.h>
+#include <torch/tensor.h>
+
+#include <ATen/ArrayRef.h>
+#include <ATen/Error.h>
+
+#include <vector>
+
+namespace torch {
+namespace data {
+
+Example<> stack(at::ArrayRef<Example<>> examples) {
+  AT_CHECK(!examples.empty(), "Cannot stack an empty batch of examples");
+  std::vector<at::Tensor> data, targets;
+  data.reserve(examples.size());
+  targets.reserve(examples.size());
+  for (const auto& example : examples) {
+    data.push_back(example.data);
+    if (example.target.defined()) {
+      targets.push_back(example.target);
+    }
+  }
+  AT_CHECK(
+      targets.empty() || targets.size() == data.size(),
+      "Cannot stack examples of which only some have a target");
+  return {torch::stack(data),
+          targets.empty() ? Tensor() : torch::stack(targets)};
+}
+
+Example<> pin_memory(const Example<>& batch) {
+  return {batch.data.pin_memory(),
+          batch.target.defined() ? batch.target.pin_memory() : Tensor()};
+}
+} // namespace data
+} // namespace torch
@@ -0,0 +1,44 @@
+#include <torch/data/dataset.h>
+
+#include <torch/data/example.h>
+#include <torch/tensor.h>
+
+#include <ATen/ArrayRef.h>
+#include <ATen/Error.h>
+
+#include <cstddef>
+#include <vector>
+
+namespace torch {
+namespace data {
+
+std::vector<Example<>> Dataset::get_batch(at::ArrayRef<size_t> indices) {
+  std::vector<Example<>> batch;
+  batch.reserve(indices.size());
+  for (const auto index : indices) {
+    batch.push_back(get(index));
+  }
+  return batch;
+}
+
+TensorDataset::TensorDataset(Tensor data, Tensor target)
+    : data_(std::move(data)), target_(std::move(target)) {
+  AT_CHECK(data_.dim() > 0, "TensorDataset: data must have a first dimension");
+  AT_CHECK(
+      !target_.defined() || target_.size(0) == data_.size(0),
+      "TensorDataset: data has ",
+      data_.size(0),
+      " examples but target has ",
+      target_.size(0));
+}
+
+Example<> TensorDataset::get(size_t index) {
+  const auto i = static_cast<int64_t>(index);
+  return {data_[i], target_.defined() ? target_[i] : Tensor()};
+}
+
+size_t TensorDataset::size() const {
+  return data_.size(0);
+}
+} // namespace data
+} // namespace torch
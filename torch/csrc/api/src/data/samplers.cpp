@@ -0,0 +1,58 @@
+#include <torch/data/samplers.h>
+
+#include <torch/tensor.h>
+
+#include <ATen/optional.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace torch {
+namespace data {
+
+SequentialSampler::SequentialSampler(size_t size) : size_(size) {}
+
+void SequentialSampler::reset() {
+  index_ = 0;
+}
+
+at::optional<std::vector<size_t>> SequentialSampler::next(size_t batch_size) {
+  if (index_ >= size_) {
+    return at::nullopt;
+  }
+  const auto end = std::min(size_, index_ + batch_size);
+  std::vector<size_t> indices;
+  indices.reserve(end - index_);
+  for (; index_ < end; ++index_) {
+    indices.push_back(index_);
+  }
+  return indices;
+}
+
+RandomSampler::RandomSampler(size_t size) : indices_(size) {
+  reset();
+}
+
+void RandomSampler::reset() {
+  const at::Tensor permutation =
+      torch::randperm(indices_.size(), torch::kInt64);
+  const auto* data = permutation.data<int64_t>();
+  for (size_t i = 0; i < indices_.size(); ++i) {
+    indices_[i] = data[i];
+  }
+  index_ = 0;
+}
+
+at::optional<std::vector<size_t>> RandomSampler::next(size_t batch_size) {
+  if (index_ >= indices_.size()) {
+    return at::nullopt;
+  }
+  const auto end = std::min(indices_.size(), index_ + batch_size);
+  std::vector<size_t> indices(
+      indices_.begin() + index_, indices_.begin() + end);
+  index_ = end;
+  return indices;
+}
+} // namespace data
+} // namespace torch
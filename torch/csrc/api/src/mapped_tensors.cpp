@@ -0,0 +1,190 @@
+#include <torch/mapped_tensors.h>
+
+#include <torch/serialization.h>
+
+#include <ATen/ATen.h>
+#include <TH/THAllocator.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace {
+// File layout (native byte order):
+//   header:  magic[8] | uint32 version | uint32 alignment | uint64 count
+//   index:   count x (uint64 name size | name | int32 type id |
+//                     uint32 ndim | int64 sizes[ndim] | uint64 offset |
+//                     uint64 nbytes)
+//   data:    the data of each tensor at its offset, a multiple of alignment
+constexpr char kMagic[8] = {'T', 'O', 'R', 'C', 'H', 'M', 'A', 'P'};
+constexpr uint32_t kVersion = 1;
+constexpr uint64_t kAlignment = 4096;
+
+uint64_t align(uint64_t offset) {
+  return (offset + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+template <typename T>
+void write(std::ostream& stream, const T& value) {
+  stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void pad_to(std::ostream& stream, uint64_t* position, uint64_t offset) {
+  static const std::vector<char> zeros(kAlignment, 0);
+  stream.write(zeros.data(), offset - *position);
+  *position = offset;
+}
+
+// Reads the index out of the mapping, checking every field against its size.
+class IndexReader {
+ public:
+  IndexReader(const char* data, uint64_t size) : data_(data), size_(size) {}
+
+  template <typename T>
+  T read() {
+    T value;
+    std::memcpy(&value, take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  std::string read_string(uint64_t size) {
+    return std::string(take(size), size);
+  }
+
+ private:
+  const char* take(uint64_t size) {
+    AT_CHECK(
+        size <= size_ - position_,
+        "Truncated index in mapped tensor file");
+    const char* ptr = data_ + position_;
+    position_ += size;
+    return ptr;
+  }
+
+  const char* data_;
+  uint64_t size_;
+  uint64_t position_ = 0;
+};
+} // namespace
+
+void save_mapped(const std::string& path, const NamedTensors& tensors) {
+  struct Entry {
+    const std::string* name;
+    Tensor data;
+    uint64_t offset;
+    uint64_t nbytes;
+  };
+  std::vector<Entry> entries;
+  uint64_t index_end = sizeof(kMagic) + 2 * sizeof(uint32_t) + sizeof(uint64_t);
+  for (const auto& named : tensors) {
+    const auto& tensor = named.second;
+    AT_CHECK(tensor.defined(), "Cannot save undefined tensor ", named.first);
+    auto contiguous = tensor.toBackend(torch::kCPU).contiguous();
+    const uint64_t nbytes =
+        contiguous.numel() * contiguous.type().elementSizeInBytes();
+    entries.push_back({&named.first, contiguous, 0, nbytes});
+    index_end += sizeof(uint64_t) + named.first.size() + sizeof(int32_t) +
+        sizeof(uint32_t) + tensor.dim() * sizeof(int64_t) +
+        2 * sizeof(uint64_t);
+  }
+  uint64_t offset = align(index_end);
+  for (auto& entry : entries) {
+    entry.offset = offset;
+    offset = align(offset + entry.nbytes);
+  }
+
+  std::ofstream stream(path, std::ios::binary);
+  AT_CHECK(stream, "Unable to open ", path, " for writing");
+  stream.write(kMagic, sizeof(kMagic));
+  write(stream, kVersion);
+  write(stream, static_cast<uint32_t>(kAlignment));
+  write(stream, static_cast<uint64_t>(entries.size()));
+  for (const auto& entry : entries) {
+    write(stream, static_cast<uint64_t>(entry.name->size()));
+    stream.write(entry.name->data(), entry.name->size());
+    write(stream, detail::scalarTypeId(entry.data.type().scalarType()));
+    write(stream, static_cast<uint32_t>(entry.data.dim()));
+    for (auto size : entry.data.sizes()) {
+      write(stream, static_cast<int64_t>(size));
+    }
+    write(stream, entry.offset);
+    write(stream, entry.nbytes);
+  }
+  uint64_t position = index_end;
+  for (const auto& entry : entries) {
+    pad_to(stream, &position, entry.offset);
+    stream.write(
+        static_cast<const char*>(entry.data.data_ptr()), entry.nbytes);
+    position += entry.nbytes;
+  }
+  // Pads the end as well, so that the offsets of empty tensors are never
+  // past the end of the file.
+  pad_to(stream, &position, offset);
+  stream.flush();
+  AT_CHECK(stream, "Error writing ", path);
+}
+
+NamedTensors load_mapped(const std::string& path) {
+  // Without any of the TH_ALLOCATOR_MAPPED flags the file is opened read-only
+  // and mapped copy-on-write, in whole.
+  std::shared_ptr<THMapAllocator> mapping =
+      std::make_shared<THMapAllocator>(path.c_str(), /*flags=*/0, /*size=*/0);
+  const char* base = static_cast<const char*>(mapping->data());
+  const uint64_t size = mapping->size();
+
+  IndexReader reader(base, size);
+  AT_CHECK(
+      reader.read_string(sizeof(kMagic)) == std::string(kMagic, sizeof(kMagic)),
+      path,
+      " is not a mapped tensor file");
+  const auto version = reader.read<uint32_t>();
+  AT_CHECK(
+      version == kVersion, "Unsupported mapped tensor file version ", version);
+  reader.read<uint32_t>(); // alignment, only needed by the writer
+  const auto count = reader.read<uint64_t>();
+
+  NamedTensors tensors;
+  for (uint64_t i = 0; i < count; ++i) {
+    auto name = reader.read_string(reader.read<uint64_t>());
+    const auto type = detail::scalarTypeFromId(reader.read<int32_t>());
+    AT_CHECK(type != torch::Dtype::Undefined, "Undefined tensor ", name);
+    const auto ndim = reader.read<uint32_t>();
+    std::vector<int64_t> sizes;
+    for (uint32_t d = 0; d < ndim; ++d) {
+      sizes.push_back(reader.read<int64_t>());
+    }
+    const auto offset = reader.read<uint64_t>();
+    const auto nbytes = reader.read<uint64_t>();
+    AT_CHECK(
+        offset <= size && nbytes <= size - offset,
+        "Data of tensor ",
+        name,
+        " is out of the bounds of ",
+        path);
+
+    auto& cpu_type = at::getType(at::kCPU, type);
+    int64_t numel = 1;
+    for (auto dim : sizes) {
+      numel *= dim;
+    }
+    AT_CHECK(
+        static_cast<uint64_t>(numel) * cpu_type.elementSizeInBytes() == nbytes,
+        "Size of tensor ",
+        name,
+        " doesn't match its shape");
+    // Each tensor holds a reference to the mapping, which is unmapped once
+    // the last of them goes away.
+    auto data = cpu_type.tensorFromBlob(
+        const_cast<char*>(base) + offset, sizes, [mapping](void*) {});
+    tensors.emplace_back(
+        std::move(name),
+        autograd::make_variable(std::move(data), /*requires_grad=*/false));
+  }
+  return tensors;
+}
+} // namespace torch
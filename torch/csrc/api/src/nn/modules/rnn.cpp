@@ -8,11 +8,13 @@
 #include <ATen/Error.h>
 #include <ATen/optional.h>
 
+#include <algorithm>
 #include <array>
 #include <cmath>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <numeric>
 #include <string>
 #include <tuple>
 #include <unordered_set>
@@ -37,6 +39,35 @@ Tensor linear(Tensor x, Tensor w, Tensor b) {
 }
 } // namespace
 
+PackedSequence pack_padded_sequence(
+    Tensor input,
+    std::vector<int64_t> lengths) {
+  AT_CHECK(
+      !lengths.empty() && lengths.size() == static_cast<size_t>(input.size(1)),
+      "pack_padded_sequence: expected one length per sequence in the batch");
+  AT_CHECK(
+      std::is_sorted(lengths.rbegin(), lengths.rend()),
+      "pack_padded_sequence: lengths must be sorted in decreasing order");
+  AT_CHECK(
+      lengths.back() > 0 && lengths.front() <= input.size(0),
+      "pack_padded_sequence: lengths must lie in [1, ",
+      input.size(0),
+      "]");
+
+  PackedSequence packed;
+  std::vector<Tensor> steps;
+  auto batch_size = static_cast<int64_t>(lengths.size());
+  for (int64_t t = 0; t < lengths.front(); ++t) {
+    while (lengths[batch_size - 1] <= t) {
+      --batch_size;
+    }
+    packed.batch_sizes.push_back(batch_size);
+    steps.push_back(input.select(0, t).narrow(0, 0, batch_size));
+  }
+  packed.data = torch::cat(TensorListView(steps));
+  return packed;
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~ RNNOptionsBase ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
 namespace detail {
@@ -105,6 +136,25 @@ RNNOutput RNNImplBase<Derived>::forward(Tensor input, Tensor state) {
   }
 }
 
+template <typename Derived>
+RNNOutput RNNImplBase<Derived>::packed_forward(
+    const PackedSequence& input,
+    Tensor state) {
+  AT_CHECK(
+      !input.batch_sizes.empty() &&
+          input.data.size(0) ==
+              std::accumulate(
+                  input.batch_sizes.begin(),
+                  input.batch_sizes.end(),
+                  int64_t(0)),
+      "packed_forward: the batch sizes do not add up to the packed data");
+  if (use_cudnn(/*sample=*/input.data)) {
+    return CUDNN_forward(input.data, state, input.batch_sizes);
+  } else {
+    return autograd_packed_forward(input, state);
+  }
+}
+
 template <typename Derived>
 std::vector<Tensor> RNNImplBase<Derived>::flat_weights() const {
   std::vector<Tensor> flat;
@@ -126,16 +176,22 @@ bool RNNImplBase<Derived>::use_cudnn(Tensor sample) const {
 }
 
 template <typename Derived>
-Tensor RNNImplBase<Derived>::create_dropout_state(Tensor input) const {
+Tensor RNNImplBase<Derived>::dropout_state(Tensor input) {
   static const int64_t dropout_seed =
       torch::ones({}, torch::kInt64).random_().toCLong();
   if (options.dropout_ > 0) {
-    torch::DeviceGuard guard(input.device());
-    return torch::_cudnn_init_dropout_state(
-        input.type().toScalarType(torch::kUInt8),
-        options.dropout_,
-        this->is_training(),
-        dropout_seed);
+    // The state is always initialized for training, since cuDNN ignores it
+    // in evaluation mode anyway.
+    if (!dropout_state_.defined() ||
+        dropout_state_.device() != input.device()) {
+      torch::DeviceGuard guard(input.device());
+      dropout_state_ = torch::_cudnn_init_dropout_state(
+          input.type().toScalarType(torch::kUInt8),
+          options.dropout_,
+          /*train=*/true,
+          dropout_seed);
+    }
+    return dropout_state_;
   }
   return torch::empty({}, input.options());
 }
@@ -176,6 +232,64 @@ RNNOutput RNNImplBase<Derived>::autograd_forward(Tensor input, Tensor state) {
   return {output, state_output};
 }
 
+template <typename Derived>
+RNNOutput RNNImplBase<Derived>::autograd_packed_forward(
+    const PackedSequence& input,
+    Tensor state) {
+  // The state of one layer is (batch, hidden), or (2, batch, hidden) when it
+  // stacks the hidden and cell state.
+  const int64_t batch_dimension = has_cell_state_ ? 1 : 0;
+  std::vector<Tensor> layer_state(options.layers_);
+  if (state.defined()) {
+    const auto layer_dimension = state.ndimension() - 3;
+    for (int64_t layer = 0; layer < options.layers_; layer++) {
+      layer_state[layer] = state.select(layer_dimension, layer);
+    }
+  }
+
+  // Sequences end in reverse batch order, so whenever the batch shrinks, the
+  // rows that drop off the end hold the final state of those sequences.
+  std::vector<std::vector<Tensor>> final_state(options.layers_);
+  std::vector<Tensor> outputs;
+  int64_t offset = 0;
+  for (const auto batch_size : input.batch_sizes) {
+    auto x = input.data.narrow(0, offset, batch_size);
+    offset += batch_size;
+    for (int64_t i = 0; i < options.layers_; i++) {
+      auto hidden = layer_state[i];
+      if (hidden.defined()) {
+        const auto running = hidden.size(batch_dimension);
+        if (running > batch_size) {
+          final_state[i].push_back(hidden.narrow(
+              batch_dimension, batch_size, running - batch_size));
+          hidden = hidden.narrow(batch_dimension, 0, batch_size);
+        }
+      }
+      auto layer_output = cell_forward(x, hidden, i);
+      layer_state[i] = layer_output.squeeze(0);
+      x = layer_output[0];
+      if (options.dropout_ > 0 && i != options.layers_ - 1) {
+        x = dropout->forward(x);
+      }
+    }
+    outputs.push_back(x);
+  }
+
+  std::vector<Tensor> new_state;
+  for (int64_t i = 0; i < options.layers_; i++) {
+    final_state[i].push_back(layer_state[i]);
+    std::reverse(final_state[i].begin(), final_state[i].end());
+    new_state.push_back(
+        torch::cat(TensorListView(final_state[i]), batch_dimension));
+  }
+
+  auto state_output = torch::stack(TensorListView(new_state));
+  if (has_cell_state_) {
+    state_output.transpose_(0, 1);
+  }
+  return {torch::cat(TensorListView(outputs)), state_output};
+}
+
 template <typename Derived>
 void RNNImplBase<Derived>::flatten_parameters_for_cudnn() {
   data_ptrs_.clear();
@@ -209,13 +323,25 @@ void RNNImplBase<Derived>::flatten_parameters_for_cudnn() {
         /*batch_first=*/false,
         /*bidirectional=*/false);
   }
-  for (auto& p : params) {
-    data_ptrs_.emplace_back(p->data().data_ptr());
+  data_ptrs_ = parameter_data_ptrs();
+}
+
+template <typename Derived>
+std::vector<void*> RNNImplBase<Derived>::parameter_data_ptrs() const {
+  std::vector<void*> data_ptrs;
+  for (auto& p : this->parameters()) {
+    data_ptrs.emplace_back(p->data().data_ptr());
   }
+  return data_ptrs;
 }
 
 template <typename Derived>
-RNNOutput RNNImplBase<Derived>::CUDNN_forward(Tensor input, Tensor state) {
+RNNOutput RNNImplBase<Derived>::CUDNN_forward(
+    Tensor input,
+    Tensor state,
+    at::IntList batch_sizes) {
+  const auto batch_size =
+      batch_sizes.empty() ? input.size(1) : batch_sizes.front();
   Tensor hx, cx;
   if (state.defined()) {
     if (has_cell_state_) {
@@ -226,31 +352,31 @@ RNNOutput RNNImplBase<Derived>::CUDNN_forward(Tensor input, Tensor state) {
     }
   } else {
     hx = torch::zeros(
-        {options.layers_, input.size(1), options.hidden_size_},
-        input.options());
+        {options.layers_, batch_size, options.hidden_size_}, input.options());
     if (has_cell_state_) {
       cx = torch::zeros(
-          {options.layers_, input.size(1), options.hidden_size_},
+          {options.layers_, batch_size, options.hidden_size_},
           input.options());
     }
   }
-  std::vector<void*> weight_data_ptrs;
-  for (auto& p : this->parameters()) {
-    weight_data_ptrs.emplace_back(p->data().data_ptr());
-  }
 
-  AT_CHECK(
-      weight_data_ptrs == data_ptrs_,
-      "Parameters are unflattened! Code path might be super slow. "
-      "Please call flatten_parameters_for_cudnn() when you muck "
-      "around with storages!")
+  // Someone replaced a parameter storage since we last flattened (e.g. by
+  // loading a checkpoint or cloning), so move the parameters back into one
+  // buffer. If they alias, flattening is not possible and cuDNN has to copy
+  // the weights on every call instead.
+  const auto weight_data_ptrs = parameter_data_ptrs();
+  if (weight_data_ptrs != data_ptrs_) {
+    flatten_parameters_for_cudnn();
+  }
+  const auto weight_buf =
+      parameter_data_ptrs() == data_ptrs_ ? flat_weights_ : Tensor();
 
   // cudnn_output = std::tuple<output, hy, cy, reserve, new_weight_buf>
   auto cudnn_output = torch::_cudnn_rnn(
       /*input=*/input,
       /*weight=*/TensorListView(flat_weights()),
       /*weight_stride0=*/options.with_bias_ ? 4 : 2,
-      /*weight_buf=*/flat_weights_,
+      /*weight_buf=*/weight_buf,
       /*hx=*/hx,
       /*cx=*/cx,
       /*mode=*/static_cast<int64_t>(*cudnn_mode_),
@@ -260,8 +386,8 @@ RNNOutput RNNImplBase<Derived>::CUDNN_forward(Tensor input, Tensor state) {
       /*dropout=*/options.dropout_,
       /*train=*/this->is_training(),
       /*bidirectional=*/false,
-      /*batch_sizes=*/{},
-      /*dropout_state=*/create_dropout_state(input));
+      /*batch_sizes=*/batch_sizes,
+      /*dropout_state=*/dropout_state(input));
 
   Tensor hidden_output = std::get<1>(cudnn_output);
   if (has_cell_state_) {
@@ -5,6 +5,7 @@
 #include <ATen/ATen.h>
 
 #include <functional>
+#include <vector>
 
 namespace torch {
 namespace optim {
@@ -19,24 +20,24 @@ const AdagradOptions& Adagrad::options() const noexcept {
 /// Adapted from
 /// https://github.com/pytorch/pytorch/blob/master/torch/optim/adagrad.py
 void Adagrad::step() {
-  for (size_t i = 0; i < parameters_.size(); ++i) {
-    auto& grad = parameters_.at(i).grad();
-    auto& p = parameters_.at(i).data();
-    if (!grad.defined())
-      continue;
-
-    auto d_p = Tensor(grad).data();
-    if (options_.weight_decay_ > 0) {
-      d_p.add_(p, options_.weight_decay_);
+  for (const auto& group : parameter_groups()) {
+    std::vector<at::Tensor> params, grads, sums;
+    std::vector<int64_t> steps;
+    for (auto i : group) {
+      params.push_back(parameters_.at(i).data());
+      grads.push_back(Tensor(parameters_.at(i).grad()).data());
+      sums.push_back(buffer_at(sum_, i).data());
+      step_.at(i) += 1.0;
+      steps.push_back(static_cast<int64_t>(step_.at(i)));
     }
-    step_.at(i) += 1.0;
-    auto clr = options_.learning_rate_ /
-        (1.0 + (step_.at(i) - 1.0) * options_.lr_decay_);
-
-    auto sum = buffer_at(sum_, i);
-    sum.data().addcmul_(d_p, d_p, 1.0);
-    auto std = sum_.at(i).data().sqrt().add_(1e-10);
-    p.addcdiv_(d_p, std, -clr);
+    torch::_fused_adagrad_step(
+        params,
+        grads,
+        sums,
+        steps,
+        options_.learning_rate_,
+        options_.lr_decay_,
+        options_.weight_decay_);
   }
 }
 } // namespace optim
@@ -5,8 +5,8 @@
 
 #include <ATen/ATen.h>
 
-#include <cmath>
 #include <functional>
+#include <vector>
 
 namespace torch {
 namespace optim {
@@ -19,45 +19,35 @@ const AdamOptions& Adam::options() const noexcept {
 }
 
 void Adam::step() {
-  for (size_t i = 0; i < parameters_.size(); ++i) {
-    auto& grad = parameters_.at(i).grad();
-    auto& p = parameters_.at(i).data();
-    if (!grad.defined()) {
-      continue;
+  for (const auto& group : parameter_groups()) {
+    std::vector<at::Tensor> params, grads, exp_averages, exp_average_sqs,
+        max_exp_average_sqs;
+    std::vector<int64_t> steps;
+    for (auto i : group) {
+      params.push_back(parameters_.at(i).data());
+      grads.push_back(
+          torch::autograd::as_variable_ref(parameters_.at(i).grad()).data());
+      exp_averages.push_back(buffer_at(exp_average_buffers_, i).data());
+      exp_average_sqs.push_back(buffer_at(exp_average_sq_buffers_, i).data());
+      if (options_.amsgrad_) {
+        max_exp_average_sqs.push_back(
+            buffer_at(max_exp_average_sq_buffers_, i).data());
+      }
+      step_buffers_.at(i) += 1;
+      steps.push_back(step_buffers_.at(i));
     }
-
-    auto exp_average = buffer_at(exp_average_buffers_, i).data();
-    auto exp_average_sq = buffer_at(exp_average_sq_buffers_, i).data();
-
-    step_buffers_.at(i) += 1;
-
-    auto d_p = torch::autograd::as_variable_ref(grad).data();
-    if (options_.weight_decay_ > 0) {
-      d_p.add_(p, options_.weight_decay_);
-    }
-
-    exp_average.mul_(options_.beta1_).add_(d_p, 1 - options_.beta1_);
-    exp_average_sq.mul_(options_.beta2_)
-        .addcmul_(d_p, d_p, 1 - options_.beta2_);
-
-    at::Tensor denom;
-    if (options_.amsgrad_) {
-      auto max_exp_average_sq =
-          buffer_at(max_exp_average_sq_buffers_, i).data();
-      torch::max_out(max_exp_average_sq, max_exp_average_sq, exp_average_sq);
-      denom = max_exp_average_sq.sqrt().add_(options_.eps_);
-    } else {
-      denom = exp_average_sq.sqrt().add_(options_.eps_);
-    }
-
-    const auto bias_correction1 =
-        1 - std::pow(options_.beta1_, step_buffers_.at(i));
-    const auto bias_correction2 =
-        1 - std::pow(options_.beta2_, step_buffers_.at(i));
-    const auto step_size = options_.learning_rate_ *
-        std::sqrt(bias_correction2) / bias_correction1;
-
-    p.addcdiv_(exp_average, denom, -step_size);
+    torch::_fused_adam_step(
+        params,
+        grads,
+        exp_averages,
+        exp_average_sqs,
+        max_exp_average_sqs,
+        steps,
+        options_.learning_rate_,
+        options_.beta1_,
+        options_.beta2_,
+        options_.weight_decay_,
+        options_.eps_);
   }
 }
 
@@ -3,6 +3,7 @@
 #include <torch/nn/cursor.h>
 #include <torch/tensor.h>
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -37,6 +38,26 @@ void OptimizerBase::zero_grad() {
   }
 }
 
+std::vector<std::vector<size_t>> OptimizerBase::parameter_groups() const {
+  std::vector<std::pair<Device, ScalarType>> keys;
+  std::vector<std::vector<size_t>> groups;
+  for (size_t i = 0; i < parameters_.size(); ++i) {
+    const auto& parameter = parameters_[i];
+    if (!parameter.grad().defined()) {
+      continue;
+    }
+    const auto key = std::make_pair(parameter.device(), parameter.dtype());
+    const auto it = std::find(keys.begin(), keys.end(), key);
+    if (it == keys.end()) {
+      keys.push_back(key);
+      groups.push_back({i});
+    } else {
+      groups[it - keys.begin()].push_back(i);
+    }
+  }
+  return groups;
+}
+
 size_t OptimizerBase::size() const noexcept {
   return parameters_.size();
 }
@@ -5,6 +5,7 @@
 #include <ATen/ATen.h>
 
 #include <functional>
+#include <vector>
 
 namespace torch {
 namespace optim {
@@ -19,40 +20,32 @@ const RMSpropOptions& RMSprop::options() const noexcept {
 /// Adapted from
 /// https://github.com/pytorch/pytorch/blob/master/torch/optim/rmsprop.py
 void RMSprop::step() {
-  for (size_t i = 0; i < parameters_.size(); ++i) {
-    auto& grad = parameters_.at(i).grad();
-    auto& p = parameters_.at(i).data();
-    if (!grad.defined()) {
-      continue;
-    }
-
-    auto d_p = torch::autograd::as_variable_ref(grad).data();
-    if (options_.weight_decay_ > 0) {
-      d_p.add_(p, options_.weight_decay_);
-    }
-
-    auto square_average = buffer_at(square_average_buffers_, i).data();
-    square_average.mul_(options_.alpha_)
-        .addcmul_(d_p, d_p, 1.0 - options_.alpha_);
-
-    at::Tensor average;
-    if (options_.centered_ > 0) {
-      auto grad_average = buffer_at(grad_average_buffers_, i).data();
-      grad_average.mul_(options_.alpha_).add_(d_p, 1.0 - options_.alpha_);
-      average = square_average.addcmul(grad_average, grad_average, -1.0)
-                    .sqrt()
-                    .add_(options_.eps_);
-    } else {
-      average = square_average.sqrt().add_(options_.eps_);
-    }
-
-    if (options_.momentum_ > 0) {
-      auto momentum = buffer_at(momentum_buffers_, i).data();
-      momentum.mul_(options_.momentum_).addcdiv_(d_p, average);
-      p.add_(momentum, -options_.learning_rate_);
-    } else {
-      p.addcdiv_(d_p, average, -options_.learning_rate_);
+  for (const auto& group : parameter_groups()) {
+    std::vector<at::Tensor> params, grads, square_averages, grad_averages,
+        momentum_buffers;
+    for (auto i : group) {
+      params.push_back(parameters_.at(i).data());
+      grads.push_back(
+          torch::autograd::as_variable_ref(parameters_.at(i).grad()).data());
+      square_averages.push_back(buffer_at(square_average_buffers_, i).data());
+      if (options_.centered_ > 0) {
+        grad_averages.push_back(buffer_at(grad_average_buffers_, i).data());
+      }
+      if (options_.momentum_ > 0) {
+        momentum_buffers.push_back(buffer_at(momentum_buffers_, i).data());
+      }
     }
+    torch::_fused_rmsprop_step(
+        params,
+        grads,
+        square_averages,
+        grad_averages,
+        momentum_buffers,
+        options_.learning_rate_,
+        options_.alpha_,
+        options_.eps_,
+        options_.weight_decay_,
+        options_.momentum_);
   }
 }
 } // namespace optim
@@ -5,6 +5,7 @@
 #include <ATen/ATen.h>
 
 #include <functional>
+#include <vector>
 
 namespace torch {
 namespace optim {
@@ -15,34 +16,25 @@ const SGDOptions& SGD::options() const noexcept {
 }
 
 void SGD::step() {
-  for (size_t i = 0; i < parameters_.size(); ++i) {
-    auto& grad = parameters_.at(i).grad();
-    auto& p = parameters_.at(i).data();
-
-    if (!grad.defined()) {
-      continue;
-    }
-
-    auto d_p = torch::Tensor(grad).data();
-    if (options_.weight_decay_ > 0) {
-      d_p.add_(p, options_.weight_decay_);
-    }
-
-    if (options_.momentum_ != 0) {
-      auto momentum = buffer_at(momentum_buffers_, i).data();
-      if (iteration_ == 0) {
-        momentum.mul_(options_.momentum_).add_(d_p);
-      } else {
-        momentum.mul_(options_.momentum_).add_(d_p, 1 - options_.dampening_);
-      }
-      if (options_.nesterov_) {
-        d_p = d_p.add(momentum, options_.momentum_);
-      } else {
-        d_p = momentum;
+  for (const auto& group : parameter_groups()) {
+    std::vector<at::Tensor> params, grads, momentum_buffers;
+    for (auto i : group) {
+      params.push_back(parameters_.at(i).data());
+      grads.push_back(torch::Tensor(parameters_.at(i).grad()).data());
+      if (options_.momentum_ != 0) {
+        momentum_buffers.push_back(buffer_at(momentum_buffers_, i).data());
       }
     }
-
-    p.add_(d_p, -options_.learning_rate_);
+    torch::_fused_sgd_step(
+        params,
+        grads,
+        momentum_buffers,
+        options_.learning_rate_,
+        options_.momentum_,
+        options_.dampening_,
+        options_.weight_decay_,
+        options_.nesterov_,
+        /*first_step=*/iteration_ == 0);
   }
   iteration_ += 1;
 }
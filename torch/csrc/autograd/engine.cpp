@@ -4,6 +4,7 @@
 #include "torch/csrc/autograd/functions/basic_ops.h"
 #include "torch/csrc/autograd/grad_mode.h"
 #include "torch/csrc/autograd/anomaly_mode.h"
+#include "torch/csrc/autograd/small_object_pool.h"
 #include "torch/csrc/autograd/variable.h"
 
 #include <ATen/DeviceGuard.h>
@@ -46,11 +47,15 @@ static thread_local int worker_device = NO_DEVICE;
 static thread_local bool checkpoint_valid = true;
 
 // XXX: Changes to the way multithreading works in execute should be done with
-// great care. Right now the implementation guarantees that a single function's
-// apply will never be entered concurrently (even if multiple graphs are
-// executed at the same time). Adding multiple threads per-device or removing
-// engine thread affinity to the device can break this invariant, and we depend
-// on it in a few places (e.g. AccumulateGrad function).
+// great care. With a single CPU worker the implementation guarantees that a
+// single function's apply will never be entered concurrently (even if
+// multiple graphs are executed at the same time). With several CPU workers
+// (see Engine::set_num_cpu_threads) the functions of one graph still run at
+// most once each, but a function shared by graphs executed at the same time
+// can run on two CPU workers at once, so functions with state that outlives
+// a backward pass must synchronize it themselves (e.g. AccumulateGrad).
+// Gradients flowing into a function are always accumulated into its
+// InputBuffer under the GraphTask's mutex.
 
 struct FunctionTask {
   GraphTask* base;
@@ -77,9 +82,16 @@ struct ReadyQueue {
   std::priority_queue<FunctionTask, std::vector<FunctionTask>, CompareFunctionTaskTime> heap;
   std::condition_variable not_empty;
   std::mutex mutex;
+  uint64_t wake_count = 0;
 
   void push(FunctionTask item);
-  FunctionTask pop();
+  // Blocks until there is a task, until graph_task (if given) has no
+  // outstanding tasks left or until wake_all is called. In the latter two
+  // cases it returns a task without a base.
+  FunctionTask pop(GraphTask* graph_task = nullptr);
+  // makes every thread waiting in pop return, so that they can check their
+  // graph_task or whether they are still needed
+  void wake_all();
 };
 
 // Note [Reentrant backwards]
@@ -119,6 +131,21 @@ struct ReadyQueue {
 //    evaluate_function() completes.
 
 
+// Note [Executing on the calling thread]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// A thread that is not a worker blocks in execute() until the backward is
+// done anyway. When none of the Functions of the graph calls into Python (no
+// Python Functions and no Python hooks), it may as well do the CPU work of
+// its graph itself, which it does from a ReadyQueue of the GraphTask, while
+// the device workers keep doing the work on their devices and push the CPU
+// work of this graph to that queue. As the Python bindings release the GIL
+// around execute(), threads each calling backward() on such a graph run
+// their passes in parallel, instead of one after the other on the CPU
+// worker, and none of them takes the GIL. Graphs which call into Python
+// keep running on the CPU workers: their Python code serializes on the GIL
+// anyway. So do all graphs when there are several CPU workers (see
+// Engine::set_num_cpu_threads), which share the CPU work of a graph.
+
 // GraphTask holds metadata needed for a single execution of backward()
 struct GraphTask {
   std::exception_ptr exception;
@@ -133,8 +160,21 @@ struct GraphTask {
   // Notified when a task finishes executing.  Check outstanding_tasks to see
   // if all tasks are done.
   std::condition_variable not_done;
-  std::unordered_map<Function*, InputBuffer> not_ready;
-  std::unordered_map<Function*, int> dependencies;
+
+  // Most Functions of the graph have an entry in the maps below, so their
+  // nodes come from an arena that is freed with the task. Like the maps, it is
+  // only modified under mutex once the task runs.
+  Arena arena;
+  template <typename T>
+  using FunctionMap = std::unordered_map<
+      Function*,
+      T,
+      std::hash<Function*>,
+      std::equal_to<Function*>,
+      ArenaAllocator<std::pair<Function* const, T>>>;
+
+  FunctionMap<InputBuffer> not_ready;
+  FunctionMap<int> dependencies;
 
   struct ExecInfo {
     struct Capture {
@@ -155,7 +195,7 @@ struct GraphTask {
   // get executed. If it's not empty, only functions that have an entry and this entry
   // has needed == True should be executed.
   // exec_info.empty() means it's .backward(), otherwise it's .grad().
-  std::unordered_map<Function*, ExecInfo> exec_info;
+  FunctionMap<ExecInfo> exec_info;
   std::vector<Variable> captured_vars;
 
   void init_to_execute(Function& graph_root, const edge_list& captures);
@@ -164,6 +204,14 @@ struct GraphTask {
   // See Note [Reentrant backwards]
   int owner;
 
+  // Whether a Function of the graph may call into Python (see
+  // Engine::runs_python).
+  bool runs_python = false;
+  // The CPU work of graphs that don't call into Python is done by the thread
+  // that executes them, from this queue, instead of by the CPU workers. See
+  // Note [Executing on the calling thread]
+  std::shared_ptr<ReadyQueue> cpu_ready_queue;
+
   bool can_checkpoint() {
     return exec_info.empty();
   }
@@ -176,8 +224,10 @@ struct GraphTask {
     , grad_mode(grad_mode)
     , mutex()
     , not_done()
-    , not_ready()
-    , dependencies()
+    , arena()
+    , not_ready(FunctionMap<InputBuffer>::allocator_type(arena))
+    , dependencies(FunctionMap<int>::allocator_type(arena))
+    , exec_info(FunctionMap<ExecInfo>::allocator_type(arena))
     , owner(NO_DEVICE) {}
 };
 
@@ -190,13 +240,28 @@ auto ReadyQueue::push(FunctionTask item) -> void {
   not_empty.notify_one();
 }
 
-auto ReadyQueue::pop() -> FunctionTask {
+auto ReadyQueue::pop(GraphTask* graph_task) -> FunctionTask {
   std::unique_lock<std::mutex> lock(mutex);
-  not_empty.wait(lock, [this]{ return !heap.empty(); });
+  auto wake_count_at_start = wake_count;
+  not_empty.wait(lock, [this, graph_task, wake_count_at_start]{
+    return !heap.empty() || wake_count != wake_count_at_start ||
+        (graph_task && graph_task->outstanding_tasks.load() == 0);
+  });
+  if (heap.empty()) {
+    return FunctionTask(nullptr, nullptr, InputBuffer(0));
+  }
   auto task = std::move(const_cast<FunctionTask&>(heap.top())); heap.pop();
   return task;
 }
 
+auto ReadyQueue::wake_all() -> void {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    ++wake_count;
+  }
+  not_empty.notify_all();
+}
+
 Engine::Engine() : ready_queues() {
 }
 
@@ -225,11 +290,22 @@ auto Engine::thread_init(int device) -> void {
 // It's all ok and is handled right now, but it should be accounted for
 // in case this code is to be changed.
 auto Engine::thread_main(GraphTask *graph_task) -> void {
-  auto queue = ready_queues[worker_device + 1];
+  auto queue = graph_task && graph_task->cpu_ready_queue
+      ? graph_task->cpu_ready_queue
+      : ready_queues[worker_device + 1];
   // Why the test on graph_task->outstanding_tasks?  See
   // Note [Reentrant backwards]
   while (!graph_task || graph_task->outstanding_tasks > 0) {
-    FunctionTask task = queue->pop();
+    // surplus CPU workers exit once they are out of reentrant calls
+    if (!graph_task && worker_device == -1 &&
+        num_cpu_threads_running.load() > num_cpu_threads.load() && stop_cpu_thread()) {
+      return;
+    }
+    FunctionTask task = queue->pop(graph_task);
+    if (!task.base) {
+      // graph_task finished, or woken up by set_num_cpu_threads
+      continue;
+    }
     if (task.fn && !task.base->has_error.load()) {
       GradMode::set_enabled(task.base->grad_mode);
       try {
@@ -244,9 +320,24 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
     auto base_owner = task.base->owner;
     // Task from a non-worker thread. Easy case.
     if (base_owner == NO_DEVICE) {
+      // The owner may return from execute as soon as outstanding_tasks is 0,
+      // keep its queue alive until we've woken it up.
+      auto cpu_ready_queue = task.base->cpu_ready_queue;
       if (--task.base->outstanding_tasks == 0) {
-        std::lock_guard<std::mutex> lock(task.base->mutex);
-        task.base->not_done.notify_all();
+        if (cpu_ready_queue) {
+          // The owner is waiting in pop, not on not_done
+          cpu_ready_queue->wake_all();
+        } else {
+          std::lock_guard<std::mutex> lock(task.base->mutex);
+          task.base->not_done.notify_all();
+        }
+      }
+    } else if (base_owner == -1) {
+      // The owner is one of the CPU workers, but not necessarily this one,
+      // and a dummy task could be picked up by any of them. Wake them all
+      // up instead, the owner sees that its graph_task is done in pop.
+      if (--task.base->outstanding_tasks == 0) {
+        ready_queue(-1).wake_all();
       }
     } else {
       // If it's a task initiated from this thread, decrease the counter, but
@@ -439,7 +530,7 @@ auto Engine::evaluate_function(FunctionTask& task) -> void {
       InputBuffer input_buffer(next.function->num_inputs());
       input_buffer.add(next.input_nr, std::move(output));
       if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
+        auto& queue = ready_queue(*task.base, input_buffer.device());
         queue.push(FunctionTask(task.base, next.function, std::move(input_buffer)));
       } else {
         not_ready.emplace(next.function.get(), std::move(input_buffer));
@@ -449,7 +540,7 @@ auto Engine::evaluate_function(FunctionTask& task) -> void {
       auto &input_buffer = not_ready_it->second;
       input_buffer.add(next.input_nr, std::move(output));
       if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
+        auto& queue = ready_queue(*task.base, input_buffer.device());
         queue.push(FunctionTask(task.base, next.function, std::move(input_buffer)));
         not_ready.erase(not_ready_it);
       }
@@ -472,7 +563,12 @@ auto Engine::compute_dependencies(Function* root, GraphTask& task) -> void {
       if (auto next_ptr = edge.function.get()) {
         dependencies[next_ptr] += 1;
         const bool was_inserted = seen.insert(next_ptr).second;
-        if (was_inserted) queue.push_back(next_ptr);
+        if (was_inserted) {
+          queue.push_back(next_ptr);
+          if (!task.runs_python && runs_python(*next_ptr)) {
+            task.runs_python = true;
+          }
+        }
       }
     }
   }
@@ -517,10 +613,22 @@ auto Engine::execute(const edge_list& input_roots,
   if (!outputs.empty()) {
     graph_task.init_to_execute(*graph_root, outputs);
   }
-  ready_queue(-1).push(FunctionTask(&graph_task, std::move(graph_root), InputBuffer(0)));
+  const bool on_calling_thread = worker_device == NO_DEVICE &&
+      !graph_task.runs_python && num_cpu_threads.load() == 1;
+  if (on_calling_thread) {
+    graph_task.cpu_ready_queue = std::make_shared<ReadyQueue>();
+  }
+  ready_queue(graph_task, -1).push(
+      FunctionTask(&graph_task, std::move(graph_root), InputBuffer(0)));
 
-  // Not a worker
-  if (worker_device == NO_DEVICE) {
+  if (on_calling_thread) {
+    // See Note [Executing on the calling thread]. thread_main sets the grad
+    // mode of every task it runs, restore ours when it's done.
+    AutoGradMode grad_mode(GradMode::is_enabled());
+    lock.unlock();
+    thread_main(&graph_task);
+  } else if (worker_device == NO_DEVICE) {
+    // Not a worker
     // Wait for all tasks to complete
     graph_task.not_done.wait(lock, [&graph_task]{
       return graph_task.outstanding_tasks.load() == 0;
@@ -588,7 +696,51 @@ auto Engine::ready_queue(int device) -> ReadyQueue& {
   return *ready_queues.at(device + 1);
 }
 
+auto Engine::ready_queue(GraphTask& graph_task, int device) -> ReadyQueue& {
+  if (device == -1 && graph_task.cpu_ready_queue) {
+    return *graph_task.cpu_ready_queue;
+  }
+  return ready_queue(device);
+}
+
+auto Engine::set_num_cpu_threads(int num_threads) -> void {
+  if (num_threads < 1) {
+    throw std::runtime_error("the autograd engine needs at least one CPU thread");
+  }
+  std::lock_guard<std::mutex> lock(cpu_threads_mutex);
+  num_cpu_threads = num_threads;
+  if (ready_queues.empty()) {
+    return; // start_threads will start them
+  }
+  while (num_cpu_threads_running < num_threads) {
+    start_cpu_thread();
+  }
+  // let the surplus threads notice
+  ready_queue(-1).wake_all();
+}
+
+auto Engine::get_num_cpu_threads() -> int {
+  return num_cpu_threads.load();
+}
+
+// requires cpu_threads_mutex
+auto Engine::start_cpu_thread() -> void {
+  ++num_cpu_threads_running;
+  std::thread t(&Engine::thread_init, this, -1);
+  t.detach();
+}
+
+auto Engine::stop_cpu_thread() -> bool {
+  std::lock_guard<std::mutex> lock(cpu_threads_mutex);
+  if (num_cpu_threads_running <= num_cpu_threads) {
+    return false;
+  }
+  --num_cpu_threads_running;
+  return true;
+}
+
 auto Engine::start_threads() -> void {
+  std::lock_guard<std::mutex> lock(cpu_threads_mutex);
   int num_devices = 0;
 #ifdef USE_CUDA
   // check for case of compiled with CUDA but no available devices
@@ -602,7 +754,10 @@ auto Engine::start_threads() -> void {
   ready_queues = std::vector<std::shared_ptr<ReadyQueue>>(num_threads);
   for (auto& queue : ready_queues)
     queue.reset(new ReadyQueue());
-  for (int i = 0; i < num_threads; ++i) {
+  while (num_cpu_threads_running < num_cpu_threads) {
+    start_cpu_thread();
+  }
+  for (int i = 1; i < num_threads; ++i) {
     std::thread t(&Engine::thread_init, this, i - 1);
     t.detach();
   }
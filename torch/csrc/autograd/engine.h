@@ -7,10 +7,12 @@
 #include "torch/csrc/autograd/input_buffer.h"
 #include "torch/csrc/autograd/anomaly_mode.h"
 
+#include <atomic>
 #include <deque>
 #include <exception>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -45,16 +47,33 @@ struct Engine {
   virtual std::unique_ptr<AnomalyMetadata> make_anomaly_metadata() {
     return nullptr;
   }
+  // Whether fn may call into Python. The thread executing a graph in which
+  // no Function does runs its CPU work itself, see
+  // Note [Executing on the calling thread] in engine.cpp.
+  virtual bool runs_python(const Function& fn) {
+    return false;
+  }
 
   void queue_callback(std::function<void()> callback);
 
   bool is_checkpoint_valid();
 
+  // Number of threads that run Functions on the CPU, 1 by default. With more
+  // than one, independent Functions of wide backward graphs run
+  // concurrently, each of them still using intra-op parallelism, so the two
+  // should be balanced against the number of cores. It can be changed at
+  // any time; surplus threads exit when they become idle.
+  void set_num_cpu_threads(int num_threads);
+  int get_num_cpu_threads();
+
 protected:
   void compute_dependencies(Function* root, GraphTask& task);
   void evaluate_function(FunctionTask& task);
   ReadyQueue& ready_queue(int device);
+  ReadyQueue& ready_queue(GraphTask& graph_task, int device);
   void start_threads();
+  void start_cpu_thread();
+  bool stop_cpu_thread();
   virtual void thread_init(int device);
   virtual void thread_main(GraphTask *task);
   virtual void thread_on_exception(FunctionTask& task, std::exception& e);
@@ -63,6 +82,10 @@ protected:
   std::vector<std::shared_ptr<ReadyQueue>> ready_queues;
   std::vector<std::function<void()>> final_callbacks;
   std::mutex post_callbacks_lock;
+  std::atomic<int> num_cpu_threads {1};
+  std::atomic<int> num_cpu_threads_running {0};
+  // guards starting and stopping CPU threads
+  std::mutex cpu_threads_mutex;
 };
 
 // allow python_engine to override the default engine when it loads
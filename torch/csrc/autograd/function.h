@@ -6,6 +6,7 @@
 #include "torch/csrc/autograd/anomaly_mode.h"
 #include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/saved_variable.h"
+#include "torch/csrc/autograd/small_object_pool.h"
 #include "torch/csrc/autograd/type_and_shape.h"
 #include "torch/csrc/autograd/variable.h"
 #include "torch/csrc/utils/auto_unique_ptr.h"
@@ -13,6 +14,7 @@
 #include "torch/csrc/utils/variadic.h"
 
 #include <ATen/ATen.h>
+#include <ATen/SmallVector.h>
 
 #include <algorithm>
 #include <cstdint>
@@ -30,7 +32,8 @@ struct FunctionPreHook;
 
 using tensor_list = std::vector<at::Tensor>;
 using variable_list = std::vector<Variable>;
-using edge_list = std::vector<Edge>;
+// Most Functions have one or two next edges, which are then stored inline.
+using edge_list = at::SmallVector<Edge, 2>;
 using saved_variable_list = std::vector<SavedVariable>;
 using IndexRange = std::pair<size_t, size_t>;
 
@@ -112,6 +115,21 @@ struct Function : std::enable_shared_from_this<Function> {
   Function& operator=(Function&& other) = delete;
   virtual ~Function() = default;
 
+  /// Functions created with `new` come from the thread-local cache of small
+  /// blocks (see small_object_pool.h), as one is recorded for every
+  /// differentiable op.
+  static void* operator new(size_t size) {
+    return allocateSmallObject(size);
+  }
+  static void operator delete(void* ptr, size_t size) noexcept {
+    freeSmallObject(ptr, size);
+  }
+  /// Declaring the above hides the global placement forms.
+  static void* operator new(size_t /*size*/, void* place) noexcept {
+    return place;
+  }
+  static void operator delete(void* /*ptr*/, void* /*place*/) noexcept {}
+
   /// Evaluates the function on the given inputs and returns the result of the
   /// function call.
   variable_list operator()(variable_list&& inputs) {
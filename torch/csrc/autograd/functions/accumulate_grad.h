@@ -3,6 +3,8 @@
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/autograd/variable.h"
 
+#include <mutex>
+
 namespace torch { namespace autograd {
 
 struct AccumulateGrad : public Function {
@@ -11,6 +13,11 @@ struct AccumulateGrad : public Function {
   variable_list apply(variable_list&& inputs) override;
 
   Variable variable;
+
+private:
+  // with several CPU workers in the engine, graphs that are executed at the
+  // same time and share this leaf can call apply concurrently
+  std::mutex mutex_;
 };
 
 }} // namespace torch::autograd
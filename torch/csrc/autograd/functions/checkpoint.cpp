@@ -0,0 +1,140 @@
+#include "torch/csrc/autograd/functions/checkpoint.h"
+
+#include "torch/csrc/autograd/engine.h"
+#include "torch/csrc/autograd/functions/utils.h"
+#include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/autograd/variable.h"
+
+#include <ATen/ATen.h>
+
+#include <stdexcept>
+#include <utility>
+
+namespace torch { namespace autograd {
+
+namespace {
+
+at::Generator& cpuGenerator() {
+  return at::globalContext().defaultGenerator(at::Backend::CPU);
+}
+
+std::unique_ptr<at::Generator> copyCPUGenerator() {
+  auto copy = at::CPU(at::kByte).generator();
+  copy->copy(cpuGenerator());
+  return copy;
+}
+
+// Sets the state of the CPU generator for the lifetime of the guard and
+// restores the previous one afterwards.
+struct CPUGeneratorGuard {
+  explicit CPUGeneratorGuard(const at::Generator* state) {
+    if (state) {
+      prev_state = copyCPUGenerator();
+      cpuGenerator().copy(*state);
+    }
+  }
+  ~CPUGeneratorGuard() {
+    if (prev_state) {
+      cpuGenerator().copy(*prev_state);
+    }
+  }
+
+  std::unique_ptr<at::Generator> prev_state;
+};
+
+} // anonymous namespace
+
+variable_list checkpoint(
+    checkpoint_function fn,
+    const variable_list& inputs,
+    bool preserve_rng_state) {
+  std::unique_ptr<at::Generator> rng_state;
+  if (preserve_rng_state) {
+    rng_state = copyCPUGenerator();
+  }
+  variable_list outputs;
+  {
+    AutoGradMode grad_mode(false);
+    outputs = fn(inputs);
+  }
+  tensor_list output_data;
+  output_data.reserve(outputs.size());
+  for (auto& output : outputs) {
+    output_data.push_back(output.defined() ? output.data() : at::Tensor());
+  }
+  return wrap_outputs(inputs, std::move(output_data), [&](edge_list&& next_edges) {
+    auto grad_fn = std::make_shared<CheckpointBackward>(std::move(fn), std::move(next_edges));
+    for (auto& input : inputs) {
+      grad_fn->inputs.emplace_back(input, /*is_output=*/false);
+      grad_fn->inputs_requires_grad.push_back(input.defined() && input.requires_grad());
+    }
+    grad_fn->cpu_rng_state = std::move(rng_state);
+    return grad_fn;
+  });
+}
+
+CheckpointBackward::CheckpointBackward(checkpoint_function fn_, edge_list&& next_edges)
+    : Function(std::move(next_edges))
+    , fn(std::move(fn_)) {}
+
+auto CheckpointBackward::apply(variable_list&& grads) -> variable_list {
+  if (!fn) {
+    throw std::runtime_error(ERR_BACKWARD_TWICE);
+  }
+  auto& engine = Engine::get_default_engine();
+  if (!engine.is_checkpoint_valid()) {
+    throw std::runtime_error(
+        "Checkpointing is not compatible with .grad(), please use .backward() if possible");
+  }
+
+  // Recompute on inputs detached from the rest of the graph, so that the
+  // nested backward stops at them.
+  variable_list detached_inputs;
+  detached_inputs.reserve(inputs.size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    auto input = inputs[i].unpack();
+    if (input.defined()) {
+      detached_inputs.push_back(make_variable(input.data(), inputs_requires_grad[i]));
+    } else {
+      detached_inputs.emplace_back();
+    }
+  }
+  variable_list outputs;
+  {
+    CPUGeneratorGuard rng_guard(cpu_rng_state.get());
+    AutoGradMode grad_mode(true);
+    outputs = fn(detached_inputs);
+  }
+  if (outputs.size() != grads.size()) {
+    throw std::runtime_error(
+        "CheckpointBackward: the recomputation returned a different number of outputs");
+  }
+
+  edge_list roots;
+  variable_list root_grads;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    if (outputs[i].defined() && outputs[i].requires_grad() && grads[i].defined()) {
+      roots.push_back(outputs[i].gradient_edge());
+      root_grads.push_back(std::move(grads[i]));
+    }
+  }
+  if (!roots.empty()) {
+    engine.execute(roots, root_grads, /*keep_graph=*/false, /*create_graph=*/false);
+  }
+
+  variable_list grad_inputs(detached_inputs.size());
+  for (size_t i = 0; i < detached_inputs.size(); ++i) {
+    if (inputs_requires_grad[i] && should_compute_output(i)) {
+      grad_inputs[i] = detached_inputs[i].grad();
+    }
+  }
+  return grad_inputs;
+}
+
+void CheckpointBackward::release_variables() {
+  fn = nullptr;
+  inputs.clear();
+  cpu_rng_state.reset();
+}
+
+}}
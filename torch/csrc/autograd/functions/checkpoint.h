@@ -0,0 +1,45 @@
+#pragma once
+
+#include "torch/csrc/autograd/function.h"
+#include "torch/csrc/autograd/saved_variable.h"
+#include "torch/csrc/autograd/variable.h"
+
+#include <ATen/Generator.h>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace torch { namespace autograd {
+
+using checkpoint_function = std::function<variable_list(const variable_list&)>;
+
+// Runs fn on inputs without recording the graph in between, and records a
+// single CheckpointBackward instead. Only the inputs are saved; backward
+// runs fn again with grad mode enabled and backpropagates through the
+// recomputed graph. With preserve_rng_state, the state of the CPU generator
+// is restored before the recomputation, so that e.g. dropout masks match
+// those of the forward pass. fn must otherwise compute the same thing both
+// times.
+//
+// Like the Python checkpoint utility, this doesn't work with
+// torch.autograd.grad, only with backward().
+variable_list checkpoint(
+    checkpoint_function fn,
+    const variable_list& inputs,
+    bool preserve_rng_state = true);
+
+struct CheckpointBackward : public Function {
+  CheckpointBackward(checkpoint_function fn, edge_list&& next_edges);
+
+  variable_list apply(variable_list&& grads) override;
+  void release_variables() override;
+
+  checkpoint_function fn;
+  std::vector<SavedVariable> inputs;
+  std::vector<bool> inputs_requires_grad;
+  // the state of the CPU generator before the forward pass, if preserved
+  std::unique_ptr<at::Generator> cpu_rng_state;
+};
+
+}}
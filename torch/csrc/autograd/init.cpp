@@ -2,9 +2,12 @@
 
 #include "torch/csrc/Exceptions.h"
 #include "torch/csrc/utils/pybind.h"
+#include "torch/csrc/autograd/engine.h"
 #include "torch/csrc/autograd/grad_mode.h"
 #include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/python_function.h"
+#include "torch/csrc/autograd/saved_variable.h"
+#include "torch/csrc/utils/python_numbers.h"
 
 PyObject * THPAutograd_initExtension(PyObject *_unused)
 {
@@ -28,6 +31,7 @@ PyObject * THPAutograd_initExtension(PyObject *_unused)
   .def("kind",&torch::autograd::profiler::Event::kind)
   .def("name",&torch::autograd::profiler::Event::name)
   .def("thread_id",&torch::autograd::profiler::Event::thread_id)
+  .def("correlation_id",&torch::autograd::profiler::Event::correlation_id)
   .def("device",&torch::autograd::profiler::Event::device)
   .def("cpu_elapsed_us",&torch::autograd::profiler::Event::cpu_elapsed_us)
   .def("cuda_elapsed_us",&torch::autograd::profiler::Event::cuda_elapsed_us)
@@ -36,10 +40,20 @@ PyObject * THPAutograd_initExtension(PyObject *_unused)
   .value("Disabled", torch::autograd::profiler::ProfilerState::Disabled)
   .value("CPU", torch::autograd::profiler::ProfilerState::CPU)
   .value("CUDA", torch::autograd::profiler::ProfilerState::CUDA)
-  .value("NVTX", torch::autograd::profiler::ProfilerState::NVTX);
+  .value("NVTX", torch::autograd::profiler::ProfilerState::NVTX)
+  .value("Sampling", torch::autograd::profiler::ProfilerState::Sampling);
+
+  py::class_<torch::autograd::profiler::OpSamples>(m, "ProfilerOpSamples")
+  .def_readonly("name", &torch::autograd::profiler::OpSamples::name)
+  .def_readonly("samples", &torch::autograd::profiler::OpSamples::samples)
+  .def_readonly("total_ns", &torch::autograd::profiler::OpSamples::total_ns)
+  .def_readonly("histogram", &torch::autograd::profiler::OpSamples::histogram);
 
   m.def("_enable_profiler", torch::autograd::profiler::enableProfiler);
   m.def("_disable_profiler", torch::autograd::profiler::disableProfiler);
+  m.def("_enable_profiler_sampling", torch::autograd::profiler::enableSampling);
+  m.def("_disable_profiler_sampling", torch::autograd::profiler::disableSampling);
+  m.def("_drain_profiler_samples", torch::autograd::profiler::drainSamples);
 
   m.def("_push_range", [](const char *name) {
     using namespace torch::autograd::profiler;
@@ -52,6 +66,13 @@ PyObject * THPAutograd_initExtension(PyObject *_unused)
     popRange();
   });
 
+  m.def("_set_num_cpu_autograd_threads", [](int num_threads) {
+    torch::autograd::Engine::get_default_engine().set_num_cpu_threads(num_threads);
+  });
+  m.def("_get_num_cpu_autograd_threads", []() {
+    return torch::autograd::Engine::get_default_engine().get_num_cpu_threads();
+  });
+
   Py_RETURN_TRUE;
 }
 
@@ -97,12 +118,52 @@ static PyObject * is_anomaly_mode_enabled(PyObject* _unused, PyObject *arg) {
   END_HANDLE_TH_ERRORS
 }
 
+static PyObject * set_offload_mode_enabled(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  if (!PyBool_Check(arg)) {
+    throw TypeError("enabled must be a bool (got %s)", Py_TYPE(arg)->tp_name);
+  }
+  OffloadMode::set_enabled(arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * is_offload_mode_enabled(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  if (OffloadMode::is_enabled()) {
+    Py_RETURN_TRUE;
+  } else {
+    Py_RETURN_FALSE;
+  }
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * set_offload_min_bytes(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  if (!THPUtils_checkLong(arg)) {
+    throw TypeError("min_bytes must be an int (got %s)", Py_TYPE(arg)->tp_name);
+  }
+  OffloadMode::set_min_bytes(THPUtils_unpackLong(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * get_offload_min_bytes(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  return THPUtils_packInt64(OffloadMode::min_bytes());
+  END_HANDLE_TH_ERRORS
+}
+
 // autograd methods on torch._C
 static PyMethodDef methods[] = {
   {"set_grad_enabled", (PyCFunction)set_grad_enabled, METH_O, nullptr},
   {"is_grad_enabled", (PyCFunction)is_grad_enabled, METH_NOARGS, nullptr},
   {"set_anomaly_enabled", (PyCFunction)set_anomaly_mode_enabled, METH_O, nullptr},
   {"is_anomaly_enabled", (PyCFunction)is_anomaly_mode_enabled, METH_NOARGS, nullptr},
+  {"_set_offload_enabled", (PyCFunction)set_offload_mode_enabled, METH_O, nullptr},
+  {"_is_offload_enabled", (PyCFunction)is_offload_mode_enabled, METH_NOARGS, nullptr},
+  {"_set_offload_min_bytes", (PyCFunction)set_offload_min_bytes, METH_O, nullptr},
+  {"_get_offload_min_bytes", (PyCFunction)get_offload_min_bytes, METH_NOARGS, nullptr},
   {nullptr, nullptr, 0, nullptr}
 };
 
@@ -2,6 +2,7 @@
 
 #include "torch/csrc/assertions.h"
 #include "torch/csrc/autograd/functions/basic_ops.h"
+#include "torch/csrc/autograd/grad_mode.h"
 
 #include <ATen/DeviceGuard.h>
 
@@ -11,6 +12,20 @@
 
 namespace torch { namespace autograd {
 
+namespace {
+
+// Whether a gradient can be accumulated into in place. This is not the case
+// if anything else can observe it: another reference to the Variable or to
+// its data, a view, a detached or saved Variable (which share the version
+// counter), or the graph of a double backward.
+bool can_accumulate_inplace(const Variable& var) {
+  return !GradMode::is_enabled() && !var.requires_grad() && !var.is_view() &&
+      var.unsafeGetTensorImpl()->use_count() == 1 &&
+      var.data().unsafeGetTensorImpl()->use_count() == 1 &&
+      var.version_counter().use_count() == 1;
+}
+
+} // anonymous namespace
 
 void InputBuffer::add(size_t pos, Variable var) {
   TORCH_ASSERT(pos < buffer.size());
@@ -22,8 +37,19 @@ void InputBuffer::add(size_t pos, Variable var) {
     buffer[pos] = std::move(var);
   } else {
     at::DeviceGuard device_guard(var);
-    // ATen doesn't route sparse additions correctly...
-    if (old_var.type().is_sparse()) {
+    // Accumulate into a dense gradient if we own it, which saves allocating
+    // a new gradient for every accumulation; dense += sparse is supported.
+    const bool same_shape = old_var.sizes().equals(var.sizes()) &&
+        old_var.type().scalarType() == var.type().scalarType();
+    if (same_shape && !old_var.type().is_sparse() &&
+        can_accumulate_inplace(old_var)) {
+      old_var.add_(var);
+    } else if (
+        same_shape && !var.type().is_sparse() && can_accumulate_inplace(var)) {
+      var.add_(old_var);
+      buffer[pos] = std::move(var);
+    } else if (old_var.type().is_sparse()) {
+      // ATen doesn't route sparse additions correctly...
       buffer[pos] = var + old_var;
     } else {
       buffer[pos] = old_var + var;
@@ -1,6 +1,10 @@
 #include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/function.h"
 
+#include <condition_variable>
+#include <deque>
+#include <unordered_map>
+
 namespace torch { namespace autograd { namespace profiler {
 
 ProfilerState state = ProfilerState::Disabled;
@@ -10,10 +14,251 @@ std::list<std::shared_ptr<RangeEventList>> all_event_lists;
 thread_local std::shared_ptr<RangeEventList> event_list;
 thread_local int32_t thread_id;
 
+static std::atomic<uint64_t> next_correlation_id {1};
+// Incremented by enableProfiler, so that the ranges a thread left open in a
+// previous session don't leak into this one.
+static std::atomic<uint64_t> profiler_session {0};
+static thread_local std::vector<uint64_t> correlation_stack;
+static thread_local uint64_t correlation_session = 0;
+
+static std::vector<uint64_t>& correlationStack() {
+  auto session = profiler_session.load();
+  if (correlation_session != session) {
+    correlation_stack.clear();
+    correlation_session = session;
+  }
+  return correlation_stack;
+}
+
+uint64_t pushCorrelationId() {
+  auto & stack = correlationStack();
+  stack.push_back(next_correlation_id++);
+  return stack.back();
+}
+
+uint64_t popCorrelationId() {
+  auto & stack = correlationStack();
+  if (stack.empty()) {
+    return 0;
+  }
+  auto id = stack.back();
+  stack.pop_back();
+  return id;
+}
+
+uint64_t currentCorrelationId() {
+  auto & stack = correlationStack();
+  return stack.empty() ? 0 : stack.back();
+}
+
+#ifdef USE_CUDA
+
+struct CUDAEventRecord {
+  CUDAEventRecord(cudaEvent_t event, int device)
+  : event(event), device(device) {}
+  ~CUDAEventRecord();
+
+  // the anchor of the event itself, if this is an anchor, and null if the
+  // timing couldn't be resolved
+  CUDAEventRecord* anchorOf() {
+    return is_anchor ? this : anchor.get();
+  }
+
+  cudaEvent_t event;
+  int device;
+  // The first event recorded on a device since the anchors were last reset
+  // is the anchor of the ones that follow. Once an event completed, the
+  // resolver sets its time since the anchor.
+  bool is_anchor = false;
+  std::shared_ptr<CUDAEventRecord> anchor;
+  double ms_since_anchor = 0;
+  std::atomic<bool> resolved {false};
+};
+
+namespace {
+
+// cudaEventCreate is far more expensive than recording an event, so the
+// events are reused, per device.
+struct CUDAEventPool {
+  cudaEvent_t acquire(int device) {
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      if (device < (int)free_events.size() && !free_events[device].empty()) {
+        auto event = free_events[device].back();
+        free_events[device].pop_back();
+        return event;
+      }
+    }
+    // blocking, so that the resolver sleeps rather than spins while it waits
+    // for the events
+    cudaEvent_t event;
+    TORCH_CUDA_CHECK(cudaEventCreateWithFlags(&event, cudaEventBlockingSync));
+    return event;
+  }
+
+  void release(cudaEvent_t event, int device) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (device >= (int)free_events.size()) {
+      free_events.resize(device + 1);
+    }
+    free_events[device].push_back(event);
+  }
+
+  std::mutex mutex;
+  std::vector<std::vector<cudaEvent_t>> free_events;
+};
+
+// Leaked, so that Events destroyed during static destruction can still
+// return their cudaEvent_t.
+CUDAEventPool& eventPool() {
+  static CUDAEventPool* pool = new CUDAEventPool();
+  return *pool;
+}
+
+// Waits on a background thread for recorded events to complete, and
+// computes their time relative to the anchor of their device, so that
+// reading timings doesn't synchronize with the device.
+//
+// cudaEventElapsedTime only has float precision, which is coarser than a
+// microsecond after a few hours. Each event is therefore timed relative to
+// the previous event resolved on its device, and those short intervals are
+// accumulated in double.
+struct CUDAEventResolver {
+  CUDAEventResolver() {
+    std::thread t([this] { run(); });
+    t.detach();
+  }
+
+  // Called with every event right after it was recorded.
+  void push(const std::shared_ptr<CUDAEventRecord>& record) {
+    std::lock_guard<std::mutex> guard(mutex);
+    if (record->device >= (int)anchors.size()) {
+      anchors.resize(record->device + 1);
+    }
+    auto & anchor = anchors[record->device];
+    if (!anchor) {
+      anchor = record;
+      record->is_anchor = true;
+      record->resolved = true;
+      return;
+    }
+    record->anchor = anchor;
+    pending.push_back(record);
+    not_empty.notify_one();
+  }
+
+  void resetAnchors() {
+    std::lock_guard<std::mutex> guard(mutex);
+    anchors.clear();
+  }
+
+  // Blocks until all events pushed so far are resolved.
+  void flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    all_resolved.wait(lock, [this] { return pending.empty() && in_progress == 0; });
+  }
+
+  void run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      not_empty.wait(lock, [this] { return !pending.empty(); });
+      std::deque<std::shared_ptr<CUDAEventRecord>> batch;
+      std::swap(batch, pending);
+      in_progress = batch.size();
+      lock.unlock();
+      // events mostly complete in the order they were recorded in, so wait
+      // for them one after the other
+      while (!batch.empty()) {
+        auto & record = batch.front();
+        auto status = cudaEventSynchronize(record->event);
+        if (record->device >= (int)last_resolved.size()) {
+          last_resolved.resize(record->device + 1);
+        }
+        auto & last = last_resolved[record->device];
+        if (!last || last->anchor != record->anchor) {
+          last = record->anchor;
+        }
+        float ms = 0;
+        if (status == cudaSuccess) {
+          at::DeviceGuard device_guard(record->device);
+          status = cudaEventElapsedTime(&ms, last->event, record->event);
+        }
+        if (status != cudaSuccess) {
+          // cuda_elapsed_us falls back to synchronizing, and reports the
+          // error from there
+          cudaGetLastError();
+          record->anchor.reset();
+        } else {
+          record->ms_since_anchor = last->ms_since_anchor + ms;
+          last = record;
+        }
+        record->resolved = true;
+        batch.pop_front();
+        lock.lock();
+        in_progress--;
+        lock.unlock();
+      }
+      lock.lock();
+      if (pending.empty()) {
+        all_resolved.notify_all();
+      }
+    }
+  }
+
+  std::mutex mutex;
+  std::condition_variable not_empty;
+  std::condition_variable all_resolved;
+  std::deque<std::shared_ptr<CUDAEventRecord>> pending;
+  size_t in_progress = 0;
+  std::vector<std::shared_ptr<CUDAEventRecord>> anchors;
+  // the last event resolved on every device, only used by the resolver
+  // thread
+  std::vector<std::shared_ptr<CUDAEventRecord>> last_resolved;
+};
+
+CUDAEventResolver& eventResolver() {
+  static CUDAEventResolver* resolver = new CUDAEventResolver();
+  return *resolver;
+}
+
+} // anonymous namespace
+
+CUDAEventRecord::~CUDAEventRecord() {
+  eventPool().release(event, device);
+}
+
+std::shared_ptr<CUDAEventRecord> recordCUDAEvent(int* device, int64_t* cpu_ns) {
+  TORCH_CUDA_CHECK(cudaGetDevice(device));
+  auto record = std::make_shared<CUDAEventRecord>(eventPool().acquire(*device), *device);
+  auto stream = at::globalContext().getCurrentCUDAStream();
+  *cpu_ns = getTime();
+  TORCH_CUDA_CHECK(cudaEventRecord(record->event, stream));
+  eventResolver().push(record);
+  return record;
+}
+
+double cudaEventsElapsedUs(CUDAEventRecord& start, CUDAEventRecord& end) {
+  if (start.resolved && end.resolved && start.anchorOf() &&
+      start.anchorOf() == end.anchorOf()) {
+    return (end.ms_since_anchor - start.ms_since_anchor) * 1000.0;
+  }
+  TORCH_CUDA_CHECK(cudaEventSynchronize(start.event));
+  TORCH_CUDA_CHECK(cudaEventSynchronize(end.event));
+  float ms;
+  TORCH_CUDA_CHECK(cudaEventElapsedTime(&ms, start.event, end.event));
+  return ms*1000.0;
+}
+
+#endif
+
 void RecordFunction::pushFunctionRange(Function* fn) {
   pushRange(fn->name());
 }
 
+void RecordFunction::startFunctionSample(Function* fn) {
+  startSample(fn->name());
+}
+
 #ifdef USE_CUDA
 static void onEachDevice(std::function<void(int)> op) {
   at::DeviceGuard device_guard;
@@ -36,6 +281,7 @@ void enableProfiler(ProfilerState new_state) {
       throw std::runtime_error("can't change kind of profiling (e.g. NVTX to CPU) while profiler is running");
   }
   state = new_state;
+  profiler_session++;
 
 #ifdef USE_CUDA
   if(state == ProfilerState::CUDA) {
@@ -47,6 +293,8 @@ void enableProfiler(ProfilerState new_state) {
           cudaDeviceSynchronize();
       });
     }
+    // make the start events below the anchors of the timings
+    eventResolver().resetAnchors();
 
     // cuda events must be on the same device, so we need a start event recorded
     // for each gpu. we then use this event to synchronize time on the GPU
@@ -63,9 +311,19 @@ thread_event_lists disableProfiler() {
   if (state == ProfilerState::Disabled) {
     throw std::runtime_error("can't disable profiler when it's not running");
   }
+  if (state == ProfilerState::Sampling) {
+    throw std::runtime_error("the profiler is sampling, use disableSampling to stop it");
+  }
   ProfilerState old_state = state;
   mark("__stop_profile");
   state = ProfilerState::Disabled;
+#ifdef USE_CUDA
+  if (old_state == ProfilerState::CUDA) {
+    // waits for the events to complete once, instead of synchronizing for
+    // every pair of events that is read
+    eventResolver().flush();
+  }
+#endif
   if (old_state == ProfilerState::NVTX) {
     return thread_event_lists();
   } else {
@@ -87,4 +345,163 @@ thread_event_lists disableProfiler() {
   }
 }
 
+std::atomic<uint32_t> sampling_period {1};
+thread_local uint32_t sampling_countdown = 1;
+
+namespace {
+
+// The counters of one op in one thread. Only the owning thread adds to
+// them, and drainSamples takes them out with exchange, so neither side
+// needs a lock.
+struct OpCounters {
+  OpCounters() {
+    for (auto & bucket : histogram) {
+      bucket = 0;
+    }
+  }
+
+  std::atomic<uint64_t> samples {0};
+  std::atomic<uint64_t> total_ns {0};
+  std::array<std::atomic<uint64_t>, kSampleHistogramBuckets> histogram;
+};
+
+struct SampleBuffer {
+  // Held by the owning thread when it adds the counters of an op it hasn't
+  // sampled before, and by drainSamples. Reading counters on the owning
+  // thread doesn't need it, as nobody else modifies the vector.
+  std::mutex mutex;
+  // by op id
+  std::vector<std::unique_ptr<OpCounters>> counters;
+};
+
+std::mutex sample_buffers_mutex;
+std::list<std::shared_ptr<SampleBuffer>> sample_buffers;
+thread_local std::shared_ptr<SampleBuffer> sample_buffer;
+
+// Interned op names. Every thread keeps its own map to the ids, so the
+// global one is only locked the first time a thread samples an op.
+std::mutex op_names_mutex;
+std::vector<std::string> op_names;
+std::unordered_map<std::string, uint32_t> op_ids;
+thread_local std::unordered_map<std::string, uint32_t> local_op_ids;
+
+uint32_t internOpName(const std::string& name) {
+  auto it = local_op_ids.find(name);
+  if (it != local_op_ids.end()) {
+    return it->second;
+  }
+  uint32_t id;
+  {
+    std::lock_guard<std::mutex> guard(op_names_mutex);
+    auto global_it = op_ids.find(name);
+    if (global_it != op_ids.end()) {
+      id = global_it->second;
+    } else {
+      id = op_names.size();
+      op_names.push_back(name);
+      op_ids.emplace(name, id);
+    }
+  }
+  local_op_ids.emplace(name, id);
+  return id;
+}
+
+SampleBuffer& getSampleBuffer() {
+  if (!sample_buffer) {
+    sample_buffer = std::make_shared<SampleBuffer>();
+    std::lock_guard<std::mutex> guard(sample_buffers_mutex);
+    sample_buffers.emplace_front(sample_buffer);
+  }
+  return *sample_buffer;
+}
+
+size_t histogramBucket(uint64_t ns) {
+  size_t bucket = 0;
+  while (ns > 1 && bucket + 1 < kSampleHistogramBuckets) {
+    ns >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+} // anonymous namespace
+
+void enableSampling(uint32_t period) {
+  if (period == 0) {
+    throw std::runtime_error("the sampling period must be positive");
+  }
+  if (state != ProfilerState::Disabled && state != ProfilerState::Sampling) {
+    throw std::runtime_error("can't change kind of profiling (e.g. CPU to sampling) while profiler is running");
+  }
+  sampling_period = period;
+  state = ProfilerState::Sampling;
+}
+
+void disableSampling() {
+  if (state != ProfilerState::Sampling) {
+    throw std::runtime_error("can't disable sampling when it's not running");
+  }
+  state = ProfilerState::Disabled;
+}
+
+uint32_t samplingPeriod() {
+  return sampling_period.load();
+}
+
+void recordSample(const std::string& name, uint64_t start_ns, uint64_t end_ns) {
+  auto id = internOpName(name);
+  auto & buffer = getSampleBuffer();
+  if (id >= buffer.counters.size() || !buffer.counters[id]) {
+    std::lock_guard<std::mutex> guard(buffer.mutex);
+    if (id >= buffer.counters.size()) {
+      buffer.counters.resize(id + 1);
+    }
+    buffer.counters[id].reset(new OpCounters());
+  }
+  auto & counters = *buffer.counters[id];
+  auto ns = end_ns - start_ns;
+  counters.samples.fetch_add(1, std::memory_order_relaxed);
+  counters.total_ns.fetch_add(ns, std::memory_order_relaxed);
+  counters.histogram[histogramBucket(ns)].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<OpSamples> drainSamples() {
+  std::unordered_map<uint32_t, OpSamples> by_id;
+  {
+    std::lock_guard<std::mutex> guard(sample_buffers_mutex);
+    for (auto it = sample_buffers.begin(); it != sample_buffers.end();) {
+      auto & buffer = **it;
+      {
+        std::lock_guard<std::mutex> buffer_guard(buffer.mutex);
+        for (uint32_t id = 0; id < buffer.counters.size(); ++id) {
+          if (!buffer.counters[id]) continue;
+          auto & counters = *buffer.counters[id];
+          auto samples = counters.samples.exchange(0, std::memory_order_relaxed);
+          if (samples == 0) continue;
+          // value-initialized, i.e. zeroed
+          auto & op = by_id.emplace(id, OpSamples()).first->second;
+          op.samples += samples;
+          op.total_ns += counters.total_ns.exchange(0, std::memory_order_relaxed);
+          for (size_t i = 0; i < kSampleHistogramBuckets; ++i) {
+            op.histogram[i] += counters.histogram[i].exchange(0, std::memory_order_relaxed);
+          }
+        }
+      }
+      // GC buffers of threads that exited
+      if (it->use_count() == 1) {
+        it = sample_buffers.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  std::vector<OpSamples> result;
+  std::lock_guard<std::mutex> guard(op_names_mutex);
+  for (auto & entry : by_id) {
+    entry.second.name = op_names.at(entry.first);
+    result.push_back(std::move(entry.second));
+  }
+  return result;
+}
+
 }}}
@@ -3,6 +3,8 @@
 #ifdef USE_CUDA
 #include <nvToolsExt.h>
 #endif
+#include <array>
+#include <atomic>
 #include <thread>
 #include <iostream>
 #include <mutex>
@@ -42,18 +44,37 @@ enum class EventKind {
   PopRange
 };
 
+// A CUDA event recorded by the profiler. The cudaEvent_ts come from a pool
+// and go back to it once the last Event referring to them is gone. Timings
+// are resolved asynchronously: a background thread waits for the recorded
+// events to complete and computes their time relative to an anchor event
+// on the same device, so that reading the elapsed time between two events
+// normally doesn't synchronize with the device. See profiler.cpp.
+struct CUDAEventRecord;
+#ifdef USE_CUDA
+std::shared_ptr<CUDAEventRecord> recordCUDAEvent(int* device, int64_t* cpu_ns);
+double cudaEventsElapsedUs(CUDAEventRecord& start, CUDAEventRecord& end);
+#endif
+
+// The correlation id of the innermost range open on this thread, see
+// Event::correlation_id.
+uint64_t pushCorrelationId();
+uint64_t popCorrelationId();
+uint64_t currentCorrelationId();
+
 struct Event {
   Event(EventKind kind, std::string name, uint32_t thread_id, bool record_cuda)
   : kind_(kind)
   , name_(std::move(name))
   , thread_id_(thread_id) {
+    switch(kind) {
+      case EventKind::PushRange: correlation_id_ = pushCorrelationId(); break;
+      case EventKind::PopRange: correlation_id_ = popCorrelationId(); break;
+      case EventKind::Mark: correlation_id_ = currentCorrelationId(); break;
+    }
 #ifdef USE_CUDA
     if(record_cuda) {
-      TORCH_CUDA_CHECK(cudaGetDevice(&device_));
-      TORCH_CUDA_CHECK(cudaEventCreate(&event));
-      auto stream = at::globalContext().getCurrentCUDAStream();
-      cpu_ns_ = getTime();
-      TORCH_CUDA_CHECK(cudaEventRecord(event, stream));
+      cuda_event_ = recordCUDAEvent(&device_, &cpu_ns_);
     } else {
       cpu_ns_ = getTime();
     }
@@ -75,6 +96,13 @@ struct Event {
   uint32_t thread_id() const {
     return thread_id_;
   }
+  // The push and the pop of a range share an id, marks get the id of the
+  // range they are in (0 outside of ranges). Ids are unique per profiler
+  // run, so they can be used to attribute GPU work to the CPU ranges that
+  // launched it.
+  uint64_t correlation_id() const {
+    return correlation_id_;
+  }
   double cpu_elapsed_us(const Event & e) {
     return (e.cpu_ns_ - cpu_ns_)/(1000.0);
   }
@@ -86,18 +114,14 @@ struct Event {
     if(e.device() != device()) {
       throw std::logic_error("Events are not on the same device");
     }
-    TORCH_CUDA_CHECK(cudaEventSynchronize(event));
-    TORCH_CUDA_CHECK(cudaEventSynchronize(e.event));
-    float ms;
-    TORCH_CUDA_CHECK(cudaEventElapsedTime(&ms, event, e.event));
-    return ms*1000.0;
+    return cudaEventsElapsedUs(*cuda_event_, *e.cuda_event_);
 #else
     throw std::logic_error("CUDA not enabled");
 #endif
   }
   bool has_cuda() const {
 #ifdef USE_CUDA
-    return event != nullptr;
+    return cuda_event_ != nullptr;
 #else
     return false;
 #endif
@@ -109,9 +133,10 @@ private:
   EventKind kind_;
   std::string name_;
   uint32_t thread_id_;
+  uint64_t correlation_id_;
   int64_t cpu_ns_; // signed to allow for negative intervals
 #ifdef USE_CUDA
-  cudaEvent_t event = nullptr;
+  std::shared_ptr<CUDAEventRecord> cuda_event_;
 #endif
   int device_ = -1;
 };
@@ -160,6 +185,7 @@ enum class ProfilerState {
     CPU, // CPU-only profiling
     CUDA, // CPU + CUDA events
     NVTX,  // only emit NVTX markers
+    Sampling, // aggregate one in N RecordFunctions, see enableSampling
 };
 
 extern ProfilerState state;
@@ -181,7 +207,9 @@ inline RangeEventList& getEventList() {
 }
 
 inline void mark(std::string name, bool include_cuda = true) {
-  if (state == ProfilerState::NVTX) {
+  if (state == ProfilerState::Sampling) {
+    return;
+  } else if (state == ProfilerState::NVTX) {
 #ifdef USE_CUDA
     nvtxMarkA(name.c_str());
 #else
@@ -193,7 +221,9 @@ inline void mark(std::string name, bool include_cuda = true) {
 }
 
 inline void pushRange(std::string name) {
-  if (state == ProfilerState::NVTX) {
+  if (state == ProfilerState::Sampling) {
+    return;
+  } else if (state == ProfilerState::NVTX) {
 #ifdef USE_CUDA
     nvtxRangePushA(name.c_str());
 #else
@@ -205,7 +235,9 @@ inline void pushRange(std::string name) {
 }
 
 inline void popRange() {
-  if (state == ProfilerState::NVTX) {
+  if (state == ProfilerState::Sampling) {
+    return;
+  } else if (state == ProfilerState::NVTX) {
 #ifdef USE_CUDA
     nvtxRangePop();
 #else
@@ -216,29 +248,95 @@ inline void popRange() {
   }
 }
 
+// Sampling mode: instead of recording a range for every RecordFunction,
+// only one in every `period` of them (counted per thread) is timed, and the
+// times are aggregated per op name into a histogram, in buffers owned by
+// the recording threads. drainSamples collects what was recorded since the
+// last drain without stopping the sampling, so it can be called
+// periodically, e.g. to export metrics from a running job. Like the rest of
+// the profiler, it must not be enabled or disabled while functions run.
+constexpr size_t kSampleHistogramBuckets = 32;
+
+struct OpSamples {
+  std::string name;
+  uint64_t samples; // multiply by the period to estimate the calls
+  uint64_t total_ns;
+  // bucket i counts the samples that took [2^i, 2^(i+1)) ns, the last one
+  // also the longer ones
+  std::array<uint64_t, kSampleHistogramBuckets> histogram;
+};
+
+void enableSampling(uint32_t period);
+void disableSampling();
+uint32_t samplingPeriod();
+// The counters of one op are drained one after the other, so a sample
+// recorded concurrently may be in the totals of one drain and in the
+// histogram of the next.
+std::vector<OpSamples> drainSamples();
+
+extern std::atomic<uint32_t> sampling_period;
+extern thread_local uint32_t sampling_countdown;
+
+inline bool shouldSample() {
+  if (--sampling_countdown != 0) {
+    return false;
+  }
+  sampling_countdown = sampling_period.load(std::memory_order_relaxed);
+  return true;
+}
+
+void recordSample(const std::string& name, uint64_t start_ns, uint64_t end_ns);
+
 struct RecordFunction {
   explicit RecordFunction(Function *fn) {
     if (state == ProfilerState::Disabled) return;
+    if (state == ProfilerState::Sampling) {
+      if (shouldSample()) startFunctionSample(fn);
+      return;
+    }
     pushFunctionRange(fn);
   }
 
   explicit RecordFunction(std::string name) {
     if (state == ProfilerState::Disabled) return;
+    if (state == ProfilerState::Sampling) {
+      if (shouldSample()) startSample(std::move(name));
+      return;
+    }
     pushRange(std::move(name));
   }
 
   explicit RecordFunction(const char *name) {
     if (state == ProfilerState::Disabled) return;
+    if (state == ProfilerState::Sampling) {
+      if (shouldSample()) startSample(name);
+      return;
+    }
     pushRange(name);
   }
 
   ~RecordFunction() {
     if (state == ProfilerState::Disabled) return;
+    if (state == ProfilerState::Sampling) {
+      if (sample_start_ns_ != 0) recordSample(sample_name_, sample_start_ns_, getTime());
+      return;
+    }
     popRange();
   }
 
   // Needed only because we don't have Function defined yet.
   void pushFunctionRange(Function *fn);
+  void startFunctionSample(Function *fn);
+
+private:
+  void startSample(std::string name) {
+    sample_name_ = std::move(name);
+    sample_start_ns_ = getTime();
+  }
+
+  // set only when this call is sampled
+  std::string sample_name_;
+  uint64_t sample_start_ns_ = 0;
 };
 
 using thread_event_lists = std::vector<std::vector<Event>>;
@@ -7,6 +7,7 @@
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/autograd/edge.h"
 #include "torch/csrc/autograd/python_function.h"
+#include "torch/csrc/autograd/python_hook.h"
 #include "torch/csrc/utils/auto_gil.h"
 
 #ifndef _WIN32
@@ -51,6 +52,23 @@ std::unique_ptr<AnomalyMetadata> PythonEngine::make_anomaly_metadata() {
   return std::unique_ptr<AnomalyMetadata>(new PyAnomalyMetadata());
 }
 
+bool PythonEngine::runs_python(const Function& fn) {
+  if (dynamic_cast<const PyFunction*>(&fn)) {
+    return true;
+  }
+  for (const auto& hook : fn.pre_hooks()) {
+    if (dynamic_cast<const PyFunctionPreHook*>(hook.get())) {
+      return true;
+    }
+  }
+  for (const auto& hook : fn.post_hooks()) {
+    if (dynamic_cast<const PyFunctionPostHook*>(hook.get())) {
+      return true;
+    }
+  }
+  return false;
+}
+
 variable_list PythonEngine::execute(
     const edge_list& roots,
     const variable_list& inputs,
@@ -139,7 +157,7 @@ PyObject *THPEngine_run_backward(THPEngine *self, PyObject *args, PyObject *kwar
     }
   }
 
-  std::vector<Edge> output_edges;
+  edge_list output_edges;
   if (inputs != nullptr) {
     int num_inputs = PyTuple_GET_SIZE(inputs);
     output_edges.reserve(num_inputs);
@@ -20,6 +20,7 @@ struct PythonEngine : public Engine {
       bool create_graph,
       const edge_list& outputs = {}) override;
   virtual std::unique_ptr<AnomalyMetadata> make_anomaly_metadata() override;
+  virtual bool runs_python(const Function& fn) override;
 };
 
 }}} // namespace torch::autograd::python
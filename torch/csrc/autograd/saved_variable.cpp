@@ -8,11 +8,230 @@
 #include <ATen/Tensor.h>
 
 #include <cstdint>
+#include <deque>
 #include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef USE_CUDA
+#include <ATen/DeviceGuard.h>
+#include <ATen/detail/CUDAHooksInterface.h>
+#include <THC/THC.h>
+#endif
 
 namespace torch { namespace autograd {
 
+bool OffloadMode::_enabled = false;
+int64_t OffloadMode::_min_bytes = 1 << 20;
+
+#ifdef USE_CUDA
+
+// A saved CUDA tensor kept in pinned host memory between the forward and the
+// backward pass. Guarded by offload_mutex.
+struct OffloadedData {
+  enum class State {
+    // The copy to the host is in flight: device still holds the data.
+    Offloading,
+    // Only host holds the data.
+    Offloaded,
+    // The copy back to the device is in flight, into device.
+    Prefetching,
+  };
+
+  ~OffloadedData() {
+    if (event) {
+      cudaEventDestroy(event);
+    }
+  }
+
+  State state = State::Offloading;
+  at::Tensor host;
+  at::Tensor device;
+  int32_t device_index;
+  // Signals the completion of the copy in flight.
+  cudaEvent_t event = nullptr;
+  // Position of the data in the order of the saves
+  uint64_t order;
+};
+
+namespace {
+
+// How many of the tensors saved before an unpacked one are fetched back.
+constexpr int kPrefetchDistance = 2;
+
+std::mutex offload_mutex;
+// The streams of the copies to the host and back, by device. They are
+// separate so that both directions of copies can run at the same time.
+std::vector<THCStream*> offload_streams;
+std::vector<THCStream*> prefetch_streams;
+// Data being offloaded, in the order of the copies, which complete in that
+// order. This keeps the device data alive until its copy completes.
+std::deque<std::shared_ptr<OffloadedData>> offloading;
+// Offloaded data by the order of the saves. The backward pass unpacks saved
+// tensors roughly in reverse, as the engine runs functions by decreasing
+// sequence number, so the data saved before an unpacked one is needed next.
+std::map<uint64_t, std::weak_ptr<OffloadedData>> offloaded;
+uint64_t next_order = 0;
+
+THCState* thc_state() {
+  return at::globalContext().lazyInitCUDA();
+}
+
+THCStream* side_stream(std::vector<THCStream*>& streams, int32_t device) {
+  if (streams.empty()) {
+    streams.resize(at::globalContext().getNumGPUs(), nullptr);
+  }
+  if (!streams.at(device)) {
+    streams[device] = THCStream_new(cudaStreamNonBlocking);
+  }
+  return streams[device];
+}
+
+cudaEvent_t record_event(cudaStream_t stream) {
+  cudaEvent_t event;
+  THCudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  THCudaCheck(cudaEventRecord(event, stream));
+  return event;
+}
+
+// Makes `waiting` wait for the work queued on `stream` so far.
+void wait_stream(cudaStream_t waiting, cudaStream_t stream) {
+  cudaEvent_t event = record_event(stream);
+  THCudaCheck(cudaStreamWaitEvent(waiting, event, 0));
+  THCudaCheck(cudaEventDestroy(event));
+}
+
+// Makes `stream` the current stream of the current device while alive.
+struct StreamGuard {
+  explicit StreamGuard(THCStream* stream)
+    : original_stream(THCState_getStream(thc_state())) {
+    THCStream_retain(original_stream);
+    THCState_setStream(thc_state(), stream);
+  }
+
+  ~StreamGuard() {
+    THCState_setStream(thc_state(), original_stream);
+    THCStream_free(original_stream);
+  }
+
+  THCStream* original_stream;
+};
+
+// Releases the device memory of the data whose copy to the host completed.
+void release_offloaded() {
+  while (!offloading.empty()) {
+    auto& data = *offloading.front();
+    if (data.state == OffloadedData::State::Offloading) {
+      if (cudaEventQuery(data.event) == cudaErrorNotReady) {
+        cudaGetLastError();
+        return;
+      }
+      THCudaCheck(cudaEventDestroy(data.event));
+      data.event = nullptr;
+      data.device.reset();
+      data.state = OffloadedData::State::Offloaded;
+    }
+    offloading.pop_front();
+  }
+  while (!offloaded.empty() && offloaded.begin()->second.expired()) {
+    offloaded.erase(offloaded.begin());
+  }
+}
+
+std::shared_ptr<OffloadedData> offload(const at::Tensor& tensor) {
+  std::lock_guard<std::mutex> lock(offload_mutex);
+  release_offloaded();
+
+  at::DeviceGuard device_guard(tensor);
+  auto data = std::make_shared<OffloadedData>();
+  data->device = tensor;
+  data->device_index = tensor.get_device();
+  data->order = next_order++;
+  data->host = tensor.type().toBackend(at::kCPU).tensorWithAllocator(
+      tensor.sizes(), at::detail::getCUDAHooks().getPinnedMemoryAllocator());
+
+  auto* stream = side_stream(offload_streams, data->device_index);
+  wait_stream(THCStream_stream(stream), THCState_getCurrentStream(thc_state()));
+  {
+    StreamGuard stream_guard(stream);
+    data->host.copy_(tensor, /*non_blocking=*/true);
+    data->event = record_event(THCStream_stream(stream));
+  }
+
+  offloading.push_back(data);
+  offloaded.emplace(data->order, data);
+  return data;
+}
+
+void prefetch(OffloadedData& data) {
+  at::DeviceGuard device_guard(data.device_index);
+  // The device memory is allocated for the current stream, which uses it.
+  // The copy waits for the work queued on the current stream so far, as that
+  // may still use the memory before the allocator handed it out again.
+  data.device = data.host.type().toBackend(at::kCUDA).tensor(data.host.sizes());
+  auto* stream = side_stream(prefetch_streams, data.device_index);
+  wait_stream(THCStream_stream(stream), THCState_getCurrentStream(thc_state()));
+  {
+    StreamGuard stream_guard(stream);
+    data.device.copy_(data.host, /*non_blocking=*/true);
+    data.event = record_event(THCStream_stream(stream));
+  }
+  data.state = OffloadedData::State::Prefetching;
+}
+
+// Returns the data on its device, ready to use on the current stream, and
+// prefetches the data saved before it.
+at::Tensor fetch(OffloadedData& data) {
+  std::lock_guard<std::mutex> lock(offload_mutex);
+  release_offloaded();
+
+  at::Tensor tensor;
+  {
+    at::DeviceGuard device_guard(data.device_index);
+    switch (data.state) {
+      case OffloadedData::State::Offloading:
+        tensor = data.device;
+        break;
+      case OffloadedData::State::Prefetching:
+        THCudaCheck(cudaStreamWaitEvent(
+            THCState_getCurrentStream(thc_state()), data.event, 0));
+        THCudaCheck(cudaEventDestroy(data.event));
+        data.event = nullptr;
+        tensor = std::move(data.device);
+        data.device.reset();
+        data.state = OffloadedData::State::Offloaded;
+        break;
+      case OffloadedData::State::Offloaded:
+        tensor = data.host.type().toBackend(at::kCUDA).tensor(data.host.sizes());
+        tensor.copy_(data.host, /*non_blocking=*/true);
+        break;
+    }
+  }
+
+  // The data stays offloaded, for a backward pass with retain_graph.
+  auto it = offloaded.find(data.order);
+  int prefetched = 0;
+  while (it != offloaded.begin() && prefetched < kPrefetchDistance) {
+    --it;
+    auto previous = it->second.lock();
+    if (!previous) {
+      it = offloaded.erase(it);
+      continue;
+    }
+    if (previous->state == OffloadedData::State::Offloaded) {
+      prefetch(*previous);
+    }
+    prefetched++;
+  }
+  return tensor;
+}
+
+} // anonymous namespace
+
+#endif // USE_CUDA
+
 SavedVariable::SavedVariable(const Variable& variable, bool is_output) {
   if (variable.defined()) {
     was_default_constructed_ = false;
@@ -22,6 +241,15 @@ SavedVariable::SavedVariable(const Variable& variable, bool is_output) {
     // These copies are all shared_ptr copies, so slightly more expensive.
     // Do them here instead of in the init list in case data is undefined.
     data_ = variable.data();
+#ifdef USE_CUDA
+    if (OffloadMode::is_enabled() && data_.type().is_cuda() &&
+        data_.is_contiguous() &&
+        data_.numel() * data_.type().elementSizeInBytes() >=
+            OffloadMode::min_bytes()) {
+      offloaded_ = offload(data_);
+      data_.reset();
+    }
+#endif
     if (variable.is_leaf()) {
       grad_accumulator_ = variable.grad_accumulator();
     } else if (!is_output) {
@@ -37,7 +265,13 @@ SavedVariable::SavedVariable(const Variable& variable, bool is_output) {
 }
 
 Variable SavedVariable::unpack(std::shared_ptr<Function> saved_for) const {
-  if (!data_.defined()) {
+  at::Tensor data = data_;
+#ifdef USE_CUDA
+  if (offloaded_) {
+    data = fetch(*offloaded_);
+  }
+#endif
+  if (!data.defined()) {
     if (!was_default_constructed_) {
       throw std::runtime_error(ERR_BACKWARD_TWICE);
     }
@@ -65,9 +299,9 @@ Variable SavedVariable::unpack(std::shared_ptr<Function> saved_for) const {
   // in-place functions on unpacked variables.
   Variable var;
   if (grad_fn) {
-    var = make_variable(data_, Edge(std::move(grad_fn), output_nr_));
+    var = make_variable(data, Edge(std::move(grad_fn), output_nr_));
   } else {
-    var = make_variable(data_, requires_grad_);
+    var = make_variable(data, requires_grad_);
   }
   var.set_version_counter(saved_version_);
 
@@ -16,6 +16,33 @@ struct Function;
 
 extern const char* ERR_BACKWARD_TWICE;
 
+/// When enabled, saved CUDA tensors of at least `min_bytes` are copied to
+/// pinned host memory on a side stream after they are saved, and their device
+/// memory is released once the copy completes. Unpacking one in the backward
+/// pass prefetches the ones saved just before it, which the backward pass is
+/// about to need. This trades PCIe bandwidth for device memory, as an
+/// alternative to recomputation (checkpointing).
+struct OffloadMode {
+  static bool is_enabled() {
+    return _enabled;
+  }
+  static void set_enabled(bool enabled) {
+    _enabled = enabled;
+  }
+  static int64_t min_bytes() {
+    return _min_bytes;
+  }
+  static void set_min_bytes(int64_t min_bytes) {
+    _min_bytes = min_bytes;
+  }
+
+private:
+  static bool _enabled;
+  static int64_t _min_bytes;
+};
+
+struct OffloadedData;
+
 /// A snapshot of a variable at a certain version. A `SavedVariable` stores
 /// enough information to reconstruct a variable from a certain point in time.
 class SavedVariable {
@@ -31,11 +58,14 @@ class SavedVariable {
   Variable unpack(std::shared_ptr<Function> saved_for = nullptr) const;
 
   void reset_data() {
+    offloaded_.reset();
     return data_.reset();
   }
 
  private:
   at::Tensor data_;
+  // Set instead of data_ when the data was offloaded to the host.
+  std::shared_ptr<OffloadedData> offloaded_;
 
   // The gradient function associated with this node. If has_grad_fn
   // is false, then this is a leaf node. Note that the grad_fn is not saved if
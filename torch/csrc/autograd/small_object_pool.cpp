@@ -0,0 +1,139 @@
+#include "torch/csrc/autograd/small_object_pool.h"
+
+#include <array>
+#include <cstddef>
+
+namespace torch { namespace autograd {
+
+namespace {
+
+constexpr size_t kSizeClassBytes = 16;
+constexpr size_t kNumSizeClasses = kMaxSmallObjectSize / kSizeClassBytes;
+// per size class and thread; enough for the graph of a few thousand ops
+constexpr size_t kMaxCachedBlocks = 4096;
+
+constexpr size_t kArenaChunkBytes = 16384;
+constexpr size_t kArenaAlignment = alignof(std::max_align_t);
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct SizeClassCache {
+  FreeBlock* head = nullptr;
+  size_t size = 0;
+};
+
+struct ThreadCache {
+  ~ThreadCache();
+
+  std::array<SizeClassCache, kNumSizeClasses> classes;
+};
+
+// Blocks freed while the thread exits, after its cache is gone, go straight
+// back to the global allocator.
+thread_local bool thread_cache_destroyed = false;
+
+ThreadCache::~ThreadCache() {
+  thread_cache_destroyed = true;
+  for (auto& cache : classes) {
+    while (cache.head) {
+      auto block = cache.head;
+      cache.head = block->next;
+      ::operator delete(block);
+    }
+  }
+}
+
+ThreadCache* threadCache() {
+  if (thread_cache_destroyed) {
+    return nullptr;
+  }
+  thread_local ThreadCache cache;
+  return &cache;
+}
+
+size_t sizeClass(size_t size) {
+  return (size + kSizeClassBytes - 1) / kSizeClassBytes - 1;
+}
+
+} // anonymous namespace
+
+void* allocateSmallObject(size_t size) {
+  if (size == 0 || size > kMaxSmallObjectSize) {
+    return ::operator new(size);
+  }
+  auto index = sizeClass(size);
+  if (auto thread_cache = threadCache()) {
+    auto& cache = thread_cache->classes[index];
+    if (cache.head) {
+      auto block = cache.head;
+      cache.head = block->next;
+      cache.size--;
+      return block;
+    }
+  }
+  return ::operator new((index + 1) * kSizeClassBytes);
+}
+
+void freeSmallObject(void* ptr, size_t size) noexcept {
+  if (!ptr) {
+    return;
+  }
+  if (size == 0 || size > kMaxSmallObjectSize) {
+    ::operator delete(ptr);
+    return;
+  }
+  auto thread_cache = threadCache();
+  if (!thread_cache) {
+    ::operator delete(ptr);
+    return;
+  }
+  auto& cache = thread_cache->classes[sizeClass(size)];
+  if (cache.size >= kMaxCachedBlocks) {
+    ::operator delete(ptr);
+    return;
+  }
+  auto block = static_cast<FreeBlock*>(ptr);
+  block->next = cache.head;
+  cache.head = block;
+  cache.size++;
+}
+
+Arena::~Arena() {
+  for (auto chunk : chunks_) {
+    ::operator delete(chunk);
+  }
+}
+
+void* Arena::allocate(size_t size) {
+  size = (size + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+  // so that push_back can't throw after the chunk is allocated
+  chunks_.reserve(chunks_.size() + 1);
+  if (size > kArenaChunkBytes / 4) {
+    // e.g. the bucket arrays of large maps, which would waste most of a chunk
+    chunks_.push_back(::operator new(size));
+    return chunks_.back();
+  }
+  if (size > left_) {
+    chunks_.push_back(::operator new(kArenaChunkBytes));
+    next_ = static_cast<char*>(chunks_.back());
+    left_ = kArenaChunkBytes;
+  }
+  auto result = next_;
+  next_ += size;
+  left_ -= size;
+  return result;
+}
+
+size_t numCachedSmallObjects() {
+  size_t total = 0;
+  if (auto thread_cache = threadCache()) {
+    for (auto& cache : thread_cache->classes) {
+      total += cache.size;
+    }
+  }
+  return total;
+}
+
+}} // namespace torch::autograd
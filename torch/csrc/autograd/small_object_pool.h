@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+namespace torch { namespace autograd {
+
+// Every differentiable op that runs with grad records a Function, and the
+// shared_ptr that owns it allocates a control block. For graphs of many tiny
+// ops (e.g. RNN cells) these allocations are a large part of the overhead
+// of recording the graph, so they come from a cache of freed blocks
+// instead, kept per thread and rounded up to size classes.
+//
+// A block can be freed on any thread (Functions are usually created by the
+// forward pass and destroyed by the engine, or the other way round); it then
+// goes to the cache of that thread. Caches are bounded, and what doesn't fit
+// goes back to the global allocator, as do blocks larger than
+// kMaxSmallObjectSize.
+
+constexpr size_t kMaxSmallObjectSize = 512;
+
+void* allocateSmallObject(size_t size);
+void freeSmallObject(void* ptr, size_t size) noexcept;
+
+// The number of blocks cached by the calling thread, for tests.
+size_t numCachedSmallObjects();
+
+// A standard allocator over the cache, for std::allocate_shared and the
+// allocator argument of std::shared_ptr's constructor.
+template <typename T>
+struct SmallObjectAllocator {
+  using value_type = T;
+
+  SmallObjectAllocator() = default;
+  template <typename U>
+  SmallObjectAllocator(const SmallObjectAllocator<U>&) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(allocateSmallObject(n * sizeof(T)));
+  }
+  void deallocate(T* ptr, size_t n) noexcept {
+    freeSmallObject(ptr, n * sizeof(T));
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const SmallObjectAllocator<T>&, const SmallObjectAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const SmallObjectAllocator<T>&, const SmallObjectAllocator<U>&) {
+  return false;
+}
+
+// Hands out memory from large chunks, and only gives it back when it is
+// destroyed. For containers that are filled while running one backward pass
+// and thrown away with it, like the bookkeeping of a GraphTask, which would
+// otherwise allocate a node per Function of the graph. Not thread safe.
+struct Arena {
+  Arena() = default;
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  ~Arena();
+
+  void* allocate(size_t size);
+
+ private:
+  std::vector<void*> chunks_;
+  char* next_ = nullptr;
+  size_t left_ = 0;
+};
+
+// A standard allocator over an Arena. Deallocation is a no-op.
+template <typename T>
+struct ArenaAllocator {
+  using value_type = T;
+
+  explicit ArenaAllocator(Arena& arena) : arena(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+  T* allocate(size_t n) {
+    return static_cast<T*>(arena->allocate(n * sizeof(T)));
+  }
+  void deallocate(T*, size_t) noexcept {}
+
+  Arena* arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena == b.arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b) {
+  return a.arena != b.arena;
+}
+
+}} // namespace torch::autograd
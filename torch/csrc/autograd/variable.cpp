@@ -116,7 +116,7 @@ void Variable::Impl::backward(
     at::optional<Tensor> gradient,
     bool keep_graph,
     bool create_graph) {
-  std::vector<Edge> edges;
+  edge_list edges;
   edges.emplace_back(grad_fn_, output_nr_);
 
   std::vector<Variable> inputs;
@@ -32,6 +32,12 @@ struct VariableVersion {
     return version_block_->load();
   }
 
+  // Number of Variables sharing this version counter: views, detached and
+  // unpacked saved Variables share it with their source.
+  long use_count() const noexcept {
+    return version_block_.use_count();
+  }
+
  private:
   std::shared_ptr<std::atomic<uint32_t>> version_block_;
 };
@@ -193,6 +193,24 @@ PyObject * THCPModule_cudaSynchronize(PyObject *_unused)
   END_HANDLE_TH_ERRORS
 }
 
+PyObject * THCPModule_setDeterministicAccumulate(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyBool_Check(arg), "set_deterministic_accumulate expects a bool, "
+          "but got %s", THPUtils_typename(arg));
+  THCState_setDeterministicAccumulate(state, arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_getDeterministicAccumulate(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  if (THCState_getDeterministicAccumulate(state)) Py_RETURN_TRUE;
+  Py_RETURN_FALSE;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject * THCPModule_cudaSleep(PyObject *_unused, PyObject *cycles)
 {
   HANDLE_TH_ERRORS
@@ -286,6 +304,69 @@ PyObject * THCPModule_maxMemoryCached(PyObject *_unused, PyObject *arg)
   END_HANDLE_TH_ERRORS
 }
 
+PyObject * THCPModule_memorySnapshot(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  py::list result;
+  for (const auto& segment : THCCachingAllocator_snapshot()) {
+    py::list blocks;
+    for (const auto& block : segment.blocks) {
+      py::dict block_info;
+      block_info["size"] = block.size;
+      block_info["allocated"] = block.allocated;
+      block_info["pending_free"] = block.pending_free;
+      block_info["tag"] = block.tag;
+      blocks.append(block_info);
+    }
+    py::dict segment_info;
+    segment_info["device"] = segment.device;
+    segment_info["address"] = segment.address;
+    segment_info["total_size"] = segment.total_size;
+    segment_info["allocated_size"] = segment.allocated_size;
+    segment_info["stream"] = (uintptr_t) segment.stream;
+    segment_info["blocks"] = blocks;
+    result.append(segment_info);
+  }
+  return result.release().ptr();
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_recordMemoryHistory(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  PyObject *enabled = NULL;
+  unsigned long long capacity = 0;
+  if (!PyArg_ParseTuple(args, "OK", &enabled, &capacity)) {
+    return NULL;
+  }
+  THCCachingAllocator_recordHistory(PyObject_IsTrue(enabled), (size_t) capacity);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_memoryTraceChromeJSON(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  return THPUtils_packString(THCCachingAllocator_traceToChromeJSON());
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_setAllocationTag(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkString(arg), "invalid argument to set_allocation_tag");
+  THCCachingAllocator_setAllocationTag(THPUtils_unpackString(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_getAllocationTag(PyObject *_unused)
+{
+  HANDLE_TH_ERRORS
+  return THPUtils_packString(THCCachingAllocator_getAllocationTag());
+  END_HANDLE_TH_ERRORS
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Cuda module initialization
 ////////////////////////////////////////////////////////////////////////////////
@@ -314,10 +395,26 @@ static void bindCudaDeviceProperties(PyObject* module) {
 }
 
 // Callback for python part. Used for additional initialization of python classes
+// Returns how long the steps of the initialization took, as a list of
+// (step, seconds) pairs, for torch.cuda.init_times.
 static PyObject * THCPModule_initExtension(PyObject *self)
 {
   HANDLE_TH_ERRORS
+  THPObjectPtr times(PyList_New(0));
+  if (!times) throw python_error();
+  auto start = std::chrono::steady_clock::now();
+  auto record_time = [&](const char* step) {
+    auto now = std::chrono::steady_clock::now();
+    THPObjectPtr time(Py_BuildValue(
+        "(sd)", step, std::chrono::duration<double>(now - start).count()));
+    if (!time || PyList_Append(times.get(), time.get()) < 0) {
+      throw python_error();
+    }
+    start = now;
+  };
+
   state = at::globalContext().lazyInitCUDA();
+  record_time("thc_state");
 
   auto m = THPObjectPtr(PyImport_ImportModule("torch.cuda"));
   if (!m) throw python_error();
@@ -331,9 +428,11 @@ static PyObject * THCPModule_initExtension(PyObject *self)
   THCPShortStorage_postInit(m);
   THCPCharStorage_postInit(m);
   THCPByteStorage_postInit(m);
+  record_time("storage_types");
 
 #ifdef USE_MAGMA
   THCMagma_init(state);
+  record_time("magma");
   bool has_magma = true;
 #else
   bool has_magma = false;
@@ -360,7 +459,7 @@ static PyObject * THCPModule_initExtension(PyObject *self)
 
   bindCudaDeviceProperties(m);
 
-  Py_RETURN_NONE;
+  return times.release();
   END_HANDLE_TH_ERRORS
 }
 
@@ -401,6 +500,11 @@ static struct PyMethodDef _THCPModule_methods[] = {
   {"_cuda_maxMemoryAllocated", (PyCFunction) THCPModule_maxMemoryAllocated, METH_O,  NULL},
   {"_cuda_memoryCached", (PyCFunction) THCPModule_memoryCached, METH_O,  NULL},
   {"_cuda_maxMemoryCached", (PyCFunction) THCPModule_maxMemoryCached, METH_O,  NULL},
+  {"_cuda_memorySnapshot", (PyCFunction) THCPModule_memorySnapshot, METH_NOARGS, NULL},
+  {"_cuda_recordMemoryHistory", (PyCFunction) THCPModule_recordMemoryHistory, METH_VARARGS, NULL},
+  {"_cuda_memoryTraceChromeJSON", (PyCFunction) THCPModule_memoryTraceChromeJSON, METH_NOARGS, NULL},
+  {"_cuda_setAllocationTag", (PyCFunction) THCPModule_setAllocationTag, METH_O,  NULL},
+  {"_cuda_getAllocationTag", (PyCFunction) THCPModule_getAllocationTag, METH_NOARGS, NULL},
   {"_cuda_manualSeed",  (PyCFunction)THCPModule_manualSeed,       METH_O,       NULL},
   {"_cuda_manualSeedAll", (PyCFunction)THCPModule_manualSeedAll,  METH_O,       NULL},
   {"_cuda_seed",        (PyCFunction)THCPModule_seed,             METH_NOARGS,  NULL},
@@ -409,6 +513,8 @@ static struct PyMethodDef _THCPModule_methods[] = {
   {"_cuda_cudaHostAllocator", (PyCFunction)THCPModule_cudaHostAllocator, METH_NOARGS, NULL},
   {"_cuda_synchronize", (PyCFunction)THCPModule_cudaSynchronize, METH_NOARGS, NULL},
   {"_cuda_sleep", (PyCFunction)THCPModule_cudaSleep, METH_O, NULL},
+  {"_cuda_setDeterministicAccumulate", (PyCFunction)THCPModule_setDeterministicAccumulate, METH_O, NULL},
+  {"_cuda_getDeterministicAccumulate", (PyCFunction)THCPModule_getDeterministicAccumulate, METH_NOARGS, NULL},
   {"_cuda_lock_mutex",   (PyCFunction)THCPModule_cudaLockMutex,   METH_NOARGS,  NULL},
   {"_cuda_unlock_mutex", (PyCFunction)THCPModule_cudaUnlockMutex, METH_NOARGS,  NULL},
 #ifdef USE_NCCL
@@ -15,6 +15,7 @@
 #include <ATen/optional.h>
 
 #include <cstddef>
+#include <mutex>
 #include <vector>
 
 namespace torch { namespace cuda {
@@ -35,7 +36,76 @@ struct unique_type_checker {
   bool unique = true;
 };
 
-std::vector<Tensor> broadcast(const Tensor& tensor, IntList devices) {
+namespace {
+// NCCL collectives run on a dedicated stream per device rather than on the
+// current one, so that flattening the next bucket on the current stream
+// overlaps with the transfer of the previous one.
+THCStream* comm_stream(int64_t device) {
+  static std::mutex mutex;
+  static std::vector<THCStream*> streams;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (streams.empty()) {
+    streams.resize(at::globalContext().getNumGPUs(), nullptr);
+  }
+  if (!streams.at(device)) {
+    at::DeviceGuard device_guard(device);
+    streams[device] = THCStream_new(cudaStreamNonBlocking);
+  }
+  return streams[device];
+}
+
+// Makes `waiting` wait for the work queued on `stream` so far.
+void wait_stream(THCStream* waiting, THCStream* stream) {
+  at::DeviceGuard device_guard(THCStream_device(stream));
+  cudaEvent_t event;
+  THCudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  THCudaCheck(cudaEventRecord(event, THCStream_stream(stream)));
+  THCudaCheck(cudaStreamWaitEvent(THCStream_stream(waiting), event, 0));
+  THCudaCheck(cudaEventDestroy(event));
+}
+
+// Hands tensors over to the comm streams of their devices and back. Before
+// each collective, the comm streams wait for the work queued on the current
+// streams so far; release() then makes the current streams wait for all the
+// collectives. The tensors are kept alive until then, since the caching
+// allocator only orders the reuse of their memory against the current stream.
+class CommStreamHandoff {
+ public:
+  std::vector<THCStream*> acquire(TensorList tensors) {
+    auto* thc_state = at::globalContext().lazyInitCUDA();
+    std::vector<THCStream*> streams;
+    streams.reserve(tensors.size());
+    for (auto & tensor : tensors) {
+      const auto device = tensor.get_device();
+      streams.push_back(comm_stream(device));
+      wait_stream(streams.back(), THCState_getStreamOnDevice(thc_state, device));
+      if (!devices_[device]) {
+        devices_[device] = true;
+        used_devices_.push_back(device);
+      }
+      buffers_.push_back(tensor);
+    }
+    return streams;
+  }
+
+  void release() {
+    auto* thc_state = at::globalContext().lazyInitCUDA();
+    for (auto device : used_devices_) {
+      wait_stream(THCState_getStreamOnDevice(thc_state, device), comm_stream(device));
+    }
+    used_devices_.clear();
+    devices_ = device_set();
+    buffers_.clear();
+  }
+
+ private:
+  device_set devices_;
+  std::vector<int64_t> used_devices_;
+  std::vector<Tensor> buffers_;
+};
+
+std::vector<Tensor> broadcast(const Tensor& tensor, IntList devices,
+                              CommStreamHandoff& handoff) {
   auto & type = tensor.type();
   if (type.is_cuda() && tensor.get_device() != devices[0])
     throw std::runtime_error("device of broadcasted tensor must appear as the "
@@ -50,7 +120,7 @@ std::vector<Tensor> broadcast(const Tensor& tensor, IntList devices) {
       _device_guard.set_index(device);
       tensors.push_back(type.tensor(tensor.sizes()));
     }
-    nccl::broadcast(tensors);
+    nccl::broadcast(tensors, handoff.acquire(tensors));
   } else {
 #else
   {
@@ -67,6 +137,14 @@ std::vector<Tensor> broadcast(const Tensor& tensor, IntList devices) {
   }
   return tensors;
 }
+} // namespace
+
+std::vector<Tensor> broadcast(const Tensor& tensor, IntList devices) {
+  CommStreamHandoff handoff;
+  auto tensors = broadcast(tensor, devices, handoff);
+  handoff.release();
+  return tensors;
+}
 
 tensor_list2d broadcast_coalesced(TensorList tensors, IntList devices, size_t buffer_size) {
   if (!std::all_of(tensors.begin(), tensors.end(),
@@ -79,15 +157,23 @@ tensor_list2d broadcast_coalesced(TensorList tensors, IntList devices, size_t bu
   for (auto & o : outputs)
     o.reserve(tensors.size());
 
+  // The current streams only wait for the broadcasts once all buckets are
+  // queued, so that flattening a bucket overlaps with the transfer of the
+  // previous one.
+  CommStreamHandoff handoff;
   unique_type_checker type_checker;
   for (auto & chunk : utils::take_tensors(tensors, buffer_size)) {
     auto & type = chunk.type();
     type_checker.show(type);
     std::vector<at::Tensor> results;
     if (chunk.type().is_sparse()) {
+      // Unflattening sparse tensors reads the broadcast buffers, so hand
+      // them back right away.
       auto flat_tuple = utils::flatten_sparse_tensors(chunk.tensors);
-      std::vector<at::Tensor> broadcast_indices = broadcast(flat_tuple.first, devices);
-      std::vector<at::Tensor> broadcast_values = broadcast(flat_tuple.second, devices);
+      CommStreamHandoff sparse_handoff;
+      std::vector<at::Tensor> broadcast_indices = broadcast(flat_tuple.first, devices, sparse_handoff);
+      std::vector<at::Tensor> broadcast_values = broadcast(flat_tuple.second, devices, sparse_handoff);
+      sparse_handoff.release();
       results.reserve(devices.size());
       for (size_t i = 1, num_devices = devices.size(); i < num_devices; ++i) {
         at::DeviceGuard device_guard(devices[i]);
@@ -100,7 +186,7 @@ tensor_list2d broadcast_coalesced(TensorList tensors, IntList devices, size_t bu
     } else {
       at::DeviceGuard device_guard(devices[0]);
       std::vector<Tensor> results = broadcast(utils::flatten_dense_tensors(chunk.tensors),
-                                              devices);
+                                              devices, handoff);
       for (size_t i = 1, num_devices = devices.size(); i < num_devices; ++i) {
         device_guard.set_index(devices[i]);
         auto & device_outputs = outputs[i];
@@ -110,6 +196,8 @@ tensor_list2d broadcast_coalesced(TensorList tensors, IntList devices, size_t bu
     }
   }
 
+  handoff.release();
+
   // If we only saw a single tensor type, then we can skip expensive reordering
   if (!type_checker.unique) {
     for (auto & o : outputs)
@@ -118,6 +206,107 @@ tensor_list2d broadcast_coalesced(TensorList tensors, IntList devices, size_t bu
   return outputs;
 }
 
+namespace {
+Tensor reduce_add(TensorList inputs, int64_t destination,
+                  CommStreamHandoff& handoff) {
+  AT_CHECK(!inputs.empty(), "reduce_add expects at least one input");
+  at::optional<size_t> root;
+  for (size_t i = 0, num_inputs = inputs.size(); i < num_inputs; ++i) {
+    AT_CHECK(inputs[i].type().is_cuda(), "reduce_add expects all inputs to be on GPUs");
+    AT_CHECK(inputs[i].sizes() == inputs[0].sizes(),
+             "input ", i, " has invalid size: got ", inputs[i].sizes(),
+             ", but expected ", inputs[0].sizes());
+    if (!root && inputs[i].get_device() == destination) {
+      root = i;
+    }
+  }
+  AT_CHECK(root, "reduce_add expects destination to be on the same GPU with one of the tensors");
+
+  at::DeviceGuard device_guard(destination);
+  auto result = inputs[*root].type().tensor();
+  result.resize_as_(inputs[*root]).zero_();
+#ifdef USE_NCCL
+  if (nccl::is_available(inputs)) {
+    // NCCL only writes the output of the root.
+    std::vector<Tensor> outputs(inputs.begin(), inputs.end());
+    outputs[*root] = result;
+    auto streams = handoff.acquire(inputs);
+    handoff.acquire(result);
+    nccl::reduce(inputs, outputs, *root, ncclSum, streams);
+    return result;
+  }
+#endif
+  for (auto & input : inputs) {
+    result.add_(input.to({at::kCUDA, destination}));
+  }
+  return result;
+}
+} // namespace
+
+Tensor reduce_add(TensorList inputs, int64_t destination) {
+  CommStreamHandoff handoff;
+  auto result = reduce_add(inputs, destination, handoff);
+  handoff.release();
+  return result;
+}
+
+std::vector<Tensor> reduce_add_coalesced(const tensor_list2d& inputs,
+                                         int64_t destination,
+                                         size_t buffer_size) {
+  AT_CHECK(!inputs.empty(), "reduce_add_coalesced expects at least one device");
+  const auto num_tensors = inputs[0].size();
+  for (auto & device_inputs : inputs) {
+    AT_CHECK(device_inputs.size() == num_tensors,
+             "reduce_add_coalesced expects the same number of tensors on every device");
+  }
+
+  // Sparse tensors may have different numbers of nonzeros on different
+  // devices, so they are reduced one by one. Everything else is coalesced.
+  CommStreamHandoff handoff;
+  std::vector<Tensor> outputs;
+  std::vector<Tensor> ref_order;
+  tensor_list2d dense_inputs(inputs.size());
+  for (size_t t = 0; t < num_tensors; ++t) {
+    std::vector<Tensor> tensor_at_devices;
+    bool all_sparse = true;
+    for (auto & device_inputs : inputs) {
+      tensor_at_devices.push_back(device_inputs[t]);
+      all_sparse &= device_inputs[t].type().is_sparse();
+    }
+    if (all_sparse) {
+      outputs.push_back(reduce_add(tensor_at_devices, destination, handoff));
+      ref_order.push_back(tensor_at_devices[0]);
+    } else {
+      for (size_t d = 0; d < inputs.size(); ++d) {
+        auto & tensor = tensor_at_devices[d];
+        dense_inputs[d].push_back(tensor.type().is_sparse() ? tensor.to_dense() : tensor);
+      }
+      ref_order.push_back(dense_inputs[0].back());
+    }
+  }
+
+  // All devices hold tensors of the same sizes and types, so they are split
+  // into the same buckets.
+  std::vector<std::vector<utils::TensorGroup>> chunks;
+  for (auto & device_inputs : dense_inputs) {
+    chunks.push_back(utils::take_tensors(device_inputs, buffer_size));
+  }
+  for (size_t c = 0, num_chunks = chunks[0].size(); c < num_chunks; ++c) {
+    std::vector<Tensor> flat_tensors;
+    for (auto & device_chunks : chunks) {
+      at::DeviceGuard device_guard(device_chunks[c].tensors[0]);
+      flat_tensors.push_back(utils::flatten_dense_tensors(device_chunks[c].tensors));
+    }
+    auto flat_result = reduce_add(flat_tensors, destination, handoff);
+    for (auto & t : utils::unflatten_dense_tensors(flat_result, chunks[0][c].tensors))
+      outputs.push_back(std::move(t));
+  }
+  handoff.release();
+
+  utils::reorder_tensors_like(outputs, ref_order);
+  return outputs;
+}
+
 std::vector<at::Tensor> scatter(
     const at::Tensor& tensor,
     at::IntList devices,
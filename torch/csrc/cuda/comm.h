@@ -16,6 +16,11 @@ std::vector<at::Tensor> broadcast(const at::Tensor& tensor, at::IntList devices)
 tensor_list2d broadcast_coalesced(at::TensorList tensors, at::IntList devices,
                                   size_t buffer_size);
 
+at::Tensor reduce_add(at::TensorList inputs, int64_t destination);
+std::vector<at::Tensor> reduce_add_coalesced(const tensor_list2d& inputs,
+                                             int64_t destination,
+                                             size_t buffer_size);
+
 std::vector<at::Tensor> scatter(
     const at::Tensor& tensor,
     at::IntList devices,
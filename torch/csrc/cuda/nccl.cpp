@@ -199,4 +199,29 @@ void broadcast(TensorList tensors, const stream_list& streams, const comm_list&
 #endif
 }
 
+void reduce(TensorList inputs, TensorList outputs, int32_t root, int32_t op,
+            const stream_list& streams, const comm_list& user_comms) {
+#ifdef USE_NCCL
+  using namespace torch::cuda::nccl::detail;
+  AT_CHECK(root >= 0 && static_cast<size_t>(root) < inputs.size(), "invalid root");
+  _check_inputs(inputs, outputs, 1, 1);
+  const auto len = inputs.size();
+  ncclDataType_t data_type = _get_data_type(inputs[0].type());
+  const auto count = inputs[0].numel();
+
+  std::lock_guard<std::mutex> lock(*(THCCachingAllocator_getCudaFreeMutex()));
+  auto comms = user_comms.empty() ? _get_communicators(inputs) : ArrayRef<ncclComm_t>(user_comms);
+  at::DeviceGuard device_guard;
+  AutoNcclGroup nccl_group_guard;
+  for (size_t i = 0; i < len; i++) {
+    device_guard.set_index(inputs[i].get_device());
+    const auto stream = (streams.empty() || !streams[i]) ? NULL : THCStream_stream(streams[i]);
+    CHECK(ncclReduce(inputs[i].data_ptr(), outputs[i].data_ptr(),
+         count, data_type, (ncclRedOp_t) op, root, comms[i], stream));
+  }
+#else
+  throw std::runtime_error("PyTorch built without NCCL support");
+#endif
+}
+
 }}}
@@ -47,4 +47,13 @@ void broadcast(at::TensorList tensors,
                const stream_list& streams = {},
                const comm_list& user_comms = {});
 
+// Reduces `inputs`, which lie on distinct devices, into `outputs[root]`. The
+// other outputs are unused by NCCL and may alias their inputs.
+void reduce(at::TensorList inputs,
+            at::TensorList outputs,
+            int32_t root = 0,
+            int32_t op = ncclSum,
+            const stream_list& streams = {},
+            const comm_list& user_comms = {});
+
 }}}
@@ -3,7 +3,9 @@
 #include <c10d/Def.hpp>
 #include <c10d/FileStore.hpp>
 #include <c10d/ProcessGroup.hpp>
+#include <c10d/ProcessGroupCompressed.hpp>
 #include <c10d/ProcessGroupGloo.hpp>
+#include <c10d/ProcessGroupHierarchical.hpp>
 
 #ifdef USE_C10D_NCCL
 #include <c10d/ProcessGroupNCCL.hpp>
@@ -14,6 +16,7 @@
 #include <pybind11/chrono.h>
 
 #include "torch/csrc/Exceptions.h"
+#include "torch/csrc/distributed/c10d/reducer.h"
 #include "torch/csrc/utils/object_ptr.h"
 #include "torch/csrc/utils/pybind.h"
 
@@ -44,6 +47,17 @@ PyObject* c10d_init(PyObject* _unused) {
       .def(py::init<>())
       .def_readwrite("reduceOp", &::c10d::AllreduceOptions::reduceOp);
 
+  py::class_<::c10d::AllreduceCoalescedOptions>(
+      module, "AllreduceCoalescedOptions")
+      .def(py::init<>())
+      .def_readwrite("reduceOp", &::c10d::AllreduceCoalescedOptions::reduceOp)
+      .def_readwrite(
+          "bucketBytes", &::c10d::AllreduceCoalescedOptions::bucketBytes);
+
+  py::class_<::c10d::ReduceScatterOptions>(module, "ReduceScatterOptions")
+      .def(py::init<>())
+      .def_readwrite("reduceOp", &::c10d::ReduceScatterOptions::reduceOp);
+
   py::enum_<::c10d::ReduceOp>(module, "ReduceOp")
       .value("SUM", ::c10d::ReduceOp::SUM)
       .value("PRODUCT", ::c10d::ReduceOp::PRODUCT)
@@ -72,6 +86,34 @@ PyObject* c10d_init(PyObject* _unused) {
                     reinterpret_cast<char*>(value.data()), value.size());
               },
               py::call_guard<py::gil_scoped_release>())
+          .def(
+              "multi_set",
+              [](::c10d::Store& store,
+                 const std::vector<std::string>& keys,
+                 const std::vector<std::string>& values) {
+                std::vector<std::vector<uint8_t>> values_;
+                values_.reserve(values.size());
+                for (const auto& value : values) {
+                  values_.emplace_back(value.begin(), value.end());
+                }
+                store.multiSet(keys, values_);
+              },
+              py::call_guard<py::gil_scoped_release>())
+          .def(
+              "multi_get",
+              [](::c10d::Store& store, const std::vector<std::string>& keys) {
+                std::vector<std::vector<uint8_t>> values;
+                {
+                  py::gil_scoped_release release;
+                  values = store.multiGet(keys);
+                }
+                py::list result;
+                for (auto& value : values) {
+                  result.append(py::bytes(
+                      reinterpret_cast<char*>(value.data()), value.size()));
+                }
+                return result;
+              })
           .def(
               "add",
               &::c10d::Store::add,
@@ -121,6 +163,49 @@ PyObject* c10d_init(PyObject* _unused) {
               },
               py::arg("tensor"),
               py::arg("op") = ::c10d::ReduceOp::SUM,
+              py::call_guard<py::gil_scoped_release>())
+          .def(
+              "allreduce_coalesced",
+              &::c10d::ProcessGroup::allreduceCoalesced,
+              py::arg("tensors"),
+              py::arg("opts") = ::c10d::AllreduceCoalescedOptions(),
+              py::call_guard<py::gil_scoped_release>())
+          .def(
+              "reduce_scatter",
+              &::c10d::ProcessGroup::reduceScatter,
+              py::arg("outputs"),
+              py::arg("inputs"),
+              py::arg("opts") = ::c10d::ReduceScatterOptions(),
+              py::call_guard<py::gil_scoped_release>())
+          .def(
+              "allgather",
+              &::c10d::ProcessGroup::allgather,
+              py::arg("outputs"),
+              py::arg("inputs"),
+              py::call_guard<py::gil_scoped_release>())
+          .def(
+              "alltoall",
+              &::c10d::ProcessGroup::alltoall,
+              py::arg("outputs"),
+              py::arg("inputs"),
+              py::call_guard<py::gil_scoped_release>())
+          .def(
+              "send",
+              &::c10d::ProcessGroup::send,
+              py::arg("tensors"),
+              py::arg("dst"),
+              py::arg("tag") = 0,
+              py::call_guard<py::gil_scoped_release>())
+          .def(
+              "recv",
+              &::c10d::ProcessGroup::recv,
+              py::arg("tensors"),
+              py::arg("src"),
+              py::arg("tag") = 0,
+              py::call_guard<py::gil_scoped_release>())
+          .def(
+              "barrier",
+              &::c10d::ProcessGroup::barrier,
               py::call_guard<py::gil_scoped_release>());
 
   auto processGroupGloo = shared_ptr_class_<::c10d::ProcessGroupGloo>(
@@ -136,7 +221,12 @@ PyObject* c10d_init(PyObject* _unused) {
       .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads)
       .def_readwrite(
           "cacheNumAlgorithmEntries",
-          &::c10d::ProcessGroupGloo::Options::cacheNumAlgorithmEntries);
+          &::c10d::ProcessGroupGloo::Options::cacheNumAlgorithmEntries)
+      .def_readwrite(
+          "cacheSizeClasses",
+          &::c10d::ProcessGroupGloo::Options::cacheSizeClasses)
+      .def_readwrite(
+          "cacheMaxBytes", &::c10d::ProcessGroupGloo::Options::cacheMaxBytes);
 
   processGroupGloo.def_static(
       "create_tcp_device",
@@ -181,14 +271,119 @@ PyObject* c10d_init(PyObject* _unused) {
                 ::gloo::transport::tcp::CreateDevice(attr));
             return std::make_shared<::c10d::ProcessGroupGloo>(
                 store, rank, size, options);
-          }));
+          }))
+      .def(
+          "warm_up_allreduce",
+          &::c10d::ProcessGroupGloo::warmupAllreduce,
+          py::arg("tensors"),
+          py::arg("opts") = ::c10d::AllreduceOptions(),
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "warm_up_broadcast",
+          &::c10d::ProcessGroupGloo::warmupBroadcast,
+          py::arg("tensors"),
+          py::arg("opts") = ::c10d::BroadcastOptions(),
+          py::call_guard<py::gil_scoped_release>())
+      .def("cache_bytes", &::c10d::ProcessGroupGloo::getCacheBytes);
 
 #ifdef USE_C10D_NCCL
-  shared_ptr_class_<::c10d::ProcessGroupNCCL>(
-      module, "ProcessGroupNCCL", processGroup)
-      .def(py::init<const std::shared_ptr<::c10d::Store>&, int, int>());
+  auto processGroupNCCL =
+      shared_ptr_class_<::c10d::ProcessGroupNCCL>(
+          module, "ProcessGroupNCCL", processGroup)
+          .def(py::init<const std::shared_ptr<::c10d::Store>&, int, int>())
+          .def(
+              "warm_up",
+              [](::c10d::ProcessGroupNCCL& pg,
+                 const std::vector<int64_t>& deviceIndices) {
+                std::vector<at::Device> devices;
+                for (auto index : deviceIndices) {
+                  devices.emplace_back(at::kCUDA, index);
+                }
+                pg.warmUp(devices);
+              },
+              py::arg("devices"),
+              py::call_guard<py::gil_scoped_release>())
+          .def("stats", &::c10d::ProcessGroupNCCL::getStats);
+
+  py::class_<::c10d::ProcessGroupNCCL::Stats>(processGroupNCCL, "Stats")
+      .def_readonly(
+          "num_communicator_inits",
+          &::c10d::ProcessGroupNCCL::Stats::numCommunicatorInits)
+      .def_readonly(
+          "communicator_init_time",
+          &::c10d::ProcessGroupNCCL::Stats::communicatorInitTime)
+      .def_readonly(
+          "num_collectives", &::c10d::ProcessGroupNCCL::Stats::numCollectives)
+      .def_readonly(
+          "queueing_time", &::c10d::ProcessGroupNCCL::Stats::queueingTime)
+      .def_readonly(
+          "num_events_created",
+          &::c10d::ProcessGroupNCCL::Stats::numEventsCreated);
 #endif
 
+  shared_ptr_class_<::c10d::ProcessGroupHierarchical>(
+      module, "ProcessGroupHierarchical", processGroup)
+      .def(
+          py::init<
+              const std::shared_ptr<::c10d::ProcessGroup>&,
+              const std::shared_ptr<::c10d::ProcessGroup>&>(),
+          py::arg("intra_node_group"),
+          py::arg("inter_node_group"));
+
+  auto gradientCodec =
+      shared_ptr_class_<::c10d::GradientCodec>(module, "GradientCodec");
+
+  shared_ptr_class_<::c10d::Fp16Codec>(module, "Fp16Codec", gradientCodec)
+      .def(py::init<>());
+
+  shared_ptr_class_<::c10d::TopKCodec>(module, "TopKCodec", gradientCodec)
+      .def(py::init<double>(), py::arg("ratio"));
+
+  shared_ptr_class_<::c10d::SignCodec>(module, "SignCodec", gradientCodec)
+      .def(py::init<>());
+
+  shared_ptr_class_<::c10d::ProcessGroupCompressed>(
+      module, "ProcessGroupCompressed", processGroup)
+      .def(
+          py::init<
+              const std::shared_ptr<::c10d::ProcessGroup>&,
+              const std::shared_ptr<::c10d::GradientCodec>&>(),
+          py::arg("process_group"),
+          py::arg("codec"))
+      .def(
+          "allreduce",
+          [](::c10d::ProcessGroupCompressed& pg,
+             at::Tensor& x,
+             const std::string& residualKey,
+             ::c10d::ReduceOp op) {
+            ::c10d::AllreduceOptions opts;
+            opts.reduceOp = op;
+            std::vector<at::Tensor> xs = {x};
+            return pg.allreduce(xs, residualKey, opts);
+          },
+          py::arg("tensor"),
+          py::arg("residual_key") = "",
+          py::arg("op") = ::c10d::ReduceOp::SUM,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "drop_residual",
+          &::c10d::ProcessGroupCompressed::dropResidual,
+          py::arg("residual_key"))
+      .def(
+          "clear_residuals", &::c10d::ProcessGroupCompressed::clearResiduals);
+
+  shared_ptr_class_<Reducer>(module, "Reducer")
+      .def(
+          py::init<
+              std::vector<torch::autograd::Variable>,
+              std::shared_ptr<::c10d::ProcessGroup>,
+              size_t>(),
+          py::arg("parameters"),
+          py::arg("process_group"),
+          py::arg("bucket_bytes_cap") = 25 * 1024 * 1024)
+      .def("num_buckets", &Reducer::numBuckets)
+      .def("bucket_assignment", &Reducer::bucketAssignment);
+
   shared_ptr_class_<::c10d::ProcessGroup::Work>(module, "Work")
       .def("isCompleted", &::c10d::ProcessGroup::Work::isCompleted)
       .def("isSuccess", &::c10d::ProcessGroup::Work::isSuccess)
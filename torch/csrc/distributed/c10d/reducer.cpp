@@ -0,0 +1,216 @@
+#include "torch/csrc/distributed/c10d/reducer.h"
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "torch/csrc/autograd/engine.h"
+#include "torch/csrc/autograd/function_hook.h"
+
+namespace torch {
+namespace distributed {
+namespace c10d {
+
+namespace {
+
+using torch::autograd::Variable;
+using torch::autograd::variable_list;
+
+class LambdaPostHook : public torch::autograd::FunctionPostHook {
+ public:
+  explicit LambdaPostHook(std::function<void()> fn) : fn_(std::move(fn)) {}
+
+  variable_list operator()(
+      const variable_list& outputs,
+      const variable_list& /* unused */) override {
+    fn_();
+    return outputs;
+  }
+
+ private:
+  std::function<void()> fn_;
+};
+
+} // namespace
+
+Reducer::Reducer(
+    std::vector<Variable> parameters,
+    std::shared_ptr<::c10d::ProcessGroup> process_group,
+    size_t bucket_bytes_cap)
+    : parameters_(std::move(parameters)),
+      process_group_(std::move(process_group)),
+      next_bucket_(0),
+      backward_in_progress_(false) {
+  locations_.resize(parameters_.size());
+
+  // Buckets that are still being filled, by type and device.
+  std::map<std::tuple<const at::Type*, int64_t>, size_t> open_buckets;
+  std::vector<size_t> bucket_bytes;
+  for (size_t i = parameters_.size(); i-- > 0;) {
+    auto& parameter = parameters_[i];
+    if (!parameter.requires_grad()) {
+      throw std::runtime_error(
+          "Reducer: parameter " + std::to_string(i) +
+          " doesn't require grad");
+    }
+    auto& data = parameter.data();
+    if (data.type().is_sparse()) {
+      throw std::runtime_error("Reducer: only dense parameters are supported");
+    }
+    auto bytes = data.numel() * data.type().elementSizeInBytes();
+    auto key = std::make_tuple(
+        &data.type(), data.type().is_cuda() ? data.get_device() : -1);
+    auto it = open_buckets.find(key);
+    if (it != open_buckets.end() &&
+        bucket_bytes[it->second] + bytes > bucket_bytes_cap) {
+      open_buckets.erase(it);
+      it = open_buckets.end();
+    }
+    if (it == open_buckets.end()) {
+      it = open_buckets.emplace(key, buckets_.size()).first;
+      buckets_.emplace_back();
+      bucket_bytes.push_back(0);
+    }
+    auto& bucket = buckets_[it->second];
+    locations_[i] = Location{it->second, bucket.parameters.size()};
+    int64_t offset = bucket.offsets.empty()
+        ? 0
+        : bucket.offsets.back() + parameters_[bucket.parameters.back()].numel();
+    bucket.parameters.push_back(i);
+    bucket.offsets.push_back(offset);
+    bucket_bytes[it->second] += bytes;
+  }
+
+  for (auto& bucket : buckets_) {
+    auto& last = parameters_[bucket.parameters.back()];
+    bucket.contents = at::empty(
+        {bucket.offsets.back() + last.numel()}, last.data().options());
+    bucket.pending = bucket.parameters.size();
+  }
+
+  for (size_t i = 0; i < parameters_.size(); ++i) {
+    auto grad_accumulator = parameters_[i].grad_accumulator();
+    if (!grad_accumulator) {
+      throw std::runtime_error(
+          "Reducer: parameter " + std::to_string(i) + " isn't a leaf");
+    }
+    std::unique_ptr<torch::autograd::FunctionPostHook> hook(
+        new LambdaPostHook([this, i] { markReady(i); }));
+    hooks_.push_back(hook.get());
+    grad_accumulator->add_post_hook(std::move(hook));
+    grad_accumulators_.push_back(std::move(grad_accumulator));
+  }
+}
+
+Reducer::~Reducer() {
+  for (size_t i = 0; i < grad_accumulators_.size(); ++i) {
+    auto& hooks = grad_accumulators_[i]->post_hooks();
+    hooks.erase(
+        std::remove_if(
+            hooks.begin(),
+            hooks.end(),
+            [&](const std::unique_ptr<torch::autograd::FunctionPostHook>& h) {
+              return h.get() == hooks_[i];
+            }),
+        hooks.end());
+  }
+}
+
+std::vector<std::vector<size_t>> Reducer::bucketAssignment() const {
+  std::vector<std::vector<size_t>> assignment;
+  for (auto& bucket : buckets_) {
+    assignment.push_back(bucket.parameters);
+  }
+  return assignment;
+}
+
+// Called by the engine after the gradient accumulator of the parameter ran,
+// possibly on any of its worker threads.
+void Reducer::markReady(size_t parameter) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!backward_in_progress_) {
+    backward_in_progress_ = true;
+    torch::autograd::Engine::get_default_engine().queue_callback(
+        [this] { finalizeBackward(); });
+  }
+
+  auto& location = locations_[parameter];
+  auto& bucket = buckets_[location.bucket];
+  auto& grad = parameters_[parameter].grad();
+  if (!grad.defined()) {
+    return;
+  }
+  auto& grad_variable = torch::autograd::as_variable_ref(grad);
+  if (grad_variable.requires_grad()) {
+    throw std::runtime_error(
+        "Reducer only works with gradients that don't require grad");
+  }
+  auto& grad_data = grad_variable.data();
+  if (grad_data.type().is_sparse()) {
+    throw std::runtime_error("Reducer only works with dense gradients");
+  }
+  bucket.contents
+      .narrow(0, bucket.offsets[location.index], grad_data.numel())
+      .copy_(grad_data.contiguous().view({-1}));
+  if (--bucket.pending > 0) {
+    return;
+  }
+
+  while (next_bucket_ < buckets_.size() &&
+         buckets_[next_bucket_].pending == 0) {
+    auto& next = buckets_[next_bucket_];
+    std::vector<at::Tensor> data = {next.contents};
+    next.work = process_group_->allreduce(data);
+    next_bucket_++;
+  }
+}
+
+void Reducer::finalizeBackward() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (next_bucket_ < buckets_.size()) {
+    auto pending = buckets_[next_bucket_].pending;
+    std::string message = "Reducer: expected every parameter to receive a "
+                          "gradient, but bucket " +
+        std::to_string(next_bucket_) + " is still missing " +
+        std::to_string(pending) +
+        " of them. This leaves the processes out of sync.";
+    resetBackward();
+    throw std::runtime_error(message);
+  }
+
+  auto scale = 1.0 / process_group_->getSize();
+  for (auto& bucket : buckets_) {
+    if (!bucket.work->wait()) {
+      std::string message = bucket.work->exception().what();
+      resetBackward();
+      throw std::runtime_error(message);
+    }
+    bucket.contents.mul_(scale);
+    for (size_t i = 0; i < bucket.parameters.size(); ++i) {
+      auto& grad_data = torch::autograd::as_variable_ref(
+                            parameters_[bucket.parameters[i]].grad())
+                            .data();
+      grad_data.copy_(
+          bucket.contents.narrow(0, bucket.offsets[i], grad_data.numel())
+              .view(grad_data.sizes()));
+    }
+  }
+  resetBackward();
+}
+
+void Reducer::resetBackward() {
+  for (auto& bucket : buckets_) {
+    bucket.pending = bucket.parameters.size();
+    bucket.work.reset();
+  }
+  next_bucket_ = 0;
+  backward_in_progress_ = false;
+}
+
+} // namespace c10d
+} // namespace distributed
+} // namespace torch
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <ATen/ATen.h>
+
+#include <c10d/ProcessGroup.hpp>
+
+#include "torch/csrc/autograd/function.h"
+#include "torch/csrc/autograd/variable.h"
+
+namespace torch {
+namespace distributed {
+namespace c10d {
+
+// Reduces the gradients of a set of parameters across a process group
+// while backward is still running.
+//
+// The parameters are packed into buckets of at most bucket_bytes_cap bytes
+// (a single parameter larger than that gets a bucket of its own), walking
+// them in reverse registration order, as that's roughly the order in which
+// backward produces their gradients. Every bucket only holds parameters of
+// the same type and device.
+//
+// A hook on the gradient accumulator of every parameter copies the
+// gradient into its bucket once it's been accumulated. When a bucket is
+// full it is allreduced asynchronously, so that the communication overlaps
+// with the rest of backward. Buckets are always launched in order, as every
+// process must issue the same collectives in the same order.
+//
+// At the end of backward the reducer waits for all reductions, averages
+// the results over the processes and copies them back into the gradients.
+// Every parameter must receive a gradient in every backward pass.
+class Reducer {
+ public:
+  explicit Reducer(
+      std::vector<torch::autograd::Variable> parameters,
+      std::shared_ptr<::c10d::ProcessGroup> process_group,
+      size_t bucket_bytes_cap = 25 * 1024 * 1024);
+
+  ~Reducer();
+
+  Reducer(const Reducer&) = delete;
+  Reducer& operator=(const Reducer&) = delete;
+
+  size_t numBuckets() const {
+    return buckets_.size();
+  }
+
+  // The indices into parameters of the parameters in every bucket.
+  std::vector<std::vector<size_t>> bucketAssignment() const;
+
+ protected:
+  struct Bucket {
+    std::vector<size_t> parameters;
+    // the offsets of the parameters in contents, in elements
+    std::vector<int64_t> offsets;
+    at::Tensor contents;
+    // the number of parameters whose gradient is still missing
+    size_t pending;
+    std::shared_ptr<::c10d::ProcessGroup::Work> work;
+  };
+
+  struct Location {
+    size_t bucket;
+    size_t index; // into Bucket::parameters
+  };
+
+  void markReady(size_t parameter);
+  void finalizeBackward();
+  // requires mutex_
+  void resetBackward();
+
+  std::mutex mutex_;
+  std::vector<torch::autograd::Variable> parameters_;
+  std::shared_ptr<::c10d::ProcessGroup> process_group_;
+  std::vector<Bucket> buckets_;
+  std::vector<Location> locations_;
+  // keep the accumulators alive, they own the hooks
+  std::vector<std::shared_ptr<torch::autograd::Function>> grad_accumulators_;
+  std::vector<torch::autograd::FunctionPostHook*> hooks_;
+  // the first bucket that hasn't been launched in this backward pass
+  size_t next_bucket_;
+  bool backward_in_progress_;
+};
+
+} // namespace c10d
+} // namespace distributed
+} // namespace torch
@@ -14,6 +14,12 @@ static PyObject * THPStorage_(sharedDecref)(THPStorage *self)
   if (ctx) {
     ctx->decref();
   }
+#ifndef _WIN32
+  THManagedPoolBlock *block = THManagedPoolBlock::fromDataPtr(storage->data_ptr);
+  if (block) {
+    block->decref();
+  }
+#endif
 #endif
   Py_INCREF(self);
   return (PyObject *)self;
@@ -29,6 +35,12 @@ static PyObject * THPStorage_(sharedIncref)(THPStorage *self)
   if (ctx) {
     ctx->incref();
   }
+#ifndef _WIN32
+  THManagedPoolBlock *block = THManagedPoolBlock::fromDataPtr(storage->data_ptr);
+  if (block) {
+    block->incref();
+  }
+#endif
 #endif
   Py_RETURN_NONE;
   END_HANDLE_TH_ERRORS
@@ -127,6 +139,98 @@ static PyObject * THPStorage_(newSharedFilename)(PyObject *_unused, PyObject *ar
   END_HANDLE_TH_ERRORS
 }
 
+#ifndef _WIN32
+static THWStorage* THPStorage_(newPoolStorage)(ptrdiff_t size)
+{
+  return THWStorage_(newWithDataAndAllocator)(
+      THManagedPoolBlock::makeDataPtr(size * sizeof(real)), size, /* allocator */ nullptr);
+}
+
+static PyObject * THPStorage_(pyNewPoolStorage)(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  long long size;
+  if (!PyArg_ParseTuple(args, "L", &size)) {
+    return NULL;
+  }
+  return THPStorage_(New)(THPStorage_(newPoolStorage)(size));
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPStorage_(sharePool)(THPStorage *self)
+{
+  HANDLE_TH_ERRORS
+  THWStorage *storage = self->cdata;
+  THManagedPoolBlock *block;
+  // Storage is already in a block of the pool, just return its position
+  if ((block = THManagedPoolBlock::fromDataPtr(storage->data_ptr))) {
+    // done
+  } else {
+    THWStoragePtr new_storage(THPStorage_(newPoolStorage)(storage->size));
+    THWStorage_(copy)(new_storage, storage);
+    THWStorage_(swap)(storage, new_storage);
+    block = THManagedPoolBlock::fromDataPtr(storage->data_ptr);
+    AT_ASSERT(block);
+  }
+
+  THPObjectPtr manager_handle(PyBytes_FromString(block->manager_handle()));
+  if (!manager_handle) return NULL;
+  THPObjectPtr segment_handle(PyBytes_FromString(block->segment_name()));
+  if (!segment_handle) return NULL;
+  THPObjectPtr segment_size(PyLong_FromLongLong(block->segment_size()));
+  if (!segment_size) return NULL;
+  THPObjectPtr offset(PyLong_FromLongLong(block->offset()));
+  if (!offset) return NULL;
+  THPObjectPtr generation(PyLong_FromLongLong(block->generation()));
+  if (!generation) return NULL;
+  THPObjectPtr size(PyLong_FromLong(storage->size));
+  if (!size) return NULL;
+
+  THPObjectPtr tuple(PyTuple_New(6));
+  if (!tuple) return NULL;
+  PyTuple_SET_ITEM(tuple.get(), 0, manager_handle.release());
+  PyTuple_SET_ITEM(tuple.get(), 1, segment_handle.release());
+  PyTuple_SET_ITEM(tuple.get(), 2, segment_size.release());
+  PyTuple_SET_ITEM(tuple.get(), 3, offset.release());
+  PyTuple_SET_ITEM(tuple.get(), 4, generation.release());
+  PyTuple_SET_ITEM(tuple.get(), 5, size.release());
+  return tuple.release();
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPStorage_(newSharedPool)(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyTuple_GET_SIZE(args) == 6, "tuple of 6 items expected");
+  PyObject *_manager_handle = PyTuple_GET_ITEM(args, 0);
+  PyObject *_segment_handle = PyTuple_GET_ITEM(args, 1);
+  PyObject *_segment_size = PyTuple_GET_ITEM(args, 2);
+  PyObject *_offset = PyTuple_GET_ITEM(args, 3);
+  PyObject *_generation = PyTuple_GET_ITEM(args, 4);
+  PyObject *_size = PyTuple_GET_ITEM(args, 5);
+  if (!PyBytes_Check(_manager_handle) || !PyBytes_Check(_segment_handle) ||
+      !THPUtils_checkLong(_segment_size) || !THPUtils_checkLong(_offset) ||
+      !THPUtils_checkLong(_generation) || !THPUtils_checkLong(_size)) {
+    THPUtils_invalidArguments(args, NULL, "_new_shared in file system pool mode", 1,
+        "a manager handle and segment handle (string/bytes), the segment size, block "
+        "offset and block generation (int) and storage size (int)");
+    return NULL;
+  }
+  const char *manager_handle = PyBytes_AS_STRING(_manager_handle);
+  const char *segment_handle = PyBytes_AS_STRING(_segment_handle);
+  int64_t segment_size = THPUtils_unpackLong(_segment_size);
+  int64_t offset = THPUtils_unpackLong(_offset);
+  int64_t generation = THPUtils_unpackLong(_generation);
+  int64_t size = THPUtils_unpackLong(_size);
+  return THPStorage_(New)(
+          THWStorage_(newWithDataAndAllocator)(
+            THManagedPoolBlock::makeDataPtr(manager_handle, segment_handle, segment_size, offset, generation),
+            size,
+            /* allocator */ nullptr));
+  END_HANDLE_TH_ERRORS
+}
+#endif
+
 static THWStorage* THPStorage_(newFdStorage)(ptrdiff_t size)
 {
   int flags = TH_ALLOCATOR_MAPPED_SHAREDMEM |
@@ -371,9 +475,13 @@ PyObject * THPStorage_(isShared)(THPStorage *self)
   if (THMapAllocator::fromDataPtr(self->cdata->data_ptr) ||
       THManagedMapAllocator::fromDataPtr(self->cdata->data_ptr)) {
     Py_RETURN_TRUE;
-  } else {
-    Py_RETURN_FALSE;
   }
+#ifndef _WIN32
+  if (THManagedPoolBlock::fromDataPtr(self->cdata->data_ptr)) {
+    Py_RETURN_TRUE;
+  }
+#endif
+  Py_RETURN_FALSE;
 #endif
 }
 
@@ -389,6 +497,11 @@ static PyMethodDef THPStorage_(sharingMethods)[] = {
   {"_share_filename_", (PyCFunction)THPStorage_(shareFilename), METH_NOARGS, NULL},
   {"_new_shared_filename", (PyCFunction)THPStorage_(newSharedFilename), METH_VARARGS | METH_STATIC, NULL},
   {"_new_using_filename", (PyCFunction)THPStorage_(pyNewFilenameStorage), METH_VARARGS | METH_STATIC, NULL},
+#ifndef _WIN32
+  {"_share_pool_", (PyCFunction)THPStorage_(sharePool), METH_NOARGS, NULL},
+  {"_new_shared_pool", (PyCFunction)THPStorage_(newSharedPool), METH_VARARGS | METH_STATIC, NULL},
+  {"_new_using_pool", (PyCFunction)THPStorage_(pyNewPoolStorage), METH_VARARGS | METH_STATIC, NULL},
+#endif
 #endif
   {"_weak_ref", (PyCFunction)THPStorage_(weakRef), METH_O, NULL},
   {"_free_weak_ref", (PyCFunction)THPStorage_(freeWeakRef), METH_O | METH_STATIC, NULL},
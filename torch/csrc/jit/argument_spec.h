@@ -1,9 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
+#include "torch/csrc/assertions.h"
 #include "torch/csrc/autograd/variable.h"
 #include "torch/csrc/utils/hash.h"
+#include "torch/csrc/jit/type.h"
 #include "torch/csrc/jit/variable_tensor_list.h"
 
 namespace torch { namespace jit {
@@ -39,8 +42,12 @@ struct TensorInfo;
 
 struct ArgumentSpec {
   // note: tensors must always be variables
-  ArgumentSpec(bool with_grad, const variable_tensor_list & tensors)
-  :  hash_code(0), ntensors(tensors.size()) {
+  // If with_sizes is false, the spec only records the rank of each tensor,
+  // which of its dimensions have size 1 (so broadcasting is unchanged), and
+  // its contiguity, see TensorDesc::findContiguous. Such a spec stands for
+  // a whole family of full specs and cannot be used to specialize a graph.
+  ArgumentSpec(bool with_grad, const variable_tensor_list & tensors, bool with_sizes = true)
+  :  hash_code(0), ntensors(tensors.size()), with_sizes(with_sizes) {
     int all_dims = 0;
     for(size_t i = 0; i < ntensors; i++) {
       all_dims += tensors[i].defined() ? tensors[i].ndimension() : 0;
@@ -62,27 +69,63 @@ struct ArgumentSpec {
         pod.requires_grad = with_grad && static_cast<const autograd::Variable&>(t).requires_grad();
         total_dims += t.ndimension();
         auto sizes = t.sizes();
-        std::copy(sizes.begin(),sizes.end(), next_dim);
-        next_dim += sizes.size();
         auto strides = t.strides();
-        std::copy(strides.begin(), strides.end(), next_dim);
-        next_dim += strides.size();
+        if(with_sizes) {
+          std::copy(sizes.begin(),sizes.end(), next_dim);
+          next_dim += sizes.size();
+          std::copy(strides.begin(), strides.end(), next_dim);
+          next_dim += strides.size();
+        } else {
+          for(auto s : sizes)
+            *next_dim++ = s == 1 ? 1 : -1;
+          for(size_t d = 0; d < strides.size(); ++d) {
+            int64_t expected_stride = (d + 1 < sizes.size()) ? sizes[d+1]*strides[d+1] : 1;
+            *next_dim++ = strides[d] == expected_stride;
+          }
+        }
       }
       // each POD has a running tally of all dimensions including its own
       pod.total_dims = total_dims;
     }
-    // we precompute the hash_code to minimize the time inside of hash
-    // table operations where we may need to hold a compiler cache lock.
-    hash_code = hash_combine(0, ntensors);
-    for(auto d : data) {
-      hash_code = hash_combine(hash_code, d);
+    computeHashCode();
+  }
+
+  // The spec of inputs of these types, none of which requires grad, e.g.
+  // the input types of a graph specialized to a spec (see TensorInfo's
+  // conversion to TypePtr). DynamicType stands for an undefined tensor.
+  explicit ArgumentSpec(at::ArrayRef<TypePtr> types)
+  :  hash_code(0), ntensors(types.size()), with_sizes(true) {
+    int all_dims = 0;
+    for(auto & type : types) {
+      if(auto t = type->cast<TensorType>())
+        all_dims += t->sizes().size();
+    }
+    data.resize(ntensors + all_dims*2);
+
+    TensorInfoPOD * pods = reinterpret_cast<TensorInfoPOD*>(data.data());
+    int64_t * next_dim = sizes_strides();
+    int total_dims = 0;
+    for(size_t i = 0; i < ntensors; i++) {
+      auto & pod = pods[i];
+      auto t = types[i]->cast<TensorType>();
+      pod.defined = t != nullptr;
+      if(t) {
+        pod.type = static_cast<unsigned int>(t->scalarType());
+        pod.device = t->device();
+        pod.requires_grad = false;
+        total_dims += t->sizes().size();
+        next_dim = std::copy(t->sizes().begin(), t->sizes().end(), next_dim);
+        next_dim = std::copy(t->strides().begin(), t->strides().end(), next_dim);
+      }
+      pod.total_dims = total_dims;
     }
+    computeHashCode();
   }
 
   // equality is fast: check ntensors, and then check the raw array data,
   // there are no size/stride indirections
   bool operator==(const ArgumentSpec & spec) const {
-    return ntensors == spec.ntensors && data == spec.data;
+    return ntensors == spec.ntensors && with_sizes == spec.with_sizes && data == spec.data;
   }
   bool operator!=(const ArgumentSpec & spec) const {
     return !(*this == spec);
@@ -95,8 +138,21 @@ struct ArgumentSpec {
   size_t hashCode() const {
     return hash_code;
   }
+  // false if sizes and strides were abstracted away, see the constructor
+  bool hasSizes() const {
+    return with_sizes;
+  }
 
 private:
+  void computeHashCode() {
+    // we precompute the hash_code to minimize the time inside of hash
+    // table operations where we may need to hold a compiler cache lock.
+    hash_code = hash_combine(0, ntensors);
+    hash_code = hash_combine(hash_code, with_sizes);
+    for(auto d : data) {
+      hash_code = hash_combine(hash_code, d);
+    }
+  }
   ArrayRef<TensorInfoPOD> tensor_info() const {
     return ArrayRef<TensorInfoPOD>(reinterpret_cast<const TensorInfoPOD*>(data.data()), ntensors);
   }
@@ -109,6 +165,7 @@ private:
   }
   size_t hash_code; // precomputed on construction
   uint32_t ntensors;
+  bool with_sizes;
   // layout is ntensors of TensorPOD (each 64-bit) followed by their size and stride info
   // for 3 tensors: [t0POD][t1POD][t2POD][t0 sizes][t0 strides][t1 sizes][t1 strides][t2 sizes][t2 strides]
   std::vector<int64_t> data;
@@ -130,6 +187,9 @@ struct TensorInfo {
   int device() const {
     return pod(i).device;
   }
+  bool hasSizes() const {
+    return spec.hasSizes();
+  }
   int ndimension() const {
     // See [valid range], it is always valid to ask for offset for (i + 1)
     return (sizes_strides_offset(i + 1) - sizes_strides_offset(i))/2;
@@ -144,6 +204,7 @@ struct TensorInfo {
   operator TypePtr() const {
     if(!defined())
       return DynamicType::get();
+    JIT_ASSERTM(spec.hasSizes(), "cannot create a type from an ArgumentSpec without sizes");
     return std::make_shared<TensorType>(type(), device(), sizes(), strides());
   }
 private:
@@ -167,9 +228,15 @@ inline std::ostream & operator<<(std::ostream & out, const TensorInfo & info) {
   }
   out << "Tensor(device=" << info.device()
     << ", type=" << toString(info.type())
-    << ", requires_grad=" << info.requires_grad()
-    << ", sizes=" << info.sizes()
-    << ", strides=" << info.strides() << ")";
+    << ", requires_grad=" << info.requires_grad();
+  if(info.hasSizes()) {
+    out << ", sizes=" << info.sizes()
+      << ", strides=" << info.strides() << ")";
+  } else {
+    // -1 is any size other than 1, see ArgumentSpec
+    out << ", sizes=" << info.sizes()
+      << ", contiguity=" << info.strides() << ")";
+  }
   return out;
 }
 
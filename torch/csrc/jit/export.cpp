@@ -6,9 +6,11 @@
 #include <ATen/ATen.h>
 #include <ATen/optional.h>
 
+#include <cstdint>
 #include <cstring>
 #include <fstream>
 #include <memory>
+#include <sstream>
 #include <vector>
 #include <string>
 
@@ -25,6 +27,8 @@ std::string value_name(Value* n) {
 struct ExportContext {
   size_t num_blocks = 0;
   onnx::OperatorExportTypes operator_export_type;
+  // also record the complete type of every value, see encodeType
+  bool export_types = false;
 };
 
 void encodeGraph(onnx::GraphProto * p_g, const std::shared_ptr<Graph> & g,
@@ -191,11 +195,47 @@ void encodeTypeProtoTensorType(onnx::TypeProtoTensor* tensor_type, Value* n) {
   }
 }
 
-void encodeValueInfo(onnx::ValueInfoProto* v, Value* n) {
+// ONNX types have no strides or devices, so typed exports write the
+// complete type of a value to the doc_string of its ValueInfoProto:
+//   Tensor <scalar type> <device> <ndim> <sizes...> <strides...>
+// or the name of the type kind for Number, Float, Int and Dynamic.
+// Lists and tuples are written as Dynamic. ImportIRGraph parses this back.
+std::string encodeType(const TypePtr & type) {
+  std::stringstream ss;
+  switch(type->kind()) {
+    case TypeKind::TensorType: {
+      auto t = type->expect<TensorType>();
+      ss << "Tensor " << static_cast<int>(t->scalarType()) << " " << t->device()
+         << " " << t->sizes().size();
+      for(auto s : t->sizes())
+        ss << " " << s;
+      for(auto s : t->strides())
+        ss << " " << s;
+    } break;
+    case TypeKind::NumberType:
+      ss << "Number";
+      break;
+    case TypeKind::FloatType:
+      ss << "Float";
+      break;
+    case TypeKind::IntType:
+      ss << "Int";
+      break;
+    default:
+      ss << "Dynamic";
+      break;
+  }
+  return ss.str();
+}
+
+void encodeValueInfo(onnx::ValueInfoProto* v, Value* n, ExportContext *ctx) {
   v->set_name(value_name(n));
   onnx::TypeProto* t = v->mutable_type();
   onnx::TypeProtoTensor* tensor_type = t->mutable_tensor_type();
   encodeTypeProtoTensorType(tensor_type, n);
+  if (ctx->export_types) {
+    v->set_doc_string(encodeType(n->type()));
+  }
 }
 
 void encodeGraph(onnx::GraphProto * p_g, const std::shared_ptr<Graph>& g,
@@ -217,11 +257,11 @@ void encodeBlock(onnx::GraphProto * p_g, Block *b,
 
   for (auto input : b->inputs()) {
     onnx::ValueInfoProto* v = p_g->add_input();
-    encodeValueInfo(v, input);
+    encodeValueInfo(v, input, ctx);
   }
   for (auto output : b->outputs()) {
     onnx::ValueInfoProto* v = p_g->add_output();
-    encodeValueInfo(v, output);
+    encodeValueInfo(v, output, ctx);
   }
   for (auto node : b->nodes()) {
     bool is_raw_export = ctx->operator_export_type == onnx::OperatorExportTypes::RAW;
@@ -246,6 +286,9 @@ void encodeBlock(onnx::GraphProto * p_g, Block *b,
     }
     for(auto output : node->outputs()) {
       p_n->add_output(value_name(output));
+      if (ctx->export_types) {
+        encodeValueInfo(p_g->add_value_info(), output, ctx);
+      }
     }
     if (is_raw_export) {
       JIT_ASSERT(!node->kind().is_onnx());
@@ -417,6 +460,16 @@ std::string PrettyPrintExportedGraph(
   return model_proto.prettyPrint();
 }
 
+namespace {
+
+bool writeToStream(pb_ostream_t *stream, const pb_byte_t *buf, size_t count) {
+  auto out = static_cast<std::ostream*>(stream->state);
+  out->write(reinterpret_cast<const char*>(buf), count);
+  return out->good();
+}
+
+} // namespace
+
 // export_raw_ir will export IR ops without turning them into ONNX ops.
 // The output will use the ONNX protobuf format, but the ops will not
 // conform to the ONNX op specification. Thus, the output will not
@@ -445,4 +498,72 @@ std::tuple<std::string, RawDataExportMap> ExportGraph(
   return std::make_tuple(out, raw_data_export_map);
 }
 
+RawDataExportMap ExportGraph(
+                        const std::shared_ptr<Graph>& graph,
+                        const std::vector<at::Tensor> & initializers,
+                        int64_t onnx_opset_version,
+                        bool defer_weight_export,
+                        ::torch::onnx::OperatorExportTypes operator_export_type,
+                        std::ostream& out) {
+  ::torch::onnx::ModelProto model_proto;
+  RawDataExportMap raw_data_export_map;
+  raw_data_export_map = ToModelProto(
+    graph, initializers, onnx_opset_version, defer_weight_export, operator_export_type,
+    &model_proto);
+
+  // nanopb encodes the raw data of the tensors straight from their memory, so
+  // streaming it avoids holding a second copy of the weights
+  pb_ostream_t ostream = pb_ostream_from_buffer(nullptr, 0);
+  ostream.callback = &writeToStream;
+  ostream.state = &out;
+  ostream.max_size = SIZE_MAX;
+  if (!pb_encode(&ostream, onnx_ModelProto_fields, &model_proto.proto)) {
+    throw std::runtime_error("Failed to write the exported graph");
+  }
+  return raw_data_export_map;
+}
+
+void ExportRawData(
+    const RawDataExportMap& raw_data_export_map,
+    const std::string& directory) {
+  for (auto& kv : raw_data_export_map) {
+    const auto& t = kv.second;
+    std::ofstream out(directory + "/" + kv.first, std::ios::binary);
+    out.write(
+        static_cast<const char*>(t.data_ptr()),
+        t.type().elementSizeInBytes() * t.numel());
+    if (!out.good()) {
+      throw std::runtime_error("Failed to write the raw data of " + kv.first);
+    }
+  }
+}
+
+std::string ExportExecutionPlans(const std::vector<std::shared_ptr<Graph>>& plans) {
+  ::torch::onnx::ModelProto model_proto;
+  model_proto.set_producer_name("pytorch");
+  model_proto.set_producer_version("0.3");
+
+  ExportContext ctx;
+  ctx.operator_export_type = onnx::OperatorExportTypes::RAW;
+  ctx.export_types = true;
+  // a single node holding the plans as graph attributes
+  auto p_g = model_proto.mutable_graph();
+  p_g->set_name("torch-jit-execution-plans");
+  auto p_n = p_g->add_node();
+  p_n->set_op_type("ExecutionPlans");
+  auto attr = p_n->add_attribute();
+  attr->set_name("plans");
+  attr->set_type(onnx::aGRAPHS);
+  for (auto & plan : plans) {
+    encodeGraph(attr->add_graphs(), plan, {}, &ctx);
+  }
+
+  size_t out_size;
+  pb_get_encoded_size(&out_size, onnx_ModelProto_fields, &model_proto.proto);
+  std::string out(out_size, '\0');
+  pb_ostream_t ostream = pb_ostream_from_buffer(reinterpret_cast<pb_byte_t *>(&out[0]), out_size);
+  pb_encode(&ostream, onnx_ModelProto_fields, &model_proto.proto);
+  return out;
+}
+
 }}
@@ -3,6 +3,8 @@
 #include "torch/csrc/jit/ir.h"
 #include "torch/csrc/onnx/onnx.h"
 
+#include <ostream>
+
 namespace torch { namespace jit {
 
 // This map is used to keep track of parameters that should be exported
@@ -23,6 +25,22 @@ std::tuple<std::string, RawDataExportMap> ExportGraph(
     ::torch::onnx::OperatorExportTypes operator_export_type
       = ::torch::onnx::OperatorExportTypes::ONNX);
 
+// Like ExportGraph, but streams the ModelProto to `out` instead of building it
+// in memory.
+RawDataExportMap ExportGraph(
+    const std::shared_ptr<Graph>& graph,
+    const std::vector<at::Tensor>& initializers,
+    int64_t onnx_opset_version,
+    bool defer_weight_export,
+    ::torch::onnx::OperatorExportTypes operator_export_type,
+    std::ostream& out);
+
+// Writes every entry of the export map to a file of its name in `directory`,
+// straight from the memory of the tensor.
+void ExportRawData(
+    const RawDataExportMap& raw_data_export_map,
+    const std::string& directory);
+
 // For testing purposes
 std::string PrettyPrintExportedGraph(
     const std::shared_ptr<Graph>& graph,
@@ -32,4 +50,11 @@ std::string PrettyPrintExportedGraph(
     ::torch::onnx::OperatorExportTypes operator_export_type
       = ::torch::onnx::OperatorExportTypes::ONNX);
 
+// Serializes graphs specialized and optimized by a GraphExecutor (see
+// GraphExecutor::exportPlans) in the raw IR format. Unlike ExportGraph it
+// also records the complete type of every value, including strides and
+// devices, since fusion groups and memory plans depend on them.
+// ImportExecutionPlans reads the result back.
+std::string ExportExecutionPlans(const std::vector<std::shared_ptr<Graph>>& plans);
+
 }}
@@ -20,8 +20,11 @@
 #include <vector>
 #include <sstream>
 #include <iostream>
+#include <fstream>
+#include <cerrno>
 #include <dlfcn.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 namespace torch { namespace jit {
 
@@ -103,17 +106,27 @@ auto cpu_compilation_unit_template = CodeTemplate(R"(
 #include <math.h>
 ${type_declarations}
 
-#define OMP_THRESHOLD 100000
+// Like at::parallel_for, work is split into GRAIN_SIZE chunks so small
+// kernels stay on the calling thread and each thread gets a contiguous,
+// vectorizable range rather than an interleaved set of elements.
+#define GRAIN_SIZE 32768
 static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
-  #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
-  for (IndexType linearIndex = 0;
-        linearIndex < totalElements;
-        linearIndex += 1) {
-      // Convert `linearIndex` into an offset of tensor:
-      ${tensorOffsets}
-      // calculate the results
-      ${kernelBody}
-    }
+  IndexType numChunks = totalElements / GRAIN_SIZE + (totalElements % GRAIN_SIZE != 0);
+  #pragma omp parallel for schedule(static) if(numChunks > 1)
+  for (IndexType chunk = 0; chunk < numChunks; chunk += 1) {
+    IndexType begin = chunk * GRAIN_SIZE;
+    IndexType end = totalElements - begin > GRAIN_SIZE ? begin + GRAIN_SIZE : totalElements;
+    ${chunkPrologue}
+    ${loopPragma}
+    for (IndexType linearIndex = begin;
+          linearIndex < end;
+          linearIndex += 1) {
+        // Convert `linearIndex` into an offset of tensor:
+        ${tensorOffsets}
+        // calculate the results
+        ${kernelBody}
+      }
+  }
 }
 
 extern "C"
@@ -122,6 +135,65 @@ void ${kernelName}(IndexType totalElements, void ** args) {
 }
 )");
 
+// Fusion groups ending in reductions over the last dimension of the map
+// (see ReductionDesc) iterate over rows: each row is traversed once,
+// pointwise outputs are written on the way and the reductions are
+// accumulated in registers, then written once per row.
+auto cuda_reduction_compilation_unit_template = CodeTemplate(R"(
+${type_declarations}
+
+extern "C" __global__
+void ${kernelName}(IndexType totalRows, IndexType rowSize, ${formals}) {
+  for (IndexType row = blockIdx.x * blockDim.x + threadIdx.x;
+        row < totalRows;
+        row += gridDim.x * blockDim.x) {
+      ${reductionPrologue}
+      for (IndexType column = 0; column < rowSize; column += 1) {
+        IndexType linearIndex = row * rowSize + column;
+        // Convert `linearIndex` into an offset of tensor:
+        ${tensorOffsets}
+        // calculate the results
+        ${kernelBody}
+      }
+      // Convert `row` into an offset of the reduced tensors:
+      ${reductionOffsets}
+      ${reductionEpilogue}
+    }
+}
+)");
+
+auto cpu_reduction_compilation_unit_template = CodeTemplate(R"(
+#include <cstddef>
+#include <cstdint>
+#include <math.h>
+${type_declarations}
+
+#define GRAIN_SIZE 32768
+static void ${kernelName}_kernel(IndexType totalRows, IndexType rowSize, ${formals}) {
+  #pragma omp parallel for schedule(static) if(totalRows * rowSize > GRAIN_SIZE)
+  for (IndexType row = 0; row < totalRows; row += 1) {
+    ${chunkPrologue}
+    ${reductionPrologue}
+    ${loopPragma}
+    for (IndexType column = 0; column < rowSize; column += 1) {
+        IndexType linearIndex = row * rowSize + column;
+        // Convert `linearIndex` into an offset of tensor:
+        ${tensorOffsets}
+        // calculate the results
+        ${kernelBody}
+      }
+    // Convert `row` into an offset of the reduced tensors:
+    ${reductionOffsets}
+    ${reductionEpilogue}
+  }
+}
+
+extern "C"
+void ${kernelName}(IndexType totalRows, void ** args) {
+  ${kernelName}_kernel(totalRows, *static_cast<IndexType*>(args[1]) ${,argument_loads});
+}
+)");
+
 // This snippet enables half support in the jit. Following the pattern for
 // reductions, fp16 input data is immediately upconverted to float
 // with __half2float(). All mathematical operations are done on float
@@ -169,11 +241,13 @@ size_t ${tensor}_dimIndex${d} = ${tensor}_linearIndex ${mod_sizes};
 ${tensor}_offset += ${tensor}_dimIndex${d} ${times_stride};
 )");
 
-void emitIndexingFor(std::ostream & out, const std::string & tensor, int ndim, bool last_is_cont) {
+void emitIndexingFor(std::ostream & out, const std::string & tensor, int ndim, bool last_is_cont,
+                     const std::string & index = "linearIndex") {
   TemplateEnv env;
   env.s("tensor",tensor);
+  env.s("index",index);
   out << format("IndexType ${tensor}_offset = 0;\n",env);
-  out << format("IndexType ${tensor}_linearIndex = linearIndex;\n",env);
+  out << format("IndexType ${tensor}_linearIndex = ${index};\n",env);
   for(int d = ndim - 1; d >= 0; --d) {
     env.d("d",d);
     env.s("mod_sizes", d > 0 ? format("% ${tensor}.sizes[${d}]",env) : "");
@@ -186,6 +260,12 @@ void emitIndexingFor(std::ostream & out, const std::string & tensor, int ndim, b
   }
 }
 
+// reductions over the last dimension of the map, which the graph fuser only
+// places at the outputs of a fusion group
+bool isReduction(Node * n) {
+  return n->kind() == aten::sum || n->kind() == aten::mean;
+}
+
 std::string valueName(Value * n) {
   return "n" + std::to_string(n->unique());
 }
@@ -323,20 +403,41 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
   // TODO: handle cases where we need to generate > 2^32 element tensors
   env.s("IndexType","unsigned int"); //avoiding slow header includes to get uint32_t
 
+  bool has_reduction = false;
+  for(auto o : subgraph.outputs())
+    has_reduction = has_reduction || isReduction(o->node());
+
   std::stringstream body;
   std::stringstream tensorOffsets;
+  std::stringstream chunkPrologue;
+  std::stringstream reductionPrologue;
+  std::stringstream reductionOffsets;
+  std::stringstream reductionEpilogue;
   std::vector<std::string> formals;
   std::vector<std::string> argument_loads;
+  std::vector<std::string> accumulators;
+  // true if every tensor compresses to a single dimension with stride 1,
+  // in which case the CPU kernel indexes all of them with linearIndex directly
+  bool all_contiguous = true;
   auto emitFormal = [&](Value * n, const TensorDesc & desc) {
     std::string tensor = "t" + std::to_string(formals.size()); //can't be unique() because Param may be an output
     size_t nDim = desc.nDim();
-    emitIndexingFor(tensorOffsets, tensor, nDim,  desc.lastIsContiguous());
+    // reduced outputs have one element per row of the map
+    if(isReduction(n->node()))
+      emitIndexingFor(reductionOffsets, tensor, nDim, desc.lastIsContiguous(), "row");
+    else
+      emitIndexingFor(tensorOffsets, tensor, nDim,  desc.lastIsContiguous());
+    all_contiguous = all_contiguous && nDim == 1 && desc.lastIsContiguous();
     env.s("tensor",tensor);
-    env.d("formal_index", formals.size() + 1); // + 1 because the first argument is the linearIndex
+    // + 1 because the first argument is the linearIndex, and reduction
+    // kernels also take the row size
+    env.d("formal_index", formals.size() + (has_reduction ? 2 : 1));
     env.d("nDim",nDim);
     env.s("scalar_type",scalarTypeName(desc.scalar_type));
     formals.push_back(format("TensorInfo<${scalar_type},${nDim}> ${tensor}",env));
     argument_loads.push_back(format("*static_cast<TensorInfo<${scalar_type},${nDim}>*>(args[${formal_index}])",env));
+    // fused outputs never alias each other or the inputs
+    chunkPrologue << format("${scalar_type} * __restrict__ ${tensor}_data = ${tensor}.data;\n",env);
   };
   {
     size_t i = 0;
@@ -365,6 +466,17 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
     }
   }
 
+  // Contiguous fast path for the CPU: plain restrict pointers indexed by the
+  // loop counter, which the host compiler can vectorize. CUDA kernels keep
+  // the offset computation, which is cheap next to the memory accesses.
+  bool contiguous_fast_path = !use_cuda && all_contiguous;
+  auto tensorAccess = [&](const std::string & index) {
+    env.s("index", index);
+    return contiguous_fast_path ?
+      format("t${formal}_data[${index}]", env) :
+      format("t${formal}.data[t${formal}_offset]", env);
+  };
+
   bool has_half_tensor = false;
   size_t formal_count = 0;
   for(auto p : subgraph.inputs()) {
@@ -379,7 +491,7 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
       , format("__half2float(t${formal}.data[t${formal}_offset])", env));
       has_half_tensor = true;
     } else {
-      env.s("access", format("t${formal}.data[t${formal}_offset]", env));
+      env.s("access", tensorAccess("linearIndex"));
     }
     
     //TODO: actual type propagation rather than relying on auto..
@@ -390,22 +502,36 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
     if(n->kind() == aten::cat)
       continue; // Concat nodes by narrowing the output Tensors before the kernel runs
     env.s("node",valueName(n->output()));
+    if(isReduction(n)) {
+      // accumulated in float, whatever the type of the input
+      env.s("input",valueName(n->input()));
+      reductionPrologue << format("float ${node} = 0;\n",env);
+      body << format("${node} += ${input};\n",env);
+      accumulators.push_back(valueName(n->output()));
+      continue;
+    }
     env.s("rhs", encodeRHS(n));
     body << format("auto ${node} = ${rhs};\n",env);
   }
 
   for(auto o : flat_output_nodes) {
+    bool reduced = isReduction(o->node());
     env.d("formal",formal_count++);
-    env.s("access",format("t${formal}.data[t${formal}_offset]",env));
-    env.s("node",valueName(o));
+    env.s("access",tensorAccess(reduced ? "row" : "linearIndex"));
+    if(reduced && o->node()->kind() == aten::mean) {
+      env.s("node","(" + valueName(o) + " / rowSize)");
+    } else {
+      env.s("node",valueName(o));
+    }
 
     // Acquires and converts (if needed) outputs
+    std::ostream & store = reduced ? reductionEpilogue : body;
     auto ot = o->type()->cast<TensorType>();
     if (use_cuda && ot && ot->scalarType() == at::ScalarType::Half) {
-      body << format("${access} = __float2half(${node});\n",env);
+      store << format("${access} = __float2half(${node});\n",env);
       has_half_tensor = true;
     } else {
-      body << format("${access} = ${node};\n",env);
+      store << format("${access} = ${node};\n",env);
     }
   }
 
@@ -416,12 +542,31 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
     env.s("HalfHeader", "");
   }
 
-  env.s("tensorOffsets",tensorOffsets.str());
+  if(contiguous_fast_path) {
+    env.s("tensorOffsets", "");
+    env.s("reductionOffsets", "");
+    env.s("chunkPrologue", chunkPrologue.str());
+    if(accumulators.empty()) {
+      env.s("loopPragma", "#pragma omp simd");
+    } else {
+      env.v("accumulators", accumulators);
+      env.s("loopPragma", format("#pragma omp simd reduction(+:${accumulators})", env));
+    }
+  } else {
+    env.s("tensorOffsets",tensorOffsets.str());
+    env.s("reductionOffsets",reductionOffsets.str());
+    env.s("chunkPrologue", "");
+    env.s("loopPragma", "");
+  }
+  env.s("reductionPrologue",reductionPrologue.str());
+  env.s("reductionEpilogue",reductionEpilogue.str());
   env.s("kernelBody",body.str());
   env.v("formals",formals);
   env.v("argument_loads",argument_loads);
   env.s("type_declarations", type_declarations_template.format(env));
-  if(use_cuda) {
+  if(has_reduction) {
+    out << (use_cuda ? cuda_reduction_compilation_unit_template : cpu_reduction_compilation_unit_template).format(env);
+  } else if(use_cuda) {
     out << cuda_compilation_unit_template.format(env);
   } else {
     out << cpu_compilation_unit_template.format(env);
@@ -450,7 +595,16 @@ struct TensorInfo {
 CompiledFusionFunction::CompiledFusionFunction(const std::string & name, AnnotatedGraph & agraph)
   : name(name)
   , input_desc(agraph.input_desc)
-  , output_desc(agraph.output_desc) {}
+  , output_desc(agraph.output_desc) {
+  for(auto o : agraph.graph->outputs()) {
+    if(codegen::isReduction(o->node())) {
+      reduction_desc.emplace_back(o->node()->i(attr::keepdim) != 0);
+      has_reduction = true;
+    } else {
+      reduction_desc.emplace_back();
+    }
+  }
+}
 
 namespace {
 
@@ -510,19 +664,36 @@ void CompiledFusionFunction::launch_with_tensors(at::ArrayRef<at::Tensor> inputs
   for(auto & c : concat_desc)
     flat_outputs_size += c.nSubtensors;
   // XXX: this code assumes that inputs are 32-bit addressable
-  // XXX: this code assumes that all inputs are of the same size
   JIT_ASSERT(inputs[0].numel() <= std::numeric_limits<uint32_t>::max());
   uint32_t numel = inputs[0].numel();
   at::IntList map_size = inputs[0].sizes();
+  // kernels with reduction outputs run one iteration per row of the map
+  JIT_ASSERT(!has_reduction || map_size.size() > 0);
+  uint32_t row_size = has_reduction ? map_size.back() : 1;
+  uint32_t num_rows = 1;
+  std::vector<int64_t> reduced_size;
+  if(has_reduction) {
+    reduced_size.assign(map_size.begin(), map_size.end() - 1);
+    for(auto s : reduced_size)
+      num_rows *= s;
+  }
+  // the kernel indexes every input with the same sizes. Graphs specialized
+  // with dynamic sizes can't guarantee that statically, so check it here.
+  for(auto & i : inputs) {
+    if(!i.sizes().equals(map_size)) {
+      throw std::runtime_error("fused kernel inputs must all have the same sizes");
+    }
+  }
   // Compute the storage needed to store TensorInfo structs for inputs and outputs.
   size_t uncompressedDim = input_desc.at(0).contiguity.size();
   size_t maxPossibleTensorInfoSize = sizeof(TensorInfo) + 2 * sizeof(uint32_t) * uncompressedDim;
   size_t maxPossibleBufferSize = maxPossibleTensorInfoSize * (inputs.size() + flat_outputs_size);
   std::vector<char> buffer(maxPossibleBufferSize);
   char * buffer_next = buffer.data();
-  // A vector of arguments to the kernel. It's (numel, *input_descs, *output_descs)
+  // A vector of arguments to the kernel. It's (numel, *input_descs, *output_descs),
+  // or (num_rows, row_size, *input_descs, *output_descs) with reductions
   std::vector<void*> arguments;
-  arguments.reserve(1 + inputs.size() + flat_outputs_size);
+  arguments.reserve(2 + inputs.size() + flat_outputs_size);
   // Asserts that t's dims can be compressed in the same way as in desc
   // (that's what the kernel assumes), and appends it to the arguments vector.
   auto addTensorInfo = [&](TensorDesc & desc, const at::Tensor & t) {
@@ -534,13 +705,27 @@ void CompiledFusionFunction::launch_with_tensors(at::ArrayRef<at::Tensor> inputs
     buffer_next += maxPossibleTensorInfoSize;
     arguments.push_back(ti);
   };
-  arguments.push_back(&numel);
+  if(has_reduction) {
+    arguments.push_back(&num_rows);
+    arguments.push_back(&row_size);
+  } else {
+    arguments.push_back(&numel);
+  }
   for (size_t i = 0; i < input_desc.size(); ++i)
     addTensorInfo(input_desc[i], inputs[i]);
   for (size_t i = 0; i < output_desc.size(); ++i) {
     auto & c = concat_desc[i];
     at::Tensor o = outputs[i];
-    if(c.nSubtensors == 1) {
+    if(reduction_desc[i].is_reduction) {
+      if(reduction_desc[i].keepdim) {
+        std::vector<int64_t> keepdim_size(reduced_size);
+        keepdim_size.push_back(1);
+        o.resize_(keepdim_size);
+      } else {
+        o.resize_(reduced_size);
+      }
+      addTensorInfo(output_desc[i], outputs[i]);
+    } else if(c.nSubtensors == 1) {
       o.resize_(map_size);
       addTensorInfo(output_desc[i], outputs[i]);
     } else {
@@ -559,7 +744,7 @@ void CompiledFusionFunction::launch_with_tensors(at::ArrayRef<at::Tensor> inputs
       }
     }
   }
-  launch_raw(numel, arguments.data());
+  launch_raw(has_reduction ? num_rows : numel, arguments.data());
 }
 
 void CompiledFusionFunction::launch(at::ArrayRef<at::Tensor> inputs, std::vector<at::Tensor> & outputs) {
@@ -572,6 +757,140 @@ void CompiledFusionFunction::launch(at::ArrayRef<at::Tensor> inputs, std::vector
   launch_with_tensors(inputs, outputs);
 }
 
+// On-disk kernel cache. Entries are content addressed: the key is the full
+// text that determines the compiled artifact (kernel source, tensor
+// descriptors, target architecture and compiler version). An entry is a
+// file <hash(key)>.key whose first line names the artifact and whose
+// remainder is the key itself; artifacts are named after the hash of their
+// own contents and never change once written. A lookup only hits when the
+// stored key matches exactly, so hash collisions cost a recompile, never a
+// wrong kernel. Files are written to a temporary name and rename()d into
+// place, which keeps the directory safe to share between concurrent
+// processes: a reader sees either no entry or a complete one.
+namespace {
+
+uint64_t fnv1a(const std::string & str) {
+  uint64_t h = 14695981039346656037ULL;
+  for(unsigned char c : str) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+std::string hexDigest(const std::string & str) {
+  std::ostringstream out;
+  out << std::hex;
+  out.width(16);
+  out.fill('0');
+  out << fnv1a(str);
+  return out.str();
+}
+
+// mkdir -p; returns false if the directory could not be created
+bool makeDirectories(const std::string & path) {
+  for(size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+    std::string prefix = path.substr(0, pos);
+    if(mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST)
+      return false;
+    if(pos == std::string::npos)
+      return true;
+  }
+}
+
+bool readFile(const std::string & path, std::string & contents) {
+  std::ifstream in(path, std::ios::binary);
+  if(!in)
+    return false;
+  std::ostringstream ss;
+  ss << in.rdbuf();
+  contents = ss.str();
+  return !in.bad();
+}
+
+// writes contents to a temporary file next to path and renames it over path
+bool writeFileAtomic(const std::string & path, const std::string & contents) {
+  std::vector<char> tmp(path.c_str(), path.c_str() + path.size() + 1);
+  tmp.insert(tmp.end() - 1, {'.', 't', 'm', 'p', 'X', 'X', 'X', 'X', 'X', 'X'});
+  int fd = mkstemp(tmp.data());
+  if(fd == -1)
+    return false;
+  const char * data = contents.data();
+  size_t remaining = contents.size();
+  while(remaining > 0) {
+    ssize_t written = ::write(fd, data, remaining);
+    if(written < 0) {
+      if(errno == EINTR)
+        continue;
+      break;
+    }
+    data += written;
+    remaining -= written;
+  }
+  bool ok = remaining == 0 && fchmod(fd, 0644) == 0;
+  ok = (close(fd) == 0) && ok;
+  ok = ok && rename(tmp.data(), path.c_str()) == 0;
+  if(!ok)
+    unlink(tmp.data());
+  return ok;
+}
+
+void disableKernelCache(FusionCompilerConfig & config, const char * what) {
+  std::cerr << "warning: pytorch jit fuser could not " << what << " the kernel cache in "
+            << config.cache_dir << ", continuing without it...\n";
+  config.cache_dir = ""; // disable for future compiles
+}
+
+// Returns true and sets path to the cached artifact for key, if there is one.
+bool lookupCachedKernel(FusionCompilerConfig & config, const std::string & key,
+                        std::string & path) {
+  if(config.cache_dir.empty())
+    return false;
+  std::string entry;
+  if(!readFile(config.cache_dir + "/" + hexDigest(key) + ".key", entry))
+    return false;
+  size_t newline = entry.find('\n');
+  if(newline == std::string::npos || entry.compare(newline + 1, std::string::npos, key) != 0)
+    return false;
+  path = config.cache_dir + "/" + entry.substr(0, newline);
+  return access(path.c_str(), R_OK) == 0;
+}
+
+#ifdef USE_CUDA
+bool readCachedKernel(FusionCompilerConfig & config, const std::string & key,
+                      std::string & contents) {
+  std::string path;
+  return lookupCachedKernel(config, key, path) && readFile(path, contents);
+}
+#endif
+
+void writeCachedKernel(FusionCompilerConfig & config, const std::string & key,
+                       const std::string & suffix, const std::string & contents) {
+  if(config.cache_dir.empty())
+    return;
+  if(!makeDirectories(config.cache_dir))
+    return disableKernelCache(config, "create");
+  std::string artifact = hexDigest(contents) + suffix;
+  // the artifact goes first so that a visible .key always has its artifact
+  if(!writeFileAtomic(config.cache_dir + "/" + artifact, contents) ||
+     !writeFileAtomic(config.cache_dir + "/" + hexDigest(key) + ".key", artifact + "\n" + key))
+    return disableKernelCache(config, "write to");
+}
+
+std::string kernelCacheKey(const std::string & target, const std::string & compilation_unit,
+                           AnnotatedGraph & agraph) {
+  std::stringstream key;
+  key << target << "\n";
+  for(auto & i : agraph.input_desc)
+    key << i << "\n";
+  for(auto & o : agraph.output_desc)
+    key << o << "\n";
+  key << compilation_unit;
+  return key.str();
+}
+
+} // anonymous namespace
+
 #ifdef USE_CUDA
 
 void checkCUDAVersion(const cudaDeviceProp & prop) {
@@ -586,7 +905,7 @@ void checkCUDAVersion(const cudaDeviceProp & prop) {
 }
 
 struct CUDAFusionFunction : public CompiledFusionFunction {
-  CUDAFusionFunction(const std::string & name, AnnotatedGraph & agraph)
+  CUDAFusionFunction(const std::string & name, AnnotatedGraph & agraph, FusionCompilerConfig & config)
   : CompiledFusionFunction(name, agraph) {
     at::DeviceGuard device_guard(agraph.device);
 
@@ -596,11 +915,40 @@ struct CUDAFusionFunction : public CompiledFusionFunction {
     std::stringstream cu;
     concat_desc = codegen::emitCompilationUnit(cu, name, agraph, true);
     compilation_unit = cu.str();
-    nvrtcProgram program;
-    TORCH_NVRTC_CHECK(nvrtcCreateProgram(&program, compilation_unit.c_str(), NULL, 0, nullptr, nullptr));
 
     std::string compute = "--gpu-architecture=compute_" + std::to_string(prop.major) + std::to_string(prop.minor);
     std::vector<const char *> args = {"--std=c++11", compute.c_str()};
+
+    int nvrtc_major, nvrtc_minor;
+    TORCH_NVRTC_CHECK(nvrtcVersion(&nvrtc_major, &nvrtc_minor));
+    std::string cache_key = kernelCacheKey(
+      "nvrtc " + std::to_string(nvrtc_major) + "." + std::to_string(nvrtc_minor) +
+      " cuda " + std::to_string(CUDA_VERSION) + " " + compute,
+      compilation_unit, agraph);
+    std::string cached_ptx;
+    if(readCachedKernel(config, cache_key, cached_ptx)) {
+      ptx.assign(cached_ptx.begin(), cached_ptx.end());
+    } else {
+      compileToPTX(args, cu);
+      writeCachedKernel(config, cache_key, ".ptx", std::string(ptx.begin(), ptx.end()));
+    }
+
+    TORCH_CU_CHECK(cuModuleLoadData(&module, ptx.data()));
+    TORCH_CU_CHECK(cuModuleGetFunction(&function, module, name.c_str()));
+
+    TORCH_CU_CHECK(cuOccupancyMaxActiveBlocksPerMultiprocessor(
+      &maxBlocks, function, 128, 0));
+    maxBlocks *= prop.multiProcessorCount;
+  }
+  virtual ~CUDAFusionFunction() override {
+    TORCH_CU_CHECK(cuModuleUnload(module));
+  }
+protected:
+  // runs nvrtc on compilation_unit, filling in ptx.
+  // cu holds the source and gets the compiler log appended on failure.
+  void compileToPTX(const std::vector<const char *> & args, std::stringstream & cu) {
+    nvrtcProgram program;
+    TORCH_NVRTC_CHECK(nvrtcCreateProgram(&program, compilation_unit.c_str(), NULL, 0, nullptr, nullptr));
     nvrtcResult result = nvrtcCompileProgram(program, args.size(), args.data());
     if (result == NVRTC_ERROR_COMPILATION) {
       size_t logsize;
@@ -619,18 +967,8 @@ struct CUDAFusionFunction : public CompiledFusionFunction {
     TORCH_NVRTC_CHECK(nvrtcGetPTXSize(program, &ptx_size));
     ptx.resize(ptx_size);
     TORCH_NVRTC_CHECK(nvrtcGetPTX(program, ptx.data()));
-
-    TORCH_CU_CHECK(cuModuleLoadData(&module, ptx.data()));
-    TORCH_CU_CHECK(cuModuleGetFunction(&function, module, name.c_str()));
-
-    TORCH_CU_CHECK(cuOccupancyMaxActiveBlocksPerMultiprocessor(
-      &maxBlocks, function, 128, 0));
-    maxBlocks *= prop.multiProcessorCount;
-  }
-  virtual ~CUDAFusionFunction() override {
-    TORCH_CU_CHECK(cuModuleUnload(module));
   }
-protected:
+
   virtual at::Backend backend() const override {
     return at::kCUDA;
   }
@@ -747,12 +1085,14 @@ static const std::string cpp_template = "/tmp/pytorch_fuserXXXXXX.cpp";
 // actually supports it or not, so we heuristically use the host
 // compiler to predict if the runtime compiler supports the option we
 // want.  This probably won't work if you're cross-compiling.
+// -fno-math-errno lets calls like sqrt be inlined inside vectorized loops;
+// the generated kernels never look at errno.
 static const std::string compile_string =
   "\"${cxx}\" -O3 -g "
 #ifndef __PPC64__
   "-march=native "
 #endif
-  "-std=c++11 -fPIC ${fopenmp} -shared \"${cpp_file}\" -o \"${so_file}\" -lm";
+  "-std=c++11 -fPIC -fno-math-errno ${fopenmp} -shared \"${cpp_file}\" -o \"${so_file}\" -lm";
 
 static void runCompiler(FusionCompilerConfig & config, const std::string & cpp_file, const std::string & so_file) {
   TemplateEnv env;
@@ -771,6 +1111,42 @@ static void runCompiler(FusionCompilerConfig & config, const std::string & cpp_f
 }
 
 
+static const std::string version_string =
+  "\"${cxx}\" --version 2>/dev/null";
+
+// Everything about the host compiler and machine that changes the .so we
+// build from a given source: compiler version, flags, and (because of
+// -march=native) the CPU model and its feature flags.
+static std::string cpuCompilerDescription(FusionCompilerConfig & config) {
+  if(config.cxx_description.empty()) {
+    std::stringstream desc;
+    TemplateEnv env;
+    env.s("cxx", config.cxx);
+    std::string cmd = format(version_string, env);
+    if(FILE * pipe = popen(cmd.c_str(), "r")) {
+      char buf[256];
+      size_t n;
+      while((n = fread(buf, 1, sizeof(buf), pipe)) > 0)
+        desc.write(buf, n);
+      pclose(pipe);
+    }
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    bool seen_model = false, seen_flags = false;
+    while(std::getline(cpuinfo, line) && !(seen_model && seen_flags)) {
+      if(!seen_model && line.compare(0, 10, "model name") == 0) {
+        desc << line << "\n";
+        seen_model = true;
+      } else if(!seen_flags && line.compare(0, 5, "flags") == 0) {
+        desc << line << "\n";
+        seen_flags = true;
+      }
+    }
+    config.cxx_description = desc.str();
+  }
+  return "cpu " + compile_string + (config.openmp ? " openmp\n" : "\n") + config.cxx_description;
+}
+
 static const std::string disas_string =
   "objdump -M  intel -d \"${so_file}\"";
 static void disas(const std::string & so_file) {
@@ -784,19 +1160,36 @@ static void disas(const std::string & so_file) {
 struct CPUFusionFunction : public CompiledFusionFunction {
   CPUFusionFunction(const std::string & name, AnnotatedGraph & agraph, FusionCompilerConfig & config)
   : CompiledFusionFunction(name, agraph) {
-    TempFile so_file(so_template, 3);
-    TempFile cpp_file(cpp_template, 4);
-
     std::stringstream cu;
     concat_desc = codegen::emitCompilationUnit(cu, name, agraph, false);
     compilation_unit = cu.str();
-    cpp_file.write(compilation_unit);
-    cpp_file.sync();
-    runCompiler(config, cpp_file.name(), so_file.name());
-    if(config.debug) {
-      disas(so_file.name());
+
+    std::string cached_path;
+    std::string cache_key;
+    if(!config.cache_dir.empty()) {
+      cache_key = kernelCacheKey(cpuCompilerDescription(config), compilation_unit, agraph);
+    }
+    if(!cache_key.empty() && lookupCachedKernel(config, cache_key, cached_path)) {
+      so_lib.reset(new DynamicLibrary(cached_path.c_str()));
+    } else {
+      TempFile so_file(so_template, 3);
+      TempFile cpp_file(cpp_template, 4);
+      cpp_file.write(compilation_unit);
+      cpp_file.sync();
+      runCompiler(config, cpp_file.name(), so_file.name());
+      if(config.debug) {
+        disas(so_file.name());
+      }
+      // runCompiler may have turned off openmp, which changes the key
+      if(!cache_key.empty()) {
+        std::string so_contents;
+        if(readFile(so_file.name(), so_contents)) {
+          cache_key = kernelCacheKey(cpuCompilerDescription(config), compilation_unit, agraph);
+          writeCachedKernel(config, cache_key, ".so", so_contents);
+        }
+      }
+      so_lib.reset(new DynamicLibrary(so_file.name().c_str()));
     }
-    so_lib.reset(new DynamicLibrary(so_file.name().c_str()));
 #pragma GCC diagnostic ignored "-Wpedantic"
     kernel = reinterpret_cast<void(*)(uint32_t, void**)>(so_lib->sym(name.c_str()));
 #pragma GCC diagnostic pop
@@ -824,11 +1217,14 @@ std::shared_ptr<CompiledFusionFunction> FusionCompiler::getOrCompile(AnnotatedGr
 
   auto it = cache.find(key_);
   if (it == cache.end()) {
-    std::string name = "kernel_" + std::to_string(cache.size());
+    // Named after its contents rather than the order of compilation so that
+    // the same fusion group generates the same source in every process,
+    // which is what lets the on-disk cache hit across restarts.
+    std::string name = "kernel_" + hexDigest(key_);
     CompiledFusionFunction * raw_func;
     if(agraph.device != kCPUDevice) {
 #ifdef USE_CUDA
-      raw_func = new CUDAFusionFunction(name, agraph);
+      raw_func = new CUDAFusionFunction(name, agraph, config_);
 #else
       throw std::runtime_error("cannot compile a CUDA fusion group, CUDA is not enabled.");
 #endif
@@ -895,6 +1291,20 @@ FusionCompiler::FusionCompiler() {
   }
   const char * debug_env = getenv("PYTORCH_FUSION_DEBUG");
   config_.debug = debug_env && atoi(debug_env) != 0;
+  // PYTORCH_FUSION_CACHE_DIR overrides the location of the on-disk kernel
+  // cache, $TORCH_HOME/fuser_cache; setting it to the empty string disables it.
+  const char * cache_env = getenv("PYTORCH_FUSION_CACHE_DIR");
+  if(cache_env != nullptr) {
+    config_.cache_dir = cache_env;
+  } else {
+    const char * torch_home = getenv("TORCH_HOME");
+    const char * home = getenv("HOME");
+    if(torch_home != nullptr) {
+      config_.cache_dir = std::string(torch_home) + "/fuser_cache";
+    } else if(home != nullptr) {
+      config_.cache_dir = std::string(home) + "/.torch/fuser_cache";
+    }
+  }
 }
 
 //TODO: thread safety
@@ -78,6 +78,18 @@ struct ConcatDesc {
   }
 };
 
+// Outputs can also reduce the last dimension of the map (aten::sum or
+// aten::mean), e.g. the statistics of a layer norm or a softmax. They hold
+// one element per row and are written once the row has been accumulated.
+struct ReductionDesc {
+  bool is_reduction;
+  bool keepdim;
+  ReductionDesc()
+  : is_reduction(false), keepdim(false) {}
+  explicit ReductionDesc(bool keepdim)
+  : is_reduction(true), keepdim(keepdim) {}
+};
+
 struct CompiledFusionFunction {
   TH_DISALLOW_COPY_AND_ASSIGN(CompiledFusionFunction);
 
@@ -101,7 +113,10 @@ protected:
   // cuLaunchKernel as the kernel arguments.
   // Currently the first argument is a pointer to numel (for passing to
   // CUDA code), and the remainder are pointers to the TensorInfo<T> structs
-  // that compiled code uses to load Tensor data.
+  // that compiled code uses to load Tensor data. Kernels with a reduction
+  // output iterate over rows instead: the first argument is then the number
+  // of rows, followed by a pointer to the row size, and numel passed to
+  // launch_raw is the number of rows.
   // launch_with_tensors handles packing at::Tensors into this arguments array.
   // CPU code uses the same convension so that launch_with_tensors can be shared.
   virtual void launch_raw(uint32_t numel, void ** arguments) = 0;
@@ -115,12 +130,19 @@ protected:
   // an output is actually a concatenation of
   // many subtensors that the fusion group produces
   std::vector<ConcatDesc> concat_desc;
+
+  // same size as output_desc, describes whether an output
+  // is a reduction over the last dimension of the map
+  std::vector<ReductionDesc> reduction_desc;
+  bool has_reduction = false;
 };
 
 struct FusionCompilerConfig {
   std::string cxx = "g++"; // compiler location
   bool debug = false; // emit debugging information about fusions
   bool openmp = true;
+  std::string cache_dir; // on-disk kernel cache, disabled if empty
+  std::string cxx_description; // cxx version and host CPU, part of cache keys
 };
 
 // caching compiler
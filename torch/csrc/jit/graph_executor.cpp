@@ -4,10 +4,13 @@
 #include "torch/csrc/jit/argument_spec.h"
 #include "torch/csrc/jit/autodiff.h"
 #include "torch/csrc/jit/interpreter.h"
+#include "torch/csrc/jit/graph_profiler.h"
 #include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/parallel_interpreter.h"
 #include "torch/csrc/jit/tracer.h"
 #include "torch/csrc/jit/passes/batch_mm.h"
 #include "torch/csrc/jit/passes/common_subexpression_elimination.h"
+#include "torch/csrc/jit/passes/constant_propagation.h"
 #include "torch/csrc/jit/passes/create_autodiff_subgraphs.h"
 #include "torch/csrc/jit/passes/dead_code_elimination.h"
 #include "torch/csrc/jit/passes/erase_number_types.h"
@@ -19,6 +22,7 @@
 #include "torch/csrc/jit/passes/decompose_addmm.h"
 #include "torch/csrc/jit/passes/specialize_undef.h"
 #include "torch/csrc/jit/passes/loop_unrolling.h"
+#include "torch/csrc/jit/passes/loop_invariant_code_motion.h"
 #include "torch/csrc/jit/passes/lower_grad_of.h"
 #include "torch/csrc/jit/symbolic_variable.h"
 #include "torch/csrc/jit/ivalue.h"
@@ -27,7 +31,10 @@
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/jit/script/compiler.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -89,28 +96,58 @@ inline variable_tensor_list runOneStage(const Code & code, variable_tensor_list
 // It can optionally also have a gradient which is hooked up
 // to the output Variables if present.
 struct ExecutionPlan {
-  ExecutionPlan(std::shared_ptr<Graph>& graph)
-      : f(graph), graph(graph) {}
+  ExecutionPlan(std::shared_ptr<Graph>& graph, bool plan_memory = false, bool inter_op_parallel = false,
+                bool unwrap_variables = false)
+      : pf(inter_op_parallel ? createParallelCode(graph) : ParallelCode()),
+        unwrapped(unwrap_variables && !pf && canRunUnwrapped(graph->block())),
+        f(graph, plan_memory && !pf, unwrapped),
+        graph(graph) {}
   ExecutionPlan(std::shared_ptr<Graph>& graph, Gradient grad)
       : f(graph),
         graph(graph),
         grad(std::move(grad)),
-        grad_executor(this->grad.df) {}
+        grad_executor(this->grad.df) {
+    // The inputs of df carry the types the forward propagated: the
+    // captured values have them, and the vjps those of the outputs. Compile
+    // df for them now, so that the backward runs specialized and fused from
+    // its first call. Gradients that don't match (undefined, or laid out
+    // differently than the outputs) get their own plan when they show up.
+    auto df_types = fmap(this->grad.df->inputs(), [](Value * v) { return v->type(); });
+    bool complete = std::all_of(df_types.begin(), df_types.end(), [](const TypePtr & t) {
+      return t->kind() == TypeKind::TensorType;
+    });
+    if(complete)
+      grad_executor.compileFor(ArgumentSpec(df_types));
+  }
 
   variable_tensor_list run(variable_tensor_list&& stack) const {
     if(grad) {
       return runWithGrad(std::move(stack));
     }
+    if(unwrapped) {
+      return runUnwrapped(std::move(stack));
+    }
+    if(pf) {
+      std::vector<IValue> ivalues(stack.begin(), stack.end());
+      pf.run(ivalues);
+      return variable_tensor_list(fmap(ivalues, [](IValue& v) {
+        return std::move(v).toTensor();
+      }));
+    }
     return runOneStage(f, std::move(stack));
   }
   std::shared_ptr<Graph> get_graph() const {
     return graph;
   }
+  bool hasGradient() const {
+    return static_cast<bool>(grad);
+  }
 
   ExecutionPlanState getDebugState() {
     ExecutionPlanState state;
     state.f = &f;
     state.graph = graph.get();
+    state.unwrapped = unwrapped;
     if (grad) {
       state.grad = &grad;
       state.grad_executor = std::unique_ptr<GraphExecutorState>(
@@ -123,6 +160,33 @@ struct ExecutionPlan {
   }
 
 private:
+  // whether no node of the graph needs its inputs to be Variables
+  static bool canRunUnwrapped(Block * block) {
+    for(auto n : block->nodes()) {
+      if(n->kind() == prim::PythonOp || n->kind() == prim::GraphExecutor)
+        return false;
+      for(auto b : n->blocks()) {
+        if(!canRunUnwrapped(b))
+          return false;
+      }
+    }
+    return true;
+  }
+  variable_tensor_list runUnwrapped(variable_tensor_list&& inputs) const {
+    std::vector<IValue> stack = fmap(inputs, [](const Variable& v) -> IValue {
+      return v.defined() ? autograd::as_variable_ref(v).data() : at::Tensor();
+    });
+    InterpreterState(f).runOneStage(stack);
+    return variable_tensor_list(fmap(stack, [](IValue& v) -> at::Tensor {
+      auto t = std::move(v).toTensor();
+      return t.defined() ? autograd::make_variable(std::move(t), /*requires_grad=*/false) : t;
+    }));
+  }
+  // only worth it if some nodes can run at the same time
+  static ParallelCode createParallelCode(const std::shared_ptr<Graph>& graph) {
+    ParallelCode pf(graph);
+    return pf.width() > 1 ? pf : ParallelCode();
+  }
   // note: should be inplace to avoid allocations, but we have to switch from
   // a list of tensor to a list of ivalues
   std::vector<IValue> unwrapVariables(variable_tensor_list && list) const {
@@ -187,6 +251,11 @@ private:
     outputs.erase(outputs.begin() + grad.f_real_outputs, outputs.end());
     return outputs;
   }
+  // runs the plan instead of f when inter-op parallelism is enabled and
+  // the graph has independent nodes. f is still built, for debugging.
+  ParallelCode pf;
+  // runs f on tensors rather than Variables, see GraphExecutorOptions
+  bool unwrapped = false;
   Code f;
   // optimized graph for debugging and testing
   std::shared_ptr<Graph> graph;
@@ -205,12 +274,16 @@ private:
 // tracing concerns separated.
 struct GraphExecutorImpl {
 
-  GraphExecutorImpl(std::shared_ptr<Graph> graph, bool optimize, bool symbolically_differentiable)
+  GraphExecutorImpl(std::shared_ptr<Graph> graph, bool optimize, bool symbolically_differentiable,
+                    const GraphExecutorOptions & options)
   : graph(std::move(graph))
   , optimize(optimize)
   , num_inputs(this->graph->inputs().size())
   , symbolically_differentiable(symbolically_differentiable)
-  , may_introduce_gradient(calcMayIntroduceGradient(this->graph->block())) {}
+  , may_introduce_gradient(calcMayIntroduceGradient(this->graph->block()))
+  , options(options) {}
+  GraphExecutorImpl(std::shared_ptr<Graph> graph, bool optimize, bool symbolically_differentiable)
+  : GraphExecutorImpl(graph, optimize, symbolically_differentiable, getDefaultGraphExecutorOptions()) {}
   GraphExecutorImpl(std::shared_ptr<Graph> graph, bool optimize)
   : GraphExecutorImpl(graph, optimize, isDifferentiable(*graph)) {}
 
@@ -238,21 +311,27 @@ struct GraphExecutorImpl {
     // either we can symbolically differentiate, or we do not need a gradient.
     // go down the route where we treat the inputs as tensors
     // and fully optimize
-    auto & implementation = getOrCompile(inputs);
-    return implementation.run(std::move(inputs));
+    // the plan is held by shared_ptr since another thread may evict it
+    // from the cache while it runs
+    std::shared_ptr<ExecutionPlan> implementation;
+    {
+      ProfileExecutorRange range("GraphExecutor::getOrCompile");
+      implementation = getOrCompile(inputs);
+    }
+    return implementation->run(std::move(inputs));
   }
 
   std::shared_ptr<Graph> graphFor(const variable_tensor_list& inputs) const {
-    ArgumentSpec spec(autograd::GradMode::is_enabled(), inputs);
-
     if (!optimize || (!symbolically_differentiable && needsGradient(inputs))) {
       JIT_ASSERTM(autograd_fallback_graph, "No graph found for given inputs");
       return autograd_fallback_graph;
     }
 
+    ArgumentSpec spec = cacheKey(inputs);
+    std::lock_guard<std::mutex> lock(compile_mutex);
     auto it = plan_cache.find(spec);
     JIT_ASSERTM(it != plan_cache.end(), "No graph found for given inputs");
-    return it->second.get_graph();
+    return it->second.plan->get_graph();
   }
 
   GraphExecutorState getDebugState() {
@@ -265,9 +344,11 @@ struct GraphExecutorImpl {
       state.autograd_fallback = nullptr;
       state.autograd_fallback_graph = nullptr;
     }
+    std::lock_guard<std::mutex> lock(compile_mutex);
     for (auto & entry : plan_cache) {
-      state.execution_plans.emplace(entry.first, entry.second.getDebugState());
+      state.execution_plans.emplace(entry.first, entry.second.plan->getDebugState());
     }
+    state.plan_cache_stats = plan_cache_stats;
     return state;
   }
 
@@ -366,18 +447,117 @@ private:
     autograd_fallback = Code(graph_);
     return autograd_fallback;
   }
-  const ExecutionPlan & getOrCompile(const variable_tensor_list & inputs) {
+  // The spec that plans are looked up by. With dynamic_sizes it leaves out
+  // the sizes, unless some input requires grad, because the derivative
+  // graph bakes in the sizes it was built for.
+  ArgumentSpec cacheKey(const variable_tensor_list & inputs) const {
+    bool with_grad = autograd::GradMode::is_enabled();
+    bool with_sizes = !options.dynamic_sizes || (with_grad && needsGradient(inputs));
+    return ArgumentSpec(with_grad, inputs, with_sizes);
+  }
+
+  std::shared_ptr<ExecutionPlan> getOrCompile(const variable_tensor_list & inputs) {
     // outside lock guard, to minimize the time holding the lock on the fast path
     // ArgumentSpec even computes its hashCode here.
-    ArgumentSpec spec(autograd::GradMode::is_enabled(), inputs);
+    ArgumentSpec spec = cacheKey(inputs);
     {
       std::lock_guard<std::mutex> lock(compile_mutex);
       auto it = plan_cache.find(spec);
-      if(it != plan_cache.end())
-        return it->second;
-      auto plan = compileSpec(spec);
-      auto r = plan_cache.emplace(std::move(spec), std::move(plan));
-      return r.first->second;
+      if(it != plan_cache.end()) {
+        plan_cache_stats.hits++;
+        plan_lru.splice(plan_lru.begin(), plan_lru, it->second.lru_position);
+        return it->second.plan;
+      }
+      plan_cache_stats.misses++;
+      ProfileExecutorRange range("GraphExecutor::compile");
+      auto start = std::chrono::steady_clock::now();
+      std::shared_ptr<ExecutionPlan> plan;
+      if(spec.hasSizes()) {
+        plan = std::make_shared<ExecutionPlan>(compileSpec(spec, /*dynamic_sizes=*/false));
+      } else {
+        // compile for the sizes at hand, without relying on them
+        ArgumentSpec full_spec(autograd::GradMode::is_enabled(), inputs);
+        plan = std::make_shared<ExecutionPlan>(compileSpec(full_spec, /*dynamic_sizes=*/true));
+      }
+      plan_cache_stats.compile_ms += std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - start).count();
+      insertPlan(std::move(spec), plan);
+      return plan;
+    }
+  }
+
+  // requires compile_mutex
+  void insertPlan(ArgumentSpec spec, std::shared_ptr<ExecutionPlan> plan) {
+    auto it = plan_cache.find(spec);
+    if(it != plan_cache.end()) {
+      plan_lru.erase(it->second.lru_position);
+      plan_cache.erase(it);
+    }
+    if(options.max_plans > 0 && plan_cache.size() >= options.max_plans) {
+      plan_cache.erase(*plan_lru.back());
+      plan_lru.pop_back();
+      plan_cache_stats.evictions++;
+    }
+    auto r = plan_cache.emplace(std::move(spec), CachedPlan{std::move(plan), {}});
+    plan_lru.push_front(&r.first->first);
+    r.first->second.lru_position = plan_lru.begin();
+  }
+
+  void compileFor(const variable_tensor_list & inputs) {
+    if(!optimize || (!symbolically_differentiable && needsGradient(inputs))) {
+      getOrCreateAutogradFallback();
+      return;
+    }
+    getOrCompile(inputs);
+  }
+
+  void compileFor(const ArgumentSpec & spec) {
+    if(!optimize || options.dynamic_sizes)
+      return;
+    JIT_ASSERT(spec.hasSizes() && !argumentSpecRequiresGradient(spec));
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    if(plan_cache.count(spec) > 0)
+      return;
+    ProfileExecutorRange range("GraphExecutor::compile");
+    auto start = std::chrono::steady_clock::now();
+    auto plan = std::make_shared<ExecutionPlan>(compileSpec(spec, /*dynamic_sizes=*/false));
+    plan_cache_stats.compile_ms += std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+    insertPlan(spec, std::move(plan));
+  }
+
+  std::vector<std::shared_ptr<Graph>> exportPlans() const {
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    std::vector<std::shared_ptr<Graph>> plans;
+    for(auto spec : plan_lru) {
+      auto & plan = plan_cache.at(*spec).plan;
+      // plans of sizeless specs are keyed by more than their graph's
+      // input types say, and plans with gradients hold a derivative graph
+      if(spec->hasSizes() && !plan->hasGradient())
+        plans.push_back(plan->get_graph()->copy());
+    }
+    return plans;
+  }
+
+  void importPlans(const std::vector<std::shared_ptr<Graph>> & plans) {
+    if(options.dynamic_sizes)
+      throw std::runtime_error("plans can't be imported into an executor with dynamic_sizes");
+    // the most recently used plan comes first, so insert it last
+    for(auto it = plans.rbegin(); it != plans.rend(); ++it) {
+      auto graph_ = *it;
+      if(graph_->inputs().size() != num_inputs)
+        throw std::runtime_error("imported plan expects " + std::to_string(graph_->inputs().size()) +
+                                 " inputs, but this graph has " + std::to_string(num_inputs));
+      ArgumentSpec spec(fmap(graph_->inputs(), [](Value * v) { return v->type(); }));
+      // creating the plan compiles its fusion groups
+      auto start = std::chrono::steady_clock::now();
+      auto plan = std::make_shared<ExecutionPlan>(graph_, /*plan_memory=*/options.plan_memory,
+                                                  /*inter_op_parallel=*/options.inter_op_parallel,
+                                                  /*unwrap_variables=*/options.unwrap_variables);
+      std::lock_guard<std::mutex> lock(compile_mutex);
+      plan_cache_stats.compile_ms += std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - start).count();
+      insertPlan(std::move(spec), std::move(plan));
     }
   }
 
@@ -389,16 +569,19 @@ private:
     return false;
   }
 
-  ExecutionPlan compileSpec(const ArgumentSpec & spec) {
+  ExecutionPlan compileSpec(const ArgumentSpec & spec, bool dynamic_sizes) {
     auto graph_ = graph->copy();
 
-    specializeToSpec(graph_, spec);
+    specializeToSpec(graph_, spec, dynamic_sizes);
 
     if(!argumentSpecRequiresGradient(spec)) {
-      runOptimization(graph_, /*graphMustSupportVariables=*/false);
-      return ExecutionPlan(graph_);
+      runOptimization(graph_, /*graphMustSupportVariables=*/false, dynamic_sizes);
+      return ExecutionPlan(graph_, /*plan_memory=*/options.plan_memory && !dynamic_sizes,
+                           /*inter_op_parallel=*/options.inter_op_parallel,
+                           /*unwrap_variables=*/options.unwrap_variables);
     }
     JIT_ASSERT(symbolically_differentiable);
+    JIT_ASSERT(!dynamic_sizes);
 
     std::vector<bool> requires_grads;
     requires_grads.reserve(spec.size());
@@ -439,24 +622,55 @@ private:
   std::shared_ptr<Graph> autograd_fallback_graph;
   Code autograd_fallback;
 
+  const GraphExecutorOptions options;
+
   // optimizable code paths, used when we can differentiate or when no derivative is needed
   // Spec describes input conditions, Plan describes how to execute them.
-  std::unordered_map<ArgumentSpec, ExecutionPlan> plan_cache;
+  // plan_lru orders the keys of plan_cache from most to least recently used,
+  // and is used to evict plans once there are options.max_plans of them.
+  struct CachedPlan {
+    std::shared_ptr<ExecutionPlan> plan;
+    std::list<const ArgumentSpec*>::iterator lru_position;
+  };
+  std::unordered_map<ArgumentSpec, CachedPlan> plan_cache;
+  std::list<const ArgumentSpec*> plan_lru;
+  PlanCacheStats plan_cache_stats;
 
   // GraphExecutor can be accessed from  multiple thread so
   // anytime we are checking or updating the autograd_fallback or
   // plan_cache, we must hold the compile mutex.
   // along the fast path (no compilation) code should
   // hold this for as little time as possible.
-  std::mutex compile_mutex;
+  mutable std::mutex compile_mutex;
 };
 
+namespace {
+
+std::mutex default_options_mutex;
+GraphExecutorOptions default_options;
+
+} // anonymous namespace
+
+GraphExecutorOptions getDefaultGraphExecutorOptions() {
+  std::lock_guard<std::mutex> lock(default_options_mutex);
+  return default_options;
+}
+
+void setDefaultGraphExecutorOptions(const GraphExecutorOptions & options) {
+  std::lock_guard<std::mutex> lock(default_options_mutex);
+  default_options = options;
+}
+
 GraphExecutor::GraphExecutor(std::shared_ptr<Graph> graph, bool optimize)
 : pImpl(new GraphExecutorImpl(std::move(graph), optimize)) {}
 
 GraphExecutor::GraphExecutor(std::shared_ptr<Graph> graph, bool optimize, bool symbolically_differentiable)
 : pImpl(new GraphExecutorImpl(std::move(graph), optimize, symbolically_differentiable)) {}
 
+GraphExecutor::GraphExecutor(std::shared_ptr<Graph> graph, bool optimize, bool symbolically_differentiable,
+                             const GraphExecutorOptions & options)
+: pImpl(new GraphExecutorImpl(std::move(graph), optimize, symbolically_differentiable, options)) {}
+
 variable_tensor_list GraphExecutor::run(variable_tensor_list && inputs) {
   return pImpl->run(std::move(inputs));
 }
@@ -473,6 +687,22 @@ GraphExecutorState GraphExecutor::getDebugState() {
   return pImpl->getDebugState();
 }
 
+void GraphExecutor::compileFor(const variable_tensor_list& inputs) {
+  pImpl->compileFor(inputs);
+}
+
+void GraphExecutor::compileFor(const ArgumentSpec& spec) {
+  pImpl->compileFor(spec);
+}
+
+std::vector<std::shared_ptr<Graph>> GraphExecutor::exportPlans() const {
+  return pImpl->exportPlans();
+}
+
+void GraphExecutor::importPlans(const std::vector<std::shared_ptr<Graph>>& plans) {
+  pImpl->importPlans(plans);
+}
+
 
 void runRequiredPasses(const std::shared_ptr<Graph>& g)  {
   LowerGradOf(*g);
@@ -483,7 +713,7 @@ void runRequiredPasses(const std::shared_ptr<Graph>& g)  {
   RemoveExpands(g);
 }
 
-void specializeToSpec(const std::shared_ptr<Graph>& graph_, const ArgumentSpec& spec) {
+void specializeToSpec(const std::shared_ptr<Graph>& graph_, const ArgumentSpec& spec, bool dynamic_sizes) {
   // clean up GradOf and AutogradAdd nodes
   // this must be first because later passes do not know what GradOfs are
   std::vector<bool> defined;
@@ -504,15 +734,18 @@ void specializeToSpec(const std::shared_ptr<Graph>& graph_, const ArgumentSpec&
   // clean up dead constants from specialization
   EliminateDeadCode(graph_);
   // calculate all input shapes
-  PropagateInputShapes(*graph_, spec);
+  // expands would bake the current sizes into the graph
+  PropagateInputShapes(*graph_, spec, /*insert_expands=*/!dynamic_sizes);
 }
 
-void runOptimization(std::shared_ptr<Graph> & graph, bool graphMustSupportVariables) {
+void runOptimization(std::shared_ptr<Graph> & graph, bool graphMustSupportVariables, bool dynamic_sizes) {
 
   // these optimizations must run in the presence of variables
   // and when shape information is not statically known.
   EliminateDeadCode(graph);
   CheckInplace(graph);
+  ConstantPropagation(graph);
+  LoopInvariantCodeMotion(graph);
   EliminateCommonSubexpression(graph);
 
   if (!graphMustSupportVariables) {
@@ -524,10 +757,16 @@ void runOptimization(std::shared_ptr<Graph> & graph, bool graphMustSupportVariab
 
     //TODO: create peephole optimizations that are safe to run
     // when we are using variables, and when we do not know sizes.
-    PeepholeOptimize(graph);
-    // TODO: remove mandatory size checking in BatchMM, otherwise
-    // it works fine on variables.
-    BatchMM(graph);
+    // Peephole removes expands that are no-ops at the current sizes, and
+    // BatchMM only batches matrices of equal size, so neither is valid
+    // when sizes are dynamic. The fuser only relies on the sizes of its
+    // inputs being equal, which fused kernels check when they launch.
+    if (!dynamic_sizes) {
+      PeepholeOptimize(graph);
+      // TODO: remove mandatory size checking in BatchMM, otherwise
+      // it works fine on variables.
+      BatchMM(graph);
+    }
     FuseGraph(graph);
   }
 }
@@ -17,27 +17,72 @@ struct GraphExecutorState;
 struct ExecutionPlanState {
   Code* f;
   Graph* graph;
+  // whether f runs on tensors rather than Variables
+  bool unwrapped = false;
 
   // Those two fields are optional
   Gradient* grad;
   std::shared_ptr<GraphExecutorState> grad_executor; // shared_ptr to break the cycle...
 };
 
+// Counters for the cache of specialized ExecutionPlans in a GraphExecutor.
+struct PlanCacheStats {
+  size_t hits = 0;
+  size_t misses = 0; // every miss compiles a new plan
+  size_t evictions = 0;
+  double compile_ms = 0; // total time spent compiling plans
+};
+
 struct GraphExecutorState {
   Graph* graph;
   std::unordered_map<ArgumentSpec, ExecutionPlanState> execution_plans;
+  PlanCacheStats plan_cache_stats;
 
   // Those two fields are optional
   Code* autograd_fallback;
   Graph* autograd_fallback_graph;
 };
 
+struct GraphExecutorOptions {
+  // Maximum number of specialized plans kept by an executor. When it is
+  // reached the least recently used plan is evicted. 0 means no limit.
+  size_t max_plans = 64;
+  // Specialize plans only on the rank, contiguity and size-1 dimensions of
+  // the inputs instead of their exact sizes, so inputs of varying sizes
+  // (e.g. sequence lengths) share a plan. Such plans skip size dependent
+  // optimizations, like expanding broadcasts for the fuser. Inputs that
+  // require grad are still specialized on their sizes, since the derivative
+  // graph depends on them.
+  bool dynamic_sizes = false;
+  // Run plans that don't need gradients with a static memory plan, which
+  // preallocates their intermediates once, see passes/memory_planning.h.
+  // Not used together with dynamic_sizes.
+  bool plan_memory = true;
+  // Run independent nodes of plans that don't need gradients concurrently
+  // on the inter-op thread pool, see parallel_interpreter.h. Such plans
+  // don't use a memory plan.
+  bool inter_op_parallel = false;
+  // Run plans that don't need gradients on the data of their inputs rather
+  // than on Variables, so that their ops dispatch straight to the backend
+  // Type instead of through VariableType, and their intermediates carry no
+  // autograd metadata. The outputs are new Variables that share no version
+  // counter with the inputs, even when they are views of them. Not used for
+  // plans that call into Python or run concurrently.
+  bool unwrap_variables = false;
+};
+
+// options used by executors that are constructed without explicit options
+GraphExecutorOptions getDefaultGraphExecutorOptions();
+void setDefaultGraphExecutorOptions(const GraphExecutorOptions & options);
+
 struct GraphExecutorImpl;
 struct GraphExecutor {
   GraphExecutor() {}
   GraphExecutor(std::shared_ptr<Graph> graph, bool optimize = true);
   // note: if not specified, symbolically_differentiable is computed from the graph.
   GraphExecutor(std::shared_ptr<Graph> graph, bool optimize, bool symbolically_differentiable);
+  GraphExecutor(std::shared_ptr<Graph> graph, bool optimize, bool symbolically_differentiable,
+                const GraphExecutorOptions & options);
   variable_tensor_list run(variable_tensor_list && inputs);
   explicit operator bool() const {
     return pImpl != nullptr;
@@ -45,6 +90,23 @@ struct GraphExecutor {
   std::shared_ptr<Graph> graph() const;
   std::shared_ptr<Graph> graphFor(const variable_tensor_list& inputs) const;
   GraphExecutorState getDebugState();
+
+  // Ahead-of-time compilation. compileFor creates the plan that inputs like
+  // these will run with, without running it. exportPlans returns the
+  // optimized graph of every cached plan that computes no gradients
+  // (specialized, with fusion groups), most recently used first; the types
+  // of its inputs describe the inputs it was specialized to. importPlans
+  // adds such graphs, e.g. read back with ImportExecutionPlans, to the cache
+  // of an executor of the same unoptimized graph, so that calls with those
+  // inputs skip optimization. Their fusion groups are compiled while
+  // importing, or loaded from the on-disk kernel cache if one is configured.
+  void compileFor(const variable_tensor_list& inputs);
+  // compileFor inputs of a spec with sizes that don't require grad, e.g. one
+  // built from types. Does nothing with dynamic_sizes, whose cache isn't
+  // keyed by such specs.
+  void compileFor(const ArgumentSpec& spec);
+  std::vector<std::shared_ptr<Graph>> exportPlans() const;
+  void importPlans(const std::vector<std::shared_ptr<Graph>>& plans);
 private:
   std::shared_ptr<GraphExecutorImpl> pImpl;
 };
@@ -57,11 +119,18 @@ void runRequiredPasses(const std::shared_ptr<Graph>& g);
 // this prepares the graph for execution, including running runRequiredPasses,
 // but the execution only remains valid for tensors whose properties match spec
 // otherwise running the graph will have undefined results.
-void specializeToSpec(const std::shared_ptr<Graph>& graph, const ArgumentSpec& spec);
+// if dynamic_sizes=true the graph also remains valid for tensors whose sizes
+// differ from spec, as long as their ranks, contiguity and size-1 dimensions
+// match (see ArgumentSpec with_sizes=false).
+void specializeToSpec(const std::shared_ptr<Graph>& graph, const ArgumentSpec& spec,
+                      bool dynamic_sizes = false);
 
 // apply standard optimizations. if graphMustSupportVariables=false then
 // then the passes are allowed to modify the graph in ways that make it no longer
 // work with tensors that have requires_grad=True
-void runOptimization(std::shared_ptr<Graph> & graph, bool graphMustSupportVariables);
+// if dynamic_sizes=true passes that rely on the concrete sizes in the graph's
+// types are skipped.
+void runOptimization(std::shared_ptr<Graph> & graph, bool graphMustSupportVariables,
+                     bool dynamic_sizes = false);
 
 }}
@@ -0,0 +1,255 @@
+#include "torch/csrc/jit/graph_profiler.h"
+
+#include "torch/csrc/autograd/profiler.h"
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+namespace torch { namespace jit {
+
+namespace profiler_detail {
+std::atomic<bool> graph_profiling_enabled {false};
+}
+
+namespace {
+
+using autograd::profiler::Event;
+using autograd::profiler::EventKind;
+using autograd::profiler::getTime;
+
+struct RecordedEvent {
+  GraphProfileEvent event;
+  uint64_t start_ns;
+  uint64_t end_ns;
+  std::unique_ptr<Event> cuda_start;
+  std::unique_ptr<Event> cuda_end;
+};
+
+std::mutex profile_mutex;
+std::atomic<bool> record_cuda_events {false};
+uint64_t profile_start_ns = 0;
+std::vector<RecordedEvent> recorded_events;
+std::unordered_map<Graph*, std::shared_ptr<Graph>> profiled_graphs;
+
+std::atomic<uint32_t> next_thread_id {0};
+
+uint32_t currentThreadId() {
+  thread_local uint32_t id = next_thread_id++;
+  return id;
+}
+
+void record(RecordedEvent e, const std::shared_ptr<Graph>& graph) {
+  std::lock_guard<std::mutex> guard(profile_mutex);
+  // profiling may have been disabled while this ran
+  if(!isGraphProfilingEnabled())
+    return;
+  if(graph)
+    profiled_graphs.emplace(graph.get(), graph);
+  recorded_events.push_back(std::move(e));
+}
+
+void printSizes(std::ostream & out, const std::vector<std::vector<int64_t>> & sizes) {
+  for(size_t i = 0; i < sizes.size(); ++i) {
+    if(i > 0)
+      out << ", ";
+    out << "[";
+    for(size_t j = 0; j < sizes[i].size(); ++j) {
+      if(j > 0)
+        out << ", ";
+      out << sizes[i][j];
+    }
+    out << "]";
+  }
+}
+
+// node kinds and executor step names only need quotes and backslashes
+// escaped
+std::string jsonString(const std::string & s) {
+  std::string r = "\"";
+  for(auto c : s) {
+    if(c == '"' || c == '\\')
+      r += '\\';
+    r += c;
+  }
+  return r + "\"";
+}
+
+} // anonymous namespace
+
+struct ProfileNodeRange::Impl {
+  std::shared_ptr<Graph> graph;
+  RecordedEvent e;
+  // the tensor the kernel of a fusion group runs on the device of
+  at::Tensor cuda_input;
+};
+
+ProfileNodeRange::ProfileNodeRange(const std::shared_ptr<Graph>& graph, Node* node, at::ArrayRef<IValue> inputs) {
+  if(!isGraphProfilingEnabled())
+    return;
+  pImpl.reset(new Impl());
+  pImpl->graph = graph;
+  auto & e = pImpl->e.event;
+  e.name = node->kind().toQualString();
+  e.node = node;
+  e.thread_id = currentThreadId();
+  e.cuda_us = -1;
+  for(auto & input : inputs) {
+    if(input.isTensor() && input.toTensor().defined()) {
+      auto t = input.toTensor();
+      e.input_sizes.push_back(t.sizes().vec());
+      if(!pImpl->cuda_input.defined() && t.type().is_cuda())
+        pImpl->cuda_input = t;
+    } else {
+      e.input_sizes.emplace_back();
+    }
+  }
+  if(!record_cuda_events || node->kind() != prim::FusionGroup)
+    pImpl->cuda_input = at::Tensor();
+  if(pImpl->cuda_input.defined()) {
+    at::DeviceGuard device_guard(pImpl->cuda_input);
+    pImpl->e.cuda_start.reset(new Event(EventKind::Mark, "", e.thread_id, /*record_cuda=*/true));
+  }
+  pImpl->e.start_ns = getTime();
+}
+
+ProfileNodeRange::~ProfileNodeRange() {
+  if(!pImpl)
+    return;
+  pImpl->e.end_ns = getTime();
+  if(pImpl->cuda_input.defined()) {
+    at::DeviceGuard device_guard(pImpl->cuda_input);
+    pImpl->e.cuda_end.reset(new Event(EventKind::Mark, "", pImpl->e.event.thread_id, /*record_cuda=*/true));
+  }
+  record(std::move(pImpl->e), pImpl->graph);
+}
+
+ProfileExecutorRange::ProfileExecutorRange(const char* name)
+: name(name)
+, start_ns(isGraphProfilingEnabled() ? getTime() : 0) {}
+
+ProfileExecutorRange::~ProfileExecutorRange() {
+  if(start_ns == 0)
+    return;
+  RecordedEvent e;
+  e.event.name = name;
+  e.event.node = nullptr;
+  e.event.thread_id = currentThreadId();
+  e.event.cuda_us = -1;
+  e.start_ns = start_ns;
+  e.end_ns = getTime();
+  record(std::move(e), nullptr);
+}
+
+void enableGraphProfiling(bool record_cuda) {
+  std::lock_guard<std::mutex> guard(profile_mutex);
+  if(isGraphProfilingEnabled())
+    throw std::runtime_error("graph profiling is already enabled");
+#ifndef USE_CUDA
+  if(record_cuda)
+    throw std::runtime_error("Can't record CUDA events - PyTorch was compiled without CUDA");
+#endif
+  record_cuda_events = record_cuda;
+  profile_start_ns = getTime();
+  profiler_detail::graph_profiling_enabled = true;
+}
+
+GraphProfile disableGraphProfiling() {
+  std::vector<RecordedEvent> events;
+  GraphProfile profile;
+  uint64_t start_ns;
+  {
+    std::lock_guard<std::mutex> guard(profile_mutex);
+    if(!isGraphProfilingEnabled())
+      throw std::runtime_error("can't disable graph profiling when it's not enabled");
+    profiler_detail::graph_profiling_enabled = false;
+    events = std::move(recorded_events);
+    recorded_events.clear();
+    for(auto & entry : profiled_graphs)
+      profile.graphs.push_back(std::move(entry.second));
+    profiled_graphs.clear();
+    start_ns = profile_start_ns;
+  }
+  std::sort(events.begin(), events.end(), [](const RecordedEvent & a, const RecordedEvent & b) {
+    return a.start_ns < b.start_ns;
+  });
+  for(auto & e : events) {
+    e.event.start_us = (static_cast<int64_t>(e.start_ns) - static_cast<int64_t>(start_ns)) / 1000.0;
+    e.event.cpu_us = (e.end_ns - e.start_ns) / 1000.0;
+    // synchronizes with the kernels
+    if(e.cuda_start && e.cuda_end)
+      e.event.cuda_us = e.cuda_start->cuda_elapsed_us(*e.cuda_end);
+    profile.events.push_back(std::move(e.event));
+  }
+  return profile;
+}
+
+std::unordered_map<Node*, ProfiledNode> GraphProfile::summarize() const {
+  std::unordered_map<Node*, ProfiledNode> nodes;
+  for(auto & e : events) {
+    if(!e.node)
+      continue;
+    auto & n = nodes[e.node];
+    n.calls++;
+    n.cpu_us += e.cpu_us;
+    if(e.cuda_us >= 0)
+      n.cuda_us += e.cuda_us;
+    n.input_sizes = e.input_sizes;
+  }
+  return nodes;
+}
+
+void GraphProfile::printAnnotatedGraphs(std::ostream & out) const {
+  // executor steps first, by name
+  std::map<std::string, std::pair<size_t, double>> steps;
+  for(auto & e : events) {
+    if(e.node)
+      continue;
+    auto & s = steps[e.name];
+    s.first++;
+    s.second += e.cpu_us;
+  }
+  for(auto & s : steps) {
+    out << s.first << ": calls: " << s.second.first << ", total: " << s.second.second << "us\n";
+  }
+  auto nodes = summarize();
+  for(auto & graph : graphs) {
+    printAnnotatedGraph(out, *graph, [&](const Node* n) -> std::string {
+      auto it = nodes.find(const_cast<Node*>(n));
+      if(it == nodes.end())
+        return "";
+      auto & p = it->second;
+      std::stringstream ss;
+      ss << "calls: " << p.calls << ", total: " << p.cpu_us << "us, avg: " << p.cpu_us / p.calls << "us";
+      if(p.cuda_us > 0)
+        ss << ", cuda: " << p.cuda_us << "us";
+      ss << ", input sizes: ";
+      printSizes(ss, p.input_sizes);
+      return ss.str();
+    });
+  }
+}
+
+void GraphProfile::writeChromeTrace(std::ostream & out) const {
+  out << "{\"traceEvents\": [";
+  for(size_t i = 0; i < events.size(); ++i) {
+    auto & e = events[i];
+    if(i > 0)
+      out << ",";
+    out << "\n  {\"name\": " << jsonString(e.name)
+        << ", \"ph\": \"X\", \"ts\": " << e.start_us << ", \"dur\": " << e.cpu_us
+        << ", \"pid\": 0, \"tid\": " << e.thread_id << ", \"args\": {";
+    std::stringstream sizes;
+    printSizes(sizes, e.input_sizes);
+    out << "\"input_sizes\": " << jsonString(sizes.str());
+    if(e.cuda_us >= 0)
+      out << ", \"cuda_us\": " << e.cuda_us;
+    out << "}}";
+  }
+  out << "\n]}\n";
+}
+
+}}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/ivalue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace torch { namespace jit {
+
+// A profiling mode for JIT graphs. The autograd profiler sees the ATen
+// calls a graph makes, but not which node they came from, nor the time
+// spent outside of operators. While graph profiling is enabled:
+//  - interpreters record the wall time and input sizes of every node they
+//    call (plain operators, fusion groups, nested executors),
+//  - GraphExecutors record the time spent looking up the plan for their
+//    inputs (hashing the ArgumentSpec and probing the cache) and compiling
+//    new plans,
+//  - with record_cuda, fusion groups whose inputs are on the GPU are also
+//    timed with CUDA events, which separates kernel time from launch time.
+// Profiling is meant for finding what to optimize; it adds a lock and two
+// clock reads to every node, so don't compare its times to unprofiled runs.
+
+struct GraphProfileEvent {
+  std::string name; // the kind of the node, or the name of the executor step
+  Node* node; // nullptr for executor steps
+  uint32_t thread_id;
+  double start_us; // since profiling was enabled
+  double cpu_us; // wall time
+  double cuda_us; // kernel time, negative if not recorded
+  // empty for inputs that aren't tensors
+  std::vector<std::vector<int64_t>> input_sizes;
+};
+
+struct ProfiledNode {
+  size_t calls = 0;
+  double cpu_us = 0;
+  double cuda_us = 0; // over the calls that recorded it
+  std::vector<std::vector<int64_t>> input_sizes; // of the last call
+};
+
+struct GraphProfile {
+  std::vector<GraphProfileEvent> events;
+  // the graphs the profiled nodes belong to. These are the graphs that the
+  // interpreters run, i.e. copies of the optimized graphs of the execution
+  // plans, and are kept alive by the profile.
+  std::vector<std::shared_ptr<Graph>> graphs;
+
+  std::unordered_map<Node*, ProfiledNode> summarize() const;
+  // prints every graph with the number of calls, the total and average
+  // time and the last input sizes appended to each node that ran
+  void printAnnotatedGraphs(std::ostream & out) const;
+  // the events in the Trace Event Format, for chrome://tracing
+  void writeChromeTrace(std::ostream & out) const;
+};
+
+void enableGraphProfiling(bool record_cuda = false);
+GraphProfile disableGraphProfiling();
+
+namespace profiler_detail {
+extern std::atomic<bool> graph_profiling_enabled;
+}
+
+inline bool isGraphProfilingEnabled() {
+  return profiler_detail::graph_profiling_enabled.load(std::memory_order_relaxed);
+}
+
+// Records the time until it is destroyed as an event for node, which
+// belongs to graph. inputs are the inputs of the node.
+struct ProfileNodeRange {
+  ProfileNodeRange(const std::shared_ptr<Graph>& graph, Node* node, at::ArrayRef<IValue> inputs);
+  ~ProfileNodeRange();
+private:
+  struct Impl;
+  std::unique_ptr<Impl> pImpl;
+};
+
+// Records the time until it is destroyed as an executor step, if profiling
+// is enabled.
+struct ProfileExecutorRange {
+  explicit ProfileExecutorRange(const char* name);
+  ~ProfileExecutorRange();
+private:
+  const char* name;
+  uint64_t start_ns;
+};
+
+}}
@@ -5,6 +5,7 @@
 
 #include <ATen/ATen.h>
 
+#include <sstream>
 #include <unordered_map>
 #include <vector>
 #include <string>
@@ -40,6 +41,7 @@ struct AttributeValue_ {
 
 struct Value_ {
   std::string name;
+  std::string doc_string; // the complete type in typed exports
 };
 
 struct Node_ {
@@ -53,6 +55,7 @@ struct Node_ {
 struct Graph_ {
   std::vector<Value_> inputs;
   std::vector<Value_> outputs;
+  std::vector<Value_> value_info;
   std::vector<Node_> nodes;
   std::vector<Tensor_> initializers;
 };
@@ -234,7 +237,8 @@ template<>
 struct Reader<Value_> : ReaderBase {
   Reader()
     : proto(onnx_ValueInfoProto_init_default)
-    , name_reader(proto.name) {}
+    , name_reader(proto.name)
+    , doc_string_reader(proto.doc_string) {}
   Reader(pb_callback_t& cb)
     : Reader() { initialize_callback(cb); }
 
@@ -244,10 +248,12 @@ struct Reader<Value_> : ReaderBase {
     }
 
     value.name = std::move(name_reader.value);
+    value.doc_string = std::move(doc_string_reader.value);
   }
 
   onnx_ValueInfoProto proto;
   Reader<std::string> name_reader;
+  Reader<std::string> doc_string_reader;
   Value_ value;
 };
 
@@ -293,6 +299,7 @@ struct Reader<Graph_> : ReaderBase {
     : proto(onnx_GraphProto_init_default)
     , input_reader(proto.input)
     , output_reader(proto.output)
+    , value_info_reader(proto.value_info)
     , node_reader(proto.node)
     , initializer_reader(proto.initializer)
   {}
@@ -306,6 +313,7 @@ struct Reader<Graph_> : ReaderBase {
 
     value.inputs = std::move(input_reader.values);
     value.outputs = std::move(output_reader.values);
+    value.value_info = std::move(value_info_reader.values);
     value.nodes = std::move(node_reader.values);
     value.initializers = std::move(initializer_reader.values);
   }
@@ -319,6 +327,7 @@ struct Reader<Graph_> : ReaderBase {
   onnx_GraphProto proto;
   Reader<std::vector<Value_>> input_reader;
   Reader<std::vector<Value_>> output_reader;
+  Reader<std::vector<Value_>> value_info_reader;
   Reader<std::vector<Node_>> node_reader;
   Reader<std::vector<Tensor_>> initializer_reader;
   Graph_ value;
@@ -397,6 +406,36 @@ at::Tensor buildTensor(const Tensor_& tensor_) {
   return tensor;
 }
 
+// parses the types written by typed exports, see encodeType in export.cpp
+TypePtr buildType(const std::string& encoded) {
+  std::istringstream ss(encoded);
+  std::string kind;
+  ss >> kind;
+  if (kind == "Tensor") {
+    int scalar_type, device;
+    size_t ndim;
+    ss >> scalar_type >> device >> ndim;
+    std::vector<int64_t> sizes(ndim), strides(ndim);
+    for (auto & s : sizes)
+      ss >> s;
+    for (auto & s : strides)
+      ss >> s;
+    if (!ss) {
+      throw std::runtime_error("Malformed type: " + encoded);
+    }
+    return std::make_shared<TensorType>(static_cast<at::ScalarType>(scalar_type), device, sizes, strides);
+  } else if (kind == "Number") {
+    return NumberType::get();
+  } else if (kind == "Float") {
+    return FloatType::get();
+  } else if (kind == "Int") {
+    return IntType::get();
+  } else if (kind == "Dynamic") {
+    return DynamicType::get();
+  }
+  throw std::runtime_error("Malformed type: " + encoded);
+}
+
 Graph_ readSubgraph(const std::string& serialized_subgraph) {
   pb_istream_t istream = pb_istream_from_buffer(reinterpret_cast<const pb_byte_t *>(serialized_subgraph.data()), serialized_subgraph.size());
 
@@ -427,7 +466,15 @@ void buildBlock(const Graph_& graph_, Block* block,
                 std::unordered_map<std::string, Value*>& value_map) {
 
   for (auto & input : graph_.inputs) {
-    value_map[input.name] = block->addInput();
+    auto v = block->addInput();
+    if (!input.doc_string.empty()) {
+      v->setType(buildType(input.doc_string));
+    }
+    value_map[input.name] = v;
+  }
+  std::unordered_map<std::string, const std::string*> value_types;
+  for (auto & info : graph_.value_info) {
+    value_types[info.name] = &info.doc_string;
   }
 
   for (auto & node_ : graph_.nodes) {
@@ -489,6 +536,20 @@ void buildBlock(const Graph_& graph_, Block* block,
 
     for (size_t i=0; i<node_.outputs.size(); i++) {
       value_map[node_.outputs[i]] = node->outputs()[i];
+      auto it = value_types.find(node_.outputs[i]);
+      if (it != value_types.end() && !it->second->empty()) {
+        node->outputs()[i]->setType(buildType(*it->second));
+      }
+    }
+
+    // tensors are always serialized from the CPU, put constants back where
+    // the typed export says they were
+    if (node->kind() == prim::Constant && node->hasAttribute(attr::value)) {
+      auto type = node->output()->type()->cast<TensorType>();
+      if (type && type->device() != -1) {
+        at::DeviceGuard guard(type->device());
+        node->t_(attr::value, node->t(attr::value).toBackend(at::kCUDA));
+      }
     }
 
     block->appendNode(node);
@@ -525,4 +586,19 @@ std::shared_ptr<Graph> ImportIRGraph(const std::string& serialized_graph,
   return graph;
 }
 
+std::vector<std::shared_ptr<Graph>> ImportExecutionPlans(const std::string& serialized_plans) {
+  pb_istream_t istream = pb_istream_from_buffer(reinterpret_cast<const pb_byte_t *>(serialized_plans.data()), serialized_plans.size());
+
+  auto model = Reader<Model_>::read(&istream);
+
+  auto & nodes = model.graph.nodes;
+  if (nodes.size() != 1 || nodes[0].op_type != "ExecutionPlans" ||
+      nodes[0].attrs.size() != 1 || nodes[0].attrs[0].name != "plans") {
+    throw std::runtime_error("Serialized data does not contain execution plans");
+  }
+  return fmap(nodes[0].attrs[0].gs, [](const std::string& g) {
+    return buildGraph(readSubgraph(g));
+  });
+}
+
 }}
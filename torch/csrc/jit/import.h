@@ -6,4 +6,7 @@ namespace torch { namespace jit {
 
 std::shared_ptr<Graph> ImportIRGraph(const std::string& serialized_graph, std::vector<at::Tensor> & initializers);
 
+// Reads graphs written by ExportExecutionPlans, with their complete types.
+std::vector<std::shared_ptr<Graph>> ImportExecutionPlans(const std::string& serialized_plans);
+
 }}
@@ -18,14 +18,21 @@
 #include "torch/csrc/jit/passes/shape_analysis.h"
 #include "torch/csrc/jit/passes/decompose_addmm.h"
 #include "torch/csrc/jit/passes/loop_unrolling.h"
+#include "torch/csrc/jit/passes/constant_propagation.h"
+#include "torch/csrc/jit/passes/loop_invariant_code_motion.h"
 #include "torch/csrc/jit/passes/to_batch.h"
 #include "torch/csrc/jit/passes/specialize_undef.h"
 #include "torch/csrc/jit/graph_executor.h"
+#include "torch/csrc/jit/graph_profiler.h"
+#include "torch/csrc/jit/parallel_interpreter.h"
 #include "torch/csrc/jit/script/init.h"
 #include "torch/csrc/jit/script/python_tree_views.h"
 #include "torch/csrc/jit/batched/BatchTensor.h"
 #include "torch/csrc/jit/pybind_utils.h"
 
+#include <fstream>
+#include <sstream>
+
 namespace torch  { namespace jit {
 
 namespace {
@@ -70,6 +77,8 @@ void initJITBindings(PyObject *module) {
    })
    .def("_jit_pass_erase_number_types", EraseNumberTypes)
    .def("_jit_pass_loop_unrolling", UnrollLoops)
+   .def("_jit_pass_constant_propagation", ConstantPropagation)
+   .def("_jit_pass_licm", LoopInvariantCodeMotion)
    .def("_jit_run_cpp_tests", [] {
      // We have to release the GIL inside this method, because if we happen to
      // initialize the autograd engine in these tests, the newly spawned worker threads will
@@ -88,6 +97,24 @@ void initJITBindings(PyObject *module) {
    .def("_jit_pass_fixup_onnx_loops", FixupONNXLoops)
    .def("_jit_pass_decompose_addmm", DecomposeAddmm)
     .def("_jit_pass_specialize_undef", specializeUndef)
+   .def("_jit_set_executor_options", [](size_t max_plans, bool dynamic_sizes, bool plan_memory,
+                                        bool inter_op_parallel, bool unwrap_variables) {
+     GraphExecutorOptions options;
+     options.max_plans = max_plans;
+     options.dynamic_sizes = dynamic_sizes;
+     options.plan_memory = plan_memory;
+     options.inter_op_parallel = inter_op_parallel;
+     options.unwrap_variables = unwrap_variables;
+     setDefaultGraphExecutorOptions(options);
+   }, py::arg("max_plans") = GraphExecutorOptions().max_plans,
+      py::arg("dynamic_sizes") = GraphExecutorOptions().dynamic_sizes,
+      py::arg("plan_memory") = GraphExecutorOptions().plan_memory,
+      py::arg("inter_op_parallel") = GraphExecutorOptions().inter_op_parallel,
+      py::arg("unwrap_variables") = GraphExecutorOptions().unwrap_variables)
+   .def("_jit_set_num_inter_op_threads", setNumInterOpThreads)
+   .def("_jit_get_num_inter_op_threads", getNumInterOpThreads)
+   .def("_jit_enable_graph_profiling", enableGraphProfiling, py::arg("record_cuda") = false)
+   .def("_jit_disable_graph_profiling", disableGraphProfiling)
    .def("_jit_differentiate", [](Graph &g, const std::vector<bool>& requires_grad) {
        // the python binding slightly differs in semantics
        // it makes a copy of the input Graph, and works on that
@@ -141,6 +168,23 @@ void initJITBindings(PyObject *module) {
       return m.df_output_vjps;
     });
 
+  py::class_<PlanCacheStats>(m, "PlanCacheStats")
+    .def_readonly("hits", &PlanCacheStats::hits)
+    .def_readonly("misses", &PlanCacheStats::misses)
+    .def_readonly("evictions", &PlanCacheStats::evictions)
+    .def_readonly("compile_ms", &PlanCacheStats::compile_ms);
+
+  py::class_<GraphProfile>(m, "GraphProfile")
+    .def("annotated_graphs", [](GraphProfile& p) {
+      std::ostringstream s;
+      p.printAnnotatedGraphs(s);
+      return s.str();
+    })
+    .def("export_chrome_trace", [](GraphProfile& p, const std::string& path) {
+      std::ofstream out(path);
+      p.writeChromeTrace(out);
+    });
+
   py::class_<GraphExecutorState>(m, "GraphExecutorState")
     .def_property_readonly("graph", [](GraphExecutorState& s) {
       return s.graph;
@@ -153,6 +197,9 @@ void initJITBindings(PyObject *module) {
     })
     .def_property_readonly("autograd_fallback_graph", [](GraphExecutorState& s) {
       return s.autograd_fallback_graph;
+    })
+    .def_property_readonly("plan_cache_stats", [](GraphExecutorState& s) {
+      return s.plan_cache_stats;
     });
 
   py::class_<GraphExecutor>(m, "GraphExecutor", py::dynamic_attr())
@@ -7,12 +7,16 @@
 #include "torch/csrc/jit/fusion_compiler.h"
 #include "torch/csrc/jit/operator.h"
 #include "torch/csrc/jit/graph_executor.h"
+#include "torch/csrc/jit/graph_profiler.h"
 #include "torch/csrc/jit/ir.h"
 #include "torch/csrc/jit/tensor_conversions.h"
 #include "torch/csrc/jit/ivalue.h"
+#include "torch/csrc/jit/passes/inplace_ops.h"
+#include "torch/csrc/jit/passes/memory_planning.h"
 #include "torch/csrc/variable_tensor_functions.h"
 #include "torch/csrc/autograd/generated/variable_factories.h"
 
+#include <algorithm>
 #include <exception>
 #include <iostream>
 #include <memory>
@@ -383,13 +387,42 @@ struct UseList {
   ListHandle<bool> free_flags;
 };
 
+// Control flow, assignments and drops only shuffle registers, so the
+// interpreter executes them directly instead of pushing their inputs onto
+// the stack and calling a no-op callback. Everything else is a Call.
+enum class OpCode : uint8_t {
+  Call,
+  Assign,
+  Drop,
+  Jump,
+  JumpZ,
+  JumpNZ,
+};
+
 // one instruction plus meta-data
 struct Instruction {
+  OpCode opcode = OpCode::Call;
   Operation callback;
   UseList inputs;
   ListHandle<int> outputs;
+  int jump_offset = 0; // relative target of Jump, JumpZ and JumpNZ
+  // Assign whose outputs can be written one at a time without clobbering
+  // an input that is still to be read, see markInPlaceAssigns
+  bool assign_in_place = false;
+  // Superinstruction flags, see forwardOutputs. When forward_outputs is set
+  // the outputs stay on the stack instead of being stored to registers,
+  // and the next instruction, which has forwarded_inputs == outputs.size,
+  // uses them in place of loading its first inputs.
+  bool forward_outputs = false;
+  int forwarded_inputs = 0;
+  // index of the preallocated output when the callback is an out= variant,
+  // see CodeImpl::memory_plan
+  int planned_output = -1;
+  // the callback is the in-place variant, see CodeImpl::inplace_nodes
+  bool inplace = false;
   Symbol debug_name; // used in dump to understand the generated code
   std::shared_ptr<SourceLocation> debug_location; // for error reporting
+  Node * node = nullptr; // the node of a Call, for profiling
 };
 
 
@@ -397,46 +430,56 @@ int relativeJump(int from_inst, int to_inst) {
   return to_inst - (from_inst + 1);
 }
 
+// Preallocated memory for the values of a MemoryPlan. A running
+// InterpreterState owns one, so it can be reused by later runs, but never
+// by two runs at once.
+struct MemoryArena {
+  std::vector<at::Tensor> buffers; // one per MemoryPlan::arenas
+  std::vector<IValue> tensors; // one per MemoryPlan::values, views of buffers
+};
+
 struct CodeImpl {
-  CodeImpl(std::shared_ptr<Graph>& graph_)
-      : preprocess(*graph_) {
+  CodeImpl(std::shared_ptr<Graph>& graph_, bool plan_memory, bool unwrapped)
+      : preprocess(*graph_), unwrapped(unwrapped) {
     graph = preprocess.graph;
     //std::cout << "into code graph:\n" << *graph << "\n";
+    // planned values live in the arena of a single InterpreterState, which
+    // clone() would share between stages run by different states
+    if(plan_memory && preprocess.stage_input_types.size() == 1) {
+      memory_plan = PlanMemory(*graph);
+      for(size_t i = 0; i < memory_plan.values.size(); ++i)
+        planned_outputs[memory_plan.values[i].value] = i;
+    }
+    if(plan_memory)
+      inplace_nodes = FindInplaceNodes(*graph);
     insertNodesFromBlock(graph->block());
+    markInPlaceAssigns();
+    forwardOutputs();
   }
 
   // jump when input is 0
+  // the input is either the instruction's own input or, for loops, the
+  // condition left on top of the stack by the preceding Assign
   void createJumpZ(int from_inst, int to_inst) {
-    auto & inst = instructions[from_inst];
-    JIT_ASSERT(inst.debug_name == prim::Placeholder);
-    auto offset = relativeJump(from_inst, to_inst);
-    inst.callback = [offset](Stack & stack) {
-      auto t = tensor_as<int64_t>(pop(stack).toTensor());
-      return (t == 0) ? offset : 0;
-    };
-    inst.debug_name = prim::JumpZ;
+    createJump(from_inst, to_inst, OpCode::JumpZ, prim::JumpZ);
   }
 
   // jump when input is not 0
   void createJumpNZ(int from_inst, int to_inst) {
-    auto & inst = instructions[from_inst];
-    JIT_ASSERT(inst.debug_name == prim::Placeholder);
-    auto offset = relativeJump(from_inst, to_inst);
-    inst.callback = [offset](Stack & stack) {
-      auto t = tensor_as<int64_t>(pop(stack).toTensor());
-      return (t != 0) ? offset : 0;
-    };
-    inst.debug_name = prim::JumpNZ;
+    createJump(from_inst, to_inst, OpCode::JumpNZ, prim::JumpNZ);
   }
 
   void createJump(int from_inst, int to_inst) {
+    createJump(from_inst, to_inst, OpCode::Jump, prim::Jump);
+  }
+
+  void createJump(int from_inst, int to_inst, OpCode opcode, Symbol sym) {
     auto & inst = instructions[from_inst];
     JIT_ASSERT(inst.debug_name == prim::Placeholder);
-    auto offset = relativeJump(from_inst, to_inst);
-    inst.callback = [=](Stack & stack) {
-      return offset;
-    };
-    inst.debug_name = prim::Jump;
+    inst.opcode = opcode;
+    inst.jump_offset = relativeJump(from_inst, to_inst);
+    inst.debug_name = sym;
+    jump_targets.insert(to_inst);
   }
 
   void insertNodesFromBlock(Block* block) {
@@ -526,9 +569,52 @@ struct CodeImpl {
 
   size_t insertInstruction(Node * n) {
     auto inst = insertInstruction(n->kind(), n->getSourceLocation(), n->inputs(), moveFlags(n) , n->outputs());
-    instructions[inst].callback = getInterpreterOperation(n);
+    instructions[inst].node = n;
+    if(n->kind() == prim::Drop) {
+      instructions[inst].opcode = OpCode::Drop;
+    } else if(n->outputs().size() == 1 && planned_outputs.count(n->output()) > 0) {
+      instructions[inst].callback = getOperatorFor(n).selectOutVariant(n);
+      instructions[inst].planned_output = planned_outputs.at(n->output());
+    } else if(inplace_nodes.count(n) > 0 && planned_outputs.count(n->input(0)) == 0) {
+      // the memory plan reuses the memory of a planned input after its last
+      // use, so it can't become the output
+      instructions[inst].callback = getOperatorFor(n).selectInplaceVariant(n);
+      instructions[inst].inplace = true;
+    } else if(unwrapped && n->kind() == prim::Constant) {
+      auto t = n->t(attr::value);
+      instructions[inst].callback = [t](Stack & stack) {
+        stack.push_back(t);
+        return 0;
+      };
+    } else {
+      instructions[inst].callback = getInterpreterOperation(n);
+    }
+    if(unwrapped && instructions[inst].callback && mayReturnVariables(n))
+      instructions[inst].callback = unwrapOutputs(std::move(instructions[inst].callback), n->outputs().size());
     return inst;
   }
+  // the factories, which create Variables with torch::, and the ops that
+  // aren't ATen's, e.g. FusionGroups, which allocate Variables too
+  bool mayReturnVariables(Node * n) {
+    if(n->kind() == prim::Constant || n->kind() == prim::Drop)
+      return false;
+    if(!n->kind().is_aten())
+      return true;
+    auto & arguments = getOperatorFor(n).schema.arguments;
+    return std::any_of(arguments.begin(), arguments.end(), [](const Argument & a) {
+      return a.name == "layout";
+    });
+  }
+  static Operation unwrapOutputs(Operation op, size_t num_outputs) {
+    return [op, num_outputs](Stack & stack) {
+      int r = op(stack);
+      for(size_t i = stack.size() - num_outputs; i < stack.size(); ++i) {
+        if(stack[i].isTensor() && stack[i].toTensor().is_variable())
+          stack[i] = autograd::as_variable_ref(stack[i].toTensor()).data();
+      }
+      return r;
+    };
+  }
   size_t insertInstruction(Symbol sym,
                            std::shared_ptr<SourceLocation> debug_location,
                                  ArrayRef<Value*> inputs,
@@ -562,12 +648,65 @@ struct CodeImpl {
   size_t insertAssign(std::shared_ptr<SourceLocation> debug_location, ArrayRef<Value*> inputs, ArrayRef<uint8_t> move_flags, ArrayRef<Value*> outputs) {
     auto inst = insertInstruction(prim::Assign, std::move(debug_location),inputs, move_flags, outputs);
     // This node effectively forwards its inputs into different places in a register list.
-    // We don't need to manipulate the stack in any way, because all inputs are also outputs,
-    // and the interpreter will take care of putting them in correct places.
-    instructions[inst].callback = [](Stack& stack) { return 0; };
+    // Any leading inputs without a matching output (a loop condition) are left on the stack.
+    instructions[inst].opcode = OpCode::Assign;
     return inst;
   }
 
+  // An Assign is a parallel copy: the stack-based implementation pushes every
+  // input before storing any output. Writing outputs directly is equivalent
+  // unless some output register is also read as an input by another
+  // position; an input assigned to its own register is a no-op.
+  void markInPlaceAssigns() {
+    for(auto & inst : instructions) {
+      if(inst.opcode != OpCode::Assign)
+        continue;
+      int num_leading = inst.inputs.values.size - inst.outputs.size;
+      JIT_ASSERT(num_leading >= 0);
+      std::unordered_set<int> read;
+      for(int i = 0; i < inst.outputs.size; ++i) {
+        int in = get(inst.inputs.values, num_leading + i);
+        if(in != get(inst.outputs, i))
+          read.insert(in);
+      }
+      bool overlaps = false;
+      for(int i = 0; i < inst.outputs.size; ++i) {
+        if(read.count(get(inst.outputs, i)) > 0)
+          overlaps = true;
+      }
+      inst.assign_in_place = !overlaps;
+    }
+  }
+
+  // Fuses store-then-load pairs between consecutive calls: when the outputs
+  // of a call are exactly the first inputs of the next call, in order, and
+  // that is their last use, they are left on the stack rather than being
+  // stored to registers and immediately moved back out. A chain like
+  // y = f(x); z = g(y) then costs one push per value instead of three moves.
+  // The next instruction must not be a jump target, since arriving there
+  // through a jump would not have the values on the stack.
+  void forwardOutputs() {
+    for(size_t pc = 0; pc + 1 < instructions.size(); ++pc) {
+      auto & inst = instructions[pc];
+      auto & next = instructions[pc + 1];
+      if(inst.opcode != OpCode::Call || next.opcode != OpCode::Call)
+        continue;
+      if(inst.outputs.size == 0 || inst.outputs.size > next.inputs.values.size)
+        continue;
+      if(jump_targets.count(pc + 1) > 0)
+        continue;
+      bool match = true;
+      for(int i = 0; i < inst.outputs.size && match; ++i) {
+        match = get(inst.outputs, i) == get(next.inputs.values, i) &&
+                get(next.inputs.free_flags, i);
+      }
+      if(!match)
+        continue;
+      inst.forward_outputs = true;
+      next.forwarded_inputs = inst.outputs.size;
+    }
+  }
+
   // helpers to build/access RegList objects
   int get(const ListHandle<int> & list, int i)  const {
     return int_data[list.start + i];
@@ -644,6 +783,52 @@ struct CodeImpl {
     return graph_executors;
   }
 
+  // Returns nullptr if nothing is planned. The arena goes back to the pool
+  // when the last reference to it is dropped, so every reference must be
+  // held by something that also keeps this CodeImpl alive.
+  std::shared_ptr<MemoryArena> acquireArena() {
+    if(memory_plan.values.empty())
+      return nullptr;
+    std::unique_ptr<MemoryArena> arena;
+    {
+      std::lock_guard<std::mutex> guard(arena_mutex);
+      if(!free_arenas.empty()) {
+        arena = std::move(free_arenas.back());
+        free_arenas.pop_back();
+      }
+    }
+    if(!arena)
+      arena = createArena();
+    return std::shared_ptr<MemoryArena>(arena.release(), [this](MemoryArena * a) {
+      std::lock_guard<std::mutex> guard(arena_mutex);
+      free_arenas.emplace_back(a);
+    });
+  }
+
+  std::unique_ptr<MemoryArena> createArena() const {
+    std::unique_ptr<MemoryArena> arena(new MemoryArena());
+    for(auto & a : memory_plan.arenas) {
+      at::DeviceGuard device_guard(a.device);
+      auto backend = a.device < 0 ? at::Backend::CPU : at::Backend::CUDA;
+      arena->buffers.push_back(at::getType(backend, at::kByte).tensor({static_cast<int64_t>(a.size)}));
+    }
+    for(auto & v : memory_plan.values) {
+      auto type = v.value->type()->expect<TensorType>();
+      auto & buffer = arena->buffers.at(v.arena);
+      at::DeviceGuard device_guard(buffer);
+      auto data = static_cast<char*>(buffer.data_ptr()) + v.offset;
+      // the deleter holds a reference to keep the buffer alive
+      auto t = at::getType(buffer.type().backend(), type->scalarType())
+        .tensorFromBlob(data, type->sizes(), type->strides(), [buffer](void*) {});
+      if(unwrapped) {
+        arena->tensors.emplace_back(std::move(t));
+      } else {
+        arena->tensors.emplace_back(autograd::make_variable(std::move(t), /*requires_grad=*/false));
+      }
+    }
+    return arena;
+  }
+
   void dumpInstruction(std::ostream & out, size_t pc) const {
     auto writeList = [&](const ListHandle<int> & list) {
       for(int i = 0; i < list.size; i++) {
@@ -668,6 +853,14 @@ struct CodeImpl {
     // dispatch
     out << " = " << inst.debug_name.toUnqualString() << " ";
     writeUseList(inst.inputs);
+    if(inst.opcode == OpCode::Jump || inst.opcode == OpCode::JumpZ || inst.opcode == OpCode::JumpNZ)
+      out << " -> " << pc + 1 + inst.jump_offset;
+    if(inst.planned_output >= 0)
+      out << " (out=planned[" << inst.planned_output << "])";
+    if(inst.inplace)
+      out << " (in-place)";
+    if(inst.forward_outputs)
+      out << " (forwarded)";
   }
   void dump(std::ostream & out) const {
     for(size_t i = 0; i < instructions.size(); ++i) {
@@ -684,12 +877,19 @@ struct CodeImpl {
   std::shared_ptr<Graph> graph;
   std::vector<GraphExecutor*> graph_executors; // for debugging
   PreprocessGraph preprocess;
+  bool unwrapped; // see Code
 
   std::unordered_map<size_t, int> unique_to_reg; // map from unique of nodes to register in register table
 
   friend struct InterpreterState;
   std::vector<Instruction> instructions;
+  MemoryPlan memory_plan;
+  std::unordered_map<Value*, int> planned_outputs; // index into memory_plan.values
+  std::unordered_set<Node*> inplace_nodes; // see passes/inplace_ops.h
+  std::mutex arena_mutex;
+  std::vector<std::unique_ptr<MemoryArena>> free_arenas;
   std::vector<size_t> stage_end; // each stage runs while(pc < stage_end[stage])
+  std::unordered_set<size_t> jump_targets;
   int register_size = 0;
 
   // all memory ArrayRef<int> are slices of this, to make sure
@@ -704,7 +904,8 @@ struct InterpreterStateImpl {
   : function(function_.pImpl),
     int_data(function->int_data.data()),
     bool_data(function->bool_data),
-    registers(function->register_size) {
+    registers(function->register_size),
+    arena(function->acquireArena()) {
   }
   void runOneStage(Stack & stack) {
     // std::cout << "running stage: " << current_stage << " of " << function->stage_end.size() << "\n";
@@ -713,18 +914,50 @@ struct InterpreterStateImpl {
     size_t pc = current_pc;
     size_t last = function->stage_end[current_stage];
     auto & instructions = function->instructions;
+    bool profiling = isGraphProfilingEnabled();
     while(pc < last) {
         // std::cout << "executing " << pc << ": ";
         // function->dumpInstruction(std::cout, pc);
         // std::cout << "\n";
         try {
           auto & inst = instructions[pc];
-          loadTensorsFromRegisters(inst.inputs, stack);
-          size_t new_pc = pc + 1 + inst.callback(stack);
-          for(int i = inst.outputs.size - 1; i >= 0; i--) {
-            int reg = get(inst.outputs,i);
-            registers[reg] = pop(stack);
-            // std::cout << "pop reg[" << reg << "];\n" << registers[reg].pImpl << "\n";
+          size_t new_pc = pc + 1;
+          switch(inst.opcode) {
+            case OpCode::Call:
+              loadTensorsFromRegisters(inst.inputs, stack, inst.forwarded_inputs);
+              if(profiling && inst.node) {
+                ProfileNodeRange range(function->graph, inst.node,
+                                       jit::last(stack, inst.inputs.values.size));
+                new_pc += call(inst, stack);
+              } else {
+                new_pc += call(inst, stack);
+              }
+              if(!inst.forward_outputs)
+                storeOutputs(inst.outputs, stack);
+              break;
+            case OpCode::Assign:
+              if(inst.assign_in_place) {
+                assignInPlace(inst, stack);
+              } else {
+                loadTensorsFromRegisters(inst.inputs, stack);
+                storeOutputs(inst.outputs, stack);
+              }
+              break;
+            case OpCode::Drop:
+              for(int i = 0; i < inst.inputs.values.size; i++) {
+                if(get(inst.inputs.free_flags, i))
+                  registers[get(inst.inputs.values, i)] = IValue();
+              }
+              break;
+            case OpCode::Jump:
+              new_pc += inst.jump_offset;
+              break;
+            case OpCode::JumpZ:
+            case OpCode::JumpNZ: {
+              auto t = tensor_as<int64_t>(takeCondition(inst.inputs, stack).toTensor());
+              if((t == 0) == (inst.opcode == OpCode::JumpZ))
+                new_pc += inst.jump_offset;
+            } break;
           }
           pc = new_pc;
         } catch(std::exception & e) {
@@ -737,6 +970,11 @@ struct InterpreterStateImpl {
     current_pc = pc;
     current_stage++;
   }
+  int call(const Instruction & inst, Stack & stack) {
+    if(inst.planned_output >= 0)
+      stack.push_back(arena->tensors[inst.planned_output]);
+    return inst.callback(stack);
+  }
   const TensorType & tensorTypeForInput(size_t i) const {
     return *function->preprocess.stage_input_types.at(current_stage).at(i)->expect<TensorType>();
   }
@@ -746,8 +984,10 @@ struct InterpreterStateImpl {
   bool get(const ListHandle<bool> & list, int i) {
     return bool_data[list.start + i];
   }
-  void loadTensorsFromRegisters(const UseList & uses, Stack & stack) {
-    for(int i = 0; i < uses.values.size; i++) {
+  // loads inputs [start, size) onto the stack; the first start inputs
+  // were forwarded on the stack by the previous instruction
+  void loadTensorsFromRegisters(const UseList & uses, Stack & stack, int start = 0) {
+    for(int i = start; i < uses.values.size; i++) {
       int reg = get(uses.values,i);
       // std::cout << "push reg[" << reg << "];\n" << registers[reg] << "\n\n";
       if(get(uses.free_flags,i)) {
@@ -758,6 +998,48 @@ struct InterpreterStateImpl {
 
     }
   }
+  void storeOutputs(const ListHandle<int> & outputs, Stack & stack) {
+    for(int i = outputs.size - 1; i >= 0; i--) {
+      int reg = get(outputs,i);
+      registers[reg] = pop(stack);
+      // std::cout << "pop reg[" << reg << "];\n" << registers[reg].pImpl << "\n";
+    }
+  }
+  // same effect as loading all inputs and storing the outputs, but only
+  // leading inputs without an output go through the stack
+  void assignInPlace(const Instruction & inst, Stack & stack) {
+    int num_leading = inst.inputs.values.size - inst.outputs.size;
+    for(int i = 0; i < num_leading; i++) {
+      int reg = get(inst.inputs.values, i);
+      if(get(inst.inputs.free_flags, i)) {
+        stack.push_back(std::move(registers[reg]));
+      } else {
+        stack.push_back(registers[reg]);
+      }
+    }
+    for(int i = 0; i < inst.outputs.size; i++) {
+      int in = get(inst.inputs.values, num_leading + i);
+      int out = get(inst.outputs, i);
+      if(in == out)
+        continue;
+      if(get(inst.inputs.free_flags, num_leading + i)) {
+        // move-assignment swaps, so go through a temporary to leave
+        // the input register empty and release the old output
+        registers[out] = IValue(std::move(registers[in]));
+      } else {
+        registers[out] = registers[in];
+      }
+    }
+  }
+  IValue takeCondition(const UseList & uses, Stack & stack) {
+    if(uses.values.size == 0)
+      return pop(stack);
+    JIT_ASSERT(uses.values.size == 1);
+    int reg = get(uses.values, 0);
+    if(get(uses.free_flags, 0))
+      return std::move(registers[reg]);
+    return registers[reg];
+  }
   size_t current_stage = 0;
   size_t current_pc = 0;
   std::shared_ptr<CodeImpl> function; // keep function alive
@@ -778,6 +1060,10 @@ struct InterpreterStateImpl {
   // total number or register
   std::vector<IValue> registers;
 
+  // preallocated outputs of out= calls, see CodeImpl::memory_plan.
+  // Declared after function and registers, so that it is released first.
+  std::shared_ptr<MemoryArena> arena;
+
   // single buffer for input/output calls to ATen functions, so that we do not reallocate
   Stack stack;
 };
@@ -788,8 +1074,8 @@ std::ostream & operator<<(std::ostream & out, const Code & code) {
   return out;
 }
 
-Code::Code(std::shared_ptr<Graph>& graph)
-    : pImpl(new CodeImpl(graph)) {}
+Code::Code(std::shared_ptr<Graph>& graph, bool plan_memory, bool unwrapped)
+    : pImpl(new CodeImpl(graph, plan_memory, unwrapped)) {}
 Code::~Code() {}
 
 const std::vector<GraphExecutor*>& Code::executors() {
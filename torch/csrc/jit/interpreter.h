@@ -25,7 +25,16 @@ using Stack = std::vector<IValue>;
 struct Code {
   Code()
     : pImpl(nullptr) {}
-  Code(std::shared_ptr<Graph>& graph);
+  // plan_memory: preallocate the intermediates of single-stage graphs with
+  // complete shapes, see passes/memory_planning.h, and run the nodes whose
+  // first input dies there in place, see passes/inplace_ops.h. Only valid for
+  // graphs run without autograd.
+  // unwrapped: run on tensors that aren't Variables, so that ops dispatch
+  // straight to their backend Type rather than through VariableType, and
+  // intermediates carry no autograd metadata. The inputs must be unwrapped
+  // too, and the graph must not call into Python or autograd (PythonOp and
+  // GraphExecutor nodes).
+  Code(std::shared_ptr<Graph>& graph, bool plan_memory = false, bool unwrapped = false);
   ~Code();
 
   // Returns pointers to GraphExecutors created to run GraphExecutor nodes in the given graph.
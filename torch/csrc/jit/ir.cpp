@@ -157,7 +157,10 @@ static std::ostream & indent(std::ostream & out, size_t level) {
   return out;
 }
 
-std::ostream& printNode(std::ostream & out, size_t level, const Node * n, std::vector<const Node*> * groups) {
+using NodeAnnotation = std::function<std::string(const Node*)>;
+
+std::ostream& printNode(std::ostream & out, size_t level, const Node * n, std::vector<const Node*> * groups,
+                        const NodeAnnotation * annotate = nullptr) {
   auto outputs = n->outputs();
   indent(out, level) << const_value_list_with_types(outputs);
   out << " = ";
@@ -180,18 +183,21 @@ std::ostream& printNode(std::ostream & out, size_t level, const Node * n, std::v
   IR_END()
   out << "(" << n->inputs() << ")";
   std::string scopeName = n->scopeName();
-  if (scopeName.empty()) {
-    out << "\n";
-  }
-  else {
+  if (!scopeName.empty()) {
     out << ", ";
-    out << "scope: " << scopeName << "\n";
+    out << "scope: " << scopeName;
   }
+  if (annotate) {
+    auto annotation = (*annotate)(n);
+    if (!annotation.empty())
+      out << "  # " << annotation;
+  }
+  out << "\n";
   for(size_t i = 0; i < n->blocks().size(); ++i) {
     auto b = n->blocks()[i];
     indent(out, level + 1) << "block" << i << "(" << const_value_list_with_types(b->inputs(), false) << ") {\n";
     for(auto n : b->nodes()) {
-      printNode(out, level + 2, n, groups);
+      printNode(out, level + 2, n, groups, annotate);
     }
     indent(out, level + 2) << "-> (" << b->outputs() << ")\n";
     indent(out, level + 1) << "}\n";
@@ -203,7 +209,7 @@ std::ostream& operator<<(std::ostream & out, const Node & n) {
   return printNode(out, 0, &n, nullptr);
 }
 
-std::ostream& operator<<(std::ostream & out, const Graph & g) {
+static std::ostream& printGraph(std::ostream & out, const Graph & g, const NodeAnnotation * annotate) {
   out << "graph(" << const_value_list_with_types(g.inputs(), true) << ") {\n";
   std::vector<const Node*> groups;
   size_t prev_stage = 0;
@@ -212,7 +218,7 @@ std::ostream& operator<<(std::ostream & out, const Graph & g) {
       out << "  ---------------- stage " << n->stage() << " ----------------\n";
       prev_stage = n->stage();
     }
-    printNode(out, 1, n, &groups);
+    printNode(out, 1, n, &groups, annotate);
   }
   out << "  return (" << g.outputs() << ");\n}\n";
   size_t i = 0;
@@ -232,6 +238,15 @@ std::ostream& operator<<(std::ostream & out, const Graph & g) {
   return out;
 }
 
+std::ostream& operator<<(std::ostream & out, const Graph & g) {
+  return printGraph(out, g, nullptr);
+}
+
+std::ostream& printAnnotatedGraph(std::ostream & out, const Graph & g,
+                                  const std::function<std::string(const Node*)> & annotate) {
+  return printGraph(out, g, &annotate);
+}
+
 static void checkSameDevice(const Node* node) {
   bool has_device = false;
   int device;
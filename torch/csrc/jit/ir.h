@@ -53,6 +53,10 @@ struct Value;
 std::ostream& operator<<(std::ostream & out, const Graph & g);
 std::ostream& operator<<(std::ostream & out, const Type & t);
 std::ostream& operator<<(std::ostream & out, const Node & t);
+// prints g like operator<< does, appending annotate(n) as a comment to the
+// line of every node n of g (and of its blocks) for which it isn't empty
+std::ostream& printAnnotatedGraph(std::ostream & out, const Graph & g,
+                                  const std::function<std::string(const Node*)> & annotate);
 
 // A list of nodes, with inputs and outputs
 struct Block;
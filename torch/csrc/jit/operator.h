@@ -14,13 +14,23 @@ FunctionSchema parseSchema(const std::string& decl);
 using OperationCreator = std::function<Operation(Node*)>;
 
 struct Operator {
-  Operator(FunctionSchema schema, OperationCreator op, OperationCreator op_const_attributes = nullptr)
+  Operator(FunctionSchema schema, OperationCreator op, OperationCreator op_const_attributes = nullptr,
+           OperationCreator op_out = nullptr, OperationCreator op_out_const_attributes = nullptr,
+           OperationCreator op_inplace = nullptr, OperationCreator op_inplace_const_attributes = nullptr)
     : schema(std::move(schema))
     , op(std::move(op))
-    , op_const_attributes(std::move(op_const_attributes)) {}
+    , op_const_attributes(std::move(op_const_attributes))
+    , op_out(std::move(op_out))
+    , op_out_const_attributes(std::move(op_out_const_attributes))
+    , op_inplace(std::move(op_inplace))
+    , op_inplace_const_attributes(std::move(op_inplace_const_attributes)) {}
 
-  Operator(const std::string& schema, OperationCreator op, OperationCreator op_const_attributes = nullptr)
-    : Operator(parseSchema(schema), std::move(op), std::move(op_const_attributes)) {}
+  Operator(const std::string& schema, OperationCreator op, OperationCreator op_const_attributes = nullptr,
+           OperationCreator op_out = nullptr, OperationCreator op_out_const_attributes = nullptr,
+           OperationCreator op_inplace = nullptr, OperationCreator op_inplace_const_attributes = nullptr)
+    : Operator(parseSchema(schema), std::move(op), std::move(op_const_attributes),
+               std::move(op_out), std::move(op_out_const_attributes),
+               std::move(op_inplace), std::move(op_inplace_const_attributes)) {}
 
   // Helper constructor to regsiter `op` to run
   // run for _every_ IR Node where n.kind() == name, regardless of arguments.
@@ -45,9 +55,46 @@ struct Operator {
       return op(n);
     }
   }
+
+  // Some operators also have an out= variant, which writes its single
+  // output into a preallocated tensor instead of allocating it. The tensor
+  // is passed as an extra input on top of the stack, after the regular
+  // inputs, and is returned as the output.
+  bool hasOutVariant() const {
+    return op_out != nullptr;
+  }
+  // Behavior is undefined if matchesNode(n) == false or !hasOutVariant()
+  Operation selectOutVariant(Node* n) const {
+    if(n->hasAttributes()) {
+      JIT_ASSERT(op_out_const_attributes != nullptr);
+      return op_out_const_attributes(n);
+    } else {
+      return op_out(n);
+    }
+  }
+
+  // Some operators also have an in-place variant (relu_ for relu), which
+  // takes the same inputs, writes its result into the first one and returns
+  // it as the output.
+  bool hasInplaceVariant() const {
+    return op_inplace != nullptr;
+  }
+  // Behavior is undefined if matchesNode(n) == false or !hasInplaceVariant()
+  Operation selectInplaceVariant(Node* n) const {
+    if(n->hasAttributes()) {
+      JIT_ASSERT(op_inplace_const_attributes != nullptr);
+      return op_inplace_const_attributes(n);
+    } else {
+      return op_inplace(n);
+    }
+  }
 private:
   OperationCreator op;
   OperationCreator op_const_attributes;
+  OperationCreator op_out;
+  OperationCreator op_out_const_attributes;
+  OperationCreator op_inplace;
+  OperationCreator op_inplace_const_attributes;
 };
 
 const std::vector<std::shared_ptr<Operator>>& getAllOperatorsFor(Symbol name);
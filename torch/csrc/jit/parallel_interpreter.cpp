@@ -0,0 +1,433 @@
+#include "torch/csrc/jit/parallel_interpreter.h"
+
+#include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/jit/graph_profiler.h"
+#include "torch/csrc/jit/interpreter.h"
+#include "torch/csrc/jit/ir.h"
+#include "torch/csrc/jit/ivalue.h"
+#include "torch/csrc/jit/operator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace torch { namespace jit {
+
+namespace {
+
+thread_local bool in_inter_op_thread = false;
+
+struct InterOpThreadPool {
+  explicit InterOpThreadPool(size_t num_threads) {
+    for(size_t i = 0; i < num_threads; i++)
+      threads.emplace_back([this] { workerLoop(); });
+  }
+  ~InterOpThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    cv.notify_all();
+    for(auto & t : threads)
+      t.join();
+  }
+  void run(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push_back(std::move(task));
+    }
+    cv.notify_one();
+  }
+private:
+  void workerLoop() {
+    in_inter_op_thread = true;
+    while(true) {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [this] { return stopping || !tasks.empty(); });
+      if(tasks.empty())
+        return;
+      auto task = std::move(tasks.front());
+      tasks.pop_front();
+      lock.unlock();
+      task();
+    }
+  }
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> tasks;
+  bool stopping = false;
+};
+
+std::atomic<size_t> num_inter_op_threads {0};
+
+InterOpThreadPool & interOpThreadPool() {
+  // never destroyed, so that graphs may still run while static objects
+  // are torn down at exit
+  static InterOpThreadPool * pool = new InterOpThreadPool(getNumInterOpThreads());
+  return *pool;
+}
+
+bool isInPlace(Node * n) {
+  if(!n->kind().is_aten())
+    return false;
+  const char * name = n->kind().toUnqualString();
+  size_t len = std::strlen(name);
+  return len > 0 && name[len - 1] == '_';
+}
+
+// nodes that have to run in program order with respect to all other nodes
+bool hasSideEffects(Node * n) {
+  if(n->kind() == prim::Print || n->kind() == prim::PythonOp || isInPlace(n))
+    return true;
+  for(auto b : n->blocks()) {
+    for(auto nested : b->nodes()) {
+      if(hasSideEffects(nested))
+        return true;
+    }
+  }
+  return false;
+}
+
+constexpr size_t kNoTask = static_cast<size_t>(-1);
+
+} // anonymous namespace
+
+struct ParallelCodeImpl {
+  // one node of the graph
+  struct Step {
+    Operation op;
+    std::vector<size_t> inputs; // value slots
+    std::vector<size_t> outputs;
+    std::shared_ptr<SourceLocation> debug_location;
+    Node * node;
+  };
+  struct Task {
+    std::vector<Step> steps;
+    std::vector<size_t> successors;
+    size_t num_dependencies = 0;
+    bool ordered = false; // contains a node with side effects
+  };
+
+  ParallelCodeImpl(const std::shared_ptr<Graph>& graph_)
+  : graph(graph_) {
+    JIT_ASSERTM(graph->stage() == 0, "ParallelCode only runs single-stage graphs");
+    std::unordered_map<Value*, size_t> slots;
+    auto slotFor = [&](Value * v) {
+      auto it = slots.find(v);
+      if(it != slots.end())
+        return it->second;
+      slots.emplace(v, slots.size());
+      use_counts.push_back(0);
+      return slots.size() - 1;
+    };
+    for(auto input : graph->inputs())
+      slotFor(input);
+    num_inputs = graph->inputs().size();
+
+    // the task producing each value; graph inputs and prologue values have none
+    std::unordered_map<Value*, size_t> producer;
+    size_t last_ordered = kNoTask;
+    std::vector<size_t> since_ordered;
+    for(auto n : graph->nodes()) {
+      Step step;
+      step.op = getStepOperation(n);
+      step.debug_location = n->getSourceLocation();
+      step.node = n;
+      for(auto input : n->inputs()) {
+        auto slot = slotFor(input);
+        step.inputs.push_back(slot);
+        use_counts[slot]++;
+      }
+      for(auto output : n->outputs())
+        step.outputs.push_back(slotFor(output));
+
+      bool ordered = hasSideEffects(n);
+      if(!ordered && n->inputs().empty()) {
+        prologue.push_back(std::move(step));
+        continue;
+      }
+      std::vector<size_t> deps;
+      for(auto input : n->inputs()) {
+        auto it = producer.find(input);
+        if(it != producer.end())
+          deps.push_back(it->second);
+      }
+      std::sort(deps.begin(), deps.end());
+      deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+
+      size_t task;
+      if(!ordered && deps.size() == 1 && tasks[deps[0]].successors.empty() && !tasks[deps[0]].ordered) {
+        // extend the chain; it already comes after the last ordered task
+        task = deps[0];
+      } else {
+        if(last_ordered != kNoTask)
+          deps.push_back(last_ordered);
+        if(ordered)
+          deps.insert(deps.end(), since_ordered.begin(), since_ordered.end());
+        std::sort(deps.begin(), deps.end());
+        deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+        task = tasks.size();
+        tasks.emplace_back();
+        for(auto d : deps)
+          tasks[d].successors.push_back(task);
+        tasks[task].num_dependencies = deps.size();
+        if(deps.empty())
+          roots.push_back(task);
+        since_ordered.push_back(task);
+      }
+      if(ordered) {
+        tasks[task].ordered = true;
+        last_ordered = task;
+        since_ordered.clear();
+      }
+      tasks[task].steps.push_back(std::move(step));
+      for(auto output : n->outputs())
+        producer[output] = task;
+    }
+    for(auto output : graph->outputs()) {
+      auto slot = slotFor(output);
+      outputs.push_back(slot);
+      use_counts[slot]++;
+    }
+    num_values = slots.size();
+
+    // tasks are created in topological order
+    std::vector<size_t> level(tasks.size(), 0);
+    std::vector<size_t> level_size;
+    for(size_t t = 0; t < tasks.size(); t++) {
+      if(level[t] >= level_size.size())
+        level_size.resize(level[t] + 1, 0);
+      width_ = std::max(width_, ++level_size[level[t]]);
+      for(auto s : tasks[t].successors)
+        level[s] = std::max(level[s], level[t] + 1);
+    }
+  }
+
+  void run(Stack & stack) const;
+
+  size_t width() const {
+    return width_;
+  }
+
+private:
+  friend struct ParallelRun;
+
+  Operation getStepOperation(Node * n) {
+    if(n->blocks().empty() && n->kind() != prim::GraphExecutor)
+      return getOperation(n);
+    // run nodes with blocks (and nested executors) through the interpreter
+    auto g = std::make_shared<Graph>();
+    std::unordered_map<Value*, Value*> value_map;
+    for(auto input : n->inputs()) {
+      auto new_input = g->addInput()->setType(input->type());
+      value_map[input] = new_input;
+    }
+    auto clone = g->appendNode(g->createClone(n, [&](Value * v) { return value_map.at(v); }));
+    for(auto output : clone->outputs())
+      g->registerOutput(output);
+    Code code(g);
+    return [code](Stack & stack) {
+      InterpreterState(code).runOneStage(stack);
+      return 0;
+    };
+  }
+
+  std::shared_ptr<Graph> graph;
+  std::vector<Step> prologue;
+  std::vector<Task> tasks;
+  std::vector<size_t> roots;
+  size_t num_inputs;
+  size_t num_values;
+  std::vector<size_t> outputs;
+  // number of times each value is used, including as a graph output
+  std::vector<int> use_counts;
+  size_t width_ = 0;
+};
+
+// the state of one call to run, shared with the pool threads running its
+// tasks
+struct ParallelRun {
+  explicit ParallelRun(const ParallelCodeImpl & code)
+  : code(code)
+  , values(code.num_values)
+  , use_counts(new std::atomic<int>[code.num_values])
+  , pending(new std::atomic<size_t>[code.tasks.size()])
+  , remaining(code.tasks.size())
+  , grad_mode(autograd::GradMode::is_enabled()) {
+    for(size_t i = 0; i < code.num_values; i++)
+      use_counts[i].store(code.use_counts[i], std::memory_order_relaxed);
+    for(size_t t = 0; t < code.tasks.size(); t++)
+      pending[t].store(code.tasks[t].num_dependencies, std::memory_order_relaxed);
+  }
+
+  void runStep(const ParallelCodeImpl::Step & step, Stack & stack) {
+    for(auto i : step.inputs)
+      stack.push_back(values[i]);
+    if(isGraphProfilingEnabled()) {
+      ProfileNodeRange range(code.graph, step.node, stack);
+      step.op(stack);
+    } else {
+      step.op(stack);
+    }
+    JIT_ASSERT(stack.size() == step.outputs.size());
+    for(size_t i = 0; i < step.outputs.size(); i++) {
+      if(code.use_counts[step.outputs[i]] > 0)
+        values[step.outputs[i]] = std::move(stack[i]);
+    }
+    stack.clear();
+    for(auto i : step.inputs) {
+      if(use_counts[i].fetch_sub(1, std::memory_order_acq_rel) == 1)
+        values[i] = IValue();
+    }
+  }
+
+  void runPrologue() {
+    Stack stack;
+    for(auto & step : code.prologue)
+      runStep(step, stack);
+  }
+
+  // never throws, the first error is kept in error
+  void runTaskSteps(size_t t) {
+    if(failed.load(std::memory_order_relaxed))
+      return;
+    Stack stack;
+    const ParallelCodeImpl::Step * current = nullptr;
+    try {
+      for(auto & step : code.tasks[t].steps) {
+        current = &step;
+        runStep(step, stack);
+      }
+    } catch(std::exception & e) {
+      std::exception_ptr wrapped;
+      if(current && current->debug_location) {
+        try {
+          current->debug_location->wrapAndRethrowException(e, "operation failed in interpreter");
+        } catch(...) {
+          wrapped = std::current_exception();
+        }
+      } else {
+        wrapped = std::current_exception();
+      }
+      setError(wrapped);
+    } catch(...) {
+      setError(std::current_exception());
+    }
+  }
+
+  static void runTask(std::shared_ptr<ParallelRun> self, size_t t) {
+    autograd::AutoGradMode grad_mode_guard(self->grad_mode);
+    while(t != kNoTask) {
+      self->runTaskSteps(t);
+      size_t next = kNoTask;
+      for(auto s : self->code.tasks[t].successors) {
+        if(self->pending[s].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          if(next == kNoTask)
+            next = s;
+          else
+            interOpThreadPool().run([self, s] { runTask(self, s); });
+        }
+      }
+      self->finishTask();
+      t = next;
+    }
+  }
+
+  void runSequentially() {
+    for(size_t t = 0; t < code.tasks.size(); t++)
+      runTaskSteps(t);
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this] { return remaining.load() == 0; });
+  }
+
+  void rethrowIfFailed() {
+    if(error)
+      std::rethrow_exception(error);
+  }
+
+  const ParallelCodeImpl & code;
+  std::vector<IValue> values;
+private:
+  void setError(std::exception_ptr e) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if(!error)
+      error = std::move(e);
+    failed = true;
+  }
+  void finishTask() {
+    if(remaining.fetch_sub(1) == 1) {
+      std::lock_guard<std::mutex> lock(mutex);
+      done.notify_all();
+    }
+  }
+
+  std::unique_ptr<std::atomic<int>[]> use_counts;
+  std::unique_ptr<std::atomic<size_t>[]> pending;
+  std::atomic<size_t> remaining;
+  std::atomic<bool> failed {false};
+  std::exception_ptr error;
+  std::mutex mutex;
+  std::condition_variable done;
+  bool grad_mode;
+};
+
+void ParallelCodeImpl::run(Stack & stack) const {
+  JIT_ASSERT(stack.size() == num_inputs);
+  auto state = std::make_shared<ParallelRun>(*this);
+  for(size_t i = 0; i < num_inputs; i++)
+    state->values[i] = std::move(stack[i]);
+  stack.clear();
+  state->runPrologue();
+  // a pool thread waiting for the pool could deadlock it
+  if(in_inter_op_thread || width_ < 2) {
+    state->runSequentially();
+  } else if(!roots.empty()) {
+    for(size_t i = 1; i < roots.size(); i++) {
+      auto root = roots[i];
+      interOpThreadPool().run([state, root] { ParallelRun::runTask(state, root); });
+    }
+    ParallelRun::runTask(state, roots[0]);
+    state->wait();
+  }
+  state->rethrowIfFailed();
+  for(auto o : outputs)
+    stack.push_back(state->values[o]);
+}
+
+ParallelCode::ParallelCode(const std::shared_ptr<Graph>& graph)
+  : pImpl(std::make_shared<ParallelCodeImpl>(graph)) {}
+ParallelCode::~ParallelCode() {}
+
+size_t ParallelCode::width() const {
+  return pImpl->width();
+}
+
+void ParallelCode::run(Stack & stack) const {
+  pImpl->run(stack);
+}
+
+void setNumInterOpThreads(size_t num_threads) {
+  num_inter_op_threads = num_threads;
+}
+
+size_t getNumInterOpThreads() {
+  size_t n = num_inter_op_threads.load();
+  if(n == 0)
+    n = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  return n;
+}
+
+}}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace torch { namespace jit {
+
+// Runs independent nodes of a graph concurrently, on a pool of inter-op
+// threads shared by all graphs.
+//
+// The top-level nodes of the graph are grouped into tasks: a node whose
+// inputs all come from one task that nothing else depends on yet extends
+// that task, so that straight-line chains run as one task. Tasks depend on
+// the tasks that produce their inputs, and nodes with side effects (prints,
+// Python ops, in-place ops) are ordered with respect to everything before
+// and after them. Nodes without inputs (constants) run before any task.
+// A node with blocks runs as a whole, through its own Code.
+//
+// When a task finishes, the first task it makes ready continues on the same
+// thread and the others go to the pool. runs started from a pool thread
+// (e.g. by a nested GraphExecutor) execute the tasks in order on that thread
+// instead, so they never wait for the pool.
+//
+// The graph must consist of a single stage. Unlike Code, there is no memory
+// planning: lifetimes depend on the order tasks happen to run in.
+
+struct Graph;
+struct IValue;
+using Stack = std::vector<IValue>;
+struct ParallelCodeImpl;
+
+struct ParallelCode {
+  ParallelCode() {}
+  explicit ParallelCode(const std::shared_ptr<Graph>& graph);
+  ~ParallelCode();
+
+  // the largest number of tasks that can run at the same time, counted over
+  // the levels of the task graph. 1 means running in parallel doesn't help.
+  size_t width() const;
+  // stack holds the inputs of the graph on entry and its outputs on exit
+  void run(Stack & stack) const;
+
+  explicit operator bool() const {
+    return pImpl != nullptr;
+  }
+
+private:
+  std::shared_ptr<ParallelCodeImpl> pImpl;
+};
+
+// Number of threads of the inter-op pool. The pool is created with
+// std::thread::hardware_concurrency() threads the first time a graph runs,
+// unless this was set before. Setting it afterwards has no effect.
+void setNumInterOpThreads(size_t num_threads);
+size_t getNumInterOpThreads();
+
+}}
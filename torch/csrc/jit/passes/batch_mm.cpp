@@ -5,6 +5,7 @@
 #include "torch/csrc/utils/functional.h"
 
 #include <ATen/ATen.h>
+#include <ATen/optional.h>
 #include <algorithm>
 #include <unordered_map>
 
@@ -64,6 +65,30 @@ namespace torch { namespace jit {
 // topological order and labeling nodes with TreeTokens. Then, we look for roots of
 // the trees we formed and fuse them.
 
+// Note [Batching independent matmuls]
+// Models with parallel branches (e.g. the heads of multi-head attention or
+// mixture of experts) issue many small matrix multiplies of the same shape
+// that don't depend on each other. Each of them is too small to fill a GPU,
+// so we stack their operands and do a single bmm instead:
+//
+//   %y1 = mm(%a1, %b1)          %a = stack[dim=0](%a1, %a2)
+//   %y2 = mm(%a2, %b2)    ==>   %b = stack[dim=0](%b1, %b2)
+//                               %y = bmm(%a, %b)
+//                               %y1 = select[dim=0, index=0](%y)
+//                               %y2 = select[dim=0, index=1](%y)
+//
+// matmul of two matrices is the same as mm, and addmm nodes with the same
+// beta and alpha are turned into a baddbmm the same way.
+//
+// The batched nodes are inserted right before the last matmul of a group,
+// where all operands are already available. This is only valid if none of
+// the results is used before that point, which also guarantees that no
+// matmul of the group depends on another one, so that's the condition we check
+// when adding a matmul to a group.
+//
+// On the CPU the copies made by stack cost more than what we save, so only
+// CUDA matmuls are batched this way.
+
 // Tunable parameter. Set to something larger if it turns out to be better.
 static constexpr size_t min_fusion_size = 2;
 
@@ -139,6 +164,176 @@ struct TreeToken {
   }
 };
 
+// A mm, matmul of matrices or addmm (self is non-null) with complete types
+struct MatMulOperands {
+  Node *node = nullptr;
+  Value *self = nullptr;
+  Value *lhs = nullptr;
+  Value *rhs = nullptr;
+};
+
+static bool isCUDAMatrix(Value *v) {
+  auto type = v->type()->cast<TensorType>();
+  return type && type->sizes().size() == 2 && type->device() >= 0;
+}
+
+static at::optional<MatMulOperands> asBatchableMatMul(Node *node) {
+  MatMulOperands ops;
+  ops.node = node;
+  if (node->kind() == aten::mm || node->kind() == aten::matmul) {
+    if (node->inputs().size() != 2 || node->hasAttributes())
+      return at::nullopt;
+    ops.lhs = node->inputs()[0];
+    ops.rhs = node->inputs()[1];
+  } else if (node->kind() == aten::addmm) {
+    // only the form with constant beta and alpha attributes
+    if (node->inputs().size() != 3 || !node->hasAttribute(attr::beta) ||
+        !node->hasAttribute(attr::alpha) || node->numAttributes() != 2)
+      return at::nullopt;
+    ops.self = node->inputs()[0];
+    ops.lhs = node->inputs()[1];
+    ops.rhs = node->inputs()[2];
+    // baddbmm would broadcast self just like addmm does, but the stacked
+    // selfs have to match the batch
+    if (!isCUDAMatrix(ops.self) || !isCUDAMatrix(node->output()) ||
+        ops.self->type()->expect<TensorType>()->sizes() !=
+            node->output()->type()->expect<TensorType>()->sizes())
+      return at::nullopt;
+  } else {
+    return at::nullopt;
+  }
+  if (!isCUDAMatrix(ops.lhs) || !isCUDAMatrix(ops.rhs))
+    return at::nullopt;
+  return ops;
+}
+
+static bool canBatchTogether(const MatMulOperands& a, const MatMulOperands& b) {
+  if ((a.self == nullptr) != (b.self == nullptr))
+    return false;
+  auto same_type = [](Value *x, Value *y) {
+    auto tx = x->type()->expect<TensorType>();
+    auto ty = y->type()->expect<TensorType>();
+    return tx->sizes() == ty->sizes() && tx->scalarType() == ty->scalarType() &&
+           tx->device() == ty->device();
+  };
+  if (!same_type(a.lhs, b.lhs) || !same_type(a.rhs, b.rhs))
+    return false;
+  if (a.self) {
+    if (!same_type(a.self, b.self))
+      return false;
+    for (auto name : {attr::beta, attr::alpha}) {
+      if (at::Scalar(a.node->t(name)).toDouble() != at::Scalar(b.node->t(name)).toDouble())
+        return false;
+    }
+  }
+  return true;
+}
+
+struct MatMulGroup {
+  std::vector<MatMulOperands> members;
+  // position of the earliest use of any member's output, see
+  // Note [Batching independent matmuls]
+  size_t first_use;
+};
+
+static void batchMatMulGroup(const MatMulGroup& group) {
+  auto& members = group.members;
+  Node *last = members.back().node;
+  auto graph = last->owningGraph();
+  int64_t batch_size = members.size();
+
+  auto stack_inputs = [&](Value* MatMulOperands::*operand) -> Value* {
+    auto inputs = fmap(members, [&](const MatMulOperands& m) { return m.*operand; });
+    auto type = inputs[0]->type()->expect<TensorType>();
+    auto sizes = type->sizes();
+    sizes.insert(sizes.begin(), batch_size);
+    Node *stack = graph->create(aten::stack, inputs)
+                       ->i_(attr::dim, 0);
+    stack->insertBefore(last);
+    stack->output()->setType(type->withSizes(sizes));
+    return stack->output();
+  };
+
+  auto lhs_batch = stack_inputs(&MatMulOperands::lhs);
+  auto rhs_batch = stack_inputs(&MatMulOperands::rhs);
+  Node *batch_mm;
+  if (members[0].self) {
+    auto self_batch = stack_inputs(&MatMulOperands::self);
+    batch_mm = graph->create(aten::baddbmm, {self_batch, lhs_batch, rhs_batch})
+                    ->t_(attr::beta, members[0].node->t(attr::beta))
+                    ->t_(attr::alpha, members[0].node->t(attr::alpha));
+  } else {
+    batch_mm = graph->create(aten::bmm, {lhs_batch, rhs_batch});
+  }
+  auto type = last->output()->type()->expect<TensorType>();
+  auto sizes = type->sizes();
+  sizes.insert(sizes.begin(), batch_size);
+  batch_mm->output()->setType(type->withSizes(sizes));
+  batch_mm->insertBefore(last);
+
+  for (int64_t i = 0; i < batch_size; ++i) {
+    Node *select = graph->create(aten::select, {batch_mm->output()})
+                        ->i_(attr::dim, 0)
+                        ->i_(attr::index, i);
+    select->insertBefore(last);
+    select->output()->setType(members[i].node->output()->type());
+    members[i].node->output()->replaceAllUsesWith(select->output());
+  }
+  // NB: the original matmuls are removed by DCE
+}
+
+static void BatchIndependentMatMuls(Block* block) {
+  std::unordered_map<Node*, size_t> position;
+  for (auto node : block->nodes())
+    position.emplace(node, position.size());
+  // uses in nested blocks count at the node containing them, and uses
+  // as outputs of the block after all of its nodes
+  auto firstUse = [&](Value *v) {
+    size_t first = position.size();
+    for (auto & use : v->uses()) {
+      Node *user = use.user;
+      while (user->owningBlock() != block)
+        user = user->owningBlock()->owningNode();
+      if (user != block->return_node())
+        first = std::min(first, position.at(user));
+    }
+    return first;
+  };
+
+  std::vector<MatMulGroup> groups;
+  std::vector<size_t> open_groups; // indices into groups still accepting members
+  for (auto node : block->nodes()) {
+    auto ops = asBatchableMatMul(node);
+    if (!ops)
+      continue;
+    size_t pos = position.at(node);
+    bool added = false;
+    for (auto it = open_groups.begin(); it != open_groups.end(); ++it) {
+      auto & group = groups[*it];
+      if (!canBatchTogether(group.members[0], *ops))
+        continue;
+      if (group.first_use > pos) {
+        group.members.push_back(*ops);
+        group.first_use = std::min(group.first_use, firstUse(node->output()));
+        added = true;
+      } else {
+        // some result is already used, so this group can't grow anymore
+        open_groups.erase(it);
+      }
+      break;
+    }
+    if (!added) {
+      open_groups.push_back(groups.size());
+      groups.push_back(MatMulGroup{{*ops}, firstUse(node->output())});
+    }
+  }
+
+  for (auto & group : groups) {
+    if (group.members.size() >= min_fusion_size)
+      batchMatMulGroup(group);
+  }
+}
+
 void BatchMMBlock(Block* block) {
   enum class Side { LHS, RHS };
   auto graph = block->owningGraph();
@@ -203,6 +398,10 @@ void BatchMMBlock(Block* block) {
     // NB: don't bother with cleaning up after yourself. We'll use DCE for that.
   }
   EliminateDeadCode(block);
+
+  // See Note [Batching independent matmuls]
+  BatchIndependentMatMuls(block);
+  EliminateDeadCode(block);
 }
 
 void BatchMM(std::shared_ptr<Graph>& graph) {
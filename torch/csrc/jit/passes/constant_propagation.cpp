@@ -0,0 +1,114 @@
+#include "torch/csrc/jit/passes/constant_propagation.h"
+
+#include "torch/csrc/autograd/variable.h"
+#include "torch/csrc/jit/ivalue.h"
+#include "torch/csrc/jit/operator.h"
+
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace torch { namespace jit {
+
+namespace {
+
+const std::unordered_set<Symbol>& randomOps() {
+  static const std::unordered_set<Symbol> ops = [] {
+    std::unordered_set<Symbol> ops;
+    for(auto name : {"alpha_dropout", "bernoulli", "dropout", "feature_alpha_dropout",
+                     "feature_dropout", "multinomial", "normal", "poisson", "rand",
+                     "rand_like", "randint", "randint_like", "randn", "randn_like",
+                     "randperm", "rrelu", "rrelu_with_noise", "_standard_gamma"})
+      ops.insert(Symbol::aten(name));
+    return ops;
+  }();
+  return ops;
+}
+
+// ops that may return (a view of) one of their inputs
+const std::unordered_set<Symbol>& aliasingOps() {
+  static const std::unordered_set<Symbol> ops = [] {
+    std::unordered_set<Symbol> ops;
+    for(auto name : {"alias", "as_strided", "chunk", "contiguous", "detach", "diagonal",
+                     "expand", "expand_as", "narrow", "permute", "reshape", "reshape_as",
+                     "select", "slice", "split", "squeeze", "t", "to", "transpose",
+                     "type_as", "unfold", "unsqueeze", "view", "view_as"})
+      ops.insert(Symbol::aten(name));
+    return ops;
+  }();
+  return ops;
+}
+
+// conservatively includes the magic methods, e.g. __and__
+bool isInplace(Node * n) {
+  std::string name = n->kind().toUnqualString();
+  return name.back() == '_';
+}
+
+// a constant baked into the graph is shared by all its runs, so it must not
+// be mutated or returned, not even through a view
+bool canShareOutputs(Node * n) {
+  for(auto output : n->outputs()) {
+    for(auto use : output->uses()) {
+      Node * user = use.user;
+      if(!user->kind().is_aten() || isInplace(user) || aliasingOps().count(user->kind()) > 0)
+        return false;
+    }
+  }
+  return true;
+}
+
+bool isConstant(Value * v) {
+  return v->node()->kind() == prim::Constant;
+}
+
+void propagateConstants(Block * block) {
+  for(auto it = block->nodes().begin(); it != block->nodes().end();) {
+    Node * n = *it++;
+    for(auto b : n->blocks())
+      propagateConstants(b);
+    if(!isPureOp(n) || n->inputs().empty() ||
+       !std::all_of(n->inputs().begin(), n->inputs().end(), isConstant) ||
+       !canShareOutputs(n))
+      continue;
+    auto op = findOperatorFor(n);
+    if(!op)
+      continue;
+    Stack stack;
+    for(auto input : n->inputs())
+      stack.push_back(autograd::make_variable(input->node()->t(attr::value)));
+    try {
+      op->selectVariant(n)(stack);
+    } catch(const std::exception &) {
+      continue;
+    }
+    JIT_ASSERT(stack.size() == n->outputs().size());
+    bool all_tensors = std::all_of(stack.begin(), stack.end(), [](const IValue & v) {
+      return v.isTensor() && v.toTensor().defined();
+    });
+    if(!all_tensors)
+      continue;
+    for(size_t i = 0; i < stack.size(); ++i) {
+      auto value = autograd::Variable(std::move(stack[i]).toTensor()).data();
+      Node * constant = block->owningGraph()->createConstant(value);
+      constant->setStage(n->stage());
+      constant->insertBefore(n);
+      n->outputs()[i]->replaceAllUsesWith(constant->output());
+    }
+    n->destroy();
+  }
+}
+
+} // anonymous namespace
+
+bool isPureOp(Node * n) {
+  return n->kind().is_aten() && n->blocks().empty() && !isInplace(n) &&
+      randomOps().count(n->kind()) == 0;
+}
+
+void ConstantPropagation(std::shared_ptr<Graph>& graph) {
+  propagateConstants(graph->block());
+}
+
+}}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Whether n is an ATen op whose outputs only depend on its inputs and
+// attributes, and which has no other effect: not in-place, not random.
+bool isPureOp(Node * n);
+
+// Runs the pure ops whose inputs are all constants once, replacing their
+// outputs with constants. Ops whose outputs could be mutated or escape the
+// graph, and hence a constant shared by all runs with them, are left alone,
+// as are ops that fail on their constant inputs: they throw when the graph
+// runs, as they did before.
+void ConstantPropagation(std::shared_ptr<Graph>& graph);
+
+}}
@@ -1,6 +1,7 @@
 #include "torch/csrc/jit/passes/graph_fuser.h"
 #include "torch/csrc/jit/fusion_compiler.h"
 #include "torch/csrc/jit/autodiff.h"
+#include <algorithm>
 #include <unordered_map>
 
 #ifdef USE_CUDA
@@ -103,6 +104,37 @@ bool isSimpleMap(Node *node) {
   return true;
 }
 
+// sum or mean over the last dimension, e.g. the statistics of a layer norm
+// or the normalizer of a softmax. These can end a fusion group: the fused
+// kernel then iterates over rows, and accumulates the reduction while it
+// computes the pointwise ops producing its input.
+bool isLastDimReduction(Node * node) {
+  if(node->kind() != aten::sum && node->kind() != aten::mean)
+    return false;
+  if(node->inputs().size() != 1 || node->outputs().size() != 1)
+    return false;
+  // dtype overloads carry more attributes
+  if(node->attributeNames().size() != 2 ||
+     !node->hasAttribute(attr::dim) || !node->hasAttribute(attr::keepdim))
+    return false;
+  int64_t dim;
+  if(node->kindOf(attr::dim) == AttributeKind::is) {
+    if(node->is(attr::dim).size() != 1)
+      return false;
+    dim = node->is(attr::dim)[0];
+  } else if(node->kindOf(attr::dim) == AttributeKind::i) {
+    dim = node->i(attr::dim);
+  } else {
+    return false;
+  }
+  TensorType* type = node->input()->type()->cast<TensorType>();
+  if(!type || !node->output()->type()->cast<TensorType>())
+    return false;
+  // a 1-d input would reduce to a 0-dim output, which the fusion compiler
+  // can't index
+  int64_t ndim = type->sizes().size();
+  return ndim >= 2 && (dim == ndim - 1 || dim == -1);
+}
 
 struct GraphFuser {
   Block * block;
@@ -207,10 +239,29 @@ struct GraphFuser {
     // otherwise they cannot partipate in the same map
     if(node->kind() == aten::cat && allOutputsHaveSameSize(node))
       return true;
+    // reductions are exit nodes as well, see isLastDimReduction
+    if(node->owningBlock() == block && isLastDimReduction(node) && allSupportedIO(node))
+      return true;
 
     return false;
   }
 
+  bool containsKind(Node * group, NodeKind kind) {
+    for(auto n : getSubgraph(group).nodes()) {
+      if(n->kind() == kind)
+        return true;
+    }
+    return false;
+  }
+
+  // a reduction's output has the reduced sizes, so nothing in its group can
+  // read it (the map iterates over the unreduced sizes), which means the
+  // group can't be fused into its consumers
+  bool hasReduction(Node * node) {
+    return node->kind() == prim::FusionGroup &&
+      (containsKind(node, aten::sum) || containsKind(node, aten::mean));
+  }
+
   // necessary condition for fusion. If all of the uses of producer are consumer
   // then it is safe to merge producer into consumer, because it doesn't have any other uses
   // If there are other uses, but they occur _after_ consumer, then we can still merge in producer
@@ -244,7 +295,7 @@ struct GraphFuser {
     // we can move the consumer up into the producer.
     // but this requires better handling of merging fusion groups so it is not done now
     at::optional<int> consumer_device = getDevice(consumer);
-    return isFusable(producer->node()) &&
+    return isFusable(producer->node()) && !hasReduction(producer->node()) &&
       allUsersAreThisConsumerOrOccurAfterIt(consumer, producer) &&
       consumer_device && consumer_device == getDevice(producer->node()) &&
       (*consumer_device != kCPUDevice || sharedFusionCompiler().canCompileOnCPU());
@@ -531,6 +582,73 @@ struct GraphFuser {
     return std::make_pair(++consumer->reverseIterator(), false);
   }
 
+  // position of n, or of the node of this block that contains it
+  size_t topologicalIndexOf(Node * n) {
+    while(n->owningBlock() != block) {
+      n = n->owningBlock()->owningNode();
+      JIT_ASSERT(n);
+    }
+    return topological_index.at(n);
+  }
+
+  // Horizontal fusion: two fusion groups that don't depend on each other but
+  // map over the same sizes and read a common input, e.g. the mean and the
+  // mean of squares of a layer norm, can run as a single kernel that loads
+  // the shared input once. first occurs before second and its computation
+  // moves down into second, so every use of first's outputs has to occur
+  // after second.
+  bool canFuseSiblings(Node * first, Node * second) {
+    if(first->stage() != second->stage() || getDevice(first) != getDevice(second))
+      return false;
+    // concat outputs don't have the sizes of the map
+    if(containsKind(first, aten::cat) || containsKind(second, aten::cat))
+      return false;
+    if(first->inputs().size() == 0 || second->inputs().size() == 0)
+      return false;
+    auto first_type = first->inputs()[0]->type()->cast<TensorType>();
+    auto second_type = second->inputs()[0]->type()->cast<TensorType>();
+    if(!first_type || !second_type || first_type->sizes() != second_type->sizes())
+      return false;
+    auto second_inputs = second->inputs();
+    bool shares_input = std::any_of(first->inputs().begin(), first->inputs().end(), [&](Value * i) {
+      return std::find(second_inputs.begin(), second_inputs.end(), i) != second_inputs.end();
+    });
+    if(!shares_input)
+      return false;
+    for(auto o : first->outputs()) {
+      for(auto u : o->uses()) {
+        if(topologicalIndexOf(u.user) <= topological_index.at(second))
+          return false;
+      }
+    }
+    return true;
+  }
+
+  // returns whether any groups were merged
+  bool fuseSiblingGroups() {
+    bool any_changed = false;
+    bool changed = true;
+    while(changed) {
+      changed = false;
+      std::vector<Node*> groups;
+      for(auto n : block->nodes()) {
+        if(n->kind() == prim::FusionGroup)
+          groups.push_back(n);
+      }
+      for(size_t i = 0; i < groups.size() && !changed; ++i) {
+        for(size_t j = i + 1; j < groups.size(); ++j) {
+          if(canFuseSiblings(groups[i], groups[j])) {
+            auto stage_guard = block->owningGraph()->setStageTemporary(groups[j]->stage());
+            mergeFusionGroups(groups[j], groups[i]);
+            changed = any_changed = true;
+            break;
+          }
+        }
+      }
+    }
+    return any_changed;
+  }
+
   void run() {
     for(auto p : block->inputs()) {
       topological_index[p->node()] = 0;
@@ -565,6 +683,8 @@ struct GraphFuser {
         std::tie(it, changed) = scanNode(*it);
         any_changed |= changed;
       }
+      // merged siblings can expose new producer-consumer fusions
+      any_changed |= fuseSiblingGroups();
     }
     for (Node * node : block->nodes()) {
       for (Block * sub_block : node->blocks()) {
@@ -0,0 +1,53 @@
+#include "torch/csrc/jit/passes/inplace_ops.h"
+
+#include "torch/csrc/jit/operator.h"
+
+namespace torch { namespace jit {
+
+namespace {
+
+// whether n allocates its single output
+bool producesFreshTensor(Node * n) {
+  if(n->kind() == prim::FusionGroup)
+    return true;
+  if(n->outputs().size() != 1)
+    return false;
+  auto op = findOperatorFor(n);
+  return op && op->hasOutVariant();
+}
+
+bool canRunInplace(Node * n) {
+  if(n->inputs().empty() || n->outputs().size() != 1)
+    return false;
+  Value * input = n->input(0);
+  Value * output = n->output();
+  auto input_type = input->type()->cast<TensorType>();
+  auto output_type = output->type()->cast<TensorType>();
+  if(!input_type || !output_type || !(*input_type == *output_type))
+    return false;
+  if(input->uses().size() != 1 || input->node()->owningBlock() != n->owningBlock())
+    return false;
+  if(!producesFreshTensor(input->node()))
+    return false;
+  auto op = findOperatorFor(n);
+  return op && op->hasInplaceVariant();
+}
+
+void findInplaceNodes(Block * block, std::unordered_set<Node*>& nodes) {
+  for(auto n : block->nodes()) {
+    for(auto b : n->blocks())
+      findInplaceNodes(b, nodes);
+    if(canRunInplace(n))
+      nodes.insert(n);
+  }
+}
+
+} // anonymous namespace
+
+std::unordered_set<Node*> FindInplaceNodes(Graph& graph) {
+  std::unordered_set<Node*> nodes;
+  findInplaceNodes(graph.block(), nodes);
+  return nodes;
+}
+
+}}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+#include <unordered_set>
+
+namespace torch { namespace jit {
+
+// Finds the nodes that can run their operator's in-place variant (relu_ for
+// relu) instead of allocating their output, because their first input dies
+// there and nothing else can observe it being overwritten: the input is used
+// only by the node (so it is neither a graph output nor aliased by a view),
+// it is the result of an operator with an out= variant or of a FusionGroup
+// in the same block (so it is not a graph input, a view, or a value carried
+// around a loop), and it has the same complete type as the output.
+//
+// The IR doesn't say which tensors require grad, so this is only valid for
+// graphs that run without autograd, as the interpreter runs planned graphs
+// (see Code).
+std::unordered_set<Node*> FindInplaceNodes(Graph& graph);
+
+}}
@@ -0,0 +1,68 @@
+#include "torch/csrc/jit/passes/loop_invariant_code_motion.h"
+
+#include "torch/csrc/jit/passes/constant_propagation.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace torch { namespace jit {
+
+namespace {
+
+// whether n may write memory an op of the loop reads
+bool hasSideEffects(Node * n) {
+  if(n->kind() == prim::Print || n->kind() == prim::PythonOp || n->kind() == prim::Eval)
+    return true;
+  // in-place ops, and conservatively the magic methods, e.g. __and__
+  if(n->kind().is_aten() && std::string(n->kind().toUnqualString()).back() == '_')
+    return true;
+  return std::any_of(n->blocks().begin(), n->blocks().end(), [](Block * b) {
+    return std::any_of(b->nodes().begin(), b->nodes().end(),
+                       [](Node * n) { return hasSideEffects(n); });
+  });
+}
+
+bool isDefinedIn(Value * v, Block * block) {
+  for(Block * b = v->node()->owningBlock(); b; b = b->owningNode() ? b->owningNode()->owningBlock() : nullptr) {
+    if(b == block)
+      return true;
+  }
+  return false;
+}
+
+void hoistInvariants(Node * loop) {
+  Block * body = loop->blocks().at(0);
+  if(std::any_of(body->nodes().begin(), body->nodes().end(),
+                 [](Node * n) { return hasSideEffects(n); }))
+    return;
+  // nodes are visited in order, so the inputs of a node that only depends
+  // on hoisted nodes are already outside when it is reached
+  std::vector<Node*> nodes(body->nodes().begin(), body->nodes().end());
+  for(auto n : nodes) {
+    if(n->kind() != prim::Constant && !isPureOp(n))
+      continue;
+    bool invariant = std::none_of(n->inputs().begin(), n->inputs().end(), [&](Value * v) {
+      return isDefinedIn(v, body);
+    });
+    if(invariant)
+      n->moveBefore(loop);
+  }
+}
+
+void hoistInvariants(Block * block) {
+  for(auto n : block->nodes()) {
+    for(auto b : n->blocks())
+      hoistInvariants(b);
+    if(n->kind() == prim::Loop)
+      hoistInvariants(n);
+  }
+}
+
+} // anonymous namespace
+
+void LoopInvariantCodeMotion(std::shared_ptr<Graph>& graph) {
+  hoistInvariants(graph->block());
+}
+
+}}
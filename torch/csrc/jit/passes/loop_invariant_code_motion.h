@@ -0,0 +1,15 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Moves the pure ops (see isPureOp) of prim::Loop bodies whose inputs are
+// all defined outside the loop before it, so that they run once instead of
+// on every iteration. Inner loops are handled first, so values invariant in
+// a whole nest of loops leave all of it. Loops whose bodies contain an op
+// that may have side effects, e.g. an in-place op that could mutate one of
+// those inputs, are left alone.
+void LoopInvariantCodeMotion(std::shared_ptr<Graph>& graph);
+
+}}
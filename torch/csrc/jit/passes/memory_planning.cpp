@@ -0,0 +1,130 @@
+#include "torch/csrc/jit/passes/memory_planning.h"
+
+#include "torch/csrc/jit/operator.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace torch { namespace jit {
+
+constexpr size_t MemoryPlan::kAlignment;
+
+namespace {
+
+bool hasOutVariant(Node * n) {
+  auto op = findOperatorFor(n);
+  return op && op->hasOutVariant();
+}
+
+// a use that can neither return an alias of the value nor hold on to it
+// after it ran
+bool isPlannableUse(const Use & u) {
+  auto kind = u.user->kind();
+  return kind == prim::Drop || kind == prim::FusionGroup || hasOutVariant(u.user);
+}
+
+// the node of block containing n
+Node * enclosingNodeIn(Block * block, Node * n) {
+  while(n->owningBlock() != block) {
+    n = n->owningBlock()->owningNode();
+    JIT_ASSERT(n);
+  }
+  return n;
+}
+
+struct Candidate {
+  Value * value;
+  size_t arena;
+  size_t size; // bytes, rounded up to kAlignment
+  // live from the node that defines the value up to its last use,
+  // inclusive, as positions in the top-level block
+  size_t begin;
+  size_t end;
+  size_t offset;
+};
+
+size_t plannedSize(Value * v) {
+  auto type = v->type()->cast<TensorType>();
+  if(!type || !(*type == *type->contiguous()))
+    return 0;
+  size_t numel = 1;
+  for(auto s : type->sizes())
+    numel *= s;
+  size_t size = numel * at::elementSize(type->scalarType());
+  return (size + MemoryPlan::kAlignment - 1) / MemoryPlan::kAlignment * MemoryPlan::kAlignment;
+}
+
+} // anonymous namespace
+
+MemoryPlan PlanMemory(Graph & graph) {
+  MemoryPlan plan;
+  Block * block = graph.block();
+  std::unordered_map<Node*, size_t> position;
+  for(auto n : block->nodes())
+    position.emplace(n, position.size());
+
+  std::vector<Candidate> candidates;
+  std::unordered_map<int, size_t> arena_for_device;
+  for(auto n : block->nodes()) {
+    if(n->outputs().size() != 1 || !hasOutVariant(n))
+      continue;
+    Value * v = n->output();
+    size_t size = plannedSize(v);
+    if(size == 0 || v->uses().empty())
+      continue;
+    bool plannable = true;
+    size_t end = position.at(n);
+    for(auto & u : v->uses()) {
+      if(u.user == block->return_node() || !isPlannableUse(u)) {
+        plannable = false;
+        break;
+      }
+      end = std::max(end, position.at(enclosingNodeIn(block, u.user)));
+    }
+    if(!plannable)
+      continue;
+    int device = v->type()->expect<TensorType>()->device();
+    auto it = arena_for_device.find(device);
+    if(it == arena_for_device.end()) {
+      it = arena_for_device.emplace(device, plan.arenas.size()).first;
+      plan.arenas.push_back(MemoryPlan::Arena{device, 0});
+    }
+    candidates.push_back(Candidate{v, it->second, size, position.at(n), end, 0});
+  }
+
+  // Greedy by size: place the largest values first, each at the lowest
+  // offset that doesn't overlap a placed value with an overlapping lifetime.
+  std::vector<Candidate*> order;
+  for(auto & c : candidates)
+    order.push_back(&c);
+  std::stable_sort(order.begin(), order.end(), [](Candidate * a, Candidate * b) {
+    return a->size > b->size;
+  });
+  std::vector<Candidate*> placed;
+  for(auto c : order) {
+    std::vector<Candidate*> conflicts;
+    for(auto p : placed) {
+      if(p->arena == c->arena && p->begin <= c->end && c->begin <= p->end)
+        conflicts.push_back(p);
+    }
+    std::sort(conflicts.begin(), conflicts.end(), [](Candidate * a, Candidate * b) {
+      return a->offset < b->offset;
+    });
+    size_t offset = 0;
+    for(auto p : conflicts) {
+      if(offset + c->size <= p->offset)
+        break;
+      offset = std::max(offset, p->offset + p->size);
+    }
+    c->offset = offset;
+    auto & arena = plan.arenas[c->arena];
+    arena.size = std::max(arena.size, offset + c->size);
+    placed.push_back(c);
+  }
+
+  for(auto & c : candidates)
+    plan.values.push_back(MemoryPlan::PlannedValue{c.value, c.arena, c.offset});
+  return plan;
+}
+
+}}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "torch/csrc/jit/ir.h"
+
+namespace torch { namespace jit {
+
+// Static memory planning for graphs whose shapes are fully known, e.g.
+// after PropagateInputShapes with a complete ArgumentSpec.
+//
+// An intermediate is planned when it is produced by a node in the top-level
+// block whose operator has an out= variant, its type is a contiguous
+// TensorType of known size, and every use is by a node that neither aliases
+// nor keeps it (another out= capable op, a FusionGroup or a Drop). Planned
+// values are assigned offsets in one arena per device, and values whose
+// lifetimes don't overlap share memory. The interpreter preallocates the
+// arenas once and runs planned nodes with their out= variant, so that
+// steady-state runs don't allocate these intermediates.
+struct MemoryPlan {
+  struct Arena {
+    int device; // -1 for CPU
+    size_t size; // in bytes
+  };
+  struct PlannedValue {
+    Value* value;
+    size_t arena; // index into arenas
+    size_t offset; // in bytes, aligned to kAlignment
+  };
+  static constexpr size_t kAlignment = 64;
+
+  std::vector<Arena> arenas;
+  std::vector<PlannedValue> values;
+};
+
+MemoryPlan PlanMemory(Graph& graph);
+
+}}
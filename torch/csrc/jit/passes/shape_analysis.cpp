@@ -114,8 +114,8 @@ void PropagateShapeOnNode(Node * node, bool insert_expands) {
     case prim::If: {
       auto then_block = node->blocks().at(0);
       auto else_block = node->blocks().at(1);
-      PropagateShapeOnBlock(then_block);
-      PropagateShapeOnBlock(else_block);
+      PropagateShapeOnBlock(then_block, insert_expands);
+      PropagateShapeOnBlock(else_block, insert_expands);
       mergeTypes(then_block->outputs(), else_block->outputs(), node->outputs());
       return;
     }
@@ -138,7 +138,7 @@ void PropagateShapeOnNode(Node * node, bool insert_expands) {
       } while(mergeTypes(loop_carried_block, loop_carried_outputs, loop_carried_block));
 
       // now that the types are stable, we can insert the expands
-      PropagateShapeOnBlock(body_block, /*insert_expands=*/true);
+      PropagateShapeOnBlock(body_block, insert_expands);
 
 
       for(size_t i = 0; i < loop_carried_inputs.size(); ++i) {
@@ -394,12 +394,12 @@ void PropagateShapeOnBlock(Block * block, bool insert_expands) {
 }
 
 }
-void PropagateInputShapes(Graph & graph, const ArgumentSpec & spec) {
+void PropagateInputShapes(Graph & graph, const ArgumentSpec & spec, bool insert_expands) {
   JIT_ASSERT(graph.inputs().size() == spec.size());
   for(size_t i = 0; i < spec.size(); ++i) {
     graph.inputs()[i]->setType(spec.tensorInfo(i));
   }
-  PropagateShapeOnBlock(graph.block());
+  PropagateShapeOnBlock(graph.block(), insert_expands);
 }
 
 }}
@@ -3,6 +3,9 @@
 namespace torch { namespace jit {
 struct Graph;
 struct ArgumentSpec;
-void PropagateInputShapes(Graph & graph, const ArgumentSpec & spec);
+// insert_expands=false leaves broadcasting implicit instead of adding expand
+// nodes with the concrete sizes in spec, for graphs that have to stay valid
+// when sizes change
+void PropagateInputShapes(Graph & graph, const ArgumentSpec & spec, bool insert_expands = true);
 
 }}
@@ -13,6 +13,7 @@
 
 
 #include <iostream>
+#include <fstream>
 #include <sstream>
 
 namespace torch { namespace jit {
@@ -168,6 +169,27 @@ void initPythonIRBindings(PyObject * module_) {
        py::arg("onnx_opset_version")=0,
        py::arg("defer_weight_export")=false,
        py::arg("operator_export_type")=::torch::onnx::OperatorExportTypes::ONNX)
+    .def("export_to_file", [](const std::shared_ptr<Graph> g, const std::vector<at::Tensor>& initializers,
+                      const std::string& path, int64_t onnx_opset_version, bool defer_weight_export,
+                      ::torch::onnx::OperatorExportTypes operator_export_type,
+                      const std::string& external_data_dir) {
+      // Unlike export, neither the ModelProto nor the deferred weights are
+      // copied into Python objects
+      std::ofstream out(path, std::ios::binary);
+      if (!out) {
+        throw std::runtime_error("Cannot open " + path + " for writing");
+      }
+      auto export_map = ExportGraph(
+        g, initializers, onnx_opset_version, defer_weight_export, operator_export_type, out);
+      if (defer_weight_export) {
+        ExportRawData(export_map, external_data_dir);
+      }
+    }, py::arg("initializers"),
+       py::arg("path"),
+       py::arg("onnx_opset_version")=0,
+       py::arg("defer_weight_export")=false,
+       py::arg("operator_export_type")=::torch::onnx::OperatorExportTypes::ONNX,
+       py::arg("external_data_dir")="")
     .def("prettyPrintExport", [](const std::shared_ptr<Graph> g, const std::vector<at::Tensor>& initializers,
                       int64_t onnx_opset_version, bool defer_weight_export,
                       ::torch::onnx::OperatorExportTypes operator_export_type) {
@@ -282,7 +304,10 @@ void initPythonIRBindings(PyObject * module_) {
 
   #undef VS
 
-  py::class_<Block, std::unique_ptr<Block, py::nodelete>>(m, "Block");
+  py::class_<Block, std::unique_ptr<Block, py::nodelete>>(m, "Block")
+    .def("nodes",[](Block &b) {
+      return py::make_iterator(b.nodes().begin(), b.nodes().end());
+    });
 
   #define NS(name) \
     def(#name,&Node :: name)
@@ -131,6 +131,11 @@ void initPythonTracerBindings(PyObject* module_) {
   m.def("_is_tracing", [](const variable_list& vars) {
     return isTracingVar(vars);
   });
+  m.def("_tracer_set_source_locations", [](bool enabled) {
+    bool prev = recordsSourceLocations();
+    setRecordsSourceLocations(enabled);
+    return prev;
+  });
 }
 
 }}} // namespace torch::jit::tracing
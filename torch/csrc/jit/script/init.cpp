@@ -4,6 +4,8 @@
 #include "torch/csrc/Dtype.h"
 #include "torch/csrc/Layout.h"
 #include "torch/csrc/jit/script/compiler.h"
+#include "torch/csrc/jit/export.h"
+#include "torch/csrc/jit/import.h"
 #include "torch/csrc/jit/tensor_conversions.h"
 #include "torch/csrc/jit/python_tracer.h"
 #include "torch/csrc/jit/pybind_utils.h"
@@ -501,6 +503,15 @@ void initJitScriptBindings(PyObject* module) {
     .def("params", &Method::params)
     .def("graph_for", [](Method& self, py::args args) {
       return self.graph_for(createVariableTensorList(args));
+    })
+    .def("compile_for", [](Method& self, py::args args) {
+      self.compile_for(createVariableTensorList(args));
+    })
+    .def("export_plans", [](Method& self) {
+      return py::bytes(ExportExecutionPlans(self.export_plans()));
+    })
+    .def("import_plans", [](Method& self, const std::string& serialized) {
+      self.import_plans(ImportExecutionPlans(serialized));
     });
 
   m.def("_jit_script_compile", [](Def def, ResolutionCallback rcb) {
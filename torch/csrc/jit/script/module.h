@@ -62,6 +62,19 @@ struct Method {
   std::shared_ptr<Graph> graph_for(const variable_tensor_list& inputs) {
     return get_executor().graphFor(inputs);
   }
+  // see GraphExecutor::compileFor, exportPlans and importPlans
+  void compile_for(variable_tensor_list && inputs) {
+    for(auto tp : member_inputs) {
+      inputs.push_back(*tp);
+    }
+    get_executor().compileFor(inputs);
+  }
+  std::vector<std::shared_ptr<Graph>> export_plans() {
+    return get_executor().exportPlans();
+  }
+  void import_plans(const std::vector<std::shared_ptr<Graph>>& plans) {
+    get_executor().importPlans(plans);
+  }
   std::shared_ptr<Graph> graph() const {
     return graph_;
   }
@@ -15,6 +15,7 @@
 #include "torch/csrc/jit/attributes.h"
 #include "torch/csrc/jit/interned_strings.h"
 #include "torch/csrc/jit/interpreter.h"
+#include "torch/csrc/jit/parallel_interpreter.h"
 #include "torch/csrc/jit/symbolic_variable.h"
 #include "torch/csrc/jit/autodiff.h"
 #include "torch/csrc/jit/tracer.h"
@@ -25,6 +26,10 @@
 #include "torch/csrc/jit/passes/shape_analysis.h"
 #include "torch/csrc/jit/passes/dead_code_elimination.h"
 #include "torch/csrc/jit/passes/lower_grad_of.h"
+#include "torch/csrc/jit/passes/batch_mm.h"
+#include "torch/csrc/jit/passes/graph_fuser.h"
+#include "torch/csrc/jit/passes/memory_planning.h"
+#include "torch/csrc/jit/passes/inplace_ops.h"
 #include "torch/csrc/variable_tensor_functions.h"
 
 #include "torch/csrc/assertions.h"
@@ -34,6 +39,9 @@
 #include "torch/csrc/jit/passes/shape_analysis.h"
 
 #include "torch/csrc/jit/graph_executor.h"
+#include "torch/csrc/jit/graph_profiler.h"
+#include "torch/csrc/jit/export.h"
+#include "torch/csrc/jit/import.h"
 #include "torch/csrc/jit/script/compiler.h"
 #include "torch/csrc/jit/script/module.h"
 #include "torch/csrc/jit/ivalue.h"
@@ -44,9 +52,12 @@
 #include <ATen/ATen.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cstddef>
+#include <cstdlib>
 #include <functional>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <stdexcept>
 #include <string>
@@ -55,6 +66,10 @@
 #include <utility>
 #include <vector>
 
+#ifndef _WIN32
+#include <dirent.h>
+#endif
+
 namespace torch { namespace jit {
 
 using Var = SymbolicVariable;
@@ -249,6 +264,104 @@ static void fusionTests() {
   testConcat(2);
 }
 
+// the fuser is not supported on Windows
+#ifndef _WIN32
+static void cpuFusionTests() {
+  FusionCompiler comp;
+  if(!comp.canCompileOnCPU())
+    return;
+
+  // Sizes that span several parallel chunks, with a partial last chunk,
+  // for both the contiguous fast path and the strided path.
+  auto testOne = [&](bool transpose_input) {
+    Graph graph;
+    Var i0 = Var::asNewInput(graph);
+    Var i1 = Var::asNewInput(graph);
+    auto o0 = i0.sigmoid() * i1 + i1.tanh();
+    o0.addAsOutput();
+
+    auto a = at::rand({301, 257}, at::kCPU);
+    auto b = transpose_input ?
+      at::rand({257, 301}, at::kCPU).transpose(0, 1) :
+      at::rand({301, 257}, at::kCPU);
+    auto o = at::zeros({301, 257}, at::kCPU);
+    comp.debugLaunchGraph(graph, kCPUDevice, {a, b}, {o});
+    auto o_r = a.sigmoid() * b + b.tanh();
+    float max_diff = (o_r - o).abs().max().toCDouble();
+    REQUIRE(max_diff < 1e-6);
+  };
+  testOne(false);
+  testOne(true);
+
+  // Reductions over the last dimension next to a pointwise output.
+  auto testReduction = [&](bool transpose_input) {
+    Graph graph;
+    Var i0 = Var::asNewInput(graph);
+    Var i1 = Var::asNewInput(graph);
+    auto p = i0 * i1.sigmoid();
+    p.addAsOutput();
+    Node * sum = graph.appendNode(graph.create(aten::sum, {p}));
+    sum->is_(attr::dim, {1});
+    sum->i_(attr::keepdim, 0);
+    graph.registerOutput(sum->output());
+    Node * mean = graph.appendNode(graph.create(aten::mean, {i0}));
+    mean->i_(attr::dim, 1);
+    mean->i_(attr::keepdim, 1);
+    graph.registerOutput(mean->output());
+
+    auto a = at::rand({301, 257}, at::kCPU);
+    auto b = transpose_input ?
+      at::rand({257, 301}, at::kCPU).transpose(0, 1) :
+      at::rand({301, 257}, at::kCPU);
+    std::vector<at::Tensor> outputs = {
+      at::zeros({301, 257}, at::kCPU), at::zeros({301}, at::kCPU), at::zeros({301, 1}, at::kCPU)};
+    comp.debugLaunchGraph(graph, kCPUDevice, {a, b}, outputs);
+    auto p_r = a * b.sigmoid();
+    REQUIRE(outputs[1].sizes().equals({301}));
+    REQUIRE(outputs[2].sizes().equals({301, 1}));
+    REQUIRE((p_r - outputs[0]).abs().max().toCDouble() < 1e-6);
+    REQUIRE((p_r.sum(1) - outputs[1]).abs().max().toCDouble() < 1e-4);
+    REQUIRE((a.mean(1, true) - outputs[2]).abs().max().toCDouble() < 1e-6);
+  };
+  testReduction(false);
+  testReduction(true);
+
+  // A second compiler pointed at the same cache directory loads the kernel
+  // the first one built instead of compiling it again.
+  char cache_dir[] = "/tmp/pytorch_fuser_cacheXXXXXX";
+  REQUIRE(mkdtemp(cache_dir) != nullptr);
+  setenv("PYTORCH_FUSION_CACHE_DIR", cache_dir, 1);
+  auto testCached = [&] {
+    FusionCompiler cached_comp;
+    Graph graph;
+    Var i0 = Var::asNewInput(graph);
+    Var i1 = Var::asNewInput(graph);
+    auto o0 = i0 * i1.sigmoid();
+    o0.addAsOutput();
+    auto a = at::rand({3, 4}, at::kCPU);
+    auto b = at::rand({3, 4}, at::kCPU);
+    auto o = at::zeros({3, 4}, at::kCPU);
+    cached_comp.debugLaunchGraph(graph, kCPUDevice, {a, b}, {o});
+    float max_diff = (a * b.sigmoid() - o).abs().max().toCDouble();
+    REQUIRE(max_diff < 1e-6);
+  };
+  testCached();
+  size_t entries = 0;
+  if(DIR * dir = opendir(cache_dir)) {
+    while(struct dirent * e = readdir(dir))
+      entries += e->d_name[0] != '.';
+    closedir(dir);
+  }
+  REQUIRE(entries == 2); // one .key and one .so
+  testCached();
+  unsetenv("PYTORCH_FUSION_CACHE_DIR");
+  std::string cleanup = std::string("rm -rf ") + cache_dir;
+  REQUIRE(system(cleanup.c_str()) == 0);
+}
+#else
+static void cpuFusionTests() {}
+#endif
+
 struct Attr : public Attributes<Attr> {
 };
 void attributesTest() {
@@ -550,9 +663,15 @@ std::shared_ptr<Graph> trace(const ADTestSpec& test, const variable_list& vars_i
 }
 
 variable_list grad(const variable_list& outputs, const variable_list& inputs, const variable_list& grad_outputs) {
-  static const auto get_edge = [](const Variable& v) { return v.gradient_edge(); };
+  static const auto get_edges = [](const variable_list& vars) {
+    edge_list edges;
+    for (auto & v : vars) {
+      edges.push_back(v.gradient_edge());
+    }
+    return edges;
+  };
   auto & engine = torch::autograd::Engine::get_default_engine();
-  return engine.execute(fmap(outputs, get_edge), grad_outputs, true, false, fmap(inputs, get_edge));
+  return engine.execute(get_edges(outputs), grad_outputs, true, false, get_edges(inputs));
 }
 
 void assertAllClose(const tensor_list& a, const tensor_list& b) {
@@ -805,6 +924,134 @@ void shapeAnalysisTest() {
 
 }
 
+void memoryPlanningTest() {
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  auto g = std::make_shared<Graph>();
+  Var a = g->addInput();
+  Var b = g->addInput();
+  auto t1 = a*b;
+  auto t2 = t1.sigmoid();
+  auto t3 = t2.tanh();
+  (t3 + a).addAsOutput();
+
+  auto ta = at::randn({4, 5});
+  auto tb = at::randn({4, 5});
+  PropagateInputShapes(*g, ArgumentSpec(false, createVarList({v(ta), v(tb)})));
+  auto plan = PlanMemory(*g);
+  // the output escapes, t1 and t3 are never live at the same time
+  REQUIRE(plan.values.size() == 3);
+  REQUIRE(plan.arenas.size() == 1);
+  // 4*5 floats round up to two alignment units each
+  REQUIRE(plan.arenas[0].size == 2 * (2 * MemoryPlan::kAlignment));
+  REQUIRE(plan.values[0].value == t1.value());
+  REQUIRE(plan.values[2].value == t3.value());
+  REQUIRE(plan.values[0].offset == plan.values[2].offset);
+  // t1, t2 and t3 die at their only use, the graph inputs don't
+  auto inplace = FindInplaceNodes(*g);
+  REQUIRE(inplace.size() == 3);
+  REQUIRE(inplace.count(t1.value()->node()) == 0);
+  REQUIRE(inplace.count(t2.value()->node()) == 1);
+
+  auto expected = (ta*tb).sigmoid().tanh() + ta;
+  Code code(g, /*plan_memory=*/true);
+  for(int i = 0; i < 2; ++i) {
+    // the second run reuses the arena of the first
+    InterpreterState interp(code);
+    std::vector<at::Tensor> outputs;
+    runOneStage(interp, {v(ta), v(tb)}, outputs);
+    REQUIRE(almostEqual(Variable(outputs[0]).data(), expected));
+  }
+}
+
+// the fuser is not supported on Windows
+#ifndef _WIN32
+void graphFuserReductionTest() {
+  if(!sharedFusionCompiler().canCompileOnCPU())
+    return;
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  auto g = std::make_shared<Graph>();
+  Var x = g->addInput();
+  Var y = g->addInput();
+  auto sumLastDim = [&](Var input, int64_t keepdim) {
+    Node * n = g->appendNode(g->create(aten::sum, {input}));
+    n->is_(attr::dim, {1});
+    n->i_(attr::keepdim, keepdim);
+    return Var(n->output());
+  };
+  auto p = x * y;
+  sumLastDim(p, 0).addAsOutput();
+  // reads x as well, so it is fused horizontally with the group above
+  sumLastDim(x.sigmoid(), 1).addAsOutput();
+  // the reduction's group can't be fused into this one, but p is an
+  // output of it
+  p.sigmoid().addAsOutput();
+
+  auto tx = at::randn({4, 37});
+  auto ty = at::randn({4, 37});
+  PropagateInputShapes(*g, ArgumentSpec(false, createVarList({v(tx), v(ty)})));
+  FuseGraph(g);
+  g->lint();
+  size_t num_groups = 0, num_sums = 0;
+  for(auto n : g->nodes()) {
+    num_groups += n->kind() == prim::FusionGroup;
+    num_sums += n->kind() == aten::sum;
+  }
+  REQUIRE(num_groups == 1);
+  REQUIRE(num_sums == 0);
+
+  Code code(g);
+  InterpreterState interp(code);
+  std::vector<at::Tensor> outputs;
+  runOneStage(interp, {v(tx), v(ty)}, outputs);
+  REQUIRE(almostEqual(Variable(outputs[0]).data(), (tx * ty).sum(1)));
+  REQUIRE(almostEqual(Variable(outputs[1]).data(), tx.sigmoid().sum(1, true)));
+  REQUIRE(almostEqual(Variable(outputs[2]).data(), (tx * ty).sigmoid()));
+}
+#else
+void graphFuserReductionTest() {}
+#endif
+
+void batchIndependentMatMulTest() {
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  auto g = std::make_shared<Graph>();
+  Var x = g->addInput();
+  std::vector<Var> w;
+  for(int i = 0; i < 4; ++i)
+    w.push_back(g->addInput());
+  // three independent heads are batched, the mm depending on the first one isn't
+  std::vector<Var> heads;
+  for(int i = 0; i < 3; ++i)
+    heads.push_back(x.mm(w[i]));
+  auto dependent = heads[0].mm(w[3]);
+  for(auto & h : heads)
+    h.tanh().addAsOutput();
+  dependent.addAsOutput();
+
+  at::Tensor tx = at::randn({4, 8}, at::kCUDA);
+  std::vector<at::Tensor> inputs = {v(tx)};
+  for(int i = 0; i < 4; ++i)
+    inputs.push_back(v(at::randn({8, 8}, at::kCUDA)));
+  PropagateInputShapes(*g, ArgumentSpec(false, variable_tensor_list(std::vector<at::Tensor>(inputs))));
+  BatchMM(g);
+  g->lint();
+  size_t num_bmm = 0, num_mm = 0;
+  for(auto n : g->nodes()) {
+    num_bmm += n->kind() == aten::bmm;
+    num_mm += n->kind() == aten::mm;
+  }
+  REQUIRE(num_bmm == 1);
+  REQUIRE(num_mm == 1);
+
+  Code code(g);
+  InterpreterState interp(code);
+  std::vector<at::Tensor> outputs;
+  runOneStage(interp, inputs, outputs);
+  for(int i = 0; i < 3; ++i)
+    REQUIRE(almostEqual(Variable(outputs[i]).data(), tx.mm(Variable(inputs[i + 1]).data()).tanh()));
+  REQUIRE(almostEqual(Variable(outputs[3]).data(),
+                      tx.mm(Variable(inputs[1]).data()).mm(Variable(inputs[4]).data())));
+}
+
 void testGraphExecutor() {
   constexpr int batch_size = 4;
   constexpr int input_size = 256;
@@ -829,6 +1076,212 @@ void testGraphExecutor() {
   REQUIRE(almostEqual(Variable(outputs[1]).data(), r1));
 }
 
+void testGraphExecutorPlanCache() {
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  auto build = []() {
+    auto g = std::make_shared<Graph>();
+    Var a = g->addInput();
+    Var b = g->addInput();
+    ((a*b).sigmoid() + a).addAsOutput();
+    return g;
+  };
+  auto run = [&](GraphExecutor & executor, std::vector<int64_t> sizes) {
+    auto a = at::randn(sizes);
+    auto b = at::randn(sizes);
+    std::vector<at::Tensor> inputs = {v(a), v(b)};
+    auto outputs = executor.run(variable_tensor_list(std::move(inputs)));
+    REQUIRE(almostEqual(Variable(outputs[0]).data(), (a*b).sigmoid() + a));
+  };
+
+  {
+    GraphExecutorOptions options;
+    options.max_plans = 2;
+    GraphExecutor executor(build(), true, true, options);
+    run(executor, {2, 3});
+    run(executor, {4, 3});
+    run(executor, {6, 3}); // evicts {2, 3}
+    run(executor, {4, 3});
+    run(executor, {2, 3}); // evicts {6, 3}
+    auto state = executor.getDebugState();
+    REQUIRE(state.execution_plans.size() == 2);
+    REQUIRE(state.plan_cache_stats.hits == 1);
+    REQUIRE(state.plan_cache_stats.misses == 4);
+    REQUIRE(state.plan_cache_stats.evictions == 2);
+  }
+
+  {
+    GraphExecutorOptions options;
+    options.dynamic_sizes = true;
+    GraphExecutor executor(build(), true, true, options);
+    run(executor, {2, 3});
+    run(executor, {5, 3});
+    run(executor, {1, 3}); // size-1 dimensions are still specialized on
+    auto state = executor.getDebugState();
+    REQUIRE(state.execution_plans.size() == 2);
+    REQUIRE(state.plan_cache_stats.hits == 1);
+    REQUIRE(state.plan_cache_stats.misses == 2);
+  }
+}
+
+void testExecutionPlanExport() {
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  auto build = []() {
+    auto g = std::make_shared<Graph>();
+    Var a = g->addInput();
+    Var b = g->addInput();
+    ((a*b).sigmoid() + a).addAsOutput();
+    return g;
+  };
+  auto a = at::randn({4, 3});
+  auto b = at::randn({4, 3});
+  auto inputs = [&]() {
+    std::vector<at::Tensor> inputs = {v(a), v(b)};
+    return variable_tensor_list(std::move(inputs));
+  };
+
+  GraphExecutor executor(build(), true);
+  executor.compileFor(inputs());
+  auto serialized = ExportExecutionPlans(executor.exportPlans());
+
+  auto plans = ImportExecutionPlans(serialized);
+  REQUIRE(plans.size() == 1);
+  GraphExecutor imported(build(), true);
+  imported.importPlans(plans);
+  auto outputs = imported.run(inputs());
+  REQUIRE(almostEqual(Variable(outputs[0]).data(), (a*b).sigmoid() + a));
+  auto state = imported.getDebugState();
+  REQUIRE(state.execution_plans.size() == 1);
+  REQUIRE(state.plan_cache_stats.hits == 1);
+  REQUIRE(state.plan_cache_stats.misses == 0);
+}
+
+void testParallelInterpreter() {
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  // two independent towers and their sum
+  auto build = []() {
+    auto g = std::make_shared<Graph>();
+    Var a = g->addInput();
+    Var b = g->addInput();
+    Var x = (a * a).sigmoid().tanh();
+    Var y = (b + b).tanh().sigmoid();
+    (x + y).addAsOutput();
+    x.addAsOutput();
+    return g;
+  };
+  auto a = at::randn({4, 3});
+  auto b = at::randn({4, 3});
+  auto x = (a * a).sigmoid().tanh();
+  auto expected = x + (b + b).tanh().sigmoid();
+
+  auto g = build();
+  ParallelCode pf(g);
+  REQUIRE(pf.width() == 2);
+  for(int i = 0; i < 10; i++) {
+    Stack stack = {v(a), v(b)};
+    pf.run(stack);
+    REQUIRE(stack.size() == 2);
+    REQUIRE(almostEqual(stack[0].toTensor(), expected));
+    REQUIRE(almostEqual(stack[1].toTensor(), x));
+  }
+
+  GraphExecutorOptions options;
+  options.inter_op_parallel = true;
+  GraphExecutor executor(build(), true, true, options);
+  std::vector<at::Tensor> inputs = {v(a), v(b)};
+  auto outputs = executor.run(variable_tensor_list(std::move(inputs)));
+  REQUIRE(almostEqual(Variable(outputs[0]).data(), expected));
+  REQUIRE(almostEqual(Variable(outputs[1]).data(), x));
+}
+
+void testUnwrappedExecution() {
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  auto build = []() {
+    auto g = std::make_shared<Graph>();
+    Var a = g->addInput();
+    Var b = g->addInput();
+    Var c = g->appendNode(g->createConstant(at::ones({4, 3})))->output();
+    ((a * b).sigmoid() + c).addAsOutput();
+    return g;
+  };
+  auto a = at::randn({4, 3});
+  auto b = at::randn({4, 3});
+  auto expected = (a * b).sigmoid() + 1;
+
+  auto g = build();
+  Code code(g, /*plan_memory=*/false, /*unwrapped=*/true);
+  Stack stack = {a, b};
+  InterpreterState(code).runOneStage(stack);
+  REQUIRE(stack.size() == 1);
+  REQUIRE(!stack[0].toTensor().is_variable());
+  REQUIRE(almostEqual(stack[0].toTensor(), expected));
+
+  GraphExecutorOptions options;
+  options.unwrap_variables = true;
+  GraphExecutor executor(build(), true, true, options);
+  for(int i = 0; i < 2; i++) {
+    std::vector<at::Tensor> inputs = {v(a), v(b)};
+    auto outputs = executor.run(variable_tensor_list(std::move(inputs)));
+    REQUIRE(outputs[0].is_variable());
+    REQUIRE(almostEqual(Variable(outputs[0]).data(), expected));
+  }
+  auto state = executor.getDebugState();
+  REQUIRE(state.execution_plans.size() == 1);
+  REQUIRE(state.execution_plans.begin()->second.unwrapped);
+
+  // without the option the same plan runs on Variables
+  GraphExecutor wrapped(build(), true, true);
+  std::vector<at::Tensor> inputs = {v(a), v(b)};
+  auto outputs = wrapped.run(variable_tensor_list(std::move(inputs)));
+  REQUIRE(almostEqual(Variable(outputs[0]).data(), expected));
+  REQUIRE(!wrapped.getDebugState().execution_plans.begin()->second.unwrapped);
+}
+
+void testGraphProfiling() {
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  auto g = std::make_shared<Graph>();
+  Var a = g->addInput();
+  Var b = g->addInput();
+  (a.mm(b) + a).addAsOutput();
+  GraphExecutor executor(g, /*optimize=*/true);
+  auto run = [&]() {
+    std::vector<at::Tensor> inputs = {v(at::randn({3, 3})), v(at::randn({3, 3}))};
+    executor.run(variable_tensor_list(std::move(inputs)));
+  };
+
+  run(); // not profiled
+  enableGraphProfiling();
+  run();
+  run();
+  auto profile = disableGraphProfiling();
+  run();
+
+  size_t lookups = 0, compiles = 0;
+  for(auto & e : profile.events) {
+    if(e.name == "GraphExecutor::getOrCompile")
+      lookups++;
+    if(e.name == "GraphExecutor::compile")
+      compiles++;
+  }
+  REQUIRE(lookups == 2);
+  REQUIRE(compiles == 0);
+  REQUIRE(profile.graphs.size() == 1);
+  bool found_mm = false;
+  for(auto & entry : profile.summarize()) {
+    REQUIRE(entry.second.calls == 2);
+    if(entry.first->kind() == aten::mm) {
+      found_mm = true;
+      REQUIRE(entry.second.input_sizes == std::vector<std::vector<int64_t>>({{3, 3}, {3, 3}}));
+    }
+  }
+  REQUIRE(found_mm);
+
+  std::stringstream annotated, trace;
+  profile.printAnnotatedGraphs(annotated);
+  REQUIRE(annotated.str().find("calls: 2") != std::string::npos);
+  profile.writeChromeTrace(trace);
+  REQUIRE(trace.str().find("\"name\": \"aten::mm\"") != std::string::npos);
+}
+
 void testBlocks(std::ostream & out) {
   Graph g;
   auto a = Var::asNewInput(g, "a");
@@ -880,6 +1333,17 @@ const static auto cf_examples = R"JIT(
       a *= a
       i += 1
     return a
+  def fib_test(a, b):
+    i = a - a
+    while i < 5:
+      c = a + b
+      a = b
+      b = c
+      i += 1
+    return a
+  def chain_test(a, b):
+    c = (a + b) * b - b
+    return c
 )JIT";
 void testControlFlow() {
   script::Module cu;
@@ -902,6 +1366,59 @@ void testControlFlow() {
   REQUIRE(2 == run_binary("if_one", 2, 3));
   REQUIRE(2 == run_binary("if_one", 3, 2));
   REQUIRE(256 == run_binary("while_test",2,0));
+  REQUIRE(8 == run_binary("fib_test", 1, 1));
+  REQUIRE(9 == run_binary("chain_test", 1, 3));
+}
+
+const static auto dispatch_examples = R"JIT(
+  def loop_1(a, i, n):
+    while i < n:
+      a = a + i
+      i += 1
+    return a
+  def loop_9(a, i, n):
+    while i < n:
+      a = a + i
+      a = a - i
+      a = a + i
+      a = a - i
+      a = a + i
+      a = a - i
+      a = a + i
+      a = a - i
+      a = a + i
+      i += 1
+    return a
+)JIT";
+
+// Microbenchmark for the cost of dispatching one instruction in the
+// interpreter. The two loops only differ by 8 ops on one-element tensors,
+// so the difference in time per iteration, divided by 8, is the per-op cost
+// of interpreter dispatch plus a tiny ATen kernel.
+void interpreterDispatchBenchmark(std::ostream & out) {
+  script::Module cu;
+  script::defineMethodsInModule(cu, dispatch_examples, torch::jit::script::Resolver(), nullptr);
+  auto L = [](int64_t l) { return IValue(autograd::make_variable(at::Scalar(l).toTensor())); };
+  constexpr int64_t iters = 20000;
+  auto time_per_iter = [&](const std::string & name) {
+    auto graph = cu.get_method(name).graph();
+    Code code(graph);
+    double best = std::numeric_limits<double>::max();
+    for(int rep = 0; rep < 5; ++rep) {
+      std::vector<IValue> stack = {L(0), L(0), L(iters)};
+      InterpreterState interp(code);
+      auto start = std::chrono::steady_clock::now();
+      interp.runOneStage(stack);
+      auto end = std::chrono::steady_clock::now();
+      REQUIRE(stack.size() == 1);
+      best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / iters);
+    }
+    return best;
+  };
+  double t1 = time_per_iter("loop_1");
+  double t9 = time_per_iter("loop_9");
+  out << "interpreter: " << t1 << " ns/iteration with 1 op, " << t9 << " ns/iteration with 9 ops, "
+      << (t9 - t1) / 8 << " ns/op\n";
 }
 
 void testIValue() {
@@ -958,6 +1475,11 @@ std::string runJITCPPTests() {
   testIValue();
   testControlFlow();
   testGraphExecutor();
+  testGraphExecutorPlanCache();
+  testExecutionPlanExport();
+  testParallelInterpreter();
+  testUnwrappedExecution();
+  testGraphProfiling();
   testBlocks(out);
   testCreateAutodiffSubgraphs(out);
   testDifferentiate(out);
@@ -967,11 +1489,15 @@ std::string runJITCPPTests() {
   interpStageTest();
   codeTemplateTest();
   fusionTests();
+  cpuFusionTests();
   attributesTest();
   internedStringsTests();
   fromQualStringTests();
   argumentSpecTest();
   shapeAnalysisTest();
+  memoryPlanningTest();
+  graphFuserReductionTest();
+  batchIndependentMatMulTest();
   testProto();
   return out.str();
 }
@@ -983,6 +1509,16 @@ TEST_CASE( "jit test CPU", "[cpu]" ) {
   std::stringstream out;
   SECTION( "control flow" )
     testControlFlow();
+  SECTION( "graph executor plan cache" )
+    testGraphExecutorPlanCache();
+  SECTION( "execution plan export" )
+    testExecutionPlanExport();
+  SECTION( "parallel interpreter" )
+    testParallelInterpreter();
+  SECTION( "unwrapped execution" )
+    testUnwrappedExecution();
+  SECTION( "graph profiling" )
+    testGraphProfiling();
   SECTION( "blocks" )
     testBlocks(out);
   SECTION( "create autodiff subgraphs" )
@@ -995,10 +1531,21 @@ TEST_CASE( "jit test CPU", "[cpu]" ) {
     testADFormulas();
   SECTION( "code template" )
     codeTemplateTest();
+  SECTION( "cpu fusion" )
+    cpuFusionTests();
   SECTION( "attributes" )
     attributesTest();
   SECTION( "interned strings" )
     internedStringsTests();
+  SECTION( "memory planning" )
+    memoryPlanningTest();
+  SECTION( "graph fuser reductions" )
+    graphFuserReductionTest();
+}
+
+// not run by default, select it with [benchmark]
+TEST_CASE( "jit interpreter dispatch benchmark", "[.][benchmark]" ) {
+  interpreterDispatchBenchmark(std::cout);
 }
 
 TEST_CASE( "jit test CUDA", "[cuda]" ) {
@@ -1015,6 +1562,8 @@ TEST_CASE( "jit test CUDA", "[cuda]" ) {
     argumentSpecTest();
   SECTION( "shape analysis" )
     shapeAnalysisTest();
+  SECTION( "batch independent matmuls" )
+    batchIndependentMatMulTest();
 }
 
 #endif
@@ -77,4 +77,12 @@ void setRecordSourceLocation(void (*v)(Node*)) {
   record_source_location.store(v);
 }
 
+thread_local bool records_source_locations = true;
+bool recordsSourceLocations() {
+  return records_source_locations;
+}
+void setRecordsSourceLocations(bool enabled) {
+  records_source_locations = enabled;
+}
+
 }}}
@@ -253,6 +253,13 @@ autograd::Variable getSizeOf(const autograd::Variable& var, int64_t dim);
 void recordSourceLocation(Node* n);
 void setRecordSourceLocation(void (*v)(Node*));
 
+// Whether the nodes traced by this thread record where they were traced
+// from, true by default. With Python, that is the whole interpreter stack,
+// captured for every op, which is most of the time it takes to trace large
+// models.
+bool recordsSourceLocations();
+void setRecordsSourceLocations(bool enabled);
+
 // We must record the nodes of inputs before we actually carry out
 // the operation, because an inplace operation may destroy the information
 // we're interested in.  See #4480.
@@ -264,7 +271,9 @@ PreTraceInfo makePreTraceInfo(at::ArrayRef<Variable> inputs, F ctor) {
   auto state_lock = info.state->lock();
 
   Node *n = ctor(info.state, *graph);
-  recordSourceLocation(n);
+  if (recordsSourceLocations()) {
+    recordSourceLocation(n);
+  }
 
   for (Variable input : inputs) {
     n->addInput(getValueTrace(info.state, input));
@@ -261,11 +261,13 @@ public:
 class ValueInfoProto : public MicroProto<onnx_ValueInfoProto> {
 private:
   std::string name;
+  std::string doc_string;
   std::unique_ptr<TypeProto> type;
 public:
   ValueInfoProto() : MicroProto(onnx_ValueInfoProto_init_default) {}
   std::string get_name() { return name; }
   void set_name(const std::string& s) { proto.name = string(&name, s); }
+  void set_doc_string(const std::string& s) { proto.doc_string = string(&doc_string, s); }
   TypeProto* mutable_type() {
     proto.type = msg<TypeProto, onnx_TypeProto_fields>(&type);
     return type.get();
@@ -346,12 +348,14 @@ private:
   std::string name;
   unique_vector<ValueInfoProto> inputs;
   unique_vector<ValueInfoProto> outputs;
+  unique_vector<ValueInfoProto> value_infos;
   unique_vector<NodeProto> nodes;
   unique_vector<TensorProto> initializers;
 public:
   GraphProto() : MicroProto(onnx_GraphProto_init_default) {
     proto.input = list<ValueInfoProto, onnx_ValueInfoProto_fields>(&inputs);
     proto.output = list<ValueInfoProto, onnx_ValueInfoProto_fields>(&outputs);
+    proto.value_info = list<ValueInfoProto, onnx_ValueInfoProto_fields>(&value_infos);
     proto.node = list<NodeProto, onnx_NodeProto_fields>(&nodes);
     proto.initializer = list<TensorProto, onnx_TensorProto_fields>(&initializers);
   }
@@ -367,6 +371,11 @@ public:
     outputs.emplace_back(ptr);
     return ptr;
   }
+  ValueInfoProto* add_value_info() {
+    auto ptr = new ValueInfoProto();
+    value_infos.emplace_back(ptr);
+    return ptr;
+  }
   NodeProto* add_node() {
     auto ptr = new NodeProto();
     nodes.emplace_back(ptr);
@@ -7,6 +7,7 @@
 
 #include <ATen/ATen.h>
 
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -464,6 +465,8 @@ bool FunctionSignature::parse(PyObject* args, PyObject* kwargs, PyObject* dst[],
 PythonArgParser::PythonArgParser(std::vector<std::string> fmts, bool traceable)
  : max_args(0)
  , traceable(traceable)
+ , cache_size_(0)
+ , cache_next_(0)
 {
   for (auto& fmt : fmts) {
     signatures_.push_back(FunctionSignature(fmt));
@@ -478,6 +481,23 @@ PythonArgParser::PythonArgParser(std::vector<std::string> fmts, bool traceable)
   }
 }
 
+// Everything FunctionParameter::check looks at: the type of the argument,
+// and for tensors, whether they can also bind to Scalar and int64_t.  Type
+// objects are aligned, which leaves the low bits for the latter.
+static uintptr_t arg_key(PyObject* obj) {
+  auto key = reinterpret_cast<uintptr_t>(Py_TYPE(obj));
+  if (THPVariable_Check(obj)) {
+    auto& var = ((THPVariable*)obj)->cdata;
+    if (var.dim() == 0 && !var.requires_grad()) {
+      key |= 1;
+      if (at::isIntegralType(var.type().scalarType())) {
+        key |= 2;
+      }
+    }
+  }
+  return key;
+}
+
 PythonArgs PythonArgParser::raw_parse(PyObject* args, PyObject* kwargs, PyObject* parsed_args[]) {
   if (signatures_.size() == 1) {
     auto& signature = signatures_[0];
@@ -485,9 +505,42 @@ PythonArgs PythonArgParser::raw_parse(PyObject* args, PyObject* kwargs, PyObject
     return PythonArgs(0, traceable, signature, parsed_args);
   }
 
+  // Without keyword arguments, the keys of the positional arguments decide
+  // which signatures match, so the one that matched the last call with the
+  // same keys is the first one that matches this call too, and the
+  // signatures before it need not be tried again.
+  auto nargs = PyTuple_GET_SIZE(args);
+  uintptr_t keys[kMaxCachedArgs];
+  bool cacheable = nargs <= kMaxCachedArgs && (!kwargs || PyDict_Size(kwargs) == 0);
+  if (cacheable) {
+    for (ssize_t j = 0; j < nargs; j++) {
+      keys[j] = arg_key(PyTuple_GET_ITEM(args, j));
+    }
+    for (int e = 0; e < cache_size_; e++) {
+      auto& entry = cache_[e];
+      if (entry.nargs == nargs && std::equal(keys, keys + nargs, entry.keys)) {
+        auto& signature = signatures_[entry.idx];
+        if (signature.parse(args, kwargs, parsed_args, false)) {
+          return PythonArgs(entry.idx, traceable, signature, parsed_args);
+        }
+        break;
+      }
+    }
+  }
+
   int i = 0;
   for (auto& signature : signatures_) {
     if (signature.parse(args, kwargs, parsed_args, false)) {
+      if (cacheable) {
+        auto& entry = cache_[cache_next_];
+        entry.nargs = nargs;
+        std::copy(keys, keys + nargs, entry.keys);
+        entry.idx = i;
+        cache_next_ = (cache_next_ + 1) % kCacheSize;
+        if (cache_size_ < kCacheSize) {
+          cache_size_++;
+        }
+      }
       return PythonArgs(i, traceable, signature, parsed_args);
     }
     i++;
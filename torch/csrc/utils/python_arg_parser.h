@@ -60,6 +60,7 @@
 
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <sstream>
 #include <string>
@@ -93,10 +94,24 @@ private:
   void print_error(PyObject* args, PyObject* kwargs, PyObject* dst[]);
   PythonArgs raw_parse(PyObject* args, PyObject* kwargs, PyObject* dst[]);
 
+  // The signature that the last calls with only positional arguments of
+  // given kinds matched, see raw_parse.  Parsers are only used with the GIL
+  // held, so the cache needs no lock.
+  static constexpr ssize_t kMaxCachedArgs = 4;
+  static constexpr int kCacheSize = 4;
+  struct CacheEntry {
+    ssize_t nargs;
+    uintptr_t keys[kMaxCachedArgs];
+    int idx;
+  };
+
   std::vector<FunctionSignature> signatures_;
   std::string function_name;
   ssize_t max_args;
   bool traceable;
+  CacheEntry cache_[kCacheSize];
+  int cache_size_;
+  int cache_next_;
 };
 
 struct PythonArgs {
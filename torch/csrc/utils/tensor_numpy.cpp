@@ -90,6 +90,15 @@ at::Tensor tensor_from_numpy(PyObject* obj) {
   }
 
   auto array = (PyArrayObject*)obj;
+  // Check what the memory holds before looking at its layout, so that arrays
+  // that can't be shared fail early and with the actual reason.
+  auto& type = CPU(numpy_dtype_to_aten(PyArray_TYPE(array)));
+  if (!PyArray_ISNOTSWAPPED(array)) {
+    throw ValueError(
+        "given numpy array has byte order different from the native byte order. "
+        "Conversion between byte orders is currently not supported.");
+  }
+
   int ndim = PyArray_NDIM(array);
   auto sizes = to_aten_shape(ndim, PyArray_DIMS(array));
   auto strides = to_aten_shape(ndim, PyArray_STRIDES(array));
@@ -116,7 +125,6 @@ at::Tensor tensor_from_numpy(PyObject* obj) {
   }
 
   void* data_ptr = PyArray_DATA(array);
-  auto& type = CPU(numpy_dtype_to_aten(PyArray_TYPE(array)));
   Py_INCREF(obj);
   return type.tensorFromBlob(data_ptr, sizes, strides, [obj](void* data) {
     AutoGIL gil;
@@ -12,9 +12,11 @@ import contextlib
 import platform
 import ctypes
 import os
+import time
 import torch
 import traceback
 import warnings
+from collections import OrderedDict
 from torch._six import raise_from
 from subprocess import Popen, PIPE
 from multiprocessing.util import register_after_fork as _register_after_fork
@@ -24,6 +26,8 @@ _queued_calls = []  # don't invoke these until initialization occurs
 _in_bad_fork = False  # this global is also used in torch.manual_seed
 _original_pid = False
 _cudart = None
+_init_times = OrderedDict()
+_checked_devices = set()  # devices whose capability _check_capability checked
 
 
 def find_cuda_windows_lib():
@@ -90,7 +94,15 @@ a PyTorch version that has been compiled with your version
 of the CUDA driver.""".format(str(torch._C._cuda_getDriverVersion())))
 
 
-def _check_capability():
+def _check_capability(d=None):
+    # Only checks devices as they are used, looking at every visible device
+    # would slow down the initialization.
+    if d is None:
+        d = torch._C._cuda_getDevice()
+    if d in _checked_devices:
+        return
+    _checked_devices.add(d)
+
     incorrect_binary_warn = """
     Found GPU%d %s which requires CUDA_VERSION >= %d for
      optimal performance and fast startup time, but your PyTorch was compiled
@@ -104,16 +116,15 @@ def _check_capability():
     """
 
     CUDA_VERSION = torch._C._cuda_getCompiledVersion()
-    for d in range(device_count()):
-        capability = get_device_capability(d)
-        major = capability[0]
-        name = get_device_name(d)
-        if CUDA_VERSION < 8000 and major >= 6:
-            warnings.warn(incorrect_binary_warn % (d, name, 8000, CUDA_VERSION))
-        elif CUDA_VERSION < 9000 and major >= 7:
-            warnings.warn(incorrect_binary_warn % (d, name, 9000, CUDA_VERSION))
-        elif capability == (3, 0) or major < 3:
-            warnings.warn(old_gpu_warn % (d, name, major, capability[1]))
+    capability = get_device_capability(d)
+    major = capability[0]
+    name = get_device_name(d)
+    if CUDA_VERSION < 8000 and major >= 6:
+        warnings.warn(incorrect_binary_warn % (d, name, 8000, CUDA_VERSION))
+    elif CUDA_VERSION < 9000 and major >= 7:
+        warnings.warn(incorrect_binary_warn % (d, name, 9000, CUDA_VERSION))
+    elif capability == (3, 0) or major < 3:
+        warnings.warn(old_gpu_warn % (d, name, major, capability[1]))
 
 
 def _lazy_call(callable):
@@ -157,15 +168,20 @@ def _lazy_init():
                    "'spawn' start method")
         raise RuntimeError(
             "Cannot re-initialize CUDA in forked subprocess. " + msg)
+    start = time.time()
     _check_driver()
-    torch._C._cuda_init()
+    _init_times['check_driver'] = time.time() - start
+    _init_times.update(torch._C._cuda_init())
+    start = time.time()
     _cudart = _load_cudart()
     _cudart.cudaGetErrorName.restype = ctypes.c_char_p
     _cudart.cudaGetErrorString.restype = ctypes.c_char_p
+    _init_times['load_cudart'] = time.time() - start
     _original_pid = os.getpid()
     _initialized = True
     # Important to do this after _initialized, since some queued calls
     # may themselves call _lazy_init()
+    start = time.time()
     for queued_call, orig_traceback in _queued_calls:
         try:
             queued_call()
@@ -173,6 +189,22 @@ def _lazy_init():
             msg = ("CUDA call failed lazily at initialization with error: {}\n\n"
                    "CUDA call was originally invoked at:\n\n{}").format(str(e), orig_traceback)
             raise_from(DeferredCudaCallError(msg), e)
+    _init_times['queued_calls'] = time.time() - start
+
+
+def init_times():
+    r"""Returns how long the steps of the initialization of PyTorch's CUDA
+    state took, in seconds, as an ordered dictionary. It is empty if CUDA
+    isn't initialized yet.
+
+    CUDA is initialized on first use, and only does what the process can't
+    start without: devices are set up as they are used, and the cuBLAS and
+    cuDNN handles of a device are created by the first operation that needs
+    them. Creating the CUDA context of a device happens on the first
+    operation that runs on it and usually dominates the time to the first
+    result, which is not part of these steps.
+    """
+    return OrderedDict(_init_times)
 
 
 def _after_fork(arg):
@@ -226,6 +258,7 @@ class device(object):
         if self.prev_idx != self.idx:
             torch._C._cuda_setDevice(self.idx)
         _lazy_init()
+        _check_capability(self.idx)
 
     def __exit__(self, *args):
         if self.prev_idx != self.idx:
@@ -260,6 +293,8 @@ def set_device(device):
     """
     if device >= 0:
         torch._C._cuda_setDevice(device)
+        if _initialized:
+            _check_capability(device)
 
 
 def get_device_name(device):
@@ -351,6 +386,32 @@ def current_blas_handle():
     return torch._C._cuda_getCurrentBlasHandle()
 
 
+def set_deterministic_accumulate(enabled):
+    r"""Sets whether accumulating index operations (:meth:`~torch.Tensor.index_add_`,
+    :meth:`~torch.Tensor.scatter_add_`, :meth:`~torch.Tensor.put_` with
+    ``accumulate=True`` and the backward of :func:`torch.nn.functional.embedding`)
+    produce bitwise reproducible results on CUDA.
+
+    By default, these add with atomic operations when there are few updates
+    per destination, so the order of floating point additions can change
+    from run to run. When enabled, the updates are always sorted by
+    destination and reduced in their original order, which is deterministic
+    but can be slower.
+
+    Arguments:
+        enabled (bool): whether to make accumulation deterministic
+    """
+    _lazy_init()
+    torch._C._cuda_setDeterministicAccumulate(enabled)
+
+
+def is_deterministic_accumulate():
+    r"""Returns whether accumulating index operations are deterministic, see
+    :func:`~torch.cuda.set_deterministic_accumulate`."""
+    _lazy_init()
+    return torch._C._cuda_getDeterministicAccumulate()
+
+
 def empty_cache():
     r"""Releases all unoccupied cached memory currently held by the caching
     allocator so that those can be used in other GPU application and visible in
@@ -443,6 +504,68 @@ def max_memory_cached(device=None):
     return torch._C._cuda_maxMemoryCached(device)
 
 
+def memory_snapshot():
+    r"""Returns a snapshot of every segment the caching allocator holds on
+    all devices, as a list of dicts with keys ``device``, ``address``,
+    ``total_size``, ``allocated_size``, ``stream`` and ``blocks``. Each
+    block is a dict with keys ``size``, ``allocated``, ``pending_free``
+    (freed, but still waiting on :meth:`~torch.Tensor.record_stream` uses)
+    and ``tag`` (see :func:`~torch.cuda.allocation_tag`).
+
+    .. note::
+        Useful for telling fragmentation apart from real memory pressure:
+        a large :meth:`~torch.cuda.memory_cached` with many small unallocated
+        blocks spread over segments means the cache is fragmented.
+    """
+    if not _initialized:
+        return []
+    return torch._C._cuda_memorySnapshot()
+
+
+def record_memory_history(enabled=True, capacity=100000):
+    r"""Starts or stops recording allocator events (allocations, frees and
+    the ``cudaMalloc``/``cudaFree`` calls behind them) into a ring buffer
+    holding the last :attr:`capacity` events. Restarting clears the buffer.
+
+    Arguments:
+        enabled (bool, optional): whether to record events (default: ``True``).
+        capacity (int, optional): number of events to keep (default: 100000).
+    """
+    torch._C._cuda_recordMemoryHistory(enabled, capacity)
+
+
+def memory_trace_chrome_json(path=None):
+    r"""Returns the events recorded since :func:`~torch.cuda.record_memory_history`
+    as a Chrome trace (viewable in ``chrome://tracing``), with one process per
+    device, one thread per stream and counters of allocated and cached bytes.
+
+    Arguments:
+        path (str, optional): if given, the trace is also written to this file.
+    """
+    trace = torch._C._cuda_memoryTraceChromeJSON()
+    if path is not None:
+        with open(path, 'w') as f:
+            f.write(trace)
+    return trace
+
+
+@contextlib.contextmanager
+def allocation_tag(tag):
+    r"""Context manager that tags the CUDA allocations made by the current
+    thread inside it with :attr:`tag`. Tags show up in
+    :func:`~torch.cuda.memory_snapshot` and in the allocator trace.
+
+    Arguments:
+        tag (str): the tag, e.g. the name of the module doing the allocations.
+    """
+    prev = torch._C._cuda_getAllocationTag()
+    torch._C._cuda_setAllocationTag(tag)
+    try:
+        yield
+    finally:
+        torch._C._cuda_setAllocationTag(prev)
+
+
 def _host_allocator():
     _lazy_init()
     return torch._C._cuda_cudaHostAllocator()
@@ -1,8 +1,6 @@
 import torch
 from . import nccl
-from torch._utils import _accumulate, _take_tensors, _flatten_dense_tensors, \
-    _flatten_sparse_tensors, _unflatten_dense_tensors, \
-    _unflatten_sparse_tensors, _reorder_tensors_as
+from torch._utils import _accumulate
 
 
 def broadcast(tensor, devices):
@@ -100,26 +98,10 @@ def reduce_add_coalesced(inputs, destination=None, buffer_size=10485760):
         A tuple of tensors containing an elementwise sum of each group of
         inputs, placed on the ``destination`` device.
     """
-    dense_tensors = [[] for _ in inputs]  # shape (num_gpus, num_tensors)
-    output = []
-    ref_order = []
-    # process sparse ones first since they may have different sizes on different gpus
-    for tensor_at_gpus in zip(*inputs):
-        if all(t.is_sparse for t in tensor_at_gpus):
-            result = reduce_add(tensor_at_gpus, destination)
-            output.append(result)
-            ref_order.append(tensor_at_gpus[0])
-        else:
-            for coll, t in zip(dense_tensors, tensor_at_gpus):
-                coll.append(t.to_dense() if t.is_sparse else t)
-            ref_order.append(dense_tensors[0][-1])
-    itrs = [_take_tensors(tensors, buffer_size) for tensors in dense_tensors]
-    # now the dense ones, which have consistent sizes
-    for chunks in zip(*itrs):
-        flat_tensors = [_flatten_dense_tensors(chunk) for chunk in chunks]
-        flat_result = reduce_add(flat_tensors, destination)
-        output.extend(_unflatten_dense_tensors(flat_result, chunks[0]))
-    return tuple(_reorder_tensors_as(output, ref_order))
+    if destination is None:
+        destination = torch.cuda.current_device()
+    inputs = [list(tensors) for tensors in inputs]
+    return tuple(torch._C._reduce_add_coalesced(inputs, destination, buffer_size))
 
 
 def scatter(tensor, devices, chunk_sizes=None, dim=0, streams=None):
@@ -48,6 +48,25 @@ def scope(scope_name, *vars):
             tracing_state.pop_scope()
 
 
+@contextlib.contextmanager
+def record_source_locations(enabled):
+    """
+    Context manager that sets whether the operations traced in it record the
+    Python stack they are called from, which error messages about them show.
+    Capturing the stack is most of the cost of tracing large models.
+
+    Example:
+
+        >>> with torch.jit.record_source_locations(False):
+        ...     trace, out = torch.jit.get_trace_graph(model, (input,))
+    """
+    prev = torch._C._tracer_set_source_locations(enabled)
+    try:
+        yield
+    finally:
+        torch._C._tracer_set_source_locations(prev)
+
+
 def get_trace_graph(f, args=tuple(), kwargs=None):
     """
     Trace a function or model, returning a tuple consisting of the both the
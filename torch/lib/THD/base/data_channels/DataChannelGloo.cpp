@@ -218,9 +218,10 @@ void DataChannelGloo::scatter(std::vector<at::Tensor>& input,
 template<typename T>
 void DataChannelGloo::allReduceT(at::Tensor& t, THDReduceOp operation,
                                  THDGroup group_id) {
-  uint64_t tensor_bytes = t.type().elementSizeInBytes() * t.numel();
+  uint64_t count = _cache->sizeClass(t.numel());
+  uint64_t buffer_bytes = t.type().elementSizeInBytes() * count;
   auto ret = _cache->getAlgorithm<CollectiveType::ALL_REDUCE, T>(
-    group_id, _groups.at(group_id), getDeviceType(t), tensor_bytes, t.numel(), operation);
+    group_id, _groups.at(group_id), getDeviceType(t), buffer_bytes, count, operation);
 
   {
     std::lock_guard<std::mutex> lock(*GlooCache::mutex(ret));
@@ -247,9 +248,10 @@ void DataChannelGloo::reduce(at::Tensor& data, THDReduceOp operation,
 template<typename T>
 void DataChannelGloo::broadcastT(at::Tensor& data, rank_type src_rank,
                                  THDGroup group_id) {
-  uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
+  uint64_t count = _cache->sizeClass(data.numel());
+  uint64_t buffer_bytes = data.type().elementSizeInBytes() * count;
   auto ret = _cache->getAlgorithm<CollectiveType::BROADCAST, T>(
-    group_id, _groups.at(group_id), getDeviceType(data), tensor_bytes, data.numel(),
+    group_id, _groups.at(group_id), getDeviceType(data), buffer_bytes, count,
     _groups.at(group_id).mustGetGroupRank(src_rank));
 
   {
@@ -1,6 +1,5 @@
 #include "DataChannelTCP.hpp"
 
-#include <sys/poll.h>
 #include <unistd.h>
 #include <algorithm>
 #include <cstdint>
@@ -40,8 +39,8 @@ inline uint64_t pow2(T value) {
 } // namespace
 
 
-DataChannelTCP::RequestTCP::RequestTCP(QueueWorker::Request&& request)
-  : _request(std::move(request)) {
+DataChannelTCP::RequestTCP::RequestTCP(ProgressEngineTCP::op_ptr op)
+  : _op(std::move(op)) {
 }
 
 
@@ -49,12 +48,12 @@ DataChannelTCP::RequestTCP::~RequestTCP() {}
 
 
 bool DataChannelTCP::RequestTCP::isCompleted() {
-  return _request.isCompleted();
+  return _op->isCompleted();
 }
 
 
 void DataChannelTCP::RequestTCP::wait() {
-  _request.wait();
+  _op->wait();
 }
 
 
@@ -68,7 +67,7 @@ DataChannelTCP::DataChannelTCP(InitMethod::Config config, int timeout)
   , _port(0)
   , _timeout(timeout)
   , _processes(config.world_size)
-  , _poll_events(nullptr)
+  , _options(ProgressEngineTCP::Options::fromEnv())
 {
   _rank = config.rank;
 
@@ -80,7 +79,7 @@ DataChannelTCP::DataChannelTCP(InitMethod::Config config, int timeout)
       .rank = 0,
       .address = "",
       .port = 0,
-      .socket = -1,
+      .sockets = {},
     };
   } else { // WORKER
     // add master
@@ -88,20 +87,25 @@ DataChannelTCP::DataChannelTCP(InitMethod::Config config, int timeout)
       .rank = 0,
       .address = config.worker.master_addr,
       .port = config.worker.master_port,
-      .socket = -1,
+      .sockets = {},
     };
   }
 }
 
 
 DataChannelTCP::~DataChannelTCP() {
+  // stop the transfers before closing their sockets
+  _engine.reset();
 
   if (_socket != -1)
     ::close(_socket);
 
   for (const auto& process : _processes) {
-    if ((process.rank != _rank) && (process.socket != -1))
-      ::close(process.socket);
+    if (process.rank == _rank)
+      continue;
+
+    for (int socket : process.sockets)
+      ::close(socket);
   }
 }
 
@@ -111,27 +115,40 @@ void DataChannelTCP::destroy() {}
 
 bool DataChannelTCP::initWorker() {
   auto& master = _processes[0];
-  master.socket = connect(master.address, master.port);
+  int master_socket = connect(master.address, master.port);
+  master.sockets.push_back(master_socket);
 
   std::tie(_socket, _port) = listen();
 
-  send_value<rank_type>(master.socket, _rank, true);
-  send_value<port_type>(master.socket, _port); // send listening port to master
+  send_value<rank_type>(master_socket, _rank, true);
+  send_value<port_type>(master_socket, _port); // send listening port to master
+
+  // all processes use the number of sockets per peer of the master
+  _options.sockets_per_peer = recv_value<size_type>(master_socket);
 
   // get all metadata of other processes in network
   for (size_t i = 1; i < _processes.size(); ++i) {
-    rank_type p_rank = recv_value<rank_type>(master.socket);
-    port_type p_port = recv_value<port_type>(master.socket);
-    std::string p_address = recv_string(master.socket);
+    rank_type p_rank = recv_value<rank_type>(master_socket);
+    port_type p_port = recv_value<port_type>(master_socket);
+    std::string p_address = recv_string(master_socket);
 
     _processes[p_rank] = {
       .rank = p_rank,
       .address = p_address,
       .port = p_port,
-      .socket = -1,
+      .sockets = {},
     };
   }
 
+  // open the remaining connections to master
+  for (size_type i = 1; i < _options.sockets_per_peer; ++i) {
+    int socket = connect(master.address, master.port);
+    master.sockets.push_back(socket);
+
+    send_value<rank_type>(socket, _rank, true);
+    send_value<size_type>(socket, i);
+  }
+
   /*
    * Firstly we are connecting to workers with rank lower than our rank,
    * then we accepting connections from other wokers with higher rank.
@@ -142,19 +159,28 @@ bool DataChannelTCP::initWorker() {
 
   for (rank_type r = 1; r < _rank; ++r) {
     auto& process = _processes[r];
-    process.socket = connect(process.address, process.port);
+    for (size_type i = 0; i < _options.sockets_per_peer; ++i) {
+      int socket = connect(process.address, process.port);
+      process.sockets.push_back(socket);
 
-    // send rank to tell to the accepting process who we are
-    send_value<rank_type>(process.socket, _rank);
+      // send rank and socket index to tell to the accepting process who we are
+      send_value<rank_type>(socket, _rank, true);
+      send_value<size_type>(socket, i);
+    }
   }
 
-  for (rank_type i = _rank + 1; i < _processes.size(); ++i) {
+  for (rank_type r = _rank + 1; r < _processes.size(); ++r)
+    _processes[r].sockets.assign(_options.sockets_per_peer, -1);
+
+  for (size_t i = (_rank + 1) * _options.sockets_per_peer;
+       i < _processes.size() * _options.sockets_per_peer; ++i) {
     int socket;
     std::tie(socket, std::ignore) = accept(_socket, _timeout);
 
     // get rank of process we have just accepted
     rank_type p_rank = recv_value<rank_type>(socket);
-    _processes[p_rank].socket = socket;
+    size_type p_index = recv_value<size_type>(socket);
+    _processes.at(p_rank).sockets.at(p_index) = socket;
   }
 
   // close socket for listening, we will not use it anymore
@@ -193,7 +219,7 @@ bool DataChannelTCP::initMaster() {
       .rank = p_rank,
       .address = p_address,
       .port = p_port,
-      .socket = p_socket,
+      .sockets = {p_socket},
     };
   }
 
@@ -201,15 +227,37 @@ bool DataChannelTCP::initMaster() {
   for (const auto& worker : _processes) {
     if (worker.rank == 0) continue;
 
+    int worker_socket = worker.sockets.front();
+    send_value<size_type>(worker_socket, _options.sockets_per_peer, true);
     for (auto& process : _processes) {
       if (process.rank == 0) continue;
 
-      send_value<rank_type>(worker.socket, process.rank, true);
-      send_value<port_type>(worker.socket, process.port, true);
-      send_string(worker.socket, process.address);
+      send_value<rank_type>(worker_socket, process.rank, true);
+      send_value<port_type>(worker_socket, process.port, true);
+      send_string(worker_socket, process.address);
     }
   }
 
+  // accept the remaining connections of all workers
+  for (auto& worker : _processes) {
+    if (worker.rank != 0)
+      worker.sockets.resize(_options.sockets_per_peer, -1);
+  }
+
+  size_t extra_sockets = (_processes.size() - 1) * (_options.sockets_per_peer - 1);
+  for (size_t i = 0; i < extra_sockets; ++i) {
+    int socket;
+    std::tie(socket, std::ignore) = accept(_socket, _timeout);
+
+    rank_type p_rank = recv_value<rank_type>(socket);
+    size_type p_index = recv_value<size_type>(socket);
+    if (p_rank == 0 || p_index == 0) {
+      ::close(socket);
+      throw std::logic_error("unexpected connection while initializing the TCP data channel");
+    }
+    _processes.at(p_rank).sockets.at(p_index) = socket;
+  }
+
   // close socket for listening, we will not use it anymore
   ::close(_socket);
   _socket = -1;
@@ -221,6 +269,12 @@ bool DataChannelTCP::initMaster() {
 bool DataChannelTCP::init() {
   bool ok = (_rank == 0 ? initMaster() : initWorker());
   if (ok) {
+    std::vector<std::vector<int>> sockets;
+    sockets.reserve(_processes.size());
+    for (const auto& process : _processes)
+      sockets.push_back(process.rank == _rank ? std::vector<int>() : process.sockets);
+    _engine.reset(new ProgressEngineTCP(_rank, std::move(sockets), _options));
+
     std::vector<rank_type> ranks;
     ranks.reserve(_processes.size());
     for (rank_type rank = 0; rank < _processes.size(); ++rank)
@@ -527,90 +581,67 @@ void DataChannelTCP::broadcast(at::Tensor& data, rank_type src_rank,
 
 
 void DataChannelTCP::send(Scalar& data, rank_type dst_rank) {
-  auto request = _send_worker.push([this, &data, dst_rank]{
-    this->_send(data, dst_rank);
-  });
-  request.wait();
-}
+  /*
+   * We have to check if dst_rank is positive to properly use `.at` function in vector.
+   * Not checking that can result in int overflow and strange errors.
+   */
 
+  const auto& process_dst = _processes.at(dst_rank);
+  if (process_dst.rank == _rank)
+    throw std::logic_error("cannot send scalar to process with same rank");
 
-void DataChannelTCP::send(at::Tensor& data, rank_type dst_rank) {
-  auto request = _send_worker.push([this, &data, dst_rank]{
-    this->_send(data, dst_rank);
-  });
-  request.wait();
+  _engine->send(dst_rank, data.data(), data.elementSize())->wait();
 }
 
 
-void DataChannelTCP::receive(Scalar& data, rank_type src_rank) {
-  auto request = _receive_worker.push([this, &data, src_rank]{
-    this->_receive(data, src_rank);
-  });
-  request.wait();
+void DataChannelTCP::send(at::Tensor& data, rank_type dst_rank) {
+  _send(data, dst_rank)->wait();
 }
 
 
-rank_type DataChannelTCP::receive(at::Tensor& data) {
-  rank_type sender;
-  auto request = _receive_worker.push([this, &data, &sender]{
-    if (!this->_poll_events) {
-      // cache poll events array, it will be reused in another `receive` calls
-      this->_poll_events.reset(new struct pollfd[this->_processes.size()]);
-      for (size_t rank = 0; rank < this->_processes.size(); ++rank) {
-        this->_poll_events[rank] = {
-          .fd = this->_processes[rank].socket,
-          .events = POLLIN
-        };
-      }
-    }
+void DataChannelTCP::receive(Scalar& data, rank_type src_rank) {
+  /*
+   * We have to check if src_rank is positive to properly use `.at` function in vector.
+   * Not checking that can result in int overflow and strange errors.
+   */
 
-    // cleanup
-    for (size_t rank = 0; rank < this->_processes.size(); ++rank) {
-      this->_poll_events[rank].revents = 0;
-    }
+  const auto& process_src = _processes.at(src_rank);
+  if (process_src.rank == _rank)
+    throw std::logic_error("cannot receive scalar from process with same rank");
 
-    SYSCHECK(::poll(this->_poll_events.get(), this->_processes.size(), -1)) // infinite timeout
-    for (size_t rank = 0; rank < this->_processes.size(); ++rank) {
-      if (this->_poll_events[rank].revents == 0)
-        continue;
+  _engine->receive(src_rank, data.data(), data.elementSize(),
+                   "scalar sizes do not match")->wait();
+}
 
-      if (this->_poll_events[rank].revents ^ POLLIN)
-        throw std::system_error(ECONNABORTED, std::system_category());
 
-      this->_receive(data, rank);
-      sender = rank;
-      break;
-    }
-  });
+rank_type DataChannelTCP::receive(at::Tensor& data) {
+  if (!data.is_contiguous())
+    throw std::logic_error("tensor to receive is not contiguous");
 
-  request.wait();
-  return sender;
+  auto op = _engine->receiveAny(
+    data.data_ptr(),
+    data.type().elementSizeInBytes() * data.numel(),
+    "tensor sizes do not match"
+  );
+  op->wait();
+  return op->peer();
 }
 
 
 void DataChannelTCP::receive(at::Tensor& data, rank_type src_rank) {
-  auto request = _receive_worker.push([this, &data, src_rank]{
-    this->_receive(data, src_rank);
-  });
-  request.wait();
+  _receive(data, src_rank)->wait();
 }
 
 
 DataChannelTCP::RequestTCP* DataChannelTCP::isend(at::Tensor& data,
                                                   rank_type dst_rank) {
-  auto request = _send_worker.push([this, data, dst_rank]{
-    this->_send(data, dst_rank);
-  });
-  return new DataChannelTCP::RequestTCP(std::move(request));
+  return new DataChannelTCP::RequestTCP(_send(data, dst_rank));
 }
 
 
 DataChannelTCP::RequestTCP* DataChannelTCP::ireceive(at::Tensor& data,
                                                      rank_type src_rank) {
-  auto request = _receive_worker.push([this, data, src_rank]{
-    this->_receive(data, src_rank);
-  });
-  return new DataChannelTCP::RequestTCP(std::move(request));
+  return new DataChannelTCP::RequestTCP(_receive(data, src_rank));
 }
 
 
@@ -618,8 +649,7 @@ void DataChannelTCP::barrier(THDGroup group_id) {
   /*
    * Barrier is implementation of Bruck algorithm. All processes send to
    * other processes with rank (i + 2^k) and recv from process with rank (i - 2^k)
-   * with wrap-around. Since we cannot do recv and send at the same time
-   * we do recv asynchronously (thread), send byte and then wait for recv to complete.
+   * with wrap-around. Both transfers are started at once and then waited for.
    */
 
   std::lock_guard<std::mutex> lock(_mutex);
@@ -632,22 +662,17 @@ void DataChannelTCP::barrier(THDGroup group_id) {
   if (!exists)
     return;
 
-  std::uint8_t byte = 1;
+  std::uint8_t send_byte = 1, recv_byte;
   for (rank_type distance = 1; distance < group.size(); distance <<= 1) {
     rank_type recv_partner = (group_rank + group.size() - distance) % group.size();
-    const auto& recv_process = _processes.at(group.mustGetGlobalRank(recv_partner));
-    auto recv_request = _receive_worker.push([&recv_process, &byte]{
-      recv_bytes<std::uint8_t>(recv_process.socket, &byte, 1);
-    });
+    auto recv_request = _engine->receive(group.mustGetGlobalRank(recv_partner),
+                                         &recv_byte, 1, "barrier message of unexpected size");
 
     rank_type send_partner = (group_rank + distance) % group.size();
-    const auto& send_process = _processes.at(group.mustGetGlobalRank(send_partner));
-    auto send_request = _send_worker.push([&send_process, &byte]{
-      send_bytes<std::uint8_t>(send_process.socket, &byte, 1);
-    });
+    auto send_request = _engine->send(group.mustGetGlobalRank(send_partner), &send_byte, 1);
 
-    send_request.wait();
-    recv_request.wait();
+    send_request->wait();
+    recv_request->wait();
   }
 }
 
@@ -661,30 +686,8 @@ THDGroup DataChannelTCP::newGroup(const std::vector<rank_type>& ranks) {
 }
 
 
-void DataChannelTCP::_send(const Scalar& data, rank_type dst_rank) {
-  /*
-   * We have to check if dst_rank is positive to properly use `.at` function in vector.
-   * Not checking that can result in int overflow and strange errors.
-   */
-
-  const auto& process_dst = _processes.at(dst_rank);
-  if (process_dst.rank == _rank)
-    throw std::logic_error("cannot send scalar to process with same rank");
-
-  // send size of scalar in bytes
-  uint64_t scalar_bytes = data.elementSize();
-  send_bytes<uint64_t>(process_dst.socket, &scalar_bytes, 1, true);
-
-  // send data (bytes)
-  send_bytes<std::uint8_t>(
-    process_dst.socket,
-    reinterpret_cast<const std::uint8_t*>(data.data()),
-    scalar_bytes
-  );
-}
-
-
-void DataChannelTCP::_send(const at::Tensor& data, rank_type dst_rank) {
+ProgressEngineTCP::op_ptr DataChannelTCP::_send(const at::Tensor& data,
+                                                rank_type dst_rank) {
   /*
    * We have to check if dst_rank is positive to properly use `.at` function in vector.
    * Not checking that can result in int overflow and strange errors.
@@ -697,50 +700,18 @@ void DataChannelTCP::_send(const at::Tensor& data, rank_type dst_rank) {
   if (!data.is_contiguous())
     throw std::logic_error("tensor to send is not contiguous");
 
-  // send size of tensor data in bytes
-  uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
-  send_bytes<uint64_t>(process_dst.socket, &tensor_bytes, 1, true);
-
-  // send data (bytes)
-  send_bytes<std::uint8_t>(
-    process_dst.socket,
-    reinterpret_cast<const std::uint8_t*>(data.data_ptr()),
-    tensor_bytes
+  // the tensor is kept alive until the last byte is sent
+  return _engine->send(
+    dst_rank,
+    data.data_ptr(),
+    data.type().elementSizeInBytes() * data.numel(),
+    std::make_shared<at::Tensor>(data)
   );
 }
 
 
-void DataChannelTCP::_receive(Scalar& data, rank_type src_rank) {
-  /*
-   * We have to check if src_rank is positive to properly use `.at` function in vector.
-   * Not checking that can result in int overflow and strange errors.
-   */
-
-  const auto& process_src = _processes.at(src_rank);
-  if (process_src.rank == _rank)
-    throw std::logic_error("cannot receive scalar from process with same rank");
-
-  // get size of scalar in bytes
-  uint64_t scalar_bytes;
-  recv_bytes<uint64_t>(process_src.socket, &scalar_bytes, 1);
-
-  uint64_t actual_scalar_bytes = data.elementSize();
-  if (actual_scalar_bytes == scalar_bytes) {
-    recv_bytes<std::uint8_t>(
-      process_src.socket,
-      reinterpret_cast<std::uint8_t*>(data.data()),
-      scalar_bytes
-    );
-  } else {
-    // remove invalid data from recv buffer
-    std::unique_ptr<std::uint8_t[]> bytes(new std::uint8_t[scalar_bytes]);
-    recv_bytes<std::uint8_t>(process_src.socket, bytes.get(), scalar_bytes);
-    throw std::logic_error("scalar sizes do not match");
-  }
-}
-
-
-void DataChannelTCP::_receive(const at::Tensor& data, rank_type src_rank) {
+ProgressEngineTCP::op_ptr DataChannelTCP::_receive(const at::Tensor& data,
+                                                   rank_type src_rank) {
   /*
    * We have to check if src_rank is positive to properly use `.at` function in vector.
    * Not checking that can result in int overflow and strange errors.
@@ -753,23 +724,13 @@ void DataChannelTCP::_receive(const at::Tensor& data, rank_type src_rank) {
   if (!data.is_contiguous())
     throw std::logic_error("tensor to receive is not contiguous");
 
-  // get size of tensor data in bytes
-  uint64_t tensor_bytes;
-  recv_bytes<uint64_t>(process_src.socket, &tensor_bytes, 1);
-
-  uint64_t actual_tensor_bytes = data.type().elementSizeInBytes() * data.numel();
-  if (actual_tensor_bytes == tensor_bytes) {
-    recv_bytes<std::uint8_t>(
-      process_src.socket,
-      reinterpret_cast<std::uint8_t*>(data.data_ptr()),
-      tensor_bytes
-    );
-  } else {
-    // remove invalid data from recv buffer
-    std::unique_ptr<std::uint8_t[]> bytes(new std::uint8_t[tensor_bytes]);
-    recv_bytes<std::uint8_t>(process_src.socket, bytes.get(), tensor_bytes);
-    throw std::logic_error("tensor sizes do not match");
-  }
+  return _engine->receive(
+    src_rank,
+    data.data_ptr(),
+    data.type().elementSizeInBytes() * data.numel(),
+    "tensor sizes do not match",
+    std::make_shared<at::Tensor>(data)
+  );
 }
 
 void DataChannelTCP::_reduce(at::Tensor& result, at::Tensor& data,
@@ -2,8 +2,8 @@
 
 #include "../DataChannel.hpp"
 #include "DataChannelUtils.hpp"
+#include "ProgressEngineTCP.hpp"
 
-#include <sys/poll.h>
 #include <cstdint>
 #include <map>
 #include <memory>
@@ -16,14 +16,14 @@ namespace thd {
 struct DataChannelTCP : DataChannel {
 
   struct RequestTCP : DataChannel::Request {
-    RequestTCP(QueueWorker::Request&& request);
+    RequestTCP(ProgressEngineTCP::op_ptr op);
     virtual ~RequestTCP();
 
     virtual bool isCompleted() override;
     virtual void wait() override;
 
   private:
-    QueueWorker::Request _request;
+    ProgressEngineTCP::op_ptr _op;
   };
 
   DataChannelTCP(InitMethod::Config config);
@@ -81,16 +81,14 @@ private:
     rank_type rank;
     std::string address;
     port_type port;
-    int socket;
+    std::vector<int> sockets; // the first one is used during initialization
   };
 
   bool initMaster();
   bool initWorker();
 
-  void _send(const Scalar& data, rank_type dst_id);
-  void _send(const at::Tensor& data, rank_type dst_id);
-  void _receive(Scalar& data, rank_type src_id);
-  void _receive(const at::Tensor& data, rank_type src_id);
+  ProgressEngineTCP::op_ptr _send(const at::Tensor& data, rank_type dst_id);
+  ProgressEngineTCP::op_ptr _receive(const at::Tensor& data, rank_type src_id);
   void _reduce(at::Tensor& result, at::Tensor& data,
                THDReduceOp operation) const;
 
@@ -101,7 +99,6 @@ private:
   int _timeout; // Accept waiting timeout in milliseconds (it is optional, default = infinity)
 
   std::vector<Process> _processes; // Other processes in network
-  std::unique_ptr<struct pollfd[]> _poll_events; // Events array for `poll`
 
   // General mutex for methods - to protect access to the TCP data channel.
   std::mutex _mutex;
@@ -109,8 +106,9 @@ private:
   // Existing groups of processes and corresponding group ids
   std::unordered_map<THDGroup, DataChannel::Group> _groups;
 
-  // Workers
-  QueueWorker _send_worker, _receive_worker;
+  // Sockets and point-to-point transfers, created once connections are set up
+  ProgressEngineTCP::Options _options;
+  std::unique_ptr<ProgressEngineTCP> _engine;
 
 };
 
@@ -24,7 +24,9 @@
 #include <THC/THC.h>
 #endif
 #include <cstdint>
+#include <cstdlib>
 #include <memory>
+#include <string>
 #include <tuple>
 #include <vector>
 #include <type_traits>
@@ -66,6 +68,19 @@ MAKE_HASHABLE(
 
 namespace thd {
 
+/*
+ * Every collective on tensors of a new size creates an algorithm, with its
+ * own buffers and connections. Two environment variables limit their number:
+ *
+ * THD_GLOO_CACHE_SIZE_CLASSES - if 1, all reduces and broadcasts round the
+ *   number of elements up to a size class (see sizeClass) and work on the
+ *   prefix of a larger buffer, so tensors of similar sizes share algorithms
+ * THD_GLOO_CACHE_MAX_BYTES - if not 0, the least recently used algorithms are
+ *   evicted once their buffers hold more bytes
+ *
+ * All processes call the collectives in the same order, so they evict the same
+ * algorithms. A recreated algorithm connects under a new store prefix.
+ */
 struct GlooCache {
   using buffer_type = char;
   using algorithm_type = ::gloo::Algorithm;
@@ -85,6 +100,10 @@ struct GlooCache {
             std::vector<std::shared_ptr<::gloo::transport::Device>> deviceList)
    : _rank(rank)
    , _deviceList(deviceList)
+   , _size_classes(getEnvOr("THD_GLOO_CACHE_SIZE_CLASSES", 0) != 0)
+   , _max_bytes(getEnvOr("THD_GLOO_CACHE_MAX_BYTES", 0))
+   , _bytes(0)
+   , _clock(0)
   {}
 
   GlooCache(GlooCache const&)      = delete;
@@ -151,6 +170,29 @@ struct GlooCache {
     }
   }
 
+  /*
+   * Number of elements of the buffers of an all reduce or a broadcast of
+   * `count` elements. Above 64 elements it is one of 4 sizes between
+   * consecutive powers of two, so at most 25% larger, and a power of two below.
+   */
+  std::size_t sizeClass(std::size_t count) const {
+    if (!_size_classes || count == 0)
+      return count;
+
+    if (count <= 64) {
+      std::size_t size = 1;
+      while (size < count)
+        size <<= 1;
+      return size;
+    }
+
+    std::size_t power = 64;
+    while (power * 2 <= count)
+      power <<= 1;
+    std::size_t step = power / 4;
+    return (count + step - 1) / step * step;
+  }
+
   template<CollectiveType D, typename T, typename... Args>
   value_type getAlgorithm(THDGroup group_id, const DataChannelGloo::Group& group,
                           Args... args) {
@@ -159,21 +201,31 @@ struct GlooCache {
     std::unique_lock<std::mutex> lock(_mutex);
     auto it = _algorithms.find(key);
     if (it == _algorithms.end()) {
+      std::string store_prefix = print_key(key);
+      auto generation = _generations.find(key);
+      if (generation != _generations.end())
+        store_prefix += "-" + std::to_string(generation->second);
+
       lock.unlock();
 
       auto algorithm = gloo_cache::algorithm_spec<D, T>::create(*this, group,
-              print_key(key), std::forward<Args>(args)...);
+              store_prefix, std::forward<Args>(args)...);
 
       lock.lock();
 
       bool inserted;
       std::tie(it, inserted) = _algorithms.emplace(
-        std::move(key), std::move(algorithm));
+        key, std::move(algorithm));
       if (!inserted)
           throw std::runtime_error("detected a race when creating Gloo algorithm");
+
+      _bytes += buffer_bytes(key);
     }
 
-    return it->second;
+    auto value = it->second;
+    _last_use[key] = ++_clock;
+    evict(key);
+    return value;
   }
 
   static void memcpy_input(value_type& info, at::Tensor& t) {
@@ -213,6 +265,48 @@ struct GlooCache {
   }
 
 private:
+  static long getEnvOr(const char* env, long default_value) {
+    const char* value_str = std::getenv(env);
+    if (value_str == nullptr)
+      return default_value;
+
+    long value = std::stol(value_str);
+    if (value < 0)
+      throw std::invalid_argument(std::string(env) + " should be at least 0");
+    return value;
+  }
+
+  // All reduces and broadcasts get their result in the input buffer.
+  static std::size_t buffer_bytes(const key_type& k) {
+    if (std::get<0>(k) == CollectiveType::ALL_GATHER)
+      return std::get<4>(k) + std::get<5>(k);
+    return std::get<4>(k);
+  }
+
+  // Evicts the least recently used algorithms other than `key` until the
+  // buffers fit in _max_bytes. Must be called with _mutex held. Running
+  // collectives keep their algorithm alive through their copy of the value.
+  void evict(const key_type& key) {
+    while (_max_bytes > 0 && _bytes > _max_bytes) {
+      auto lru = _last_use.end();
+      for (auto it = _last_use.begin(); it != _last_use.end(); ++it) {
+        if (it->first == key)
+          continue;
+        if (lru == _last_use.end() || it->second < lru->second)
+          lru = it;
+      }
+
+      // The algorithm exceeds the bound on its own
+      if (lru == _last_use.end())
+        return;
+
+      _bytes -= buffer_bytes(lru->first);
+      _generations[lru->first]++;
+      _algorithms.erase(lru->first);
+      _last_use.erase(lru);
+    }
+  }
+
   std::string print_key(const key_type& k) {
     return std::to_string(static_cast<uint8_t>(std::get<0>(k))) + "-"
       + std::to_string(std::get<1>(k)) + "-"
@@ -231,6 +325,14 @@ private:
   std::mutex _mutex;
 
   std::unordered_map<key_type, value_type> _algorithms;
+
+  bool _size_classes;
+  std::size_t _max_bytes;
+  std::size_t _bytes;
+  std::uint64_t _clock;
+  std::unordered_map<key_type, std::uint64_t> _last_use;
+  // Number of times each key was evicted, part of the store prefix
+  std::unordered_map<key_type, std::uint64_t> _generations;
 };
 
 namespace gloo_cache {
@@ -0,0 +1,753 @@
+#include "ProgressEngineTCP.hpp"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#else
+#include <sys/poll.h>
+#endif // __linux__
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <system_error>
+
+
+namespace thd {
+namespace {
+
+constexpr char SOCKETS_PER_PEER_ENV[] = "THD_TCP_SOCKETS_PER_PEER";
+constexpr char CHUNK_SIZE_ENV[] = "THD_TCP_CHUNK_SIZE";
+constexpr char NO_DELAY_ENV[] = "THD_TCP_NODELAY";
+constexpr char SEND_BUFFER_SIZE_ENV[] = "THD_TCP_SEND_BUFFER_SIZE";
+constexpr char RECV_BUFFER_SIZE_ENV[] = "THD_TCP_RECV_BUFFER_SIZE";
+
+constexpr std::size_t DEFAULT_CHUNK_SIZE = 1 << 19; // 512 KB
+constexpr std::size_t DISCARD_BUFFER_SIZE = 1 << 16;
+
+// Identifies the wake up pipe among the sockets in the poller.
+constexpr std::size_t WAKE_UP_ID = std::numeric_limits<std::size_t>::max();
+
+enum : unsigned {
+  EVENT_READ = 1,
+  EVENT_WRITE = 2,
+  EVENT_ERROR = 4,
+};
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif // MSG_NOSIGNAL
+
+long getEnvOr(const char* env, long default_value, long min_value) {
+  const char* value_str = std::getenv(env);
+  if (value_str == nullptr)
+    return default_value;
+
+  long value = std::stol(value_str);
+  if (value < min_value)
+    throw std::invalid_argument(std::string(env) + " should be at least " +
+                                std::to_string(min_value));
+  return value;
+}
+
+void setNonBlocking(int socket) {
+  int flags;
+  SYSCHECK(flags = ::fcntl(socket, F_GETFL))
+  SYSCHECK(::fcntl(socket, F_SETFL, flags | O_NONBLOCK))
+}
+
+void setIntOption(int socket, int level, int option, int value) {
+  SYSCHECK(::setsockopt(socket, level, option, &value, sizeof(value)))
+}
+
+inline bool wouldBlock(int error) {
+  return error == EAGAIN || error == EWOULDBLOCK;
+}
+
+inline std::exception_ptr connectionReset() {
+  return std::make_exception_ptr(
+    std::system_error(ECONNRESET, std::system_category()));
+}
+
+} // anonymous namespace
+
+
+/*
+ * Thin wrapper over epoll, or over poll where epoll is not available. The
+ * registered descriptors are identified by an id given on `add`.
+ */
+struct ProgressEngineTCP::Poller {
+  using ready_list = std::vector<std::pair<std::size_t, unsigned>>;
+
+#ifdef __linux__
+  Poller() {
+    SYSCHECK(_epoll_fd = ::epoll_create1(EPOLL_CLOEXEC))
+  }
+
+  ~Poller() {
+    ::close(_epoll_fd);
+  }
+
+  void add(int fd, std::size_t id, unsigned events) {
+    struct epoll_event event = _toEpoll(id, events);
+    SYSCHECK(::epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd, &event))
+  }
+
+  void modify(int fd, std::size_t id, unsigned events) {
+    struct epoll_event event = _toEpoll(id, events);
+    SYSCHECK(::epoll_ctl(_epoll_fd, EPOLL_CTL_MOD, fd, &event))
+  }
+
+  void remove(int fd) {
+    struct epoll_event event = {};
+    SYSCHECK(::epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, fd, &event))
+  }
+
+  void wait(ready_list& ready) {
+    ready.clear();
+    int num_ready = ::epoll_wait(_epoll_fd, _events, MAX_EVENTS, -1);
+    if (num_ready < 0) {
+      if (errno == EINTR)
+        return;
+      throw std::system_error(errno, std::system_category());
+    }
+
+    for (int i = 0; i < num_ready; ++i) {
+      unsigned events = 0;
+      if (_events[i].events & EPOLLIN) events |= EVENT_READ;
+      if (_events[i].events & EPOLLOUT) events |= EVENT_WRITE;
+      if (_events[i].events & (EPOLLERR | EPOLLHUP)) events |= EVENT_ERROR;
+      ready.emplace_back(static_cast<std::size_t>(_events[i].data.u64), events);
+    }
+  }
+
+private:
+  static struct epoll_event _toEpoll(std::size_t id, unsigned events) {
+    struct epoll_event event = {};
+    if (events & EVENT_READ) event.events |= EPOLLIN;
+    if (events & EVENT_WRITE) event.events |= EPOLLOUT;
+    event.data.u64 = id;
+    return event;
+  }
+
+  static constexpr int MAX_EVENTS = 64;
+
+  int _epoll_fd;
+  struct epoll_event _events[MAX_EVENTS];
+#else
+  void add(int fd, std::size_t id, unsigned events) {
+    _fds.push_back({fd, _toPoll(events), 0});
+    _ids.push_back(id);
+  }
+
+  void modify(int fd, std::size_t id, unsigned events) {
+    _fds.at(_find(fd)).events = _toPoll(events);
+  }
+
+  void remove(int fd) {
+    auto pos = _find(fd);
+    _fds.erase(_fds.begin() + pos);
+    _ids.erase(_ids.begin() + pos);
+  }
+
+  void wait(ready_list& ready) {
+    ready.clear();
+    for (auto& pfd : _fds)
+      pfd.revents = 0;
+
+    if (::poll(_fds.data(), _fds.size(), -1) < 0) {
+      if (errno == EINTR)
+        return;
+      throw std::system_error(errno, std::system_category());
+    }
+
+    for (std::size_t i = 0; i < _fds.size(); ++i) {
+      unsigned events = 0;
+      if (_fds[i].revents & POLLIN) events |= EVENT_READ;
+      if (_fds[i].revents & POLLOUT) events |= EVENT_WRITE;
+      if (_fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) events |= EVENT_ERROR;
+      if (events != 0)
+        ready.emplace_back(_ids[i], events);
+    }
+  }
+
+private:
+  static short _toPoll(unsigned events) {
+    short poll_events = 0;
+    if (events & EVENT_READ) poll_events |= POLLIN;
+    if (events & EVENT_WRITE) poll_events |= POLLOUT;
+    return poll_events;
+  }
+
+  std::size_t _find(int fd) const {
+    for (std::size_t i = 0; i < _fds.size(); ++i) {
+      if (_fds[i].fd == fd)
+        return i;
+    }
+    throw std::logic_error("descriptor is not registered in the poller");
+  }
+
+  std::vector<struct pollfd> _fds;
+  std::vector<std::size_t> _ids;
+#endif // __linux__
+};
+
+
+ProgressEngineTCP::Options::Options()
+  : sockets_per_peer(1)
+  , chunk_size(DEFAULT_CHUNK_SIZE)
+  , no_delay(true)
+  , send_buffer_size(0)
+  , recv_buffer_size(0)
+{}
+
+
+/*
+ * THD_TCP_SOCKETS_PER_PEER - number of connections between each pair of
+ *   processes (only the value of the master process is used)
+ * THD_TCP_CHUNK_SIZE - largest frame in bytes, larger messages are pipelined
+ * THD_TCP_NODELAY - set to 0 to enable Nagle's algorithm
+ * THD_TCP_SEND_BUFFER_SIZE, THD_TCP_RECV_BUFFER_SIZE - SO_SNDBUF and
+ *   SO_RCVBUF of the sockets in bytes
+ */
+ProgressEngineTCP::Options ProgressEngineTCP::Options::fromEnv() {
+  Options options;
+  options.sockets_per_peer = getEnvOr(SOCKETS_PER_PEER_ENV, options.sockets_per_peer, 1);
+  options.chunk_size = getEnvOr(CHUNK_SIZE_ENV, options.chunk_size, 1);
+  options.no_delay = getEnvOr(NO_DELAY_ENV, options.no_delay, 0) != 0;
+  options.send_buffer_size = getEnvOr(SEND_BUFFER_SIZE_ENV, options.send_buffer_size, 0);
+  options.recv_buffer_size = getEnvOr(RECV_BUFFER_SIZE_ENV, options.recv_buffer_size, 0);
+  return options;
+}
+
+
+ProgressEngineTCP::Operation::Operation(std::uint8_t* data, std::size_t bytes,
+                                        std::shared_ptr<void> keep_alive)
+  : _data(data)
+  , _bytes(bytes)
+  , _keep_alive(std::move(keep_alive))
+  , _peer(0)
+  , _seq(0)
+  , _pending_frames(0)
+  , _received(0)
+  , _wire_bytes(0)
+  , _matched(false)
+  , _completed(false)
+{}
+
+
+bool ProgressEngineTCP::Operation::isCompleted() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_exception)
+    std::rethrow_exception(_exception);
+  return _completed;
+}
+
+
+void ProgressEngineTCP::Operation::wait() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  _cond.wait(lock, [this]{ return _completed; });
+  if (_exception)
+    std::rethrow_exception(_exception);
+}
+
+
+rank_type ProgressEngineTCP::Operation::peer() const {
+  return _peer;
+}
+
+
+void ProgressEngineTCP::Operation::_complete(std::exception_ptr exception) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  if (_completed)
+    return;
+
+  _completed = true;
+  _exception = exception;
+  _keep_alive.reset();
+  lock.unlock();
+  _cond.notify_all();
+}
+
+
+ProgressEngineTCP::ProgressEngineTCP(rank_type rank,
+                                     std::vector<std::vector<int>> sockets,
+                                     Options options)
+  : _rank(rank)
+  , _options(options)
+  , _peers(sockets.size())
+  , _discard_buffer(std::min(options.chunk_size, DISCARD_BUFFER_SIZE))
+  , _poller(new Poller())
+  , _exiting(false)
+{
+  SYSCHECK(::pipe(_wake_pipe))
+  setNonBlocking(_wake_pipe[0]);
+  setNonBlocking(_wake_pipe[1]);
+  _poller->add(_wake_pipe[0], WAKE_UP_ID, EVENT_READ);
+
+  for (rank_type peer_rank = 0; peer_rank < sockets.size(); ++peer_rank) {
+    auto& peer = _peers[peer_rank];
+    peer.next_send_seq = 0;
+    peer.next_recv_seq = 0;
+
+    for (int fd : sockets[peer_rank]) {
+      setNonBlocking(fd);
+      setIntOption(fd, IPPROTO_TCP, TCP_NODELAY, _options.no_delay);
+      if (_options.send_buffer_size > 0)
+        setIntOption(fd, SOL_SOCKET, SO_SNDBUF, _options.send_buffer_size);
+      if (_options.recv_buffer_size > 0)
+        setIntOption(fd, SOL_SOCKET, SO_RCVBUF, _options.recv_buffer_size);
+#ifdef SO_NOSIGPIPE
+      setIntOption(fd, SOL_SOCKET, SO_NOSIGPIPE, 1);
+#endif // SO_NOSIGPIPE
+
+      Socket socket;
+      socket.fd = fd;
+      socket.peer = peer_rank;
+      socket.closed = false;
+      socket.registered_events = EVENT_READ;
+      socket.sent = 0;
+      socket.header_received = 0;
+      socket.payload_received = 0;
+      socket.waiting_for_receive = false;
+
+      peer.sockets.push_back(_sockets.size());
+      _poller->add(fd, _sockets.size(), socket.registered_events);
+      _sockets.push_back(std::move(socket));
+    }
+  }
+
+  _progress_thread = std::thread(&ProgressEngineTCP::_run, this);
+}
+
+
+ProgressEngineTCP::~ProgressEngineTCP() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _exiting = true;
+  }
+  _wakeUp();
+  _progress_thread.join();
+
+  // nobody will make progress on the remaining operations anymore
+  auto error = std::make_exception_ptr(std::runtime_error(
+    "TCP data channel was destroyed before the operation completed"));
+  for (rank_type rank = 0; rank < _peers.size(); ++rank)
+    _failPeer(rank, error);
+  for (auto& op : _any_receives)
+    op->_complete(error);
+
+  ::close(_wake_pipe[0]);
+  ::close(_wake_pipe[1]);
+}
+
+
+ProgressEngineTCP::op_ptr ProgressEngineTCP::send(rank_type dst_rank,
+                                                  const void* data,
+                                                  std::size_t bytes,
+                                                  std::shared_ptr<void> keep_alive) {
+  op_ptr op(new Operation(
+    const_cast<std::uint8_t*>(reinterpret_cast<const std::uint8_t*>(data)),
+    bytes,
+    std::move(keep_alive)
+  ));
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  auto& peer = _mustGetPeer(dst_rank);
+  op->_peer = dst_rank;
+  if (peer.error) {
+    op->_complete(peer.error);
+    return op;
+  }
+
+  op->_seq = peer.next_send_seq++;
+  std::size_t num_sockets = peer.sockets.size();
+  std::size_t num_frames = std::max<std::size_t>(
+    1, (bytes + _options.chunk_size - 1) / _options.chunk_size);
+
+  // the peer has closed some of the sockets this message would go through
+  for (std::size_t i = 0; i < std::min(num_frames, num_sockets); ++i) {
+    if (_sockets[peer.sockets[(op->_seq + i) % num_sockets]].closed) {
+      op->_complete(connectionReset());
+      return op;
+    }
+  }
+
+  op->_pending_frames = num_frames;
+  for (std::size_t i = 0; i < num_frames; ++i) {
+    std::uint64_t offset = i * _options.chunk_size;
+    Frame frame;
+    frame.header.seq = op->_seq;
+    frame.header.total_bytes = bytes;
+    frame.header.offset = offset;
+    frame.header.length = std::min<std::uint64_t>(_options.chunk_size, bytes - offset);
+    frame.op = op;
+
+    // consecutive frames and messages go round-robin over the sockets
+    auto& socket = _sockets[peer.sockets[(op->_seq + i) % num_sockets]];
+    socket.send_queue.push_back(std::move(frame));
+  }
+
+  lock.unlock();
+  _wakeUp();
+  return op;
+}
+
+
+ProgressEngineTCP::op_ptr ProgressEngineTCP::receive(rank_type src_rank,
+                                                     void* data,
+                                                     std::size_t bytes,
+                                                     std::string mismatch_error,
+                                                     std::shared_ptr<void> keep_alive) {
+  op_ptr op(new Operation(reinterpret_cast<std::uint8_t*>(data), bytes,
+                          std::move(keep_alive)));
+  op->_mismatch_error = std::move(mismatch_error);
+  return _postReceive(op, src_rank);
+}
+
+
+ProgressEngineTCP::op_ptr ProgressEngineTCP::receiveAny(void* data,
+                                                        std::size_t bytes,
+                                                        std::string mismatch_error,
+                                                        std::shared_ptr<void> keep_alive) {
+  op_ptr op(new Operation(reinterpret_cast<std::uint8_t*>(data), bytes,
+                          std::move(keep_alive)));
+  op->_mismatch_error = std::move(mismatch_error);
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  bool any_peer_alive = false;
+  for (rank_type rank = 0; rank < _peers.size(); ++rank) {
+    if (rank != _rank && !_peers[rank].error)
+      any_peer_alive = true;
+  }
+
+  if (!any_peer_alive) {
+    op->_complete(connectionReset());
+    return op;
+  }
+
+  _any_receives.push_back(op);
+  lock.unlock();
+  _wakeUp();
+  return op;
+}
+
+
+ProgressEngineTCP::op_ptr ProgressEngineTCP::_postReceive(op_ptr op,
+                                                          rank_type src_rank) {
+  std::unique_lock<std::mutex> lock(_mutex);
+  auto& peer = _mustGetPeer(src_rank);
+  op->_peer = src_rank;
+  if (peer.error) {
+    op->_complete(peer.error);
+    return op;
+  }
+
+  op->_seq = peer.next_recv_seq++;
+  peer.receives.emplace(op->_seq, op);
+  lock.unlock();
+  _wakeUp();
+  return op;
+}
+
+
+void ProgressEngineTCP::_wakeUp() {
+  std::uint8_t byte = 1;
+  // a full pipe already has a wake up pending, so the result can be ignored
+  ssize_t written = ::write(_wake_pipe[1], &byte, 1);
+  (void)written;
+}
+
+
+void ProgressEngineTCP::_run() {
+  Poller::ready_list ready;
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (!_exiting) {
+    _matchWaitingSockets();
+    _updateEvents();
+
+    lock.unlock();
+    _poller->wait(ready);
+    lock.lock();
+
+    for (const auto& event : ready) {
+      if (event.first == WAKE_UP_ID) {
+        std::uint8_t bytes[64];
+        while (::read(_wake_pipe[0], bytes, sizeof(bytes)) > 0) /* empty */;
+        continue;
+      }
+
+      auto& socket = _sockets[event.first];
+      if (socket.closed)
+        continue;
+
+      try {
+        if (event.second & EVENT_READ)
+          _readSocket(socket);
+        if (!socket.closed && (event.second & EVENT_WRITE))
+          _writeSocket(socket);
+        if (!socket.closed && (event.second & EVENT_ERROR)) {
+          int error = 0;
+          socklen_t error_len = sizeof(error);
+          ::getsockopt(socket.fd, SOL_SOCKET, SO_ERROR, &error, &error_len);
+          throw std::system_error(error != 0 ? error : ECONNRESET, std::system_category());
+        }
+      } catch (...) {
+        _failPeer(socket.peer, std::current_exception());
+      }
+    }
+  }
+}
+
+
+void ProgressEngineTCP::_updateEvents() {
+  for (std::size_t i = 0; i < _sockets.size(); ++i) {
+    auto& socket = _sockets[i];
+    if (socket.closed)
+      continue;
+
+    unsigned events = 0;
+    if (!socket.waiting_for_receive)
+      events |= EVENT_READ;
+    if (!socket.send_queue.empty())
+      events |= EVENT_WRITE;
+
+    if (events != socket.registered_events) {
+      _poller->modify(socket.fd, i, events);
+      socket.registered_events = events;
+    }
+  }
+}
+
+
+void ProgressEngineTCP::_matchWaitingSockets() {
+  for (auto& socket : _sockets) {
+    if (socket.closed || !socket.waiting_for_receive)
+      continue;
+
+    try {
+      if (_matchReceive(socket) && socket.recv_header.length == 0)
+        _finishFrame(socket);
+    } catch (...) {
+      _failPeer(socket.peer, std::current_exception());
+    }
+  }
+}
+
+
+bool ProgressEngineTCP::_matchReceive(Socket& socket) {
+  const auto& header = socket.recv_header;
+  if (header.offset > header.total_bytes ||
+      header.length > header.total_bytes - header.offset)
+    throw std::runtime_error("received a malformed frame");
+
+  auto& peer = _peers[socket.peer];
+  op_ptr op;
+  auto it = peer.receives.find(header.seq);
+  if (it != peer.receives.end()) {
+    op = it->second;
+  } else if (header.seq == peer.next_recv_seq && !_any_receives.empty()) {
+    op = _any_receives.front();
+    _any_receives.pop_front();
+    op->_peer = socket.peer;
+    op->_seq = peer.next_recv_seq++;
+    peer.receives.emplace(op->_seq, op);
+  } else {
+    socket.waiting_for_receive = true;
+    return false;
+  }
+
+  if (!op->_matched) {
+    op->_matched = true;
+    op->_wire_bytes = header.total_bytes;
+  } else if (op->_wire_bytes != header.total_bytes) {
+    throw std::runtime_error("received a malformed frame");
+  }
+
+  socket.recv_op = op;
+  socket.waiting_for_receive = false;
+  return true;
+}
+
+
+void ProgressEngineTCP::_readSocket(Socket& socket) {
+  constexpr std::size_t header_size = sizeof(FrameHeader);
+
+  // bound the time spent on one socket, so that all peers make progress
+  std::size_t budget = _options.chunk_size;
+  while (!socket.closed && !socket.waiting_for_receive && budget > 0) {
+    bool reading_header = socket.header_received < header_size;
+    std::uint8_t* target;
+    std::size_t length;
+    if (reading_header) {
+      target = reinterpret_cast<std::uint8_t*>(&socket.recv_header) + socket.header_received;
+      length = header_size - socket.header_received;
+    } else {
+      const auto& op = socket.recv_op;
+      length = socket.recv_header.length - socket.payload_received;
+      if (op->_wire_bytes == op->_bytes) {
+        target = op->_data + socket.recv_header.offset + socket.payload_received;
+      } else { // remove invalid data from recv buffer
+        target = _discard_buffer.data();
+        length = std::min(length, _discard_buffer.size());
+      }
+    }
+
+    ssize_t bytes = ::recv(socket.fd, target, length, 0);
+    if (bytes < 0) {
+      if (wouldBlock(errno))
+        return;
+      if (errno == EINTR)
+        continue;
+      throw std::system_error(errno, std::system_category());
+    }
+
+    if (bytes == 0) {
+      // the peer has closed the connection, which is fine between frames
+      // if nothing has to be sent there anymore
+      if (socket.header_received != 0 || !socket.send_queue.empty())
+        throw std::system_error(ECONNRESET, std::system_category());
+
+      socket.closed = true;
+      _poller->remove(socket.fd);
+
+      auto& peer = _peers[socket.peer];
+      bool all_closed = std::all_of(peer.sockets.begin(), peer.sockets.end(),
+        [this](std::size_t i) { return _sockets[i].closed; });
+      if (all_closed)
+        _failPeer(socket.peer, connectionReset());
+      return;
+    }
+
+    budget -= std::min(budget, static_cast<std::size_t>(bytes));
+    if (reading_header) {
+      socket.header_received += bytes;
+      if (socket.header_received < header_size)
+        continue;
+      if (!_matchReceive(socket))
+        return;
+      if (socket.recv_header.length == 0)
+        _finishFrame(socket);
+    } else {
+      socket.payload_received += bytes;
+      if (socket.payload_received == socket.recv_header.length)
+        _finishFrame(socket);
+    }
+  }
+}
+
+
+void ProgressEngineTCP::_writeSocket(Socket& socket) {
+  constexpr std::size_t header_size = sizeof(FrameHeader);
+
+  std::size_t budget = _options.chunk_size;
+  while (!socket.send_queue.empty() && budget > 0) {
+    auto& frame = socket.send_queue.front();
+    std::size_t frame_size = header_size + frame.header.length;
+
+    // write the rest of the header and the payload with a single call
+    struct iovec iov[2];
+    int iov_count = 0;
+    if (socket.sent < header_size) {
+      iov[iov_count].iov_base = reinterpret_cast<std::uint8_t*>(&frame.header) + socket.sent;
+      iov[iov_count].iov_len = header_size - socket.sent;
+      ++iov_count;
+    }
+    std::size_t payload_sent = socket.sent > header_size ? socket.sent - header_size : 0;
+    if (payload_sent < frame.header.length) {
+      iov[iov_count].iov_base = frame.op->_data + frame.header.offset + payload_sent;
+      iov[iov_count].iov_len = frame.header.length - payload_sent;
+      ++iov_count;
+    }
+
+    struct msghdr message;
+    std::memset(&message, 0, sizeof(message));
+    message.msg_iov = iov;
+    message.msg_iovlen = iov_count;
+
+    ssize_t bytes = ::sendmsg(socket.fd, &message, SEND_FLAGS);
+    if (bytes < 0) {
+      if (wouldBlock(errno))
+        return;
+      if (errno == EINTR)
+        continue;
+      throw std::system_error(errno, std::system_category());
+    }
+
+    socket.sent += bytes;
+    budget -= std::min(budget, static_cast<std::size_t>(bytes));
+    if (socket.sent < frame_size)
+      continue;
+
+    auto op = std::move(frame.op);
+    socket.send_queue.pop_front();
+    socket.sent = 0;
+    if (--op->_pending_frames == 0)
+      op->_complete();
+  }
+}
+
+
+void ProgressEngineTCP::_finishFrame(Socket& socket) {
+  auto op = std::move(socket.recv_op);
+  socket.recv_op.reset();
+  op->_received += socket.recv_header.length;
+  socket.header_received = 0;
+  socket.payload_received = 0;
+
+  if (op->_received < op->_wire_bytes)
+    return;
+
+  _peers[socket.peer].receives.erase(op->_seq);
+  if (op->_wire_bytes == op->_bytes) {
+    op->_complete();
+  } else {
+    op->_complete(std::make_exception_ptr(std::logic_error(op->_mismatch_error)));
+  }
+}
+
+
+void ProgressEngineTCP::_failPeer(rank_type rank, std::exception_ptr error) {
+  auto& peer = _peers[rank];
+  if (!peer.error)
+    peer.error = error;
+
+  for (auto i : peer.sockets) {
+    auto& socket = _sockets[i];
+    if (!socket.closed) {
+      socket.closed = true;
+      _poller->remove(socket.fd);
+    }
+
+    for (auto& frame : socket.send_queue)
+      frame.op->_complete(peer.error);
+    socket.send_queue.clear();
+    socket.sent = 0;
+    socket.recv_op.reset();
+    socket.header_received = 0;
+    socket.payload_received = 0;
+    socket.waiting_for_receive = false;
+  }
+
+  for (auto& entry : peer.receives)
+    entry.second->_complete(peer.error);
+  peer.receives.clear();
+}
+
+
+ProgressEngineTCP::Peer& ProgressEngineTCP::_mustGetPeer(rank_type rank) {
+  if (rank >= _peers.size() || rank == _rank)
+    throw std::out_of_range("invalid peer rank: " + std::to_string(rank));
+  return _peers[rank];
+}
+
+} // namespace thd
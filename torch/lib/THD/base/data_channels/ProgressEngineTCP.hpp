@@ -0,0 +1,173 @@
+#pragma once
+
+#include "../ChannelUtils.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace thd {
+
+/*
+ * Moves the point-to-point messages of DataChannelTCP over non-blocking
+ * sockets. Operations are queued from any thread and a single progress
+ * thread multiplexes all sockets (epoll on Linux, poll elsewhere), so a slow
+ * or silent peer never stalls the transfers with other peers.
+ *
+ * Every message is split into frames of at most `chunk_size` bytes. Each frame
+ * carries the sequence number of its message on the (sender -> receiver)
+ * stream, so the frames of a message can be spread over several sockets to the
+ * same peer and reassembled on the other side. The n-th message sent to a peer
+ * is matched with the n-th receive posted for that peer, like on a single
+ * stream. A socket whose next frame belongs to a receive that is not posted
+ * yet is not read until it is, and its data stays in the kernel buffers.
+ */
+struct ProgressEngineTCP {
+  struct Options {
+    Options();
+
+    // Reads the THD_TCP_* environment variables, see the definition.
+    static Options fromEnv();
+
+    std::size_t sockets_per_peer;
+    std::size_t chunk_size;
+    bool no_delay;
+    int send_buffer_size; // 0 keeps the system default
+    int recv_buffer_size; // 0 keeps the system default
+  };
+
+  struct Operation {
+    Operation(const Operation&) = delete;
+    Operation& operator=(const Operation&) = delete;
+
+    bool isCompleted();
+    void wait();
+
+    // Rank of the peer; for receives from any source it is valid after `wait`.
+    rank_type peer() const;
+
+  private:
+    friend struct ProgressEngineTCP;
+
+    Operation(std::uint8_t* data, std::size_t bytes, std::shared_ptr<void> keep_alive);
+
+    void _complete(std::exception_ptr exception = nullptr);
+
+    std::uint8_t* _data;
+    std::size_t _bytes;
+    std::shared_ptr<void> _keep_alive; // keeps the buffer alive while in flight
+    rank_type _peer;
+    std::uint64_t _seq;
+    std::size_t _pending_frames; // sends: frames not written yet
+    std::size_t _received; // receives: payload bytes read so far
+    std::uint64_t _wire_bytes; // receives: size announced by the sender
+    bool _matched; // receives: a frame of the message was read
+    std::string _mismatch_error;
+
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    bool _completed;
+    std::exception_ptr _exception;
+  };
+
+  using op_ptr = std::shared_ptr<Operation>;
+
+  /*
+   * `sockets[rank]` are the connected sockets to the process with `rank` and
+   * are empty for this process. The sockets are switched to non-blocking mode
+   * and are not closed by the engine.
+   */
+  ProgressEngineTCP(rank_type rank, std::vector<std::vector<int>> sockets,
+                    Options options = Options());
+  ~ProgressEngineTCP();
+
+  ProgressEngineTCP(const ProgressEngineTCP&) = delete;
+  ProgressEngineTCP& operator=(const ProgressEngineTCP&) = delete;
+
+  op_ptr send(rank_type dst_rank, const void* data, std::size_t bytes,
+              std::shared_ptr<void> keep_alive = nullptr);
+  /*
+   * If the sender sends a message of a different size the operation fails
+   * with std::logic_error(mismatch_error) once the message is drained.
+   */
+  op_ptr receive(rank_type src_rank, void* data, std::size_t bytes,
+                 std::string mismatch_error,
+                 std::shared_ptr<void> keep_alive = nullptr);
+  op_ptr receiveAny(void* data, std::size_t bytes, std::string mismatch_error,
+                    std::shared_ptr<void> keep_alive = nullptr);
+
+private:
+  struct FrameHeader {
+    std::uint64_t seq;
+    std::uint64_t total_bytes; // size of the whole message
+    std::uint64_t offset;
+    std::uint64_t length;
+  };
+
+  struct Frame {
+    FrameHeader header;
+    op_ptr op;
+  };
+
+  struct Socket {
+    int fd;
+    rank_type peer;
+    bool closed;
+    unsigned registered_events;
+
+    std::deque<Frame> send_queue;
+    std::size_t sent; // bytes of the first frame in `send_queue` written so far
+
+    FrameHeader recv_header;
+    std::size_t header_received;
+    std::size_t payload_received;
+    op_ptr recv_op; // receive the frame being read belongs to
+    bool waiting_for_receive; // header read, but its receive is not posted
+  };
+
+  struct Peer {
+    std::vector<std::size_t> sockets; // indices in `_sockets`
+    std::uint64_t next_send_seq;
+    std::uint64_t next_recv_seq;
+    std::unordered_map<std::uint64_t, op_ptr> receives; // by sequence number
+    std::exception_ptr error;
+  };
+
+  struct Poller;
+
+  op_ptr _postReceive(op_ptr op, rank_type src_rank);
+  void _wakeUp();
+  void _run();
+  void _updateEvents();
+  void _matchWaitingSockets();
+  bool _matchReceive(Socket& socket);
+  void _readSocket(Socket& socket);
+  void _writeSocket(Socket& socket);
+  void _finishFrame(Socket& socket);
+  void _failPeer(rank_type rank, std::exception_ptr error);
+  Peer& _mustGetPeer(rank_type rank);
+
+  rank_type _rank;
+  Options _options;
+  std::vector<Socket> _sockets;
+  std::vector<Peer> _peers;
+  std::deque<op_ptr> _any_receives;
+  std::vector<std::uint8_t> _discard_buffer; // sink of mismatched messages
+
+  std::unique_ptr<Poller> _poller;
+  int _wake_pipe[2];
+
+  // Protects the queues above, it is released only while waiting for events.
+  std::mutex _mutex;
+  bool _exiting;
+  std::thread _progress_thread;
+};
+
+} // namespace thd
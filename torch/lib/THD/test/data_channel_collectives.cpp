@@ -45,6 +45,25 @@ void test_send_recv_tensor(std::shared_ptr<thd::DataChannel> data_channel) {
   }
 }
 
+void test_send_recv_large_tensor(std::shared_ptr<thd::DataChannel> data_channel) {
+  if (g_data_channel_type == "gloo") {
+    return; // XXX: Gloo does not support send/recv
+  }
+
+  // larger than a TCP frame, both directions at once
+  auto rank = data_channel->getRank();
+  if (rank == 0 || rank == 1) {
+    auto send_tensor = buildTensor<float>({4, 1024, 1024}, rank + 1);
+    auto recv_tensor = buildTensor<float>({4, 1024, 1024}, -1);
+    auto request = std::shared_ptr<thd::DataChannel::Request>(
+      data_channel->isend(*send_tensor, 1 - rank)
+    );
+    data_channel->receive(*recv_tensor, 1 - rank);
+    request->wait();
+    ASSERT_TENSOR_VALUE(float, *recv_tensor, 2 - rank);
+  }
+}
+
 void test_send_recv_tensor_any_source(std::shared_ptr<thd::DataChannel> data_channel,
                                       int workers) {
   if (g_data_channel_type == "gloo") {
@@ -613,6 +632,7 @@ void test_tensors_are_not_the_same(std::shared_ptr<thd::DataChannel> data_channe
 
 void run_all_tests(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
   test_send_recv_tensor(data_channel);
+  test_send_recv_large_tensor(data_channel);
   test_send_recv_tensor_any_source(data_channel, workers);
   test_send_recv_scalar(data_channel);
   test_broadcast(data_channel);
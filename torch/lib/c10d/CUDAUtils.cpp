@@ -23,12 +23,27 @@ CUDAEvent::~CUDAEvent() {
   }
 }
 
-CUDAStream CUDAStream::create() {
+CUDAStream CUDAStream::create(bool highPriority) {
   CUDAStream stream;
-  stream.stream_ = THCStream_new(cudaStreamNonBlocking);
+  if (highPriority) {
+    // The greatest priority is the lowest number
+    int leastPriority;
+    int greatestPriority;
+    C10D_CUDA_CHECK(
+        cudaDeviceGetStreamPriorityRange(&leastPriority, &greatestPriority));
+    stream.stream_ =
+        THCStream_newWithPriority(cudaStreamNonBlocking, greatestPriority);
+  } else {
+    stream.stream_ = THCStream_new(cudaStreamNonBlocking);
+  }
   return stream;
 }
 
+CUDAStream CUDAStream::share() const {
+  THCStream_retain(stream_);
+  return CUDAStream(stream_);
+}
+
 CUDAStream::~CUDAStream() {
   if (stream_ != nullptr) {
     THCStream_free(stream_);
@@ -40,4 +55,32 @@ cudaStream_t CUDAStream::getStream() const {
   return THCStream_stream(stream_);
 }
 
+CUDAEvent CUDAEventPool::get(int device) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto& events = events_[device];
+    if (!events.empty()) {
+      auto event = std::move(events.back());
+      events.pop_back();
+      return event;
+    }
+    ++numCreated_;
+  }
+  at::DeviceGuard guard(device);
+  return CUDAEvent::create(flags_);
+}
+
+void CUDAEventPool::put(CUDAEvent&& event) {
+  if (event.getEvent() == nullptr) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  events_[event.getDevice()].push_back(std::move(event));
+}
+
+size_t CUDAEventPool::numCreated() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return numCreated_;
+}
+
 } // namespace c10d
@@ -3,6 +3,9 @@
 typedef struct CUDAStreamInternals THCStream;
 
 #include <algorithm>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <cuda.h>
 #include <cuda_runtime.h>
@@ -25,7 +28,7 @@ class CUDAEvent {
   CUDAEvent(const CUDAEvent&) = delete;
 
   // Must be move constructable.
-  CUDAEvent(CUDAEvent&& other) {
+  CUDAEvent(CUDAEvent&& other) : CUDAEvent() {
     std::swap(event_, other.event_);
     std::swap(device_, other.device_);
   }
@@ -64,14 +67,19 @@ class CUDAStream {
 
   ~CUDAStream();
 
-  static CUDAStream create();
+  // Creates a stream on the current device. A high priority stream runs its
+  // kernels ahead of the pending kernels of lower priority streams.
+  static CUDAStream create(bool highPriority = false);
+
+  // Returns another owner of the same stream.
+  CUDAStream share() const;
 
   // Must not be copyable.
   CUDAStream& operator=(const CUDAStream&) = delete;
   CUDAStream(const CUDAStream&) = delete;
 
   // Must be move constructable.
-  CUDAStream(CUDAStream&& other) {
+  CUDAStream(CUDAStream&& other) : CUDAStream() {
     std::swap(stream_, other.stream_);
   }
 
@@ -91,4 +99,29 @@ class CUDAStream {
   THCStream* stream_;
 };
 
+// Pool of CUDA events created with the same flags, so that short lived
+// users of events don't create and destroy an event every time.
+//
+// Safe to use from multiple threads.
+class CUDAEventPool {
+ public:
+  explicit CUDAEventPool(unsigned int flags = cudaEventDefault)
+      : flags_(flags) {}
+
+  // Returns an event of the device, which is created if the pool has none.
+  CUDAEvent get(int device);
+
+  // Returns an event to the pool.
+  void put(CUDAEvent&& event);
+
+  // The number of events created by the pool
+  size_t numCreated() const;
+
+ protected:
+  const unsigned int flags_;
+  mutable std::mutex mutex_;
+  std::unordered_map<int, std::vector<CUDAEvent>> events_;
+  size_t numCreated_ = 0;
+};
+
 } // namespace c10d
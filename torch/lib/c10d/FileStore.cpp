@@ -7,10 +7,17 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <sstream>
 #include <system_error>
 #include <thread>
@@ -118,7 +125,7 @@ class File {
     while (count > 0) {
       auto rv = syscall(std::bind(::write, fd_, buf, count));
       SYSASSERT(rv, "write");
-      buf = (uint8_t*)buf + count;
+      buf = (uint8_t*)buf + rv;
       count -= rv;
     }
   }
@@ -127,7 +134,7 @@ class File {
     while (count > 0) {
       auto rv = syscall(std::bind(::read, fd_, buf, count));
       SYSASSERT(rv, "read");
-      buf = (uint8_t*)buf + count;
+      buf = (uint8_t*)buf + rv;
       count -= rv;
     }
   }
@@ -165,6 +172,67 @@ class File {
   int fd_;
 };
 
+constexpr std::chrono::milliseconds kMinPollInterval(10);
+constexpr std::chrono::milliseconds kMaxPollInterval(1000);
+
+// Waits for a file to change. On Linux, inotify wakes the waiter up as soon
+// as a process on this host writes to the file, but it doesn't see writes
+// from other hosts on shared filesystems (such as NFS). Every wait is
+// therefore also bounded by a poll interval, which doubles while the file
+// doesn't change so that many waiting ranks don't hammer the filesystem.
+class FileWatcher {
+ public:
+  explicit FileWatcher(const std::string& path)
+      : fd_(-1), interval_(kMinPollInterval) {
+#ifdef __linux__
+    fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd_ >= 0 && ::inotify_add_watch(fd_, path.c_str(), IN_MODIFY) < 0) {
+      ::close(fd_);
+      fd_ = -1;
+    }
+#endif
+  }
+
+  ~FileWatcher() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  FileWatcher(const FileWatcher& that) = delete;
+
+  // Blocks until the file may have changed, for at most the current poll
+  // interval and limit.
+  void wait(std::chrono::milliseconds limit) {
+    const auto interval = std::min(interval_, limit);
+    interval_ = std::min(interval_ * 2, kMaxPollInterval);
+#ifdef __linux__
+    if (fd_ >= 0) {
+      struct pollfd pfd = {fd_, POLLIN, 0};
+      auto rv = syscall(
+          std::bind(::poll, &pfd, 1, static_cast<int>(interval.count())));
+      SYSASSERT(rv, "poll");
+      // Drain the events; they only tell us to look at the file again.
+      char buf[4096];
+      while (::read(fd_, buf, sizeof(buf)) > 0) {
+      }
+      return;
+    }
+#endif
+    /* sleep override */
+    std::this_thread::sleep_for(interval);
+  }
+
+  // Restarts the backoff after the file has changed.
+  void reset() {
+    interval_ = kMinPollInterval;
+  }
+
+ protected:
+  int fd_;
+  std::chrono::milliseconds interval_;
+};
+
 off_t refresh(
     File& file,
     off_t pos,
@@ -199,18 +267,28 @@ void FileStore::set(const std::string& key, const std::vector<uint8_t>& value) {
 }
 
 std::vector<uint8_t> FileStore::get(const std::string& key) {
+  std::unique_ptr<FileWatcher> watcher;
   while (cache_.count(key) == 0) {
     File file(path_, O_RDONLY);
     auto lock = file.lockShared();
     auto size = file.size();
     if (size == pos_) {
-      // No new entries; release the shared lock and sleep for a bit
+      // No new entries; release the shared lock and wait for the file to
+      // change. The watcher is started before looking at the file once
+      // more, so that a write in between is not missed.
       lock.unlock();
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      if (watcher) {
+        watcher->wait(kMaxPollInterval);
+      } else {
+        watcher.reset(new FileWatcher(path_));
+      }
       continue;
     }
 
     pos_ = refresh(file, pos_, cache_);
+    if (watcher) {
+      watcher->reset();
+    }
   }
 
   return cache_[key];
@@ -254,18 +332,30 @@ bool FileStore::check(const std::vector<std::string>& keys) {
 void FileStore::wait(
     const std::vector<std::string>& keys,
     const std::chrono::milliseconds& timeout) {
-  // Not using inotify because it doesn't work on many
-  // shared filesystems (such as NFS).
   const auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<FileWatcher> watcher;
+  auto pos = pos_;
   while (!check(keys)) {
-    const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::steady_clock::now() - start);
     if (timeout != kNoTimeout && elapsed > timeout) {
       throw std::runtime_error("Wait timeout");
     }
 
-    /* sleep override */
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (!watcher) {
+      // Look at the file once more after starting to watch it; see get().
+      watcher.reset(new FileWatcher(path_));
+      continue;
+    }
+    if (pos_ != pos) {
+      pos = pos_;
+      watcher->reset();
+    }
+    auto limit = kMaxPollInterval;
+    if (timeout != kNoTimeout) {
+      limit = std::min(limit, timeout - elapsed);
+    }
+    watcher->wait(limit);
   }
 }
 
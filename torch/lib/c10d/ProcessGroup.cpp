@@ -2,10 +2,176 @@
 
 namespace c10d {
 
+namespace {
+
+// Tensors are only coalesced with tensors of the same type on the same
+// device.
+std::string getCoalescingKey(const at::Tensor& tensor) {
+  return std::string(tensor.type().toString()) + ":" +
+      std::to_string(tensor.type().is_cuda() ? tensor.get_device() : -1);
+}
+
+} // namespace
+
 ProcessGroup::Work::~Work() {}
 
+bool ProcessGroup::CompletedWork::isCompleted() const {
+  return true;
+}
+
+bool ProcessGroup::CompletedWork::isSuccess() const {
+  return true;
+}
+
+void ProcessGroup::CompletedWork::synchronize() {}
+
+bool ProcessGroup::CompletedWork::wait() {
+  return true;
+}
+
+const std::exception& ProcessGroup::CompletedWork::exception() const {
+  throw std::runtime_error(
+      "exception() is not supported by completed work, since its "
+      "collective either succeeded or threw");
+}
+
 ProcessGroup::ProcessGroup(int rank, int size) : rank_(rank), size_(size) {}
 
 ProcessGroup::~ProcessGroup() {}
 
+std::shared_ptr<ProcessGroup::Work> ProcessGroup::allreduceCoalesced(
+    std::vector<at::Tensor>& tensors,
+    const AllreduceCoalescedOptions& opts) {
+  struct Bucket {
+    std::string key;
+    std::vector<size_t> indices;
+    int64_t numel = 0;
+    int64_t bytes = 0;
+  };
+
+  // Fill the buckets in the order of the tensors, with an open bucket for
+  // every type and device.
+  std::vector<Bucket> buckets;
+  std::unordered_map<std::string, size_t> openBuckets;
+  for (size_t i = 0; i < tensors.size(); i++) {
+    const auto& tensor = tensors[i];
+    if (tensor.type().is_sparse()) {
+      throw std::invalid_argument(
+          "allreduceCoalesced only supports dense tensors");
+    }
+    const auto key = getCoalescingKey(tensor);
+    const int64_t bytes = tensor.numel() * tensor.type().elementSizeInBytes();
+    auto it = openBuckets.find(key);
+    if (it == openBuckets.end() ||
+        (buckets[it->second].bytes > 0 &&
+         buckets[it->second].bytes + bytes > opts.bucketBytes)) {
+      buckets.emplace_back();
+      buckets.back().key = key;
+      openBuckets[key] = buckets.size() - 1;
+    }
+    auto& bucket = buckets[openBuckets[key]];
+    bucket.indices.push_back(i);
+    bucket.numel += tensor.numel();
+    bucket.bytes += bytes;
+  }
+
+  // Pack every bucket into its flat buffer, and start its allreduce. The
+  // buffers are taken out of the cache for the duration of the call, so
+  // that concurrent calls don't share them, and are put back in the same
+  // order, so that the same buffers are used by every call for the same
+  // tensors.
+  AllreduceOptions allreduceOpts;
+  allreduceOpts.reduceOp = opts.reduceOp;
+  std::vector<std::string> bufferKeys(buckets.size());
+  std::vector<std::vector<at::Tensor>> flats(buckets.size());
+  std::vector<std::shared_ptr<Work>> works(buckets.size());
+  for (size_t b = 0; b < buckets.size(); b++) {
+    const auto& bucket = buckets[b];
+    const auto& first = tensors[bucket.indices[0]];
+    bufferKeys[b] = bucket.key + ":" + std::to_string(bucket.numel);
+    at::Tensor buffer;
+    {
+      std::lock_guard<std::mutex> lock(coalescedBuffersMutex_);
+      auto& buffers = coalescedBuffers_[bufferKeys[b]];
+      if (!buffers.empty()) {
+        buffer = std::move(buffers.back());
+        buffers.pop_back();
+      }
+    }
+    if (!buffer.defined()) {
+      at::DeviceGuard deviceGuard(first);
+      buffer = first.type().tensor({bucket.numel});
+    }
+    flats[b] = {buffer};
+
+    int64_t offset = 0;
+    for (auto i : bucket.indices) {
+      auto& tensor = tensors[i];
+      flats[b][0]
+          .narrow(0, offset, tensor.numel())
+          .view(tensor.sizes())
+          .copy_(tensor);
+      offset += tensor.numel();
+    }
+    works[b] = allreduce(flats[b], allreduceOpts);
+  }
+
+  // Unpack the results
+  for (size_t b = 0; b < buckets.size(); b++) {
+    if (!works[b]->wait()) {
+      throw std::runtime_error(works[b]->exception().what());
+    }
+    int64_t offset = 0;
+    for (auto i : buckets[b].indices) {
+      auto& tensor = tensors[i];
+      tensor.copy_(
+          flats[b][0].narrow(0, offset, tensor.numel()).view(tensor.sizes()));
+      offset += tensor.numel();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(coalescedBuffersMutex_);
+  for (size_t b = buckets.size(); b-- > 0;) {
+    coalescedBuffers_[bufferKeys[b]].push_back(std::move(flats[b][0]));
+  }
+  return std::make_shared<CompletedWork>();
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroup::reduceScatter(
+    std::vector<at::Tensor>&,
+    std::vector<at::Tensor>&,
+    const ReduceScatterOptions&) {
+  throw std::runtime_error("reduceScatter is not supported by this backend");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroup::allgather(
+    std::vector<at::Tensor>&,
+    std::vector<at::Tensor>&) {
+  throw std::runtime_error("allgather is not supported by this backend");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroup::alltoall(
+    std::vector<at::Tensor>&,
+    std::vector<at::Tensor>&) {
+  throw std::runtime_error("alltoall is not supported by this backend");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroup::send(
+    std::vector<at::Tensor>&,
+    int,
+    int) {
+  throw std::runtime_error("send is not supported by this backend");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroup::recv(
+    std::vector<at::Tensor>&,
+    int,
+    int) {
+  throw std::runtime_error("recv is not supported by this backend");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroup::barrier() {
+  throw std::runtime_error("barrier is not supported by this backend");
+}
+
 } // namespace c10d
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <ATen/ATen.h>
@@ -75,6 +78,22 @@ class ProcessGroup {
     virtual const std::exception& exception() const = 0;
   };
 
+  // Work of the collectives that complete before returning, and throw on
+  // errors.
+  class CompletedWork : public Work {
+   public:
+    bool isCompleted() const override;
+
+    bool isSuccess() const override;
+
+    void synchronize() override;
+
+    bool wait() override;
+
+    // Not supported: the collectives throw instead
+    const std::exception& exception() const override;
+  };
+
   explicit ProcessGroup(int rank, int size);
   virtual ~ProcessGroup();
 
@@ -94,9 +113,78 @@ class ProcessGroup {
       std::vector<at::Tensor>& data,
       const AllreduceOptions& opts = AllreduceOptions()) = 0;
 
+  // Allreduces many tensors with few collectives: the tensors are packed by
+  // type and device into flat buffers of up to opts.bucketBytes, every
+  // buffer is allreduced, and the results are copied back into the tensors.
+  // The buffers are kept for the next calls with the same tensor sizes.
+  //
+  // The allreduce of all the buffers is started before waiting for any of
+  // them. The returned work is already completed, and operations on the
+  // tensors issued after it are sequenced after the allreduce.
+  virtual std::shared_ptr<Work> allreduceCoalesced(
+      std::vector<at::Tensor>& tensors,
+      const AllreduceCoalescedOptions& opts = AllreduceCoalescedOptions());
+
+  // Reduces the inputs of all the processes, and leaves the i-th of
+  // getSize() equal chunks of the result in the output of process i. The
+  // input tensors have getSize() times as many elements as the outputs.
+  //
+  // Optional: the default implementation throws.
+  virtual std::shared_ptr<Work> reduceScatter(
+      std::vector<at::Tensor>& outputs,
+      std::vector<at::Tensor>& inputs,
+      const ReduceScatterOptions& opts = ReduceScatterOptions());
+
+  // Concatenates the inputs of all the processes, in the order of their
+  // ranks, into the outputs. The output tensors have getSize() times as many
+  // elements as the inputs.
+  //
+  // Optional: the default implementation throws.
+  virtual std::shared_ptr<Work> allgather(
+      std::vector<at::Tensor>& outputs,
+      std::vector<at::Tensor>& inputs);
+
+  // Splits the input of every process into getSize() equal chunks, and
+  // sends the i-th chunk to process i, which receives the chunks of all the
+  // processes, in the order of their ranks, into its output. The input and
+  // the output tensors have the same number of elements.
+  //
+  // Optional: the default implementation throws.
+  virtual std::shared_ptr<Work> alltoall(
+      std::vector<at::Tensor>& outputs,
+      std::vector<at::Tensor>& inputs);
+
+  // Sends the tensors to process dstRank, which receives them with a recv
+  // of the same tag. Sends and receives between two processes with the same
+  // tag are matched in the order they are issued.
+  //
+  // Optional: the default implementation throws.
+  virtual std::shared_ptr<Work> send(
+      std::vector<at::Tensor>& tensors,
+      int dstRank,
+      int tag = 0);
+
+  // Receives into the tensors what process srcRank sends with the same tag.
+  //
+  // Optional: the default implementation throws.
+  virtual std::shared_ptr<Work> recv(
+      std::vector<at::Tensor>& tensors,
+      int srcRank,
+      int tag = 0);
+
+  // Completes once all the processes have entered the barrier.
+  //
+  // Optional: the default implementation throws.
+  virtual std::shared_ptr<Work> barrier();
+
  protected:
   const int rank_;
   const int size_;
+
+  // Flat buffers of allreduceCoalesced, by type, device and size, that no
+  // call is using.
+  std::mutex coalescedBuffersMutex_;
+  std::unordered_map<std::string, std::vector<at::Tensor>> coalescedBuffers_;
 };
 
 } // namespace c10d
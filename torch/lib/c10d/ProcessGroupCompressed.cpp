@@ -0,0 +1,198 @@
+#include "ProcessGroupCompressed.hpp"
+
+#include <algorithm>
+
+namespace c10d {
+
+namespace {
+
+void waitOrThrow(const std::shared_ptr<ProcessGroup::Work>& work) {
+  if (!work->wait()) {
+    throw std::runtime_error(work->exception().what());
+  }
+}
+
+// The weights of the 8 bits of a byte, on the backend of the tensor
+at::Tensor getBitWeights(const at::Tensor& tensor) {
+  auto weights = at::CPU(at::kInt).tensor({8});
+  auto data = weights.data<int32_t>();
+  for (auto i = 0; i < 8; i++) {
+    data[i] = 1 << i;
+  }
+  return weights.toBackend(tensor.type().backend());
+}
+
+} // namespace
+
+GradientCodec::~GradientCodec() {}
+
+std::vector<at::Tensor> Fp16Codec::encode(const at::Tensor& input) {
+  return {input.toType(at::kHalf)};
+}
+
+void Fp16Codec::decodeAdd(
+    const std::vector<at::Tensor>& parts,
+    at::Tensor& output) {
+  output.add_(parts[0].toType(at::kFloat));
+}
+
+TopKCodec::TopKCodec(double ratio) : ratio_(ratio) {
+  if (ratio <= 0 || ratio > 1) {
+    throw std::invalid_argument("The ratio of TopKCodec must be in (0, 1]");
+  }
+}
+
+std::vector<at::Tensor> TopKCodec::encode(const at::Tensor& input) {
+  const int64_t k = std::max<int64_t>(1, input.numel() * ratio_);
+  auto indices = std::get<1>(input.abs().topk(k, 0, true, false));
+  return {indices, input.index_select(0, indices)};
+}
+
+void TopKCodec::decodeAdd(
+    const std::vector<at::Tensor>& parts,
+    at::Tensor& output) {
+  output.index_add_(0, parts[0], parts[1]);
+}
+
+std::vector<at::Tensor> SignCodec::encode(const at::Tensor& input) {
+  const int64_t numel = input.numel();
+  const int64_t numBytes = (numel + 7) / 8;
+
+  // Pack the signs 8 per byte, the bits of the padding being 0
+  auto bits = at::zeros({numBytes * 8}, input.options().dtype(at::kInt));
+  bits.narrow(0, 0, numel).copy_(input.ge(0));
+  auto packed = (bits.view({numBytes, 8}) *
+                 getBitWeights(input).expand({numBytes, 8}))
+                    .sum(1)
+                    .toType(at::kByte);
+  return {packed, input.abs().mean().view({1})};
+}
+
+void SignCodec::decodeAdd(
+    const std::vector<at::Tensor>& parts,
+    at::Tensor& output) {
+  const int64_t numel = output.numel();
+  const int64_t numBytes = parts[0].numel();
+
+  auto bits = parts[0]
+                  .toType(at::kInt)
+                  .unsqueeze(1)
+                  .expand({numBytes, 8})
+                  .__and__(getBitWeights(output).expand({numBytes, 8}));
+  auto signs = bits.ne(0)
+                   .toType(at::kFloat)
+                   .view({numBytes * 8})
+                   .narrow(0, 0, numel)
+                   .mul_(2)
+                   .add_(-1);
+  output.add_(signs.mul_(parts[1].expand({numel})));
+}
+
+ProcessGroupCompressed::ProcessGroupCompressed(
+    const std::shared_ptr<ProcessGroup>& processGroup,
+    const std::shared_ptr<GradientCodec>& codec)
+    : ProcessGroup(processGroup->getRank(), processGroup->getSize()),
+      processGroup_(processGroup),
+      codec_(codec) {
+  if (!codec) {
+    throw std::invalid_argument("ProcessGroupCompressed needs a codec");
+  }
+}
+
+ProcessGroupCompressed::~ProcessGroupCompressed() {}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupCompressed::broadcast(
+    std::vector<at::Tensor>& tensors,
+    const BroadcastOptions& opts) {
+  return processGroup_->broadcast(tensors, opts);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupCompressed::barrier() {
+  return processGroup_->barrier();
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupCompressed::allreduce(
+    std::vector<at::Tensor>& tensors,
+    const AllreduceOptions& opts) {
+  return allreduce(tensors, std::string(), opts);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupCompressed::allreduce(
+    std::vector<at::Tensor>& tensors,
+    const std::string& residualKey,
+    const AllreduceOptions& opts) {
+  if (tensors.size() != 1) {
+    throw std::invalid_argument(
+        "ProcessGroupCompressed expects one tensor per process");
+  }
+  if (tensors[0].type().scalarType() != at::kFloat) {
+    throw std::invalid_argument(
+        "ProcessGroupCompressed only supports float tensors");
+  }
+  if (opts.reduceOp != ReduceOp::SUM) {
+    throw std::invalid_argument("ProcessGroupCompressed only supports sums");
+  }
+  auto& tensor = tensors[0];
+  auto input = tensor.contiguous().view({tensor.numel()});
+
+  // Add what the previous encodings under the same key lost
+  at::Tensor residual;
+  if (codec_->usesErrorFeedback()) {
+    if (residualKey.empty()) {
+      throw std::invalid_argument(
+          "ProcessGroupCompressed needs a residual key for error feedback");
+    }
+    {
+      std::lock_guard<std::mutex> lock(residualsMutex_);
+      residual = residuals_[residualKey];
+      if (!residual.defined() || residual.numel() != input.numel() ||
+          residual.type() != input.type()) {
+        residual = at::zeros_like(input);
+        residuals_[residualKey] = residual;
+      }
+    }
+    input = input + residual;
+  }
+
+  auto parts = codec_->encode(input);
+  if (residual.defined()) {
+    auto decoded = at::zeros_like(input);
+    codec_->decodeAdd(parts, decoded);
+    residual.copy_(input - decoded);
+  }
+
+  // Gather the parts of all the processes
+  std::vector<at::Tensor> gathered(parts.size());
+  for (size_t i = 0; i < parts.size(); i++) {
+    std::vector<at::Tensor> inputs = {parts[i].contiguous()};
+    std::vector<at::Tensor> outputs = {
+        parts[i].type().tensor({parts[i].numel() * size_})};
+    waitOrThrow(processGroup_->allgather(outputs, inputs));
+    gathered[i] = outputs[0];
+  }
+
+  auto result = at::zeros_like(input);
+  std::vector<at::Tensor> rankParts(parts.size());
+  for (int rank = 0; rank < size_; rank++) {
+    for (size_t i = 0; i < parts.size(); i++) {
+      const auto numel = parts[i].numel();
+      rankParts[i] =
+          gathered[i].narrow(0, rank * numel, numel).view(parts[i].sizes());
+    }
+    codec_->decodeAdd(rankParts, result);
+  }
+  tensor.copy_(result.view(tensor.sizes()));
+  return std::make_shared<CompletedWork>();
+}
+
+void ProcessGroupCompressed::dropResidual(const std::string& residualKey) {
+  std::lock_guard<std::mutex> lock(residualsMutex_);
+  residuals_.erase(residualKey);
+}
+
+void ProcessGroupCompressed::clearResiduals() {
+  std::lock_guard<std::mutex> lock(residualsMutex_);
+  residuals_.clear();
+}
+
+} // namespace c10d
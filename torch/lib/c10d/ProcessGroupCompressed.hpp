@@ -0,0 +1,137 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <c10d/ProcessGroup.hpp>
+
+namespace c10d {
+
+// GradientCodec compresses the tensors of an allreduce before they are sent.
+// Every process encodes its flattened float tensor into a few parts, the
+// parts of all the processes are gathered, and every process decodes them
+// and sums them in float.
+//
+// The sizes of the parts must only depend on the number of elements of the
+// tensor, so that they are the same on every process.
+class GradientCodec {
+ public:
+  virtual ~GradientCodec();
+
+  virtual std::vector<at::Tensor> encode(const at::Tensor& input) = 0;
+
+  // Adds the decoded parts of one process to the output.
+  virtual void decodeAdd(
+      const std::vector<at::Tensor>& parts,
+      at::Tensor& output) = 0;
+
+  // If true, what the encoding of a tensor loses is kept, and added to the
+  // next tensor encoded under the same residual key.
+  virtual bool usesErrorFeedback() const = 0;
+};
+
+// Sends the tensors as half floats.
+class Fp16Codec : public GradientCodec {
+ public:
+  std::vector<at::Tensor> encode(const at::Tensor& input) override;
+
+  void decodeAdd(const std::vector<at::Tensor>& parts, at::Tensor& output)
+      override;
+
+  bool usesErrorFeedback() const override {
+    return false;
+  }
+};
+
+// Sends the ratio of the elements of largest magnitude, with their indices.
+class TopKCodec : public GradientCodec {
+ public:
+  explicit TopKCodec(double ratio);
+
+  std::vector<at::Tensor> encode(const at::Tensor& input) override;
+
+  void decodeAdd(const std::vector<at::Tensor>& parts, at::Tensor& output)
+      override;
+
+  bool usesErrorFeedback() const override {
+    return true;
+  }
+
+ protected:
+  const double ratio_;
+};
+
+// Sends the sign of every element as a bit, and the mean magnitude of the
+// elements, which every element is decoded to.
+class SignCodec : public GradientCodec {
+ public:
+  std::vector<at::Tensor> encode(const at::Tensor& input) override;
+
+  void decodeAdd(const std::vector<at::Tensor>& parts, at::Tensor& output)
+      override;
+
+  bool usesErrorFeedback() const override {
+    return true;
+  }
+};
+
+// ProcessGroupCompressed runs the allreduce of float tensors through a
+// GradientCodec, over the allgather of another process group, which must
+// support allgather for the tensors. Only sums are supported, of a single
+// tensor per process. Other collectives are run by the other process group.
+//
+// With error feedback, the residual of a tensor is kept under a key the
+// caller names it by, e.g. the index of its gradient bucket. The allreduce
+// without a key fails for such codecs. Residuals are kept until they are
+// dropped with dropResidual() or clearResiduals().
+//
+// The collectives are issued by the calling thread, which waits for them,
+// and the returned work is already completed.
+//
+// Example, sending 1% of the gradients:
+//
+//   ProcessGroupCompressed pg(glooPG, std::make_shared<TopKCodec>(0.01));
+//   pg.allreduce(tensors, "bucket0")->wait();
+//
+class ProcessGroupCompressed : public ProcessGroup {
+ public:
+  ProcessGroupCompressed(
+      const std::shared_ptr<ProcessGroup>& processGroup,
+      const std::shared_ptr<GradientCodec>& codec);
+
+  virtual ~ProcessGroupCompressed();
+
+  std::shared_ptr<ProcessGroup::Work> broadcast(
+      std::vector<at::Tensor>& data,
+      const BroadcastOptions& opts = BroadcastOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allreduce(
+      std::vector<at::Tensor>& data,
+      const AllreduceOptions& opts = AllreduceOptions()) override;
+
+  // Like allreduce, keeping the residual of the error feedback under
+  // residualKey. An empty key means none.
+  std::shared_ptr<ProcessGroup::Work> allreduce(
+      std::vector<at::Tensor>& data,
+      const std::string& residualKey,
+      const AllreduceOptions& opts = AllreduceOptions());
+
+  std::shared_ptr<ProcessGroup::Work> barrier() override;
+
+  void dropResidual(const std::string& residualKey);
+
+  void clearResiduals();
+
+ protected:
+  std::shared_ptr<ProcessGroup> processGroup_;
+  std::shared_ptr<GradientCodec> codec_;
+
+  // Residuals of the error feedback, by residual key
+  std::mutex residualsMutex_;
+  std::unordered_map<std::string, at::Tensor> residuals_;
+};
+
+} // namespace c10d
@@ -1,11 +1,18 @@
 #include "ProcessGroupGloo.hpp"
 
+#include <cstring>
+#include <functional>
+#include <numeric>
+
+#include <gloo/allgather_ring.h>
 #include <gloo/allreduce_halving_doubling.h>
 #include <gloo/allreduce_ring_chunked.h>
+#include <gloo/barrier_all_to_one.h>
 #include <gloo/broadcast_one_to_all.h>
 #include <gloo/cuda_allreduce_halving_doubling.h>
 #include <gloo/cuda_allreduce_ring_chunked.h>
 #include <gloo/cuda_broadcast_one_to_all.h>
+#include <gloo/reduce_scatter.h>
 #include <gloo/rendezvous/context.h>
 #include <gloo/transport/tcp/device.h>
 
@@ -94,6 +101,211 @@ const ::gloo::ReductionFunction<T>* reductionFunction(const ReduceOp& r) {
   throw std::runtime_error("Unhandled ReduceOp");
 }
 
+// Rounds a number of elements up to the next of 4 size classes between
+// consecutive powers of two, so that a buffer is at most 25% larger than
+// the tensors sharing it. Small tensors round up to a power of two.
+int64_t roundToSizeClass(int64_t numel) {
+  if (numel <= 64) {
+    int64_t size = 1;
+    while (size < numel) {
+      size <<= 1;
+    }
+    return numel == 0 ? 0 : size;
+  }
+  int64_t power = 64;
+  while (power * 2 <= numel) {
+    power <<= 1;
+  }
+  const int64_t step = power / 4;
+  return (numel + step - 1) / step * step;
+}
+
+// Sends and receives differ between processes, so unlike the collectives
+// they are not counted against cacheMaxBytes and never evicted.
+bool isPointToPoint(const AlgorithmKey& key) {
+  return key.collectiveType == CollectiveType::SEND ||
+      key.collectiveType == CollectiveType::RECV;
+}
+
+// Bytes of the buffers an entry for this key allocates (see construct)
+size_t getEntryBytes(const AlgorithmKey& key) {
+  size_t numel = 0;
+  for (const auto& sizes : key.srcSizes) {
+    numel += std::accumulate(
+        sizes.begin(), sizes.end(), int64_t(1), std::multiplies<int64_t>());
+  }
+  for (const auto& sizes : key.dstSizes) {
+    numel += std::accumulate(
+        sizes.begin(), sizes.end(), int64_t(1), std::multiplies<int64_t>());
+  }
+  return numel * key.type->elementSizeInBytes();
+}
+
+// The elements of a buffer of an entry that hold the elements of tensor.
+// With size classes, the buffer is flat and may be larger than tensor.
+at::Tensor bufferPrefix(const at::Tensor& buffer, const at::Tensor& tensor) {
+  return buffer.view({buffer.numel()})
+      .narrow(0, 0, tensor.numel())
+      .view(tensor.sizes());
+}
+
+// Sends and receives use slots above the ones of the Gloo algorithms, two
+// for every tag: one for the data, and one for the notification that the
+// receiver is ready for it.
+constexpr int kPointToPointSlotBase = 1 << 30;
+
+int getPointToPointSlot(int tag) {
+  return kPointToPointSlotBase + 2 * tag;
+}
+
+// Sends a buffer to a peer once the peer notifies that its receive buffer is
+// free, so that both buffers can be reused by the next sends.
+class SendAlgorithm : public ::gloo::Algorithm {
+ public:
+  SendAlgorithm(
+      const std::shared_ptr<::gloo::Context>& context,
+      int dstRank,
+      int slot,
+      void* ptr,
+      size_t bytes)
+      : ::gloo::Algorithm(context) {
+    auto& pair = context_->getPair(dstRank);
+    dataBuffer_ = pair->createSendBuffer(slot, ptr, bytes);
+    readyBuffer_ = pair->createRecvBuffer(slot + 1, &dummy_, sizeof(dummy_));
+  }
+
+  void run() override {
+    readyBuffer_->waitRecv();
+    dataBuffer_->send();
+    dataBuffer_->waitSend();
+  }
+
+ protected:
+  int dummy_;
+  std::unique_ptr<::gloo::transport::Buffer> dataBuffer_;
+  std::unique_ptr<::gloo::transport::Buffer> readyBuffer_;
+};
+
+// Receives a buffer from a peer running SendAlgorithm.
+class RecvAlgorithm : public ::gloo::Algorithm {
+ public:
+  RecvAlgorithm(
+      const std::shared_ptr<::gloo::Context>& context,
+      int srcRank,
+      int slot,
+      void* ptr,
+      size_t bytes)
+      : ::gloo::Algorithm(context) {
+    auto& pair = context_->getPair(srcRank);
+    dataBuffer_ = pair->createRecvBuffer(slot, ptr, bytes);
+    readyBuffer_ = pair->createSendBuffer(slot + 1, &dummy_, sizeof(dummy_));
+  }
+
+  void run() override {
+    readyBuffer_->send();
+    dataBuffer_->waitRecv();
+    readyBuffer_->waitSend();
+  }
+
+ protected:
+  int dummy_;
+  std::unique_ptr<::gloo::transport::Buffer> dataBuffer_;
+  std::unique_ptr<::gloo::transport::Buffer> readyBuffer_;
+};
+
+// Sends the i-th chunk of the input to process i, and receives the chunk of
+// process i into the i-th chunk of the output, with the same handshake as
+// SendAlgorithm and RecvAlgorithm for every peer.
+class AlltoallAlgorithm : public ::gloo::Algorithm {
+ public:
+  AlltoallAlgorithm(
+      const std::shared_ptr<::gloo::Context>& context,
+      void* input,
+      void* output,
+      size_t chunkBytes)
+      : ::gloo::Algorithm(context),
+        input_(static_cast<char*>(input)),
+        output_(static_cast<char*>(output)),
+        chunkBytes_(chunkBytes) {
+    const auto dataSlot = context_->nextSlot();
+    const auto readySlot = context_->nextSlot();
+    for (int i = 0; i < contextSize_; i++) {
+      if (i == contextRank_) {
+        continue;
+      }
+      auto& pair = context_->getPair(i);
+      sendBuffers_.push_back(pair->createSendBuffer(
+          dataSlot, input_ + i * chunkBytes_, chunkBytes_));
+      recvBuffers_.push_back(pair->createRecvBuffer(
+          dataSlot, output_ + i * chunkBytes_, chunkBytes_));
+      readySendBuffers_.push_back(
+          pair->createSendBuffer(readySlot, &sendDummy_, sizeof(sendDummy_)));
+      readyRecvBuffers_.push_back(
+          pair->createRecvBuffer(readySlot, &recvDummy_, sizeof(recvDummy_)));
+    }
+  }
+
+  void run() override {
+    std::memcpy(
+        output_ + contextRank_ * chunkBytes_,
+        input_ + contextRank_ * chunkBytes_,
+        chunkBytes_);
+    for (auto& buffer : readySendBuffers_) {
+      buffer->send();
+    }
+    for (size_t i = 0; i < sendBuffers_.size(); i++) {
+      readyRecvBuffers_[i]->waitRecv();
+      sendBuffers_[i]->send();
+    }
+    for (auto& buffer : recvBuffers_) {
+      buffer->waitRecv();
+    }
+    for (auto& buffer : sendBuffers_) {
+      buffer->waitSend();
+    }
+    for (auto& buffer : readySendBuffers_) {
+      buffer->waitSend();
+    }
+  }
+
+ protected:
+  char* input_;
+  char* output_;
+  const size_t chunkBytes_;
+  int sendDummy_;
+  int recvDummy_;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> sendBuffers_;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> recvBuffers_;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> readySendBuffers_;
+  std::vector<std::unique_ptr<::gloo::transport::Buffer>> readyRecvBuffers_;
+};
+
+size_t getBytes(const at::Tensor& tensor) {
+  return tensor.numel() * tensor.type().elementSizeInBytes();
+}
+
+void checkSingleCPUTensor(const std::vector<at::Tensor>& tensors) {
+  if (tensors.size() != 1) {
+    throw std::invalid_argument(
+        "ProcessGroupGloo only supports a single tensor for this operation");
+  }
+  if (tensors[0].type().is_cuda()) {
+    throw std::invalid_argument(
+        "ProcessGroupGloo only supports CPU tensors for this operation");
+  }
+}
+
+void checkInputOutput(
+    const std::vector<at::Tensor>& inputs,
+    const std::vector<at::Tensor>& outputs) {
+  checkSingleCPUTensor(inputs);
+  checkSingleCPUTensor(outputs);
+  if (inputs[0].type() != outputs[0].type()) {
+    throw std::invalid_argument(
+        "Input and output tensors must have the same type");
+  }
+}
+
 std::vector<cudaStream_t> getStreamVector(AlgorithmEntry& entry) {
   std::vector<cudaStream_t> streams(entry.streams.size());
   for (size_t i = 0; i < entry.streams.size(); i++) {
@@ -203,7 +415,9 @@ void ProcessGroupGloo::WorkGloo::finishWithException(
 ProcessGroupGloo::Options::Options()
     : timeout(std::chrono::milliseconds(10 * 1000)),
       threads(2),
-      cacheNumAlgorithmEntries(1) {}
+      cacheNumAlgorithmEntries(1),
+      cacheSizeClasses(false),
+      cacheMaxBytes(0) {}
 
 ProcessGroupGloo::ProcessGroupGloo(
     const std::shared_ptr<Store>& store,
@@ -213,7 +427,11 @@ ProcessGroupGloo::ProcessGroupGloo(
     : ProcessGroup(rank, size),
       store_(new GlooStore(store)),
       stop_(false),
-      cacheNumAlgorithmEntries_(options.cacheNumAlgorithmEntries) {
+      cacheNumAlgorithmEntries_(options.cacheNumAlgorithmEntries),
+      cacheSizeClasses_(options.cacheSizeClasses),
+      cacheMaxBytes_(options.cacheMaxBytes),
+      cacheBytes_(0),
+      cacheClock_(0) {
   auto& devices = options.devices;
   if (devices.empty()) {
     throw std::runtime_error("No device(s) specified");
@@ -306,6 +524,40 @@ void ProcessGroupGloo::createAlgorithm(AlgorithmEntry& entry) {
     case CollectiveType::BROADCAST:
       GENERATE_ALL_TYPES(key.type->scalarType(), createBroadcast, entry);
       return;
+    case CollectiveType::REDUCE_SCATTER:
+      GENERATE_ALL_TYPES(key.type->scalarType(), createReduceScatter, entry);
+      return;
+    case CollectiveType::ALLGATHER:
+      GENERATE_ALL_TYPES(key.type->scalarType(), createAllgather, entry);
+      return;
+    case CollectiveType::ALLTOALL:
+      entry.algorithm =
+          std::unique_ptr<::gloo::Algorithm>(new AlltoallAlgorithm(
+              contexts_[0],
+              entry.src[0].data_ptr(),
+              entry.dst[0].data_ptr(),
+              getBytes(entry.src[0]) / getSize()));
+      return;
+    case CollectiveType::SEND:
+      entry.algorithm = std::unique_ptr<::gloo::Algorithm>(new SendAlgorithm(
+          contexts_[0],
+          key.dstRank,
+          getPointToPointSlot(key.tag),
+          entry.src[0].data_ptr(),
+          getBytes(entry.src[0])));
+      return;
+    case CollectiveType::RECV:
+      entry.algorithm = std::unique_ptr<::gloo::Algorithm>(new RecvAlgorithm(
+          contexts_[0],
+          key.srcRank,
+          getPointToPointSlot(key.tag),
+          entry.src[0].data_ptr(),
+          getBytes(entry.src[0])));
+      return;
+    case CollectiveType::BARRIER:
+      entry.algorithm = std::unique_ptr<::gloo::Algorithm>(
+          new ::gloo::BarrierAllToOne(contexts_[0]));
+      return;
     case CollectiveType::UNUSED:
       break;
   }
@@ -400,6 +652,32 @@ void ProcessGroupGloo::createBroadcast(AlgorithmEntry& entry) {
       "Unhandled backend: " + std::string(at::toString(backend)));
 }
 
+template <typename T>
+void ProcessGroupGloo::createReduceScatter(AlgorithmEntry& entry) {
+  const auto& key = entry.key;
+
+  // Every process receives an equal share of the input
+  const int count = entry.src[0].numel();
+  entry.algorithm = std::unique_ptr<::gloo::Algorithm>(
+      new ::gloo::ReduceScatterHalvingDoubling<T>(
+          contexts_[0],
+          getDataPointers<T>(entry.src),
+          count,
+          std::vector<int>(getSize(), count / getSize()),
+          reductionFunction<T>(key.reduceOp)));
+}
+
+template <typename T>
+void ProcessGroupGloo::createAllgather(AlgorithmEntry& entry) {
+  const auto ptrs = getDataPointers<T>(entry.src);
+  entry.algorithm =
+      std::unique_ptr<::gloo::Algorithm>(new ::gloo::AllgatherRing<T>(
+          contexts_[0],
+          std::vector<const T*>(ptrs.begin(), ptrs.end()),
+          getDataPointers<T>(entry.dst),
+          entry.src[0].numel()));
+}
+
 // Constructs an AlgorithmEntry instance, except for the algorithm
 // itself. It allocates the temporary input/output tensors necessary
 // to have a fixed address to pass to the Gloo algorithms. The
@@ -423,6 +701,14 @@ EntryType ProcessGroupGloo::construct(const AlgorithmKey& key) {
     entry->src[i] = key.type->tensor(srcSizes[i]);
   }
 
+  // Allocate destination tensors for this entry
+  auto& dstSizes = key.dstSizes;
+  entry->dst.resize(dstSizes.size());
+  for (size_t i = 0; i < dstSizes.size(); i++) {
+    deviceGuard.set_index(key.type->is_cuda() ? key.devices[i] : -1);
+    entry->dst[i] = key.type->tensor(dstSizes[i]);
+  }
+
   // If these are CUDA tensors, create streams and events
   if (key.type->is_cuda()) {
     entry->streams.resize(key.devices.size());
@@ -441,17 +727,31 @@ AlgorithmEntry* ProcessGroupGloo::checkout(const AlgorithmKey& key) {
   auto& vec = cache_[key];
   const auto i = cacheCurrentEntry_[key];
 
+  // The slots of sends and receives are given by their tags, so they can
+  // only have a single entry
+  const int numEntries = isPointToPoint(key) ? 1 : cacheNumAlgorithmEntries_;
+
   // Ensure the cache vector is appropriately sized
-  if (vec.size() != cacheNumAlgorithmEntries_) {
-    vec.resize(cacheNumAlgorithmEntries_);
+  if (vec.size() != numEntries) {
+    vec.resize(numEntries);
   }
 
   // The next call must use the next entry
-  cacheCurrentEntry_[key] = (i + 1) % cacheNumAlgorithmEntries_;
+  cacheCurrentEntry_[key] = (i + 1) % numEntries;
 
   // If there is no entry for this key, create a new one
   if (!vec[i]) {
-    vec[i] = construct(key);
+    if (isPointToPoint(key)) {
+      vec[i] = construct(key);
+    } else {
+      const auto bytes = getEntryBytes(key);
+      evict(key, bytes);
+      vec[i] = construct(key);
+      cacheBytes_ += bytes;
+    }
+  }
+  if (!isPointToPoint(key)) {
+    cacheLastUse_[key] = ++cacheClock_;
   }
 
   auto& entry = vec[i];
@@ -467,6 +767,118 @@ AlgorithmEntry* ProcessGroupGloo::checkout(const AlgorithmKey& key) {
   return entry.get();
 }
 
+void ProcessGroupGloo::evict(const AlgorithmKey& key, size_t bytes) {
+  while (cacheMaxBytes_ > 0 && cacheBytes_ + bytes > cacheMaxBytes_) {
+    auto lru = cacheLastUse_.end();
+    for (auto it = cacheLastUse_.begin(); it != cacheLastUse_.end(); ++it) {
+      if (it->first == key) {
+        continue;
+      }
+      if (lru == cacheLastUse_.end() || it->second < lru->second) {
+        lru = it;
+      }
+    }
+
+    // Nothing left to evict, the new entry exceeds the bound on its own
+    if (lru == cacheLastUse_.end()) {
+      return;
+    }
+
+    const auto evicted = lru->first;
+    const auto evictedBytes = getEntryBytes(evicted);
+    for (auto& entry : cache_[evicted]) {
+      if (!entry) {
+        continue;
+      }
+
+      // Wait for the work that is still queued on the entry
+      std::unique_lock<std::mutex> lock(entry->m);
+      while (entry->busy) {
+        entry->cv.wait(lock);
+      }
+      lock.unlock();
+
+      entry.reset();
+      cacheBytes_ -= evictedBytes;
+    }
+
+    cache_.erase(evicted);
+    cacheCurrentEntry_.erase(evicted);
+    cacheLastUse_.erase(evicted);
+  }
+}
+
+size_t ProcessGroupGloo::getCacheBytes() const {
+  return cacheBytes_;
+}
+
+std::vector<std::vector<int64_t>> ProcessGroupGloo::getSizeClasses(
+    const std::vector<at::Tensor>& tensors) const {
+  std::vector<std::vector<int64_t>> sizes(tensors.size());
+  for (size_t i = 0; i < tensors.size(); i++) {
+    sizes[i] = {roundToSizeClass(tensors[i].numel())};
+  }
+  return sizes;
+}
+
+AlgorithmKey ProcessGroupGloo::broadcastKey(
+    const std::vector<at::Tensor>& tensors,
+    const BroadcastOptions& opts) const {
+  AlgorithmKey key;
+  key.collectiveType = CollectiveType::BROADCAST;
+  key.type = &tensors[0].type();
+  key.devices = getDevices(tensors);
+  key.srcSizes =
+      cacheSizeClasses_ ? getSizeClasses(tensors) : getSizes(tensors);
+  key.srcRank = opts.rootRank;
+  key.srcTensor = opts.rootTensor;
+  return key;
+}
+
+AlgorithmKey ProcessGroupGloo::allreduceKey(
+    const std::vector<at::Tensor>& tensors,
+    const AllreduceOptions& opts) const {
+  AlgorithmKey key;
+  key.collectiveType = CollectiveType::ALLREDUCE;
+  key.type = &tensors[0].type();
+  key.srcSizes =
+      cacheSizeClasses_ ? getSizeClasses(tensors) : getSizes(tensors);
+  key.devices = getDevices(tensors);
+  key.reduceOp = opts.reduceOp;
+  return key;
+}
+
+void ProcessGroupGloo::warmup(const AlgorithmKey& key) {
+  // Checking out every entry of the key once leaves the index of the
+  // next entry to use where it was
+  std::vector<std::shared_ptr<Work>> work;
+  for (auto i = 0; i < cacheNumAlgorithmEntries_; i++) {
+    auto entry = checkout(key);
+    entry->run = []() {};
+    work.push_back(enqueue(entry));
+  }
+
+  for (auto& w : work) {
+    if (!w->wait()) {
+      throw std::runtime_error(w->exception().what());
+    }
+  }
+}
+
+void ProcessGroupGloo::warmupAllreduce(
+    std::vector<at::Tensor>& tensors,
+    const AllreduceOptions& opts) {
+  assertSameSizeAndType(tensors);
+  warmup(allreduceKey(tensors, opts));
+}
+
+void ProcessGroupGloo::warmupBroadcast(
+    std::vector<at::Tensor>& tensors,
+    const BroadcastOptions& opts) {
+  assertSameSizeAndType(tensors);
+  warmup(broadcastKey(tensors, opts));
+}
+
 std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::enqueue(
     AlgorithmEntry* entry) {
   auto work = std::make_shared<WorkGloo>();
@@ -480,21 +892,15 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::broadcast(
     std::vector<at::Tensor>& tensors,
     const BroadcastOptions& opts) {
   assertSameSizeAndType(tensors);
-
-  AlgorithmKey key;
-  key.collectiveType = CollectiveType::BROADCAST;
-  key.type = &tensors[0].type();
-  key.devices = getDevices(tensors);
-  key.srcSizes = getSizes(tensors);
-  key.srcRank = opts.rootRank;
-  key.srcTensor = opts.rootTensor;
+  const auto key = broadcastKey(tensors, opts);
 
   // Retrieve (create or wait for) pointer to cache entry
   auto entry = checkout(key);
 
   // Only copy root tensor
   if (getRank() == opts.rootRank) {
-    entry->src[opts.rootTensor].copy_(tensors[opts.rootTensor]);
+    bufferPrefix(entry->src[opts.rootTensor], tensors[opts.rootTensor])
+        .copy_(tensors[opts.rootTensor]);
   }
 
   // In case of CUDA, ensure that operations that are queued after
@@ -508,14 +914,14 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::broadcast(
         // overriding the current THCStream. This also sets the
         // current device to the stream's device.
         THCStreamGuard guard(thcState_, entry->streams[i]);
-        tensors[i].copy_(entry->src[i]);
+        tensors[i].copy_(bufferPrefix(entry->src[i], tensors[i]));
       }
     };
   } else {
     entry->run = [=]() mutable {
       entry->algorithm->run();
       for (size_t i = 0; i < tensors.size(); i++) {
-        tensors[i].copy_(entry->src[i]);
+        tensors[i].copy_(bufferPrefix(entry->src[i], tensors[i]));
       }
     };
   }
@@ -527,20 +933,14 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allreduce(
     std::vector<at::Tensor>& tensors,
     const AllreduceOptions& opts) {
   assertSameSizeAndType(tensors);
-
-  AlgorithmKey key;
-  key.collectiveType = CollectiveType::ALLREDUCE;
-  key.type = &tensors[0].type();
-  key.srcSizes = getSizes(tensors);
-  key.devices = getDevices(tensors);
-  key.reduceOp = opts.reduceOp;
+  const auto key = allreduceKey(tensors, opts);
 
   // Retrieve (create or wait for) cache entry
   auto entry = checkout(key);
 
   // Copy input tensors
   for (size_t i = 0; i < tensors.size(); i++) {
-    entry->src[i].copy_(tensors[i]);
+    bufferPrefix(entry->src[i], tensors[i]).copy_(tensors[i]);
   }
 
   // In case of CUDA, ensure that operations that are queued after
@@ -554,14 +954,14 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allreduce(
         // overriding the current THCStream. This also sets the
         // current device to the stream's device.
         THCStreamGuard guard(thcState_, entry->streams[i]);
-        tensors[i].copy_(entry->src[i]);
+        tensors[i].copy_(bufferPrefix(entry->src[i], tensors[i]));
       }
     };
   } else {
     entry->run = [=]() mutable {
       entry->algorithm->run();
       for (size_t i = 0; i < tensors.size(); i++) {
-        tensors[i].copy_(entry->src[i]);
+        tensors[i].copy_(bufferPrefix(entry->src[i], tensors[i]));
       }
     };
   }
@@ -569,4 +969,172 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allreduce(
   return enqueue(entry);
 }
 
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::reduceScatter(
+    std::vector<at::Tensor>& outputs,
+    std::vector<at::Tensor>& inputs,
+    const ReduceScatterOptions& opts) {
+  checkInputOutput(inputs, outputs);
+  const auto numel = outputs[0].numel();
+  if (inputs[0].numel() != numel * getSize()) {
+    throw std::invalid_argument(
+        "The input must have group size times as many elements as the "
+        "output");
+  }
+
+  AlgorithmKey key;
+  key.collectiveType = CollectiveType::REDUCE_SCATTER;
+  key.type = &inputs[0].type();
+  key.srcSizes = getSizes(inputs);
+  key.devices = getDevices(inputs);
+  key.reduceOp = opts.reduceOp;
+
+  // Retrieve (create or wait for) cache entry
+  auto entry = checkout(key);
+  entry->src[0].copy_(inputs[0]);
+
+  // The share of this process is left in place in the input buffer
+  const auto rank = getRank();
+  entry->run = [=]() mutable {
+    entry->algorithm->run();
+    outputs[0].view({numel}).copy_(
+        entry->src[0].view({numel * getSize()}).narrow(0, rank * numel, numel));
+  };
+
+  return enqueue(entry);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allgather(
+    std::vector<at::Tensor>& outputs,
+    std::vector<at::Tensor>& inputs) {
+  checkInputOutput(inputs, outputs);
+  if (outputs[0].numel() != inputs[0].numel() * getSize()) {
+    throw std::invalid_argument(
+        "The output must have group size times as many elements as the "
+        "input");
+  }
+
+  AlgorithmKey key;
+  key.collectiveType = CollectiveType::ALLGATHER;
+  key.type = &inputs[0].type();
+  key.srcSizes = getSizes(inputs);
+  key.dstSizes = getSizes(outputs);
+  key.devices = getDevices(inputs);
+
+  // Retrieve (create or wait for) cache entry
+  auto entry = checkout(key);
+  entry->src[0].copy_(inputs[0]);
+
+  entry->run = [=]() mutable {
+    entry->algorithm->run();
+    outputs[0].copy_(entry->dst[0]);
+  };
+
+  return enqueue(entry);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::alltoall(
+    std::vector<at::Tensor>& outputs,
+    std::vector<at::Tensor>& inputs) {
+  checkInputOutput(inputs, outputs);
+  if (outputs[0].numel() != inputs[0].numel() ||
+      inputs[0].numel() % getSize() != 0) {
+    throw std::invalid_argument(
+        "The input and the output must have the same number of elements, "
+        "which must be a multiple of the group size");
+  }
+
+  AlgorithmKey key;
+  key.collectiveType = CollectiveType::ALLTOALL;
+  key.type = &inputs[0].type();
+  key.srcSizes = getSizes(inputs);
+  key.dstSizes = getSizes(outputs);
+  key.devices = getDevices(inputs);
+
+  // Retrieve (create or wait for) cache entry
+  auto entry = checkout(key);
+  entry->src[0].copy_(inputs[0]);
+
+  entry->run = [=]() mutable {
+    entry->algorithm->run();
+    outputs[0].copy_(entry->dst[0]);
+  };
+
+  return enqueue(entry);
+}
+
+void ProcessGroupGloo::checkPointToPoint(
+    const std::vector<at::Tensor>& tensors,
+    int peerRank,
+    int tag) {
+  checkSingleCPUTensor(tensors);
+  if (peerRank < 0 || peerRank >= getSize() || peerRank == getRank()) {
+    throw std::invalid_argument(
+        "Invalid peer rank: " + std::to_string(peerRank));
+  }
+  if (tag < 0 || tag > kMaxTag) {
+    throw std::invalid_argument("Invalid tag: " + std::to_string(tag));
+  }
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::send(
+    std::vector<at::Tensor>& tensors,
+    int dstRank,
+    int tag) {
+  checkPointToPoint(tensors, dstRank, tag);
+
+  AlgorithmKey key;
+  key.collectiveType = CollectiveType::SEND;
+  key.type = &tensors[0].type();
+  key.srcSizes = getSizes(tensors);
+  key.devices = getDevices(tensors);
+  key.dstRank = dstRank;
+  key.tag = tag;
+
+  // Retrieve (create or wait for) cache entry
+  auto entry = checkout(key);
+  entry->src[0].copy_(tensors[0]);
+
+  entry->run = [=]() mutable { entry->algorithm->run(); };
+
+  return enqueue(entry);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::recv(
+    std::vector<at::Tensor>& tensors,
+    int srcRank,
+    int tag) {
+  checkPointToPoint(tensors, srcRank, tag);
+
+  AlgorithmKey key;
+  key.collectiveType = CollectiveType::RECV;
+  key.type = &tensors[0].type();
+  key.srcSizes = getSizes(tensors);
+  key.devices = getDevices(tensors);
+  key.srcRank = srcRank;
+  key.tag = tag;
+
+  // Retrieve (create or wait for) cache entry
+  auto entry = checkout(key);
+
+  entry->run = [=]() mutable {
+    entry->algorithm->run();
+    tensors[0].copy_(entry->src[0]);
+  };
+
+  return enqueue(entry);
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::barrier() {
+  AlgorithmKey key;
+  key.collectiveType = CollectiveType::BARRIER;
+  key.type = &at::getType(at::kCPU, at::kFloat);
+
+  // Retrieve (create or wait for) cache entry
+  auto entry = checkout(key);
+
+  entry->run = [=]() mutable { entry->algorithm->run(); };
+
+  return enqueue(entry);
+}
+
 } // namespace c10d
@@ -43,7 +43,8 @@ struct AlgorithmKey {
         (devices == other.devices) && (srcSizes == other.srcSizes) &&
         (dstSizes == other.dstSizes) && (srcRank == other.srcRank) &&
         (dstRank == other.dstRank) && (srcTensor == other.srcTensor) &&
-        (dstTensor == other.dstTensor) && (reduceOp == other.reduceOp);
+        (dstTensor == other.dstTensor) && (reduceOp == other.reduceOp) &&
+        (tag == other.tag);
   }
 
   CollectiveType collectiveType = CollectiveType::UNUSED;
@@ -56,6 +57,7 @@ struct AlgorithmKey {
   int srcTensor = -1;
   int dstTensor = -1;
   ReduceOp reduceOp = ReduceOp::UNUSED;
+  int tag = -1;
 
   // This function is called by torch::hash<AlgorithmKey>
   static size_t hash(const AlgorithmKey& k) {
@@ -69,7 +71,8 @@ struct AlgorithmKey {
         k.dstRank,
         k.srcTensor,
         k.dstTensor,
-        k.reduceOp);
+        k.reduceOp,
+        k.tag);
   }
 };
 
@@ -163,6 +166,13 @@ namespace c10d {
 // number can be automatically tuned, but only if we let a single
 // process take charge, and have it broadcast the limits.
 //
+// Calls with tensors of many different sizes would create an entry for
+// every size. With the cacheSizeClasses option, allreduce and broadcast
+// round the number of elements up to a size class and work on a prefix
+// of larger buffers, and cacheMaxBytes bounds the memory held by the
+// buffers of the cache by evicting the least recently used keys. All
+// processes make the same decisions, because they see the same calls.
+//
 class ProcessGroupGloo : public ProcessGroup {
  public:
   class WorkGloo : public ProcessGroup::Work {
@@ -225,6 +235,16 @@ class ProcessGroupGloo : public ProcessGroup {
     // be greater than 1. More cache entries means more memory usage.
     // The default value is 1.
     int cacheNumAlgorithmEntries;
+
+    // Makes allreduce and broadcast share entries between tensors whose
+    // number of elements rounds up to the same size class, no more than
+    // 25% larger above 64 elements and a power of two below. The default
+    // value is false.
+    bool cacheSizeClasses;
+
+    // Upper bound of the bytes held by the buffers of the cached entries
+    // of the collectives, or 0 for no bound. The default value is 0.
+    size_t cacheMaxBytes;
   };
 
   explicit ProcessGroupGloo(
@@ -243,6 +263,54 @@ class ProcessGroupGloo : public ProcessGroup {
       std::vector<at::Tensor>& tensors,
       const AllreduceOptions& opts = AllreduceOptions()) override;
 
+  // The collectives below only support a single CPU tensor per process.
+
+  std::shared_ptr<Work> reduceScatter(
+      std::vector<at::Tensor>& outputs,
+      std::vector<at::Tensor>& inputs,
+      const ReduceScatterOptions& opts = ReduceScatterOptions()) override;
+
+  std::shared_ptr<Work> allgather(
+      std::vector<at::Tensor>& outputs,
+      std::vector<at::Tensor>& inputs) override;
+
+  std::shared_ptr<Work> alltoall(
+      std::vector<at::Tensor>& outputs,
+      std::vector<at::Tensor>& inputs) override;
+
+  // Sends and receives run on the worker threads like the collectives, and
+  // a receive holds its thread until the data arrives, so there must be
+  // more worker threads than receives waiting at the same time. Tags are
+  // between 0 and kMaxTag.
+  std::shared_ptr<Work> send(
+      std::vector<at::Tensor>& tensors,
+      int dstRank,
+      int tag = 0) override;
+
+  std::shared_ptr<Work> recv(
+      std::vector<at::Tensor>& tensors,
+      int srcRank,
+      int tag = 0) override;
+
+  std::shared_ptr<Work> barrier() override;
+
+  // Create the cache entries, and the Gloo algorithms, that allreduce and
+  // broadcast calls with these tensors and options use, so the first call
+  // does not pay for connecting the buffers. They must be called by all
+  // processes like the collectives, and return once the entries are ready.
+  void warmupAllreduce(
+      std::vector<at::Tensor>& tensors,
+      const AllreduceOptions& opts = AllreduceOptions());
+
+  void warmupBroadcast(
+      std::vector<at::Tensor>& tensors,
+      const BroadcastOptions& opts = BroadcastOptions());
+
+  // Bytes held by the buffers of the cached entries.
+  size_t getCacheBytes() const;
+
+  static constexpr int kMaxTag = (1 << 29) - 1;
+
  protected:
   using KeyType = AlgorithmKey;
   using EntryType = std::unique_ptr<AlgorithmEntry>;
@@ -266,15 +334,56 @@ class ProcessGroupGloo : public ProcessGroup {
   template <typename T>
   void createBroadcast(AlgorithmEntry& entry);
 
+  template <typename T>
+  void createReduceScatter(AlgorithmEntry& entry);
+
+  template <typename T>
+  void createAllgather(AlgorithmEntry& entry);
+
+  // Checks the peer and the tag of a send or a receive
+  void checkPointToPoint(
+      const std::vector<at::Tensor>& tensors,
+      int peerRank,
+      int tag);
+
+  AlgorithmKey allreduceKey(
+      const std::vector<at::Tensor>& tensors,
+      const AllreduceOptions& opts) const;
+
+  AlgorithmKey broadcastKey(
+      const std::vector<at::Tensor>& tensors,
+      const BroadcastOptions& opts) const;
+
+  // Sizes of the (flat) buffers of the size class of these tensors.
+  std::vector<std::vector<int64_t>> getSizeClasses(
+      const std::vector<at::Tensor>& tensors) const;
+
+  // Runs every entry of the key once without running its algorithm.
+  void warmup(const KeyType& key);
+
   // Construct creates AlgorithmEntry for specified key.
   EntryType construct(const KeyType& key);
 
   // Checkout constructs new AlgorithmEntry or returns existing one.
   AlgorithmEntry* checkout(const KeyType& key);
 
+  // Evicts the least recently used keys other than this one until an entry
+  // of this many bytes fits in cacheMaxBytes_.
+  void evict(const KeyType& key, size_t bytes);
+
   // The maximum number of cached algorithms for a single key.
   const int cacheNumAlgorithmEntries_;
 
+  const bool cacheSizeClasses_;
+  const size_t cacheMaxBytes_;
+
+  // Bytes held by the buffers of the cached entries.
+  size_t cacheBytes_;
+
+  // Logical time of the last checkout of every key, for eviction.
+  uint64_t cacheClock_;
+  std::unordered_map<KeyType, uint64_t, HashType> cacheLastUse_;
+
   // Index of the next algorithm to use for a particular key.
   // Note that this index must be the same for all particating processes.
   std::unordered_map<KeyType, int, HashType> cacheCurrentEntry_;
@@ -0,0 +1,112 @@
+#include "ProcessGroupHierarchical.hpp"
+
+namespace c10d {
+
+namespace {
+
+// The rank and the size of the whole group, from the ranks and the sizes of
+// the subgroups.
+int getHierarchicalRank(
+    const std::shared_ptr<ProcessGroup>& intraNodeGroup,
+    const std::shared_ptr<ProcessGroup>& interNodeGroup) {
+  if (!intraNodeGroup || !interNodeGroup) {
+    throw std::invalid_argument(
+        "ProcessGroupHierarchical needs an intra-node and an inter-node "
+        "process group");
+  }
+  return interNodeGroup->getRank() * intraNodeGroup->getSize() +
+      intraNodeGroup->getRank();
+}
+
+int getHierarchicalSize(
+    const std::shared_ptr<ProcessGroup>& intraNodeGroup,
+    const std::shared_ptr<ProcessGroup>& interNodeGroup) {
+  return interNodeGroup->getSize() * intraNodeGroup->getSize();
+}
+
+void checkSingleTensor(const std::vector<at::Tensor>& tensors) {
+  if (tensors.size() != 1) {
+    throw std::invalid_argument(
+        "ProcessGroupHierarchical expects one tensor per process");
+  }
+  if (!tensors[0].is_contiguous()) {
+    throw std::invalid_argument(
+        "ProcessGroupHierarchical expects a contiguous tensor");
+  }
+}
+
+void waitOrThrow(const std::shared_ptr<ProcessGroup::Work>& work) {
+  if (!work->wait()) {
+    throw std::runtime_error(work->exception().what());
+  }
+}
+
+} // namespace
+
+ProcessGroupHierarchical::ProcessGroupHierarchical(
+    const std::shared_ptr<ProcessGroup>& intraNodeGroup,
+    const std::shared_ptr<ProcessGroup>& interNodeGroup)
+    : ProcessGroup(
+          getHierarchicalRank(intraNodeGroup, interNodeGroup),
+          getHierarchicalSize(intraNodeGroup, interNodeGroup)),
+      intraNodeGroup_(intraNodeGroup),
+      interNodeGroup_(interNodeGroup) {}
+
+ProcessGroupHierarchical::~ProcessGroupHierarchical() {}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::broadcast(
+    std::vector<at::Tensor>& tensors,
+    const BroadcastOptions& opts) {
+  checkSingleTensor(tensors);
+  if (opts.rootRank < 0 || opts.rootRank >= size_ || opts.rootTensor != 0) {
+    throw std::invalid_argument("Invalid root for the broadcast");
+  }
+  const int localSize = intraNodeGroup_->getSize();
+
+  // The processes of the root's local rank get the data from the root's
+  // node, and then pass it on within their nodes.
+  if (intraNodeGroup_->getRank() == opts.rootRank % localSize) {
+    BroadcastOptions interNodeOpts;
+    interNodeOpts.rootRank = opts.rootRank / localSize;
+    waitOrThrow(interNodeGroup_->broadcast(tensors, interNodeOpts));
+  }
+  BroadcastOptions intraNodeOpts;
+  intraNodeOpts.rootRank = opts.rootRank % localSize;
+  waitOrThrow(intraNodeGroup_->broadcast(tensors, intraNodeOpts));
+  return std::make_shared<CompletedWork>();
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::allreduce(
+    std::vector<at::Tensor>& tensors,
+    const AllreduceOptions& opts) {
+  checkSingleTensor(tensors);
+  auto& tensor = tensors[0];
+  const int64_t localSize = intraNodeGroup_->getSize();
+  const int64_t numel = tensor.numel();
+  const int64_t shardSize = (numel + localSize - 1) / localSize;
+
+  // The tensor is padded to a multiple of the intra-node group size, so that
+  // every local rank owns a shard of the same size. The padding does not
+  // matter for any reduction, since it is dropped at the end.
+  std::vector<at::Tensor> flat = {tensor.view({numel})};
+  if (shardSize * localSize != numel) {
+    flat[0] = at::zeros({shardSize * localSize}, tensor.options());
+    flat[0].narrow(0, 0, numel).copy_(tensor.view({numel}));
+  }
+  std::vector<at::Tensor> shard = {tensor.type().tensor({shardSize})};
+
+  ReduceScatterOptions reduceScatterOpts;
+  reduceScatterOpts.reduceOp = opts.reduceOp;
+  waitOrThrow(intraNodeGroup_->reduceScatter(shard, flat, reduceScatterOpts));
+  if (interNodeGroup_->getSize() > 1) {
+    waitOrThrow(interNodeGroup_->allreduce(shard, opts));
+  }
+  waitOrThrow(intraNodeGroup_->allgather(flat, shard));
+
+  if (shardSize * localSize != numel) {
+    tensor.view({numel}).copy_(flat[0].narrow(0, 0, numel));
+  }
+  return std::make_shared<CompletedWork>();
+}
+
+} // namespace c10d
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+
+#include <c10d/ProcessGroup.hpp>
+
+namespace c10d {
+
+// ProcessGroupHierarchical runs the collectives of a group spread over
+// several nodes in two levels: within every node over a fast process group
+// (typically ProcessGroupNCCL over NVLink), and between the nodes over
+// another process group (Gloo or MPI over the network).
+//
+// The group is laid out node by node: the process of rank r is the process
+// r % localSize of the node r / localSize, where localSize is the size of
+// the intra-node group. The inter-node group of a process connects the
+// processes of the same local rank on every node.
+//
+// An allreduce is done as an intra-node reduce-scatter, an inter-node
+// allreduce of the shard of every process, and an intra-node allgather.
+// Each process only sends 1 / localSize of the data over the network, and
+// the inter-node allreduce of the shards runs in parallel over all the local
+// ranks.
+//
+// The intra-node group must support reduceScatter and allgather. The
+// collectives take one tensor per process, and are issued by the calling
+// thread, which waits for every step before starting the next one. The
+// returned work is already completed.
+//
+// Example for 2 nodes of 8 GPUs, with a store per node and a store per local
+// rank for the subgroups:
+//
+//   auto intra = std::make_shared<ProcessGroupNCCL>(nodeStore, localRank, 8);
+//   auto inter = std::make_shared<ProcessGroupGloo>(
+//       localRankStore, nodeRank, 2, options);
+//   ProcessGroupHierarchical pg(intra, inter);
+//   pg.allreduce(tensors)->wait();
+//
+class ProcessGroupHierarchical : public ProcessGroup {
+ public:
+  ProcessGroupHierarchical(
+      const std::shared_ptr<ProcessGroup>& intraNodeGroup,
+      const std::shared_ptr<ProcessGroup>& interNodeGroup);
+
+  virtual ~ProcessGroupHierarchical();
+
+  std::shared_ptr<ProcessGroup::Work> broadcast(
+      std::vector<at::Tensor>& data,
+      const BroadcastOptions& opts = BroadcastOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allreduce(
+      std::vector<at::Tensor>& data,
+      const AllreduceOptions& opts = AllreduceOptions()) override;
+
+ protected:
+  std::shared_ptr<ProcessGroup> intraNodeGroup_;
+  std::shared_ptr<ProcessGroup> interNodeGroup_;
+};
+
+} // namespace c10d
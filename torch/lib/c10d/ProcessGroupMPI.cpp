@@ -68,6 +68,32 @@ void checkSingleTensor(const std::vector<at::Tensor>& tensors) {
   }
 }
 
+// Checking the input and the output tensors of a collective, where the
+// output has outputOverInput times as many elements as the input (or
+// inputOverOutput times fewer)
+void checkInputOutput(
+    const std::vector<at::Tensor>& inputs,
+    const std::vector<at::Tensor>& outputs,
+    int64_t outputOverInput,
+    int64_t inputOverOutput) {
+  checkSingleTensor(inputs);
+  checkSingleTensor(outputs);
+  if (inputs[0].type() != outputs[0].type()) {
+    throw std::runtime_error(
+        "input and output tensors have to be of the same type");
+  }
+  if (inputs[0].numel() * outputOverInput !=
+      outputs[0].numel() * inputOverOutput) {
+    throw std::runtime_error("unexpected number of elements of the output");
+  }
+}
+
+void checkRank(int rank, int size) {
+  if (rank < 0 || rank >= size) {
+    throw std::runtime_error("invalid rank: " + std::to_string(rank));
+  }
+}
+
 void mpiExit() {
   MPI_CHECK(MPI_Finalize());
 }
@@ -293,4 +319,133 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::allreduce(
   return enqueue(std::move(entry));
 }
 
+std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::reduceScatter(
+    std::vector<at::Tensor>& outputs,
+    std::vector<at::Tensor>& inputs,
+    const ReduceScatterOptions& opts) {
+  checkInputOutput(inputs, outputs, 1, size_);
+  std::function<void(std::unique_ptr<WorkEntry>&)> runFunc =
+      [opts](std::unique_ptr<WorkEntry>& entry) {
+        auto input = (*entry->src)[0];
+        auto output = (*entry->dst)[0];
+        MPI_CHECK(MPI_Reduce_scatter_block(
+            input.data_ptr(),
+            output.data_ptr(),
+            output.numel(),
+            mpiDatatype.at(output.type().scalarType()),
+            mpiOp.at(opts.reduceOp),
+            MPI_COMM_WORLD));
+      };
+  auto entry = std::unique_ptr<WorkEntry>(
+      new WorkEntry(&inputs, &outputs, std::move(runFunc)));
+  return enqueue(std::move(entry));
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::allgather(
+    std::vector<at::Tensor>& outputs,
+    std::vector<at::Tensor>& inputs) {
+  checkInputOutput(inputs, outputs, size_, 1);
+  std::function<void(std::unique_ptr<WorkEntry>&)> runFunc =
+      [](std::unique_ptr<WorkEntry>& entry) {
+        auto input = (*entry->src)[0];
+        auto output = (*entry->dst)[0];
+        auto datatype = mpiDatatype.at(input.type().scalarType());
+        MPI_CHECK(MPI_Allgather(
+            input.data_ptr(),
+            input.numel(),
+            datatype,
+            output.data_ptr(),
+            input.numel(),
+            datatype,
+            MPI_COMM_WORLD));
+      };
+  auto entry = std::unique_ptr<WorkEntry>(
+      new WorkEntry(&inputs, &outputs, std::move(runFunc)));
+  return enqueue(std::move(entry));
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::alltoall(
+    std::vector<at::Tensor>& outputs,
+    std::vector<at::Tensor>& inputs) {
+  checkInputOutput(inputs, outputs, 1, 1);
+  if (inputs[0].numel() % size_ != 0) {
+    throw std::runtime_error(
+        "the number of elements of the input has to be a multiple of the "
+        "group size");
+  }
+  const int size = size_;
+  std::function<void(std::unique_ptr<WorkEntry>&)> runFunc =
+      [size](std::unique_ptr<WorkEntry>& entry) {
+        auto input = (*entry->src)[0];
+        auto output = (*entry->dst)[0];
+        auto datatype = mpiDatatype.at(input.type().scalarType());
+        MPI_CHECK(MPI_Alltoall(
+            input.data_ptr(),
+            input.numel() / size,
+            datatype,
+            output.data_ptr(),
+            input.numel() / size,
+            datatype,
+            MPI_COMM_WORLD));
+      };
+  auto entry = std::unique_ptr<WorkEntry>(
+      new WorkEntry(&inputs, &outputs, std::move(runFunc)));
+  return enqueue(std::move(entry));
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::send(
+    std::vector<at::Tensor>& tensors,
+    int dstRank,
+    int tag) {
+  checkSingleTensor(tensors);
+  checkRank(dstRank, size_);
+  std::function<void(std::unique_ptr<WorkEntry>&)> runFunc =
+      [dstRank, tag](std::unique_ptr<WorkEntry>& entry) {
+        auto data = (*entry->src)[0];
+        MPI_CHECK(MPI_Send(
+            data.data_ptr(),
+            data.numel(),
+            mpiDatatype.at(data.type().scalarType()),
+            dstRank,
+            tag,
+            MPI_COMM_WORLD));
+      };
+  auto entry = std::unique_ptr<WorkEntry>(
+      new WorkEntry(&tensors, nullptr, std::move(runFunc)));
+  return enqueue(std::move(entry));
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::recv(
+    std::vector<at::Tensor>& tensors,
+    int srcRank,
+    int tag) {
+  checkSingleTensor(tensors);
+  checkRank(srcRank, size_);
+  std::function<void(std::unique_ptr<WorkEntry>&)> runFunc =
+      [srcRank, tag](std::unique_ptr<WorkEntry>& entry) {
+        auto data = (*entry->src)[0];
+        MPI_CHECK(MPI_Recv(
+            data.data_ptr(),
+            data.numel(),
+            mpiDatatype.at(data.type().scalarType()),
+            srcRank,
+            tag,
+            MPI_COMM_WORLD,
+            MPI_STATUS_IGNORE));
+      };
+  auto entry = std::unique_ptr<WorkEntry>(
+      new WorkEntry(&tensors, nullptr, std::move(runFunc)));
+  return enqueue(std::move(entry));
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupMPI::barrier() {
+  std::function<void(std::unique_ptr<WorkEntry>&)> runFunc =
+      [](std::unique_ptr<WorkEntry>&) {
+        MPI_CHECK(MPI_Barrier(MPI_COMM_WORLD));
+      };
+  auto entry = std::unique_ptr<WorkEntry>(
+      new WorkEntry(nullptr, nullptr, std::move(runFunc)));
+  return enqueue(std::move(entry));
+}
+
 } // namespace c10d
@@ -85,18 +85,30 @@ void syncStreams(
 
 } // namespace
 
-ProcessGroupNCCL::WorkNCCL::WorkNCCL(const std::vector<at::Device>& devices)
-    : devices_(devices) {
+ProcessGroupNCCL::WorkNCCL::WorkNCCL(
+    const std::vector<at::Device>& devices,
+    const std::shared_ptr<CUDAEventPool>& eventPool)
+    : devices_(devices), eventPool_(eventPool) {
   at::DeviceGuard gpuGuard;
   cudaEvents_.resize(devices.size());
-  // Now create the CUDA events
+  // Now take or create the CUDA events
   for (size_t i = 0; i < devices.size(); ++i) {
-    gpuGuard.set_index(devices[i].index());
-    cudaEvents_[i] = CUDAEvent::create(cudaEventDisableTiming);
+    if (eventPool_) {
+      cudaEvents_[i] = eventPool_->get(devices[i].index());
+    } else {
+      gpuGuard.set_index(devices[i].index());
+      cudaEvents_[i] = CUDAEvent::create(cudaEventDisableTiming);
+    }
   }
 }
 
-ProcessGroupNCCL::WorkNCCL::~WorkNCCL() {}
+ProcessGroupNCCL::WorkNCCL::~WorkNCCL() {
+  if (eventPool_) {
+    for (auto& cudaEvent : cudaEvents_) {
+      eventPool_->put(std::move(cudaEvent));
+    }
+  }
+}
 
 // Check if the NCCL kernels are queued on the GPUs
 bool ProcessGroupNCCL::WorkNCCL::isCompleted() const {
@@ -160,7 +172,9 @@ ProcessGroupNCCL::ProcessGroupNCCL(
     const std::shared_ptr<Store>& store,
     int rank,
     int size)
-    : ProcessGroup(rank, size), store_(store) {
+    : ProcessGroup(rank, size),
+      store_(store),
+      workEventPool_(std::make_shared<CUDAEventPool>(cudaEventDisableTiming)) {
   thcState_ = ::at::globalContext().lazyInitCUDA();
   // Generate the Process Group ID for current PG, this needs to be identical
   // for all processes
@@ -224,6 +238,7 @@ std::vector<std::shared_ptr<NCCLComm>>& ProcessGroupNCCL::getNCCLComm(
     return devNCCLCommMap_[devicesKey];
   }
   // NCCL communicator not cached, create a new entry
+  const auto start = std::chrono::steady_clock::now();
   std::vector<std::shared_ptr<NCCLComm>> ncclComms;
   ncclComms.resize(devices.size());
 
@@ -256,8 +271,12 @@ std::vector<std::shared_ptr<NCCLComm>>& ProcessGroupNCCL::getNCCLComm(
     gpuGuard.set_index(devices[i].index());
     ncclComms[i] = NCCLComm::create(numRanks, rank, ncclID);
 
-    // Also create the NCCL streams and events
-    streamVal[i] = CUDAStream::create();
+    // Also create the NCCL events, and share the stream of the device
+    auto& deviceStream = deviceStreams_[devices[i].index()];
+    if (deviceStream.getTHCStream() == nullptr) {
+      deviceStream = CUDAStream::create(true);
+    }
+    streamVal[i] = deviceStream.share();
     // Event created using cudaEventDisableTiming flag and not
     // cudaEventBlockingSync flag will provide the best performance when used
     // with cudaStreamWaitEvent() and cudaEventQuery(). Since we here don't
@@ -267,6 +286,16 @@ std::vector<std::shared_ptr<NCCLComm>>& ProcessGroupNCCL::getNCCLComm(
 
   C10D_NCCL_CHECK(ncclGroupEnd());
 
+  if (barrierDevices_.empty()) {
+    barrierDevices_ = devices;
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(statsMutex_);
+    ++stats_.numCommunicatorInits;
+    stats_.communicatorInitTime += std::chrono::steady_clock::now() - start;
+  }
+
   // Move the NCCL resource to cache
   devNCCLCommMap_.emplace(devicesKey, std::move(ncclComms));
   ncclStreams_.emplace(devicesKey, std::move(streamVal));
@@ -360,12 +389,14 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allreduce(
   auto devices = getDevices(tensors);
   auto key = getKeyFromDevices(devices);
   auto& ncclComms = getNCCLComm(key, devices);
+  const auto start = std::chrono::steady_clock::now();
 
   // First let NCCL streams wait for THC stream
   syncStreams(thcState_, devices, ncclEvents_[key], ncclStreams_[key]);
 
   // Work itself will create the CUDA events on all GPUs of tensors
-  auto work = std::make_shared<ProcessGroupNCCL::WorkNCCL>(devices);
+  auto work =
+      std::make_shared<ProcessGroupNCCL::WorkNCCL>(devices, workEventPool_);
 
   at::DeviceGuard gpuGuard;
 
@@ -399,6 +430,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allreduce(
         cudaEventRecord(cudaEvent.getEvent(), ncclStream.getStream()));
   }
 
+  recordQueueing(start);
   return work;
 }
 
@@ -410,12 +442,14 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::broadcast(
   auto devices = getDevices(tensors);
   auto key = getKeyFromDevices(devices);
   auto& ncclComms = getNCCLComm(key, devices);
+  const auto start = std::chrono::steady_clock::now();
 
   // First let NCCL streams wait for THC stream
   syncStreams(thcState_, devices, ncclEvents_[key], ncclStreams_[key]);
 
   // Work itself will create the CUDA events on all GPUs of tensors
-  auto work = std::make_shared<ProcessGroupNCCL::WorkNCCL>(devices);
+  auto work =
+      std::make_shared<ProcessGroupNCCL::WorkNCCL>(devices, workEventPool_);
 
   at::DeviceGuard gpuGuard;
 
@@ -450,7 +484,160 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::broadcast(
         cudaEventRecord(cudaEvent.getEvent(), ncclStream.getStream()));
   }
 
+  recordQueueing(start);
   return work;
 }
 
+std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::reduceScatter(
+    std::vector<at::Tensor>& outputs,
+    std::vector<at::Tensor>& inputs,
+    const ReduceScatterOptions& opts) {
+  // Every input holds a chunk of output for every GPU of the group.
+  tensorCheckHelper(outputs, inputs, getSize() * outputs.size());
+
+  auto devices = getDevices(inputs);
+  auto key = getKeyFromDevices(devices);
+  auto& ncclComms = getNCCLComm(key, devices);
+  const auto start = std::chrono::steady_clock::now();
+
+  // First let NCCL streams wait for THC stream
+  syncStreams(thcState_, devices, ncclEvents_[key], ncclStreams_[key]);
+
+  // Work itself will create the CUDA events on all GPUs of tensors
+  auto work =
+      std::make_shared<ProcessGroupNCCL::WorkNCCL>(devices, workEventPool_);
+
+  at::DeviceGuard gpuGuard;
+
+  std::unique_lock<std::mutex> cudaFreeMutexLock(
+      *(THCCachingAllocator_getCudaFreeMutex()));
+
+  C10D_NCCL_CHECK(ncclGroupStart());
+
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    gpuGuard.set_index(devices[i].index());
+    CUDAStream& ncclStream = ncclStreams_[key][i];
+
+    C10D_NCCL_CHECK(ncclReduceScatter(
+        inputs[i].data_ptr(),
+        outputs[i].data_ptr(),
+        outputs[i].numel(),
+        getNcclDataType(inputs[i].type().scalarType()),
+        ncclOp[opts.reduceOp],
+        ncclComms[i]->getNcclComm(),
+        ncclStream.getStream()));
+  }
+
+  C10D_NCCL_CHECK(ncclGroupEnd());
+
+  // Event should only be recorded after the ncclGroupEnd()
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    CUDAStream& ncclStream = ncclStreams_[key][i];
+    CUDAEvent& cudaEvent = work->cudaEvents_[i];
+
+    C10D_CUDA_CHECK(
+        cudaEventRecord(cudaEvent.getEvent(), ncclStream.getStream()));
+  }
+
+  recordQueueing(start);
+  return work;
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allgather(
+    std::vector<at::Tensor>& outputs,
+    std::vector<at::Tensor>& inputs) {
+  // Every output receives the input of every GPU of the group.
+  tensorCheckHelper(inputs, outputs, getSize() * inputs.size());
+
+  auto devices = getDevices(inputs);
+  auto key = getKeyFromDevices(devices);
+  auto& ncclComms = getNCCLComm(key, devices);
+  const auto start = std::chrono::steady_clock::now();
+
+  // First let NCCL streams wait for THC stream
+  syncStreams(thcState_, devices, ncclEvents_[key], ncclStreams_[key]);
+
+  // Work itself will create the CUDA events on all GPUs of tensors
+  auto work =
+      std::make_shared<ProcessGroupNCCL::WorkNCCL>(devices, workEventPool_);
+
+  at::DeviceGuard gpuGuard;
+
+  std::unique_lock<std::mutex> cudaFreeMutexLock(
+      *(THCCachingAllocator_getCudaFreeMutex()));
+
+  C10D_NCCL_CHECK(ncclGroupStart());
+
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    gpuGuard.set_index(devices[i].index());
+    CUDAStream& ncclStream = ncclStreams_[key][i];
+
+    C10D_NCCL_CHECK(ncclAllGather(
+        inputs[i].data_ptr(),
+        outputs[i].data_ptr(),
+        inputs[i].numel(),
+        getNcclDataType(inputs[i].type().scalarType()),
+        ncclComms[i]->getNcclComm(),
+        ncclStream.getStream()));
+  }
+
+  C10D_NCCL_CHECK(ncclGroupEnd());
+
+  // Event should only be recorded after the ncclGroupEnd()
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    CUDAStream& ncclStream = ncclStreams_[key][i];
+    CUDAEvent& cudaEvent = work->cudaEvents_[i];
+
+    C10D_CUDA_CHECK(
+        cudaEventRecord(cudaEvent.getEvent(), ncclStream.getStream()));
+  }
+
+  recordQueueing(start);
+  return work;
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::barrier() {
+  auto devices = barrierDevices_;
+  if (devices.empty()) {
+    int device;
+    C10D_CUDA_CHECK(cudaGetDevice(&device));
+    devices.emplace_back(at::kCUDA, device);
+  }
+
+  std::vector<at::Tensor> tensors;
+  at::DeviceGuard gpuGuard;
+  for (const auto& device : devices) {
+    gpuGuard.set_index(device.index());
+    tensors.push_back(at::zeros({1}, at::device(device).dtype(at::kFloat)));
+  }
+
+  auto work = allreduce(tensors);
+
+  // Wait for the allreduce on the host, which is the point of a barrier
+  auto ncclWork = std::static_pointer_cast<WorkNCCL>(work);
+  for (auto& cudaEvent : ncclWork->cudaEvents_) {
+    C10D_CUDA_CHECK(cudaEventSynchronize(cudaEvent.getEvent()));
+  }
+  return work;
+}
+
+void ProcessGroupNCCL::warmUp(const std::vector<at::Device>& devices) {
+  getNCCLComm(getKeyFromDevices(devices), devices);
+}
+
+ProcessGroupNCCL::Stats ProcessGroupNCCL::getStats() const {
+  std::unique_lock<std::mutex> lock(statsMutex_);
+  auto stats = stats_;
+  stats.numEventsCreated = workEventPool_->numCreated();
+  return stats;
+}
+
+void ProcessGroupNCCL::recordQueueing(
+    std::chrono::steady_clock::time_point start) {
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  std::unique_lock<std::mutex> lock(statsMutex_);
+  ++stats_.numCollectives;
+  stats_.queueingTime += elapsed;
+}
+
 } // namespace c10d
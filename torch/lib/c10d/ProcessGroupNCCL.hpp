@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <mutex>
 #include <unordered_map>
 
@@ -59,8 +60,11 @@ class ProcessGroupNCCL : public ProcessGroup {
  public:
   class WorkNCCL : public ProcessGroup::Work {
    public:
-    // Constructor takes a list of CUDA devices
-    WorkNCCL(const std::vector<at::Device>& devices);
+    // Constructor takes a list of CUDA devices, and the pool to take the
+    // CUDA events from, if any
+    WorkNCCL(
+        const std::vector<at::Device>& devices,
+        const std::shared_ptr<CUDAEventPool>& eventPool = nullptr);
     virtual ~WorkNCCL();
 
     // Checks if request has completed. In this specific case of NCCL, it checks
@@ -93,9 +97,27 @@ class ProcessGroupNCCL : public ProcessGroup {
     // The CUDA events tracking this work item on multiple CUDA devices
     std::vector<CUDAEvent> cudaEvents_;
 
+    // The pool the events are returned to
+    std::shared_ptr<CUDAEventPool> eventPool_;
+
     friend class ProcessGroupNCCL;
   };
 
+  struct Stats {
+    // NCCL communicators created, and the time spent creating them,
+    // including the rendezvous of all the ranks through the store
+    size_t numCommunicatorInits = 0;
+    std::chrono::nanoseconds communicatorInitTime{0};
+
+    // Collectives issued, and the time the calling thread spent queueing
+    // them on the NCCL streams, excluding the communicator creation
+    size_t numCollectives = 0;
+    std::chrono::nanoseconds queueingTime{0};
+
+    // CUDA events created for the work items, which are otherwise reused
+    size_t numEventsCreated = 0;
+  };
+
   // Constructor will also check the number of available GPUs in the system
   ProcessGroupNCCL(const std::shared_ptr<Store>& store, int rank, int size);
 
@@ -109,6 +131,32 @@ class ProcessGroupNCCL : public ProcessGroup {
       std::vector<at::Tensor>& tensors,
       const AllreduceOptions& opts = AllreduceOptions()) override;
 
+  // With several GPUs per process, the chunks of the result are ordered by
+  // process and then by the index of the input tensor.
+  std::shared_ptr<ProcessGroup::Work> reduceScatter(
+      std::vector<at::Tensor>& outputs,
+      std::vector<at::Tensor>& inputs,
+      const ReduceScatterOptions& opts = ReduceScatterOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allgather(
+      std::vector<at::Tensor>& outputs,
+      std::vector<at::Tensor>& inputs) override;
+
+  // Allreduces a single element on the GPUs of the first collective of this
+  // process group (or on the current GPU), and waits for it on the host, so
+  // unlike the other functions it blocks the caller.
+  //
+  // alltoall, send and recv are not supported, since NCCL has no
+  // point-to-point primitives.
+  std::shared_ptr<ProcessGroup::Work> barrier() override;
+
+  // Creates the NCCL communicators of a list of devices ahead of the first
+  // collective on them, which is otherwise delayed by the rendezvous. Must
+  // be called by all the processes with the same number of devices.
+  void warmUp(const std::vector<at::Device>& devices);
+
+  Stats getStats() const;
+
  protected:
   // Helper that broadcasts nccl unique ID to all ranks through the store
   void broadcastUniqueNCCLID(ncclUniqueId* ncclID);
@@ -150,12 +198,29 @@ class ProcessGroupNCCL : public ProcessGroup {
   std::unordered_map<std::string, std::vector<std::shared_ptr<NCCLComm>>>
       devNCCLCommMap_;
 
-  // The CUDA steams used by NCCL kernels
+  // The CUDA steams used by NCCL kernels, which are the streams of
+  // deviceStreams_ of their devices
   std::unordered_map<std::string, std::vector<CUDAStream>> ncclStreams_;
 
+  // The high priority stream of every device, which all the collectives on
+  // the device run on, by device index
+  std::unordered_map<int, CUDAStream> deviceStreams_;
+
+  // The CUDA events of the work items
+  std::shared_ptr<CUDAEventPool> workEventPool_;
+
+  // Adds a collective that started queueing at the given time to the stats
+  void recordQueueing(std::chrono::steady_clock::time_point start);
+
+  mutable std::mutex statsMutex_;
+  Stats stats_;
+
   // The CUDA events used to sync NCCL streams
   std::unordered_map<std::string, std::vector<CUDAEvent>> ncclEvents_;
 
+  // The devices of the first NCCL communicator, used by the barrier
+  std::vector<at::Device> barrierDevices_;
+
   // Store copy of pointer to THCState retrieved from ::at::globalContext().
   THCState* thcState_;
 
@@ -23,6 +23,16 @@ class Store {
 
   virtual std::vector<uint8_t> get(const std::string& key) = 0;
 
+  // Sets or gets several keys at once. Stores that can serve them in a
+  // single request override these; by default they are set or got one by
+  // one.
+  virtual void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values);
+
+  virtual std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys);
+
   virtual int64_t add(const std::string& key, int64_t value) = 0;
 
   virtual bool check(const std::vector<std::string>& keys) = 0;
@@ -1,21 +1,86 @@
 #include "TCPStore.hpp"
 
-#include <poll.h>
+#include <sys/epoll.h>
 
 #include <unistd.h>
 #include <algorithm>
+#include <cstring>
 #include <system_error>
 
 namespace c10d {
 
 namespace {
 
-enum class QueryType : uint8_t { SET, GET, ADD, CHECK, WAIT };
+enum class QueryType : uint8_t {
+  SET,
+  GET,
+  ADD,
+  CHECK,
+  WAIT,
+  MULTI_SET,
+  MULTI_GET
+};
 
 enum class CheckResponseType : uint8_t { READY, NOT_READY };
 
 enum class WaitResponseType : uint8_t { STOP_WAITING };
 
+constexpr int kMaxEpollEvents = 64;
+
+// Builds a whole message, in the same format as the tcputil functions, so
+// that it is handed to the kernel with a single send rather than one per
+// field.
+class SendBuffer {
+ public:
+  explicit SendBuffer(int socket) : socket_(socket) {}
+
+  template <typename T>
+  void appendValue(const T& value) {
+    appendBytes(&value, sizeof(T));
+  }
+
+  void appendString(const std::string& str) {
+    appendValue<SizeType>(str.size());
+    appendBytes(str.data(), str.size());
+  }
+
+  void appendVector(const std::vector<uint8_t>& vec) {
+    appendValue<SizeType>(vec.size());
+    appendBytes(vec.data(), vec.size());
+  }
+
+  void appendKeys(const std::vector<std::string>& keys) {
+    appendValue<SizeType>(keys.size());
+    for (const auto& key : keys) {
+      appendString(key);
+    }
+  }
+
+  void flush() {
+    tcputil::sendBytes<uint8_t>(socket_, buffer_.data(), buffer_.size());
+    buffer_.clear();
+  }
+
+ private:
+  void appendBytes(const void* data, size_t size) {
+    auto bytes = reinterpret_cast<const uint8_t*>(data);
+    buffer_.insert(buffer_.end(), bytes, bytes + size);
+  }
+
+  int socket_;
+  std::vector<uint8_t> buffer_;
+};
+
+std::vector<std::string> recvKeys(int socket) {
+  SizeType nargs;
+  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
+  std::vector<std::string> keys(nargs);
+  for (size_t i = 0; i < nargs; i++) {
+    keys[i] = tcputil::recvString(socket);
+  }
+  return keys;
+}
+
 } // anonymous namespace
 
 // TCPStoreDaemon class methods
@@ -42,6 +107,9 @@ TCPStoreDaemon::~TCPStoreDaemon() {
       ::close(fd);
     }
   }
+  if (epollFd_ != -1) {
+    ::close(epollFd_);
+  }
 }
 
 void TCPStoreDaemon::join() {
@@ -56,65 +124,69 @@ void TCPStoreDaemon::run() {
         "TCPStoreDaemon run");
   }
 
-  std::vector<struct pollfd> fds;
-  fds.push_back({.fd = storeListenSocket_, .events = POLLIN});
-  // Push the read end of the pipe to signal the stopping of the daemon run
-  fds.push_back({.fd = controlPipeFd_[0], .events = POLLHUP});
+  SYSCHECK(epollFd_ = ::epoll_create1(EPOLL_CLOEXEC));
+  struct epoll_event event;
+  std::memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN;
+  event.data.fd = storeListenSocket_;
+  SYSCHECK(::epoll_ctl(epollFd_, EPOLL_CTL_ADD, storeListenSocket_, &event));
+  // Add the read end of the pipe to signal the stopping of the daemon run
+  event.data.fd = controlPipeFd_[0];
+  SYSCHECK(::epoll_ctl(epollFd_, EPOLL_CTL_ADD, controlPipeFd_[0], &event));
 
   // receive the queries
+  struct epoll_event events[kMaxEpollEvents];
   bool finished = false;
   while (!finished) {
-    for (size_t i = 0; i < sockets_.size(); i++) {
-      fds[i].revents = 0;
-    }
-
-    SYSCHECK(::poll(fds.data(), fds.size(), -1));
-
-    // TCPStore's listening socket has an event and it should now be able to
-    // accept new connections.
-    if (fds[0].revents != 0) {
-      if (fds[0].revents ^ POLLIN) {
-        throw std::system_error(
-            ECONNABORTED,
-            std::system_category(),
-            "Unexpected poll revent on the master's listening socket: " +
-                std::to_string(fds[0].revents));
-      }
-      int sockFd = std::get<0>(tcputil::accept(storeListenSocket_));
-      sockets_.push_back(sockFd);
-      fds.push_back({.fd = sockFd, .events = POLLIN});
-    }
-    // The pipe receives an event which tells us to shutdown the daemon
-    if (fds[1].revents != 0) {
-      // Will be POLLUP when the pipe is closed
-      if (fds[1].revents ^ POLLHUP) {
-        throw std::system_error(
-            ECONNABORTED,
-            std::system_category(),
-            "Unexpected poll revent on the control pipe's reading fd: " +
-                std::to_string(fds[1].revents));
-      }
-      finished = true;
-      break;
-    }
-    // Skipping the fds[0] and fds[1],
-    // fds[0] is master's listening socket
-    // fds[1] is control pipe's reading fd
-    for (size_t fdIdx = 2; fdIdx < fds.size(); ++fdIdx) {
-      if (fds[fdIdx].revents == 0) {
+    int numEvents;
+    SYSCHECK(
+        numEvents = ::epoll_wait(epollFd_, events, kMaxEpollEvents, -1));
+
+    for (int i = 0; i < numEvents; ++i) {
+      const int fd = events[i].data.fd;
+      const uint32_t revents = events[i].events;
+
+      // TCPStore's listening socket has an event and it should now be able
+      // to accept new connections.
+      if (fd == storeListenSocket_) {
+        if (revents ^ EPOLLIN) {
+          throw std::system_error(
+              ECONNABORTED,
+              std::system_category(),
+              "Unexpected epoll event on the master's listening socket: " +
+                  std::to_string(revents));
+        }
+        int sockFd = std::get<0>(tcputil::accept(storeListenSocket_));
+        sockets_.push_back(sockFd);
+        struct epoll_event clientEvent;
+        std::memset(&clientEvent, 0, sizeof(clientEvent));
+        clientEvent.events = EPOLLIN;
+        clientEvent.data.fd = sockFd;
+        SYSCHECK(::epoll_ctl(epollFd_, EPOLL_CTL_ADD, sockFd, &clientEvent));
         continue;
       }
 
-      if (fds[fdIdx].revents ^ POLLIN) {
-        throw std::system_error(
-            ECONNABORTED,
-            std::system_category(),
-            "Unexpected poll revent: " + std::to_string(fds[fdIdx].revents) +
-                " on socket: " + std::to_string(fds[fdIdx].fd));
+      // The pipe receives an event which tells us to shutdown the daemon.
+      // It is EPOLLHUP when the write end of the pipe is closed.
+      if (fd == controlPipeFd_[0]) {
+        if (revents ^ EPOLLHUP) {
+          throw std::system_error(
+              ECONNABORTED,
+              std::system_category(),
+              "Unexpected epoll event on the control pipe's reading fd: " +
+                  std::to_string(revents));
+        }
+        finished = true;
+        break;
       }
-      // Now query the socket that has the event
+
+      // Now query the socket that has the event. A socket that is waiting
+      // for keys only reports errors and hang-ups, which close it.
       try {
-        query(fds[fdIdx].fd);
+        if (!(revents & EPOLLIN)) {
+          throw std::system_error(ECONNRESET, std::system_category());
+        }
+        query(fd);
       } catch (...) {
         // There was an error when processing query. Probably an exception
         // occurred in recv/send what would indicate that socket on the other
@@ -123,39 +195,41 @@ void TCPStoreDaemon::run() {
         // exception, other connections will get an exception once they try to
         // use the store. We will go ahead and close this connection whenever
         // we hit an exception here.
-        ::close(fds[fdIdx].fd);
-
-        // Remove all the tracking state of the close FD
-        for (auto it = waitingSockets_.begin(); it != waitingSockets_.end();) {
-          for (auto vecIt = it->second.begin(); vecIt != it->second.end();) {
-            if (*vecIt == fds[fdIdx].fd) {
-              vecIt = it->second.erase(vecIt);
-            } else {
-              ++vecIt;
-            }
-          }
-          if (it->second.size() == 0) {
-            it = waitingSockets_.erase(it);
-          } else {
-            ++it;
-          }
-        }
-        for (auto it = keysAwaited_.begin(); it != keysAwaited_.end();) {
-          if (it->first == fds[fdIdx].fd) {
-            it = keysAwaited_.erase(it);
-          } else {
-            ++it;
-          }
-        }
-        fds.erase(fds.begin() + fdIdx);
-        sockets_.erase(sockets_.begin() + fdIdx - 2);
-        --fdIdx;
-        continue;
+        closeSocket(fd);
       }
     }
   }
 }
 
+void TCPStoreDaemon::watchSocket(int socket, bool watch) {
+  struct epoll_event event;
+  std::memset(&event, 0, sizeof(event));
+  event.events = watch ? EPOLLIN : 0;
+  event.data.fd = socket;
+  SYSCHECK(::epoll_ctl(epollFd_, EPOLL_CTL_MOD, socket, &event));
+}
+
+void TCPStoreDaemon::closeSocket(int socket) {
+  // Closing the socket also removes it from the epoll set.
+  ::close(socket);
+
+  // Remove all the tracking state of the close FD
+  if (keysAwaited_.erase(socket) > 0) {
+    for (auto it = waitingSockets_.begin(); it != waitingSockets_.end();) {
+      auto& sockets = it->second;
+      sockets.erase(
+          std::remove(sockets.begin(), sockets.end(), socket), sockets.end());
+      if (sockets.empty()) {
+        it = waitingSockets_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  sockets_.erase(
+      std::remove(sockets_.begin(), sockets_.end(), socket), sockets_.end());
+}
+
 void TCPStoreDaemon::stop() {
   if (controlPipeFd_[1] != -1) {
     // close the write end of the pipe
@@ -167,8 +241,11 @@ void TCPStoreDaemon::stop() {
 // query communicates with the worker. The format
 // of the query is as follows:
 // type of query | size of arg1 | arg1 | size of arg2 | arg2 | ...
-// or, in the case of wait
+// or, in the case of check, wait and multi get
 // type of query | number of args | size of arg1 | arg1 | ...
+// or, in the case of multi set
+// type of query | number of keys | size of key1 | key1 | size of value1 |
+// value1 | ...
 void TCPStoreDaemon::query(int socket) {
   QueryType qt;
   tcputil::recvBytes<QueryType>(socket, &qt, 1);
@@ -188,6 +265,12 @@ void TCPStoreDaemon::query(int socket) {
   } else if (qt == QueryType::WAIT) {
     waitHandler(socket);
 
+  } else if (qt == QueryType::MULTI_SET) {
+    multiSetHandler(socket);
+
+  } else if (qt == QueryType::MULTI_GET) {
+    multiGetHandler(socket);
+
   } else {
     throw std::runtime_error("Unexpected query type");
   }
@@ -198,8 +281,11 @@ void TCPStoreDaemon::wakeupWaitingClients(const std::string& key) {
   if (socketsToWait != waitingSockets_.end()) {
     for (int socket : socketsToWait->second) {
       if (--keysAwaited_[socket] == 0) {
+        keysAwaited_.erase(socket);
         tcputil::sendValue<WaitResponseType>(
             socket, WaitResponseType::STOP_WAITING);
+        // Read the queries that were pipelined after the wait.
+        watchSocket(socket, true);
       }
     }
     waitingSockets_.erase(socketsToWait);
@@ -237,12 +323,7 @@ void TCPStoreDaemon::getHandler(int socket) const {
 }
 
 void TCPStoreDaemon::checkHandler(int socket) const {
-  SizeType nargs;
-  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
-  std::vector<std::string> keys(nargs);
-  for (size_t i = 0; i < nargs; i++) {
-    keys[i] = tcputil::recvString(socket);
-  }
+  std::vector<std::string> keys = recvKeys(socket);
   // Now we have received all the keys
   if (checkKeys(keys)) {
     tcputil::sendValue<CheckResponseType>(socket, CheckResponseType::READY);
@@ -252,13 +333,17 @@ void TCPStoreDaemon::checkHandler(int socket) const {
 }
 
 void TCPStoreDaemon::waitHandler(int socket) {
-  SizeType nargs;
-  tcputil::recvBytes<SizeType>(socket, &nargs, 1);
-  std::vector<std::string> keys(nargs);
-  for (size_t i = 0; i < nargs; i++) {
-    keys[i] = tcputil::recvString(socket);
-  }
-  if (checkKeys(keys)) {
+  std::vector<std::string> keys = recvKeys(socket);
+  // Only wait for the missing keys, each of them once.
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  keys.erase(
+      std::remove_if(
+          keys.begin(),
+          keys.end(),
+          [this](const std::string& key) { return tcpStore_.count(key) > 0; }),
+      keys.end());
+  if (keys.empty()) {
     tcputil::sendValue<WaitResponseType>(
         socket, WaitResponseType::STOP_WAITING);
   } else {
@@ -266,9 +351,31 @@ void TCPStoreDaemon::waitHandler(int socket) {
       waitingSockets_[key].push_back(socket);
     }
     keysAwaited_[socket] = keys.size();
+    // The client may have pipelined queries that need the keys, such as a
+    // get, so they are left unread until the keys are set.
+    watchSocket(socket, false);
   }
 }
 
+void TCPStoreDaemon::multiSetHandler(int socket) {
+  SizeType nkeys;
+  tcputil::recvBytes<SizeType>(socket, &nkeys, 1);
+  for (size_t i = 0; i < nkeys; i++) {
+    std::string key = tcputil::recvString(socket);
+    tcpStore_[key] = tcputil::recvVector<uint8_t>(socket);
+    wakeupWaitingClients(key);
+  }
+}
+
+void TCPStoreDaemon::multiGetHandler(int socket) const {
+  std::vector<std::string> keys = recvKeys(socket);
+  SendBuffer response(socket);
+  for (const auto& key : keys) {
+    response.appendVector(tcpStore_.at(key));
+  }
+  response.flush();
+}
+
 bool TCPStoreDaemon::checkKeys(const std::vector<std::string>& keys) const {
   return std::all_of(keys.begin(), keys.end(), [this](const std::string& s) {
     return tcpStore_.count(s) > 0;
@@ -305,32 +412,75 @@ TCPStore::~TCPStore() {
 }
 
 void TCPStore::set(const std::string& key, const std::vector<uint8_t>& data) {
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::SET);
-  tcputil::sendString(storeSocket_, key, true);
-  tcputil::sendVector<uint8_t>(storeSocket_, data);
+  SendBuffer request(storeSocket_);
+  request.appendValue<QueryType>(QueryType::SET);
+  request.appendString(key);
+  request.appendVector(data);
+  request.flush();
 }
 
 std::vector<uint8_t> TCPStore::get(const std::string& key) {
-  wait({key});
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::GET);
-  tcputil::sendString(storeSocket_, key);
+  // The get is pipelined after the wait, and is answered once the key is
+  // set.
+  setTimeout(kDefaultTimeout);
+  SendBuffer request(storeSocket_);
+  request.appendValue<QueryType>(QueryType::WAIT);
+  request.appendKeys({key});
+  request.appendValue<QueryType>(QueryType::GET);
+  request.appendString(key);
+  request.flush();
+  recvWaitResponse();
   return tcputil::recvVector<uint8_t>(storeSocket_);
 }
 
+void TCPStore::multiSet(
+    const std::vector<std::string>& keys,
+    const std::vector<std::vector<uint8_t>>& values) {
+  if (keys.size() != values.size()) {
+    throw std::invalid_argument("multiSet needs as many values as keys");
+  }
+  SendBuffer request(storeSocket_);
+  request.appendValue<QueryType>(QueryType::MULTI_SET);
+  request.appendValue<SizeType>(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    request.appendString(keys[i]);
+    request.appendVector(values[i]);
+  }
+  request.flush();
+}
+
+std::vector<std::vector<uint8_t>> TCPStore::multiGet(
+    const std::vector<std::string>& keys) {
+  setTimeout(kDefaultTimeout);
+  SendBuffer request(storeSocket_);
+  request.appendValue<QueryType>(QueryType::WAIT);
+  request.appendKeys(keys);
+  request.appendValue<QueryType>(QueryType::MULTI_GET);
+  request.appendKeys(keys);
+  request.flush();
+  recvWaitResponse();
+  std::vector<std::vector<uint8_t>> values;
+  values.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    values.push_back(tcputil::recvVector<uint8_t>(storeSocket_));
+  }
+  return values;
+}
+
 int64_t TCPStore::add(const std::string& key, int64_t value) {
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::ADD);
-  tcputil::sendString(storeSocket_, key, true);
-  tcputil::sendValue<int64_t>(storeSocket_, value);
+  SendBuffer request(storeSocket_);
+  request.appendValue<QueryType>(QueryType::ADD);
+  request.appendString(key);
+  request.appendValue<int64_t>(value);
+  request.flush();
   return tcputil::recvValue<int64_t>(storeSocket_);
 }
 
 bool TCPStore::check(const std::vector<std::string>& keys) {
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::CHECK);
-  SizeType nkeys = keys.size();
-  tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, (nkeys > 0));
-  for (size_t i = 0; i < nkeys; i++) {
-    tcputil::sendString(storeSocket_, keys[i], (i != (nkeys - 1)));
-  }
+  SendBuffer request(storeSocket_);
+  request.appendValue<QueryType>(QueryType::CHECK);
+  request.appendKeys(keys);
+  request.flush();
   auto checkResponse = tcputil::recvValue<CheckResponseType>(storeSocket_);
   if (checkResponse == CheckResponseType::READY) {
     return true;
@@ -344,6 +494,15 @@ bool TCPStore::check(const std::vector<std::string>& keys) {
 void TCPStore::wait(
     const std::vector<std::string>& keys,
     const std::chrono::milliseconds& timeout) {
+  setTimeout(timeout);
+  SendBuffer request(storeSocket_);
+  request.appendValue<QueryType>(QueryType::WAIT);
+  request.appendKeys(keys);
+  request.flush();
+  recvWaitResponse();
+}
+
+void TCPStore::setTimeout(const std::chrono::milliseconds& timeout) {
   // Set the socket timeout if there is a wait timeout
   if (timeout != kNoTimeout) {
     struct timeval timeoutTV = {.tv_sec = timeout.count() / 1000,
@@ -355,12 +514,9 @@ void TCPStore::wait(
         reinterpret_cast<char*>(&timeoutTV),
         sizeof(timeoutTV)));
   }
-  tcputil::sendValue<QueryType>(storeSocket_, QueryType::WAIT);
-  SizeType nkeys = keys.size();
-  tcputil::sendBytes<SizeType>(storeSocket_, &nkeys, 1, (nkeys > 0));
-  for (size_t i = 0; i < nkeys; i++) {
-    tcputil::sendString(storeSocket_, keys[i], (i != (nkeys - 1)));
-  }
+}
+
+void TCPStore::recvWaitResponse() {
   auto waitResponse = tcputil::recvValue<WaitResponseType>(storeSocket_);
   if (waitResponse != WaitResponseType::STOP_WAITING) {
     throw std::runtime_error("Stop_waiting response is expected");
@@ -9,6 +9,9 @@
 
 namespace c10d {
 
+// The daemon serves all the clients from one thread, with an epoll loop.
+// Clients may pipeline their queries: the queries that follow a WAIT on a
+// socket are only read once the keys of the WAIT are set.
 class TCPStoreDaemon {
  public:
   explicit TCPStoreDaemon(int storeListenSocket);
@@ -27,11 +30,19 @@ class TCPStoreDaemon {
   void getHandler(int socket) const;
   void checkHandler(int socket) const;
   void waitHandler(int socket);
+  void multiSetHandler(int socket);
+  void multiGetHandler(int socket) const;
 
   bool checkKeys(const std::vector<std::string>& keys) const;
   void wakeupWaitingClients(const std::string& key);
 
+  // Starts or stops reading the queries of a socket.
+  void watchSocket(int socket, bool watch);
+  // Closes a client socket and drops its tracking state.
+  void closeSocket(int socket);
+
   std::thread daemonThread_;
+  int epollFd_ = -1;
   std::unordered_map<std::string, std::vector<uint8_t>> tcpStore_;
   // From key -> the list of sockets waiting on it
   std::unordered_map<std::string, std::vector<int>> waitingSockets_;
@@ -56,6 +67,15 @@ class TCPStore : public Store {
 
   std::vector<uint8_t> get(const std::string& key) override;
 
+  // Both are served with a single request, and multiGet waits for all the
+  // keys in the same round trip.
+  void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values) override;
+
+  std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys) override;
+
   int64_t add(const std::string& key, int64_t value) override;
 
   bool check(const std::vector<std::string>& keys) override;
@@ -65,6 +85,9 @@ class TCPStore : public Store {
       const std::chrono::milliseconds& timeout = kDefaultTimeout) override;
 
  protected:
+  void setTimeout(const std::chrono::milliseconds& timeout);
+  void recvWaitResponse();
+
   bool isServer_;
   int storeSocket_ = -1;
   int masterListenSocket_ = -1;
@@ -7,6 +7,12 @@ namespace c10d {
 enum class CollectiveType : std::uint8_t {
   BROADCAST,
   ALLREDUCE,
+  REDUCE_SCATTER,
+  ALLGATHER,
+  ALLTOALL,
+  SEND,
+  RECV,
+  BARRIER,
   UNUSED,
 };
 
@@ -27,4 +33,15 @@ struct AllreduceOptions {
   ReduceOp reduceOp = ReduceOp::SUM;
 };
 
+struct AllreduceCoalescedOptions {
+  ReduceOp reduceOp = ReduceOp::SUM;
+  // Tensors are packed into flat buffers of up to this size; larger tensors
+  // get a buffer of their own.
+  int64_t bucketBytes = 25 * 1024 * 1024;
+};
+
+struct ReduceScatterOptions {
+  ReduceOp reduceOp = ReduceOp::SUM;
+};
+
 } // namespace c10d
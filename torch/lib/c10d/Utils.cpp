@@ -21,7 +21,9 @@ namespace tcputil {
 
 namespace {
 
-constexpr int LISTEN_QUEUE_SIZE = 64;
+// Large enough for the connections of all the ranks of a big job to the store
+// at startup, which would otherwise be dropped and retried.
+constexpr int LISTEN_QUEUE_SIZE = 2048;
 
 void setSocketNoDelay(int socket) {
   int flag = 1;
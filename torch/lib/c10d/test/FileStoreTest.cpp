@@ -48,6 +48,36 @@ int main(int argc, char** argv) {
     c10d::test::check(store, "key0", "value0");
   }
 
+  // Block in get and wait until another instance sets the key
+  {
+    c10d::FileStore store(path);
+    std::thread setter([&] {
+      c10d::FileStore other(path);
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      c10d::test::set(other, "key3", "value3");
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      c10d::test::set(other, "key4", "value4");
+    });
+    c10d::test::check(store, "key3", "value3");
+    store.wait({"key4"});
+    c10d::test::check(store, "key4", "value4");
+    setter.join();
+  }
+
+  // Wait times out on a key that is never set
+  {
+    c10d::FileStore store(path);
+    bool timedOut = false;
+    try {
+      store.wait({"missing"}, std::chrono::milliseconds(100));
+    } catch (const std::runtime_error&) {
+      timedOut = true;
+    }
+    if (!timedOut) {
+      throw std::runtime_error("Expected wait to time out");
+    }
+  }
+
   // Hammer on FileStore#add
   std::vector<std::thread> threads;
   const auto numThreads = 4;
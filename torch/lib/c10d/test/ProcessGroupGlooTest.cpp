@@ -3,6 +3,7 @@
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <condition_variable>
 #include <iostream>
 #include <mutex>
@@ -186,6 +187,65 @@ void testAllreduce(const std::string& path, const at::Backend b) {
   }
 }
 
+void testAllreduceCoalesced(const std::string& path, const at::Backend b) {
+  const auto size = 4;
+  auto tests = CollectiveTest::initialize(path, size);
+
+  // Tensors of two types and of different sizes, with buckets small enough
+  // to need several buckets of each type
+  const std::vector<at::ScalarType> scalarTypes = {
+      at::kFloat, at::kDouble, at::kFloat, at::kFloat, at::kDouble};
+  const std::vector<int64_t> numels = {16, 32, 100, 4, 7};
+  ::c10d::AllreduceCoalescedOptions options;
+  options.bucketBytes = 256;
+
+  // Run twice, to also allreduce through the cached buffers
+  for (auto iteration = 0; iteration < 2; iteration++) {
+    std::vector<std::vector<at::Tensor>> inputs(size);
+    for (auto i = 0; i < size; i++) {
+      for (size_t j = 0; j < numels.size(); j++) {
+        const auto& type = at::getType(b, scalarTypes[j]);
+        inputs[i].push_back(at::ones(type, {numels[j]}) * (i + iteration));
+      }
+    }
+
+    // The collective blocks until it is done, so every process group runs
+    // in its own thread
+    std::vector<std::thread> threads;
+    std::vector<bool> success(size, true);
+    for (auto i = 0; i < size; i++) {
+      threads.emplace_back([&, i] {
+        try {
+          tests[i].getProcessGroup().allreduceCoalesced(inputs[i], options);
+        } catch (const std::exception& ex) {
+          std::cerr << "allreduceCoalesced failed: " << ex.what() << std::endl;
+          success[i] = false;
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    if (std::find(success.begin(), success.end(), false) != success.end()) {
+      throw std::runtime_error("BOOM!");
+    }
+
+    // Verify outputs
+    const auto expected = (size * (size - 1)) / 2 + size * iteration;
+    for (auto i = 0; i < size; i++) {
+      for (size_t j = 0; j < numels.size(); j++) {
+        auto tensor = inputs[i][j].toBackend(at::kCPU).toType(at::kDouble);
+        auto data = tensor.data<double>();
+        for (auto k = 0; k < tensor.numel(); k++) {
+          if (data[k] != expected) {
+            throw std::runtime_error("BOOM!");
+          }
+        }
+      }
+    }
+  }
+}
+
 void testBroadcast(const std::string& path, const at::Backend b) {
   const auto size = 2;
   const auto stride = 2;
@@ -269,6 +329,16 @@ int main(int argc, char** argv) {
     testAllreduce(file.path, at::kCUDA);
   }
 
+  {
+    TemporaryFile file;
+    testAllreduceCoalesced(file.path, at::kCPU);
+  }
+
+  {
+    TemporaryFile file;
+    testAllreduceCoalesced(file.path, at::kCUDA);
+  }
+
   {
     TemporaryFile file;
     testBroadcast(file.path, at::kCPU);
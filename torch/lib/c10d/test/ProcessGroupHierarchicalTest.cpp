@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <iostream>
+
+#include <c10d/FileStore.hpp>
+#include <c10d/ProcessGroupGloo.hpp>
+#include <c10d/ProcessGroupHierarchical.hpp>
+#include <c10d/ProcessGroupNCCL.hpp>
+#include <c10d/test/CUDATest.hpp>
+#include <c10d/test/TestUtils.hpp>
+
+using namespace c10d::test;
+
+// Runs as two "nodes" of numDevices / 2 processes each on this machine, with
+// one GPU per process.
+void runRank(
+    int rank,
+    int localSize,
+    const std::vector<std::string>& nodePaths,
+    const std::vector<std::string>& localRankPaths) {
+  const int nodeRank = rank / localSize;
+  const int localRank = rank % localSize;
+  const int size = localSize * nodePaths.size();
+  at::DeviceGuard deviceGuard;
+  deviceGuard.set_index(rank);
+
+  auto intra = std::make_shared<::c10d::ProcessGroupNCCL>(
+      std::make_shared<::c10d::FileStore>(nodePaths[nodeRank]),
+      localRank,
+      localSize);
+  auto inter = std::make_shared<::c10d::ProcessGroupGloo>(
+      std::make_shared<::c10d::FileStore>(localRankPaths[localRank]),
+      nodeRank,
+      nodePaths.size(),
+      ::c10d::ProcessGroupGloo::Options());
+  ::c10d::ProcessGroupHierarchical pg(intra, inter);
+  if (pg.getRank() != rank || pg.getSize() != size) {
+    throw std::runtime_error("Unexpected rank or size");
+  }
+
+  // The number of elements isn't a multiple of the intra-node group size,
+  // to test the padding of the shards.
+  const auto& type = at::getType(at::kCUDA, at::kFloat);
+  std::vector<at::Tensor> tensors = {
+      at::ones(type, {3, localSize * 5 + 1}) * rank};
+  pg.allreduce(tensors)->wait();
+
+  const auto expected = (size * (size - 1)) / 2;
+  auto output = tensors[0].toBackend(at::kCPU);
+  auto data = output.data<float>();
+  for (auto k = 0; k < output.numel(); k++) {
+    if (data[k] != expected) {
+      throw std::runtime_error("BOOM!");
+    }
+  }
+
+  // Try every root of the broadcast
+  for (auto rootRank = 0; rootRank < size; rootRank++) {
+    tensors[0].fill_(rank);
+    ::c10d::BroadcastOptions options;
+    options.rootRank = rootRank;
+    pg.broadcast(tensors, options)->wait();
+    output = tensors[0].toBackend(at::kCPU);
+    data = output.data<float>();
+    for (auto k = 0; k < output.numel(); k++) {
+      if (data[k] != rootRank) {
+        throw std::runtime_error("BOOM!");
+      }
+    }
+  }
+}
+
+// CUDA can't be used after a fork once it is initialized, so the devices are
+// counted in a child process.
+int countDevices() {
+  pid_t pid = fork();
+  if (pid < 0) {
+    throw std::system_error(errno, std::system_category(), "fork");
+  }
+  if (pid == 0) {
+    _exit(std::min(cudaNumDevices(), 255));
+  }
+  int status;
+  waitpid(pid, &status, 0);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : 0;
+}
+
+int main(int argc, char** argv) {
+  const int numDevices = countDevices();
+  if (numDevices < 2) {
+    std::cout << "Hierarchical test needs at least 2 GPUs, skipping"
+              << std::endl;
+    return EXIT_SUCCESS;
+  }
+  const int localSize = numDevices / 2;
+  const int size = localSize * 2;
+
+  std::vector<TemporaryFile> files(2 + localSize);
+  std::vector<std::string> nodePaths = {files[0].path, files[1].path};
+  std::vector<std::string> localRankPaths;
+  for (auto i = 0; i < localSize; i++) {
+    localRankPaths.push_back(files[2 + i].path);
+  }
+
+  // Every rank runs in its own process, so that the NCCL process groups of
+  // the ranks are set up like on separate nodes.
+  std::vector<pid_t> pids;
+  for (auto rank = 0; rank < size; rank++) {
+    pid_t pid = fork();
+    if (pid < 0) {
+      throw std::system_error(errno, std::system_category(), "fork");
+    }
+    if (pid == 0) {
+      try {
+        runRank(rank, localSize, nodePaths, localRankPaths);
+      } catch (const std::exception& e) {
+        std::cerr << "Rank " << rank << " failed: " << e.what() << std::endl;
+        _exit(EXIT_FAILURE);
+      }
+      _exit(EXIT_SUCCESS);
+    }
+    pids.push_back(pid);
+  }
+
+  bool success = true;
+  for (auto pid : pids) {
+    int status;
+    waitpid(pid, &status, 0);
+    success = success && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+  if (!success) {
+    return EXIT_FAILURE;
+  }
+  std::cout << "Hierarchical test successful" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -1,5 +1,6 @@
 #include "StoreTestCommon.hpp"
 
+#include <chrono>
 #include <cstdlib>
 #include <iostream>
 #include <thread>
@@ -83,6 +84,34 @@ int main(int argc, char** argv) {
     c10d::test::check(serverStore, key, val);
   }
 
+  // Batched set and get of many keys, and a get of keys that are only set
+  // later by another client
+  {
+    c10d::TCPStore clientStore("127.0.0.1", 29500, false);
+    const auto numKeys = 2048;
+    std::vector<std::string> keys;
+    std::vector<std::vector<uint8_t>> values;
+    for (auto i = 0; i < numKeys; i++) {
+      keys.push_back("multi_" + std::to_string(i));
+      std::string val = "multi_val_" + std::to_string(i);
+      values.emplace_back(val.begin(), val.end());
+    }
+    std::thread setter([&keys, &values] {
+      c10d::TCPStore setterStore("127.0.0.1", 29500, false);
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      setterStore.multiSet(keys, values);
+    });
+    auto results = clientStore.multiGet(keys);
+    setter.join();
+    if (results != values) {
+      throw std::runtime_error("multiGet returned unexpected values");
+    }
+    c10d::test::check(serverStore, keys.back(), "multi_val_2047");
+    // The queries pipelined after the wait are still served in order
+    c10d::test::set(clientStore, "after_multi", "value");
+    c10d::test::check(clientStore, "after_multi", "value");
+  }
+
   std::cout << "Test succeeded" << std::endl;
   return EXIT_SUCCESS;
 }
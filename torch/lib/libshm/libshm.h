@@ -4,6 +4,8 @@
 
 #ifdef __cplusplus
 
+#include <memory>
+
 void libshm_init(const char *manager_exec_path);
 
 // Superclass to run a constructor before THRefcountedMapAllocator
@@ -30,4 +32,50 @@ public:
   const char* manager_handle() const { return manager_handle_.c_str(); }
 };
 
+struct THManagedSegment;
+
+// A storage in a block of a large shared memory segment (see pool.cpp). The
+// blocks of a process come from the segments of its pool, and every process
+// maps a segment only once, so that sending a storage to another process
+// costs no new shared memory file. The refcount of a block lives in the
+// segment, and the process that allocated the block reuses it once no process
+// holds it any more.
+class THManagedPoolBlock {
+public:
+  // A new block of size bytes from the pool of this process.
+  static at::DataPtr makeDataPtr(ptrdiff_t size);
+  // The block of another process (or of this one) at offset in the segment
+  // segment_name. generation must be the value of generation() in the process
+  // that sent the block.
+  static at::DataPtr makeDataPtr(const char* manager_handle, const char* segment_name,
+                                 ptrdiff_t segment_size, ptrdiff_t offset, int64_t generation);
+  static THManagedPoolBlock* fromDataPtr(const at::DataPtr&);
+
+  // Like THRefcountedMapAllocator::incref and decref, for the block and its
+  // segment, so that both outlive the sending of the block.
+  void incref();
+  void decref();
+
+  const char* manager_handle() const;
+  const char* segment_name() const;
+  ptrdiff_t segment_size() const;
+  ptrdiff_t offset() const { return offset_; }
+  // Tells the blocks apart that reuse the same offset of a segment.
+  int64_t generation() const;
+  void* data() const;
+
+  ~THManagedPoolBlock();
+
+private:
+  THManagedPoolBlock(std::shared_ptr<THManagedSegment> segment, ptrdiff_t offset);
+
+  std::shared_ptr<THManagedSegment> segment_;
+  ptrdiff_t offset_;
+};
+
+// Stops allocating from the segments of the pool of this process, and lets
+// the other processes unmap them once they don't use their blocks. Called when
+// the process exits.
+void libshm_retire_pool();
+
 #endif
@@ -0,0 +1,378 @@
+#include <atomic>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+
+#include <TH/TH.h>
+#include "libshm.h"
+
+// A segment is a THManagedMapAllocator, so that the shared memory manager
+// unlinks it if its processes die. Its data starts with a SegmentHeader, and
+// is then cut into blocks, each a BlockHeader followed by the data of a
+// storage:
+//
+//   | SegmentHeader | BlockHeader | data | BlockHeader | data | free ... |
+//
+// The refcount of a block counts the storages of all processes that use it,
+// plus the ones being sent. The process that owns the segment keeps the
+// offsets of the blocks it handed out, and takes a block back once its
+// refcount is 0. The refcount of the segment (the one of
+// THRefcountedMapAllocator) counts the processes that map it, plus the blocks
+// being sent.
+
+namespace {
+
+constexpr ptrdiff_t kAlignment = 64;
+// Storages larger than this get a segment of their own, which is unmapped
+// once they are freed.
+constexpr ptrdiff_t kSegmentSize = 16 << 20;
+
+struct SegmentHeader {
+  std::atomic<int> retired;
+};
+
+struct BlockHeader {
+  std::atomic<int> refcount;
+  int64_t generation;
+};
+
+static_assert(sizeof(SegmentHeader) <= kAlignment, "SegmentHeader doesn't fit its alignment");
+static_assert(sizeof(BlockHeader) <= kAlignment, "BlockHeader doesn't fit its alignment");
+
+ptrdiff_t round_up(ptrdiff_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+std::string new_segment_name() {
+  static std::random_device rd;
+  std::string name = "/torch_";
+  name += std::to_string(getpid());
+  name += "_pool_";
+  name += std::to_string(rd());
+  return name;
+}
+
+} // namespace
+
+struct THManagedSegment {
+  THManagedSegment(const char* manager_handle, const char* name, int flags, ptrdiff_t size, bool owned)
+    : mapping(manager_handle, name, flags, size), size(size), owned(owned) {}
+
+  SegmentHeader* header() {
+    return static_cast<SegmentHeader*>(mapping.data());
+  }
+
+  BlockHeader* block(ptrdiff_t offset) {
+    return reinterpret_cast<BlockHeader*>(static_cast<char*>(mapping.data()) + offset);
+  }
+
+  THManagedMapAllocator mapping;
+  const ptrdiff_t size;
+  // whether this process allocates its blocks
+  const bool owned;
+};
+
+namespace {
+
+// Adds the range [offset, offset + size) to ranges, merged with its
+// neighbours.
+void add_range(std::map<ptrdiff_t, ptrdiff_t>& ranges, ptrdiff_t offset, ptrdiff_t size) {
+  auto next = ranges.lower_bound(offset);
+  if (next != ranges.end() && offset + size == next->first) {
+    size += next->second;
+    next = ranges.erase(next);
+  }
+  if (next != ranges.begin()) {
+    auto prev = std::prev(next);
+    if (prev->first + prev->second == offset) {
+      prev->second += size;
+      return;
+    }
+  }
+  ranges.emplace_hint(next, offset, size);
+}
+
+// The segments this process allocates blocks from.
+class SegmentPool {
+public:
+  std::pair<std::shared_ptr<THManagedSegment>, ptrdiff_t> allocate(ptrdiff_t size) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (pid_ != getpid()) {
+      // A forked child shares the segments of its parent, but must not
+      // allocate from them, nor unmap them on its own.
+      inherited_.insert(inherited_.end(), segments_.begin(), segments_.end());
+      segments_.clear();
+      pid_ = getpid();
+    }
+
+    ptrdiff_t block_size = kAlignment + round_up(std::max<ptrdiff_t>(size, 1));
+    ptrdiff_t offset;
+    for (int reclaimed = 0; reclaimed < 2; reclaimed++) {
+      for (auto& segment : segments_) {
+        if ((offset = take(segment, block_size)) >= 0) {
+          return start_block(segment.segment, offset);
+        }
+      }
+      reclaim();
+    }
+
+    PoolSegment segment;
+    ptrdiff_t data_size = std::max(block_size, kSegmentSize);
+    std::string name = new_segment_name();
+    segment.segment = std::make_shared<THManagedSegment>(
+        "", name.c_str(), TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_EXCLUSIVE,
+        kAlignment + data_size, /* owned */ true);
+    new (&segment.segment->header()->retired) std::atomic<int>(0);
+    segment.free_ranges.emplace(kAlignment, data_size);
+    offset = take(segment, block_size);
+    segments_.push_back(std::move(segment));
+    return start_block(segments_.back().segment, offset);
+  }
+
+  std::shared_ptr<THManagedSegment> find(const std::string& name) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (pid_ == getpid()) {
+      for (auto& segment : segments_) {
+        if (name == segment.segment->mapping.filename()) {
+          return segment.segment;
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  void retire() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (pid_ == getpid()) {
+      for (auto& segment : segments_) {
+        segment.segment->header()->retired = 1;
+      }
+      segments_.clear();
+    }
+  }
+
+private:
+  struct PoolSegment {
+    std::shared_ptr<THManagedSegment> segment;
+    // offset -> size
+    std::map<ptrdiff_t, ptrdiff_t> free_ranges;
+    std::map<ptrdiff_t, ptrdiff_t> used_blocks;
+  };
+
+  // The offset of a new block of block_size bytes in segment, or -1.
+  ptrdiff_t take(PoolSegment& segment, ptrdiff_t block_size) {
+    for (auto it = segment.free_ranges.begin(); it != segment.free_ranges.end(); ++it) {
+      if (it->second >= block_size) {
+        ptrdiff_t offset = it->first;
+        ptrdiff_t remaining = it->second - block_size;
+        segment.free_ranges.erase(it);
+        if (remaining > 0) {
+          segment.free_ranges.emplace(offset + block_size, remaining);
+        }
+        segment.used_blocks.emplace(offset, block_size);
+        return offset;
+      }
+    }
+    return -1;
+  }
+
+  std::pair<std::shared_ptr<THManagedSegment>, ptrdiff_t>
+  start_block(const std::shared_ptr<THManagedSegment>& segment, ptrdiff_t offset) {
+    BlockHeader* block = segment->block(offset);
+    new (&block->refcount) std::atomic<int>(1);
+    block->generation = next_generation_++;
+    return {segment, offset};
+  }
+
+  // Takes back the blocks no process holds. Segments of a single storage are
+  // unmapped then, and the others are kept for the next blocks.
+  void reclaim() {
+    for (auto segment = segments_.begin(); segment != segments_.end();) {
+      auto& used = segment->used_blocks;
+      for (auto block = used.begin(); block != used.end();) {
+        if (segment->segment->block(block->first)->refcount == 0) {
+          add_range(segment->free_ranges, block->first, block->second);
+          block = used.erase(block);
+        } else {
+          ++block;
+        }
+      }
+      if (used.empty() && segment->segment->size > kAlignment + kSegmentSize) {
+        segment->segment->header()->retired = 1;
+        segment = segments_.erase(segment);
+      } else {
+        ++segment;
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  pid_t pid_ = getpid();
+  std::vector<PoolSegment> segments_;
+  // See allocate(). Never unmapped.
+  std::vector<PoolSegment> inherited_;
+  int64_t next_generation_ = 1;
+};
+
+// The segments of other processes this process maps. A segment stays mapped
+// until its owner retired it and this process holds none of its blocks.
+class ForeignSegments {
+public:
+  std::shared_ptr<THManagedSegment> get(const char* manager_handle, const char* name, ptrdiff_t size) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (pid_ != getpid()) {
+      // The mappings of a forked child don't count in the refcounts of the
+      // segments, so it maps them again.
+      for (auto& segment : segments_) {
+        inherited_.push_back(std::move(segment.second));
+      }
+      segments_.clear();
+      pid_ = getpid();
+    }
+    release_unused();
+    auto it = segments_.find(name);
+    if (it != segments_.end()) {
+      return it->second;
+    }
+    auto segment = std::make_shared<THManagedSegment>(
+        manager_handle, name, TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_NOCREATE,
+        size, /* owned */ false);
+    segments_.emplace(name, segment);
+    return segment;
+  }
+
+  void release() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (pid_ == getpid()) {
+      release_unused();
+    }
+  }
+
+private:
+  void release_unused() {
+    for (auto it = segments_.begin(); it != segments_.end();) {
+      if (it->second.use_count() == 1 && it->second->header()->retired) {
+        it = segments_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  pid_t pid_ = getpid();
+  std::unordered_map<std::string, std::shared_ptr<THManagedSegment>> segments_;
+  // See get(). Never unmapped.
+  std::vector<std::shared_ptr<THManagedSegment>> inherited_;
+};
+
+// Never destroyed, so that storages freed during the exit still find them.
+SegmentPool& segment_pool() {
+  static SegmentPool* pool = new SegmentPool();
+  return *pool;
+}
+
+ForeignSegments& foreign_segments() {
+  static ForeignSegments* segments = new ForeignSegments();
+  return *segments;
+}
+
+void deleteTHManagedPoolBlock(void* ptr) {
+  delete static_cast<THManagedPoolBlock*>(ptr);
+}
+
+} // namespace
+
+THManagedPoolBlock::THManagedPoolBlock(std::shared_ptr<THManagedSegment> segment, ptrdiff_t offset)
+  : segment_(std::move(segment)), offset_(offset) {}
+
+THManagedPoolBlock::~THManagedPoolBlock() {
+  --segment_->block(offset_)->refcount;
+  bool owned = segment_->owned;
+  segment_.reset();
+  if (!owned) {
+    try {
+      foreign_segments().release();
+    } catch (...) {
+      // unmapping a segment failed, which mustn't escape a deleter
+    }
+  }
+}
+
+at::DataPtr THManagedPoolBlock::makeDataPtr(ptrdiff_t size) {
+  std::pair<std::shared_ptr<THManagedSegment>, ptrdiff_t> block;
+  try {
+    block = segment_pool().allocate(size);
+  } catch (std::exception& e) {
+    THError(e.what());
+  }
+  auto* context = new THManagedPoolBlock(std::move(block.first), block.second);
+  return {context->data(), context, &deleteTHManagedPoolBlock, at::kCPU};
+}
+
+at::DataPtr THManagedPoolBlock::makeDataPtr(const char* manager_handle, const char* segment_name,
+                                            ptrdiff_t segment_size, ptrdiff_t offset, int64_t generation) {
+  std::shared_ptr<THManagedSegment> segment = segment_pool().find(segment_name);
+  if (!segment) {
+    try {
+      segment = foreign_segments().get(manager_handle, segment_name, segment_size);
+    } catch (std::exception& e) {
+      THError(e.what());
+    }
+  }
+  if (offset < kAlignment || offset + kAlignment > segment_size) {
+    THError("invalid offset %td of a block of the shared memory segment %s", offset, segment_name);
+  }
+  BlockHeader* block = segment->block(offset);
+  if (block->generation != generation || block->refcount == 0) {
+    THError("the block at offset %td of the shared memory segment %s was freed before it "
+            "was received", offset, segment_name);
+  }
+  ++block->refcount;
+  auto* context = new THManagedPoolBlock(std::move(segment), offset);
+  return {context->data(), context, &deleteTHManagedPoolBlock, at::kCPU};
+}
+
+THManagedPoolBlock* THManagedPoolBlock::fromDataPtr(const at::DataPtr& dptr) {
+  return dptr.cast_context<THManagedPoolBlock>(&deleteTHManagedPoolBlock);
+}
+
+void THManagedPoolBlock::incref() {
+  ++segment_->block(offset_)->refcount;
+  segment_->mapping.incref();
+}
+
+void THManagedPoolBlock::decref() {
+  --segment_->block(offset_)->refcount;
+  segment_->mapping.decref();
+}
+
+const char* THManagedPoolBlock::manager_handle() const {
+  return segment_->mapping.manager_handle();
+}
+
+const char* THManagedPoolBlock::segment_name() const {
+  return segment_->mapping.filename();
+}
+
+ptrdiff_t THManagedPoolBlock::segment_size() const {
+  return segment_->size;
+}
+
+int64_t THManagedPoolBlock::generation() const {
+  return segment_->block(offset_)->generation;
+}
+
+void* THManagedPoolBlock::data() const {
+  return static_cast<char*>(segment_->mapping.data()) + offset_ + kAlignment;
+}
+
+void libshm_retire_pool() {
+  segment_pool().retire();
+}
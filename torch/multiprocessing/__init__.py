@@ -34,12 +34,15 @@ if sys.version_info < (3, 3):
     from .pool import Pool
 
 
-if sys.platform == 'darwin' or sys.platform == 'win32':
+if sys.platform == 'win32':
     _sharing_strategy = 'file_system'
     _all_sharing_strategies = {'file_system'}
+elif sys.platform == 'darwin':
+    _sharing_strategy = 'file_system'
+    _all_sharing_strategies = {'file_system', 'file_system_pool'}
 else:
     _sharing_strategy = 'file_descriptor'
-    _all_sharing_strategies = {'file_descriptor', 'file_system'}
+    _all_sharing_strategies = {'file_descriptor', 'file_system', 'file_system_pool'}
 
 
 def set_sharing_strategy(new_strategy):
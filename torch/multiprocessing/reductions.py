@@ -2,6 +2,7 @@ import torch
 import os
 import weakref
 import multiprocessing
+import multiprocessing.util
 from multiprocessing.reduction import ForkingPickler
 import sys
 try:
@@ -169,6 +170,32 @@ def rebuild_storage_filename(cls, manager, handle, size):
     return storage._shared_decref()
 
 
+def rebuild_storage_pool(cls, manager, segment, segment_size, offset, generation, size):
+    # blocks are reused once freed, so that the offset alone doesn't identify
+    # the storage
+    cache_key = (segment, offset, generation)
+    storage = storage_from_cache(cls, cache_key)
+    if storage is not None:
+        return storage._shared_decref()
+    storage = cls._new_shared_pool(manager, segment, segment_size, offset, generation, size)
+    shared_cache[cache_key] = storage._weak_ref(StorageRef)
+    return storage._shared_decref()
+
+
+# pid of the process that called retire_shared_pool_at_exit
+_shared_pool_pid = None
+
+
+def retire_shared_pool_at_exit():
+    # Lets the other processes unmap the segments of the pool of this process
+    # once it exits. This must run after the feeder threads of the queues
+    # (exitpriority -5) have sent their last storages.
+    global _shared_pool_pid
+    if _shared_pool_pid != os.getpid():
+        _shared_pool_pid = os.getpid()
+        multiprocessing.util.Finalize(None, torch._C._retire_shared_pool, exitpriority=-10)
+
+
 def rebuild_storage_empty(cls):
     return cls()
 
@@ -182,6 +209,12 @@ def reduce_storage(storage):
         cache_key = metadata[1]
         rebuild = rebuild_storage_filename
         storage._shared_incref()
+    elif get_sharing_strategy() == 'file_system_pool':
+        retire_shared_pool_at_exit()
+        metadata = storage._share_pool_()
+        cache_key = (metadata[1], metadata[3], metadata[4])
+        rebuild = rebuild_storage_pool
+        storage._shared_incref()
     elif storage.size() == 0:
         # This is special cased because Empty tensors
         # (with size 0) cannot be mmapped.
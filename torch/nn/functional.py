@@ -592,6 +592,9 @@ def adaptive_avg_pool3d(input, output_size):
 
 # Activation functions
 def dropout(input, p=0.5, training=False, inplace=False):
+    if training and not inplace and 0 < p < 1 and not torch._C._is_tracing([input]):
+        # fused dropout, which keeps a mask of one bit per element for backward
+        return torch._fused_dropout(input, p)[0]
     return _functions.dropout.Dropout.apply(input, p, training, inplace)
 
 
@@ -1547,6 +1550,9 @@ def cross_entropy(input, target, weight=None, size_average=None, ignore_index=-1
     """
     if size_average is not None or reduce is not None:
         reduction = _Reduction.legacy_get_string(size_average, reduce)
+    if weight is None and input.dim() == 2 and not torch._C._is_tracing([input]):
+        # fused log_softmax and nll_loss, which doesn't keep the log-probabilities
+        return torch._cross_entropy_forward(input, target, _Reduction.get_enum(reduction), ignore_index)[0]
     return nll_loss(log_softmax(input, 1), target, weight, None, ignore_index, None, reduction)
 
 
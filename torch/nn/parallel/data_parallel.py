@@ -3,7 +3,7 @@ import torch
 import warnings
 from ..modules import Module
 from .scatter_gather import scatter_kwargs, gather
-from .replicate import replicate
+from .replicate import replicate, ReplicaCache
 from .parallel_apply import parallel_apply
 
 
@@ -79,6 +79,11 @@ class DataParallel(Module):
         module: module to be parallelized
         device_ids: CUDA devices (default: all devices)
         output_device: device location of output (default: device_ids[0])
+        cache_replicas: if ``True``, forward passes run without gradients keep
+            the replicas alive and only broadcast the parameters and buffers
+            that changed since the previous such pass. Modifications made
+            through ``.data`` are not detected; call
+            :meth:`clear_replica_cache` after them. (default: ``False``)
 
     Attributes:
         module (Module): the module to be parallelized
@@ -91,9 +96,11 @@ class DataParallel(Module):
 
     # TODO: update notes/cuda.rst when this class handles 8+ GPUs well
 
-    def __init__(self, module, device_ids=None, output_device=None, dim=0):
+    def __init__(self, module, device_ids=None, output_device=None, dim=0,
+                 cache_replicas=False):
         super(DataParallel, self).__init__()
 
+        self._replica_cache = ReplicaCache() if cache_replicas else None
         if not torch.cuda.is_available():
             self.module = module
             self.device_ids = []
@@ -124,8 +131,29 @@ class DataParallel(Module):
         return self.gather(outputs, self.output_device)
 
     def replicate(self, module, device_ids):
+        if self._replica_cache is not None:
+            if not torch.is_grad_enabled():
+                return self._replica_cache.replicate(module, device_ids)
+            # Don't hold on to replicas that training makes stale.
+            self._replica_cache.clear()
         return replicate(module, device_ids)
 
+    def clear_replica_cache(self):
+        r"""Drops the replicas kept for forward passes without gradients."""
+        if self._replica_cache is not None:
+            self._replica_cache.clear()
+
+    def __getstate__(self):
+        state = self.__dict__.copy()
+        if state.get('_replica_cache') is not None:
+            state['_replica_cache'] = ReplicaCache()
+        return state
+
+    def __setstate__(self, state):
+        super(DataParallel, self).__setstate__(state)
+        if '_replica_cache' not in self.__dict__:
+            self._replica_cache = None
+
     def scatter(self, inputs, kwargs, device_ids):
         return scatter_kwargs(inputs, kwargs, device_ids, dim=self.dim)
 
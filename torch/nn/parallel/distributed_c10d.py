@@ -165,6 +165,7 @@ class _DistributedDataParallelC10d(Module):
             self.modules_buffers_data[dev_idx] = [b.data for b in module._all_buffers()]
 
         bucket_bytes_cap = bucket_cap_mb * MB
+        self.bucket_bytes_cap = bucket_bytes_cap
 
         # This is a triply-nested list where the "dimensions" are: devices, buckets, bucket_elems
         param_buckets = []
@@ -213,6 +214,7 @@ class _DistributedDataParallelC10d(Module):
     def __getstate__(self):
         attrs = copy.copy(self.__dict__)
         del attrs['_grad_accs']
+        del attrs['_reducer']
         return attrs
 
     def __setstate__(self, state):
@@ -275,6 +277,15 @@ class _DistributedDataParallelC10d(Module):
 
     def _register_grad_hooks(self):
         self._grad_accs = []  # need to keep them in scope
+        self._reducer = None
+        if len(self._module_copies) == 1:
+            # With a single device per process the C++ reducer does the
+            # bucketing and overlaps the reductions with backward.
+            self._reducer = c10d.Reducer(
+                [p for p in self.module.parameters() if p.requires_grad],
+                self.process_group,
+                self.bucket_bytes_cap)
+            return
         for device_idx, module in enumerate(self._module_copies):
             for p in module.parameters():
                 if p.requires_grad:
@@ -1,3 +1,4 @@
+import torch
 import torch.cuda.comm as comm
 
 
@@ -8,18 +9,27 @@ def replicate(network, devices, detach=False):
     num_replicas = len(devices)
 
     params = list(network.parameters())
-    param_indices = {param: idx for idx, param in enumerate(params)}
     param_copies = Broadcast.apply(devices, *params)
     if len(params) > 0:
         param_copies = [param_copies[i:i + len(params)]
                         for i in range(0, len(param_copies), len(params))]
+    if detach:
+        param_copies = [[param.detach() for param in copies] for copies in param_copies]
 
     buffers = list(network._all_buffers())
-    buffer_indices = {buf: idx for idx, buf in enumerate(buffers)}
     buffer_copies = comm.broadcast_coalesced(buffers, devices)
 
+    return _replicate_modules(network, num_replicas, param_copies, buffer_copies)
+
+
+def _replicate_modules(network, num_replicas, param_copies, buffer_copies):
+    # param_copies[j] and buffer_copies[j] are indexed like network.parameters()
+    # and network._all_buffers(), and hold the tensors used by the j-th replica.
+    param_indices = {param: idx for idx, param in enumerate(network.parameters())}
+    buffer_indices = {buf: idx for idx, buf in enumerate(network._all_buffers())}
+
     modules = list(network.modules())
-    module_copies = [[] for device in devices]
+    module_copies = [[] for _ in range(num_replicas)]
     module_indices = {}
 
     for i, module in enumerate(modules):
@@ -52,8 +62,7 @@ def replicate(network, devices, detach=False):
                 param_idx = param_indices[param]
                 for j in range(num_replicas):
                     replica = module_copies[j][i]
-                    replica._parameters[key] = param_copies[j][param_idx].detach() \
-                        if detach else param_copies[j][param_idx]
+                    replica._parameters[key] = param_copies[j][param_idx]
         for key, buf in module._buffers.items():
             if buf is None:
                 for j in range(num_replicas):
@@ -66,3 +75,105 @@ def replicate(network, devices, detach=False):
                     replica._buffers[key] = buffer_copies[j][buffer_idx]
 
     return [module_copies[j][0] for j in range(num_replicas)]
+
+
+def _module_structure(modules):
+    # Compares objects by identity; the cache keeps them alive, so their ids
+    # can't be reused.
+    return [(id(module),
+             [(key, id(param)) for key, param in module._parameters.items()],
+             [(key, id(buf)) for key, buf in module._buffers.items()],
+             [(key, id(child)) for key, child in module._modules.items()])
+            for module in modules]
+
+
+def _tensor_state(tensor):
+    return tensor.data_ptr(), tensor._version
+
+
+class ReplicaCache(object):
+    r"""Keeps detached replicas of a module alive across calls to
+    :meth:`replicate`, for forward passes that don't need gradients.
+
+    A call only broadcasts the parameters and buffers whose storage or version
+    counter changed since the previous call, or whose copy was modified by a
+    replica, and rebuilds the replicas only if the devices or the structure of
+    the module changed.
+
+    .. warning::
+        Modifications made through ``tensor.data`` are not tracked by the
+        version counter of ``tensor``. Call :meth:`clear` after making them.
+    """
+
+    def __init__(self):
+        self.clear()
+
+    def clear(self):
+        self._devices = None
+        self._modules = []
+        self._structure = None
+        self._tensors = []
+        self._states = []
+        self._copies = []
+        self._copy_versions = []
+        self._replicas = None
+        self._replica_modules = []
+
+    def replicate(self, network, devices):
+        devices = tuple(devices)
+        modules = list(network.modules())
+        structure = _module_structure(modules)
+        with torch.no_grad():
+            if devices != self._devices or structure != self._structure:
+                self._build(network, modules, devices, structure)
+            else:
+                self._update()
+                for module, replicas in zip(modules, self._replica_modules):
+                    self._refresh_attributes(module, replicas)
+        return self._replicas
+
+    def _build(self, network, modules, devices, structure):
+        self.clear()
+        params = list(network.parameters())
+        buffers = list(network._all_buffers())
+        tensors = params + buffers
+        copies = comm.broadcast_coalesced(tensors, devices)
+        self._copies = [[copy.detach() for copy in device_copies] for device_copies in copies]
+        self._replicas = _replicate_modules(
+            network, len(devices),
+            [device_copies[:len(params)] for device_copies in self._copies],
+            [device_copies[len(params):] for device_copies in self._copies])
+        # The replicas of the i-th module on every device.
+        self._replica_modules = list(zip(*[list(replica.modules()) for replica in self._replicas]))
+        self._devices = devices
+        self._modules = modules
+        self._structure = structure
+        self._tensors = tensors
+        self._record_states()
+
+    def _update(self):
+        changed = [i for i, tensor in enumerate(self._tensors)
+                   if _tensor_state(tensor) != self._states[i] or
+                   any(copies[i]._version != versions[i]
+                       for copies, versions in zip(self._copies[1:], self._copy_versions[1:]))]
+        if not changed:
+            return
+        copies = comm.broadcast_coalesced([self._tensors[i] for i in changed], self._devices)
+        for device_copies, new_copies in zip(self._copies, copies):
+            for i, new_copy in zip(changed, new_copies):
+                device_copies[i].set_(new_copy)
+        self._record_states()
+
+    def _record_states(self):
+        self._states = [_tensor_state(tensor) for tensor in self._tensors]
+        self._copy_versions = [[copy._version for copy in device_copies]
+                               for device_copies in self._copies]
+
+    @staticmethod
+    def _refresh_attributes(module, replicas):
+        # Plain attributes, like the training flag, may have changed since the
+        # replicas were built.
+        for replica in replicas:
+            for key, value in module.__dict__.items():
+                if key not in ('_parameters', '_buffers', '_modules'):
+                    replica.__dict__[key] = value
@@ -225,13 +225,30 @@ def _export(model, args, f, export_params=True, verbose=False, training=False,
                                                output_names, operator_export_type,
                                                example_outputs, propagate)
 
-    # TODO: Don't allocate a in-memory string for the protobuf
     from torch.onnx.symbolic import _onnx_opset_version
     defer_weight_export = export_type is not ExportTypes.PROTOBUF_FILE
-    if export_params:
-        proto, export_map = graph.export(params, _onnx_opset_version, defer_weight_export, operator_export_type)
-    else:
-        proto, export_map = graph.export([], _onnx_opset_version, False, operator_export_type)
+    if not export_params:
+        params = []
+        defer_weight_export = False
+
+    # When writing to files, the protobuf is streamed to them and the weights
+    # are written straight from the tensors, without building them in memory
+    if export_type == ExportTypes.PROTOBUF_FILE and isinstance(f, string_classes):
+        graph.export_to_file(params, f, _onnx_opset_version, False, operator_export_type)
+        return torch_out
+    if export_type == ExportTypes.DIRECTORY:
+        import os
+        if os.path.exists(f):
+            assert(os.path.isdir(f))
+        else:
+            os.makedirs(f)
+
+        model_proto_file = os.path.join(f, ONNX_ARCHIVE_MODEL_PROTO_NAME)
+        graph.export_to_file(params, model_proto_file, _onnx_opset_version,
+                             defer_weight_export, operator_export_type, f)
+        return torch_out
+
+    proto, export_map = graph.export(params, _onnx_opset_version, defer_weight_export, operator_export_type)
 
     if export_type == ExportTypes.PROTOBUF_FILE:
         assert(len(export_map) == 0)
@@ -245,21 +262,6 @@ def _export(model, args, f, export_params=True, verbose=False, training=False,
             z.writestr(ONNX_ARCHIVE_MODEL_PROTO_NAME, proto)
             for k, v in export_map.items():
                 z.writestr(k, v)
-    elif export_type == ExportTypes.DIRECTORY:
-        import os
-        if os.path.exists(f):
-            assert(os.path.isdir(f))
-        else:
-            os.makedirs(f)
-
-        model_proto_file = os.path.join(f, ONNX_ARCHIVE_MODEL_PROTO_NAME)
-        torch.serialization._with_file_like(
-            model_proto_file, "wb", lambda f: f.write(proto))
-
-        for k, v in export_map.items():
-            weight_proto_file = os.path.join(f, k)
-            torch.serialization._with_file_like(
-                weight_proto_file, "wb", lambda f: f.write(v))
     else:
         raise RuntimeError('Unknown export type')
     return torch_out
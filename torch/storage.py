@@ -104,6 +104,10 @@ class _StorageBase(object):
             pass  # CUDA doesn't use POSIX shared memory
         elif get_sharing_strategy() == 'file_system':
             self._share_filename_()
+        elif get_sharing_strategy() == 'file_system_pool':
+            from torch.multiprocessing.reductions import retire_shared_pool_at_exit
+            retire_shared_pool_at_exit()
+            self._share_pool_()
         else:
             self._share_fd_()
         return self
@@ -116,6 +120,10 @@ class _StorageBase(object):
             return cls(size)
         elif get_sharing_strategy() == 'file_system':
             return cls._new_using_filename(size)
+        elif get_sharing_strategy() == 'file_system_pool':
+            from torch.multiprocessing.reductions import retire_shared_pool_at_exit
+            retire_shared_pool_at_exit()
+            return cls._new_using_pool(size)
         else:
             return cls._new_using_fd(size)
 
@@ -1,27 +1,53 @@
 import torch
 
-from torch._C import _from_dlpack as from_dlpack
-from torch._C import _to_dlpack as to_dlpack
-
-torch._C._add_docstr(from_dlpack, r"""from_dlpack(dlpack) -> Tensor
-
-Decodes a DLPack to a tensor.
-
-Args:
-    dlpack: a PyCapsule object with the dltensor
-
-The tensor will share the memory with the object represented
-in the dlpack.
-Note that each dlpack can only be consumed once.
-""")
-
-torch._C._add_docstr(to_dlpack, r"""to_dlpack(tensor) -> PyCapsule
-
-Returns a DLPack representing the tensor.
-
-Args:
-    tensor: a tensor to be exported
-
-The dlpack shares the tensors memory.
-Note that each dlpack can only be consumed once.
-""")
+from torch._C import _from_dlpack
+from torch._C import _to_dlpack
+from torch._C import _dlpack_event
+
+
+def to_dlpack(tensor, stream=None):
+    r"""Returns a DLPack representing the tensor.
+
+    Args:
+        tensor: a tensor to be exported
+        stream (torch.cuda.Stream, optional): for CUDA tensors, the stream the
+            work producing the tensor was queued on (default: the current
+            stream of the tensor's device)
+
+    The dlpack shares the tensors memory.
+    Note that each dlpack can only be consumed once.
+
+    For CUDA tensors, an event recorded on :attr:`stream` travels with the
+    dlpack, and :func:`from_dlpack` makes the consuming stream wait on it,
+    so that neither side needs to synchronize the device.
+    """
+    event = None
+    if tensor.is_cuda:
+        with torch.cuda.device(tensor.get_device()):
+            event = torch.cuda.Event()
+            event.record(stream)
+    return _to_dlpack(tensor, event)
+
+
+def from_dlpack(dlpack, stream=None):
+    r"""Decodes a DLPack to a tensor.
+
+    Args:
+        dlpack: a PyCapsule object with the dltensor
+        stream (torch.cuda.Stream, optional): for CUDA tensors, the stream
+            that will use the tensor (default: the current stream of the
+            tensor's device)
+
+    The tensor will share the memory with the object represented
+    in the dlpack.
+    Note that each dlpack can only be consumed once.
+
+    If the dlpack was made by :func:`to_dlpack` from a CUDA tensor,
+    :attr:`stream` waits for the work that produced it.
+    """
+    event = _dlpack_event(dlpack)
+    tensor = _from_dlpack(dlpack)
+    if event is not None:
+        with torch.cuda.device(tensor.get_device()):
+            event.wait(stream)
+    return tensor